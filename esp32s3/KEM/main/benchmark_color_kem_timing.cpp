@@ -1,4 +1,7 @@
 #include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <esp_idf_version.h>
+#include <cstdio>
 #include <vector>
 #include <functional>
 #include <algorithm>
@@ -6,6 +9,16 @@
 #include <clwe/color_kem.hpp>
 #include <clwe/cpu_features.hpp>
 #include <clwe/performance_metrics.hpp>
+#include <clwe/ntt_scalar.hpp>
+#include <clwe/ntt_esp32s3.hpp>
+#include <clwe/dual_core_executor.hpp>
+#include <clwe/memory_placement.hpp>
+#include <clwe/stage_profile.hpp>
+
+#ifdef CLWE_STATIC_WORKSPACE
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
 
 using namespace clwe;
 
@@ -112,6 +125,223 @@ void benchmark_security_level(int security_level, int iterations = 10) {
     ESP_LOGI(TAG, "  Decap:  %.2f%%", (decap_cycles.average_cycles / (double)total_cycles * 100));
 }
 
+// Cycle counts of the scalar NTT engine and the one create_optimal_ntt_engine picks
+void benchmark_ntt_engines(int iterations = 100) {
+    const uint32_t q = 3329;
+    const uint32_t n = 256;
+    ESP_LOGI(TAG, "NTT Engines (q = %u, n = %u)", static_cast<unsigned>(q), static_cast<unsigned>(n));
+    ESP_LOGI(TAG, "=====================================");
+
+    std::vector<uint32_t> a(n), b(n), result(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        a[i] = (i * 17 + 3) % q;
+        b[i] = (i * 29 + 11) % q;
+    }
+
+    std::unique_ptr<NTTEngine> scalar(new ScalarNTTEngine(q, n));
+    std::unique_ptr<NTTEngine> optimal = create_optimal_ntt_engine(q, n);
+
+    for (NTTEngine* engine : {scalar.get(), optimal.get()}) {
+        std::vector<uint32_t> poly = a;
+        clwe::CycleStats forward_cycles = clwe::PerformanceMetrics::time_operation_cycles([&]() {
+            engine->ntt_forward(poly.data());
+        }, iterations);
+
+        poly = a;
+        clwe::CycleStats inverse_cycles = clwe::PerformanceMetrics::time_operation_cycles([&]() {
+            engine->ntt_inverse(poly.data());
+        }, iterations);
+
+        clwe::CycleStats multiply_cycles = clwe::PerformanceMetrics::time_operation_cycles([&]() {
+            engine->multiply(a.data(), b.data(), result.data());
+        }, iterations);
+
+        const char* name = engine->get_simd_support() == SIMDSupport::PIE ? "PIE" : "Scalar";
+        ESP_LOGI(TAG, "%-6s Forward NTT:  %llu cycles", name, forward_cycles.average_cycles);
+        ESP_LOGI(TAG, "%-6s Inverse NTT:  %llu cycles", name, inverse_cycles.average_cycles);
+        ESP_LOGI(TAG, "%-6s Multiply:     %llu cycles", name, multiply_cycles.average_cycles);
+    }
+}
+
+// Keygen and encapsulation with and without the second core expanding matrix A
+void benchmark_dual_core(int security_level, int iterations = 10) {
+    clwe::CLWEParameters params(security_level);
+    clwe::ColorKEM kem(params);
+    clwe::DualCoreExecutor executor;
+
+    ESP_LOGI(TAG, "Dual Core: level %d, worker %s", security_level,
+             executor.dual_core() ? "running" : "unavailable (single-core fallback)");
+    ESP_LOGI(TAG, "=====================================");
+
+    auto keypair = kem.keygen();
+    for (clwe::DualCoreExecutor* active : {static_cast<clwe::DualCoreExecutor*>(nullptr), &executor}) {
+        kem.set_executor(active);
+
+        clwe::CycleStats keygen_cycles = clwe::PerformanceMetrics::time_operation_cycles([&]() {
+            kem.keygen();
+        }, iterations);
+
+        clwe::CycleStats encap_cycles = clwe::PerformanceMetrics::time_operation_cycles([&]() {
+            kem.encapsulate(keypair.first);
+        }, iterations);
+
+        const char* name = active != nullptr ? "Dual" : "Single";
+        ESP_LOGI(TAG, "%-6s KeyGen Cycles: %llu", name, keygen_cycles.average_cycles);
+        ESP_LOGI(TAG, "%-6s Encap Cycles:  %llu", name, encap_cycles.average_cycles);
+    }
+    kem.set_executor(nullptr);
+}
+
+// Keygen and encapsulation with matrix A in internal SRAM and in PSRAM; tables and
+// scratch stay internal in both runs, so the difference is the cost of PSRAM for A
+void benchmark_placement(int security_level, int iterations = 10) {
+    clwe::CLWEParameters params(security_level);
+    size_t matrix_bytes = params.module_rank * params.module_rank * params.degree * sizeof(ColorValue);
+
+    ESP_LOGI(TAG, "Placement: level %d, matrix A %zu bytes", security_level, matrix_bytes);
+    ESP_LOGI(TAG, "=====================================");
+
+    const clwe::PlacementPolicy saved = clwe::placement_policy();
+    clwe::PlacementPolicy internal;
+    internal.matrix = clwe::MemoryRegion::Internal;
+    for (const clwe::PlacementPolicy& policy : {internal, clwe::PlacementPolicy::psram_matrix()}) {
+        clwe::set_placement_policy(policy);
+        clwe::ColorKEM kem(params);
+        auto keypair = kem.keygen();
+
+        clwe::CycleStats keygen_cycles = clwe::PerformanceMetrics::time_operation_cycles([&]() {
+            kem.keygen();
+        }, iterations);
+
+        clwe::CycleStats encap_cycles = clwe::PerformanceMetrics::time_operation_cycles([&]() {
+            kem.encapsulate(keypair.first);
+        }, iterations);
+
+        const char* name = policy.matrix == clwe::MemoryRegion::External ? "PSRAM" : "SRAM";
+        ESP_LOGI(TAG, "%-6s KeyGen Cycles: %llu", name, keygen_cycles.average_cycles);
+        ESP_LOGI(TAG, "%-6s Encap Cycles:  %llu", name, encap_cycles.average_cycles);
+    }
+    clwe::set_placement_policy(saved);
+}
+
+// Lowest free 8-bit heap while operation runs. IDF 5.1 and later track a minimum local to
+// the call; older releases only report the low-water mark since boot.
+size_t minimum_free_heap_during(const std::function<void()>& operation) {
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+    heap_caps_monitor_local_minimum_free_size_start();
+    operation();
+    size_t minimum = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    heap_caps_monitor_local_minimum_free_size_stop();
+#else
+    operation();
+    size_t minimum = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+#endif
+    return minimum;
+}
+
+// One CSV row over UART: average cycles per operation in total and per stage, and the
+// heap the operation took at its peak. Rows start with "CSV," so a log scraper can pick
+// them out of the ESP_LOG output; code says whether the CLWE_HOT kernels ran from IRAM.
+void report_stage_row(int security_level, const char* operation_name, const std::function<void()>& operation,
+                      int iterations) {
+    clwe::stage_profile_reset();
+    clwe::CycleStats cycles = clwe::PerformanceMetrics::time_operation_cycles(operation, iterations);
+    clwe::StageCycles stages = clwe::stage_profile_snapshot();
+
+    size_t free_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    size_t minimum_free = minimum_free_heap_during(operation);
+    size_t heap_peak = free_before > minimum_free ? free_before - minimum_free : 0;
+
+    uint64_t accounted = stages.total() / iterations;
+    uint64_t other = cycles.average_cycles > accounted ? cycles.average_cycles - accounted : 0;
+
+#ifdef CLWE_HOT_IN_FLASH
+    const char* code = "flash";
+#else
+    const char* code = "iram";
+#endif
+    printf("CSV,%s,%d,%s,%llu", code, security_level, operation_name,
+           static_cast<unsigned long long>(cycles.average_cycles));
+    for (size_t s = 0; s < clwe::KEM_STAGE_COUNT; ++s) {
+        printf(",%llu", static_cast<unsigned long long>(stages.cycles[s] / iterations));
+    }
+    printf(",%llu,%u,%u\n", static_cast<unsigned long long>(other), static_cast<unsigned>(heap_peak),
+           static_cast<unsigned>(heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT)));
+    fflush(stdout);
+}
+
+// Per-stage cycle breakdown of single-core keygen, encapsulation and decapsulation as CSV.
+// Stage columns need a -DCLWE_STAGE_PROFILE=ON build; compare IRAM and flash placement by
+// running a second build with -DCLWE_HOT_IN_FLASH=ON.
+void benchmark_stage_breakdown(int iterations = 10) {
+    ESP_LOGI(TAG, "Stage Breakdown (CSV)%s", clwe::stage_profile_enabled() ? "" : ": stage columns need CLWE_STAGE_PROFILE");
+    ESP_LOGI(TAG, "=====================================");
+
+    printf("CSV,code,level,operation,total_cycles");
+    for (size_t s = 0; s < clwe::KEM_STAGE_COUNT; ++s) {
+        printf(",%s_cycles", clwe::kem_stage_name(static_cast<clwe::KemStage>(s)));
+    }
+    printf(",other_cycles,heap_peak_bytes,heap_min_free_bytes\n");
+
+    for (int level : {512, 768, 1024}) {
+        clwe::CLWEParameters params(level);
+        clwe::ColorKEM kem(params);
+        auto keypair = kem.keygen();
+        auto encapsulated = kem.encapsulate(keypair.first);
+
+        report_stage_row(level, "keygen", [&]() { kem.keygen(); }, iterations);
+        report_stage_row(level, "encapsulate", [&]() { kem.encapsulate(keypair.first); }, iterations);
+        report_stage_row(level, "decapsulate", [&]() {
+            kem.decapsulate(keypair.first, keypair.second, encapsulated.first);
+        }, iterations);
+    }
+}
+
+#ifdef CLWE_STATIC_WORKSPACE
+// Zero-heap profile: one keygen/encap/decap round must leave the free heap untouched
+void benchmark_static_workspace(int iterations = 10) {
+    ESP_LOGI(TAG, "Static Workspace: level %u, %zu bytes", static_cast<unsigned>(STATIC_SECURITY_LEVEL),
+             STATIC_WORKSPACE_BYTES);
+    ESP_LOGI(TAG, "=====================================");
+
+    static uint8_t public_data[STATIC_PUBLIC_DATA_BYTES];
+    static uint8_t secret_data[STATIC_SECRET_DATA_BYTES];
+    static uint8_t ciphertext_data[STATIC_CIPHERTEXT_DATA_BYTES];
+    static uint8_t hint[STATIC_HINT_BYTES];
+    std::array<uint8_t, 32> seed;
+
+    clwe::CLWEParameters params(STATIC_SECURITY_LEVEL);
+    clwe::ColorKEM kem(params);
+
+    size_t heap_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    UBaseType_t stack_before = uxTaskGetStackHighWaterMark(nullptr);
+    kem.keygen_static(seed, public_data, secret_data);
+    ColorValue shared_secret = kem.encapsulate_static(seed, public_data, ciphertext_data, hint);
+    ColorValue recovered = kem.decapsulate_static(secret_data, ciphertext_data, hint);
+    size_t heap_after = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    UBaseType_t stack_after = uxTaskGetStackHighWaterMark(nullptr);
+
+    clwe::CycleStats keygen_cycles = clwe::PerformanceMetrics::time_operation_cycles([&]() {
+        kem.keygen_static(seed, public_data, secret_data);
+    }, iterations);
+
+    clwe::CycleStats encap_cycles = clwe::PerformanceMetrics::time_operation_cycles([&]() {
+        kem.encapsulate_static(seed, public_data, ciphertext_data, hint);
+    }, iterations);
+
+    clwe::CycleStats decap_cycles = clwe::PerformanceMetrics::time_operation_cycles([&]() {
+        kem.decapsulate_static(secret_data, ciphertext_data, hint);
+    }, iterations);
+
+    ESP_LOGI(TAG, "Round trip:         %s", shared_secret == recovered ? "match" : "MISMATCH");
+    ESP_LOGI(TAG, "Heap delta:         %d bytes", static_cast<int>(heap_before) - static_cast<int>(heap_after));
+    ESP_LOGI(TAG, "Stack used:         %u bytes", static_cast<unsigned>((stack_before - stack_after) * sizeof(StackType_t)));
+    ESP_LOGI(TAG, "KeyGen Cycles:      %llu", keygen_cycles.average_cycles);
+    ESP_LOGI(TAG, "Encap Cycles:       %llu", encap_cycles.average_cycles);
+    ESP_LOGI(TAG, "Decap Cycles:       %llu", decap_cycles.average_cycles);
+}
+#endif
+
 extern "C" void app_main(void) {
     ESP_LOGI(TAG, "🎨 CLWE Color KEM Timing Benchmark");
     ESP_LOGI(TAG, "===================================");
@@ -119,6 +349,16 @@ extern "C" void app_main(void) {
     CPUFeatures features = CPUFeatureDetector::detect();
     ESP_LOGI(TAG, "CPU: %s", features.to_string().c_str());
 
+#ifdef CLWE_STATIC_WORKSPACE
+    // First, so the task's stack high-water mark reflects only the static calls
+    benchmark_static_workspace();
+#endif
+
+    benchmark_stage_breakdown();
+    benchmark_ntt_engines();
+    benchmark_dual_core(768);
+    benchmark_placement(1024);
+
     std::vector<int> security_levels = {512, 768, 1024};
 
     for (int level : security_levels) {
@@ -1,4 +1,5 @@
 #include "clwe/color_integration.hpp"
+#include <cstring>
 #include <stdexcept>
 #include <algorithm>
 
@@ -69,55 +70,102 @@ std::vector<uint8_t> decode_colors_to_color_kem_ciphertext(const std::vector<uin
     return decode_colors_to_color_kem_public_key(color_data, expected_size);
 }
 
+namespace {
+
+// Leading byte of a 0x07 code: total code length (0 = invalid), the mask of its
+// payload bits and the shifts that join them with the two bytes after it. 0xF0 leads
+// the five-byte code, whose payload is the four bytes after it.
+struct CompressedLead {
+    uint8_t length;
+    uint8_t mask;
+    uint8_t lead_shift;
+    uint8_t tail_shift;
+};
+
+constexpr CompressedLead lead_for(int b) {
+    return b == 0x00 ? CompressedLead{1, 0x00, 0, 16}
+         : b < 0x80 ? CompressedLead{0, 0x00, 0, 16}
+         : b < 0xC0 ? CompressedLead{1, 0x3F, 0, 16}
+         : b < 0xE0 ? CompressedLead{2, 0x1F, 8, 8}
+         : b < 0xF0 ? CompressedLead{3, 0x0F, 16, 0}
+         : b == 0xF0 ? CompressedLead{5, 0x00, 0, 0}
+         : CompressedLead{0, 0x00, 0, 16};
+}
+
+struct CompressedLeadTable {
+    CompressedLead entries[256];
+    constexpr CompressedLeadTable() : entries() {
+        for (int b = 0; b < 256; ++b) {
+            entries[b] = lead_for(b);
+        }
+    }
+};
+
+constexpr CompressedLeadTable COMPRESSED_LEADS{};
+
+// Code length and leading-byte prefix per size class
+constexpr uint32_t COMPRESSED_LENGTHS[4] = {1, 2, 3, 5};
+constexpr uint64_t COMPRESSED_PREFIXES[4] = {0x80, 0xC0, 0xE0, 0xF0};
+
+inline uint64_t load_be64(const uint8_t* p) {
+    uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+    return __builtin_bswap64(word);
+}
+
+inline void store_be64(uint8_t* p, uint64_t word) {
+    word = __builtin_bswap64(word);
+    std::memcpy(p, &word, sizeof(word));
+}
+
+inline void store_be32(uint8_t* p, uint32_t value) {
+    p[0] = static_cast<uint8_t>(value >> 24);
+    p[1] = static_cast<uint8_t>(value >> 16);
+    p[2] = static_cast<uint8_t>(value >> 8);
+    p[3] = static_cast<uint8_t>(value);
+}
+
+// Four two-byte codes with leading bytes 0xC0-0xDF
+inline bool four_two_byte_codes(uint64_t word) {
+    return (word & 0xE000E000E000E000ULL) == 0xC000C000C000C000ULL;
+}
+
+} // namespace
+
 // Compressed color encoding adapted for KEM keys using variable-length encoding
 std::vector<uint8_t> encode_color_kem_key_as_colors_compressed(const std::vector<uint8_t>& key_data) {
-    std::vector<uint8_t> compressed;
-    compressed.reserve(key_data.size() + 8);
+    // Each code is written as a full 8-byte word, so the buffer holds the longest
+    // possible encoding plus that overhang and is trimmed afterwards
+    size_t num_coeffs = key_data.size() / 4;
+    std::vector<uint8_t> compressed(6 + 5 * num_coeffs + 3);
 
     // Add format version and compression flag for KEM key color-compatible compression
-    compressed.push_back(0x01); // Version 1
-    compressed.push_back(0x07); // Compression flag (7 = KEM key color-compatible compressed)
+    compressed[0] = 0x01; // Version 1
+    compressed[1] = 0x07; // Compression flag (7 = KEM key color-compatible compressed)
 
     // Store key data size
     uint32_t data_size = key_data.size();
-    compressed.push_back(static_cast<uint8_t>(data_size >> 24));
-    compressed.push_back(static_cast<uint8_t>(data_size >> 16));
-    compressed.push_back(static_cast<uint8_t>(data_size >> 8));
-    compressed.push_back(static_cast<uint8_t>(data_size & 0xFF));
-
-    // Compress the coefficients using variable-length encoding
-    // Each coefficient is 4 bytes (uint32_t big-endian)
-    for (size_t i = 0; i < key_data.size(); i += 4) {
-        if (i + 3 >= key_data.size()) break;
+    store_be32(compressed.data() + 2, data_size);
+    uint8_t* out = compressed.data() + 6;
 
-        // Reconstruct the uint32_t coefficient from big-endian bytes
+    // Each coefficient is 4 bytes (uint32_t big-endian); a trailing partial one is dropped.
+    // 0x00 for zero, 0x80 | c below 0x40, then 2 and 3-byte codes led by 0xC0 and 0xE0
+    // and 0xF0 followed by all four bytes
+    for (size_t i = 0; i + 4 <= key_data.size(); i += 4) {
         uint32_t coeff = (static_cast<uint32_t>(key_data[i]) << 24) |
                         (static_cast<uint32_t>(key_data[i + 1]) << 16) |
                         (static_cast<uint32_t>(key_data[i + 2]) << 8) |
                         static_cast<uint32_t>(key_data[i + 3]);
 
-        // Apply variable-length encoding for compression
-        if (coeff == 0) {
-            compressed.push_back(0x00); // Single byte for zero
-        } else if (coeff < 0x40) {
-            compressed.push_back(static_cast<uint8_t>(coeff | 0x80)); // 1 byte (0x80-0xBF)
-        } else if (coeff < 0x2000) {
-            compressed.push_back(static_cast<uint8_t>((coeff >> 8) | 0xC0)); // 2 bytes (0xC0-0xDF)
-            compressed.push_back(static_cast<uint8_t>(coeff & 0xFF));
-        } else if (coeff < 0x100000) {
-            compressed.push_back(static_cast<uint8_t>((coeff >> 16) | 0xE0)); // 3 bytes (0xE0-0xEF)
-            compressed.push_back(static_cast<uint8_t>((coeff >> 8) & 0xFF));
-            compressed.push_back(static_cast<uint8_t>(coeff & 0xFF));
-        } else {
-            // For larger values, use 5 bytes (0xF0 + 4 bytes)
-            compressed.push_back(0xF0);
-            compressed.push_back(static_cast<uint8_t>((coeff >> 24) & 0xFF));
-            compressed.push_back(static_cast<uint8_t>((coeff >> 16) & 0xFF));
-            compressed.push_back(static_cast<uint8_t>((coeff >> 8) & 0xFF));
-            compressed.push_back(static_cast<uint8_t>(coeff & 0xFF));
-        }
+        uint32_t index = (coeff >= 0x40) + (coeff >= 0x2000) + (coeff >= 0x100000);
+        uint32_t length = COMPRESSED_LENGTHS[index];
+        uint64_t prefix = (coeff == 0) ? 0 : COMPRESSED_PREFIXES[index];
+        uint64_t code = (prefix << (8 * (length - 1))) | coeff;
+        store_be64(out, code << (8 * (8 - length)));
+        out += length;
     }
 
+    compressed.resize(out - compressed.data());
     return compressed;
 }
 
@@ -148,52 +196,56 @@ std::vector<uint8_t> decode_colors_to_color_kem_key_compressed(const std::vector
     }
 
     // Decompress the coefficients using variable-length decoding
-    std::vector<uint8_t> key_data;
-    key_data.reserve(data_size);
-
     size_t num_coeffs = data_size / 4; // Each coefficient is 4 bytes
+    std::vector<uint8_t> key_data(num_coeffs * 4);
+    uint8_t* out = key_data.data();
+    const uint8_t* data = color_data.data();
+    const size_t size = color_data.size();
     size_t coeff_idx = 0;
 
-    while (coeff_idx < num_coeffs && offset < color_data.size()) {
-        if (offset >= color_data.size()) {
-            throw std::invalid_argument("Truncated compressed color data");
+    // Runs of four two-byte codes (uniform coefficients) are decoded a 64-bit word at a
+    // time, other codes through the leading-byte table. Decoding stops early if the
+    // data ends on a code boundary, which the size check below reports.
+    while (coeff_idx < num_coeffs && offset < size) {
+        if (offset + 8 <= size && coeff_idx + 4 <= num_coeffs) {
+            uint64_t word = load_be64(data + offset);
+            if (four_two_byte_codes(word)) {
+                for (int c = 0; c < 4; ++c) {
+                    store_be32(out, static_cast<uint32_t>(word >> (48 - 16 * c)) & 0x1FFF);
+                    out += 4;
+                }
+                offset += 8;
+                coeff_idx += 4;
+                continue;
+            }
         }
 
-        uint8_t first_byte = color_data[offset++];
-        uint32_t coeff = 0;
-
-        if (first_byte == 0x00) {
-            coeff = 0;
-        } else if ((first_byte & 0xC0) == 0x80) {
-            // 1-byte encoding: 0x80-0xBF
-            coeff = first_byte & 0x3F;
-        } else if ((first_byte & 0xE0) == 0xC0) {
-            // 2-byte encoding: 0xC0-0xDF
-            if (offset >= color_data.size()) throw std::invalid_argument("Truncated compressed color data");
-            coeff = ((first_byte & 0x1F) << 8) | color_data[offset++];
-        } else if ((first_byte & 0xF0) == 0xE0) {
-            // 3-byte encoding: 0xE0-0xEF
-            if (offset + 1 >= color_data.size()) throw std::invalid_argument("Truncated compressed color data");
-            coeff = ((first_byte & 0x0F) << 16) | (color_data[offset] << 8) | color_data[offset + 1];
-            offset += 2;
-        } else if (first_byte == 0xF0) {
-            // 5-byte encoding: 0xF0 + 4 bytes
-            if (offset + 3 >= color_data.size()) throw std::invalid_argument("Truncated compressed color data");
-            coeff = (color_data[offset] << 24) | (color_data[offset + 1] << 16) | (color_data[offset + 2] << 8) | color_data[offset + 3];
-            offset += 4;
-        } else {
+        uint8_t first_byte = data[offset];
+        const CompressedLead& lead = COMPRESSED_LEADS.entries[first_byte];
+        if (lead.length == 0) {
             throw std::invalid_argument("Invalid KEM key color-compatible compression encoding");
         }
+        if (offset + lead.length > size) {
+            throw std::invalid_argument("Truncated compressed color data");
+        }
+        uint32_t coeff = first_byte & lead.mask;
+        if (lead.length <= 3 && offset + 3 <= size) {
+            uint32_t tail = (static_cast<uint32_t>(data[offset + 1]) << 8) | data[offset + 2];
+            coeff = (coeff << lead.lead_shift) | (tail >> lead.tail_shift);
+        } else {
+            for (uint32_t b = 1; b < lead.length; ++b) {
+                coeff = (coeff << 8) | data[offset + b];
+            }
+        }
+        offset += lead.length;
 
         // Convert back to 4-byte big-endian representation
-        key_data.push_back(static_cast<uint8_t>((coeff >> 24) & 0xFF));
-        key_data.push_back(static_cast<uint8_t>((coeff >> 16) & 0xFF));
-        key_data.push_back(static_cast<uint8_t>((coeff >> 8) & 0xFF));
-        key_data.push_back(static_cast<uint8_t>(coeff & 0xFF));
-
+        store_be32(out, coeff);
+        out += 4;
         coeff_idx++;
     }
 
+    key_data.resize(coeff_idx * 4);
     if (key_data.size() != expected_size) {
         throw std::invalid_argument("Decompressed key data size does not match expected size: got " + std::to_string(key_data.size()) + ", expected " + std::to_string(expected_size));
     }
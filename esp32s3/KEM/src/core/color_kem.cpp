@@ -2,6 +2,10 @@
 #include "clwe/shake_sampler.hpp"
 #include "clwe/utils.hpp"
 #include "clwe/color_integration.hpp"
+#include "clwe/dual_core_executor.hpp"
+#include "clwe/noise_pool.hpp"
+#include "clwe/stage_profile.hpp"
+#include <atomic>
 #include <random>
 #include <cstring>
 #include <algorithm>
@@ -10,54 +14,96 @@
 
 namespace clwe {
 
+namespace {
+
+// Noise coefficients are at most eta2 <= 16 from zero, so a signed byte holds them
+uint8_t to_centered_byte(const ColorValue& coeff, uint32_t modulus) {
+    int32_t value = static_cast<int32_t>(coeff.to_math_value());
+    if (value > static_cast<int32_t>(modulus / 2)) {
+        value -= static_cast<int32_t>(modulus);
+    }
+    return static_cast<uint8_t>(static_cast<int8_t>(value));
+}
+
+ColorValue from_centered_byte(uint8_t byte, uint32_t modulus) {
+    int32_t value = static_cast<int8_t>(byte);
+    return ColorValue::from_math_value(static_cast<uint32_t>(value < 0 ? value + static_cast<int32_t>(modulus) : value));
+}
+
+} // namespace
+
 ColorKEM::ColorKEM(const CLWEParameters& params)
-    : params_(params) {
+    : params_(params), executor_(nullptr), noise_pool_(nullptr) {
     color_ntt_engine_ = std::unique_ptr<ColorNTTEngine>(new ColorNTTEngine(params_.modulus, params_.degree));
 }
 
 ColorKEM::~ColorKEM() = default;
 
-std::vector<std::vector<std::vector<ColorValue>>> ColorKEM::generate_matrix_A(const std::array<uint8_t, 32>& seed) const {
+std::vector<std::vector<ColorValue>> ColorKEM::generate_matrix_A_row(const std::array<uint8_t, 32>& seed, uint32_t i) const {
     uint32_t k = params_.module_rank;
     uint32_t n = params_.degree;
-    uint32_t q = params_.modulus;
 
-    std::vector<std::vector<std::vector<ColorValue>>> matrix(k, std::vector<std::vector<ColorValue>>(k, std::vector<ColorValue>(n)));
+    std::vector<ColorValue> flat(k * n);
+    generate_matrix_A_row(seed, i, flat.data());
 
-    for (uint32_t i = 0; i < k; ++i) {
-        for (uint32_t j = 0; j < k; ++j) {
+    std::vector<std::vector<ColorValue>> row(k);
+    for (uint32_t j = 0; j < k; ++j) {
+        row[j].assign(flat.begin() + j * n, flat.begin() + (j + 1) * n);
+    }
+    return row;
+}
 
-            std::vector<uint8_t> shake_input;
-            shake_input.reserve(seed.size() + 2);
-            shake_input.insert(shake_input.end(), seed.begin(), seed.end());
-            shake_input.push_back(static_cast<uint8_t>(i));
-            shake_input.push_back(static_cast<uint8_t>(j));
+void ColorKEM::generate_matrix_A_row(const std::array<uint8_t, 32>& seed, uint32_t i, ColorValue* row) const {
+    for (uint32_t j = 0; j < params_.module_rank; ++j) {
+        generate_matrix_A_entry(seed, i, j, row + j * params_.degree);
+    }
+}
 
+void ColorKEM::generate_matrix_A_entry(const std::array<uint8_t, 32>& seed, uint32_t i, uint32_t j, ColorValue* poly) const {
+    StageTimer timer(KemStage::MatrixExpansion);
+    uint32_t n = params_.degree;
+    uint32_t q = params_.modulus;
 
-            SHAKE128Sampler shake128;
-            shake128.init(shake_input.data(), shake_input.size());
+    std::array<uint8_t, 34> shake_input;
+    std::copy(seed.begin(), seed.end(), shake_input.begin());
+    shake_input[32] = static_cast<uint8_t>(i);
+    shake_input[33] = static_cast<uint8_t>(j);
 
+    SHAKE128Sampler shake128;
+    shake128.init(shake_input.data(), shake_input.size());
 
-            size_t coeff_idx = 0;
-            while (coeff_idx < n) {
-                std::array<uint8_t, 3> bytes;
-                shake128.squeeze(bytes.data(), bytes.size());
+    // A rate block holds 56 whole 3-byte groups, so parsing block by block reads
+    // the same stream as squeezing 3 bytes at a time
+    size_t coeff_idx = 0;
+    std::array<uint8_t, SHAKE128Sampler::BLOCK_BYTES> block;
+    while (coeff_idx < n) {
+        shake128.squeeze_blocks(block.data(), 1);
 
-                uint16_t coeff1 = ((bytes[0] << 4) | (bytes[1] >> 4)) & 0xFFF;
-                uint16_t coeff2 = ((bytes[1] << 8) | bytes[2]) & 0xFFF;
+        for (size_t pos = 0; pos < block.size() && coeff_idx < n; pos += 3) {
+            const uint8_t* bytes = block.data() + pos;
+            uint16_t coeff1 = ((bytes[0] << 4) | (bytes[1] >> 4)) & 0xFFF;
+            uint16_t coeff2 = ((bytes[1] << 8) | bytes[2]) & 0xFFF;
 
-                if (coeff1 < q && coeff_idx < n) {
-                    matrix[i][j][coeff_idx++] = ColorValue::from_math_value(coeff1);
-                }
-                if (coeff2 < q && coeff_idx < n) {
-                    matrix[i][j][coeff_idx++] = ColorValue::from_math_value(coeff2);
-                }
+            if (coeff1 < q && coeff_idx < n) {
+                poly[coeff_idx++] = ColorValue::from_math_value(coeff1);
+            }
+            if (coeff2 < q && coeff_idx < n) {
+                poly[coeff_idx++] = ColorValue::from_math_value(coeff2);
             }
         }
     }
+}
+
+std::vector<std::vector<std::vector<ColorValue>>> ColorKEM::generate_matrix_A(const std::array<uint8_t, 32>& seed) const {
+    std::vector<std::vector<std::vector<ColorValue>>> matrix(params_.module_rank);
+
+    for (uint32_t i = 0; i < params_.module_rank; ++i) {
+        matrix[i] = generate_matrix_A_row(seed, i);
+    }
 
     return matrix;
 }
+
 std::vector<std::vector<ColorValue>> ColorKEM::generate_error_vector(uint32_t eta) const {
     std::vector<std::vector<ColorValue>> error_vector(params_.module_rank, std::vector<ColorValue>(params_.degree));
 
@@ -136,11 +182,9 @@ std::vector<std::vector<ColorValue>> ColorKEM::generate_secret_key_deterministic
 }
 
 
-std::vector<std::vector<ColorValue>> ColorKEM::generate_public_key(const std::vector<std::vector<ColorValue>>& secret_key,
-                                                     const std::vector<std::vector<std::vector<ColorValue>>>& matrix_A,
+std::vector<std::vector<ColorValue>> ColorKEM::generate_public_key(const std::vector<std::vector<ColorValue>>& As,
                                                      const std::vector<std::vector<ColorValue>>& error_vector) const {
 
-    auto As = this->matrix_vector_mul(matrix_A, secret_key);
     std::vector<std::vector<ColorValue>> public_key(params_.module_rank, std::vector<ColorValue>(params_.degree));
 
     for (uint32_t i = 0; i < params_.module_rank; ++i) {
@@ -261,6 +305,64 @@ std::vector<std::vector<ColorValue>> ColorKEM::matrix_transpose_vector_mul(const
 
 
 
+std::vector<std::vector<ColorValue>> ColorKEM::expand_and_multiply(const std::array<uint8_t, 32>& seed, bool transpose,
+                                                                    const std::function<void()>& sample,
+                                                                    const std::vector<std::vector<ColorValue>>& vector) const {
+    uint32_t k = params_.module_rank;
+    uint32_t n = params_.degree;
+    const PlacementPolicy& policy = placement_policy();
+    PlacedVector<ColorValue> scratch(3 * n, PlacementAllocator<ColorValue>(policy.scratch));
+    ColorValue* product = scratch.data() + 2 * n;
+    std::vector<std::vector<ColorValue>> result(k, std::vector<ColorValue>(n, ColorValue(0, 0, 0, 0)));
+
+    auto accumulate = [&](std::vector<ColorValue>& sum, const ColorValue* a, const std::vector<ColorValue>& b) {
+        color_ntt_engine_->multiply_colors(a, b.data(), product, scratch.data());
+        for (uint32_t d = 0; d < n; ++d) {
+            uint64_t s_val = sum[d].to_math_value();
+            uint64_t p_val = product[d].to_math_value();
+            sum[d] = ColorValue::from_math_value((s_val + p_val) % params_.modulus);
+        }
+    };
+
+    if (executor_ == nullptr) {
+        // Each entry of A is consumed as soon as it is expanded, so one polynomial of A is live
+        sample();
+        PlacedVector<ColorValue> entry(n, PlacementAllocator<ColorValue>(policy.matrix));
+        for (uint32_t i = 0; i < k; ++i) {
+            for (uint32_t j = 0; j < k; ++j) {
+                generate_matrix_A_entry(seed, i, j, entry.data());
+                if (transpose) {
+                    accumulate(result[j], entry.data(), vector[i]);
+                } else {
+                    accumulate(result[i], entry.data(), vector[j]);
+                }
+            }
+        }
+        return result;
+    }
+
+    // Row i of A comes from the worker while the caller samples and folds in earlier rows.
+    // A * v needs row i for result[i]; A^T * v takes row i's contribution to every result[c].
+    // The worker runs ahead of the caller, so every row keeps its own buffer.
+    PlacedVector<ColorValue> matrix(k * k * n, PlacementAllocator<ColorValue>(policy.matrix));
+    auto row = [&](uint32_t i) { return matrix.data() + i * k * n; };
+    executor_->run_pipeline(k,
+        [&](uint32_t i) { generate_matrix_A_row(seed, i, row(i)); },
+        sample,
+        [&](uint32_t i) {
+            for (uint32_t j = 0; j < k; ++j) {
+                if (transpose) {
+                    accumulate(result[j], row(i) + j * n, vector[i]);
+                } else {
+                    accumulate(result[i], row(i) + j * n, vector[j]);
+                }
+            }
+        });
+
+    return result;
+}
+
+
 ColorValue ColorKEM::decrypt_message(const std::vector<std::vector<ColorValue>>& secret_key,
                                      const std::vector<std::vector<ColorValue>>& ciphertext) const {
 
@@ -292,6 +394,13 @@ ColorValue ColorKEM::decrypt_message(const std::vector<std::vector<ColorValue>>&
     uint64_t s_dot_c1 = s_dot_c1_poly[0].to_math_value(); // Constant term
 
     uint64_t c2_val = c2[0].to_math_value(); // Constant term
+    return decode_message(c2_val, s_dot_c1);
+}
+
+
+ColorValue ColorKEM::decode_message(uint64_t c2_val, uint64_t s_dot_c1) const {
+    uint32_t q = params_.modulus;
+
     // Constant-time modular subtraction: v = (c2_val - s_dot_c1) mod q
     uint64_t diff_v = c2_val - s_dot_c1;
     uint64_t mask_v = -static_cast<uint64_t>(static_cast<int64_t>(diff_v) >> 63);
@@ -350,6 +459,7 @@ ColorValue ColorKEM::decode_color_secret(const std::vector<uint8_t>& encoded) co
 
 
 std::pair<ColorPublicKey, ColorPrivateKey> ColorKEM::keygen() {
+    OperationTrace trace(KemOperation::Keygen);
 
     std::array<uint8_t, 32> matrix_seed;
     secure_random_bytes(matrix_seed.data(), matrix_seed.size());
@@ -358,43 +468,27 @@ std::pair<ColorPublicKey, ColorPrivateKey> ColorKEM::keygen() {
     // for (uint8_t b : matrix_seed) std::cout << std::hex << std::setw(2) << std::setfill('0') << (int)b;
     // std::cout << std::dec << std::endl;
 
-    auto matrix_A = generate_matrix_A(matrix_seed);
-    // std::cout << "DEBUG: Matrix A generated (" << matrix_A.size() << "x" << matrix_A[0].size() << ")" << std::endl;
-
-    auto secret_key_colors = generate_secret_key(params_.eta1);
+    std::vector<std::vector<ColorValue>> secret_key_colors;
+    std::vector<std::vector<ColorValue>> error_vector;
+    auto As = expand_and_multiply(matrix_seed, false, [&] {
+        secret_key_colors = generate_secret_key(params_.eta1);
+        error_vector = generate_error_vector(params_.eta1);
+    }, secret_key_colors);
     // std::cout << "DEBUG: Secret key generated (" << secret_key_colors.size() << " elements)" << std::endl;
     // for (size_t i = 0; i < secret_key_colors.size(); ++i) {
     //     std::cout << "  s[" << i << "] = " << secret_key_colors[i].to_math_value() << std::endl;
     // }
 
-    auto error_vector = generate_error_vector(params_.eta1);
-    // std::cout << "DEBUG: Error vector generated (" << error_vector.size() << " elements)" << std::endl;
-    // for (size_t i = 0; i < error_vector.size(); ++i) {
-    //     std::cout << "  e[" << i << "] = " << error_vector[i].to_math_value() << std::endl;
-    // }
-
-    auto public_key_colors = generate_public_key(secret_key_colors, matrix_A, error_vector);
+    auto public_key_colors = generate_public_key(As, error_vector);
     // std::cout << "DEBUG: Public key generated (" << public_key_colors.size() << " elements)" << std::endl;
     // for (size_t i = 0; i < public_key_colors.size(); ++i) {
     //     std::cout << "  t[" << i << "] = " << public_key_colors[i].to_math_value() << std::endl;
     // }
 
 
-    std::vector<uint8_t> secret_data;
-    for (const auto& poly : secret_key_colors) {
-        for (const auto& coeff : poly) {
-            auto bytes = color_secret_to_bytes(coeff);
-            secret_data.insert(secret_data.end(), bytes.begin(), bytes.end());
-        }
-    }
+    std::vector<uint8_t> secret_data = pack_colors(secret_key_colors);
 
-    std::vector<uint8_t> public_data;
-    for (const auto& poly : public_key_colors) {
-        for (const auto& coeff : poly) {
-            auto bytes = color_secret_to_bytes(coeff);
-            public_data.insert(public_data.end(), bytes.begin(), bytes.end());
-        }
-    }
+    std::vector<uint8_t> public_data = pack_colors(public_key_colors);
 
     ColorPublicKey public_key{matrix_seed, public_data, params_};
     ColorPrivateKey private_key{secret_data, params_};
@@ -405,31 +499,21 @@ std::pair<ColorPublicKey, ColorPrivateKey> ColorKEM::keygen() {
 std::pair<ColorPublicKey, ColorPrivateKey> ColorKEM::keygen_deterministic(const std::array<uint8_t, 32>& matrix_seed,
                                                                        const std::array<uint8_t, 32>& secret_seed,
                                                                        const std::array<uint8_t, 32>& error_seed) {
+    OperationTrace trace(KemOperation::Keygen);
 
-    auto matrix_A = generate_matrix_A(matrix_seed);
+    std::vector<std::vector<ColorValue>> secret_key_colors;
+    std::vector<std::vector<ColorValue>> error_vector;
+    auto As = expand_and_multiply(matrix_seed, false, [&] {
+        secret_key_colors = generate_secret_key_deterministic(params_.eta1, secret_seed);
+        error_vector = generate_error_vector_deterministic(params_.eta1, error_seed);
+    }, secret_key_colors);
 
-    auto secret_key_colors = generate_secret_key_deterministic(params_.eta1, secret_seed);
+    auto public_key_colors = generate_public_key(As, error_vector);
 
-    auto error_vector = generate_error_vector_deterministic(params_.eta1, error_seed);
 
-    auto public_key_colors = generate_public_key(secret_key_colors, matrix_A, error_vector);
+    std::vector<uint8_t> secret_data = pack_colors(secret_key_colors);
 
-
-    std::vector<uint8_t> secret_data;
-    for (const auto& poly : secret_key_colors) {
-        for (const auto& coeff : poly) {
-            auto bytes = color_secret_to_bytes(coeff);
-            secret_data.insert(secret_data.end(), bytes.begin(), bytes.end());
-        }
-    }
-
-    std::vector<uint8_t> public_data;
-    for (const auto& poly : public_key_colors) {
-        for (const auto& coeff : poly) {
-            auto bytes = color_secret_to_bytes(coeff);
-            public_data.insert(public_data.end(), bytes.begin(), bytes.end());
-        }
-    }
+    std::vector<uint8_t> public_data = pack_colors(public_key_colors);
 
     ColorPublicKey public_key{matrix_seed, public_data, params_};
     ColorPrivateKey private_key{secret_data, params_};
@@ -439,6 +523,11 @@ std::pair<ColorPublicKey, ColorPrivateKey> ColorKEM::keygen_deterministic(const
 
 
 std::pair<ColorCiphertext, ColorValue> ColorKEM::encapsulate(const ColorPublicKey& public_key) {
+    return encapsulate(ColorPublicKeyView(public_key));
+}
+
+std::pair<ColorCiphertext, ColorValue> ColorKEM::encapsulate(const ColorPublicKeyView& public_key) {
+    OperationTrace trace(KemOperation::Encapsulate);
 
     // Validate public key parameters match instance parameters
     if (public_key.params.security_level != params_.security_level ||
@@ -449,52 +538,51 @@ std::pair<ColorCiphertext, ColorValue> ColorKEM::encapsulate(const ColorPublicKe
     }
 
     // Validate public key data size
-    if (public_key.public_data.size() != params_.module_rank * params_.degree * 4) {
-        throw std::invalid_argument("Invalid public key data size: expected " + std::to_string(params_.module_rank * params_.degree * 4) + " bytes, got " + std::to_string(public_key.public_data.size()));
+    if (public_key.public_data_size != params_.module_rank * params_.degree * 4) {
+        throw std::invalid_argument("Invalid public key data size: expected " + std::to_string(params_.module_rank * params_.degree * 4) + " bytes, got " + std::to_string(public_key.public_data_size));
     }
 
-    // Validate public key data is not empty and properly sized
-    if (public_key.public_data.empty()) {
+    // Validate public key data is present
+    if (public_key.public_data == nullptr || public_key.seed == nullptr) {
         throw std::invalid_argument("Public key data cannot be empty");
     }
+    std::array<uint8_t, 32> seed;
+    std::copy(public_key.seed, public_key.seed + seed.size(), seed.begin());
 
-    uint8_t byte;
-    secure_random_bytes(&byte, 1);
-    ColorValue shared_secret = ColorValue::from_math_value(byte & 1);
+    std::vector<std::vector<ColorValue>> r_vector;
+    std::vector<std::vector<ColorValue>> e1_vector;
+    ColorValue e2;
+    ColorValue shared_secret;
+    bool precomputed = take_precomputed_noise(r_vector, e1_vector, e2, shared_secret);
+    if (!precomputed) {
+        uint8_t byte;
+        secure_random_bytes(&byte, 1);
+        shared_secret = ColorValue::from_math_value(byte & 1);
+    }
     // std::cout << "DEBUG ENCAP: Shared secret = " << shared_secret.to_precise_value() << std::endl;
 
-    auto matrix_A = generate_matrix_A(public_key.seed);
-    // std::cout << "DEBUG ENCAP: Regenerated matrix A from seed" << std::endl;
-
-    std::vector<std::vector<ColorValue>> public_key_colors(params_.module_rank, std::vector<ColorValue>(params_.degree));
-    size_t idx = 0;
-    for (size_t i = 0; i < params_.module_rank; ++i) {
-        for (size_t d = 0; d < params_.degree; ++d) {
-            std::vector<uint8_t> bytes(public_key.public_data.begin() + idx,
-                                       public_key.public_data.begin() + idx + 4);
-            public_key_colors[i][d] = bytes_to_color_secret(bytes);
-            idx += 4;
-        }
-    }
+    std::vector<std::vector<ColorValue>> public_key_colors = unpack_colors(public_key.public_data, params_.module_rank);
     // std::cout << "DEBUG ENCAP: Public key colors (" << public_key_colors.size() << " elements):" << std::endl;
     // for (size_t i = 0; i < public_key_colors.size(); ++i) {
     //     std::cout << "  t[" << i << "] = " << public_key_colors[i].to_math_value() << std::endl;
     // }
 
-    auto ciphertext_colors = encrypt_message(matrix_A, public_key_colors, shared_secret);
+    auto ciphertext_colors = precomputed
+        ? encrypt_with_noise(seed, public_key_colors, shared_secret,
+                             [&](std::vector<std::vector<ColorValue>>& r, std::vector<std::vector<ColorValue>>& e1,
+                                 ColorValue& e2_out) {
+                                 r = std::move(r_vector);
+                                 e1 = std::move(e1_vector);
+                                 e2_out = e2;
+                             })
+        : encrypt_message(seed, public_key_colors, shared_secret);
     // std::cout << "DEBUG ENCAP: Ciphertext colors (" << ciphertext_colors.size() << " elements):" << std::endl;
     // for (size_t i = 0; i < ciphertext_colors.size(); ++i) {
     //     std::cout << "  c[" << i << "] = " << ciphertext_colors[i].to_math_value() << std::endl;
     // }
 
 
-    std::vector<uint8_t> ciphertext_data;
-    for (const auto& poly : ciphertext_colors) {
-        for (const auto& coeff : poly) {
-            auto bytes = color_secret_to_bytes(coeff);
-            ciphertext_data.insert(ciphertext_data.end(), bytes.begin(), bytes.end());
-        }
-    }
+    std::vector<uint8_t> ciphertext_data = pack_colors(ciphertext_colors);
 
 
     auto shared_secret_hint = encode_color_secret(shared_secret);
@@ -509,6 +597,7 @@ std::pair<ColorCiphertext, ColorValue> ColorKEM::encapsulate_deterministic(const
                                                                         const std::array<uint8_t, 32>& e1_seed,
                                                                         const std::array<uint8_t, 32>& e2_seed,
                                                                         const ColorValue& shared_secret) {
+    OperationTrace trace(KemOperation::Encapsulate);
 
     // Validate public key parameters match instance parameters
     if (public_key.params.security_level != params_.security_level ||
@@ -528,29 +617,12 @@ std::pair<ColorCiphertext, ColorValue> ColorKEM::encapsulate_deterministic(const
         throw std::invalid_argument("Public key data cannot be empty");
     }
 
-    auto matrix_A = generate_matrix_A(public_key.seed);
-
-    std::vector<std::vector<ColorValue>> public_key_colors(params_.module_rank, std::vector<ColorValue>(params_.degree));
-    size_t idx = 0;
-    for (size_t i = 0; i < params_.module_rank; ++i) {
-        for (size_t d = 0; d < params_.degree; ++d) {
-            std::vector<uint8_t> bytes(public_key.public_data.begin() + idx,
-                                       public_key.public_data.begin() + idx + 4);
-            public_key_colors[i][d] = bytes_to_color_secret(bytes);
-            idx += 4;
-        }
-    }
+    std::vector<std::vector<ColorValue>> public_key_colors = unpack_colors(public_key.public_data, params_.module_rank);
 
-    auto ciphertext_colors = encrypt_message_deterministic(matrix_A, public_key_colors, shared_secret, r_seed, e1_seed, e2_seed);
+    auto ciphertext_colors = encrypt_message_deterministic(public_key.seed, public_key_colors, shared_secret, r_seed, e1_seed, e2_seed);
 
 
-    std::vector<uint8_t> ciphertext_data;
-    for (const auto& poly : ciphertext_colors) {
-        for (const auto& coeff : poly) {
-            auto bytes = color_secret_to_bytes(coeff);
-            ciphertext_data.insert(ciphertext_data.end(), bytes.begin(), bytes.end());
-        }
-    }
+    std::vector<uint8_t> ciphertext_data = pack_colors(ciphertext_colors);
 
 
     auto shared_secret_hint = encode_color_secret(shared_secret);
@@ -564,6 +636,7 @@ std::pair<ColorCiphertext, ColorValue> ColorKEM::encapsulate_deterministic(const
 ColorValue ColorKEM::decapsulate(const ColorPublicKey& public_key,
                                 const ColorPrivateKey& private_key,
                                 const ColorCiphertext& ciphertext) {
+    OperationTrace trace(KemOperation::Decapsulate);
 
     // Validate public key parameters match instance parameters
     if (public_key.params.security_level != params_.security_level ||
@@ -599,16 +672,7 @@ ColorValue ColorKEM::decapsulate(const ColorPublicKey& public_key,
         throw std::invalid_argument("Private key data cannot be empty");
     }
 
-    std::vector<std::vector<ColorValue>> secret_key_colors(params_.module_rank, std::vector<ColorValue>(params_.degree));
-    size_t idx_sk = 0;
-    for (size_t i = 0; i < params_.module_rank; ++i) {
-        for (size_t d = 0; d < params_.degree; ++d) {
-            std::vector<uint8_t> bytes(private_key.secret_data.begin() + idx_sk,
-                                       private_key.secret_data.begin() + idx_sk + 4);
-            secret_key_colors[i][d] = bytes_to_color_secret(bytes);
-            idx_sk += 4;
-        }
-    }
+    std::vector<std::vector<ColorValue>> secret_key_colors = unpack_colors(private_key.secret_data, params_.module_rank);
     // std::cout << "DEBUG DECAP: Secret key colors (" << secret_key_colors.size() << " elements):" << std::endl;
     // for (size_t i = 0; i < secret_key_colors.size(); ++i) {
     //     std::cout << "  s[" << i << "] = " << secret_key_colors[i].to_math_value() << std::endl;
@@ -629,16 +693,7 @@ ColorValue ColorKEM::decapsulate(const ColorPublicKey& public_key,
         throw std::invalid_argument("Invalid shared secret hint size: expected 4 bytes, got " + std::to_string(ciphertext.shared_secret_hint.size()));
     }
 
-    std::vector<std::vector<ColorValue>> ciphertext_colors(params_.module_rank + 1, std::vector<ColorValue>(params_.degree));
-    size_t idx = 0;
-    for (size_t i = 0; i < params_.module_rank + 1; ++i) {
-        for (size_t d = 0; d < params_.degree; ++d) {
-            std::vector<uint8_t> bytes(ciphertext.ciphertext_data.begin() + idx,
-                                       ciphertext.ciphertext_data.begin() + idx + 4);
-            ciphertext_colors[i][d] = bytes_to_color_secret(bytes);
-            idx += 4;
-        }
-    }
+    std::vector<std::vector<ColorValue>> ciphertext_colors = unpack_colors(ciphertext.ciphertext_data, params_.module_rank + 1);
     // std::cout << "DEBUG DECAP: Ciphertext colors (" << ciphertext_colors.size() << " elements):" << std::endl;
     // for (size_t i = 0; i < ciphertext_colors.size(); ++i) {
     //     std::cout << "  c[" << i << "] = " << ciphertext_colors[i].to_math_value() << std::endl;
@@ -656,6 +711,72 @@ ColorValue ColorKEM::decapsulate(const ColorPublicKey& public_key,
     }
 }
 
+ColorValue ColorKEM::decapsulate(const ColorPrivateKeyView& private_key, const ColorCiphertext& ciphertext) {
+    OperationTrace trace(KemOperation::Decapsulate);
+    const uint32_t k = params_.module_rank;
+    const uint32_t n = params_.degree;
+    const uint32_t q = params_.modulus;
+
+    if (private_key.params.security_level != params_.security_level ||
+        private_key.params.modulus != params_.modulus ||
+        private_key.params.degree != params_.degree ||
+        private_key.params.module_rank != params_.module_rank) {
+        throw std::invalid_argument("Private key parameters do not match KEM instance parameters");
+    }
+    if (private_key.prepared_secret == nullptr) {
+        throw std::invalid_argument("Private key data cannot be empty");
+    }
+    if (ciphertext.params.security_level != params_.security_level ||
+        ciphertext.params.modulus != params_.modulus ||
+        ciphertext.params.degree != params_.degree ||
+        ciphertext.params.module_rank != params_.module_rank) {
+        throw std::invalid_argument("Ciphertext parameters do not match KEM instance parameters");
+    }
+    if (ciphertext.ciphertext_data.size() != (k + 1) * n * 4) {
+        throw std::invalid_argument("Invalid ciphertext data size: expected " + std::to_string((k + 1) * n * 4) + " bytes, got " + std::to_string(ciphertext.ciphertext_data.size()));
+    }
+    if (ciphertext.shared_secret_hint.size() != 4) {
+        throw std::invalid_argument("Invalid shared secret hint size: expected 4 bytes, got " + std::to_string(ciphertext.shared_secret_hint.size()));
+    }
+
+    // c1[i] and the product in RAM, s_hat[i] read where it lies; only the constant term of
+    // s^T c1 is used, so the products are not summed beyond it
+    PlacedVector<ColorValue> scratch(3 * n, PlacementAllocator<ColorValue>(placement_policy().scratch));
+    ColorValue* c1 = scratch.data();
+    ColorValue* product = c1 + n;
+    const uint8_t* data = ciphertext.ciphertext_data.data();
+    uint64_t s_dot_c1 = 0;
+    for (uint32_t i = 0; i < k; ++i) {
+        {
+            StageTimer timer(KemStage::Packing);
+            for (uint32_t d = 0; d < n; ++d) {
+                const uint8_t* bytes = data + (static_cast<size_t>(i) * n + d) * 4;
+                c1[d] = ColorValue::from_math_value((static_cast<uint32_t>(bytes[0]) << 24) |
+                                                    (static_cast<uint32_t>(bytes[1]) << 16) |
+                                                    (static_cast<uint32_t>(bytes[2]) << 8) |
+                                                    static_cast<uint32_t>(bytes[3]));
+            }
+        }
+        color_ntt_engine_->multiply_colors_prepared(private_key.prepared_secret + static_cast<size_t>(i) * n, c1,
+                                                    product, product + n);
+        s_dot_c1 = (s_dot_c1 + product[0].to_math_value()) % q;
+    }
+    secure_zero(scratch.data(), scratch.size() * sizeof(ColorValue));
+
+    const uint8_t* c2 = data + static_cast<size_t>(k) * n * 4;
+    uint64_t c2_val = (static_cast<uint32_t>(c2[0]) << 24) | (static_cast<uint32_t>(c2[1]) << 16) |
+                      (static_cast<uint32_t>(c2[2]) << 8) | static_cast<uint32_t>(c2[3]);
+    ColorValue recovered_secret = decode_message(c2_val, s_dot_c1);
+
+    // Fujisaki-Okamoto transform, as decapsulate()
+    ColorValue hinted_secret = decode_color_secret(ciphertext.shared_secret_hint);
+    if (recovered_secret == hinted_secret) {
+        return recovered_secret;
+    } else {
+        return hash_ciphertext(ciphertext);
+    }
+}
+
 ColorValue ColorKEM::hash_ciphertext(const ColorCiphertext& ciphertext) const {
     auto ct_serial = ciphertext.serialize();
     SHAKE256Sampler shake;
@@ -673,6 +794,90 @@ ColorValue ColorKEM::hash_ciphertext(const ColorCiphertext& ciphertext) const {
 }
 
 
+void ColorKEM::set_executor(DualCoreExecutor* executor) {
+    executor_ = executor;
+}
+
+void ColorKEM::set_noise_pool(NoisePool* pool) {
+    if (pool != nullptr && pool->security_level() != params_.security_level) {
+        throw std::invalid_argument("Noise pool was created for security level " +
+                                    std::to_string(pool->security_level()));
+    }
+    noise_pool_ = pool;
+}
+
+size_t ColorKEM::precompute_noise(size_t max_bundles) {
+    if (noise_pool_ == nullptr) {
+        throw std::logic_error("precompute_noise() needs a NoisePool attached with set_noise_pool()");
+    }
+
+    size_t coeffs = static_cast<size_t>(params_.module_rank) * params_.degree;
+    size_t filled = 0;
+    while (filled < max_bundles) {
+        uint8_t* slot = noise_pool_->find_slot(NoisePool::SLOT_EMPTY);
+        if (slot == nullptr) {
+            break;
+        }
+
+        // The same draws encrypt_message() makes
+        uint8_t byte;
+        secure_random_bytes(&byte, 1);
+        auto r_vector = generate_secret_key(params_.eta2);
+        auto e1_vector = generate_error_vector(params_.eta2);
+        auto e2_vector = generate_error_vector(params_.eta2);
+
+        slot[NoisePool::SLOT_MESSAGE] = byte & 1;
+        slot[NoisePool::SLOT_E2] = to_centered_byte(e2_vector[0][0], params_.modulus);
+        uint8_t* r_bytes = slot + NoisePool::SLOT_R;
+        uint8_t* e1_bytes = r_bytes + coeffs;
+        for (uint32_t i = 0; i < params_.module_rank; ++i) {
+            for (uint32_t d = 0; d < params_.degree; ++d) {
+                r_bytes[i * params_.degree + d] = to_centered_byte(r_vector[i][d], params_.modulus);
+                e1_bytes[i * params_.degree + d] = to_centered_byte(e1_vector[i][d], params_.modulus);
+            }
+        }
+        // Published only once complete, so a reset mid-fill leaves the slot empty. The fence
+        // keeps the compiler from moving the flag store ahead of the bundle stores
+        std::atomic_signal_fence(std::memory_order_release);
+        slot[0] = NoisePool::SLOT_READY;
+        ++filled;
+    }
+    return filled;
+}
+
+bool ColorKEM::take_precomputed_noise(std::vector<std::vector<ColorValue>>& r, std::vector<std::vector<ColorValue>>& e1,
+                                      ColorValue& e2, ColorValue& message) {
+    if (noise_pool_ == nullptr) {
+        return false;
+    }
+    uint8_t* slot = noise_pool_->find_slot(NoisePool::SLOT_READY);
+    if (slot == nullptr) {
+        return false;
+    }
+    // Claimed before it is read: a reset from here on loses the bundle instead of reusing it.
+    // The fence pairs with the one in precompute_noise() and keeps the bundle reads after
+    // both the flag read and the claim store
+    slot[0] = NoisePool::SLOT_EMPTY;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+
+    size_t coeffs = static_cast<size_t>(params_.module_rank) * params_.degree;
+    const uint8_t* r_bytes = slot + NoisePool::SLOT_R;
+    const uint8_t* e1_bytes = r_bytes + coeffs;
+    r.assign(params_.module_rank, std::vector<ColorValue>(params_.degree));
+    e1.assign(params_.module_rank, std::vector<ColorValue>(params_.degree));
+    for (uint32_t i = 0; i < params_.module_rank; ++i) {
+        for (uint32_t d = 0; d < params_.degree; ++d) {
+            r[i][d] = from_centered_byte(r_bytes[i * params_.degree + d], params_.modulus);
+            e1[i][d] = from_centered_byte(e1_bytes[i * params_.degree + d], params_.modulus);
+        }
+    }
+    e2 = from_centered_byte(slot[NoisePool::SLOT_E2], params_.modulus);
+    message = ColorValue::from_math_value(slot[NoisePool::SLOT_MESSAGE]);
+
+    secure_zero(slot + 1, noise_pool_->bundle_bytes_ - 1);
+    return true;
+}
+
 bool ColorKEM::verify_keypair(const ColorPublicKey& public_key, const ColorPrivateKey& private_key) const {
     
     return public_key.params.security_level == private_key.params.security_level &&
@@ -680,6 +885,36 @@ bool ColorKEM::verify_keypair(const ColorPublicKey& public_key, const ColorPriva
 }
 
 
+std::vector<uint8_t> ColorKEM::pack_colors(const std::vector<std::vector<ColorValue>>& polys) {
+    StageTimer timer(KemStage::Packing);
+    std::vector<uint8_t> data;
+    for (const auto& poly : polys) {
+        for (const auto& coeff : poly) {
+            auto bytes = color_secret_to_bytes(coeff);
+            data.insert(data.end(), bytes.begin(), bytes.end());
+        }
+    }
+    return data;
+}
+
+std::vector<std::vector<ColorValue>> ColorKEM::unpack_colors(const std::vector<uint8_t>& data, size_t rows) {
+    return unpack_colors(data.data(), rows);
+}
+
+std::vector<std::vector<ColorValue>> ColorKEM::unpack_colors(const uint8_t* data, size_t rows) {
+    StageTimer timer(KemStage::Packing);
+    std::vector<std::vector<ColorValue>> polys(rows, std::vector<ColorValue>(params_.degree));
+    size_t idx = 0;
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t d = 0; d < params_.degree; ++d) {
+            std::vector<uint8_t> bytes(data + idx, data + idx + 4);
+            polys[i][d] = bytes_to_color_secret(bytes);
+            idx += 4;
+        }
+    }
+    return polys;
+}
+
 std::vector<uint8_t> ColorKEM::color_secret_to_bytes(const ColorValue& secret) {
     uint32_t value = secret.to_math_value();
     // Validate value is within reasonable bounds (though ColorValue should ensure this)
@@ -929,19 +1164,10 @@ ColorCiphertext ColorCiphertext::deserialize(const std::vector<uint8_t>& data, c
 }
 
 
-std::vector<std::vector<ColorValue>> ColorKEM::encrypt_message(const std::vector<std::vector<std::vector<ColorValue>>>& matrix_A,
-                                                   const std::vector<std::vector<ColorValue>>& public_key,
-                                                   const ColorValue& message) const {
-
-    // Validate matrix_A dimensions
-    if (matrix_A.size() != params_.module_rank) {
-        throw std::invalid_argument("Invalid matrix_A rows: expected " + std::to_string(params_.module_rank) + ", got " + std::to_string(matrix_A.size()));
-    }
-    for (const auto& row : matrix_A) {
-        if (row.size() != params_.module_rank) {
-            throw std::invalid_argument("Invalid matrix_A columns: expected " + std::to_string(params_.module_rank) + " per row");
-        }
-    }
+std::vector<std::vector<ColorValue>> ColorKEM::encrypt_with_noise(const std::array<uint8_t, 32>& matrix_seed,
+                                                                   const std::vector<std::vector<ColorValue>>& public_key,
+                                                                   const ColorValue& message,
+                                                                   const NoiseSource& sample) const {
 
     // Validate public_key size
     if (public_key.size() != params_.module_rank) {
@@ -955,13 +1181,11 @@ std::vector<std::vector<ColorValue>> ColorKEM::encrypt_message(const std::vector
 
     std::vector<std::vector<ColorValue>> ciphertext(params_.module_rank + 1, std::vector<ColorValue>(params_.degree));
 
-    auto r_vector = generate_secret_key(params_.eta2);
+    std::vector<std::vector<ColorValue>> r_vector;
+    std::vector<std::vector<ColorValue>> e1_vector;
+    ColorValue e2;
+    auto A_trans_r = expand_and_multiply(matrix_seed, true, [&] { sample(r_vector, e1_vector, e2); }, r_vector);
 
-    auto e1_vector = generate_error_vector(params_.eta2);
-    auto e2_vector = generate_error_vector(params_.eta2);
-    auto e2 = e2_vector[0];
-
-    auto A_trans_r = matrix_transpose_vector_mul(matrix_A, r_vector);
     for (uint32_t i = 0; i < params_.module_rank; ++i) {
         for (uint32_t d = 0; d < params_.degree; ++d) {
             uint64_t atr_val = A_trans_r[i][d].to_math_value();
@@ -984,7 +1208,7 @@ std::vector<std::vector<ColorValue>> ColorKEM::encrypt_message(const std::vector
 
     uint64_t inner_product = inner_product_poly[0].to_math_value(); // Constant term
 
-    uint64_t e2_val = e2[0].to_math_value(); // Constant term
+    uint64_t e2_val = e2.to_math_value(); // Constant term
     uint64_t m_val = message.to_math_value();
 
     uint64_t q_half = params_.modulus / 2;
@@ -999,77 +1223,29 @@ std::vector<std::vector<ColorValue>> ColorKEM::encrypt_message(const std::vector
     return ciphertext;
 }
 
-std::vector<std::vector<ColorValue>> ColorKEM::encrypt_message_deterministic(const std::vector<std::vector<std::vector<ColorValue>>>& matrix_A,
+std::vector<std::vector<ColorValue>> ColorKEM::encrypt_message(const std::array<uint8_t, 32>& matrix_seed,
+                                                   const std::vector<std::vector<ColorValue>>& public_key,
+                                                   const ColorValue& message) const {
+    return encrypt_with_noise(matrix_seed, public_key, message,
+        [&](std::vector<std::vector<ColorValue>>& r, std::vector<std::vector<ColorValue>>& e1, ColorValue& e2) {
+            r = generate_secret_key(params_.eta2);
+            e1 = generate_error_vector(params_.eta2);
+            e2 = generate_error_vector(params_.eta2)[0][0];
+        });
+}
+
+std::vector<std::vector<ColorValue>> ColorKEM::encrypt_message_deterministic(const std::array<uint8_t, 32>& matrix_seed,
                                                                 const std::vector<std::vector<ColorValue>>& public_key,
                                                                 const ColorValue& message,
                                                                 const std::array<uint8_t, 32>& r_seed,
                                                                 const std::array<uint8_t, 32>& e1_seed,
                                                                 const std::array<uint8_t, 32>& e2_seed) const {
-
-    // Validate matrix_A dimensions
-    if (matrix_A.size() != params_.module_rank) {
-        throw std::invalid_argument("Invalid matrix_A rows: expected " + std::to_string(params_.module_rank) + ", got " + std::to_string(matrix_A.size()));
-    }
-    for (const auto& row : matrix_A) {
-        if (row.size() != params_.module_rank) {
-            throw std::invalid_argument("Invalid matrix_A columns: expected " + std::to_string(params_.module_rank) + " per row");
-        }
-    }
-
-    // Validate public_key size
-    if (public_key.size() != params_.module_rank) {
-        throw std::invalid_argument("Invalid public_key size: expected " + std::to_string(params_.module_rank) + ", got " + std::to_string(public_key.size()));
-    }
-
-    // Validate message value is within modulus
-    if (message.to_math_value() >= params_.modulus) {
-        throw std::invalid_argument("Invalid message value: must be less than modulus " + std::to_string(params_.modulus));
-    }
-
-    std::vector<std::vector<ColorValue>> ciphertext(params_.module_rank + 1, std::vector<ColorValue>(params_.degree));
-
-    auto r_vector = generate_secret_key_deterministic(params_.eta2, r_seed);
-
-    auto e1_vector = generate_error_vector_deterministic(params_.eta2, e1_seed);
-    auto e2_vector = generate_error_vector_deterministic(params_.eta2, e2_seed);
-    auto e2 = e2_vector[0];
-
-    auto A_trans_r = matrix_transpose_vector_mul(matrix_A, r_vector);
-    for (uint32_t i = 0; i < params_.module_rank; ++i) {
-        for (uint32_t d = 0; d < params_.degree; ++d) {
-            uint64_t atr_val = A_trans_r[i][d].to_math_value();
-            uint64_t e1_val = e1_vector[i][d].to_math_value();
-            uint64_t c1_val = (atr_val + e1_val) % params_.modulus;
-            ciphertext[i][d] = ColorValue::from_math_value(c1_val);
-        }
-    }
-
-    std::vector<ColorValue> inner_product_poly(params_.degree, ColorValue(0, 0, 0, 0));
-    for (uint32_t i = 0; i < params_.module_rank; ++i) {
-        std::vector<ColorValue> product(params_.degree);
-        color_ntt_engine_->multiply_colors(public_key[i].data(), r_vector[i].data(), product.data());
-        for (uint32_t d = 0; d < params_.degree; ++d) {
-            uint64_t ip_val = inner_product_poly[d].to_math_value();
-            uint64_t p_val = product[d].to_math_value();
-            inner_product_poly[d] = ColorValue::from_math_value((ip_val + p_val) % params_.modulus);
-        }
-    }
-
-    uint64_t inner_product = inner_product_poly[0].to_math_value(); // Constant term
-
-    uint64_t e2_val = e2[0].to_math_value(); // Constant term
-    uint64_t m_val = message.to_math_value();
-
-    uint64_t q_half = params_.modulus / 2;
-    uint64_t encoded_m = m_val * q_half;
-    uint64_t c2_val = (inner_product + e2_val + encoded_m) % params_.modulus;
-
-    ciphertext[params_.module_rank][0] = ColorValue::from_math_value(c2_val);
-    for (uint32_t d = 1; d < params_.degree; ++d) {
-        ciphertext[params_.module_rank][d] = ColorValue(0, 0, 0, 0); // Zero elsewhere
-    }
-
-    return ciphertext;
+    return encrypt_with_noise(matrix_seed, public_key, message,
+        [&](std::vector<std::vector<ColorValue>>& r, std::vector<std::vector<ColorValue>>& e1, ColorValue& e2) {
+            r = generate_secret_key_deterministic(params_.eta2, r_seed);
+            e1 = generate_error_vector_deterministic(params_.eta2, e1_seed);
+            e2 = generate_error_vector_deterministic(params_.eta2, e2_seed)[0][0];
+        });
 }
 
 } 
\ No newline at end of file
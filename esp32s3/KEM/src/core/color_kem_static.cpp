@@ -0,0 +1,253 @@
+#ifdef CLWE_STATIC_WORKSPACE
+
+#include "clwe/color_kem.hpp"
+#include "clwe/shake_sampler.hpp"
+#include "clwe/utils.hpp"
+#include "clwe/stage_profile.hpp"
+#include "clwe/tiny_sha3.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace clwe {
+
+namespace {
+
+void store_coeff(const ColorValue& value, uint8_t* out) {
+    uint32_t v = value.to_math_value();
+    out[0] = static_cast<uint8_t>((v >> 24) & 0xFF);
+    out[1] = static_cast<uint8_t>((v >> 16) & 0xFF);
+    out[2] = static_cast<uint8_t>((v >> 8) & 0xFF);
+    out[3] = static_cast<uint8_t>(v & 0xFF);
+}
+
+ColorValue load_coeff(const uint8_t* in) {
+    return ColorValue::from_math_value((static_cast<uint32_t>(in[0]) << 24) |
+                                       (static_cast<uint32_t>(in[1]) << 16) |
+                                       (static_cast<uint32_t>(in[2]) << 8) |
+                                       static_cast<uint32_t>(in[3]));
+}
+
+void store_vector(const ColorValue* vector, size_t count, uint8_t* out) {
+    StageTimer timer(KemStage::Packing);
+    for (size_t i = 0; i < count; ++i) {
+        store_coeff(vector[i], out + 4 * i);
+    }
+}
+
+void load_vector(const uint8_t* in, size_t count, ColorValue* vector) {
+    StageTimer timer(KemStage::Packing);
+    for (size_t i = 0; i < count; ++i) {
+        vector[i] = load_coeff(in + 4 * i);
+    }
+}
+
+} // namespace
+
+void ColorKEM::require_static_params() const {
+    if (params_.security_level != STATIC_SECURITY_LEVEL ||
+        params_.degree != STATIC_DEGREE ||
+        params_.module_rank != STATIC_RANK) {
+        throw std::invalid_argument("Static workspace is built for security level " + std::to_string(STATIC_SECURITY_LEVEL) +
+                                    ", KEM instance uses " + std::to_string(params_.security_level));
+    }
+}
+
+void ColorKEM::sample_vector_into(uint32_t eta, const std::array<uint8_t, 32>* seed, ColorValue* vector) const {
+    // A null seed draws a fresh random seed per polynomial, as generate_secret_key() does
+    for (uint32_t i = 0; i < STATIC_RANK; ++i) {
+        std::array<uint8_t, 32> poly_seed;
+        if (seed != nullptr) {
+            poly_seed = *seed;
+            poly_seed[0] ^= static_cast<uint8_t>(i);
+        } else {
+            secure_random_bytes(poly_seed.data(), poly_seed.size());
+        }
+
+        SHAKE256Sampler sampler;
+        sampler.init(poly_seed.data(), poly_seed.size());
+        sampler.sample_polynomial_binomial(reinterpret_cast<uint32_t*>(vector + i * STATIC_DEGREE),
+                                           STATIC_DEGREE, eta, params_.modulus);
+    }
+}
+
+void ColorKEM::matrix_vector_mul_into(const std::array<uint8_t, 32>& seed, const ColorValue* vector, bool transpose,
+                                      const ColorValue* addend, ColorValue* result, StaticWorkspace& ws) const {
+    const uint32_t k = STATIC_RANK;
+    const uint32_t n = STATIC_DEGREE;
+    const uint32_t q = params_.modulus;
+
+    for (uint32_t i = 0; i < k; ++i) {
+        std::fill(ws.sum, ws.sum + n, ColorValue(0, 0, 0, 0));
+        for (uint32_t j = 0; j < k; ++j) {
+            if (transpose) {
+                generate_matrix_A_entry(seed, j, i, ws.matrix_entry);
+            } else {
+                generate_matrix_A_entry(seed, i, j, ws.matrix_entry);
+            }
+            color_ntt_engine_->multiply_colors(ws.matrix_entry, vector + j * n, ws.product, ws.ntt_scratch);
+            for (uint32_t d = 0; d < n; ++d) {
+                uint64_t s_val = ws.sum[d].to_math_value();
+                uint64_t p_val = ws.product[d].to_math_value();
+                ws.sum[d] = ColorValue::from_math_value((s_val + p_val) % q);
+            }
+        }
+        for (uint32_t d = 0; d < n; ++d) {
+            uint64_t s_val = ws.sum[d].to_math_value();
+            uint64_t a_val = addend[i * n + d].to_math_value();
+            result[i * n + d] = ColorValue::from_math_value((s_val + a_val) % q);
+        }
+    }
+}
+
+uint32_t ColorKEM::inner_product_constant(const ColorValue* a, const ColorValue* b, StaticWorkspace& ws) const {
+    const uint32_t n = STATIC_DEGREE;
+    const uint32_t q = params_.modulus;
+
+    std::fill(ws.sum, ws.sum + n, ColorValue(0, 0, 0, 0));
+    for (uint32_t i = 0; i < STATIC_RANK; ++i) {
+        color_ntt_engine_->multiply_colors(a + i * n, b + i * n, ws.product, ws.ntt_scratch);
+        for (uint32_t d = 0; d < n; ++d) {
+            uint64_t s_val = ws.sum[d].to_math_value();
+            uint64_t p_val = ws.product[d].to_math_value();
+            ws.sum[d] = ColorValue::from_math_value((s_val + p_val) % q);
+        }
+    }
+    return ws.sum[0].to_math_value();
+}
+
+void ColorKEM::keygen_static(std::array<uint8_t, 32>& seed, uint8_t* public_data, uint8_t* secret_data) {
+    OperationTrace trace(KemOperation::Keygen);
+    require_static_params();
+    StaticWorkspace& ws = static_workspace();
+
+    secure_random_bytes(seed.data(), seed.size());
+    sample_vector_into(params_.eta1, nullptr, ws.secret);
+    sample_vector_into(params_.eta1, nullptr, ws.error);
+    matrix_vector_mul_into(seed, ws.secret, false, ws.error, ws.result, ws);
+
+    store_vector(ws.result, STATIC_RANK * STATIC_DEGREE, public_data);
+    store_vector(ws.secret, STATIC_RANK * STATIC_DEGREE, secret_data);
+}
+
+void ColorKEM::keygen_deterministic_static(const std::array<uint8_t, 32>& matrix_seed,
+                                           const std::array<uint8_t, 32>& secret_seed,
+                                           const std::array<uint8_t, 32>& error_seed,
+                                           uint8_t* public_data, uint8_t* secret_data) {
+    OperationTrace trace(KemOperation::Keygen);
+    require_static_params();
+    StaticWorkspace& ws = static_workspace();
+
+    sample_vector_into(params_.eta1, &secret_seed, ws.secret);
+    sample_vector_into(params_.eta1, &error_seed, ws.error);
+    matrix_vector_mul_into(matrix_seed, ws.secret, false, ws.error, ws.result, ws);
+
+    store_vector(ws.result, STATIC_RANK * STATIC_DEGREE, public_data);
+    store_vector(ws.secret, STATIC_RANK * STATIC_DEGREE, secret_data);
+}
+
+ColorValue ColorKEM::encapsulate_into(const std::array<uint8_t, 32>& seed, const uint8_t* public_data,
+                                      const std::array<uint8_t, 32>* r_seed, const std::array<uint8_t, 32>* e1_seed,
+                                      const std::array<uint8_t, 32>* e2_seed, const ColorValue& shared_secret,
+                                      uint8_t* ciphertext_data, uint8_t* shared_secret_hint) {
+    OperationTrace trace(KemOperation::Encapsulate);
+    const uint32_t n = STATIC_DEGREE;
+    const uint32_t q = params_.modulus;
+
+    if (shared_secret.to_math_value() >= q) {
+        throw std::invalid_argument("Invalid message value: must be less than modulus " + std::to_string(q));
+    }
+
+    StaticWorkspace& ws = static_workspace();
+    load_vector(public_data, STATIC_RANK * n, ws.public_key);
+
+    sample_vector_into(params_.eta2, r_seed, ws.secret);
+    sample_vector_into(params_.eta2, e1_seed, ws.error);
+
+    // Only the constant term of e2 enters c2, and it comes from the first polynomial's
+    // first coefficient, so sampling that one coefficient gives the same value
+    std::array<uint8_t, 32> e2_poly_seed;
+    if (e2_seed != nullptr) {
+        e2_poly_seed = *e2_seed;
+    } else {
+        secure_random_bytes(e2_poly_seed.data(), e2_poly_seed.size());
+    }
+    uint32_t e2_raw = 0;
+    SHAKE256Sampler e2_sampler;
+    e2_sampler.init(e2_poly_seed.data(), e2_poly_seed.size());
+    e2_sampler.sample_polynomial_binomial(&e2_raw, 1, params_.eta2, q);
+    ColorValue e2;
+    std::copy(reinterpret_cast<const uint8_t*>(&e2_raw), reinterpret_cast<const uint8_t*>(&e2_raw) + 4,
+              reinterpret_cast<uint8_t*>(&e2));
+
+    matrix_vector_mul_into(seed, ws.secret, true, ws.error, ws.result, ws);
+    store_vector(ws.result, STATIC_RANK * n, ciphertext_data);
+
+    uint64_t inner_product = inner_product_constant(ws.public_key, ws.secret, ws);
+    uint64_t e2_val = e2.to_math_value();
+    uint64_t encoded_m = static_cast<uint64_t>(shared_secret.to_math_value()) * (q / 2);
+    uint64_t c2_val = (inner_product + e2_val + encoded_m) % q;
+
+    uint8_t* c2 = ciphertext_data + STATIC_RANK * n * 4;
+    std::fill(c2, c2 + n * 4, 0);
+    store_coeff(ColorValue::from_math_value(static_cast<uint32_t>(c2_val)), c2);
+
+    store_coeff(shared_secret, shared_secret_hint);
+    return shared_secret;
+}
+
+ColorValue ColorKEM::encapsulate_static(const std::array<uint8_t, 32>& seed, const uint8_t* public_data,
+                                        uint8_t* ciphertext_data, uint8_t* shared_secret_hint) {
+    require_static_params();
+
+    uint8_t byte;
+    secure_random_bytes(&byte, 1);
+    ColorValue shared_secret = ColorValue::from_math_value(byte & 1);
+
+    return encapsulate_into(seed, public_data, nullptr, nullptr, nullptr, shared_secret,
+                            ciphertext_data, shared_secret_hint);
+}
+
+ColorValue ColorKEM::encapsulate_deterministic_static(const std::array<uint8_t, 32>& seed, const uint8_t* public_data,
+                                                      const std::array<uint8_t, 32>& r_seed,
+                                                      const std::array<uint8_t, 32>& e1_seed,
+                                                      const std::array<uint8_t, 32>& e2_seed,
+                                                      const ColorValue& shared_secret,
+                                                      uint8_t* ciphertext_data, uint8_t* shared_secret_hint) {
+    require_static_params();
+    return encapsulate_into(seed, public_data, &r_seed, &e1_seed, &e2_seed, shared_secret,
+                            ciphertext_data, shared_secret_hint);
+}
+
+ColorValue ColorKEM::decapsulate_static(const uint8_t* secret_data, const uint8_t* ciphertext_data,
+                                        const uint8_t* shared_secret_hint) {
+    OperationTrace trace(KemOperation::Decapsulate);
+    require_static_params();
+    const uint32_t n = STATIC_DEGREE;
+    StaticWorkspace& ws = static_workspace();
+
+    load_vector(secret_data, STATIC_RANK * n, ws.secret);
+    load_vector(ciphertext_data, STATIC_RANK * n, ws.result);
+
+    uint64_t s_dot_c1 = inner_product_constant(ws.secret, ws.result, ws);
+    uint64_t c2_val = load_coeff(ciphertext_data + STATIC_RANK * n * 4).to_math_value();
+    ColorValue recovered_secret = decode_message(c2_val, s_dot_c1);
+
+    // Fujisaki-Okamoto transform, hashing ciphertext_data || hint as hash_ciphertext() does
+    if (recovered_secret == load_coeff(shared_secret_hint)) {
+        return recovered_secret;
+    }
+
+    sha3_ctx_t ctx;
+    shake256_init(&ctx);
+    shake_update(&ctx, ciphertext_data, STATIC_CIPHERTEXT_DATA_BYTES);
+    shake_update(&ctx, shared_secret_hint, STATIC_HINT_BYTES);
+    shake_xof(&ctx);
+
+    std::array<uint8_t, 4> hash_bytes;
+    shake_out(&ctx, hash_bytes.data(), hash_bytes.size());
+    return ColorValue::from_math_value(load_coeff(hash_bytes.data()).to_math_value() % params_.modulus);
+}
+
+} // namespace clwe
+
+#endif // CLWE_STATIC_WORKSPACE
@@ -1,12 +1,14 @@
 #include "clwe/color_ntt_engine.hpp"
 #include "clwe/utils.hpp"
+#include "clwe/stage_profile.hpp"
 #include <algorithm>
 #include <iostream>
 
 namespace clwe {
 
 ColorNTTEngine::ColorNTTEngine(uint32_t q, uint32_t n)
-    : NTTEngine(q, n), color_zetas_(n), color_zetas_inv_(n) {
+    : NTTEngine(q, n), color_zetas_(n, table_allocator<ColorValue>()),
+      color_zetas_inv_(n, table_allocator<ColorValue>()) {
 
     std::vector<uint32_t> standard_zetas(n);
     std::vector<uint32_t> standard_zetas_inv(n);
@@ -78,6 +80,7 @@ void ColorNTTEngine::color_butterfly_inv(ColorValue& a, ColorValue& b, const Col
 }
 
 void ColorNTTEngine::ntt_forward_colors(ColorValue* poly) const {
+    StageTimer timer(KemStage::NTT);
     uint32_t m = 1;
     uint32_t k = n_ / 2;
 
@@ -94,6 +97,7 @@ void ColorNTTEngine::ntt_forward_colors(ColorValue* poly) const {
 }
 
 void ColorNTTEngine::ntt_inverse_colors(ColorValue* poly) const {
+    StageTimer timer(KemStage::NTT);
     uint32_t m = n_ / 2;
     uint32_t k = 1;
 
@@ -117,19 +121,32 @@ void ColorNTTEngine::ntt_inverse_colors(ColorValue* poly) const {
 }
 
 void ColorNTTEngine::multiply_colors(const ColorValue* a, const ColorValue* b, ColorValue* result) const {
-    std::vector<ColorValue> a_ntt(n_);
-    std::vector<ColorValue> b_ntt(n_);
-    std::copy(a, a + n_, a_ntt.begin());
-    std::copy(b, b + n_, b_ntt.begin());
-
-    ntt_forward_colors(a_ntt.data());
-    ntt_forward_colors(b_ntt.data());
-
-    for (uint32_t i = 0; i < n_; ++i) {
-        uint64_t a_val = a_ntt[i].to_precise_value();
-        uint64_t b_val = b_ntt[i].to_precise_value();
-        uint64_t product = (a_val * b_val) % modulus();
-        result[i] = ColorValue::from_precise_value(product);
+    std::vector<ColorValue> scratch(2 * n_);
+    multiply_colors(a, b, result, scratch.data());
+}
+
+void ColorNTTEngine::multiply_colors(const ColorValue* a, const ColorValue* b, ColorValue* result,
+                                     ColorValue* scratch) const {
+    ColorValue* a_ntt = scratch;
+    std::copy(a, a + n_, a_ntt);
+    ntt_forward_colors(a_ntt);
+    multiply_colors_prepared(a_ntt, b, result, scratch + n_);
+}
+
+void ColorNTTEngine::multiply_colors_prepared(const ColorValue* a_ntt, const ColorValue* b, ColorValue* result,
+                                              ColorValue* scratch) const {
+    ColorValue* b_ntt = scratch;
+    std::copy(b, b + n_, b_ntt);
+    ntt_forward_colors(b_ntt);
+
+    {
+        StageTimer timer(KemStage::Basemul);
+        for (uint32_t i = 0; i < n_; ++i) {
+            uint64_t a_val = a_ntt[i].to_precise_value();
+            uint64_t b_val = b_ntt[i].to_precise_value();
+            uint64_t product = (a_val * b_val) % modulus();
+            result[i] = ColorValue::from_precise_value(product);
+        }
     }
 
     ntt_inverse_colors(result);
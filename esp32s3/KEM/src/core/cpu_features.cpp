@@ -7,6 +7,10 @@
 #include <intrin.h>
 #endif
 
+#ifdef ESP_PLATFORM
+#include <sdkconfig.h>
+#endif
+
 namespace clwe {
 
 std::string CPUFeatures::to_string() const {
@@ -18,6 +22,7 @@ std::string CPUFeatures::to_string() const {
         case CPUArchitecture::ARM64: ss << "ARM64"; break;
         case CPUArchitecture::RISCV64: ss << "RISC-V 64"; break;
         case CPUArchitecture::PPC64: ss << "PowerPC 64"; break;
+        case CPUArchitecture::XTENSA: ss << "Xtensa"; break;
         default: ss << "Unknown"; break;
     }
 
@@ -28,6 +33,7 @@ std::string CPUFeatures::to_string() const {
         case SIMDSupport::NEON: ss << "NEON"; break;
         case SIMDSupport::RVV: ss << "RVV"; break;
         case SIMDSupport::VSX: ss << "VSX"; break;
+        case SIMDSupport::PIE: ss << "PIE"; break;
         default: ss << "None"; break;
     }
 
@@ -46,6 +52,8 @@ CPUFeatures CPUFeatureDetector::detect() {
             return detect_riscv();
         case CPUArchitecture::PPC64:
             return detect_ppc();
+        case CPUArchitecture::XTENSA:
+            return detect_xtensa();
         default:
             CPUFeatures features;
             features.architecture = CPUArchitecture::UNKNOWN;
@@ -63,6 +71,8 @@ CPUArchitecture CPUFeatureDetector::detect_architecture() {
     return CPUArchitecture::RISCV64;
 #elif defined(__powerpc64__) || defined(__ppc64__)
     return CPUArchitecture::PPC64;
+#elif defined(__XTENSA__)
+    return CPUArchitecture::XTENSA;
 #else
     return CPUArchitecture::UNKNOWN;
 #endif
@@ -164,6 +174,21 @@ CPUFeatures CPUFeatureDetector::detect_ppc() {
     return features;
 }
 
+CPUFeatures CPUFeatureDetector::detect_xtensa() {
+    CPUFeatures features;
+    features.architecture = CPUArchitecture::XTENSA;
+
+    // PIE is part of the ESP32-S3 LX7 core; the ESP32 and ESP32-S2 cores lack it
+#if defined(CONFIG_IDF_TARGET_ESP32S3)
+    features.has_pie = true;
+    features.max_simd_support = SIMDSupport::PIE;
+#else
+    features.max_simd_support = SIMDSupport::NONE;
+#endif
+
+    return features;
+}
+
 bool CPUFeatureDetector::has_cpuid() {
 #if defined(__x86_64__) || defined(_M_X64)
     return true;
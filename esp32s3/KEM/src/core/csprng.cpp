@@ -0,0 +1,178 @@
+#include "clwe/csprng.hpp"
+#include "clwe/utils.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef ESP_PLATFORM
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#else
+#include <atomic>
+#include <pthread.h>
+#endif
+
+namespace clwe {
+
+namespace {
+
+#ifndef ESP_PLATFORM
+// Bumped in the child of every fork(); a thread whose DRBG saw an older value reseeds
+// before serving anything, so parent and child never share output
+std::atomic<uint64_t> fork_generation_counter{0};
+
+void on_fork_child() {
+    fork_generation_counter.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t current_fork_generation() {
+    static const bool registered = pthread_atfork(nullptr, nullptr, &on_fork_child) == 0;
+    (void)registered;
+    return fork_generation_counter.load(std::memory_order_relaxed);
+}
+#endif
+
+inline uint32_t rotl32(uint32_t x, int n) {
+    return (x << n) | (x >> (32 - n));
+}
+
+inline uint32_t load_le32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+inline void store_le32(uint8_t* p, uint32_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+    p[2] = static_cast<uint8_t>(v >> 16);
+    p[3] = static_cast<uint8_t>(v >> 24);
+}
+
+#define CHACHA_QR(a, b, c, d)                \
+    a += b; d ^= a; d = rotl32(d, 16);       \
+    c += d; b ^= c; b = rotl32(b, 12);       \
+    a += b; d ^= a; d = rotl32(d, 8);        \
+    c += d; b ^= c; b = rotl32(b, 7)
+
+} // namespace
+
+void ChaCha20Drbg::block(const uint32_t key[8], uint32_t counter, uint8_t out[BLOCK_BYTES]) {
+    uint32_t input[16] = {
+        0x61707865, 0x3320646e, 0x79622d32, 0x6b206574,
+        key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7],
+        counter, 0, 0, 0
+    };
+    uint32_t x[16];
+    std::memcpy(x, input, sizeof(x));
+
+    for (int round = 0; round < 10; ++round) {
+        CHACHA_QR(x[0], x[4], x[8], x[12]);
+        CHACHA_QR(x[1], x[5], x[9], x[13]);
+        CHACHA_QR(x[2], x[6], x[10], x[14]);
+        CHACHA_QR(x[3], x[7], x[11], x[15]);
+        CHACHA_QR(x[0], x[5], x[10], x[15]);
+        CHACHA_QR(x[1], x[6], x[11], x[12]);
+        CHACHA_QR(x[2], x[7], x[8], x[13]);
+        CHACHA_QR(x[3], x[4], x[9], x[14]);
+    }
+
+    for (int i = 0; i < 16; ++i) {
+        store_le32(out + 4 * i, x[i] + input[i]);
+    }
+    secure_zero(x, sizeof(x));
+    secure_zero(input, sizeof(input));
+}
+
+ChaCha20Drbg::~ChaCha20Drbg() {
+    secure_zero(key_, sizeof(key_));
+    secure_zero(buffer_, sizeof(buffer_));
+}
+
+void ChaCha20Drbg::seed(const uint8_t key[KEY_BYTES]) {
+    for (size_t i = 0; i < KEY_BYTES / 4; ++i) {
+        key_[i] = load_le32(key + 4 * i);
+    }
+    secure_zero(buffer_, sizeof(buffer_));
+    available_ = 0;
+    since_reseed_ = 0;
+    seeded_ = true;
+    auto_reseed_ = false;
+}
+
+void ChaCha20Drbg::reseed() {
+    uint8_t fresh[KEY_BYTES];
+    os_random_bytes(fresh, sizeof(fresh));
+    for (size_t i = 0; i < KEY_BYTES / 4; ++i) {
+        key_[i] ^= load_le32(fresh + 4 * i);
+    }
+    secure_zero(fresh, sizeof(fresh));
+    secure_zero(buffer_, sizeof(buffer_));
+    available_ = 0;
+    since_reseed_ = 0;
+#ifndef ESP_PLATFORM
+    fork_generation_ = current_fork_generation();
+#endif
+    seeded_ = true;
+}
+
+void ChaCha20Drbg::refill() {
+    if (auto_reseed_ && since_reseed_ >= RESEED_INTERVAL) {
+        reseed();
+    }
+
+    for (uint32_t b = 0; b < BUFFER_BLOCKS; ++b) {
+        block(key_, b, buffer_ + b * BLOCK_BYTES);
+    }
+    // The key for the next refill comes off the front, so the buffer can never rebuild it
+    for (size_t i = 0; i < KEY_BYTES / 4; ++i) {
+        key_[i] = load_le32(buffer_ + 4 * i);
+    }
+    secure_zero(buffer_, KEY_BYTES);
+    available_ = BUFFER_BYTES - KEY_BYTES;
+}
+
+void ChaCha20Drbg::generate(uint8_t* out, size_t len) {
+#ifdef ESP_PLATFORM
+    if (auto_reseed_ && !seeded_) {
+        reseed();
+    }
+#else
+    if (auto_reseed_ && (!seeded_ || fork_generation_ != current_fork_generation())) {
+        reseed();
+    }
+#endif
+
+    while (len > 0) {
+        if (available_ == 0) {
+            refill();
+        }
+        size_t take = std::min(len, available_);
+        uint8_t* src = buffer_ + BUFFER_BYTES - available_;
+        std::memcpy(out, src, take);
+        secure_zero(src, take);
+        available_ -= take;
+        since_reseed_ += take;
+        out += take;
+        len -= take;
+    }
+}
+
+#ifdef ESP_PLATFORM
+void drbg_random_bytes(uint8_t* buffer, size_t len) {
+    static ChaCha20Drbg drbg;
+    static SemaphoreHandle_t lock = xSemaphoreCreateMutex();
+    if (lock == nullptr) {
+        throw std::runtime_error("Failed to create the DRBG mutex");
+    }
+    xSemaphoreTake(lock, portMAX_DELAY);
+    drbg.generate(buffer, len);
+    xSemaphoreGive(lock);
+}
+#else
+void drbg_random_bytes(uint8_t* buffer, size_t len) {
+    thread_local ChaCha20Drbg drbg;
+    drbg.generate(buffer, len);
+}
+#endif
+
+} // namespace clwe
@@ -0,0 +1,163 @@
+#include "clwe/dual_core_executor.hpp"
+#include <stdexcept>
+#include <string>
+
+namespace clwe {
+
+namespace {
+
+// Single-core order: all of overlap() first, then each row produced and consumed in turn
+void run_on_caller(uint32_t rows,
+                   const std::function<void(uint32_t)>& produce,
+                   const std::function<void()>& overlap,
+                   const std::function<void(uint32_t)>& consume) {
+    overlap();
+    for (uint32_t i = 0; i < rows; ++i) {
+        produce(i);
+        consume(i);
+    }
+}
+
+void check_rows(uint32_t rows) {
+    if (rows > DualCoreExecutor::MAX_PIPELINE_ROWS) {
+        throw std::invalid_argument("Pipeline rows exceed " + std::to_string(DualCoreExecutor::MAX_PIPELINE_ROWS));
+    }
+}
+
+} // namespace
+
+#ifdef CLWE_HAVE_DUAL_CORE
+
+DualCoreExecutor::DualCoreExecutor(int worker_core, uint32_t stack_bytes, uint32_t priority)
+    : worker_(nullptr), start_(nullptr), rows_(nullptr), done_(nullptr), lock_(nullptr),
+      produce_(nullptr), job_rows_(0), failed_(false), cancel_(false), stop_(false) {
+    start_ = xSemaphoreCreateBinary();
+    rows_ = xSemaphoreCreateCounting(MAX_PIPELINE_ROWS, 0);
+    done_ = xSemaphoreCreateBinary();
+    lock_ = xSemaphoreCreateMutex();
+    if (start_ == nullptr || rows_ == nullptr || done_ == nullptr || lock_ == nullptr) {
+        return;
+    }
+    if (xTaskCreatePinnedToCore(&DualCoreExecutor::worker_entry, "clwe_worker", stack_bytes, this,
+                                priority, &worker_, worker_core) != pdPASS) {
+        worker_ = nullptr;
+    }
+}
+
+DualCoreExecutor::~DualCoreExecutor() {
+    if (worker_ != nullptr) {
+        xSemaphoreTake(lock_, portMAX_DELAY);
+        stop_ = true;
+        xSemaphoreGive(start_);
+        xSemaphoreTake(done_, portMAX_DELAY);
+        xSemaphoreGive(lock_);
+    }
+    if (start_ != nullptr) vSemaphoreDelete(start_);
+    if (rows_ != nullptr) vSemaphoreDelete(rows_);
+    if (done_ != nullptr) vSemaphoreDelete(done_);
+    if (lock_ != nullptr) vSemaphoreDelete(lock_);
+}
+
+bool DualCoreExecutor::dual_core() const {
+    return worker_ != nullptr;
+}
+
+void DualCoreExecutor::worker_entry(void* arg) {
+    static_cast<DualCoreExecutor*>(arg)->worker_loop();
+    vTaskDelete(nullptr);
+}
+
+void DualCoreExecutor::worker_loop() {
+    while (true) {
+        xSemaphoreTake(start_, portMAX_DELAY);
+        if (stop_) {
+            xSemaphoreGive(done_);
+            return;
+        }
+
+        for (uint32_t i = 0; i < job_rows_ && !cancel_.load(); ++i) {
+            try {
+                (*produce_)(i);
+            } catch (...) {
+                worker_error_ = std::current_exception();
+                failed_.store(true);
+                // Wake the caller so it sees the failure instead of waiting on row i
+                xSemaphoreGive(rows_);
+                break;
+            }
+            xSemaphoreGive(rows_);
+        }
+        xSemaphoreGive(done_);
+    }
+}
+
+void DualCoreExecutor::run_pipeline(uint32_t rows,
+                                    const std::function<void(uint32_t)>& produce,
+                                    const std::function<void()>& overlap,
+                                    const std::function<void(uint32_t)>& consume) {
+    check_rows(rows);
+
+    if (worker_ == nullptr) {
+        run_on_caller(rows, produce, overlap, consume);
+        return;
+    }
+
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    produce_ = &produce;
+    job_rows_ = rows;
+    worker_error_ = nullptr;
+    failed_.store(false);
+    cancel_.store(false);
+    xSemaphoreGive(start_);
+
+    // The callbacks live on the caller's stack, so wait for the worker before leaving,
+    // including on the error path
+    std::exception_ptr caller_error;
+    try {
+        overlap();
+        for (uint32_t i = 0; i < rows; ++i) {
+            xSemaphoreTake(rows_, portMAX_DELAY);
+            if (failed_.load()) {
+                break;
+            }
+            consume(i);
+        }
+    } catch (...) {
+        caller_error = std::current_exception();
+    }
+    cancel_.store(true);
+    xSemaphoreTake(done_, portMAX_DELAY);
+    while (xSemaphoreTake(rows_, 0) == pdTRUE) {
+    }
+
+    std::exception_ptr error = worker_error_ ? worker_error_ : caller_error;
+    produce_ = nullptr;
+    worker_error_ = nullptr;
+    xSemaphoreGive(lock_);
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+#else
+
+DualCoreExecutor::DualCoreExecutor(int, uint32_t, uint32_t) {}
+
+DualCoreExecutor::~DualCoreExecutor() = default;
+
+bool DualCoreExecutor::dual_core() const {
+    return false;
+}
+
+void DualCoreExecutor::run_pipeline(uint32_t rows,
+                                    const std::function<void(uint32_t)>& produce,
+                                    const std::function<void()>& overlap,
+                                    const std::function<void(uint32_t)>& consume) {
+    check_rows(rows);
+    run_on_caller(rows, produce, overlap, consume);
+}
+
+#endif // CLWE_HAVE_DUAL_CORE
+
+} // namespace clwe
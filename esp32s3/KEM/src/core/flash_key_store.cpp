@@ -0,0 +1,239 @@
+#include "clwe/flash_key_store.hpp"
+#include "clwe/color_ntt_engine.hpp"
+#include "clwe/tiny_sha3.h"
+#include "clwe/utils.hpp"
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#ifdef ESP_PLATFORM
+#include <esp_partition.h>
+#endif
+
+namespace clwe {
+
+namespace {
+
+constexpr uint8_t RECORD_MAGIC[4] = {'C', 'L', 'W', 'K'};
+constexpr size_t HEADER_BYTES = sizeof(FlashKeyRecordHeader);
+constexpr size_t SEED_BYTES = 32;
+constexpr size_t CHECKED_HEADER_BYTES = offsetof(FlashKeyRecordHeader, check);
+
+size_t payload_bytes(const CLWEParameters& params) {
+    size_t coefficients = static_cast<size_t>(params.module_rank) * params.degree;
+    return SEED_BYTES + coefficients * 4 + coefficients * sizeof(ColorValue);
+}
+
+void record_check(const uint8_t* record, size_t payload, uint8_t out[16]) {
+    sha3_ctx_t ctx;
+    shake256_init(&ctx);
+    shake_update(&ctx, record, CHECKED_HEADER_BYTES);
+    shake_update(&ctx, record + HEADER_BYTES, payload);
+    shake_xof(&ctx);
+    shake_out(&ctx, out, 16);
+}
+
+bool same_params(const CLWEParameters& a, const CLWEParameters& b) {
+    return a.security_level == b.security_level && a.degree == b.degree &&
+           a.module_rank == b.module_rank && a.modulus == b.modulus &&
+           a.eta1 == b.eta1 && a.eta2 == b.eta2;
+}
+
+} // namespace
+
+size_t FlashKeyStore::record_bytes(const CLWEParameters& params) {
+    size_t bytes = HEADER_BYTES + payload_bytes(params);
+    return (bytes + SECTOR_BYTES - 1) / SECTOR_BYTES * SECTOR_BYTES;
+}
+
+std::vector<uint8_t> FlashKeyStore::encode_record(const ColorPublicKey& public_key,
+                                                  const ColorPrivateKey& private_key) {
+    const CLWEParameters& params = public_key.params;
+    if (!same_params(params, private_key.params)) {
+        throw std::invalid_argument("Public and private key parameters do not match");
+    }
+    const uint32_t n = params.degree;
+    const size_t coefficients = static_cast<size_t>(params.module_rank) * n;
+    if (public_key.public_data.size() != coefficients * 4) {
+        throw std::invalid_argument("Invalid public key data size: expected " + std::to_string(coefficients * 4) +
+                                    " bytes, got " + std::to_string(public_key.public_data.size()));
+    }
+    if (private_key.secret_data.size() != coefficients * 4) {
+        throw std::invalid_argument("Invalid private key data size: expected " + std::to_string(coefficients * 4) +
+                                    " bytes, got " + std::to_string(private_key.secret_data.size()));
+    }
+
+    std::vector<uint8_t> record(record_bytes(params), 0xFF);
+    FlashKeyRecordHeader header;
+    std::memset(&header, 0xFF, sizeof(header));
+    std::memcpy(header.magic, RECORD_MAGIC, sizeof(RECORD_MAGIC));
+    header.version = RECORD_VERSION;
+    header.security_level = params.security_level;
+    header.degree = params.degree;
+    header.module_rank = params.module_rank;
+    header.modulus = params.modulus;
+    header.eta1 = params.eta1;
+    header.eta2 = params.eta2;
+    header.record_bytes = static_cast<uint32_t>(record.size());
+    std::memcpy(record.data(), &header, sizeof(header));
+
+    uint8_t* seed = record.data() + HEADER_BYTES;
+    std::memcpy(seed, public_key.seed.data(), SEED_BYTES);
+    uint8_t* public_data = seed + SEED_BYTES;
+    std::memcpy(public_data, public_key.public_data.data(), coefficients * 4);
+
+    // The NTT domain secret, exactly what decapsulate() derives from secret_data per call
+    ColorNTTEngine engine(params.modulus, n);
+    std::vector<ColorValue> prepared(coefficients);
+    const uint8_t* secret = private_key.secret_data.data();
+    for (size_t i = 0; i < coefficients; ++i) {
+        const uint8_t* bytes = secret + i * 4;
+        prepared[i] = ColorValue::from_math_value((static_cast<uint32_t>(bytes[0]) << 24) |
+                                                  (static_cast<uint32_t>(bytes[1]) << 16) |
+                                                  (static_cast<uint32_t>(bytes[2]) << 8) |
+                                                  static_cast<uint32_t>(bytes[3]));
+    }
+    for (uint32_t i = 0; i < params.module_rank; ++i) {
+        engine.ntt_forward_colors(prepared.data() + static_cast<size_t>(i) * n);
+    }
+    std::memcpy(public_data + coefficients * 4, prepared.data(), coefficients * sizeof(ColorValue));
+    secure_zero(prepared.data(), prepared.size() * sizeof(ColorValue));
+
+    FlashKeyRecordHeader* stored = reinterpret_cast<FlashKeyRecordHeader*>(record.data());
+    record_check(record.data(), payload_bytes(params), stored->check);
+    return record;
+}
+
+FlashKeyStore::FlashKeyStore(const uint8_t* region, size_t region_bytes)
+    : region_(region), region_bytes_(region_bytes) {
+    if (region_ == nullptr && region_bytes_ != 0) {
+        throw std::invalid_argument("FlashKeyStore region cannot be null");
+    }
+    scan();
+}
+
+#ifdef ESP_PLATFORM
+FlashKeyStore::FlashKeyStore(const char* partition_label)
+    : region_(nullptr), region_bytes_(0) {
+    const esp_partition_t* partition =
+        esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, partition_label);
+    if (partition == nullptr) {
+        throw std::runtime_error(std::string("Key partition not found: ") + partition_label);
+    }
+    const void* mapped = nullptr;
+    esp_partition_mmap_handle_t handle;
+    esp_err_t err = esp_partition_mmap(partition, 0, partition->size, ESP_PARTITION_MMAP_DATA, &mapped, &handle);
+    if (err != ESP_OK) {
+        throw std::runtime_error(std::string("Failed to map key partition: ") + esp_err_to_name(err));
+    }
+    mmap_handle_ = handle;
+    mapped_ = true;
+    region_ = static_cast<const uint8_t*>(mapped);
+    region_bytes_ = partition->size;
+    scan();
+}
+
+void FlashKeyStore::provision(const char* partition_label,
+                              const std::vector<std::pair<ColorPublicKey, ColorPrivateKey>>& keys) {
+    const esp_partition_t* partition =
+        esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, partition_label);
+    if (partition == nullptr) {
+        throw std::runtime_error(std::string("Key partition not found: ") + partition_label);
+    }
+    size_t total = 0;
+    for (const auto& pair : keys) {
+        total += record_bytes(pair.first.params);
+    }
+    if (total > partition->size) {
+        throw std::runtime_error("Key partition too small: " + std::to_string(total) + " bytes needed, " +
+                                 std::to_string(partition->size) + " available");
+    }
+
+    esp_err_t err = esp_partition_erase_range(partition, 0, partition->size);
+    if (err != ESP_OK) {
+        throw std::runtime_error(std::string("Failed to erase key partition: ") + esp_err_to_name(err));
+    }
+    size_t offset = 0;
+    for (const auto& pair : keys) {
+        std::vector<uint8_t> record = encode_record(pair.first, pair.second);
+        // Encrypted partitions go through the flash encryption engine here
+        err = esp_partition_write(partition, offset, record.data(), record.size());
+        secure_zero(record.data(), record.size());
+        if (err != ESP_OK) {
+            throw std::runtime_error(std::string("Failed to write key partition: ") + esp_err_to_name(err));
+        }
+        offset += record.size();
+    }
+}
+#endif
+
+FlashKeyStore::~FlashKeyStore() {
+#ifdef ESP_PLATFORM
+    if (mapped_) {
+        esp_partition_munmap(static_cast<esp_partition_mmap_handle_t>(mmap_handle_));
+    }
+#endif
+}
+
+void FlashKeyStore::scan() {
+    size_t offset = 0;
+    while (offset + HEADER_BYTES <= region_bytes_) {
+        const uint8_t* base = region_ + offset;
+        FlashKeyRecordHeader header;
+        std::memcpy(&header, base, sizeof(header));
+        size_t advance = SECTOR_BYTES;
+        if (std::memcmp(header.magic, RECORD_MAGIC, sizeof(RECORD_MAGIC)) == 0 && header.version == RECORD_VERSION) {
+            try {
+                CLWEParameters params(header.security_level, header.degree, header.module_rank,
+                                      header.modulus, header.eta1, header.eta2);
+                size_t bytes = record_bytes(params);
+                if (header.record_bytes == bytes && bytes <= region_bytes_ - offset) {
+                    uint8_t check[16];
+                    record_check(base, payload_bytes(params), check);
+                    if (std::memcmp(check, header.check, sizeof(check)) == 0) {
+                        records_.push_back({base, params});
+                        advance = bytes;
+                    }
+                }
+            } catch (const std::invalid_argument&) {
+                // Not a parameter set this build accepts; skip the sector
+            }
+        }
+        offset += advance;
+    }
+}
+
+const FlashKeyStore::Record& FlashKeyStore::record(size_t index) const {
+    if (index >= records_.size()) {
+        throw std::out_of_range("FlashKeyStore index " + std::to_string(index) + " out of range (" +
+                                std::to_string(records_.size()) + " records)");
+    }
+    return records_[index];
+}
+
+const CLWEParameters& FlashKeyStore::params(size_t index) const {
+    return record(index).params;
+}
+
+ColorPublicKeyView FlashKeyStore::public_key(size_t index) const {
+    const Record& rec = record(index);
+    ColorPublicKeyView view;
+    view.seed = rec.base + HEADER_BYTES;
+    view.public_data = view.seed + SEED_BYTES;
+    view.public_data_size = static_cast<size_t>(rec.params.module_rank) * rec.params.degree * 4;
+    view.params = rec.params;
+    return view;
+}
+
+ColorPrivateKeyView FlashKeyStore::private_key(size_t index) const {
+    const Record& rec = record(index);
+    size_t coefficients = static_cast<size_t>(rec.params.module_rank) * rec.params.degree;
+    ColorPrivateKeyView view;
+    view.prepared_secret =
+        reinterpret_cast<const ColorValue*>(rec.base + HEADER_BYTES + SEED_BYTES + coefficients * 4);
+    view.params = rec.params;
+    return view;
+}
+
+} // namespace clwe
@@ -0,0 +1,71 @@
+#include "clwe/memory_placement.hpp"
+#include <cstdlib>
+
+#ifdef ESP_PLATFORM
+#include <esp_heap_caps.h>
+#include <esp_memory_utils.h>
+#include <sdkconfig.h>
+#endif
+
+namespace clwe {
+
+namespace {
+
+PlacementPolicy active_policy;
+
+} // namespace
+
+void set_placement_policy(const PlacementPolicy& policy) {
+    active_policy = policy;
+}
+
+const PlacementPolicy& placement_policy() {
+    return active_policy;
+}
+
+void* placement_malloc(size_t bytes, MemoryRegion region) {
+#ifdef ESP_PLATFORM
+    void* ptr = nullptr;
+    switch (region) {
+    case MemoryRegion::Internal:
+        ptr = heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        break;
+    case MemoryRegion::External:
+#ifdef CONFIG_SPIRAM
+        ptr = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#endif
+        break;
+    case MemoryRegion::Default:
+        break;
+    }
+    if (ptr == nullptr) {
+        ptr = heap_caps_malloc(bytes, MALLOC_CAP_8BIT);
+    }
+#else
+    (void)region;
+    void* ptr = std::malloc(bytes);
+#endif
+    if (ptr == nullptr && bytes != 0) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void placement_free(void* ptr) noexcept {
+#ifdef ESP_PLATFORM
+    heap_caps_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+bool is_external_ram(const void* ptr) {
+#ifdef ESP_PLATFORM
+    return esp_ptr_external_ram(ptr);
+#else
+    (void)ptr;
+    return false;
+#endif
+}
+
+} // namespace clwe
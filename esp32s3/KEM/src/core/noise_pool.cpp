@@ -0,0 +1,69 @@
+#include "clwe/noise_pool.hpp"
+#include "clwe/utils.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace clwe {
+
+namespace {
+
+constexpr uint32_t POOL_MAGIC = 0x504e4c43;  // "CLNP"
+
+} // namespace
+
+size_t NoisePool::bundle_bytes(const CLWEParameters& params) {
+    size_t bytes = SLOT_R + 2 * static_cast<size_t>(params.module_rank) * params.degree;
+    return (bytes + 3) & ~static_cast<size_t>(3);
+}
+
+size_t NoisePool::region_bytes(const CLWEParameters& params, size_t bundles) {
+    return HEADER_BYTES + bundles * bundle_bytes(params);
+}
+
+NoisePool::NoisePool(void* region, size_t bytes, const CLWEParameters& params)
+    : region_(static_cast<uint8_t*>(region)), capacity_(0), bundle_bytes_(bundle_bytes(params)),
+      security_level_(params.security_level) {
+    if (region == nullptr) {
+        throw std::invalid_argument("Noise pool region cannot be null");
+    }
+    if (bytes < region_bytes(params, 1)) {
+        throw std::invalid_argument("Noise pool region too small: need at least " +
+                                    std::to_string(region_bytes(params, 1)) + " bytes");
+    }
+    capacity_ = (bytes - HEADER_BYTES) / bundle_bytes_;
+
+    const uint32_t expected[4] = {POOL_MAGIC, security_level_, static_cast<uint32_t>(bundle_bytes_),
+                                  static_cast<uint32_t>(capacity_)};
+    // The region may have any alignment, so the header goes through memcpy
+    uint32_t found[4];
+    std::memcpy(found, region_, sizeof(found));
+    if (std::memcmp(found, expected, sizeof(found)) != 0) {
+        secure_zero(region_, region_bytes(params, capacity_));
+        std::memcpy(region_, expected, sizeof(expected));
+    }
+}
+
+size_t NoisePool::available() const {
+    size_t ready = 0;
+    for (size_t i = 0; i < capacity_; ++i) {
+        ready += slot(i)[0] == SLOT_READY;
+    }
+    return ready;
+}
+
+void NoisePool::clear() {
+    secure_zero(slot(0), capacity_ * bundle_bytes_);
+}
+
+uint8_t* NoisePool::find_slot(uint8_t state) const {
+    for (size_t i = 0; i < capacity_; ++i) {
+        // Any byte other than SLOT_READY (a torn write, say) counts as empty
+        if ((slot(i)[0] == SLOT_READY) == (state == SLOT_READY)) {
+            return slot(i);
+        }
+    }
+    return nullptr;
+}
+
+} // namespace clwe
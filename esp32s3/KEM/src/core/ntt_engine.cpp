@@ -1,5 +1,6 @@
 #include "clwe/ntt_engine.hpp"
 #include "clwe/ntt_scalar.hpp"
+#include "clwe/ntt_esp32s3.hpp"
 #include "clwe/utils.hpp"
 #include <algorithm>
 #include <stdexcept>
@@ -7,7 +8,7 @@
 namespace clwe {
 
 NTTEngine::NTTEngine(uint32_t q, uint32_t n)
-    : q_(q), n_(n), log_n_(0), bitrev_(n) {
+    : q_(q), n_(n), log_n_(0), bitrev_(n, table_allocator<uint32_t>()) {
 
     if (!is_power_of_two(n)) {
         throw std::invalid_argument("NTT degree must be a power of 2");
@@ -53,11 +54,20 @@ void NTTEngine::copy_to_uint32(const uint32_t* ntt_coeffs, uint32_t* coeffs) con
 class ScalarNTTEngine;
 
 std::unique_ptr<NTTEngine> create_optimal_ntt_engine(uint32_t q, uint32_t n) {
+#ifdef CLWE_HAVE_PIE
+    return std::unique_ptr<NTTEngine>(new ESP32S3NTTEngine(q, n));
+#else
     return std::unique_ptr<NTTEngine>(new ScalarNTTEngine(q, n));
+#endif
 }
 
-std::unique_ptr<NTTEngine> create_ntt_engine(SIMDSupport /*simd_support*/, uint32_t q, uint32_t n) {
-    return std::unique_ptr<NTTEngine>(new ScalarNTTEngine(q, n));
+std::unique_ptr<NTTEngine> create_ntt_engine(SIMDSupport simd_support, uint32_t q, uint32_t n) {
+    switch (simd_support) {
+        case SIMDSupport::PIE:
+            return std::unique_ptr<NTTEngine>(new ESP32S3NTTEngine(q, n));
+        default:
+            return std::unique_ptr<NTTEngine>(new ScalarNTTEngine(q, n));
+    }
 }
 
 } // namespace clwe
\ No newline at end of file
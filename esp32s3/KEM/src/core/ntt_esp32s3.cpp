@@ -0,0 +1,306 @@
+#include "clwe/ntt_esp32s3.hpp"
+#include "clwe/utils.hpp"
+#include <algorithm>
+
+namespace clwe {
+
+constexpr uint32_t ESP32S3NTTEngine::LANES;
+constexpr uint32_t ESP32S3NTTEngine::MAX_VECTOR_DEGREE;
+
+namespace {
+
+// Kernel constants, one 8-lane vector each: q, -q and floor(2^26 / q)
+constexpr uint32_t CONST_Q = 0;
+constexpr uint32_t CONST_NEG_Q = 8;
+constexpr uint32_t CONST_BARRETT = 16;
+constexpr uint32_t CONST_COUNT = 24;
+
+} // namespace
+
+#ifdef CLWE_HAVE_PIE
+// ntt_esp32s3_pie.S; every pointer is 16-byte aligned and groups counts 8-lane vectors
+extern "C" {
+void clwe_pie_butterflies(int16_t* lo, int16_t* hi, const int16_t* zetas, const int16_t* zetas_shoup,
+                          uint32_t groups, const int16_t* consts);
+void clwe_pie_mul_const(int16_t* poly, const int16_t* zeta, const int16_t* zeta_shoup,
+                        uint32_t groups, const int16_t* consts);
+void clwe_pie_basemul(int16_t* a, const int16_t* b, uint32_t groups, const int16_t* consts);
+}
+#else
+namespace {
+
+// Portable kernels with the PIE lane arithmetic: EE.VMUL.S16 keeps (x * y) >> SAR,
+// EE.VMULAS.S16.QACC accumulates exact products and EE.SRCMB.S16.QACC reads them back
+inline int16_t vmul(int16_t x, int16_t y, int sar) {
+    return static_cast<int16_t>((static_cast<int32_t>(x) * y) >> sar);
+}
+
+inline int16_t reduce_once(int16_t x, int16_t q) {
+    int16_t y = static_cast<int16_t>(x - q);
+    return static_cast<int16_t>(y + (y < 0 ? q : 0));
+}
+
+// a * z mod q for a < q, with r = a * z - t * q in [0, 2q)
+inline int16_t mul_shoup(int16_t a, int16_t z, int16_t zs, int16_t q) {
+    int16_t t = vmul(a, zs, 15);
+    int32_t acc = static_cast<int32_t>(a) * z - static_cast<int32_t>(t) * q;
+    return reduce_once(static_cast<int16_t>(acc), q);
+}
+
+void clwe_pie_butterflies(int16_t* lo, int16_t* hi, const int16_t* zetas, const int16_t* zetas_shoup,
+                          uint32_t groups, const int16_t* consts) {
+    const int16_t q = consts[CONST_Q];
+    for (uint32_t i = 0; i < groups * ESP32S3NTTEngine::LANES; ++i) {
+        int16_t diff = reduce_once(static_cast<int16_t>(lo[i] - hi[i] + q), q);
+        lo[i] = reduce_once(static_cast<int16_t>(lo[i] + hi[i]), q);
+        hi[i] = mul_shoup(diff, zetas[i], zetas_shoup[i], q);
+    }
+}
+
+void clwe_pie_mul_const(int16_t* poly, const int16_t* zeta, const int16_t* zeta_shoup,
+                        uint32_t groups, const int16_t* consts) {
+    const int16_t q = consts[CONST_Q];
+    for (uint32_t i = 0; i < groups * ESP32S3NTTEngine::LANES; ++i) {
+        poly[i] = mul_shoup(poly[i], zeta[i % ESP32S3NTTEngine::LANES], zeta_shoup[i % ESP32S3NTTEngine::LANES], q);
+    }
+}
+
+void clwe_pie_basemul(int16_t* a, const int16_t* b, uint32_t groups, const int16_t* consts) {
+    const int16_t q = consts[CONST_Q];
+    const int16_t m = consts[CONST_BARRETT];
+    for (uint32_t i = 0; i < groups * ESP32S3NTTEngine::LANES; ++i) {
+        // Quotient of b, floor(b * 2^15 / q) up to 5 short, puts r in [0, 3q)
+        int16_t bs = vmul(b[i], m, 11);
+        int16_t t = vmul(a[i], bs, 15);
+        int32_t acc = static_cast<int32_t>(a[i]) * b[i] - static_cast<int32_t>(t) * q;
+        a[i] = reduce_once(reduce_once(static_cast<int16_t>(acc), q), q);
+    }
+}
+
+} // namespace
+#endif
+
+ESP32S3NTTEngine::ESP32S3NTTEngine(uint32_t q, uint32_t n)
+    : NTTEngine(q, n), zetas_(n, table_allocator<uint32_t>()), zetas_inv_(n, table_allocator<uint32_t>()),
+      n_inv_(mod_inverse(n, q)), storage_(table_allocator<int16_t>()),
+      tables_(nullptr), scale_offset_(0), consts_offset_(0),
+      vector_path_(q > (1u << 11) && q < (1u << 13) && n >= 2 * LANES && n <= MAX_VECTOR_DEGREE) {
+    precompute_zetas();
+    if (vector_path_) {
+        precompute_tables();
+    }
+}
+
+void ESP32S3NTTEngine::precompute_zetas() {
+    // Same roots as ScalarNTTEngine
+    uint32_t g = 17;
+    uint32_t zeta = mod_pow(g, (q_ - 1) / n_, q_);
+
+    zetas_[0] = 1;
+    for (uint32_t i = 1; i < n_; ++i) {
+        zetas_[i] = (static_cast<uint64_t>(zetas_[i-1]) * zeta) % q_;
+    }
+
+    uint32_t zeta_inv = mod_inverse(zeta, q_);
+    zetas_inv_[0] = 1;
+    for (uint32_t i = 1; i < n_; ++i) {
+        zetas_inv_[i] = (static_cast<uint64_t>(zetas_inv_[i-1]) * zeta_inv) % q_;
+    }
+}
+
+void ESP32S3NTTEngine::precompute_tables() {
+    auto shoup = [this](uint32_t z) {
+        return static_cast<int16_t>((static_cast<uint64_t>(z) << 15) / q_);
+    };
+
+    // Forward stages run k = n/2 down to LANES, inverse stages LANES up to n/2
+    std::vector<int16_t> tables;
+    for (uint32_t k = n_ / 2, m = 1; k >= LANES; k /= 2, m *= 2) {
+        fwd_offsets_.push_back(static_cast<uint32_t>(tables.size()));
+        for (uint32_t i = 0; i < k; ++i) tables.push_back(static_cast<int16_t>(zetas_[i * m]));
+        for (uint32_t i = 0; i < k; ++i) tables.push_back(shoup(zetas_[i * m]));
+    }
+    for (uint32_t k = 1, m = n_ / 2; k < n_; k *= 2, m /= 2) {
+        inv_offsets_.push_back(static_cast<uint32_t>(tables.size()));
+        if (k < LANES) {
+            continue;
+        }
+        for (uint32_t i = 0; i < k; ++i) tables.push_back(static_cast<int16_t>(zetas_inv_[i * m]));
+        for (uint32_t i = 0; i < k; ++i) tables.push_back(shoup(zetas_inv_[i * m]));
+    }
+
+    scale_offset_ = static_cast<uint32_t>(tables.size());
+    tables.insert(tables.end(), LANES, static_cast<int16_t>(n_inv_));
+    tables.insert(tables.end(), LANES, shoup(n_inv_));
+
+    consts_offset_ = static_cast<uint32_t>(tables.size());
+    tables.insert(tables.end(), LANES, static_cast<int16_t>(q_));
+    tables.insert(tables.end(), LANES, static_cast<int16_t>(-static_cast<int32_t>(q_)));
+    tables.insert(tables.end(), LANES, static_cast<int16_t>((1u << 26) / q_));
+    static_assert(CONST_COUNT == 3 * LANES, "kernel constant layout");
+
+    // Over-allocate so the tables can start on a 16-byte boundary for EE.VLD.128
+    storage_.assign(tables.size() + LANES, 0);
+    uintptr_t base = (reinterpret_cast<uintptr_t>(storage_.data()) + 15) & ~static_cast<uintptr_t>(15);
+    int16_t* aligned = reinterpret_cast<int16_t*>(base);
+    std::copy(tables.begin(), tables.end(), aligned);
+    tables_ = aligned;
+}
+
+void CLWE_HOT ESP32S3NTTEngine::butterfly(uint32_t& a, uint32_t& b, uint32_t zeta) const {
+    uint32_t sum = (a + b) % q_;
+    uint32_t diff = (a - b + q_) % q_;
+    uint32_t prod = (static_cast<uint64_t>(diff) * zeta) % q_;
+    a = sum;
+    b = prod;
+}
+
+void CLWE_HOT ESP32S3NTTEngine::butterfly16(int16_t& a, int16_t& b, uint32_t zeta) const {
+    uint32_t x = static_cast<uint16_t>(a);
+    uint32_t y = static_cast<uint16_t>(b);
+    butterfly(x, y, zeta);
+    a = static_cast<int16_t>(x);
+    b = static_cast<int16_t>(y);
+}
+
+void CLWE_HOT ESP32S3NTTEngine::forward16(int16_t* poly) const {
+    // Like ScalarNTTEngine, each stage transforms the first block of 2k coefficients
+    const int16_t* consts = tables_ + consts_offset_;
+    uint32_t m = 1;
+    uint32_t k = n_ / 2;
+
+    for (uint32_t stage = 0; stage < log_degree(); ++stage) {
+        if (k >= LANES) {
+            const int16_t* z = tables_ + fwd_offsets_[stage];
+            clwe_pie_butterflies(poly, poly + k, z, z + k, k / LANES, consts);
+        } else {
+            for (uint32_t i = 0; i < k; ++i) {
+                butterfly16(poly[i], poly[i + k], zetas_[i * m]);
+            }
+        }
+        m *= 2;
+        k /= 2;
+    }
+}
+
+void CLWE_HOT ESP32S3NTTEngine::inverse16(int16_t* poly) const {
+    const int16_t* consts = tables_ + consts_offset_;
+    uint32_t m = n_ / 2;
+    uint32_t k = 1;
+
+    for (uint32_t stage = 0; stage < log_degree(); ++stage) {
+        if (k >= LANES) {
+            const int16_t* z = tables_ + inv_offsets_[stage];
+            clwe_pie_butterflies(poly, poly + k, z, z + k, k / LANES, consts);
+        } else {
+            for (uint32_t i = 0; i < k; ++i) {
+                butterfly16(poly[i], poly[i + k], zetas_inv_[i * m]);
+            }
+        }
+        m /= 2;
+        k *= 2;
+    }
+
+    const int16_t* scale = tables_ + scale_offset_;
+    clwe_pie_mul_const(poly, scale, scale + LANES, n_ / LANES, consts);
+}
+
+void ESP32S3NTTEngine::bit_reverse16(int16_t* poly) const {
+    // bitrev_ is an involution, so swapping each pair once permutes in place
+    for (uint32_t i = 0; i < n_; ++i) {
+        uint32_t r = bitrev_[i];
+        if (i < r) {
+            std::swap(poly[i], poly[r]);
+        }
+    }
+}
+
+void CLWE_HOT ESP32S3NTTEngine::ntt_forward(uint32_t* poly) const {
+    if (vector_path_) {
+        alignas(16) int16_t buf[MAX_VECTOR_DEGREE];
+        for (uint32_t i = 0; i < n_; ++i) {
+            buf[i] = static_cast<int16_t>(poly[i] % q_);
+        }
+        forward16(buf);
+        for (uint32_t i = 0; i < n_; ++i) {
+            poly[i] = static_cast<uint16_t>(buf[i]);
+        }
+    } else {
+        uint32_t m = 1;
+        uint32_t k = n_ / 2;
+        for (uint32_t stage = 0; stage < log_degree(); ++stage) {
+            for (uint32_t i = 0; i < k; ++i) {
+                butterfly(poly[i], poly[i + k], zetas_[i * m]);
+            }
+            m *= 2;
+            k /= 2;
+        }
+    }
+
+    bit_reverse(poly);
+}
+
+void CLWE_HOT ESP32S3NTTEngine::ntt_inverse(uint32_t* poly) const {
+    if (vector_path_) {
+        alignas(16) int16_t buf[MAX_VECTOR_DEGREE];
+        for (uint32_t i = 0; i < n_; ++i) {
+            buf[i] = static_cast<int16_t>(poly[i] % q_);
+        }
+        inverse16(buf);
+        for (uint32_t i = 0; i < n_; ++i) {
+            poly[i] = static_cast<uint16_t>(buf[i]);
+        }
+    } else {
+        uint32_t m = n_ / 2;
+        uint32_t k = 1;
+        for (uint32_t stage = 0; stage < log_degree(); ++stage) {
+            for (uint32_t i = 0; i < k; ++i) {
+                butterfly(poly[i], poly[i + k], zetas_inv_[i * m]);
+            }
+            m /= 2;
+            k *= 2;
+        }
+        for (uint32_t i = 0; i < n_; ++i) {
+            poly[i] = (static_cast<uint64_t>(poly[i]) * n_inv_) % q_;
+        }
+    }
+
+    bit_reverse(poly);
+}
+
+void CLWE_HOT ESP32S3NTTEngine::multiply(const uint32_t* a, const uint32_t* b, uint32_t* result) const {
+    if (!vector_path_) {
+        std::vector<uint32_t> a_ntt(a, a + n_);
+        std::vector<uint32_t> b_ntt(b, b + n_);
+        ntt_forward(a_ntt.data());
+        ntt_forward(b_ntt.data());
+        for (uint32_t i = 0; i < n_; ++i) {
+            result[i] = (static_cast<uint64_t>(a_ntt[i]) * b_ntt[i]) % q_;
+        }
+        ntt_inverse(result);
+        return;
+    }
+
+    // Both operands stay in int16_t lanes from the forward transforms to the inverse
+    alignas(16) int16_t a16[MAX_VECTOR_DEGREE];
+    alignas(16) int16_t b16[MAX_VECTOR_DEGREE];
+    for (uint32_t i = 0; i < n_; ++i) {
+        a16[i] = static_cast<int16_t>(a[i] % q_);
+        b16[i] = static_cast<int16_t>(b[i] % q_);
+    }
+
+    forward16(a16);
+    bit_reverse16(a16);
+    forward16(b16);
+    bit_reverse16(b16);
+
+    clwe_pie_basemul(a16, b16, n_ / LANES, tables_ + consts_offset_);
+
+    inverse16(a16);
+    bit_reverse16(a16);
+    for (uint32_t i = 0; i < n_; ++i) {
+        result[i] = static_cast<uint16_t>(a16[i]);
+    }
+}
+
+} // namespace clwe
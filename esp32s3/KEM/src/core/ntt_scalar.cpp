@@ -8,12 +8,18 @@
 namespace clwe {
 
 ScalarNTTEngine::ScalarNTTEngine(uint32_t q, uint32_t n)
-    : NTTEngine(q, n), zetas_(n), zetas_inv_(n),
-      montgomery_r_(0), montgomery_r_inv_(0) {
+    : NTTEngine(q, n), zetas_(n, table_allocator<uint32_t>()), zetas_inv_(n, table_allocator<uint32_t>()),
+      zetas_inv_scaled_(n / 2, table_allocator<uint32_t>()),
+      n_inv_mont_(0), montgomery_r_(0), q_inv_neg_(0) {
 
     // Pre-compute Montgomery constants for modular reduction
     montgomery_r_ = (1ULL << 32) % q_;
-    montgomery_r_inv_ = mod_inverse(montgomery_r_, q_);
+    // Newton iteration doubles the correct low bits of q^(-1) mod 2^32 each step
+    uint32_t q_inv = q_;
+    for (int i = 0; i < 5; ++i) {
+        q_inv *= 2 - q_ * q_inv;
+    }
+    q_inv_neg_ = 0u - q_inv;
 
     precompute_zetas();
 }
@@ -22,46 +28,58 @@ void ScalarNTTEngine::precompute_zetas() {
     // Precompute primitive n-th root of unity
     uint32_t g = 17;  // Primitive root for q = 3329 (Kyber modulus)
     uint32_t zeta = mod_pow(g, (q_ - 1) / n_, q_);
-
-    zetas_[0] = 1;
-    for (uint32_t i = 1; i < n_; ++i) {
-        zetas_[i] = (static_cast<uint64_t>(zetas_[i-1]) * zeta) % q_;
-    }
-
-    // Inverse zetas for inverse NTT
     uint32_t zeta_inv = mod_inverse(zeta, q_);
-    zetas_inv_[0] = 1;
-    for (uint32_t i = 1; i < n_; ++i) {
-        zetas_inv_[i] = (static_cast<uint64_t>(zetas_inv_[i-1]) * zeta_inv) % q_;
+    uint32_t n_inv = mod_inverse(n_, q_);
+
+    uint32_t power = 1;
+    uint32_t power_inv = 1;
+    for (uint32_t i = 0; i < n_; ++i) {
+        zetas_[i] = to_montgomery(power);
+        zetas_inv_[i] = to_montgomery(power_inv);
+        if (i < n_ / 2) {
+            zetas_inv_scaled_[i] = to_montgomery(static_cast<uint32_t>((static_cast<uint64_t>(power_inv) * n_inv) % q_));
+        }
+        power = static_cast<uint32_t>((static_cast<uint64_t>(power) * zeta) % q_);
+        power_inv = static_cast<uint32_t>((static_cast<uint64_t>(power_inv) * zeta_inv) % q_);
     }
+    n_inv_mont_ = to_montgomery(n_inv);
 }
 
-void IRAM_ATTR ScalarNTTEngine::butterfly(uint32_t& a, uint32_t& b, uint32_t zeta) const {
-    uint32_t sum = (a + b) % q_;
-    uint32_t diff = (a - b + q_) % q_;  // (a - b) mod q
-    uint32_t prod = (static_cast<uint64_t>(diff) * zeta) % q_;
+void CLWE_HOT ScalarNTTEngine::butterfly(uint32_t& a, uint32_t& b, uint32_t zeta) const {
+    uint32_t sum = a + b;
+    sum -= q_ & (0u - static_cast<uint32_t>(sum >= q_));
+    uint32_t diff = a - b;
+    diff += q_ & (0u - static_cast<uint32_t>(a < b));  // (a - b) mod q
     a = sum;
-    b = prod;
+    b = montgomery_reduce(static_cast<uint64_t>(diff) * zeta);
 }
 
-void IRAM_ATTR ScalarNTTEngine::butterfly_inv(uint32_t& a, uint32_t& b, uint32_t zeta) const {
+void CLWE_HOT ScalarNTTEngine::butterfly_inv(uint32_t& a, uint32_t& b, uint32_t zeta) const {
     // Same as forward for inverse (zeta is already inverse)
     butterfly(a, b, zeta);
 }
 
-uint32_t IRAM_ATTR ScalarNTTEngine::mod_reduce(uint32_t val) const {
+uint32_t CLWE_HOT ScalarNTTEngine::mod_reduce(uint32_t val) const {
     return val % q_;
 }
 
-uint32_t IRAM_ATTR ScalarNTTEngine::montgomery_reduce(uint64_t val) const {
-    // Montgomery reduction: (val * R^-1) mod q
-    uint64_t t = val * montgomery_r_inv_;
-    uint32_t k = t % (1ULL << 32);
-    uint64_t res = val - static_cast<uint64_t>(k) * q_;
-    return res >> 32;
+uint32_t CLWE_HOT ScalarNTTEngine::montgomery_reduce(uint64_t val) const {
+    // REDC: adding m * q clears the low 32 bits, leaving (val * R^(-1) mod q) + {0, q}
+    uint32_t m = static_cast<uint32_t>(val) * q_inv_neg_;
+    uint32_t t = static_cast<uint32_t>((val + static_cast<uint64_t>(m) * q_) >> 32);
+    return t - (q_ & (0u - static_cast<uint32_t>(t >= q_)));
+}
+
+uint32_t ScalarNTTEngine::to_montgomery(uint32_t val) const {
+    return static_cast<uint32_t>((static_cast<uint64_t>(val % q_) << 32) % q_);
 }
 
-void IRAM_ATTR ScalarNTTEngine::ntt_forward(uint32_t* poly) const {
+void CLWE_HOT ScalarNTTEngine::ntt_forward(uint32_t* poly) const {
+    // The butterflies take reduced coefficients
+    for (uint32_t i = 0; i < n_; ++i) {
+        poly[i] = mod_reduce(poly[i]);
+    }
+
     // Iterative NTT implementation
     uint32_t m = 1;
     uint32_t k = n_ / 2;
@@ -81,12 +99,17 @@ void IRAM_ATTR ScalarNTTEngine::ntt_forward(uint32_t* poly) const {
     bit_reverse(poly);
 }
 
-void IRAM_ATTR ScalarNTTEngine::ntt_inverse(uint32_t* poly) const {
-    // Inverse NTT: similar to forward but with inverse zetas and scaling
+void CLWE_HOT ScalarNTTEngine::ntt_inverse(uint32_t* poly) const {
+    for (uint32_t i = 0; i < n_; ++i) {
+        poly[i] = mod_reduce(poly[i]);
+    }
+
+    // Inverse NTT: similar to forward but with inverse zetas. The last stage pairs every
+    // coefficient once, so it also applies the n^(-1) scaling through its twiddles.
     uint32_t m = n_ / 2;
     uint32_t k = 1;
 
-    for (uint32_t stage = 0; stage < log_degree(); ++stage) {
+    for (uint32_t stage = 0; stage + 1 < log_degree(); ++stage) {
         uint32_t j = 0;
         for (uint32_t i = 0; i < k; ++i) {
             uint32_t zeta = zetas_inv_[j];
@@ -97,17 +120,20 @@ void IRAM_ATTR ScalarNTTEngine::ntt_inverse(uint32_t* poly) const {
         k *= 2;
     }
 
-    // Scale by n^(-1) mod q
-    uint32_t n_inv = mod_inverse(n_, q_);
-    for (uint32_t i = 0; i < n_; ++i) {
-        poly[i] = (static_cast<uint64_t>(poly[i]) * n_inv) % q_;
+    // Final stage, k = n / 2 and m = 1: (a, b) -> ((a + b) / n, (a - b) * zeta / n)
+    for (uint32_t i = 0; i < n_ / 2; ++i) {
+        uint32_t a = poly[i];
+        uint32_t b = poly[i + n_ / 2];
+        butterfly_inv(a, b, zetas_inv_scaled_[i]);
+        poly[i] = montgomery_reduce(static_cast<uint64_t>(a) * n_inv_mont_);
+        poly[i + n_ / 2] = b;
     }
 
     // Bit-reverse output
     bit_reverse(poly);
 }
 
-void IRAM_ATTR ScalarNTTEngine::multiply(const uint32_t* a, const uint32_t* b, uint32_t* result) const {
+void CLWE_HOT ScalarNTTEngine::multiply(const uint32_t* a, const uint32_t* b, uint32_t* result) const {
     // Copy inputs for NTT
     std::vector<uint32_t> a_ntt(n_);
     std::vector<uint32_t> b_ntt(n_);
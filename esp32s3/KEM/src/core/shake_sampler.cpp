@@ -1,5 +1,6 @@
 #include "clwe/shake_sampler.hpp"
 #include "clwe/utils.hpp"
+#include "clwe/stage_profile.hpp"
 #include "clwe/tiny_sha3.h"
 #include <cstring>
 #include <algorithm>
@@ -31,24 +32,30 @@ void SHAKE256Sampler::init(const uint8_t* seed, size_t seed_len) {
     shake_xof(&ctx_);
 }
 
-void IRAM_ATTR SHAKE256Sampler::squeeze(uint8_t* out, size_t len) {
+void CLWE_HOT SHAKE256Sampler::squeeze(uint8_t* out, size_t len) {
     shake_out(&ctx_, out, len);
 }
 
-void IRAM_ATTR SHAKE256Sampler::random_bytes(uint8_t* out, size_t len) {
+void CLWE_HOT SHAKE256Sampler::squeeze_blocks(uint8_t* out, size_t nblocks) {
+    shake_out_blocks(&ctx_, out, nblocks);
+}
+
+void CLWE_HOT SHAKE256Sampler::random_bytes(uint8_t* out, size_t len) {
     squeeze(out, len);
 }
 
 int32_t SHAKE256Sampler::sample_binomial_coefficient(uint32_t eta) {
     // Sample from centered binomial distribution B(2η, 0.5) - η
     // Count the number of 1s in 2η random bits, then subtract η
+    // The XOF is a byte stream, so pulling one byte per 8 bits reads the same
+    // (2η + 7) / 8 bytes as a single squeeze without a heap buffer
     uint32_t count_ones = 0;
-    size_t num_bytes = (2 * eta + 7) / 8; // Enough bytes for 2η bits
-    std::vector<uint8_t> bytes(num_bytes);
-    random_bytes(bytes.data(), num_bytes);
+    uint8_t byte = 0;
 
     for (uint32_t i = 0; i < 2 * eta; ++i) {
-        uint8_t byte = bytes[i / 8];
+        if (i % 8 == 0) {
+            random_bytes(&byte, 1);
+        }
         uint8_t bit = (byte >> (i % 8)) & 1;
         count_ones += bit;
     }
@@ -58,10 +65,35 @@ int32_t SHAKE256Sampler::sample_binomial_coefficient(uint32_t eta) {
 
 void SHAKE256Sampler::sample_polynomial_binomial(uint32_t* coeffs, size_t degree,
                                                 uint32_t eta, uint32_t modulus) {
-    for (size_t i = 0; i < degree; ++i) {
-        int32_t sample = sample_binomial_coefficient(eta);
-        // Map to positive range: (sample mod modulus + modulus) mod modulus
-        coeffs[i] = (sample % static_cast<int32_t>(modulus) + modulus) % modulus;
+    StageTimer timer(KemStage::NoiseSampling);
+    // Each coefficient reads (2η + 7) / 8 consecutive bytes, so squeezing up to a rate
+    // block of them at once reads the same stream as sample_binomial_coefficient
+    const size_t coeff_bytes = (2 * eta + 7) / 8;
+    if (coeff_bytes == 0 || coeff_bytes > BLOCK_BYTES) {
+        for (size_t i = 0; i < degree; ++i) {
+            int32_t sample = sample_binomial_coefficient(eta);
+            coeffs[i] = (sample % static_cast<int32_t>(modulus) + modulus) % modulus;
+        }
+        return;
+    }
+
+    const size_t per_chunk = BLOCK_BYTES / coeff_bytes;
+    uint8_t chunk[BLOCK_BYTES];
+
+    for (size_t i = 0; i < degree; i += per_chunk) {
+        const size_t count = std::min(per_chunk, degree - i);
+        squeeze(chunk, count * coeff_bytes);
+
+        for (size_t c = 0; c < count; ++c) {
+            const uint8_t* bytes = chunk + c * coeff_bytes;
+            uint32_t count_ones = 0;
+            for (uint32_t b = 0; b < 2 * eta; ++b) {
+                count_ones += (bytes[b / 8] >> (b % 8)) & 1;
+            }
+            int32_t sample = static_cast<int32_t>(count_ones) - static_cast<int32_t>(eta);
+            // Map to positive range: (sample mod modulus + modulus) mod modulus
+            coeffs[i + c] = (sample % static_cast<int32_t>(modulus) + modulus) % modulus;
+        }
     }
 }
 
@@ -130,8 +162,12 @@ void SHAKE128Sampler::init(const uint8_t* seed, size_t seed_len) {
     shake_xof(&ctx_);
 }
 
-void IRAM_ATTR SHAKE128Sampler::squeeze(uint8_t* out, size_t len) {
+void CLWE_HOT SHAKE128Sampler::squeeze(uint8_t* out, size_t len) {
     shake_out(&ctx_, out, len);
 }
 
+void CLWE_HOT SHAKE128Sampler::squeeze_blocks(uint8_t* out, size_t nblocks) {
+    shake_out_blocks(&ctx_, out, nblocks);
+}
+
 } // namespace clwe
\ No newline at end of file
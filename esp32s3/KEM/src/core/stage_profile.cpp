@@ -0,0 +1,127 @@
+#include "clwe/stage_profile.hpp"
+#include <cstring>
+
+#ifdef ESP_PLATFORM
+#include <esp_cpu.h>
+#else
+#include <chrono>
+#endif
+
+// SystemView ships with the app_trace component; host builds keep the spans as no-ops
+#if defined(CLWE_SYSVIEW_TRACE) && defined(ESP_PLATFORM)
+#include "SEGGER_SYSVIEW.h"
+#define CLWE_SYSVIEW_ON_TARGET 1
+#endif
+
+namespace clwe {
+
+namespace {
+
+constexpr size_t MAX_CORES = 2;
+
+// Each core only adds to its own row, so no locking is needed between cores
+StageCycles core_counters[MAX_CORES];
+
+#ifdef CLWE_STAGE_PROFILE
+// CCOUNT on target; the 32-bit difference stays correct across one wrap-around. Off
+// target, nanoseconds stand in for cycles.
+inline uint32_t cycle_count() {
+#ifdef ESP_PLATFORM
+    return static_cast<uint32_t>(esp_cpu_get_cycle_count());
+#else
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+inline StageCycles& this_core() {
+#ifdef ESP_PLATFORM
+    return core_counters[esp_cpu_get_core_id() % MAX_CORES];
+#else
+    return core_counters[0];
+#endif
+}
+#endif
+
+#ifdef CLWE_SYSVIEW_TRACE
+inline void sysview_start(unsigned id) {
+#ifdef CLWE_SYSVIEW_ON_TARGET
+    SEGGER_SYSVIEW_OnUserStart(id);
+#else
+    (void)id;
+#endif
+}
+
+inline void sysview_stop(unsigned id) {
+#ifdef CLWE_SYSVIEW_ON_TARGET
+    SEGGER_SYSVIEW_OnUserStop(id);
+#else
+    (void)id;
+#endif
+}
+#endif
+
+} // namespace
+
+const char* kem_stage_name(KemStage stage) {
+    switch (stage) {
+    case KemStage::MatrixExpansion: return "matrix_a";
+    case KemStage::NoiseSampling: return "cbd";
+    case KemStage::NTT: return "ntt";
+    case KemStage::Basemul: return "basemul";
+    case KemStage::Packing: return "packing";
+    }
+    return "unknown";
+}
+
+void stage_profile_reset() {
+    std::memset(core_counters, 0, sizeof(core_counters));
+}
+
+StageCycles stage_profile_snapshot() {
+    StageCycles sum;
+    std::memset(&sum, 0, sizeof(sum));
+    for (const StageCycles& core : core_counters) {
+        for (size_t s = 0; s < KEM_STAGE_COUNT; ++s) {
+            sum.cycles[s] += core.cycles[s];
+            sum.calls[s] += core.calls[s];
+        }
+    }
+    return sum;
+}
+
+#if defined(CLWE_STAGE_PROFILE) || defined(CLWE_SYSVIEW_TRACE)
+StageTimer::StageTimer(KemStage stage) : stage_(stage), start_(0) {
+#ifdef CLWE_SYSVIEW_TRACE
+    sysview_start(static_cast<unsigned>(stage));
+#endif
+#ifdef CLWE_STAGE_PROFILE
+    // Read last, so the event record above is not charged to the stage
+    start_ = cycle_count();
+#endif
+}
+
+StageTimer::~StageTimer() {
+#ifdef CLWE_STAGE_PROFILE
+    uint32_t elapsed = cycle_count() - start_;
+    StageCycles& counters = this_core();
+    counters.cycles[static_cast<size_t>(stage_)] += elapsed;
+    counters.calls[static_cast<size_t>(stage_)] += 1;
+#endif
+#ifdef CLWE_SYSVIEW_TRACE
+    sysview_stop(static_cast<unsigned>(stage_));
+#endif
+}
+#endif
+
+#ifdef CLWE_SYSVIEW_TRACE
+OperationTrace::OperationTrace(KemOperation operation) : operation_(operation) {
+    sysview_start(SYSVIEW_OPERATION_ID_BASE + static_cast<unsigned>(operation));
+}
+
+OperationTrace::~OperationTrace() {
+    sysview_stop(SYSVIEW_OPERATION_ID_BASE + static_cast<unsigned>(operation_));
+}
+#endif
+
+} // namespace clwe
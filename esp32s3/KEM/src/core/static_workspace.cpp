@@ -0,0 +1,67 @@
+#ifdef CLWE_STATIC_WORKSPACE
+
+#include "clwe/static_workspace.hpp"
+#include <stdexcept>
+#include <string>
+
+#ifdef ESP_PLATFORM
+#include <esp_attr.h>
+#include <esp_heap_caps.h>
+#include <sdkconfig.h>
+#endif
+
+namespace clwe {
+
+namespace {
+
+// .bss in internal DRAM; with CONFIG_SPIRAM_ALLOW_BSS_SEG_EXTERNAL_MEMORY the linker
+// can place it in PSRAM instead and leave the internal SRAM to the application
+#if defined(ESP_PLATFORM) && defined(CONFIG_SPIRAM_ALLOW_BSS_SEG_EXTERNAL_MEMORY) && defined(CLWE_STATIC_WORKSPACE_EXT_BSS)
+EXT_RAM_BSS_ATTR StaticWorkspace default_workspace;
+#else
+StaticWorkspace default_workspace;
+#endif
+
+StaticWorkspace* active_workspace = &default_workspace;
+
+} // namespace
+
+void static_workspace_attach(void* region, size_t size) {
+    if (region == nullptr) {
+        throw std::invalid_argument("Static workspace region cannot be null");
+    }
+    if (size < STATIC_WORKSPACE_BYTES) {
+        throw std::invalid_argument("Static workspace region too small: need " + std::to_string(STATIC_WORKSPACE_BYTES) +
+                                    " bytes, got " + std::to_string(size));
+    }
+    if (reinterpret_cast<uintptr_t>(region) % alignof(StaticWorkspace) != 0) {
+        throw std::invalid_argument("Static workspace region must be " + std::to_string(alignof(StaticWorkspace)) +
+                                    "-byte aligned");
+    }
+    active_workspace = static_cast<StaticWorkspace*>(region);
+}
+
+void static_workspace_attach_psram() {
+#if defined(ESP_PLATFORM) && defined(CONFIG_SPIRAM)
+    void* region = heap_caps_malloc(STATIC_WORKSPACE_BYTES, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (region == nullptr) {
+        throw std::runtime_error("Failed to allocate " + std::to_string(STATIC_WORKSPACE_BYTES) +
+                                 " bytes of PSRAM for the static workspace");
+    }
+    active_workspace = static_cast<StaticWorkspace*>(region);
+#else
+    throw std::runtime_error("PSRAM is not enabled in this build");
+#endif
+}
+
+void static_workspace_detach() {
+    active_workspace = &default_workspace;
+}
+
+StaticWorkspace& static_workspace() {
+    return *active_workspace;
+}
+
+} // namespace clwe
+
+#endif // CLWE_STATIC_WORKSPACE
@@ -6,10 +6,178 @@
 
 #include "clwe/tiny_sha3.h"
 
+#include <string.h>
+
+#include "clwe/hot_path.h"
+
+#ifdef ESP_PLATFORM
+#include <esp_attr.h>
+#endif
+
+#ifndef DRAM_ATTR
+#define DRAM_ATTR
+#endif
+
+// 32-bit targets (Xtensa LX7 on the ESP32-S3) run Keccak-f[1600] on bit-interleaved
+// lanes, so every 64-bit rotation becomes two 32-bit rotations with no carries between
+// words. CLWE_KECCAK_INTERLEAVED selects it on 64-bit hosts for testing.
+#if defined(CLWE_KECCAK_INTERLEAVED) || UINTPTR_MAX == 0xFFFFFFFFu
+#define KECCAKF_INTERLEAVED 1
+#endif
+
+#ifdef KECCAKF_INTERLEAVED
+
+#define ROTL32(x, y) (((x) << (y)) | ((x) >> ((32 - (y)) & 31)))
+
+// round constants split into even and odd bits
+static const uint32_t DRAM_ATTR keccakf_rndc32[24][2] = {
+    { 0x00000001, 0x00000000 }, { 0x00000000, 0x00000089 }, { 0x00000000, 0x8000008b },
+    { 0x00000000, 0x80008080 }, { 0x00000001, 0x0000008b }, { 0x00000001, 0x00008000 },
+    { 0x00000001, 0x80008088 }, { 0x00000001, 0x80000082 }, { 0x00000000, 0x0000000b },
+    { 0x00000000, 0x0000000a }, { 0x00000001, 0x00008082 }, { 0x00000000, 0x00008003 },
+    { 0x00000001, 0x0000808b }, { 0x00000001, 0x8000000b }, { 0x00000001, 0x8000008a },
+    { 0x00000001, 0x80000081 }, { 0x00000000, 0x80000081 }, { 0x00000000, 0x00000008 },
+    { 0x00000000, 0x00000083 }, { 0x00000000, 0x80008003 }, { 0x00000001, 0x80008088 },
+    { 0x00000000, 0x80000088 }, { 0x00000001, 0x00008000 }, { 0x00000000, 0x80008082 }
+};
+
+static const uint8_t DRAM_ATTR keccakf_rotc32[24] = {
+    1,  3,  6,  10, 15, 21, 28, 36, 45, 55, 2,  14,
+    27, 41, 56, 8,  25, 43, 62, 18, 39, 61, 20, 44
+};
+
+static const uint8_t DRAM_ATTR keccakf_piln32[24] = {
+    10, 7,  11, 17, 18, 3, 5,  16, 8,  21, 24, 4,
+    15, 23, 19, 13, 12, 2, 20, 14, 22, 9,  6,  1
+};
+
+// gather the even bits of x into the low half and the odd bits into the high half
+static inline uint32_t keccak_unzip32(uint32_t x)
+{
+    uint32_t t;
+
+    t = (x ^ (x >> 1)) & 0x22222222; x ^= t ^ (t << 1);
+    t = (x ^ (x >> 2)) & 0x0C0C0C0C; x ^= t ^ (t << 2);
+    t = (x ^ (x >> 4)) & 0x00F000F0; x ^= t ^ (t << 4);
+    t = (x ^ (x >> 8)) & 0x0000FF00; x ^= t ^ (t << 8);
+    return x;
+}
+
+static inline uint32_t keccak_zip32(uint32_t x)
+{
+    uint32_t t;
+
+    t = (x ^ (x >> 8)) & 0x0000FF00; x ^= t ^ (t << 8);
+    t = (x ^ (x >> 4)) & 0x00F000F0; x ^= t ^ (t << 4);
+    t = (x ^ (x >> 2)) & 0x0C0C0C0C; x ^= t ^ (t << 2);
+    t = (x ^ (x >> 1)) & 0x22222222; x ^= t ^ (t << 1);
+    return x;
+}
+
+// a[2 * i] holds the even bits of lane i, a[2 * i + 1] the odd bits
+static void CLWE_HOT keccakf_rounds32(uint32_t a[50])
+{
+    int i, j, r;
+    uint32_t ce[5], co[5], de, dob, te, to, se, so;
+    unsigned rot;
+
+    for (r = 0; r < KECCAKF_ROUNDS; r++) {
+
+        // Theta; a rotation by one moves odd bits up into the even word
+        for (i = 0; i < 5; i++) {
+            ce[i] = a[2 * i] ^ a[2 * i + 10] ^ a[2 * i + 20] ^ a[2 * i + 30] ^ a[2 * i + 40];
+            co[i] = a[2 * i + 1] ^ a[2 * i + 11] ^ a[2 * i + 21] ^ a[2 * i + 31] ^ a[2 * i + 41];
+        }
+
+        for (i = 0; i < 5; i++) {
+            j = i == 0 ? 4 : i - 1;
+            de = ce[j] ^ ROTL32(co[i == 4 ? 0 : i + 1], 1);
+            dob = co[j] ^ ce[i == 4 ? 0 : i + 1];
+            for (j = 0; j < 50; j += 10) {
+                a[j + 2 * i] ^= de;
+                a[j + 2 * i + 1] ^= dob;
+            }
+        }
+
+        // Rho Pi; an odd rotation swaps the halves
+        te = a[2];
+        to = a[3];
+        for (i = 0; i < 24; i++) {
+            j = 2 * keccakf_piln32[i];
+            se = a[j];
+            so = a[j + 1];
+            rot = keccakf_rotc32[i];
+            if (rot & 1) {
+                a[j] = ROTL32(to, (rot + 1) >> 1);
+                a[j + 1] = ROTL32(te, rot >> 1);
+            } else {
+                a[j] = ROTL32(te, rot >> 1);
+                a[j + 1] = ROTL32(to, rot >> 1);
+            }
+            te = se;
+            to = so;
+        }
+
+        //  Chi
+        for (j = 0; j < 50; j += 10) {
+            for (i = 0; i < 5; i++) {
+                ce[i] = a[j + 2 * i];
+                co[i] = a[j + 2 * i + 1];
+            }
+            for (i = 0; i < 5; i++) {
+                a[j + 2 * i] ^= (~ce[(i + 1) % 5]) & ce[(i + 2) % 5];
+                a[j + 2 * i + 1] ^= (~co[(i + 1) % 5]) & co[(i + 2) % 5];
+            }
+        }
+
+        //  Iota
+        a[0] ^= keccakf_rndc32[r][0];
+        a[1] ^= keccakf_rndc32[r][1];
+    }
+}
+
+#endif // KECCAKF_INTERLEAVED
+
 // update the state with given number of rounds
 
-void sha3_keccakf(uint64_t st[25])
+void CLWE_HOT sha3_keccakf(uint64_t st[25])
 {
+    // variables
+    int i;
+
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+    uint64_t t;
+    uint8_t *v;
+
+    // endianess conversion. this is redundant on little-endian targets
+    for (i = 0; i < 25; i++) {
+        v = (uint8_t *) &st[i];
+        st[i] = ((uint64_t) v[0])     | (((uint64_t) v[1]) << 8) |
+            (((uint64_t) v[2]) << 16) | (((uint64_t) v[3]) << 24) |
+            (((uint64_t) v[4]) << 32) | (((uint64_t) v[5]) << 40) |
+            (((uint64_t) v[6]) << 48) | (((uint64_t) v[7]) << 56);
+    }
+#endif
+
+#ifdef KECCAKF_INTERLEAVED
+    uint32_t a[50], lo, hi;
+
+    // split every lane into its even and odd bits
+    for (i = 0; i < 25; i++) {
+        lo = keccak_unzip32((uint32_t) st[i]);
+        hi = keccak_unzip32((uint32_t) (st[i] >> 32));
+        a[2 * i] = (lo & 0x0000FFFF) | (hi << 16);
+        a[2 * i + 1] = (lo >> 16) | (hi & 0xFFFF0000);
+    }
+
+    keccakf_rounds32(a);
+
+    for (i = 0; i < 25; i++) {
+        lo = keccak_zip32((a[2 * i] & 0x0000FFFF) | (a[2 * i + 1] << 16));
+        hi = keccak_zip32((a[2 * i] >> 16) | (a[2 * i + 1] & 0xFFFF0000));
+        st[i] = ((uint64_t) hi << 32) | lo;
+    }
+#else
     // constants
     const uint64_t keccakf_rndc[24] = {
         0x0000000000000001, 0x0000000000008082, 0x800000000000808a,
@@ -30,22 +198,8 @@ void sha3_keccakf(uint64_t st[25])
         15, 23, 19, 13, 12, 2, 20, 14, 22, 9,  6,  1
     };
 
-    // variables
-    int i, j, r;
-    uint64_t t, bc[5];
-
-#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
-    uint8_t *v;
-
-    // endianess conversion. this is redundant on little-endian targets
-    for (i = 0; i < 25; i++) {
-        v = (uint8_t *) &st[i];
-        st[i] = ((uint64_t) v[0])     | (((uint64_t) v[1]) << 8) |
-            (((uint64_t) v[2]) << 16) | (((uint64_t) v[3]) << 24) |
-            (((uint64_t) v[4]) << 32) | (((uint64_t) v[5]) << 40) |
-            (((uint64_t) v[6]) << 48) | (((uint64_t) v[7]) << 56);
-    }
-#endif
+    int j, r;
+    uint64_t u, bc[5];
 
     // actual iteration
     for (r = 0; r < KECCAKF_ROUNDS; r++) {
@@ -55,18 +209,18 @@ void sha3_keccakf(uint64_t st[25])
             bc[i] = st[i] ^ st[i + 5] ^ st[i + 10] ^ st[i + 15] ^ st[i + 20];
 
         for (i = 0; i < 5; i++) {
-            t = bc[(i + 4) % 5] ^ ROTL64(bc[(i + 1) % 5], 1);
+            u = bc[(i + 4) % 5] ^ ROTL64(bc[(i + 1) % 5], 1);
             for (j = 0; j < 25; j += 5)
-                st[j + i] ^= t;
+                st[j + i] ^= u;
         }
 
         // Rho Pi
-        t = st[1];
+        u = st[1];
         for (i = 0; i < 24; i++) {
             j = keccakf_piln[i];
             bc[0] = st[j];
-            st[j] = ROTL64(t, keccakf_rotc[i]);
-            t = bc[0];
+            st[j] = ROTL64(u, keccakf_rotc[i]);
+            u = bc[0];
         }
 
         //  Chi
@@ -80,6 +234,7 @@ void sha3_keccakf(uint64_t st[25])
         //  Iota
         st[0] ^= keccakf_rndc[r];
     }
+#endif
 
 #if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
     // endianess conversion. this is redundant on little-endian targets
@@ -173,18 +328,31 @@ void shake_xof(sha3_ctx_t *c)
     c->pt = 0;
 }
 
-void shake_out(sha3_ctx_t *c, void *out, size_t len)
+// copies whole runs of the rate instead of one byte per iteration
+
+void CLWE_HOT shake_out(sha3_ctx_t *c, void *out, size_t len)
 {
-    size_t i;
-    int j;
+    uint8_t *p = (uint8_t *) out;
+    size_t run;
 
-    j = c->pt;
-    for (i = 0; i < len; i++) {
-        if (j >= c->rsiz) {
+    while (len > 0) {
+        if (c->pt >= c->rsiz) {
             sha3_keccakf(c->st.q);
-            j = 0;
+            c->pt = 0;
         }
-        ((uint8_t *) out)[i] = c->st.b[j++];
+        run = (size_t) (c->rsiz - c->pt);
+        if (run > len)
+            run = len;
+        memcpy(p, &c->st.b[c->pt], run);
+        c->pt += (int) run;
+        p += run;
+        len -= run;
     }
-    c->pt = j;
+}
+
+// squeeze nblocks * rsiz bytes; the same stream as shake_out with that length
+
+void CLWE_HOT shake_out_blocks(sha3_ctx_t *c, void *out, size_t nblocks)
+{
+    shake_out(c, out, nblocks * (size_t) c->rsiz);
 }
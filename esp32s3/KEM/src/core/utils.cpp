@@ -1,4 +1,5 @@
 #include "clwe/utils.hpp"
+#include "clwe/csprng.hpp"
 #include <cstring>
 #include <chrono>
 #include <iostream>
@@ -263,8 +264,8 @@ uint32_t mod_pow(uint32_t base, uint32_t exp, uint32_t mod) {
     return result;
 }
 
-// Secure random bytes using platform-specific APIs
-void secure_random_bytes(uint8_t* buffer, size_t len) {
+// Entropy using platform-specific APIs
+void os_random_bytes(uint8_t* buffer, size_t len) {
 #ifdef __APPLE__
     if (SecRandomCopyBytes(kSecRandomDefault, len, buffer) != 0) {
         throw std::runtime_error("Failed to generate secure random bytes on macOS");
@@ -278,15 +279,26 @@ void secure_random_bytes(uint8_t* buffer, size_t len) {
         throw std::runtime_error("Failed to generate secure random bytes on Linux");
     }
 #elif defined(ESP_PLATFORM)
-    for (size_t i = 0; i < len; i += 4) {
-        uint32_t rand_val = esp_random();
-        uint8_t* rand_bytes = reinterpret_cast<uint8_t*>(&rand_val);
-        size_t copy_len = std::min(size_t(4), len - i);
-        memcpy(buffer + i, rand_bytes, copy_len);
-    }
+    esp_fill_random(buffer, len);
 #else
     throw std::runtime_error("Secure random not implemented for this platform");
 #endif
 }
 
+void secure_random_bytes(uint8_t* buffer, size_t len) {
+#ifdef CLWE_DIRECT_OS_RANDOM
+    os_random_bytes(buffer, len);
+#else
+    drbg_random_bytes(buffer, len);
+#endif
+}
+
+void secure_zero(void* ptr, size_t len) {
+    // Stores through a volatile pointer are observable, so they survive dead-store elimination
+    volatile uint8_t* bytes = static_cast<volatile uint8_t*>(ptr);
+    for (size_t i = 0; i < len; ++i) {
+        bytes[i] = 0;
+    }
+}
+
 } // namespace clwe
\ No newline at end of file
@@ -26,13 +26,20 @@
 #include "clwe/color_ntt_engine.hpp"
 #include <vector>
 #include <array>
+#include <functional>
 #include <memory>
 
+#ifdef CLWE_STATIC_WORKSPACE
+#include "clwe/static_workspace.hpp"
+#endif
+
 namespace clwe {
 
 // Forward declarations
 class ColorNTTEngine;
 class ColorKEM;
+class DualCoreExecutor;
+class NoisePool;
 
 /**
  * @brief Public key structure for ColorKEM
@@ -103,6 +110,39 @@ struct ColorCiphertext {
     static ColorCiphertext deserialize(const std::vector<uint8_t>& data, const CLWEParameters& params);
 };
 
+/**
+ * @brief Read-only view of a public key held elsewhere
+ *
+ * Points at a seed and public data laid out as in ColorPublicKey, for example
+ * a FlashKeyStore record in memory-mapped flash, so encapsulation to a
+ * long-term key needs no RAM copy of it. The viewed memory must outlive the view.
+ */
+struct ColorPublicKeyView {
+    const uint8_t* seed = nullptr;         /**< 32-byte matrix seed */
+    const uint8_t* public_data = nullptr;  /**< k * n big-endian coefficients, as ColorPublicKey::public_data */
+    size_t public_data_size = 0;           /**< Size of public_data in bytes */
+    CLWEParameters params;                 /**< Parameters the key is for */
+
+    ColorPublicKeyView() = default;
+    explicit ColorPublicKeyView(const ColorPublicKey& public_key)
+        : seed(public_key.seed.data()), public_data(public_key.public_data.data()),
+          public_data_size(public_key.public_data.size()), params(public_key.params) {}
+};
+
+/**
+ * @brief Read-only view of a prepared private key held elsewhere
+ *
+ * The secret vector is already in the NTT domain (ntt_forward_colors() of
+ * every polynomial of ColorPrivateKey::secret_data), stored as k * n
+ * ColorValue in their native byte layout. Decapsulation reads it in place, so
+ * it may point into memory-mapped flash (see FlashKeyStore). The viewed
+ * memory must outlive the view.
+ */
+struct ColorPrivateKeyView {
+    const ColorValue* prepared_secret = nullptr;  /**< k * n NTT-domain coefficients */
+    CLWEParameters params;                        /**< Parameters the key is for */
+};
+
 /**
  * @brief Main ColorKEM key encapsulation mechanism implementation
  *
@@ -135,32 +175,59 @@ class ColorKEM {
 private:
     CLWEParameters params_;
     std::unique_ptr<ColorNTTEngine> color_ntt_engine_;
+    DualCoreExecutor* executor_;  // not owned; null runs everything on the calling task
+    NoisePool* noise_pool_;       // not owned; null samples every encapsulation afresh
 
     // Helper methods
     std::vector<std::vector<std::vector<ColorValue>>> generate_matrix_A(const std::array<uint8_t, 32>& seed) const;
+    std::vector<std::vector<ColorValue>> generate_matrix_A_row(const std::array<uint8_t, 32>& seed, uint32_t i) const;
+    // Row i of A into k consecutive polynomials at row
+    void generate_matrix_A_row(const std::array<uint8_t, 32>& seed, uint32_t i, ColorValue* row) const;
+    // Entry A[i][j] into the n coefficients at poly, without touching the heap
+    void generate_matrix_A_entry(const std::array<uint8_t, 32>& seed, uint32_t i, uint32_t j, ColorValue* poly) const;
     std::vector<std::vector<ColorValue>> generate_error_vector(uint32_t eta) const;
     std::vector<std::vector<ColorValue>> generate_secret_key(uint32_t eta) const;
     // Deterministic versions for KATs
     std::vector<std::vector<ColorValue>> generate_error_vector_deterministic(uint32_t eta, const std::array<uint8_t, 32>& seed) const;
     std::vector<std::vector<ColorValue>> generate_secret_key_deterministic(uint32_t eta, const std::array<uint8_t, 32>& seed) const;
-    std::vector<std::vector<ColorValue>> generate_public_key(const std::vector<std::vector<ColorValue>>& secret_key,
-                                                const std::vector<std::vector<std::vector<ColorValue>>>& matrix_A,
+    std::vector<std::vector<ColorValue>> generate_public_key(const std::vector<std::vector<ColorValue>>& As,
                                                 const std::vector<std::vector<ColorValue>>& error_vector) const;
     std::vector<std::vector<ColorValue>> matrix_vector_mul(const std::vector<std::vector<std::vector<ColorValue>>>& matrix,
                                               const std::vector<std::vector<ColorValue>>& vector) const;
     std::vector<std::vector<ColorValue>> matrix_transpose_vector_mul(const std::vector<std::vector<std::vector<ColorValue>>>& matrix,
                                                         const std::vector<std::vector<ColorValue>>& vector) const;
+    // A * vector (or A^T * vector) for A expanded from seed; sample() fills vector first. Without
+    // an executor each entry of A is expanded just before it is multiplied, so one polynomial of
+    // A is live; with one the rows of A are expanded on the worker core while sample() runs and
+    // all of A is kept. A and the multiplication scratch are placed by the active PlacementPolicy.
+    std::vector<std::vector<ColorValue>> expand_and_multiply(const std::array<uint8_t, 32>& seed, bool transpose,
+                                                const std::function<void()>& sample,
+                                                const std::vector<std::vector<ColorValue>>& vector) const;
     ColorValue decrypt_message(const std::vector<std::vector<ColorValue>>& secret_key,
                               const std::vector<std::vector<ColorValue>>& ciphertext) const;
+    ColorValue decode_message(uint64_t c2_val, uint64_t s_dot_c1) const;
     ColorValue generate_shared_secret() const;
     std::vector<uint8_t> encode_color_secret(const ColorValue& secret) const;
     ColorValue decode_color_secret(const std::vector<uint8_t>& encoded) const;
     std::vector<uint8_t> color_secret_to_bytes(const ColorValue& secret);
     ColorValue bytes_to_color_secret(const std::vector<uint8_t>& bytes);
-    std::vector<std::vector<ColorValue>> encrypt_message(const std::vector<std::vector<std::vector<ColorValue>>>& matrix_A,
+    // Polynomials to and from 4-byte big-endian coefficients, timed as KemStage::Packing
+    std::vector<uint8_t> pack_colors(const std::vector<std::vector<ColorValue>>& polys);
+    std::vector<std::vector<ColorValue>> unpack_colors(const std::vector<uint8_t>& data, size_t rows);
+    std::vector<std::vector<ColorValue>> unpack_colors(const uint8_t* data, size_t rows);
+    // Fills r, e1 and the constant term of e2 for one encryption
+    using NoiseSource = std::function<void(std::vector<std::vector<ColorValue>>& r,
+                                           std::vector<std::vector<ColorValue>>& e1, ColorValue& e2)>;
+    std::vector<std::vector<ColorValue>> encrypt_with_noise(const std::array<uint8_t, 32>& matrix_seed,
+                                               const std::vector<std::vector<ColorValue>>& public_key,
+                                               const ColorValue& message, const NoiseSource& sample) const;
+    // Claims a ready bundle of the noise pool, if any, and wipes it once decoded
+    bool take_precomputed_noise(std::vector<std::vector<ColorValue>>& r, std::vector<std::vector<ColorValue>>& e1,
+                                ColorValue& e2, ColorValue& message);
+    std::vector<std::vector<ColorValue>> encrypt_message(const std::array<uint8_t, 32>& matrix_seed,
                                            const std::vector<std::vector<ColorValue>>& public_key,
                                            const ColorValue& message) const;
-    std::vector<std::vector<ColorValue>> encrypt_message_deterministic(const std::vector<std::vector<std::vector<ColorValue>>>& matrix_A,
+    std::vector<std::vector<ColorValue>> encrypt_message_deterministic(const std::array<uint8_t, 32>& matrix_seed,
                                                           const std::vector<std::vector<ColorValue>>& public_key,
                                                           const ColorValue& message,
                                                           const std::array<uint8_t, 32>& r_seed,
@@ -168,6 +235,21 @@ private:
                                                           const std::array<uint8_t, 32>& e2_seed) const;
     ColorValue hash_ciphertext(const ColorCiphertext& ciphertext) const;
 
+#ifdef CLWE_STATIC_WORKSPACE
+    // Flat-buffer counterparts of the helpers above for the zero-heap profile
+    void require_static_params() const;
+    void sample_vector_into(uint32_t eta, const std::array<uint8_t, 32>* seed, ColorValue* vector) const;
+    // A * vector + addend (A^T with transpose), expanding each entry of A from seed into
+    // ws.matrix_entry just before it is used
+    void matrix_vector_mul_into(const std::array<uint8_t, 32>& seed, const ColorValue* vector, bool transpose,
+                                const ColorValue* addend, ColorValue* result, StaticWorkspace& ws) const;
+    uint32_t inner_product_constant(const ColorValue* a, const ColorValue* b, StaticWorkspace& ws) const;
+    ColorValue encapsulate_into(const std::array<uint8_t, 32>& seed, const uint8_t* public_data,
+                                const std::array<uint8_t, 32>* r_seed, const std::array<uint8_t, 32>* e1_seed,
+                                const std::array<uint8_t, 32>* e2_seed, const ColorValue& shared_secret,
+                                uint8_t* ciphertext_data, uint8_t* shared_secret_hint);
+#endif
+
 public:
     /**
      * @brief Construct a new ColorKEM instance
@@ -228,6 +310,9 @@ public:
      * 3. Computes ciphertext using public key
      * 4. Returns (ciphertext, shared_secret) pair
      *
+     * With a NoisePool attached, steps 1 and 2 take a precomputed bundle instead
+     * while one is ready.
+     *
      * @param public_key The recipient's public key
      * @return std::pair<ColorCiphertext, ColorValue> Ciphertext and encapsulated shared secret
      *
@@ -266,6 +351,69 @@ public:
                            const ColorPrivateKey& private_key,
                            const ColorCiphertext& ciphertext);
 
+    /**
+     * @brief Encapsulate to a public key read in place
+     *
+     * Same as encapsulate(const ColorPublicKey&) without copying the key into a
+     * ColorPublicKey first.
+     *
+     * @throws std::invalid_argument If the view's parameters or size do not match this instance
+     */
+    std::pair<ColorCiphertext, ColorValue> encapsulate(const ColorPublicKeyView& public_key);
+
+    /**
+     * @brief Decapsulate with a prepared private key read in place
+     *
+     * Returns what decapsulate() returns for the same key. One secret
+     * polynomial at a time is multiplied straight from the view, so the key is
+     * never copied to RAM: the only buffers are two polynomials of scratch,
+     * placed by PlacementPolicy::scratch, instead of the unpacked key and
+     * ciphertext.
+     *
+     * @throws std::invalid_argument If the view or ciphertext does not match this instance
+     */
+    ColorValue decapsulate(const ColorPrivateKeyView& private_key, const ColorCiphertext& ciphertext);
+
+    /**
+     * @brief Split keygen and encapsulation across the ESP32-S3's two cores
+     *
+     * Matrix A is expanded row by row on the executor's worker core while this
+     * task samples the noise vectors and multiplies the finished rows. Outputs are
+     * byte-identical to the single-core path. Pass nullptr to go back to it.
+     *
+     * @param executor Executor that outlives its use by this instance; may be
+     *                 shared by several ColorKEM instances
+     *
+     * @see DualCoreExecutor
+     */
+    void set_executor(DualCoreExecutor* executor);
+
+    /**
+     * @brief Let encapsulate() draw its randomness from precomputed bundles
+     *
+     * Pass nullptr to sample every encapsulation afresh again.
+     *
+     * @param pool Pool that outlives its use by this instance
+     *
+     * @throws std::invalid_argument If the pool was made for another security level
+     *
+     * @see NoisePool
+     */
+    void set_noise_pool(NoisePool* pool);
+
+    /**
+     * @brief Fill empty bundles of the attached NoisePool
+     *
+     * Samples the message bit and the r, e1 and e2 noise of future encapsulations,
+     * for an idle period ahead of a latency-sensitive handshake.
+     *
+     * @param max_bundles Upper bound on the bundles filled by this call
+     * @return size_t Number of bundles filled
+     *
+     * @throws std::logic_error If no pool is attached
+     */
+    size_t precompute_noise(size_t max_bundles = SIZE_MAX);
+
     // Key verification
     bool verify_keypair(const ColorPublicKey& public_key, const ColorPrivateKey& private_key) const;
 
@@ -281,6 +429,64 @@ public:
                                                                      const std::array<uint8_t, 32>& e2_seed,
                                                                      const ColorValue& shared_secret);
 
+#ifdef CLWE_STATIC_WORKSPACE
+    /**
+     * @brief Generate a key pair without heap allocation
+     *
+     * Produces the same bytes keygen() stores in ColorPublicKey::seed,
+     * ColorPublicKey::public_data and ColorPrivateKey::secret_data, working in
+     * static_workspace() and the caller's buffers only.
+     *
+     * @param seed Receives the 32-byte matrix seed
+     * @param public_data STATIC_PUBLIC_DATA_BYTES output buffer
+     * @param secret_data STATIC_SECRET_DATA_BYTES output buffer
+     *
+     * @throws std::invalid_argument If this instance is not at CLWE_STATIC_LEVEL
+     */
+    void keygen_static(std::array<uint8_t, 32>& seed, uint8_t* public_data, uint8_t* secret_data);
+
+    // Deterministic zero-heap key generation, byte-identical to keygen_deterministic()
+    void keygen_deterministic_static(const std::array<uint8_t, 32>& matrix_seed,
+                                     const std::array<uint8_t, 32>& secret_seed,
+                                     const std::array<uint8_t, 32>& error_seed,
+                                     uint8_t* public_data, uint8_t* secret_data);
+
+    /**
+     * @brief Encapsulate a shared secret without heap allocation
+     *
+     * @param seed Matrix seed of the recipient's public key
+     * @param public_data STATIC_PUBLIC_DATA_BYTES of public key data
+     * @param ciphertext_data STATIC_CIPHERTEXT_DATA_BYTES output buffer
+     * @param shared_secret_hint STATIC_HINT_BYTES output buffer
+     * @return ColorValue The encapsulated shared secret
+     *
+     * @throws std::invalid_argument If this instance is not at CLWE_STATIC_LEVEL
+     */
+    ColorValue encapsulate_static(const std::array<uint8_t, 32>& seed, const uint8_t* public_data,
+                                  uint8_t* ciphertext_data, uint8_t* shared_secret_hint);
+
+    // Deterministic zero-heap encapsulation, byte-identical to encapsulate_deterministic()
+    ColorValue encapsulate_deterministic_static(const std::array<uint8_t, 32>& seed, const uint8_t* public_data,
+                                                const std::array<uint8_t, 32>& r_seed,
+                                                const std::array<uint8_t, 32>& e1_seed,
+                                                const std::array<uint8_t, 32>& e2_seed,
+                                                const ColorValue& shared_secret,
+                                                uint8_t* ciphertext_data, uint8_t* shared_secret_hint);
+
+    /**
+     * @brief Decapsulate a shared secret without heap allocation
+     *
+     * @param secret_data STATIC_SECRET_DATA_BYTES of private key data
+     * @param ciphertext_data STATIC_CIPHERTEXT_DATA_BYTES of ciphertext data
+     * @param shared_secret_hint STATIC_HINT_BYTES of ciphertext hint
+     * @return ColorValue The recovered shared secret, as decapsulate() returns it
+     *
+     * @throws std::invalid_argument If this instance is not at CLWE_STATIC_LEVEL
+     */
+    ColorValue decapsulate_static(const uint8_t* secret_data, const uint8_t* ciphertext_data,
+                                  const uint8_t* shared_secret_hint);
+#endif
+
     // Getters
     const CLWEParameters& params() const { return params_; }
 };
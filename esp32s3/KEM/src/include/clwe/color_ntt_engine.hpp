@@ -46,8 +46,8 @@ namespace clwe {
  */
 class ColorNTTEngine : public NTTEngine {
 private:
-    std::vector<ColorValue> color_zetas_;
-    std::vector<ColorValue> color_zetas_inv_;
+    PlacedVector<ColorValue> color_zetas_;      // placed by PlacementPolicy::tables
+    PlacedVector<ColorValue> color_zetas_inv_;
 
     ColorValue color_to_crypto_space(const ColorValue& color) const;
     ColorValue crypto_space_to_color(const ColorValue& crypto_val) const;
@@ -116,6 +116,26 @@ public:
      */
     void multiply_colors(const ColorValue* a, const ColorValue* b, ColorValue* result) const;
 
+    /**
+     * @brief Multiply two color polynomials using caller-provided scratch
+     *
+     * Same result as the three-argument overload without allocating.
+     *
+     * @param scratch Work area of 2n coefficients, must not overlap the operands
+     */
+    void multiply_colors(const ColorValue* a, const ColorValue* b, ColorValue* result, ColorValue* scratch) const;
+
+    /**
+     * @brief Multiply by a polynomial already transformed with ntt_forward_colors()
+     *
+     * Same result as multiply_colors(a, b, ...) given a_ntt = NTT(a). a_ntt is
+     * only read, so it may point into memory-mapped flash.
+     *
+     * @param scratch Work area of n coefficients, must not overlap the operands
+     */
+    void multiply_colors_prepared(const ColorValue* a_ntt, const ColorValue* b, ColorValue* result,
+                                  ColorValue* scratch) const;
+
     // Base class interface implementations
     /**
      * @brief Forward NTT for uint32_t polynomials (base class interface)
@@ -11,7 +11,8 @@ enum class CPUArchitecture {
     X86_64,
     ARM64,
     RISCV64,
-    PPC64
+    PPC64,
+    XTENSA
 };
 
 enum class SIMDSupport {
@@ -20,7 +21,8 @@ enum class SIMDSupport {
     AVX512,
     NEON,
     RVV,
-    VSX
+    VSX,
+    PIE
 };
 
 struct CPUFeatures {
@@ -42,6 +44,8 @@ struct CPUFeatures {
     bool has_vsx = false;
     bool has_altivec = false;
 
+    bool has_pie = false;  // ESP32-S3 Processor Instruction Extensions
+
     std::string to_string() const;
 };
 
@@ -58,6 +62,8 @@ private:
 
     static CPUFeatures detect_ppc();
 
+    static CPUFeatures detect_xtensa();
+
     static CPUArchitecture detect_architecture();
 
     static bool has_cpuid();
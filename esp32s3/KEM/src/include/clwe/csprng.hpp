@@ -0,0 +1,64 @@
+#ifndef CSPRNG_HPP
+#define CSPRNG_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace clwe {
+
+// ChaCha20 DRBG with fast key erasure: each refill runs ChaCha20 under the current key,
+// replaces the key with the first 32 keystream bytes and serves the rest, wiping every
+// byte it hands out. Compromising the state never reveals earlier output.
+// secure_random_bytes() serves from one instance seeded from the hardware RNG
+// (esp_fill_random), so a KEM operation costs at most one entropy read.
+class ChaCha20Drbg {
+public:
+    static constexpr size_t KEY_BYTES = 32;
+    static constexpr size_t BLOCK_BYTES = 64;
+    static constexpr size_t BUFFER_BLOCKS = 16;
+    static constexpr size_t BUFFER_BYTES = BLOCK_BYTES * BUFFER_BLOCKS;
+    // Output served between entropy reseeds
+    static constexpr uint64_t RESEED_INTERVAL = uint64_t(1) << 20;
+
+    ChaCha20Drbg() = default;
+    ~ChaCha20Drbg();
+
+    ChaCha20Drbg(const ChaCha20Drbg&) = delete;
+    ChaCha20Drbg& operator=(const ChaCha20Drbg&) = delete;
+
+    // Install a key and drop any buffered output; generate() never reseeds after an
+    // explicit seed, which keeps known-answer runs reproducible
+    void seed(const uint8_t key[KEY_BYTES]);
+
+    // XOR fresh hardware or OS entropy into the key and drop any buffered output
+    void reseed();
+
+    void generate(uint8_t* out, size_t len);
+
+    bool seeded() const { return seeded_; }
+
+    // ChaCha20 block function (RFC 8439) with a zero nonce, for testing
+    static void block(const uint32_t key[8], uint32_t counter, uint8_t out[BLOCK_BYTES]);
+
+private:
+    uint32_t key_[KEY_BYTES / 4] = {};
+    uint8_t buffer_[BUFFER_BYTES] = {};
+    size_t available_ = 0;          // unread bytes at the end of buffer_
+    uint64_t since_reseed_ = 0;
+#ifndef ESP_PLATFORM
+    uint64_t fork_generation_ = 0;
+#endif
+    bool seeded_ = false;
+    bool auto_reseed_ = true;
+
+    void refill();
+};
+
+// Fill buffer from the shared DRBG. On ESP-IDF one instance serves every task behind a
+// mutex (the single FreeRTOS TLS slot belongs to pthreads); host builds keep one per
+// thread and reseed after fork()
+void drbg_random_bytes(uint8_t* buffer, size_t len);
+
+} // namespace clwe
+
+#endif // CSPRNG_HPP
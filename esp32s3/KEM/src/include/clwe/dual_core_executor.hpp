@@ -0,0 +1,104 @@
+#ifndef DUAL_CORE_EXECUTOR_HPP
+#define DUAL_CORE_EXECUTOR_HPP
+
+/**
+ * @file dual_core_executor.hpp
+ * @brief Two-core row pipeline for ColorKEM on the ESP32-S3
+ *
+ * ColorKEM::set_executor() hands the matrix A expansion (SHAKE-128, one row of
+ * k polynomials at a time) to a FreeRTOS task pinned to the second LX7 core.
+ * Meanwhile the calling task samples the noise vectors and multiplies each row
+ * of A into the result as soon as the worker finishes it.
+ *
+ * Builds without a second core (CONFIG_FREERTOS_UNICORE, host builds) or where
+ * the worker task cannot be created run the same pipeline on the caller, so
+ * results are identical either way.
+ */
+
+#include <cstdint>
+#include <functional>
+
+#ifdef ESP_PLATFORM
+#include <sdkconfig.h>
+#endif
+
+#if defined(ESP_PLATFORM) && !defined(CONFIG_FREERTOS_UNICORE)
+#define CLWE_HAVE_DUAL_CORE 1
+#include <atomic>
+#include <exception>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#endif
+
+namespace clwe {
+
+class DualCoreExecutor {
+public:
+    // app_main runs on core 0, so the worker takes core 1 by default
+    static constexpr int DEFAULT_WORKER_CORE = 1;
+    static constexpr uint32_t DEFAULT_STACK_BYTES = 4096;
+    static constexpr uint32_t DEFAULT_PRIORITY = 5;
+    static constexpr uint32_t MAX_PIPELINE_ROWS = 16;
+
+    /**
+     * @brief Start the worker task
+     *
+     * Run the KEM from a task on the other core (app_main by default) to get
+     * the overlap. If the task cannot be created, the executor falls back to
+     * running on the caller; dual_core() reports which mode is in use.
+     *
+     * @param worker_core Core the worker task is pinned to
+     * @param stack_bytes Worker task stack size
+     * @param priority Worker task priority
+     */
+    explicit DualCoreExecutor(int worker_core = DEFAULT_WORKER_CORE,
+                              uint32_t stack_bytes = DEFAULT_STACK_BYTES,
+                              uint32_t priority = DEFAULT_PRIORITY);
+    ~DualCoreExecutor();
+
+    DualCoreExecutor(const DualCoreExecutor&) = delete;
+    DualCoreExecutor& operator=(const DualCoreExecutor&) = delete;
+
+    /**
+     * @brief Whether a worker task on a second core is running
+     */
+    bool dual_core() const;
+
+    /**
+     * @brief Run produce(0..rows-1) on the worker while the caller runs overlap()
+     *        and then consume(i) as soon as row i has been produced
+     *
+     * Calls from several tasks are serialized. An exception from any callback is
+     * rethrown on the caller after the worker has stopped.
+     *
+     * @throws std::invalid_argument If rows exceeds MAX_PIPELINE_ROWS
+     */
+    void run_pipeline(uint32_t rows,
+                      const std::function<void(uint32_t)>& produce,
+                      const std::function<void()>& overlap,
+                      const std::function<void(uint32_t)>& consume);
+
+private:
+#ifdef CLWE_HAVE_DUAL_CORE
+    static void worker_entry(void* arg);
+    void worker_loop();
+
+    TaskHandle_t worker_;
+    SemaphoreHandle_t start_;   // a job or the stop request is ready
+    SemaphoreHandle_t rows_;    // one count per produced row
+    SemaphoreHandle_t done_;    // the worker finished the job
+    SemaphoreHandle_t lock_;    // one pipeline at a time
+
+    const std::function<void(uint32_t)>* produce_;
+    uint32_t job_rows_;
+    std::exception_ptr worker_error_;
+    std::atomic<bool> failed_;
+    std::atomic<bool> cancel_;
+    bool stop_;
+#endif
+};
+
+} // namespace clwe
+
+#endif // DUAL_CORE_EXECUTOR_HPP
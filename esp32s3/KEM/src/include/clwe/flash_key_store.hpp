@@ -0,0 +1,142 @@
+#ifndef FLASH_KEY_STORE_HPP
+#define FLASH_KEY_STORE_HPP
+
+/**
+ * @file flash_key_store.hpp
+ * @brief Long-term ColorKEM keys read in place from a flash partition
+ *
+ * A device's long-term key pair otherwise lives in RAM: the public key's
+ * k * n * 4 bytes and the private key's, plus the k NTT-domain polynomials
+ * decapsulate() derives from it on every call (12 KiB of internal SRAM in
+ * total at level 1024). A FlashKeyStore keeps prepared keys in a data
+ * partition instead and maps it with esp_partition_mmap(), so encapsulate()
+ * and decapsulate() on the views it hands out read the coefficients through
+ * the flash cache and only the per-call scratch is in RAM.
+ *
+ * Each record starts on a 4 KiB sector and holds one key pair:
+ *
+ *   offset 0   FlashKeyRecordHeader (64 bytes)
+ *   offset 64  matrix seed (32 bytes)
+ *   offset 96  public data (k * n * 4 bytes, as ColorPublicKey::public_data)
+ *   then       prepared secret (k * n ColorValue, NTT domain)
+ *
+ * Records whose magic, parameters, size or check value do not match are
+ * skipped when the store is opened, so a torn provision() or a partially
+ * erased partition loses those records only.
+ *
+ * The partition holds the private key in the clear unless flash encryption
+ * is enabled; mark it `encrypted` in the partition table (see
+ * partitions.kemkeys.csv) so both provision() and the mapping go through the
+ * flash encryption engine.
+ */
+
+#include "clwe.hpp"
+#include "color_kem.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace clwe {
+
+/** @brief Header of one FlashKeyStore record, in the target's byte order */
+struct FlashKeyRecordHeader {
+    uint8_t magic[4];         ///< "CLWK"
+    uint16_t version;         ///< FlashKeyStore::RECORD_VERSION
+    uint16_t reserved0;
+    uint32_t security_level;
+    uint32_t degree;
+    uint32_t module_rank;
+    uint32_t modulus;
+    uint32_t eta1;
+    uint32_t eta2;
+    uint32_t record_bytes;    ///< Sector-rounded size of the whole record
+    uint8_t check[16];        ///< SHAKE-256 of the header up to here and the payload
+    uint8_t reserved1[12];
+};
+
+static_assert(sizeof(FlashKeyRecordHeader) == 64, "FlashKeyRecordHeader layout must not change");
+
+class FlashKeyStore {
+public:
+    static constexpr size_t SECTOR_BYTES = 4096;
+    static constexpr uint16_t RECORD_VERSION = 1;
+
+    /**
+     * @brief Bytes one record of params takes, a whole number of sectors
+     */
+    static size_t record_bytes(const CLWEParameters& params);
+
+    /**
+     * @brief Build the record for a key pair, padded with 0xFF to record_bytes()
+     *
+     * The secret is transformed to the NTT domain here, once, instead of on
+     * every decapsulation.
+     *
+     * @throws std::invalid_argument If the keys' parameters or sizes disagree
+     */
+    static std::vector<uint8_t> encode_record(const ColorPublicKey& public_key, const ColorPrivateKey& private_key);
+
+    /**
+     * @brief Open records in memory that is already readable, e.g. a region
+     * mapped by the application or a copy of the partition image
+     *
+     * The memory must outlive the store and every view taken from it.
+     */
+    FlashKeyStore(const uint8_t* region, size_t region_bytes);
+
+#ifdef ESP_PLATFORM
+    /**
+     * @brief Map the data partition with this label and open its records
+     *
+     * @throws std::runtime_error If the partition is missing or cannot be mapped
+     */
+    explicit FlashKeyStore(const char* partition_label);
+
+    /**
+     * @brief Erase the partition and write one record per key pair
+     *
+     * @throws std::runtime_error If the partition is missing, too small, or a flash operation fails
+     */
+    static void provision(const char* partition_label,
+                          const std::vector<std::pair<ColorPublicKey, ColorPrivateKey>>& keys);
+#endif
+
+    ~FlashKeyStore();
+
+    FlashKeyStore(const FlashKeyStore&) = delete;
+    FlashKeyStore& operator=(const FlashKeyStore&) = delete;
+
+    /** @brief Number of valid records */
+    size_t size() const { return records_.size(); }
+
+    /** @brief Parameters of record index */
+    const CLWEParameters& params(size_t index) const;
+
+    /** @throws std::out_of_range If index >= size() */
+    ColorPublicKeyView public_key(size_t index) const;
+
+    /** @throws std::out_of_range If index >= size() */
+    ColorPrivateKeyView private_key(size_t index) const;
+
+private:
+    struct Record {
+        const uint8_t* base;
+        CLWEParameters params;
+    };
+
+    void scan();
+    const Record& record(size_t index) const;
+
+    const uint8_t* region_;
+    size_t region_bytes_;
+    std::vector<Record> records_;
+#ifdef ESP_PLATFORM
+    uint32_t mmap_handle_ = 0;  // esp_partition_mmap_handle_t
+    bool mapped_ = false;
+#endif
+};
+
+} // namespace clwe
+
+#endif // FLASH_KEY_STORE_HPP
@@ -0,0 +1,17 @@
+#ifndef CLWE_HOT_PATH_H
+#define CLWE_HOT_PATH_H
+
+/*
+ * CLWE_HOT marks the NTT, Keccak and squeeze kernels. It places them in internal
+ * instruction RAM, like IRAM_ATTR. A build with CLWE_HOT_IN_FLASH leaves them in
+ * flash, run through the instruction cache, to measure what IRAM placement buys.
+ */
+
+#if defined(ESP_PLATFORM) && !defined(CLWE_HOT_IN_FLASH)
+#include <esp_attr.h>
+#define CLWE_HOT IRAM_ATTR
+#else
+#define CLWE_HOT
+#endif
+
+#endif /* CLWE_HOT_PATH_H */
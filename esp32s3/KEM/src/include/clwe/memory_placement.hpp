@@ -0,0 +1,142 @@
+#ifndef MEMORY_PLACEMENT_HPP
+#define MEMORY_PLACEMENT_HPP
+
+/**
+ * @file memory_placement.hpp
+ * @brief Internal SRAM / PSRAM placement policy for ColorKEM buffers
+ *
+ * By default every ColorKEM buffer comes from the default heap. On boards with
+ * PSRAM that heap spans both internal SRAM and external RAM, so the large, cold
+ * matrix A can push small, hot tables out to PSRAM, or crowd the application's
+ * own data out of internal SRAM.
+ *
+ * A PlacementPolicy assigns a region to each class of data:
+ * - tables:  NTT twiddles and bit-reversal tables, read by every butterfly
+ * - scratch: the NTT operands and product polynomial of a multiplication
+ * - matrix:  the expanded matrix A of keygen and encapsulation: one polynomial
+ *            at a time single-core, all k*k (16 KiB at level 1024) with a
+ *            DualCoreExecutor
+ *
+ * Tables are read when an engine is constructed, so set the policy before
+ * constructing ColorKEM. Scratch and matrix placement is read at each keygen and
+ * encapsulation.
+ *
+ * A region is a preference: if PSRAM is not enabled or the region is exhausted,
+ * the allocation falls back to any 8-bit capable RAM. The Keccak state and the
+ * current squeeze block live on the task stack, which is internal SRAM. Serialized
+ * keys and ciphertexts are std::vector<uint8_t> members of the public key types,
+ * so they follow the application's malloc policy (CONFIG_SPIRAM_USE_MALLOC and
+ * heap_caps_malloc_extmem_enable()).
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+namespace clwe {
+
+enum class MemoryRegion : uint8_t {
+    Default,   ///< The default heap (malloc)
+    Internal,  ///< Internal SRAM (MALLOC_CAP_INTERNAL)
+    External   ///< PSRAM (MALLOC_CAP_SPIRAM)
+};
+
+struct PlacementPolicy {
+    MemoryRegion tables = MemoryRegion::Internal;
+    MemoryRegion scratch = MemoryRegion::Internal;
+    MemoryRegion matrix = MemoryRegion::Default;
+
+    /**
+     * @brief Hot data in internal SRAM, matrix A in PSRAM
+     */
+    static PlacementPolicy psram_matrix() {
+        PlacementPolicy policy;
+        policy.matrix = MemoryRegion::External;
+        return policy;
+    }
+};
+
+/**
+ * @brief Replace the active policy
+ *
+ * Not synchronized: set it during start-up, before KEM objects are constructed
+ * and before KEM tasks start.
+ */
+void set_placement_policy(const PlacementPolicy& policy);
+
+/**
+ * @brief The active policy
+ */
+const PlacementPolicy& placement_policy();
+
+/**
+ * @brief Allocate bytes from a region, falling back to any 8-bit capable RAM
+ *
+ * @throws std::bad_alloc If no RAM is left
+ */
+void* placement_malloc(size_t bytes, MemoryRegion region);
+
+/**
+ * @brief Free memory returned by placement_malloc
+ */
+void placement_free(void* ptr) noexcept;
+
+/**
+ * @brief Whether ptr points into PSRAM (always false off-target)
+ */
+bool is_external_ram(const void* ptr);
+
+/**
+ * @brief Standard allocator drawing from one MemoryRegion
+ *
+ * Every region is released through the same free path, so all instances compare
+ * equal and containers may exchange storage freely.
+ */
+template <typename T>
+class PlacementAllocator {
+public:
+    using value_type = T;
+
+    PlacementAllocator() noexcept : region_(MemoryRegion::Default) {}
+    explicit PlacementAllocator(MemoryRegion region) noexcept : region_(region) {}
+    template <typename U>
+    PlacementAllocator(const PlacementAllocator<U>& other) noexcept : region_(other.region()) {}
+
+    T* allocate(size_t count) {
+        if (count > static_cast<size_t>(-1) / sizeof(T)) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(placement_malloc(count * sizeof(T), region_));
+    }
+
+    void deallocate(T* ptr, size_t) noexcept {
+        placement_free(ptr);
+    }
+
+    MemoryRegion region() const noexcept { return region_; }
+
+private:
+    MemoryRegion region_;
+};
+
+template <typename T, typename U>
+bool operator==(const PlacementAllocator<T>&, const PlacementAllocator<U>&) noexcept { return true; }
+
+template <typename T, typename U>
+bool operator!=(const PlacementAllocator<T>&, const PlacementAllocator<U>&) noexcept { return false; }
+
+template <typename T>
+using PlacedVector = std::vector<T, PlacementAllocator<T>>;
+
+/**
+ * @brief Allocator for precomputed tables under the active policy
+ */
+template <typename T>
+PlacementAllocator<T> table_allocator() {
+    return PlacementAllocator<T>(placement_policy().tables);
+}
+
+} // namespace clwe
+
+#endif // MEMORY_PLACEMENT_HPP
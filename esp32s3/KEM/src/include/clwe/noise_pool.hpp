@@ -0,0 +1,113 @@
+#ifndef NOISE_POOL_HPP
+#define NOISE_POOL_HPP
+
+/**
+ * @file noise_pool.hpp
+ * @brief Encapsulation randomness precomputed while the device is idle
+ *
+ * Apart from the public key, encapsulation needs a message bit and the noise
+ * vectors r, e1 and e2. None of these depend on the recipient, so an idle sensor
+ * can sample them ahead of time with ColorKEM::precompute_noise() and cut the
+ * SHAKE-256 and binomial sampling out of its wake-to-handshake latency.
+ *
+ * A NoisePool keeps these bundles in a region the application owns. Placed in
+ * RTC memory, the bundles survive deep sleep:
+ *
+ * @code
+ * RTC_DATA_ATTR static uint8_t pool_region[4 * 1024 + 16];
+ *
+ * clwe::NoisePool pool(pool_region, sizeof(pool_region), params);
+ * kem.set_noise_pool(&pool);
+ * kem.precompute_noise();          // before entering deep sleep
+ * ...
+ * auto [ct, ss] = kem.encapsulate(pk);  // after waking: uses a stored bundle
+ * @endcode
+ *
+ * A bundle stores its coefficients as signed bytes, so one takes
+ * bundle_bytes(params) = 2 * k * n + 4 bytes: 1028 at level 512, 2052 at 1024.
+ *
+ * Each bundle is used at most once: encapsulation marks it empty before reading
+ * it and wipes it afterwards, so a reset in between loses the bundle rather than
+ * reusing it. With no bundle left, encapsulation samples fresh randomness.
+ *
+ * @warning Not synchronized: let one KEM task use a pool at a time.
+ */
+
+#include "clwe/clwe.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace clwe {
+
+class ColorKEM;
+
+class NoisePool {
+public:
+    // Region header: magic, security level, bundle size and bundle count
+    static constexpr size_t HEADER_BYTES = 16;
+
+    /**
+     * @brief Bytes one precomputed bundle occupies at these parameters
+     */
+    static size_t bundle_bytes(const CLWEParameters& params);
+
+    /**
+     * @brief Region size holding the header and the given number of bundles
+     */
+    static size_t region_bytes(const CLWEParameters& params, size_t bundles);
+
+    /**
+     * @brief Manage the bundles in a caller-owned region
+     *
+     * A region that already holds a pool for the same parameters and size (RTC
+     * memory after a deep-sleep wake) keeps its bundles. Anything else is wiped
+     * and starts empty.
+     *
+     * @param region Memory that outlives the pool; any alignment
+     * @param bytes Region size
+     * @param params Parameters of the KEM that will use the pool
+     *
+     * @throws std::invalid_argument If region is null or too small for one bundle
+     */
+    NoisePool(void* region, size_t bytes, const CLWEParameters& params);
+
+    NoisePool(const NoisePool&) = delete;
+    NoisePool& operator=(const NoisePool&) = delete;
+
+    uint32_t security_level() const { return security_level_; }
+
+    // Number of bundles the region holds
+    size_t capacity() const { return capacity_; }
+
+    // Number of bundles ready for use
+    size_t available() const;
+
+    /**
+     * @brief Wipe every bundle
+     */
+    void clear();
+
+private:
+    friend class ColorKEM;
+
+    static constexpr uint8_t SLOT_EMPTY = 0x00;
+    static constexpr uint8_t SLOT_READY = 0x5A;
+
+    // Slot layout: state, message bit, e2 constant term, r (k*n), e1 (k*n), padding
+    static constexpr size_t SLOT_MESSAGE = 1;
+    static constexpr size_t SLOT_E2 = 2;
+    static constexpr size_t SLOT_R = 3;
+
+    uint8_t* slot(size_t index) const { return region_ + HEADER_BYTES + index * bundle_bytes_; }
+    // First slot in the given state, or null
+    uint8_t* find_slot(uint8_t state) const;
+
+    uint8_t* region_;
+    size_t capacity_;
+    size_t bundle_bytes_;
+    uint32_t security_level_;
+};
+
+} // namespace clwe
+
+#endif // NOISE_POOL_HPP
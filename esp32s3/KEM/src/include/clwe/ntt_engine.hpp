@@ -2,6 +2,7 @@
 #define NTT_ENGINE_HPP
 
 #include "cpu_features.hpp"
+#include "memory_placement.hpp"
 #include <cstdint>
 #include <vector>
 #include <memory>
@@ -44,7 +45,7 @@ protected:
     uint32_t q_;           // Modulus
     uint32_t n_;           // Degree (power of 2)
     uint32_t log_n_;       // log2(n_)
-    std::vector<uint32_t> bitrev_;  // Bit reversal table
+    PlacedVector<uint32_t> bitrev_;  // Bit reversal table, placed by PlacementPolicy::tables
 
     // Precompute bit reversal table
     void precompute_bitrev();
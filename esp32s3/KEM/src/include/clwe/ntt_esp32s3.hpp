@@ -0,0 +1,74 @@
+#ifndef NTT_ESP32S3_HPP
+#define NTT_ESP32S3_HPP
+
+#include "ntt_engine.hpp"
+#include <cstdint>
+#include <vector>
+
+#include "hot_path.h"
+
+#ifdef ESP_PLATFORM
+#include <sdkconfig.h>
+#endif
+
+// The PIE kernels in ntt_esp32s3_pie.S only exist on the ESP32-S3; elsewhere the engine
+// runs portable kernels with the same lane arithmetic
+#if defined(ESP_PLATFORM) && defined(CONFIG_IDF_TARGET_ESP32S3)
+#define CLWE_HAVE_PIE 1
+#endif
+
+namespace clwe {
+
+// ESP32-S3 PIE NTT engine: 8 int16_t lanes per 128-bit q register, bit-exact with
+// ScalarNTTEngine for coefficients below q.
+// Twiddle products use precomputed quotients floor(z * 2^15 / q) (Shoup) from EE.VMUL.S16,
+// with the exact remainder a * z - t * q formed in the 40-bit QACC lanes. Pointwise products
+// derive the quotient of b on the fly. Stages with fewer than 8 butterflies stay scalar.
+// The lane path needs 2^11 < q < 2^13 and 16 <= n <= MAX_VECTOR_DEGREE; other parameters
+// use the scalar butterflies.
+class ESP32S3NTTEngine : public NTTEngine {
+public:
+    static constexpr uint32_t LANES = 8;
+    // Bounds the int16_t work buffers kept on the task stack
+    static constexpr uint32_t MAX_VECTOR_DEGREE = 256;
+
+    ESP32S3NTTEngine(uint32_t q, uint32_t n);
+    ~ESP32S3NTTEngine() override = default;
+
+    void CLWE_HOT ntt_forward(uint32_t* poly) const override;
+    void CLWE_HOT ntt_inverse(uint32_t* poly) const override;
+    void CLWE_HOT multiply(const uint32_t* a, const uint32_t* b, uint32_t* result) const override;
+
+    SIMDSupport get_simd_support() const override { return SIMDSupport::PIE; }
+
+private:
+    PlacedVector<uint32_t> zetas_;
+    PlacedVector<uint32_t> zetas_inv_;
+    uint32_t n_inv_;
+
+    // 16-byte aligned int16_t tables inside storage_: for each stage with k >= LANES the
+    // k twiddles zetas_[i * m] and their quotients, forward then inverse, followed by the
+    // n^-1 scaling vector, its quotient and the kernel constants (q, -q, floor(2^26 / q))
+    PlacedVector<int16_t> storage_;
+    const int16_t* tables_;
+    std::vector<uint32_t> fwd_offsets_;
+    std::vector<uint32_t> inv_offsets_;
+    uint32_t scale_offset_;
+    uint32_t consts_offset_;
+    bool vector_path_;
+
+    void precompute_zetas();
+    void precompute_tables();
+
+    void CLWE_HOT butterfly(uint32_t& a, uint32_t& b, uint32_t zeta) const;
+    void CLWE_HOT butterfly16(int16_t& a, int16_t& b, uint32_t zeta) const;
+
+    // Lane-path transforms on int16_t buffers, without the final bit reversal
+    void CLWE_HOT forward16(int16_t* poly) const;
+    void CLWE_HOT inverse16(int16_t* poly) const;
+    void bit_reverse16(int16_t* poly) const;
+};
+
+} // namespace clwe
+
+#endif // NTT_ESP32S3_HPP
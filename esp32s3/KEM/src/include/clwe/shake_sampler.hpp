@@ -6,9 +6,7 @@
 #include <array>
 #include "tiny_sha3.h"
 
-#ifdef ESP_PLATFORM
-#include <esp_attr.h>
-#endif
+#include "hot_path.h"
 
 namespace clwe {
 
@@ -28,9 +26,17 @@ public:
     void init(const uint8_t* seed, size_t seed_len);
 
     // Squeeze bytes from SHAKE-128
-    void IRAM_ATTR squeeze(uint8_t* out, size_t len);
+    void CLWE_HOT squeeze(uint8_t* out, size_t len);
+
+    // Squeeze whole rate blocks (BLOCK_BYTES each), continuing the squeeze() stream
+    void CLWE_HOT squeeze_blocks(uint8_t* out, size_t nblocks);
+
+    static constexpr size_t BLOCK_BYTES = SHAKE128_RATE;
 };
 
+// Matrix expansion parses whole 3-byte groups out of each block
+static_assert(SHAKE128Sampler::BLOCK_BYTES % 3 == 0, "SHAKE-128 rate must hold whole 3-byte groups");
+
 // SHAKE-256 based sampler for Kyber/ML-KEM
 class SHAKE256Sampler {
 private:
@@ -47,7 +53,12 @@ public:
     void init(const uint8_t* seed, size_t seed_len);
 
     // Squeeze bytes from SHAKE-256
-    void IRAM_ATTR squeeze(uint8_t* out, size_t len);
+    void CLWE_HOT squeeze(uint8_t* out, size_t len);
+
+    // Squeeze whole rate blocks (BLOCK_BYTES each), continuing the squeeze() stream
+    void CLWE_HOT squeeze_blocks(uint8_t* out, size_t nblocks);
+
+    static constexpr size_t BLOCK_BYTES = SHAKE256_RATE;
 
     // Sample a single coefficient from centered binomial distribution
     int32_t sample_binomial_coefficient(uint32_t eta);
@@ -70,7 +81,7 @@ public:
     void sample_polynomial_uniform(uint32_t* coeffs, size_t degree, uint32_t modulus);
 
     // Generate random bytes
-    void IRAM_ATTR random_bytes(uint8_t* out, size_t len);
+    void CLWE_HOT random_bytes(uint8_t* out, size_t len);
 };
 
 } // namespace clwe
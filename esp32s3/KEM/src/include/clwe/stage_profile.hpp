@@ -0,0 +1,149 @@
+#ifndef STAGE_PROFILE_HPP
+#define STAGE_PROFILE_HPP
+
+/**
+ * @file stage_profile.hpp
+ * @brief Per-stage cycle accounting for keygen, encapsulation and decapsulation
+ *
+ * Built with CLWE_STAGE_PROFILE, the KEM adds the CPU cycles it spends in each
+ * stage to a counter of the core it runs on. Without it StageTimer is empty and
+ * every timer compiles away, so release builds pay nothing.
+ *
+ * Stages are leaves of the call tree and never nest, so their sum is the
+ * accounted part of an operation; whatever remains (key validation, vector
+ * bookkeeping, allocation) is the operation's total minus that sum.
+ *
+ * Built with CLWE_SYSVIEW_TRACE (and CONFIG_APPTRACE_SV_ENABLE in sdkconfig),
+ * every stage and every keygen, encapsulation and decapsulation also marks a
+ * SEGGER SystemView user event, so the KEM shows up on the app_trace timeline
+ * next to FreeRTOS task switches and interrupts. Stages use their KemStage
+ * value as the event id and operations SYSVIEW_OPERATION_ID_BASE plus their
+ * KemOperation value. Both switches are independent.
+ *
+ * @warning The counters are plain per-core sums: profile one KEM task per core
+ * at a time, and read them after the operations have returned.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+namespace clwe {
+
+enum class KemStage : uint8_t {
+    MatrixExpansion,  ///< SHAKE-128 expansion and rejection sampling of matrix A
+    NoiseSampling,    ///< SHAKE-256 and the centered binomial distribution
+    NTT,              ///< Forward and inverse NTTs
+    Basemul,          ///< Pointwise products in the NTT domain
+    Packing           ///< Coefficients to and from key and ciphertext bytes
+};
+
+constexpr size_t KEM_STAGE_COUNT = 5;
+
+enum class KemOperation : uint8_t {
+    Keygen,       ///< ColorKEM::keygen() and its deterministic and static forms
+    Encapsulate,  ///< ColorKEM::encapsulate() and its deterministic and static forms
+    Decapsulate   ///< ColorKEM::decapsulate() and decapsulate_static()
+};
+
+/**
+ * @brief SystemView user event id of KemOperation::Keygen; stages take ids 0 to 4
+ */
+constexpr unsigned SYSVIEW_OPERATION_ID_BASE = 8;
+
+/**
+ * @brief Short, CSV-friendly stage name ("matrix_a", "cbd", "ntt", "basemul", "packing")
+ */
+const char* kem_stage_name(KemStage stage);
+
+/**
+ * @brief Cycles and timer activations per stage, summed over both cores
+ */
+struct StageCycles {
+    uint64_t cycles[KEM_STAGE_COUNT];
+    uint32_t calls[KEM_STAGE_COUNT];
+
+    uint64_t total() const {
+        uint64_t sum = 0;
+        for (size_t s = 0; s < KEM_STAGE_COUNT; ++s) {
+            sum += cycles[s];
+        }
+        return sum;
+    }
+};
+
+/**
+ * @brief Whether this build counts stages (CLWE_STAGE_PROFILE)
+ */
+constexpr bool stage_profile_enabled() {
+#ifdef CLWE_STAGE_PROFILE
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Whether this build marks SystemView events (CLWE_SYSVIEW_TRACE)
+ */
+constexpr bool systemview_trace_enabled() {
+#ifdef CLWE_SYSVIEW_TRACE
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Zero every counter
+ */
+void stage_profile_reset();
+
+/**
+ * @brief Counters accumulated since the last reset (all zero without CLWE_STAGE_PROFILE)
+ */
+StageCycles stage_profile_snapshot();
+
+/**
+ * @brief Scoped timer adding its lifetime to one stage
+ */
+class StageTimer {
+public:
+#if defined(CLWE_STAGE_PROFILE) || defined(CLWE_SYSVIEW_TRACE)
+    explicit StageTimer(KemStage stage);
+    ~StageTimer();
+
+private:
+    KemStage stage_;
+    uint32_t start_;
+#else
+    explicit StageTimer(KemStage) {}
+#endif
+
+public:
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+};
+
+/**
+ * @brief Scoped SystemView span of one whole KEM operation; empty without CLWE_SYSVIEW_TRACE
+ */
+class OperationTrace {
+public:
+#ifdef CLWE_SYSVIEW_TRACE
+    explicit OperationTrace(KemOperation operation);
+    ~OperationTrace();
+
+private:
+    KemOperation operation_;
+#else
+    explicit OperationTrace(KemOperation) {}
+#endif
+
+public:
+    OperationTrace(const OperationTrace&) = delete;
+    OperationTrace& operator=(const OperationTrace&) = delete;
+};
+
+} // namespace clwe
+
+#endif // STAGE_PROFILE_HPP
@@ -0,0 +1,108 @@
+#ifndef STATIC_WORKSPACE_HPP
+#define STATIC_WORKSPACE_HPP
+
+/**
+ * @file static_workspace.hpp
+ * @brief Compile-time sized KEM workspace for the CLWE_STATIC_WORKSPACE profile
+ *
+ * With CLWE_STATIC_WORKSPACE defined, the ColorKEM::*_static entry points run a
+ * whole KEM operation out of one StaticWorkspace and caller-provided byte buffers,
+ * without touching the heap. Every buffer is sized for CLWE_STATIC_LEVEL (512, 768
+ * or 1024, default 512) at compile time.
+ *
+ * The workspace lives in internal DRAM .bss by default. It can be moved to a region
+ * the application owns (static_workspace_attach) or, on boards with PSRAM, to
+ * external RAM allocated once at start-up (static_workspace_attach_psram).
+ *
+ * Stack use of any *_static call stays below STATIC_STACK_BYTES on top of the
+ * caller's frame: the deepest call chain holds two SHAKE states (212 bytes each),
+ * two seeds, one squeeze block and the Keccak permutation, and no frame holds a
+ * polynomial.
+ *
+ * @warning There is one active workspace, so *_static calls must not run
+ * concurrently (one KEM task, or a mutex around the calls).
+ */
+
+#include "clwe/color_value.hpp"
+#include <cstddef>
+#include <cstdint>
+
+#ifndef CLWE_STATIC_LEVEL
+#define CLWE_STATIC_LEVEL 512
+#endif
+
+#if CLWE_STATIC_LEVEL != 512 && CLWE_STATIC_LEVEL != 768 && CLWE_STATIC_LEVEL != 1024
+#error "CLWE_STATIC_LEVEL must be 512, 768 or 1024"
+#endif
+
+namespace clwe {
+
+constexpr uint32_t STATIC_SECURITY_LEVEL = CLWE_STATIC_LEVEL;
+constexpr uint32_t STATIC_DEGREE = 256;
+constexpr uint32_t STATIC_RANK = CLWE_STATIC_LEVEL / 256;
+
+constexpr size_t STATIC_PUBLIC_DATA_BYTES = STATIC_RANK * STATIC_DEGREE * 4;
+constexpr size_t STATIC_SECRET_DATA_BYTES = STATIC_RANK * STATIC_DEGREE * 4;
+constexpr size_t STATIC_CIPHERTEXT_DATA_BYTES = (STATIC_RANK + 1) * STATIC_DEGREE * 4;
+constexpr size_t STATIC_HINT_BYTES = 4;
+
+// Documented stack budget for a *_static call, see the file comment
+constexpr size_t STATIC_STACK_BYTES = 2048;
+
+/**
+ * @brief Every buffer a keygen, encapsulation or decapsulation needs
+ *
+ * Buffer roles per operation:
+ * - keygen:        matrix_entry = A[i][j], secret = s, error = e, result = t = As + e
+ * - encapsulation: matrix_entry = A[j][i], secret = r, error = e1, public_key = t, result = u
+ *
+ * A is expanded one entry at a time, just before the entry is multiplied, so only
+ * one of its k*k polynomials is ever held.
+ * - decapsulation: secret = s, result = c1
+ */
+struct StaticWorkspace {
+    ColorValue matrix_entry[STATIC_DEGREE];
+    ColorValue secret[STATIC_RANK * STATIC_DEGREE];
+    ColorValue error[STATIC_RANK * STATIC_DEGREE];
+    ColorValue public_key[STATIC_RANK * STATIC_DEGREE];
+    ColorValue result[STATIC_RANK * STATIC_DEGREE];
+    ColorValue sum[STATIC_DEGREE];
+    ColorValue product[STATIC_DEGREE];
+    ColorValue ntt_scratch[2 * STATIC_DEGREE];  // ColorNTTEngine::multiply_colors operands
+};
+
+constexpr size_t STATIC_WORKSPACE_BYTES = sizeof(StaticWorkspace);
+
+/**
+ * @brief Use a caller-owned region as the workspace
+ *
+ * The region must stay valid for as long as *_static calls are made and must be
+ * at least STATIC_WORKSPACE_BYTES long and aligned to alignof(StaticWorkspace).
+ *
+ * @throws std::invalid_argument If the region is null, too small or misaligned
+ */
+void static_workspace_attach(void* region, size_t size);
+
+/**
+ * @brief Move the workspace to PSRAM with a single heap_caps allocation
+ *
+ * Call once during start-up, before the heap fragments. The allocation is never
+ * freed; later KEM operations do not allocate.
+ *
+ * @throws std::runtime_error If PSRAM is not enabled or the allocation fails
+ */
+void static_workspace_attach_psram();
+
+/**
+ * @brief Return to the built-in internal DRAM workspace
+ */
+void static_workspace_detach();
+
+/**
+ * @brief The workspace the *_static entry points use
+ */
+StaticWorkspace& static_workspace();
+
+} // namespace clwe
+
+#endif // STATIC_WORKSPACE_HPP
@@ -46,6 +46,11 @@ void *sha3(const void *in, size_t inlen, void *md, int mdlen);
 
 void shake_xof(sha3_ctx_t *c);
 void shake_out(sha3_ctx_t *c, void *out, size_t len);
+void shake_out_blocks(sha3_ctx_t *c, void *out, size_t nblocks);   // nblocks * rsiz bytes
+
+// SHAKE rates in bytes, the block size of shake_out_blocks
+#define SHAKE128_RATE 168
+#define SHAKE256_RATE 136
 
 #ifdef __cplusplus
 }
@@ -86,9 +86,16 @@ uint32_t mod_inverse(uint32_t a, uint32_t m);
 // Modular exponentiation
 uint32_t mod_pow(uint32_t base, uint32_t exp, uint32_t mod);
 
-// Secure random bytes
+// Secure random bytes from the ChaCha20 DRBG (csprng.hpp), or straight from the
+// hardware RNG when built with CLWE_DIRECT_OS_RANDOM
 void secure_random_bytes(uint8_t* buffer, size_t len);
 
+// One read of hardware or OS entropy (esp_fill_random, getrandom, ...)
+void os_random_bytes(uint8_t* buffer, size_t len);
+
+// Zero len bytes in a way the compiler cannot elide, for wiping secrets
+void secure_zero(void* ptr, size_t len);
+
 } // namespace clwe
 
 #endif // UTILS_HPP
\ No newline at end of file
@@ -1,6 +1,11 @@
 #include <gtest/gtest.h>
 #include "color_kem.hpp"
 #include "clwe.hpp"
+#include "dual_core_executor.hpp"
+#include "flash_key_store.hpp"
+#include "memory_placement.hpp"
+#include "noise_pool.hpp"
+#include "stage_profile.hpp"
 #include <vector>
 #include <array>
 
@@ -261,4 +266,237 @@ TEST_F(ColorKEMTest, DifferentKeysDifferentCiphertexts) {
     EXPECT_EQ(ciphertext1.shared_secret_hint, ciphertext2.shared_secret_hint);
 }
 
+// The row pipeline gives the same keys and ciphertexts as the single-task path
+TEST_F(ColorKEMTest, ExecutorMatchesSingleCore) {
+    std::array<uint8_t, 32> matrix_seed, secret_seed, error_seed;
+    for (size_t i = 0; i < 32; ++i) {
+        matrix_seed[i] = static_cast<uint8_t>(i);
+        secret_seed[i] = static_cast<uint8_t>(2 * i + 1);
+        error_seed[i] = static_cast<uint8_t>(5 * i);
+    }
+
+    for (uint32_t level : {512u, 768u, 1024u}) {
+        CLWEParameters level_params(level);
+        ColorKEM single(level_params);
+        ColorKEM piped(level_params);
+        DualCoreExecutor executor;
+        piped.set_executor(&executor);
+
+        auto expected = single.keygen_deterministic(matrix_seed, secret_seed, error_seed);
+        auto actual = piped.keygen_deterministic(matrix_seed, secret_seed, error_seed);
+        EXPECT_EQ(expected.first.public_data, actual.first.public_data);
+        EXPECT_EQ(expected.second.secret_data, actual.second.secret_data);
+
+        ColorValue message = ColorValue::from_math_value(1);
+        auto expected_ct = single.encapsulate_deterministic(expected.first, error_seed, secret_seed, matrix_seed, message);
+        auto actual_ct = piped.encapsulate_deterministic(expected.first, error_seed, secret_seed, matrix_seed, message);
+        EXPECT_EQ(expected_ct.first.ciphertext_data, actual_ct.first.ciphertext_data);
+        EXPECT_EQ(expected_ct.first.shared_secret_hint, actual_ct.first.shared_secret_hint);
+    }
+}
+
+// Placement moves buffers between heaps without changing a single output byte
+TEST_F(ColorKEMTest, PlacementPolicyMatchesDefault) {
+    std::array<uint8_t, 32> matrix_seed, secret_seed, error_seed;
+    for (size_t i = 0; i < 32; ++i) {
+        matrix_seed[i] = static_cast<uint8_t>(3 * i);
+        secret_seed[i] = static_cast<uint8_t>(i + 7);
+        error_seed[i] = static_cast<uint8_t>(11 * i);
+    }
+
+    const PlacementPolicy saved = placement_policy();
+    PlacementPolicy defaults;
+    defaults.tables = MemoryRegion::Default;
+    defaults.scratch = MemoryRegion::Default;
+    set_placement_policy(defaults);
+    ColorKEM reference(params);
+    auto expected = reference.keygen_deterministic(matrix_seed, secret_seed, error_seed);
+
+    set_placement_policy(PlacementPolicy::psram_matrix());
+    ColorKEM placed(params);
+    auto actual = placed.keygen_deterministic(matrix_seed, secret_seed, error_seed);
+    set_placement_policy(saved);
+
+    EXPECT_EQ(expected.first.public_data, actual.first.public_data);
+    EXPECT_EQ(expected.second.secret_data, actual.second.secret_data);
+
+    PlacedVector<uint32_t> bulk(64, PlacementAllocator<uint32_t>(MemoryRegion::External));
+    EXPECT_EQ(MemoryRegion::External, bulk.get_allocator().region());
+}
+
+// Precomputed bundles decapsulate correctly, are used once and are wiped once used
+TEST_F(ColorKEMTest, NoisePoolBundlesAreSingleUse) {
+    std::vector<uint8_t> region(NoisePool::region_bytes(params, 2));
+    NoisePool pool(region.data(), region.size(), params);
+    EXPECT_EQ(2u, pool.capacity());
+    EXPECT_EQ(0u, pool.available());
+    EXPECT_THROW(kem->precompute_noise(), std::logic_error);
+
+    kem->set_noise_pool(&pool);
+    EXPECT_EQ(1u, kem->precompute_noise(1));
+    EXPECT_EQ(1u, kem->precompute_noise());
+    EXPECT_EQ(0u, kem->precompute_noise());
+    EXPECT_EQ(2u, pool.available());
+
+    // A pool opened over the same region again (after a deep-sleep wake) keeps its bundles
+    NoisePool reopened(region.data(), region.size(), params);
+    EXPECT_EQ(2u, reopened.available());
+
+    // Bundles are taken in slot order; the byte after a slot's state is its message bit
+    auto keypair = kem->keygen();
+    std::vector<std::vector<uint8_t>> ciphertexts;
+    for (size_t used = 1; used <= 3; ++used) {
+        size_t slot = NoisePool::HEADER_BYTES + (used - 1) * NoisePool::bundle_bytes(params);
+        uint8_t stored_message = used <= 2 ? region[slot + 1] : 0;
+        auto encapsulated = kem->encapsulate(keypair.first);
+        if (used <= 2) {
+            EXPECT_EQ(ColorValue::from_math_value(stored_message), encapsulated.second);
+        }
+        EXPECT_EQ(used < 2 ? 2 - used : 0, pool.available());
+        ciphertexts.push_back(encapsulated.first.ciphertext_data);
+    }
+    EXPECT_NE(ciphertexts[0], ciphertexts[1]);
+    EXPECT_NE(ciphertexts[1], ciphertexts[2]);
+    for (size_t i = NoisePool::HEADER_BYTES; i < region.size(); ++i) {
+        ASSERT_EQ(0, region[i]) << "byte " << i;
+    }
+
+    ColorKEM other(CLWEParameters(768));
+    EXPECT_THROW(other.set_noise_pool(&pool), std::invalid_argument);
+    NoisePool reformatted(region.data(), region.size(), CLWEParameters(768));
+    EXPECT_EQ(0u, reformatted.available());
+    EXPECT_THROW(NoisePool(region.data(), NoisePool::HEADER_BYTES, params), std::invalid_argument);
+    kem->set_noise_pool(nullptr);
+}
+
+// Every stage is visited by a full round trip, and the counters cover only what ran
+TEST_F(ColorKEMTest, StageProfileCountsEveryStage) {
+    auto keypair = kem->keygen();
+    stage_profile_reset();
+    auto encapsulated = kem->encapsulate(keypair.first);
+    kem->decapsulate(keypair.first, keypair.second, encapsulated.first);
+    StageCycles stages = stage_profile_snapshot();
+
+    for (size_t s = 0; s < KEM_STAGE_COUNT; ++s) {
+        EXPECT_EQ(stage_profile_enabled(), stages.calls[s] > 0) << kem_stage_name(static_cast<KemStage>(s));
+    }
+
+    stage_profile_reset();
+    EXPECT_EQ(0u, stage_profile_snapshot().total());
+    EXPECT_STREQ("matrix_a", kem_stage_name(KemStage::MatrixExpansion));
+    EXPECT_STREQ("packing", kem_stage_name(KemStage::Packing));
+}
+
+// Keys read in place from a FlashKeyStore image must behave like the RAM keys
+TEST_F(ColorKEMTest, FlashKeyStoreViewsMatchKeys) {
+    auto [public_key, private_key] = kem->keygen();
+    auto [other_public, other_private] = kem->keygen();
+    std::vector<uint8_t> image = FlashKeyStore::encode_record(public_key, private_key);
+    std::vector<uint8_t> second = FlashKeyStore::encode_record(other_public, other_private);
+    EXPECT_EQ(image.size(), FlashKeyStore::record_bytes(params));
+    EXPECT_EQ(image.size() % FlashKeyStore::SECTOR_BYTES, 0u);
+    image.resize(image.size() + FlashKeyStore::SECTOR_BYTES, 0xFF);  // Erased sector between records
+    image.insert(image.end(), second.begin(), second.end());
+
+    FlashKeyStore store(image.data(), image.size());
+    ASSERT_EQ(store.size(), 2u);
+    EXPECT_EQ(store.params(1).security_level, params.security_level);
+    EXPECT_THROW(store.public_key(2), std::out_of_range);
+
+    auto [ciphertext, shared_secret] = kem->encapsulate(public_key);
+    EXPECT_EQ(kem->decapsulate(store.private_key(0), ciphertext), shared_secret);
+    EXPECT_EQ(kem->decapsulate(store.private_key(0), ciphertext),
+              kem->decapsulate(public_key, private_key, ciphertext));
+
+    auto [flash_ciphertext, flash_secret] = kem->encapsulate(store.public_key(1));
+    EXPECT_EQ(kem->decapsulate(other_public, other_private, flash_ciphertext), flash_secret);
+
+    // Implicit rejection agrees with the RAM key too
+    ciphertext.ciphertext_data[7] ^= 1;
+    EXPECT_EQ(kem->decapsulate(store.private_key(0), ciphertext),
+              kem->decapsulate(public_key, private_key, ciphertext));
+}
+
+// Records that fail their check are skipped when the store is opened
+TEST_F(ColorKEMTest, FlashKeyStoreSkipsCorruptRecords) {
+    auto [public_key, private_key] = kem->keygen();
+    std::vector<uint8_t> record = FlashKeyStore::encode_record(public_key, private_key);
+    std::vector<uint8_t> image = record;
+    image.insert(image.end(), record.begin(), record.end());
+    image[sizeof(FlashKeyRecordHeader) + 100] ^= 1;
+
+    FlashKeyStore store(image.data(), image.size());
+    ASSERT_EQ(store.size(), 1u);
+    EXPECT_EQ(store.public_key(0).seed, image.data() + record.size() + sizeof(FlashKeyRecordHeader));
+
+    FlashKeyStore truncated(record.data(), record.size() - 1);
+    EXPECT_EQ(truncated.size(), 0u);
+
+    ColorPrivateKey wrong = private_key;
+    wrong.secret_data.pop_back();
+    EXPECT_THROW(FlashKeyStore::encode_record(public_key, wrong), std::invalid_argument);
+}
+
+#ifdef CLWE_STATIC_WORKSPACE
+// The zero-heap entry points must produce the same bytes as the vector API
+TEST(ColorKEMStaticTest, MatchesVectorAPI) {
+    CLWEParameters params(STATIC_SECURITY_LEVEL);
+    ColorKEM kem(params);
+
+    std::array<uint8_t, 32> matrix_seed, secret_seed, error_seed, r_seed, e1_seed, e2_seed;
+    for (size_t i = 0; i < 32; ++i) {
+        matrix_seed[i] = static_cast<uint8_t>(i);
+        secret_seed[i] = static_cast<uint8_t>(3 * i + 1);
+        error_seed[i] = static_cast<uint8_t>(5 * i + 2);
+        r_seed[i] = static_cast<uint8_t>(7 * i + 3);
+        e1_seed[i] = static_cast<uint8_t>(11 * i + 4);
+        e2_seed[i] = static_cast<uint8_t>(13 * i + 5);
+    }
+    ColorValue message = ColorValue::from_math_value(1);
+
+    auto [public_key, private_key] = kem.keygen_deterministic(matrix_seed, secret_seed, error_seed);
+    auto [ciphertext, shared_secret] = kem.encapsulate_deterministic(public_key, r_seed, e1_seed, e2_seed, message);
+
+    std::vector<uint8_t> public_data(STATIC_PUBLIC_DATA_BYTES), secret_data(STATIC_SECRET_DATA_BYTES);
+    std::vector<uint8_t> ciphertext_data(STATIC_CIPHERTEXT_DATA_BYTES), hint(STATIC_HINT_BYTES);
+    kem.keygen_deterministic_static(matrix_seed, secret_seed, error_seed, public_data.data(), secret_data.data());
+    ColorValue static_secret = kem.encapsulate_deterministic_static(matrix_seed, public_data.data(), r_seed, e1_seed,
+                                                                    e2_seed, message, ciphertext_data.data(), hint.data());
+
+    EXPECT_EQ(public_data, public_key.public_data);
+    EXPECT_EQ(secret_data, private_key.secret_data);
+    EXPECT_EQ(ciphertext_data, ciphertext.ciphertext_data);
+    EXPECT_EQ(hint, ciphertext.shared_secret_hint);
+    EXPECT_EQ(static_secret, shared_secret);
+
+    EXPECT_EQ(kem.decapsulate_static(secret_data.data(), ciphertext_data.data(), hint.data()),
+              kem.decapsulate(public_key, private_key, ciphertext));
+
+    // Tampered ciphertext takes the implicit-rejection path on both sides
+    ciphertext_data[5] ^= 1;
+    ciphertext.ciphertext_data[5] ^= 1;
+    hint[3] ^= 1;
+    ciphertext.shared_secret_hint[3] ^= 1;
+    EXPECT_EQ(kem.decapsulate_static(secret_data.data(), ciphertext_data.data(), hint.data()),
+              kem.decapsulate(public_key, private_key, ciphertext));
+}
+
+TEST(ColorKEMStaticTest, RejectsOtherSecurityLevel) {
+    ColorKEM kem(CLWEParameters(STATIC_SECURITY_LEVEL == 512 ? 768 : 512));
+    std::array<uint8_t, 32> seed;
+    std::vector<uint8_t> public_data(STATIC_PUBLIC_DATA_BYTES), secret_data(STATIC_SECRET_DATA_BYTES);
+    EXPECT_THROW(kem.keygen_static(seed, public_data.data(), secret_data.data()), std::invalid_argument);
+}
+
+TEST(ColorKEMStaticTest, AttachValidatesRegion) {
+    alignas(StaticWorkspace) static uint8_t region[STATIC_WORKSPACE_BYTES];
+    EXPECT_THROW(static_workspace_attach(nullptr, sizeof(region)), std::invalid_argument);
+    EXPECT_THROW(static_workspace_attach(region, sizeof(region) - 1), std::invalid_argument);
+    static_workspace_attach(region, sizeof(region));
+    EXPECT_EQ(reinterpret_cast<uint8_t*>(&static_workspace()), region);
+    static_workspace_detach();
+    EXPECT_NE(reinterpret_cast<uint8_t*>(&static_workspace()), region);
+}
+#endif
+
 } // namespace clwe
\ No newline at end of file
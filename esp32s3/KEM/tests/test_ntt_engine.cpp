@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include "color_ntt_engine.hpp"
 #include "ntt_engine.hpp"
+#include "ntt_scalar.hpp"
+#include "ntt_esp32s3.hpp"
 #include "utils.hpp"
 #include <vector>
 #include <algorithm>
@@ -288,4 +290,37 @@ TEST_F(NTTEngineTest, MultiplicationByMonomial) {
     }
 }
 
+// The PIE engine (portable kernels off-target) must match the scalar engine bit for bit
+TEST_F(NTTEngineTest, ESP32S3MatchesScalar) {
+    for (uint32_t q : {3329u, 7681u, 12289u}) {
+        for (uint32_t n : {16u, 64u, 256u}) {
+            ScalarNTTEngine scalar(q, n);
+            ESP32S3NTTEngine pie(q, n);
+            EXPECT_EQ(pie.get_simd_support(), SIMDSupport::PIE);
+
+            std::vector<uint32_t> a(n), b(n);
+            for (uint32_t i = 0; i < n; ++i) {
+                a[i] = (i * 2654435761u) % q;
+                b[i] = (i * 40503u + 17) % q;
+            }
+
+            std::vector<uint32_t> expected = a, actual = a;
+            scalar.ntt_forward(expected.data());
+            pie.ntt_forward(actual.data());
+            EXPECT_EQ(actual, expected);
+
+            expected = a;
+            actual = a;
+            scalar.ntt_inverse(expected.data());
+            pie.ntt_inverse(actual.data());
+            EXPECT_EQ(actual, expected);
+
+            std::vector<uint32_t> product_expected(n), product_actual(n);
+            scalar.multiply(a.data(), b.data(), product_expected.data());
+            pie.multiply(a.data(), b.data(), product_actual.data());
+            EXPECT_EQ(product_actual, product_expected);
+        }
+    }
+}
+
 } // namespace clwe
\ No newline at end of file
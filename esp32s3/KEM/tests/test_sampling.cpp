@@ -346,4 +346,47 @@ TEST_F(SamplingTest, AVX512BatchSampling) {
 }
 #endif
 
+// Block-wise squeezing continues the same XOF stream as byte-wise squeezing
+TEST_F(SamplingTest, SqueezeBlocksMatchesSqueeze) {
+    std::array<uint8_t, 34> seed{};
+    for (size_t i = 0; i < seed.size(); ++i) seed[i] = static_cast<uint8_t>(i * 7);
+
+    SHAKE128Sampler blocks128, bytes128;
+    blocks128.init(seed.data(), seed.size());
+    bytes128.init(seed.data(), seed.size());
+    std::vector<uint8_t> expected(3 * SHAKE128Sampler::BLOCK_BYTES + 5);
+    std::vector<uint8_t> actual(expected.size());
+    for (auto& byte : expected) bytes128.squeeze(&byte, 1);
+    blocks128.squeeze_blocks(actual.data(), 3);
+    blocks128.squeeze(actual.data() + 3 * SHAKE128Sampler::BLOCK_BYTES, 5);
+    EXPECT_EQ(expected, actual);
+
+    SHAKE256Sampler blocks256, bytes256;
+    blocks256.init(seed.data(), seed.size());
+    bytes256.init(seed.data(), seed.size());
+    expected.assign(2 * SHAKE256Sampler::BLOCK_BYTES + 3, 0);
+    actual.assign(expected.size(), 0);
+    bytes256.squeeze(expected.data(), expected.size());
+    blocks256.squeeze(actual.data(), 3);
+    blocks256.squeeze_blocks(actual.data() + 3, 2);
+    EXPECT_EQ(expected, actual);
+}
+
+// Polynomial sampling reads the same bytes as one coefficient at a time
+TEST_F(SamplingTest, BinomialPolynomialMatchesCoefficients) {
+    std::array<uint8_t, 32> seed = {9, 8, 7, 6, 5, 4, 3, 2, 1};
+    for (uint32_t e : {1u, 2u, 3u, 5u}) {
+        SHAKE256Sampler poly_sampler, coeff_sampler;
+        poly_sampler.init(seed.data(), seed.size());
+        coeff_sampler.init(seed.data(), seed.size());
+
+        std::vector<uint32_t> poly(degree);
+        poly_sampler.sample_polynomial_binomial(poly.data(), degree, e, modulus);
+        for (uint32_t i = 0; i < degree; ++i) {
+            int32_t sample = coeff_sampler.sample_binomial_coefficient(e);
+            EXPECT_EQ(poly[i], static_cast<uint32_t>((sample % static_cast<int32_t>(modulus) + modulus) % modulus));
+        }
+    }
+}
+
 } // namespace clwe
\ No newline at end of file
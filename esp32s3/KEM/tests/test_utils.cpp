@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 #include "utils.hpp"
+#include "csprng.hpp"
+#include <algorithm>
+#include <cstring>
 #include <vector>
 #include <chrono>
 #include <thread>
@@ -170,6 +173,44 @@ TEST_F(UtilsTest, SecureRandomBytes) {
     EXPECT_NO_THROW(secure_random_bytes(large_buffer, 1024));
 }
 
+// RFC 8439 appendix A.1, test vector 1: all-zero key, nonce and counter
+static const uint8_t CHACHA20_ZERO_BLOCK[64] = {
+    0x76, 0xb8, 0xe0, 0xad, 0xa0, 0xf1, 0x3d, 0x90, 0x40, 0x5d, 0x6a, 0xe5, 0x53, 0x86, 0xbd, 0x28,
+    0xbd, 0xd2, 0x19, 0xb8, 0xa0, 0x8d, 0xed, 0x1a, 0xa8, 0x36, 0xef, 0xcc, 0x8b, 0x77, 0x0d, 0xc7,
+    0xda, 0x41, 0x59, 0x7c, 0x51, 0x57, 0x48, 0x8d, 0x77, 0x24, 0xe0, 0x3f, 0xb8, 0xd8, 0x4a, 0x37,
+    0x6a, 0x43, 0xb8, 0xf4, 0x15, 0x18, 0xa1, 0x1c, 0xc3, 0x87, 0xb6, 0x69, 0xb2, 0xee, 0x65, 0x86
+};
+
+TEST_F(UtilsTest, ChaCha20Block) {
+    uint32_t key[8] = {};
+    uint8_t out[ChaCha20Drbg::BLOCK_BYTES];
+    ChaCha20Drbg::block(key, 0, out);
+    EXPECT_EQ(0, std::memcmp(out, CHACHA20_ZERO_BLOCK, sizeof(out)));
+}
+
+// The first 32 keystream bytes become the next key and are never served
+TEST_F(UtilsTest, DrbgFastKeyErasure) {
+    uint8_t key[ChaCha20Drbg::KEY_BYTES] = {};
+    ChaCha20Drbg drbg;
+    drbg.seed(key);
+
+    uint8_t out[32];
+    drbg.generate(out, sizeof(out));
+    EXPECT_EQ(0, std::memcmp(out, CHACHA20_ZERO_BLOCK + 32, sizeof(out)));
+
+    // Reads of any size draw the same stream
+    ChaCha20Drbg a, b;
+    a.seed(key);
+    b.seed(key);
+    std::vector<uint8_t> whole(3 * ChaCha20Drbg::BUFFER_BYTES + 5);
+    std::vector<uint8_t> pieces(whole.size());
+    a.generate(whole.data(), whole.size());
+    for (size_t i = 0; i < pieces.size(); i += 7) {
+        b.generate(pieces.data() + i, std::min<size_t>(7, pieces.size() - i));
+    }
+    EXPECT_EQ(whole, pieces);
+}
+
 // Test AVXAllocator
 TEST_F(UtilsTest, AVXAllocator) {
     // Test allocation and deallocation
@@ -3,16 +3,44 @@
 #include <vector>
 #include <functional>
 #include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <atomic>
+#include <cmath>
+#include <iomanip>
+#include <thread>
+#include <cctype>
+#include <cstdlib>
+#include <stdexcept>
+#include <memory>
+#include <mutex>
+#include <deque>
+#include <utility>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 #include "clwe/clwe.hpp"
 #include "src/core/color_kem.hpp"
 #include "src/core/cpu_features.hpp"
 #include "src/core/performance_metrics.hpp"
+#include "src/core/benchmark_report.hpp"
 
 using namespace clwe;
 
-void benchmark_security_level(int security_level) {
-    std::cout << "Security Level: " << security_level << "-bit" << std::endl;
-    std::cout << "=====================================" << std::endl;
+enum class OutputFormat { TEXT, JSON, CSV };
+
+const int kTimingIterations = 100;  // time_operation_with_memory default
+
+// Human-readable text goes to `out`; json/csv runs pass a sink so only the report is printed
+void benchmark_security_level(int security_level, std::ostream& out, clwe::BenchmarkReport& report) {
+    out << "Security Level: " << security_level << "-bit" << std::endl;
+    out << "=====================================" << std::endl;
 
     clwe::CLWEParameters params(security_level);
     clwe::ColorKEM kem(params);
@@ -31,15 +59,20 @@ void benchmark_security_level(int security_level) {
     clwe::MemoryStats keygen_mem, encap_mem, decap_mem;
     clwe::TimingStats keygen_timing = clwe::PerformanceMetrics::time_operation_with_memory([&]() {
         auto [pk, sk] = kem.keygen();
-    }, keygen_mem);
+    }, keygen_mem, kTimingIterations);
 
     clwe::TimingStats encap_timing = clwe::PerformanceMetrics::time_operation_with_memory([&]() {
         auto [ct, ss] = kem.encapsulate(public_key);
-    }, encap_mem);
+    }, encap_mem, kTimingIterations);
 
     clwe::TimingStats decap_timing = clwe::PerformanceMetrics::time_operation_with_memory([&]() {
         ColorValue recovered = kem.decapsulate(public_key, private_key, ciphertext);
-    }, decap_mem);
+    }, decap_mem, kTimingIterations);
+
+    const std::string level = "/" + std::to_string(security_level);
+    report.records.push_back(clwe::BenchmarkRecord::from_timing("keygen" + level, keygen_timing, kTimingIterations));
+    report.records.push_back(clwe::BenchmarkRecord::from_timing("encapsulate" + level, encap_timing, kTimingIterations));
+    report.records.push_back(clwe::BenchmarkRecord::from_timing("decapsulate" + level, decap_timing, kTimingIterations));
 
     // CPU cycle measurements
     clwe::CycleStats keygen_cycles = clwe::PerformanceMetrics::time_operation_cycles([&]() {
@@ -54,6 +87,20 @@ void benchmark_security_level(int security_level) {
         ColorValue recovered = kem.decapsulate(public_key, private_key, ciphertext);
     });
 
+    // Energy per operation, where a counter is readable (RAPL as root, or an installed reader)
+    clwe::EnergyStats keygen_energy = clwe::PerformanceMetrics::measure_energy([&]() {
+        auto [pk, sk] = kem.keygen();
+    });
+
+    clwe::EnergyStats encap_energy = clwe::PerformanceMetrics::measure_energy([&]() {
+        auto [ct, ss] = kem.encapsulate(public_key);
+    });
+
+    clwe::EnergyStats decap_energy = clwe::PerformanceMetrics::measure_energy([&]() {
+        ColorValue recovered = kem.decapsulate(public_key, private_key, ciphertext);
+        (void)recovered;
+    });
+
     // Calculate bandwidth (bytes transferred per second)
     double keygen_bandwidth = (public_key_size + private_key_size) / (keygen_timing.average_time / 1000000.0);
     double encap_bandwidth = (ciphertext_size + shared_secret_size) / (encap_timing.average_time / 1000000.0);
@@ -70,71 +117,1259 @@ void benchmark_security_level(int security_level) {
     size_t avg_memory = (keygen_mem.average_memory + encap_mem.average_memory + decap_mem.average_memory) / 3;
 
     // Display results
-    std::cout << "=== TIMING METRICS ===" << std::endl;
-    std::cout << "Key Generation:     " << keygen_timing.average_time << " μs" << std::endl;
-    std::cout << "Encapsulation:      " << encap_timing.average_time << " μs" << std::endl;
-    std::cout << "Decapsulation:      " << decap_timing.average_time << " μs" << std::endl;
-    std::cout << "Total KEM Time:     " << total_kem_time << " μs" << std::endl;
-    std::cout << "Throughput:         " << throughput << " operations/second" << std::endl;
-    std::cout << std::endl;
-
-    std::cout << "=== CPU CYCLE METRICS ===" << std::endl;
-    std::cout << "KeyGen Cycles:      " << keygen_cycles.average_cycles << std::endl;
-    std::cout << "Encap Cycles:       " << encap_cycles.average_cycles << std::endl;
-    std::cout << "Decap Cycles:       " << decap_cycles.average_cycles << std::endl;
-    std::cout << "Total Cycles:       " << total_cycles << std::endl;
-    std::cout << "Cycles/Second:      " << cycles_per_second << std::endl;
-    std::cout << std::endl;
-
-    std::cout << "=== MEMORY USAGE METRICS ===" << std::endl;
-    std::cout << "Peak Memory:        " << total_peak_memory / 1024.0 << " KB" << std::endl;
-    std::cout << "Average Memory:     " << avg_memory / 1024.0 << " KB" << std::endl;
-    std::cout << std::endl;
-
-    std::cout << "=== STORAGE REQUIREMENTS ===" << std::endl;
-    std::cout << "Public Key Size:    " << public_key_size << " bytes" << std::endl;
-    std::cout << "Private Key Size:   " << private_key_size << " bytes" << std::endl;
-    std::cout << "Ciphertext Size:    " << ciphertext_size << " bytes" << std::endl;
-    std::cout << "Shared Secret Size: " << shared_secret_size << " bytes" << std::endl;
-    std::cout << std::endl;
-
-    std::cout << "=== BANDWIDTH METRICS ===" << std::endl;
-    std::cout << "KeyGen Bandwidth:   " << keygen_bandwidth / 1024.0 << " KB/s" << std::endl;
-    std::cout << "Encap Bandwidth:    " << encap_bandwidth / 1024.0 << " KB/s" << std::endl;
-    std::cout << "Decap Bandwidth:    " << decap_bandwidth / 1024.0 << " KB/s" << std::endl;
-    std::cout << std::endl;
-
-    std::cout << "=== PERFORMANCE BREAKDOWN ===" << std::endl;
-    std::cout << "Time Distribution:" << std::endl;
-    std::cout << "  KeyGen: " << (keygen_timing.average_time / total_kem_time * 100) << "%" << std::endl;
-    std::cout << "  Encap:  " << (encap_timing.average_time / total_kem_time * 100) << "%" << std::endl;
-    std::cout << "  Decap:  " << (decap_timing.average_time / total_kem_time * 100) << "%" << std::endl;
-    std::cout << std::endl;
-
-    std::cout << "Cycle Distribution:" << std::endl;
-    std::cout << "  KeyGen: " << (keygen_cycles.average_cycles / (double)total_cycles * 100) << "%" << std::endl;
-    std::cout << "  Encap:  " << (encap_cycles.average_cycles / (double)total_cycles * 100) << "%" << std::endl;
-    std::cout << "  Decap:  " << (decap_cycles.average_cycles / (double)total_cycles * 100) << "%" << std::endl;
-    std::cout << std::endl;
-}
-
-int main() {
-    std::cout << "🎨 CLWE Color KEM Timing Benchmark" << std::endl;
-    std::cout << "===================================" << std::endl;
+    out << "=== TIMING METRICS ===" << std::endl;
+    out << "Key Generation:     " << keygen_timing.average_time << " μs" << std::endl;
+    out << "Encapsulation:      " << encap_timing.average_time << " μs" << std::endl;
+    out << "Decapsulation:      " << decap_timing.average_time << " μs" << std::endl;
+    out << "Total KEM Time:     " << total_kem_time << " μs" << std::endl;
+    out << "Throughput:         " << throughput << " operations/second" << std::endl;
+    out << std::endl;
+
+    out << "=== CPU CYCLE METRICS ===" << std::endl;
+    out << "KeyGen Cycles:      " << keygen_cycles.average_cycles << std::endl;
+    out << "Encap Cycles:       " << encap_cycles.average_cycles << std::endl;
+    out << "Decap Cycles:       " << decap_cycles.average_cycles << std::endl;
+    out << "Total Cycles:       " << total_cycles << std::endl;
+    out << "Cycles/Second:      " << cycles_per_second << std::endl;
+    out << std::endl;
+
+    out << "=== ENERGY METRICS ===" << std::endl;
+    if (keygen_energy.available && encap_energy.available && decap_energy.available) {
+        out << "Source:             " << keygen_energy.source << std::endl;
+        out << "KeyGen Energy:      " << keygen_energy.microjoules_per_operation << " μJ" << std::endl;
+        out << "Encap Energy:       " << encap_energy.microjoules_per_operation << " μJ" << std::endl;
+        out << "Decap Energy:       " << decap_energy.microjoules_per_operation << " μJ" << std::endl;
+        out << "Average Power:      " << (keygen_energy.average_watts + encap_energy.average_watts +
+                                          decap_energy.average_watts) / 3 << " W" << std::endl;
+    } else {
+        out << "Energy:             not available (RAPL needs read access to /sys/class/powercap)" << std::endl;
+    }
+    out << std::endl;
+
+    out << "=== MEMORY USAGE METRICS ===" << std::endl;
+    out << "Peak Memory:        " << total_peak_memory / 1024.0 << " KB" << std::endl;
+    out << "Average Memory:     " << avg_memory / 1024.0 << " KB" << std::endl;
+    out << std::endl;
+
+    out << "=== STORAGE REQUIREMENTS ===" << std::endl;
+    out << "Public Key Size:    " << public_key_size << " bytes" << std::endl;
+    out << "Private Key Size:   " << private_key_size << " bytes" << std::endl;
+    out << "Ciphertext Size:    " << ciphertext_size << " bytes" << std::endl;
+    out << "Shared Secret Size: " << shared_secret_size << " bytes" << std::endl;
+    out << std::endl;
+
+    // Seed-only storage: regenerating s_hat on load against parsing the stored coefficients
+    ColorCompactPrivateKey compact_key{std::array<uint8_t, 32>{}, params};
+    std::vector<uint8_t> stored_key = private_key.serialize();
+    std::vector<uint8_t> stored_compact = compact_key.serialize();
+    clwe::TimingStats load_timing = clwe::PerformanceMetrics::time_operation([&]() {
+        clwe::do_not_optimize(kem.prepare_private_key(ColorPrivateKey::deserialize(stored_key, params)));
+    }, kTimingIterations, 10);
+    clwe::TimingStats load_compact_timing = clwe::PerformanceMetrics::time_operation([&]() {
+        clwe::do_not_optimize(kem.prepare_private_key(ColorCompactPrivateKey::deserialize(stored_compact, params)));
+    }, kTimingIterations, 10);
+    report.records.push_back(clwe::BenchmarkRecord::from_timing("load_private_key" + level, load_timing,
+                                                                kTimingIterations));
+    report.records.push_back(clwe::BenchmarkRecord::from_timing("load_compact_private_key" + level,
+                                                                load_compact_timing, kTimingIterations));
+
+    out << "=== COMPACT PRIVATE KEY ===" << std::endl;
+    out << "Stored Size:        " << stored_compact.size() << " bytes (" << stored_key.size() << " full, "
+        << stored_key.size() - stored_compact.size() << " saved)" << std::endl;
+    out << "Load (full):        " << load_timing.average_time << " μs" << std::endl;
+    out << "Load (compact):     " << load_compact_timing.average_time << " μs ("
+        << load_compact_timing.average_time - load_timing.average_time << " μs extra, "
+        << (load_compact_timing.average_time - load_timing.average_time) * 1000.0 /
+               static_cast<double>(stored_key.size() - stored_compact.size())
+        << " ns per byte saved)" << std::endl;
+    out << std::endl;
+
+    out << "=== BANDWIDTH METRICS ===" << std::endl;
+    out << "KeyGen Bandwidth:   " << keygen_bandwidth / 1024.0 << " KB/s" << std::endl;
+    out << "Encap Bandwidth:    " << encap_bandwidth / 1024.0 << " KB/s" << std::endl;
+    out << "Decap Bandwidth:    " << decap_bandwidth / 1024.0 << " KB/s" << std::endl;
+    out << std::endl;
+
+    out << "=== PERFORMANCE BREAKDOWN ===" << std::endl;
+    out << "Time Distribution:" << std::endl;
+    out << "  KeyGen: " << (keygen_timing.average_time / total_kem_time * 100) << "%" << std::endl;
+    out << "  Encap:  " << (encap_timing.average_time / total_kem_time * 100) << "%" << std::endl;
+    out << "  Decap:  " << (decap_timing.average_time / total_kem_time * 100) << "%" << std::endl;
+    out << std::endl;
+
+    out << "Cycle Distribution:" << std::endl;
+    out << "  KeyGen: " << (keygen_cycles.average_cycles / (double)total_cycles * 100) << "%" << std::endl;
+    out << "  Encap:  " << (encap_cycles.average_cycles / (double)total_cycles * 100) << "%" << std::endl;
+    out << "  Decap:  " << (decap_cycles.average_cycles / (double)total_cycles * 100) << "%" << std::endl;
+    out << std::endl;
+}
+
+// Warm latency (tight loop after warm-up) against cold latency (the caches displaced by
+// evictor before every run) for each operation. A handshake arriving after other request
+// processing sees something close to the cold figure, so table sizes and layouts are best
+// judged on it.
+void benchmark_cache_states(int security_level, clwe::CacheEvictor& evictor, std::ostream& out,
+                            clwe::BenchmarkReport& report) {
+    clwe::CLWEParameters params(security_level);
+    clwe::ColorKEM kem(params);
+    auto [public_key, private_key] = kem.keygen();
+    auto [ciphertext, shared_secret] = kem.encapsulate(public_key);
+
+    struct Operation {
+        const char* name;
+        std::function<void()> run;
+    };
+    const std::vector<Operation> operations = {
+        {"keygen", [&]() { auto [pk, sk] = kem.keygen(); }},
+        {"encapsulate", [&]() { auto [ct, ss] = kem.encapsulate(public_key); }},
+        {"decapsulate", [&]() { (void)kem.decapsulate(public_key, private_key, ciphertext); }},
+    };
+
+    out << "Security Level: " << security_level << "-bit" << std::endl;
+    out << "Operation       Warm p50 (μs)  Cold p50 (μs)  Cold p99 (μs)  Cold/Warm" << std::endl;
+    const std::string level = "/" + std::to_string(security_level);
+    for (const Operation& operation : operations) {
+        clwe::TimingStats warm = clwe::PerformanceMetrics::time_operation(operation.run, kTimingIterations, 10);
+        clwe::TimingStats cold = clwe::PerformanceMetrics::time_operation_cold(operation.run, evictor,
+                                                                               kTimingIterations);
+        report.records.push_back(clwe::BenchmarkRecord::from_timing(std::string(operation.name) + level + "/warm",
+                                                                    warm, kTimingIterations));
+        report.records.push_back(clwe::BenchmarkRecord::from_timing(std::string(operation.name) + level + "/cold",
+                                                                    cold, kTimingIterations));
+        out << std::left << std::setw(14) << operation.name << std::right << std::fixed << std::setprecision(2)
+            << std::setw(15) << warm.p50_time << std::setw(15) << cold.p50_time << std::setw(15) << cold.p99_time
+            << std::setw(10) << cold.p50_time / warm.p50_time << "x" << std::defaultfloat << std::setprecision(6)
+            << std::endl;
+    }
+    out << std::endl;
+}
+
+// Per-worker latency samples of the throughput mode; merged once the run stops
+struct WorkerSamples {
+    clwe::LatencyHistogram histogram;
+    double sum_ns = 0;
+    double sum_squares_ns = 0;
+    uint64_t min_ns = UINT64_MAX;
+    uint64_t max_ns = 0;
+
+    void record(uint64_t ns) {
+        histogram.record(ns);
+        sum_ns += static_cast<double>(ns);
+        sum_squares_ns += static_cast<double>(ns) * static_cast<double>(ns);
+        min_ns = std::min(min_ns, ns);
+        max_ns = std::max(max_ns, ns);
+    }
+
+    void merge(const WorkerSamples& other) {
+        histogram.merge(other.histogram);
+        sum_ns += other.sum_ns;
+        sum_squares_ns += other.sum_squares_ns;
+        min_ns = std::min(min_ns, other.min_ns);
+        max_ns = std::max(max_ns, other.max_ns);
+    }
+
+    void reset() {
+        histogram.reset();
+        sum_ns = 0;
+        sum_squares_ns = 0;
+        min_ns = UINT64_MAX;
+        max_ns = 0;
+    }
+
+    // mean/stddev/min/max/p50/p99 in μs; iterations and ops_per_sec are left to the caller
+    void fill(clwe::BenchmarkRecord& record) const {
+        if (histogram.count() == 0) {
+            return;
+        }
+        double n = static_cast<double>(histogram.count());
+        double mean_ns = sum_ns / n;
+        record.mean_us = mean_ns / 1000.0;
+        record.stddev_us = std::sqrt(std::max(0.0, sum_squares_ns / n - mean_ns * mean_ns)) / 1000.0;
+        record.min_us = static_cast<double>(min_ns) / 1000.0;
+        record.max_us = static_cast<double>(max_ns) / 1000.0;
+        record.p50_us = static_cast<double>(histogram.value_at_percentile(50.0)) / 1000.0;
+        record.p99_us = static_cast<double>(histogram.value_at_percentile(99.0)) / 1000.0;
+    }
+};
+
+struct ScalingPoint {
+    unsigned threads;
+    uint64_t operations;
+    double ops_per_sec;
+    clwe::BenchmarkRecord record;
+};
+
+// N workers alternate encapsulate and decapsulate against one shared key pair and KEM
+// instance for `duration`, so allocator and shared-cache contention show up in the numbers
+ScalingPoint run_throughput(int security_level, unsigned threads, std::chrono::milliseconds duration) {
+    clwe::CLWEParameters params(security_level);
+    clwe::ColorKEM kem(params);
+    auto [public_key, private_key] = kem.keygen();
+    auto [ciphertext, shared_secret] = kem.encapsulate(public_key);
+
+    std::vector<WorkerSamples> samples(threads);
+    std::atomic<unsigned> ready{0};
+    std::atomic<bool> go{false};
+    std::atomic<bool> stop{false};
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            WorkerSamples& mine = samples[t];
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            for (uint64_t i = 0; !stop.load(std::memory_order_relaxed); ++i) {
+                auto start = std::chrono::steady_clock::now();
+                if (i % 2 == 0) {
+                    auto encapsulation = kem.encapsulate(public_key);
+                    (void)encapsulation;
+                } else {
+                    ColorValue recovered = kem.decapsulate(public_key, private_key, ciphertext);
+                    (void)recovered;
+                }
+                auto end = std::chrono::steady_clock::now();
+                uint64_t ns = static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+                mine.record(ns);
+            }
+        });
+    }
+
+    while (ready.load() != threads) {
+        std::this_thread::yield();
+    }
+    auto started = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(duration);
+    stop.store(true);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    WorkerSamples total;
+    for (const WorkerSamples& worker : samples) {
+        total.merge(worker);
+    }
+
+    ScalingPoint point;
+    point.threads = threads;
+    point.operations = total.histogram.count();
+    point.ops_per_sec = static_cast<double>(point.operations) / elapsed_s;
+
+    clwe::BenchmarkRecord& record = point.record;
+    record.name = "throughput/" + std::to_string(security_level) + "/t" + std::to_string(threads);
+    record.iterations = point.operations;
+    record.ops_per_sec = point.ops_per_sec;
+    total.fill(record);
+    return point;
+}
+
+// Throughput for 1..max_threads workers, with scaling efficiency ops(N) / (N * ops(1)) as a bar chart
+void benchmark_throughput(int security_level, unsigned max_threads, std::chrono::milliseconds duration,
+                          std::ostream& out, clwe::BenchmarkReport& report) {
+    out << "Throughput, Security Level: " << security_level << "-bit (50% encapsulate / 50% decapsulate)"
+        << std::endl;
+    out << "=====================================" << std::endl;
+    out << "Threads      Ops/sec     p99 (μs)  Efficiency" << std::endl;
+
+    double single_thread_ops = 0;
+    for (unsigned threads = 1; threads <= max_threads; ++threads) {
+        ScalingPoint point = run_throughput(security_level, threads, duration);
+        if (threads == 1) {
+            single_thread_ops = point.ops_per_sec;
+        }
+        double efficiency = single_thread_ops > 0 ? point.ops_per_sec / (threads * single_thread_ops) : 0.0;
+
+        out << std::setw(7) << threads << std::fixed << std::setprecision(0) << std::setw(13) << point.ops_per_sec
+            << std::setprecision(1) << std::setw(13) << point.record.p99_us << std::setw(10) << efficiency * 100.0
+            << "% " << std::string(static_cast<size_t>(std::min(1.0, efficiency) * 40.0 + 0.5), '#')
+            << std::defaultfloat << std::setprecision(6) << std::endl;
+        report.records.push_back(point.record);
+    }
+    out << std::endl;
+}
+
+// Length-prefixed messages between the two sides of a simulated handshake
+class HandshakeTransport {
+public:
+    virtual ~HandshakeTransport() = default;
+    virtual void send(const std::vector<uint8_t>& message) = 0;
+    // Replaces message with the next one; an empty message ends the exchange
+    virtual void receive(std::vector<uint8_t>& message) = 0;
+};
+
+// One direction of the in-memory transport: send copies the bytes in, as a socket write would
+struct MemoryPipe {
+    std::vector<uint8_t> bytes;
+};
+
+class MemoryTransport : public HandshakeTransport {
+public:
+    MemoryTransport(MemoryPipe& outgoing, MemoryPipe& incoming) : outgoing_(outgoing), incoming_(incoming) {}
+
+    void send(const std::vector<uint8_t>& message) override {
+        outgoing_.bytes.assign(message.begin(), message.end());
+    }
+
+    void receive(std::vector<uint8_t>& message) override {
+        message.swap(incoming_.bytes);
+        incoming_.bytes.clear();
+    }
+
+private:
+    MemoryPipe& outgoing_;
+    MemoryPipe& incoming_;
+};
+
+// A connected TCP socket on 127.0.0.1, Nagle off; each message is a 4-byte length and the payload
+class SocketTransport : public HandshakeTransport {
+public:
+    explicit SocketTransport(int fd) : fd_(fd) {
+        int one = 1;
+        setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+
+    ~SocketTransport() override {
+        close(fd_);
+    }
+
+    void send(const std::vector<uint8_t>& message) override {
+        uint8_t length[4];
+        for (size_t i = 0; i < sizeof(length); ++i) {
+            length[i] = static_cast<uint8_t>(message.size() >> (8 * i));
+        }
+        write_all(length, sizeof(length));
+        write_all(message.data(), message.size());
+    }
+
+    void receive(std::vector<uint8_t>& message) override {
+        uint8_t length[4];
+        read_all(length, sizeof(length));
+        uint32_t size = 0;
+        for (size_t i = 0; i < sizeof(length); ++i) {
+            size |= static_cast<uint32_t>(length[i]) << (8 * i);
+        }
+        message.resize(size);
+        read_all(message.data(), size);
+    }
+
+    // Both ends of a fresh loopback connection, client first
+    static std::pair<std::unique_ptr<SocketTransport>, std::unique_ptr<SocketTransport>> connect_loopback() {
+        int listener = socket(AF_INET, SOCK_STREAM, 0);
+        if (listener < 0) {
+            throw std::runtime_error("Cannot create a loopback socket");
+        }
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t address_size = sizeof(address);
+        int client = -1;
+        int server = -1;
+        if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0 &&
+            listen(listener, 1) == 0 &&
+            getsockname(listener, reinterpret_cast<sockaddr*>(&address), &address_size) == 0) {
+            client = socket(AF_INET, SOCK_STREAM, 0);
+            if (client >= 0 && connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+                server = accept(listener, nullptr, nullptr);
+            }
+        }
+        close(listener);
+        if (server < 0) {
+            if (client >= 0) {
+                close(client);
+            }
+            throw std::runtime_error("Cannot connect over loopback");
+        }
+        return {std::unique_ptr<SocketTransport>(new SocketTransport(client)),
+                std::unique_ptr<SocketTransport>(new SocketTransport(server))};
+    }
+
+private:
+    void write_all(const uint8_t* data, size_t size) {
+        while (size > 0) {
+            ssize_t written = ::send(fd_, data, size, MSG_NOSIGNAL);
+            if (written <= 0) {
+                throw std::runtime_error("Loopback write failed");
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+    }
+
+    void read_all(uint8_t* data, size_t size) {
+        while (size > 0) {
+            ssize_t got = recv(fd_, data, size, 0);
+            if (got <= 0) {
+                throw std::runtime_error("Loopback read failed");
+            }
+            data += got;
+            size -= static_cast<size_t>(got);
+        }
+    }
+
+    int fd_;
+};
+
+enum HandshakeStage {
+    STAGE_KEYGEN,
+    STAGE_PK_SERIALIZE,
+    STAGE_PK_DESERIALIZE,
+    STAGE_ENCAPSULATE,
+    STAGE_CT_SERIALIZE,
+    STAGE_CT_DESERIALIZE,
+    STAGE_DECAPSULATE,
+    STAGE_COUNT
+};
+
+const char* const kHandshakeStageNames[STAGE_COUNT] = {
+    "keygen", "pk_serialize", "pk_deserialize", "encapsulate", "ct_serialize", "ct_deserialize", "decapsulate",
+};
+
+uint64_t nanoseconds_since(std::chrono::steady_clock::time_point start) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+// Server samples of a handshake; the client records the other stages
+struct ServerStages {
+    WorkerSamples pk_deserialize, encapsulate, ct_serialize;
+    std::vector<ColorValue> secrets;
+};
+
+// Server side of one handshake: public key in, ciphertext out. False on the closing empty message.
+bool serve_handshake(const clwe::ColorKEM& kem, HandshakeTransport& transport, std::vector<uint8_t>& message,
+                     ServerStages* samples) {
+    transport.receive(message);
+    if (message.empty()) {
+        return false;
+    }
+    auto start = std::chrono::steady_clock::now();
+    ColorPublicKey public_key = ColorPublicKey::deserialize(message, kem.params());
+    uint64_t deserialize_ns = nanoseconds_since(start);
+
+    start = std::chrono::steady_clock::now();
+    auto [ciphertext, shared_secret] = kem.encapsulate(public_key);
+    uint64_t encapsulate_ns = nanoseconds_since(start);
+
+    start = std::chrono::steady_clock::now();
+    std::vector<uint8_t> reply = ciphertext.serialize();
+    uint64_t serialize_ns = nanoseconds_since(start);
+
+    if (samples != nullptr) {
+        samples->pk_deserialize.record(deserialize_ns);
+        samples->encapsulate.record(encapsulate_ns);
+        samples->ct_serialize.record(serialize_ns);
+        samples->secrets.push_back(shared_secret);
+    }
+    transport.send(reply);
+    return true;
+}
+
+struct HandshakeResult {
+    uint64_t handshakes = 0;
+    uint64_t mismatches = 0;  // Client and server secrets differed
+    double handshakes_per_sec = 0;
+    size_t public_key_bytes = 0, ciphertext_bytes = 0;
+    WorkerSamples end_to_end;
+    WorkerSamples stages[STAGE_COUNT];
+};
+
+const int kHandshakeWarmup = 10;
+
+// Back-to-back handshakes for `duration`, each with a fresh client key pair. Over memory the server
+// step runs inline on the client's thread; over loopback a server thread answers on its own socket.
+// Both sides drop the first kHandshakeWarmup handshakes from their samples.
+HandshakeResult run_handshakes(int security_level, bool loopback, std::chrono::milliseconds duration) {
+    clwe::CLWEParameters params(security_level);
+    clwe::ColorKEM kem(params);
+    HandshakeResult result;
+    ServerStages server_samples;
+    std::vector<ColorValue> client_secrets;
+
+    MemoryPipe to_server, to_client;
+    std::unique_ptr<HandshakeTransport> client_end, server_end;
+    if (loopback) {
+        auto ends = SocketTransport::connect_loopback();
+        client_end = std::move(ends.first);
+        server_end = std::move(ends.second);
+    } else {
+        client_end.reset(new MemoryTransport(to_server, to_client));
+        server_end.reset(new MemoryTransport(to_client, to_server));
+    }
+
+    std::thread server;
+    if (loopback) {
+        server = std::thread([&] {
+            std::vector<uint8_t> message;
+            try {
+                for (int i = -kHandshakeWarmup;
+                     serve_handshake(kem, *server_end, message, i >= 0 ? &server_samples : nullptr); ++i) {
+                }
+            } catch (const std::exception&) {
+                // The client sees the closed socket and reports the failure
+            }
+            server_end.reset();
+        });
+    }
+
+    std::vector<uint8_t> message;
+    auto started = std::chrono::steady_clock::now();
+    try {
+        for (int i = -kHandshakeWarmup; i < 0 || std::chrono::steady_clock::now() - started < duration; ++i) {
+            if (i == 0) {
+                started = std::chrono::steady_clock::now();
+            }
+            const bool measured = i >= 0;
+            auto handshake_start = std::chrono::steady_clock::now();
+            auto [public_key, private_key] = kem.keygen();
+            uint64_t keygen_ns = nanoseconds_since(handshake_start);
+
+            auto start = std::chrono::steady_clock::now();
+            message = public_key.serialize();
+            uint64_t serialize_ns = nanoseconds_since(start);
+            result.public_key_bytes = message.size();
+
+            client_end->send(message);
+            if (!loopback) {
+                serve_handshake(kem, *server_end, message, measured ? &server_samples : nullptr);
+            }
+            client_end->receive(message);
+            result.ciphertext_bytes = message.size();
+
+            start = std::chrono::steady_clock::now();
+            ColorCiphertext ciphertext = ColorCiphertext::deserialize(message, params);
+            uint64_t deserialize_ns = nanoseconds_since(start);
+
+            start = std::chrono::steady_clock::now();
+            ColorValue shared_secret = kem.decapsulate(public_key, private_key, ciphertext);
+            uint64_t decapsulate_ns = nanoseconds_since(start);
+            uint64_t end_to_end_ns = nanoseconds_since(handshake_start);
+
+            if (measured) {
+                result.stages[STAGE_KEYGEN].record(keygen_ns);
+                result.stages[STAGE_PK_SERIALIZE].record(serialize_ns);
+                result.stages[STAGE_CT_DESERIALIZE].record(deserialize_ns);
+                result.stages[STAGE_DECAPSULATE].record(decapsulate_ns);
+                result.end_to_end.record(end_to_end_ns);
+                client_secrets.push_back(shared_secret);
+            }
+        }
+        client_end->send(std::vector<uint8_t>());
+    } catch (...) {
+        // Closing the client end unblocks the server thread
+        client_end.reset();
+        if (server.joinable()) {
+            server.join();
+        }
+        throw;
+    }
+    double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    if (server.joinable()) {
+        server.join();
+    }
+
+    result.stages[STAGE_PK_DESERIALIZE] = server_samples.pk_deserialize;
+    result.stages[STAGE_ENCAPSULATE] = server_samples.encapsulate;
+    result.stages[STAGE_CT_SERIALIZE] = server_samples.ct_serialize;
+    result.handshakes = client_secrets.size();
+    result.handshakes_per_sec = static_cast<double>(result.handshakes) / elapsed_s;
+    for (size_t i = 0; i < client_secrets.size(); ++i) {
+        if (i >= server_samples.secrets.size() || !(client_secrets[i] == server_samples.secrets[i])) {
+            ++result.mismatches;
+        }
+    }
+    return result;
+}
+
+// Handshakes/sec and end-to-end latency, with each stage's share of the mean; "transport" is
+// what the stages leave of the end-to-end mean (copies or socket round trip and wake-ups)
+void benchmark_handshake(int security_level, bool loopback, std::chrono::milliseconds duration,
+                         std::ostream& out, clwe::BenchmarkReport& report) {
+    HandshakeResult result = run_handshakes(security_level, loopback, duration);
+    if (result.mismatches != 0) {
+        throw std::runtime_error(std::to_string(result.mismatches) + " handshakes derived different secrets");
+    }
+
+    const std::string prefix = "handshake/" + std::to_string(security_level) + (loopback ? "/loopback" : "/memory");
+    clwe::BenchmarkRecord total;
+    total.name = prefix + "/end_to_end";
+    total.iterations = result.handshakes;
+    total.ops_per_sec = result.handshakes_per_sec;
+    result.end_to_end.fill(total);
+    report.records.push_back(total);
+
+    out << "Handshake, Security Level: " << security_level << "-bit ("
+        << (loopback ? "loopback TCP" : "in-memory") << " transport, " << result.public_key_bytes
+        << "-byte public key, " << result.ciphertext_bytes << "-byte ciphertext)" << std::endl;
+    out << "=====================================" << std::endl;
+    out << std::fixed << std::setprecision(0) << "Handshakes/sec:     " << result.handshakes_per_sec << std::endl
+        << std::setprecision(2) << "End-to-end p50:     " << total.p50_us << " μs" << std::endl
+        << "End-to-end p99:     " << total.p99_us << " μs" << std::endl;
+    out << "Stage              Mean (μs)    p50 (μs)    p99 (μs)   Share" << std::endl;
+
+    double stage_sum_us = 0;
+    for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+        clwe::BenchmarkRecord record;
+        record.name = prefix + "/" + kHandshakeStageNames[stage];
+        record.iterations = result.stages[stage].histogram.count();
+        result.stages[stage].fill(record);
+        report.records.push_back(record);
+        stage_sum_us += record.mean_us;
+        out << std::left << std::setw(16) << kHandshakeStageNames[stage] << std::right << std::setw(12)
+            << record.mean_us << std::setw(12) << record.p50_us << std::setw(12) << record.p99_us << std::setw(7)
+            << (total.mean_us > 0 ? record.mean_us / total.mean_us * 100.0 : 0.0) << "%" << std::endl;
+    }
+    double transport_us = std::max(0.0, total.mean_us - stage_sum_us);
+    out << std::left << std::setw(16) << "transport" << std::right << std::setw(12) << transport_us
+        << std::setw(12) << "-" << std::setw(12) << "-" << std::setw(7)
+        << (total.mean_us > 0 ? transport_us / total.mean_us * 100.0 : 0.0) << "%" << std::defaultfloat
+        << std::setprecision(6) << std::endl;
+    out << std::endl;
+}
+
+// One (n, k) point of the sweep mode
+struct SweepPoint {
+    uint32_t degree;
+    uint32_t rank;
+    bool correct;  // A decapsulation recovered the encapsulated secret
+    int iterations;
+    clwe::TimingStats keygen, encapsulate, decapsulate;
+    size_t peak_rss_bytes;  // Process peak resident set over the three operations
+    clwe::KemMemoryRequirements requirements;
+    size_t public_key_bytes, ciphertext_bytes;
+};
+
+// Iterations for a grid point: the level-512 count, scaled down with the k^2 * n matrix
+// work so that large points still finish in seconds
+int sweep_iterations(uint32_t degree, uint32_t rank) {
+    double work = static_cast<double>(rank) * rank * degree / (2.0 * 2.0 * 256.0);
+    return std::max(5, std::min(kTimingIterations, static_cast<int>(kTimingIterations / work)));
+}
+
+SweepPoint run_sweep_point(uint32_t degree, uint32_t rank, uint32_t modulus) {
+    // The level only labels custom sets; eta 2 keeps the noise within range at every degree
+    clwe::CLWEParameters params(512, degree, rank, modulus, 2, 2);
+    clwe::ColorKEM kem(params);
+    auto [public_key, private_key] = kem.keygen();
+    auto [ciphertext, shared_secret] = kem.encapsulate(public_key);
+
+    SweepPoint point;
+    point.degree = degree;
+    point.rank = rank;
+    point.correct = kem.decapsulate(public_key, private_key, ciphertext) == shared_secret;
+    point.iterations = sweep_iterations(degree, rank);
+    clwe::MemoryStats keygen_mem, encap_mem, decap_mem;
+    point.keygen = clwe::PerformanceMetrics::time_operation_with_memory([&]() {
+        auto [pk, sk] = kem.keygen();
+    }, keygen_mem, point.iterations);
+    point.encapsulate = clwe::PerformanceMetrics::time_operation_with_memory([&]() {
+        auto [ct, ss] = kem.encapsulate(public_key);
+    }, encap_mem, point.iterations);
+    point.decapsulate = clwe::PerformanceMetrics::time_operation_with_memory([&]() {
+        ColorValue recovered = kem.decapsulate(public_key, private_key, ciphertext);
+        (void)recovered;
+    }, decap_mem, point.iterations);
+    point.peak_rss_bytes = std::max({keygen_mem.peak_memory, encap_mem.peak_memory, decap_mem.peak_memory});
+    point.requirements = kem.memory_requirements();
+    point.public_key_bytes = public_key.serialize().size();
+    point.ciphertext_bytes = ciphertext.serialize().size();
+    return point;
+}
+
+// Keygen/encapsulate/decapsulate over a grid of custom (n, k) sets, one CSV row per point.
+// Timing against n and k shows where the working set leaves each cache level and where the
+// O(k^2) matrix expansion starts to dominate.
+void benchmark_sweep(const std::vector<uint32_t>& degrees, const std::vector<uint32_t>& ranks, uint32_t modulus,
+                     std::ostream& out, std::ostream& progress) {
+    const clwe::BenchmarkEnvironment env = clwe::BenchmarkEnvironment::current();
+    out << "# cpu: " << env.cpu << "\n"
+        << "# compiler: " << env.compiler << "\n"
+        << "# flags: " << env.flags << "\n"
+        << "# modulus: " << modulus << "\n"
+        << "degree,rank,correct,iterations,keygen_us,keygen_p99_us,encapsulate_us,encapsulate_p99_us,"
+           "decapsulate_us,decapsulate_p99_us,peak_rss_bytes,workspace_bytes,expanded_key_bytes,"
+           "public_key_bytes,ciphertext_bytes\n";
+    for (uint32_t degree : degrees) {
+        for (uint32_t rank : ranks) {
+            progress << "n=" << degree << " k=" << rank << "..." << std::endl;
+            SweepPoint point = run_sweep_point(degree, rank, modulus);
+            out << point.degree << ',' << point.rank << ',' << (point.correct ? 1 : 0) << ',' << point.iterations
+                << ',' << point.keygen.average_time << ',' << point.keygen.p99_time << ','
+                << point.encapsulate.average_time << ',' << point.encapsulate.p99_time << ','
+                << point.decapsulate.average_time << ',' << point.decapsulate.p99_time << ','
+                << point.peak_rss_bytes << ',' << point.requirements.workspace_bytes() << ','
+                << point.requirements.encapsulate.expanded_key_bytes << ',' << point.public_key_bytes << ','
+                << point.ciphertext_bytes << std::endl;
+        }
+    }
+}
+
+// Intervals merged into the soak mode's sliding window
+const size_t kSoakWindowIntervals = 5;
+// Trend checks need this many intervals after the first, which is left out as warm-up
+const size_t kSoakMinTrendIntervals = 6;
+const double kSoakDecayThreshold = 0.05;        // Least-squares throughput change over the run
+const double kSoakLatencyDriftThreshold = 1.25;  // Last window's p99 against the first window's
+const size_t kSoakGrowthThresholdBytes = 1 << 20;
+
+// Resident set from /proc/self/statm; 0 where it cannot be read
+size_t read_rss_bytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0;
+    size_t resident = 0;
+    if (!(statm >> pages >> resident)) {
+        return 0;
+    }
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+// malloc's own view of the heap, summed over its arenas (glibc 2.33+ only)
+struct HeapStats {
+    bool available = false;
+    size_t in_use_bytes = 0;  // Allocated chunks, mmap'ed blocks included
+    size_t free_bytes = 0;    // Free chunks kept in the arenas: fragmentation when in_use stays flat
+};
+
+HeapStats read_heap_stats() {
+    HeapStats stats;
+#ifdef __GLIBC__
+#if __GLIBC_PREREQ(2, 33)
+    struct mallinfo2 info = mallinfo2();
+    stats.available = true;
+    stats.in_use_bytes = info.uordblks + info.hblkhd;
+    stats.free_bytes = info.fordblks;
+#endif
+#endif
+    return stats;
+}
+
+// One interval of the soak mode
+struct SoakSample {
+    double elapsed_s;
+    uint64_t operations;
+    double ops_per_sec;
+    double window_ops_per_sec;  // Over the last kSoakWindowIntervals intervals
+    double p50_us, p99_us, p999_us;  // Over the same window
+    size_t rss_bytes;
+    HeapStats heap;
+};
+
+// One worker's latencies since the sampler last collected them
+struct SoakWorker {
+    std::mutex mutex;
+    WorkerSamples window;
+};
+
+// Least-squares slope of ys against xs times the x span, relative to the mean of ys
+double relative_trend(const std::vector<double>& xs, const std::vector<double>& ys) {
+    const double n = static_cast<double>(xs.size());
+    double mean_x = 0, mean_y = 0;
+    for (size_t i = 0; i < xs.size(); ++i) {
+        mean_x += xs[i] / n;
+        mean_y += ys[i] / n;
+    }
+    double covariance = 0, variance = 0;
+    for (size_t i = 0; i < xs.size(); ++i) {
+        covariance += (xs[i] - mean_x) * (ys[i] - mean_y);
+        variance += (xs[i] - mean_x) * (xs[i] - mean_x);
+    }
+    if (variance == 0 || mean_y == 0) {
+        return 0;
+    }
+    return covariance / variance * (xs.back() - xs.front()) / mean_y;
+}
+
+// Growth from the first to the last value when no value is below its predecessor, else 0
+size_t monotonic_growth(const std::vector<size_t>& values) {
+    for (size_t i = 1; i < values.size(); ++i) {
+        if (values[i] < values[i - 1]) {
+            return 0;
+        }
+    }
+    return values.back() - values.front();
+}
+
+// Trends over the intervals after the first: throughput decay, p99 drift, and RSS or heap
+// that only ever grow
+std::vector<std::string> soak_trends(const std::vector<SoakSample>& samples) {
+    std::vector<std::string> trends;
+    if (samples.size() < kSoakMinTrendIntervals + 1) {
+        return trends;
+    }
+    std::vector<double> elapsed, throughput;
+    std::vector<size_t> rss, heap_in_use, heap_free;
+    for (size_t i = 1; i < samples.size(); ++i) {
+        elapsed.push_back(samples[i].elapsed_s);
+        throughput.push_back(samples[i].ops_per_sec);
+        rss.push_back(samples[i].rss_bytes);
+        heap_in_use.push_back(samples[i].heap.in_use_bytes);
+        heap_free.push_back(samples[i].heap.free_bytes);
+    }
+    std::ostringstream message;
+    message << std::fixed << std::setprecision(1);
+
+    double decay = relative_trend(elapsed, throughput);
+    if (decay < -kSoakDecayThreshold) {
+        message << "throughput decays " << -decay * 100.0 << "% over the run";
+        trends.push_back(message.str());
+    }
+    // The first full window after warm-up against the last one
+    const SoakSample& first_window = samples[std::min(kSoakWindowIntervals, samples.size() - 1)];
+    if (first_window.p99_us > 0 && samples.back().p99_us / first_window.p99_us > kSoakLatencyDriftThreshold) {
+        message.str("");
+        message << "p99 latency drifts from " << first_window.p99_us << " to " << samples.back().p99_us << " μs";
+        trends.push_back(message.str());
+    }
+    auto growth = [&](const std::vector<size_t>& values, const char* what) {
+        size_t grown = monotonic_growth(values);
+        if (grown >= kSoakGrowthThresholdBytes) {
+            message.str("");
+            message << what << " grows monotonically by " << grown / 1048576.0 << " MiB";
+            trends.push_back(message.str());
+        }
+    };
+    growth(rss, "RSS");
+    if (samples.back().heap.available) {
+        growth(heap_in_use, "Heap in use");
+        growth(heap_free, "Free heap (fragmentation)");
+    }
+    return trends;
+}
+
+// Mixed keygen/encapsulate/decapsulate at every level on `threads` workers for `duration`,
+// one row per interval, then the flagged trends on `warnings`. Each worker keeps one key
+// pair and ciphertext per level and replaces them as it goes, so the heap sees the same
+// churn of key, ciphertext and SHAKE buffer sizes as a long-running service. Returns the
+// number of trends flagged, or -1 if a decapsulation got the wrong secret.
+int benchmark_soak(unsigned threads, std::chrono::milliseconds duration, std::chrono::milliseconds interval,
+                   bool csv, std::ostream& out, std::ostream& warnings) {
+    const std::vector<int> levels = {512, 768, 1024};
+    std::vector<std::unique_ptr<clwe::ColorKEM>> kems;
+    for (int level : levels) {
+        kems.push_back(std::make_unique<clwe::ColorKEM>(clwe::CLWEParameters(level)));
+    }
+
+    std::vector<SoakWorker> workers(threads);
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> wrong_secrets{0};
+    std::vector<std::thread> threads_running;
+    for (unsigned t = 0; t < threads; ++t) {
+        threads_running.emplace_back([&, t] {
+            SoakWorker& mine = workers[t];
+            std::vector<std::pair<ColorPublicKey, ColorPrivateKey>> keys;
+            std::vector<std::pair<ColorCiphertext, ColorValue>> encapsulations;
+            for (const auto& kem : kems) {
+                keys.push_back(kem->keygen());
+                encapsulations.push_back(kem->encapsulate(keys.back().first));
+            }
+            for (uint64_t i = 0; !stop.load(std::memory_order_relaxed); ++i) {
+                const size_t level = i % kems.size();
+                const clwe::ColorKEM& kem = *kems[level];
+                auto start = std::chrono::steady_clock::now();
+                switch ((i / kems.size()) % 3) {
+                    case 0:
+                        keys[level] = kem.keygen();
+                        break;
+                    case 1:
+                        encapsulations[level] = kem.encapsulate(keys[level].first);
+                        break;
+                    default:
+                        if (kem.decapsulate(keys[level].first, keys[level].second, encapsulations[level].first) !=
+                            encapsulations[level].second) {
+                            wrong_secrets.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        break;
+                }
+                uint64_t ns = nanoseconds_since(start);
+                std::lock_guard<std::mutex> lock(mine.mutex);
+                mine.window.record(ns);
+            }
+        });
+    }
+
+    if (csv) {
+        const clwe::BenchmarkEnvironment env = clwe::BenchmarkEnvironment::current();
+        out << "# cpu: " << env.cpu << "\n"
+            << "# threads: " << threads << "\n"
+            << "# interval_ms: " << interval.count() << "\n"
+            << "elapsed_s,operations,ops_per_sec,window_ops_per_sec,p50_us,p99_us,p999_us,rss_bytes,"
+               "heap_in_use_bytes,heap_free_bytes"
+            << std::endl;
+    } else {
+        out << "=== SOAK (" << threads << " threads, levels 512/768/1024 keygen/encapsulate/decapsulate, "
+            << kSoakWindowIntervals << "-interval window) ===" << std::endl;
+        out << "Elapsed (s)    Ops/sec  Window ops/s   p50 (μs)   p99 (μs) p99.9 (μs)   RSS (MiB)  Heap (MiB)"
+               "  Free (MiB)"
+            << std::endl;
+    }
+
+    std::vector<SoakSample> samples;
+    std::deque<WorkerSamples> window;
+    std::deque<double> window_seconds;
+    const auto started = std::chrono::steady_clock::now();
+    auto previous = started;
+    for (size_t tick = 1; previous - started < duration; ++tick) {
+        std::this_thread::sleep_until(started + std::min<std::chrono::steady_clock::duration>(static_cast<long>(tick) * interval, duration));
+        const auto now = std::chrono::steady_clock::now();
+        window.emplace_back();
+        for (SoakWorker& worker : workers) {
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            window.back().merge(worker.window);
+            worker.window.reset();
+        }
+        window_seconds.push_back(std::chrono::duration<double>(now - previous).count());
+        previous = now;
+        if (window.size() > kSoakWindowIntervals) {
+            window.pop_front();
+            window_seconds.pop_front();
+        }
+
+        WorkerSamples merged;
+        double seconds = 0;
+        for (size_t w = 0; w < window.size(); ++w) {
+            merged.merge(window[w]);
+            seconds += window_seconds[w];
+        }
+        SoakSample sample;
+        sample.elapsed_s = std::chrono::duration<double>(now - started).count();
+        sample.operations = window.back().histogram.count();
+        sample.ops_per_sec = static_cast<double>(sample.operations) / window_seconds.back();
+        sample.window_ops_per_sec = static_cast<double>(merged.histogram.count()) / seconds;
+        sample.p50_us = static_cast<double>(merged.histogram.value_at_percentile(50.0)) / 1000.0;
+        sample.p99_us = static_cast<double>(merged.histogram.value_at_percentile(99.0)) / 1000.0;
+        sample.p999_us = static_cast<double>(merged.histogram.value_at_percentile(99.9)) / 1000.0;
+        sample.rss_bytes = read_rss_bytes();
+        sample.heap = read_heap_stats();
+        samples.push_back(sample);
+
+        if (csv) {
+            out << sample.elapsed_s << ',' << sample.operations << ',' << sample.ops_per_sec << ','
+                << sample.window_ops_per_sec << ',' << sample.p50_us << ',' << sample.p99_us << ','
+                << sample.p999_us << ',' << sample.rss_bytes << ',' << sample.heap.in_use_bytes << ','
+                << sample.heap.free_bytes << std::endl;
+        } else {
+            out << std::fixed << std::setprecision(1) << std::setw(11) << sample.elapsed_s << std::setprecision(0)
+                << std::setw(11) << sample.ops_per_sec << std::setw(14) << sample.window_ops_per_sec
+                << std::setprecision(1) << std::setw(11) << sample.p50_us << std::setw(11) << sample.p99_us
+                << std::setw(11) << sample.p999_us << std::setw(12) << sample.rss_bytes / 1048576.0;
+            if (sample.heap.available) {
+                out << std::setw(12) << sample.heap.in_use_bytes / 1048576.0 << std::setw(12)
+                    << sample.heap.free_bytes / 1048576.0;
+            } else {
+                out << std::setw(12) << "-" << std::setw(12) << "-";
+            }
+            out << std::defaultfloat << std::setprecision(6) << std::endl;
+        }
+    }
+    stop.store(true);
+    for (std::thread& worker : threads_running) {
+        worker.join();
+    }
+
+    if (wrong_secrets.load() != 0) {
+        warnings << "Error: " << wrong_secrets.load() << " decapsulations recovered the wrong secret" << std::endl;
+        return -1;
+    }
+    std::vector<std::string> trends = soak_trends(samples);
+    if (samples.size() < kSoakMinTrendIntervals + 1) {
+        warnings << "Note: trends need " << kSoakMinTrendIntervals + 1 << " intervals, the run had "
+                 << samples.size() << std::endl;
+    }
+    for (const std::string& trend : trends) {
+        warnings << "Warning: " << trend << std::endl;
+    }
+    if (!csv) {
+        out << trends.size() << " trends flagged" << std::endl << std::endl;
+    }
+    return static_cast<int>(trends.size());
+}
+
+// Comma-separated positive integers, each at most max_value; empty on a malformed list
+std::vector<uint32_t> parse_list(const std::string& text, unsigned long max_value) {
+    std::vector<uint32_t> values;
+    std::stringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        char* end = nullptr;
+        unsigned long value = std::strtoul(item.c_str(), &end, 10);
+        if (item.empty() || *end != '\0' || value == 0 || value > max_value) {
+            return {};
+        }
+        values.push_back(static_cast<uint32_t>(value));
+    }
+    return values;
+}
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " [--format=text|json|csv] [--output=FILE]"
+              << " [--mode=latency|throughput|sweep|cold|handshake|soak] [--threads=N] [--duration-ms=MS]"
+              << " [--evict-mb=MB] [--transport=memory|loopback] [--interval-ms=MS]"
+              << " [--pin-cpu=N] [--repeat=N] [--degrees=N,N,...] [--ranks=K,K,...] [--modulus=Q]"
+              << std::endl;
+}
+
+int main(int argc, char** argv) {
+    OutputFormat format = OutputFormat::TEXT;
+    std::string output_path;
+    bool throughput_mode = false;
+    bool sweep_mode = false;
+    bool cold_mode = false;
+    bool handshake_mode = false;
+    bool soak_mode = false;
+    bool loopback_transport = false;
+    bool transport_given = false;
+    long evict_mb = 0;
+    std::vector<uint32_t> sweep_degrees = {256, 512, 1024, 2048, 4096};
+    std::vector<uint32_t> sweep_ranks = {2, 3, 4, 6, 8};
+    uint32_t sweep_modulus = 3329;
+    unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+    long duration_ms = 1000;
+    long interval_ms = 0;
+    long pin_cpu = -1;
+    long repeats = 1;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--format=text") {
+            format = OutputFormat::TEXT;
+        } else if (arg == "--format=json") {
+            format = OutputFormat::JSON;
+        } else if (arg == "--format=csv") {
+            format = OutputFormat::CSV;
+        } else if (arg.rfind("--output=", 0) == 0) {
+            output_path = arg.substr(9);
+        } else if (arg == "--mode=latency") {
+            throughput_mode = false;
+            sweep_mode = false;
+            cold_mode = false;
+            handshake_mode = false;
+            soak_mode = false;
+        } else if (arg == "--mode=throughput") {
+            throughput_mode = true;
+            sweep_mode = false;
+            cold_mode = false;
+            handshake_mode = false;
+            soak_mode = false;
+        } else if (arg == "--mode=sweep") {
+            throughput_mode = false;
+            sweep_mode = true;
+            cold_mode = false;
+            handshake_mode = false;
+            soak_mode = false;
+        } else if (arg == "--mode=cold") {
+            throughput_mode = false;
+            sweep_mode = false;
+            cold_mode = true;
+            handshake_mode = false;
+            soak_mode = false;
+        } else if (arg == "--mode=handshake") {
+            throughput_mode = false;
+            sweep_mode = false;
+            cold_mode = false;
+            handshake_mode = true;
+            soak_mode = false;
+        } else if (arg == "--mode=soak") {
+            throughput_mode = false;
+            sweep_mode = false;
+            cold_mode = false;
+            handshake_mode = false;
+            soak_mode = true;
+        } else if (arg == "--transport=memory" || arg == "--transport=loopback") {
+            loopback_transport = arg == "--transport=loopback";
+            transport_given = true;
+        } else if (arg.rfind("--evict-mb=", 0) == 0 && std::atol(arg.c_str() + 11) > 0) {
+            evict_mb = std::atol(arg.c_str() + 11);
+        } else if (arg.rfind("--degrees=", 0) == 0 && !parse_list(arg.substr(10), 8192).empty()) {
+            sweep_degrees = parse_list(arg.substr(10), 8192);
+        } else if (arg.rfind("--ranks=", 0) == 0 && !parse_list(arg.substr(8), 16).empty()) {
+            sweep_ranks = parse_list(arg.substr(8), 16);
+        } else if (arg.rfind("--modulus=", 0) == 0 && std::atol(arg.c_str() + 10) > 0) {
+            sweep_modulus = static_cast<uint32_t>(std::atol(arg.c_str() + 10));
+        } else if (arg.rfind("--threads=", 0) == 0 && std::atol(arg.c_str() + 10) > 0) {
+            max_threads = static_cast<unsigned>(std::atol(arg.c_str() + 10));
+        } else if (arg.rfind("--duration-ms=", 0) == 0 && std::atol(arg.c_str() + 14) > 0) {
+            duration_ms = std::atol(arg.c_str() + 14);
+        } else if (arg.rfind("--interval-ms=", 0) == 0 && std::atol(arg.c_str() + 14) > 0) {
+            interval_ms = std::atol(arg.c_str() + 14);
+        } else if (arg.rfind("--pin-cpu=", 0) == 0 && std::isdigit(static_cast<unsigned char>(arg[10]))) {
+            pin_cpu = std::atol(arg.c_str() + 10);
+        } else if (arg.rfind("--repeat=", 0) == 0 && std::atol(arg.c_str() + 9) > 0) {
+            repeats = std::atol(arg.c_str() + 9);
+        } else {
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (transport_given && !handshake_mode) {
+        std::cerr << "--transport applies to the handshake mode only" << std::endl;
+        return 2;
+    }
+
+    if (interval_ms != 0 && !soak_mode) {
+        std::cerr << "--interval-ms applies to the soak mode only" << std::endl;
+        return 2;
+    }
+
+    // The soak streams one row per interval, text or its own CSV layout, for as long as it runs
+    if (soak_mode) {
+        if (format == OutputFormat::JSON) {
+            std::cerr << "--mode=soak writes text or CSV only" << std::endl;
+            return 2;
+        }
+        if (pin_cpu >= 0) {
+            std::cerr << "--pin-cpu applies to the latency mode only" << std::endl;
+            return 2;
+        }
+        std::ofstream file;
+        if (!output_path.empty()) {
+            file.open(output_path);
+            if (!file) {
+                std::cerr << "Cannot write " << output_path << std::endl;
+                return 1;
+            }
+        }
+        // Twenty intervals by default, so a run of any length gets its trends checked
+        const long interval = interval_ms != 0 ? interval_ms : std::max(10L, duration_ms / 20);
+        int trends = benchmark_soak(max_threads, std::chrono::milliseconds(duration_ms),
+                                    std::chrono::milliseconds(interval), format == OutputFormat::CSV,
+                                    output_path.empty() ? std::cout : file, std::cerr);
+        // A flagged trend exits with 3, so scheduled soak jobs fail without parsing the output
+        return trends < 0 ? 1 : (trends > 0 ? 3 : 0);
+    }
+
+    // The sweep has its own CSV layout, one row per grid point, written as each finishes
+    if (sweep_mode) {
+        if (format == OutputFormat::JSON) {
+            std::cerr << "--mode=sweep writes CSV only" << std::endl;
+            return 2;
+        }
+        std::ofstream file;
+        if (!output_path.empty()) {
+            file.open(output_path);
+            if (!file) {
+                std::cerr << "Cannot write " << output_path << std::endl;
+                return 1;
+            }
+        }
+        if (pin_cpu >= 0 && !clwe::pin_current_thread(static_cast<unsigned>(pin_cpu))) {
+            std::cerr << "Cannot pin to CPU " << pin_cpu << std::endl;
+            return 1;
+        }
+        try {
+            benchmark_sweep(sweep_degrees, sweep_ranks, sweep_modulus, output_path.empty() ? std::cout : file,
+                            std::cerr);
+        } catch (const std::invalid_argument& e) {
+            std::cerr << "Invalid sweep parameters: " << e.what() << std::endl;
+            return 2;
+        }
+        return 0;
+    }
+
+    std::ostringstream discarded;
+    std::ostream& out = format == OutputFormat::TEXT ? std::cout : discarded;
+
+    out << "🎨 CLWE Color KEM Timing Benchmark" << std::endl;
+    out << "===================================" << std::endl;
 
     
     CPUFeatures features = CPUFeatureDetector::detect();
-    std::cout << "CPU: " << features.to_string() << std::endl;
-    std::cout << std::endl;
+    out << "CPU: " << features.to_string() << std::endl;
+
+    // Pinning the main thread would also confine every throughput worker to that CPU
+    if (pin_cpu >= 0 && throughput_mode) {
+        std::cerr << "--pin-cpu applies to the latency mode only" << std::endl;
+        return 2;
+    }
+    if (pin_cpu >= 0 && !clwe::pin_current_thread(static_cast<unsigned>(pin_cpu))) {
+        std::cerr << "Cannot pin to CPU " << pin_cpu << std::endl;
+        return 1;
+    }
+    clwe::BenchmarkHostState host = clwe::BenchmarkHostState::inspect();
+    out << "Host: " << host.to_string() << std::endl;
+    for (const std::string& warning : host.warnings()) {
+        if (throughput_mode && warning.find("not pinned") != std::string::npos) {
+            continue;
+        }
+        std::cerr << "Warning: " << warning << std::endl;
+    }
+    out << std::endl;
 
     
-    std::vector<int> security_levels = {128, 192, 256};
+    std::vector<int> security_levels = {512, 768, 1024};
 
-    for (int level : security_levels) {
-        benchmark_security_level(level);
+    clwe::BenchmarkReport report;
+    report.environment = clwe::BenchmarkEnvironment::current();
+    report.environment.host = host.to_string();
+    if (throughput_mode) {
+        for (int level : security_levels) {
+            benchmark_throughput(level, max_threads, std::chrono::milliseconds(duration_ms), out, report);
+        }
+    } else if (handshake_mode) {
+        for (int level : security_levels) {
+            try {
+                benchmark_handshake(level, loopback_transport, std::chrono::milliseconds(duration_ms), out, report);
+            } catch (const std::runtime_error& e) {
+                std::cerr << "Handshake benchmark failed: " << e.what() << std::endl;
+                return 1;
+            }
+        }
+    } else if (cold_mode) {
+        clwe::CacheEvictor evictor(static_cast<size_t>(evict_mb) << 20);
+        out << "=== COLD VS WARM CACHE LATENCY (" << (evictor.size() >> 20) << " MiB evicted per run) ==="
+            << std::endl;
+        for (int level : security_levels) {
+            benchmark_cache_states(level, evictor, out, report);
+        }
+    } else {
+        // Only the first pass prints its details; later ones feed the run-to-run spread
+        std::vector<clwe::BenchmarkReport> runs(static_cast<size_t>(repeats));
+        for (size_t run = 0; run < runs.size(); ++run) {
+            for (int level : security_levels) {
+                benchmark_security_level(level, run == 0 ? out : discarded, runs[run]);
+            }
+        }
+        std::vector<clwe::BenchmarkRepeatSummary> summaries = clwe::summarize_repeats(runs);
+        if (repeats > 1) {
+            out << "=== RUN-TO-RUN VARIATION (" << repeats << " runs) ===" << std::endl;
+            out << "Operation             Mean (μs)    Min (μs)    Max (μs)      CV" << std::endl;
+        }
+        for (const clwe::BenchmarkRepeatSummary& summary : summaries) {
+            report.records.push_back(summary.median);
+            if (repeats > 1) {
+                out << std::left << std::setw(18) << summary.name << std::right << std::fixed << std::setprecision(2)
+                    << std::setw(13) << summary.mean_us << std::setw(12) << summary.min_us << std::setw(12)
+                    << summary.max_us << std::setw(7) << summary.cv * 100.0 << "%"
+                    << (summary.cv > 0.03 ? "  (noisy)" : "") << std::defaultfloat << std::setprecision(6)
+                    << std::endl;
+            }
+        }
+        if (repeats > 1) {
+            out << std::endl;
+        }
     }
 
-    std::cout << "Benchmark completed successfully!" << std::endl;
+    out << "Benchmark completed successfully!" << std::endl;
+
+    if (format == OutputFormat::TEXT) {
+        return 0;
+    }
 
+    std::ofstream file;
+    if (!output_path.empty()) {
+        file.open(output_path);
+        if (!file) {
+            std::cerr << "Cannot write " << output_path << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& report_out = output_path.empty() ? std::cout : file;
+    if (format == OutputFormat::JSON) {
+        clwe::write_report_json(report_out, report);
+    } else {
+        clwe::write_report_csv(report_out, report);
+    }
     return 0;
 }
\ No newline at end of file
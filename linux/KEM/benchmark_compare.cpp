@@ -0,0 +1,86 @@
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "src/core/benchmark_report.hpp"
+
+// Diff two benchmark_color_kem_timing --format=json|csv reports.
+// Exit status: 0 no significant regression, 1 at least one regression, 2 usage or input error.
+
+namespace {
+
+clwe::BenchmarkReport load(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    return clwe::read_report(in);
+}
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " [--alpha=P] [--threshold=FRACTION] BASELINE CANDIDATE" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    clwe::BenchmarkCompareOptions options;
+    std::string paths[2];
+    int path_count = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--alpha=", 0) == 0) {
+            options.alpha = std::atof(arg.c_str() + 8);
+        } else if (arg.rfind("--threshold=", 0) == 0) {
+            options.min_change = std::atof(arg.c_str() + 12);
+        } else if (arg.rfind("--", 0) != 0 && path_count < 2) {
+            paths[path_count++] = arg;
+        } else {
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+    if (path_count != 2) {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    clwe::BenchmarkReport baseline, candidate;
+    try {
+        baseline = load(paths[0]);
+        candidate = load(paths[1]);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+
+    if (baseline.environment.cpu != candidate.environment.cpu) {
+        std::cout << "warning: reports come from different CPUs" << std::endl;
+        std::cout << "  baseline:  " << baseline.environment.cpu << std::endl;
+        std::cout << "  candidate: " << candidate.environment.cpu << std::endl;
+    }
+    std::cout << "baseline " << baseline.environment.commit << " vs candidate " << candidate.environment.commit
+              << std::endl;
+
+    int regressions = 0;
+    std::cout << std::fixed;
+    for (const clwe::BenchmarkComparison& c : clwe::compare_reports(baseline, candidate, options)) {
+        const char* verdict = c.regression ? "REGRESSION" : c.improvement ? "improved" : "same";
+        std::cout << std::left << std::setw(20) << c.name << std::right
+                  << std::setprecision(2) << std::setw(12) << c.baseline_mean_us << " us"
+                  << std::setw(12) << c.candidate_mean_us << " us"
+                  << std::showpos << std::setw(9) << c.change * 100.0 << "%" << std::noshowpos
+                  << "  p=" << std::setprecision(4) << c.p_value << "  " << verdict << std::endl;
+        if (c.regression) {
+            ++regressions;
+        }
+    }
+
+    if (regressions > 0) {
+        std::cout << regressions << " significant regression(s)" << std::endl;
+        return 1;
+    }
+    return 0;
+}
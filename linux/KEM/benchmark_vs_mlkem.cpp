@@ -0,0 +1,254 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <oqs/oqs.h>
+#include "clwe/clwe_c.h"
+#include "src/core/cpu_features.hpp"
+#include "src/core/performance_metrics.hpp"
+#include "src/core/benchmark_report.hpp"
+
+// ColorKEM against the liboqs ML-KEM of the same security level. Both sides run through their
+// byte-oriented C interfaces (clwe_* and OQS_KEM_*), so every operation takes and returns
+// serialized keys and ciphertexts, exactly what a protocol handles.
+
+using namespace clwe;
+
+namespace {
+
+enum class OutputFormat { TEXT, JSON, CSV };
+
+// One KEM behind the keypair/encaps/decaps byte contract shared by clwe_c.h and liboqs
+class ByteKem {
+public:
+    virtual ~ByteKem() = default;
+    virtual const char* name() const = 0;
+    virtual size_t public_key_bytes() const = 0;
+    virtual size_t secret_key_bytes() const = 0;
+    virtual size_t ciphertext_bytes() const = 0;
+    virtual size_t shared_secret_bytes() const = 0;
+    virtual bool keypair(uint8_t* pk, uint8_t* sk) const = 0;
+    virtual bool encaps(uint8_t* ct, uint8_t* ss, const uint8_t* pk) const = 0;
+    virtual bool decaps(uint8_t* ss, const uint8_t* ct, const uint8_t* sk) const = 0;
+};
+
+// clwe_decapsulate() keeps the last parsed private key in its context; the workload reuses one
+// key pair, so decapsulation here is the warm path, like a server holding its key
+class ColorByteKem : public ByteKem {
+public:
+    explicit ColorByteKem(uint32_t level) : ctx_(clwe_ctx_new(level)) {
+        if (ctx_ == nullptr) {
+            throw std::invalid_argument("unsupported ColorKEM security level");
+        }
+    }
+    ~ColorByteKem() override { clwe_ctx_free(ctx_); }
+
+    const char* name() const override { return "ColorKEM"; }
+    size_t public_key_bytes() const override { return clwe_public_key_bytes(ctx_); }
+    size_t secret_key_bytes() const override { return clwe_private_key_bytes(ctx_); }
+    size_t ciphertext_bytes() const override { return clwe_ciphertext_bytes(ctx_); }
+    size_t shared_secret_bytes() const override { return CLWE_SHARED_SECRET_BYTES; }
+
+    bool keypair(uint8_t* pk, uint8_t* sk) const override {
+        return clwe_keygen(ctx_, pk, public_key_bytes(), sk, secret_key_bytes()) == CLWE_OK;
+    }
+    bool encaps(uint8_t* ct, uint8_t* ss, const uint8_t* pk) const override {
+        return clwe_encapsulate(ctx_, pk, public_key_bytes(), ct, ciphertext_bytes(), ss) == CLWE_OK;
+    }
+    bool decaps(uint8_t* ss, const uint8_t* ct, const uint8_t* sk) const override {
+        return clwe_decapsulate(ctx_, sk, secret_key_bytes(), ct, ciphertext_bytes(), ss) == CLWE_OK;
+    }
+
+private:
+    clwe_ctx* ctx_;
+};
+
+class OqsByteKem : public ByteKem {
+public:
+    // liboqs 0.10 and later name the FIPS 203 schemes "ML-KEM-*"; older releases only ship
+    // the round-3 "Kyber*" variants, which time the same arithmetic
+    explicit OqsByteKem(uint32_t level) {
+        const std::string fips = "ML-KEM-" + std::to_string(level);
+        const std::string kyber = "Kyber" + std::to_string(level);
+        kem_ = OQS_KEM_new(fips.c_str());
+        if (kem_ == nullptr) {
+            kem_ = OQS_KEM_new(kyber.c_str());
+        }
+        if (kem_ == nullptr) {
+            throw std::runtime_error("liboqs was built without " + fips + " and " + kyber);
+        }
+    }
+    ~OqsByteKem() override { OQS_KEM_free(kem_); }
+
+    const char* name() const override { return kem_->method_name; }
+    size_t public_key_bytes() const override { return kem_->length_public_key; }
+    size_t secret_key_bytes() const override { return kem_->length_secret_key; }
+    size_t ciphertext_bytes() const override { return kem_->length_ciphertext; }
+    size_t shared_secret_bytes() const override { return kem_->length_shared_secret; }
+
+    bool keypair(uint8_t* pk, uint8_t* sk) const override {
+        return OQS_KEM_keypair(kem_, pk, sk) == OQS_SUCCESS;
+    }
+    bool encaps(uint8_t* ct, uint8_t* ss, const uint8_t* pk) const override {
+        return OQS_KEM_encaps(kem_, ct, ss, pk) == OQS_SUCCESS;
+    }
+    bool decaps(uint8_t* ss, const uint8_t* ct, const uint8_t* sk) const override {
+        return OQS_KEM_decaps(kem_, ss, ct, sk) == OQS_SUCCESS;
+    }
+
+private:
+    OQS_KEM* kem_;
+};
+
+struct KemTimings {
+    TimingStats keygen;
+    TimingStats encaps;
+    TimingStats decaps;
+};
+
+// Times the three operations on one key pair; throws if an operation fails or the shared
+// secrets disagree, so a broken build never reports numbers
+KemTimings time_kem(const ByteKem& kem, int iterations, int warmup) {
+    std::vector<uint8_t> pk(kem.public_key_bytes()), sk(kem.secret_key_bytes());
+    std::vector<uint8_t> ct(kem.ciphertext_bytes());
+    std::vector<uint8_t> ss(kem.shared_secret_bytes()), recovered(kem.shared_secret_bytes());
+    if (!kem.keypair(pk.data(), sk.data()) || !kem.encaps(ct.data(), ss.data(), pk.data()) ||
+        !kem.decaps(recovered.data(), ct.data(), sk.data()) || ss != recovered) {
+        throw std::runtime_error(std::string(kem.name()) + " failed its round trip");
+    }
+
+    std::vector<uint8_t> scratch_pk(pk.size()), scratch_sk(sk.size());
+    KemTimings timings;
+    bool ok = true;
+    timings.keygen = PerformanceMetrics::time_operation([&]() {
+        ok &= kem.keypair(scratch_pk.data(), scratch_sk.data());
+    }, iterations, warmup);
+    timings.encaps = PerformanceMetrics::time_operation([&]() {
+        ok &= kem.encaps(ct.data(), ss.data(), pk.data());
+    }, iterations, warmup);
+    timings.decaps = PerformanceMetrics::time_operation([&]() {
+        ok &= kem.decaps(recovered.data(), ct.data(), sk.data());
+    }, iterations, warmup);
+    if (!ok || ss != recovered) {
+        throw std::runtime_error(std::string(kem.name()) + " failed while timed");
+    }
+    return timings;
+}
+
+void print_row(std::ostream& out, const char* label, double color, double reference, const char* unit,
+               int precision = 2) {
+    out << "  " << std::left << std::setw(16) << label << std::right
+        << std::setw(12) << std::fixed << std::setprecision(precision) << color << std::setw(12) << reference
+        << std::setw(10) << std::setprecision(2) << (reference > 0 ? color / reference : 0.0) << "x  " << unit
+        << std::defaultfloat << std::endl;
+}
+
+void compare_level(uint32_t level, int iterations, int warmup, std::ostream& out, BenchmarkReport& report) {
+    ColorByteKem color(level);
+    OqsByteKem reference(level);
+    KemTimings color_timings = time_kem(color, iterations, warmup);
+    KemTimings reference_timings = time_kem(reference, iterations, warmup);
+
+    out << "Security level " << level << ": ColorKEM vs " << reference.name() << std::endl;
+    out << "  " << std::left << std::setw(16) << "" << std::right << std::setw(12) << "ColorKEM"
+        << std::setw(12) << "ML-KEM" << std::setw(11) << "ratio" << std::endl;
+    print_row(out, "keygen", color_timings.keygen.average_time, reference_timings.keygen.average_time, "us mean");
+    print_row(out, "encapsulate", color_timings.encaps.average_time, reference_timings.encaps.average_time, "us mean");
+    print_row(out, "decapsulate", color_timings.decaps.average_time, reference_timings.decaps.average_time, "us mean");
+    print_row(out, "encaps p99", color_timings.encaps.p99_time, reference_timings.encaps.p99_time, "us");
+    print_row(out, "decaps p99", color_timings.decaps.p99_time, reference_timings.decaps.p99_time, "us");
+    print_row(out, "public key", double(color.public_key_bytes()), double(reference.public_key_bytes()), "bytes", 0);
+    print_row(out, "private key", double(color.secret_key_bytes()), double(reference.secret_key_bytes()), "bytes", 0);
+    print_row(out, "ciphertext", double(color.ciphertext_bytes()), double(reference.ciphertext_bytes()), "bytes", 0);
+    print_row(out, "shared secret", double(color.shared_secret_bytes()), double(reference.shared_secret_bytes()),
+              "bytes", 0);
+    out << std::endl;
+
+    const std::string suffix = "/" + std::to_string(level);
+    const uint64_t n = static_cast<uint64_t>(iterations);
+    report.records.push_back(BenchmarkRecord::from_timing("colorkem/keygen" + suffix, color_timings.keygen, n));
+    report.records.push_back(BenchmarkRecord::from_timing("colorkem/encapsulate" + suffix, color_timings.encaps, n));
+    report.records.push_back(BenchmarkRecord::from_timing("colorkem/decapsulate" + suffix, color_timings.decaps, n));
+    report.records.push_back(BenchmarkRecord::from_timing("mlkem/keygen" + suffix, reference_timings.keygen, n));
+    report.records.push_back(BenchmarkRecord::from_timing("mlkem/encapsulate" + suffix, reference_timings.encaps, n));
+    report.records.push_back(BenchmarkRecord::from_timing("mlkem/decapsulate" + suffix, reference_timings.decaps, n));
+}
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " [--format=text|json|csv] [--output=FILE] [--iterations=N]"
+              << " [--level=512|768|1024]" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    OutputFormat format = OutputFormat::TEXT;
+    std::string output_path;
+    int iterations = 1000;
+    std::vector<uint32_t> levels = {512, 768, 1024};
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--format=text") {
+            format = OutputFormat::TEXT;
+        } else if (arg == "--format=json") {
+            format = OutputFormat::JSON;
+        } else if (arg == "--format=csv") {
+            format = OutputFormat::CSV;
+        } else if (arg.rfind("--output=", 0) == 0) {
+            output_path = arg.substr(9);
+        } else if (arg.rfind("--iterations=", 0) == 0 && std::atoi(arg.c_str() + 13) > 0) {
+            iterations = std::atoi(arg.c_str() + 13);
+        } else if (arg == "--level=512" || arg == "--level=768" || arg == "--level=1024") {
+            levels = {static_cast<uint32_t>(std::atoi(arg.c_str() + 8))};
+        } else {
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+
+    std::ostringstream discarded;
+    std::ostream& out = format == OutputFormat::TEXT ? std::cout : discarded;
+    out << "ColorKEM vs ML-KEM (liboqs " << OQS_version() << ")" << std::endl;
+    out << "CPU: " << CPUFeatureDetector::cached().to_string() << std::endl;
+    out << "Ratios are ColorKEM / ML-KEM: above 1x ColorKEM is slower or larger" << std::endl << std::endl;
+
+    OQS_init();
+    BenchmarkReport report;
+    report.environment = BenchmarkEnvironment::current();
+    try {
+        for (uint32_t level : levels) {
+            compare_level(level, iterations, iterations / 10, out, report);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Comparison failed: " << e.what() << std::endl;
+        OQS_destroy();
+        return 1;
+    }
+    OQS_destroy();
+
+    if (format == OutputFormat::TEXT) {
+        return 0;
+    }
+
+    std::ofstream file;
+    if (!output_path.empty()) {
+        file.open(output_path);
+        if (!file) {
+            std::cerr << "Cannot write " << output_path << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& report_out = output_path.empty() ? std::cout : file;
+    if (format == OutputFormat::JSON) {
+        write_report_json(report_out, report);
+    } else {
+        write_report_csv(report_out, report);
+    }
+    return 0;
+}
@@ -0,0 +1,467 @@
+#include <benchmark/benchmark.h>
+#include <array>
+#include <string>
+#include <vector>
+#include "clwe/autotune.hpp"
+#include "clwe/batch_device.hpp"
+#include "clwe/clwe.hpp"
+#include "clwe/keccak_backend.hpp"
+#include "clwe/random_source.hpp"
+#include "src/core/aes_ctr.hpp"
+#include "src/core/color_kem.hpp"
+#include "src/core/cpu_features.hpp"
+#include "src/core/ntt_engine.hpp"
+#include "src/core/poly_multiplier.hpp"
+#include "src/core/shake_sampler.hpp"
+#include "src/core/sparse_ternary.hpp"
+#include "src/core/binomial_sampling.hpp"
+#include "src/core/rejection_sampling.hpp"
+
+using namespace clwe;
+
+namespace {
+
+const uint32_t kSecurityLevels[] = {512, 768, 1024};
+
+std::vector<uint32_t> random_poly(const clwe::CLWEParameters& params) {
+    SHAKE128Sampler sampler;
+    std::array<uint8_t, 32> seed{};
+    sampler.init(seed.data(), seed.size());
+    std::vector<uint32_t> poly(params.degree);
+    for (uint32_t& coeff : poly) {
+        uint8_t bytes[2];
+        sampler.squeeze(bytes, sizeof(bytes));
+        coeff = ((static_cast<uint32_t>(bytes[0]) << 8) | bytes[1]) % params.modulus;
+    }
+    return poly;
+}
+
+// ColorKEM operations draw their seeds from a deterministic source, so the numbers
+// measure the KEM rather than the entropy source and repeat from run to run
+
+void use_bench_random_source(ColorKEM& kem) {
+    kem.set_random_source(std::make_shared<DeterministicRandomSource>(std::array<uint8_t, 32>{}));
+}
+
+clwe::CLWEParameters xof_params(uint32_t level, XofAlgorithm xof) {
+    clwe::CLWEParameters params(level);
+    params.xof = xof;
+    return params;
+}
+
+const char* xof_name(XofAlgorithm xof) {
+    return xof == XofAlgorithm::AES256_CTR ? "aes256ctr" : "shake";
+}
+
+void BM_keygen(benchmark::State& state, uint32_t level, XofAlgorithm xof) {
+    ColorKEM kem{xof_params(level, xof)};
+    use_bench_random_source(kem);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kem.keygen());
+    }
+}
+
+void BM_encapsulate(benchmark::State& state, uint32_t level, XofAlgorithm xof) {
+    ColorKEM kem{xof_params(level, xof)};
+    use_bench_random_source(kem);
+    auto keys = kem.keygen();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kem.encapsulate(keys.first));
+    }
+}
+
+void BM_decapsulate(benchmark::State& state, uint32_t level, XofAlgorithm xof) {
+    ColorKEM kem{xof_params(level, xof)};
+    use_bench_random_source(kem);
+    auto keys = kem.keygen();
+    auto encapsulation = kem.encapsulate(keys.first);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kem.decapsulate(keys.first, keys.second, encapsulation.first));
+    }
+}
+
+// Prepared decapsulation with a binomial secret (weight 0, NTT inner product) or a
+// fixed-weight ternary one (sparse rotations)
+void BM_decapsulate_prepared(benchmark::State& state, uint32_t level, uint32_t weight) {
+    clwe::CLWEParameters params(level);
+    params.secret_weight = weight;
+    ColorKEM kem{params};
+    use_bench_random_source(kem);
+    auto keys = kem.keygen();
+    auto encapsulation = kem.encapsulate(keys.first);
+    PreparedPrivateKey prepared = kem.prepare_private_key(keys.second);
+    KemWorkspace workspace;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kem.decapsulate(prepared, encapsulation.first, workspace));
+    }
+}
+
+// Batch throughput per device: key pairs and encapsulations per second over one call
+
+void BM_keygen_batch(benchmark::State& state, uint32_t level, BatchDevice device) {
+    ColorKEM kem{clwe::CLWEParameters(level)};
+    kem.set_batch_device(device);
+    use_bench_random_source(kem);
+    const size_t count = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kem.keygen_batch(count));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_encapsulate_batch(benchmark::State& state, uint32_t level, BatchDevice device) {
+    ColorKEM kem{clwe::CLWEParameters(level)};
+    use_bench_random_source(kem);
+    std::vector<ColorPublicKey> public_keys;
+    for (auto& keys : kem.keygen_batch(static_cast<size_t>(state.range(0)))) {
+        public_keys.push_back(std::move(keys.first));
+    }
+    kem.set_batch_device(device);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kem.encapsulate_batch(public_keys));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// NTT backends
+
+void BM_ntt_forward(benchmark::State& state, SIMDSupport simd) {
+    clwe::CLWEParameters params;
+    auto engine = create_ntt_engine(simd, params.modulus, params.degree);
+    std::vector<uint32_t> input = random_poly(params);
+    std::vector<uint32_t> poly(input.size());
+    for (auto _ : state) {
+        poly = input;
+        engine->ntt_forward(poly.data());
+        benchmark::DoNotOptimize(poly.data());
+    }
+}
+
+void BM_ntt_inverse(benchmark::State& state, SIMDSupport simd) {
+    clwe::CLWEParameters params;
+    auto engine = create_ntt_engine(simd, params.modulus, params.degree);
+    std::vector<uint32_t> input = random_poly(params);
+    engine->ntt_forward(input.data());
+    std::vector<uint32_t> poly(input.size());
+    for (auto _ : state) {
+        poly = input;
+        engine->ntt_inverse(poly.data());
+        benchmark::DoNotOptimize(poly.data());
+    }
+}
+
+void BM_ntt_multiply(benchmark::State& state, SIMDSupport simd) {
+    clwe::CLWEParameters params;
+    auto engine = create_ntt_engine(simd, params.modulus, params.degree);
+    std::vector<uint32_t> a = random_poly(params);
+    std::vector<uint32_t> b = random_poly(params);
+    std::vector<uint32_t> result(params.degree);
+    for (auto _ : state) {
+        engine->multiply(a.data(), b.data(), result.data());
+        benchmark::DoNotOptimize(result.data());
+    }
+}
+
+// Pointwise products of k NTT-domain polynomials, the matrix-vector inner loop
+void BM_ntt_basemul_acc(benchmark::State& state, SIMDSupport simd) {
+    clwe::CLWEParameters params;
+    const size_t k = static_cast<size_t>(state.range(0));
+    auto engine = create_ntt_engine(simd, params.modulus, params.degree);
+    std::vector<uint32_t> poly = random_poly(params);
+    std::vector<uint32_t> a, b;
+    for (size_t j = 0; j < k; ++j) {
+        a.insert(a.end(), poly.begin(), poly.end());
+        b.insert(b.end(), poly.rbegin(), poly.rend());
+    }
+    std::vector<uint32_t> result(params.degree);
+    for (auto _ : state) {
+        engine->basemul_acc(a.data(), b.data(), k, result.data());
+        benchmark::DoNotOptimize(result.data());
+    }
+}
+
+// s^T c for a rank-3 weight-h ternary s (state.range(0) = h), against the NTT/multiply rows
+void BM_sparse_ternary_dot(benchmark::State& state) {
+    clwe::CLWEParameters params;
+    const uint32_t weight = static_cast<uint32_t>(state.range(0));
+    const uint32_t n = params.degree, rank = 3;
+    std::vector<ColorValue> s(rank * n), c(rank * n), out(n);
+    std::vector<uint32_t> keys(n), rotate_a(n), rotate_b(n);
+    std::vector<uint8_t> random(fixed_weight_random_bytes(n));
+    for (uint32_t i = 0; i < rank; ++i) {
+        for (size_t j = 0; j < random.size(); ++j) {
+            random[j] = static_cast<uint8_t>(j * 131 + i * 17);
+        }
+        sample_fixed_weight_ternary(random.data(), n, weight, params.modulus, keys.data(), s.data() + i * n);
+    }
+    std::vector<uint32_t> poly = random_poly(params);
+    for (uint32_t i = 0; i < rank * n; ++i) {
+        c[i] = ColorValue::from_math_value(poly[i % n]);
+    }
+    SparseTernaryVec sparse(rank, n, weight);
+    sparse.assign(s.data(), params.modulus);
+    for (auto _ : state) {
+        sparse_ternary_dot(sparse, c.data(), params.modulus, rotate_a.data(), rotate_b.data(), out.data());
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+
+// Coefficient-domain multipliers for a modulus q (state.range(0) = n); 3329 is NTT-friendly up
+// to n = 256 and 4099 never is
+
+void BM_poly_multiply(benchmark::State& state, MultiplierStrategy strategy, uint32_t q) {
+    const uint32_t n = static_cast<uint32_t>(state.range(0));
+    auto multiplier = create_poly_multiplier(strategy, q, n);
+    std::vector<uint32_t> a(n), b(n), result(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        a[i] = (i * 1103 + 17) % q;
+        b[i] = (i * i * 31 + 5) % q;
+    }
+    for (auto _ : state) {
+        multiplier->multiply(a.data(), b.data(), result.data());
+        benchmark::DoNotOptimize(result.data());
+    }
+}
+
+// SHAKE samplers and CBD
+
+template <typename Sampler>
+void BM_shake_squeeze(benchmark::State& state) {
+    const size_t len = static_cast<size_t>(state.range(0));
+    std::array<uint8_t, 32> seed{};
+    std::vector<uint8_t> out(len);
+    Sampler sampler;
+    for (auto _ : state) {
+        sampler.init(seed.data(), seed.size());
+        sampler.squeeze(out.data(), out.size());
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(len));
+}
+
+void BM_cbd_polynomial(benchmark::State& state) {
+    const uint32_t eta = static_cast<uint32_t>(state.range(0));
+    clwe::CLWEParameters params;
+    std::vector<uint8_t> buf(cbd_block_bytes(eta) * (params.degree / 64));
+    SHAKE256Sampler sampler;
+    std::array<uint8_t, 32> seed{};
+    sampler.init(seed.data(), seed.size());
+    sampler.squeeze(buf.data(), buf.size());
+    std::vector<uint32_t> coeffs(params.degree);
+    for (auto _ : state) {
+        cbd_blocks(coeffs.data(), buf.data(), params.degree / 64, eta, params.modulus);
+        benchmark::DoNotOptimize(coeffs.data());
+    }
+}
+
+// One polynomial's worth of SHAKE128 output through the 12-bit rejection parse
+void BM_rejection_uniform12(benchmark::State& state) {
+    clwe::CLWEParameters params;
+    std::vector<uint8_t> buf(3 * 168);
+    SHAKE128Sampler sampler;
+    std::array<uint8_t, 32> seed{};
+    sampler.init(seed.data(), seed.size());
+    sampler.squeeze(buf.data(), buf.size());
+    std::vector<uint32_t> coeffs(params.degree);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            rejection_sample_uniform12(coeffs.data(), coeffs.size(), buf.data(), buf.size(), params.modulus));
+        benchmark::DoNotOptimize(coeffs.data());
+    }
+}
+
+void BM_shake256_binomial_polynomial(benchmark::State& state) {
+    const uint32_t eta = static_cast<uint32_t>(state.range(0));
+    clwe::CLWEParameters params;
+    std::array<uint8_t, 32> seed{};
+    std::vector<uint32_t> coeffs(params.degree);
+    SHAKE256Sampler sampler;
+    for (auto _ : state) {
+        sampler.init(seed.data(), seed.size());
+        sampler.sample_polynomial_binomial(coeffs.data(), coeffs.size(), eta, params.modulus);
+        benchmark::DoNotOptimize(coeffs.data());
+    }
+}
+
+// Keccak backends: single SHAKE streams and four-lane matrix expansion
+
+template <typename Sampler>
+void BM_keccak_stream(benchmark::State& state, KeccakBackend backend) {
+    const KeccakBackend saved = keccak_backend();
+    set_keccak_backend(backend);
+    BM_shake_squeeze<Sampler>(state);
+    set_keccak_backend(saved);
+}
+
+void BM_keccak_x4(benchmark::State& state, KeccakBackend backend) {
+    const KeccakBackend saved = keccak_backend();
+    set_keccak_backend(backend);
+    const size_t nblocks = static_cast<size_t>(state.range(0));
+    std::array<std::array<uint8_t, 34>, 4> seeds{};
+    std::vector<uint8_t> out(4 * nblocks * SHAKE128_RATE);
+    const uint8_t* seed_ptrs[4] = {seeds[0].data(), seeds[1].data(), seeds[2].data(), seeds[3].data()};
+    uint8_t* out_ptrs[4];
+    for (size_t lane = 0; lane < 4; ++lane) {
+        seeds[lane][0] = static_cast<uint8_t>(lane);
+        out_ptrs[lane] = out.data() + lane * nblocks * SHAKE128_RATE;
+    }
+    SHAKE128x4Sampler sampler;
+    for (auto _ : state) {
+        sampler.init_x4(seed_ptrs, seeds[0].size());
+        sampler.squeeze_blocks_x4(out_ptrs, nblocks);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(out.size()));
+    set_keccak_backend(saved);
+}
+
+// AES-256-CTR keystream per backend, the AES256_CTR counterpart of Keccak/shake128x4
+
+void BM_aes_keystream(benchmark::State& state, AESBackend backend) {
+    const size_t blocks = static_cast<size_t>(state.range(0));
+    std::array<uint8_t, AES256CTR::KEY_BYTES> key{};
+    AES256CTR aes(key.data());
+    std::vector<uint8_t> out(blocks * AES256CTR::BLOCK_BYTES);
+    for (auto _ : state) {
+        aes.keystream(0, 0, out.data(), blocks, backend);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(out.size()));
+}
+
+// Serialization
+
+void BM_public_key_serialize(benchmark::State& state, uint32_t level) {
+    ColorKEM kem{clwe::CLWEParameters(level)};
+    auto keys = kem.keygen();
+    std::vector<uint8_t> out(ColorPublicKey::serialized_size(keys.first.params));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(keys.first.serialize(out.data(), out.size()));
+    }
+}
+
+void BM_public_key_deserialize(benchmark::State& state, uint32_t level) {
+    clwe::CLWEParameters params(level);
+    ColorKEM kem(params);
+    std::vector<uint8_t> bytes = kem.keygen().first.serialize();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ColorPublicKey::deserialize(bytes, params));
+    }
+}
+
+void BM_ciphertext_serialize(benchmark::State& state, uint32_t level) {
+    ColorKEM kem{clwe::CLWEParameters(level)};
+    auto ciphertext = kem.encapsulate(kem.keygen().first).first;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ciphertext.serialize());
+    }
+}
+
+void BM_ciphertext_deserialize(benchmark::State& state, uint32_t level) {
+    clwe::CLWEParameters params(level);
+    ColorKEM kem(params);
+    std::vector<uint8_t> bytes = kem.encapsulate(kem.keygen().first).first.serialize();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ColorCiphertext::deserialize(bytes, params));
+    }
+}
+
+void register_benchmarks() {
+    for (uint32_t level : kSecurityLevels) {
+        const std::string suffix = "/" + std::to_string(level);
+        benchmark::RegisterBenchmark(("ColorKEM/keygen" + suffix).c_str(), BM_keygen, level, XofAlgorithm::SHAKE128);
+        benchmark::RegisterBenchmark(("ColorKEM/encapsulate" + suffix).c_str(), BM_encapsulate, level,
+                                     XofAlgorithm::SHAKE128);
+        benchmark::RegisterBenchmark(("ColorKEM/decapsulate" + suffix).c_str(), BM_decapsulate, level,
+                                     XofAlgorithm::SHAKE128);
+        // The Kyber-90s style sets against the SHAKE rows above, on the dispatched AES backend
+        const std::string aes_suffix = suffix + "/" + xof_name(XofAlgorithm::AES256_CTR);
+        benchmark::RegisterBenchmark(("ColorKEM/keygen" + aes_suffix).c_str(), BM_keygen, level,
+                                     XofAlgorithm::AES256_CTR);
+        benchmark::RegisterBenchmark(("ColorKEM/encapsulate" + aes_suffix).c_str(), BM_encapsulate, level,
+                                     XofAlgorithm::AES256_CTR);
+        benchmark::RegisterBenchmark(("ColorKEM/decapsulate" + aes_suffix).c_str(), BM_decapsulate, level,
+                                     XofAlgorithm::AES256_CTR);
+        benchmark::RegisterBenchmark(("ColorKEM/decapsulate_prepared" + suffix).c_str(), BM_decapsulate_prepared,
+                                     level, 0u);
+        for (uint32_t weight : {64u, 128u}) {
+            benchmark::RegisterBenchmark(
+                ("ColorKEM/decapsulate_prepared" + suffix + "/ternary" + std::to_string(weight)).c_str(),
+                BM_decapsulate_prepared, level, weight);
+        }
+        benchmark::RegisterBenchmark(("Serialize/public_key" + suffix).c_str(), BM_public_key_serialize, level);
+        benchmark::RegisterBenchmark(("Deserialize/public_key" + suffix).c_str(), BM_public_key_deserialize, level);
+        benchmark::RegisterBenchmark(("Serialize/ciphertext" + suffix).c_str(), BM_ciphertext_serialize, level);
+        benchmark::RegisterBenchmark(("Deserialize/ciphertext" + suffix).c_str(), BM_ciphertext_deserialize, level);
+        for (BatchDevice device : {BatchDevice::Cpu, BatchDevice::Cuda}) {
+            if (!batch_device_available(device)) {
+                continue;
+            }
+            const std::string batch_suffix = suffix + "/" + batch_device_name(device);
+            benchmark::RegisterBenchmark(("ColorKEM/keygen_batch" + batch_suffix).c_str(), BM_keygen_batch, level,
+                                         device)->Arg(4096);
+            benchmark::RegisterBenchmark(("ColorKEM/encapsulate_batch" + batch_suffix).c_str(),
+                                         BM_encapsulate_batch, level, device)->Arg(4096);
+        }
+    }
+
+    for (SIMDSupport simd : available_ntt_backends()) {
+        const std::string suffix = std::string("/") + ntt_backend_name(simd);
+        benchmark::RegisterBenchmark(("NTT/forward" + suffix).c_str(), BM_ntt_forward, simd);
+        benchmark::RegisterBenchmark(("NTT/inverse" + suffix).c_str(), BM_ntt_inverse, simd);
+        benchmark::RegisterBenchmark(("NTT/multiply" + suffix).c_str(), BM_ntt_multiply, simd);
+        benchmark::RegisterBenchmark(("NTT/basemul_acc" + suffix).c_str(), BM_ntt_basemul_acc, simd)
+            ->Arg(2)->Arg(3)->Arg(4);
+    }
+    benchmark::RegisterBenchmark("SparseTernary/dot", BM_sparse_ternary_dot)->Arg(32)->Arg(64)->Arg(128);
+
+    for (MultiplierStrategy strategy : {MultiplierStrategy::Schoolbook, MultiplierStrategy::Karatsuba,
+                                        MultiplierStrategy::NTT, MultiplierStrategy::MultiModularNTT}) {
+        for (uint32_t q : {3329u, 4099u}) {
+            std::vector<int64_t> degrees;
+            for (uint32_t n = 16; n <= 4096; n *= 2) {
+                if (strategy != MultiplierStrategy::NTT || ntt_friendly(q, n)) {
+                    degrees.push_back(n);
+                }
+            }
+            if (degrees.empty()) {
+                continue;
+            }
+            const std::string name =
+                std::string("PolyMul/") + multiplier_strategy_name(strategy) + "/" + std::to_string(q);
+            benchmark::RegisterBenchmark(name.c_str(), BM_poly_multiply, strategy, q)->ArgsProduct({degrees});
+        }
+    }
+
+    benchmark::RegisterBenchmark("SHAKE128/squeeze", BM_shake_squeeze<SHAKE128Sampler>)->Arg(168)->Arg(4096);
+    benchmark::RegisterBenchmark("SHAKE256/squeeze", BM_shake_squeeze<SHAKE256Sampler>)->Arg(136)->Arg(4096);
+    for (KeccakBackend keccak : available_keccak_backends()) {
+        const std::string suffix = std::string("/") + keccak_backend_name(keccak);
+        benchmark::RegisterBenchmark(("Keccak/shake128" + suffix).c_str(), BM_keccak_stream<SHAKE128Sampler>, keccak)
+            ->Arg(4096);
+        benchmark::RegisterBenchmark(("Keccak/shake256" + suffix).c_str(), BM_keccak_stream<SHAKE256Sampler>, keccak)
+            ->Arg(4096);
+        benchmark::RegisterBenchmark(("Keccak/shake128x4" + suffix).c_str(), BM_keccak_x4, keccak)->Arg(3);
+    }
+    for (AESBackend aes : available_aes_backends()) {
+        // 126 blocks: the 2016 bytes of Keccak/shake128x4, four lanes of three SHAKE-128 blocks
+        benchmark::RegisterBenchmark((std::string("AES/ctr/") + aes_backend_name(aes)).c_str(), BM_aes_keystream, aes)
+            ->Arg(126);
+    }
+    benchmark::RegisterBenchmark("CBD/blocks", BM_cbd_polynomial)->Arg(2)->Arg(3);
+    benchmark::RegisterBenchmark("Rejection/uniform12", BM_rejection_uniform12);
+    benchmark::RegisterBenchmark("CBD/shake256_polynomial", BM_shake256_binomial_polynomial)->Arg(2)->Arg(3);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    register_benchmarks();
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "clwe/kem_daemon.hpp"
+
+// Host-wide KEM service: clients connect with clwe::KemClient and submit requests through
+// shared-memory rings. Runs until SIGINT or SIGTERM.
+
+namespace {
+
+clwe::KemDaemon* running_daemon = nullptr;
+
+void handle_signal(int) {
+    if (running_daemon != nullptr) {
+        running_daemon->stop();
+    }
+}
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program
+              << " [--socket=PATH] [--mode=OCTAL] [--slots=N] [--max-slots=N] [--max-batch=N] [--max-clients=N]"
+              << std::endl;
+}
+
+bool parse_size(const std::string& arg, const char* prefix, size_t& value) {
+    const std::string option(prefix);
+    if (arg.rfind(option, 0) != 0) {
+        return false;
+    }
+    value = std::strtoull(arg.c_str() + option.size(), nullptr, 10);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    clwe::KemDaemonConfig config;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--socket=", 0) == 0) {
+            config.socket_path = arg.substr(9);
+        } else if (arg.rfind("--mode=", 0) == 0) {
+            config.socket_mode = static_cast<uint32_t>(std::strtoul(arg.c_str() + 7, nullptr, 8));
+        } else if (!parse_size(arg, "--slots=", config.ring_slots) &&
+                   !parse_size(arg, "--max-slots=", config.max_ring_slots) &&
+                   !parse_size(arg, "--max-batch=", config.max_batch) &&
+                   !parse_size(arg, "--max-clients=", config.max_clients)) {
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+
+    try {
+        clwe::KemDaemon daemon(config);
+        running_daemon = &daemon;
+        std::signal(SIGINT, handle_signal);
+        std::signal(SIGTERM, handle_signal);
+        std::cout << "clwe-kemd listening on " << daemon.socket_path() << std::endl;
+        daemon.run();
+        running_daemon = nullptr;
+        std::cout << "clwe-kemd served " << daemon.requests_served() << " requests" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "clwe-kemd: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
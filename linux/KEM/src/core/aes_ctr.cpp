@@ -0,0 +1,433 @@
+#include "aes_ctr.hpp"
+#include "cpu_features.hpp"
+#include "simd_target.hpp"
+#include "utils.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#ifdef HAVE_AES_NI
+#include <immintrin.h>
+#endif
+#ifdef HAVE_ARM_AES
+#include <arm_neon.h>
+#endif
+
+namespace clwe {
+
+namespace {
+
+// The portable S-box works on eight bytes packed into a word, with no table and no
+// secret-dependent branch: the key schedule of a noise PRF key runs through it too
+
+constexpr uint64_t BYTE_ONES = 0x0101010101010101ULL;
+
+uint64_t xtime_bytes(uint64_t x) {
+    return ((x & (BYTE_ONES * 0x7F)) << 1) ^ (((x >> 7) & BYTE_ONES) * 0x1B);
+}
+
+uint64_t gf_mul_bytes(uint64_t a, uint64_t b) {
+    uint64_t r = 0;
+    for (int bit = 0; bit < 8; ++bit) {
+        r ^= a & (((b >> bit) & BYTE_ONES) * 0xFF);
+        a = xtime_bytes(a);
+    }
+    return r;
+}
+
+uint64_t rotl_bytes(uint64_t x, int k) {
+    return ((x & (BYTE_ONES * (0xFFu >> k))) << k) | ((x >> (8 - k)) & (BYTE_ONES * ((1u << k) - 1)));
+}
+
+// SubBytes of eight bytes: the inverse x^254 (0 for 0), then the FIPS-197 affine map
+uint64_t sub_bytes_word(uint64_t x) {
+    uint64_t x2 = gf_mul_bytes(x, x);
+    uint64_t x3 = gf_mul_bytes(x2, x);
+    uint64_t x7 = gf_mul_bytes(gf_mul_bytes(x3, x3), x);
+    uint64_t x56 = gf_mul_bytes(x7, x7);
+    x56 = gf_mul_bytes(x56, x56);
+    x56 = gf_mul_bytes(x56, x56);
+    uint64_t x63 = gf_mul_bytes(x56, x7);
+    uint64_t x127 = gf_mul_bytes(gf_mul_bytes(x63, x63), x);
+    uint64_t inv = gf_mul_bytes(x127, x127);
+    return inv ^ rotl_bytes(inv, 1) ^ rotl_bytes(inv, 2) ^ rotl_bytes(inv, 3) ^ rotl_bytes(inv, 4) ^
+           (BYTE_ONES * 0x63);
+}
+
+void sub_bytes(uint8_t* bytes, size_t count) {
+    uint64_t word = 0;
+    std::memcpy(&word, bytes, count);
+    word = sub_bytes_word(word);
+    std::memcpy(bytes, &word, count);
+}
+
+uint8_t xtime(uint8_t b) {
+    return static_cast<uint8_t>((b << 1) ^ (0x1B & (0u - (b >> 7))));
+}
+
+// SubWord of a key schedule word held little-endian (byte 0 in the low bits)
+uint32_t sub_word_portable(uint32_t word) {
+    return static_cast<uint32_t>(sub_bytes_word(word));
+}
+
+// FIPS-197 KeyExpansion with Nk = 8: 60 words, four per round key
+template <typename SubWord>
+void expand_key(const uint8_t key[AES256CTR::KEY_BYTES], uint8_t round_keys[AES256CTR::ROUNDS + 1][16],
+                SubWord sub_word) {
+    uint32_t words[4 * (AES256CTR::ROUNDS + 1)];
+    for (size_t i = 0; i < 8; ++i) {
+        words[i] = static_cast<uint32_t>(key[4 * i]) | (static_cast<uint32_t>(key[4 * i + 1]) << 8) |
+                   (static_cast<uint32_t>(key[4 * i + 2]) << 16) | (static_cast<uint32_t>(key[4 * i + 3]) << 24);
+    }
+    uint8_t rcon = 1;
+    for (size_t i = 8; i < 4 * (AES256CTR::ROUNDS + 1); ++i) {
+        uint32_t temp = words[i - 1];
+        if (i % 8 == 0) {
+            temp = sub_word((temp >> 8) | (temp << 24)) ^ rcon;  // RotWord moves byte 1 to byte 0
+            rcon = xtime(rcon);
+        } else if (i % 8 == 4) {
+            temp = sub_word(temp);
+        }
+        words[i] = words[i - 8] ^ temp;
+    }
+    for (size_t i = 0; i < 4 * (AES256CTR::ROUNDS + 1); ++i) {
+        for (size_t b = 0; b < 4; ++b) {
+            round_keys[i / 4][4 * (i % 4) + b] = static_cast<uint8_t>(words[i] >> (8 * b));
+        }
+    }
+    secure_zero(words, sizeof(words));
+}
+
+// State bytes are column-major, byte r + 4c at row r of column c
+void encrypt_block_portable(const uint8_t round_keys[AES256CTR::ROUNDS + 1][16], const uint8_t in[16],
+                            uint8_t out[16]) {
+    uint8_t state[16];
+    for (int i = 0; i < 16; ++i) {
+        state[i] = in[i] ^ round_keys[0][i];
+    }
+    for (size_t round = 1; round <= AES256CTR::ROUNDS; ++round) {
+        sub_bytes(state, 8);
+        sub_bytes(state + 8, 8);
+
+        uint8_t shifted[16];
+        for (int c = 0; c < 4; ++c) {
+            for (int r = 0; r < 4; ++r) {
+                shifted[r + 4 * c] = state[r + 4 * ((c + r) % 4)];
+            }
+        }
+
+        if (round == AES256CTR::ROUNDS) {
+            std::memcpy(state, shifted, sizeof(state));
+        } else {
+            for (int c = 0; c < 4; ++c) {
+                const uint8_t* a = shifted + 4 * c;
+                uint8_t all = a[0] ^ a[1] ^ a[2] ^ a[3];
+                for (int r = 0; r < 4; ++r) {
+                    state[r + 4 * c] = a[r] ^ all ^ xtime(a[r] ^ a[(r + 1) % 4]);
+                }
+            }
+        }
+        for (int i = 0; i < 16; ++i) {
+            state[i] ^= round_keys[round][i];
+        }
+    }
+    std::memcpy(out, state, sizeof(state));
+    secure_zero(state, sizeof(state));
+}
+
+void counter_block(uint64_t nonce, uint32_t block, uint8_t out[16]) {
+    for (int i = 0; i < 8; ++i) {
+        out[i] = static_cast<uint8_t>(nonce >> (8 * i));
+    }
+    out[8] = out[9] = out[10] = out[11] = 0;
+    out[12] = static_cast<uint8_t>(block >> 24);
+    out[13] = static_cast<uint8_t>(block >> 16);
+    out[14] = static_cast<uint8_t>(block >> 8);
+    out[15] = static_cast<uint8_t>(block);
+}
+
+void keystream_portable(const uint8_t round_keys[AES256CTR::ROUNDS + 1][16], uint64_t nonce, uint32_t first_block,
+                        uint8_t* out, size_t blocks) {
+    uint8_t input[16];
+    for (size_t b = 0; b < blocks; ++b) {
+        counter_block(nonce, first_block + static_cast<uint32_t>(b), input);
+        encrypt_block_portable(round_keys, input, out + 16 * b);
+    }
+}
+
+#ifdef HAVE_AES_NI
+uint32_t byteswap32(uint32_t x) {
+    return (x >> 24) | ((x >> 8) & 0xFF00) | ((x << 8) & 0xFF0000) | (x << 24);
+}
+
+// One even (assist = AESKEYGENASSIST of the previous odd key, word 3) or odd (word 2)
+// AES-256 round key from the one two rounds back
+CLWE_TARGET_AES __m128i next_round_key(__m128i previous, __m128i assist) {
+    previous = _mm_xor_si128(previous, _mm_slli_si128(previous, 4));
+    previous = _mm_xor_si128(previous, _mm_slli_si128(previous, 4));
+    previous = _mm_xor_si128(previous, _mm_slli_si128(previous, 4));
+    return _mm_xor_si128(previous, assist);
+}
+
+CLWE_TARGET_AES void expand_key_aesni(const uint8_t key[AES256CTR::KEY_BYTES],
+                                      uint8_t round_keys[AES256CTR::ROUNDS + 1][16]) {
+    __m128i rk[AES256CTR::ROUNDS + 1];
+    rk[0] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key));
+    rk[1] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key + 16));
+    // AESKEYGENASSIST takes the round constant as an immediate
+#define CLWE_AES256_ROUND_KEYS(i, rcon)                                                                       \
+    rk[i] = next_round_key(rk[i - 2], _mm_shuffle_epi32(_mm_aeskeygenassist_si128(rk[i - 1], rcon), 0xFF)); \
+    rk[i + 1] = next_round_key(rk[i - 1], _mm_shuffle_epi32(_mm_aeskeygenassist_si128(rk[i], 0), 0xAA));
+    CLWE_AES256_ROUND_KEYS(2, 0x01)
+    CLWE_AES256_ROUND_KEYS(4, 0x02)
+    CLWE_AES256_ROUND_KEYS(6, 0x04)
+    CLWE_AES256_ROUND_KEYS(8, 0x08)
+    CLWE_AES256_ROUND_KEYS(10, 0x10)
+    CLWE_AES256_ROUND_KEYS(12, 0x20)
+    rk[14] = next_round_key(rk[12], _mm_shuffle_epi32(_mm_aeskeygenassist_si128(rk[13], 0x40), 0xFF));
+#undef CLWE_AES256_ROUND_KEYS
+    for (size_t r = 0; r <= AES256CTR::ROUNDS; ++r) {
+        _mm_store_si128(reinterpret_cast<__m128i*>(round_keys[r]), rk[r]);
+    }
+}
+
+// Eight independent blocks per pass keep the AES unit's pipeline full
+CLWE_TARGET_AES void keystream_aesni(const uint8_t round_keys[AES256CTR::ROUNDS + 1][16], uint64_t nonce,
+                                     uint32_t first_block, uint8_t* out, size_t blocks) {
+    __m128i rk[AES256CTR::ROUNDS + 1];
+    for (size_t r = 0; r <= AES256CTR::ROUNDS; ++r) {
+        rk[r] = _mm_load_si128(reinterpret_cast<const __m128i*>(round_keys[r]));
+    }
+    const int lo = static_cast<int>(static_cast<uint32_t>(nonce));
+    const int hi = static_cast<int>(static_cast<uint32_t>(nonce >> 32));
+
+    size_t b = 0;
+    for (; b + 8 <= blocks; b += 8) {
+        __m128i s[8];
+        for (int j = 0; j < 8; ++j) {
+            const uint32_t counter = first_block + static_cast<uint32_t>(b + j);
+            s[j] = _mm_xor_si128(_mm_set_epi32(static_cast<int>(byteswap32(counter)), 0, hi, lo), rk[0]);
+        }
+        for (size_t r = 1; r < AES256CTR::ROUNDS; ++r) {
+            for (int j = 0; j < 8; ++j) {
+                s[j] = _mm_aesenc_si128(s[j], rk[r]);
+            }
+        }
+        for (int j = 0; j < 8; ++j) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16 * (b + j)),
+                             _mm_aesenclast_si128(s[j], rk[AES256CTR::ROUNDS]));
+        }
+    }
+    for (; b < blocks; ++b) {
+        const uint32_t counter = first_block + static_cast<uint32_t>(b);
+        __m128i s = _mm_xor_si128(_mm_set_epi32(static_cast<int>(byteswap32(counter)), 0, hi, lo), rk[0]);
+        for (size_t r = 1; r < AES256CTR::ROUNDS; ++r) {
+            s = _mm_aesenc_si128(s, rk[r]);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16 * b), _mm_aesenclast_si128(s, rk[AES256CTR::ROUNDS]));
+    }
+}
+#endif
+
+#if defined(HAVE_AES_NI) && defined(HAVE_VAES)
+// Four YMM registers of two blocks each; the tail goes through AES-NI, which VAES implies
+CLWE_TARGET_VAES void keystream_vaes(const uint8_t round_keys[AES256CTR::ROUNDS + 1][16], uint64_t nonce,
+                                     uint32_t first_block, uint8_t* out, size_t blocks) {
+    __m256i rk[AES256CTR::ROUNDS + 1];
+    for (size_t r = 0; r <= AES256CTR::ROUNDS; ++r) {
+        rk[r] = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(round_keys[r])));
+    }
+    const int lo = static_cast<int>(static_cast<uint32_t>(nonce));
+    const int hi = static_cast<int>(static_cast<uint32_t>(nonce >> 32));
+
+    size_t b = 0;
+    for (; b + 8 <= blocks; b += 8) {
+        __m256i s[4];
+        for (int j = 0; j < 4; ++j) {
+            const uint32_t counter = first_block + static_cast<uint32_t>(b + 2 * j);
+            s[j] = _mm256_xor_si256(_mm256_set_epi32(static_cast<int>(byteswap32(counter + 1)), 0, hi, lo,
+                                                     static_cast<int>(byteswap32(counter)), 0, hi, lo),
+                                    rk[0]);
+        }
+        for (size_t r = 1; r < AES256CTR::ROUNDS; ++r) {
+            for (int j = 0; j < 4; ++j) {
+                s[j] = _mm256_aesenc_epi128(s[j], rk[r]);
+            }
+        }
+        for (int j = 0; j < 4; ++j) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 16 * (b + 2 * j)),
+                                _mm256_aesenclast_epi128(s[j], rk[AES256CTR::ROUNDS]));
+        }
+    }
+    if (b < blocks) {
+        keystream_aesni(round_keys, nonce, first_block + static_cast<uint32_t>(b), out + 16 * b, blocks - b);
+    }
+}
+#endif
+
+#ifdef HAVE_ARM_AES
+// AESE with a zero key is SubBytes then ShiftRows, and ShiftRows leaves a word copied into
+// every column where it was
+CLWE_TARGET_ARM_AES uint32_t sub_word_arm(uint32_t word) {
+    uint8x16_t state = vaeseq_u8(vreinterpretq_u8_u32(vdupq_n_u32(word)), vdupq_n_u8(0));
+    return vgetq_lane_u32(vreinterpretq_u32_u8(state), 0);
+}
+
+// AESE does AddRoundKey, SubBytes and ShiftRows; AESMC the MixColumns of the same round
+CLWE_TARGET_ARM_AES void keystream_arm(const uint8_t round_keys[AES256CTR::ROUNDS + 1][16], uint64_t nonce,
+                                       uint32_t first_block, uint8_t* out, size_t blocks) {
+    uint8x16_t rk[AES256CTR::ROUNDS + 1];
+    for (size_t r = 0; r <= AES256CTR::ROUNDS; ++r) {
+        rk[r] = vld1q_u8(round_keys[r]);
+    }
+    uint8_t input[16];
+    size_t b = 0;
+    for (; b + 8 <= blocks; b += 8) {
+        uint8x16_t s[8];
+        for (int j = 0; j < 8; ++j) {
+            counter_block(nonce, first_block + static_cast<uint32_t>(b + j), input);
+            s[j] = vld1q_u8(input);
+        }
+        for (size_t r = 0; r + 1 < AES256CTR::ROUNDS; ++r) {
+            for (int j = 0; j < 8; ++j) {
+                s[j] = vaesmcq_u8(vaeseq_u8(s[j], rk[r]));
+            }
+        }
+        for (int j = 0; j < 8; ++j) {
+            s[j] = veorq_u8(vaeseq_u8(s[j], rk[AES256CTR::ROUNDS - 1]), rk[AES256CTR::ROUNDS]);
+            vst1q_u8(out + 16 * (b + j), s[j]);
+        }
+    }
+    for (; b < blocks; ++b) {
+        counter_block(nonce, first_block + static_cast<uint32_t>(b), input);
+        uint8x16_t s = vld1q_u8(input);
+        for (size_t r = 0; r + 1 < AES256CTR::ROUNDS; ++r) {
+            s = vaesmcq_u8(vaeseq_u8(s, rk[r]));
+        }
+        vst1q_u8(out + 16 * b, veorq_u8(vaeseq_u8(s, rk[AES256CTR::ROUNDS - 1]), rk[AES256CTR::ROUNDS]));
+    }
+}
+#endif
+
+AESBackend default_aes_backend() {
+    static const AESBackend backend = available_aes_backends().front();
+    return backend;
+}
+
+} // namespace
+
+bool aes_backend_available(AESBackend backend) {
+    const CPUFeatures& cpu = CPUFeatureDetector::cached();
+    switch (backend) {
+        case AESBackend::Portable:
+            return true;
+        case AESBackend::AesNi:
+#ifdef HAVE_AES_NI
+            return cpu.has_aes;
+#else
+            return false;
+#endif
+        case AESBackend::Vaes:
+#if defined(HAVE_AES_NI) && defined(HAVE_VAES)
+            return cpu.has_vaes;
+#else
+            return false;
+#endif
+        case AESBackend::ArmCrypto:
+#ifdef HAVE_ARM_AES
+            return cpu.has_aes;
+#else
+            return false;
+#endif
+    }
+    (void)cpu;
+    return false;
+}
+
+std::vector<AESBackend> available_aes_backends() {
+    std::vector<AESBackend> backends;
+    for (AESBackend backend : {AESBackend::Vaes, AESBackend::AesNi, AESBackend::ArmCrypto, AESBackend::Portable}) {
+        if (aes_backend_available(backend)) {
+            backends.push_back(backend);
+        }
+    }
+    return backends;
+}
+
+const char* aes_backend_name(AESBackend backend) {
+    switch (backend) {
+        case AESBackend::Portable: return "portable";
+        case AESBackend::AesNi: return "aesni";
+        case AESBackend::Vaes: return "vaes";
+        case AESBackend::ArmCrypto: return "armv8";
+    }
+    return "unknown";
+}
+
+AES256CTR::~AES256CTR() {
+    secure_zero(round_keys_, sizeof(round_keys_));
+}
+
+void AES256CTR::set_key(const uint8_t key[KEY_BYTES]) {
+    // A schedule per matrix group and noise seed: on the portable S-box it would cost as
+    // much as the blocks it serves, so the AES instructions compute it where they exist
+#ifdef HAVE_AES_NI
+    if (aes_backend_available(AESBackend::AesNi)) {
+        expand_key_aesni(key, round_keys_);
+        return;
+    }
+#endif
+#ifdef HAVE_ARM_AES
+    if (aes_backend_available(AESBackend::ArmCrypto)) {
+        expand_key(key, round_keys_, sub_word_arm);
+        return;
+    }
+#endif
+    expand_key(key, round_keys_, sub_word_portable);
+}
+
+void AES256CTR::keystream(uint64_t nonce, uint32_t first_block, uint8_t* out, size_t blocks) const {
+    keystream(nonce, first_block, out, blocks, default_aes_backend());
+}
+
+void AES256CTR::keystream(uint64_t nonce, uint32_t first_block, uint8_t* out, size_t blocks,
+                          AESBackend backend) const {
+    switch (backend) {
+#if defined(HAVE_AES_NI) && defined(HAVE_VAES)
+        case AESBackend::Vaes:
+            if (aes_backend_available(backend)) {
+                keystream_vaes(round_keys_, nonce, first_block, out, blocks);
+                return;
+            }
+            break;
+#endif
+#ifdef HAVE_AES_NI
+        case AESBackend::AesNi:
+            if (aes_backend_available(backend)) {
+                keystream_aesni(round_keys_, nonce, first_block, out, blocks);
+                return;
+            }
+            break;
+#endif
+#ifdef HAVE_ARM_AES
+        case AESBackend::ArmCrypto:
+            if (aes_backend_available(backend)) {
+                keystream_arm(round_keys_, nonce, first_block, out, blocks);
+                return;
+            }
+            break;
+#endif
+        case AESBackend::Portable:
+            keystream_portable(round_keys_, nonce, first_block, out, blocks);
+            return;
+        default:
+            break;
+    }
+    throw std::invalid_argument(std::string("AES backend not available: ") + aes_backend_name(backend));
+}
+
+void AES256CTR::encrypt_block(const uint8_t in[BLOCK_BYTES], uint8_t out[BLOCK_BYTES]) const {
+    encrypt_block_portable(round_keys_, in, out);
+}
+
+} // namespace clwe
@@ -0,0 +1,62 @@
+#ifndef AES_CTR_HPP
+#define AES_CTR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace clwe {
+
+// AES implementation behind AES256CTR::keystream. Every backend produces the same bytes.
+enum class AESBackend {
+    Portable,  // Table-free, constant-time C++ (S-box as a GF(2^8) inverse); slow but safe
+    AesNi,     // AES-NI, eight blocks in flight
+    Vaes,      // VAES on 256-bit registers, two blocks per instruction
+    ArmCrypto  // ARMv8 Crypto AESE/AESMC
+};
+
+// Built in and reported by CPUFeatureDetector::cached(); Portable always is
+bool aes_backend_available(AESBackend backend);
+
+// Available backends, fastest first; keystream() without a backend uses the first
+std::vector<AESBackend> available_aes_backends();
+
+// "portable", "aesni", "vaes" or "armv8"
+const char* aes_backend_name(AESBackend backend);
+
+// AES-256 in counter mode, the XOF and PRF of XofAlgorithm::AES256_CTR parameter sets.
+// Block b of the stream under nonce is AES-256 of nonce as 8 little-endian bytes, four
+// zero bytes and b as 4 big-endian bytes: the Kyber-90s layout, whose 12-byte nonces
+// only ever use their first two bytes. The key schedule is wiped on destruction.
+class AES256CTR {
+public:
+    static constexpr size_t KEY_BYTES = 32;
+    static constexpr size_t BLOCK_BYTES = 16;
+    static constexpr size_t ROUNDS = 14;
+
+    AES256CTR() = default;
+    explicit AES256CTR(const uint8_t key[KEY_BYTES]) { set_key(key); }
+    ~AES256CTR();
+    AES256CTR(const AES256CTR&) = delete;
+    AES256CTR& operator=(const AES256CTR&) = delete;
+
+    // Expands key into the round keys, in constant time
+    void set_key(const uint8_t key[KEY_BYTES]);
+
+    // blocks blocks of the stream under nonce, from block first_block on; the 32-bit
+    // block counter wraps. Uses available_aes_backends().front()
+    void keystream(uint64_t nonce, uint32_t first_block, uint8_t* out, size_t blocks) const;
+
+    // Same on the given backend; throws std::invalid_argument if it is not available
+    void keystream(uint64_t nonce, uint32_t first_block, uint8_t* out, size_t blocks, AESBackend backend) const;
+
+    // One AES-256 block encryption on the portable path, for known-answer tests
+    void encrypt_block(const uint8_t in[BLOCK_BYTES], uint8_t out[BLOCK_BYTES]) const;
+
+private:
+    alignas(16) uint8_t round_keys_[ROUNDS + 1][BLOCK_BYTES] = {};
+};
+
+} // namespace clwe
+
+#endif // AES_CTR_HPP
@@ -0,0 +1,131 @@
+// Replacement global operator new/delete that feed AllocationTracker. Built as the
+// clwe_alloc_hooks object library so only executables that link it are affected.
+#include "allocation_tracker.hpp"
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+
+namespace {
+
+// Runs at static initialization of any executable that links the hooks
+const bool hooks_registered = (clwe::AllocationTracker::mark_hooks_installed(), true);
+
+void* tracked_allocate(size_t size) noexcept {
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (p != nullptr) {
+        clwe::AllocationTracker::record_allocation(size, malloc_usable_size(p));
+    }
+    return p;
+}
+
+// aligned_alloc wants a size that is a multiple of the alignment
+void* tracked_allocate_aligned(size_t size, std::align_val_t alignment) noexcept {
+    const size_t align = static_cast<size_t>(alignment);
+    const size_t rounded = ((size == 0 ? 1 : size) + align - 1) / align * align;
+    void* p = std::aligned_alloc(align, rounded);
+    if (p != nullptr) {
+        clwe::AllocationTracker::record_allocation(size, malloc_usable_size(p));
+    }
+    return p;
+}
+
+void tracked_free(void* p) noexcept {
+    if (p != nullptr) {
+        clwe::AllocationTracker::record_deallocation(malloc_usable_size(p));
+        std::free(p);
+    }
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+    if (void* p = tracked_allocate(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    if (void* p = tracked_allocate(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return tracked_allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return tracked_allocate(size);
+}
+
+void operator delete(void* p) noexcept {
+    tracked_free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    tracked_free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    tracked_free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    tracked_free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    tracked_free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    tracked_free(p);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    if (void* p = tracked_allocate_aligned(size, alignment)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+    if (void* p = tracked_allocate_aligned(size, alignment)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return tracked_allocate_aligned(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return tracked_allocate_aligned(size, alignment);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    tracked_free(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept {
+    tracked_free(p);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept {
+    tracked_free(p);
+}
+
+void operator delete[](void* p, size_t, std::align_val_t) noexcept {
+    tracked_free(p);
+}
+
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    tracked_free(p);
+}
+
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    tracked_free(p);
+}
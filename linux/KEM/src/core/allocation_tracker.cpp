@@ -0,0 +1,76 @@
+#include "allocation_tracker.hpp"
+#include "slow_operations.hpp"
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+
+namespace clwe {
+
+namespace {
+
+// Constant-initialized, so the hooks may use them before static constructors run
+std::atomic<bool> hooks_linked{false};
+std::atomic<bool> tracking{false};
+std::atomic<size_t> allocation_count{0};
+std::atomic<size_t> requested_bytes{0};
+std::atomic<int64_t> live_bytes{0};
+std::atomic<int64_t> peak_bytes{0};
+
+} // namespace
+
+AllocationTracker::AllocationTracker() {
+    allocation_count.store(0, std::memory_order_relaxed);
+    requested_bytes.store(0, std::memory_order_relaxed);
+    live_bytes.store(0, std::memory_order_relaxed);
+    peak_bytes.store(0, std::memory_order_relaxed);
+
+    bool expected = false;
+    if (!tracking.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+        throw std::logic_error("Another AllocationTracker is already active");
+    }
+}
+
+AllocationTracker::~AllocationTracker() {
+    tracking.store(false, std::memory_order_release);
+}
+
+AllocationStats AllocationTracker::stats() const {
+    AllocationStats stats;
+    stats.allocations = allocation_count.load(std::memory_order_relaxed);
+    stats.bytes_allocated = requested_bytes.load(std::memory_order_relaxed);
+    stats.peak_live_bytes = static_cast<size_t>(peak_bytes.load(std::memory_order_relaxed));
+    return stats;
+}
+
+bool AllocationTracker::hooks_installed() {
+    return hooks_linked.load(std::memory_order_relaxed);
+}
+
+void AllocationTracker::mark_hooks_installed() noexcept {
+    hooks_linked.store(true, std::memory_order_relaxed);
+}
+
+void AllocationTracker::record_allocation(size_t requested, size_t usable) noexcept {
+    count_slow_operation_heap_allocation();
+    if (!tracking.load(std::memory_order_relaxed)) {
+        return;
+    }
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    requested_bytes.fetch_add(requested, std::memory_order_relaxed);
+
+    int64_t live = live_bytes.fetch_add(static_cast<int64_t>(usable), std::memory_order_relaxed) +
+                   static_cast<int64_t>(usable);
+    int64_t peak = peak_bytes.load(std::memory_order_relaxed);
+    while (live > peak && !peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+}
+
+void AllocationTracker::record_deallocation(size_t usable) noexcept {
+    if (!tracking.load(std::memory_order_relaxed)) {
+        return;
+    }
+    // Blocks allocated before the tracker started may drive this negative; the peak stays >= 0
+    live_bytes.fetch_sub(static_cast<int64_t>(usable), std::memory_order_relaxed);
+}
+
+} // namespace clwe
@@ -0,0 +1,42 @@
+#ifndef ALLOCATION_TRACKER_HPP
+#define ALLOCATION_TRACKER_HPP
+
+#include <cstddef>
+
+namespace clwe {
+
+// Heap traffic seen by one AllocationTracker
+struct AllocationStats {
+    size_t allocations = 0;      // operator new calls
+    size_t bytes_allocated = 0;  // Bytes those calls requested
+    size_t peak_live_bytes = 0;  // Highest net heap growth since the tracker started
+};
+
+// Opt-in operator new/delete accounting. The counting hooks live in the clwe_alloc_hooks
+// object library; executables that do not link it keep the standard allocator and every
+// tracker reports zeros. Counts are process-wide, so run the measured code on one thread.
+// Only one tracker may be active at a time.
+class AllocationTracker {
+public:
+    // Start counting; throws std::logic_error if another tracker is active
+    AllocationTracker();
+    ~AllocationTracker();
+
+    AllocationTracker(const AllocationTracker&) = delete;
+    AllocationTracker& operator=(const AllocationTracker&) = delete;
+
+    // Traffic since construction
+    AllocationStats stats() const;
+
+    // True when the counting hooks are linked into this executable
+    static bool hooks_installed();
+
+    // Entry points for the hooks; size is the block's usable size for the live-byte count
+    static void mark_hooks_installed() noexcept;
+    static void record_allocation(size_t requested, size_t usable) noexcept;
+    static void record_deallocation(size_t usable) noexcept;
+};
+
+} // namespace clwe
+
+#endif // ALLOCATION_TRACKER_HPP
@@ -0,0 +1,324 @@
+#include "clwe/async_kem.hpp"
+#include "utils.hpp"
+#include "worker_thread.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace clwe {
+
+namespace {
+
+using KeyPair = std::pair<ColorPublicKey, ColorPrivateKey>;
+using Encapsulation = std::pair<ColorCiphertext, ColorValue>;
+
+enum class RequestKind { KEYGEN, ENCAPSULATE, DECAPSULATE };
+
+struct Request {
+    RequestKind kind;
+    AsyncKEM::Ticket ticket;
+    ColorPublicKey public_key;
+    ColorPrivateKey private_key;
+    ColorCiphertext ciphertext;
+    AsyncKemHandler<KeyPair> on_keygen;
+    AsyncKemHandler<Encapsulation> on_encapsulate;
+    AsyncKemHandler<ColorValue> on_decapsulate;
+};
+
+void wipe_private_key(ColorPrivateKey& key) {
+    if (!key.secret_data.empty()) {
+        secure_zero(key.secret_data.data(), key.secret_data.size());
+    }
+}
+
+void fail(Request& request, std::exception_ptr error) {
+    switch (request.kind) {
+        case RequestKind::KEYGEN:
+            request.on_keygen(error, KeyPair());
+            break;
+        case RequestKind::ENCAPSULATE:
+            request.on_encapsulate(error, Encapsulation());
+            break;
+        case RequestKind::DECAPSULATE:
+            request.on_decapsulate(error, ColorValue());
+            break;
+    }
+}
+
+} // namespace
+
+struct AsyncKEM::Impl {
+    const ColorKEM kem;
+    const AsyncKemConfig config;
+    std::unique_ptr<WorkerThread> worker;
+    AsyncKemPost post;
+
+    mutable std::mutex mutex;
+    std::condition_variable idle_cv;
+    std::deque<Request> queue;
+    Ticket next_ticket = 1;
+    bool drain_scheduled = false;
+    size_t outstanding_jobs = 0;  // Posted jobs not yet finished; the destructor waits for 0
+
+    Impl(const CLWEParameters& params, AsyncKemPost executor, const AsyncKemConfig& async_config)
+        : kem(params), config(async_config) {
+        if (executor) {
+            post = std::move(executor);
+        } else {
+            worker.reset(new WorkerThread());
+            WorkerThread* thread = worker.get();
+            post = [thread](std::function<void()> job) { thread->post(std::move(job)); };
+        }
+    }
+
+    Ticket submit(Request request) {
+        bool schedule = false;
+        Ticket ticket;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ticket = next_ticket++;
+            request.ticket = ticket;
+            queue.push_back(std::move(request));
+            if (!drain_scheduled) {
+                drain_scheduled = true;
+                ++outstanding_jobs;
+                schedule = true;
+            }
+        }
+        if (schedule) {
+            post([this] { drain(); });
+        }
+        return ticket;
+    }
+
+    void finish_job() {
+        std::lock_guard<std::mutex> lock(mutex);
+        --outstanding_jobs;
+        idle_cv.notify_all();
+    }
+
+    void drain() {
+        std::vector<Request> batch;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            size_t count = std::min(queue.size(), config.max_batch);
+            for (size_t i = 0; i < count; ++i) {
+                batch.push_back(std::move(queue.front()));
+                queue.pop_front();
+            }
+        }
+
+        run_batch(batch);
+
+        bool reschedule = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (queue.empty()) {
+                drain_scheduled = false;
+            } else {
+                ++outstanding_jobs;
+                reschedule = true;
+            }
+        }
+        if (reschedule) {
+            post([this] { drain(); });
+        }
+        finish_job();
+    }
+
+    void run_batch(std::vector<Request>& batch) {
+        std::vector<Request*> keygens;
+        std::vector<Request*> encapsulations;
+        std::vector<Request*> decapsulations;
+        for (Request& request : batch) {
+            switch (request.kind) {
+                case RequestKind::KEYGEN: keygens.push_back(&request); break;
+                case RequestKind::ENCAPSULATE: encapsulations.push_back(&request); break;
+                case RequestKind::DECAPSULATE: decapsulations.push_back(&request); break;
+            }
+        }
+
+        if (!keygens.empty()) {
+            run_keygens(keygens);
+        }
+        if (!encapsulations.empty()) {
+            run_encapsulations(encapsulations);
+        }
+        if (!decapsulations.empty()) {
+            run_decapsulations(decapsulations);
+        }
+    }
+
+    void run_keygens(const std::vector<Request*>& requests) {
+        std::vector<KeyPair> keys;
+        try {
+            keys = kem.keygen_batch(requests.size());
+        } catch (...) {
+            for (Request* request : requests) {
+                fail(*request, std::current_exception());
+            }
+            return;
+        }
+        for (size_t i = 0; i < requests.size(); ++i) {
+            requests[i]->on_keygen(nullptr, std::move(keys[i]));
+        }
+    }
+
+    void run_encapsulations(const std::vector<Request*>& requests) {
+        std::vector<ColorPublicKey> public_keys;
+        public_keys.reserve(requests.size());
+        for (Request* request : requests) {
+            public_keys.push_back(std::move(request->public_key));
+        }
+
+        std::vector<Encapsulation> results;
+        try {
+            results = kem.encapsulate_batch(public_keys);
+        } catch (...) {
+            // Isolate the invalid key: rerun each request on its own
+            for (size_t i = 0; i < requests.size(); ++i) {
+                Encapsulation result;
+                try {
+                    result = kem.encapsulate(public_keys[i]);
+                } catch (...) {
+                    fail(*requests[i], std::current_exception());
+                    continue;
+                }
+                requests[i]->on_encapsulate(nullptr, std::move(result));
+            }
+            return;
+        }
+        for (size_t i = 0; i < requests.size(); ++i) {
+            requests[i]->on_encapsulate(nullptr, std::move(results[i]));
+        }
+    }
+
+    void run_decapsulations(const std::vector<Request*>& requests) {
+        std::vector<ColorPublicKey> public_keys;
+        std::vector<ColorPrivateKey> private_keys;
+        std::vector<ColorCiphertext> ciphertexts;
+        public_keys.reserve(requests.size());
+        private_keys.reserve(requests.size());
+        ciphertexts.reserve(requests.size());
+        for (Request* request : requests) {
+            public_keys.push_back(std::move(request->public_key));
+            private_keys.push_back(std::move(request->private_key));
+            ciphertexts.push_back(std::move(request->ciphertext));
+        }
+
+        std::vector<ColorValue> secrets;
+        bool batched = true;
+        try {
+            secrets = kem.decapsulate_batch(public_keys, private_keys, ciphertexts);
+        } catch (...) {
+            batched = false;
+        }
+
+        for (size_t i = 0; i < requests.size(); ++i) {
+            if (batched) {
+                requests[i]->on_decapsulate(nullptr, secrets[i]);
+                continue;
+            }
+            ColorValue secret;
+            try {
+                secret = kem.decapsulate(public_keys[i], private_keys[i], ciphertexts[i]);
+            } catch (...) {
+                fail(*requests[i], std::current_exception());
+                continue;
+            }
+            requests[i]->on_decapsulate(nullptr, secret);
+        }
+
+        for (ColorPrivateKey& key : private_keys) {
+            wipe_private_key(key);
+        }
+    }
+};
+
+AsyncKEM::AsyncKEM(const CLWEParameters& params, AsyncKemPost post, const AsyncKemConfig& config) {
+    if (config.max_batch == 0) {
+        throw std::invalid_argument("AsyncKEM max_batch must be positive");
+    }
+    impl_.reset(new Impl(params, std::move(post), config));
+}
+
+AsyncKEM::~AsyncKEM() {
+    std::deque<Request> cancelled;
+    {
+        std::unique_lock<std::mutex> lock(impl_->mutex);
+        cancelled.swap(impl_->queue);
+    }
+    for (Request& request : cancelled) {
+        wipe_private_key(request.private_key);
+        fail(request, std::make_exception_ptr(AsyncKemCancelled()));
+    }
+
+    std::unique_lock<std::mutex> lock(impl_->mutex);
+    impl_->idle_cv.wait(lock, [this] { return impl_->outstanding_jobs == 0; });
+    lock.unlock();
+    impl_->worker.reset();
+}
+
+AsyncKEM::Ticket AsyncKEM::async_keygen(AsyncKemHandler<std::pair<ColorPublicKey, ColorPrivateKey>> handler) {
+    Request request;
+    request.kind = RequestKind::KEYGEN;
+    request.on_keygen = std::move(handler);
+    return impl_->submit(std::move(request));
+}
+
+AsyncKEM::Ticket AsyncKEM::async_encapsulate(const ColorPublicKey& public_key,
+                                             AsyncKemHandler<std::pair<ColorCiphertext, ColorValue>> handler) {
+    Request request;
+    request.kind = RequestKind::ENCAPSULATE;
+    request.public_key = public_key;
+    request.on_encapsulate = std::move(handler);
+    return impl_->submit(std::move(request));
+}
+
+AsyncKEM::Ticket AsyncKEM::async_decapsulate(const ColorPublicKey& public_key, const ColorPrivateKey& private_key,
+                                             const ColorCiphertext& ciphertext, AsyncKemHandler<ColorValue> handler) {
+    Request request;
+    request.kind = RequestKind::DECAPSULATE;
+    request.public_key = public_key;
+    request.private_key = private_key;
+    request.ciphertext = ciphertext;
+    request.on_decapsulate = std::move(handler);
+    return impl_->submit(std::move(request));
+}
+
+bool AsyncKEM::cancel(Ticket ticket) {
+    std::shared_ptr<Request> cancelled;
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        auto it = std::find_if(impl_->queue.begin(), impl_->queue.end(),
+                               [ticket](const Request& request) { return request.ticket == ticket; });
+        if (it == impl_->queue.end()) {
+            return false;
+        }
+        cancelled = std::make_shared<Request>(std::move(*it));
+        impl_->queue.erase(it);
+        ++impl_->outstanding_jobs;
+    }
+    wipe_private_key(cancelled->private_key);
+
+    Impl* impl = impl_.get();
+    impl->post([impl, cancelled] {
+        fail(*cancelled, std::make_exception_ptr(AsyncKemCancelled()));
+        impl->finish_job();
+    });
+    return true;
+}
+
+size_t AsyncKEM::pending() const {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    return impl_->queue.size();
+}
+
+const ColorKEM& AsyncKEM::kem() const {
+    return impl_->kem;
+}
+
+} // namespace clwe
@@ -0,0 +1,309 @@
+#include "clwe/autotune.hpp"
+#include "color_kem.hpp"
+#include "cpu_features.hpp"
+#include "ntt_engine.hpp"
+#include "shake_sampler.hpp"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace clwe {
+
+namespace {
+
+constexpr const char* PROFILE_HEADER = "# clwe autotune profile v1: cpu key, ntt backend, keccak backend, batch size";
+
+// Shortest wall time of options.repetitions runs of op, per call. The iteration count
+// doubles until one run lasts options.min_run, so short kernels are not timer noise.
+template <typename Op>
+double fastest_ns(const AutotuneOptions& options, Op&& op) {
+    using clock = std::chrono::steady_clock;
+    auto run = [&](size_t iterations) {
+        const auto start = clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            op();
+        }
+        return std::chrono::duration<double, std::nano>(clock::now() - start).count();
+    };
+    op();  // First touch of the code, tables and scratch
+    size_t iterations = 1;
+    double elapsed = run(iterations);
+    const double min_run_ns = std::chrono::duration<double, std::nano>(options.min_run).count();
+    while (elapsed < min_run_ns && iterations < (size_t(1) << 24)) {
+        iterations *= 2;
+        elapsed = run(iterations);
+    }
+    double best = elapsed / iterations;
+    for (unsigned r = 1; r < options.repetitions; ++r) {
+        best = std::min(best, run(iterations) / iterations);
+    }
+    return best;
+}
+
+// k forward transforms, one basemul row and one inverse, as a decapsulation computes s^T c1
+double time_ntt(SIMDSupport backend, const AutotuneOptions& options) {
+    const CLWEParameters& params = options.params;
+    const uint32_t n = params.degree, k = params.module_rank;
+    auto engine = create_ntt_engine(backend, params.modulus, n);
+    std::vector<uint32_t> secret(static_cast<size_t>(k) * n), input(secret.size()), work(secret.size()), out(n);
+    for (size_t i = 0; i < secret.size(); ++i) {
+        secret[i] = static_cast<uint32_t>((i * 7919 + 3) % params.modulus);
+        input[i] = static_cast<uint32_t>((i * i * 31 + 5) % params.modulus);
+    }
+    engine->ntt_forward_batch(secret.data(), k);
+    return fastest_ns(options, [&] {
+        std::copy(input.begin(), input.end(), work.begin());
+        engine->ntt_forward_batch(work.data(), k);
+        engine->basemul_acc(secret.data(), work.data(), k, out.data());
+        engine->ntt_inverse(out.data());
+    });
+}
+
+// One SHAKE128x4 matrix row (three blocks per lane) and k SHAKE256 noise streams
+double time_keccak(KeccakBackend backend, const AutotuneOptions& options) {
+    set_keccak_backend(backend);
+    const uint32_t k = options.params.module_rank;
+    std::array<uint8_t, 34> seeds[4] = {};
+    const uint8_t* seed_ptrs[4];
+    std::vector<uint8_t> lanes(4 * 3 * SHAKE128_RATE);
+    uint8_t* out_ptrs[4];
+    for (int lane = 0; lane < 4; ++lane) {
+        seeds[lane][32] = static_cast<uint8_t>(lane);
+        seed_ptrs[lane] = seeds[lane].data();
+        out_ptrs[lane] = lanes.data() + lane * 3 * SHAKE128_RATE;
+    }
+    uint8_t noise[192];
+    SHAKE128x4Sampler matrix;
+    SHAKE256Sampler stream;
+    return fastest_ns(options, [&] {
+        matrix.init_x4(seed_ptrs, seeds[0].size());
+        matrix.squeeze_blocks_x4(out_ptrs, 3);
+        for (uint32_t i = 0; i < k; ++i) {
+            stream.init(seeds[0].data(), 33);
+            stream.squeeze(noise, sizeof(noise));
+        }
+    });
+}
+
+// Per-encapsulation cost of encapsulate_batch() on batches of the given size
+double time_batch(size_t size, const AutotuneOptions& options) {
+    ColorKEM kem(options.params);
+    auto keys = kem.keygen();
+    const std::vector<ColorPublicKey> public_keys(size, keys.first);
+    return fastest_ns(options, [&] { kem.encapsulate_batch(public_keys); }) / size;
+}
+
+std::string cpu_model_name() {
+#if defined(__linux__)
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line, implementer, part;
+    while (std::getline(cpuinfo, line)) {
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        std::string key = line.substr(0, line.find_last_not_of(" \t", colon - 1) + 1);
+        std::string value = colon + 2 <= line.size() ? line.substr(colon + 2) : std::string();
+        // x86 and most others name the model; ARM cores give implementer and part codes
+        if (key == "model name" || key == "cpu model" || key == "Model") {
+            return value;
+        }
+        if (key == "CPU implementer" && implementer.empty()) implementer = value;
+        if (key == "CPU part" && part.empty()) part = value;
+    }
+    if (!implementer.empty()) {
+        return "implementer " + implementer + " part " + part;
+    }
+#endif
+    return "unknown";
+}
+
+struct ProfileEntry {
+    SIMDSupport ntt = SIMDSupport::NONE;
+    KeccakBackend keccak = KeccakBackend::Reference;
+    size_t batch_size = 1;
+};
+
+std::vector<std::string> split_tabs(const std::string& line) {
+    std::vector<std::string> fields;
+    std::stringstream stream(line);
+    std::string field;
+    while (std::getline(stream, field, '\t')) {
+        fields.push_back(field);
+    }
+    return fields;
+}
+
+// The entry for key, if the file has one that parses and names backends this build
+// and CPU still run
+bool find_entry(const std::vector<std::string>& lines, const std::string& key, ProfileEntry& entry) {
+    const std::vector<SIMDSupport> ntt_backends = available_ntt_backends();
+    for (const std::string& line : lines) {
+        std::vector<std::string> fields = split_tabs(line);
+        if (fields.size() != 4 || fields[0] != key) {
+            continue;
+        }
+        ProfileEntry parsed;
+        if (!CPUFeatureDetector::parse_backend(fields[1], parsed.ntt) ||
+            std::find(ntt_backends.begin(), ntt_backends.end(), parsed.ntt) == ntt_backends.end() ||
+            !parse_keccak_backend(fields[2], parsed.keccak) || !keccak_backend_available(parsed.keccak) ||
+            fields[3].empty() || fields[3].size() > 9 || fields[3].find_first_not_of("0123456789") != std::string::npos) {
+            return false;
+        }
+        parsed.batch_size = static_cast<size_t>(std::stoull(fields[3]));
+        if (parsed.batch_size == 0) {
+            return false;
+        }
+        entry = parsed;
+        return true;
+    }
+    return false;
+}
+
+std::vector<std::string> read_profile(const std::string& path) {
+    std::vector<std::string> lines;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line[0] != '#') {
+            lines.push_back(line);
+        }
+    }
+    return lines;
+}
+
+// Rewrites the profile with key's entry replaced, through a temporary file and rename
+void write_profile(const std::string& path, const std::vector<std::string>& lines, const std::string& key,
+                   const AutotuneResult& result) {
+    const std::string temp_path = path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("Cannot write autotune profile " + temp_path + ": " + std::strerror(errno));
+        }
+        file << PROFILE_HEADER << "\n";
+        for (const std::string& line : lines) {
+            if (split_tabs(line).front() != key) {
+                file << line << "\n";
+            }
+        }
+        file << key << "\t" << ntt_backend_name(result.ntt_backend) << "\t"
+             << keccak_backend_name(result.keccak_backend) << "\t" << result.batch_size << "\n";
+        file.flush();
+        if (!file) {
+            std::remove(temp_path.c_str());
+            throw std::runtime_error("Cannot write autotune profile " + temp_path);
+        }
+    }
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        int err = errno;
+        std::remove(temp_path.c_str());
+        throw std::runtime_error("Cannot replace autotune profile " + path + ": " + std::strerror(err));
+    }
+}
+
+} // namespace
+
+std::string autotune_cpu_key() {
+    std::string key = cpu_model_name() + ", " + CPUFeatureDetector::cached().to_string();
+    // Tabs separate the profile's fields
+    std::replace(key.begin(), key.end(), '\t', ' ');
+    return key;
+}
+
+AutotuneResult autotune(const AutotuneOptions& options) {
+    const auto start = std::chrono::steady_clock::now();
+    options.params.validate();
+    if (options.repetitions == 0) {
+        throw std::invalid_argument("Autotune needs at least one repetition");
+    }
+    if (options.batch_sizes.empty() ||
+        std::find(options.batch_sizes.begin(), options.batch_sizes.end(), size_t(0)) != options.batch_sizes.end()) {
+        throw std::invalid_argument("Autotune batch sizes must be non-empty and positive");
+    }
+
+    AutotuneResult result;
+    result.cpu_key = autotune_cpu_key();
+    const bool ntt_selected = ntt_backend_selected();
+    const SIMDSupport previous_ntt = ntt_backend();
+    const KeccakBackend previous_keccak = keccak_backend();
+
+    std::vector<std::string> lines;
+    ProfileEntry entry;
+    if (!options.profile_path.empty()) {
+        lines = read_profile(options.profile_path);
+    }
+    if (!options.retune && find_entry(lines, result.cpu_key, entry)) {
+        result.ntt_backend = entry.ntt;
+        result.keccak_backend = entry.keccak;
+        result.batch_size = entry.batch_size;
+        result.from_profile = true;
+    } else {
+        double best_ntt = 0.0;
+        for (SIMDSupport backend : available_ntt_backends()) {
+            double ns = time_ntt(backend, options);
+            result.ntt_timings.push_back({ntt_backend_name(backend), ns});
+            if (result.ntt_timings.size() == 1 || ns < best_ntt) {
+                best_ntt = ns;
+                result.ntt_backend = backend;
+            }
+        }
+        double best_keccak = 0.0;
+        for (KeccakBackend backend : available_keccak_backends()) {
+            double ns = time_keccak(backend, options);
+            result.keccak_timings.push_back({keccak_backend_name(backend), ns});
+            if (result.keccak_timings.size() == 1 || ns < best_keccak) {
+                best_keccak = ns;
+                result.keccak_backend = backend;
+            }
+        }
+
+        // Batches run on the winners; the smallest one close to the best cost adds the least latency
+        set_ntt_backend(result.ntt_backend);
+        set_keccak_backend(result.keccak_backend);
+        std::vector<size_t> sizes = options.batch_sizes;
+        std::sort(sizes.begin(), sizes.end());
+        sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+        double cheapest = 0.0;
+        for (size_t size : sizes) {
+            double ns = time_batch(size, options);
+            result.batch_timings.push_back({std::to_string(size), ns});
+            cheapest = result.batch_timings.size() == 1 ? ns : std::min(cheapest, ns);
+        }
+        for (size_t i = 0; i < sizes.size(); ++i) {
+            if (result.batch_timings[i].ns_per_op <= cheapest * (1.0 + options.batch_tolerance)) {
+                result.batch_size = sizes[i];
+                break;
+            }
+        }
+
+        if (!options.profile_path.empty()) {
+            write_profile(options.profile_path, lines, result.cpu_key, result);
+        }
+    }
+
+    if (options.apply) {
+        set_ntt_backend(result.ntt_backend);
+        set_keccak_backend(result.keccak_backend);
+        result.applied = true;
+    } else {
+        if (ntt_selected) {
+            set_ntt_backend(previous_ntt);
+        } else {
+            reset_ntt_backend();
+        }
+        set_keccak_backend(previous_keccak);
+    }
+    result.elapsed_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+} // namespace clwe
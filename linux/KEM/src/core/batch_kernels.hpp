@@ -0,0 +1,289 @@
+#ifndef BATCH_KERNELS_HPP
+#define BATCH_KERNELS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Stage functions of the batch offload path, compiled both by nvcc for the CUDA kernels
+// (src/cuda/batch_kernels.cu) and by the host compiler for run_*_batch_host(), which the
+// tests compare against ColorKEM. Everything works on canonical uint32_t residues.
+#ifdef __CUDACC__
+#define CLWE_HD __host__ __device__
+#else
+#define CLWE_HD
+#endif
+
+namespace clwe {
+namespace batch {
+
+constexpr uint32_t SHAKE128_BLOCK = 168;
+constexpr uint32_t SHAKE256_BLOCK = 136;
+constexpr size_t SEED_BYTES = 32;
+// matrix || secret || error seeds of a keygen; r || e1 || e2 seeds of an encapsulation
+constexpr size_t INSTANCE_SEED_BYTES = 3 * SEED_BYTES;
+
+// One parameter set as the kernels see it; the tables point into device memory on the GPU
+struct KernelParams {
+    uint32_t q;
+    uint32_t n;
+    uint32_t k;
+    uint32_t log_n;
+    uint32_t eta1;
+    uint32_t eta2;
+    uint32_t n_inv;         // n^(-1) mod q, applied after the inverse NTT
+    uint32_t matrix_bound;  // min(q, 4096): 12-bit candidates below it are accepted
+    bool sparse_c2;
+    const uint32_t* zetas;      // ntt_tables(q, n).zetas
+    const uint32_t* zetas_inv;  // ntt_tables(q, n).zetas_inv
+};
+
+// Keccak-f[1600] and a SHAKE sponge that absorbs one short input
+
+CLWE_HD inline uint64_t rotl64(uint64_t x, unsigned s) {
+    return s == 0 ? x : (x << s) | (x >> (64 - s));
+}
+
+CLWE_HD inline void keccak_f1600(uint64_t st[25]) {
+    const uint64_t round_constants[24] = {
+        0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL, 0x8000000080008000ULL,
+        0x000000000000808bULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+        0x000000000000008aULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+        0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+        0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800aULL, 0x800000008000000aULL,
+        0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL};
+    const unsigned rotations[24] = {1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14,
+                                    27, 41, 56, 8, 25, 43, 62, 18, 39, 61, 20, 44};
+    const unsigned lanes[24] = {10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4,
+                                15, 23, 19, 13, 12, 2, 20, 14, 22, 9, 6, 1};
+    uint64_t c[5];
+    for (unsigned round = 0; round < 24; ++round) {
+        // Theta
+        for (unsigned x = 0; x < 5; ++x) {
+            c[x] = st[x] ^ st[x + 5] ^ st[x + 10] ^ st[x + 15] ^ st[x + 20];
+        }
+        for (unsigned x = 0; x < 5; ++x) {
+            const uint64_t d = c[(x + 4) % 5] ^ rotl64(c[(x + 1) % 5], 1);
+            for (unsigned y = 0; y < 25; y += 5) {
+                st[y + x] ^= d;
+            }
+        }
+        // Rho and pi
+        uint64_t carried = st[1];
+        for (unsigned i = 0; i < 24; ++i) {
+            const uint64_t next = st[lanes[i]];
+            st[lanes[i]] = rotl64(carried, rotations[i]);
+            carried = next;
+        }
+        // Chi
+        for (unsigned y = 0; y < 25; y += 5) {
+            for (unsigned x = 0; x < 5; ++x) {
+                c[x] = st[y + x];
+            }
+            for (unsigned x = 0; x < 5; ++x) {
+                st[y + x] = c[x] ^ (~c[(x + 1) % 5] & c[(x + 2) % 5]);
+            }
+        }
+        // Iota
+        st[0] ^= round_constants[round];
+    }
+}
+
+// SHAKE state after absorbing len < rate bytes and the padding
+CLWE_HD inline void shake_absorb_short(uint64_t st[25], uint32_t rate, const uint8_t* in, uint32_t len) {
+    for (unsigned i = 0; i < 25; ++i) {
+        st[i] = 0;
+    }
+    for (uint32_t i = 0; i < len; ++i) {
+        st[i / 8] ^= static_cast<uint64_t>(in[i]) << (8 * (i % 8));
+    }
+    st[len / 8] ^= static_cast<uint64_t>(0x1F) << (8 * (len % 8));
+    st[(rate - 1) / 8] ^= static_cast<uint64_t>(0x80) << (8 * ((rate - 1) % 8));
+}
+
+CLWE_HD inline void shake_squeeze_block(uint64_t st[25], uint32_t rate, uint8_t* out) {
+    keccak_f1600(st);
+    for (uint32_t i = 0; i < rate; ++i) {
+        out[i] = static_cast<uint8_t>(st[i / 8] >> (8 * (i % 8)));
+    }
+}
+
+// Sampling
+
+// Cell (row, col) of A_hat: SHAKE-128(seed || row || col) read as 12-bit candidates,
+// matching rejection_sample_uniform12_be()
+CLWE_HD inline void expand_matrix_poly(const KernelParams& p, const uint8_t* seed, uint32_t row, uint32_t col,
+                                       uint32_t* out) {
+    uint8_t input[SEED_BYTES + 2];
+    for (size_t i = 0; i < SEED_BYTES; ++i) {
+        input[i] = seed[i];
+    }
+    input[SEED_BYTES] = static_cast<uint8_t>(row);
+    input[SEED_BYTES + 1] = static_cast<uint8_t>(col);
+    uint64_t st[25];
+    shake_absorb_short(st, SHAKE128_BLOCK, input, sizeof(input));
+
+    uint8_t block[SHAKE128_BLOCK];
+    uint32_t filled = 0;
+    while (filled < p.n) {
+        shake_squeeze_block(st, SHAKE128_BLOCK, block);
+        for (uint32_t pos = 0; pos + 3 <= SHAKE128_BLOCK && filled < p.n; pos += 3) {
+            const uint32_t c1 = ((block[pos] << 4) | (block[pos + 1] >> 4)) & 0xFFF;
+            const uint32_t c2 = ((block[pos + 1] << 8) | block[pos + 2]) & 0xFFF;
+            if (c1 < p.matrix_bound) {
+                out[filled++] = c1;
+            }
+            if (c2 < p.matrix_bound && filled < p.n) {
+                out[filled++] = c2;
+            }
+        }
+    }
+}
+
+CLWE_HD inline uint32_t popcount_bits(uint32_t x) {
+    uint32_t count = 0;
+    for (; x != 0; x &= x - 1) {
+        ++count;
+    }
+    return count;
+}
+
+// B(eta) - B(eta) from SHAKE-256(seed with byte 0 ^ index): each coefficient takes 2 * eta
+// consecutive little-endian bits of the stream, as cbd_blocks() does
+CLWE_HD inline void sample_noise_poly(const KernelParams& p, uint32_t eta, const uint8_t* seed, uint32_t index,
+                                      uint32_t* out) {
+    uint8_t input[SEED_BYTES];
+    for (size_t i = 0; i < SEED_BYTES; ++i) {
+        input[i] = seed[i];
+    }
+    input[0] ^= static_cast<uint8_t>(index);
+    uint64_t st[25];
+    shake_absorb_short(st, SHAKE256_BLOCK, input, sizeof(input));
+
+    uint8_t block[SHAKE256_BLOCK];
+    uint32_t pos = SHAKE256_BLOCK;
+    uint32_t bits = 0;
+    uint32_t nbits = 0;
+    const uint32_t mask = (1u << eta) - 1;
+    for (uint32_t c = 0; c < p.n; ++c) {
+        while (nbits < 2 * eta) {
+            if (pos == SHAKE256_BLOCK) {
+                shake_squeeze_block(st, SHAKE256_BLOCK, block);
+                pos = 0;
+            }
+            bits |= static_cast<uint32_t>(block[pos++]) << nbits;
+            nbits += 8;
+        }
+        const uint32_t a = popcount_bits(bits & mask);
+        const uint32_t b = popcount_bits((bits >> eta) & mask);
+        bits >>= 2 * eta;
+        nbits -= 2 * eta;
+        out[c] = a >= b ? a - b : a + p.q - b;
+    }
+}
+
+// NTT, one butterfly at a time so a CUDA block can run a stage with one thread per butterfly
+
+CLWE_HD inline uint32_t mul_mod(uint32_t a, uint32_t b, uint32_t q) {
+    return static_cast<uint32_t>(static_cast<uint64_t>(a) * b % q);
+}
+
+// Butterfly b < n / 2 of forward stage s: Gentleman-Sande, natural order in, bit-reversed out
+CLWE_HD inline void ntt_forward_butterfly(const KernelParams& p, uint32_t* poly, uint32_t stage, uint32_t b) {
+    const uint32_t half = p.n >> (stage + 1);
+    const uint32_t i = b % half;
+    uint32_t* x = poly + (b / half) * 2 * half + i;
+    uint32_t* y = x + half;
+    uint32_t sum = *x + *y;
+    sum -= sum >= p.q ? p.q : 0;
+    const uint32_t diff = *x >= *y ? *x - *y : *x + p.q - *y;
+    *x = sum;
+    *y = mul_mod(diff, p.zetas[i << stage], p.q);
+}
+
+// Butterfly b < n / 2 of inverse stage s: Cooley-Tukey, bit-reversed order in, natural out
+CLWE_HD inline void ntt_inverse_butterfly(const KernelParams& p, uint32_t* poly, uint32_t stage, uint32_t b) {
+    const uint32_t half = 1u << stage;
+    const uint32_t i = b % half;
+    uint32_t* x = poly + (b / half) * 2 * half + i;
+    uint32_t* y = x + half;
+    const uint32_t t = mul_mod(*y, p.zetas_inv[i * (p.n / (2 * half))], p.q);
+    const uint32_t diff = *x >= t ? *x - t : *x + p.q - t;
+    uint32_t sum = *x + t;
+    sum -= sum >= p.q ? p.q : 0;
+    *x = sum;
+    *y = diff;
+}
+
+CLWE_HD inline void ntt_forward_poly(const KernelParams& p, uint32_t* poly) {
+    for (uint32_t stage = 0; stage < p.log_n; ++stage) {
+        for (uint32_t b = 0; b < p.n / 2; ++b) {
+            ntt_forward_butterfly(p, poly, stage, b);
+        }
+    }
+}
+
+// Inverse NTT including the n^(-1) scaling
+CLWE_HD inline void ntt_inverse_poly(const KernelParams& p, uint32_t* poly) {
+    for (uint32_t stage = 0; stage < p.log_n; ++stage) {
+        for (uint32_t b = 0; b < p.n / 2; ++b) {
+            ntt_inverse_butterfly(p, poly, stage, b);
+        }
+    }
+    for (uint32_t c = 0; c < p.n; ++c) {
+        poly[c] = mul_mod(poly[c], p.n_inv, p.q);
+    }
+}
+
+// NTT-domain products, one output coefficient at a time
+
+// sum_j a[j * a_stride + c] * b[j * n + c] mod q; q < 2^16 keeps k products in 64 bits
+CLWE_HD inline uint32_t dot_coeff(const KernelParams& p, const uint32_t* a, size_t a_stride, const uint32_t* b,
+                                  uint32_t c) {
+    uint64_t acc = 0;
+    for (uint32_t j = 0; j < p.k; ++j) {
+        acc += static_cast<uint64_t>(a[j * a_stride + c]) * b[static_cast<size_t>(j) * p.n + c];
+    }
+    return static_cast<uint32_t>(acc % p.q);
+}
+
+// t_hat[row][c] = (A_hat s_hat)[row][c] + e_hat[row][c]; a is row-major k x k
+CLWE_HD inline void keygen_combine_coeff(const KernelParams& p, const uint32_t* a, const uint32_t* s_hat,
+                                         const uint32_t* e_hat, uint32_t row, uint32_t c, uint32_t* t_hat) {
+    const size_t at = static_cast<size_t>(row) * p.n + c;
+    const uint32_t sum = dot_coeff(p, a + static_cast<size_t>(row) * p.k * p.n, p.n, s_hat, c) + e_hat[at];
+    t_hat[at] = sum % p.q;
+}
+
+// Row `row` < k of u_hat = A_hat^T r_hat (a stores A_hat^T row-major), or v_hat = t_hat^T r_hat
+// for row == k; u_hat and v_hat are consecutive in uv_hat
+CLWE_HD inline void encapsulate_product_coeff(const KernelParams& p, const uint32_t* a_trans, const uint32_t* t_hat,
+                                              const uint32_t* r_hat, uint32_t row, uint32_t c, uint32_t* uv_hat) {
+    const uint32_t* lhs = row < p.k ? a_trans + static_cast<size_t>(row) * p.k * p.n : t_hat;
+    uv_hat[static_cast<size_t>(row) * p.n + c] = dot_coeff(p, lhs, p.n, r_hat, c);
+}
+
+// Coefficient c of polynomial `row` of c1 || c2 from the inverse-transformed u || v:
+// c1 = u + e1, c2 = v + e2 + message * floor(q / 2) * x^0, zero past c2[0] when sparse
+CLWE_HD inline void encapsulate_finish_coeff(const KernelParams& p, const uint32_t* uv, const uint32_t* e1,
+                                             const uint32_t* e2, uint32_t message, uint32_t row, uint32_t c,
+                                             uint32_t* ciphertext) {
+    const size_t at = static_cast<size_t>(row) * p.n + c;
+    if (row < p.k) {
+        ciphertext[at] = (uv[at] + e1[at]) % p.q;
+        return;
+    }
+    if (p.sparse_c2 && c != 0) {
+        ciphertext[at] = 0;
+        return;
+    }
+    uint32_t value = (uv[at] + e2[c]) % p.q;
+    if (c == 0) {
+        value = (value + message * (p.q / 2)) % p.q;
+    }
+    ciphertext[at] = value;
+}
+
+} // namespace batch
+} // namespace clwe
+
+#endif // BATCH_KERNELS_HPP
@@ -0,0 +1,431 @@
+#include "batch_offload.hpp"
+#include "cpu_features.hpp"
+#include "keccak_x4.hpp"
+#include "simd_target.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#ifdef HAVE_AVX2
+#include <immintrin.h>
+#endif
+
+// Lane-parallel host run of the encapsulation stages. BATCH_LANES independent requests are
+// interleaved coefficient by coefficient (residue c of lane l at [c * BATCH_LANES + l]), so
+// every stage runs the same butterfly, bit extraction or product for all requests at once:
+// one AVX2 register holds coefficient c of all eight. The sponges of the lanes run
+// together as two keccakf1600_x4() permutations. Only the matrix rejection sampling, whose
+// acceptance differs per lane, is parsed lane by lane.
+
+namespace clwe {
+
+namespace {
+
+constexpr size_t L = BATCH_LANES;
+
+// Operations on WIDTH adjacent lanes of 32-bit residues
+struct ScalarLanes {
+    using V = uint32_t;
+    static constexpr size_t WIDTH = 1;
+    static V load(const uint32_t* p) { return *p; }
+    static void store(uint32_t* p, V a) { *p = a; }
+    static V constant(uint32_t c) { return c; }
+    static V add(V a, V b) { return a + b; }
+    static V sub(V a, V b) { return a - b; }
+    static V mul_lo(V a, V b) { return a * b; }
+    static V mul_hi(V a, V b) { return static_cast<uint32_t>((static_cast<uint64_t>(a) * b) >> 32); }
+    static V min(V a, V b) { return a < b ? a : b; }
+    static V band(V a, V b) { return a & b; }
+    static V srl(V a, uint32_t n) { return a >> n; }
+};
+
+// No __m256i crosses a real call: every user is always inlined into a tagged caller, hence
+// the silenced ABI note, for the whole file since GCC reports it where the templates below
+// are instantiated, at the end of the translation unit
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+#ifdef HAVE_AVX2
+struct AVX2Lanes {
+    using V = __m256i;
+    static constexpr size_t WIDTH = 8;
+    CLWE_TARGET_AVX2 static V load(const uint32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const V*>(p)); }
+    CLWE_TARGET_AVX2 static void store(uint32_t* p, V a) { _mm256_storeu_si256(reinterpret_cast<V*>(p), a); }
+    CLWE_TARGET_AVX2 static V constant(uint32_t c) { return _mm256_set1_epi32(static_cast<int>(c)); }
+    CLWE_TARGET_AVX2 static V add(V a, V b) { return _mm256_add_epi32(a, b); }
+    CLWE_TARGET_AVX2 static V sub(V a, V b) { return _mm256_sub_epi32(a, b); }
+    CLWE_TARGET_AVX2 static V mul_lo(V a, V b) { return _mm256_mullo_epi32(a, b); }
+    CLWE_TARGET_AVX2 static V mul_hi(V a, V b) {
+        // High halves of the even products, then the odd products moved into place
+        const V even = _mm256_srli_epi64(_mm256_mul_epu32(a, b), 32);
+        const V odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+        return _mm256_blend_epi32(even, odd, 0xAA);
+    }
+    CLWE_TARGET_AVX2 static V min(V a, V b) { return _mm256_min_epu32(a, b); }
+    CLWE_TARGET_AVX2 static V band(V a, V b) { return _mm256_and_si256(a, b); }
+    CLWE_TARGET_AVX2 static V srl(V a, uint32_t n) { return _mm256_srl_epi32(a, _mm_cvtsi32_si128(static_cast<int>(n))); }
+};
+#endif
+
+// The stages, generic over the lane type and always inlined so the AVX2 instance is
+// compiled for the target of its caller
+
+// x < 2q to x mod q: x - q wraps above x when x < q
+template <typename S>
+CLWE_ALWAYS_INLINE typename S::V reduce_once(typename S::V x, typename S::V q) {
+    return S::min(x, S::sub(x, q));
+}
+
+// x * w mod q for x < 2^32 with w' = floor(w * 2^32 / q)
+template <typename S>
+CLWE_ALWAYS_INLINE typename S::V mul_shoup(typename S::V x, typename S::V w, typename S::V w_shoup,
+                                           typename S::V q) {
+    return reduce_once<S>(S::sub(S::mul_lo(x, w), S::mul_lo(S::mul_hi(x, w_shoup), q)), q);
+}
+
+// x mod q for x < 2^32 with barrett = floor(2^32 / q)
+template <typename S>
+CLWE_ALWAYS_INLINE typename S::V reduce(typename S::V x, typename S::V barrett, typename S::V q) {
+    return reduce_once<S>(S::sub(x, S::mul_lo(S::mul_hi(x, barrett), q)), q);
+}
+
+inline uint32_t shoup_factor(uint32_t w, uint32_t q) {
+    return static_cast<uint32_t>((static_cast<uint64_t>(w) << 32) / q);
+}
+
+// Shoup factors of a twiddle table
+std::vector<uint32_t> shoup_table(const uint32_t* table, uint32_t count, uint32_t q) {
+    std::vector<uint32_t> shoup(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        shoup[i] = shoup_factor(table[i], q);
+    }
+    return shoup;
+}
+
+// Eight sponges as two lane-major keccakf1600_x4() states
+struct LaneSponge {
+    uint64_t state[2][25][4];
+    uint32_t rate;
+
+    // Absorb one short input per lane, then the SHAKE padding
+    void absorb_short(uint32_t sponge_rate, const uint8_t* const inputs[L], uint32_t len) {
+        rate = sponge_rate;
+        std::memset(state, 0, sizeof(state));
+        for (size_t lane = 0; lane < L; ++lane) {
+            uint64_t (*st)[4] = state[lane / 4];
+            const size_t slot = lane % 4;
+            for (uint32_t i = 0; i < len; ++i) {
+                st[i / 8][slot] ^= static_cast<uint64_t>(inputs[lane][i]) << (8 * (i % 8));
+            }
+            st[len / 8][slot] ^= static_cast<uint64_t>(0x1F) << (8 * (len % 8));
+            st[(rate - 1) / 8][slot] ^= static_cast<uint64_t>(0x80) << (8 * ((rate - 1) % 8));
+        }
+    }
+
+    // Next rate-byte block of every lane: lane l's block at out + l * stride
+    void squeeze_block(uint8_t* out, size_t stride) {
+        keccakf1600_x4(state[0]);
+        keccakf1600_x4(state[1]);
+        for (size_t lane = 0; lane < L; ++lane) {
+            uint8_t* block = out + lane * stride;
+            for (uint32_t word = 0; word < rate / 8; ++word) {
+                const uint64_t w = state[lane / 4][word][lane % 4];
+                for (uint32_t b = 0; b < 8; ++b) {
+                    block[word * 8 + b] = static_cast<uint8_t>(w >> (8 * b));
+                }
+            }
+        }
+    }
+
+    ~LaneSponge() { secure_zero(state, sizeof(state)); }
+};
+
+// Cell (row, col) of A_hat for every lane, as batch::expand_matrix_poly(); lanes squeeze in
+// lockstep until the slowest has n accepted candidates
+void expand_matrix_lanes(const batch::KernelParams& p, const uint8_t* const seeds[L], uint32_t row, uint32_t col,
+                         uint32_t* out) {
+    uint8_t inputs[L][batch::SEED_BYTES + 2];
+    const uint8_t* input_ptrs[L];
+    for (size_t lane = 0; lane < L; ++lane) {
+        std::memcpy(inputs[lane], seeds[lane], batch::SEED_BYTES);
+        inputs[lane][batch::SEED_BYTES] = static_cast<uint8_t>(row);
+        inputs[lane][batch::SEED_BYTES + 1] = static_cast<uint8_t>(col);
+        input_ptrs[lane] = inputs[lane];
+    }
+    LaneSponge sponge;
+    sponge.absorb_short(batch::SHAKE128_BLOCK, input_ptrs, batch::SEED_BYTES + 2);
+
+    uint8_t blocks[L][batch::SHAKE128_BLOCK];
+    uint32_t filled[L] = {};
+    size_t done = 0;
+    while (done < L) {
+        sponge.squeeze_block(blocks[0], batch::SHAKE128_BLOCK);
+        done = 0;
+        for (size_t lane = 0; lane < L; ++lane) {
+            const uint8_t* block = blocks[lane];
+            uint32_t count = filled[lane];
+            for (uint32_t pos = 0; pos + 3 <= batch::SHAKE128_BLOCK && count < p.n; pos += 3) {
+                const uint32_t c1 = ((block[pos] << 4) | (block[pos + 1] >> 4)) & 0xFFF;
+                const uint32_t c2 = ((block[pos + 1] << 8) | block[pos + 2]) & 0xFFF;
+                if (c1 < p.matrix_bound) {
+                    out[count++ * L + lane] = c1;
+                }
+                if (c2 < p.matrix_bound && count < p.n) {
+                    out[count++ * L + lane] = c2;
+                }
+            }
+            filled[lane] = count;
+            done += count == p.n ? 1 : 0;
+        }
+    }
+}
+
+// SHAKE-256 output sample_noise_lanes() needs per lane, in whole blocks
+size_t noise_stream_bytes(const batch::KernelParams& p, uint32_t eta) {
+    const size_t needed = static_cast<size_t>(p.n) / 4 * eta;
+    return (needed + batch::SHAKE256_BLOCK - 1) / batch::SHAKE256_BLOCK * batch::SHAKE256_BLOCK;
+}
+
+// B(eta) - B(eta) for every lane, as batch::sample_noise_poly(). Every eta stream bytes hold
+// four coefficients of 2 * eta bits at the same place in all lanes, so the whole stream is
+// squeezed first (into stream, L * noise_stream_bytes() bytes) and decoded for all lanes at once
+template <typename S>
+CLWE_ALWAYS_INLINE void sample_noise_lanes(const batch::KernelParams& p, uint32_t eta, const uint8_t* const seeds[L],
+                                           uint32_t index, uint8_t* stream, uint32_t* out) {
+    uint8_t inputs[L][batch::SEED_BYTES];
+    const uint8_t* input_ptrs[L];
+    for (size_t lane = 0; lane < L; ++lane) {
+        std::memcpy(inputs[lane], seeds[lane], batch::SEED_BYTES);
+        inputs[lane][0] ^= static_cast<uint8_t>(index);
+        input_ptrs[lane] = inputs[lane];
+    }
+    const size_t stride = noise_stream_bytes(p, eta);
+    {
+        LaneSponge sponge;
+        sponge.absorb_short(batch::SHAKE256_BLOCK, input_ptrs, batch::SEED_BYTES);
+        for (size_t offset = 0; offset < stride; offset += batch::SHAKE256_BLOCK) {
+            sponge.squeeze_block(stream + offset, stride);
+        }
+    }
+
+    using V = typename S::V;
+    const V q = S::constant(p.q);
+    const V one = S::constant(1);
+    uint32_t words[L];
+    for (uint32_t group = 0; group < p.n / 4; ++group) {
+        for (size_t lane = 0; lane < L; ++lane) {
+            const uint8_t* bytes = stream + lane * stride + group * eta;
+            uint32_t w = 0;
+            for (uint32_t b = 0; b < eta; ++b) {
+                w |= static_cast<uint32_t>(bytes[b]) << (8 * b);
+            }
+            words[lane] = w;
+        }
+        for (uint32_t j = 0; j < 4; ++j) {
+            uint32_t* coeff = out + (static_cast<size_t>(group) * 4 + j) * L;
+            for (size_t lane = 0; lane < L; lane += S::WIDTH) {
+                const V bits = S::srl(S::load(words + lane), 2 * eta * j);
+                V a = S::constant(0);
+                V b = S::constant(0);
+                for (uint32_t bit = 0; bit < eta; ++bit) {
+                    a = S::add(a, S::band(S::srl(bits, bit), one));
+                    b = S::add(b, S::band(S::srl(bits, eta + bit), one));
+                }
+                S::store(coeff + lane, reduce_once<S>(S::sub(S::add(a, q), b), q));
+            }
+        }
+    }
+    secure_zero(inputs, sizeof(inputs));
+    secure_zero(words, sizeof(words));
+    secure_zero(stream, L * stride);
+}
+
+// batch::ntt_forward_poly() on all lanes with Shoup twiddles
+template <typename S>
+CLWE_ALWAYS_INLINE void ntt_forward_lanes(const batch::KernelParams& p, const uint32_t* zetas_shoup, uint32_t* poly) {
+    using V = typename S::V;
+    const V q = S::constant(p.q);
+    for (uint32_t stage = 0; stage < p.log_n; ++stage) {
+        const uint32_t half = p.n >> (stage + 1);
+        for (uint32_t start = 0; start < p.n; start += 2 * half) {
+            for (uint32_t i = 0; i < half; ++i) {
+                const V w = S::constant(p.zetas[i << stage]);
+                const V w_shoup = S::constant(zetas_shoup[i << stage]);
+                uint32_t* x = poly + static_cast<size_t>(start + i) * L;
+                uint32_t* y = x + static_cast<size_t>(half) * L;
+                for (size_t lane = 0; lane < L; lane += S::WIDTH) {
+                    const V a = S::load(x + lane);
+                    const V b = S::load(y + lane);
+                    S::store(x + lane, reduce_once<S>(S::add(a, b), q));
+                    S::store(y + lane, mul_shoup<S>(S::sub(S::add(a, q), b), w, w_shoup, q));
+                }
+            }
+        }
+    }
+}
+
+// batch::ntt_inverse_poly() on all lanes, without the n^(-1) scaling
+template <typename S>
+CLWE_ALWAYS_INLINE void ntt_inverse_lanes(const batch::KernelParams& p, const uint32_t* zetas_inv_shoup,
+                                          uint32_t* poly) {
+    using V = typename S::V;
+    const V q = S::constant(p.q);
+    for (uint32_t stage = 0; stage < p.log_n; ++stage) {
+        const uint32_t half = 1u << stage;
+        const uint32_t step = p.n / (2 * half);
+        for (uint32_t start = 0; start < p.n; start += 2 * half) {
+            for (uint32_t i = 0; i < half; ++i) {
+                const V w = S::constant(p.zetas_inv[i * step]);
+                const V w_shoup = S::constant(zetas_inv_shoup[i * step]);
+                uint32_t* x = poly + static_cast<size_t>(start + i) * L;
+                uint32_t* y = x + static_cast<size_t>(half) * L;
+                for (size_t lane = 0; lane < L; lane += S::WIDTH) {
+                    const V a = S::load(x + lane);
+                    const V t = mul_shoup<S>(S::load(y + lane), w, w_shoup, q);
+                    S::store(x + lane, reduce_once<S>(S::add(a, t), q));
+                    S::store(y + lane, reduce_once<S>(S::sub(S::add(a, q), t), q));
+                }
+            }
+        }
+    }
+}
+
+// acc += a * b mod q, coefficient-wise over size interleaved residues
+template <typename S>
+CLWE_ALWAYS_INLINE void multiply_accumulate_lanes(const batch::KernelParams& p, const uint32_t* a, const uint32_t* b,
+                                                  uint32_t* acc, size_t size) {
+    using V = typename S::V;
+    const V q = S::constant(p.q);
+    const V barrett = S::constant(static_cast<uint32_t>((static_cast<uint64_t>(1) << 32) / p.q));
+    for (size_t i = 0; i < size; i += S::WIDTH) {
+        const V product = reduce<S>(S::mul_lo(S::load(a + i), S::load(b + i)), barrett, q);
+        S::store(acc + i, reduce_once<S>(S::add(S::load(acc + i), product), q));
+    }
+}
+
+// out = x * n^(-1) + e mod q, coefficient-wise: the inverse NTT scaling and the noise term
+template <typename S>
+CLWE_ALWAYS_INLINE void scale_add_lanes(const batch::KernelParams& p, const uint32_t* x, const uint32_t* e,
+                                        uint32_t* out, size_t size) {
+    using V = typename S::V;
+    const V q = S::constant(p.q);
+    const V n_inv = S::constant(p.n_inv);
+    const V n_inv_shoup = S::constant(shoup_factor(p.n_inv, p.q));
+    for (size_t i = 0; i < size; i += S::WIDTH) {
+        const V scaled = mul_shoup<S>(S::load(x + i), n_inv, n_inv_shoup, q);
+        S::store(out + i, reduce_once<S>(S::add(scaled, S::load(e + i)), q));
+    }
+}
+
+template <typename S>
+CLWE_ALWAYS_INLINE void encapsulate_lanes(const batch::KernelParams& p, const uint8_t* matrix_seeds,
+                                          const uint8_t* noise_seeds, const uint32_t* messages, const uint32_t* t_hat,
+                                          size_t count, uint32_t* ciphertext) {
+    const uint32_t k = p.k;
+    const size_t poly = p.n;
+    const size_t vec = static_cast<size_t>(k) * poly;
+    const size_t wide = poly * L;  // One interleaved polynomial
+    const std::vector<uint32_t> zetas_shoup = shoup_table(p.zetas, p.n, p.q);
+    const std::vector<uint32_t> zetas_inv_shoup = shoup_table(p.zetas_inv, p.n, p.q);
+
+    std::vector<uint32_t> r(k * wide);
+    std::vector<uint32_t> e1(k * wide);
+    std::vector<uint32_t> e2(wide);
+    std::vector<uint32_t> cell(wide);
+    std::vector<uint32_t> t_lanes(k * wide);
+    std::vector<uint32_t> uv((k + 1) * wide);
+    std::vector<uint8_t> stream(L * noise_stream_bytes(p, p.eta2));
+
+    for (size_t first = 0; first < count; first += L) {
+        // A short last group repeats its first instance in the spare lanes and drops them
+        size_t instance[L];
+        const uint8_t* matrix_seed[L];
+        const uint8_t* r_seed[L];
+        const uint8_t* e1_seed[L];
+        const uint8_t* e2_seed[L];
+        for (size_t lane = 0; lane < L; ++lane) {
+            instance[lane] = first + lane < count ? first + lane : first;
+            matrix_seed[lane] = matrix_seeds + instance[lane] * batch::SEED_BYTES;
+            r_seed[lane] = noise_seeds + instance[lane] * batch::INSTANCE_SEED_BYTES;
+            e1_seed[lane] = r_seed[lane] + batch::SEED_BYTES;
+            e2_seed[lane] = r_seed[lane] + 2 * batch::SEED_BYTES;
+        }
+
+        for (size_t c = 0; c < vec; ++c) {
+            for (size_t lane = 0; lane < L; ++lane) {
+                t_lanes[c * L + lane] = t_hat[instance[lane] * vec + c];
+            }
+        }
+        for (uint32_t i = 0; i < k; ++i) {
+            sample_noise_lanes<S>(p, p.eta2, r_seed, i, stream.data(), r.data() + i * wide);
+            sample_noise_lanes<S>(p, p.eta2, e1_seed, i, stream.data(), e1.data() + i * wide);
+            ntt_forward_lanes<S>(p, zetas_shoup.data(), r.data() + i * wide);
+        }
+        sample_noise_lanes<S>(p, p.eta2, e2_seed, 0, stream.data(), e2.data());
+
+        // u_hat[i] = sum_j A_hat[j][i] r_hat[j], one matrix cell in memory at a time;
+        // v_hat = sum_j t_hat[j] r_hat[j]
+        std::fill(uv.begin(), uv.end(), 0);
+        for (uint32_t i = 0; i < k; ++i) {
+            for (uint32_t j = 0; j < k; ++j) {
+                expand_matrix_lanes(p, matrix_seed, j, i, cell.data());
+                multiply_accumulate_lanes<S>(p, cell.data(), r.data() + j * wide, uv.data() + i * wide, wide);
+            }
+        }
+        for (uint32_t j = 0; j < k; ++j) {
+            multiply_accumulate_lanes<S>(p, t_lanes.data() + j * wide, r.data() + j * wide, uv.data() + k * wide,
+                                         wide);
+        }
+
+        // c1 = u + e1, c2 = v + e2 + message * floor(q / 2) * x^0
+        for (uint32_t row = 0; row <= k; ++row) {
+            ntt_inverse_lanes<S>(p, zetas_inv_shoup.data(), uv.data() + row * wide);
+        }
+        scale_add_lanes<S>(p, uv.data(), e1.data(), uv.data(), k * wide);
+        uint32_t* v = uv.data() + k * wide;
+        scale_add_lanes<S>(p, v, e2.data(), v, wide);
+        for (size_t lane = 0; lane < L; ++lane) {
+            v[lane] = (v[lane] + messages[instance[lane]] * (p.q / 2)) % p.q;
+        }
+        if (p.sparse_c2) {
+            std::fill(v + L, v + wide, 0);
+        }
+
+        for (size_t lane = 0; lane < L && first + lane < count; ++lane) {
+            uint32_t* out = ciphertext + (first + lane) * (vec + poly);
+            for (size_t c = 0; c < vec + poly; ++c) {
+                out[c] = uv[c * L + lane];
+            }
+        }
+    }
+    secure_zero(r.data(), r.size() * sizeof(uint32_t));
+    secure_zero(e1.data(), e1.size() * sizeof(uint32_t));
+    secure_zero(e2.data(), e2.size() * sizeof(uint32_t));
+    secure_zero(uv.data(), uv.size() * sizeof(uint32_t));
+}
+
+#ifdef HAVE_AVX2
+CLWE_TARGET_AVX2 void encapsulate_lanes_avx2(const batch::KernelParams& p, const uint8_t* matrix_seeds,
+                                             const uint8_t* noise_seeds, const uint32_t* messages,
+                                             const uint32_t* t_hat, size_t count, uint32_t* ciphertext) {
+    encapsulate_lanes<AVX2Lanes>(p, matrix_seeds, noise_seeds, messages, t_hat, count, ciphertext);
+}
+#endif
+
+} // namespace
+
+void run_encapsulate_batch_lanes(const batch::KernelParams& p, const uint8_t* matrix_seeds, const uint8_t* noise_seeds,
+                                 const uint32_t* messages, const uint32_t* t_hat, size_t count, uint32_t* ciphertext) {
+#ifdef HAVE_AVX2
+    static const bool avx2 = CPUFeatureDetector::cached().has_avx2;
+    if (avx2) {
+        encapsulate_lanes_avx2(p, matrix_seeds, noise_seeds, messages, t_hat, count, ciphertext);
+        return;
+    }
+#endif
+    encapsulate_lanes<ScalarLanes>(p, matrix_seeds, noise_seeds, messages, t_hat, count, ciphertext);
+}
+
+} // namespace clwe
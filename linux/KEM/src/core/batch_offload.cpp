@@ -0,0 +1,164 @@
+#include "batch_offload.hpp"
+#include "ntt_tables.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace clwe {
+
+bool batch_device_available(BatchDevice device) {
+    switch (device) {
+        case BatchDevice::Cpu: return true;
+        case BatchDevice::Cuda:
+#ifdef CLWE_HAVE_CUDA
+            return cuda_batch_device_count() > 0;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+const char* batch_device_name(BatchDevice device) {
+    switch (device) {
+        case BatchDevice::Cpu: return "cpu";
+        case BatchDevice::Cuda: return "cuda";
+    }
+    return "unknown";
+}
+
+bool parse_batch_device(const std::string& name, BatchDevice& device) {
+    if (name == "cpu") device = BatchDevice::Cpu;
+    else if (name == "cuda") device = BatchDevice::Cuda;
+    else return false;
+    return true;
+}
+
+bool batch_kernels_support(const CLWEParameters& params) {
+    auto cbd = [&](uint32_t eta) { return (eta == 2 || eta == 3) && params.modulus > eta; };
+    return cbd(params.eta1) && cbd(params.eta2) && params.degree % 64 == 0 && params.modulus < (1u << 16) &&
+           params.xof == XofAlgorithm::SHAKE128 && !params.shared_matrix;
+}
+
+batch::KernelParams batch_kernel_params(const CLWEParameters& params) {
+    NTTTableView tables = ntt_tables(params.modulus, params.degree);
+    batch::KernelParams p{};
+    p.q = params.modulus;
+    p.n = params.degree;
+    p.k = params.module_rank;
+    while ((1u << p.log_n) < p.n) {
+        ++p.log_n;
+    }
+    p.eta1 = params.eta1;
+    p.eta2 = params.eta2;
+    p.n_inv = mod_inverse(params.degree, params.modulus);
+    p.matrix_bound = std::min<uint32_t>(params.modulus, 4096);
+    p.sparse_c2 = params.sparse_c2;
+    p.zetas = tables.zetas;
+    p.zetas_inv = tables.zetas_inv;
+    return p;
+}
+
+void run_keygen_batch_host(const batch::KernelParams& p, const uint8_t* seeds, size_t count, uint32_t* t_hat,
+                           uint32_t* s_hat) {
+    const size_t poly = p.n;
+    const size_t vec = static_cast<size_t>(p.k) * poly;
+    std::vector<uint32_t> a(p.k * vec);
+    std::vector<uint32_t> e(vec);
+    for (size_t inst = 0; inst < count; ++inst) {
+        const uint8_t* seed = seeds + inst * batch::INSTANCE_SEED_BYTES;
+        uint32_t* s = s_hat + inst * vec;
+        for (uint32_t i = 0; i < p.k; ++i) {
+            for (uint32_t j = 0; j < p.k; ++j) {
+                batch::expand_matrix_poly(p, seed, i, j, a.data() + (i * p.k + j) * poly);
+            }
+            batch::sample_noise_poly(p, p.eta1, seed + batch::SEED_BYTES, i, s + i * poly);
+            batch::sample_noise_poly(p, p.eta1, seed + 2 * batch::SEED_BYTES, i, e.data() + i * poly);
+            batch::ntt_forward_poly(p, s + i * poly);
+            batch::ntt_forward_poly(p, e.data() + i * poly);
+        }
+        for (uint32_t i = 0; i < p.k; ++i) {
+            for (uint32_t c = 0; c < p.n; ++c) {
+                batch::keygen_combine_coeff(p, a.data(), s, e.data(), i, c, t_hat + inst * vec);
+            }
+        }
+    }
+}
+
+void run_encapsulate_batch_host(const batch::KernelParams& p, const uint8_t* matrix_seeds, const uint8_t* noise_seeds,
+                                const uint32_t* messages, const uint32_t* t_hat, size_t count, uint32_t* ciphertext) {
+    const size_t poly = p.n;
+    const size_t vec = static_cast<size_t>(p.k) * poly;
+    std::vector<uint32_t> a_trans(p.k * vec);
+    std::vector<uint32_t> r(vec);
+    std::vector<uint32_t> e1(vec);
+    std::vector<uint32_t> e2(poly);
+    std::vector<uint32_t> uv(vec + poly);
+    for (size_t inst = 0; inst < count; ++inst) {
+        const uint8_t* matrix_seed = matrix_seeds + inst * batch::SEED_BYTES;
+        const uint8_t* seed = noise_seeds + inst * batch::INSTANCE_SEED_BYTES;
+        for (uint32_t i = 0; i < p.k; ++i) {
+            // Position (i, j) of A_hat^T is stream (j, i)
+            for (uint32_t j = 0; j < p.k; ++j) {
+                batch::expand_matrix_poly(p, matrix_seed, j, i, a_trans.data() + (i * p.k + j) * poly);
+            }
+            batch::sample_noise_poly(p, p.eta2, seed, i, r.data() + i * poly);
+            batch::sample_noise_poly(p, p.eta2, seed + batch::SEED_BYTES, i, e1.data() + i * poly);
+            batch::ntt_forward_poly(p, r.data() + i * poly);
+        }
+        batch::sample_noise_poly(p, p.eta2, seed + 2 * batch::SEED_BYTES, 0, e2.data());
+
+        for (uint32_t row = 0; row <= p.k; ++row) {
+            for (uint32_t c = 0; c < p.n; ++c) {
+                batch::encapsulate_product_coeff(p, a_trans.data(), t_hat + inst * vec, r.data(), row, c, uv.data());
+            }
+            batch::ntt_inverse_poly(p, uv.data() + row * poly);
+        }
+        for (uint32_t row = 0; row <= p.k; ++row) {
+            for (uint32_t c = 0; c < p.n; ++c) {
+                batch::encapsulate_finish_coeff(p, uv.data(), e1.data(), e2.data(), messages[inst], row, c,
+                                                ciphertext + inst * (vec + poly));
+            }
+        }
+    }
+}
+
+void run_keygen_batch(BatchDevice device, const GpuBatchConfig& config, const batch::KernelParams& p,
+                      const uint8_t* seeds, size_t count, uint32_t* t_hat, uint32_t* s_hat) {
+    switch (device) {
+        case BatchDevice::Cpu:
+            run_keygen_batch_host(p, seeds, count, t_hat, s_hat);
+            return;
+        case BatchDevice::Cuda:
+#ifdef CLWE_HAVE_CUDA
+            run_keygen_batch_cuda(config, p, seeds, count, t_hat, s_hat);
+            return;
+#else
+            (void)config;
+            break;
+#endif
+    }
+    throw std::logic_error(std::string("Batch device not compiled in: ") + batch_device_name(device));
+}
+
+void run_encapsulate_batch(BatchDevice device, const GpuBatchConfig& config, const batch::KernelParams& p,
+                           const uint8_t* matrix_seeds, const uint8_t* noise_seeds, const uint32_t* messages,
+                           const uint32_t* t_hat, size_t count, uint32_t* ciphertext) {
+    switch (device) {
+        case BatchDevice::Cpu:
+            run_encapsulate_batch_lanes(p, matrix_seeds, noise_seeds, messages, t_hat, count, ciphertext);
+            return;
+        case BatchDevice::Cuda:
+#ifdef CLWE_HAVE_CUDA
+            run_encapsulate_batch_cuda(config, p, matrix_seeds, noise_seeds, messages, t_hat, count, ciphertext);
+            return;
+#else
+            (void)config;
+            break;
+#endif
+    }
+    throw std::logic_error(std::string("Batch device not compiled in: ") + batch_device_name(device));
+}
+
+} // namespace clwe
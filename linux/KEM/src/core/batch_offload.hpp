@@ -0,0 +1,61 @@
+#ifndef BATCH_OFFLOAD_HPP
+#define BATCH_OFFLOAD_HPP
+
+#include "batch_kernels.hpp"
+#include "clwe/batch_device.hpp"
+#include "clwe/clwe.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace clwe {
+
+// Whether the kernels cover params: CBD with eta 2 or 3 on whole 64-coefficient blocks (the
+// sampling every built-in level uses), q < 2^16 and the SHAKE xof (they run Keccak only),
+// with per-key matrix seeds (they expand A themselves, so never for shared_matrix);
+// anything else stays on the CPU
+bool batch_kernels_support(const CLWEParameters& params);
+
+// Kernel view of params with host table pointers
+batch::KernelParams batch_kernel_params(const CLWEParameters& params);
+
+// Lattice core of count key generations. seeds holds INSTANCE_SEED_BYTES per instance
+// (matrix || secret || error); t_hat and s_hat receive k * n residues per instance.
+void run_keygen_batch_host(const batch::KernelParams& p, const uint8_t* seeds, size_t count, uint32_t* t_hat,
+                           uint32_t* s_hat);
+
+// Lattice core of count encapsulations: per instance a 32-byte matrix seed, INSTANCE_SEED_BYTES
+// of noise seeds (r || e1 || e2), a message bit and k * n residues of t_hat in;
+// (k + 1) * n residues of c1 || c2 out
+void run_encapsulate_batch_host(const batch::KernelParams& p, const uint8_t* matrix_seeds, const uint8_t* noise_seeds,
+                                const uint32_t* messages, const uint32_t* t_hat, size_t count, uint32_t* ciphertext);
+
+// Requests run_encapsulate_batch_lanes() handles in lockstep
+constexpr size_t BATCH_LANES = 8;
+
+// run_encapsulate_batch_host() on groups of BATCH_LANES requests interleaved coefficient by
+// coefficient, one request per vector lane (batch_lanes.cpp); same inputs and outputs
+void run_encapsulate_batch_lanes(const batch::KernelParams& p, const uint8_t* matrix_seeds, const uint8_t* noise_seeds,
+                                 const uint32_t* messages, const uint32_t* t_hat, size_t count, uint32_t* ciphertext);
+
+// The host or CUDA variant, by device; the host runs encapsulations on the lane layout
+void run_keygen_batch(BatchDevice device, const GpuBatchConfig& config, const batch::KernelParams& p,
+                      const uint8_t* seeds, size_t count, uint32_t* t_hat, uint32_t* s_hat);
+void run_encapsulate_batch(BatchDevice device, const GpuBatchConfig& config, const batch::KernelParams& p,
+                           const uint8_t* matrix_seeds, const uint8_t* noise_seeds, const uint32_t* messages,
+                           const uint32_t* t_hat, size_t count, uint32_t* ciphertext);
+
+#ifdef CLWE_HAVE_CUDA
+// The same on a CUDA device (src/cuda/batch_kernels.cu), launch by launch through pinned
+// staging buffers; p carries host tables, which are copied to the device once per call.
+// Throw std::runtime_error on CUDA errors.
+int cuda_batch_device_count();
+void run_keygen_batch_cuda(const GpuBatchConfig& config, const batch::KernelParams& p, const uint8_t* seeds,
+                           size_t count, uint32_t* t_hat, uint32_t* s_hat);
+void run_encapsulate_batch_cuda(const GpuBatchConfig& config, const batch::KernelParams& p,
+                                const uint8_t* matrix_seeds, const uint8_t* noise_seeds, const uint32_t* messages,
+                                const uint32_t* t_hat, size_t count, uint32_t* ciphertext);
+#endif
+
+} // namespace clwe
+
+#endif // BATCH_OFFLOAD_HPP
@@ -0,0 +1,683 @@
+#include "benchmark_report.hpp"
+#include "cpu_features.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#if defined(__linux__)
+#include <fstream>
+#include <sched.h>
+#elif defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#endif
+
+// Filled in by CMake for this file only
+#ifndef CLWE_BUILD_FLAGS
+#define CLWE_BUILD_FLAGS ""
+#endif
+#ifndef CLWE_BUILD_TYPE
+#define CLWE_BUILD_TYPE ""
+#endif
+#ifndef CLWE_GIT_COMMIT
+#define CLWE_GIT_COMMIT "unknown"
+#endif
+
+namespace clwe {
+
+namespace {
+
+const char* const kCsvHeader = "name,iterations,mean_us,stddev_us,min_us,p50_us,p99_us,max_us,ops_per_sec";
+
+void write_json_string(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec
+                << std::setfill(' ');
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+// Recursive-descent reader for the subset of JSON write_report_json produces, skipping unknown keys
+class JsonReader {
+private:
+    std::string text_;
+    size_t pos_ = 0;
+
+    [[noreturn]] void fail(const std::string& what) const {
+        throw std::runtime_error("Malformed benchmark JSON at offset " + std::to_string(pos_) + ": " + what);
+    }
+
+    void skip_whitespace() {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) {
+            ++pos_;
+        }
+    }
+
+    char peek() {
+        skip_whitespace();
+        if (pos_ >= text_.size()) {
+            fail("unexpected end of input");
+        }
+        return text_[pos_];
+    }
+
+    void expect(char c) {
+        if (peek() != c) {
+            fail(std::string("expected '") + c + "'");
+        }
+        ++pos_;
+    }
+
+    bool consume(char c) {
+        if (peek() == c) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+public:
+    explicit JsonReader(std::string text) : text_(std::move(text)) {}
+
+    std::string read_string() {
+        expect('"');
+        std::string value;
+        while (pos_ < text_.size() && text_[pos_] != '"') {
+            char c = text_[pos_++];
+            if (c != '\\') {
+                value += c;
+                continue;
+            }
+            if (pos_ >= text_.size()) {
+                fail("unterminated escape");
+            }
+            char escaped = text_[pos_++];
+            switch (escaped) {
+                case 'n': value += '\n'; break;
+                case 't': value += '\t'; break;
+                case 'r': value += '\r'; break;
+                case 'u': {
+                    if (pos_ + 4 > text_.size()) {
+                        fail("short \\u escape");
+                    }
+                    value += static_cast<char>(std::strtol(text_.substr(pos_, 4).c_str(), nullptr, 16));
+                    pos_ += 4;
+                    break;
+                }
+                default: value += escaped; break;
+            }
+        }
+        if (pos_ >= text_.size()) {
+            fail("unterminated string");
+        }
+        ++pos_;
+        return value;
+    }
+
+    double read_number() {
+        skip_whitespace();
+        const char* begin = text_.c_str() + pos_;
+        char* end = nullptr;
+        double value = std::strtod(begin, &end);
+        if (end == begin) {
+            fail("expected a number");
+        }
+        pos_ += static_cast<size_t>(end - begin);
+        return value;
+    }
+
+    void skip_value() {
+        char c = peek();
+        if (c == '"') {
+            read_string();
+        } else if (c == '{') {
+            for_each_member([this](const std::string&) { skip_value(); });
+        } else if (c == '[') {
+            for_each_element([this] { skip_value(); });
+        } else if (std::isalpha(static_cast<unsigned char>(c))) {
+            while (pos_ < text_.size() && std::isalpha(static_cast<unsigned char>(text_[pos_]))) {
+                ++pos_;
+            }
+        } else {
+            read_number();
+        }
+    }
+
+    template <typename OnMember>
+    void for_each_member(OnMember on_member) {
+        expect('{');
+        if (consume('}')) {
+            return;
+        }
+        do {
+            std::string key = read_string();
+            expect(':');
+            on_member(key);
+        } while (consume(','));
+        expect('}');
+    }
+
+    template <typename OnElement>
+    void for_each_element(OnElement on_element) {
+        expect('[');
+        if (consume(']')) {
+            return;
+        }
+        do {
+            on_element();
+        } while (consume(','));
+        expect(']');
+    }
+
+    void finish() {
+        skip_whitespace();
+        if (pos_ != text_.size()) {
+            fail("trailing characters");
+        }
+    }
+};
+
+BenchmarkReport read_report_json(const std::string& text) {
+    BenchmarkReport report;
+    JsonReader reader(text);
+    reader.for_each_member([&](const std::string& section) {
+        if (section == "environment") {
+            reader.for_each_member([&](const std::string& key) {
+                BenchmarkEnvironment& env = report.environment;
+                if (key == "cpu") env.cpu = reader.read_string();
+                else if (key == "compiler") env.compiler = reader.read_string();
+                else if (key == "flags") env.flags = reader.read_string();
+                else if (key == "build_type") env.build_type = reader.read_string();
+                else if (key == "commit") env.commit = reader.read_string();
+                else if (key == "host") env.host = reader.read_string();
+                else reader.skip_value();
+            });
+        } else if (section == "results") {
+            reader.for_each_element([&] {
+                BenchmarkRecord record;
+                reader.for_each_member([&](const std::string& key) {
+                    if (key == "name") record.name = reader.read_string();
+                    else if (key == "iterations") record.iterations = static_cast<uint64_t>(reader.read_number());
+                    else if (key == "mean_us") record.mean_us = reader.read_number();
+                    else if (key == "stddev_us") record.stddev_us = reader.read_number();
+                    else if (key == "min_us") record.min_us = reader.read_number();
+                    else if (key == "p50_us") record.p50_us = reader.read_number();
+                    else if (key == "p99_us") record.p99_us = reader.read_number();
+                    else if (key == "max_us") record.max_us = reader.read_number();
+                    else if (key == "ops_per_sec") record.ops_per_sec = reader.read_number();
+                    else reader.skip_value();
+                });
+                report.records.push_back(record);
+            });
+        } else {
+            reader.skip_value();
+        }
+    });
+    reader.finish();
+    return report;
+}
+
+BenchmarkReport read_report_csv(std::istream& in) {
+    BenchmarkReport report;
+    std::string line;
+    bool header_seen = false;
+    size_t line_number = 0;
+    while (std::getline(in, line)) {
+        ++line_number;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            continue;
+        }
+        if (line[0] == '#') {
+            size_t colon = line.find(':');
+            if (colon == std::string::npos) {
+                continue;
+            }
+            std::string key = line.substr(1, colon - 1);
+            key.erase(0, key.find_first_not_of(' '));
+            std::string value = colon + 2 <= line.size() ? line.substr(colon + 2) : std::string();
+            BenchmarkEnvironment& env = report.environment;
+            if (key == "cpu") env.cpu = value;
+            else if (key == "compiler") env.compiler = value;
+            else if (key == "flags") env.flags = value;
+            else if (key == "build_type") env.build_type = value;
+            else if (key == "commit") env.commit = value;
+            else if (key == "host") env.host = value;
+            continue;
+        }
+        if (!header_seen) {
+            if (line != kCsvHeader) {
+                throw std::runtime_error("Unexpected benchmark CSV header on line " + std::to_string(line_number));
+            }
+            header_seen = true;
+            continue;
+        }
+
+        std::vector<std::string> fields;
+        std::stringstream row(line);
+        std::string field;
+        while (std::getline(row, field, ',')) {
+            fields.push_back(field);
+        }
+        if (fields.size() != 9) {
+            throw std::runtime_error("Expected 9 benchmark CSV fields on line " + std::to_string(line_number) +
+                                     ", got " + std::to_string(fields.size()));
+        }
+        try {
+            BenchmarkRecord record;
+            record.name = fields[0];
+            record.iterations = std::stoull(fields[1]);
+            record.mean_us = std::stod(fields[2]);
+            record.stddev_us = std::stod(fields[3]);
+            record.min_us = std::stod(fields[4]);
+            record.p50_us = std::stod(fields[5]);
+            record.p99_us = std::stod(fields[6]);
+            record.max_us = std::stod(fields[7]);
+            record.ops_per_sec = std::stod(fields[8]);
+            report.records.push_back(record);
+        } catch (const std::logic_error&) {
+            throw std::runtime_error("Invalid number in benchmark CSV line " + std::to_string(line_number));
+        }
+    }
+    if (!header_seen) {
+        throw std::runtime_error("Benchmark CSV has no header row");
+    }
+    return report;
+}
+
+#if defined(__linux__)
+std::string read_line(const std::string& path) {
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+// Kernel list format: "0-3,8"
+std::vector<unsigned> parse_cpu_list(const std::string& text) {
+    std::vector<unsigned> cpus;
+    std::stringstream list(text);
+    std::string range;
+    while (std::getline(list, range, ',')) {
+        if (range.empty() || range.find_first_not_of("0123456789-") != std::string::npos) {
+            continue;
+        }
+        size_t dash = range.find('-');
+        unsigned first = static_cast<unsigned>(std::stoul(range.substr(0, dash)));
+        unsigned last = dash == std::string::npos ? first : static_cast<unsigned>(std::stoul(range.substr(dash + 1)));
+        for (unsigned cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+// Busy and total jiffies per CPU from /proc/stat; busy excludes idle and iowait
+struct CpuTimes {
+    uint64_t busy = 0;
+    uint64_t total = 0;
+};
+
+std::vector<CpuTimes> read_cpu_times() {
+    std::vector<CpuTimes> times;
+    std::ifstream stat("/proc/stat");
+    std::string line;
+    while (std::getline(stat, line)) {
+        if (line.compare(0, 3, "cpu") != 0 || line.size() < 4 || !std::isdigit(static_cast<unsigned char>(line[3]))) {
+            continue;
+        }
+        std::istringstream fields(line.substr(3));
+        size_t cpu = 0;
+        fields >> cpu;
+        CpuTimes entry;
+        uint64_t value = 0;
+        for (int column = 0; column < 8 && fields >> value; ++column) {
+            entry.total += value;
+            if (column != 3 && column != 4) {
+                entry.busy += value;
+            }
+        }
+        if (times.size() <= cpu) {
+            times.resize(cpu + 1);
+        }
+        times[cpu] = entry;
+    }
+    return times;
+}
+#endif
+
+} // namespace
+
+BenchmarkHostState BenchmarkHostState::inspect(std::chrono::milliseconds window) {
+    BenchmarkHostState state;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    std::vector<unsigned> allowed;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                allowed.push_back(cpu);
+            }
+        }
+    }
+
+    // The governor of every CPU the thread may run on
+    for (unsigned cpu : allowed) {
+        std::string governor =
+            read_line("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cpufreq/scaling_governor");
+        if (governor.empty()) {
+            continue;
+        }
+        if (state.governor.empty()) {
+            state.governor = governor;
+        } else if (state.governor != governor) {
+            state.governor = "mixed";
+        }
+    }
+
+    // intel_pstate inverts the sense; acpi-cpufreq and amd-pstate use boost
+    std::string no_turbo = read_line("/sys/devices/system/cpu/intel_pstate/no_turbo");
+    std::string boost = read_line("/sys/devices/system/cpu/cpufreq/boost");
+    if (no_turbo == "0" || no_turbo == "1") {
+        state.turbo = no_turbo == "0" ? 1 : 0;
+    } else if (boost == "0" || boost == "1") {
+        state.turbo = boost == "1" ? 1 : 0;
+    }
+
+    if (allowed.size() != 1) {
+        return state;
+    }
+    state.pinned_cpu = static_cast<int>(allowed[0]);
+    for (unsigned cpu : parse_cpu_list(read_line("/sys/devices/system/cpu/cpu" + std::to_string(allowed[0]) +
+                                                 "/topology/thread_siblings_list"))) {
+        if (cpu != allowed[0]) {
+            state.smt_siblings.push_back(cpu);
+        }
+    }
+    if (state.smt_siblings.empty()) {
+        state.sibling_busy = 0;
+        return state;
+    }
+
+    std::vector<CpuTimes> before = read_cpu_times();
+    std::this_thread::sleep_for(window);
+    std::vector<CpuTimes> after = read_cpu_times();
+    uint64_t busy = 0;
+    uint64_t total = 0;
+    for (unsigned cpu : state.smt_siblings) {
+        if (cpu < before.size() && cpu < after.size()) {
+            busy += after[cpu].busy - before[cpu].busy;
+            total += after[cpu].total - before[cpu].total;
+        }
+    }
+    if (total > 0) {
+        state.sibling_busy = static_cast<double>(busy) / static_cast<double>(total);
+    }
+#else
+    (void)window;
+#endif
+    return state;
+}
+
+std::string BenchmarkHostState::to_string() const {
+    std::ostringstream text;
+    text << "governor=" << (governor.empty() ? "unknown" : governor)
+         << " turbo=" << (turbo < 0 ? "unknown" : turbo ? "on" : "off");
+    if (pinned_cpu >= 0) {
+        text << " cpu=" << pinned_cpu << " smt_siblings=" << smt_siblings.size();
+    } else {
+        text << " cpu=unpinned";
+    }
+    if (sibling_busy >= 0) {
+        text << " sibling_busy=" << std::fixed << std::setprecision(2) << sibling_busy;
+    }
+    return text.str();
+}
+
+std::vector<std::string> BenchmarkHostState::warnings() const {
+    std::vector<std::string> lines;
+    if (!governor.empty() && governor != "performance") {
+        lines.push_back("CPU frequency governor is '" + governor + "', not 'performance'");
+    }
+    if (turbo == 1) {
+        lines.push_back("Turbo boost is on; clock speed follows temperature and load");
+    }
+    if (pinned_cpu < 0) {
+        lines.push_back("Benchmark thread is not pinned to a CPU (--pin-cpu=N)");
+    }
+    if (sibling_busy > 0.05) {
+        std::ostringstream line;
+        line << "SMT sibling(s) of CPU " << pinned_cpu << " were " << std::fixed << std::setprecision(0)
+             << sibling_busy * 100.0 << "% busy; pick a CPU whose siblings are idle";
+        lines.push_back(line.str());
+    }
+    return lines;
+}
+
+bool pin_current_thread(unsigned cpu) {
+#if defined(__linux__)
+    if (cpu >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+    if (cpu >= sizeof(DWORD_PTR) * 8) {
+        return false;
+    }
+    return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) != 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+BenchmarkEnvironment BenchmarkEnvironment::current() {
+    BenchmarkEnvironment env;
+    env.cpu = CPUFeatureDetector::cached().to_string();
+#if defined(__clang__)
+    env.compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+    env.compiler = "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+    env.compiler = "msvc " + std::to_string(_MSC_VER);
+#else
+    env.compiler = "unknown";
+#endif
+    env.flags = CLWE_BUILD_FLAGS;
+    env.build_type = CLWE_BUILD_TYPE;
+    env.commit = CLWE_GIT_COMMIT;
+    return env;
+}
+
+BenchmarkRecord BenchmarkRecord::from_timing(const std::string& name, const TimingStats& timing,
+                                             uint64_t iterations) {
+    BenchmarkRecord record;
+    record.name = name;
+    record.iterations = iterations;
+    record.mean_us = timing.average_time;
+    record.stddev_us = timing.stddev_time;
+    record.min_us = timing.min_time;
+    record.p50_us = timing.p50_time;
+    record.p99_us = timing.p99_time;
+    record.max_us = timing.max_time;
+    return record;
+}
+
+void write_report_json(std::ostream& out, const BenchmarkReport& report) {
+    const BenchmarkEnvironment& env = report.environment;
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision(10);
+
+    out << "{\n  \"environment\": {";
+    out << "\n    \"cpu\": ";
+    write_json_string(out, env.cpu);
+    out << ",\n    \"compiler\": ";
+    write_json_string(out, env.compiler);
+    out << ",\n    \"flags\": ";
+    write_json_string(out, env.flags);
+    out << ",\n    \"build_type\": ";
+    write_json_string(out, env.build_type);
+    out << ",\n    \"commit\": ";
+    write_json_string(out, env.commit);
+    out << ",\n    \"host\": ";
+    write_json_string(out, env.host);
+    out << "\n  },\n  \"results\": [";
+    for (size_t i = 0; i < report.records.size(); ++i) {
+        const BenchmarkRecord& record = report.records[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\"name\": ";
+        write_json_string(out, record.name);
+        out << ", \"iterations\": " << record.iterations
+            << ", \"mean_us\": " << record.mean_us
+            << ", \"stddev_us\": " << record.stddev_us
+            << ", \"min_us\": " << record.min_us
+            << ", \"p50_us\": " << record.p50_us
+            << ", \"p99_us\": " << record.p99_us
+            << ", \"max_us\": " << record.max_us
+            << ", \"ops_per_sec\": " << record.ops_per_sec << "}";
+    }
+    out << (report.records.empty() ? "]\n}\n" : "\n  ]\n}\n");
+
+    out.precision(precision);
+    out.flags(flags);
+}
+
+void write_report_csv(std::ostream& out, const BenchmarkReport& report) {
+    const BenchmarkEnvironment& env = report.environment;
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision(10);
+
+    out << "# cpu: " << env.cpu << "\n"
+        << "# compiler: " << env.compiler << "\n"
+        << "# flags: " << env.flags << "\n"
+        << "# build_type: " << env.build_type << "\n"
+        << "# commit: " << env.commit << "\n"
+        << "# host: " << env.host << "\n"
+        << kCsvHeader << "\n";
+    for (const BenchmarkRecord& record : report.records) {
+        out << record.name << ',' << record.iterations << ',' << record.mean_us << ',' << record.stddev_us << ','
+            << record.min_us << ',' << record.p50_us << ',' << record.p99_us << ',' << record.max_us << ','
+            << record.ops_per_sec << "\n";
+    }
+
+    out.precision(precision);
+    out.flags(flags);
+}
+
+BenchmarkReport read_report(std::istream& in) {
+    std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    size_t first = text.find_first_not_of(" \t\r\n");
+    if (first != std::string::npos && text[first] == '{') {
+        return read_report_json(text);
+    }
+    std::istringstream csv(text);
+    return read_report_csv(csv);
+}
+
+std::vector<BenchmarkComparison> compare_reports(const BenchmarkReport& baseline, const BenchmarkReport& candidate,
+                                                 const BenchmarkCompareOptions& options) {
+    std::vector<BenchmarkComparison> comparisons;
+    for (const BenchmarkRecord& base : baseline.records) {
+        auto it = std::find_if(candidate.records.begin(), candidate.records.end(),
+                               [&base](const BenchmarkRecord& record) { return record.name == base.name; });
+        if (it == candidate.records.end()) {
+            continue;
+        }
+        const BenchmarkRecord& cand = *it;
+
+        BenchmarkComparison comparison;
+        comparison.name = base.name;
+        comparison.baseline_mean_us = base.mean_us;
+        comparison.candidate_mean_us = cand.mean_us;
+        comparison.change = base.mean_us > 0 ? (cand.mean_us - base.mean_us) / base.mean_us : 0.0;
+
+        // Welch's t statistic; sample counts are large enough for the normal tail
+        double variance = 0;
+        if (base.iterations > 0) {
+            variance += base.stddev_us * base.stddev_us / static_cast<double>(base.iterations);
+        }
+        if (cand.iterations > 0) {
+            variance += cand.stddev_us * cand.stddev_us / static_cast<double>(cand.iterations);
+        }
+        double difference = cand.mean_us - base.mean_us;
+        if (variance > 0) {
+            comparison.p_value = std::erfc(std::fabs(difference) / std::sqrt(variance) / std::sqrt(2.0));
+        } else {
+            comparison.p_value = difference == 0 ? 1.0 : 0.0;
+        }
+
+        bool significant = comparison.p_value < options.alpha && std::fabs(comparison.change) >= options.min_change;
+        comparison.regression = significant && difference > 0;
+        comparison.improvement = significant && difference < 0;
+        comparisons.push_back(comparison);
+    }
+    return comparisons;
+}
+
+std::vector<BenchmarkRepeatSummary> summarize_repeats(const std::vector<BenchmarkReport>& runs) {
+    std::vector<BenchmarkRepeatSummary> summaries;
+    if (runs.empty()) {
+        return summaries;
+    }
+    for (const BenchmarkRecord& first : runs.front().records) {
+        std::vector<const BenchmarkRecord*> records;
+        for (const BenchmarkReport& run : runs) {
+            auto it = std::find_if(run.records.begin(), run.records.end(),
+                                   [&first](const BenchmarkRecord& record) { return record.name == first.name; });
+            if (it != run.records.end()) {
+                records.push_back(&*it);
+            }
+        }
+        std::sort(records.begin(), records.end(),
+                  [](const BenchmarkRecord* a, const BenchmarkRecord* b) { return a->mean_us < b->mean_us; });
+
+        BenchmarkRepeatSummary summary;
+        summary.name = first.name;
+        summary.runs = records.size();
+        summary.min_us = records.front()->mean_us;
+        summary.max_us = records.back()->mean_us;
+        summary.median = *records[(records.size() - 1) / 2];
+
+        double sum = 0;
+        double sum_squares = 0;
+        for (const BenchmarkRecord* record : records) {
+            sum += record->mean_us;
+            sum_squares += record->mean_us * record->mean_us;
+        }
+        double n = static_cast<double>(records.size());
+        summary.mean_us = sum / n;
+        if (records.size() > 1 && summary.mean_us > 0) {
+            // Sample standard deviation: the runs estimate the spread of a future run
+            double variance = std::max(0.0, (sum_squares - sum * sum / n) / (n - 1));
+            summary.cv = std::sqrt(variance) / summary.mean_us;
+        }
+        summaries.push_back(summary);
+    }
+    return summaries;
+}
+
+} // namespace clwe
@@ -0,0 +1,113 @@
+#ifndef BENCHMARK_REPORT_HPP
+#define BENCHMARK_REPORT_HPP
+
+#include "performance_metrics.hpp"
+#include <chrono>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace clwe {
+
+// Where a benchmark ran; current() fills it from the CPU and the build
+struct BenchmarkEnvironment {
+    std::string cpu;         // CPUFeatures::to_string()
+    std::string compiler;
+    std::string flags;       // C++ flags of the build type the library was compiled with
+    std::string build_type;
+    std::string commit;      // git revision at configure time, "unknown" outside a checkout
+    std::string host;        // BenchmarkHostState::to_string() of the run, empty if not inspected
+
+    static BenchmarkEnvironment current();
+};
+
+// Frequency scaling and scheduling state that moves benchmark numbers, from Linux sysfs
+// and /proc/stat; fields stay unknown on other platforms
+struct BenchmarkHostState {
+    std::string governor;                // cpufreq scaling_governor, "mixed" if CPUs differ, "" unknown
+    int turbo = -1;                      // 1 turbo/boost on, 0 off, -1 unknown
+    int pinned_cpu = -1;                 // CPU the calling thread is restricted to, -1 if several
+    std::vector<unsigned> smt_siblings;  // Other hardware threads of pinned_cpu's core
+    double sibling_busy = -1;            // Non-idle share of the siblings over the window, -1 unknown
+
+    // Reads the state of the calling thread's CPUs, sampling sibling load for window
+    static BenchmarkHostState inspect(std::chrono::milliseconds window = std::chrono::milliseconds(100));
+
+    // e.g. "governor=performance turbo=off cpu=3 smt_siblings=1 sibling_busy=0.01"
+    std::string to_string() const;
+
+    // One line per condition that makes timings unreliable; empty when the host looks quiet
+    std::vector<std::string> warnings() const;
+};
+
+// Restrict the calling thread (and threads it creates later) to one CPU
+bool pin_current_thread(unsigned cpu);
+
+// Latency summary of one measured operation, in microseconds
+struct BenchmarkRecord {
+    std::string name;  // e.g. "keygen/512"
+    uint64_t iterations = 0;
+    double mean_us = 0;
+    double stddev_us = 0;
+    double min_us = 0;
+    double p50_us = 0;
+    double p99_us = 0;
+    double max_us = 0;
+    double ops_per_sec = 0;  // Aggregate throughput; 0 for single-threaded latency rows
+
+    static BenchmarkRecord from_timing(const std::string& name, const TimingStats& timing, uint64_t iterations);
+};
+
+struct BenchmarkReport {
+    BenchmarkEnvironment environment;
+    std::vector<BenchmarkRecord> records;
+};
+
+// JSON: {"environment":{...},"results":[{...}]}. CSV: "# key: value" environment lines,
+// then a header row and one row per record.
+void write_report_json(std::ostream& out, const BenchmarkReport& report);
+void write_report_csv(std::ostream& out, const BenchmarkReport& report);
+
+// Reads either format back, detected from the first character; throws std::runtime_error
+// on malformed input
+BenchmarkReport read_report(std::istream& in);
+
+// Spread of one operation's mean over repeated runs of the same benchmark
+struct BenchmarkRepeatSummary {
+    std::string name;
+    size_t runs = 0;
+    double mean_us = 0;       // Mean of the run means
+    double min_us = 0;        // Fastest run mean
+    double max_us = 0;        // Slowest run mean
+    double cv = 0;            // Standard deviation of the run means over their mean
+    BenchmarkRecord median;   // The record of the run with the median mean
+};
+
+// Per operation of the first run, in its order; operations missing from a run are skipped there
+std::vector<BenchmarkRepeatSummary> summarize_repeats(const std::vector<BenchmarkReport>& runs);
+
+struct BenchmarkCompareOptions {
+    double alpha = 0.01;        // Two-sided significance level of the mean difference
+    double min_change = 0.05;   // Relative change below which a difference is ignored
+};
+
+// One operation present in both reports
+struct BenchmarkComparison {
+    std::string name;
+    double baseline_mean_us = 0;
+    double candidate_mean_us = 0;
+    double change = 0;    // (candidate - baseline) / baseline
+    double p_value = 1;   // Welch's t-test, normal approximation
+    bool regression = false;
+    bool improvement = false;
+};
+
+// Compare the records both reports share, in baseline order
+std::vector<BenchmarkComparison> compare_reports(const BenchmarkReport& baseline, const BenchmarkReport& candidate,
+                                                 const BenchmarkCompareOptions& options = BenchmarkCompareOptions());
+
+} // namespace clwe
+
+#endif // BENCHMARK_REPORT_HPP
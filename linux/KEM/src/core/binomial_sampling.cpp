@@ -0,0 +1,349 @@
+#include "binomial_sampling.hpp"
+#include "cpu_features.hpp"
+#include "simd_target.hpp"
+
+#if defined(HAVE_AVX2) || defined(HAVE_AVX512BW)
+#include <immintrin.h>
+#endif
+#ifdef HAVE_NEON
+#include <arm_neon.h>
+#endif
+#ifdef HAVE_SVE
+#include "sampling_sve.hpp"
+#endif
+
+namespace clwe {
+
+namespace {
+
+// a - b lifted into [0, modulus) without a branch on the sign
+inline uint32_t lift(int32_t value, uint32_t modulus) {
+    uint32_t negative = static_cast<uint32_t>(value >> 31);
+    return static_cast<uint32_t>(value) + (modulus & negative);
+}
+
+// Eight coefficients from each 32-bit word: pair sums of a and b sit in alternate 2-bit fields
+void cbd2_scalar(uint32_t* out, const uint8_t* buf, uint32_t modulus) {
+    for (size_t w = 0; w < 8; ++w) {
+        uint32_t t = static_cast<uint32_t>(buf[4 * w]) |
+                     (static_cast<uint32_t>(buf[4 * w + 1]) << 8) |
+                     (static_cast<uint32_t>(buf[4 * w + 2]) << 16) |
+                     (static_cast<uint32_t>(buf[4 * w + 3]) << 24);
+        uint32_t d = (t & 0x55555555u) + ((t >> 1) & 0x55555555u);
+        for (size_t j = 0; j < 8; ++j) {
+            int32_t a = static_cast<int32_t>((d >> (4 * j)) & 0x3);
+            int32_t b = static_cast<int32_t>((d >> (4 * j + 2)) & 0x3);
+            out[8 * w + j] = lift(a - b, modulus);
+        }
+    }
+}
+
+// Four coefficients from each 24-bit group, summing three bits at a time
+void cbd3_scalar(uint32_t* out, const uint8_t* buf, uint32_t modulus) {
+    for (size_t g = 0; g < 16; ++g) {
+        uint32_t t = static_cast<uint32_t>(buf[3 * g]) |
+                     (static_cast<uint32_t>(buf[3 * g + 1]) << 8) |
+                     (static_cast<uint32_t>(buf[3 * g + 2]) << 16);
+        uint32_t d = (t & 0x00249249u) + ((t >> 1) & 0x00249249u) + ((t >> 2) & 0x00249249u);
+        for (size_t j = 0; j < 4; ++j) {
+            int32_t a = static_cast<int32_t>((d >> (6 * j)) & 0x7);
+            int32_t b = static_cast<int32_t>((d >> (6 * j + 3)) & 0x7);
+            out[4 * g + j] = lift(a - b, modulus);
+        }
+    }
+}
+
+#ifdef HAVE_AVX2
+bool use_avx2() {
+    static const bool supported = CPUFeatureDetector::cached().has_avx2;
+    return supported;
+}
+
+// Store eight signed coefficients lifted into [0, modulus)
+CLWE_TARGET_AVX2 inline void store_lifted(uint32_t* out, __m256i values, __m256i modulus) {
+    values = _mm256_add_epi32(values, _mm256_and_si256(_mm256_srai_epi32(values, 31), modulus));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), values);
+}
+
+// 32 bytes -> 64 coefficients: each nibble becomes a - b + 2, split into bytes and widened
+CLWE_TARGET_AVX2 void cbd2_avx2(uint32_t* out, const uint8_t* buf, uint32_t q) {
+    const __m256i mask55 = _mm256_set1_epi8(0x55);
+    const __m256i mask33 = _mm256_set1_epi8(0x33);
+    const __m256i mask0f = _mm256_set1_epi8(0x0F);
+    const __m256i offset = _mm256_set1_epi32(2);
+    const __m256i modulus = _mm256_set1_epi32(static_cast<int>(q));
+
+    __m256i f = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(buf));
+    f = _mm256_add_epi8(_mm256_and_si256(f, mask55), _mm256_and_si256(_mm256_srli_epi16(f, 1), mask55));
+    __m256i a = _mm256_and_si256(f, mask33);
+    __m256i b = _mm256_and_si256(_mm256_srli_epi16(f, 2), mask33);
+    // Nibbles of a + 2 never borrow from each other when b (at most 2) is subtracted
+    __m256i d = _mm256_sub_epi8(_mm256_add_epi8(a, _mm256_set1_epi8(0x22)), b);
+
+    __m256i lo = _mm256_and_si256(d, mask0f);
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi16(d, 4), mask0f);
+    // Coefficient 2i comes from the low nibble of byte i, 2i + 1 from the high one
+    __m256i inter_lo = _mm256_unpacklo_epi8(lo, hi);
+    __m256i inter_hi = _mm256_unpackhi_epi8(lo, hi);
+    __m256i first = _mm256_permute2x128_si256(inter_lo, inter_hi, 0x20);
+    __m256i second = _mm256_permute2x128_si256(inter_lo, inter_hi, 0x31);
+
+    const __m256i halves[2] = {first, second};
+    for (size_t h = 0; h < 2; ++h) {
+        __m128i low = _mm256_castsi256_si128(halves[h]);
+        __m128i high = _mm256_extracti128_si256(halves[h], 1);
+        const __m128i parts[4] = {low, _mm_srli_si128(low, 8), high, _mm_srli_si128(high, 8)};
+        for (size_t p = 0; p < 4; ++p) {
+            __m256i values = _mm256_sub_epi32(_mm256_cvtepu8_epi32(parts[p]), offset);
+            store_lifted(out + 32 * h + 8 * p, values, modulus);
+        }
+    }
+}
+
+// 24 bytes -> 32 coefficients per step: one 24-bit group per 32-bit lane, then a 4x8 transpose
+CLWE_TARGET_AVX2 void cbd3_avx2(uint32_t* out, const uint8_t* buf, uint32_t q) {
+    // Lane 0 loads bytes [0, 16) for groups 0-3, lane 1 loads [8, 24) for groups 4-7
+    const __m256i spread = _mm256_setr_epi8(
+        0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+        4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, -1, 13, 14, 15, -1);
+    const __m256i mask249 = _mm256_set1_epi32(0x00249249);
+    const __m256i mask7 = _mm256_set1_epi32(0x7);
+    const __m256i modulus = _mm256_set1_epi32(static_cast<int>(q));
+
+    for (size_t step = 0; step < 2; ++step) {
+        const uint8_t* src = buf + 24 * step;
+        __m256i raw = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 8)), 1);
+        __m256i t = _mm256_shuffle_epi8(raw, spread);
+        __m256i d = _mm256_add_epi32(
+            _mm256_add_epi32(_mm256_and_si256(t, mask249), _mm256_and_si256(_mm256_srli_epi32(t, 1), mask249)),
+            _mm256_and_si256(_mm256_srli_epi32(t, 2), mask249));
+
+        __m256i c[4];
+        for (int j = 0; j < 4; ++j) {
+            __m256i a = _mm256_and_si256(_mm256_srli_epi32(d, 6 * j), mask7);
+            __m256i b = _mm256_and_si256(_mm256_srli_epi32(d, 6 * j + 3), mask7);
+            c[j] = _mm256_sub_epi32(a, b);
+        }
+        // c[j] holds coefficient j of groups 0-7; reorder so each group's four are adjacent
+        __m256i t0 = _mm256_unpacklo_epi32(c[0], c[1]);
+        __m256i t1 = _mm256_unpackhi_epi32(c[0], c[1]);
+        __m256i t2 = _mm256_unpacklo_epi32(c[2], c[3]);
+        __m256i t3 = _mm256_unpackhi_epi32(c[2], c[3]);
+        __m256i r0 = _mm256_unpacklo_epi64(t0, t2);  // groups 0 | 4
+        __m256i r1 = _mm256_unpackhi_epi64(t0, t2);  // groups 1 | 5
+        __m256i r2 = _mm256_unpacklo_epi64(t1, t3);  // groups 2 | 6
+        __m256i r3 = _mm256_unpackhi_epi64(t1, t3);  // groups 3 | 7
+
+        uint32_t* dst = out + 32 * step;
+        store_lifted(dst, _mm256_permute2x128_si256(r0, r1, 0x20), modulus);
+        store_lifted(dst + 8, _mm256_permute2x128_si256(r2, r3, 0x20), modulus);
+        store_lifted(dst + 16, _mm256_permute2x128_si256(r0, r1, 0x31), modulus);
+        store_lifted(dst + 24, _mm256_permute2x128_si256(r2, r3, 0x31), modulus);
+    }
+}
+#endif
+
+#ifdef HAVE_AVX512BW
+bool use_avx512() {
+    static const bool supported = CPUFeatureDetector::cached().has_avx512bw;
+    return supported;
+}
+
+// Sixteen signed coefficients lifted into [0, modulus)
+CLWE_TARGET_AVX512 inline void store_lifted512(uint32_t* out, __m512i values, __m512i modulus) {
+    __mmask16 negative = _mm512_cmplt_epi32_mask(values, _mm512_setzero_si512());
+    _mm512_storeu_si512(out, _mm512_mask_add_epi32(values, negative, values, modulus));
+}
+
+// 64 bytes -> 128 coefficients: the AVX2 nibble scheme over four 128-bit lanes
+CLWE_TARGET_AVX512 void cbd2x2_avx512(uint32_t* out, const uint8_t* buf, uint32_t q) {
+    const __m512i mask55 = _mm512_set1_epi8(0x55);
+    const __m512i mask33 = _mm512_set1_epi8(0x33);
+    const __m512i mask0f = _mm512_set1_epi8(0x0F);
+    const __m512i offset = _mm512_set1_epi32(2);
+    const __m512i modulus = _mm512_set1_epi32(static_cast<int>(q));
+
+    __m512i f = _mm512_loadu_si512(buf);
+    f = _mm512_add_epi8(_mm512_and_si512(f, mask55), _mm512_and_si512(_mm512_srli_epi16(f, 1), mask55));
+    __m512i a = _mm512_and_si512(f, mask33);
+    __m512i b = _mm512_and_si512(_mm512_srli_epi16(f, 2), mask33);
+    __m512i d = _mm512_sub_epi8(_mm512_add_epi8(a, _mm512_set1_epi8(0x22)), b);
+
+    __m512i lo = _mm512_and_si512(d, mask0f);
+    __m512i hi = _mm512_and_si512(_mm512_srli_epi16(d, 4), mask0f);
+    // Lane L of inter_lo holds coefficients 32L..32L+15, inter_hi the next sixteen
+    __m512i inter_lo = _mm512_unpacklo_epi8(lo, hi);
+    __m512i inter_hi = _mm512_unpackhi_epi8(lo, hi);
+
+    const __m128i parts[8] = {
+        _mm512_extracti32x4_epi32(inter_lo, 0), _mm512_extracti32x4_epi32(inter_hi, 0),
+        _mm512_extracti32x4_epi32(inter_lo, 1), _mm512_extracti32x4_epi32(inter_hi, 1),
+        _mm512_extracti32x4_epi32(inter_lo, 2), _mm512_extracti32x4_epi32(inter_hi, 2),
+        _mm512_extracti32x4_epi32(inter_lo, 3), _mm512_extracti32x4_epi32(inter_hi, 3)};
+    for (size_t p = 0; p < 8; ++p) {
+        __m512i values = _mm512_sub_epi32(_mm512_cvtepu8_epi32(parts[p]), offset);
+        store_lifted512(out + 16 * p, values, modulus);
+    }
+}
+
+// Byte spread for cbd3_block_avx512: groups 0-3 of each lane's 16-byte load, offset
+// by 4 in the last lane
+alignas(64) constexpr int8_t CBD3_SPREAD_512[64] = {
+    0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+    0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+    0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+    4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, -1, 13, 14, 15, -1};
+
+// 48 bytes -> 64 coefficients: one 24-bit group per 32-bit lane and a 4x16 transpose
+CLWE_TARGET_AVX512 void cbd3_block_avx512(uint32_t* out, const uint8_t* buf, uint32_t q) {
+    // Lanes 0-2 load 16 bytes at 12L; lane 3 loads at 32 so the read stays inside the block
+    const __m512i spread = _mm512_loadu_si512(CBD3_SPREAD_512);
+    const __m512i mask249 = _mm512_set1_epi32(0x00249249);
+    const __m512i mask7 = _mm512_set1_epi32(0x7);
+    const __m512i modulus = _mm512_set1_epi32(static_cast<int>(q));
+
+    __m512i raw = _mm512_castsi128_si512(_mm_loadu_si128(reinterpret_cast<const __m128i*>(buf)));
+    raw = _mm512_inserti32x4(raw, _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 12)), 1);
+    raw = _mm512_inserti32x4(raw, _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 24)), 2);
+    raw = _mm512_inserti32x4(raw, _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 32)), 3);
+    __m512i t = _mm512_shuffle_epi8(raw, spread);
+    __m512i d = _mm512_add_epi32(
+        _mm512_add_epi32(_mm512_and_si512(t, mask249), _mm512_and_si512(_mm512_srli_epi32(t, 1), mask249)),
+        _mm512_and_si512(_mm512_srli_epi32(t, 2), mask249));
+
+    __m512i c[4];
+    for (int j = 0; j < 4; ++j) {
+        __m512i a = _mm512_and_si512(_mm512_srli_epi32(d, 6 * j), mask7);
+        __m512i b = _mm512_and_si512(_mm512_srli_epi32(d, 6 * j + 3), mask7);
+        c[j] = _mm512_sub_epi32(a, b);
+    }
+    // Within each 128-bit lane L, r_i ends up holding the four coefficients of group 4L + i
+    __m512i t0 = _mm512_unpacklo_epi32(c[0], c[1]);
+    __m512i t1 = _mm512_unpackhi_epi32(c[0], c[1]);
+    __m512i t2 = _mm512_unpacklo_epi32(c[2], c[3]);
+    __m512i t3 = _mm512_unpackhi_epi32(c[2], c[3]);
+    __m512i r0 = _mm512_unpacklo_epi64(t0, t2);
+    __m512i r1 = _mm512_unpackhi_epi64(t0, t2);
+    __m512i r2 = _mm512_unpacklo_epi64(t1, t3);
+    __m512i r3 = _mm512_unpackhi_epi64(t1, t3);
+
+    // Gather lane L of r0..r3 into output vector L
+    __m512i even01 = _mm512_shuffle_i64x2(r0, r1, 0x88);
+    __m512i even23 = _mm512_shuffle_i64x2(r2, r3, 0x88);
+    __m512i odd01 = _mm512_shuffle_i64x2(r0, r1, 0xDD);
+    __m512i odd23 = _mm512_shuffle_i64x2(r2, r3, 0xDD);
+    store_lifted512(out, _mm512_shuffle_i64x2(even01, even23, 0x88), modulus);
+    store_lifted512(out + 16, _mm512_shuffle_i64x2(odd01, odd23, 0x88), modulus);
+    store_lifted512(out + 32, _mm512_shuffle_i64x2(even01, even23, 0xDD), modulus);
+    store_lifted512(out + 48, _mm512_shuffle_i64x2(odd01, odd23, 0xDD), modulus);
+}
+#endif
+
+#ifdef HAVE_SVE
+bool use_sve() {
+    static const bool supported = CPUFeatureDetector::cached().has_sve;
+    return supported;
+}
+#endif
+
+#ifdef HAVE_NEON
+// 16 bytes -> 32 coefficients per step, same nibble layout as the AVX2 kernel
+void cbd2_neon(uint32_t* out, const uint8_t* buf, uint32_t q) {
+    const uint8x16_t mask55 = vdupq_n_u8(0x55);
+    const uint8x16_t mask33 = vdupq_n_u8(0x33);
+    const uint8x16_t mask0f = vdupq_n_u8(0x0F);
+    const int32x4_t offset = vdupq_n_s32(2);
+    const uint32x4_t modulus = vdupq_n_u32(q);
+
+    for (size_t step = 0; step < 2; ++step) {
+        uint8x16_t f = vld1q_u8(buf + 16 * step);
+        f = vaddq_u8(vandq_u8(f, mask55), vandq_u8(vshrq_n_u8(f, 1), mask55));
+        uint8x16_t a = vandq_u8(f, mask33);
+        uint8x16_t b = vandq_u8(vshrq_n_u8(f, 2), mask33);
+        uint8x16_t d = vsubq_u8(vaddq_u8(a, vdupq_n_u8(0x22)), b);
+
+        uint8x16_t lo = vandq_u8(d, mask0f);
+        uint8x16_t hi = vshrq_n_u8(d, 4);
+        const uint8x16_t ordered[2] = {vzip1q_u8(lo, hi), vzip2q_u8(lo, hi)};
+        for (size_t h = 0; h < 2; ++h) {
+            const uint16x8_t wide[2] = {vmovl_u8(vget_low_u8(ordered[h])), vmovl_u8(vget_high_u8(ordered[h]))};
+            for (size_t w = 0; w < 2; ++w) {
+                const uint32x4_t parts[2] = {vmovl_u16(vget_low_u16(wide[w])), vmovl_u16(vget_high_u16(wide[w]))};
+                for (size_t p = 0; p < 2; ++p) {
+                    int32x4_t values = vsubq_s32(vreinterpretq_s32_u32(parts[p]), offset);
+                    uint32x4_t negative = vreinterpretq_u32_s32(vshrq_n_s32(values, 31));
+                    uint32x4_t lifted = vaddq_u32(vreinterpretq_u32_s32(values), vandq_u32(negative, modulus));
+                    vst1q_u32(out + 32 * step + 16 * h + 8 * w + 4 * p, lifted);
+                }
+            }
+        }
+    }
+}
+#endif
+
+} // namespace
+
+void cbd_blocks(uint32_t* out, const uint8_t* buf, size_t nblocks, uint32_t eta, uint32_t modulus) {
+    const size_t block_bytes = cbd_block_bytes(eta);
+    size_t block = 0;
+#ifdef HAVE_SVE
+    if (use_sve()) {
+        cbd_blocks_sve(out, buf, nblocks, eta, modulus);
+        return;
+    }
+#endif
+#ifdef HAVE_AVX512BW
+    if (use_avx512()) {
+        if (eta == 2) {
+            for (; block + 2 <= nblocks; block += 2) {
+                cbd2x2_avx512(out + 64 * block, buf + block_bytes * block, modulus);
+            }
+        } else {
+            for (; block < nblocks; ++block) {
+                cbd3_block_avx512(out + 64 * block, buf + block_bytes * block, modulus);
+            }
+        }
+    }
+#endif
+    for (; block < nblocks; ++block) {
+        cbd_block64(out + 64 * block, buf + block_bytes * block, eta, modulus);
+    }
+}
+
+void cbd_block64_scalar(uint32_t* out, const uint8_t* buf, uint32_t eta, uint32_t modulus) {
+    if (eta == 2) {
+        cbd2_scalar(out, buf, modulus);
+    } else {
+        cbd3_scalar(out, buf, modulus);
+    }
+}
+
+void cbd_block64(uint32_t* out, const uint8_t* buf, uint32_t eta, uint32_t modulus) {
+#ifdef HAVE_AVX2
+    if (use_avx2()) {
+        if (eta == 2) {
+            cbd2_avx2(out, buf, modulus);
+        } else {
+            cbd3_avx2(out, buf, modulus);
+        }
+        return;
+    }
+#endif
+#ifdef HAVE_SVE
+    if (use_sve()) {
+        cbd_blocks_sve(out, buf, 1, eta, modulus);
+        return;
+    }
+#endif
+#ifdef HAVE_NEON
+    if (eta == 2) {
+        cbd2_neon(out, buf, modulus);
+        return;
+    }
+#endif
+    cbd_block64_scalar(out, buf, eta, modulus);
+}
+
+} // namespace clwe
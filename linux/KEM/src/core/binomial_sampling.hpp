@@ -0,0 +1,27 @@
+#ifndef BINOMIAL_SAMPLING_HPP
+#define BINOMIAL_SAMPLING_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace clwe {
+
+// Bytes of SHAKE output a centered binomial block of 64 coefficients consumes: 2*eta bits each
+constexpr size_t cbd_block_bytes(uint32_t eta) { return 16 * static_cast<size_t>(eta); }
+
+// Write 64 coefficients of B(eta) - B(eta) mod modulus from cbd_block_bytes(eta) bytes.
+// Each coefficient takes 2*eta consecutive little-endian bits: the first eta count
+// towards a, the rest towards b. eta must be 2 or 3 and modulus > eta.
+// Bit-sliced on 32-bit words, or SVE/AVX2/NEON when available.
+void cbd_block64(uint32_t* out, const uint8_t* buf, uint32_t eta, uint32_t modulus);
+
+// cbd_block64 over nblocks consecutive blocks; AVX-512BW takes two blocks per step and
+// SVE as many as its vector length covers
+void cbd_blocks(uint32_t* out, const uint8_t* buf, size_t nblocks, uint32_t eta, uint32_t modulus);
+
+// Portable path of cbd_block64, kept callable for cross-checking the SIMD ones
+void cbd_block64_scalar(uint32_t* out, const uint8_t* buf, uint32_t eta, uint32_t modulus);
+
+} // namespace clwe
+
+#endif // BINOMIAL_SAMPLING_HPP
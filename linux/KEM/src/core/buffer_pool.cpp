@@ -0,0 +1,207 @@
+#include "clwe/buffer_pool.hpp"
+#include "color_kem.hpp"
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace clwe {
+
+struct BufferPoolState {
+    CLWEParameters params;
+    size_t ciphertext_bytes = 0;   // ciphertext_data of one ciphertext
+    size_t public_data_bytes = 0;  // public_data of one key
+    size_t max_cached = 0;
+    uint64_t id = 0;               // Never reused, so a thread cache cannot mistake a new pool for a dead one
+    std::atomic<uint64_t> acquired{0};
+    std::atomic<uint64_t> reused{0};
+    std::atomic<uint64_t> returned{0};
+    std::atomic<uint64_t> dropped{0};
+};
+
+namespace {
+
+constexpr size_t HINT_BYTES = 4;
+
+std::atomic<uint64_t> g_next_pool_id{1};
+
+struct CiphertextBuffers {
+    std::vector<uint8_t> data;
+    std::vector<uint8_t> hint;
+};
+
+// One thread's free lists for one pool, reserved to max_cached up front so returning a
+// buffer never allocates
+struct PoolCache {
+    uint64_t id = 0;
+    std::weak_ptr<BufferPoolState> owner;
+    std::vector<CiphertextBuffers> ciphertexts;
+    std::vector<std::vector<uint8_t>> public_data;
+};
+
+// Set once the thread's caches are destroyed; objects destroyed later in thread exit
+// free their buffers instead of touching them
+thread_local bool t_caches_gone = false;
+
+struct ThreadCaches {
+    std::vector<PoolCache> pools;
+    ~ThreadCaches() { t_caches_gone = true; }
+};
+
+ThreadCaches& thread_caches() {
+    thread_local ThreadCaches caches;
+    return caches;
+}
+
+PoolCache* find_cache(const BufferPoolState& state) {
+    if (t_caches_gone) {
+        return nullptr;
+    }
+    for (PoolCache& cache : thread_caches().pools) {
+        if (cache.id == state.id) {
+            return &cache;
+        }
+    }
+    return nullptr;
+}
+
+// The calling thread's cache for state, created on its first return here; caches of pools
+// that are gone are freed at the same time. nullptr when the thread is exiting or the
+// cache cannot be allocated.
+PoolCache* cache_for_return(const std::shared_ptr<BufferPoolState>& state) noexcept {
+    if (PoolCache* cache = find_cache(*state)) {
+        return cache;
+    }
+    if (t_caches_gone) {
+        return nullptr;
+    }
+    try {
+        std::vector<PoolCache>& pools = thread_caches().pools;
+        pools.erase(std::remove_if(pools.begin(), pools.end(),
+                                   [](const PoolCache& cache) { return cache.owner.expired(); }),
+                    pools.end());
+        PoolCache cache;
+        cache.id = state->id;
+        cache.owner = state;
+        cache.ciphertexts.reserve(state->max_cached);
+        cache.public_data.reserve(state->max_cached);
+        pools.push_back(std::move(cache));
+        return &pools.back();
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+} // namespace
+
+KemBufferPool::KemBufferPool(const CLWEParameters& params, size_t max_cached_per_thread)
+    : state_(std::make_shared<BufferPoolState>()) {
+    params.validate();
+    if (max_cached_per_thread == 0) {
+        throw std::invalid_argument("KemBufferPool needs room for at least one buffer per thread");
+    }
+    state_->params = params;
+    state_->ciphertext_bytes = ColorCiphertext::serialized_size(params) - HINT_BYTES;
+    state_->public_data_bytes = ColorPublicKey::serialized_size(params) - ColorPublicKey::seed_bytes(params);
+    state_->max_cached = max_cached_per_thread;
+    state_->id = g_next_pool_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+KemBufferPool::~KemBufferPool() = default;
+
+const CLWEParameters& KemBufferPool::params() const {
+    return state_->params;
+}
+
+size_t KemBufferPool::max_cached_per_thread() const {
+    return state_->max_cached;
+}
+
+void KemBufferPool::trim() {
+    if (t_caches_gone) {
+        return;
+    }
+    std::vector<PoolCache>& pools = thread_caches().pools;
+    pools.erase(std::remove_if(pools.begin(), pools.end(),
+                               [this](const PoolCache& cache) { return cache.id == state_->id; }),
+                pools.end());
+}
+
+KemBufferPoolStats KemBufferPool::stats() const {
+    KemBufferPoolStats stats;
+    stats.acquired = state_->acquired.load(std::memory_order_relaxed);
+    stats.reused = state_->reused.load(std::memory_order_relaxed);
+    stats.returned = state_->returned.load(std::memory_order_relaxed);
+    stats.dropped = state_->dropped.load(std::memory_order_relaxed);
+    return stats;
+}
+
+ColorCiphertext ColorCiphertext::acquire(KemBufferPool& pool) {
+    BufferPoolState& state = *pool.state_;
+    ColorCiphertext ciphertext;
+    PoolCache* cache = find_cache(state);
+    if (cache && !cache->ciphertexts.empty()) {
+        ciphertext.ciphertext_data = std::move(cache->ciphertexts.back().data);
+        ciphertext.shared_secret_hint = std::move(cache->ciphertexts.back().hint);
+        cache->ciphertexts.pop_back();
+        state.reused.fetch_add(1, std::memory_order_relaxed);
+    }
+    // Within the capacity they came back with when reused
+    ciphertext.ciphertext_data.resize(state.ciphertext_bytes);
+    ciphertext.shared_secret_hint.resize(HINT_BYTES);
+    ciphertext.params = state.params;
+    ciphertext.pool_ = pool.state_;
+    state.acquired.fetch_add(1, std::memory_order_relaxed);
+    return ciphertext;
+}
+
+ColorCiphertext::~ColorCiphertext() {
+    if (!pool_) {
+        return;
+    }
+    BufferPoolState& state = *pool_;
+    PoolCache* cache = nullptr;
+    if (ciphertext_data.capacity() >= state.ciphertext_bytes && shared_secret_hint.capacity() >= HINT_BYTES) {
+        cache = cache_for_return(pool_);
+    }
+    if (cache && cache->ciphertexts.size() < state.max_cached) {
+        cache->ciphertexts.push_back({std::move(ciphertext_data), std::move(shared_secret_hint)});
+        state.returned.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        state.dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+ColorPublicKey ColorPublicKey::acquire(KemBufferPool& pool) {
+    BufferPoolState& state = *pool.state_;
+    ColorPublicKey key;
+    key.seed.fill(0);
+    PoolCache* cache = find_cache(state);
+    if (cache && !cache->public_data.empty()) {
+        key.public_data = std::move(cache->public_data.back());
+        cache->public_data.pop_back();
+        state.reused.fetch_add(1, std::memory_order_relaxed);
+    }
+    key.public_data.resize(state.public_data_bytes);
+    key.params = state.params;
+    key.pool_ = pool.state_;
+    state.acquired.fetch_add(1, std::memory_order_relaxed);
+    return key;
+}
+
+ColorPublicKey::~ColorPublicKey() {
+    if (!pool_) {
+        return;
+    }
+    BufferPoolState& state = *pool_;
+    PoolCache* cache = public_data.capacity() >= state.public_data_bytes ? cache_for_return(pool_) : nullptr;
+    if (cache && cache->public_data.size() < state.max_cached) {
+        cache->public_data.push_back(std::move(public_data));
+        state.returned.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        state.dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+} // namespace clwe
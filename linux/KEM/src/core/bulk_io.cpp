@@ -0,0 +1,431 @@
+#include "bulk_io.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+#ifdef CLWE_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+namespace clwe {
+
+BulkFileIo::BulkFileIo(int fd, size_t buffer_count, size_t buffer_bytes, size_t submit_batch)
+    : fd_(fd), buffer_bytes_(buffer_bytes), ops_(buffer_count),
+      submit_batch_(std::max<size_t>(1, std::min(submit_batch, buffer_count))) {
+    if (buffer_count == 0 || buffer_bytes == 0) {
+        throw std::invalid_argument("Bulk I/O needs at least one non-empty buffer");
+    }
+    region_ = allocate_page_region(buffer_count * buffer_bytes, page_policy());
+    queued_.reserve(buffer_count);
+}
+
+BulkFileIo::~BulkFileIo() {
+    release_page_region(region_);
+}
+
+void BulkFileIo::queue(size_t index, bool write, size_t size, uint64_t offset) {
+    if (index >= ops_.size() || size > buffer_bytes_) {
+        throw std::invalid_argument("Bulk I/O transfer of " + std::to_string(size) + " bytes on buffer " +
+                                    std::to_string(index) + " is outside the buffers");
+    }
+    if (ops_[index].state != OpState::Idle) {
+        throw std::logic_error("Bulk I/O buffer " + std::to_string(index) + " is still busy");
+    }
+    Op& op = ops_[index];
+    op.write = write;
+    op.state = OpState::Queued;
+    op.size = size;
+    op.offset = offset;
+    op.done = 0;
+    op.error = 0;
+    queued_.push_back(index);
+    if (queued_.size() >= submit_batch_) {
+        submit();
+    }
+}
+
+void BulkFileIo::write(size_t index, size_t size, uint64_t offset) {
+    queue(index, true, size, offset);
+}
+
+void BulkFileIo::read(size_t index, size_t size, uint64_t offset) {
+    queue(index, false, size, offset);
+}
+
+void BulkFileIo::submit() {
+    if (queued_.empty()) {
+        return;
+    }
+    for (size_t index : queued_) {
+        ops_[index].state = OpState::InFlight;
+    }
+    start(queued_);
+    queued_.clear();
+}
+
+size_t BulkFileIo::wait(size_t index) {
+    Op& op = ops_[index];
+    if (op.state == OpState::Idle) {
+        return 0;
+    }
+    if (op.state == OpState::Queued) {
+        submit();
+    }
+    complete(index);
+    op.state = OpState::Idle;
+    if (op.error != 0) {
+        throw std::runtime_error(std::string(op.write ? "Bulk write" : "Bulk read") + " of " +
+                                 std::to_string(op.size) + " bytes at offset " + std::to_string(op.offset) +
+                                 " failed: " + std::strerror(op.error));
+    }
+    if (op.write && op.done != op.size) {
+        throw std::runtime_error("Bulk write at offset " + std::to_string(op.offset) + " made no progress");
+    }
+    return op.done;
+}
+
+void BulkFileIo::wait_all() {
+    submit();
+    // Every operation is waited for, even after one fails, so no buffer is left in flight
+    std::exception_ptr failure;
+    for (size_t i = 0; i < ops_.size(); ++i) {
+        try {
+            wait(i);
+        } catch (...) {
+            if (!failure) {
+                failure = std::current_exception();
+            }
+        }
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+namespace {
+
+class ThreadedBulkFileIo : public BulkFileIo {
+public:
+    ThreadedBulkFileIo(int fd, size_t buffer_count, size_t buffer_bytes, size_t submit_batch)
+        : BulkFileIo(fd, buffer_count, buffer_bytes, submit_batch), results_(buffer_count) {
+        const size_t threads = std::min<size_t>(buffer_count, 4);
+        for (size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back([this] { run(); });
+        }
+    }
+
+    ~ThreadedBulkFileIo() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        work_ready_.notify_all();
+        for (std::thread& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    BulkIoBackend backend() const override { return BulkIoBackend::Threaded; }
+
+protected:
+    void start(const std::vector<size_t>& indices) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (size_t index : indices) {
+                results_[index] = Op();
+                pending_.push_back(index);
+            }
+        }
+        work_ready_.notify_all();
+    }
+
+    // Workers report through results_, so ops_ is only ever written by the driving thread
+    void complete(size_t index) override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        op_done_.wait(lock, [&] { return results_[index].state == OpState::Done; });
+        ops_[index].done = results_[index].done;
+        ops_[index].error = results_[index].error;
+        ops_[index].state = OpState::Done;
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            work_ready_.wait(lock, [&] { return stopping_ || !pending_.empty(); });
+            if (pending_.empty()) {
+                return;
+            }
+            const size_t index = pending_.front();
+            pending_.pop_front();
+            Op op = ops_[index];
+            lock.unlock();
+
+            uint8_t* data = buffer(index);
+            while (op.done < op.size) {
+                ssize_t result = op.write ? ::pwrite(fd_, data + op.done, op.size - op.done,
+                                                     static_cast<off_t>(op.offset + op.done))
+                                          : ::pread(fd_, data + op.done, op.size - op.done,
+                                                    static_cast<off_t>(op.offset + op.done));
+                if (result < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    op.error = errno;
+                    break;
+                }
+                if (result == 0) {
+                    break;  // End of file for a read; a write reports the shortfall
+                }
+                op.done += static_cast<size_t>(result);
+            }
+
+            lock.lock();
+            results_[index].done = op.done;
+            results_[index].error = op.error;
+            results_[index].state = OpState::Done;
+            op_done_.notify_all();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable work_ready_;
+    std::condition_variable op_done_;
+    std::deque<size_t> pending_;
+    std::vector<Op> results_;
+    std::vector<std::thread> workers_;
+    bool stopping_ = false;
+};
+
+#ifdef CLWE_HAVE_IO_URING
+
+// One submission and one completion ring, with the buffers and the file registered so
+// each transfer skips the per-call page pinning and file lookup
+class IoUringBulkFileIo : public BulkFileIo {
+public:
+    // Throws std::runtime_error when the kernel refuses any part of the setup
+    IoUringBulkFileIo(int fd, size_t buffer_count, size_t buffer_bytes, size_t submit_batch)
+        : BulkFileIo(fd, buffer_count, buffer_bytes, submit_batch) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, static_cast<unsigned>(buffer_count), &params));
+        if (ring_fd_ < 0) {
+            throw std::runtime_error(std::string("io_uring_setup failed: ") + std::strerror(errno));
+        }
+        try {
+            map_rings(params);
+            std::vector<iovec> iovecs(buffer_count);
+            for (size_t i = 0; i < buffer_count; ++i) {
+                iovecs[i].iov_base = buffer(i);
+                iovecs[i].iov_len = buffer_bytes;
+            }
+            if (syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_BUFFERS, iovecs.data(),
+                        static_cast<unsigned>(buffer_count)) < 0) {
+                throw std::runtime_error(std::string("io_uring buffer registration failed: ") + std::strerror(errno));
+            }
+            if (syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_FILES, &fd_, 1u) < 0) {
+                throw std::runtime_error(std::string("io_uring file registration failed: ") + std::strerror(errno));
+            }
+        } catch (...) {
+            unmap_rings();
+            ::close(ring_fd_);
+            throw;
+        }
+    }
+
+    ~IoUringBulkFileIo() override {
+        // Buffers must not be released under a transfer the kernel still owns
+        for (size_t i = 0; i < ops_.size(); ++i) {
+            if (ops_[i].state == OpState::InFlight) {
+                try {
+                    complete(i);
+                } catch (...) {
+                }
+            }
+        }
+        unmap_rings();
+        ::close(ring_fd_);
+    }
+
+    BulkIoBackend backend() const override { return BulkIoBackend::IoUring; }
+
+protected:
+    void start(const std::vector<size_t>& indices) override {
+        for (size_t index : indices) {
+            push_sqe(index);
+        }
+        enter(0);
+    }
+
+    void complete(size_t index) override {
+        while (ops_[index].state != OpState::Done) {
+            enter(1);
+            reap();
+        }
+    }
+
+private:
+    void map_rings(const io_uring_params& params) {
+        sq_ring_bytes_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_bytes_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap) {
+            sq_ring_bytes_ = cq_ring_bytes_ = std::max(sq_ring_bytes_, cq_ring_bytes_);
+        }
+        sq_ring_ = map(sq_ring_bytes_, IORING_OFF_SQ_RING);
+        cq_ring_ = single_mmap ? sq_ring_ : map(cq_ring_bytes_, IORING_OFF_CQ_RING);
+        sqes_bytes_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(map(sqes_bytes_, IORING_OFF_SQES));
+
+        uint8_t* sq = static_cast<uint8_t*>(sq_ring_);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        uint8_t* cq = static_cast<uint8_t*>(cq_ring_);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    }
+
+    void* map(size_t bytes, uint64_t offset) {
+        void* mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                             static_cast<off_t>(offset));
+        if (mapping == MAP_FAILED) {
+            throw std::runtime_error(std::string("io_uring ring mapping failed: ") + std::strerror(errno));
+        }
+        return mapping;
+    }
+
+    void unmap_rings() {
+        if (sqes_ != nullptr) {
+            munmap(sqes_, sqes_bytes_);
+        }
+        if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+            munmap(cq_ring_, cq_ring_bytes_);
+        }
+        if (sq_ring_ != nullptr) {
+            munmap(sq_ring_, sq_ring_bytes_);
+        }
+        sqes_ = nullptr;
+        sq_ring_ = cq_ring_ = nullptr;
+    }
+
+    // At most one transfer per buffer is in flight and the ring has an entry per buffer,
+    // so the submission queue never fills
+    void push_sqe(size_t index) {
+        const Op& op = ops_[index];
+        const unsigned tail = *sq_tail_;
+        const unsigned slot = tail & sq_mask_;
+        io_uring_sqe& sqe = sqes_[slot];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = op.write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+        sqe.flags = IOSQE_FIXED_FILE;
+        sqe.fd = 0;  // Index into the registered files
+        sqe.off = op.offset + op.done;
+        sqe.addr = reinterpret_cast<uint64_t>(buffer(index) + op.done);
+        sqe.len = static_cast<uint32_t>(op.size - op.done);
+        sqe.buf_index = static_cast<uint16_t>(index);
+        sqe.user_data = index;
+        sq_array_[slot] = slot;
+        __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+        ++unsubmitted_;
+    }
+
+    void enter(unsigned min_complete) {
+        for (;;) {
+            long submitted = syscall(__NR_io_uring_enter, ring_fd_, unsubmitted_, min_complete,
+                                     min_complete > 0 ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0);
+            if (submitted >= 0) {
+                unsubmitted_ -= static_cast<unsigned>(submitted);
+                if (unsubmitted_ == 0 || min_complete > 0) {
+                    return;
+                }
+                continue;
+            }
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                throw std::runtime_error(std::string("io_uring_enter failed: ") + std::strerror(errno));
+            }
+        }
+    }
+
+    void reap() {
+        unsigned head = *cq_head_;
+        const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+            Op& op = ops_[static_cast<size_t>(cqe.user_data)];
+            if (cqe.res < 0) {
+                if (cqe.res == -EINTR || cqe.res == -EAGAIN) {
+                    push_sqe(static_cast<size_t>(cqe.user_data));
+                    continue;
+                }
+                op.error = -cqe.res;
+                op.state = OpState::Done;
+            } else if (cqe.res == 0) {
+                op.state = OpState::Done;  // End of file for a read; a write reports the shortfall
+            } else {
+                op.done += static_cast<size_t>(cqe.res);
+                if (op.done < op.size) {
+                    push_sqe(static_cast<size_t>(cqe.user_data));
+                } else {
+                    op.state = OpState::Done;
+                }
+            }
+        }
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    }
+
+    int ring_fd_ = -1;
+    void* sq_ring_ = nullptr;
+    void* cq_ring_ = nullptr;
+    size_t sq_ring_bytes_ = 0;
+    size_t cq_ring_bytes_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_bytes_ = 0;
+    unsigned* sq_tail_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned* sq_array_ = nullptr;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+    unsigned unsubmitted_ = 0;
+};
+
+#endif
+
+} // namespace
+
+std::unique_ptr<BulkFileIo> make_bulk_file_io(int fd, size_t buffer_count, size_t buffer_bytes,
+                                              size_t submit_batch, BulkIoBackend backend) {
+#ifdef CLWE_HAVE_IO_URING
+    if (backend != BulkIoBackend::Threaded) {
+        try {
+            return std::make_unique<IoUringBulkFileIo>(fd, buffer_count, buffer_bytes, submit_batch);
+        } catch (const std::runtime_error&) {
+            // Seccomp filters, io_uring_disabled and old kernels all refuse the ring
+            if (backend == BulkIoBackend::IoUring) {
+                throw;
+            }
+        }
+    }
+#else
+    if (backend == BulkIoBackend::IoUring) {
+        throw std::runtime_error("io_uring is not available on this platform");
+    }
+#endif
+    return std::make_unique<ThreadedBulkFileIo>(fd, buffer_count, buffer_bytes, submit_batch);
+}
+
+} // namespace clwe
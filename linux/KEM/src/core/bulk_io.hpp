@@ -0,0 +1,87 @@
+#ifndef BULK_IO_HPP
+#define BULK_IO_HPP
+
+#include "clwe/key_archive.hpp"
+#include "page_allocator.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// The kernel header is enough: the ring is driven with raw syscalls, not liburing
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define CLWE_HAVE_IO_URING 1
+#endif
+#endif
+
+namespace clwe {
+
+// Positional reads and writes of whole buffers from a fixed set, several in flight at
+// once. An operation is queued on a buffer, handed to the backend in batches and
+// waited for before the buffer is touched again. One thread drives an instance.
+class BulkFileIo {
+public:
+    virtual ~BulkFileIo();
+
+    BulkFileIo(const BulkFileIo&) = delete;
+    BulkFileIo& operator=(const BulkFileIo&) = delete;
+
+    size_t buffer_count() const { return ops_.size(); }
+    size_t buffer_bytes() const { return buffer_bytes_; }
+    uint8_t* buffer(size_t index) { return region_.data + index * buffer_bytes_; }
+    virtual BulkIoBackend backend() const = 0;
+
+    // Queue a transfer of size bytes between buffer(index) and the file at offset; the
+    // batch goes to the backend once submit_batch operations are queued
+    void write(size_t index, size_t size, uint64_t offset);
+    void read(size_t index, size_t size, uint64_t offset);
+
+    // Hand every queued operation to the backend
+    void submit();
+
+    // Wait for the operation on buffer(index) and return the bytes transferred, fewer
+    // than asked only for a read that reached the end of the file; 0 for an idle buffer.
+    // Throws std::runtime_error if the transfer failed.
+    size_t wait(size_t index);
+    void wait_all();
+
+protected:
+    enum class OpState : uint8_t { Idle, Queued, InFlight, Done };
+
+    struct Op {
+        bool write = false;
+        OpState state = OpState::Idle;
+        size_t size = 0;
+        uint64_t offset = 0;
+        size_t done = 0;  // Bytes transferred so far
+        int error = 0;    // errno of a failed transfer
+    };
+
+    BulkFileIo(int fd, size_t buffer_count, size_t buffer_bytes, size_t submit_batch);
+
+    // Start the queued operations; they complete in any order
+    virtual void start(const std::vector<size_t>& indices) = 0;
+    // Block until ops_[index] is Done
+    virtual void complete(size_t index) = 0;
+
+    int fd_;
+    size_t buffer_bytes_;
+    PageRegion region_;
+    std::vector<Op> ops_;
+
+private:
+    void queue(size_t index, bool write, size_t size, uint64_t offset);
+
+    size_t submit_batch_;
+    std::vector<size_t> queued_;
+};
+
+// The fd must stay open for the lifetime of the result. Throws std::runtime_error when
+// IoUring is asked for and the kernel refuses the ring or the buffer registration.
+std::unique_ptr<BulkFileIo> make_bulk_file_io(int fd, size_t buffer_count, size_t buffer_bytes,
+                                              size_t submit_batch, BulkIoBackend backend);
+
+} // namespace clwe
+
+#endif // BULK_IO_HPP
@@ -0,0 +1,268 @@
+#include "clwe/clwe_c.h"
+#include "color_kem.hpp"
+#include "utils.hpp"
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+struct clwe_ctx {
+    explicit clwe_ctx(const clwe::CLWEParameters& params)
+        : kem(params),
+          public_key_bytes(clwe::ColorPublicKey::serialized_size(params)),
+          private_key_bytes(clwe::ColorExpandedPrivateKey::serialized_size(params)),
+          ciphertext_bytes(clwe::ColorCiphertext::serialized_size(params)) {}
+
+    ~clwe_ctx() {
+        clwe::secure_zero(cached_private_bytes.data(), cached_private_bytes.size());
+    }
+
+    clwe::ColorKEM kem;
+    size_t public_key_bytes;
+    size_t private_key_bytes;
+    size_t ciphertext_bytes;
+
+    // The private key of the latest clwe_decapsulate(), with the bytes it was parsed from
+    mutable std::mutex private_key_mutex;
+    mutable std::vector<uint8_t> cached_private_bytes;
+    mutable std::shared_ptr<const clwe::ColorExpandedPrivateKey> cached_private_key;
+};
+
+namespace clwe {
+
+namespace {
+
+KemWorkspace& c_api_workspace() {
+    static thread_local KemWorkspace workspace;
+    return workspace;
+}
+
+// Maps whatever the C++ call threw to a status; nothing may unwind into C
+int current_exception_status() {
+    try {
+        throw;
+    } catch (const std::bad_alloc&) {
+        return CLWE_ERROR_OUT_OF_MEMORY;
+    } catch (const std::invalid_argument&) {
+        return CLWE_ERROR_INVALID_ARGUMENT;
+    } catch (...) {
+        return CLWE_ERROR_INTERNAL;
+    }
+}
+
+int error_status(CLWEError error) {
+    switch (error) {
+    case CLWEError::SUCCESS:
+        return CLWE_OK;
+    case CLWEError::BUFFER_TOO_SMALL:
+        return CLWE_ERROR_BUFFER_TOO_SMALL;
+    case CLWEError::MEMORY_ALLOCATION_FAILED:
+        return CLWE_ERROR_OUT_OF_MEMORY;
+    case CLWEError::INVALID_PARAMETERS:
+    case CLWEError::INVALID_KEY:
+    case CLWEError::INVALID_CIPHERTEXT:
+        return CLWE_ERROR_INVALID_ARGUMENT;
+    default:
+        return CLWE_ERROR_INTERNAL;
+    }
+}
+
+ColorPublicKeyView public_key_view(const clwe_ctx& ctx, const uint8_t* pk) {
+    ColorPublicKeyView view;
+    view.seed = pk;
+    view.public_data = pk + 32;
+    view.public_data_size = ctx.public_key_bytes - 32;
+    view.encoding = ctx.kem.params().encoding;
+    view.params = ctx.kem.params();
+    return view;
+}
+
+// Equality of secret bytes: every byte is read whatever the first difference
+bool secret_bytes_equal(const uint8_t* a, const uint8_t* b, size_t size) {
+    uint8_t difference = 0;
+    for (size_t i = 0; i < size; ++i) {
+        difference |= static_cast<uint8_t>(a[i] ^ b[i]);
+    }
+    return difference == 0;
+}
+
+void delete_private_key(const ColorExpandedPrivateKey* key) {
+    ColorExpandedPrivateKey* owned = const_cast<ColorExpandedPrivateKey*>(key);
+    secure_zero(owned->secret_data.data(), owned->secret_data.size());
+    delete owned;
+}
+
+// The cached key when sk is its serialized form, otherwise a freshly parsed (and
+// H(pk)-checked) one that replaces it. A key that fails the check is a status, not an
+// exception; only allocation failures throw
+CLWEError private_key_for(const clwe_ctx& ctx, const uint8_t* sk, std::shared_ptr<const ColorExpandedPrivateKey>& out) {
+    {
+        std::lock_guard<std::mutex> lock(ctx.private_key_mutex);
+        if (ctx.cached_private_key && secret_bytes_equal(ctx.cached_private_bytes.data(), sk, ctx.private_key_bytes)) {
+            out = ctx.cached_private_key;
+            return CLWEError::SUCCESS;
+        }
+    }
+    std::shared_ptr<ColorExpandedPrivateKey> key(new ColorExpandedPrivateKey(), delete_private_key);
+    CLWEError error = ColorExpandedPrivateKey::try_deserialize(sk, ctx.private_key_bytes, ctx.kem.params(), *key);
+    if (error != CLWEError::SUCCESS) {
+        return error;
+    }
+    std::lock_guard<std::mutex> lock(ctx.private_key_mutex);
+    ctx.cached_private_bytes.assign(sk, sk + ctx.private_key_bytes);
+    ctx.cached_private_key = key;
+    out = std::move(key);
+    return CLWEError::SUCCESS;
+}
+
+} // namespace
+
+} // namespace clwe
+
+extern "C" {
+
+clwe_ctx* clwe_ctx_new(uint32_t security_level) {
+    try {
+        return new clwe_ctx(clwe::CLWEParameters(security_level));
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void clwe_ctx_free(clwe_ctx* ctx) {
+    delete ctx;
+}
+
+size_t clwe_public_key_bytes(const clwe_ctx* ctx) {
+    return ctx ? ctx->public_key_bytes : 0;
+}
+
+size_t clwe_private_key_bytes(const clwe_ctx* ctx) {
+    return ctx ? ctx->private_key_bytes : 0;
+}
+
+size_t clwe_ciphertext_bytes(const clwe_ctx* ctx) {
+    return ctx ? ctx->ciphertext_bytes : 0;
+}
+
+const char* clwe_status_string(int status) {
+    switch (status) {
+    case CLWE_OK:
+        return "success";
+    case CLWE_ERROR_INVALID_ARGUMENT:
+        return "invalid argument";
+    case CLWE_ERROR_BUFFER_TOO_SMALL:
+        return "output buffer too small";
+    case CLWE_ERROR_OUT_OF_MEMORY:
+        return "out of memory";
+    case CLWE_ERROR_INTERNAL:
+        return "internal error";
+    }
+    return "unknown status";
+}
+
+int clwe_keygen(const clwe_ctx* ctx, uint8_t* pk_out, size_t pk_out_len, uint8_t* sk_out, size_t sk_out_len) {
+    if (ctx == nullptr || pk_out == nullptr || sk_out == nullptr) {
+        return CLWE_ERROR_INVALID_ARGUMENT;
+    }
+    if (pk_out_len < ctx->public_key_bytes || sk_out_len < ctx->private_key_bytes) {
+        return CLWE_ERROR_BUFFER_TOO_SMALL;
+    }
+    try {
+        auto keypair = ctx->kem.keygen(clwe::c_api_workspace());
+        clwe::ColorExpandedPrivateKey private_key = ctx->kem.expand_private_key(keypair.first, keypair.second);
+        clwe::secure_zero(keypair.second.secret_data.data(), keypair.second.secret_data.size());
+        keypair.first.serialize(pk_out, pk_out_len);
+        private_key.serialize(sk_out, sk_out_len);
+        clwe::secure_zero(private_key.secret_data.data(), private_key.secret_data.size());
+        return CLWE_OK;
+    } catch (...) {
+        clwe::secure_zero(sk_out, ctx->private_key_bytes);
+        return clwe::current_exception_status();
+    }
+}
+
+int clwe_encapsulate(const clwe_ctx* ctx, const uint8_t* pk, size_t pk_len, uint8_t* ct_out, size_t ct_out_len,
+                     uint8_t* ss_out) {
+    return clwe_encapsulate_batch(ctx, 1, pk, pk_len, ct_out, ct_out_len, ss_out);
+}
+
+int clwe_encapsulate_batch(const clwe_ctx* ctx, size_t count, const uint8_t* pks, size_t pk_len, uint8_t* ct_out,
+                           size_t ct_out_len, uint8_t* ss_out) {
+    if (ctx == nullptr || ss_out == nullptr) {
+        return CLWE_ERROR_INVALID_ARGUMENT;
+    }
+    if (count == 0) {
+        return CLWE_OK;
+    }
+    // No buffer can hold more secrets than this, so there is nothing to zero
+    if (count > SIZE_MAX / CLWE_SHARED_SECRET_BYTES) {
+        return CLWE_ERROR_INVALID_ARGUMENT;
+    }
+    if (pks == nullptr || ct_out == nullptr || pk_len != ctx->public_key_bytes) {
+        std::memset(ss_out, 0, count * CLWE_SHARED_SECRET_BYTES);
+        return CLWE_ERROR_INVALID_ARGUMENT;
+    }
+    if (ct_out_len < ctx->ciphertext_bytes) {
+        std::memset(ss_out, 0, count * CLWE_SHARED_SECRET_BYTES);
+        return CLWE_ERROR_BUFFER_TOO_SMALL;
+    }
+    try {
+        clwe::KemWorkspace& workspace = clwe::c_api_workspace();
+        clwe::SharedSecret shared_key;
+        for (size_t i = 0; i < count; ++i) {
+            clwe::CLWEError error = ctx->kem.try_encapsulate_key_into(
+                clwe::public_key_view(*ctx, pks + i * pk_len), ct_out + i * ct_out_len, ct_out_len, shared_key,
+                workspace);
+            if (error != clwe::CLWEError::SUCCESS) {
+                clwe::secure_zero(ss_out, count * CLWE_SHARED_SECRET_BYTES);
+                return clwe::error_status(error);
+            }
+            std::memcpy(ss_out + i * CLWE_SHARED_SECRET_BYTES, shared_key.data(), CLWE_SHARED_SECRET_BYTES);
+        }
+        clwe::secure_zero(shared_key.data(), shared_key.size());
+        return CLWE_OK;
+    } catch (...) {
+        clwe::secure_zero(ss_out, count * CLWE_SHARED_SECRET_BYTES);
+        return clwe::current_exception_status();
+    }
+}
+
+int clwe_decapsulate(const clwe_ctx* ctx, const uint8_t* sk, size_t sk_len, const uint8_t* ct, size_t ct_len,
+                     uint8_t* ss_out) {
+    if (ctx == nullptr || ss_out == nullptr) {
+        return CLWE_ERROR_INVALID_ARGUMENT;
+    }
+    if (sk == nullptr || ct == nullptr || sk_len != ctx->private_key_bytes || ct_len != ctx->ciphertext_bytes) {
+        std::memset(ss_out, 0, CLWE_SHARED_SECRET_BYTES);
+        return CLWE_ERROR_INVALID_ARGUMENT;
+    }
+    try {
+        // Every malformed input below comes back as a code: a flood of bad ciphertexts
+        // never unwinds or formats a message
+        std::shared_ptr<const clwe::ColorExpandedPrivateKey> private_key;
+        clwe::ColorCiphertextView ciphertext;
+        clwe::SharedSecret shared_key;
+        clwe::CLWEError error = clwe::private_key_for(*ctx, sk, private_key);
+        if (error == clwe::CLWEError::SUCCESS) {
+            error = clwe::ColorCiphertextView::try_parse(ct, ct_len, ctx->kem.params(), ciphertext);
+        }
+        if (error == clwe::CLWEError::SUCCESS) {
+            error = ctx->kem.try_decapsulate_key(*private_key, ciphertext, shared_key, clwe::c_api_workspace());
+        }
+        if (error != clwe::CLWEError::SUCCESS) {
+            std::memset(ss_out, 0, CLWE_SHARED_SECRET_BYTES);
+            return clwe::error_status(error);
+        }
+        std::memcpy(ss_out, shared_key.data(), CLWE_SHARED_SECRET_BYTES);
+        clwe::secure_zero(shared_key.data(), shared_key.size());
+        return CLWE_OK;
+    } catch (...) {
+        std::memset(ss_out, 0, CLWE_SHARED_SECRET_BYTES);
+        return clwe::current_exception_status();
+    }
+}
+
+} // extern "C"
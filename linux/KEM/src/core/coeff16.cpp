@@ -0,0 +1,187 @@
+#include "coeff16.hpp"
+#include "cpu_features.hpp"
+#include "ntt_tables.hpp"
+#include "simd_target.hpp"
+
+#ifdef HAVE_AVX2
+#include <immintrin.h>
+#endif
+#ifdef HAVE_NEON
+#include <arm_neon.h>
+#endif
+
+namespace clwe {
+
+namespace {
+
+#ifdef HAVE_AVX2
+bool use_avx2() {
+    static const bool supported = CPUFeatureDetector::cached().has_avx2;
+    return supported;
+}
+
+// Big-endian 32-bit words; swap each lane to native order
+CLWE_TARGET_AVX2 inline __m256i load_be32(const uint8_t* in) {
+    const __m256i swap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                          3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    return _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in)), swap);
+}
+
+// Barrett reduction of arbitrary 32-bit lanes; the quotient estimate is at most one short
+CLWE_TARGET_AVX2 inline __m256i reduce32(__m256i x, __m256i q_vec, __m256i m_vec) {
+    __m256i t_even = _mm256_srli_epi64(_mm256_mul_epu32(x, m_vec), 32);
+    __m256i t_odd = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), m_vec);
+    __m256i t = _mm256_blend_epi32(t_even, t_odd, 0xAA);
+    __m256i r = _mm256_sub_epi32(x, _mm256_mullo_epi32(t, q_vec));
+    return _mm256_min_epu32(r, _mm256_sub_epi32(r, q_vec));
+}
+
+// a * b * 2^-16 mod q in (-q, q), for |a * b| < q * 2^15
+CLWE_TARGET_AVX2 inline __m256i montgomery_mul16(__m256i a, __m256i b, __m256i q_vec, __m256i qinv_vec) {
+    __m256i lo = _mm256_mullo_epi16(a, b);
+    __m256i hi = _mm256_mulhi_epi16(a, b);
+    __m256i t = _mm256_mulhi_epi16(_mm256_mullo_epi16(lo, qinv_vec), q_vec);
+    return _mm256_sub_epi16(hi, t);
+}
+
+// The kernels below run whole vector steps and return how many coefficients they handled
+CLWE_TARGET_AVX2 size_t unpack_coeffs_be32_avx2(const uint8_t* in, size_t count, Coeff16* coeffs, uint32_t modulus) {
+    size_t i = 0;
+    const __m256i q_vec = _mm256_set1_epi32(static_cast<int>(modulus));
+    const __m256i m_vec = _mm256_set1_epi32(static_cast<int>(static_cast<uint32_t>((1ULL << 32) / modulus)));
+    for (; i + 16 <= count; i += 16) {
+        __m256i lo = reduce32(load_be32(in + 4 * i), q_vec, m_vec);
+        __m256i hi = reduce32(load_be32(in + 4 * i + 32), q_vec, m_vec);
+        // packus works per 128-bit lane; the permute restores coefficient order
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(coeffs + i), packed);
+    }
+    return i;
+}
+
+CLWE_TARGET_AVX2 size_t pack_coeffs_be32_avx2(const Coeff16* coeffs, size_t count, uint8_t* out) {
+    size_t i = 0;
+    const __m256i swap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                          3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    for (; i + 8 <= count; i += 8) {
+        __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(coeffs + i));
+        __m256i wide = _mm256_shuffle_epi8(_mm256_cvtepu16_epi32(words), swap);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 4 * i), wide);
+    }
+    return i;
+}
+
+CLWE_TARGET_AVX2 size_t multiply_accumulate_avx2(const Coeff16* a, const Coeff16* b, Coeff16* acc, size_t count,
+                                                uint32_t modulus) {
+    size_t i = 0;
+    const __m256i q_vec = _mm256_set1_epi16(static_cast<int16_t>(modulus));
+    const __m256i qinv_vec = _mm256_set1_epi16(static_cast<int16_t>(inverse_mod_2_16(modulus)));
+    // 2^32 mod q undoes the two Montgomery factors of 2^-16
+    const __m256i r2_vec = _mm256_set1_epi16(static_cast<int16_t>((1ULL << 32) % modulus));
+    for (; i + 16 <= count; i += 16) {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        __m256i vacc = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + i));
+
+        __m256i product = montgomery_mul16(montgomery_mul16(va, vb, q_vec, qinv_vec), r2_vec, q_vec, qinv_vec);
+        // (-q, q) -> [0, q), then the sum lands in [0, 2q)
+        product = _mm256_add_epi16(product, _mm256_and_si256(_mm256_srai_epi16(product, 15), q_vec));
+        __m256i sum = _mm256_add_epi16(vacc, product);
+        __m256i over = _mm256_cmpgt_epi16(sum, _mm256_sub_epi16(q_vec, _mm256_set1_epi16(1)));
+        sum = _mm256_sub_epi16(sum, _mm256_and_si256(over, q_vec));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + i), sum);
+    }
+    return i;
+}
+#endif
+
+#ifdef HAVE_NEON
+// Barrett reduction of 32-bit lanes, as reduce32 above
+inline uint32x4_t reduce32_neon(uint32x4_t x, uint32x2_t m_vec, uint32x4_t q_vec) {
+    uint64x2_t lo = vmull_u32(vget_low_u32(x), m_vec);
+    uint64x2_t hi = vmull_u32(vget_high_u32(x), m_vec);
+    uint32x4_t t = vcombine_u32(vshrn_n_u64(lo, 32), vshrn_n_u64(hi, 32));
+    uint32x4_t r = vmlsq_u32(x, t, q_vec);
+    return vminq_u32(r, vsubq_u32(r, q_vec));
+}
+
+inline uint32x4_t load_be32_neon(const uint8_t* in) {
+    return vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(in)));
+}
+#endif
+
+} // namespace
+
+void unpack_coeffs_be32(const uint8_t* in, size_t count, Coeff16* coeffs, uint32_t modulus) {
+    size_t i = 0;
+#ifdef HAVE_AVX2
+    if (use_avx2()) {
+        i = unpack_coeffs_be32_avx2(in, count, coeffs, modulus);
+    }
+#elif defined(HAVE_NEON)
+    const uint32x4_t q_vec = vdupq_n_u32(modulus);
+    const uint32x2_t m_vec = vdup_n_u32(static_cast<uint32_t>((1ULL << 32) / modulus));
+    for (; i + 8 <= count; i += 8) {
+        uint16x4_t lo = vmovn_u32(reduce32_neon(load_be32_neon(in + 4 * i), m_vec, q_vec));
+        uint16x4_t hi = vmovn_u32(reduce32_neon(load_be32_neon(in + 4 * i + 16), m_vec, q_vec));
+        vst1q_s16(coeffs + i, vreinterpretq_s16_u16(vcombine_u16(lo, hi)));
+    }
+#endif
+    for (; i < count; ++i) {
+        const uint8_t* word = in + 4 * i;
+        uint32_t value = (static_cast<uint32_t>(word[0]) << 24) | (static_cast<uint32_t>(word[1]) << 16) |
+                         (static_cast<uint32_t>(word[2]) << 8) | word[3];
+        coeffs[i] = static_cast<Coeff16>(value % modulus);
+    }
+}
+
+void pack_coeffs_be32(const Coeff16* coeffs, size_t count, uint8_t* out) {
+    size_t i = 0;
+#ifdef HAVE_AVX2
+    if (use_avx2()) {
+        i = pack_coeffs_be32_avx2(coeffs, count, out);
+    }
+#elif defined(HAVE_NEON)
+    for (; i + 8 <= count; i += 8) {
+        uint16x8_t words = vreinterpretq_u16_s16(vld1q_s16(coeffs + i));
+        uint32x4_t lo = vmovl_u16(vget_low_u16(words));
+        uint32x4_t hi = vmovl_u16(vget_high_u16(words));
+        vst1q_u8(out + 4 * i, vrev32q_u8(vreinterpretq_u8_u32(lo)));
+        vst1q_u8(out + 4 * i + 16, vrev32q_u8(vreinterpretq_u8_u32(hi)));
+    }
+#endif
+    for (; i < count; ++i) {
+        uint16_t value = static_cast<uint16_t>(coeffs[i]);
+        out[4 * i] = 0;
+        out[4 * i + 1] = 0;
+        out[4 * i + 2] = static_cast<uint8_t>(value >> 8);
+        out[4 * i + 3] = static_cast<uint8_t>(value);
+    }
+}
+
+// The color layout (r, g, b, a) is the big-endian math value, so ColorValue arrays are
+// be32 byte buffers
+void colors_to_coeff16(const ColorValue* colors, Coeff16* coeffs, size_t count, uint32_t modulus) {
+    static_assert(sizeof(ColorValue) == 4, "ColorValue must be 4 packed bytes");
+    unpack_coeffs_be32(reinterpret_cast<const uint8_t*>(colors), count, coeffs, modulus);
+}
+
+void coeff16_to_colors(const Coeff16* coeffs, ColorValue* colors, size_t count) {
+    pack_coeffs_be32(coeffs, count, reinterpret_cast<uint8_t*>(colors));
+}
+
+void coeff16_multiply_accumulate(const Coeff16* a, const Coeff16* b, Coeff16* acc, size_t count,
+                                 uint32_t modulus) {
+    size_t i = 0;
+#ifdef HAVE_AVX2
+    if (use_avx2()) {
+        i = multiply_accumulate_avx2(a, b, acc, count, modulus);
+    }
+#endif
+    for (; i < count; ++i) {
+        uint32_t product = static_cast<uint32_t>(a[i]) * static_cast<uint32_t>(b[i]) % modulus;
+        acc[i] = static_cast<Coeff16>((static_cast<uint32_t>(acc[i]) + product) % modulus);
+    }
+}
+
+} // namespace clwe
@@ -0,0 +1,41 @@
+#ifndef COEFF16_HPP
+#define COEFF16_HPP
+
+#include "color_value.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace clwe {
+
+// Compact working form of a coefficient: the canonical residue in [0, q) as int16_t.
+// ColorValue stays the storage and API format; hot loops convert to this in bulk so
+// AVX2 can work on 16 coefficients per register instead of 8.
+using Coeff16 = int16_t;
+
+// Moduli the int16_t kernels support: odd, and small enough that the sum of two
+// residues stays below 2^15 (q = 3329 qualifies)
+constexpr bool coeff16_supported(uint32_t modulus) {
+    return modulus % 2 == 1 && modulus < (1u << 14);
+}
+
+// count big-endian 32-bit words (the COLOR32 wire layout) -> residues mod q.
+// Byte-swaps with pshufb under AVX2 and vrev32 under NEON.
+void unpack_coeffs_be32(const uint8_t* in, size_t count, Coeff16* coeffs, uint32_t modulus);
+
+// Residues in [0, q) -> count big-endian 32-bit words; out holds 4 * count bytes
+void pack_coeffs_be32(const Coeff16* coeffs, size_t count, uint8_t* out);
+
+// ColorValue math values -> residues mod q
+void colors_to_coeff16(const ColorValue* colors, Coeff16* coeffs, size_t count, uint32_t modulus);
+
+// Residues in [0, q) -> ColorValue
+void coeff16_to_colors(const Coeff16* coeffs, ColorValue* colors, size_t count);
+
+// acc[i] = (acc[i] + a[i] * b[i]) mod q on residues in [0, q); Montgomery multiplication
+// on 16 lanes under AVX2. Requires coeff16_supported(modulus).
+void coeff16_multiply_accumulate(const Coeff16* a, const Coeff16* b, Coeff16* acc, size_t count,
+                                 uint32_t modulus);
+
+} // namespace clwe
+
+#endif // COEFF16_HPP
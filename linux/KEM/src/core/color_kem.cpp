@@ -1,302 +1,1026 @@
 #include "color_kem.hpp"
+#include "aes_ctr.hpp"
+#include "kem_arena.hpp"
+#include "metrics.hpp"
+#include "batch_offload.hpp"
+#include "encoding.hpp"
+#include "rejection_sampling.hpp"
+#include "probes.hpp"
+#include "ring_operations.hpp"
+#include "sparse_ternary.hpp"
+#include "binomial_sampling.hpp"
 #include "shake_sampler.hpp"
+#include "slow_operations.hpp"
+#include "trace.hpp"
 #include "utils.hpp"
+#include "work_counters.hpp"
 #include <random>
 #include <cstring>
 #include <algorithm>
 #include <iomanip>
+#include <map>
+#include <new>
 #include <stdexcept>
+#include <tuple>
+#include <utility>
 
-#ifdef HAVE_AVX2
-#include <immintrin.h>
-#endif
+namespace clwe {
 
-#ifdef HAVE_AVX512
-#include <immintrin.h>
-#endif
+namespace {
 
-#ifdef HAVE_NEON
-#include <arm_neon.h>
-#endif
+// Decode one coefficient of v = c2 - s^T c1 to the bit it carries: 1 when v is closer to
+// q/2 than to 0. s_dot_c1 is already reduced; c2_val may not be. Reduction goes through
+// Barrett rather than %, which would be a data-dependent hardware divide.
+uint32_t decode_message_bit(uint32_t c2_val, uint32_t s_dot_c1, const BarrettReducer& reducer) {
+    uint64_t q = reducer.modulus;
 
-namespace clwe {
+    // Constant-time modular subtraction: v = (c2_val - s_dot_c1) mod q
+    uint64_t v = reducer.sub(reducer.reduce(c2_val), s_dot_c1);
 
-ColorKEM::ColorKEM(const CLWEParameters& params)
-    : params_(params), cpu_features_(CPUFeatureDetector::detect()) {
-    color_ntt_engine_ = std::make_unique<ColorNTTEngine>(params_.modulus, params_.degree);
+    // Constant-time min for dist = min(v, q - v)
+    uint64_t a_dist = v;
+    uint64_t b_dist = q - v;
+    int64_t signed_diff_dist = static_cast<int64_t>(a_dist) - static_cast<int64_t>(b_dist);
+    uint64_t mask_dist = static_cast<uint64_t>(signed_diff_dist >> 63);
+    uint64_t dist = b_dist + (mask_dist & (a_dist - b_dist));
+
+    // Constant-time comparison: bit = 1 if dist > q/4, 0 otherwise
+    uint32_t q_fourth = q / 4;
+    uint64_t diff_m = dist - q_fourth - 1;
+    uint64_t mask_m = static_cast<uint64_t>(static_cast<int64_t>(diff_m) >> 63);
+    return 1 - static_cast<uint32_t>(mask_m & 1);
 }
 
-ColorKEM::~ColorKEM() = default;
+// All ones when x is zero, zero otherwise, without branching on x
+uint32_t ct_zero_mask(uint32_t x) {
+    return static_cast<uint32_t>((static_cast<uint64_t>(x) - 1) >> 32);
+}
 
+// The CLWEError of the exception in flight, for the try_*() functions. By then every
+// input check has passed, so an invalid_argument can only be key content (an
+// unreduced t_hat coefficient)
+CLWEError current_exception_error() noexcept {
+    try {
+        throw;
+    } catch (const std::bad_alloc&) {
+        return CLWEError::MEMORY_ALLOCATION_FAILED;
+    } catch (const std::invalid_argument&) {
+        return CLWEError::INVALID_KEY;
+    } catch (...) {
+        return CLWEError::UNKNOWN_ERROR;
+    }
+}
 
-std::vector<std::vector<std::vector<ColorValue>>> ColorKEM::generate_matrix_A(const std::array<uint8_t, 32>& seed) const {
-    uint32_t k = params_.module_rank;
-    uint32_t n = params_.degree;
-    uint32_t q = params_.modulus;
 
-    std::vector<std::vector<std::vector<ColorValue>>> matrix(k, std::vector<std::vector<ColorValue>>(k, std::vector<ColorValue>(n)));
+// Serialized size of rank polynomials under the parameters' coefficient encoding
+size_t polyvec_size(const CLWEParameters& params, uint32_t rank) {
+    return encoded_coefficients_size(static_cast<size_t>(rank) * params.degree, params.encoding);
+}
 
-    
-    for (uint32_t i = 0; i < k; ++i) {
-        for (uint32_t j = 0; j < k; ++j) {
-            
-            std::vector<uint8_t> shake_input;
-            shake_input.reserve(seed.size() + 2);
-            shake_input.insert(shake_input.end(), seed.begin(), seed.end());
-            shake_input.push_back(static_cast<uint8_t>(i));
-            shake_input.push_back(static_cast<uint8_t>(j));
-
-            
-            SHAKE128Sampler shake128;
-            shake128.init(shake_input.data(), shake_input.size());
-
-            
-            size_t coeff_idx = 0;
-            while (coeff_idx < n) {
-                std::array<uint8_t, 3> bytes;
-                shake128.squeeze(bytes.data(), bytes.size());
-
-                
-                uint16_t coeff1 = ((bytes[0] << 4) | (bytes[1] >> 4)) & 0xFFF;
-                uint16_t coeff2 = ((bytes[1] << 8) | bytes[2]) & 0xFFF;
-
-                if (coeff1 < q && coeff_idx < n) {
-                    matrix[i][j][coeff_idx++] = ColorValue::from_math_value(coeff1);
-                }
-                if (coeff2 < q && coeff_idx < n) {
-                    matrix[i][j][coeff_idx++] = ColorValue::from_math_value(coeff2);
-                }
-            }
-        }
+// Serialized size of public key data: t1 at rounded_t_bits() when t is rounded, whatever
+// the coefficient encoding
+size_t public_data_size(const CLWEParameters& params, CoefficientEncoding encoding) {
+    size_t count = static_cast<size_t>(params.module_rank) * params.degree;
+    if (params.t_dropped_bits != 0) {
+        return compressed_coefficients_size(count, params.rounded_t_bits());
     }
+    return encoded_coefficients_size(count, encoding);
+}
 
-    return matrix;
+// COLOR32 data is a whole number of 4-byte coefficients; packed encodings have no such unit
+bool misaligned(size_t size, const CLWEParameters& params) {
+    return params.encoding == CoefficientEncoding::COLOR32 && size % 4 != 0;
+}
+
+bool public_misaligned(size_t size, const CLWEParameters& params) {
+    return params.t_dropped_bits == 0 && misaligned(size, params);
+}
+
+bool compressed(const CLWEParameters& params) {
+    return params.du != 0;
+}
+
+// Transmitted c2 coefficients: all of them, or only the message-bearing constant term
+size_t c2_size(const CLWEParameters& params) {
+    return params.sparse_c2 ? 1 : params.degree;
 }
 
+// Serialized size of c1 followed by c2: at du and dv bits when compressed
+size_t ciphertext_size(const CLWEParameters& params) {
+    size_t c1_count = static_cast<size_t>(params.module_rank) * params.degree;
+    if (!compressed(params)) {
+        return encoded_coefficients_size(c1_count, params.encoding) +
+               encoded_coefficients_size(c2_size(params), params.encoding);
+    }
+    return compressed_coefficients_size(c1_count, params.du) +
+           compressed_coefficients_size(c2_size(params), params.dv);
+}
+
+bool ciphertext_misaligned(size_t size, const CLWEParameters& params) {
+    return !compressed(params) && misaligned(size, params);
+}
+
+// Domain bytes that keep the derandomized seed expansions apart
+constexpr uint8_t KEYGEN_DOMAIN = 0x4B;
+constexpr uint8_t ENCAPSULATION_DOMAIN = 0x45;
+constexpr uint8_t KEY_ENCAPSULATION_DOMAIN = 0x4D;
+constexpr uint8_t KEY_REJECTION_DOMAIN = 0x52;
+constexpr uint8_t SHARED_SECRET_DOMAIN = 0x53;
+constexpr uint8_t MULTI_RECIPIENT_DOMAIN = 0x4E;
+constexpr uint8_t DEVICE_DOMAIN = 0x44;
+
+// DEVICE_DOMAIN || parameter fingerprint || master seed || device id, both integers
+// little-endian: the SHAKE-256 input of one device's keygen_derand seed
+constexpr size_t DEVICE_INPUT_BYTES = 1 + 8 + 32 + 8;
+
+void device_seed_input(uint64_t params_fingerprint, const std::array<uint8_t, 32>& master_seed, uint64_t device_id,
+                       uint8_t out[DEVICE_INPUT_BYTES]) {
+    out[0] = DEVICE_DOMAIN;
+    for (size_t i = 0; i < 8; ++i) {
+        out[1 + i] = static_cast<uint8_t>(params_fingerprint >> (8 * i));
+        out[41 + i] = static_cast<uint8_t>(device_id >> (8 * i));
+    }
+    std::copy(master_seed.begin(), master_seed.end(), out + 9);
+}
+
+// SHAKE-256(domain || rank || seed) squeezed into out
+void expand_operation_seed(uint8_t domain, uint32_t rank, const std::array<uint8_t, 32>& seed,
+                           uint8_t* out, size_t len) {
+    SHAKE256Sampler& shake = thread_shake256();
+    const uint8_t prefix[2] = {domain, static_cast<uint8_t>(rank)};
+    shake.begin();
+    shake.absorb(prefix, sizeof(prefix));
+    shake.absorb(seed.data(), seed.size());
+    shake.finalize();
+    shake.squeeze(out, len);
+}
 
-std::vector<std::vector<ColorValue>> ColorKEM::generate_error_vector(uint32_t eta) const {
-    std::vector<std::vector<ColorValue>> error_vector(params_.module_rank, std::vector<ColorValue>(params_.degree));
+// SHAKE-256(MULTI_RECIPIENT_DOMAIN || rank || seed || index, little-endian): the noise seed of
+// one seed group or recipient of a multi-recipient encapsulation
+std::array<uint8_t, 32> derive_indexed_seed(uint32_t rank, const std::array<uint8_t, 32>& seed, uint32_t index) {
+    SHAKE256Sampler& shake = thread_shake256();
+    const uint8_t prefix[2] = {MULTI_RECIPIENT_DOMAIN, static_cast<uint8_t>(rank)};
+    const uint8_t suffix[4] = {static_cast<uint8_t>(index), static_cast<uint8_t>(index >> 8),
+                               static_cast<uint8_t>(index >> 16), static_cast<uint8_t>(index >> 24)};
+    std::array<uint8_t, 32> derived;
+    shake.begin();
+    shake.absorb(prefix, sizeof(prefix));
+    shake.absorb(seed.data(), seed.size());
+    shake.absorb(suffix, sizeof(suffix));
+    shake.finalize();
+    shake.squeeze(derived.data(), derived.size());
+    return derived;
+}
+
+// Everything one encapsulation draws, derived from its 32-byte seed m
+struct EncapsulationSeeds {
+    ColorValue shared_secret;
+    std::array<uint8_t, 32> r_seed;
+    std::array<uint8_t, 32> e1_seed;
+    std::array<uint8_t, 32> e2_seed;
+};
+
+EncapsulationSeeds derive_encapsulation_seeds(uint32_t rank, const std::array<uint8_t, 32>& m) {
+    std::array<uint8_t, 1 + 3 * 32> expanded;
+    expand_operation_seed(ENCAPSULATION_DOMAIN, rank, m, expanded.data(), expanded.size());
+
+    EncapsulationSeeds seeds;
+    seeds.shared_secret = ColorValue::from_math_value(expanded[0] & 1);
+    std::copy(expanded.begin() + 1, expanded.begin() + 33, seeds.r_seed.begin());
+    std::copy(expanded.begin() + 33, expanded.begin() + 65, seeds.e1_seed.begin());
+    std::copy(expanded.begin() + 65, expanded.end(), seeds.e2_seed.begin());
+    return seeds;
+}
+
+// The noise seeds a 256-bit encapsulation draws from m
+struct KeyEncapsulationSeeds {
+    std::array<uint8_t, 32> r_seed;
+    std::array<uint8_t, 32> e1_seed;
+    std::array<uint8_t, 32> e2_seed;
+};
+
+KeyEncapsulationSeeds derive_key_encapsulation_seeds(uint32_t rank, const std::array<uint8_t, 32>& m) {
+    std::array<uint8_t, 3 * 32> expanded;
+    expand_operation_seed(KEY_ENCAPSULATION_DOMAIN, rank, m, expanded.data(), expanded.size());
+
+    KeyEncapsulationSeeds seeds;
+    std::copy(expanded.begin(), expanded.begin() + 32, seeds.r_seed.begin());
+    std::copy(expanded.begin() + 32, expanded.begin() + 64, seeds.e1_seed.begin());
+    std::copy(expanded.begin() + 64, expanded.end(), seeds.e2_seed.begin());
+    secure_zero(expanded.data(), expanded.size());
+    return seeds;
+}
 
-    for (auto& poly : error_vector) {
-        SHAKE256Sampler sampler;
-        std::array<uint8_t, 32> seed;
-        secure_random_bytes(seed.data(), seed.size());
-        sampler.init(seed.data(), seed.size());
+// SHAKE-256(domain || rank || m || H(ct)), H(ct) = SHAKE-256(ciphertext data || hint).
+// Both hashes absorb in place, so the ciphertext is never copied.
+SharedSecret derive_shared_secret(uint32_t rank, const std::array<uint8_t, 32>& m, const uint8_t* ciphertext_data,
+                                  size_t ciphertext_size, const uint8_t* hint) {
+    SHAKE256Sampler& shake = thread_shake256();
+    std::array<uint8_t, 32> ciphertext_hash;
+    shake.begin();
+    shake.absorb(ciphertext_data, ciphertext_size);
+    shake.absorb(hint, 4);
+    shake.finalize();
+    shake.squeeze(ciphertext_hash.data(), ciphertext_hash.size());
+
+    SharedSecret secret;
+    const uint8_t prefix[2] = {SHARED_SECRET_DOMAIN, static_cast<uint8_t>(rank)};
+    shake.begin();
+    shake.absorb(prefix, sizeof(prefix));
+    shake.absorb(m.data(), m.size());
+    shake.absorb(ciphertext_hash.data(), ciphertext_hash.size());
+    shake.finalize();
+    shake.squeeze(secret.data(), secret.size());
+    return secret;
+}
 
-        sampler.sample_polynomial_binomial(reinterpret_cast<uint32_t*>(poly.data()), params_.degree, eta, params_.modulus);
+// H(pk) = SHAKE-256(seed || public data), the serialized public key; shared_matrix keys
+// serialize, and so hash, t_hat alone
+std::array<uint8_t, 32> hash_public_key(const ColorPublicKey& public_key) {
+    SHAKE256Sampler& shake = thread_shake256();
+    std::array<uint8_t, 32> hash;
+    shake.begin();
+    if (!public_key.params.shared_matrix) {
+        shake.absorb(public_key.seed.data(), public_key.seed.size());
+    }
+    shake.absorb(public_key.public_data.data(), public_key.public_data.size());
+    shake.finalize();
+    shake.squeeze(hash.data(), hash.size());
+    return hash;
+}
 
-        for (auto& coeff : poly) {
-            coeff = ColorValue::from_math_value(coeff.to_math_value());
+// One noise polynomial: the CBD of SHAKE-256(seed with byte 0 xored by index), or of
+// AES-256-CTR under seed with nonce index for AES256_CTR parameter sets. With ntt set the
+// samples go straight from the sampler's buffer into the forward NTT, and out receives
+// the NTT-domain polynomial instead.
+struct NoiseRequest {
+    const std::array<uint8_t, 32>* seed;
+    uint8_t index;
+    bool ntt;
+    ColorValue* out;
+};
+
+// KemWorkspace::arena_bytes() sizes the workspace from these without seeing them
+static_assert(sizeof(NoiseRequest) == KemWorkspace::NOISE_REQUEST_BYTES, "NoiseRequest size changed");
+static_assert(KemArena::ALIGNMENT == KemWorkspace::ARENA_ALIGNMENT, "KemArena alignment changed");
+static_assert(SHAKE256_RATE == KemWorkspace::NOISE_SHAKE_RATE && cbd_block_bytes(3) == KemWorkspace::NOISE_CBD_BYTES,
+              "Noise sampler stream size changed");
+
+// Fixed-capacity list of noise requests carved from an arena
+struct NoiseBatch {
+    NoiseRequest* requests = nullptr;
+    size_t capacity = 0;
+    size_t count = 0;
+
+    void clear() { count = 0; }
+    void push_back(const NoiseRequest& request) {
+        if (count == capacity) {
+            throw std::logic_error("Noise batch is full: capacity " + std::to_string(capacity));
         }
+        requests[count++] = request;
+    }
+};
+
+// SHAKE-256 output of one 4-lane pass of the bit-sliced CBD over degree n
+constexpr size_t noise_stream_bytes(uint32_t n, uint32_t eta) {
+    return 4 * ((n / 64 * cbd_block_bytes(eta) + SHAKE256_RATE - 1) / SHAKE256_RATE) * SHAKE256_RATE;
+}
+
+// Coefficient and SHAKE stream buffers for sample_noise_batch, carved from an arena
+struct NoiseScratch {
+    uint32_t* coeffs;
+    uint8_t* stream;
+
+    // Arena bytes of a scratch that serves every eta the sampler supports
+    static constexpr size_t arena_bytes(uint32_t n) {
+        return KemArena::block_size(n * sizeof(uint32_t)) + KemArena::block_size(noise_stream_bytes(n, 3));
     }
 
-    return error_vector;
+    static NoiseScratch carve(KemArena& arena, uint32_t n) {
+        return {arena.allocate_array<uint32_t>(n), arena.allocate_array<uint8_t>(noise_stream_bytes(n, 3))};
+    }
+};
+
+// Store one sampled polynomial, transformed first when the request asks for NTT domain
+void store_noise(const NoiseRequest& request, uint32_t* coeffs, uint32_t n, const ColorNTTEngine& engine) {
+    if (request.ntt) {
+        CLWE_PROBE_SCOPE(ntt_forward);
+        engine.ntt_forward_u32_to_colors(coeffs, request.out, 1);
+    } else {
+        colors_from_u32(coeffs, request.out, n);
+    }
 }
 
+// Sample every request, four SHAKE-256 streams at a time on the 4-way Keccak when the
+// bit-sliced CBD applies; the result matches sampling each request on its own
+void sample_noise_batch(const CLWEParameters& params, uint32_t eta, const NoiseRequest* requests, size_t count,
+                        const NoiseScratch& scratch, const ColorNTTEngine& engine) {
+    CLWE_TRACE_SPAN("sample_noise");
+    SlowStageTimer slow_stage(SlowStage::NOISE);
+    const uint32_t n = params.degree;
+    uint32_t* coeffs = scratch.coeffs;
+
+    if (params.xof == XofAlgorithm::AES256_CTR) {
+        // validate() limits AES sets to the block CBD's eta and degree. Requests of one
+        // batch share their seed, so the key schedule is only redone when it changes
+        const size_t stream_blocks = n / 64 * cbd_block_bytes(eta) / AES256CTR::BLOCK_BYTES;
+        AES256CTR aes;
+        const std::array<uint8_t, 32>* keyed = nullptr;
+        for (size_t r = 0; r < count; ++r) {
+            const NoiseRequest& request = requests[r];
+            if (request.seed != keyed) {
+                aes.set_key(request.seed->data());
+                keyed = request.seed;
+            }
+            aes.keystream(request.index, 0, scratch.stream, stream_blocks);
+            cbd_blocks(coeffs, scratch.stream, n / 64, eta, params.modulus);
+            store_noise(request, coeffs, n, engine);
+        }
+        return;
+    }
+
+    if (!((eta == 2 || eta == 3) && params.modulus > eta && n % 64 == 0)) {
+        for (size_t r = 0; r < count; ++r) {
+            const NoiseRequest& request = requests[r];
+            SHAKE256Sampler& sampler = thread_shake256();
+            std::array<uint8_t, 32> indexed_seed = *request.seed;
+            indexed_seed[0] ^= request.index;
+            sampler.init(indexed_seed.data(), indexed_seed.size());
+            sampler.sample_polynomial_binomial(coeffs, n, eta, params.modulus);
+            store_noise(request, coeffs, n, engine);
+        }
+        return;
+    }
+
+    const size_t cbd_blocks_per_poly = n / 64;
+    const size_t shake_blocks = (cbd_blocks_per_poly * cbd_block_bytes(eta) + SHAKE256_RATE - 1) / SHAKE256_RATE;
+    std::array<std::array<uint8_t, 32>, 4> seeds;
+    SHAKE256x4Sampler shake256x4;
+
+    for (size_t first = 0; first < count; first += 4) {
+        const uint8_t* seed_ptrs[4];
+        uint8_t* outputs[4];
+        for (size_t lane = 0; lane < 4; ++lane) {
+            // Lanes past the last request rehash it and are discarded
+            const NoiseRequest& request = requests[std::min(first + lane, count - 1)];
+            seeds[lane] = *request.seed;
+            seeds[lane][0] ^= request.index;
+            seed_ptrs[lane] = seeds[lane].data();
+            outputs[lane] = scratch.stream + lane * shake_blocks * SHAKE256_RATE;
+        }
+        shake256x4.init_x4(seed_ptrs, seeds[0].size());
+        shake256x4.squeeze_blocks_x4(outputs, shake_blocks);
+
+        for (size_t lane = 0; lane < 4 && first + lane < count; ++lane) {
+            cbd_blocks(coeffs, outputs[lane], cbd_blocks_per_poly, eta, params.modulus);
+            store_noise(requests[first + lane], coeffs, n, engine);
+        }
+    }
+}
 
-std::vector<std::vector<ColorValue>> ColorKEM::generate_secret_key(uint32_t eta) const {
-    std::vector<std::vector<ColorValue>> secret_key(params_.module_rank, std::vector<ColorValue>(params_.degree));
+// Fixed-weight ternary s_i in NTT domain, from the stream the binomial sampler would read
+// for the same request (SHAKE-256 of the seed with the index folded in, or its AES nonce)
+void sample_ternary_secret(const CLWEParameters& params, const std::array<uint8_t, 32>& seed, uint8_t index,
+                           const NoiseScratch& scratch, ColorValue* out, const ColorNTTEngine& engine) {
+    const size_t bytes = fixed_weight_random_bytes(params.degree);
+    if (params.xof == XofAlgorithm::AES256_CTR) {
+        AES256CTR aes(seed.data());
+        aes.keystream(index, 0, scratch.stream, bytes / AES256CTR::BLOCK_BYTES);
+    } else {
+        SHAKE256Sampler& sampler = thread_shake256();
+        std::array<uint8_t, 32> indexed_seed = seed;
+        indexed_seed[0] ^= index;
+        sampler.init(indexed_seed.data(), indexed_seed.size());
+        sampler.squeeze(scratch.stream, bytes);
+        secure_zero(indexed_seed.data(), indexed_seed.size());
+    }
+    sample_fixed_weight_ternary(scratch.stream, params.degree, params.secret_weight, params.modulus,
+                                scratch.coeffs, out);
+    CLWE_PROBE_SCOPE(ntt_forward);
+    engine.ntt_forward_colors(out);
+}
 
-    for (auto& poly : secret_key) {
-        SHAKE256Sampler sampler;
-        std::array<uint8_t, 32> seed;
-        secure_random_bytes(seed.data(), seed.size());
-        sampler.init(seed.data(), seed.size());
+} // namespace
+
+// Everything one keygen, encapsulation or decapsulation writes besides its outputs.
+// The polynomials and sampler buffers are carved from one arena when the operation
+// starts and wiped when it ends; nested operations share the outermost one's buffers.
+struct KemWorkspace::Buffers {
+    KemArena arena;
+    unsigned depth = 0;
+    uint32_t rank = 0;
+    uint32_t degree = 0;
+
+    // Key generation: A_hat, s_hat, e_hat and t_hat. Operations that materialize A get
+    // matrix_A; all others get matrix_line, which the streamed products expand one row or
+    // column of A into.
+    bool has_matrix = false;
+    PolyMatrix matrix_A;
+    PolyVec matrix_line;
+    PolyVec secret;
+    PolyVec error;
+    PolyVec public_key;
+
+    // Encryption: r_hat, e1, e2, A^T r and t^T r
+    PolyVec r;
+    PolyVec e1;
+    Poly e2;
+    PolyVec A_trans_r;
+    Poly inner_product;
+    NoiseBatch noise_requests;
+    NoiseScratch noise;
+
+    // c1 || c2 in coefficient form, written by encryption and by ciphertext parsing
+    PolyVec ciphertext_colors;
+
+    // Decryption: s_hat of an unprepared key, c1_hat and s^T c1
+    PolyVec c1_hat;
+    Poly s_dot_c1;
+
+    // Workspaces live across operations, so their arena is worth huge pages
+    Buffers() { arena.set_follow_page_policy(true); }
+
+    void begin(uint32_t k, uint32_t n, bool with_matrix) {
+        if (depth++ > 0) {
+            if (rank != k || degree != n) {
+                --depth;
+                throw std::logic_error("KemWorkspace is already in use for rank " + std::to_string(rank) +
+                                       ", degree " + std::to_string(degree));
+            }
+            if (with_matrix != has_matrix) {
+                --depth;
+                throw std::logic_error("KemWorkspace is already in use with a different matrix A layout");
+            }
+            return;
+        }
 
-        sampler.sample_polynomial_binomial(reinterpret_cast<uint32_t*>(poly.data()), params_.degree, eta, params_.modulus);
+        arena.reserve(KemWorkspace::arena_bytes(k, n, with_matrix));
+        has_matrix = with_matrix;
+        matrix_A = with_matrix ? PolyMatrix(k, n, arena) : PolyMatrix();
+        matrix_line = with_matrix ? PolyVec() : PolyVec(k, n, arena);
+        secret = PolyVec(k, n, arena);
+        error = PolyVec(k, n, arena);
+        public_key = PolyVec(k, n, arena);
+        r = PolyVec(k, n, arena);
+        e1 = PolyVec(k, n, arena);
+        e2 = Poly(n, arena);
+        A_trans_r = PolyVec(k, n, arena);
+        inner_product = Poly(n, arena);
+        ciphertext_colors = PolyVec(k + 1, n, arena);
+        c1_hat = PolyVec(k, n, arena);
+        s_dot_c1 = Poly(n, arena);
+        noise = NoiseScratch::carve(arena, n);
+        noise_requests.capacity = 2 * static_cast<size_t>(k) + 1;
+        noise_requests.requests = arena.allocate_array<NoiseRequest>(noise_requests.capacity);
+        noise_requests.count = 0;
+        rank = k;
+        degree = n;
+        if (arena.used() != KemWorkspace::arena_bytes(k, n, with_matrix)) {
+            throw std::logic_error("KemWorkspace carved " + std::to_string(arena.used()) + " bytes, sized for " +
+                                   std::to_string(KemWorkspace::arena_bytes(k, n, with_matrix)));
+        }
+    }
 
-        for (auto& coeff : poly) {
-            coeff = ColorValue::from_math_value(coeff.to_math_value());
+    void end() {
+        if (--depth == 0) {
+            // The buffers dangle until the next begin() re-carves them
+            arena.reset();
         }
     }
+};
+
+KemWorkspace::KemWorkspace() : buffers_(new Buffers()) {}
+KemWorkspace::~KemWorkspace() = default;
+KemWorkspace::KemWorkspace(KemWorkspace&&) noexcept = default;
+KemWorkspace& KemWorkspace::operator=(KemWorkspace&&) noexcept = default;
 
-    return secret_key;
+size_t KemWorkspace::reserved_bytes() const {
+    return buffers_ ? buffers_->arena.capacity() : 0;
 }
 
+PageBacking KemWorkspace::page_backing() const {
+    return buffers_ ? buffers_->arena.backing() : PageBacking::Heap;
+}
 
-std::vector<std::vector<ColorValue>> ColorKEM::generate_public_key(const std::vector<std::vector<ColorValue>>& secret_key,
-                                                    const std::vector<std::vector<std::vector<ColorValue>>>& matrix_A,
-                                                    const std::vector<std::vector<ColorValue>>& error_vector) const {
+namespace {
 
-    auto As = this->matrix_vector_mul(matrix_A, secret_key);
-    std::vector<std::vector<ColorValue>> public_key(params_.module_rank, std::vector<ColorValue>(params_.degree));
+// Workspace behind the overloads that take none; one per thread, so a shared
+// ColorKEM can serve concurrent callers
+KemWorkspace& thread_workspace() {
+    thread_local KemWorkspace workspace;
+    return workspace;
+}
 
-    for (uint32_t i = 0; i < params_.module_rank; ++i) {
-        for (uint32_t d = 0; d < params_.degree; ++d) {
-            uint64_t as_val = As[i][d].to_math_value();
-            uint64_t e_val = error_vector[i][d].to_math_value();
-            uint64_t pk_val = (as_val + e_val) % params_.modulus;
-            public_key[i][d] = ColorValue::from_math_value(pk_val);
+// Ciphertext that 256-bit decapsulation re-encrypts into; reused so its capacity is
+// reserved once per thread
+ColorCiphertext& thread_key_reencryption() {
+    thread_local ColorCiphertext ciphertext;
+    return ciphertext;
+}
+
+// Installed deployment matrices, one per (rank, degree, modulus, XOF) shape
+using SharedMatrixShape = std::tuple<uint32_t, uint32_t, uint32_t, XofAlgorithm>;
+
+SharedMatrixShape shared_matrix_shape(const CLWEParameters& params) {
+    return SharedMatrixShape(params.module_rank, params.degree, params.modulus, params.xof);
+}
+
+std::mutex& shared_matrix_mutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::map<SharedMatrixShape, std::shared_ptr<const SharedMatrix>>& shared_matrices() {
+    static std::map<SharedMatrixShape, std::shared_ptr<const SharedMatrix>> matrices;
+    return matrices;
+}
+
+// One operation's hold on a workspace; wipes its arena on exit, including by exception
+class WorkspaceScope {
+private:
+    KemWorkspace::Buffers& buffers_;
+
+public:
+    // with_matrix carves room for a materialized matrix A
+    WorkspaceScope(KemWorkspace::Buffers& buffers, const CLWEParameters& params, bool with_matrix = false)
+        : buffers_(buffers) {
+        buffers_.begin(params.module_rank, params.degree, with_matrix);
+    }
+    ~WorkspaceScope() { buffers_.end(); }
+
+    WorkspaceScope(const WorkspaceScope&) = delete;
+    WorkspaceScope& operator=(const WorkspaceScope&) = delete;
+
+    KemWorkspace::Buffers& buffers() { return buffers_; }
+};
+
+} // namespace
+
+ColorKEM::ColorKEM(const CLWEParameters& params)
+    : params_(params), params_fingerprint_(params.fingerprint()),
+      polyvec_bytes_(polyvec_size(params, params.module_rank)),
+      public_key_bytes_(public_data_size(params, params.encoding)), ciphertext_bytes_(ciphertext_size(params)),
+      reducer_(params.reducer()),
+      cpu_features_(CPUFeatureDetector::cached()),
+      expanded_key_cache_capacity_(DEFAULT_EXPANDED_KEY_CACHE_CAPACITY),
+      parallel_min_rank_(DEFAULT_PARALLEL_MIN_RANK), matrix_streaming_(false),
+      random_source_(default_random_source()), batch_device_(BatchDevice::Cpu) {
+    // Engines and CPU features are immutable and shared, so short-lived instances are cheap
+    color_ntt_engine_ = ColorNTTEngine::shared(params_.modulus, params_.degree);
+    // The inverse NTT leaves results scaled by n
+    degree_inv_ = mod_inverse(params_.degree, params_.modulus);
+    if (params_.shared_matrix) {
+        shared_matrix_ = find_shared_matrix(params_);
+        if (!shared_matrix_) {
+            throw std::logic_error("shared_matrix parameters need ColorKEM::install_shared_matrix() first");
+        }
+    }
+}
+
+ColorKEM::~ColorKEM() = default;
+
+
+std::shared_ptr<const SharedMatrix> ColorKEM::install_shared_matrix(const CLWEParameters& params,
+                                                                    const std::array<uint8_t, 32>& seed) {
+    // Expansion needs an instance that does not itself look for the shared matrix
+    CLWEParameters expansion_params = params;
+    expansion_params.shared_matrix = false;
+    expansion_params.validate();
+
+    std::lock_guard<std::mutex> lock(shared_matrix_mutex());
+    std::shared_ptr<const SharedMatrix>& installed = shared_matrices()[shared_matrix_shape(params)];
+    if (installed) {
+        if (installed->seed != seed) {
+            throw std::logic_error("A shared matrix from a different seed is already installed for these parameters");
         }
+        return installed;
     }
 
-    return public_key;
+    ColorKEM kem(expansion_params);
+    auto matrix = std::make_shared<SharedMatrix>();
+    matrix->seed = seed;
+    matrix->matrix_A = std::make_shared<const PolyMatrix>(kem.generate_matrix_A(seed, false));
+    matrix->matrix_A_trans = std::make_shared<const PolyMatrix>(kem.generate_matrix_A(seed, true));
+    installed = std::move(matrix);
+    return installed;
 }
 
 
-std::vector<std::vector<ColorValue>> ColorKEM::matrix_vector_mul(const std::vector<std::vector<std::vector<ColorValue>>>& matrix,
-                                                   const std::vector<std::vector<ColorValue>>& vector) const {
-    uint32_t k = params_.module_rank;
-    uint32_t n = params_.degree;
+std::shared_ptr<const SharedMatrix> ColorKEM::find_shared_matrix(const CLWEParameters& params) {
+    std::lock_guard<std::mutex> lock(shared_matrix_mutex());
+    auto it = shared_matrices().find(shared_matrix_shape(params));
+    return it == shared_matrices().end() ? nullptr : it->second;
+}
 
-    // Validate matrix dimensions
-    if (matrix.size() != k) {
-        throw std::invalid_argument("Invalid matrix rows: expected " + std::to_string(k) + ", got " + std::to_string(matrix.size()));
+
+KemWorkspace::Buffers& ColorKEM::workspace_buffers(KemWorkspace& workspace) const {
+    if (!workspace.buffers_) {
+        // Moved-from workspaces are usable again
+        workspace.buffers_.reset(new KemWorkspace::Buffers());
+    }
+    return *workspace.buffers_;
+}
+
+
+// Uniform entries are sampled directly as NTT-domain values (A_hat)
+PolyMatrix ColorKEM::generate_matrix_A(const std::array<uint8_t, 32>& seed, bool transposed) const {
+    PolyMatrix matrix(params_.module_rank, params_.degree);
+    generate_matrix_A(seed, matrix, transposed);
+    return matrix;
+}
+
+
+template <typename Task>
+void ColorKEM::parallel_for(size_t count, const Task& task) const {
+    if (executor_ && count > 1 && params_.module_rank >= parallel_min_rank_) {
+        // A reference_wrapper fits std::function's inline storage, so this does not allocate either
+        executor_(count, std::function<void(size_t)>(std::cref(task)));
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        task(i);
     }
-    for (const auto& row : matrix) {
-        if (row.size() != k) {
-            throw std::invalid_argument("Invalid matrix columns: expected " + std::to_string(k) + " per row");
+}
+
+
+void ColorKEM::generate_matrix_A(const std::array<uint8_t, 32>& seed, PolyMatrix& matrix, bool transposed) const {
+    CLWE_TRACE_SPAN("generate_matrix_A");
+    SlowStageTimer slow_stage(SlowStage::MATRIX);
+    CLWE_PROBE_SCOPE(generate_matrix_A);
+    uint32_t k = params_.module_rank;
+
+    // Expand four cells per pass on the 4-way Keccak; groups of four write disjoint cells
+    // and may run on the executor. Transposed, position (i, j) reads the seed || j || i
+    // stream, so A^T is stored row-major and A^T r walks it with unit stride.
+    const uint32_t cells = k * k;
+    auto expand_group = [&](size_t group) {
+        const uint32_t first = static_cast<uint32_t>(group) * 4;
+        std::array<uint32_t, 4> group_cells{};
+        std::array<ColorValue*, 4> polys{};
+        const uint32_t count = std::min<uint32_t>(4, cells - first);
+        for (uint32_t lane = 0; lane < count; ++lane) {
+            const uint32_t i = (first + lane) / k;
+            const uint32_t j = (first + lane) % k;
+            group_cells[lane] = transposed ? j * k + i : i * k + j;
+            polys[lane] = matrix.at(i, j);
         }
-        for (const auto& poly : row) {
-            if (poly.size() != n) {
-                throw std::invalid_argument("Invalid polynomial size: expected " + std::to_string(n));
+        expand_matrix_cells(seed, group_cells.data(), polys.data(), count);
+    };
+    parallel_for((cells + 3) / 4, expand_group);
+}
+
+
+void ColorKEM::expand_matrix_cells(const std::array<uint8_t, 32>& seed, const uint32_t* cells,
+                                   ColorValue* const* polys, uint32_t count) const {
+    uint32_t k = params_.module_rank;
+    uint32_t n = params_.degree;
+    uint32_t q = params_.modulus;
+
+    if (params_.xof == XofAlgorithm::AES256_CTR) {
+        // Cell (i, j) reads AES-256-CTR under the seed with nonce i | j << 8, the counterpart
+        // of the seed || i || j SHAKE input, 192 bytes (whole 3-byte triples) at a time
+        constexpr size_t CHUNK_BLOCKS = 12;
+        AES256CTR aes(seed.data());
+        alignas(16) uint8_t stream[CHUNK_BLOCKS * AES256CTR::BLOCK_BYTES];
+        for (uint32_t lane = 0; lane < count; ++lane) {
+            const uint64_t nonce = (cells[lane] / k) | ((cells[lane] % k) << 8);
+            uint32_t* coeffs = reinterpret_cast<uint32_t*>(polys[lane]);
+            uint32_t filled = 0;
+            for (uint32_t block = 0; filled < n; block += CHUNK_BLOCKS) {
+                aes.keystream(nonce, block, stream, CHUNK_BLOCKS);
+                filled += static_cast<uint32_t>(
+                    rejection_sample_uniform12_be(coeffs + filled, n - filled, stream, sizeof(stream), q));
             }
         }
+        return;
+    }
+
+    // Each cell still reads its own SHAKE-128(seed || i || j) stream, so the result matches
+    // one-cell-at-a-time expansion
+    SHAKE128x4Sampler shake128x4;
+    std::array<std::array<uint8_t, 34>, 4> shake_inputs;
+    std::array<std::array<uint8_t, SHAKE128_RATE>, 4> blocks;
+    std::array<uint32_t, 4> filled{};
+    const uint8_t* seeds[4];
+    uint8_t* outputs[4];
+    for (uint32_t lane = 0; lane < 4; ++lane) {
+        // Lanes past count rehash the last cell and are discarded
+        uint32_t cell = cells[std::min(lane, count - 1)];
+        std::copy(seed.begin(), seed.end(), shake_inputs[lane].begin());
+        shake_inputs[lane][32] = static_cast<uint8_t>(cell / k);
+        shake_inputs[lane][33] = static_cast<uint8_t>(cell % k);
+        seeds[lane] = shake_inputs[lane].data();
+        outputs[lane] = blocks[lane].data();
+        if (lane >= count) {
+            filled[lane] = n;
+        }
     }
+    shake128x4.init_x4(seeds, shake_inputs[0].size());
 
-    // Validate vector size
-    if (vector.size() != k) {
-        throw std::invalid_argument("Invalid vector size: expected " + std::to_string(k) + ", got " + std::to_string(vector.size()));
-    }
-    for (const auto& poly : vector) {
-        if (poly.size() != n) {
-            throw std::invalid_argument("Invalid polynomial size: expected " + std::to_string(n));
+    while (filled[0] < n || filled[1] < n || filled[2] < n || filled[3] < n) {
+        shake128x4.squeeze_blocks_x4(outputs, 1);
+        for (uint32_t lane = 0; lane < 4; ++lane) {
+            if (filled[lane] < n) {
+                // ColorValue storage is the big-endian coefficient, so accepted values land in place
+                uint32_t* coeffs = reinterpret_cast<uint32_t*>(polys[lane]);
+                filled[lane] += static_cast<uint32_t>(rejection_sample_uniform12_be(
+                    coeffs + filled[lane], n - filled[lane], blocks[lane].data(), SHAKE128_RATE, q));
+            }
         }
     }
+}
 
-    std::vector<std::vector<ColorValue>> result(k, std::vector<ColorValue>(n));
 
+void ColorKEM::matrix_vector_mul_streamed(const std::array<uint8_t, 32>& seed, const PolyVec& vector, bool transpose,
+                                          PolyVec& line, PolyVec& result) const {
+    CLWE_TRACE_SPAN("matrix_vector_mul_streamed");
+    SlowStageTimer slow_stage(SlowStage::MULTIPLY);
+    uint32_t k = params_.module_rank;
+    uint32_t n = params_.degree;
+
+    // Row i of A (column i for A^T) is expanded into line and consumed before row i + 1,
+    // so at most k polynomials of A exist at a time. Rows share line, so they run in order.
     for (uint32_t i = 0; i < k; ++i) {
-        std::vector<ColorValue> sum(n, ColorValue(0, 0, 0, 0)); // Zero polynomial
-        for (uint32_t j = 0; j < k; ++j) {
-            std::vector<ColorValue> product(n);
-            color_ntt_engine_->multiply_colors(matrix[i][j].data(), vector[j].data(), product.data());
-            // Add product to sum
-            for (uint32_t d = 0; d < n; ++d) {
-                uint64_t s_val = sum[d].to_math_value();
-                uint64_t p_val = product[d].to_math_value();
-                uint64_t new_val = (s_val + p_val) % params_.modulus;
-                sum[d] = ColorValue::from_math_value(new_val);
-            }
+        expand_matrix_line(seed, i, transpose, line);
+        color_ntt_engine_->row_dot_colors(line.data(), n, vector.data(), k, result[i]);
+    }
+}
+
+
+void ColorKEM::expand_matrix_line(const std::array<uint8_t, 32>& seed, uint32_t i, bool transpose,
+                                  PolyVec& line) const {
+    uint32_t k = params_.module_rank;
+    std::array<uint32_t, 4> cells;
+    std::array<ColorValue*, 4> polys;
+    for (uint32_t first = 0; first < k; first += 4) {
+        const uint32_t count = std::min<uint32_t>(4, k - first);
+        for (uint32_t lane = 0; lane < count; ++lane) {
+            uint32_t j = first + lane;
+            cells[lane] = transpose ? j * k + i : i * k + j;
+            polys[lane] = line[j];
         }
-        result[i] = sum;
+        expand_matrix_cells(seed, cells.data(), polys.data(), count);
+    }
+}
+
+
+PolyVec ColorKEM::sample_noise_vector(uint32_t eta, const std::array<uint8_t, 32>& seed) const {
+    PolyVec noise(params_.module_rank, params_.degree);
+    std::vector<NoiseRequest> requests;
+    for (uint32_t i = 0; i < noise.rank(); ++i) {
+        // Byte 0 of the seed is xored with the index to make it unique per element
+        requests.push_back({&seed, static_cast<uint8_t>(i), false, noise[i]});
     }
+    KemArena arena(NoiseScratch::arena_bytes(params_.degree));
+    sample_noise_batch(params_, eta, requests.data(), requests.size(), NoiseScratch::carve(arena, params_.degree),
+                       *color_ntt_engine_);
+
+    return noise;
+}
+
+
+PolyVec ColorKEM::generate_error_vector(uint32_t eta) const {
+    std::array<uint8_t, 32> seed;
+    random_bytes(seed.data(), seed.size());
+    return sample_noise_vector(eta, seed);
+}
+
+
+PolyVec ColorKEM::generate_error_vector_deterministic(uint32_t eta, const std::array<uint8_t, 32>& seed) const {
+    return sample_noise_vector(eta, seed);
+}
+
+
+PolyVec ColorKEM::generate_secret_key(uint32_t eta) const {
+    std::array<uint8_t, 32> seed;
+    random_bytes(seed.data(), seed.size());
+    return sample_noise_vector(eta, seed);
+}
+
+
+PolyVec ColorKEM::generate_secret_key_deterministic(uint32_t eta, const std::array<uint8_t, 32>& seed) const {
+    return sample_noise_vector(eta, seed);
+}
+
 
+// t_hat = A_hat o s_hat + e_hat; every operand and the result are in NTT domain
+void ColorKEM::generate_public_key(const PolyVec& secret_key,
+                                   const PolyMatrix& matrix_A,
+                                   const PolyVec& error_vector,
+                                   PolyVec& public_key) const {
+
+    this->matrix_vector_mul(matrix_A, secret_key, public_key);
+    add_error_vector(error_vector, public_key);
+}
+
+
+void ColorKEM::add_error_vector(const PolyVec& error_vector, PolyVec& public_key) const {
+    polyvec_add(public_key, error_vector, public_key, params_.modulus);
+}
+
+
+// Pointwise product in NTT domain: matrix_hat and vector_hat in, result_hat out
+PolyVec ColorKEM::matrix_vector_mul(const PolyMatrix& matrix, const PolyVec& vector) const {
+    PolyVec result(params_.module_rank, params_.degree);
+    matrix_vector_mul(matrix, vector, result);
     return result;
 }
 
 
-std::vector<std::vector<ColorValue>> ColorKEM::matrix_transpose_vector_mul(const std::vector<std::vector<std::vector<ColorValue>>>& matrix,
-                                                             const std::vector<std::vector<ColorValue>>& vector) const {
+void ColorKEM::matrix_vector_mul(const PolyMatrix& matrix, const PolyVec& vector, PolyVec& result) const {
+    CLWE_TRACE_SPAN("matrix_vector_mul");
+    SlowStageTimer slow_stage(SlowStage::MULTIPLY);
     uint32_t k = params_.module_rank;
     uint32_t n = params_.degree;
 
     // Validate matrix dimensions
-    if (matrix.size() != k) {
-        throw std::invalid_argument("Invalid matrix rows: expected " + std::to_string(k) + ", got " + std::to_string(matrix.size()));
+    if (matrix.rank() != k) {
+        throw std::invalid_argument("Invalid matrix rank: expected " + std::to_string(k) + ", got " + std::to_string(matrix.rank()));
     }
-    for (const auto& row : matrix) {
-        if (row.size() != k) {
-            throw std::invalid_argument("Invalid matrix columns: expected " + std::to_string(k) + " per row");
-        }
-        for (const auto& poly : row) {
-            if (poly.size() != n) {
-                throw std::invalid_argument("Invalid polynomial size: expected " + std::to_string(n));
-            }
-        }
+    if (matrix.degree() != n) {
+        throw std::invalid_argument("Invalid polynomial size: expected " + std::to_string(n));
     }
 
     // Validate vector size
-    if (vector.size() != k) {
-        throw std::invalid_argument("Invalid vector size: expected " + std::to_string(k) + ", got " + std::to_string(vector.size()));
+    if (vector.rank() != k) {
+        throw std::invalid_argument("Invalid vector size: expected " + std::to_string(k) + ", got " + std::to_string(vector.rank()));
     }
-    for (const auto& poly : vector) {
-        if (poly.size() != n) {
-            throw std::invalid_argument("Invalid polynomial size: expected " + std::to_string(n));
-        }
+    if (vector.degree() != n) {
+        throw std::invalid_argument("Invalid polynomial size: expected " + std::to_string(n));
     }
 
-    std::vector<std::vector<ColorValue>> result(k, std::vector<ColorValue>(n));
+    // Output rows are independent, so they may run on the executor
+    parallel_for(k, [&](size_t i) {
+        color_ntt_engine_->row_dot_colors(matrix.at(i, 0), n, vector.data(), k, result[i]);
+    });
+}
 
-    for (uint32_t i = 0; i < k; ++i) {
-        std::vector<ColorValue> sum(n, ColorValue(0, 0, 0, 0)); // Zero polynomial
-        for (uint32_t j = 0; j < k; ++j) {
-            std::vector<ColorValue> product(n);
-            color_ntt_engine_->multiply_colors(matrix[j][i].data(), vector[j].data(), product.data());
-            // Add product to sum
-            for (uint32_t d = 0; d < n; ++d) {
-                uint64_t s_val = sum[d].to_math_value();
-                uint64_t p_val = product[d].to_math_value();
-                uint64_t new_val = (s_val + p_val) % params_.modulus;
-                sum[d] = ColorValue::from_math_value(new_val);
-            }
-        }
-        result[i] = sum;
-    }
 
+// Transposed pointwise product in NTT domain: matrix_hat and vector_hat in, result_hat out
+PolyVec ColorKEM::matrix_transpose_vector_mul(const PolyMatrix& matrix, const PolyVec& vector) const {
+    PolyVec result(params_.module_rank, params_.degree);
+    matrix_transpose_vector_mul(matrix, vector, result);
     return result;
 }
 
 
+void ColorKEM::matrix_transpose_vector_mul(const PolyMatrix& matrix, const PolyVec& vector, PolyVec& result) const {
+    CLWE_TRACE_SPAN("matrix_transpose_vector_mul");
+    SlowStageTimer slow_stage(SlowStage::MULTIPLY);
+    uint32_t k = params_.module_rank;
+    uint32_t n = params_.degree;
+
+    // Validate matrix dimensions
+    if (matrix.rank() != k) {
+        throw std::invalid_argument("Invalid matrix rank: expected " + std::to_string(k) + ", got " + std::to_string(matrix.rank()));
+    }
+    if (matrix.degree() != n) {
+        throw std::invalid_argument("Invalid polynomial size: expected " + std::to_string(n));
+    }
+
+    // Validate vector size
+    if (vector.rank() != k) {
+        throw std::invalid_argument("Invalid vector size: expected " + std::to_string(k) + ", got " + std::to_string(vector.rank()));
+    }
+    if (vector.degree() != n) {
+        throw std::invalid_argument("Invalid polynomial size: expected " + std::to_string(n));
+    }
+
+    // Column i of the row-major matrix: consecutive entries are k polynomials apart
+    parallel_for(k, [&](size_t i) {
+        color_ntt_engine_->row_dot_colors(matrix.at(0, i), static_cast<size_t>(k) * n, vector.data(), k, result[i]);
+    });
+}
+
+
+
+PolyVec ColorKEM::ntt_forward_vector(const PolyVec& vector) const {
+    PolyVec vector_hat = vector;
+    polyvec_ntt(*color_ntt_engine_, vector_hat);
+    return vector_hat;
+}
+
+
+void ColorKEM::ntt_inverse_poly(ColorValue* poly) const {
+    CLWE_PROBE_SCOPE(ntt_inverse);
+    color_ntt_engine_->ntt_inverse_colors(poly);
+    poly_scale(poly, degree_inv_, poly, params_.degree, params_.modulus);
+}
+
+
+void ColorKEM::ntt_inverse_vector(PolyVec& vector) const {
+    polyvec_invntt(*color_ntt_engine_, vector, degree_inv_);
+}
+
+
+// Constant term of the coefficient-domain product: the inverse NTT at index 0 is
+// n^(-1) times the sum of all NTT-domain entries, so this is O(k n) with no transform
+uint32_t ColorKEM::constant_term_ntt(const PolyVec& a_hat, const PolyVec& b_hat) const {
+    uint64_t sum = 0;
+    const ColorValue* a = a_hat.data();
+    const ColorValue* b = b_hat.data();
+    for (size_t c = 0; c < a_hat.coeff_count(); ++c) {
+        // Reduced products are below q^2 < 2^32, so 2^32 terms fit before overflow
+        sum += reducer_.mul(reducer_.reduce(a[c].to_math_value()), reducer_.reduce(b[c].to_math_value()));
+    }
+    return reducer_.mul(static_cast<uint32_t>(sum % params_.modulus), degree_inv_);
+}
+
+
+Poly ColorKEM::inner_product_ntt(const PolyVec& a_hat, const PolyVec& b_hat) const {
+    Poly result_hat(params_.degree);
+    polyvec_basemul_acc(*color_ntt_engine_, a_hat, b_hat, result_hat.data());
+    return result_hat;
+}
+
+
+ColorValue ColorKEM::decrypt_message(const PolyVec& secret_key,
+                                     const PolyVec& ciphertext,
+                                     bool& padding_valid) const {
+    PolyVec c1_hat(params_.module_rank, params_.degree);
+    Poly s_dot_c1_poly(params_.degree);
+    return decrypt_message_into(secret_key, ciphertext, c1_hat, s_dot_c1_poly, padding_valid);
+}
 
-ColorValue ColorKEM::decrypt_message(const std::vector<std::vector<ColorValue>>& secret_key,
-                                     const std::vector<std::vector<ColorValue>>& ciphertext) const {
 
+void ColorKEM::decrypt_inner_product(const PolyVec& secret_key,
+                                     const PolyVec& ciphertext,
+                                     PolyVec& c1_hat,
+                                     Poly& s_dot_c1_poly) const {
     uint32_t k = params_.module_rank;
-    uint32_t q = params_.modulus;
 
-    if (ciphertext.size() != k + 1) {
+    if (ciphertext.rank() != k + 1 || ciphertext.degree() != params_.degree) {
         throw std::invalid_argument("Invalid ciphertext size: expected " + std::to_string(k + 1) + " polynomials");
     }
 
-    if (secret_key.size() != k) {
+    if (secret_key.rank() != k || secret_key.degree() != params_.degree) {
         throw std::invalid_argument("Invalid secret key size: expected " + std::to_string(k) + " polynomials");
     }
 
-    std::vector<std::vector<ColorValue>> c1(ciphertext.begin(), ciphertext.begin() + k);
-    std::vector<ColorValue> c2 = ciphertext[k];
+    // secret_key holds s_hat; one batched forward NTT over c1 and a single inverse
+    std::copy(ciphertext.data(), ciphertext.data() + c1_hat.coeff_count(), c1_hat.data());
+    polyvec_ntt(*color_ntt_engine_, c1_hat);
 
-    std::vector<ColorValue> s_dot_c1_poly(params_.degree, ColorValue(0, 0, 0, 0));
-    for (uint32_t i = 0; i < k; ++i) {
-        std::vector<ColorValue> product(params_.degree);
-        color_ntt_engine_->multiply_colors(secret_key[i].data(), c1[i].data(), product.data());
-        for (uint32_t d = 0; d < params_.degree; ++d) {
-            uint64_t sdc_val = s_dot_c1_poly[d].to_math_value();
-            uint64_t p_val = product[d].to_math_value();
-            s_dot_c1_poly[d] = ColorValue::from_math_value((sdc_val + p_val) % q);
-        }
+    // A sparse c2 carries only the constant term, which needs no inverse NTT
+    if (params_.sparse_c2) {
+        s_dot_c1_poly[0] = ColorValue::from_math_value(constant_term_ntt(secret_key, c1_hat));
+    } else {
+        polyvec_basemul_acc(*color_ntt_engine_, secret_key, c1_hat, s_dot_c1_poly.data());
+        ntt_inverse_poly(s_dot_c1_poly.data());
     }
+}
 
-    uint64_t s_dot_c1 = s_dot_c1_poly[0].to_math_value(); // Constant term
 
-    uint64_t c2_val = c2[0].to_math_value(); // Constant term
-    // Constant-time modular subtraction: v = (c2_val - s_dot_c1) mod q
-    uint64_t diff_v = c2_val - s_dot_c1;
-    uint64_t mask_v = -static_cast<uint64_t>(static_cast<int64_t>(diff_v) >> 63);
-    uint64_t v = diff_v + (mask_v & q);
-    v %= q;
+ColorValue ColorKEM::decrypt_message_into(const PolyVec& secret_key,
+                                          const PolyVec& ciphertext,
+                                          PolyVec& c1_hat,
+                                          Poly& s_dot_c1_poly,
+                                          bool& padding_valid) const {
+    CLWE_TRACE_SPAN("decrypt");
+    SlowStageTimer slow_stage(SlowStage::DECRYPT);
+    decrypt_inner_product(secret_key, ciphertext, c1_hat, s_dot_c1_poly);
+    return decode_message(ciphertext[params_.module_rank], s_dot_c1_poly.data(), padding_valid);
+}
 
-    // Constant-time min for dist = min(v, q - v)
-    uint64_t q_half = q / 2;
-    uint64_t a_dist = v;
-    uint64_t b_dist = q - v;
-    int64_t signed_diff_dist = static_cast<int64_t>(a_dist) - static_cast<int64_t>(b_dist);
-    uint64_t mask_dist = -static_cast<uint64_t>(signed_diff_dist >> 63);
-    uint64_t dist = b_dist + (mask_dist & (a_dist - b_dist));
 
-    // Constant-time comparison: m = 1 if dist > q/4, 0 otherwise
-    uint32_t q_fourth = q / 4;
-    uint64_t diff_m = dist - q_fourth - 1;
-    uint64_t mask_m = -static_cast<uint64_t>(static_cast<int64_t>(diff_m) >> 63);
-    uint32_t m = 1 - static_cast<uint32_t>(mask_m & 1);
+ColorValue ColorKEM::decode_message(const ColorValue* c2, const ColorValue* s_dot_c1, bool& padding_valid) const {
+    // Decode every transmitted coefficient of v = c2 - s^T c1. The message lives in the
+    // constant term; the remaining coefficients encode zero and must decode as such.
+    uint32_t decoded_coeffs = params_.sparse_c2 ? 1 : params_.degree;
+    uint32_t m = decode_message_bit(c2[0].to_math_value(), s_dot_c1[0].to_math_value(), reducer_);
+    uint32_t padding_bits = 0;
+    for (uint32_t d = 1; d < decoded_coeffs; ++d) {
+        padding_bits |= decode_message_bit(c2[d].to_math_value(), s_dot_c1[d].to_math_value(), reducer_);
+    }
 
+    padding_valid = (padding_bits == 0);
     return ColorValue::from_math_value(m);
 }
 
 
+void ColorKEM::decrypt_key_message_into(const PolyVec& secret_key,
+                                        const PolyVec& ciphertext,
+                                        PolyVec& c1_hat,
+                                        Poly& s_dot_c1_poly,
+                                        std::array<uint8_t, 32>& message) const {
+    CLWE_TRACE_SPAN("decrypt");
+    SlowStageTimer slow_stage(SlowStage::DECRYPT);
+    decrypt_inner_product(secret_key, ciphertext, c1_hat, s_dot_c1_poly);
+
+    // Bit i of the message is coefficient i of v = c2 - s^T c1; coefficients past the
+    // message are left to the re-encryption check
+    const ColorValue* c2 = ciphertext[params_.module_rank];
+    message.fill(0);
+    for (uint32_t d = 0; d < KEY_MESSAGE_BITS; ++d) {
+        uint32_t bit = decode_message_bit(c2[d].to_math_value(), s_dot_c1_poly[d].to_math_value(), reducer_);
+        message[d / 8] |= static_cast<uint8_t>(bit << (d % 8));
+    }
+}
+
+
 ColorValue ColorKEM::generate_shared_secret() const {
     uint8_t bytes[4];
-    secure_random_bytes(bytes, 4);
+    random_bytes(bytes, 4);
     uint32_t value = (bytes[0] << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
     value %= params_.modulus;
 
@@ -327,227 +1051,1850 @@ ColorValue ColorKEM::decode_color_secret(const std::vector<uint8_t>& encoded) co
 }
 
 
-std::pair<ColorPublicKey, ColorPrivateKey> ColorKEM::keygen() {
+std::pair<ColorPublicKey, ColorPrivateKey> ColorKEM::keygen() const {
+    return keygen(thread_workspace());
+}
 
-    std::array<uint8_t, 32> matrix_seed;
-    secure_random_bytes(matrix_seed.data(), matrix_seed.size());
 
-    // std::cout << "DEBUG: Matrix seed: ";
-    // for (uint8_t b : matrix_seed) std::cout << std::hex << std::setw(2) << std::setfill('0') << (int)b;
-    // std::cout << std::dec << std::endl;
+std::pair<ColorPublicKey, ColorPrivateKey> ColorKEM::keygen(KemWorkspace& workspace) const {
+    std::array<uint8_t, 32> d;
+    random_bytes(d.data(), d.size());
+    return keygen_derand(d, workspace);
+}
 
-    auto matrix_A = generate_matrix_A(matrix_seed);
-    // std::cout << "DEBUG: Matrix A generated (" << matrix_A.size() << "x" << matrix_A[0].size() << ")" << std::endl;
 
-    auto secret_key_colors = generate_secret_key(params_.eta1);
-    // std::cout << "DEBUG: Secret key generated (" << secret_key_colors.size() << " elements)" << std::endl;
-    // for (size_t i = 0; i < secret_key_colors.size(); ++i) {
-    //     std::cout << "  s[" << i << "] = " << secret_key_colors[i].to_math_value() << std::endl;
-    // }
+std::pair<ColorPublicKey, ColorPrivateKey> ColorKEM::keygen_derand(const std::array<uint8_t, 32>& d) const {
+    return keygen_derand(d, thread_workspace());
+}
 
-    auto error_vector = generate_error_vector(params_.eta1);
-    // std::cout << "DEBUG: Error vector generated (" << error_vector.size() << " elements)" << std::endl;
-    // for (size_t i = 0; i < error_vector.size(); ++i) {
-    //     std::cout << "  e[" << i << "] = " << error_vector[i].to_math_value() << std::endl;
-    // }
 
-    auto public_key_colors = generate_public_key(secret_key_colors, matrix_A, error_vector);
-    // std::cout << "DEBUG: Public key generated (" << public_key_colors.size() << " elements)" << std::endl;
-    // for (size_t i = 0; i < public_key_colors.size(); ++i) {
-    //     std::cout << "  t[" << i << "] = " << public_key_colors[i].to_math_value() << std::endl;
-    // }
+std::pair<ColorPublicKey, ColorPrivateKey> ColorKEM::keygen_derand(const std::array<uint8_t, 32>& d,
+                                                                KemWorkspace& workspace) const {
+    std::array<uint8_t, 32> matrix_seed, secret_seed, error_seed;
+    expand_keygen_seed(d, matrix_seed, secret_seed, error_seed);
+    WorkspaceScope scope(workspace_buffers(workspace), params_, !matrix_streaming_ && !shared_matrix_);
+    return keygen_expanded(matrix_seed, secret_seed, error_seed, scope.buffers());
+}
 
-    
-    std::vector<uint8_t> secret_data;
-    for (const auto& poly : secret_key_colors) {
-        for (const auto& coeff : poly) {
-            auto bytes = color_secret_to_bytes(coeff);
-            secret_data.insert(secret_data.end(), bytes.begin(), bytes.end());
-        }
-    }
 
-    std::vector<uint8_t> public_data;
-    for (const auto& poly : public_key_colors) {
-        for (const auto& coeff : poly) {
-            auto bytes = color_secret_to_bytes(coeff);
-            public_data.insert(public_data.end(), bytes.begin(), bytes.end());
-        }
+void ColorKEM::expand_keygen_seed(const std::array<uint8_t, 32>& d, std::array<uint8_t, 32>& matrix_seed,
+                                  std::array<uint8_t, 32>& secret_seed, std::array<uint8_t, 32>& error_seed) const {
+    std::array<uint8_t, 3 * 32> expanded;
+    expand_operation_seed(KEYGEN_DOMAIN, params_.module_rank, d, expanded.data(), expanded.size());
+    std::copy(expanded.begin(), expanded.begin() + 32, matrix_seed.begin());
+    std::copy(expanded.begin() + 32, expanded.begin() + 64, secret_seed.begin());
+    std::copy(expanded.begin() + 64, expanded.end(), error_seed.begin());
+    secure_zero(expanded.data(), expanded.size());
+}
+
+
+void ColorKEM::sample_keygen_noise(const std::array<uint8_t, 32>& seed, uint8_t index, bool secret, ColorValue* out,
+                                   KemArena& scratch) const {
+    scratch.reset();
+    NoiseScratch noise = NoiseScratch::carve(scratch, params_.degree);
+    if (secret && params_.secret_weight != 0) {
+        sample_ternary_secret(params_, seed, index, noise, out, *color_ntt_engine_);
+        return;
     }
+    // One request gives the polynomial keygen_expanded()'s batch gives it
+    NoiseRequest request{&seed, index, true, out};
+    sample_noise_batch(params_, params_.eta1, &request, 1, noise, *color_ntt_engine_);
+}
 
-    ColorPublicKey public_key{matrix_seed, public_data, params_};
-    ColorPrivateKey private_key{secret_data, params_};
 
-    return {public_key, private_key};
+size_t ColorKEM::keygen_noise_scratch_bytes(uint32_t degree) {
+    return NoiseScratch::arena_bytes(degree);
 }
 
 
-std::pair<ColorCiphertext, ColorValue> ColorKEM::encapsulate(const ColorPublicKey& public_key) {
+std::pair<ColorPublicKey, ColorPrivateKey> ColorKEM::keygen_deterministic(const std::array<uint8_t, 32>& matrix_seed,
+                                                                       const std::array<uint8_t, 32>& secret_seed,
+                                                                       const std::array<uint8_t, 32>& error_seed) const {
+    WorkspaceScope scope(workspace_buffers(thread_workspace()), params_, !matrix_streaming_ && !shared_matrix_);
+    return keygen_expanded(matrix_seed, secret_seed, error_seed, scope.buffers());
+}
 
-    // Validate public key parameters match instance parameters
-    if (public_key.params.security_level != params_.security_level ||
-        public_key.params.modulus != params_.modulus ||
-        public_key.params.degree != params_.degree ||
-        public_key.params.module_rank != params_.module_rank) {
-        throw std::invalid_argument("Public key parameters do not match KEM instance parameters");
+
+std::pair<ColorPublicKey, ColorPrivateKey> ColorKEM::keygen_expanded(const std::array<uint8_t, 32>& matrix_seed,
+                                                                  const std::array<uint8_t, 32>& secret_seed,
+                                                                  const std::array<uint8_t, 32>& error_seed,
+                                                                  KemWorkspace::Buffers& workspace) const {
+    CLWE_TRACE_SPAN("keygen");
+    CLWE_PROBE_SCOPE(keygen);
+    MetricsTimer metrics_timer(MetricOperation::KEYGEN, params_.security_level);
+    SlowOperationTimer slow_timer(MetricOperation::KEYGEN, params_.security_level, *color_ntt_engine_);
+    uint32_t k = params_.module_rank;
+
+    // With a shared matrix the key's own seed is unused: A is the installed one
+    if (!matrix_streaming_ && !shared_matrix_) {
+        generate_matrix_A(matrix_seed, workspace.matrix_A);
     }
 
-    // Validate public key data size
-    if (public_key.public_data.size() != params_.module_rank * params_.degree * 4) {
-        throw std::invalid_argument("Invalid public key data size: expected " + std::to_string(params_.module_rank * params_.degree * 4) + " bytes, got " + std::to_string(public_key.public_data.size()));
+    // s and e share eta1, so both come from one batched pass over their seeds. Keys are
+    // stored in NTT domain (s_hat in the private key, t_hat in the public key), so each
+    // sample is transformed as it leaves the sampler and first stored as s_hat or e_hat
+    workspace.noise_requests.clear();
+    for (uint32_t i = 0; i < k; ++i) {
+        if (params_.secret_weight != 0) {
+            // A fixed-weight s is still multiplied by A in NTT domain: A_hat is sampled there
+            sample_ternary_secret(params_, secret_seed, static_cast<uint8_t>(i), workspace.noise, workspace.secret[i],
+                                  *color_ntt_engine_);
+        } else {
+            workspace.noise_requests.push_back({&secret_seed, static_cast<uint8_t>(i), true, workspace.secret[i]});
+        }
+    }
+    for (uint32_t i = 0; i < k; ++i) {
+        workspace.noise_requests.push_back({&error_seed, static_cast<uint8_t>(i), true, workspace.error[i]});
     }
+    sample_noise_batch(params_, params_.eta1, workspace.noise_requests.requests, workspace.noise_requests.count,
+                       workspace.noise, *color_ntt_engine_);
+
+    if (matrix_streaming_) {
+        matrix_vector_mul_streamed(matrix_seed, workspace.secret, false, workspace.matrix_line, workspace.public_key);
+        add_error_vector(workspace.error, workspace.public_key);
+    } else {
+        generate_public_key(workspace.secret, shared_matrix_ ? *shared_matrix_->matrix_A : workspace.matrix_A,
+                            workspace.error, workspace.public_key);
+    }
+
+    // Pack straight into the returned keys: one exact-size allocation per key, no copies
+    CLWE_TRACE_SPAN("pack_keys");
+    SlowStageTimer slow_stage(SlowStage::PACK);
+    std::pair<ColorPublicKey, ColorPrivateKey> keys;
+    keys.first.seed = shared_matrix_ ? shared_matrix_->seed : matrix_seed;
+    keys.first.params = params_;
+    encode_public_key_data(workspace.public_key, keys.first.public_data);
+    keys.second.params = params_;
+    encode_polyvec(workspace.secret, params_.encoding, keys.second.secret_data);
+    return keys;
+}
 
-    // Validate public key data is not empty and properly sized
-    if (public_key.public_data.empty()) {
-        throw std::invalid_argument("Public key data cannot be empty");
+
+std::pair<ColorCiphertext, ColorValue> ColorKEM::encapsulate(const ColorPublicKey& public_key) const {
+    return encapsulate(public_key, thread_workspace());
+}
+
+
+std::pair<ColorCiphertext, ColorValue> ColorKEM::encapsulate(const ColorPublicKey& public_key,
+                                                           KemWorkspace& workspace) const {
+    std::array<uint8_t, 32> m;
+    random_bytes(m.data(), m.size());
+    return encapsulate_derand(public_key, m, workspace);
+}
+
+
+std::pair<ColorCiphertext, ColorValue> ColorKEM::encapsulate_derand(const ColorPublicKey& public_key,
+                                                                   const std::array<uint8_t, 32>& m) const {
+    return encapsulate_derand(public_key, m, thread_workspace());
+}
+
+
+std::pair<ColorCiphertext, ColorValue> ColorKEM::encapsulate_derand(const ColorPublicKey& public_key,
+                                                                   const std::array<uint8_t, 32>& m,
+                                                                   KemWorkspace& workspace) const {
+    EncapsulationSeeds seeds = derive_encapsulation_seeds(params_.module_rank, m);
+    ColorCiphertext ciphertext;
+    ColorValue shared_secret = encapsulate_public_key(public_key, seeds.r_seed, seeds.e1_seed, seeds.e2_seed,
+                                                      seeds.shared_secret, ciphertext, workspace);
+    return {std::move(ciphertext), shared_secret};
+}
+
+
+std::pair<ColorCiphertext, ColorValue> ColorKEM::encapsulate_deterministic(const ColorPublicKey& public_key,
+                                                                        const std::array<uint8_t, 32>& r_seed,
+                                                                        const std::array<uint8_t, 32>& e1_seed,
+                                                                        const std::array<uint8_t, 32>& e2_seed,
+                                                                        const ColorValue& shared_secret) const {
+    ColorCiphertext ciphertext;
+    encapsulate_public_key(public_key, r_seed, e1_seed, e2_seed, shared_secret, ciphertext, thread_workspace());
+    return {std::move(ciphertext), shared_secret};
+}
+
+
+ColorValue ColorKEM::encapsulate_public_key(const ColorPublicKey& public_key,
+                                            const std::array<uint8_t, 32>& r_seed,
+                                            const std::array<uint8_t, 32>& e1_seed,
+                                            const std::array<uint8_t, 32>& e2_seed,
+                                            const ColorValue& shared_secret,
+                                            ColorCiphertext& ciphertext,
+                                            KemWorkspace& workspace) const {
+    if (!matrix_streaming_) {
+        std::shared_ptr<const ExpandedPublicKey> expanded = cached_expanded_key(public_key);
+        WorkspaceScope scope(workspace_buffers(workspace), params_);
+        return encapsulate_expanded(expanded->matrix_A.get(), nullptr, *expanded->public_key_colors,
+                                    r_seed, e1_seed, e2_seed, shared_secret, ciphertext, scope.buffers());
+    }
+
+    // Streaming skips the expanded-key cache: t_hat is decoded into the workspace and A is
+    // expanded column by column from the seed
+    validate_public_key(public_key);
+    WorkspaceScope scope(workspace_buffers(workspace), params_);
+    KemWorkspace::Buffers& buffers = scope.buffers();
+    decode_public_key_data(public_key.public_data.data(), buffers.public_key, params_.encoding);
+    return encapsulate_expanded(nullptr, &public_key.seed, buffers.public_key,
+                                r_seed, e1_seed, e2_seed, shared_secret, ciphertext, buffers);
+}
+
+
+KemMemoryRequirements ColorKEM::memory_requirements(const CLWEParameters& params, bool matrix_streaming) {
+    return memory_requirements(params.module_rank, params.degree,
+                               public_data_size(params, params.encoding),
+                               ColorPrivateKey::serialized_size(params),
+                               ColorCiphertext::serialized_size(params) - 4,
+                               matrix_streaming);
+}
+
+
+ExpandedPublicKey ColorKEM::expand_public_key(const ColorPublicKey& public_key) const {
+    CLWE_TRACE_SPAN("expand_public_key");
+    SlowStageTimer slow_stage(SlowStage::MATRIX);
+    validate_public_key(public_key);
+
+    ExpandedPublicKey expanded;
+    expanded.seed = public_key.seed;
+    expanded.public_data = public_key.public_data;
+    expanded.params = public_key.params;
+    if (shared_matrix_) {
+        expanded.matrix_A = shared_matrix_->matrix_A_trans;
+    } else {
+        expanded.matrix_A = std::make_shared<const PolyMatrix>(generate_matrix_A(public_key.seed, true));
+    }
+    auto colors = std::make_shared<PolyVec>(params_.module_rank, params_.degree);
+    decode_public_key_data(public_key.public_data.data(), *colors, params_.encoding);
+    expanded.public_key_colors = std::move(colors);
+    expanded.coefficients_reduced = true;
+    return expanded;
+}
+
+
+std::pair<ColorCiphertext, ColorValue> ColorKEM::encapsulate(const ExpandedPublicKey& public_key) const {
+    std::array<uint8_t, 32> m;
+    random_bytes(m.data(), m.size());
+
+    ColorCiphertext ciphertext;
+    ColorValue shared_secret = encapsulate_into(public_key, m, ciphertext, thread_workspace());
+    return {std::move(ciphertext), shared_secret};
+}
+
+
+ColorValue ColorKEM::encapsulate_into(const ExpandedPublicKey& public_key,
+                                      const std::array<uint8_t, 32>& m,
+                                      ColorCiphertext& ciphertext,
+                                      KemWorkspace& workspace) const {
+    if (!matches_parameters(public_key.params) || !public_key.matrix_A || !public_key.public_key_colors) {
+        throw std::invalid_argument("Expanded public key does not belong to this KEM instance");
+    }
+    if (!public_key.coefficients_reduced &&
+        !coefficients_reduced(public_key.public_key_colors->data(), public_key.public_key_colors->coeff_count(),
+                              params_.modulus)) {
+        throw std::invalid_argument("Invalid public key: coefficient not reduced mod q");
+    }
+
+    EncapsulationSeeds seeds = derive_encapsulation_seeds(params_.module_rank, m);
+    WorkspaceScope scope(workspace_buffers(workspace), params_);
+    return encapsulate_expanded(public_key.matrix_A.get(), nullptr, *public_key.public_key_colors,
+                                seeds.r_seed, seeds.e1_seed, seeds.e2_seed, seeds.shared_secret,
+                                ciphertext, scope.buffers());
+}
+
+
+std::pair<ColorCiphertext, ColorValue> ColorKEM::encapsulate(const ColorPublicKeyView& public_key) const {
+    std::array<uint8_t, 32> m;
+    random_bytes(m.data(), m.size());
+
+    ColorCiphertext ciphertext;
+    ColorValue shared_secret = encapsulate_into(public_key, m, ciphertext, thread_workspace());
+    return {std::move(ciphertext), shared_secret};
+}
+
+
+ColorValue ColorKEM::encapsulate_into(const ColorPublicKeyView& public_key,
+                                      const std::array<uint8_t, 32>& m,
+                                      ColorCiphertext& ciphertext,
+                                      KemWorkspace& workspace) const {
+    validate_public_key(public_key);
+    EncapsulationSeeds seeds = derive_encapsulation_seeds(params_.module_rank, m);
+
+    // The view bypasses the expanded-key cache: t_hat goes from the viewed memory into the
+    // workspace, and A is either the shared one, expanded there or streamed from the seed
+    WorkspaceScope scope(workspace_buffers(workspace), params_, !matrix_streaming_ && !shared_matrix_);
+    KemWorkspace::Buffers& buffers = scope.buffers();
+    decode_public_key_data(public_key.public_data, buffers.public_key, public_key.encoding);
+    if (shared_matrix_) {
+        return encapsulate_expanded(shared_matrix_->matrix_A_trans.get(), nullptr, buffers.public_key,
+                                    seeds.r_seed, seeds.e1_seed, seeds.e2_seed, seeds.shared_secret,
+                                    ciphertext, buffers);
+    }
+    std::array<uint8_t, 32> matrix_seed;
+    std::copy(public_key.seed, public_key.seed + matrix_seed.size(), matrix_seed.begin());
+    if (!matrix_streaming_) {
+        generate_matrix_A(matrix_seed, buffers.matrix_A, true);
+        return encapsulate_expanded(&buffers.matrix_A, nullptr, buffers.public_key,
+                                    seeds.r_seed, seeds.e1_seed, seeds.e2_seed, seeds.shared_secret,
+                                    ciphertext, buffers);
+    }
+    return encapsulate_expanded(nullptr, &matrix_seed, buffers.public_key,
+                                seeds.r_seed, seeds.e1_seed, seeds.e2_seed, seeds.shared_secret,
+                                ciphertext, buffers);
+}
+
+
+EncapsulationBundle::~EncapsulationBundle() {
+    wipe();
+}
+
+
+EncapsulationBundle::EncapsulationBundle(EncapsulationBundle&& other) noexcept
+    : params_(other.params_),
+      ciphertext_data_(std::move(other.ciphertext_data_)),
+      c2_(std::move(other.c2_)),
+      shared_secret_(other.shared_secret_),
+      ready_(other.ready_) {
+    other.wipe();
+}
+
+
+EncapsulationBundle& EncapsulationBundle::operator=(EncapsulationBundle&& other) noexcept {
+    if (this != &other) {
+        wipe();
+        params_ = other.params_;
+        ciphertext_data_ = std::move(other.ciphertext_data_);
+        c2_ = std::move(other.c2_);
+        shared_secret_ = other.shared_secret_;
+        ready_ = other.ready_;
+        other.wipe();
+    }
+    return *this;
+}
+
+
+void EncapsulationBundle::wipe() {
+    // c2 before the message and the secret together reveal m; c1 is public
+    if (!c2_.empty()) {
+        secure_zero(c2_.data(), c2_.size() * sizeof(ColorValue));
+    }
+    secure_zero(&shared_secret_, sizeof(shared_secret_));
+    c2_.clear();
+    ciphertext_data_.clear();
+    ready_ = false;
+}
+
+
+void ColorKEM::precompute_bundle(const PolyMatrix* matrix_A_trans, const std::array<uint8_t, 32>* matrix_seed,
+                                 const PolyVec& public_key_colors, EncapsulationBundle& bundle,
+                                 KemWorkspace::Buffers& workspace) const {
+    std::array<uint8_t, 32> m;
+    random_bytes(m.data(), m.size());
+    EncapsulationSeeds seeds = derive_encapsulation_seeds(params_.module_rank, m);
+    secure_zero(m.data(), m.size());
+    encrypt_noise_into(matrix_A_trans, matrix_seed, public_key_colors, seeds.r_seed, seeds.e1_seed, seeds.e2_seed,
+                       workspace);
+
+    // c1 lands where encode_ciphertext() puts it; c2 waits for the message
+    const PolyVec& ciphertext_colors = workspace.ciphertext_colors;
+    const size_t c1_count = static_cast<size_t>(params_.module_rank) * params_.degree;
+    bundle.ciphertext_data_.resize(ciphertext_bytes_);
+    if (compressed(params_)) {
+        compress_encode_coefficients(ciphertext_colors.data(), c1_count, params_.du, params_.modulus,
+                                     bundle.ciphertext_data_.data());
+    } else {
+        encode_coefficients(ciphertext_colors.data(), c1_count, params_.encoding, bundle.ciphertext_data_.data());
+    }
+    const ColorValue* c2 = ciphertext_colors[params_.module_rank];
+    bundle.c2_.assign(c2, c2 + c2_size(params_));
+    bundle.shared_secret_ = seeds.shared_secret;
+    bundle.params_ = params_;
+    bundle.ready_ = true;
+    secure_zero(&seeds, sizeof(seeds));
+}
+
+
+std::vector<EncapsulationBundle> ColorKEM::precompute_encapsulation(const ColorPublicKey& public_key,
+                                                                    size_t count) const {
+    if (!matrix_streaming_) {
+        return precompute_encapsulation(*cached_expanded_key(public_key), count);
+    }
+
+    CLWE_TRACE_SPAN("precompute_encapsulation");
+    validate_public_key(public_key);
+    std::vector<EncapsulationBundle> bundles(count);
+    KemWorkspace& workspace = thread_workspace();
+    for (EncapsulationBundle& bundle : bundles) {
+        WorkspaceScope scope(workspace_buffers(workspace), params_);
+        KemWorkspace::Buffers& buffers = scope.buffers();
+        decode_public_key_data(public_key.public_data.data(), buffers.public_key, params_.encoding);
+        precompute_bundle(nullptr, &public_key.seed, buffers.public_key, bundle, buffers);
+    }
+    return bundles;
+}
+
+
+std::vector<EncapsulationBundle> ColorKEM::precompute_encapsulation(const ExpandedPublicKey& public_key,
+                                                                    size_t count) const {
+    CLWE_TRACE_SPAN("precompute_encapsulation");
+    if (!matches_parameters(public_key.params) || !public_key.matrix_A || !public_key.public_key_colors) {
+        throw std::invalid_argument("Expanded public key does not belong to this KEM instance");
+    }
+    if (!public_key.coefficients_reduced &&
+        !coefficients_reduced(public_key.public_key_colors->data(), public_key.public_key_colors->coeff_count(),
+                              params_.modulus)) {
+        throw std::invalid_argument("Invalid public key: coefficient not reduced mod q");
+    }
+
+    std::vector<EncapsulationBundle> bundles(count);
+    KemWorkspace& workspace = thread_workspace();
+    for (EncapsulationBundle& bundle : bundles) {
+        WorkspaceScope scope(workspace_buffers(workspace), params_);
+        precompute_bundle(public_key.matrix_A.get(), nullptr, *public_key.public_key_colors, bundle,
+                          scope.buffers());
+    }
+    return bundles;
+}
+
+
+std::pair<ColorCiphertext, ColorValue> ColorKEM::encapsulate_online(EncapsulationBundle& bundle) const {
+    ColorCiphertext ciphertext;
+    ColorValue shared_secret = encapsulate_online(bundle, ciphertext);
+    return {std::move(ciphertext), shared_secret};
+}
+
+
+ColorValue ColorKEM::encapsulate_online(EncapsulationBundle& bundle, ColorCiphertext& ciphertext) const {
+    if (!bundle.ready_) {
+        throw std::invalid_argument("Encapsulation bundle is empty or already used");
+    }
+    if (!matches_parameters(bundle.params_)) {
+        throw std::invalid_argument("Encapsulation bundle does not belong to this KEM instance");
+    }
+    CLWE_TRACE_SPAN("encapsulate_online");
+    MetricsTimer metrics_timer(MetricOperation::ENCAPSULATE, params_.security_level);
+    SlowOperationTimer slow_timer(MetricOperation::ENCAPSULATE, params_.security_level, *color_ntt_engine_);
+    SlowStageTimer slow_stage(SlowStage::PACK);
+
+    // c2 += m * q/2 * x^0, as add_message()
+    const ColorValue shared_secret = bundle.shared_secret_;
+    ColorValue* c2 = bundle.c2_.data();
+    const uint32_t encoded_m = shared_secret.to_math_value() * (params_.modulus / 2);
+    c2[0] = ColorValue::from_math_value(reducer_.reduce(c2[0].to_math_value() + encoded_m));
+
+    const size_t c1_count = static_cast<size_t>(params_.module_rank) * params_.degree;
+    uint8_t* bytes = bundle.ciphertext_data_.data();
+    if (compressed(params_)) {
+        compress_encode_coefficients(c2, bundle.c2_.size(), params_.dv, params_.modulus,
+                                     bytes + compressed_coefficients_size(c1_count, params_.du));
+    } else {
+        encode_coefficients(c2, bundle.c2_.size(), params_.encoding,
+                            bytes + encoded_coefficients_size(c1_count, params_.encoding));
+    }
+    ciphertext.ciphertext_data.swap(bundle.ciphertext_data_);
+
+    uint32_t hint = shared_secret.to_math_value();
+    ciphertext.shared_secret_hint.resize(4);
+    ciphertext.shared_secret_hint[0] = static_cast<uint8_t>((hint >> 24) & 0xFF);
+    ciphertext.shared_secret_hint[1] = static_cast<uint8_t>((hint >> 16) & 0xFF);
+    ciphertext.shared_secret_hint[2] = static_cast<uint8_t>((hint >> 8) & 0xFF);
+    ciphertext.shared_secret_hint[3] = static_cast<uint8_t>(hint & 0xFF);
+    ciphertext.params = params_;
+    bundle.wipe();
+    return shared_secret;
+}
+
+
+ColorValue ColorKEM::encapsulate_streamed(const ColorPublicKey& public_key, const CiphertextSink& sink) const {
+    std::array<uint8_t, 32> m;
+    random_bytes(m.data(), m.size());
+    return encapsulate_streamed(public_key, m, sink, thread_workspace());
+}
+
+
+ColorValue ColorKEM::encapsulate_streamed(const ColorPublicKey& public_key, const std::array<uint8_t, 32>& m,
+                                          const CiphertextSink& sink, KemWorkspace& workspace) const {
+    EncapsulationSeeds seeds = derive_encapsulation_seeds(params_.module_rank, m);
+    if (!matrix_streaming_) {
+        std::shared_ptr<const ExpandedPublicKey> expanded = cached_expanded_key(public_key);
+        WorkspaceScope scope(workspace_buffers(workspace), params_);
+        return encapsulate_expanded_streamed(expanded->matrix_A.get(), nullptr, *expanded->public_key_colors,
+                                             seeds.r_seed, seeds.e1_seed, seeds.e2_seed, seeds.shared_secret,
+                                             sink, scope.buffers());
+    }
+
+    validate_public_key(public_key);
+    WorkspaceScope scope(workspace_buffers(workspace), params_);
+    KemWorkspace::Buffers& buffers = scope.buffers();
+    decode_public_key_data(public_key.public_data.data(), buffers.public_key, params_.encoding);
+    return encapsulate_expanded_streamed(nullptr, &public_key.seed, buffers.public_key,
+                                         seeds.r_seed, seeds.e1_seed, seeds.e2_seed, seeds.shared_secret,
+                                         sink, buffers);
+}
+
+
+ColorValue ColorKEM::encapsulate_streamed(const ExpandedPublicKey& public_key, const std::array<uint8_t, 32>& m,
+                                          const CiphertextSink& sink, KemWorkspace& workspace) const {
+    if (!matches_parameters(public_key.params) || !public_key.matrix_A || !public_key.public_key_colors) {
+        throw std::invalid_argument("Expanded public key does not belong to this KEM instance");
+    }
+    if (!public_key.coefficients_reduced &&
+        !coefficients_reduced(public_key.public_key_colors->data(), public_key.public_key_colors->coeff_count(),
+                              params_.modulus)) {
+        throw std::invalid_argument("Invalid public key: coefficient not reduced mod q");
+    }
+
+    EncapsulationSeeds seeds = derive_encapsulation_seeds(params_.module_rank, m);
+    WorkspaceScope scope(workspace_buffers(workspace), params_);
+    return encapsulate_expanded_streamed(public_key.matrix_A.get(), nullptr, *public_key.public_key_colors,
+                                         seeds.r_seed, seeds.e1_seed, seeds.e2_seed, seeds.shared_secret,
+                                         sink, scope.buffers());
+}
+
+
+std::pair<ColorCiphertext, SharedSecret> ColorKEM::encapsulate_key(const ColorPublicKey& public_key) const {
+    return encapsulate_key(public_key, thread_workspace());
+}
+
+
+std::pair<ColorCiphertext, SharedSecret> ColorKEM::encapsulate_key(const ColorPublicKey& public_key,
+                                                                   KemWorkspace& workspace) const {
+    std::array<uint8_t, 32> m;
+    random_bytes(m.data(), m.size());
+    auto result = encapsulate_key_derand(public_key, m, workspace);
+    secure_zero(m.data(), m.size());
+    return result;
+}
+
+
+std::pair<ColorCiphertext, SharedSecret> ColorKEM::encapsulate_key_derand(const ColorPublicKey& public_key,
+                                                                          const std::array<uint8_t, 32>& m) const {
+    return encapsulate_key_derand(public_key, m, thread_workspace());
+}
+
+
+std::pair<ColorCiphertext, SharedSecret> ColorKEM::encapsulate_key_derand(const ColorPublicKey& public_key,
+                                                                          const std::array<uint8_t, 32>& m,
+                                                                          KemWorkspace& workspace) const {
+    std::pair<ColorCiphertext, SharedSecret> result;
+    result.second = encapsulate_key_derand_into(public_key, m, result.first, workspace);
+    return result;
+}
+
+
+SharedSecret ColorKEM::encapsulate_key_derand_into(const ColorPublicKey& public_key,
+                                                   const std::array<uint8_t, 32>& m,
+                                                   ColorCiphertext& ciphertext,
+                                                   KemWorkspace& workspace) const {
+    validate_key_message_mode();
+    MetricsTimer metrics_timer(MetricOperation::ENCAPSULATE, params_.security_level);
+    SlowOperationTimer slow_timer(MetricOperation::ENCAPSULATE, params_.security_level, *color_ntt_engine_);
+    if (!matrix_streaming_) {
+        std::shared_ptr<const ExpandedPublicKey> expanded = cached_expanded_key(public_key);
+        WorkspaceScope scope(workspace_buffers(workspace), params_);
+        return encapsulate_key_expanded(expanded->matrix_A.get(), nullptr, *expanded->public_key_colors,
+                                        m, ciphertext, scope.buffers());
+    }
+
+    validate_public_key(public_key);
+    WorkspaceScope scope(workspace_buffers(workspace), params_);
+    KemWorkspace::Buffers& buffers = scope.buffers();
+    decode_public_key_data(public_key.public_data.data(), buffers.public_key, params_.encoding);
+    return encapsulate_key_expanded(nullptr, &public_key.seed, buffers.public_key, m, ciphertext, buffers);
+}
+
+
+CLWEError ColorKEM::try_encapsulate_key(const ColorPublicKey& public_key, ColorCiphertext& ciphertext,
+                                        SharedSecret& shared_key) const noexcept {
+    try {
+        return try_encapsulate_key(public_key, ciphertext, shared_key, thread_workspace());
+    } catch (...) {
+        // Only the first use of the thread's workspace can throw here
+        shared_key = SharedSecret();
+        return current_exception_error();
+    }
+}
+
+
+CLWEError ColorKEM::try_encapsulate_key(const ColorPublicKey& public_key, ColorCiphertext& ciphertext,
+                                        SharedSecret& shared_key, KemWorkspace& workspace) const noexcept {
+    shared_key = SharedSecret();
+    CLWEError error = check_key_message_mode();
+    if (error == CLWEError::SUCCESS) {
+        error = check_public_key(public_key);
+    }
+    if (error != CLWEError::SUCCESS) {
+        return error;
+    }
+    std::array<uint8_t, 32> m;
+    try {
+        random_bytes(m.data(), m.size());
+        shared_key = encapsulate_key_derand_into(public_key, m, ciphertext, workspace);
+        secure_zero(m.data(), m.size());
+        return CLWEError::SUCCESS;
+    } catch (...) {
+        secure_zero(m.data(), m.size());
+        shared_key = SharedSecret();
+        return current_exception_error();
+    }
+}
+
+
+CLWEError ColorKEM::try_encapsulate_key_into(const ColorPublicKeyView& public_key, uint8_t* ciphertext_out,
+                                             size_t ciphertext_out_size, SharedSecret& shared_key,
+                                             KemWorkspace& workspace) const noexcept {
+    shared_key = SharedSecret();
+    CLWEError error = check_key_message_mode();
+    if (error == CLWEError::SUCCESS) {
+        error = check_public_key(public_key);
+    }
+    if (error != CLWEError::SUCCESS) {
+        return error;
+    }
+    if (ciphertext_out == nullptr || ciphertext_out_size < ciphertext_bytes_ + 4) {
+        return CLWEError::BUFFER_TOO_SMALL;
+    }
+    try {
+        shared_key = encapsulate_key_into(public_key, ciphertext_out, ciphertext_out_size, workspace);
+        return CLWEError::SUCCESS;
+    } catch (...) {
+        shared_key = SharedSecret();
+        return current_exception_error();
+    }
+}
+
+
+SharedSecret ColorKEM::encapsulate_key_into(const ColorPublicKeyView& public_key,
+                                            uint8_t* ciphertext_out,
+                                            size_t ciphertext_out_size,
+                                            KemWorkspace& workspace) const {
+    std::array<uint8_t, 32> m;
+    random_bytes(m.data(), m.size());
+    SharedSecret shared_key = encapsulate_key_into(public_key, m, ciphertext_out, ciphertext_out_size, workspace);
+    secure_zero(m.data(), m.size());
+    return shared_key;
+}
+
+
+SharedSecret ColorKEM::encapsulate_key_into(const ColorPublicKeyView& public_key,
+                                            const std::array<uint8_t, 32>& m,
+                                            uint8_t* ciphertext_out,
+                                            size_t ciphertext_out_size,
+                                            KemWorkspace& workspace) const {
+    validate_key_message_mode();
+    validate_public_key(public_key);
+    const size_t size = ciphertext_bytes_ + 4;
+    if (ciphertext_out == nullptr || ciphertext_out_size < size) {
+        throw std::invalid_argument("Output buffer too small: need " + std::to_string(size) + " bytes, got " + std::to_string(ciphertext_out_size));
+    }
+    MetricsTimer metrics_timer(MetricOperation::ENCAPSULATE, params_.security_level);
+    SlowOperationTimer slow_timer(MetricOperation::ENCAPSULATE, params_.security_level, *color_ntt_engine_);
+
+    // As encapsulate_into() on a view: t_hat is decoded into the workspace, A shared,
+    // expanded there or streamed, and the serialized ciphertext written straight to the caller
+    WorkspaceScope scope(workspace_buffers(workspace), params_, !matrix_streaming_ && !shared_matrix_);
+    KemWorkspace::Buffers& buffers = scope.buffers();
+    decode_public_key_data(public_key.public_data, buffers.public_key, public_key.encoding);
+    if (shared_matrix_) {
+        return encapsulate_key_expanded(shared_matrix_->matrix_A_trans.get(), nullptr, buffers.public_key, m,
+                                        ciphertext_out, ciphertext_out + ciphertext_bytes_, buffers);
+    }
+    std::array<uint8_t, 32> matrix_seed;
+    std::copy(public_key.seed, public_key.seed + matrix_seed.size(), matrix_seed.begin());
+    if (!matrix_streaming_) {
+        generate_matrix_A(matrix_seed, buffers.matrix_A, true);
+        return encapsulate_key_expanded(&buffers.matrix_A, nullptr, buffers.public_key, m,
+                                        ciphertext_out, ciphertext_out + ciphertext_bytes_, buffers);
+    }
+    return encapsulate_key_expanded(nullptr, &matrix_seed, buffers.public_key, m,
+                                    ciphertext_out, ciphertext_out + ciphertext_bytes_, buffers);
+}
+
+
+SharedSecret ColorKEM::encapsulate_key_expanded(const PolyMatrix* matrix_A_trans,
+                                                const std::array<uint8_t, 32>* matrix_seed,
+                                                const PolyVec& public_key_colors,
+                                                const std::array<uint8_t, 32>& m,
+                                                uint8_t* ciphertext_data,
+                                                uint8_t* hint,
+                                                KemWorkspace::Buffers& workspace) const {
+    CLWE_TRACE_SPAN("encapsulate");
+    CLWE_PROBE_SCOPE(encapsulate);
+    KeyEncapsulationSeeds seeds = derive_key_encapsulation_seeds(params_.module_rank, m);
+    encrypt_key_message_into(matrix_A_trans, matrix_seed, public_key_colors, m,
+                             seeds.r_seed, seeds.e1_seed, seeds.e2_seed, ciphertext_data, workspace);
+
+    // The key is confirmed by re-encryption, so the hint carries nothing and stays zero
+    std::fill(hint, hint + 4, uint8_t(0));
+
+    secure_zero(&seeds, sizeof(seeds));
+    return derive_shared_secret(params_.module_rank, m, ciphertext_data, ciphertext_bytes_, hint);
+}
+
+
+SharedSecret ColorKEM::encapsulate_key_expanded(const PolyMatrix* matrix_A_trans,
+                                                const std::array<uint8_t, 32>* matrix_seed,
+                                                const PolyVec& public_key_colors,
+                                                const std::array<uint8_t, 32>& m,
+                                                ColorCiphertext& ciphertext,
+                                                KemWorkspace::Buffers& workspace) const {
+    ciphertext.ciphertext_data.resize(ciphertext_bytes_);
+    ciphertext.shared_secret_hint.resize(4);
+    ciphertext.params = params_;
+    return encapsulate_key_expanded(matrix_A_trans, matrix_seed, public_key_colors, m,
+                                    ciphertext.ciphertext_data.data(), ciphertext.shared_secret_hint.data(),
+                                    workspace);
+}
+
+
+CLWEError ColorKEM::check_key_message_mode() const noexcept {
+    return params_.degree < KEY_MESSAGE_BITS || params_.sparse_c2 ? CLWEError::INVALID_PARAMETERS
+                                                                 : CLWEError::SUCCESS;
+}
+
+
+CLWEError ColorKEM::check_public_key(const ColorPublicKey& public_key) const noexcept {
+    if (!matches_parameters(public_key.params)) {
+        return CLWEError::INVALID_PARAMETERS;
+    }
+    return public_key.public_data.size() == public_key_bytes_ ? CLWEError::SUCCESS : CLWEError::INVALID_KEY;
+}
+
+
+CLWEError ColorKEM::check_public_key(const ColorPublicKeyView& public_key) const noexcept {
+    // Views of shared_matrix keys need no seed
+    if ((public_key.seed == nullptr && !shared_matrix_) || public_key.public_data == nullptr) {
+        return CLWEError::INVALID_KEY;
+    }
+    if (!matches_parameters(public_key.params)) {
+        return CLWEError::INVALID_PARAMETERS;
+    }
+    if (public_key.encoding == CoefficientEncoding::PACKED12 && params_.modulus > 4096) {
+        return CLWEError::INVALID_KEY;
+    }
+    size_t expected = public_data_size(params_, public_key.encoding);
+    return public_key.public_data_size == expected ? CLWEError::SUCCESS : CLWEError::INVALID_KEY;
+}
+
+
+CLWEError ColorKEM::check_private_key(const CLWEParameters& params,
+                                      const std::vector<uint8_t>& secret_data) const noexcept {
+    if (!matches_parameters(params)) {
+        return CLWEError::INVALID_PARAMETERS;
+    }
+    return secret_data.size() == polyvec_bytes_ ? CLWEError::SUCCESS : CLWEError::INVALID_KEY;
+}
+
+
+CLWEError ColorKEM::check_ciphertext(const ColorCiphertextView& ciphertext) const noexcept {
+    if (!matches_parameters(ciphertext.params)) {
+        return CLWEError::INVALID_PARAMETERS;
+    }
+    // ColorCiphertextView(ColorCiphertext) leaves the hint unbound unless it is 4 bytes
+    if (ciphertext.ciphertext_size != ciphertext_bytes_ || ciphertext.ciphertext_data == nullptr ||
+        ciphertext.shared_secret_hint == nullptr) {
+        return CLWEError::INVALID_CIPHERTEXT;
+    }
+    return CLWEError::SUCCESS;
+}
+
+
+void ColorKEM::validate_key_message_mode() const {
+    if (params_.degree < KEY_MESSAGE_BITS || params_.sparse_c2) {
+        throw std::invalid_argument("256-bit key encapsulation needs a degree of at least " +
+                                    std::to_string(KEY_MESSAGE_BITS) + " and a full c2");
+    }
+}
+
+
+void ColorKEM::validate_public_key(const ColorPublicKey& public_key) const {
+    if (check_public_key(public_key) == CLWEError::SUCCESS) {
+        return;
+    }
+    if (!matches_parameters(public_key.params)) {
+        throw std::invalid_argument("Public key parameters do not match KEM instance parameters");
+    }
+    // public_key_bytes_ is never 0, so this also rejects empty data
+    if (public_key.public_data.size() != public_key_bytes_) {
+        throw std::invalid_argument("Invalid public key data size: expected " + std::to_string(public_key_bytes_) + " bytes, got " + std::to_string(public_key.public_data.size()));
+    }
+}
+
+
+void ColorKEM::validate_public_key(const ColorPublicKeyView& public_key) const {
+    if (check_public_key(public_key) == CLWEError::SUCCESS) {
+        return;
+    }
+    if ((public_key.seed == nullptr && !shared_matrix_) || public_key.public_data == nullptr) {
+        throw std::invalid_argument("Public key view cannot be empty");
+    }
+    if (!matches_parameters(public_key.params)) {
+        throw std::invalid_argument("Public key parameters do not match KEM instance parameters");
+    }
+    if (public_key.encoding == CoefficientEncoding::PACKED12 && params_.modulus > 4096) {
+        throw std::invalid_argument("Invalid public key encoding: PACKED12 requires a modulus of at most 4096");
+    }
+
+    size_t expected = public_data_size(params_, public_key.encoding);
+    if (public_key.public_data_size != expected) {
+        throw std::invalid_argument("Invalid public key data size: expected " + std::to_string(expected) + " bytes, got " + std::to_string(public_key.public_data_size));
+    }
+}
+
+
+void ColorKEM::validate_ciphertext(const ColorCiphertextView& ciphertext) const {
+    if (check_ciphertext(ciphertext) == CLWEError::SUCCESS) {
+        return;
+    }
+    if (!matches_parameters(ciphertext.params)) {
+        throw std::invalid_argument("Ciphertext parameters do not match KEM instance parameters");
+    }
+    if (ciphertext.ciphertext_size != ciphertext_bytes_) {
+        throw std::invalid_argument("Invalid ciphertext data size: expected " + std::to_string(ciphertext_bytes_) + " bytes, got " + std::to_string(ciphertext.ciphertext_size));
+    }
+    if (ciphertext.ciphertext_data == nullptr) {
+        throw std::invalid_argument("Ciphertext view is not bound to any data");
+    }
+    throw std::invalid_argument("Invalid shared secret hint size: expected 4 bytes");
+}
+
+
+void ColorKEM::validate_private_key(const CLWEParameters& params, const std::vector<uint8_t>& secret_data) const {
+    if (check_private_key(params, secret_data) == CLWEError::SUCCESS) {
+        return;
+    }
+    if (!matches_parameters(params)) {
+        throw std::invalid_argument("Private key parameters do not match KEM instance parameters");
+    }
+    if (secret_data.size() != polyvec_bytes_) {
+        throw std::invalid_argument("Invalid private key data size: expected " + std::to_string(polyvec_bytes_) + " bytes, got " + std::to_string(secret_data.size()));
+    }
+}
+
+
+std::shared_ptr<const ExpandedPublicKey> ColorKEM::cached_expanded_key(const ColorPublicKey& public_key) const {
+    validate_public_key(public_key);
+
+    std::lock_guard<std::mutex> lock(expanded_key_cache_mutex_);
+
+    for (auto it = expanded_key_cache_.begin(); it != expanded_key_cache_.end(); ++it) {
+        const ExpandedPublicKey& entry = **it;
+        if (entry.seed == public_key.seed && entry.public_data == public_key.public_data) {
+            // Move to the front so the least recently used entry sits at the back
+            expanded_key_cache_.splice(expanded_key_cache_.begin(), expanded_key_cache_, it);
+            add_metric_counter(MetricCounter::EXPANDED_KEY_CACHE_HITS, params_.security_level, 1);
+            return expanded_key_cache_.front();
+        }
+    }
+    add_metric_counter(MetricCounter::EXPANDED_KEY_CACHE_MISSES, params_.security_level, 1);
+
+    auto expanded = std::make_shared<const ExpandedPublicKey>(expand_public_key(public_key));
+    if (expanded_key_cache_capacity_ > 0) {
+        expanded_key_cache_.push_front(expanded);
+        while (expanded_key_cache_.size() > expanded_key_cache_capacity_) {
+            expanded_key_cache_.pop_back();
+        }
+    }
+    return expanded;
+}
+
+
+void ColorKEM::set_expanded_key_cache_capacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(expanded_key_cache_mutex_);
+    expanded_key_cache_capacity_ = capacity;
+    while (expanded_key_cache_.size() > expanded_key_cache_capacity_) {
+        expanded_key_cache_.pop_back();
+    }
+}
+
+
+size_t ColorKEM::expanded_key_cache_size() const {
+    std::lock_guard<std::mutex> lock(expanded_key_cache_mutex_);
+    return expanded_key_cache_.size();
+}
+
+
+void ColorKEM::set_matrix_streaming(bool enabled) {
+    // A shared matrix is never expanded, so there is nothing to stream
+    matrix_streaming_ = enabled && !shared_matrix_;
+}
+
+
+void ColorKEM::set_random_source(std::shared_ptr<RandomSource> source) {
+    random_source_ = source ? std::move(source) : default_random_source();
+}
+
+
+void ColorKEM::random_bytes(uint8_t* out, size_t len) const {
+    count_work(WorkCounter::RNG_BYTES, len);
+    random_source_->generate(out, len);
+}
+
+
+void ColorKEM::set_batch_device(BatchDevice device, const GpuBatchConfig& config) {
+    if (!batch_device_available(device)) {
+        throw std::invalid_argument(std::string("Batch device not available: ") + batch_device_name(device));
+    }
+    if (config.instances_per_launch == 0 || config.streams == 0) {
+        throw std::invalid_argument("GPU batch config needs a nonzero launch size and stream count");
+    }
+    batch_device_ = device;
+    batch_config_ = config;
+}
+
+
+void ColorKEM::set_executor(KemExecutor executor, uint32_t min_rank) {
+    executor_ = std::move(executor);
+    parallel_min_rank_ = min_rank;
+}
+
+
+SIMDSupport ColorKEM::backend() const {
+    return color_ntt_engine_->get_simd_support();
+}
+
+
+ColorValue ColorKEM::encapsulate_expanded(const PolyMatrix* matrix_A_trans,
+                                          const std::array<uint8_t, 32>* matrix_seed,
+                                          const PolyVec& public_key_colors,
+                                          const std::array<uint8_t, 32>& r_seed,
+                                          const std::array<uint8_t, 32>& e1_seed,
+                                          const std::array<uint8_t, 32>& e2_seed,
+                                          const ColorValue& shared_secret,
+                                          ColorCiphertext& ciphertext,
+                                          KemWorkspace::Buffers& workspace) const {
+    CLWE_TRACE_SPAN("encapsulate");
+    CLWE_PROBE_SCOPE(encapsulate);
+    MetricsTimer metrics_timer(MetricOperation::ENCAPSULATE, params_.security_level);
+    SlowOperationTimer slow_timer(MetricOperation::ENCAPSULATE, params_.security_level, *color_ntt_engine_);
+    encrypt_message_into(matrix_A_trans, matrix_seed, public_key_colors, shared_secret, r_seed, e1_seed, e2_seed, workspace);
+
+    pack_ciphertext(workspace.ciphertext_colors, shared_secret, ciphertext);
+    return shared_secret;
+}
+
+
+ColorValue ColorKEM::encapsulate_expanded_streamed(const PolyMatrix* matrix_A_trans,
+                                                   const std::array<uint8_t, 32>* matrix_seed,
+                                                   const PolyVec& public_key_colors,
+                                                   const std::array<uint8_t, 32>& r_seed,
+                                                   const std::array<uint8_t, 32>& e1_seed,
+                                                   const std::array<uint8_t, 32>& e2_seed,
+                                                   const ColorValue& shared_secret,
+                                                   const CiphertextSink& sink,
+                                                   KemWorkspace::Buffers& workspace) const {
+    CLWE_TRACE_SPAN("encapsulate");
+    CLWE_PROBE_SCOPE(encapsulate);
+    MetricsTimer metrics_timer(MetricOperation::ENCAPSULATE, params_.security_level);
+    SlowOperationTimer slow_timer(MetricOperation::ENCAPSULATE, params_.security_level, *color_ntt_engine_);
+    const uint32_t k = params_.module_rank;
+    const uint32_t n = params_.degree;
+    if (matrix_A_trans != nullptr && matrix_A_trans->rank() != k) {
+        throw std::invalid_argument("Invalid matrix_A_trans rank: expected " + std::to_string(k) + ", got " + std::to_string(matrix_A_trans->rank()));
+    }
+    if (public_key_colors.rank() != k) {
+        throw std::invalid_argument("Invalid public_key size: expected " + std::to_string(k) + ", got " + std::to_string(public_key_colors.rank()));
+    }
+
+    // Each c1 polynomial is emitted on its own, so it has to fill whole bytes of c1
+    const bool is_compressed = compressed(params_);
+    const size_t poly_bytes = is_compressed ? compressed_coefficients_size(n, params_.du)
+                                            : encoded_coefficients_size(n, params_.encoding);
+    const size_t c1_bytes = is_compressed ? compressed_coefficients_size(static_cast<size_t>(k) * n, params_.du)
+                                          : encoded_coefficients_size(static_cast<size_t>(k) * n, params_.encoding);
+    if (poly_bytes * k != c1_bytes) {
+        throw std::invalid_argument("Streamed encapsulation needs c1 polynomials that end on a byte boundary");
+    }
+
+    sample_encryption_noise(r_seed, e1_seed, &e2_seed, workspace);
+
+    // c1_hat is idle during encapsulation and holds the largest encoded polynomial
+    uint8_t* staging = reinterpret_cast<uint8_t*>(workspace.c1_hat.data());
+    PolyVec& A_trans_r = workspace.A_trans_r;
+    PolyVec& ciphertext_colors = workspace.ciphertext_colors;
+    for (uint32_t i = 0; i < k; ++i) {
+        // Row i of A^T r, then c1_i = its inverse transform + e1_i, encoded and handed out
+        const ColorValue* a_row = matrix_A_trans != nullptr ? matrix_A_trans->at(i, 0) : nullptr;
+        if (a_row == nullptr) {
+            expand_matrix_line(*matrix_seed, i, true, workspace.matrix_line);
+            a_row = workspace.matrix_line.data();
+        }
+        color_ntt_engine_->row_dot_colors(a_row, n, workspace.r.data(), k, A_trans_r[i]);
+        ntt_inverse_poly(A_trans_r[i]);
+        poly_add(A_trans_r[i], workspace.e1[i], ciphertext_colors[i], n, params_.modulus);
+        if (is_compressed) {
+            compress_encode_coefficients(ciphertext_colors[i], n, params_.du, params_.modulus, staging);
+        } else {
+            encode_coefficients(ciphertext_colors[i], n, params_.encoding, staging);
+        }
+        sink(staging, poly_bytes);
+    }
+
+    encrypt_c2_into(public_key_colors, workspace);
+    add_message(shared_secret, ciphertext_colors);
+    const size_t c2_count = c2_size(params_);
+    const ColorValue* c2 = ciphertext_colors[k];
+    if (is_compressed) {
+        compress_encode_coefficients(c2, c2_count, params_.dv, params_.modulus, staging);
+        sink(staging, compressed_coefficients_size(c2_count, params_.dv));
+    } else {
+        encode_coefficients(c2, c2_count, params_.encoding, staging);
+        sink(staging, encoded_coefficients_size(c2_count, params_.encoding));
+    }
+
+    uint32_t hint = shared_secret.to_math_value();
+    std::array<uint8_t, 4> hint_bytes = {static_cast<uint8_t>((hint >> 24) & 0xFF),
+                                         static_cast<uint8_t>((hint >> 16) & 0xFF),
+                                         static_cast<uint8_t>((hint >> 8) & 0xFF),
+                                         static_cast<uint8_t>(hint & 0xFF)};
+    sink(hint_bytes.data(), hint_bytes.size());
+    return shared_secret;
+}
+
+
+void ColorKEM::pack_ciphertext(const PolyVec& ciphertext_colors, const ColorValue& shared_secret,
+                               ColorCiphertext& ciphertext) const {
+    // Reused ciphertexts keep their capacity, so resizing to the same length never allocates
+    CLWE_TRACE_SPAN("pack_ciphertext");
+    SlowStageTimer slow_stage(SlowStage::PACK);
+    ciphertext.ciphertext_data.resize(ciphertext_bytes_);
+    encode_ciphertext(ciphertext_colors, ciphertext.ciphertext_data.data());
+
+    uint32_t hint = shared_secret.to_math_value();
+    ciphertext.shared_secret_hint.resize(4);
+    ciphertext.shared_secret_hint[0] = static_cast<uint8_t>((hint >> 24) & 0xFF);
+    ciphertext.shared_secret_hint[1] = static_cast<uint8_t>((hint >> 16) & 0xFF);
+    ciphertext.shared_secret_hint[2] = static_cast<uint8_t>((hint >> 8) & 0xFF);
+    ciphertext.shared_secret_hint[3] = static_cast<uint8_t>(hint & 0xFF);
+    ciphertext.params = params_;
+}
+
+
+ColorValue ColorKEM::decapsulate(const ColorPublicKey& public_key,
+                                const ColorPrivateKey& private_key,
+                                const ColorCiphertext& ciphertext) const {
+    return decapsulate(public_key, private_key, ciphertext, thread_workspace());
+}
+
+
+ColorValue ColorKEM::decapsulate(const ColorPublicKey& public_key,
+                                const ColorPrivateKey& private_key,
+                                const ColorCiphertext& ciphertext,
+                                KemWorkspace& workspace) const {
+
+    // One branch on the success path; the failing object is only identified when throwing
+    const bool public_ok = matches_parameters(public_key.params);
+    const bool private_ok = matches_parameters(private_key.params);
+    const bool ciphertext_ok = matches_parameters(ciphertext.params);
+    if (!(public_ok & private_ok & ciphertext_ok & (private_key.secret_data.size() == polyvec_bytes_))) {
+        if (!public_ok) {
+            throw std::invalid_argument("Public key parameters do not match KEM instance parameters");
+        }
+        if (!private_ok) {
+            throw std::invalid_argument("Private key parameters do not match KEM instance parameters");
+        }
+        if (!ciphertext_ok) {
+            throw std::invalid_argument("Ciphertext parameters do not match KEM instance parameters");
+        }
+        throw std::invalid_argument("Invalid private key data size: expected " + std::to_string(polyvec_bytes_) + " bytes, got " + std::to_string(private_key.secret_data.size()));
+    }
+
+    WorkspaceScope scope(workspace_buffers(workspace), params_);
+    KemWorkspace::Buffers& buffers = scope.buffers();
+    {
+        CLWE_TRACE_SPAN("unpack_private_key");
+        SlowStageTimer slow_stage(SlowStage::UNPACK);
+        decode_polyvec(private_key.secret_data.data(), buffers.secret, params_.encoding);
+    }
+
+    return decapsulate_expanded(buffers.secret, ciphertext, buffers);
+}
+
+
+ColorExpandedPrivateKey ColorKEM::expand_private_key(const ColorPublicKey& public_key,
+                                                     const ColorPrivateKey& private_key) const {
+    validate_public_key(public_key);
+    validate_private_key(private_key.params, private_key.secret_data);
+
+    ColorExpandedPrivateKey expanded;
+    expanded.secret_data = private_key.secret_data;
+    expanded.public_key = public_key;
+    expanded.public_key_hash = public_key.fingerprint();
+    expanded.params = private_key.params;
+    return expanded;
+}
+
+
+ColorValue ColorKEM::decapsulate(const ColorExpandedPrivateKey& private_key,
+                                 const ColorCiphertext& ciphertext) const {
+    return decapsulate(private_key, ciphertext, thread_workspace());
+}
+
+
+ColorValue ColorKEM::decapsulate(const ColorExpandedPrivateKey& private_key,
+                                 const ColorCiphertext& ciphertext,
+                                 KemWorkspace& workspace) const {
+    // Decryption needs only s_hat; the embedded public key is not touched
+    const bool private_ok = matches_parameters(private_key.params);
+    const bool ciphertext_ok = matches_parameters(ciphertext.params);
+    if (!(private_ok & ciphertext_ok & (private_key.secret_data.size() == polyvec_bytes_))) {
+        if (!ciphertext_ok) {
+            throw std::invalid_argument("Ciphertext parameters do not match KEM instance parameters");
+        }
+        validate_private_key(private_key.params, private_key.secret_data);
+    }
+
+    WorkspaceScope scope(workspace_buffers(workspace), params_);
+    KemWorkspace::Buffers& buffers = scope.buffers();
+    {
+        CLWE_TRACE_SPAN("unpack_private_key");
+        SlowStageTimer slow_stage(SlowStage::UNPACK);
+        decode_polyvec(private_key.secret_data.data(), buffers.secret, params_.encoding);
+    }
+
+    return decapsulate_expanded(buffers.secret, ciphertext, buffers);
+}
+
+
+ColorValue ColorKEM::decapsulate_expanded(const PolyVec& secret_key_colors, const ColorCiphertext& ciphertext,
+                                          KemWorkspace::Buffers& workspace,
+                                          const SparseTernaryVec* sparse_secret) const {
+    // Validate shared secret hint size
+    if (ciphertext.shared_secret_hint.size() != 4) {
+        throw std::invalid_argument("Invalid shared secret hint size: expected 4 bytes, got " + std::to_string(ciphertext.shared_secret_hint.size()));
+    }
+
+    return decapsulate_expanded(secret_key_colors, ColorCiphertextView(ciphertext), workspace, sparse_secret);
+}
+
+
+ColorValue ColorKEM::decapsulate_expanded(const PolyVec& secret_key_colors, const ColorCiphertextView& ciphertext,
+                                          KemWorkspace::Buffers& workspace,
+                                          const SparseTernaryVec* sparse_secret) const {
+    CLWE_TRACE_SPAN("decapsulate");
+    CLWE_PROBE_SCOPE(decapsulate);
+    MetricsTimer metrics_timer(MetricOperation::DECAPSULATE, params_.security_level);
+    SlowOperationTimer slow_timer(MetricOperation::DECAPSULATE, params_.security_level, *color_ntt_engine_);
+
+    // Validate ciphertext data size
+    if (ciphertext.ciphertext_size != ciphertext_bytes_) {
+        throw std::invalid_argument("Invalid ciphertext data size: expected " + std::to_string(ciphertext_bytes_) + " bytes, got " + std::to_string(ciphertext.ciphertext_size));
+    }
+
+    if (ciphertext.ciphertext_data == nullptr || ciphertext.shared_secret_hint == nullptr) {
+        throw std::invalid_argument("Ciphertext view is not bound to any data");
+    }
+
+    // Parse and decrypt in the workspace buffers; nothing is allocated. A ciphertext with
+    // an unreduced coefficient is rejected implicitly, by mask, like any other invalid one.
+    bool reduced;
+    {
+        CLWE_TRACE_SPAN("unpack_ciphertext");
+        SlowStageTimer slow_stage(SlowStage::UNPACK);
+        reduced = decode_ciphertext(ciphertext.ciphertext_data, workspace.ciphertext_colors);
+    }
+    // std::cout << "DEBUG DECAP: Ciphertext colors (" << ciphertext_colors.size() << " elements):" << std::endl;
+    // for (size_t i = 0; i < ciphertext_colors.size(); ++i) {
+    //     std::cout << "  c[" << i << "] = " << ciphertext_colors[i].to_math_value() << std::endl;
+    // }
+
+    bool padding_valid = false;
+    ColorValue recovered_secret;
+    if (sparse_secret != nullptr) {
+        // s^T c1 straight from the coefficient-domain c1; decryption leaves e2 and
+        // inner_product free for the rotations
+        CLWE_TRACE_SPAN("decrypt_sparse");
+        SlowStageTimer slow_stage(SlowStage::DECRYPT);
+        const ColorValue* c1 = workspace.ciphertext_colors.data();
+        if (params_.sparse_c2) {
+            workspace.s_dot_c1[0] = ColorValue::from_math_value(
+                sparse_ternary_dot_constant(*sparse_secret, c1, params_.modulus));
+        } else {
+            sparse_ternary_dot(*sparse_secret, c1, params_.modulus,
+                               reinterpret_cast<uint32_t*>(workspace.e2.data()),
+                               reinterpret_cast<uint32_t*>(workspace.inner_product.data()), workspace.s_dot_c1.data());
+        }
+        recovered_secret = decode_message(workspace.ciphertext_colors[params_.module_rank], workspace.s_dot_c1.data(),
+                                          padding_valid);
+    } else {
+        recovered_secret = decrypt_message_into(secret_key_colors, workspace.ciphertext_colors,
+                                                workspace.c1_hat, workspace.s_dot_c1, padding_valid);
+    }
+    padding_valid &= reduced;
+    // std::cout << "DEBUG DECAP: Recovered secret = " << recovered_secret.to_precise_value() << std::endl;
+
+    // Fujisaki-Okamoto transform for IND-CCA2 security
+    return select_decapsulated_secret(recovered_secret, padding_valid, ciphertext.shared_secret_hint,
+                                      hash_ciphertext(ciphertext));
+}
+
+
+ColorValue ColorKEM::select_decapsulated_secret(const ColorValue& recovered_secret, bool padding_valid,
+                                                const uint8_t* hint, const ColorValue& rejection) const {
+    CLWE_PROBE(implicit_rejection_entry);
+    ColorValue hinted_secret = ColorValue::from_math_value((static_cast<uint32_t>(hint[0]) << 24) |
+                                                           (static_cast<uint32_t>(hint[1]) << 16) |
+                                                           (static_cast<uint32_t>(hint[2]) << 8) |
+                                                           static_cast<uint32_t>(hint[3]));
+    // Both outcomes are always computed and one is selected by mask, so valid and
+    // rejected ciphertexts take the same path and time
+    uint32_t mismatch = (recovered_secret.to_math_value() ^ hinted_secret.to_math_value()) |
+                        static_cast<uint32_t>(!padding_valid);
+    uint32_t accept = ct_zero_mask(mismatch);
+    add_metric_counter(MetricCounter::IMPLICIT_REJECTIONS, params_.security_level, ~accept & 1);
+    // The outcome goes to the probe as a value, with no branch on it
+    CLWE_PROBE1(implicit_rejection_return, ~accept & 1);
+    return ColorValue::from_math_value((recovered_secret.to_math_value() & accept) |
+                                       (rejection.to_math_value() & ~accept));
+}
+
+
+SharedSecret ColorKEM::decapsulate_key(const ColorPublicKey& public_key,
+                                       const ColorPrivateKey& private_key,
+                                       const ColorCiphertext& ciphertext) const {
+    return decapsulate_key(public_key, private_key, ciphertext, thread_workspace());
+}
+
+
+SharedSecret ColorKEM::decapsulate_key(const ColorPublicKey& public_key,
+                                       const ColorPrivateKey& private_key,
+                                       const ColorCiphertext& ciphertext,
+                                       KemWorkspace& workspace) const {
+    validate_key_message_mode();
+    validate_public_key(public_key);
+    validate_private_key(private_key.params, private_key.secret_data);
+    return decapsulate_key_validated(public_key, private_key.secret_data, ColorCiphertextView(ciphertext), workspace);
+}
+
+
+SharedSecret ColorKEM::decapsulate_key(const ColorExpandedPrivateKey& private_key,
+                                       const ColorCiphertext& ciphertext) const {
+    return decapsulate_key(private_key, ciphertext, thread_workspace());
+}
+
+
+SharedSecret ColorKEM::decapsulate_key(const ColorExpandedPrivateKey& private_key,
+                                       const ColorCiphertext& ciphertext,
+                                       KemWorkspace& workspace) const {
+    validate_key_message_mode();
+    validate_private_key(private_key.params, private_key.secret_data);
+    validate_public_key(private_key.public_key);
+    return decapsulate_key_validated(private_key.public_key, private_key.secret_data, ColorCiphertextView(ciphertext),
+                                     workspace);
+}
+
+
+SharedSecret ColorKEM::decapsulate_key(const ColorExpandedPrivateKey& private_key,
+                                       const ColorCiphertextView& ciphertext,
+                                       KemWorkspace& workspace) const {
+    validate_key_message_mode();
+    validate_private_key(private_key.params, private_key.secret_data);
+    validate_public_key(private_key.public_key);
+    return decapsulate_key_validated(private_key.public_key, private_key.secret_data, ciphertext, workspace);
+}
+
+
+CLWEError ColorKEM::try_decapsulate_key(const ColorExpandedPrivateKey& private_key,
+                                        const ColorCiphertextView& ciphertext,
+                                        SharedSecret& shared_key) const noexcept {
+    try {
+        return try_decapsulate_key(private_key, ciphertext, shared_key, thread_workspace());
+    } catch (...) {
+        shared_key = SharedSecret();
+        return current_exception_error();
+    }
+}
+
+
+CLWEError ColorKEM::try_decapsulate_key(const ColorExpandedPrivateKey& private_key,
+                                        const ColorCiphertextView& ciphertext,
+                                        SharedSecret& shared_key,
+                                        KemWorkspace& workspace) const noexcept {
+    shared_key = SharedSecret();
+    CLWEError error = check_key_message_mode();
+    if (error == CLWEError::SUCCESS) {
+        error = check_private_key(private_key.params, private_key.secret_data);
+    }
+    if (error == CLWEError::SUCCESS) {
+        error = check_public_key(private_key.public_key);
+    }
+    if (error == CLWEError::SUCCESS) {
+        error = check_ciphertext(ciphertext);
+    }
+    if (error != CLWEError::SUCCESS) {
+        return error;
+    }
+    try {
+        shared_key = decapsulate_key_validated(private_key.public_key, private_key.secret_data, ciphertext, workspace);
+        return CLWEError::SUCCESS;
+    } catch (...) {
+        shared_key = SharedSecret();
+        return current_exception_error();
+    }
+}
+
+
+SharedSecret ColorKEM::decapsulate_key_validated(const ColorPublicKey& public_key,
+                                                 const std::vector<uint8_t>& secret_data,
+                                                 const ColorCiphertextView& ciphertext,
+                                                 KemWorkspace& workspace) const {
+    MetricsTimer metrics_timer(MetricOperation::DECAPSULATE, params_.security_level);
+    SlowOperationTimer slow_timer(MetricOperation::DECAPSULATE, params_.security_level, *color_ntt_engine_);
+    validate_ciphertext(ciphertext);
+
+    // Re-encryption needs A and t_hat as well as s_hat
+    std::shared_ptr<const ExpandedPublicKey> expanded;
+    if (!matrix_streaming_) {
+        expanded = cached_expanded_key(public_key);
+    }
+    WorkspaceScope scope(workspace_buffers(workspace), params_);
+    KemWorkspace::Buffers& buffers = scope.buffers();
+    {
+        CLWE_TRACE_SPAN("unpack_private_key");
+        SlowStageTimer slow_stage(SlowStage::UNPACK);
+        decode_polyvec(secret_data.data(), buffers.secret, params_.encoding);
+    }
+    bool reduced;
+    {
+        CLWE_TRACE_SPAN("unpack_ciphertext");
+        SlowStageTimer slow_stage(SlowStage::UNPACK);
+        reduced = decode_ciphertext(ciphertext.ciphertext_data, buffers.ciphertext_colors);
+    }
+
+    std::array<uint8_t, 32> message;
+    decrypt_key_message_into(buffers.secret, buffers.ciphertext_colors, buffers.c1_hat, buffers.s_dot_c1, message);
+
+    // Fujisaki-Okamoto: re-encrypt the recovered message and accept only an identical ciphertext
+    SharedSecret shared_key;
+    ColorCiphertext& reencrypted = thread_key_reencryption();
+    if (expanded) {
+        shared_key = encapsulate_key_expanded(expanded->matrix_A.get(), nullptr, *expanded->public_key_colors,
+                                              message, reencrypted, buffers);
+    } else {
+        decode_public_key_data(public_key.public_data.data(), buffers.public_key, params_.encoding);
+        shared_key = encapsulate_key_expanded(nullptr, &public_key.seed, buffers.public_key,
+                                              message, reencrypted, buffers);
+    }
+    secure_zero(message.data(), message.size());
+
+    uint32_t difference = 0;
+    for (size_t i = 0; i < ciphertext_bytes_; ++i) {
+        difference |= static_cast<uint32_t>(ciphertext.ciphertext_data[i] ^ reencrypted.ciphertext_data[i]);
+    }
+    for (size_t i = 0; i < 4; ++i) {
+        difference |= ciphertext.shared_secret_hint[i];
+    }
+    // Re-encryption never yields an unreduced coefficient; rejecting one is explicit all the same
+    difference |= static_cast<uint32_t>(!reduced);
+    uint8_t accept = static_cast<uint8_t>(ct_zero_mask(difference));
+    add_metric_counter(MetricCounter::IMPLICIT_REJECTIONS, params_.security_level, ~accept & 1u);
+
+    // Implicit rejection: a key derived from the private key and the ciphertext, always
+    // computed so the selection below takes the same time either way
+    SharedSecret rejection_key;
+    SHAKE256Sampler& shake = thread_shake256();
+    const uint8_t prefix[2] = {KEY_REJECTION_DOMAIN, static_cast<uint8_t>(params_.module_rank)};
+    shake.begin();
+    shake.absorb(prefix, sizeof(prefix));
+    shake.absorb(secret_data.data(), secret_data.size());
+    shake.absorb(ciphertext.ciphertext_data, ciphertext.ciphertext_size);
+    shake.absorb(ciphertext.shared_secret_hint, 4);
+    shake.finalize();
+    shake.squeeze(rejection_key.data(), rejection_key.size());
+
+    for (size_t i = 0; i < shared_key.size(); ++i) {
+        shared_key.bytes[i] = static_cast<uint8_t>((shared_key.bytes[i] & accept) | (rejection_key.bytes[i] & ~accept));
+    }
+    secure_zero(rejection_key.data(), rejection_key.size());
+    return shared_key;
+}
+
+
+PreparedPrivateKey ColorKEM::prepare_private_key(const ColorPrivateKey& private_key) const {
+    if (!matches_parameters(private_key.params)) {
+        throw std::invalid_argument("Private key parameters do not match KEM instance parameters");
+    }
+
+    if (private_key.secret_data.size() != polyvec_bytes_) {
+        throw std::invalid_argument("Invalid private key data size: expected " + std::to_string(polyvec_bytes_) + " bytes, got " + std::to_string(private_key.secret_data.size()));
+    }
+
+    PreparedPrivateKey prepared;
+    prepared.params = private_key.params;
+    prepared.secret_key_colors = std::make_shared<const PolyVec>(
+        bytes_to_polyvec(private_key.secret_data, params_.module_rank, params_.degree, params_.encoding));
+    attach_sparse_secret(prepared);
+    return prepared;
+}
+
+
+void ColorKEM::attach_sparse_secret(PreparedPrivateKey& prepared) const {
+    if (params_.secret_weight == 0) {
+        return;
+    }
+    // Keys whose s is not fixed-weight ternary (made under other noise settings) keep the NTT path
+    PolyVec s = *prepared.secret_key_colors;
+    polyvec_invntt(*color_ntt_engine_, s, degree_inv_);
+    auto sparse = std::make_shared<SparseTernaryVec>(params_.module_rank, params_.degree, params_.secret_weight);
+    if (sparse->assign(s.data(), params_.modulus)) {
+        prepared.sparse_secret = std::move(sparse);
+    }
+    secure_zero(s.data(), s.coeff_count() * sizeof(ColorValue));
+}
+
+
+std::pair<ColorPublicKey, ColorCompactPrivateKey> ColorKEM::keygen_compact() const {
+    std::pair<ColorPublicKey, ColorCompactPrivateKey> keys;
+    random_bytes(keys.second.seed.data(), keys.second.seed.size());
+    keys.second.params = params_;
+    std::pair<ColorPublicKey, ColorPrivateKey> full = keygen_derand(keys.second.seed);
+    secure_zero(full.second.secret_data.data(), full.second.secret_data.size());
+    keys.first = std::move(full.first);
+    return keys;
+}
+
+
+void ColorKEM::regenerate_secret(const std::array<uint8_t, 32>& d, PolyVec& secret,
+                                 KemWorkspace::Buffers& workspace) const {
+    CLWE_TRACE_SPAN("regenerate_secret");
+    std::array<uint8_t, 32> matrix_seed, secret_seed, error_seed;
+    expand_keygen_seed(d, matrix_seed, secret_seed, error_seed);
+
+    // The secret half of keygen_expanded()'s noise pass; e is not needed
+    workspace.noise_requests.clear();
+    for (uint32_t i = 0; i < params_.module_rank; ++i) {
+        if (params_.secret_weight != 0) {
+            sample_ternary_secret(params_, secret_seed, static_cast<uint8_t>(i), workspace.noise, secret[i],
+                                  *color_ntt_engine_);
+        } else {
+            workspace.noise_requests.push_back({&secret_seed, static_cast<uint8_t>(i), true, secret[i]});
+        }
+    }
+    if (workspace.noise_requests.count != 0) {
+        sample_noise_batch(params_, params_.eta1, workspace.noise_requests.requests, workspace.noise_requests.count,
+                           workspace.noise, *color_ntt_engine_);
+    }
+    secure_zero(matrix_seed.data(), matrix_seed.size());
+    secure_zero(secret_seed.data(), secret_seed.size());
+    secure_zero(error_seed.data(), error_seed.size());
+}
+
+
+ColorPrivateKey ColorKEM::expand_compact_private_key(const ColorCompactPrivateKey& private_key) const {
+    if (!matches_parameters(private_key.params)) {
+        throw std::invalid_argument("Private key parameters do not match KEM instance parameters");
+    }
+    WorkspaceScope scope(workspace_buffers(thread_workspace()), params_);
+    KemWorkspace::Buffers& buffers = scope.buffers();
+    regenerate_secret(private_key.seed, buffers.secret, buffers);
+
+    ColorPrivateKey expanded;
+    expanded.params = params_;
+    encode_polyvec(buffers.secret, params_.encoding, expanded.secret_data);
+    return expanded;
+}
+
+
+PreparedPrivateKey ColorKEM::prepare_private_key(const ColorCompactPrivateKey& private_key) const {
+    if (!matches_parameters(private_key.params)) {
+        throw std::invalid_argument("Private key parameters do not match KEM instance parameters");
+    }
+    auto secret = std::make_shared<PolyVec>(params_.module_rank, params_.degree);
+    {
+        WorkspaceScope scope(workspace_buffers(thread_workspace()), params_);
+        regenerate_secret(private_key.seed, *secret, scope.buffers());
+    }
+
+    PreparedPrivateKey prepared;
+    prepared.params = params_;
+    prepared.secret_key_colors = std::move(secret);
+    attach_sparse_secret(prepared);
+    return prepared;
+}
+
+
+ColorValue ColorKEM::decapsulate(const PreparedPrivateKey& private_key, const ColorCiphertext& ciphertext) const {
+    return decapsulate(private_key, ciphertext, thread_workspace());
+}
+
+
+ColorValue ColorKEM::decapsulate(const PreparedPrivateKey& private_key, const ColorCiphertext& ciphertext,
+                                KemWorkspace& workspace) const {
+    if (!matches_parameters(private_key.params) || !private_key.secret_key_colors) {
+        throw std::invalid_argument("Prepared private key does not belong to this KEM instance");
+    }
+
+    if (!matches_parameters(ciphertext.params)) {
+        throw std::invalid_argument("Ciphertext parameters do not match KEM instance parameters");
+    }
+
+    WorkspaceScope scope(workspace_buffers(workspace), params_);
+    return decapsulate_expanded(*private_key.secret_key_colors, ciphertext, scope.buffers(),
+                                private_key.sparse_secret.get());
+}
+
+
+ColorValue ColorKEM::decapsulate(const PreparedPrivateKey& private_key, const ColorCiphertextView& ciphertext) const {
+    return decapsulate(private_key, ciphertext, thread_workspace());
+}
+
+
+ColorValue ColorKEM::decapsulate(const PreparedPrivateKey& private_key, const ColorCiphertextView& ciphertext,
+                                KemWorkspace& workspace) const {
+    if (!matches_parameters(private_key.params) || !private_key.secret_key_colors) {
+        throw std::invalid_argument("Prepared private key does not belong to this KEM instance");
+    }
+
+    if (!matches_parameters(ciphertext.params)) {
+        throw std::invalid_argument("Ciphertext parameters do not match KEM instance parameters");
+    }
+
+    WorkspaceScope scope(workspace_buffers(workspace), params_);
+    return decapsulate_expanded(*private_key.secret_key_colors, ciphertext, scope.buffers(),
+                                private_key.sparse_secret.get());
+}
+
+
+std::vector<std::pair<ColorPublicKey, ColorPrivateKey>> ColorKEM::keygen_batch(size_t count) const {
+    // One entropy draw for the whole batch: a keygen_derand seed per key
+    std::vector<uint8_t> seeds(count * 32);
+    if (!seeds.empty()) {
+        random_bytes(seeds.data(), seeds.size());
+    }
+    std::vector<std::pair<ColorPublicKey, ColorPrivateKey>> keys = keygen_batch_derand(seeds, count);
+    secure_zero(seeds.data(), seeds.size());
+    return keys;
+}
+
+
+std::vector<std::pair<ColorPublicKey, ColorPrivateKey>> ColorKEM::keygen_batch_derand(
+    const std::vector<uint8_t>& seeds, size_t count) const {
+    // The batch kernels sample binomial secrets only
+    if (batch_device_ != BatchDevice::Cpu && batch_kernels_support(params_) && params_.secret_weight == 0) {
+        return keygen_batch_offloaded(seeds, count);
+    }
+
+    std::vector<std::pair<ColorPublicKey, ColorPrivateKey>> keys;
+    keys.reserve(count);
+    KemWorkspace& workspace = thread_workspace();
+    for (size_t i = 0; i < count; ++i) {
+        std::array<uint8_t, 32> d;
+        std::copy(seeds.begin() + i * 32, seeds.begin() + (i + 1) * 32, d.begin());
+        keys.push_back(keygen_derand(d, workspace));
+        secure_zero(d.data(), d.size());
+    }
+    return keys;
+}
+
+std::array<uint8_t, 32> ColorKEM::derive_device_seed(const std::array<uint8_t, 32>& master_seed,
+                                                     uint64_t device_id) const {
+    uint8_t input[DEVICE_INPUT_BYTES];
+    device_seed_input(params_fingerprint_, master_seed, device_id, input);
+    SHAKE256Sampler& shake = thread_shake256();
+    std::array<uint8_t, 32> d;
+    shake.begin();
+    shake.absorb(input, sizeof(input));
+    shake.finalize();
+    shake.squeeze(d.data(), d.size());
+    secure_zero(input, sizeof(input));
+    return d;
+}
+
+std::pair<ColorPublicKey, ColorPrivateKey> ColorKEM::derive_keypair(const std::array<uint8_t, 32>& master_seed,
+                                                                    uint64_t device_id) const {
+    std::array<uint8_t, 32> d = derive_device_seed(master_seed, device_id);
+    std::pair<ColorPublicKey, ColorPrivateKey> keys = keygen_derand(d);
+    secure_zero(d.data(), d.size());
+    return keys;
+}
+
+std::vector<std::pair<ColorPublicKey, ColorPrivateKey>> ColorKEM::derive_keypair_batch(
+    const std::array<uint8_t, 32>& master_seed, uint64_t first_device_id, size_t count) const {
+    if (count > 0 && first_device_id + (count - 1) < first_device_id) {
+        throw std::invalid_argument("Device id range overflows 64 bits");
+    }
+
+    // The device seeds are independent single-block SHAKE-256 calls, run four per
+    // permutation on the multi-lane Keccak; a short tail goes through the scalar sponge
+    std::vector<uint8_t> seeds(count * 32);
+    size_t i = 0;
+    if (count >= 4) {
+        uint8_t inputs[4][DEVICE_INPUT_BYTES];
+        uint8_t blocks[4][SHAKE256_RATE];
+        const uint8_t* const in[4] = {inputs[0], inputs[1], inputs[2], inputs[3]};
+        uint8_t* const out[4] = {blocks[0], blocks[1], blocks[2], blocks[3]};
+        SHAKE256x4Sampler shake;
+        for (; i + 4 <= count; i += 4) {
+            for (size_t lane = 0; lane < 4; ++lane) {
+                device_seed_input(params_fingerprint_, master_seed, first_device_id + i + lane, inputs[lane]);
+            }
+            shake.init_x4(in, DEVICE_INPUT_BYTES);
+            shake.squeeze_blocks_x4(out, 1);
+            for (size_t lane = 0; lane < 4; ++lane) {
+                std::copy(blocks[lane], blocks[lane] + 32, seeds.begin() + (i + lane) * 32);
+            }
+        }
+        secure_zero(inputs, sizeof(inputs));
+        secure_zero(blocks, sizeof(blocks));
+    }
+    for (; i < count; ++i) {
+        std::array<uint8_t, 32> d = derive_device_seed(master_seed, first_device_id + i);
+        std::copy(d.begin(), d.end(), seeds.begin() + i * 32);
+        secure_zero(d.data(), d.size());
     }
 
-    uint8_t byte;
-    secure_random_bytes(&byte, 1);
-    ColorValue shared_secret = ColorValue::from_math_value(byte & 1);
-    // std::cout << "DEBUG ENCAP: Shared secret = " << shared_secret.to_precise_value() << std::endl;
+    std::vector<std::pair<ColorPublicKey, ColorPrivateKey>> keys = keygen_batch_derand(seeds, count);
+    secure_zero(seeds.data(), seeds.size());
+    return keys;
+}
 
-    auto matrix_A = generate_matrix_A(public_key.seed);
-    // std::cout << "DEBUG ENCAP: Regenerated matrix A from seed" << std::endl;
 
-    std::vector<std::vector<ColorValue>> public_key_colors(params_.module_rank, std::vector<ColorValue>(params_.degree));
-    size_t idx = 0;
-    for (size_t i = 0; i < params_.module_rank; ++i) {
-        for (size_t d = 0; d < params_.degree; ++d) {
-            std::vector<uint8_t> bytes(public_key.public_data.begin() + idx,
-                                      public_key.public_data.begin() + idx + 4);
-            public_key_colors[i][d] = bytes_to_color_secret(bytes);
-            idx += 4;
-        }
+std::vector<std::pair<ColorCiphertext, ColorValue>> ColorKEM::encapsulate_batch(const std::vector<ColorPublicKey>& public_keys) const {
+    // One entropy draw for the whole batch: an encapsulate_derand seed per request
+    std::vector<uint8_t> seeds(public_keys.size() * 32);
+    if (!seeds.empty()) {
+        random_bytes(seeds.data(), seeds.size());
+    }
+    if (batch_device_ != BatchDevice::Cpu && batch_kernels_support(params_)) {
+        return encapsulate_batch_offloaded(public_keys, seeds);
+    }
+    // On the CPU, a batch of at least BATCH_LANES requests to mostly different keys runs its
+    // lattice core lane-parallel; runs of one key keep the expanded-key cache below
+    size_t repeats = 0;
+    for (size_t i = 1; i < public_keys.size(); ++i) {
+        repeats += public_keys[i].seed == public_keys[i - 1].seed ? 1 : 0;
+    }
+    if (public_keys.size() >= BATCH_LANES && 2 * repeats < public_keys.size() && batch_kernels_support(params_)) {
+        return encapsulate_batch_offloaded(public_keys, seeds);
     }
-    // std::cout << "DEBUG ENCAP: Public key colors (" << public_key_colors.size() << " elements):" << std::endl;
-    // for (size_t i = 0; i < public_key_colors.size(); ++i) {
-    //     std::cout << "  t[" << i << "] = " << public_key_colors[i].to_math_value() << std::endl;
-    // }
 
-    auto ciphertext_colors = encrypt_message(matrix_A, public_key_colors, shared_secret);
-    // std::cout << "DEBUG ENCAP: Ciphertext colors (" << ciphertext_colors.size() << " elements):" << std::endl;
-    // for (size_t i = 0; i < ciphertext_colors.size(); ++i) {
-    //     std::cout << "  c[" << i << "] = " << ciphertext_colors[i].to_math_value() << std::endl;
-    // }
+    std::vector<std::pair<ColorCiphertext, ColorValue>> results;
+    results.reserve(public_keys.size());
 
-    
-    std::vector<uint8_t> ciphertext_data;
-    for (const auto& poly : ciphertext_colors) {
-        for (const auto& coeff : poly) {
-            auto bytes = color_secret_to_bytes(coeff);
-            ciphertext_data.insert(ciphertext_data.end(), bytes.begin(), bytes.end());
-        }
+    // Repeated keys hit the expanded-key cache inside encapsulate_derand
+    for (size_t i = 0; i < public_keys.size(); ++i) {
+        std::array<uint8_t, 32> m;
+        std::copy(seeds.begin() + i * 32, seeds.begin() + (i + 1) * 32, m.begin());
+        results.push_back(encapsulate_derand(public_keys[i], m));
     }
+    return results;
+}
 
-    
-    auto shared_secret_hint = encode_color_secret(shared_secret);
-
-    ColorCiphertext ciphertext{ciphertext_data, shared_secret_hint, params_};
 
-    return {ciphertext, shared_secret};
+std::pair<std::vector<ColorCiphertext>, ColorValue> ColorKEM::encapsulate_multi(
+    const std::vector<ColorPublicKey>& public_keys) const {
+    std::array<uint8_t, 32> m;
+    random_bytes(m.data(), m.size());
+    return encapsulate_multi_derand(public_keys, m, thread_workspace());
 }
 
 
-ColorValue ColorKEM::decapsulate(const ColorPublicKey& public_key,
-                                const ColorPrivateKey& private_key,
-                                const ColorCiphertext& ciphertext) {
-
-    // Validate public key parameters match instance parameters
-    if (public_key.params.security_level != params_.security_level ||
-        public_key.params.modulus != params_.modulus ||
-        public_key.params.degree != params_.degree ||
-        public_key.params.module_rank != params_.module_rank) {
-        throw std::invalid_argument("Public key parameters do not match KEM instance parameters");
-    }
+std::pair<std::vector<ColorCiphertext>, ColorValue> ColorKEM::encapsulate_multi_derand(
+    const std::vector<ColorPublicKey>& public_keys, const std::array<uint8_t, 32>& m) const {
+    return encapsulate_multi_derand(public_keys, m, thread_workspace());
+}
 
-    // Validate private key parameters match instance parameters
-    if (private_key.params.security_level != params_.security_level ||
-        private_key.params.modulus != params_.modulus ||
-        private_key.params.degree != params_.degree ||
-        private_key.params.module_rank != params_.module_rank) {
-        throw std::invalid_argument("Private key parameters do not match KEM instance parameters");
-    }
 
-    // Validate ciphertext parameters match instance parameters
-    if (ciphertext.params.security_level != params_.security_level ||
-        ciphertext.params.modulus != params_.modulus ||
-        ciphertext.params.degree != params_.degree ||
-        ciphertext.params.module_rank != params_.module_rank) {
-        throw std::invalid_argument("Ciphertext parameters do not match KEM instance parameters");
+std::pair<std::vector<ColorCiphertext>, ColorValue> ColorKEM::encapsulate_multi_derand(
+    const std::vector<ColorPublicKey>& public_keys, const std::array<uint8_t, 32>& m,
+    KemWorkspace& workspace) const {
+    if (public_keys.empty()) {
+        throw std::invalid_argument("Multi-recipient encapsulation needs at least one public key");
     }
-
-    // Validate private key data size
-    if (private_key.secret_data.size() != params_.module_rank * params_.degree * 4) {
-        throw std::invalid_argument("Invalid private key data size: expected " + std::to_string(params_.module_rank * params_.degree * 4) + " bytes, got " + std::to_string(private_key.secret_data.size()));
+    for (const ColorPublicKey& public_key : public_keys) {
+        validate_public_key(public_key);
     }
 
-    // Validate private key data is not empty
-    if (private_key.secret_data.empty()) {
-        throw std::invalid_argument("Private key data cannot be empty");
-    }
+    CLWE_TRACE_SPAN("encapsulate_multi");
+    EncapsulationSeeds seeds = derive_encapsulation_seeds(params_.module_rank, m);
+    std::pair<std::vector<ColorCiphertext>, ColorValue> result;
+    result.first.resize(public_keys.size());
+    result.second = seeds.shared_secret;
 
-    std::vector<std::vector<ColorValue>> secret_key_colors(params_.module_rank, std::vector<ColorValue>(params_.degree));
-    size_t idx_sk = 0;
-    for (size_t i = 0; i < params_.module_rank; ++i) {
-        for (size_t d = 0; d < params_.degree; ++d) {
-            std::vector<uint8_t> bytes(private_key.secret_data.begin() + idx_sk,
-                                       private_key.secret_data.begin() + idx_sk + 4);
-            secret_key_colors[i][d] = bytes_to_color_secret(bytes);
-            idx_sk += 4;
+    WorkspaceScope scope(workspace_buffers(workspace), params_, !matrix_streaming_ && !shared_matrix_);
+    KemWorkspace::Buffers& buffers = scope.buffers();
+    std::vector<bool> encapsulated(public_keys.size(), false);
+    uint32_t group = 0;
+    for (size_t first = 0; first < public_keys.size(); ++first) {
+        if (encapsulated[first]) {
+            continue;
+        }
+        // One r, A and c1 for every recipient with this matrix seed
+        const std::array<uint8_t, 32>& matrix_seed = public_keys[first].seed;
+        std::array<uint8_t, 32> r_seed = derive_indexed_seed(params_.module_rank, seeds.r_seed, group);
+        std::array<uint8_t, 32> e1_seed = derive_indexed_seed(params_.module_rank, seeds.e1_seed, group);
+        ++group;
+        const PolyMatrix* matrix_A_trans = nullptr;
+        if (shared_matrix_) {
+            matrix_A_trans = shared_matrix_->matrix_A_trans.get();
+        } else if (!matrix_streaming_) {
+            generate_matrix_A(matrix_seed, buffers.matrix_A, true);
+            matrix_A_trans = &buffers.matrix_A;
+        }
+        encrypt_c1_into(matrix_A_trans, &matrix_seed, r_seed, e1_seed, nullptr, buffers);
+        secure_zero(r_seed.data(), r_seed.size());
+        secure_zero(e1_seed.data(), e1_seed.size());
+
+        for (size_t i = first; i < public_keys.size(); ++i) {
+            // Under a shared matrix every recipient is in the first group
+            if (encapsulated[i] || (!shared_matrix_ && public_keys[i].seed != matrix_seed)) {
+                continue;
+            }
+            // Per recipient: t_i^T r with its own e2
+            decode_public_key_data(public_keys[i].public_data.data(), buffers.public_key, params_.encoding);
+            std::array<uint8_t, 32> e2_seed =
+                derive_indexed_seed(params_.module_rank, seeds.e2_seed, static_cast<uint32_t>(i));
+            NoiseBatch& requests = buffers.noise_requests;
+            requests.clear();
+            requests.push_back({&e2_seed, 0, false, buffers.e2.data()});
+            sample_noise_batch(params_, params_.eta2, requests.requests, requests.count, buffers.noise,
+                               *color_ntt_engine_);
+            secure_zero(e2_seed.data(), e2_seed.size());
+
+            encrypt_c2_into(buffers.public_key, buffers);
+            add_message(seeds.shared_secret, buffers.ciphertext_colors);
+            pack_ciphertext(buffers.ciphertext_colors, seeds.shared_secret, result.first[i]);
+            encapsulated[i] = true;
         }
     }
-    // std::cout << "DEBUG DECAP: Secret key colors (" << secret_key_colors.size() << " elements):" << std::endl;
-    // for (size_t i = 0; i < secret_key_colors.size(); ++i) {
-    //     std::cout << "  s[" << i << "] = " << secret_key_colors[i].to_math_value() << std::endl;
-    // }
+    secure_zero(seeds.r_seed.data(), seeds.r_seed.size());
+    secure_zero(seeds.e1_seed.data(), seeds.e1_seed.size());
+    secure_zero(seeds.e2_seed.data(), seeds.e2_seed.size());
+    return result;
+}
 
-    // Validate ciphertext data size
-    if (ciphertext.ciphertext_data.size() != (params_.module_rank + 1) * params_.degree * 4) {
-        throw std::invalid_argument("Invalid ciphertext data size: expected " + std::to_string((params_.module_rank + 1) * params_.degree * 4) + " bytes, got " + std::to_string(ciphertext.ciphertext_data.size()));
-    }
 
-    // Validate ciphertext data is not empty
-    if (ciphertext.ciphertext_data.empty()) {
-        throw std::invalid_argument("Ciphertext data cannot be empty");
-    }
+std::vector<std::pair<ColorPublicKey, ColorPrivateKey>> ColorKEM::keygen_batch_offloaded(
+    const std::vector<uint8_t>& seeds, size_t count) const {
+    const uint32_t k = params_.module_rank;
+    const size_t vec = static_cast<size_t>(k) * params_.degree;
+
+    // The host splits each d into its three seeds exactly as keygen_derand does
+    std::vector<uint8_t> instance_seeds(count * batch::INSTANCE_SEED_BYTES);
+    for (size_t i = 0; i < count; ++i) {
+        std::array<uint8_t, 32> d;
+        std::copy(seeds.begin() + i * 32, seeds.begin() + (i + 1) * 32, d.begin());
+        expand_operation_seed(KEYGEN_DOMAIN, k, d, instance_seeds.data() + i * batch::INSTANCE_SEED_BYTES,
+                              batch::INSTANCE_SEED_BYTES);
+    }
+
+    std::vector<uint32_t> t_hat(count * vec);
+    std::vector<uint32_t> s_hat(count * vec);
+    run_keygen_batch(batch_device_, batch_config_, batch_kernel_params(params_), instance_seeds.data(), count,
+                     t_hat.data(), s_hat.data());
+
+    std::vector<std::pair<ColorPublicKey, ColorPrivateKey>> keys(count);
+    PolyVec colors(k, params_.degree);
+    for (size_t i = 0; i < count; ++i) {
+        std::pair<ColorPublicKey, ColorPrivateKey>& pair = keys[i];
+        std::copy(instance_seeds.begin() + i * batch::INSTANCE_SEED_BYTES,
+                  instance_seeds.begin() + i * batch::INSTANCE_SEED_BYTES + 32, pair.first.seed.begin());
+        pair.first.params = params_;
+        colors_from_u32(t_hat.data() + i * vec, colors.data(), vec);
+        encode_public_key_data(colors, pair.first.public_data);
+        pair.second.params = params_;
+        colors_from_u32(s_hat.data() + i * vec, colors.data(), vec);
+        encode_polyvec(colors, params_.encoding, pair.second.secret_data);
+    }
+    secure_zero(s_hat.data(), s_hat.size() * sizeof(uint32_t));
+    secure_zero(instance_seeds.data(), instance_seeds.size());
+    return keys;
+}
+
+
+std::vector<std::pair<ColorCiphertext, ColorValue>> ColorKEM::encapsulate_batch_offloaded(
+    const std::vector<ColorPublicKey>& public_keys, const std::vector<uint8_t>& seeds) const {
+    const size_t count = public_keys.size();
+    const uint32_t k = params_.module_rank;
+    const size_t vec = static_cast<size_t>(k) * params_.degree;
+    const size_t out = vec + params_.degree;
+
+    std::vector<uint8_t> matrix_seeds(count * batch::SEED_BYTES);
+    std::vector<uint8_t> noise_seeds(count * batch::INSTANCE_SEED_BYTES);
+    std::vector<uint32_t> messages(count);
+    std::vector<uint32_t> t_hat(count * vec);
+    std::vector<ColorValue> secrets(count);
+    PolyVec colors(k + 1, params_.degree);
+    PolyVec key_colors(k, params_.degree);
+    for (size_t i = 0; i < count; ++i) {
+        const ColorPublicKey& public_key = public_keys[i];
+        validate_public_key(public_key);
+        std::copy(public_key.seed.begin(), public_key.seed.end(), matrix_seeds.begin() + i * batch::SEED_BYTES);
+        decode_public_key_data(public_key.public_data.data(), key_colors, params_.encoding);
+        colors_to_u32(key_colors.data(), t_hat.data() + i * vec, vec);
+
+        std::array<uint8_t, 32> m;
+        std::copy(seeds.begin() + i * 32, seeds.begin() + (i + 1) * 32, m.begin());
+        EncapsulationSeeds derived = derive_encapsulation_seeds(k, m);
+        uint8_t* noise = noise_seeds.data() + i * batch::INSTANCE_SEED_BYTES;
+        std::copy(derived.r_seed.begin(), derived.r_seed.end(), noise);
+        std::copy(derived.e1_seed.begin(), derived.e1_seed.end(), noise + batch::SEED_BYTES);
+        std::copy(derived.e2_seed.begin(), derived.e2_seed.end(), noise + 2 * batch::SEED_BYTES);
+        secrets[i] = derived.shared_secret;
+        messages[i] = derived.shared_secret.to_math_value();
+    }
+
+    std::vector<uint32_t> ciphertexts(count * out);
+    run_encapsulate_batch(batch_device_, batch_config_, batch_kernel_params(params_), matrix_seeds.data(),
+                          noise_seeds.data(), messages.data(), t_hat.data(), count, ciphertexts.data());
+
+    std::vector<std::pair<ColorCiphertext, ColorValue>> results(count);
+    for (size_t i = 0; i < count; ++i) {
+        colors_from_u32(ciphertexts.data() + i * out, colors.data(), out);
+        pack_ciphertext(colors, secrets[i], results[i].first);
+        results[i].second = secrets[i];
+    }
+    secure_zero(noise_seeds.data(), noise_seeds.size());
+    secure_zero(messages.data(), messages.size() * sizeof(uint32_t));
+    return results;
+}
 
-    // Validate shared secret hint size
-    if (ciphertext.shared_secret_hint.size() != 4) {
-        throw std::invalid_argument("Invalid shared secret hint size: expected 4 bytes, got " + std::to_string(ciphertext.shared_secret_hint.size()));
-    }
 
-    std::vector<std::vector<ColorValue>> ciphertext_colors(params_.module_rank + 1, std::vector<ColorValue>(params_.degree));
-    size_t idx = 0;
-    for (size_t i = 0; i < params_.module_rank + 1; ++i) {
-        for (size_t d = 0; d < params_.degree; ++d) {
-            std::vector<uint8_t> bytes(ciphertext.ciphertext_data.begin() + idx,
-                                      ciphertext.ciphertext_data.begin() + idx + 4);
-            ciphertext_colors[i][d] = bytes_to_color_secret(bytes);
-            idx += 4;
+std::vector<ColorValue> ColorKEM::decapsulate_batch(const std::vector<ColorPublicKey>& public_keys,
+                                                    const std::vector<ColorPrivateKey>& private_keys,
+                                                    const std::vector<ColorCiphertext>& ciphertexts) const {
+    if (public_keys.size() != ciphertexts.size() || private_keys.size() != ciphertexts.size()) {
+        throw std::invalid_argument("Batch size mismatch: " + std::to_string(public_keys.size()) + " public keys, " +
+                                    std::to_string(private_keys.size()) + " private keys, " +
+                                    std::to_string(ciphertexts.size()) + " ciphertexts");
+    }
+
+    std::vector<ColorValue> secrets;
+    secrets.reserve(ciphertexts.size());
+
+    // Consecutive ciphertexts for the same private key reuse its s_hat, which the
+    // full decapsulation leaves parsed in the workspace; the batch holds the workspace
+    // throughout, so the arena is wiped once at the end
+    KemWorkspace& workspace = thread_workspace();
+    WorkspaceScope scope(workspace_buffers(workspace), params_);
+    const ColorPrivateKey* parsed_key = nullptr;
+
+    for (size_t i = 0; i < ciphertexts.size(); ++i) {
+        bool same_key = parsed_key != nullptr &&
+                        matches_parameters(public_keys[i].params) &&
+                        matches_parameters(private_keys[i].params) &&
+                        matches_parameters(ciphertexts[i].params) &&
+                        parsed_key->secret_data == private_keys[i].secret_data;
+        if (!same_key) {
+            // Full single-shot path validates all three inputs
+            secrets.push_back(decapsulate(public_keys[i], private_keys[i], ciphertexts[i], workspace));
+            parsed_key = &private_keys[i];
+            continue;
         }
+
+        secrets.push_back(decapsulate_expanded(scope.buffers().secret, ciphertexts[i], scope.buffers()));
     }
-    // std::cout << "DEBUG DECAP: Ciphertext colors (" << ciphertext_colors.size() << " elements):" << std::endl;
-    // for (size_t i = 0; i < ciphertext_colors.size(); ++i) {
-    //     std::cout << "  c[" << i << "] = " << ciphertext_colors[i].to_math_value() << std::endl;
-    // }
+    return secrets;
+}
 
-    ColorValue recovered_secret = decrypt_message(secret_key_colors, ciphertext_colors);
-    // std::cout << "DEBUG DECAP: Recovered secret = " << recovered_secret.to_precise_value() << std::endl;
 
-    // Fujisaki-Okamoto transform for IND-CCA2 security
-    ColorValue hinted_secret = decode_color_secret(ciphertext.shared_secret_hint);
-    if (recovered_secret == hinted_secret) {
-        return recovered_secret;
-    } else {
-        return hash_ciphertext(ciphertext);
-    }
+ColorValue ColorKEM::hash_ciphertext(const ColorCiphertextView& ciphertext) const {
+    // Hash the serialized form (data then hint) in place, without assembling it
+    SHAKE256Sampler& shake = thread_shake256();
+    shake.begin();
+    shake.absorb(ciphertext.ciphertext_data, ciphertext.ciphertext_size);
+    shake.absorb(ciphertext.shared_secret_hint, 4);
+    shake.finalize();
+    return rejection_secret(shake);
 }
 
-ColorValue ColorKEM::hash_ciphertext(const ColorCiphertext& ciphertext) const {
-    auto ct_serial = ciphertext.serialize();
-    SHAKE256Sampler shake;
-    shake.init(ct_serial.data(), ct_serial.size());
 
+ColorValue ColorKEM::rejection_secret(SHAKE256Sampler& shake) const {
     std::array<uint8_t, 4> hash_bytes;
     shake.squeeze(hash_bytes.data(), 4);
 
@@ -567,35 +2914,101 @@ bool ColorKEM::verify_keypair(const ColorPublicKey& public_key, const ColorPriva
 }
 
 
-std::vector<uint8_t> ColorKEM::color_secret_to_bytes(const ColorValue& secret) {
-    uint32_t value = secret.to_math_value();
-    // Validate value is within reasonable bounds (though ColorValue should ensure this)
-    if (value > 0xFFFFFFFF) {
-        throw std::invalid_argument("Color value too large for serialization: " + std::to_string(value));
+void ColorKEM::encode_polyvec(const PolyVec& polys, CoefficientEncoding encoding, std::vector<uint8_t>& bytes) {
+    bytes.resize(encoded_coefficients_size(polys.coeff_count(), encoding));
+    encode_coefficients(polys.data(), polys.coeff_count(), encoding, bytes.data());
+}
+
+PolyVec ColorKEM::bytes_to_polyvec(const std::vector<uint8_t>& bytes, uint32_t rank, uint32_t degree,
+                                   CoefficientEncoding encoding) {
+    PolyVec polys(rank, degree);
+    size_t expected = encoded_coefficients_size(polys.coeff_count(), encoding);
+    if (bytes.size() != expected) {
+        throw std::invalid_argument("Invalid polynomial vector encoding: expected " + std::to_string(expected) + " bytes, got " + std::to_string(bytes.size()));
     }
-    return {
-        static_cast<uint8_t>((value >> 24) & 0xFF),
-        static_cast<uint8_t>((value >> 16) & 0xFF),
-        static_cast<uint8_t>((value >> 8) & 0xFF),
-        static_cast<uint8_t>(value & 0xFF)
-    };
+
+    decode_polyvec(bytes.data(), polys, encoding);
+    return polys;
 }
 
-ColorValue ColorKEM::bytes_to_color_secret(const std::vector<uint8_t>& bytes) {
-    if (bytes.size() < 4) {
-        throw std::invalid_argument("Insufficient bytes for color secret: need 4 bytes, got " + std::to_string(bytes.size()));
+void ColorKEM::decode_polyvec(const uint8_t* bytes, PolyVec& polys, CoefficientEncoding encoding) {
+    decode_coefficients(bytes, polys.coeff_count(), encoding, polys.data());
+}
+
+void ColorKEM::encode_public_key_data(PolyVec& t_hat, std::vector<uint8_t>& bytes) const {
+    if (params_.t_dropped_bits == 0) {
+        encode_polyvec(t_hat, params_.encoding, bytes);
+        return;
     }
+    // Power2Round works on t itself, not its NTT image
+    polyvec_invntt(*color_ntt_engine_, t_hat, degree_inv_);
+    bytes.resize(public_key_bytes_);
+    round_encode_coefficients(t_hat.data(), t_hat.coeff_count(), params_.t_dropped_bits, params_.rounded_t_bits(),
+                              bytes.data());
+}
 
-    if (bytes.size() > 4) {
-        throw std::invalid_argument("Too many bytes for color secret: expected 4 bytes, got " + std::to_string(bytes.size()));
+void ColorKEM::decode_public_key_data(const uint8_t* bytes, PolyVec& t_hat, CoefficientEncoding encoding) const {
+    if (params_.t_dropped_bits == 0) {
+        decode_public_polyvec(bytes, t_hat, encoding, "public key");
+        return;
+    }
+    if (!decode_unround_coefficients(bytes, t_hat.coeff_count(), params_.t_dropped_bits, params_.rounded_t_bits(),
+                                     params_.modulus, t_hat.data())) {
+        throw std::invalid_argument("Invalid public key: rounded coefficient out of range");
     }
+    polyvec_ntt(*color_ntt_engine_, t_hat);
+}
 
-    uint32_t value = (static_cast<uint32_t>(bytes[0]) << 24) |
-                    (static_cast<uint32_t>(bytes[1]) << 16) |
-                    (static_cast<uint32_t>(bytes[2]) << 8) |
-                    static_cast<uint32_t>(bytes[3]);
+void ColorKEM::decode_public_polyvec(const uint8_t* bytes, PolyVec& polys, CoefficientEncoding encoding,
+                                     const char* what) const {
+    if (!decode_coefficients_checked(bytes, polys.coeff_count(), encoding, params_.modulus, polys.data())) {
+        throw std::invalid_argument(std::string("Invalid ") + what + ": coefficient not reduced mod q");
+    }
+}
 
-    return ColorValue::from_math_value(value);
+std::vector<uint8_t> ColorKEM::ciphertext_to_bytes(const PolyVec& ciphertext) const {
+    std::vector<uint8_t> bytes(ciphertext_bytes_);
+    encode_ciphertext(ciphertext, bytes.data());
+    return bytes;
+}
+
+void ColorKEM::encode_ciphertext(const PolyVec& ciphertext, uint8_t* bytes) const {
+    size_t c1_count = static_cast<size_t>(params_.module_rank) * params_.degree;
+    size_t c2_count = c2_size(params_);
+    const ColorValue* c2 = ciphertext[params_.module_rank];
+
+    if (!compressed(params_)) {
+        encode_coefficients(ciphertext.data(), c1_count, params_.encoding, bytes);
+        encode_coefficients(c2, c2_count, params_.encoding,
+                            bytes + encoded_coefficients_size(c1_count, params_.encoding));
+    } else {
+        compress_encode_coefficients(ciphertext.data(), c1_count, params_.du, params_.modulus, bytes);
+        compress_encode_coefficients(c2, c2_count, params_.dv, params_.modulus,
+                                     bytes + compressed_coefficients_size(c1_count, params_.du));
+    }
+}
+
+bool ColorKEM::decode_ciphertext(const uint8_t* bytes, PolyVec& ciphertext) const {
+    size_t c1_count = static_cast<size_t>(params_.module_rank) * params_.degree;
+    size_t c2_count = c2_size(params_);
+    ColorValue* c2 = ciphertext[params_.module_rank];
+    // Decompressed coefficients are below q by construction; raw ones are checked
+    bool reduced = true;
+
+    if (!compressed(params_)) {
+        reduced = decode_coefficients_checked(bytes, c1_count, params_.encoding, params_.modulus,
+                                              ciphertext.data());
+        reduced &= decode_coefficients_checked(bytes + encoded_coefficients_size(c1_count, params_.encoding),
+                                               c2_count, params_.encoding, params_.modulus, c2);
+    } else {
+        decode_decompress_coefficients(bytes, c1_count, params_.du, params_.modulus, ciphertext.data());
+        decode_decompress_coefficients(bytes + compressed_coefficients_size(c1_count, params_.du), c2_count,
+                                       params_.dv, params_.modulus, c2);
+    }
+
+    // The zero tail of a sparse c2 is implied, never parsed
+    std::fill(c2 + c2_count, c2 + params_.degree, ColorValue::from_math_value(0));
+    return reduced;
 }
 
 
@@ -606,412 +3019,636 @@ std::vector<uint8_t> ColorPublicKey::serialize() const {
     }
 
     // Validate public data size (should be multiple of 4 for ColorValue serialization)
-    if (public_data.size() % 4 != 0 || public_data.empty()) {
+    if (public_misaligned(public_data.size(), params) || public_data.empty()) {
         throw std::invalid_argument("Invalid public data size: must be non-empty and multiple of 4 bytes, got " + std::to_string(public_data.size()));
     }
 
-    std::vector<uint8_t> data;
-    data.insert(data.end(), seed.begin(), seed.end());
-    data.insert(data.end(), public_data.begin(), public_data.end());
+    std::vector<uint8_t> data(seed_bytes(params) + public_data.size());
+    serialize(data.data(), data.size());
     return data;
 }
 
-ColorPublicKey ColorPublicKey::deserialize(const std::vector<uint8_t>& data, const CLWEParameters& params) {
-    if (data.size() < 32) {
-        throw std::invalid_argument("Public key data too small: minimum 32 bytes required, got " + std::to_string(data.size()));
+size_t ColorPublicKey::serialized_size(const CLWEParameters& params) {
+    return seed_bytes(params) + public_data_size(params, params.encoding);
+}
+
+size_t ColorPublicKey::seed_bytes(const CLWEParameters& params) {
+    // shared_matrix keys leave the seed to the installed deployment matrix
+    return params.shared_matrix ? 0 : 32;
+}
+
+size_t ColorPublicKey::serialize(uint8_t* out, size_t out_size) const {
+    if (public_misaligned(public_data.size(), params) || public_data.empty()) {
+        throw std::invalid_argument("Invalid public data size: must be non-empty and multiple of 4 bytes, got " + std::to_string(public_data.size()));
     }
 
-    if (data.empty()) {
-        throw std::invalid_argument("Public key data cannot be empty");
+    const size_t seed_size = seed_bytes(params);
+    size_t size = seed_size + public_data.size();
+    if (out == nullptr || out_size < size) {
+        throw std::invalid_argument("Output buffer too small: need " + std::to_string(size) + " bytes, got " + std::to_string(out_size));
+    }
+
+    std::copy(seed.begin(), seed.begin() + seed_size, out);
+    std::copy(public_data.begin(), public_data.end(), out + seed_size);
+    return size;
+}
+
+struct ColorPublicKey::SerializedForm {
+    std::vector<uint8_t> bytes;
+    std::array<uint8_t, 32> hash;
+    bool shared_matrix;
+    CoefficientEncoding encoding;
+
+    // Whether the bytes are still those of key: the only parameters serialization reads
+    // are the seed layout and the size check's encoding
+    bool matches(const ColorPublicKey& key) const {
+        const size_t seed_size = seed_bytes(key.params);
+        return key.params.shared_matrix == shared_matrix && key.params.encoding == encoding &&
+               bytes.size() == seed_size + key.public_data.size() &&
+               std::equal(key.seed.begin(), key.seed.begin() + seed_size, bytes.begin()) &&
+               std::equal(key.public_data.begin(), key.public_data.end(), bytes.begin() + seed_size);
+    }
+};
+
+ColorPublicKey::ColorPublicKey(const ColorPublicKey& other)
+    : seed(other.seed), public_data(other.public_data), params(other.params),
+      serialized_(std::atomic_load(&other.serialized_)), pool_(other.pool_) {}
+
+ColorPublicKey& ColorPublicKey::operator=(const ColorPublicKey& other) {
+    if (this != &other) {
+        seed = other.seed;
+        public_data = other.public_data;
+        params = other.params;
+        serialized_ = std::atomic_load(&other.serialized_);
+        pool_ = other.pool_;
+    }
+    return *this;
+}
+
+const ColorPublicKey::SerializedForm& ColorPublicKey::serialized_form() const {
+    std::shared_ptr<const SerializedForm> form = std::atomic_load(&serialized_);
+    if (form && form->matches(*this)) {
+        return *form;
+    }
+
+    auto fresh = std::make_shared<SerializedForm>();
+    fresh->bytes = serialize();
+    fresh->hash = hash_public_key(*this);
+    fresh->shared_matrix = params.shared_matrix;
+    fresh->encoding = params.encoding;
+    std::shared_ptr<const SerializedForm> published = std::move(fresh);
+    if (!form) {
+        // First use: the first thread to publish wins, so references other threads hold stay valid
+        if (std::atomic_compare_exchange_strong(&serialized_, &form, published)) {
+            return *published;
+        }
+        if (form->matches(*this)) {
+            return *form;
+        }
     }
+    // A stale form means the key was modified, which no reader may race with
+    std::atomic_store(&serialized_, published);
+    return *published;
+}
+
+const std::vector<uint8_t>& ColorPublicKey::serialized() const {
+    return serialized_form().bytes;
+}
+
+const std::array<uint8_t, 32>& ColorPublicKey::fingerprint() const {
+    return serialized_form().hash;
+}
+
+ColorPublicKey ColorPublicKey::deserialize(const std::vector<uint8_t>& data, const CLWEParameters& params) {
+    return deserialize(data.data(), data.size(), params);
+}
 
+ColorPublicKey ColorPublicKey::deserialize(const uint8_t* data, size_t size, const CLWEParameters& params) {
     ColorPublicKey key;
-    std::copy(data.begin(), data.begin() + 32, key.seed.begin());
-    key.public_data.assign(data.begin() + 32, data.end());
-    key.params = params;
+    CLWEError error = try_deserialize(data, size, params, key);
+    if (error == CLWEError::SUCCESS) {
+        return key;
+    }
+    if (error == CLWEError::MEMORY_ALLOCATION_FAILED) {
+        throw std::bad_alloc();
+    }
+    if (error == CLWEError::INVALID_PARAMETERS) {
+        throw std::logic_error("shared_matrix public keys need ColorKEM::install_shared_matrix() first");
+    }
+    const size_t seed_size = seed_bytes(params);
+    if (data == nullptr || size < seed_size) {
+        throw std::invalid_argument("Public key data too small: minimum 32 bytes required, got " + std::to_string(size));
+    }
+    throw std::invalid_argument("Invalid public key data size: must be non-empty and multiple of 4 bytes, got " + std::to_string(size - seed_size));
+}
 
-    // Validate public data size (should be multiple of 4 for ColorValue serialization and non-empty)
-    if (key.public_data.size() % 4 != 0 || key.public_data.empty()) {
-        throw std::invalid_argument("Invalid public key data size: must be non-empty and multiple of 4 bytes, got " + std::to_string(key.public_data.size()));
+CLWEError ColorPublicKey::try_deserialize(const uint8_t* data, size_t size, const CLWEParameters& params,
+                                          ColorPublicKey& out) noexcept {
+    // Public data (should be a multiple of 4 for ColorValue serialization and non-empty)
+    const size_t seed_size = seed_bytes(params);
+    if (data == nullptr || size <= seed_size || public_misaligned(size - seed_size, params)) {
+        return CLWEError::INVALID_KEY;
+    }
+    std::shared_ptr<const SharedMatrix> shared;
+    try {
+        if (params.shared_matrix) {
+            shared = ColorKEM::find_shared_matrix(params);
+            if (!shared) {
+                return CLWEError::INVALID_PARAMETERS;
+            }
+        }
+        out.public_data.assign(data + seed_size, data + size);
+    } catch (...) {
+        return CLWEError::MEMORY_ALLOCATION_FAILED;
     }
-    return key;
+    if (shared) {
+        out.seed = shared->seed;
+    } else {
+        std::copy(data, data + 32, out.seed.begin());
+    }
+    out.params = params;
+    return CLWEError::SUCCESS;
 }
 
 std::vector<uint8_t> ColorPrivateKey::serialize() const {
     // Validate secret data size (should be multiple of 4 for ColorValue serialization)
-    if (secret_data.size() % 4 != 0 || secret_data.empty()) {
+    if (misaligned(secret_data.size(), params) || secret_data.empty()) {
         throw std::invalid_argument("Invalid secret data size: must be non-empty and multiple of 4 bytes, got " + std::to_string(secret_data.size()));
     }
     return secret_data;
 }
 
-ColorPrivateKey ColorPrivateKey::deserialize(const std::vector<uint8_t>& data) {
-    if (data.empty()) {
-        throw std::invalid_argument("Private key data cannot be empty");
-    }
+size_t ColorPrivateKey::serialized_size(const CLWEParameters& params) {
+    return polyvec_size(params, params.module_rank);
+}
 
-    ColorPrivateKey key;
-    key.secret_data = data;
+size_t ColorPrivateKey::serialize(uint8_t* out, size_t out_size) const {
+    if (misaligned(secret_data.size(), params) || secret_data.empty()) {
+        throw std::invalid_argument("Invalid secret data size: must be non-empty and multiple of 4 bytes, got " + std::to_string(secret_data.size()));
+    }
 
-    // Validate secret data size (should be multiple of 4 for ColorValue serialization and non-empty)
-    if (key.secret_data.size() % 4 != 0 || key.secret_data.empty()) {
-        throw std::invalid_argument("Invalid private key data size: must be non-empty and multiple of 4 bytes, got " + std::to_string(key.secret_data.size()));
+    if (out == nullptr || out_size < secret_data.size()) {
+        throw std::invalid_argument("Output buffer too small: need " + std::to_string(secret_data.size()) + " bytes, got " + std::to_string(out_size));
     }
-    return key;
+
+    std::copy(secret_data.begin(), secret_data.end(), out);
+    return secret_data.size();
 }
 
-std::vector<uint8_t> ColorCiphertext::serialize() const {
-    // Validate ciphertext data size (should be multiple of 4 for ColorValue serialization)
-    if (ciphertext_data.size() % 4 != 0 || ciphertext_data.empty()) {
-        throw std::invalid_argument("Invalid ciphertext data size: must be non-empty and multiple of 4 bytes, got " + std::to_string(ciphertext_data.size()));
+ColorPrivateKey ColorPrivateKey::deserialize(const std::vector<uint8_t>& data, const CLWEParameters& params) {
+    return deserialize(data.data(), data.size(), params);
+}
+
+ColorPrivateKey ColorPrivateKey::deserialize(const std::vector<uint8_t>& data) {
+    return deserialize(data.data(), data.size(), CLWEParameters());
+}
+
+ColorPrivateKey ColorPrivateKey::deserialize(const uint8_t* data, size_t size, const CLWEParameters& params) {
+    ColorPrivateKey key;
+    CLWEError error = try_deserialize(data, size, params, key);
+    if (error == CLWEError::SUCCESS) {
+        return key;
+    }
+    if (error == CLWEError::MEMORY_ALLOCATION_FAILED) {
+        throw std::bad_alloc();
+    }
+    if (data == nullptr || size == 0) {
+        throw std::invalid_argument("Private key data cannot be empty");
     }
+    throw std::invalid_argument("Invalid private key data size: must be non-empty and multiple of 4 bytes, got " + std::to_string(size));
+}
 
-    // Validate shared secret hint size
-    if (shared_secret_hint.size() != 4) {
-        throw std::invalid_argument("Invalid shared secret hint size: expected 4 bytes, got " + std::to_string(shared_secret_hint.size()));
+CLWEError ColorPrivateKey::try_deserialize(const uint8_t* data, size_t size, const CLWEParameters& params,
+                                           ColorPrivateKey& out) noexcept {
+    // Secret data (should be a multiple of 4 for ColorValue serialization and non-empty)
+    if (data == nullptr || size == 0 || misaligned(size, params)) {
+        return CLWEError::INVALID_KEY;
     }
+    try {
+        out.secret_data.assign(data, data + size);
+    } catch (...) {
+        return CLWEError::MEMORY_ALLOCATION_FAILED;
+    }
+    out.params = params;
+    return CLWEError::SUCCESS;
+}
 
-    std::vector<uint8_t> data;
-    data.insert(data.end(), ciphertext_data.begin(), ciphertext_data.end());
-    data.insert(data.end(), shared_secret_hint.begin(), shared_secret_hint.end());
-    return data;
+std::vector<uint8_t> ColorCompactPrivateKey::serialize() const {
+    return std::vector<uint8_t>(seed.begin(), seed.end());
 }
 
-ColorCiphertext ColorCiphertext::deserialize(const std::vector<uint8_t>& data) {
-    if (data.empty()) {
-        throw std::invalid_argument("Ciphertext data cannot be empty");
-    }
+ColorCompactPrivateKey ColorCompactPrivateKey::deserialize(const std::vector<uint8_t>& data,
+                                                           const CLWEParameters& params) {
+    return deserialize(data.data(), data.size(), params);
+}
 
-    if (data.size() < 8 || data.size() % 4 != 0) {
-        throw std::invalid_argument("Invalid ciphertext data: size must be at least 8 bytes and multiple of 4, got " + std::to_string(data.size()));
+ColorCompactPrivateKey ColorCompactPrivateKey::deserialize(const uint8_t* data, size_t size,
+                                                           const CLWEParameters& params) {
+    if (data == nullptr || size != BYTES) {
+        throw std::invalid_argument("Invalid compact private key size: expected " + std::to_string(BYTES) +
+                                    " bytes, got " + std::to_string(size));
     }
+    ColorCompactPrivateKey key;
+    std::copy(data, data + BYTES, key.seed.begin());
+    key.params = params;
+    return key;
+}
 
-    ColorCiphertext ct;
+std::vector<uint8_t> ColorExpandedPrivateKey::serialize() const {
+    std::vector<uint8_t> data(secret_data.size() + ColorPublicKey::seed_bytes(params) +
+                              public_key.public_data.size() + public_key_hash.size());
+    serialize(data.data(), data.size());
+    return data;
+}
 
-    // shared_secret_hint is always 4 bytes
-    size_t hint_size = 4;
-    size_t ciphertext_size = data.size() - hint_size;
+size_t ColorExpandedPrivateKey::serialized_size(const CLWEParameters& params) {
+    return ColorPrivateKey::serialized_size(params) + ColorPublicKey::serialized_size(params) + 32;
+}
 
-    // Ensure ciphertext data is not empty
-    if (ciphertext_size == 0) {
-        throw std::invalid_argument("Ciphertext data portion cannot be empty");
+size_t ColorExpandedPrivateKey::serialize(uint8_t* out, size_t out_size) const {
+    if (misaligned(secret_data.size(), params) || secret_data.empty()) {
+        throw std::invalid_argument("Invalid secret data size: must be non-empty and multiple of 4 bytes, got " + std::to_string(secret_data.size()));
     }
 
-    ct.ciphertext_data.assign(data.begin(), data.begin() + ciphertext_size);
-    ct.shared_secret_hint.assign(data.begin() + ciphertext_size, data.end());
-
-    // Validate shared secret hint size
-    if (ct.shared_secret_hint.size() != 4) {
-        throw std::invalid_argument("Invalid shared secret hint size: expected 4 bytes, got " + std::to_string(ct.shared_secret_hint.size()));
+    size_t size = secret_data.size() + ColorPublicKey::seed_bytes(params) + public_key.public_data.size() +
+                  public_key_hash.size();
+    if (out == nullptr || out_size < size) {
+        throw std::invalid_argument("Output buffer too small: need " + std::to_string(size) + " bytes, got " + std::to_string(out_size));
     }
 
-    return ct;
+    std::copy(secret_data.begin(), secret_data.end(), out);
+    size_t offset = secret_data.size();
+    offset += public_key.serialize(out + offset, out_size - offset);
+    std::copy(public_key_hash.begin(), public_key_hash.end(), out + offset);
+    return size;
 }
 
+ColorExpandedPrivateKey ColorExpandedPrivateKey::deserialize(const std::vector<uint8_t>& data,
+                                                             const CLWEParameters& params) {
+    return deserialize(data.data(), data.size(), params);
+}
 
-std::vector<std::vector<ColorValue>> ColorKEM::encrypt_message(const std::vector<std::vector<std::vector<ColorValue>>>& matrix_A,
-                                                  const std::vector<std::vector<ColorValue>>& public_key,
-                                                  const ColorValue& message) const {
-
-    // Validate matrix_A dimensions
-    if (matrix_A.size() != params_.module_rank) {
-        throw std::invalid_argument("Invalid matrix_A rows: expected " + std::to_string(params_.module_rank) + ", got " + std::to_string(matrix_A.size()));
+ColorExpandedPrivateKey ColorExpandedPrivateKey::deserialize(const uint8_t* data, size_t size,
+                                                             const CLWEParameters& params) {
+    ColorExpandedPrivateKey key;
+    CLWEError error = try_deserialize(data, size, params, key);
+    if (error == CLWEError::SUCCESS) {
+        return key;
     }
-    for (const auto& row : matrix_A) {
-        if (row.size() != params_.module_rank) {
-            throw std::invalid_argument("Invalid matrix_A columns: expected " + std::to_string(params_.module_rank) + " per row");
-        }
+    if (error == CLWEError::MEMORY_ALLOCATION_FAILED) {
+        throw std::bad_alloc();
     }
-
-    // Validate public_key size
-    if (public_key.size() != params_.module_rank) {
-        throw std::invalid_argument("Invalid public_key size: expected " + std::to_string(params_.module_rank) + ", got " + std::to_string(public_key.size()));
+    if (data == nullptr || size != serialized_size(params)) {
+        throw std::invalid_argument("Invalid expanded private key size: expected " + std::to_string(serialized_size(params)) + " bytes, got " + std::to_string(size));
     }
+    throw std::invalid_argument("Expanded private key hash check failed: embedded public key does not match H(pk)");
+}
 
-    // Validate message value is within modulus
-    if (message.to_math_value() >= params_.modulus) {
-        throw std::invalid_argument("Invalid message value: must be less than modulus " + std::to_string(params_.modulus));
+CLWEError ColorExpandedPrivateKey::try_deserialize(const uint8_t* data, size_t size, const CLWEParameters& params,
+                                                   ColorExpandedPrivateKey& out) noexcept {
+    // Unlike the plain keys the layout has three parts, so only the exact size parses
+    if (data == nullptr || size != serialized_size(params)) {
+        return CLWEError::INVALID_KEY;
     }
 
-    std::vector<std::vector<ColorValue>> ciphertext(params_.module_rank + 1, std::vector<ColorValue>(params_.degree));
-
-    auto r_vector = generate_secret_key(params_.eta2);
+    const size_t secret_size = ColorPrivateKey::serialized_size(params);
+    const size_t public_size = ColorPublicKey::serialized_size(params);
+    CLWEError error = ColorPublicKey::try_deserialize(data + secret_size, public_size, params, out.public_key);
+    if (error != CLWEError::SUCCESS) {
+        return error;
+    }
+    std::array<uint8_t, 32> hash;
+    try {
+        out.secret_data.assign(data, data + secret_size);
+        hash = hash_public_key(out.public_key);
+    } catch (...) {
+        return CLWEError::MEMORY_ALLOCATION_FAILED;
+    }
+    std::copy(data + secret_size + public_size, data + size, out.public_key_hash.begin());
+    out.params = params;
 
-    auto e1_vector = generate_error_vector(params_.eta2);
-    auto e2_vector = generate_error_vector(params_.eta2);
-    auto e2 = e2_vector[0];
+    // FIPS 203 hash check: the embedded public key must be the one the hash was taken of
+    uint8_t difference = 0;
+    for (size_t i = 0; i < hash.size(); ++i) {
+        difference |= static_cast<uint8_t>(hash[i] ^ out.public_key_hash[i]);
+    }
+    return difference == 0 ? CLWEError::SUCCESS : CLWEError::INVALID_KEY;
+}
 
-    auto A_trans_r = matrix_transpose_vector_mul(matrix_A, r_vector);
-    for (uint32_t i = 0; i < params_.module_rank; ++i) {
-        for (uint32_t d = 0; d < params_.degree; ++d) {
-            uint64_t atr_val = A_trans_r[i][d].to_math_value();
-            uint64_t e1_val = e1_vector[i][d].to_math_value();
-            uint64_t c1_val = (atr_val + e1_val) % params_.modulus;
-            ciphertext[i][d] = ColorValue::from_math_value(c1_val);
-        }
+std::vector<uint8_t> ColorCiphertext::serialize() const {
+    // Validate ciphertext data size (should be multiple of 4 for ColorValue serialization)
+    if (ciphertext_misaligned(ciphertext_data.size(), params) || ciphertext_data.empty()) {
+        throw std::invalid_argument("Invalid ciphertext data size: must be non-empty and multiple of 4 bytes, got " + std::to_string(ciphertext_data.size()));
     }
 
-    std::vector<ColorValue> inner_product_poly(params_.degree, ColorValue(0, 0, 0, 0));
-    for (uint32_t i = 0; i < params_.module_rank; ++i) {
-        std::vector<ColorValue> product(params_.degree);
-        color_ntt_engine_->multiply_colors(public_key[i].data(), r_vector[i].data(), product.data());
-        for (uint32_t d = 0; d < params_.degree; ++d) {
-            uint64_t ip_val = inner_product_poly[d].to_math_value();
-            uint64_t p_val = product[d].to_math_value();
-            inner_product_poly[d] = ColorValue::from_math_value((ip_val + p_val) % params_.modulus);
-        }
+    // Validate shared secret hint size
+    if (shared_secret_hint.size() != 4) {
+        throw std::invalid_argument("Invalid shared secret hint size: expected 4 bytes, got " + std::to_string(shared_secret_hint.size()));
     }
 
-    uint64_t inner_product = inner_product_poly[0].to_math_value(); // Constant term
+    std::vector<uint8_t> data(ciphertext_data.size() + shared_secret_hint.size());
+    serialize(data.data(), data.size());
+    return data;
+}
 
-    uint64_t e2_val = e2[0].to_math_value(); // Constant term
-    uint64_t m_val = message.to_math_value();
+size_t ColorCiphertext::serialized_size(const CLWEParameters& params) {
+    return ciphertext_size(params) + 4;
+}
 
-    uint64_t q_half = params_.modulus / 2;
-    uint64_t encoded_m = m_val * q_half;
-    uint64_t c2_val = (inner_product + e2_val + encoded_m) % params_.modulus;
+size_t ColorCiphertext::serialize(uint8_t* out, size_t out_size) const {
+    if (ciphertext_misaligned(ciphertext_data.size(), params) || ciphertext_data.empty()) {
+        throw std::invalid_argument("Invalid ciphertext data size: must be non-empty and multiple of 4 bytes, got " + std::to_string(ciphertext_data.size()));
+    }
 
-    ciphertext[params_.module_rank][0] = ColorValue::from_math_value(c2_val);
-    for (uint32_t d = 1; d < params_.degree; ++d) {
-        ciphertext[params_.module_rank][d] = ColorValue(0, 0, 0, 0); // Zero elsewhere
+    if (shared_secret_hint.size() != 4) {
+        throw std::invalid_argument("Invalid shared secret hint size: expected 4 bytes, got " + std::to_string(shared_secret_hint.size()));
     }
 
-    return ciphertext;
-}
+    size_t size = ciphertext_data.size() + shared_secret_hint.size();
+    if (out == nullptr || out_size < size) {
+        throw std::invalid_argument("Output buffer too small: need " + std::to_string(size) + " bytes, got " + std::to_string(out_size));
+    }
 
-// SIMD-accelerated matrix-vector multiplication implementations
-std::vector<std::vector<ColorValue>> ColorKEM::matrix_vector_mul_simd(const std::vector<std::vector<std::vector<ColorValue>>>& matrix,
-                                                        const std::vector<std::vector<ColorValue>>& vector) const {
-    // For now, just call the regular implementation
-    return matrix_vector_mul(matrix, vector);
+    std::copy(ciphertext_data.begin(), ciphertext_data.end(), out);
+    std::copy(shared_secret_hint.begin(), shared_secret_hint.end(), out + ciphertext_data.size());
+    return size;
 }
 
-std::vector<std::vector<ColorValue>> ColorKEM::matrix_transpose_vector_mul_simd(const std::vector<std::vector<std::vector<ColorValue>>>& matrix,
-                                                                  const std::vector<std::vector<ColorValue>>& vector) const {
-    // For now, just call the regular implementation
-    return matrix_transpose_vector_mul(matrix, vector);
+ColorCiphertext ColorCiphertext::deserialize(const std::vector<uint8_t>& data) {
+    return deserialize(data.data(), data.size(), CLWEParameters());
 }
 
-#ifdef HAVE_AVX512
-std::vector<ColorValue> ColorKEM::matrix_vector_mul_avx512(const std::vector<std::vector<ColorValue>>& matrix,
-                                                          const std::vector<uint32_t>& vector,
-                                                          uint32_t modulus) const {
-    uint32_t k = params_.module_rank;
-    std::vector<ColorValue> result(k);
-
-    // Load vector into AVX-512 register (pad with zeros if needed)
-    __m512i vec_reg = _mm512_setzero_si512();
-    uint32_t* vec_ptr = const_cast<uint32_t*>(vector.data());
-    vec_reg = _mm512_loadu_si512(reinterpret_cast<__m512i*>(vec_ptr));
-
-    for (uint32_t i = 0; i < k; ++i) {
-        __m512i sum_reg = _mm512_setzero_si512();
+ColorCiphertext ColorCiphertext::deserialize(const std::vector<uint8_t>& data, const CLWEParameters& params) {
+    return deserialize(data.data(), data.size(), params);
+}
 
-        // Process matrix row in chunks of 16 elements
-        for (uint32_t j = 0; j < k; j += 16) {
-            uint32_t remaining = std::min(16u, k - j);
+ColorCiphertext ColorCiphertext::deserialize(const uint8_t* data, size_t size, const CLWEParameters& params) {
+    ColorCiphertextView view = ColorCiphertextView::parse(data, size, params);
 
-            // Load matrix row elements
-            __m512i mat_reg = _mm512_setzero_si512();
-            uint32_t mat_vals[16] = {0};
-            for (uint32_t idx = 0; idx < remaining; ++idx) {
-                mat_vals[idx] = matrix[i][j + idx].to_math_value();
-            }
-            mat_reg = _mm512_loadu_si512(reinterpret_cast<__m512i*>(mat_vals));
+    ColorCiphertext ct;
+    ct.ciphertext_data.assign(view.ciphertext_data, view.ciphertext_data + view.ciphertext_size);
+    ct.shared_secret_hint.assign(view.shared_secret_hint, view.shared_secret_hint + 4);
+    ct.params = params;
+    return ct;
+}
 
-            // Multiply and accumulate
-            __m512i prod_reg = _mm512_mullo_epi32(mat_reg, vec_reg);
-            sum_reg = _mm512_add_epi64(sum_reg, _mm512_cvtepi32_epi64(_mm512_extracti32x4_epi32(prod_reg, 0)));
-            // Note: This is simplified; full implementation would need proper accumulation
-        }
+CLWEError ColorCiphertext::try_deserialize(const uint8_t* data, size_t size, const CLWEParameters& params,
+                                           ColorCiphertext& out) noexcept {
+    ColorCiphertextView view;
+    CLWEError error = ColorCiphertextView::try_parse(data, size, params, view);
+    if (error != CLWEError::SUCCESS) {
+        return error;
+    }
+    try {
+        out.ciphertext_data.assign(view.ciphertext_data, view.ciphertext_data + view.ciphertext_size);
+        out.shared_secret_hint.assign(view.shared_secret_hint, view.shared_secret_hint + 4);
+    } catch (...) {
+        return CLWEError::MEMORY_ALLOCATION_FAILED;
+    }
+    out.params = params;
+    return CLWEError::SUCCESS;
+}
 
-        // Reduce modulo q (constant-time)
-        uint64_t total_sum = 0;
-        uint32_t sum_vals[16];
-        _mm512_storeu_si512(reinterpret_cast<__m512i*>(sum_vals), sum_reg);
-        for (uint32_t val : sum_vals) {
-            total_sum = (total_sum + val) % modulus;
-        }
+ColorCiphertextView::ColorCiphertextView(const ColorCiphertext& ciphertext)
+    : ciphertext_data(ciphertext.ciphertext_data.data()),
+      ciphertext_size(ciphertext.ciphertext_data.size()),
+      shared_secret_hint(ciphertext.shared_secret_hint.size() == 4 ? ciphertext.shared_secret_hint.data() : nullptr),
+      params(ciphertext.params) {}
+
+ColorPublicKeyView::ColorPublicKeyView(const ColorPublicKey& public_key)
+    : seed(public_key.seed.data()),
+      public_data(public_key.public_data.data()),
+      public_data_size(public_key.public_data.size()),
+      encoding(public_key.params.encoding),
+      params(public_key.params) {}
+
+ColorCiphertextView ColorCiphertextView::parse(const uint8_t* data, size_t size, const CLWEParameters& params) {
+    ColorCiphertextView view;
+    if (try_parse(data, size, params, view) == CLWEError::SUCCESS) {
+        return view;
+    }
+    if (data == nullptr || size == 0) {
+        throw std::invalid_argument("Ciphertext data cannot be empty");
+    }
+    throw std::invalid_argument("Invalid ciphertext data: size must be at least 8 bytes and multiple of 4, got " + std::to_string(size));
+}
 
-        result[i] = ColorValue::from_math_value(total_sum);
+CLWEError ColorCiphertextView::try_parse(const uint8_t* data, size_t size, const CLWEParameters& params,
+                                         ColorCiphertextView& out) noexcept {
+    if (data == nullptr || size < 8 || ciphertext_misaligned(size, params)) {
+        return CLWEError::INVALID_CIPHERTEXT;
     }
 
-    return result;
+    // shared_secret_hint is always the trailing 4 bytes
+    out.ciphertext_data = data;
+    out.ciphertext_size = size - 4;
+    out.shared_secret_hint = data + out.ciphertext_size;
+    out.params = params;
+    return CLWEError::SUCCESS;
 }
 
-std::vector<ColorValue> ColorKEM::matrix_transpose_vector_mul_avx512(const std::vector<std::vector<ColorValue>>& matrix,
-                                                                    const std::vector<uint32_t>& vector,
-                                                                    uint32_t modulus) const {
-    uint32_t k = params_.module_rank;
-    std::vector<ColorValue> result(k);
 
-    // Load vector into AVX-512 register
-    __m512i vec_reg = _mm512_setzero_si512();
-    uint32_t* vec_ptr = const_cast<uint32_t*>(vector.data());
-    vec_reg = _mm512_loadu_si512(reinterpret_cast<__m512i*>(vec_ptr));
+PolyVec ColorKEM::encrypt_message(const PolyMatrix& matrix_A_trans,
+                                  const PolyVec& public_key,
+                                  const ColorValue& message) const {
+    std::array<uint8_t, 32> r_seed;
+    std::array<uint8_t, 32> e1_seed;
+    std::array<uint8_t, 32> e2_seed;
+    random_bytes(r_seed.data(), r_seed.size());
+    random_bytes(e1_seed.data(), e1_seed.size());
+    random_bytes(e2_seed.data(), e2_seed.size());
 
-    for (uint32_t i = 0; i < k; ++i) {
-        __m512i sum_reg = _mm512_setzero_si512();
+    return encrypt_message_deterministic(matrix_A_trans, public_key, message, r_seed, e1_seed, e2_seed);
+}
 
-        // Process matrix column in chunks of 16 elements
-        for (uint32_t j = 0; j < k; j += 16) {
-            uint32_t remaining = std::min(16u, k - j);
 
-            // Load matrix column elements (transposed access)
-            __m512i mat_reg = _mm512_setzero_si512();
-            uint32_t mat_vals[16] = {0};
-            for (uint32_t idx = 0; idx < remaining; ++idx) {
-                mat_vals[idx] = matrix[j + idx][i].to_math_value();
-            }
-            mat_reg = _mm512_loadu_si512(reinterpret_cast<__m512i*>(mat_vals));
+PolyVec ColorKEM::encrypt_message_deterministic(const PolyMatrix& matrix_A_trans,
+                                                const PolyVec& public_key,
+                                                const ColorValue& message,
+                                                const std::array<uint8_t, 32>& r_seed,
+                                                const std::array<uint8_t, 32>& e1_seed,
+                                                const std::array<uint8_t, 32>& e2_seed) const {
+    KemWorkspace workspace;
+    WorkspaceScope scope(workspace_buffers(workspace), params_);
+    encrypt_message_into(&matrix_A_trans, nullptr, public_key, message, r_seed, e1_seed, e2_seed, scope.buffers());
+    // Copying moves the result out of the arena before the scope wipes it
+    return PolyVec(scope.buffers().ciphertext_colors);
+}
 
-            // Multiply and accumulate
-            __m512i prod_reg = _mm512_mullo_epi32(mat_reg, vec_reg);
-            sum_reg = _mm512_add_epi64(sum_reg, _mm512_cvtepi32_epi64(_mm512_extracti32x4_epi32(prod_reg, 0)));
-        }
 
-        // Reduce modulo q
-        uint64_t total_sum = 0;
-        uint32_t sum_vals[16];
-        _mm512_storeu_si512(reinterpret_cast<__m512i*>(sum_vals), sum_reg);
-        for (uint32_t val : sum_vals) {
-            total_sum = (total_sum + val) % modulus;
-        }
+void ColorKEM::encrypt_noise_into(const PolyMatrix* matrix_A_trans,
+                                  const std::array<uint8_t, 32>* matrix_seed,
+                                  const PolyVec& public_key,
+                                  const std::array<uint8_t, 32>& r_seed,
+                                  const std::array<uint8_t, 32>& e1_seed,
+                                  const std::array<uint8_t, 32>& e2_seed,
+                                  KemWorkspace::Buffers& workspace) const {
 
-        result[i] = ColorValue::from_math_value(total_sum);
+    // Validate matrix_A_trans dimensions
+    if (matrix_A_trans != nullptr && matrix_A_trans->rank() != params_.module_rank) {
+        throw std::invalid_argument("Invalid matrix_A_trans rank: expected " + std::to_string(params_.module_rank) + ", got " + std::to_string(matrix_A_trans->rank()));
     }
 
-    return result;
-}
-#endif
+    // Validate public_key size
+    if (public_key.rank() != params_.module_rank) {
+        throw std::invalid_argument("Invalid public_key size: expected " + std::to_string(params_.module_rank) + ", got " + std::to_string(public_key.rank()));
+    }
 
-#ifdef HAVE_AVX2
-std::vector<ColorValue> ColorKEM::matrix_vector_mul_avx2(const std::vector<std::vector<ColorValue>>& matrix,
-                                                        const std::vector<uint32_t>& vector,
-                                                        uint32_t modulus) const {
-    uint32_t k = params_.module_rank;
-    std::vector<ColorValue> result(k);
+    encrypt_c1_into(matrix_A_trans, matrix_seed, r_seed, e1_seed, &e2_seed, workspace);
+    encrypt_c2_into(public_key, workspace);
+}
 
-    for (uint32_t i = 0; i < k; ++i) {
-        uint64_t sum = 0;
-
-        // Process in chunks that fit in SIMD registers
-        for (uint32_t j = 0; j < k; j += 8) {
-            uint32_t chunk_size = std::min(8u, k - j);
-
-            // Load vector chunk
-            __m256i vec_chunk = _mm256_setzero_si256();
-            if (chunk_size >= 4) {
-                vec_chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&vector[j]));
-            } else {
-                uint32_t vec_vals[8] = {0};
-                for (uint32_t idx = 0; idx < chunk_size; ++idx) {
-                    vec_vals[idx] = vector[j + idx];
-                }
-                vec_chunk = _mm256_loadu_si256(reinterpret_cast<__m256i*>(vec_vals));
-            }
 
-            // Load matrix row chunk
-            uint32_t mat_vals[8] = {0};
-            for (uint32_t idx = 0; idx < chunk_size; ++idx) {
-                mat_vals[idx] = matrix[i][j + idx].to_math_value();
-            }
-            __m256i mat_chunk = _mm256_loadu_si256(reinterpret_cast<__m256i*>(mat_vals));
+void ColorKEM::encrypt_c1_ntt_into(const PolyMatrix* matrix_A_trans,
+                                   const std::array<uint8_t, 32>* matrix_seed,
+                                   const std::array<uint8_t, 32>& r_seed,
+                                   const std::array<uint8_t, 32>& e1_seed,
+                                   const std::array<uint8_t, 32>* e2_seed,
+                                   KemWorkspace::Buffers& workspace) const {
+    sample_encryption_noise(r_seed, e1_seed, e2_seed, workspace);
 
-            // Multiply
-            __m256i prod_chunk = _mm256_mullo_epi32(mat_chunk, vec_chunk);
+    PolyVec& A_trans_r = workspace.A_trans_r;
+    if (matrix_A_trans != nullptr) {
+        matrix_vector_mul(*matrix_A_trans, workspace.r, A_trans_r);
+    } else {
+        matrix_vector_mul_streamed(*matrix_seed, workspace.r, true, workspace.matrix_line, A_trans_r);
+    }
+}
 
-            // Accumulate (extract and add to sum)
-            uint32_t prod_vals[8];
-            _mm256_storeu_si256(reinterpret_cast<__m256i*>(prod_vals), prod_chunk);
-            for (uint32_t idx = 0; idx < chunk_size; ++idx) {
-                sum = (sum + prod_vals[idx]) % modulus;
-            }
-        }
 
-        result[i] = ColorValue::from_math_value(sum);
+void ColorKEM::sample_encryption_noise(const std::array<uint8_t, 32>& r_seed,
+                                       const std::array<uint8_t, 32>& e1_seed,
+                                       const std::array<uint8_t, 32>* e2_seed,
+                                       KemWorkspace::Buffers& workspace) const {
+    // r, e1 and the single e2 polynomial come from one batched pass over the noise seeds;
+    // r is only used as r_hat, so it is transformed on its way out of the sampler
+    PolyVec& r_vector = workspace.r;
+    PolyVec& e1_vector = workspace.e1;
+    NoiseBatch& requests = workspace.noise_requests;
+    requests.clear();
+    for (uint32_t i = 0; i < params_.module_rank; ++i) {
+        requests.push_back({&r_seed, static_cast<uint8_t>(i), true, r_vector[i]});
+        requests.push_back({&e1_seed, static_cast<uint8_t>(i), false, e1_vector[i]});
+    }
+    if (e2_seed != nullptr) {
+        requests.push_back({e2_seed, 0, false, workspace.e2.data()});
     }
+    sample_noise_batch(params_, params_.eta2, requests.requests, requests.count, workspace.noise,
+                       *color_ntt_engine_);
+}
 
-    return result;
+
+void ColorKEM::encrypt_c1_into(const PolyMatrix* matrix_A_trans,
+                               const std::array<uint8_t, 32>* matrix_seed,
+                               const std::array<uint8_t, 32>& r_seed,
+                               const std::array<uint8_t, 32>& e1_seed,
+                               const std::array<uint8_t, 32>* e2_seed,
+                               KemWorkspace::Buffers& workspace) const {
+    encrypt_c1_ntt_into(matrix_A_trans, matrix_seed, r_seed, e1_seed, e2_seed, workspace);
+    PolyVec& A_trans_r = workspace.A_trans_r;
+    ntt_inverse_vector(A_trans_r);
+    // c1 = A^T r + e1, the first k polynomials of the ciphertext
+    poly_add(A_trans_r.data(), workspace.e1.data(), workspace.ciphertext_colors.data(), A_trans_r.coeff_count(),
+             params_.modulus);
 }
 
-std::vector<ColorValue> ColorKEM::matrix_transpose_vector_mul_avx2(const std::vector<std::vector<ColorValue>>& matrix,
-                                                                  const std::vector<uint32_t>& vector,
-                                                                  uint32_t modulus) const {
-    uint32_t k = params_.module_rank;
-    std::vector<ColorValue> result(k);
 
-    // Load vector into AVX2 register
-    __m256i vec_reg = _mm256_setzero_si256();
-    uint32_t* vec_ptr = const_cast<uint32_t*>(vector.data());
-    vec_reg = _mm256_loadu_si256(reinterpret_cast<__m256i*>(vec_ptr));
+void ColorKEM::encrypt_c2_into(const PolyVec& public_key, KemWorkspace::Buffers& workspace) const {
+    const PolyVec& r_vector = workspace.r;
+    const ColorValue* e2 = workspace.e2.data();
 
-    for (uint32_t i = 0; i < k; ++i) {
-        __m256i sum_reg = _mm256_setzero_si256();
+    // A sparse c2 keeps only the constant term, so the full inner product is skipped
+    uint32_t c2_coeffs = params_.sparse_c2 ? 1 : params_.degree;
+    Poly& inner_product_poly = workspace.inner_product;
+    if (params_.sparse_c2) {
+        inner_product_poly[0] = ColorValue::from_math_value(constant_term_ntt(public_key, r_vector));
+    } else {
+        polyvec_basemul_acc(*color_ntt_engine_, public_key, r_vector, inner_product_poly.data());
+        ntt_inverse_poly(inner_product_poly.data());
+    }
+
+    // c2 = t^T r + e2; the caller adds the message
+    ColorValue* c2 = workspace.ciphertext_colors[params_.module_rank];
+    poly_add(inner_product_poly.data(), e2, c2, c2_coeffs, params_.modulus);
+    // Untransmitted coefficients of a sparse c2 stay zero, as in a parsed ciphertext
+    std::fill(c2 + c2_coeffs, c2 + params_.degree, ColorValue::from_math_value(0));
+}
 
-        // Process matrix column in chunks of 8 elements
-        for (uint32_t j = 0; j < k; j += 8) {
-            uint32_t remaining = std::min(8u, k - j);
 
-            // Load matrix column elements (transposed access)
-            __m256i mat_reg = _mm256_setzero_si256();
-            uint32_t mat_vals[8] = {0};
-            for (uint32_t idx = 0; idx < remaining; ++idx) {
-                mat_vals[idx] = matrix[j + idx][i].to_math_value();
-            }
-            mat_reg = _mm256_loadu_si256(reinterpret_cast<__m256i*>(mat_vals));
+void ColorKEM::add_message(const ColorValue& message, PolyVec& ciphertext) const {
+    // c2 += m * q/2 * x^0; the other coefficients carry zero bits that decapsulation
+    // checks before accepting the message
+    ColorValue* c2 = ciphertext[params_.module_rank];
+    uint32_t encoded_m = message.to_math_value() * (params_.modulus / 2);
+    c2[0] = ColorValue::from_math_value(reducer_.reduce(c2[0].to_math_value() + encoded_m));
+}
 
-            // Multiply and accumulate
-            __m256i prod_reg = _mm256_mullo_epi32(mat_reg, vec_reg);
-            sum_reg = _mm256_add_epi32(sum_reg, prod_reg);
-        }
 
-        // Reduce modulo q
-        uint32_t sum_vals[8];
-        _mm256_storeu_si256(reinterpret_cast<__m256i*>(sum_vals), sum_reg);
-        uint64_t total_sum = 0;
-        for (uint32_t val : sum_vals) {
-            total_sum = (total_sum + val) % modulus;
-        }
+void ColorKEM::encrypt_message_into(const PolyMatrix* matrix_A_trans,
+                                    const std::array<uint8_t, 32>* matrix_seed,
+                                    const PolyVec& public_key,
+                                    const ColorValue& message,
+                                    const std::array<uint8_t, 32>& r_seed,
+                                    const std::array<uint8_t, 32>& e1_seed,
+                                    const std::array<uint8_t, 32>& e2_seed,
+                                    KemWorkspace::Buffers& workspace) const {
+    CLWE_TRACE_SPAN("encrypt");
 
-        result[i] = ColorValue::from_math_value(total_sum);
+    // Validate message value is within modulus
+    if (message.to_math_value() >= params_.modulus) {
+        throw std::invalid_argument("Invalid message value: must be less than modulus " + std::to_string(params_.modulus));
     }
 
-    return result;
+    encrypt_noise_into(matrix_A_trans, matrix_seed, public_key, r_seed, e1_seed, e2_seed, workspace);
+    add_message(message, workspace.ciphertext_colors);
 }
-#endif
 
-#ifdef HAVE_NEON
-// NEON implementations commented out due to compilation issues
-std::vector<ColorValue> ColorKEM::matrix_vector_mul_neon(const std::vector<std::vector<ColorValue>>& matrix,
-                                                        const std::vector<uint32_t>& vector,
-                                                        uint32_t modulus) const {
-    // Fallback to scalar implementation
-    std::vector<ColorValue> result(matrix.size());
-    for (size_t i = 0; i < matrix.size(); ++i) {
-        uint64_t sum = 0;
-        for (size_t j = 0; j < vector.size(); ++j) {
-            sum = (sum + (uint64_t)matrix[i][j].to_math_value() * vector[j]) % modulus;
-        }
-        result[i] = ColorValue::from_math_value(sum);
-    }
-    return result;
-}
 
-std::vector<ColorValue> ColorKEM::matrix_transpose_vector_mul_neon(const std::vector<std::vector<ColorValue>>& matrix,
-                                                                  const std::vector<uint32_t>& vector,
-                                                                  uint32_t modulus) const {
-    // Fallback to scalar implementation
-    std::vector<ColorValue> result(matrix.size());
-    for (size_t i = 0; i < matrix.size(); ++i) {
-        uint64_t sum = 0;
-        for (size_t j = 0; j < vector.size(); ++j) {
-            sum = (sum + (uint64_t)matrix[j][i].to_math_value() * vector[j]) % modulus;
-        }
-        result[i] = ColorValue::from_math_value(sum);
-    }
-    return result;
+void ColorKEM::encrypt_key_message_into(const PolyMatrix* matrix_A_trans,
+                                        const std::array<uint8_t, 32>* matrix_seed,
+                                        const PolyVec& public_key,
+                                        const std::array<uint8_t, 32>& message,
+                                        const std::array<uint8_t, 32>& r_seed,
+                                        const std::array<uint8_t, 32>& e1_seed,
+                                        const std::array<uint8_t, 32>& e2_seed,
+                                        uint8_t* ciphertext_data,
+                                        KemWorkspace::Buffers& workspace) const {
+    CLWE_TRACE_SPAN("encrypt");
+    if (matrix_A_trans != nullptr && matrix_A_trans->rank() != params_.module_rank) {
+        throw std::invalid_argument("Invalid matrix_A_trans rank: expected " + std::to_string(params_.module_rank) + ", got " + std::to_string(matrix_A_trans->rank()));
+    }
+    if (public_key.rank() != params_.module_rank) {
+        throw std::invalid_argument("Invalid public_key size: expected " + std::to_string(params_.module_rank) + ", got " + std::to_string(public_key.rank()));
+    }
+    encrypt_c1_ntt_into(matrix_A_trans, matrix_seed, r_seed, e1_seed, &e2_seed, workspace);
+    polyvec_basemul_acc(*color_ntt_engine_, public_key, workspace.r, workspace.inner_product.data());
+
+    // e2 += sum of bit_i * q/2 * x^i, one message bit per coefficient, selected by mask, so
+    // that c2 = t^T r + e2 needs no pass of its own after the inverse NTT
+    ColorValue* e2 = workspace.e2.data();
+    uint32_t q_half = params_.modulus / 2;
+    for (uint32_t d = 0; d < KEY_MESSAGE_BITS; ++d) {
+        uint32_t bit = (message[d / 8] >> (d % 8)) & 1;
+        uint32_t e2_val = reducer_.add(reducer_.reduce(e2[d].to_math_value()), (0u - bit) & q_half);
+        e2[d] = ColorValue::from_math_value(e2_val);
+    }
+
+    // The key mode never has a sparse c2, so both parts are whole polynomials
+    CLWE_TRACE_SPAN("pack_ciphertext");
+    SlowStageTimer slow_stage(SlowStage::PACK);
+    size_t c1_count = static_cast<size_t>(params_.module_rank) * params_.degree;
+    uint32_t c1_bits = compressed(params_) ? params_.du : 0;
+    uint32_t c2_bits = compressed(params_) ? params_.dv : 0;
+    const uint32_t* c1_raw = color_ntt_engine_->ntt_inverse_colors_batch_raw(workspace.A_trans_r.data(),
+                                                                             params_.module_rank);
+    poly_scale_add_encode(c1_raw, degree_inv_, workspace.e1.data(), c1_count, params_.modulus, params_.encoding,
+                          c1_bits, ciphertext_data);
+    size_t c1_bytes = c1_bits != 0 ? compressed_coefficients_size(c1_count, c1_bits)
+                                   : encoded_coefficients_size(c1_count, params_.encoding);
+    // The c2 transform reuses the scratch the c1 stage has finished reading
+    const uint32_t* c2_raw = color_ntt_engine_->ntt_inverse_colors_batch_raw(workspace.inner_product.data(), 1);
+    poly_scale_add_encode(c2_raw, degree_inv_, e2, params_.degree, params_.modulus, params_.encoding, c2_bits,
+                          ciphertext_data + c1_bytes);
 }
-#endif
 
 }
\ No newline at end of file
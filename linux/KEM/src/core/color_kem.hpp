@@ -3,29 +3,134 @@
 
 #include "color_value.hpp"
 #include "color_ntt_engine.hpp"
+#include "poly.hpp"
 #include "cpu_features.hpp"
 #include "clwe/clwe.hpp"
+#include "clwe/random_source.hpp"
+#include "clwe/page_allocation.hpp"
+#include "clwe/batch_device.hpp"
 #include <vector>
 #include <array>
+#include <memory>
+#include <list>
+#include <mutex>
+#include <functional>
+#include <utility>
 
 namespace clwe {
 
+class DecapsulationContext;
+class KeygenOp;
+class KemArena;
+class SHAKE256Sampler;
+class SparseTernaryVec;
+class KemBufferPool;
+struct BufferPoolState;
+
 // Key structures for Color KEM
 struct ColorPublicKey {
     std::array<uint8_t, 32> seed;
     std::vector<uint8_t> public_data;
     CLWEParameters params;
 
+    ColorPublicKey() = default;
+    ColorPublicKey(const std::array<uint8_t, 32>& s, std::vector<uint8_t> pd, const CLWEParameters& p)
+        : seed(s), public_data(std::move(pd)), params(p) {}
+    // Copies share the memoized serialized form
+    ColorPublicKey(const ColorPublicKey& other);
+    ColorPublicKey& operator=(const ColorPublicKey& other);
+    ColorPublicKey(ColorPublicKey&&) = default;
+    ColorPublicKey& operator=(ColorPublicKey&&) = default;
+    ~ColorPublicKey();
+
+    // Key with public_data sized for pool.params() from the calling thread's free list;
+    // the buffer goes back to the pool when the key is destroyed (clwe/buffer_pool.hpp)
+    static ColorPublicKey acquire(KemBufferPool& pool);
+
     std::vector<uint8_t> serialize() const;
     static ColorPublicKey deserialize(const std::vector<uint8_t>& data, const CLWEParameters& params);
+
+    // Caller-buffer variants; serialize returns the bytes written
+    static size_t serialized_size(const CLWEParameters& params);
+    // 32, or 0 for shared_matrix parameters, whose keys take the seed from the installed matrix
+    static size_t seed_bytes(const CLWEParameters& params);
+    size_t serialize(uint8_t* out, size_t out_size) const;
+    // Throws std::logic_error for shared_matrix parameters without an installed matrix
+    static ColorPublicKey deserialize(const uint8_t* data, size_t size, const CLWEParameters& params);
+
+    // deserialize() as a code, allocation-free on error; out keeps its capacity.
+    // INVALID_PARAMETERS: shared_matrix parameters without an installed matrix
+    static CLWEError try_deserialize(const uint8_t* data, size_t size, const CLWEParameters& params,
+                                     ColorPublicKey& out) noexcept;
+
+    // serialize() bytes and H(pk), built on first use and kept with the key. Every call checks
+    // the memo against the fields and rebuilds it after a modification; references stay valid
+    // until the key is modified or destroyed.
+    const std::vector<uint8_t>& serialized() const;
+    const std::array<uint8_t, 32>& fingerprint() const;
+
+private:
+    struct SerializedForm;
+    const SerializedForm& serialized_form() const;
+
+    // Read and published atomically: const calls on one key may race to build it
+    mutable std::shared_ptr<const SerializedForm> serialized_;
+    // Pool public_data returns to on destruction; null for keys not acquired from one
+    std::shared_ptr<BufferPoolState> pool_;
 };
 
 struct ColorPrivateKey {
     std::vector<uint8_t> secret_data;
     CLWEParameters params;
 
+    ColorPrivateKey() = default;
+    ColorPrivateKey(std::vector<uint8_t> sd, const CLWEParameters& p)
+        : secret_data(std::move(sd)), params(p) {}
+
     std::vector<uint8_t> serialize() const;
     static ColorPrivateKey deserialize(const std::vector<uint8_t>& data);
+    static ColorPrivateKey deserialize(const std::vector<uint8_t>& data, const CLWEParameters& params);
+
+    // Caller-buffer variants; serialize returns the bytes written
+    static size_t serialized_size(const CLWEParameters& params);
+    size_t serialize(uint8_t* out, size_t out_size) const;
+    static ColorPrivateKey deserialize(const uint8_t* data, size_t size, const CLWEParameters& params);
+    static CLWEError try_deserialize(const uint8_t* data, size_t size, const CLWEParameters& params,
+                                     ColorPrivateKey& out) noexcept;
+};
+
+// Seed-only private key: the 32-byte d that keygen_derand(d) expanded, instead of k*n
+// coefficients. ColorKEM regenerates s_hat from it on load. Wire format: d; the parameters
+// are not stored, as for ColorPrivateKey
+struct ColorCompactPrivateKey {
+    static constexpr size_t BYTES = 32;
+
+    std::array<uint8_t, 32> seed{};
+    CLWEParameters params;
+
+    std::vector<uint8_t> serialize() const;
+    static ColorCompactPrivateKey deserialize(const std::vector<uint8_t>& data, const CLWEParameters& params);
+    static ColorCompactPrivateKey deserialize(const uint8_t* data, size_t size, const CLWEParameters& params);
+};
+
+// Private key with the packed public key and H(pk) = SHAKE-256(serialized pk) embedded, as
+// FIPS 203's decapsulation key, so decapsulation needs nothing else.
+// Wire format: secret data || public key || H(pk); deserialize checks the hash
+struct ColorExpandedPrivateKey {
+    std::vector<uint8_t> secret_data;
+    ColorPublicKey public_key;
+    std::array<uint8_t, 32> public_key_hash{};
+    CLWEParameters params;
+
+    std::vector<uint8_t> serialize() const;
+    static ColorExpandedPrivateKey deserialize(const std::vector<uint8_t>& data, const CLWEParameters& params);
+
+    // Caller-buffer variants; serialize returns the bytes written
+    static size_t serialized_size(const CLWEParameters& params);
+    size_t serialize(uint8_t* out, size_t out_size) const;
+    static ColorExpandedPrivateKey deserialize(const uint8_t* data, size_t size, const CLWEParameters& params);
+    static CLWEError try_deserialize(const uint8_t* data, size_t size, const CLWEParameters& params,
+                                     ColorExpandedPrivateKey& out) noexcept;
 };
 
 struct ColorCiphertext {
@@ -33,66 +138,358 @@ struct ColorCiphertext {
     std::vector<uint8_t> shared_secret_hint;
     CLWEParameters params;
 
+    ColorCiphertext() = default;
+    ColorCiphertext(std::vector<uint8_t> cd, std::vector<uint8_t> ssh, const CLWEParameters& p)
+        : ciphertext_data(std::move(cd)), shared_secret_hint(std::move(ssh)), params(p) {}
+    ColorCiphertext(const ColorCiphertext&) = default;
+    ColorCiphertext& operator=(const ColorCiphertext&) = default;
+    ColorCiphertext(ColorCiphertext&&) = default;
+    ColorCiphertext& operator=(ColorCiphertext&&) = default;
+    ~ColorCiphertext();
+
+    // Ciphertext with both buffers sized for pool.params() from the calling thread's free
+    // list; they go back to the pool when it is destroyed (clwe/buffer_pool.hpp)
+    static ColorCiphertext acquire(KemBufferPool& pool);
+
     std::vector<uint8_t> serialize() const;
     static ColorCiphertext deserialize(const std::vector<uint8_t>& data);
+    static ColorCiphertext deserialize(const std::vector<uint8_t>& data, const CLWEParameters& params);
+
+    // Caller-buffer variants; serialize returns the bytes written
+    static size_t serialized_size(const CLWEParameters& params);
+    size_t serialize(uint8_t* out, size_t out_size) const;
+    static ColorCiphertext deserialize(const uint8_t* data, size_t size, const CLWEParameters& params);
+    static CLWEError try_deserialize(const uint8_t* data, size_t size, const CLWEParameters& params,
+                                     ColorCiphertext& out) noexcept;
+
+private:
+    // Pool the buffers return to on destruction; null for ciphertexts not acquired from one
+    std::shared_ptr<BufferPoolState> pool_;
 };
 
+// Non-owning ciphertext view into a ColorCiphertext or a serialized buffer; the memory must outlive it
+struct ColorCiphertextView {
+    const uint8_t* ciphertext_data = nullptr;
+    size_t ciphertext_size = 0;
+    const uint8_t* shared_secret_hint = nullptr;  // 4 bytes
+    CLWEParameters params;
+
+    ColorCiphertextView() = default;
+    explicit ColorCiphertextView(const ColorCiphertext& ciphertext);
+
+    // Serialized layout: ciphertext data followed by the 4-byte hint
+    static ColorCiphertextView parse(const uint8_t* data, size_t size, const CLWEParameters& params);
+    static CLWEError try_parse(const uint8_t* data, size_t size, const CLWEParameters& params,
+                               ColorCiphertextView& out) noexcept;
+};
+
+// Non-owning view of a public key (a ColorPublicKey or a KeyStore record); public_data is
+// laid out per encoding, which may differ from params.encoding
+struct ColorPublicKeyView {
+    const uint8_t* seed = nullptr;  // 32 bytes
+    const uint8_t* public_data = nullptr;
+    size_t public_data_size = 0;
+    CoefficientEncoding encoding = CoefficientEncoding::COLOR32;
+    CLWEParameters params;
+
+    ColorPublicKeyView() = default;
+    explicit ColorPublicKeyView(const ColorPublicKey& public_key);
+};
+
+// 32-byte shared secret of the 256-bit mode, SHAKE256(m, H(ct)); compares in constant time
+struct SharedSecret {
+    static constexpr size_t BYTES = 32;
+
+    std::array<uint8_t, BYTES> bytes{};
+
+    const uint8_t* data() const { return bytes.data(); }
+    uint8_t* data() { return bytes.data(); }
+    static constexpr size_t size() { return BYTES; }
+
+    bool operator==(const SharedSecret& other) const {
+        uint8_t difference = 0;
+        for (size_t i = 0; i < BYTES; ++i) {
+            difference |= static_cast<uint8_t>(bytes[i] ^ other.bytes[i]);
+        }
+        return difference == 0;
+    }
+    bool operator!=(const SharedSecret& other) const { return !(*this == other); }
+};
+
+// Public key with A_hat expanded and t_hat parsed, reusable across encapsulations
+struct ExpandedPublicKey {
+    std::array<uint8_t, 32> seed;
+    std::vector<uint8_t> public_data;
+    CLWEParameters params;
+    std::shared_ptr<const PolyMatrix> matrix_A;  // A_hat^T, row-major, as encapsulation reads it
+    std::shared_ptr<const PolyVec> public_key_colors;
+    bool coefficients_reduced = false;  // t_hat passed the modulus check when parsed
+};
+
+// Deployment-wide A of CLWEParameters::shared_matrix sets, expanded once in both orders
+struct SharedMatrix {
+    std::array<uint8_t, 32> seed;
+    std::shared_ptr<const PolyMatrix> matrix_A;        // A_hat, row-major, as keygen reads it
+    std::shared_ptr<const PolyMatrix> matrix_A_trans;  // A_hat^T, row-major, as encapsulation reads it
+};
+
+// Private key with s_hat parsed and validated once, reusable across decapsulations
+struct PreparedPrivateKey {
+    CLWEParameters params;
+    std::shared_ptr<const PolyVec> secret_key_colors;
+    // With secret_weight, s as sparse slots; null for keys that are not fixed-weight ternary
+    std::shared_ptr<const SparseTernaryVec> sparse_secret;
+};
+
+// Message-independent half of one encapsulation to a known public key, built ahead of time
+// by ColorKEM::precompute_encapsulation(): c1 already packed, c2 = t^T r + e2 without the
+// message, and the shared secret. Single use and move-only; encapsulate_online() consumes
+// it, and it is wiped when consumed or destroyed
+class EncapsulationBundle {
+public:
+    EncapsulationBundle() = default;
+    ~EncapsulationBundle();
+    EncapsulationBundle(EncapsulationBundle&& other) noexcept;
+    EncapsulationBundle& operator=(EncapsulationBundle&& other) noexcept;
+    EncapsulationBundle(const EncapsulationBundle&) = delete;
+    EncapsulationBundle& operator=(const EncapsulationBundle&) = delete;
+
+    // False once consumed, and for default-constructed or moved-from bundles
+    bool ready() const { return ready_; }
+    const CLWEParameters& params() const { return params_; }
+
+private:
+    friend class ColorKEM;
+    void wipe();
+
+    CLWEParameters params_;
+    std::vector<uint8_t> ciphertext_data_;  // Whole ciphertext; c1 is written, c2 is not
+    std::vector<ColorValue> c2_;            // t^T r + e2 over the transmitted coefficients
+    ColorValue shared_secret_;
+    bool ready_ = false;
+};
+
+// Parallel-for hook: runs task(0) .. task(count - 1), possibly concurrently, and returns
+// once all have finished. ColorKEM may invoke it from several threads at once.
+using KemExecutor = std::function<void(size_t count, const std::function<void(size_t)>& task)>;
+
+// Receives a serialized ciphertext (ColorCiphertext::serialize() bytes) in consecutive
+// pieces; the bytes are only valid during the call
+using CiphertextSink = std::function<void(const uint8_t* data, size_t size)>;
+
+// Scratch for ColorKEM operations: polynomials, noise requests and sampler buffers,
+// carved from one KemArena per operation and securely wiped when it ends. One operation
+// at a time per workspace; once warm, encapsulate_into() and prepared-key decapsulate()
+// allocate nothing
+class KemWorkspace {
+public:
+    KemWorkspace();
+    ~KemWorkspace();
+
+    KemWorkspace(KemWorkspace&&) noexcept;
+    KemWorkspace& operator=(KemWorkspace&&) noexcept;
+    KemWorkspace(const KemWorkspace&) = delete;
+    KemWorkspace& operator=(const KemWorkspace&) = delete;
+
+    // Arena bytes reserved so far; grows to the largest operation served
+    size_t reserved_bytes() const;
+    // Pages the arena sits on, from page_policy() when it last grew
+    PageBacking page_backing() const;
+
+    // Arena bytes one operation carves at rank k and degree n: the polynomials, with room
+    // for all of A (with_matrix) or one row of it, 2k + 1 noise requests and the noise
+    // sampler buffers. The implementation checks its types against the constants below.
+    static constexpr size_t ARENA_ALIGNMENT = 64;
+    static constexpr size_t NOISE_REQUEST_BYTES = 3 * sizeof(void*);
+    static constexpr size_t NOISE_SHAKE_RATE = 136;  // SHAKE-256 rate
+    static constexpr size_t NOISE_CBD_BYTES = 48;    // Stream bytes per 64 coefficients at eta = 3
+    static constexpr size_t arena_bytes(uint32_t k, uint32_t n, bool with_matrix) {
+        const size_t poly = arena_block(n * sizeof(ColorValue));
+        const size_t vec = arena_block(static_cast<size_t>(k) * n * sizeof(ColorValue));
+        const size_t matrix = with_matrix ? arena_block(static_cast<size_t>(k) * k * n * sizeof(ColorValue)) : vec;
+        const size_t ciphertext = arena_block(static_cast<size_t>(k + 1) * n * sizeof(ColorValue));
+        const size_t noise_stream = 4 * ((n / 64 * NOISE_CBD_BYTES + NOISE_SHAKE_RATE - 1) / NOISE_SHAKE_RATE) *
+                                    NOISE_SHAKE_RATE;
+        return matrix + 7 * vec + 3 * poly + ciphertext + arena_block(n * sizeof(uint32_t)) +
+               arena_block(noise_stream) + arena_block((2 * static_cast<size_t>(k) + 1) * NOISE_REQUEST_BYTES);
+    }
+
+    // Defined by the implementation: polynomials carved from one arena per operation
+    struct Buffers;
+
+private:
+    friend class ColorKEM;
+    std::unique_ptr<Buffers> buffers_;
+
+    static constexpr size_t arena_block(size_t bytes) { return (bytes + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1); }
+};
+
+// Heap one operation takes, in bytes. The workspace arena is reserved on a workspace's
+// first use and reused afterwards; output is the key or ciphertext data returned;
+// expanded_key is the A_hat, t_hat and public data an encapsulation adds to the
+// expanded-key cache on a miss, not counting the cache's list node and control blocks.
+struct KemOperationMemory {
+    size_t workspace_bytes = 0;
+    size_t output_bytes = 0;
+    size_t expanded_key_bytes = 0;
+
+    constexpr size_t heap_bytes() const { return workspace_bytes + output_bytes + expanded_key_bytes; }
+};
+
+// Worst case of each operation for one parameter set, from ColorKEM::memory_requirements()
+struct KemMemoryRequirements {
+    KemOperationMemory keygen;
+    KemOperationMemory encapsulate;
+    KemOperationMemory decapsulate;
+    size_t stack_bytes = 0;  // Bound on the stack of any operation on the calling thread
+
+    // Arena of one KemWorkspace that serves all three operations
+    constexpr size_t workspace_bytes() const {
+        size_t bytes = keygen.workspace_bytes;
+        bytes = encapsulate.workspace_bytes > bytes ? encapsulate.workspace_bytes : bytes;
+        return decapsulate.workspace_bytes > bytes ? decapsulate.workspace_bytes : bytes;
+    }
+};
+
+// Every operation is const and safe to call concurrently on one instance: scratch
+// lives in the caller's KemWorkspace or, for the overloads without one, a per-thread
+// workspace, and the expanded-key cache is guarded by its mutex
 class ColorKEM {
 private:
     CLWEParameters params_;
-    std::unique_ptr<ColorNTTEngine> color_ntt_engine_;
-
-    std::vector<std::vector<std::vector<ColorValue>>> generate_matrix_A(const std::array<uint8_t, 32>& seed) const;
-    std::vector<std::vector<ColorValue>> generate_secret_key(uint32_t eta) const;
-    std::vector<std::vector<ColorValue>> generate_error_vector(uint32_t eta) const;
-    std::vector<std::vector<ColorValue>> generate_public_key(const std::vector<std::vector<ColorValue>>& secret_key,
-                                                const std::vector<std::vector<std::vector<ColorValue>>>& matrix_A,
-                                                const std::vector<std::vector<ColorValue>>& error_vector) const;
-    std::vector<std::vector<ColorValue>> encrypt_message(const std::vector<std::vector<std::vector<ColorValue>>>& matrix_A,
-                                           const std::vector<std::vector<ColorValue>>& public_key,
-                                           const ColorValue& message) const;
-    ColorValue decrypt_message(const std::vector<std::vector<ColorValue>>& secret_key,
-                              const std::vector<std::vector<ColorValue>>& ciphertext) const;
-
-    std::vector<std::vector<ColorValue>> matrix_vector_mul(const std::vector<std::vector<std::vector<ColorValue>>>& matrix,
-                                              const std::vector<std::vector<ColorValue>>& vector) const;
-    std::vector<std::vector<ColorValue>> matrix_transpose_vector_mul(const std::vector<std::vector<std::vector<ColorValue>>>& matrix,
-                                                        const std::vector<std::vector<ColorValue>>& vector) const;
-
-    // SIMD-accelerated matrix operations
-    std::vector<std::vector<ColorValue>> matrix_vector_mul_simd(const std::vector<std::vector<std::vector<ColorValue>>>& matrix,
-                                                   const std::vector<std::vector<ColorValue>>& vector) const;
-    std::vector<std::vector<ColorValue>> matrix_transpose_vector_mul_simd(const std::vector<std::vector<std::vector<ColorValue>>>& matrix,
-                                                            const std::vector<std::vector<ColorValue>>& vector) const;
-
-#ifdef HAVE_AVX512
-    std::vector<ColorValue> matrix_vector_mul_avx512(const std::vector<std::vector<ColorValue>>& matrix,
-                                                    const std::vector<uint32_t>& vector,
-                                                    uint32_t modulus) const;
-    std::vector<ColorValue> matrix_transpose_vector_mul_avx512(const std::vector<std::vector<ColorValue>>& matrix,
-                                                              const std::vector<uint32_t>& vector,
-                                                              uint32_t modulus) const;
-#endif
-
-#ifdef HAVE_AVX2
-    std::vector<ColorValue> matrix_vector_mul_avx2(const std::vector<std::vector<ColorValue>>& matrix,
-                                                  const std::vector<uint32_t>& vector,
-                                                  uint32_t modulus) const;
-    std::vector<ColorValue> matrix_transpose_vector_mul_avx2(const std::vector<std::vector<ColorValue>>& matrix,
-                                                            const std::vector<uint32_t>& vector,
-                                                            uint32_t modulus) const;
-#endif
-
-#ifdef HAVE_NEON
-    std::vector<ColorValue> matrix_vector_mul_neon(const std::vector<std::vector<ColorValue>>& matrix,
-                                                  const std::vector<uint32_t>& vector,
-                                                  uint32_t modulus) const;
-    std::vector<ColorValue> matrix_transpose_vector_mul_neon(const std::vector<std::vector<ColorValue>>& matrix,
-                                                            const std::vector<uint32_t>& vector,
-                                                            uint32_t modulus) const;
-#endif
-
-    // CPU feature detection
+    std::shared_ptr<const ColorNTTEngine> color_ntt_engine_;  // Shared per (q, n)
+    uint32_t degree_inv_;  // n^(-1) mod q, undoes the scaling left by the inverse NTT
+    // Precomputed at construction so per-call validation is a few integer compares
+    uint64_t params_fingerprint_;
+    size_t polyvec_bytes_;     // k polynomials: private key data
+    size_t public_key_bytes_;  // Public key data: polyvec_bytes_, or less when t is rounded
+    size_t ciphertext_bytes_;  // Ciphertext data without the hint
+    BarrettReducer reducer_;   // Division-free mod q for the per-coefficient loops
+
+    bool matches_parameters(const CLWEParameters& params) const { return params.fingerprint() == params_fingerprint_; }
+
+    // A_hat, or with transposed A_hat^T in row order, as encapsulation consumes it
+    PolyMatrix generate_matrix_A(const std::array<uint8_t, 32>& seed, bool transposed = false) const;
+    void generate_matrix_A(const std::array<uint8_t, 32>& seed, PolyMatrix& matrix, bool transposed = false) const;
+    // Expand count <= 4 cells (i * k + j) of A into polys on the 4-way Keccak
+    void expand_matrix_cells(const std::array<uint8_t, 32>& seed, const uint32_t* cells,
+                             ColorValue* const* polys, uint32_t count) const;
+    // A_hat o vector (A_hat^T o vector when transpose) with A streamed from seed one row
+    // (column) at a time through line, which holds k polynomials
+    void matrix_vector_mul_streamed(const std::array<uint8_t, 32>& seed, const PolyVec& vector, bool transpose,
+                                    PolyVec& line, PolyVec& result) const;
+    // Row i of A (column i when transpose) into line, k polynomials
+    void expand_matrix_line(const std::array<uint8_t, 32>& seed, uint32_t i, bool transpose, PolyVec& line) const;
+    PolyVec sample_noise_vector(uint32_t eta, const std::array<uint8_t, 32>& seed) const;
+    PolyVec generate_secret_key(uint32_t eta) const;
+    PolyVec generate_error_vector(uint32_t eta) const;
+    // Deterministic versions for KATs
+    PolyVec generate_secret_key_deterministic(uint32_t eta, const std::array<uint8_t, 32>& seed) const;
+    PolyVec generate_error_vector_deterministic(uint32_t eta, const std::array<uint8_t, 32>& seed) const;
+    void generate_public_key(const PolyVec& secret_key,
+                             const PolyMatrix& matrix_A,
+                             const PolyVec& error_vector,
+                             PolyVec& public_key) const;
+    // public_key += error_vector, coefficient-wise mod q
+    void add_error_vector(const PolyVec& error_vector, PolyVec& public_key) const;
+    PolyVec encrypt_message(const PolyMatrix& matrix_A_trans,
+                            const PolyVec& public_key,
+                            const ColorValue& message) const;
+    PolyVec encrypt_message_deterministic(const PolyMatrix& matrix_A_trans,
+                                          const PolyVec& public_key,
+                                          const ColorValue& message,
+                                          const std::array<uint8_t, 32>& r_seed,
+                                          const std::array<uint8_t, 32>& e1_seed,
+                                          const std::array<uint8_t, 32>& e2_seed) const;
+    // Same, leaving c1 || c2 in workspace.ciphertext_colors; matrix_A_trans is A_hat^T as
+    // generate_matrix_A(seed, true) lays it out, and a null one streams A from *matrix_seed
+    void encrypt_message_into(const PolyMatrix* matrix_A_trans,
+                              const std::array<uint8_t, 32>* matrix_seed,
+                              const PolyVec& public_key,
+                              const ColorValue& message,
+                              const std::array<uint8_t, 32>& r_seed,
+                              const std::array<uint8_t, 32>& e1_seed,
+                              const std::array<uint8_t, 32>& e2_seed,
+                              KemWorkspace::Buffers& workspace) const;
+    // c1 and c2 = t^T r + e2 without any message, for the two encrypt_*_into() variants
+    void encrypt_noise_into(const PolyMatrix* matrix_A_trans,
+                            const std::array<uint8_t, 32>* matrix_seed,
+                            const PolyVec& public_key,
+                            const std::array<uint8_t, 32>& r_seed,
+                            const std::array<uint8_t, 32>& e1_seed,
+                            const std::array<uint8_t, 32>& e2_seed,
+                            KemWorkspace::Buffers& workspace) const;
+    // r_hat and A^T r, still in NTT domain, into workspace.A_trans_r; e1 and e2 as for encrypt_c1_into()
+    void encrypt_c1_ntt_into(const PolyMatrix* matrix_A_trans,
+                             const std::array<uint8_t, 32>* matrix_seed,
+                             const std::array<uint8_t, 32>& r_seed,
+                             const std::array<uint8_t, 32>& e1_seed,
+                             const std::array<uint8_t, 32>* e2_seed,
+                             KemWorkspace::Buffers& workspace) const;
+    // r_hat and e1 into the workspace, and e2 when e2_seed is non-null
+    void sample_encryption_noise(const std::array<uint8_t, 32>& r_seed,
+                                 const std::array<uint8_t, 32>& e1_seed,
+                                 const std::array<uint8_t, 32>* e2_seed,
+                                 KemWorkspace::Buffers& workspace) const;
+    // r_hat and c1 = A^T r + e1 into the workspace; e2 as well when e2_seed is non-null
+    void encrypt_c1_into(const PolyMatrix* matrix_A_trans,
+                         const std::array<uint8_t, 32>* matrix_seed,
+                         const std::array<uint8_t, 32>& r_seed,
+                         const std::array<uint8_t, 32>& e1_seed,
+                         const std::array<uint8_t, 32>* e2_seed,
+                         KemWorkspace::Buffers& workspace) const;
+    // c2 = t^T r + e2 from the r_hat and e2 encrypt_c1_into() left in the workspace
+    void encrypt_c2_into(const PolyVec& public_key, KemWorkspace::Buffers& workspace) const;
+    // c2[0] += message * q/2
+    void add_message(const ColorValue& message, PolyVec& ciphertext) const;
+    // Same as encrypt_message_into(), spreading the 256 message bits over c2[0..255] and
+    // writing the serialized c1 || c2 to ciphertext_data: each inverse NTT goes straight to
+    // poly_scale_add_encode(), so the ciphertext never exists as colors
+    void encrypt_key_message_into(const PolyMatrix* matrix_A_trans,
+                                  const std::array<uint8_t, 32>* matrix_seed,
+                                  const PolyVec& public_key,
+                                  const std::array<uint8_t, 32>& message,
+                                  const std::array<uint8_t, 32>& r_seed,
+                                  const std::array<uint8_t, 32>& e1_seed,
+                                  const std::array<uint8_t, 32>& e2_seed,
+                                  uint8_t* ciphertext_data,
+                                  KemWorkspace::Buffers& workspace) const;
+    // padding_valid is false when any non-constant coefficient fails to decode to zero
+    ColorValue decrypt_message(const PolyVec& secret_key,
+                              const PolyVec& ciphertext,
+                              bool& padding_valid) const;
+    // Same, with caller-provided scratch for c1_hat and s^T c1
+    ColorValue decrypt_message_into(const PolyVec& secret_key,
+                                    const PolyVec& ciphertext,
+                                    PolyVec& c1_hat,
+                                    Poly& s_dot_c1_poly,
+                                    bool& padding_valid) const;
+    // Reads the 256 message bits back from c2[0..255]
+    void decrypt_key_message_into(const PolyVec& secret_key,
+                                  const PolyVec& ciphertext,
+                                  PolyVec& c1_hat,
+                                  Poly& s_dot_c1_poly,
+                                  std::array<uint8_t, 32>& message) const;
+    // s^T c1 into s_dot_c1_poly (only its constant term for a sparse c2)
+    void decrypt_inner_product(const PolyVec& secret_key,
+                               const PolyVec& ciphertext,
+                               PolyVec& c1_hat,
+                               Poly& s_dot_c1_poly) const;
+
+    // NTT-domain arithmetic: A, s and t are kept as A_hat, s_hat and t_hat
+    PolyVec matrix_vector_mul(const PolyMatrix& matrix, const PolyVec& vector) const;
+    void matrix_vector_mul(const PolyMatrix& matrix, const PolyVec& vector, PolyVec& result) const;
+    PolyVec matrix_transpose_vector_mul(const PolyMatrix& matrix, const PolyVec& vector) const;
+    void matrix_transpose_vector_mul(const PolyMatrix& matrix, const PolyVec& vector, PolyVec& result) const;
+    PolyVec ntt_forward_vector(const PolyVec& vector) const;
+    // Inverse NTT including the n^(-1) scaling
+    void ntt_inverse_poly(ColorValue* poly) const;
+    void ntt_inverse_vector(PolyVec& vector) const;
+    Poly inner_product_ntt(const PolyVec& a_hat, const PolyVec& b_hat) const;
+    // Constant term of the product of two NTT-domain vectors, without an inverse NTT
+    uint32_t constant_term_ntt(const PolyVec& a_hat, const PolyVec& b_hat) const;
+
+    // CPU features the kernels dispatch on, after any forced backend
     CPUFeatures cpu_features_;
 
     ColorValue generate_shared_secret() const;
@@ -100,29 +497,427 @@ private:
     ColorValue decode_color_secret(const std::vector<uint8_t>& encoded) const;
 
 public:
+    // Throws std::logic_error if params.shared_matrix is set and no matrix is installed
     ColorKEM(const CLWEParameters& params = CLWEParameters());
     ~ColorKEM();
 
+    // Expands the deployment A of params' (rank, degree, modulus, XOF) shape once and
+    // registers it for shared_matrix instances. Reinstalling the same seed returns the
+    // installed matrix; a different seed throws std::logic_error. Thread-safe.
+    static std::shared_ptr<const SharedMatrix> install_shared_matrix(const CLWEParameters& params,
+                                                                     const std::array<uint8_t, 32>& seed);
+    // The installed matrix for params' shape, or nullptr
+    static std::shared_ptr<const SharedMatrix> find_shared_matrix(const CLWEParameters& params);
+
     ColorKEM(const ColorKEM&) = delete;
     ColorKEM& operator=(const ColorKEM&) = delete;
 
-    std::pair<ColorPublicKey, ColorPrivateKey> keygen();
+    std::pair<ColorPublicKey, ColorPrivateKey> keygen() const;
 
-    std::pair<ColorCiphertext, ColorValue> encapsulate(const ColorPublicKey& public_key);
+    std::pair<ColorCiphertext, ColorValue> encapsulate(const ColorPublicKey& public_key) const;
 
     ColorValue decapsulate(const ColorPublicKey& public_key,
                            const ColorPrivateKey& private_key,
-                           const ColorCiphertext& ciphertext);
+                           const ColorCiphertext& ciphertext) const;
 
     bool verify_keypair(const ColorPublicKey& public_key, const ColorPrivateKey& private_key) const;
 
-private:
-    ColorValue hash_ciphertext(const ColorCiphertext& ciphertext) const;
+    // Deterministic key generation (for KATs)
+    std::pair<ColorPublicKey, ColorPrivateKey> keygen_deterministic(const std::array<uint8_t, 32>& matrix_seed,
+                                                                   const std::array<uint8_t, 32>& secret_seed,
+                                                                   const std::array<uint8_t, 32>& error_seed) const;
+
+    // Deterministic encapsulation (for KATs)
+    std::pair<ColorCiphertext, ColorValue> encapsulate_deterministic(const ColorPublicKey& public_key,
+                                                                    const std::array<uint8_t, 32>& r_seed,
+                                                                    const std::array<uint8_t, 32>& e1_seed,
+                                                                    const std::array<uint8_t, 32>& e2_seed,
+                                                                    const ColorValue& shared_secret) const;
+
+    // Derandomized entry points: one 32-byte seed expanded with SHAKE-256 under a
+    // per-operation domain byte; keygen() and encapsulate() draw it and call these
+    std::pair<ColorPublicKey, ColorPrivateKey> keygen_derand(const std::array<uint8_t, 32>& d) const;
+    std::pair<ColorCiphertext, ColorValue> encapsulate_derand(const ColorPublicKey& public_key,
+                                                              const std::array<uint8_t, 32>& m) const;
+
+    // Batch operations; results match keygen_derand/encapsulate_derand with the seed drawn for each entry
+    std::vector<std::pair<ColorPublicKey, ColorPrivateKey>> keygen_batch(size_t count) const;
+    std::vector<std::pair<ColorCiphertext, ColorValue>> encapsulate_batch(const std::vector<ColorPublicKey>& public_keys) const;
+
+    // Device provisioning from a master secret: keygen_derand() of derive_device_seed(), which is
+    // SHAKE-256(0x44 || params fingerprint || master_seed || device_id), both integers
+    // little-endian. The batch derives the seeds four at a time on the multi-lane Keccak and
+    // runs keygen as keygen_batch() does; it throws std::invalid_argument if the ids overflow
+    std::array<uint8_t, 32> derive_device_seed(const std::array<uint8_t, 32>& master_seed, uint64_t device_id) const;
+    std::pair<ColorPublicKey, ColorPrivateKey> derive_keypair(const std::array<uint8_t, 32>& master_seed,
+                                                              uint64_t device_id) const;
+    std::vector<std::pair<ColorPublicKey, ColorPrivateKey>> derive_keypair_batch(
+        const std::array<uint8_t, 32>& master_seed, uint64_t first_device_id, size_t count) const;
+
+    // One secret to several recipients; keys sharing a matrix seed share r, A and c1, each
+    // paying only t_i^T r with its own e2. Throws std::invalid_argument if public_keys is
+    // empty or any key is invalid.
+    std::pair<std::vector<ColorCiphertext>, ColorValue> encapsulate_multi(
+        const std::vector<ColorPublicKey>& public_keys) const;
+    std::pair<std::vector<ColorCiphertext>, ColorValue> encapsulate_multi_derand(
+        const std::vector<ColorPublicKey>& public_keys, const std::array<uint8_t, 32>& m) const;
+    std::pair<std::vector<ColorCiphertext>, ColorValue> encapsulate_multi_derand(
+        const std::vector<ColorPublicKey>& public_keys, const std::array<uint8_t, 32>& m,
+        KemWorkspace& workspace) const;
+    std::vector<ColorValue> decapsulate_batch(const std::vector<ColorPublicKey>& public_keys,
+                                              const std::vector<ColorPrivateKey>& private_keys,
+                                              const std::vector<ColorCiphertext>& ciphertexts) const;
+
+    // Expanded public keys; encapsulate(const ColorPublicKey&) keeps a bounded LRU cache of them
+    static constexpr size_t DEFAULT_EXPANDED_KEY_CACHE_CAPACITY = 16;
+    ExpandedPublicKey expand_public_key(const ColorPublicKey& public_key) const;
+    std::pair<ColorCiphertext, ColorValue> encapsulate(const ExpandedPublicKey& public_key) const;
+    // Reads t_hat from the view and expands A from its seed, bypassing the expanded-key cache
+    std::pair<ColorCiphertext, ColorValue> encapsulate(const ColorPublicKeyView& public_key) const;
+    void set_expanded_key_cache_capacity(size_t capacity);
+    size_t expanded_key_cache_size() const;
+
+    // Matrix A expansion (per group of four cells) and the matrix-vector products (per
+    // output row) run on executor when module_rank >= min_rank; an empty executor keeps
+    // everything serial. Not synchronized with running operations: configure before sharing.
+    static constexpr uint32_t DEFAULT_PARALLEL_MIN_RANK = 3;
+    void set_executor(KemExecutor executor, uint32_t min_rank = DEFAULT_PARALLEL_MIN_RANK);
+
+    // Keygen and encapsulation to a ColorPublicKey expand A one row (column for A^T) at a
+    // time and consume it at once: k polynomials of A live instead of k^2, and the
+    // expanded-key cache is bypassed. Byte-identical output; streamed rows run serially.
+    // Ignored (always false) for shared_matrix instances, which never expand A.
+    // Not synchronized with running operations: configure before sharing.
+    void set_matrix_streaming(bool enabled);
+    bool matrix_streaming() const { return matrix_streaming_; }
+
+    // Every seed the instance draws (keygen, encapsulate, the batch calls) comes from
+    // source; nullptr restores default_random_source(). Not synchronized with running
+    // operations: configure before sharing.
+    void set_random_source(std::shared_ptr<RandomSource> source);
+    const std::shared_ptr<RandomSource>& random_source() const { return random_source_; }
+
+    // keygen_batch and encapsulate_batch run their lattice core on device (per config) when
+    // the kernels cover the parameters, byte-identical to the CPU path. Throws
+    // std::invalid_argument if device is unavailable or config has a zero launch size or
+    // stream count. Not synchronized with running operations: configure before sharing.
+    void set_batch_device(BatchDevice device, const GpuBatchConfig& config = GpuBatchConfig());
+    BatchDevice batch_device() const { return batch_device_; }
+
+    // Stack bound of keygen, encapsulate and decapsulate: polynomials live in the
+    // workspace, so only sampler states and seeds are on the stack, at every level
+    static constexpr size_t MAX_STACK_BYTES = 32 * 1024;
+
+    // Exact heap per operation for rank k, degree n and the given serialized data sizes
+    // (public_data, secret_data, ciphertext_data); constexpr for compile-time budgets
+    static constexpr KemMemoryRequirements memory_requirements(uint32_t k, uint32_t n, size_t public_data_bytes,
+                                                               size_t secret_data_bytes, size_t ciphertext_data_bytes,
+                                                               bool matrix_streaming = false) {
+        KemMemoryRequirements requirements;
+        requirements.keygen.workspace_bytes = KemWorkspace::arena_bytes(k, n, !matrix_streaming);
+        requirements.keygen.output_bytes = public_data_bytes + secret_data_bytes;
+        requirements.encapsulate.workspace_bytes = KemWorkspace::arena_bytes(k, n, false);
+        requirements.encapsulate.output_bytes = ciphertext_data_bytes + 4;
+        requirements.encapsulate.expanded_key_bytes =
+            matrix_streaming ? 0 : (static_cast<size_t>(k) * k + k) * n * sizeof(ColorValue) + public_data_bytes;
+        requirements.decapsulate.workspace_bytes = KemWorkspace::arena_bytes(k, n, false);
+        requirements.stack_bytes = MAX_STACK_BYTES;
+        return requirements;
+    }
+    // The same for params and its wire encoding and compression
+    static KemMemoryRequirements memory_requirements(const CLWEParameters& params, bool matrix_streaming = false);
+    // For this instance's parameters and matrix_streaming() setting
+    KemMemoryRequirements memory_requirements() const { return memory_requirements(params_, matrix_streaming_); }
+
+    // NTT/basemul backend in use; follows CLWE_FORCE_BACKEND, CPUFeatureDetector::force_backend
+    // and, for instances constructed after it, set_ntt_backend
+    SIMDSupport backend() const;
+
+    // Prepared private keys skip key parsing and validation on every decapsulation
+    PreparedPrivateKey prepare_private_key(const ColorPrivateKey& private_key) const;
+
+    // Seed-only private keys: keygen_compact() returns keygen_derand(d)'s public key with d,
+    // and loading regenerates s_hat in NTT domain from d in one batched CBD pass over the
+    // multi-lane Keccak. Both give the private key keygen_derand(d) returned; prepare skips
+    // its packing. Throw std::invalid_argument on other parameters
+    std::pair<ColorPublicKey, ColorCompactPrivateKey> keygen_compact() const;
+    ColorPrivateKey expand_compact_private_key(const ColorCompactPrivateKey& private_key) const;
+    PreparedPrivateKey prepare_private_key(const ColorCompactPrivateKey& private_key) const;
+    ColorValue decapsulate(const PreparedPrivateKey& private_key, const ColorCiphertext& ciphertext) const;
+    ColorValue decapsulate(const PreparedPrivateKey& private_key, const ColorCiphertextView& ciphertext) const;
+
+    // Expanded private keys embed pk and H(pk): decapsulation without the public key,
+    // with the same results as the (pk, sk) overloads
+    ColorExpandedPrivateKey expand_private_key(const ColorPublicKey& public_key,
+                                               const ColorPrivateKey& private_key) const;
+    ColorValue decapsulate(const ColorExpandedPrivateKey& private_key, const ColorCiphertext& ciphertext) const;
+    ColorValue decapsulate(const ColorExpandedPrivateKey& private_key, const ColorCiphertext& ciphertext,
+                           KemWorkspace& workspace) const;
+
+    // Explicit-workspace variants: same results as the overloads above, with all scratch
+    // taken from workspace instead of the calling thread's
+    std::pair<ColorPublicKey, ColorPrivateKey> keygen(KemWorkspace& workspace) const;
+    std::pair<ColorPublicKey, ColorPrivateKey> keygen_derand(const std::array<uint8_t, 32>& d,
+                                                             KemWorkspace& workspace) const;
+    std::pair<ColorCiphertext, ColorValue> encapsulate(const ColorPublicKey& public_key, KemWorkspace& workspace) const;
+    std::pair<ColorCiphertext, ColorValue> encapsulate_derand(const ColorPublicKey& public_key,
+                                                              const std::array<uint8_t, 32>& m,
+                                                              KemWorkspace& workspace) const;
+    ColorValue decapsulate(const ColorPublicKey& public_key,
+                           const ColorPrivateKey& private_key,
+                           const ColorCiphertext& ciphertext,
+                           KemWorkspace& workspace) const;
+    ColorValue decapsulate(const PreparedPrivateKey& private_key, const ColorCiphertext& ciphertext,
+                           KemWorkspace& workspace) const;
+    ColorValue decapsulate(const PreparedPrivateKey& private_key, const ColorCiphertextView& ciphertext,
+                           KemWorkspace& workspace) const;
+    // Encapsulation seeded as encapsulate_derand(), written into ciphertext; reusing the
+    // ciphertext and a warm workspace makes it allocation-free
+    ColorValue encapsulate_into(const ExpandedPublicKey& public_key,
+                                const std::array<uint8_t, 32>& m,
+                                ColorCiphertext& ciphertext,
+                                KemWorkspace& workspace) const;
+    ColorValue encapsulate_into(const ColorPublicKeyView& public_key,
+                                const std::array<uint8_t, 32>& m,
+                                ColorCiphertext& ciphertext,
+                                KemWorkspace& workspace) const;
+    // Offline/online encapsulation: count bundles, each with its own random m, holding all
+    // of an encapsulation's sampling and matrix work; encapsulate_online() then only adds
+    // the message to c2, packs it and hands over the ciphertext, the same as
+    // encapsulate_derand() with that m would have produced. Color mode only
+    std::vector<EncapsulationBundle> precompute_encapsulation(const ColorPublicKey& public_key,
+                                                              size_t count) const;
+    std::vector<EncapsulationBundle> precompute_encapsulation(const ExpandedPublicKey& public_key,
+                                                              size_t count) const;
+    std::pair<ColorCiphertext, ColorValue> encapsulate_online(EncapsulationBundle& bundle) const;
+    // Reusing the ciphertext makes it allocation-free: it swaps buffers with the bundle
+    ColorValue encapsulate_online(EncapsulationBundle& bundle, ColorCiphertext& ciphertext) const;
+    // Encapsulation seeded as encapsulate_derand() that hands the serialized ciphertext to
+    // sink while it is computed: each c1 polynomial once its row of A^T r is done, then c2,
+    // then the hint. Needs c1 polynomials that end on byte boundaries; allocation-free once
+    // the workspace is warm (and, for a ColorPublicKey, its expansion is cached)
+    ColorValue encapsulate_streamed(const ColorPublicKey& public_key, const CiphertextSink& sink) const;
+    ColorValue encapsulate_streamed(const ColorPublicKey& public_key, const std::array<uint8_t, 32>& m,
+                                    const CiphertextSink& sink, KemWorkspace& workspace) const;
+    ColorValue encapsulate_streamed(const ExpandedPublicKey& public_key, const std::array<uint8_t, 32>& m,
+                                    const CiphertextSink& sink, KemWorkspace& workspace) const;
+
+    // 256-bit mode, as ML-KEM: the 32-byte seed m is spread one bit per coefficient of
+    // c2, the shared secret is SHAKE256(m, H(ct)) and decapsulation confirms it by
+    // re-encryption.
+    // Needs degree >= KEY_MESSAGE_BITS and no sparse_c2.
+    static constexpr uint32_t KEY_MESSAGE_BITS = 256;
+    std::pair<ColorCiphertext, SharedSecret> encapsulate_key(const ColorPublicKey& public_key) const;
+    std::pair<ColorCiphertext, SharedSecret> encapsulate_key(const ColorPublicKey& public_key,
+                                                             KemWorkspace& workspace) const;
+    std::pair<ColorCiphertext, SharedSecret> encapsulate_key_derand(const ColorPublicKey& public_key,
+                                                                    const std::array<uint8_t, 32>& m) const;
+    std::pair<ColorCiphertext, SharedSecret> encapsulate_key_derand(const ColorPublicKey& public_key,
+                                                                    const std::array<uint8_t, 32>& m,
+                                                                    KemWorkspace& workspace) const;
+    SharedSecret decapsulate_key(const ColorPublicKey& public_key,
+                                 const ColorPrivateKey& private_key,
+                                 const ColorCiphertext& ciphertext) const;
+    SharedSecret decapsulate_key(const ColorPublicKey& public_key,
+                                 const ColorPrivateKey& private_key,
+                                 const ColorCiphertext& ciphertext,
+                                 KemWorkspace& workspace) const;
+    SharedSecret decapsulate_key(const ColorExpandedPrivateKey& private_key, const ColorCiphertext& ciphertext) const;
+    SharedSecret decapsulate_key(const ColorExpandedPrivateKey& private_key, const ColorCiphertext& ciphertext,
+                                 KemWorkspace& workspace) const;
+    // Key-mode encapsulation to a view, writing ColorCiphertext::serialized_size(params) bytes
+    // (the serialize() form) to ciphertext_out; allocation-free with a warm workspace
+    SharedSecret encapsulate_key_into(const ColorPublicKeyView& public_key, uint8_t* ciphertext_out,
+                                      size_t ciphertext_out_size, KemWorkspace& workspace) const;
+    SharedSecret encapsulate_key_into(const ColorPublicKeyView& public_key, const std::array<uint8_t, 32>& m,
+                                      uint8_t* ciphertext_out, size_t ciphertext_out_size,
+                                      KemWorkspace& workspace) const;
+    SharedSecret decapsulate_key(const ColorExpandedPrivateKey& private_key, const ColorCiphertextView& ciphertext,
+                                 KemWorkspace& workspace) const;
+
+    // Key-mode operations that return a CLWEError instead of throwing: the validation runs
+    // first without allocating, and only failures inside the operation are caught and
+    // mapped. Malformed ciphertexts never throw: bad shapes are refused, bad content is
+    // implicitly rejected. shared_key is zeroed on error
+    CLWEError try_encapsulate_key(const ColorPublicKey& public_key, ColorCiphertext& ciphertext,
+                                  SharedSecret& shared_key) const noexcept;
+    CLWEError try_encapsulate_key(const ColorPublicKey& public_key, ColorCiphertext& ciphertext,
+                                  SharedSecret& shared_key, KemWorkspace& workspace) const noexcept;
+    CLWEError try_encapsulate_key_into(const ColorPublicKeyView& public_key, uint8_t* ciphertext_out,
+                                       size_t ciphertext_out_size, SharedSecret& shared_key,
+                                       KemWorkspace& workspace) const noexcept;
+    CLWEError try_decapsulate_key(const ColorExpandedPrivateKey& private_key, const ColorCiphertextView& ciphertext,
+                                  SharedSecret& shared_key) const noexcept;
+    CLWEError try_decapsulate_key(const ColorExpandedPrivateKey& private_key, const ColorCiphertextView& ciphertext,
+                                  SharedSecret& shared_key, KemWorkspace& workspace) const noexcept;
 
     const CLWEParameters& params() const { return params_; }
 
-    static std::vector<uint8_t> color_secret_to_bytes(const ColorValue& secret);
-    static ColorValue bytes_to_color_secret(const std::vector<uint8_t>& bytes);
+private:
+    // DecapsulationContext runs decapsulate_expanded() one polynomial at a time
+    friend class DecapsulationContext;
+
+    ColorValue hash_ciphertext(const ColorCiphertextView& ciphertext) const;
+    // Implicit-rejection value from a finalized SHAKE-256 stream over the serialized ciphertext
+    ColorValue rejection_secret(SHAKE256Sampler& shake) const;
+    // Message bit of v = c2 - s^T c1; padding_valid is false unless every other transmitted
+    // coefficient decodes as zero
+    ColorValue decode_message(const ColorValue* c2, const ColorValue* s_dot_c1, bool& padding_valid) const;
+    // Fujisaki-Okamoto selection: recovered when it matches hint and the padding is valid,
+    // rejection otherwise, in constant time
+    ColorValue select_decapsulated_secret(const ColorValue& recovered, bool padding_valid, const uint8_t* hint,
+                                          const ColorValue& rejection) const;
+
+    // Workspace buffers sized for this instance's parameters
+    KemWorkspace::Buffers& workspace_buffers(KemWorkspace& workspace) const;
+
+    // Key generation/encapsulation/decapsulation after seed expansion, key validation and expansion
+    std::pair<ColorPublicKey, ColorPrivateKey> keygen_expanded(const std::array<uint8_t, 32>& matrix_seed,
+                                                               const std::array<uint8_t, 32>& secret_seed,
+                                                               const std::array<uint8_t, 32>& error_seed,
+                                                               KemWorkspace::Buffers& workspace) const;
+    // KeygenOp runs keygen_expanded() in bounded steps through these and the helpers above
+    friend class KeygenOp;
+    // The matrix, secret and error seeds keygen_derand(d) expands d into
+    void expand_keygen_seed(const std::array<uint8_t, 32>& d, std::array<uint8_t, 32>& matrix_seed,
+                            std::array<uint8_t, 32>& secret_seed, std::array<uint8_t, 32>& error_seed) const;
+    // s_hat[index] (secret) or e_hat[index] of keygen_expanded() into out; scratch is reset
+    // and carved, so it needs keygen_noise_scratch_bytes() of capacity
+    void sample_keygen_noise(const std::array<uint8_t, 32>& seed, uint8_t index, bool secret, ColorValue* out,
+                             KemArena& scratch) const;
+    static size_t keygen_noise_scratch_bytes(uint32_t degree);
+    // s_hat of keygen_derand(d) into secret, sampled with workspace's noise buffers
+    void regenerate_secret(const std::array<uint8_t, 32>& d, PolyVec& secret, KemWorkspace::Buffers& workspace) const;
+    // Sparse slots of prepared's s for fixed-weight ternary sets; left null for other keys
+    void attach_sparse_secret(PreparedPrivateKey& prepared) const;
+    ColorValue encapsulate_expanded(const PolyMatrix* matrix_A_trans,
+                                    const std::array<uint8_t, 32>* matrix_seed,
+                                    const PolyVec& public_key_colors,
+                                    const std::array<uint8_t, 32>& r_seed,
+                                    const std::array<uint8_t, 32>& e1_seed,
+                                    const std::array<uint8_t, 32>& e2_seed,
+                                    const ColorValue& shared_secret,
+                                    ColorCiphertext& ciphertext,
+                                    KemWorkspace::Buffers& workspace) const;
+    // encapsulate_expanded() handing each c1 polynomial to sink as its row of A^T r is done
+    ColorValue encapsulate_expanded_streamed(const PolyMatrix* matrix_A_trans,
+                                             const std::array<uint8_t, 32>* matrix_seed,
+                                             const PolyVec& public_key_colors,
+                                             const std::array<uint8_t, 32>& r_seed,
+                                             const std::array<uint8_t, 32>& e1_seed,
+                                             const std::array<uint8_t, 32>& e2_seed,
+                                             const ColorValue& shared_secret,
+                                             const CiphertextSink& sink,
+                                             KemWorkspace::Buffers& workspace) const;
+    // One bundle of precompute_encapsulation() with a fresh m: c1 packed, c2 before the message
+    void precompute_bundle(const PolyMatrix* matrix_A_trans, const std::array<uint8_t, 32>* matrix_seed,
+                           const PolyVec& public_key_colors, EncapsulationBundle& bundle,
+                           KemWorkspace::Buffers& workspace) const;
+    // Encapsulation to an unexpanded key: through the expanded-key cache, or streaming A
+    ColorValue encapsulate_public_key(const ColorPublicKey& public_key,
+                                      const std::array<uint8_t, 32>& r_seed,
+                                      const std::array<uint8_t, 32>& e1_seed,
+                                      const std::array<uint8_t, 32>& e2_seed,
+                                      const ColorValue& shared_secret,
+                                      ColorCiphertext& ciphertext,
+                                      KemWorkspace& workspace) const;
+    // encapsulate_key_derand() into ciphertext, resized in place
+    SharedSecret encapsulate_key_derand_into(const ColorPublicKey& public_key, const std::array<uint8_t, 32>& m,
+                                             ColorCiphertext& ciphertext, KemWorkspace& workspace) const;
+    // 256-bit encapsulation after key validation and expansion; returns the shared key.
+    // Writes the ciphertext_bytes_ of encoded polynomials to ciphertext_data and the zero
+    // hint to hint
+    SharedSecret encapsulate_key_expanded(const PolyMatrix* matrix_A_trans,
+                                          const std::array<uint8_t, 32>* matrix_seed,
+                                          const PolyVec& public_key_colors,
+                                          const std::array<uint8_t, 32>& m,
+                                          uint8_t* ciphertext_data,
+                                          uint8_t* hint,
+                                          KemWorkspace::Buffers& workspace) const;
+    // The same into ciphertext, resized in place
+    SharedSecret encapsulate_key_expanded(const PolyMatrix* matrix_A_trans,
+                                          const std::array<uint8_t, 32>* matrix_seed,
+                                          const PolyVec& public_key_colors,
+                                          const std::array<uint8_t, 32>& m,
+                                          ColorCiphertext& ciphertext,
+                                          KemWorkspace::Buffers& workspace) const;
+    // Throws std::invalid_argument unless the parameters can carry a 256-bit message
+    void validate_key_message_mode() const;
+    // The validate_*() conditions as codes, for the try_*() functions; the validators
+    // format their messages only once one of these has failed
+    CLWEError check_key_message_mode() const noexcept;
+    CLWEError check_public_key(const ColorPublicKey& public_key) const noexcept;
+    CLWEError check_public_key(const ColorPublicKeyView& public_key) const noexcept;
+    CLWEError check_private_key(const CLWEParameters& params, const std::vector<uint8_t>& secret_data) const noexcept;
+    CLWEError check_ciphertext(const ColorCiphertextView& ciphertext) const noexcept;
+    // decapsulate_key() after mode and key validation; checks the ciphertext
+    SharedSecret decapsulate_key_validated(const ColorPublicKey& public_key, const std::vector<uint8_t>& secret_data,
+                                           const ColorCiphertextView& ciphertext, KemWorkspace& workspace) const;
+    // Throws std::invalid_argument unless the private key matches this instance in parameters and size
+    void validate_private_key(const CLWEParameters& params, const std::vector<uint8_t>& secret_data) const;
+    // Throws std::invalid_argument unless a key-mode ciphertext matches this instance in parameters and size
+    void validate_ciphertext(const ColorCiphertextView& ciphertext) const;
+    // A non-null sparse_secret (the same s) replaces the NTT inner product with sparse passes
+    ColorValue decapsulate_expanded(const PolyVec& secret_key_colors, const ColorCiphertext& ciphertext,
+                                    KemWorkspace::Buffers& workspace,
+                                    const SparseTernaryVec* sparse_secret = nullptr) const;
+    ColorValue decapsulate_expanded(const PolyVec& secret_key_colors, const ColorCiphertextView& ciphertext,
+                                    KemWorkspace::Buffers& workspace,
+                                    const SparseTernaryVec* sparse_secret = nullptr) const;
+
+    // Coefficient (de)serialization in the parameters' wire encoding
+    // Resizes bytes to the exact encoded size (reusing its capacity) and packs polys in one pass
+    static void encode_polyvec(const PolyVec& polys, CoefficientEncoding encoding, std::vector<uint8_t>& bytes);
+    static PolyVec bytes_to_polyvec(const std::vector<uint8_t>& bytes, uint32_t rank, uint32_t degree,
+                                    CoefficientEncoding encoding);
+    // Decodes polys.coeff_count() * 4 bytes into an existing vector
+    static void decode_polyvec(const uint8_t* bytes, PolyVec& polys, CoefficientEncoding encoding);
+    // decode_polyvec for public data (t_hat, an uncompressed ciphertext): throws
+    // std::invalid_argument naming what unless every coefficient is below q
+    void decode_public_polyvec(const uint8_t* bytes, PolyVec& polys, CoefficientEncoding encoding,
+                               const char* what) const;
+    // Public key data from t_hat: encode_polyvec, or with t_dropped_bits t1 of the
+    // coefficient-domain t, leaving t_hat holding t. Either way decode_public_key_data()
+    // gives t_hat back, rounded.
+    void encode_public_key_data(PolyVec& t_hat, std::vector<uint8_t>& bytes) const;
+    void decode_public_key_data(const uint8_t* bytes, PolyVec& t_hat, CoefficientEncoding encoding) const;
+    // Ciphertext polynomials, with du/dv compression when the parameters enable it
+    std::vector<uint8_t> ciphertext_to_bytes(const PolyVec& ciphertext) const;
+    void encode_ciphertext(const PolyVec& ciphertext, uint8_t* bytes) const;
+    // Packs ciphertext colors, the secret hint and the parameters into ciphertext
+    void pack_ciphertext(const PolyVec& ciphertext_colors, const ColorValue& shared_secret,
+                         ColorCiphertext& ciphertext) const;
+    // keygen_derand() of each 32-byte seed of seeds, on batch_device_ where it applies
+    std::vector<std::pair<ColorPublicKey, ColorPrivateKey>> keygen_batch_derand(const std::vector<uint8_t>& seeds,
+                                                                                size_t count) const;
+    // keygen_batch/encapsulate_batch with the lattice core on batch_device_; seeds as drawn
+    std::vector<std::pair<ColorPublicKey, ColorPrivateKey>> keygen_batch_offloaded(
+        const std::vector<uint8_t>& seeds, size_t count) const;
+    std::vector<std::pair<ColorCiphertext, ColorValue>> encapsulate_batch_offloaded(
+        const std::vector<ColorPublicKey>& public_keys, const std::vector<uint8_t>& seeds) const;
+    // False if an uncompressed coefficient is not reduced mod q; decapsulation then rejects
+    bool decode_ciphertext(const uint8_t* bytes, PolyVec& ciphertext) const;
+
+    void validate_public_key(const ColorPublicKey& public_key) const;
+    void validate_public_key(const ColorPublicKeyView& public_key) const;
+    // Validates public_key and returns its entry in the expanded-key cache, most recently used first
+    std::shared_ptr<const ExpandedPublicKey> cached_expanded_key(const ColorPublicKey& public_key) const;
+    mutable std::list<std::shared_ptr<const ExpandedPublicKey>> expanded_key_cache_;
+    size_t expanded_key_cache_capacity_;
+    mutable std::mutex expanded_key_cache_mutex_;
+
+    // Runs task(0) .. task(count - 1) on executor_, or inline below the rank threshold.
+    // A template so the inline path never wraps task in a heap-allocated std::function.
+    template <typename Task>
+    void parallel_for(size_t count, const Task& task) const;
+    KemExecutor executor_;
+    uint32_t parallel_min_rank_;
+    bool matrix_streaming_;
+    std::shared_ptr<const SharedMatrix> shared_matrix_;
+    std::shared_ptr<RandomSource> random_source_;
+    BatchDevice batch_device_;
+    GpuBatchConfig batch_config_;
+    void random_bytes(uint8_t* out, size_t len) const;
 };
 
 } // namespace clwe
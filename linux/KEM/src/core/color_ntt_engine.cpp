@@ -1,172 +1,235 @@
 #include "color_ntt_engine.hpp"
 #include "utils.hpp"
+#include "work_counters.hpp"
+#include "clwe/autotune.hpp"
+#include "clwe/numa.hpp"
 #include <algorithm>
-#include <iostream>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <utility>
 
 namespace clwe {
 
 ColorNTTEngine::ColorNTTEngine(uint32_t q, uint32_t n)
-    : NTTEngine(q, n), color_zetas_(n), color_zetas_inv_(n) {
-
-    std::vector<uint32_t> standard_zetas(n);
-    std::vector<uint32_t> standard_zetas_inv(n);
+    : NTTEngine(q, n), backend_(create_optimal_ntt_engine(q, n)) {
+}
+
+std::shared_ptr<const ColorNTTEngine> ColorNTTEngine::shared(uint32_t q, uint32_t n) {
+    static std::mutex mutex;
+    static std::map<std::tuple<uint32_t, uint32_t, size_t, SIMDSupport>, std::shared_ptr<const ColorNTTEngine>>
+        registry;
+    // One copy of the tables per NUMA node, built (and so first touched) by a
+    // thread running there, and per backend, so set_ntt_backend() reaches later instances
+    const size_t node = current_numa_node();
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& engine = registry[{q, n, node, ntt_backend()}];
+    if (!engine) {
+        engine = std::make_shared<const ColorNTTEngine>(q, n);
+    }
+    return engine;
+}
 
-    uint32_t g = (q_ == 3329) ? 17 : 3;
-    uint32_t zeta = mod_pow(g, (q_ - 1) / n_, q_);
+namespace {
 
-    standard_zetas[0] = 1;
-    for (uint32_t i = 1; i < n_; ++i) {
-        standard_zetas[i] = (static_cast<uint64_t>(standard_zetas[i-1]) * zeta) % q_;
-    }
+// Per-thread uint32_t staging for the ColorValue wrappers; it keeps its capacity, so
+// steady-state transforms do not touch the heap
+std::vector<uint32_t>& color_scratch(size_t size) {
+    thread_local std::vector<uint32_t> scratch;
+    scratch.resize(size);
+    return scratch;
+}
 
-    uint32_t zeta_inv = mod_inverse(zeta, q_);
-    standard_zetas_inv[0] = 1;
-    for (uint32_t i = 1; i < n_; ++i) {
-        standard_zetas_inv[i] = (static_cast<uint64_t>(standard_zetas_inv[i-1]) * zeta_inv) % q_;
-    }
+} // namespace
 
-    for (uint32_t i = 0; i < n_; ++i) {
-        color_zetas_[i] = ColorValue::from_math_value(standard_zetas[i]);
-        color_zetas_inv_[i] = ColorValue::from_math_value(standard_zetas_inv[i]);
+void ColorNTTEngine::unpack_colors(const ColorValue* colors, uint32_t* coeffs, size_t count) const {
+    // Backends assume canonical residues
+    colors_to_u32(colors, coeffs, count * n_);
+    for (size_t i = 0; i < count * n_; ++i) {
+        uint32_t v = coeffs[i];
+        coeffs[i] = v < q_ ? v : v % q_;
     }
 }
 
-ColorValue ColorNTTEngine::color_to_crypto_space(const ColorValue& color) const {
-    return color;
+void ColorNTTEngine::ntt_forward_colors(ColorValue* poly) const {
+    std::vector<uint32_t>& coeffs = color_scratch(n_);
+    unpack_colors(poly, coeffs.data());
+    count_work(WorkCounter::NTT_FORWARD, 1);
+    backend_->ntt_forward(coeffs.data());
+    convert_uint32_to_colors(coeffs.data(), poly);
 }
 
-ColorValue ColorNTTEngine::crypto_space_to_color(const ColorValue& crypto_val) const {
-    return crypto_val;
+void ColorNTTEngine::ntt_inverse_colors(ColorValue* poly) const {
+    std::vector<uint32_t>& coeffs = color_scratch(n_);
+    unpack_colors(poly, coeffs.data());
+    count_work(WorkCounter::NTT_INVERSE, 1);
+    backend_->ntt_inverse(coeffs.data());
+    convert_uint32_to_colors(coeffs.data(), poly);
 }
 
-void ColorNTTEngine::color_butterfly(ColorValue& a, ColorValue& b, const ColorValue& zeta, uint32_t modulus) const {
-    ColorValue sum = color_add_precise(a, b, modulus);
-    ColorValue diff = color_subtract_precise(a, b, modulus);
-    ColorValue product = color_multiply_precise(diff, zeta, modulus);
-
-    a = sum;
-    b = product;
+void ColorNTTEngine::ntt_forward_colors_batch(ColorValue* polys, size_t count) const {
+    std::vector<uint32_t>& coeffs = color_scratch(count * n_);
+    unpack_colors(polys, coeffs.data(), count);
+    count_work(WorkCounter::NTT_FORWARD, count);
+    backend_->ntt_forward_batch(coeffs.data(), count);
+    colors_from_u32(coeffs.data(), polys, count * n_);
 }
 
-ColorValue ColorNTTEngine::color_add_precise(const ColorValue& a, const ColorValue& b, uint32_t modulus) const {
-    uint64_t a_val = a.to_precise_value();
-    uint64_t b_val = b.to_precise_value();
-    uint64_t sum = (a_val + b_val) % modulus;
-    return ColorValue::from_precise_value(sum);
+void ColorNTTEngine::ntt_inverse_colors_batch(ColorValue* polys, size_t count) const {
+    std::vector<uint32_t>& coeffs = color_scratch(count * n_);
+    unpack_colors(polys, coeffs.data(), count);
+    count_work(WorkCounter::NTT_INVERSE, count);
+    backend_->ntt_inverse_batch(coeffs.data(), count);
+    colors_from_u32(coeffs.data(), polys, count * n_);
 }
 
-ColorValue ColorNTTEngine::color_subtract_precise(const ColorValue& a, const ColorValue& b, uint32_t modulus) const {
-    uint64_t a_val = a.to_precise_value();
-    uint64_t b_val = b.to_precise_value();
-    uint64_t diff = a_val - b_val;
-    uint64_t borrow_mask = - (uint64_t)(a_val < b_val);
-    diff += borrow_mask & modulus;
-    uint64_t reduce_mask = - (uint64_t)(diff >= modulus);
-    diff -= reduce_mask & modulus;
-    return ColorValue::from_precise_value(diff);
+void ColorNTTEngine::ntt_forward_u32_to_colors(uint32_t* coeffs, ColorValue* polys, size_t count) const {
+    count_work(WorkCounter::NTT_FORWARD, count);
+    backend_->ntt_forward_batch(coeffs, count);
+    colors_from_u32(coeffs, polys, count * n_);
 }
 
-ColorValue ColorNTTEngine::color_multiply_precise(const ColorValue& a, const ColorValue& b, uint32_t modulus) const {
-    uint64_t a_val = a.to_precise_value();
-    uint64_t b_val = b.to_precise_value();
-    uint64_t product = (a_val * b_val) % modulus;
-    return ColorValue::from_precise_value(product);
+const uint32_t* ColorNTTEngine::ntt_inverse_colors_batch_raw(const ColorValue* polys, size_t count) const {
+    std::vector<uint32_t>& coeffs = color_scratch(count * n_);
+    unpack_colors(polys, coeffs.data(), count);
+    count_work(WorkCounter::NTT_INVERSE, count);
+    backend_->ntt_inverse_batch(coeffs.data(), count);
+    return coeffs.data();
 }
 
-void ColorNTTEngine::color_butterfly_inv(ColorValue& a, ColorValue& b, const ColorValue& zeta, uint32_t modulus) const {
-    color_butterfly(a, b, zeta, modulus);
-}
+void ColorNTTEngine::multiply_colors(const ColorValue* a, const ColorValue* b, ColorValue* result) const {
+    // The unpacked copies are the backend's transform buffers
+    std::vector<uint32_t>& coeffs = color_scratch(2 * static_cast<size_t>(n_));
+    uint32_t* a_coeffs = coeffs.data();
+    uint32_t* b_coeffs = a_coeffs + n_;
+
+    unpack_colors(a, a_coeffs);
+    unpack_colors(b, b_coeffs);
+    // Both operands forward, one product, one inverse
+    count_work(WorkCounter::NTT_FORWARD, 2);
+    count_work(WorkCounter::BASEMUL, 1);
+    count_work(WorkCounter::NTT_INVERSE, 1);
+    backend_->multiply_inplace(a_coeffs, b_coeffs);
+    convert_uint32_to_colors(a_coeffs, result);
+}
+
+void ColorNTTEngine::pointwise_multiply_accumulate_colors(const ColorValue* a_hat, const ColorValue* b_hat,
+                                                          ColorValue* acc_hat) const {
+    count_work(WorkCounter::BASEMUL, 1);
+    if (coeff16_supported(q_)) {
+        // Convert in bulk and run the 16-lane kernel instead of three divisions per coefficient
+        thread_local std::vector<Coeff16> scratch;
+        scratch.resize(3 * static_cast<size_t>(n_));
+        Coeff16* a16 = scratch.data();
+        Coeff16* b16 = a16 + n_;
+        Coeff16* acc16 = b16 + n_;
+        colors_to_coeff16(a_hat, a16, n_, q_);
+        colors_to_coeff16(b_hat, b16, n_, q_);
+        colors_to_coeff16(acc_hat, acc16, n_, q_);
+        coeff16_multiply_accumulate(a16, b16, acc16, n_, q_);
+        coeff16_to_colors(acc16, acc_hat, n_);
+        return;
+    }
 
-void ColorNTTEngine::ntt_forward_colors(ColorValue* poly) const {
-    uint32_t m = 1;
-    uint32_t k = n_ / 2;
-
-    for (uint32_t stage = 0; stage < log_degree(); ++stage) {
-        uint32_t j = 0;
-        for (uint32_t i = 0; i < k; ++i) {
-            const ColorValue& zeta = color_zetas_[j];
-            color_butterfly(poly[i], poly[i + k], zeta, modulus());
-            j += m;
-        }
-        m *= 2;
-        k /= 2;
+    for (uint32_t i = 0; i < n_; ++i) {
+        uint64_t product = static_cast<uint64_t>(a_hat[i].to_math_value() % q_) * (b_hat[i].to_math_value() % q_);
+        uint64_t sum = (acc_hat[i].to_math_value() % q_) + product % q_;
+        acc_hat[i] = ColorValue::from_math_value(static_cast<uint32_t>(sum % q_));
     }
 }
 
-void ColorNTTEngine::ntt_inverse_colors(ColorValue* poly) const {
-    uint32_t m = n_ / 2;
-    uint32_t k = 1;
-
-    for (uint32_t stage = 0; stage < log_degree(); ++stage) {
-        uint32_t j = 0;
-        for (uint32_t i = 0; i < k; ++i) {
-            const ColorValue& zeta = color_zetas_inv_[j];
-            color_butterfly_inv(poly[i], poly[i + k], zeta, modulus());
-            j += m;
-        }
-        m /= 2;
-        k *= 2;
+void ColorNTTEngine::row_dot_colors(const ColorValue* a_hat, size_t a_stride, const ColorValue* b_hat, size_t k,
+                                    ColorValue* out_hat) const {
+    // Unpack the k operand pairs once, then let the backend accumulate all k products per
+    // coefficient in registers with a single reduction
+    thread_local std::vector<uint32_t> scratch;
+    scratch.resize((2 * k + 1) * static_cast<size_t>(n_));
+    uint32_t* a_coeffs = scratch.data();
+    uint32_t* b_coeffs = a_coeffs + k * n_;
+    uint32_t* out_coeffs = b_coeffs + k * n_;
+    for (size_t j = 0; j < k; ++j) {
+        unpack_colors(a_hat + j * a_stride, a_coeffs + j * n_);
     }
+    unpack_colors(b_hat, b_coeffs, k);
+    count_work(WorkCounter::BASEMUL, k);
+    backend_->basemul_acc(a_coeffs, b_coeffs, k, out_coeffs);
+    convert_uint32_to_colors(out_coeffs, out_hat);
+}
 
-    uint32_t n_inv = mod_inverse(n_, modulus());
-    for (uint32_t i = 0; i < n_; ++i) {
-        uint64_t current_val = poly[i].to_precise_value();
-        uint64_t scaled = (current_val * n_inv) % modulus();
-        poly[i] = ColorValue::from_precise_value(scaled);
-    }
+void ColorNTTEngine::pointwise_multiply_accumulate16(const Coeff16* a_hat, const Coeff16* b_hat,
+                                                     Coeff16* acc_hat) const {
+    count_work(WorkCounter::BASEMUL, 1);
+    coeff16_multiply_accumulate(a_hat, b_hat, acc_hat, n_, q_);
 }
 
-void ColorNTTEngine::multiply_colors(const ColorValue* a, const ColorValue* b, ColorValue* result) const {
-    std::vector<ColorValue> a_ntt(n_);
-    std::vector<ColorValue> b_ntt(n_);
-    std::copy(a, a + n_, a_ntt.begin());
-    std::copy(b, b + n_, b_ntt.begin());
+ColorValue ColorNTTEngine::constant_term_product_colors(const ColorValue* a, const ColorValue* b) const {
+    std::vector<uint32_t>& coeffs = color_scratch(2 * static_cast<size_t>(n_));
+    unpack_colors(a, coeffs.data());
+    unpack_colors(b, coeffs.data() + n_);
+    return ColorValue::from_math_value(backend_->constant_term_product(coeffs.data(), coeffs.data() + n_));
+}
 
-    ntt_forward_colors(a_ntt.data());
-    ntt_forward_colors(b_ntt.data());
+void ColorNTTEngine::convert_uint32_to_colors(const uint32_t* coeffs, ColorValue* colors) const {
+    colors_from_u32(coeffs, colors, n_);
+}
+
+void ColorNTTEngine::convert_colors_to_uint32(const ColorValue* colors, uint32_t* coeffs) const {
+    colors_to_u32(colors, coeffs, n_);
+}
 
+void ColorNTTEngine::ntt_forward(uint32_t* poly) const {
     for (uint32_t i = 0; i < n_; ++i) {
-        uint64_t a_val = a_ntt[i].to_precise_value();
-        uint64_t b_val = b_ntt[i].to_precise_value();
-        uint64_t product = (a_val * b_val) % modulus();
-        result[i] = ColorValue::from_precise_value(product);
+        poly[i] %= q_;
     }
-
-    ntt_inverse_colors(result);
+    count_work(WorkCounter::NTT_FORWARD, 1);
+    backend_->ntt_forward(poly);
 }
 
-void ColorNTTEngine::convert_uint32_to_colors(const uint32_t* coeffs, ColorValue* colors) const {
+void ColorNTTEngine::ntt_inverse(uint32_t* poly) const {
     for (uint32_t i = 0; i < n_; ++i) {
-        colors[i] = ColorValue::from_precise_value(coeffs[i]);
+        poly[i] %= q_;
     }
+    count_work(WorkCounter::NTT_INVERSE, 1);
+    backend_->ntt_inverse(poly);
 }
 
-void ColorNTTEngine::convert_colors_to_uint32(const ColorValue* colors, uint32_t* coeffs) const {
-    for (uint32_t i = 0; i < n_; ++i) {
-        coeffs[i] = static_cast<uint32_t>(colors[i].to_precise_value());
+void ColorNTTEngine::ntt_forward_batch(uint32_t* polys, size_t count) const {
+    for (size_t i = 0; i < count * n_; ++i) {
+        polys[i] %= q_;
     }
+    count_work(WorkCounter::NTT_FORWARD, count);
+    backend_->ntt_forward_batch(polys, count);
 }
 
-void ColorNTTEngine::ntt_forward(uint32_t* poly) const {
-    std::vector<ColorValue> color_poly(n_);
-    convert_uint32_to_colors(poly, color_poly.data());
-    ntt_forward_colors(color_poly.data());
-    convert_colors_to_uint32(color_poly.data(), poly);
+void ColorNTTEngine::ntt_inverse_batch(uint32_t* polys, size_t count) const {
+    for (size_t i = 0; i < count * n_; ++i) {
+        polys[i] %= q_;
+    }
+    count_work(WorkCounter::NTT_INVERSE, count);
+    backend_->ntt_inverse_batch(polys, count);
 }
 
-void ColorNTTEngine::ntt_inverse(uint32_t* poly) const {
-    std::vector<ColorValue> color_poly(n_);
-    convert_uint32_to_colors(poly, color_poly.data());
-    ntt_inverse_colors(color_poly.data());
-    convert_colors_to_uint32(color_poly.data(), poly);
+void ColorNTTEngine::basemul_acc(const uint32_t* a, const uint32_t* b, size_t k, uint32_t* out) const {
+    count_work(WorkCounter::BASEMUL, k);
+    backend_->basemul_acc(a, b, k, out);
 }
 
 void ColorNTTEngine::multiply(const uint32_t* a, const uint32_t* b, uint32_t* result) const {
-    std::vector<ColorValue> color_a(n_), color_b(n_), color_result(n_);
-    convert_uint32_to_colors(a, color_a.data());
-    convert_uint32_to_colors(b, color_b.data());
-    multiply_colors(color_a.data(), color_b.data(), color_result.data());
-    convert_colors_to_uint32(color_result.data(), result);
+    count_work(WorkCounter::NTT_FORWARD, 2);
+    count_work(WorkCounter::BASEMUL, 1);
+    count_work(WorkCounter::NTT_INVERSE, 1);
+    backend_->multiply(a, b, result);
+}
+
+void ColorNTTEngine::multiply_inplace(uint32_t* a, uint32_t* b) const {
+    count_work(WorkCounter::NTT_FORWARD, 2);
+    count_work(WorkCounter::BASEMUL, 1);
+    count_work(WorkCounter::NTT_INVERSE, 1);
+    backend_->multiply_inplace(a, b);
+}
+
+uint32_t ColorNTTEngine::constant_term_product(const uint32_t* a, const uint32_t* b) const {
+    return backend_->constant_term_product(a, b);
 }
 
 } // namespace clwe
\ No newline at end of file
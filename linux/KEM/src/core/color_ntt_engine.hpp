@@ -3,38 +3,64 @@
 
 #include "ntt_engine.hpp"
 #include "color_value.hpp"
+#include "coeff16.hpp"
 #include <vector>
+#include <memory>
 
 namespace clwe {
 
 class ColorNTTEngine : public NTTEngine {
 private:
-    std::vector<ColorValue> color_zetas_;
-    std::vector<ColorValue> color_zetas_inv_;
+    // Coefficient arithmetic runs on the best uint32_t backend for this CPU
+    std::unique_ptr<NTTEngine> backend_;
 
-    ColorValue color_to_crypto_space(const ColorValue& color) const;
-    ColorValue crypto_space_to_color(const ColorValue& crypto_val) const;
-
-    void color_butterfly(ColorValue& a, ColorValue& b, const ColorValue& zeta, uint32_t modulus) const;
-    void color_butterfly_inv(ColorValue& a, ColorValue& b, const ColorValue& zeta, uint32_t modulus) const;
-
-    ColorValue color_add_precise(const ColorValue& a, const ColorValue& b, uint32_t modulus) const;
-    ColorValue color_subtract_precise(const ColorValue& a, const ColorValue& b, uint32_t modulus) const;
-    ColorValue color_multiply_precise(const ColorValue& a, const ColorValue& b, uint32_t modulus) const;
+    // Unpack count polynomials to a contiguous buffer of canonical residues
+    void unpack_colors(const ColorValue* colors, uint32_t* coeffs, size_t count = 1) const;
 
 public:
     ColorNTTEngine(uint32_t q, uint32_t n);
     ~ColorNTTEngine() override = default;
 
+    // Process-wide engine for (q, n) on the calling thread's NUMA node and the current
+    // ntt_backend(), created on first request. Every method is const and keeps its scratch thread-local, so one instance
+    // is safe to share across threads.
+    static std::shared_ptr<const ColorNTTEngine> shared(uint32_t q, uint32_t n);
+
     void ntt_forward_colors(ColorValue* poly) const;
     void ntt_inverse_colors(ColorValue* poly) const;
+    // count polynomials stored back to back, transformed in one batched backend call
+    void ntt_forward_colors_batch(ColorValue* polys, size_t count) const;
+    void ntt_inverse_colors_batch(ColorValue* polys, size_t count) const;
+    // Forward transform of count polynomials of canonical residues, such as fresh CBD samples,
+    // stored to polys as colors; coeffs is transformed in place. There is no color unpack, so
+    // each polynomial is written once, already in NTT domain.
+    void ntt_forward_u32_to_colors(uint32_t* coeffs, ColorValue* polys, size_t count) const;
+    // Inverse transform of count polynomials left in this thread's scratch as raw backend
+    // output, unscaled and not converted back to colors, for fused output stages. Valid
+    // until the next engine call on the calling thread.
+    const uint32_t* ntt_inverse_colors_batch_raw(const ColorValue* polys, size_t count) const;
     void multiply_colors(const ColorValue* a, const ColorValue* b, ColorValue* result) const;
+    // acc_hat += a_hat * b_hat pointwise, all three in NTT domain
+    void pointwise_multiply_accumulate_colors(const ColorValue* a_hat, const ColorValue* b_hat, ColorValue* acc_hat) const;
+    // out_hat = sum_{j < k} a_j * b_j pointwise. a_j starts at a_hat + j * a_stride (n for a
+    // matrix row, k * n for a column); the b_j are back to back
+    void row_dot_colors(const ColorValue* a_hat, size_t a_stride, const ColorValue* b_hat, size_t k,
+                        ColorValue* out_hat) const;
+    // Constant coefficient of a * b in coefficient domain, unscaled
+    ColorValue constant_term_product_colors(const ColorValue* a, const ColorValue* b) const;
+    // Compact-form counterpart of pointwise_multiply_accumulate_colors; q must satisfy coeff16_supported
+    void pointwise_multiply_accumulate16(const Coeff16* a_hat, const Coeff16* b_hat, Coeff16* acc_hat) const;
 
     void ntt_forward(uint32_t* poly) const override;
     void ntt_inverse(uint32_t* poly) const override;
+    void ntt_forward_batch(uint32_t* polys, size_t count) const override;
+    void ntt_inverse_batch(uint32_t* polys, size_t count) const override;
+    void basemul_acc(const uint32_t* a, const uint32_t* b, size_t k, uint32_t* out) const override;
     void multiply(const uint32_t* a, const uint32_t* b, uint32_t* result) const override;
+    void multiply_inplace(uint32_t* a, uint32_t* b) const override;
+    uint32_t constant_term_product(const uint32_t* a, const uint32_t* b) const override;
 
-    SIMDSupport get_simd_support() const override { return SIMDSupport::NONE; }
+    SIMDSupport get_simd_support() const override { return backend_->get_simd_support(); }
 
     void convert_uint32_to_colors(const uint32_t* coeffs, ColorValue* colors) const;
     void convert_colors_to_uint32(const ColorValue* colors, uint32_t* coeffs) const;
@@ -1,10 +1,15 @@
 #include "color_value.hpp"
+#include "cpu_features.hpp"
+#include "ring_operations.hpp"
 #include "utils.hpp"
+#include "simd_target.hpp"
 #include <algorithm>
 #include <cmath>
 #include <sstream>
+#include <stdexcept>
+#include <string>
 
-#ifdef HAVE_AVX512
+#if defined(HAVE_AVX2) || defined(HAVE_AVX512)
 #include <immintrin.h>
 #endif
 
@@ -17,7 +22,9 @@ namespace clwe {
 ColorValue ColorValue::mod_add(const ColorValue& other, uint32_t modulus) const {
     uint32_t this_val = to_math_value();
     uint32_t other_val = other.to_math_value();
-    uint32_t sum = (this_val + other_val) % modulus;
+    uint32_t sum = this_val + other_val;
+    // A zero modulus leaves the value unreduced rather than trapping
+    if (modulus != 0) sum %= modulus;
     return from_math_value(sum);
 }
 
@@ -36,7 +43,8 @@ ColorValue ColorValue::mod_multiply(const ColorValue& other, uint32_t modulus) c
     uint32_t this_val = to_math_value();
     uint32_t other_val = other.to_math_value();
     uint64_t product = static_cast<uint64_t>(this_val) * other_val;
-    uint32_t result = product % modulus;
+    uint32_t result = modulus != 0 ? static_cast<uint32_t>(product % modulus)
+                                   : static_cast<uint32_t>(product);
     return from_math_value(result);
 }
 
@@ -114,6 +122,295 @@ std::string ColorValue::to_string() const {
     return ss.str();
 }
 
+namespace {
+
+static_assert(sizeof(ColorValue) == 4, "ColorValue must be 4 packed bytes");
+
+// (r, g, b, a) is the big-endian math value, so both directions are the same 32-bit
+// byte swap. The kernels return how many words they handled; scalar code does the rest.
+#ifdef HAVE_AVX2
+bool use_avx2() {
+    static const bool supported = CPUFeatureDetector::cached().has_avx2;
+    return supported;
+}
+
+CLWE_TARGET_AVX2 size_t byteswap32_avx2(const uint8_t* in, uint8_t* out, size_t count) {
+    const __m256i swap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                          3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 4 * i));
+        __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 4 * i + 32));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 4 * i), _mm256_shuffle_epi8(lo, swap));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 4 * i + 32), _mm256_shuffle_epi8(hi, swap));
+    }
+    for (; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 4 * i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 4 * i), _mm256_shuffle_epi8(v, swap));
+    }
+    return i;
+}
+#elif defined(__ARM_NEON)
+size_t byteswap32_neon(const uint8_t* in, uint8_t* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        vst1q_u8(out + 4 * i, vrev32q_u8(vld1q_u8(in + 4 * i)));
+    }
+    return i;
+}
+#endif
+
+size_t byteswap32_simd(const uint8_t* in, uint8_t* out, size_t count) {
+#ifdef HAVE_AVX2
+    if (use_avx2()) {
+        return byteswap32_avx2(in, out, count);
+    }
+#elif defined(__ARM_NEON)
+    return byteswap32_neon(in, out, count);
+#endif
+    (void)in;
+    (void)out;
+    (void)count;
+    return 0;
+}
+
+// HSV kernels. Each lane repeats the float operations of ColorValue::to_hsv / from_hsv in
+// the same order, with the branches turned into selects, so results are bit-exact:
+// - fmod((g - b) / delta, 6) is the quotient itself, which lies in [-1, 1]
+// - the double 60 * quotient is exact, so rounding it to float equals the float product
+// - in from_hsv, 1 - |fmod(t, 2) - 1| is exact in float as f < 1 ? f : 2 - f, with
+//   f = t - 2 floor(t / 2) also exact, and c times it then rounds as the double did
+// No product feeds only an add, so contraction into FMA cannot change a lane.
+// Pixels load as little-endian words r | g << 8 | b << 16 | a << 24.
+#ifdef HAVE_AVX2
+CLWE_TARGET_AVX2 size_t rgb_to_hsv_avx2(const ColorValue* in, ColorValue* out, size_t count) {
+    const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+    const __m256i alpha_mask = _mm256_set1_epi32(static_cast<int>(0xFF000000u));
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 scale = _mm256_set1_ps(255.0f);
+    const __m256 sixty = _mm256_set1_ps(60.0f);
+    const __m256 full_turn = _mm256_set1_ps(360.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        __m256 r = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_and_si256(px, byte_mask)), scale);
+        __m256 g = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(px, 8), byte_mask)), scale);
+        __m256 b = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(px, 16), byte_mask)), scale);
+
+        __m256 max_val = _mm256_max_ps(r, _mm256_max_ps(g, b));
+        __m256 min_val = _mm256_min_ps(r, _mm256_min_ps(g, b));
+        __m256 delta = _mm256_sub_ps(max_val, min_val);
+
+        // Lanes with delta == 0 divide by zero here and are replaced below
+        __m256 h_r = _mm256_mul_ps(sixty, _mm256_div_ps(_mm256_sub_ps(g, b), delta));
+        __m256 h_g = _mm256_mul_ps(sixty, _mm256_add_ps(_mm256_div_ps(_mm256_sub_ps(b, r), delta), _mm256_set1_ps(2.0f)));
+        __m256 h_b = _mm256_mul_ps(sixty, _mm256_add_ps(_mm256_div_ps(_mm256_sub_ps(r, g), delta), _mm256_set1_ps(4.0f)));
+        __m256 h = _mm256_blendv_ps(h_b, h_g, _mm256_cmp_ps(max_val, g, _CMP_EQ_OQ));
+        h = _mm256_blendv_ps(h, h_r, _mm256_cmp_ps(max_val, r, _CMP_EQ_OQ));
+        h = _mm256_blendv_ps(h, zero, _mm256_cmp_ps(delta, zero, _CMP_EQ_OQ));
+        h = _mm256_blendv_ps(h, _mm256_add_ps(h, full_turn), _mm256_cmp_ps(h, zero, _CMP_LT_OQ));
+
+        __m256 s = _mm256_blendv_ps(_mm256_div_ps(delta, max_val), zero, _mm256_cmp_ps(max_val, zero, _CMP_EQ_OQ));
+
+        __m256i h8 = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_div_ps(h, full_turn), scale));
+        __m256i s8 = _mm256_cvttps_epi32(_mm256_mul_ps(s, scale));
+        __m256i v8 = _mm256_cvttps_epi32(_mm256_mul_ps(max_val, scale));
+        __m256i result = _mm256_or_si256(_mm256_and_si256(px, alpha_mask), h8);
+        result = _mm256_or_si256(result, _mm256_slli_epi32(s8, 8));
+        result = _mm256_or_si256(result, _mm256_slli_epi32(v8, 16));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), result);
+    }
+    return i;
+}
+
+CLWE_TARGET_AVX2 size_t hsv_to_rgb_avx2(const ColorValue* in, ColorValue* out, size_t count) {
+    const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+    const __m256i alpha_mask = _mm256_set1_epi32(static_cast<int>(0xFF000000u));
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 two = _mm256_set1_ps(2.0f);
+    const __m256 scale = _mm256_set1_ps(255.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        __m256 h = _mm256_mul_ps(_mm256_div_ps(_mm256_cvtepi32_ps(_mm256_and_si256(px, byte_mask)), scale),
+                                 _mm256_set1_ps(360.0f));
+        __m256 s = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(px, 8), byte_mask)), scale);
+        __m256 v = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(px, 16), byte_mask)), scale);
+
+        __m256 c = _mm256_mul_ps(v, s);
+        __m256 t = _mm256_div_ps(h, _mm256_set1_ps(60.0f));
+        __m256 f = _mm256_sub_ps(t, _mm256_mul_ps(two, _mm256_floor_ps(_mm256_mul_ps(t, _mm256_set1_ps(0.5f)))));
+        __m256 u = _mm256_blendv_ps(_mm256_sub_ps(two, f), f, _mm256_cmp_ps(f, one, _CMP_LT_OQ));
+        __m256 x = _mm256_mul_ps(c, u);
+        __m256 m = _mm256_sub_ps(v, c);
+
+        // Sectors from the top down: h >= 300 is (c, 0, x), then each lower bound overrides
+        __m256 r = c;
+        __m256 g = zero;
+        __m256 b = x;
+        __m256 below = _mm256_cmp_ps(h, _mm256_set1_ps(300.0f), _CMP_LT_OQ);
+        r = _mm256_blendv_ps(r, x, below);
+        b = _mm256_blendv_ps(b, c, below);
+        below = _mm256_cmp_ps(h, _mm256_set1_ps(240.0f), _CMP_LT_OQ);
+        r = _mm256_blendv_ps(r, zero, below);
+        g = _mm256_blendv_ps(g, x, below);
+        below = _mm256_cmp_ps(h, _mm256_set1_ps(180.0f), _CMP_LT_OQ);
+        g = _mm256_blendv_ps(g, c, below);
+        b = _mm256_blendv_ps(b, x, below);
+        below = _mm256_cmp_ps(h, _mm256_set1_ps(120.0f), _CMP_LT_OQ);
+        r = _mm256_blendv_ps(r, x, below);
+        b = _mm256_blendv_ps(b, zero, below);
+        below = _mm256_cmp_ps(h, _mm256_set1_ps(60.0f), _CMP_LT_OQ);
+        r = _mm256_blendv_ps(r, c, below);
+        g = _mm256_blendv_ps(g, x, below);
+
+        __m256i r8 = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_add_ps(r, m), scale));
+        __m256i g8 = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_add_ps(g, m), scale));
+        __m256i b8 = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_add_ps(b, m), scale));
+        __m256i result = _mm256_or_si256(_mm256_and_si256(px, alpha_mask), _mm256_and_si256(r8, byte_mask));
+        result = _mm256_or_si256(result, _mm256_slli_epi32(_mm256_and_si256(g8, byte_mask), 8));
+        result = _mm256_or_si256(result, _mm256_slli_epi32(_mm256_and_si256(b8, byte_mask), 16));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), result);
+    }
+    return i;
+}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+size_t rgb_to_hsv_neon(const ColorValue* in, ColorValue* out, size_t count) {
+    const uint32x4_t byte_mask = vdupq_n_u32(0xFF);
+    const uint32x4_t alpha_mask = vdupq_n_u32(0xFF000000u);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t scale = vdupq_n_f32(255.0f);
+    const float32x4_t sixty = vdupq_n_f32(60.0f);
+    const float32x4_t full_turn = vdupq_n_f32(360.0f);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        uint32x4_t px = vreinterpretq_u32_u8(vld1q_u8(reinterpret_cast<const uint8_t*>(in + i)));
+        float32x4_t r = vdivq_f32(vcvtq_f32_u32(vandq_u32(px, byte_mask)), scale);
+        float32x4_t g = vdivq_f32(vcvtq_f32_u32(vandq_u32(vshrq_n_u32(px, 8), byte_mask)), scale);
+        float32x4_t b = vdivq_f32(vcvtq_f32_u32(vandq_u32(vshrq_n_u32(px, 16), byte_mask)), scale);
+
+        float32x4_t max_val = vmaxq_f32(r, vmaxq_f32(g, b));
+        float32x4_t min_val = vminq_f32(r, vminq_f32(g, b));
+        float32x4_t delta = vsubq_f32(max_val, min_val);
+
+        float32x4_t h_r = vmulq_f32(sixty, vdivq_f32(vsubq_f32(g, b), delta));
+        float32x4_t h_g = vmulq_f32(sixty, vaddq_f32(vdivq_f32(vsubq_f32(b, r), delta), vdupq_n_f32(2.0f)));
+        float32x4_t h_b = vmulq_f32(sixty, vaddq_f32(vdivq_f32(vsubq_f32(r, g), delta), vdupq_n_f32(4.0f)));
+        float32x4_t h = vbslq_f32(vceqq_f32(max_val, g), h_g, h_b);
+        h = vbslq_f32(vceqq_f32(max_val, r), h_r, h);
+        h = vbslq_f32(vceqq_f32(delta, zero), zero, h);
+        h = vbslq_f32(vcltq_f32(h, zero), vaddq_f32(h, full_turn), h);
+
+        float32x4_t s = vbslq_f32(vceqq_f32(max_val, zero), zero, vdivq_f32(delta, max_val));
+
+        uint32x4_t h8 = vcvtq_u32_f32(vmulq_f32(vdivq_f32(h, full_turn), scale));
+        uint32x4_t s8 = vcvtq_u32_f32(vmulq_f32(s, scale));
+        uint32x4_t v8 = vcvtq_u32_f32(vmulq_f32(max_val, scale));
+        uint32x4_t result = vorrq_u32(vandq_u32(px, alpha_mask), h8);
+        result = vorrq_u32(result, vshlq_n_u32(s8, 8));
+        result = vorrq_u32(result, vshlq_n_u32(v8, 16));
+        vst1q_u8(reinterpret_cast<uint8_t*>(out + i), vreinterpretq_u8_u32(result));
+    }
+    return i;
+}
+
+size_t hsv_to_rgb_neon(const ColorValue* in, ColorValue* out, size_t count) {
+    const uint32x4_t byte_mask = vdupq_n_u32(0xFF);
+    const uint32x4_t alpha_mask = vdupq_n_u32(0xFF000000u);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t two = vdupq_n_f32(2.0f);
+    const float32x4_t scale = vdupq_n_f32(255.0f);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        uint32x4_t px = vreinterpretq_u32_u8(vld1q_u8(reinterpret_cast<const uint8_t*>(in + i)));
+        float32x4_t h = vmulq_f32(vdivq_f32(vcvtq_f32_u32(vandq_u32(px, byte_mask)), scale), vdupq_n_f32(360.0f));
+        float32x4_t s = vdivq_f32(vcvtq_f32_u32(vandq_u32(vshrq_n_u32(px, 8), byte_mask)), scale);
+        float32x4_t v = vdivq_f32(vcvtq_f32_u32(vandq_u32(vshrq_n_u32(px, 16), byte_mask)), scale);
+
+        float32x4_t c = vmulq_f32(v, s);
+        float32x4_t t = vdivq_f32(h, vdupq_n_f32(60.0f));
+        float32x4_t f = vsubq_f32(t, vmulq_f32(two, vrndmq_f32(vmulq_f32(t, vdupq_n_f32(0.5f)))));
+        float32x4_t u = vbslq_f32(vcltq_f32(f, one), f, vsubq_f32(two, f));
+        float32x4_t x = vmulq_f32(c, u);
+        float32x4_t m = vsubq_f32(v, c);
+
+        float32x4_t r = c;
+        float32x4_t g = zero;
+        float32x4_t b = x;
+        uint32x4_t below = vcltq_f32(h, vdupq_n_f32(300.0f));
+        r = vbslq_f32(below, x, r);
+        b = vbslq_f32(below, c, b);
+        below = vcltq_f32(h, vdupq_n_f32(240.0f));
+        r = vbslq_f32(below, zero, r);
+        g = vbslq_f32(below, x, g);
+        below = vcltq_f32(h, vdupq_n_f32(180.0f));
+        g = vbslq_f32(below, c, g);
+        b = vbslq_f32(below, x, b);
+        below = vcltq_f32(h, vdupq_n_f32(120.0f));
+        r = vbslq_f32(below, x, r);
+        b = vbslq_f32(below, zero, b);
+        below = vcltq_f32(h, vdupq_n_f32(60.0f));
+        r = vbslq_f32(below, c, r);
+        g = vbslq_f32(below, x, g);
+
+        uint32x4_t r8 = vandq_u32(vcvtq_u32_f32(vmulq_f32(vaddq_f32(r, m), scale)), byte_mask);
+        uint32x4_t g8 = vandq_u32(vcvtq_u32_f32(vmulq_f32(vaddq_f32(g, m), scale)), byte_mask);
+        uint32x4_t b8 = vandq_u32(vcvtq_u32_f32(vmulq_f32(vaddq_f32(b, m), scale)), byte_mask);
+        uint32x4_t result = vorrq_u32(vandq_u32(px, alpha_mask), r8);
+        result = vorrq_u32(result, vshlq_n_u32(g8, 8));
+        result = vorrq_u32(result, vshlq_n_u32(b8, 16));
+        vst1q_u8(reinterpret_cast<uint8_t*>(out + i), vreinterpretq_u8_u32(result));
+    }
+    return i;
+}
+#endif
+
+size_t rgb_to_hsv_simd(const ColorValue* in, ColorValue* out, size_t count) {
+#ifdef HAVE_AVX2
+    if (use_avx2()) {
+        return rgb_to_hsv_avx2(in, out, count);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    return rgb_to_hsv_neon(in, out, count);
+#endif
+    (void)in;
+    (void)out;
+    (void)count;
+    return 0;
+}
+
+size_t hsv_to_rgb_simd(const ColorValue* in, ColorValue* out, size_t count) {
+#ifdef HAVE_AVX2
+    if (use_avx2()) {
+        return hsv_to_rgb_avx2(in, out, count);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    return hsv_to_rgb_neon(in, out, count);
+#endif
+    (void)in;
+    (void)out;
+    (void)count;
+    return 0;
+}
+
+} // namespace
+
+void colors_from_u32(const uint32_t* values, ColorValue* colors, size_t count) {
+    size_t i = byteswap32_simd(reinterpret_cast<const uint8_t*>(values), reinterpret_cast<uint8_t*>(colors), count);
+    for (; i < count; ++i) {
+        colors[i] = ColorValue::from_math_value(values[i]);
+    }
+}
+
+void colors_to_u32(const ColorValue* colors, uint32_t* values, size_t count) {
+    size_t i = byteswap32_simd(reinterpret_cast<const uint8_t*>(colors), reinterpret_cast<uint8_t*>(values), count);
+    for (; i < count; ++i) {
+        values[i] = colors[i].to_math_value();
+    }
+}
+
 namespace color_ops {
 
 ColorValue add_colors(const ColorValue& a, const ColorValue& b) {
@@ -136,24 +433,56 @@ ColorValue multiply_colors(const ColorValue& a, const ColorValue& b) {
 
 ColorValue mod_reduce_color(const ColorValue& c, uint32_t modulus) {
     uint32_t val = c.to_math_value();
-    val %= modulus;
+    if (modulus != 0) val %= modulus;
     return ColorValue::from_math_value(val);
 }
 
 #ifdef HAVE_AVX512
-__m512i add_colors_avx512(__m512i a, __m512i b) {
-    return _mm512_add_epi8(a, b);
+// Each 32-bit lane holds one ColorValue in memory order (r, g, b, a)
+CLWE_TARGET_AVX512 __m512i add_colors_avx512(__m512i a, __m512i b) {
+#ifdef HAVE_AVX512BW
+    // Saturating per-channel add, matching add_colors
+    return _mm512_adds_epu8(a, b);
+#else
+    alignas(64) ColorValue av[16], bv[16];
+    _mm512_store_si512(reinterpret_cast<__m512i*>(av), a);
+    _mm512_store_si512(reinterpret_cast<__m512i*>(bv), b);
+    for (int i = 0; i < 16; ++i) {
+        av[i] = add_colors(av[i], bv[i]);
+    }
+    return _mm512_load_si512(reinterpret_cast<const __m512i*>(av));
+#endif
 }
 
-__m512i multiply_colors_avx512(__m512i a, __m512i b) {
-    __m512i product = _mm512_mullo_epi8(a, b);
-    __m512i divisor = _mm512_set1_epi8(255);
-    return _mm512_div_epi8(product, divisor);
+CLWE_TARGET_AVX512 __m512i multiply_colors_avx512(__m512i a, __m512i b) {
+#ifdef HAVE_AVX512BW
+    // Per-channel (a * b) / 255 in 16-bit lanes; x / 255 == (x * 0x8081) >> 23 for x <= 255 * 255
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i magic = _mm512_set1_epi16(static_cast<short>(0x8081));
+    __m512i lo = _mm512_mullo_epi16(_mm512_unpacklo_epi8(a, zero), _mm512_unpacklo_epi8(b, zero));
+    __m512i hi = _mm512_mullo_epi16(_mm512_unpackhi_epi8(a, zero), _mm512_unpackhi_epi8(b, zero));
+    lo = _mm512_srli_epi16(_mm512_mulhi_epu16(lo, magic), 7);
+    hi = _mm512_srli_epi16(_mm512_mulhi_epu16(hi, magic), 7);
+    return _mm512_packus_epi16(lo, hi);
+#else
+    alignas(64) ColorValue av[16], bv[16];
+    _mm512_store_si512(reinterpret_cast<__m512i*>(av), a);
+    _mm512_store_si512(reinterpret_cast<__m512i*>(bv), b);
+    for (int i = 0; i < 16; ++i) {
+        av[i] = multiply_colors(av[i], bv[i]);
+    }
+    return _mm512_load_si512(reinterpret_cast<const __m512i*>(av));
+#endif
 }
 
-__m512i mod_reduce_colors_avx512(__m512i c, uint32_t modulus) {
-    __m512i mod_vec = _mm512_set1_epi32(modulus);
-    return _mm512_rem_epi32(_mm512_cvtepi8_epi32(_mm512_extracti32x4_epi32(c, 0)), mod_vec);
+CLWE_TARGET_AVX512 __m512i mod_reduce_colors_avx512(__m512i c, uint32_t modulus) {
+    // No packed integer division; reduce lane by lane
+    alignas(64) ColorValue cv[16];
+    _mm512_store_si512(reinterpret_cast<__m512i*>(cv), c);
+    for (int i = 0; i < 16; ++i) {
+        cv[i] = mod_reduce_color(cv[i], modulus);
+    }
+    return _mm512_load_si512(reinterpret_cast<const __m512i*>(cv));
 }
 #endif
 
@@ -199,6 +528,51 @@ ColorValue mod_reduce_color_simd(const ColorValue& c, uint32_t modulus) {
     return mod_reduce_color(c, modulus);
 }
 
+namespace {
+
+// Residue products must fit the kernels' 32-bit lanes
+void check_array_modulus(uint32_t modulus) {
+    if (modulus < 2 || modulus > 65536) {
+        throw std::invalid_argument("color_ops modulus must be in [2, 65536], got " + std::to_string(modulus));
+    }
+}
+
+} // namespace
+
+void add_mod(const ColorValue* a, const ColorValue* b, ColorValue* out, size_t count, uint32_t modulus) {
+    check_array_modulus(modulus);
+    poly_add(a, b, out, count, modulus);
+}
+
+void sub_mod(const ColorValue* a, const ColorValue* b, ColorValue* out, size_t count, uint32_t modulus) {
+    check_array_modulus(modulus);
+    poly_sub(a, b, out, count, modulus);
+}
+
+void mul_mod(const ColorValue* a, const ColorValue* b, ColorValue* out, size_t count, uint32_t modulus) {
+    check_array_modulus(modulus);
+    poly_mul(a, b, out, count, modulus);
+}
+
+void reduce_mod(ColorValue* colors, size_t count, uint32_t modulus) {
+    check_array_modulus(modulus);
+    poly_reduce(colors, count, modulus);
+}
+
+void rgb_to_hsv(const ColorValue* in, ColorValue* out, size_t count) {
+    size_t i = rgb_to_hsv_simd(in, out, count);
+    for (; i < count; ++i) {
+        out[i] = in[i].to_hsv();
+    }
+}
+
+void hsv_to_rgb(const ColorValue* in, ColorValue* out, size_t count) {
+    size_t i = hsv_to_rgb_simd(in, out, count);
+    for (; i < count; ++i) {
+        out[i] = in[i].from_hsv();
+    }
+}
+
 } // namespace color_ops
 
 } // namespace clwe
\ No newline at end of file
@@ -1,9 +1,14 @@
 #ifndef COLOR_VALUE_HPP
 #define COLOR_VALUE_HPP
 
+#include <cstddef>
 #include <cstdint>
 #include <iostream>
 
+#ifdef HAVE_AVX512
+#include <immintrin.h>
+#endif
+
 namespace clwe {
 
 /**
@@ -84,6 +89,11 @@ struct ColorValue {
     void print() const { std::cout << to_string() << std::endl; }
 };
 
+// Bulk from_math_value / to_math_value over count elements. Both are a 32-bit byte swap,
+// run with AVX2 (runtime-detected) or NEON shuffles; in-place use is allowed.
+void colors_from_u32(const uint32_t* values, ColorValue* colors, size_t count);
+void colors_to_u32(const ColorValue* colors, uint32_t* values, size_t count);
+
 namespace color_ops {
 
     ColorValue add_colors(const ColorValue& a, const ColorValue& b);
@@ -91,6 +101,7 @@ namespace color_ops {
     ColorValue mod_reduce_color(const ColorValue& c, uint32_t modulus);
 
     #ifdef HAVE_AVX512
+    // Compiled for AVX-512 whatever the build flags; callers must be AVX-512 code too
     __m512i add_colors_avx512(__m512i a, __m512i b);
     __m512i multiply_colors_avx512(__m512i a, __m512i b);
     __m512i mod_reduce_colors_avx512(__m512i c, uint32_t modulus);
@@ -107,6 +118,19 @@ namespace color_ops {
     ColorValue multiply_colors_simd(const ColorValue& a, const ColorValue& b);
     ColorValue mod_reduce_color_simd(const ColorValue& c, uint32_t modulus);
 
+    // Array forms on math values mod q: out[i] = a[i] op b[i] mod q, reduced to [0, q) whatever
+    // the inputs hold. AVX-512, AVX2 or NEON kernels; out may alias a or b. Throw
+    // std::invalid_argument unless 2 <= modulus <= 65536.
+    void add_mod(const ColorValue* a, const ColorValue* b, ColorValue* out, size_t count, uint32_t modulus);
+    void sub_mod(const ColorValue* a, const ColorValue* b, ColorValue* out, size_t count, uint32_t modulus);
+    void mul_mod(const ColorValue* a, const ColorValue* b, ColorValue* out, size_t count, uint32_t modulus);
+    void reduce_mod(ColorValue* colors, size_t count, uint32_t modulus);
+
+    // Array forms of ColorValue::to_hsv / from_hsv, bit-exact with them; branch-free AVX2
+    // (runtime-detected) or AArch64 NEON kernels. out may alias in.
+    void rgb_to_hsv(const ColorValue* in, ColorValue* out, size_t count);
+    void hsv_to_rgb(const ColorValue* in, ColorValue* out, size_t count);
+
 };
 
 } // namespace clwe
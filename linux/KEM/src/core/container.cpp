@@ -0,0 +1,296 @@
+#include "clwe/container.hpp"
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace clwe {
+
+namespace {
+
+constexpr uint8_t CONTAINER_MAGIC[4] = {'C', 'K', 'E', 'M'};
+constexpr uint8_t CONTAINER_VERSION = 1;
+// Version 2 appends the secret weight to the header; written only when it is nonzero
+constexpr uint8_t CONTAINER_VERSION_WEIGHTED = 2;
+constexpr uint8_t FLAG_CHECKSUM = 0x01;
+constexpr uint8_t FLAG_SPARSE_C2 = 0x02;
+constexpr uint8_t FLAG_AES_XOF = 0x04;
+constexpr uint8_t FLAG_SHARED_MATRIX = 0x08;
+constexpr size_t CHECKSUM_BYTES = 4;
+
+constexpr uint32_t CRC32_POLY = 0xEDB88320u;  // IEEE 802.3, reflected
+
+constexpr std::array<uint32_t, 256> make_crc32_table() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (CRC32_POLY & (0u - (crc & 1u)));
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+constexpr std::array<uint32_t, 256> CRC32_TABLE = make_crc32_table();
+
+uint32_t crc32_update(uint32_t crc, const uint8_t* data, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        crc = (crc >> 8) ^ CRC32_TABLE[(crc ^ data[i]) & 0xFF];
+    }
+    return crc;
+}
+
+// Bitwise form for secret data: no table index depends on the bytes
+uint32_t crc32_update_constant_time(uint32_t crc, const uint8_t* data, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (CRC32_POLY & (0u - (crc & 1u)));
+        }
+    }
+    return crc;
+}
+
+// CRC of the header and payload; private keys take the constant-time path
+uint32_t container_crc(const uint8_t* data, size_t size, size_t header_size, ContainerType type) {
+    uint32_t crc = crc32_update(0xFFFFFFFFu, data, header_size);
+    if (type == ContainerType::PRIVATE_KEY) {
+        crc = crc32_update_constant_time(crc, data + header_size, size - header_size);
+    } else {
+        crc = crc32_update(crc, data + header_size, size - header_size);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+void put_be16(uint8_t* out, uint32_t value) {
+    out[0] = static_cast<uint8_t>(value >> 8);
+    out[1] = static_cast<uint8_t>(value);
+}
+
+void put_be32(uint8_t* out, uint32_t value) {
+    out[0] = static_cast<uint8_t>(value >> 24);
+    out[1] = static_cast<uint8_t>(value >> 16);
+    out[2] = static_cast<uint8_t>(value >> 8);
+    out[3] = static_cast<uint8_t>(value);
+}
+
+uint32_t get_be16(const uint8_t* in) {
+    return (static_cast<uint32_t>(in[0]) << 8) | in[1];
+}
+
+uint32_t get_be32(const uint8_t* in) {
+    return (static_cast<uint32_t>(in[0]) << 24) | (static_cast<uint32_t>(in[1]) << 16) |
+           (static_cast<uint32_t>(in[2]) << 8) | in[3];
+}
+
+size_t payload_size(ContainerType type, const CLWEParameters& params) {
+    switch (type) {
+        case ContainerType::PUBLIC_KEY: return ColorPublicKey::serialized_size(params);
+        case ContainerType::PRIVATE_KEY: return ColorPrivateKey::serialized_size(params);
+        case ContainerType::CIPHERTEXT: return ColorCiphertext::serialized_size(params);
+    }
+    return 0;
+}
+
+const char* type_name(ContainerType type) {
+    switch (type) {
+        case ContainerType::PUBLIC_KEY: return "public key";
+        case ContainerType::PRIVATE_KEY: return "private key";
+        case ContainerType::CIPHERTEXT: return "ciphertext";
+    }
+    return "unknown";
+}
+
+// Header, then the payload written by serialize_payload(out, size), then the optional CRC
+template <typename Serialize>
+std::vector<uint8_t> build_container(ContainerType type, const CLWEParameters& params, size_t object_size,
+                                     bool checksum, const Serialize& serialize_payload) {
+    // Only the 16-bit header fields can overflow; validate() bounds the others
+    params.validate();
+    if (params.security_level > 0xFFFF || params.degree > 0xFFFF || params.modulus > 0xFFFF) {
+        throw std::invalid_argument("Parameters do not fit in a container header");
+    }
+    size_t payload = payload_size(type, params);
+    if (object_size != payload) {
+        throw std::invalid_argument(std::string("Invalid ") + type_name(type) + " size for its parameters: expected " +
+                                    std::to_string(payload) + " bytes, got " + std::to_string(object_size));
+    }
+
+    const size_t header_size = params.secret_weight != 0 ? ContainerHeader::MAX_BYTES : ContainerHeader::BYTES;
+    size_t body = header_size + payload;
+    std::vector<uint8_t> out(body + (checksum ? CHECKSUM_BYTES : 0));
+    std::memcpy(out.data(), CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC));
+    out[4] = params.secret_weight != 0 ? CONTAINER_VERSION_WEIGHTED : CONTAINER_VERSION;
+    out[5] = static_cast<uint8_t>(type);
+    out[6] = static_cast<uint8_t>((checksum ? FLAG_CHECKSUM : 0) | (params.sparse_c2 ? FLAG_SPARSE_C2 : 0) |
+                                  (params.xof == XofAlgorithm::AES256_CTR ? FLAG_AES_XOF : 0) |
+                                  (params.shared_matrix ? FLAG_SHARED_MATRIX : 0));
+    out[7] = static_cast<uint8_t>(params.encoding);
+    put_be16(&out[8], params.security_level);
+    put_be16(&out[10], params.degree);
+    put_be16(&out[12], params.modulus);
+    out[14] = static_cast<uint8_t>(params.module_rank);
+    out[15] = static_cast<uint8_t>(params.eta1);
+    out[16] = static_cast<uint8_t>(params.eta2);
+    out[17] = static_cast<uint8_t>(params.du);
+    out[18] = static_cast<uint8_t>(params.dv);
+    out[19] = static_cast<uint8_t>(params.t_dropped_bits);
+    put_be32(&out[20], static_cast<uint32_t>(payload));
+    if (params.secret_weight != 0) {
+        // validate() bounds the weight by the degree, which fits in 16 bits here
+        put_be16(&out[24], params.secret_weight);
+    }
+
+    serialize_payload(out.data() + header_size, payload);
+    if (checksum) {
+        put_be32(out.data() + body, container_crc(out.data(), body, header_size, type));
+    }
+    return out;
+}
+
+// Full validation of a container expected to hold the given type; returns its header
+ContainerHeader check_container(const uint8_t* data, size_t size, ContainerType expected) {
+    ContainerHeader header = parse_container_header(data, size);
+    if (header.type != expected) {
+        throw std::invalid_argument(std::string("Container holds a ") + type_name(header.type) + ", expected a " +
+                                    type_name(expected));
+    }
+    if (size != header.total_size) {
+        throw std::invalid_argument("Container size mismatch: header describes " + std::to_string(header.total_size) +
+                                    " bytes, got " + std::to_string(size));
+    }
+    if (header.has_checksum) {
+        size_t body = header.header_size + header.payload_size;
+        if (container_crc(data, body, header.header_size, header.type) != get_be32(data + body)) {
+            throw std::invalid_argument("Container checksum mismatch");
+        }
+    }
+    return header;
+}
+
+} // namespace
+
+ContainerHeader parse_container_header(const uint8_t* data, size_t size) {
+    if (data == nullptr || size < ContainerHeader::BYTES) {
+        throw std::invalid_argument("Container too small for its header: " + std::to_string(size) + " bytes");
+    }
+    if (std::memcmp(data, CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC)) != 0) {
+        throw std::invalid_argument("Not a ColorKEM container");
+    }
+    if (data[4] != CONTAINER_VERSION && data[4] != CONTAINER_VERSION_WEIGHTED) {
+        throw std::invalid_argument("Unsupported container version " + std::to_string(data[4]));
+    }
+    const size_t header_size = data[4] == CONTAINER_VERSION_WEIGHTED ? ContainerHeader::MAX_BYTES : ContainerHeader::BYTES;
+    if (size < header_size) {
+        throw std::invalid_argument("Container too small for its header: " + std::to_string(size) + " bytes");
+    }
+    if (header_size == ContainerHeader::MAX_BYTES && (get_be16(data + 24) == 0 || get_be16(data + 26) != 0)) {
+        throw std::invalid_argument("Invalid container secret weight field");
+    }
+    if (data[5] < static_cast<uint8_t>(ContainerType::PUBLIC_KEY) || data[5] > static_cast<uint8_t>(ContainerType::CIPHERTEXT)) {
+        throw std::invalid_argument("Unknown container type " + std::to_string(data[5]));
+    }
+    if ((data[6] & ~(FLAG_CHECKSUM | FLAG_SPARSE_C2 | FLAG_AES_XOF | FLAG_SHARED_MATRIX)) != 0) {
+        throw std::invalid_argument("Unknown container flags");
+    }
+    if (data[7] > static_cast<uint8_t>(CoefficientEncoding::PACKED12)) {
+        throw std::invalid_argument("Unknown container coefficient encoding " + std::to_string(data[7]));
+    }
+
+    ContainerHeader header;
+    header.header_size = header_size;
+    header.type = static_cast<ContainerType>(data[5]);
+    header.has_checksum = (data[6] & FLAG_CHECKSUM) != 0;
+
+    CLWEParameters& params = header.params;
+    params.security_level = get_be16(data + 8);
+    params.degree = get_be16(data + 10);
+    params.modulus = get_be16(data + 12);
+    params.module_rank = data[14];
+    params.eta1 = data[15];
+    params.eta2 = data[16];
+    params.du = data[17];
+    params.dv = data[18];
+    params.t_dropped_bits = data[19];
+    params.encoding = static_cast<CoefficientEncoding>(data[7]);
+    params.sparse_c2 = (data[6] & FLAG_SPARSE_C2) != 0;
+    params.xof = (data[6] & FLAG_AES_XOF) != 0 ? XofAlgorithm::AES256_CTR : XofAlgorithm::SHAKE128;
+    params.shared_matrix = (data[6] & FLAG_SHARED_MATRIX) != 0;
+    params.secret_weight = header_size == ContainerHeader::MAX_BYTES ? get_be16(data + 24) : 0;
+    params.validate();
+
+    header.payload_size = get_be32(data + 20);
+    size_t expected = payload_size(header.type, params);
+    if (header.payload_size != expected) {
+        throw std::invalid_argument(std::string("Container payload size does not match its parameters: expected ") +
+                                    std::to_string(expected) + " bytes for a " + type_name(header.type) + ", got " +
+                                    std::to_string(header.payload_size));
+    }
+    header.total_size = header.header_size + header.payload_size + (header.has_checksum ? CHECKSUM_BYTES : 0);
+    return header;
+}
+
+std::vector<uint8_t> to_container(const ColorPublicKey& public_key, bool checksum) {
+    return build_container(ContainerType::PUBLIC_KEY, public_key.params,
+                           ColorPublicKey::seed_bytes(public_key.params) + public_key.public_data.size(),
+                           checksum, [&](uint8_t* out, size_t size) { public_key.serialize(out, size); });
+}
+
+std::vector<uint8_t> to_container(const ColorPrivateKey& private_key, bool checksum) {
+    return build_container(ContainerType::PRIVATE_KEY, private_key.params, private_key.secret_data.size(),
+                           checksum, [&](uint8_t* out, size_t size) { private_key.serialize(out, size); });
+}
+
+std::vector<uint8_t> to_container(const ColorCiphertext& ciphertext, bool checksum) {
+    return build_container(ContainerType::CIPHERTEXT, ciphertext.params,
+                           ciphertext.ciphertext_data.size() + ciphertext.shared_secret_hint.size(),
+                           checksum, [&](uint8_t* out, size_t size) { ciphertext.serialize(out, size); });
+}
+
+ColorPublicKey public_key_from_container(const uint8_t* data, size_t size) {
+    ContainerHeader header = check_container(data, size, ContainerType::PUBLIC_KEY);
+    return ColorPublicKey::deserialize(data + header.header_size, header.payload_size, header.params);
+}
+
+ColorPublicKey public_key_from_container(const std::vector<uint8_t>& data) {
+    return public_key_from_container(data.data(), data.size());
+}
+
+ColorPrivateKey private_key_from_container(const uint8_t* data, size_t size) {
+    ContainerHeader header = check_container(data, size, ContainerType::PRIVATE_KEY);
+    return ColorPrivateKey::deserialize(data + header.header_size, header.payload_size, header.params);
+}
+
+ColorPrivateKey private_key_from_container(const std::vector<uint8_t>& data) {
+    return private_key_from_container(data.data(), data.size());
+}
+
+ColorCiphertext ciphertext_from_container(const uint8_t* data, size_t size) {
+    ContainerHeader header = check_container(data, size, ContainerType::CIPHERTEXT);
+    return ColorCiphertext::deserialize(data + header.header_size, header.payload_size, header.params);
+}
+
+ColorCiphertext ciphertext_from_container(const std::vector<uint8_t>& data) {
+    return ciphertext_from_container(data.data(), data.size());
+}
+
+ColorPublicKeyView view_public_key_container(const uint8_t* data, size_t size) {
+    ContainerHeader header = check_container(data, size, ContainerType::PUBLIC_KEY);
+    ColorPublicKeyView view;
+    // shared_matrix keys carry no seed; encapsulation uses the installed matrix
+    const size_t seed_size = ColorPublicKey::seed_bytes(header.params);
+    view.seed = seed_size == 0 ? nullptr : data + header.header_size;
+    view.public_data = data + header.header_size + seed_size;
+    view.public_data_size = header.payload_size - seed_size;
+    view.encoding = header.params.encoding;
+    view.params = header.params;
+    return view;
+}
+
+ColorCiphertextView view_ciphertext_container(const uint8_t* data, size_t size) {
+    ContainerHeader header = check_container(data, size, ContainerType::CIPHERTEXT);
+    return ColorCiphertextView::parse(data + header.header_size, header.payload_size, header.params);
+}
+
+} // namespace clwe
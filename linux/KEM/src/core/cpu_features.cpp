@@ -1,11 +1,23 @@
 #include "cpu_features.hpp"
 #include <iostream>
+#include <cstdlib>
 #include <cstring>
+#include <mutex>
 #include <sstream>
+#include <stdexcept>
 
 #ifdef _MSC_VER
 #include <intrin.h>
 #endif
+#if (defined(__riscv) || defined(__aarch64__)) && defined(__linux__)
+#include <sys/auxv.h>
+#endif
+#if defined(__aarch64__) && defined(__linux__)
+#include <sys/prctl.h>
+#endif
+#if defined(__aarch64__) && defined(__APPLE__)
+#include <sys/sysctl.h>
+#endif
 
 namespace clwe {
 
@@ -18,6 +30,7 @@ std::string CPUFeatures::to_string() const {
         case CPUArchitecture::ARM64: ss << "ARM64"; break;
         case CPUArchitecture::RISCV64: ss << "RISC-V 64"; break;
         case CPUArchitecture::PPC64: ss << "PowerPC 64"; break;
+        case CPUArchitecture::WASM32: ss << "WebAssembly"; break;
         default: ss << "Unknown"; break;
     }
 
@@ -26,8 +39,10 @@ std::string CPUFeatures::to_string() const {
         case SIMDSupport::AVX512: ss << "AVX-512"; break;
         case SIMDSupport::AVX2: ss << "AVX2"; break;
         case SIMDSupport::NEON: ss << "NEON"; break;
+        case SIMDSupport::SVE: ss << "SVE (" << sve_vlen << "-bit)"; break;
         case SIMDSupport::RVV: ss << "RVV"; break;
         case SIMDSupport::VSX: ss << "VSX"; break;
+        case SIMDSupport::WASM_SIMD128: ss << "WASM SIMD128"; break;
         default: ss << "None"; break;
     }
 
@@ -46,6 +61,8 @@ CPUFeatures CPUFeatureDetector::detect() {
             return detect_riscv();
         case CPUArchitecture::PPC64:
             return detect_ppc();
+        case CPUArchitecture::WASM32:
+            return detect_wasm();
         default:
             CPUFeatures features;
             features.architecture = CPUArchitecture::UNKNOWN;
@@ -54,6 +71,112 @@ CPUFeatures CPUFeatureDetector::detect() {
     }
 }
 
+namespace {
+
+// force_backend() state; cached() reads it once while building the dispatch features
+std::mutex g_dispatch_mutex;
+bool g_dispatch_latched = false;
+bool g_backend_forced = false;
+SIMDSupport g_forced_backend = SIMDSupport::NONE;
+
+} // namespace
+
+const CPUFeatures& CPUFeatureDetector::cached() {
+    static const CPUFeatures features = [] {
+        std::lock_guard<std::mutex> lock(g_dispatch_mutex);
+        g_dispatch_latched = true;
+
+        SIMDSupport backend = g_forced_backend;
+        bool forced = g_backend_forced;
+        const char* env = std::getenv("CLWE_FORCE_BACKEND");
+        if (!forced && env != nullptr) {
+            forced = parse_backend(env, backend);  // Unknown values keep the detected features
+        }
+        return forced ? restrict_to(detect(), backend) : detect();
+    }();
+    return features;
+}
+
+void CPUFeatureDetector::force_backend(SIMDSupport backend) {
+    std::lock_guard<std::mutex> lock(g_dispatch_mutex);
+    if (g_dispatch_latched) {
+        throw std::logic_error("force_backend must be called before the first kernel dispatch");
+    }
+    g_backend_forced = true;
+    g_forced_backend = backend;
+}
+
+bool CPUFeatureDetector::parse_backend(const std::string& name, SIMDSupport& backend) {
+    if (name == "scalar" || name == "none") backend = SIMDSupport::NONE;
+    else if (name == "avx2") backend = SIMDSupport::AVX2;
+    else if (name == "avx512") backend = SIMDSupport::AVX512;
+    else if (name == "neon") backend = SIMDSupport::NEON;
+    else if (name == "sve") backend = SIMDSupport::SVE;
+    else if (name == "rvv") backend = SIMDSupport::RVV;
+    else if (name == "vsx") backend = SIMDSupport::VSX;
+    else if (name == "wasm_simd128") backend = SIMDSupport::WASM_SIMD128;
+    else return false;
+    return true;
+}
+
+CPUFeatures CPUFeatureDetector::restrict_to(const CPUFeatures& features, SIMDSupport backend) {
+    CPUFeatures restricted = features;
+    bool keep_avx2 = backend == SIMDSupport::AVX2 || backend == SIMDSupport::AVX512;
+    bool keep_avx512 = backend == SIMDSupport::AVX512;
+    bool keep_neon = backend == SIMDSupport::NEON || backend == SIMDSupport::SVE;
+    bool keep_sve = backend == SIMDSupport::SVE;
+    bool keep_rvv = backend == SIMDSupport::RVV;
+    bool keep_vsx = backend == SIMDSupport::VSX;
+    bool keep_wasm = backend == SIMDSupport::WASM_SIMD128;
+
+    restricted.has_avx2 = features.has_avx2 && keep_avx2;
+    restricted.has_avx512f = features.has_avx512f && keep_avx512;
+    restricted.has_avx512dq = features.has_avx512dq && keep_avx512;
+    restricted.has_avx512bw = features.has_avx512bw && keep_avx512;
+    restricted.has_avx512vl = features.has_avx512vl && keep_avx512;
+    restricted.has_aes = features.has_aes && (keep_avx2 || keep_neon);
+    restricted.has_vaes = features.has_vaes && keep_avx2;
+    restricted.has_neon = features.has_neon && keep_neon;
+    restricted.has_sve = features.has_sve && keep_sve;
+    restricted.has_sve2 = features.has_sve2 && keep_sve;
+    restricted.sve_vlen = restricted.has_sve ? features.sve_vlen : 0;
+    restricted.has_sha3 = features.has_sha3 && keep_neon;
+    restricted.has_rvv = features.has_rvv && keep_rvv;
+    restricted.rvv_vlen = restricted.has_rvv ? features.rvv_vlen : 0;
+    restricted.has_vsx = features.has_vsx && keep_vsx;
+    restricted.has_altivec = features.has_altivec && keep_vsx;
+    restricted.has_wasm_simd128 = features.has_wasm_simd128 && keep_wasm;
+
+    switch (features.max_simd_support) {
+        case SIMDSupport::AVX512:
+            restricted.max_simd_support = keep_avx512 ? SIMDSupport::AVX512
+                                          : restricted.has_avx2 ? SIMDSupport::AVX2 : SIMDSupport::NONE;
+            break;
+        case SIMDSupport::AVX2:
+            restricted.max_simd_support = keep_avx2 ? SIMDSupport::AVX2 : SIMDSupport::NONE;
+            break;
+        case SIMDSupport::SVE:
+            restricted.max_simd_support = keep_sve ? SIMDSupport::SVE
+                                          : keep_neon ? SIMDSupport::NEON : SIMDSupport::NONE;
+            break;
+        case SIMDSupport::NEON:
+            restricted.max_simd_support = keep_neon ? SIMDSupport::NEON : SIMDSupport::NONE;
+            break;
+        case SIMDSupport::RVV:
+            restricted.max_simd_support = keep_rvv ? SIMDSupport::RVV : SIMDSupport::NONE;
+            break;
+        case SIMDSupport::VSX:
+            restricted.max_simd_support = keep_vsx ? SIMDSupport::VSX : SIMDSupport::NONE;
+            break;
+        case SIMDSupport::WASM_SIMD128:
+            restricted.max_simd_support = keep_wasm ? SIMDSupport::WASM_SIMD128 : SIMDSupport::NONE;
+            break;
+        case SIMDSupport::NONE:
+            break;
+    }
+    return restricted;
+}
+
 CPUArchitecture CPUFeatureDetector::detect_architecture() {
 #if defined(__x86_64__) || defined(_M_X64)
     return CPUArchitecture::X86_64;
@@ -63,6 +186,8 @@ CPUArchitecture CPUFeatureDetector::detect_architecture() {
     return CPUArchitecture::RISCV64;
 #elif defined(__powerpc64__) || defined(__ppc64__)
     return CPUArchitecture::PPC64;
+#elif defined(__wasm32__)
+    return CPUArchitecture::WASM32;
 #else
     return CPUArchitecture::UNKNOWN;
 #endif
@@ -79,6 +204,10 @@ CPUFeatures CPUFeatureDetector::detect_x86() {
 
     uint32_t regs[4];
 
+    // AES-NI only touches XMM state, which every x86-64 OS saves
+    cpuid(0x1, 0, regs);
+    features.has_aes = (regs[2] & (1 << 25)) != 0;
+
     // Check AVX2 support
     cpuid(0x7, 0, regs);
     bool has_avx2 = (regs[1] & (1 << 5)) != 0;  // AVX2 bit
@@ -89,6 +218,7 @@ CPUFeatures CPUFeatureDetector::detect_x86() {
     bool has_avx512dq = (regs[1] & (1 << 17)) != 0;  // AVX-512DQ
     bool has_avx512bw = (regs[1] & (1 << 30)) != 0;  // AVX-512BW
     bool has_avx512vl = (regs[2] & (1 << 31)) != 0;  // AVX-512VL
+    bool has_vaes = (regs[2] & (1 << 9)) != 0;       // VAES
 
     // Check OS support for AVX
     uint64_t xcr0 = xgetbv(0);
@@ -100,6 +230,7 @@ CPUFeatures CPUFeatureDetector::detect_x86() {
     features.has_avx512dq = has_avx512dq && os_avx512_support;
     features.has_avx512bw = has_avx512bw && os_avx512_support;
     features.has_avx512vl = has_avx512vl && os_avx512_support;
+    features.has_vaes = has_vaes && features.has_aes && os_avx_support;
 
     // Determine maximum SIMD support
     if (features.has_avx512f) {
@@ -121,10 +252,42 @@ CPUFeatures CPUFeatureDetector::detect_arm() {
     features.has_neon = true;
     features.max_simd_support = SIMDSupport::NEON;
 
-    // Check for SVE (Scalable Vector Extension)
-    // This is a simplified check - in practice, you'd need to query the system
-#if defined(__ARM_FEATURE_SVE)
+    // SVE (Graviton 3/4, Neoverse V1/V2/N2) is picked ahead of NEON. The kernels are
+    // vector-length agnostic, so the length is only reported, never required
+#if defined(__aarch64__) && defined(__linux__)
+    features.has_sve = (getauxval(AT_HWCAP) & (1UL << 22)) != 0;    // HWCAP_SVE
+    features.has_sve2 = (getauxval(AT_HWCAP2) & (1UL << 1)) != 0;  // HWCAP2_SVE2
+    if (features.has_sve) {
+        // PR_SVE_GET_VL returns the vector length in bytes in its low 16 bits
+        int vl = prctl(51 /* PR_SVE_GET_VL */, 0, 0, 0, 0);
+        features.sve_vlen = vl > 0 ? static_cast<uint32_t>(vl & 0xFFFF) * 8 : 0;
+        features.max_simd_support = SIMDSupport::SVE;
+    }
+#elif defined(__ARM_FEATURE_SVE)
     features.has_sve = true;
+    features.max_simd_support = SIMDSupport::SVE;
+#endif
+
+    // ARMv8.2-SHA3 is optional (Graviton 3/4, Apple M-series, Neoverse V1/V2 have it)
+#if defined(__aarch64__) && defined(__linux__)
+    features.has_sha3 = (getauxval(AT_HWCAP) & (1UL << 17)) != 0;  // HWCAP_SHA3
+#elif defined(__aarch64__) && defined(__APPLE__)
+    int sha3 = 0;
+    size_t size = sizeof(sha3);
+    features.has_sha3 = sysctlbyname("hw.optional.armv8_2_sha3", &sha3, &size, nullptr, 0) == 0 && sha3 != 0;
+#elif defined(__ARM_FEATURE_SHA3)
+    features.has_sha3 = true;
+#endif
+
+    // The Crypto extension's AES instructions are optional too (absent on some Cortex-A parts)
+#if defined(__aarch64__) && defined(__linux__)
+    features.has_aes = (getauxval(AT_HWCAP) & (1UL << 3)) != 0;  // HWCAP_AES
+#elif defined(__aarch64__) && defined(__APPLE__)
+    int aes = 0;
+    size_t aes_size = sizeof(aes);
+    features.has_aes = sysctlbyname("hw.optional.arm.FEAT_AES", &aes, &aes_size, nullptr, 0) == 0 && aes != 0;
+#elif defined(__ARM_FEATURE_AES)
+    features.has_aes = true;
 #endif
 
     return features;
@@ -134,14 +297,23 @@ CPUFeatures CPUFeatureDetector::detect_riscv() {
     CPUFeatures features;
     features.architecture = CPUArchitecture::RISCV64;
 
-    // Check for RVV support
-    // This is a simplified check - in practice, you'd need to query the system
-#if defined(__riscv_v)
-    features.has_rvv = true;
-    features.rvv_vlen = __riscv_v_elen;  // Vector element length
-    features.max_simd_support = SIMDSupport::RVV;
-#else
     features.max_simd_support = SIMDSupport::NONE;
+
+#if defined(__riscv_v)
+    // A V-enabled build can still land on a hart without the vector unit; Linux reports the
+    // single-letter extensions as AT_HWCAP bits, 'V' at bit ('V' - 'A')
+    bool vector_unit = true;
+#if defined(__linux__)
+    vector_unit = (getauxval(AT_HWCAP) & (1UL << ('V' - 'A'))) != 0;
+#endif
+    if (vector_unit) {
+        // vlenb holds VLEN in bytes; the engine strip-mines to whatever width it reports
+        unsigned long vlenb = 0;
+        __asm__ volatile("csrr %0, vlenb" : "=r"(vlenb));
+        features.has_rvv = true;
+        features.rvv_vlen = static_cast<uint32_t>(vlenb * 8);
+        features.max_simd_support = SIMDSupport::RVV;
+    }
 #endif
 
     return features;
@@ -164,6 +336,22 @@ CPUFeatures CPUFeatureDetector::detect_ppc() {
     return features;
 }
 
+CPUFeatures CPUFeatureDetector::detect_wasm() {
+    CPUFeatures features;
+    features.architecture = CPUArchitecture::WASM32;
+
+    // There is no run-time query: a module using SIMD128 fails validation on engines
+    // without it, so a module that runs at all has what it was compiled for
+#if defined(__wasm_simd128__)
+    features.has_wasm_simd128 = true;
+    features.max_simd_support = SIMDSupport::WASM_SIMD128;
+#else
+    features.max_simd_support = SIMDSupport::NONE;
+#endif
+
+    return features;
+}
+
 bool CPUFeatureDetector::has_cpuid() {
 #if defined(__x86_64__) || defined(_M_X64)
     return true;
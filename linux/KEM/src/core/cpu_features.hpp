@@ -11,7 +11,8 @@ enum class CPUArchitecture {
     X86_64,
     ARM64,
     RISCV64,
-    PPC64
+    PPC64,
+    WASM32
 };
 
 enum class SIMDSupport {
@@ -20,7 +21,9 @@ enum class SIMDSupport {
     AVX512,
     NEON,
     RVV,
-    VSX
+    VSX,
+    WASM_SIMD128,
+    SVE
 };
 
 struct CPUFeatures {
@@ -32,9 +35,14 @@ struct CPUFeatures {
     bool has_avx512dq = false;
     bool has_avx512bw = false;
     bool has_avx512vl = false;
+    bool has_aes = false;   // AES-NI on x86-64, the ARMv8 Crypto AES instructions on AArch64
+    bool has_vaes = false;  // VAES: AES rounds on 256-bit registers
 
     bool has_neon = false;
     bool has_sve = false;
+    bool has_sve2 = false;
+    uint32_t sve_vlen = 0;  // bits; one binary runs at any length from 128 to 2048
+    bool has_sha3 = false;  // ARMv8.2-SHA3: EOR3, RAX1, XAR, BCAX
 
     bool has_rvv = false;
     uint32_t rvv_vlen = 0;
@@ -42,12 +50,29 @@ struct CPUFeatures {
     bool has_vsx = false;
     bool has_altivec = false;
 
+    // Fixed at compile time: a -msimd128 module only instantiates on engines with SIMD128
+    bool has_wasm_simd128 = false;
+
     std::string to_string() const;
 };
 
 class CPUFeatureDetector {
 public:
     static CPUFeatures detect();
+    // detect() run once per process; later calls return the same object. Every kernel
+    // dispatches on these features, restricted to the forced backend if there is one
+    static const CPUFeatures& cached();
+
+    // Cap dispatch at backend, as CLWE_FORCE_BACKEND=scalar|avx2|avx512|neon|sve|rvv|vsx|wasm_simd128 does.
+    // Kernels latch their choice on first use, so this must run before anything calls
+    // cached(); throws std::logic_error afterwards. A backend the CPU lacks enables nothing.
+    static void force_backend(SIMDSupport backend);
+
+    // "scalar" (or "none"), "avx2", "avx512", "neon", "sve", "rvv", "vsx", "wasm_simd128"; false if unknown
+    static bool parse_backend(const std::string& name, SIMDSupport& backend);
+
+    // features with every instruction set above backend cleared
+    static CPUFeatures restrict_to(const CPUFeatures& features, SIMDSupport backend);
 
 private:
     static CPUFeatures detect_x86();
@@ -58,6 +83,8 @@ private:
 
     static CPUFeatures detect_ppc();
 
+    static CPUFeatures detect_wasm();
+
     static CPUArchitecture detect_architecture();
 
     static bool has_cpuid();
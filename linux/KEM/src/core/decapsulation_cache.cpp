@@ -0,0 +1,283 @@
+#include "clwe/decapsulation_cache.hpp"
+#include "mpmc_ring.hpp"
+#include "shake_sampler.hpp"
+#include "utils.hpp"
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+namespace clwe {
+
+namespace {
+
+using Digest = std::array<uint8_t, 32>;
+
+// Domain separation of the digest from every other SHAKE-256 use of the library
+constexpr uint8_t DIGEST_DOMAIN[] = {'c', 'l', 'w', 'e', '-', 'd', 'e', 'c', 'a', 'p', '-',
+                                     'c', 'a', 'c', 'h', 'e'};
+
+uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// All ones when a < b, else zero; a and b below 2^63
+uint64_t less_mask(uint64_t a, uint64_t b) {
+    return 0 - ((a - b) >> 63);
+}
+
+// All ones when the digests are equal, else zero, over every byte
+uint8_t equal_mask(const Digest& a, const Digest& b) {
+    uint32_t difference = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        difference |= static_cast<uint32_t>(a[i] ^ b[i]);
+    }
+    return static_cast<uint8_t>(((difference - 1) >> 8) & 0xFF);
+}
+
+struct Way {
+    Digest digest{};
+    std::array<uint8_t, SharedSecret::BYTES> secret{};
+    uint64_t expires_ns = 0;  // 0 while empty
+};
+
+struct Set {
+    std::mutex mutex;
+    Way ways[DecapsulationCache::WAYS];
+};
+
+void wipe(Way& way) {
+    secure_zero(&way, sizeof(way));
+}
+
+} // namespace
+
+struct DecapsulationCache::Impl {
+    const ColorKEM& kem;
+    const uint64_t ttl_ns;
+    const size_t set_mask;
+    std::unique_ptr<Set[]> sets;
+    std::array<uint8_t, 32> digest_key{};
+    std::unique_ptr<const PreparedPrivateKey> prepared;
+    std::unique_ptr<ColorExpandedPrivateKey> expanded;
+    mutable std::atomic<uint64_t> hits{0};
+    mutable std::atomic<uint64_t> misses{0};
+
+    Impl(const ColorKEM& instance, const CLWEParameters& key_params, const DecapsulationCacheConfig& config)
+        : kem(instance),
+          ttl_ns(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(config.ttl).count())),
+          set_mask(round_up_power_of_two((config.capacity + WAYS - 1) / WAYS) - 1),
+          sets(new Set[set_mask + 1]) {
+        if (key_params.fingerprint() != kem.params().fingerprint()) {
+            throw std::invalid_argument("DecapsulationCache key does not match the ColorKEM parameters");
+        }
+        kem.random_source()->generate(digest_key.data(), digest_key.size());
+    }
+
+    ~Impl() {
+        wipe_all();
+        secure_zero(digest_key.data(), digest_key.size());
+        if (expanded) {
+            secure_zero(expanded->secret_data.data(), expanded->secret_data.size());
+        }
+    }
+
+    void wipe_all() {
+        for (size_t s = 0; s <= set_mask; ++s) {
+            std::lock_guard<std::mutex> lock(sets[s].mutex);
+            for (Way& way : sets[s].ways) {
+                wipe(way);
+            }
+        }
+    }
+
+    Digest digest(const ColorCiphertextView& ciphertext) const {
+        const uint64_t params_fingerprint = ciphertext.params.fingerprint();
+        uint8_t params_bytes[8];
+        for (size_t i = 0; i < sizeof(params_bytes); ++i) {
+            params_bytes[i] = static_cast<uint8_t>(params_fingerprint >> (8 * i));
+        }
+        const uint8_t has_hint = ciphertext.shared_secret_hint != nullptr ? 1 : 0;
+
+        SHAKE256Sampler& shake = thread_shake256();
+        shake.begin();
+        shake.absorb(DIGEST_DOMAIN, sizeof(DIGEST_DOMAIN));
+        shake.absorb(digest_key.data(), digest_key.size());
+        shake.absorb(params_bytes, sizeof(params_bytes));
+        shake.absorb(&has_hint, 1);
+        if (has_hint) {
+            shake.absorb(ciphertext.shared_secret_hint, 4);
+        }
+        if (ciphertext.ciphertext_data != nullptr) {
+            shake.absorb(ciphertext.ciphertext_data, ciphertext.ciphertext_size);
+        }
+        shake.finalize();
+        Digest result;
+        shake.squeeze(result.data(), result.size());
+        return result;
+    }
+
+    Set& set_of(const Digest& digest) const {
+        uint64_t index = 0;
+        std::memcpy(&index, digest.data(), sizeof(index));
+        return sets[index & set_mask];
+    }
+
+    // Every way is compared and masked in; expired ways never match and are wiped
+    bool lookup(Set& set, const Digest& digest, uint64_t now, uint8_t* secret, size_t secret_size) const {
+        std::lock_guard<std::mutex> lock(set.mutex);
+        uint8_t found = 0;
+        std::memset(secret, 0, secret_size);
+        for (Way& way : set.ways) {
+            const uint8_t live = static_cast<uint8_t>(less_mask(now, way.expires_ns));
+            const uint8_t match = static_cast<uint8_t>(equal_mask(way.digest, digest) & live);
+            for (size_t i = 0; i < secret_size; ++i) {
+                secret[i] |= static_cast<uint8_t>(way.secret[i] & match);
+            }
+            found |= match;
+            if (way.expires_ns != 0 && !live) {
+                wipe(way);
+            }
+        }
+        return found != 0;
+    }
+
+    void insert(Set& set, const Digest& digest, uint64_t now, const uint8_t* secret, size_t secret_size) const {
+        std::lock_guard<std::mutex> lock(set.mutex);
+        Way* victim = &set.ways[0];
+        for (Way& way : set.ways) {
+            // Another thread that missed on the same ciphertext stored it first
+            if (equal_mask(way.digest, digest) != 0 && way.expires_ns > now) {
+                return;
+            }
+        }
+        for (Way& way : set.ways) {
+            if (way.expires_ns <= now) {
+                victim = &way;
+                break;
+            }
+            if (way.expires_ns < victim->expires_ns) {
+                victim = &way;
+            }
+        }
+        wipe(*victim);
+        victim->digest = digest;
+        std::memcpy(victim->secret.data(), secret, secret_size);
+        victim->expires_ns = now + ttl_ns;
+    }
+
+    // Fills secret with the result cached for ciphertext, or with derive()'s, which is then cached
+    template <typename Derive>
+    void lookup_or_derive(const ColorCiphertextView& ciphertext, uint8_t* secret, size_t secret_size,
+                          const Derive& derive) const {
+        const Digest key = digest(ciphertext);
+        Set& set = set_of(key);
+        if (lookup(set, key, now_ns(), secret, secret_size)) {
+            hits.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        misses.fetch_add(1, std::memory_order_relaxed);
+        derive(secret);
+        insert(set, key, now_ns(), secret, secret_size);
+    }
+
+    template <typename Decapsulate>
+    ColorValue color_secret(const ColorCiphertextView& ciphertext, const Decapsulate& decapsulate) const {
+        if (!prepared) {
+            throw std::logic_error("DecapsulationCache holds a 256-bit mode key; use decapsulate_key()");
+        }
+        uint8_t bytes[4];
+        lookup_or_derive(ciphertext, bytes, sizeof(bytes), [&](uint8_t* out) {
+            const uint32_t value = decapsulate().to_math_value();
+            for (size_t i = 0; i < 4; ++i) {
+                out[i] = static_cast<uint8_t>(value >> (24 - 8 * i));
+            }
+        });
+        const ColorValue secret = ColorValue::from_math_value(
+            (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16) |
+            (static_cast<uint32_t>(bytes[2]) << 8) | bytes[3]);
+        secure_zero(bytes, sizeof(bytes));
+        return secret;
+    }
+
+    template <typename Decapsulate>
+    SharedSecret key_secret(const ColorCiphertextView& ciphertext, const Decapsulate& decapsulate) const {
+        if (!expanded) {
+            throw std::logic_error("DecapsulationCache holds a prepared key; use decapsulate()");
+        }
+        SharedSecret secret;
+        lookup_or_derive(ciphertext, secret.data(), secret.size(), [&](uint8_t* out) {
+            SharedSecret derived = decapsulate();
+            std::memcpy(out, derived.data(), derived.size());
+            secure_zero(derived.data(), derived.size());
+        });
+        return secret;
+    }
+};
+
+namespace {
+
+void check_config(const DecapsulationCacheConfig& config) {
+    if (config.capacity == 0 || config.ttl.count() <= 0) {
+        throw std::invalid_argument("DecapsulationCache capacity and ttl must be positive");
+    }
+}
+
+} // namespace
+
+DecapsulationCache::DecapsulationCache(const ColorKEM& kem, const PreparedPrivateKey& private_key,
+                                       const DecapsulationCacheConfig& config) {
+    check_config(config);
+    if (!private_key.secret_key_colors) {
+        throw std::invalid_argument("DecapsulationCache needs a prepared key");
+    }
+    impl_.reset(new Impl(kem, private_key.params, config));
+    impl_->prepared.reset(new PreparedPrivateKey(private_key));
+}
+
+DecapsulationCache::DecapsulationCache(const ColorKEM& kem, const ColorExpandedPrivateKey& private_key,
+                                       const DecapsulationCacheConfig& config) {
+    check_config(config);
+    impl_.reset(new Impl(kem, private_key.params, config));
+    impl_->expanded.reset(new ColorExpandedPrivateKey(private_key));
+}
+
+DecapsulationCache::~DecapsulationCache() = default;
+
+ColorValue DecapsulationCache::decapsulate(const ColorCiphertextView& ciphertext, KemWorkspace& workspace) const {
+    return impl_->color_secret(ciphertext, [&] { return impl_->kem.decapsulate(*impl_->prepared, ciphertext, workspace); });
+}
+
+ColorValue DecapsulationCache::decapsulate(const ColorCiphertext& ciphertext) const {
+    return impl_->color_secret(ColorCiphertextView(ciphertext),
+                               [&] { return impl_->kem.decapsulate(*impl_->prepared, ciphertext); });
+}
+
+SharedSecret DecapsulationCache::decapsulate_key(const ColorCiphertextView& ciphertext,
+                                                 KemWorkspace& workspace) const {
+    return impl_->key_secret(ciphertext,
+                             [&] { return impl_->kem.decapsulate_key(*impl_->expanded, ciphertext, workspace); });
+}
+
+SharedSecret DecapsulationCache::decapsulate_key(const ColorCiphertext& ciphertext) const {
+    return impl_->key_secret(ColorCiphertextView(ciphertext),
+                             [&] { return impl_->kem.decapsulate_key(*impl_->expanded, ciphertext); });
+}
+
+void DecapsulationCache::clear() {
+    impl_->wipe_all();
+}
+
+size_t DecapsulationCache::capacity() const {
+    return (impl_->set_mask + 1) * WAYS;
+}
+
+uint64_t DecapsulationCache::hits() const {
+    return impl_->hits.load(std::memory_order_relaxed);
+}
+
+uint64_t DecapsulationCache::misses() const {
+    return impl_->misses.load(std::memory_order_relaxed);
+}
+
+} // namespace clwe
@@ -0,0 +1,241 @@
+#include "clwe/decapsulation_context.hpp"
+#include "encoding.hpp"
+#include "metrics.hpp"
+#include "poly.hpp"
+#include "probes.hpp"
+#include "ring_operations.hpp"
+#include "shake_sampler.hpp"
+#include "slow_operations.hpp"
+#include "trace.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace clwe {
+
+struct DecapsulationContext::State {
+    std::shared_ptr<const PolyVec> secret;  // s_hat
+    bool compressed = false;
+    size_t c1_poly_bytes = 0;  // One encoded c1 polynomial
+    size_t c2_count = 0;       // Transmitted c2 coefficients
+    size_t c2_bytes = 0;
+    size_t total_bytes = 0;    // Ciphertext data and hint
+
+    size_t received = 0;
+    uint32_t unit = 0;  // Next c1 polynomial; rank for c2, rank + 1 for the hint
+    size_t staged = 0;  // Bytes of the current unit held in staging
+    std::vector<uint8_t> staging;
+
+    Poly c1_hat;            // The polynomial being folded in
+    Poly term;              // s_hat[i] o c1_hat[i]
+    Poly s_dot_c1;          // Running s_hat^T c1_hat, then s^T c1
+    uint64_t constant_sum = 0;  // Sparse c2: running sum of the NTT-domain products
+    Poly c2;
+    uint8_t hint[4] = {};
+    bool reduced = true;    // Every uncompressed coefficient so far is below q
+    SHAKE256Sampler shake;  // H(ciphertext data || hint), absorbed as bytes arrive
+
+    void wipe() {
+        secure_zero(staging.data(), staging.size());
+        secure_zero(c1_hat.data(), c1_hat.degree() * sizeof(ColorValue));
+        secure_zero(term.data(), term.degree() * sizeof(ColorValue));
+        secure_zero(s_dot_c1.data(), s_dot_c1.degree() * sizeof(ColorValue));
+        secure_zero(c2.data(), c2.degree() * sizeof(ColorValue));
+        secure_zero(hint, sizeof(hint));
+        constant_sum = 0;
+        reduced = true;
+        received = 0;
+        unit = 0;
+        staged = 0;
+        shake.begin();
+    }
+};
+
+DecapsulationContext::DecapsulationContext(const ColorKEM& kem, const PreparedPrivateKey& private_key)
+    : kem_(&kem) {
+    if (!kem.matches_parameters(private_key.params) || !private_key.secret_key_colors) {
+        throw std::invalid_argument("Prepared private key does not belong to this KEM instance");
+    }
+
+    const CLWEParameters& params = kem.params_;
+    const size_t c1_count = static_cast<size_t>(params.module_rank) * params.degree;
+    auto state = std::make_unique<State>();
+    state->secret = private_key.secret_key_colors;
+    state->compressed = params.du != 0;
+    state->c2_count = params.sparse_c2 ? 1 : params.degree;
+    size_t c1_bytes;
+    if (state->compressed) {
+        state->c1_poly_bytes = compressed_coefficients_size(params.degree, params.du);
+        state->c2_bytes = compressed_coefficients_size(state->c2_count, params.dv);
+        c1_bytes = compressed_coefficients_size(c1_count, params.du);
+    } else {
+        state->c1_poly_bytes = encoded_coefficients_size(params.degree, params.encoding);
+        state->c2_bytes = encoded_coefficients_size(state->c2_count, params.encoding);
+        c1_bytes = encoded_coefficients_size(c1_count, params.encoding);
+    }
+    // Polynomials are decoded one at a time from their own bytes
+    if (state->c1_poly_bytes * params.module_rank != c1_bytes) {
+        throw std::invalid_argument("Streaming decapsulation needs byte-aligned c1 polynomials; degree " +
+                                    std::to_string(params.degree) + " does not give them");
+    }
+    state->total_bytes = kem.ciphertext_bytes_ + sizeof(state->hint);
+    state->staging.resize(std::max({state->c1_poly_bytes, state->c2_bytes, sizeof(state->hint)}));
+    state->c1_hat = Poly(params.degree);
+    state->term = Poly(params.degree);
+    state->s_dot_c1 = Poly(params.degree);
+    state->c2 = Poly(params.degree);
+    state->wipe();
+    state_ = std::move(state);
+}
+
+DecapsulationContext::~DecapsulationContext() {
+    if (state_) {
+        state_->wipe();
+    }
+}
+
+DecapsulationContext::DecapsulationContext(DecapsulationContext&&) noexcept = default;
+
+DecapsulationContext& DecapsulationContext::operator=(DecapsulationContext&& other) noexcept {
+    if (this != &other) {
+        if (state_) {
+            state_->wipe();
+        }
+        kem_ = other.kem_;
+        state_ = std::move(other.state_);
+    }
+    return *this;
+}
+
+size_t DecapsulationContext::ciphertext_size() const {
+    return state_ ? state_->total_bytes : 0;
+}
+
+size_t DecapsulationContext::bytes_received() const {
+    return state_ ? state_->received : 0;
+}
+
+void DecapsulationContext::reset() {
+    if (!state_) {
+        throw std::logic_error("DecapsulationContext has been moved from");
+    }
+    state_->wipe();
+}
+
+void DecapsulationContext::feed(const uint8_t* data, size_t size) {
+    if (!state_) {
+        throw std::logic_error("DecapsulationContext has been moved from");
+    }
+    State& state = *state_;
+    if (size > state.total_bytes - state.received) {
+        throw std::invalid_argument("Ciphertext overrun: " + std::to_string(state.received + size) +
+                                    " bytes fed, expected " + std::to_string(state.total_bytes));
+    }
+    if (size == 0) {
+        return;
+    }
+    state.shake.absorb(data, size);
+    state.received += size;
+
+    const CLWEParameters& params = kem_->params_;
+    const uint32_t rank = params.module_rank;
+    while (size > 0) {
+        const size_t unit_bytes = state.unit < rank ? state.c1_poly_bytes
+                                  : state.unit == rank ? state.c2_bytes
+                                  : sizeof(state.hint);
+        // Whole units are decoded where they lie; only a unit split across pieces is staged
+        const uint8_t* bytes = data;
+        if (state.staged > 0 || size < unit_bytes) {
+            const size_t take = std::min(unit_bytes - state.staged, size);
+            std::copy(data, data + take, state.staging.data() + state.staged);
+            state.staged += take;
+            data += take;
+            size -= take;
+            if (state.staged < unit_bytes) {
+                return;
+            }
+            bytes = state.staging.data();
+        } else {
+            data += unit_bytes;
+            size -= unit_bytes;
+        }
+
+        if (state.unit < rank) {
+            CLWE_TRACE_SPAN("unpack_ciphertext");
+            SlowStageTimer slow_stage(SlowStage::UNPACK);
+            ColorValue* c1_hat = state.c1_hat.data();
+            if (state.compressed) {
+                decode_decompress_coefficients(bytes, params.degree, params.du, params.modulus, c1_hat);
+            } else {
+                state.reduced &= decode_coefficients_checked(bytes, params.degree, params.encoding, params.modulus,
+                                                             c1_hat);
+            }
+            kem_->color_ntt_engine_->ntt_forward_colors(c1_hat);
+            const ColorValue* s_hat = (*state.secret)[state.unit];
+            if (params.sparse_c2) {
+                // Same sum as ColorKEM::constant_term_ntt, one polynomial at a time
+                const BarrettReducer& reducer = kem_->reducer_;
+                for (uint32_t c = 0; c < params.degree; ++c) {
+                    state.constant_sum += reducer.mul(reducer.reduce(s_hat[c].to_math_value()),
+                                                      reducer.reduce(c1_hat[c].to_math_value()));
+                }
+            } else {
+                kem_->color_ntt_engine_->row_dot_colors(s_hat, params.degree, c1_hat, 1, state.term.data());
+                poly_add(state.s_dot_c1.data(), state.term.data(), state.s_dot_c1.data(), params.degree,
+                         params.modulus);
+            }
+        } else if (state.unit == rank) {
+            ColorValue* c2 = state.c2.data();
+            if (state.compressed) {
+                decode_decompress_coefficients(bytes, state.c2_count, params.dv, params.modulus, c2);
+            } else {
+                state.reduced &= decode_coefficients_checked(bytes, state.c2_count, params.encoding, params.modulus,
+                                                             c2);
+            }
+            // The zero tail of a sparse c2 is implied, never parsed
+            std::fill(c2 + state.c2_count, c2 + params.degree, ColorValue::from_math_value(0));
+        } else {
+            std::copy(bytes, bytes + sizeof(state.hint), state.hint);
+        }
+        ++state.unit;
+        state.staged = 0;
+    }
+}
+
+ColorValue DecapsulationContext::finish() {
+    if (!state_) {
+        throw std::logic_error("DecapsulationContext has been moved from");
+    }
+    State& state = *state_;
+    if (state.received != state.total_bytes) {
+        const size_t received = state.received;
+        state.wipe();
+        throw std::invalid_argument("Incomplete ciphertext: " + std::to_string(received) + " of " +
+                                    std::to_string(state.total_bytes) + " bytes fed");
+    }
+
+    CLWE_TRACE_SPAN("decapsulate");
+    CLWE_PROBE_SCOPE(decapsulate);
+    const CLWEParameters& params = kem_->params_;
+    MetricsTimer metrics_timer(MetricOperation::DECAPSULATE, params.security_level);
+    SlowOperationTimer slow_timer(MetricOperation::DECAPSULATE, params.security_level, *kem_->color_ntt_engine_);
+    if (params.sparse_c2) {
+        state.s_dot_c1[0] = ColorValue::from_math_value(
+            kem_->reducer_.mul(static_cast<uint32_t>(state.constant_sum % params.modulus), kem_->degree_inv_));
+    } else {
+        kem_->ntt_inverse_poly(state.s_dot_c1.data());
+    }
+
+    bool padding_valid = false;
+    ColorValue recovered_secret = kem_->decode_message(state.c2.data(), state.s_dot_c1.data(), padding_valid);
+    padding_valid &= state.reduced;
+    state.shake.finalize();
+    ColorValue secret = kem_->select_decapsulated_secret(recovered_secret, padding_valid, state.hint,
+                                                         kem_->rejection_secret(state.shake));
+    state.wipe();
+    return secret;
+}
+
+} // namespace clwe
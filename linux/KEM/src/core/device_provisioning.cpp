@@ -0,0 +1,162 @@
+#include "clwe/device_provisioning.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace clwe {
+
+namespace {
+
+using KeyPairs = std::vector<std::pair<ColorPublicKey, ColorPrivateKey>>;
+
+void wipe(KeyPairs& keys) {
+    for (auto& pair : keys) {
+        secure_zero(pair.second.secret_data.data(), pair.second.secret_data.size());
+    }
+    keys.clear();
+}
+
+// Batches are claimed in order by the workers and written in order by the caller; a
+// worker waits while batches_in_flight of them are derived or in progress but unwritten
+struct Schedule {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::map<size_t, KeyPairs> done;
+    size_t next_batch = 0;
+    size_t written = 0;
+    bool stop = false;
+    std::exception_ptr error;
+};
+
+} // namespace
+
+ProvisioningReport provision_devices(const ColorKEM& kem, const std::array<uint8_t, 32>& master_seed,
+                                     uint64_t first_device_id, size_t count, const std::string& archive_path,
+                                     const DevicePrivateKeySink& private_keys, const ProvisioningConfig& config) {
+    if (config.batch_size == 0) {
+        throw std::invalid_argument("Provisioning batch size must be positive");
+    }
+    if (count > 0 && first_device_id + (count - 1) < first_device_id) {
+        throw std::invalid_argument("Device id range overflows 64 bits");
+    }
+    const auto start = std::chrono::steady_clock::now();
+    KeyArchiveWriter writer(archive_path, kem.params(), config.archive);
+
+    const size_t batches = (count + config.batch_size - 1) / config.batch_size;
+    size_t threads = config.worker_threads;
+    if (threads == 0) {
+        threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    threads = std::max<size_t>(1, std::min(threads, batches));
+    const size_t in_flight = config.batches_in_flight != 0 ? config.batches_in_flight : 2 * threads;
+
+    Schedule schedule;
+    auto work = [&]() {
+        for (;;) {
+            size_t batch;
+            {
+                std::unique_lock<std::mutex> lock(schedule.mutex);
+                schedule.changed.wait(lock, [&] {
+                    return schedule.stop || schedule.next_batch >= batches ||
+                           schedule.next_batch < schedule.written + in_flight;
+                });
+                if (schedule.stop || schedule.next_batch >= batches) {
+                    return;
+                }
+                batch = schedule.next_batch++;
+            }
+            try {
+                const size_t first = batch * config.batch_size;
+                KeyPairs keys = kem.derive_keypair_batch(master_seed, first_device_id + first,
+                                                         std::min(config.batch_size, count - first));
+                std::lock_guard<std::mutex> lock(schedule.mutex);
+                schedule.done.emplace(batch, std::move(keys));
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(schedule.mutex);
+                if (!schedule.error) {
+                    schedule.error = std::current_exception();
+                }
+                schedule.stop = true;
+            }
+            schedule.changed.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back(work);
+    }
+    auto stop_workers = [&]() {
+        {
+            std::lock_guard<std::mutex> lock(schedule.mutex);
+            schedule.stop = true;
+        }
+        schedule.changed.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        workers.clear();
+        for (auto& entry : schedule.done) {
+            wipe(entry.second);
+        }
+        schedule.done.clear();
+    };
+
+    try {
+        for (size_t batch = 0; batch < batches; ++batch) {
+            KeyPairs keys;
+            {
+                std::unique_lock<std::mutex> lock(schedule.mutex);
+                schedule.changed.wait(lock, [&] { return schedule.error || schedule.done.count(batch) != 0; });
+                if (schedule.error) {
+                    std::rethrow_exception(schedule.error);
+                }
+                auto it = schedule.done.find(batch);
+                keys = std::move(it->second);
+                schedule.done.erase(it);
+            }
+
+            const uint64_t first_id = first_device_id + batch * config.batch_size;
+            try {
+                for (size_t i = 0; i < keys.size(); ++i) {
+                    writer.append(keys[i].first);
+                    if (private_keys) {
+                        private_keys(first_id + i, keys[i].second);
+                    }
+                }
+            } catch (...) {
+                wipe(keys);
+                throw;
+            }
+            wipe(keys);
+
+            {
+                std::lock_guard<std::mutex> lock(schedule.mutex);
+                schedule.written = batch + 1;
+            }
+            schedule.changed.notify_all();
+        }
+    } catch (...) {
+        stop_workers();
+        throw;
+    }
+    stop_workers();
+    writer.finish();
+
+    ProvisioningReport report;
+    report.devices = count;
+    report.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    const double seconds = std::chrono::duration<double>(report.elapsed).count();
+    report.devices_per_second = seconds > 0.0 ? static_cast<double>(count) / seconds : 0.0;
+    return report;
+}
+
+} // namespace clwe
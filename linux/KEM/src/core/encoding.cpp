@@ -0,0 +1,349 @@
+#include "encoding.hpp"
+#include "cpu_features.hpp"
+#include "ring_operations.hpp"
+#include "simd_target.hpp"
+#include "work_counters.hpp"
+#include <cstring>
+
+#ifdef HAVE_AVX2
+#include <immintrin.h>
+#endif
+#ifdef HAVE_NEON
+#include <arm_neon.h>
+#endif
+
+namespace clwe {
+
+namespace {
+
+// ByteEncode12 of one pair: a in the low 12 bits, b in the high 12 bits of 3 bytes
+void pack12_scalar(const ColorValue* coeffs, size_t count, uint8_t* out) {
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        uint32_t a = coeffs[i].to_math_value() & 0xFFF;
+        uint32_t b = coeffs[i + 1].to_math_value() & 0xFFF;
+        out[0] = static_cast<uint8_t>(a);
+        out[1] = static_cast<uint8_t>((a >> 8) | (b << 4));
+        out[2] = static_cast<uint8_t>(b >> 4);
+        out += 3;
+    }
+    if (i < count) {
+        // Odd tail: a lone coefficient takes two bytes
+        uint32_t a = coeffs[i].to_math_value() & 0xFFF;
+        out[0] = static_cast<uint8_t>(a);
+        out[1] = static_cast<uint8_t>(a >> 8);
+    }
+}
+
+// Returns a nonzero word if any coefficient is at or above modulus: (q - 1 - a) borrows
+// into the top bit exactly when a >= q, so the check never branches on coefficient data
+uint32_t unpack12_scalar(const uint8_t* in, size_t count, ColorValue* coeffs, uint32_t modulus) {
+    uint32_t bad = 0;
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        uint32_t a = static_cast<uint32_t>(in[0]) | ((static_cast<uint32_t>(in[1]) & 0x0F) << 8);
+        uint32_t b = (static_cast<uint32_t>(in[1]) >> 4) | (static_cast<uint32_t>(in[2]) << 4);
+        coeffs[i] = ColorValue::from_math_value(a);
+        coeffs[i + 1] = ColorValue::from_math_value(b);
+        bad |= (modulus - 1 - a) | (modulus - 1 - b);
+        in += 3;
+    }
+    if (i < count) {
+        uint32_t a = static_cast<uint32_t>(in[0]) | ((static_cast<uint32_t>(in[1]) & 0x0F) << 8);
+        coeffs[i] = ColorValue::from_math_value(a);
+        bad |= modulus - 1 - a;
+    }
+    return bad >> 31;
+}
+
+// COLOR32 words are full 32-bit values, so the borrow is taken in 64 bits. out may be
+// null to check coefficients in place.
+uint32_t color32_scalar(const uint8_t* in, size_t count, uint8_t* out, uint32_t modulus) {
+    uint64_t bad = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const uint8_t* word = in + 4 * i;
+        uint64_t value = (static_cast<uint64_t>(word[0]) << 24) | (static_cast<uint64_t>(word[1]) << 16) |
+                         (static_cast<uint64_t>(word[2]) << 8) | word[3];
+        bad |= uint64_t(modulus) - 1 - value;
+    }
+    if (out != nullptr) {
+        std::memcpy(out, in, count * 4);
+    }
+    return static_cast<uint32_t>(bad >> 63);
+}
+
+#ifdef HAVE_AVX2
+bool use_avx2() {
+    static const bool supported = CPUFeatureDetector::cached().has_avx2;
+    return supported;
+}
+
+// ColorValue stores its math value big-endian (r, g, b, a); this swaps each 32-bit lane
+CLWE_TARGET_AVX2 inline __m256i byteswap32(__m256i v) {
+    const __m256i mask = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                          3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    return _mm256_shuffle_epi8(v, mask);
+}
+
+// 8 coefficients per step -> 12 bytes. Each step stores 8 + 8 bytes at offsets 0 and 6, so
+// the loop keeps one full step in reserve for the scalar tail to overwrite the 2-byte spill.
+CLWE_TARGET_AVX2 size_t pack12_avx2(const ColorValue* coeffs, size_t count, uint8_t* out) {
+    const __m256i low12 = _mm256_set1_epi64x(0xFFF);
+    const __m256i high12 = _mm256_set1_epi64x(0xFFF000);
+    // Per 128-bit lane: the 3 bytes of each 64-bit pair packed to the front
+    const __m256i gather = _mm256_setr_epi8(0, 1, 2, 8, 9, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                            0, 1, 2, 8, 9, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 8) {
+        __m256i v = byteswap32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(coeffs + i)));
+        // Pair (a, b) in one 64-bit lane -> a | b << 12
+        __m256i pairs = _mm256_or_si256(_mm256_and_si256(v, low12),
+                                        _mm256_and_si256(_mm256_srli_epi64(v, 20), high12));
+        __m256i packed = _mm256_shuffle_epi8(pairs, gather);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm256_castsi256_si128(packed));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + 6), _mm256_extracti128_si256(packed, 1));
+        out += 12;
+    }
+    return i;
+}
+
+// Lanes at or above q: max(v, q) == v exactly when v >= q, unsigned
+CLWE_TARGET_AVX2 inline __m256i at_or_above(__m256i v, __m256i q) {
+    return _mm256_cmpeq_epi32(_mm256_max_epu32(v, q), v);
+}
+
+// 8 coefficients per step from 12 bytes; the 16-byte load reads 4 bytes of the next step.
+// Lanes at or above modulus are ORed into bad.
+CLWE_TARGET_AVX2 size_t unpack12_avx2(const uint8_t* in, size_t count, ColorValue* coeffs, uint32_t modulus,
+                                      uint32_t& bad) {
+    // Lane 0 decodes bytes 0..5, lane 1 bytes 6..11, two source bytes per coefficient
+    const __m256i spread = _mm256_setr_epi8(0, 1, -1, -1, 1, 2, -1, -1, 3, 4, -1, -1, 4, 5, -1, -1,
+                                            6, 7, -1, -1, 7, 8, -1, -1, 9, 10, -1, -1, 10, 11, -1, -1);
+    const __m256i shifts = _mm256_setr_epi32(0, 4, 0, 4, 0, 4, 0, 4);
+    const __m256i low12 = _mm256_set1_epi32(0xFFF);
+    const __m256i q = _mm256_set1_epi32(static_cast<int>(modulus));
+    __m256i over = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 16 <= count; i += 8) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+        __m256i v = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(bytes), spread);
+        v = _mm256_and_si256(_mm256_srlv_epi32(v, shifts), low12);
+        over = _mm256_or_si256(over, at_or_above(v, q));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(coeffs + i), byteswap32(v));
+        in += 12;
+    }
+    bad |= static_cast<uint32_t>(!_mm256_testz_si256(over, over));
+    return i;
+}
+
+// Copy (when out is set) and range check 8 big-endian words per step
+CLWE_TARGET_AVX2 size_t color32_avx2(const uint8_t* in, size_t count, uint8_t* out, uint32_t modulus,
+                                     uint32_t& bad) {
+    const __m256i q = _mm256_set1_epi32(static_cast<int>(modulus));
+    __m256i over = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i words = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 4 * i));
+        if (out != nullptr) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 4 * i), words);
+        }
+        over = _mm256_or_si256(over, at_or_above(byteswap32(words), q));
+    }
+    bad |= static_cast<uint32_t>(!_mm256_testz_si256(over, over));
+    return i;
+}
+#endif
+
+#ifdef HAVE_NEON
+size_t color32_neon(const uint8_t* in, size_t count, uint8_t* out, uint32_t modulus, uint32_t& bad) {
+    const uint32x4_t q = vdupq_n_u32(modulus);
+    uint32x4_t over = vdupq_n_u32(0);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        uint8x16_t words = vld1q_u8(in + 4 * i);
+        if (out != nullptr) {
+            vst1q_u8(out + 4 * i, words);
+        }
+        over = vorrq_u32(over, vcgeq_u32(vreinterpretq_u32_u8(vrev32q_u8(words)), q));
+    }
+    bad |= vmaxvq_u32(over) != 0;
+    return i;
+}
+#endif
+
+// Decode with the range check; returns nonzero if a coefficient is at or above modulus
+uint32_t decode_checked(const uint8_t* in, size_t count, CoefficientEncoding encoding, uint32_t modulus,
+                        ColorValue* coeffs) {
+    uint32_t bad = 0;
+    size_t done = 0;
+    if (encoding == CoefficientEncoding::PACKED12) {
+#ifdef HAVE_AVX2
+        if (use_avx2()) {
+            done = unpack12_avx2(in, count, coeffs, modulus, bad);
+        }
+#endif
+        return bad | unpack12_scalar(in + done / 2 * 3, count - done, coeffs + done, modulus);
+    }
+
+    uint8_t* out = reinterpret_cast<uint8_t*>(coeffs);
+#ifdef HAVE_AVX2
+    if (use_avx2()) {
+        done = color32_avx2(in, count, out, modulus, bad);
+    }
+#elif defined(HAVE_NEON)
+    done = color32_neon(in, count, out, modulus, bad);
+#endif
+    return bad | color32_scalar(in + 4 * done, count - done, out == nullptr ? nullptr : out + 4 * done, modulus);
+}
+
+} // namespace
+
+size_t compressed_coefficients_size(size_t count, uint32_t bits) {
+    return (count * bits + 7) / 8;
+}
+
+void compress_encode_coefficients(const ColorValue* coeffs, size_t count, uint32_t bits, uint32_t modulus,
+                                  uint8_t* out) {
+    count_work(WorkCounter::COEFFICIENTS_PACKED, count);
+    uint64_t acc = 0;
+    uint32_t acc_bits = 0;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t y = compress_coefficient(coeffs[i].to_math_value(), bits, modulus);
+        acc |= y << acc_bits;
+        acc_bits += bits;
+        while (acc_bits >= 8) {
+            *out++ = static_cast<uint8_t>(acc);
+            acc >>= 8;
+            acc_bits -= 8;
+        }
+    }
+    if (acc_bits > 0) {
+        *out = static_cast<uint8_t>(acc);
+    }
+}
+
+void decode_decompress_coefficients(const uint8_t* in, size_t count, uint32_t bits, uint32_t modulus,
+                                    ColorValue* coeffs) {
+    const uint64_t mask = (uint64_t{1} << bits) - 1;
+
+    uint64_t acc = 0;
+    uint32_t acc_bits = 0;
+    for (size_t i = 0; i < count; ++i) {
+        while (acc_bits < bits) {
+            acc |= static_cast<uint64_t>(*in++) << acc_bits;
+            acc_bits += 8;
+        }
+        uint64_t y = acc & mask;
+        acc >>= bits;
+        acc_bits -= bits;
+        coeffs[i] = ColorValue::from_math_value(decompress_coefficient(static_cast<uint32_t>(y), bits, modulus));
+    }
+}
+
+void round_encode_coefficients(const ColorValue* coeffs, size_t count, uint32_t dropped_bits, uint32_t bits,
+                               uint8_t* out) {
+    count_work(WorkCounter::COEFFICIENTS_PACKED, count);
+    const uint32_t half = (1u << (dropped_bits - 1)) - 1;
+    uint64_t acc = 0;
+    uint32_t acc_bits = 0;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t t1 = (coeffs[i].to_math_value() + half) >> dropped_bits;
+        acc |= t1 << acc_bits;
+        acc_bits += bits;
+        while (acc_bits >= 8) {
+            *out++ = static_cast<uint8_t>(acc);
+            acc >>= 8;
+            acc_bits -= 8;
+        }
+    }
+    if (acc_bits > 0) {
+        *out = static_cast<uint8_t>(acc);
+    }
+}
+
+bool decode_unround_coefficients(const uint8_t* in, size_t count, uint32_t dropped_bits, uint32_t bits,
+                                 uint32_t modulus, ColorValue* coeffs) {
+    const uint64_t mask = (uint64_t{1} << bits) - 1;
+    const uint32_t max_t1 = (modulus - 1 + (1u << (dropped_bits - 1)) - 1) >> dropped_bits;
+
+    // Bit 31 of (max_t1 - t1) is set for any t1 out of range; t1 * 2^d stays below 2q
+    uint32_t out_of_range = 0;
+    uint64_t acc = 0;
+    uint32_t acc_bits = 0;
+    for (size_t i = 0; i < count; ++i) {
+        while (acc_bits < bits) {
+            acc |= static_cast<uint64_t>(*in++) << acc_bits;
+            acc_bits += 8;
+        }
+        uint32_t t1 = static_cast<uint32_t>(acc & mask);
+        acc >>= bits;
+        acc_bits -= bits;
+        out_of_range |= max_t1 - t1;
+        uint32_t t = t1 << dropped_bits;
+        uint32_t reduced = t - modulus;
+        t = reduced + (modulus & (0u - (reduced >> 31)));
+        coeffs[i] = ColorValue::from_math_value(t);
+    }
+    return (out_of_range >> 31) == 0;
+}
+
+size_t encoded_coefficients_size(size_t count, CoefficientEncoding encoding) {
+    switch (encoding) {
+        case CoefficientEncoding::PACKED12:
+            return count / 2 * 3 + (count % 2) * 2;
+        case CoefficientEncoding::COLOR32:
+        default:
+            return count * 4;
+    }
+}
+
+void encode_coefficients(const ColorValue* coeffs, size_t count, CoefficientEncoding encoding, uint8_t* out) {
+    count_work(WorkCounter::COEFFICIENTS_PACKED, count);
+    if (encoding == CoefficientEncoding::PACKED12) {
+        size_t done = 0;
+#ifdef HAVE_AVX2
+        if (use_avx2()) {
+            done = pack12_avx2(coeffs, count, out);
+        }
+#endif
+        pack12_scalar(coeffs + done, count - done, out + done / 2 * 3);
+        return;
+    }
+
+    // The color layout (r, g, b, a) already is the big-endian math value
+    static_assert(sizeof(ColorValue) == 4, "ColorValue must be 4 packed bytes");
+    std::memcpy(out, coeffs, count * 4);
+}
+
+void decode_coefficients(const uint8_t* in, size_t count, CoefficientEncoding encoding, ColorValue* coeffs) {
+    if (encoding == CoefficientEncoding::PACKED12) {
+        // No 12-bit value reaches 4096, so the fused check is a no-op here
+        decode_checked(in, count, encoding, 4096, coeffs);
+        return;
+    }
+
+    std::memcpy(coeffs, in, count * 4);
+}
+
+bool decode_coefficients_checked(const uint8_t* in, size_t count, CoefficientEncoding encoding, uint32_t modulus,
+                                 ColorValue* coeffs) {
+    return decode_checked(in, count, encoding, modulus, coeffs) == 0;
+}
+
+bool coefficients_reduced(const ColorValue* coeffs, size_t count, uint32_t modulus) {
+    // The color layout is the COLOR32 encoding, so the COLOR32 kernel checks in place
+    static_assert(sizeof(ColorValue) == 4, "ColorValue must be 4 packed bytes");
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(coeffs);
+    uint32_t bad = 0;
+    size_t done = 0;
+#ifdef HAVE_AVX2
+    if (use_avx2()) {
+        done = color32_avx2(bytes, count, nullptr, modulus, bad);
+    }
+#elif defined(HAVE_NEON)
+    done = color32_neon(bytes, count, nullptr, modulus, bad);
+#endif
+    return (bad | color32_scalar(bytes + 4 * done, count - done, nullptr, modulus)) == 0;
+}
+
+} // namespace clwe
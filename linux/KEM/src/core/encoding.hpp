@@ -0,0 +1,57 @@
+#ifndef ENCODING_HPP
+#define ENCODING_HPP
+
+#include "color_value.hpp"
+#include "clwe/clwe.hpp"
+#include <cstdint>
+#include <cstddef>
+
+namespace clwe {
+
+// Serialized size of count coefficients under the given encoding
+size_t encoded_coefficients_size(size_t count, CoefficientEncoding encoding);
+
+// Write count coefficients to out, which must hold encoded_coefficients_size(count, encoding) bytes.
+// PACKED12 keeps the low 12 bits of each math value, so coefficients must be reduced mod q.
+void encode_coefficients(const ColorValue* coeffs, size_t count, CoefficientEncoding encoding, uint8_t* out);
+
+// Inverse of encode_coefficients
+void decode_coefficients(const uint8_t* in, size_t count, CoefficientEncoding encoding, ColorValue* coeffs);
+
+// decode_coefficients that also returns whether every coefficient is below modulus (the
+// FIPS 203 modulus check). The compare is fused into the unpack loop, vectorized where
+// the unpack is, and never branches on coefficient values.
+bool decode_coefficients_checked(const uint8_t* in, size_t count, CoefficientEncoding encoding, uint32_t modulus,
+                                 ColorValue* coeffs);
+
+// The same check on coefficients already in memory
+bool coefficients_reduced(const ColorValue* coeffs, size_t count, uint32_t modulus);
+
+// Serialized size of count values of the given bit width (ByteEncode_d)
+size_t compressed_coefficients_size(size_t count, uint32_t bits);
+
+// Compress_d then ByteEncode_d: round(2^d / q * x) mod 2^d, packed little-endian.
+// Rounding is a multiply and shift, never a division, so timing does not depend on x.
+// Requires coefficients reduced mod q, q <= 4096 and 1 <= bits <= 11.
+void compress_encode_coefficients(const ColorValue* coeffs, size_t count, uint32_t bits, uint32_t modulus,
+                                  uint8_t* out);
+
+// ByteDecode_d then Decompress_d: round(q / 2^d * y)
+void decode_decompress_coefficients(const uint8_t* in, size_t count, uint32_t bits, uint32_t modulus,
+                                    ColorValue* coeffs);
+
+// Power2Round then ByteEncode_bits: t1 = (x + 2^(d-1) - 1) >> d for each x, packed
+// little-endian at bits per value (CLWEParameters::rounded_t_bits). Requires coefficients
+// reduced mod q and 1 <= dropped_bits.
+void round_encode_coefficients(const ColorValue* coeffs, size_t count, uint32_t dropped_bits, uint32_t bits,
+                               uint8_t* out);
+
+// ByteDecode_bits then t1 * 2^d mod q. Returns whether every t1 is one Power2Round can
+// produce for modulus, checked without branching on the values like
+// decode_coefficients_checked.
+bool decode_unround_coefficients(const uint8_t* in, size_t count, uint32_t dropped_bits, uint32_t bits,
+                                 uint32_t modulus, ColorValue* coeffs);
+
+} // namespace clwe
+
+#endif // ENCODING_HPP
@@ -0,0 +1,331 @@
+#include "clwe/hybrid_kem.hpp"
+#include "clwe/shake_sampler.hpp"
+#include "utils.hpp"
+#include "worker_thread.hpp"
+#include "x25519.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+namespace clwe {
+
+namespace {
+
+static_assert(HYBRID_X25519_BYTES == X25519_BYTES, "HybridKEM X25519 sizes");
+
+constexpr char KDF_LABEL[] = "CLWE-X25519-ColorKEM-v1";
+
+void check_size(size_t size, size_t expected, const char* what) {
+    if (size != expected) {
+        throw std::invalid_argument(std::string("Invalid hybrid ") + what + " size: expected " +
+                                    std::to_string(expected) + " bytes, got " + std::to_string(size));
+    }
+}
+
+void check_output(const uint8_t* out, size_t out_size, size_t size) {
+    if (out == nullptr || out_size < size) {
+        throw std::invalid_argument("Output buffer too small: need " + std::to_string(size) + " bytes, got " +
+                                    std::to_string(out_size));
+    }
+}
+
+// X25519 of a secret scalar and a peer key; an all-zero result means the peer sent a
+// point of small order, which contributes nothing secret. The check is branch-free
+// until its verdict, which depends only on the public point
+void x25519_shared(uint8_t out[X25519_BYTES], const uint8_t secret[X25519_BYTES], const uint8_t peer[X25519_BYTES]) {
+    x25519(out, secret, peer);
+    uint8_t any = 0;
+    for (size_t i = 0; i < X25519_BYTES; ++i) {
+        any |= out[i];
+    }
+    if (any == 0) {
+        throw std::invalid_argument("X25519 public key has small order");
+    }
+}
+
+// SHAKE256(label || K_color || K_x25519 || ephemeral pk || static pk || color ciphertext)
+SharedSecret combine(const SharedSecret& color_secret, const uint8_t x25519_secret[X25519_BYTES],
+                     const uint8_t ephemeral_public[X25519_BYTES], const uint8_t static_public[X25519_BYTES],
+                     const ColorCiphertext& ciphertext) {
+    SHAKE256Sampler kdf;
+    kdf.begin();
+    kdf.absorb(reinterpret_cast<const uint8_t*>(KDF_LABEL), sizeof(KDF_LABEL) - 1);
+    kdf.absorb(color_secret.data(), color_secret.size());
+    kdf.absorb(x25519_secret, X25519_BYTES);
+    kdf.absorb(ephemeral_public, X25519_BYTES);
+    kdf.absorb(static_public, X25519_BYTES);
+    kdf.absorb(ciphertext.ciphertext_data.data(), ciphertext.ciphertext_data.size());
+    kdf.absorb(ciphertext.shared_secret_hint.data(), ciphertext.shared_secret_hint.size());
+    kdf.finalize();
+    SharedSecret key;
+    kdf.squeeze(key.data(), key.size());
+    return key;
+}
+
+// Wipes a secret buffer on every way out of a scope
+struct SecretWipe {
+    void* data;
+    size_t size;
+    ~SecretWipe() { secure_zero(data, size); }
+};
+
+// The X25519 half of one operation, handed to the executor. Whichever of the executor
+// and the calling thread claims it first runs it; the other side skips or waits
+struct Lane {
+    std::function<void()> work;
+    std::atomic<bool> claimed{false};
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+    std::exception_ptr error;
+};
+
+// classical() on the executor next to lattice() on the calling thread. A lane the
+// executor has not started when lattice() returns runs inline, so a busy or stopped
+// pool costs a + b rather than a deadlock; a posted job that starts later finds the
+// lane claimed and returns. The lane holds references into the caller's frame, so
+// this never returns while the executor is still inside it
+template <typename Classical, typename Lattice>
+void run_lanes(const AsyncKemPost& post, Classical&& classical, Lattice&& lattice) {
+    auto lane = std::make_shared<Lane>();
+    lane->work = classical;
+    try {
+        post([lane] {
+            if (lane->claimed.exchange(true)) {
+                return;
+            }
+            std::exception_ptr error;
+            try {
+                lane->work();
+            } catch (...) {
+                error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(lane->mutex);
+            lane->error = error;
+            lane->done = true;
+            lane->cv.notify_all();
+        });
+    } catch (...) {
+        // The executor refused the job; the inline fallback below runs it
+    }
+
+    auto join = [&lane](bool run_inline) {
+        if (!lane->claimed.exchange(true)) {
+            if (run_inline) {
+                lane->work();
+            }
+            return;
+        }
+        std::unique_lock<std::mutex> lock(lane->mutex);
+        lane->cv.wait(lock, [&lane] { return lane->done; });
+        if (lane->error && run_inline) {
+            std::rethrow_exception(lane->error);
+        }
+    };
+
+    try {
+        lattice();
+    } catch (...) {
+        join(false);
+        throw;
+    }
+    join(true);
+}
+
+} // namespace
+
+std::vector<uint8_t> HybridPublicKey::serialize() const {
+    std::vector<uint8_t> data(serialized_size(color.params));
+    serialize(data.data(), data.size());
+    return data;
+}
+
+size_t HybridPublicKey::serialize(uint8_t* out, size_t out_size) const {
+    const size_t size = serialized_size(color.params);
+    check_output(out, out_size, size);
+    std::memcpy(out, x25519.data(), X25519_BYTES);
+    color.serialize(out + X25519_BYTES, size - X25519_BYTES);
+    return size;
+}
+
+HybridPublicKey HybridPublicKey::deserialize(const uint8_t* data, size_t size, const CLWEParameters& params) {
+    check_size(data == nullptr ? 0 : size, serialized_size(params), "public key");
+    HybridPublicKey key;
+    std::memcpy(key.x25519.data(), data, X25519_BYTES);
+    key.color = ColorPublicKey::deserialize(data + X25519_BYTES, size - X25519_BYTES, params);
+    return key;
+}
+
+HybridPublicKey HybridPublicKey::deserialize(const std::vector<uint8_t>& data, const CLWEParameters& params) {
+    return deserialize(data.data(), data.size(), params);
+}
+
+size_t HybridPublicKey::serialized_size(const CLWEParameters& params) {
+    return X25519_BYTES + ColorPublicKey::serialized_size(params);
+}
+
+std::vector<uint8_t> HybridPrivateKey::serialize() const {
+    std::vector<uint8_t> data(serialized_size(color.params));
+    serialize(data.data(), data.size());
+    return data;
+}
+
+size_t HybridPrivateKey::serialize(uint8_t* out, size_t out_size) const {
+    const size_t size = serialized_size(color.params);
+    check_output(out, out_size, size);
+    std::memcpy(out, x25519_secret.data(), X25519_BYTES);
+    std::memcpy(out + X25519_BYTES, x25519_public.data(), X25519_BYTES);
+    color.serialize(out + 2 * X25519_BYTES, size - 2 * X25519_BYTES);
+    return size;
+}
+
+HybridPrivateKey HybridPrivateKey::deserialize(const uint8_t* data, size_t size, const CLWEParameters& params) {
+    check_size(data == nullptr ? 0 : size, serialized_size(params), "private key");
+    HybridPrivateKey key;
+    std::memcpy(key.x25519_secret.data(), data, X25519_BYTES);
+    std::memcpy(key.x25519_public.data(), data + X25519_BYTES, X25519_BYTES);
+
+    uint8_t expected[X25519_BYTES];
+    x25519_base(expected, key.x25519_secret.data());
+    uint8_t difference = 0;
+    for (size_t i = 0; i < X25519_BYTES; ++i) {
+        difference |= static_cast<uint8_t>(expected[i] ^ key.x25519_public[i]);
+    }
+    if (difference != 0) {
+        secure_zero(key.x25519_secret.data(), X25519_BYTES);
+        throw std::invalid_argument("Hybrid private key: X25519 public key does not match its scalar");
+    }
+    key.color = ColorExpandedPrivateKey::deserialize(data + 2 * X25519_BYTES, size - 2 * X25519_BYTES, params);
+    return key;
+}
+
+HybridPrivateKey HybridPrivateKey::deserialize(const std::vector<uint8_t>& data, const CLWEParameters& params) {
+    return deserialize(data.data(), data.size(), params);
+}
+
+size_t HybridPrivateKey::serialized_size(const CLWEParameters& params) {
+    return 2 * X25519_BYTES + ColorExpandedPrivateKey::serialized_size(params);
+}
+
+std::vector<uint8_t> HybridCiphertext::serialize() const {
+    std::vector<uint8_t> data(serialized_size(color.params));
+    serialize(data.data(), data.size());
+    return data;
+}
+
+size_t HybridCiphertext::serialize(uint8_t* out, size_t out_size) const {
+    const size_t size = serialized_size(color.params);
+    check_output(out, out_size, size);
+    std::memcpy(out, x25519.data(), X25519_BYTES);
+    color.serialize(out + X25519_BYTES, size - X25519_BYTES);
+    return size;
+}
+
+HybridCiphertext HybridCiphertext::deserialize(const uint8_t* data, size_t size, const CLWEParameters& params) {
+    check_size(data == nullptr ? 0 : size, serialized_size(params), "ciphertext");
+    HybridCiphertext ciphertext;
+    std::memcpy(ciphertext.x25519.data(), data, X25519_BYTES);
+    ciphertext.color = ColorCiphertext::deserialize(data + X25519_BYTES, size - X25519_BYTES, params);
+    return ciphertext;
+}
+
+HybridCiphertext HybridCiphertext::deserialize(const std::vector<uint8_t>& data, const CLWEParameters& params) {
+    return deserialize(data.data(), data.size(), params);
+}
+
+size_t HybridCiphertext::serialized_size(const CLWEParameters& params) {
+    return X25519_BYTES + ColorCiphertext::serialized_size(params);
+}
+
+struct HybridKEM::Impl {
+    const ColorKEM kem;
+    std::unique_ptr<WorkerThread> worker;
+    AsyncKemPost post;
+
+    Impl(const CLWEParameters& params, AsyncKemPost executor) : kem(params) {
+        if (params.degree < ColorKEM::KEY_MESSAGE_BITS || params.sparse_c2) {
+            throw std::invalid_argument("HybridKEM needs parameters with the 256-bit key mode");
+        }
+        if (executor) {
+            post = std::move(executor);
+        } else {
+            worker.reset(new WorkerThread());
+            WorkerThread* thread = worker.get();
+            post = [thread](std::function<void()> job) { thread->post(std::move(job)); };
+        }
+    }
+};
+
+HybridKEM::HybridKEM(const CLWEParameters& params, AsyncKemPost post) : impl_(new Impl(params, std::move(post))) {}
+
+HybridKEM::~HybridKEM() = default;
+
+const CLWEParameters& HybridKEM::params() const {
+    return impl_->kem.params();
+}
+
+std::pair<HybridPublicKey, HybridPrivateKey> HybridKEM::keygen() const {
+    HybridPublicKey public_key;
+    HybridPrivateKey private_key;
+    run_lanes(
+        impl_->post,
+        [&] {
+            secure_random_bytes(private_key.x25519_secret.data(), X25519_BYTES);
+            x25519_base(private_key.x25519_public.data(), private_key.x25519_secret.data());
+        },
+        [&] {
+            auto key_pair = impl_->kem.keygen();
+            private_key.color = impl_->kem.expand_private_key(key_pair.first, key_pair.second);
+            secure_zero(key_pair.second.secret_data.data(), key_pair.second.secret_data.size());
+            public_key.color = std::move(key_pair.first);
+        });
+    public_key.x25519 = private_key.x25519_public;
+    return {std::move(public_key), std::move(private_key)};
+}
+
+std::pair<HybridCiphertext, SharedSecret> HybridKEM::encapsulate(const HybridPublicKey& public_key) const {
+    HybridCiphertext ciphertext;
+    SharedSecret color_secret;
+    uint8_t x25519_secret[X25519_BYTES] = {};
+    SecretWipe wipe_color{color_secret.data(), color_secret.size()};
+    SecretWipe wipe_x25519{x25519_secret, X25519_BYTES};
+    run_lanes(
+        impl_->post,
+        [&] {
+            uint8_t ephemeral[X25519_BYTES];
+            SecretWipe wipe_ephemeral{ephemeral, X25519_BYTES};
+            secure_random_bytes(ephemeral, X25519_BYTES);
+            x25519_base(ciphertext.x25519.data(), ephemeral);
+            x25519_shared(x25519_secret, ephemeral, public_key.x25519.data());
+        },
+        [&] {
+            auto encapsulated = impl_->kem.encapsulate_key(public_key.color);
+            ciphertext.color = std::move(encapsulated.first);
+            color_secret = encapsulated.second;
+            secure_zero(encapsulated.second.data(), encapsulated.second.size());
+        });
+
+    SharedSecret shared_key =
+        combine(color_secret, x25519_secret, ciphertext.x25519.data(), public_key.x25519.data(), ciphertext.color);
+    return {std::move(ciphertext), shared_key};
+}
+
+SharedSecret HybridKEM::decapsulate(const HybridPrivateKey& private_key, const HybridCiphertext& ciphertext) const {
+    SharedSecret color_secret;
+    uint8_t x25519_secret[X25519_BYTES] = {};
+    SecretWipe wipe_color{color_secret.data(), color_secret.size()};
+    SecretWipe wipe_x25519{x25519_secret, X25519_BYTES};
+    run_lanes(
+        impl_->post,
+        [&] { x25519_shared(x25519_secret, private_key.x25519_secret.data(), ciphertext.x25519.data()); },
+        [&] { color_secret = impl_->kem.decapsulate_key(private_key.color, ciphertext.color); });
+
+    return combine(color_secret, x25519_secret, ciphertext.x25519.data(), private_key.x25519_public.data(),
+                   ciphertext.color);
+}
+
+} // namespace clwe
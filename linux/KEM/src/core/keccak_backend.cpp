@@ -0,0 +1,248 @@
+#include "clwe/keccak_backend.hpp"
+#include "keccak_x4.hpp"
+#include "shake_sampler.hpp"
+#include "cpu_features.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef CLWE_HAVE_XKCP
+extern "C" {
+#include <KeccakP-1600-SnP.h>
+}
+#endif
+
+namespace clwe {
+
+namespace {
+
+// Bundled permutation on a canonical byte-order state; sha3_keccakf fixes up the
+// word order itself on big-endian targets
+void reference_initialize(void* state) {
+    std::memset(state, 0, 200);
+}
+
+void reference_add_bytes(void* state, const uint8_t* data, size_t offset, size_t length) {
+    uint8_t* bytes = static_cast<uint8_t*>(state) + offset;
+    for (size_t i = 0; i < length; ++i) {
+        bytes[i] ^= data[i];
+    }
+}
+
+void reference_extract_bytes(const void* state, uint8_t* out, size_t offset, size_t length) {
+    std::memcpy(out, static_cast<const uint8_t*>(state) + offset, length);
+}
+
+void reference_permute(void* state) {
+    sha3_keccakf(static_cast<uint64_t*>(state));
+}
+
+constexpr KeccakOps REFERENCE_OPS = {
+    reference_initialize, reference_add_bytes, reference_extract_bytes, reference_permute
+};
+
+#ifdef HAVE_ARM_SHA3
+void arm_sha3_permute(void* state) {
+    keccakf1600_armsha3(static_cast<uint64_t*>(state));
+}
+
+constexpr KeccakOps ARM_SHA3_OPS = {
+    reference_initialize, reference_add_bytes, reference_extract_bytes, arm_sha3_permute
+};
+#endif
+
+#ifdef CLWE_HAVE_XKCP
+static_assert(KeccakP1600_stateSizeInBytes <= 200, "XKCP state must fit KeccakSponge");
+static_assert(KeccakP1600_stateAlignment <= 64, "XKCP state alignment must fit KeccakSponge");
+
+void xkcp_initialize(void* state) {
+    KeccakP1600_Initialize(state);
+}
+
+void xkcp_add_bytes(void* state, const uint8_t* data, size_t offset, size_t length) {
+    KeccakP1600_AddBytes(state, data, static_cast<unsigned int>(offset), static_cast<unsigned int>(length));
+}
+
+void xkcp_extract_bytes(const void* state, uint8_t* out, size_t offset, size_t length) {
+    KeccakP1600_ExtractBytes(state, out, static_cast<unsigned int>(offset), static_cast<unsigned int>(length));
+}
+
+void xkcp_permute(void* state) {
+    KeccakP1600_Permute_24rounds(state);
+}
+
+constexpr KeccakOps XKCP_OPS = {xkcp_initialize, xkcp_add_bytes, xkcp_extract_bytes, xkcp_permute};
+#endif
+
+// Default-selection order, fastest first
+constexpr KeccakBackend PREFERENCE[] = {
+    KeccakBackend::XKCP, KeccakBackend::ArmSha3, KeccakBackend::OpenSSL, KeccakBackend::Simd,
+    KeccakBackend::Reference
+};
+
+KeccakBackend initial_backend() {
+    KeccakBackend backend;
+    const char* env = std::getenv("CLWE_KECCAK_BACKEND");
+    if (env != nullptr && parse_keccak_backend(env, backend) && keccak_backend_available(backend)) {
+        return backend;
+    }
+    return available_keccak_backends().front();
+}
+
+std::atomic<KeccakBackend>& current_backend() {
+    static std::atomic<KeccakBackend> backend{initial_backend()};
+    return backend;
+}
+
+} // namespace
+
+bool keccak_backend_available(KeccakBackend backend) {
+    switch (backend) {
+        case KeccakBackend::Reference:
+            return true;
+        case KeccakBackend::Simd:
+#ifdef HAVE_AVX2
+            if (CPUFeatureDetector::cached().has_avx2) {
+                return true;
+            }
+#endif
+            return keccak_arm_sha3_supported() || keccak_wasm_simd128_supported();
+        case KeccakBackend::ArmSha3:
+            return keccak_arm_sha3_supported();
+        case KeccakBackend::OpenSSL:
+#ifdef CLWE_HAVE_EVP_DIGEST_SQUEEZE
+            return shake_evp_md(SHAKE128_RATE) != nullptr && shake_evp_md(SHAKE256_RATE) != nullptr;
+#else
+            return false;
+#endif
+        case KeccakBackend::XKCP:
+#ifdef CLWE_HAVE_XKCP
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+std::vector<KeccakBackend> available_keccak_backends() {
+    std::vector<KeccakBackend> backends;
+    for (KeccakBackend backend : PREFERENCE) {
+        if (keccak_backend_available(backend)) {
+            backends.push_back(backend);
+        }
+    }
+    return backends;
+}
+
+KeccakBackend keccak_backend() {
+    return current_backend().load(std::memory_order_acquire);
+}
+
+void set_keccak_backend(KeccakBackend backend) {
+    if (!keccak_backend_available(backend)) {
+        throw std::invalid_argument(std::string("Keccak backend not available: ") + keccak_backend_name(backend));
+    }
+    current_backend().store(backend, std::memory_order_release);
+}
+
+const char* keccak_backend_name(KeccakBackend backend) {
+    switch (backend) {
+        case KeccakBackend::Reference: return "reference";
+        case KeccakBackend::Simd: return "simd";
+        case KeccakBackend::ArmSha3: return "armsha3";
+        case KeccakBackend::OpenSSL: return "openssl";
+        case KeccakBackend::XKCP: return "xkcp";
+    }
+    return "unknown";
+}
+
+bool parse_keccak_backend(const std::string& name, KeccakBackend& backend) {
+    if (name == "reference") backend = KeccakBackend::Reference;
+    else if (name == "simd") backend = KeccakBackend::Simd;
+    else if (name == "armsha3") backend = KeccakBackend::ArmSha3;
+    else if (name == "openssl") backend = KeccakBackend::OpenSSL;
+    else if (name == "xkcp") backend = KeccakBackend::XKCP;
+    else return false;
+    return true;
+}
+
+const KeccakOps* keccak_ops(KeccakBackend backend) {
+    switch (backend) {
+#ifdef CLWE_HAVE_EVP_DIGEST_SQUEEZE
+        case KeccakBackend::OpenSSL:
+            return nullptr;
+#endif
+#ifdef HAVE_ARM_SHA3
+        case KeccakBackend::ArmSha3:
+            return &ARM_SHA3_OPS;
+#endif
+#ifdef CLWE_HAVE_XKCP
+        case KeccakBackend::XKCP:
+            return &XKCP_OPS;
+#endif
+        default:
+            return &REFERENCE_OPS;
+    }
+}
+
+#ifdef CLWE_HAVE_EVP_DIGEST_SQUEEZE
+const EVP_MD* shake_evp_md(size_t rate) {
+    // Process-lifetime fetches; EVP_shake*() would repeat the provider lookup on every init
+    static EVP_MD* shake128 = EVP_MD_fetch(nullptr, "SHAKE128", nullptr);
+    static EVP_MD* shake256 = EVP_MD_fetch(nullptr, "SHAKE256", nullptr);
+    return rate == SHAKE128_RATE ? shake128 : shake256;
+}
+#endif
+
+KeccakF1600x4Fn keccakf1600_x4_for(KeccakBackend backend) {
+    return backend == KeccakBackend::Reference ? keccakf1600_x4_scalar : keccakf1600_x4;
+}
+
+void KeccakSponge::begin(const KeccakOps* ops, size_t rate) {
+    ops_ = ops;
+    rate_ = rate;
+    pos_ = 0;
+    ops_->initialize(state_);
+}
+
+void KeccakSponge::absorb(const uint8_t* data, size_t len) {
+    while (len > 0) {
+        size_t chunk = std::min(len, rate_ - pos_);
+        ops_->add_bytes(state_, data, pos_, chunk);
+        pos_ += chunk;
+        data += chunk;
+        len -= chunk;
+        if (pos_ == rate_) {
+            ops_->permute(state_);
+            pos_ = 0;
+        }
+    }
+}
+
+void KeccakSponge::finalize() {
+    const uint8_t domain = 0x1F;
+    const uint8_t last = 0x80;
+    ops_->add_bytes(state_, &domain, pos_, 1);
+    ops_->add_bytes(state_, &last, rate_ - 1, 1);
+    ops_->permute(state_);
+    pos_ = 0;
+}
+
+void KeccakSponge::squeeze(uint8_t* out, size_t len) {
+    while (len > 0) {
+        if (pos_ == rate_) {
+            ops_->permute(state_);
+            pos_ = 0;
+        }
+        size_t chunk = std::min(len, rate_ - pos_);
+        ops_->extract_bytes(state_, out, pos_, chunk);
+        pos_ += chunk;
+        out += chunk;
+        len -= chunk;
+    }
+}
+
+} // namespace clwe
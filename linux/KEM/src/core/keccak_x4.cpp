@@ -0,0 +1,341 @@
+#include "keccak_x4.hpp"
+#include "cpu_features.hpp"
+#include "simd_target.hpp"
+
+#ifdef HAVE_AVX2
+#include <immintrin.h>
+#endif
+#ifdef HAVE_ARM_SHA3
+#include <arm_neon.h>
+#endif
+#ifdef HAVE_WASM_SIMD128
+#include <wasm_simd128.h>
+#endif
+
+namespace clwe {
+
+namespace {
+
+constexpr uint64_t ROUND_CONSTANTS[24] = {
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL,
+    0x8000000080008000ULL, 0x000000000000808bULL, 0x0000000080000001ULL,
+    0x8000000080008081ULL, 0x8000000000008009ULL, 0x000000000000008aULL,
+    0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+    0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL,
+    0x8000000000008003ULL, 0x8000000000008002ULL, 0x8000000000000080ULL,
+    0x000000000000800aULL, 0x800000008000000aULL, 0x8000000080008081ULL,
+    0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+};
+constexpr int RHO_OFFSETS[24] = {
+    1,  3,  6,  10, 15, 21, 28, 36, 45, 55, 2,  14,
+    27, 41, 56, 8,  25, 43, 62, 18, 39, 61, 20, 44
+};
+constexpr int PI_LANES[24] = {
+    10, 7,  11, 17, 18, 3, 5,  16, 8,  21, 24, 4,
+    15, 23, 19, 13, 12, 2, 20, 14, 22, 9,  6,  1
+};
+
+// Lane operations for one 64-bit state word
+struct ScalarLanes {
+    using V = uint64_t;
+    static V bxor(V a, V b) { return a ^ b; }
+    static V andnot(V a, V b) { return ~a & b; }
+    static V rotl(V a, int n) { return (a << n) | (a >> (64 - n)); }
+    static V constant(uint64_t c) { return c; }
+};
+
+#ifdef HAVE_AVX2
+// Lane operations for the same word of four states at once
+struct AVX2Lanes {
+    using V = __m256i;
+    CLWE_TARGET_AVX2 static V bxor(V a, V b) { return _mm256_xor_si256(a, b); }
+    CLWE_TARGET_AVX2 static V andnot(V a, V b) { return _mm256_andnot_si256(a, b); }
+    CLWE_TARGET_AVX2 static V rotl(V a, int n) {
+        return _mm256_or_si256(_mm256_sll_epi64(a, _mm_cvtsi32_si128(n)),
+                               _mm256_srl_epi64(a, _mm_cvtsi32_si128(64 - n)));
+    }
+    CLWE_TARGET_AVX2 static V constant(uint64_t c) { return _mm256_set1_epi64x(static_cast<long long>(c)); }
+};
+#endif
+
+#ifdef HAVE_WASM_SIMD128
+// Lane operations for the same word of two states; SIMD128 has no 64-bit rotate, so
+// rotl is two shifts and an OR
+struct WasmLanes {
+    using V = v128_t;
+    static V bxor(V a, V b) { return wasm_v128_xor(a, b); }
+    static V andnot(V a, V b) { return wasm_v128_andnot(b, a); }
+    static V rotl(V a, int n) { return wasm_v128_or(wasm_i64x2_shl(a, n), wasm_u64x2_shr(a, 64 - n)); }
+    static V constant(uint64_t c) { return wasm_u64x2_splat(c); }
+};
+#endif
+
+// The tiny_sha3 round structure, generic over the lane type. Always inlined so the AVX2
+// instance is compiled for the target of its caller; no __m256i ever crosses a real call,
+// hence the silenced ABI note.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+template <typename L>
+CLWE_ALWAYS_INLINE void keccak_rounds(typename L::V st[25]) {
+    using V = typename L::V;
+    V bc[5];
+    for (int r = 0; r < 24; ++r) {
+        // Theta
+        for (int i = 0; i < 5; ++i) {
+            bc[i] = L::bxor(L::bxor(L::bxor(st[i], st[i + 5]), L::bxor(st[i + 10], st[i + 15])), st[i + 20]);
+        }
+        for (int i = 0; i < 5; ++i) {
+            V t = L::bxor(bc[(i + 4) % 5], L::rotl(bc[(i + 1) % 5], 1));
+            for (int j = 0; j < 25; j += 5) {
+                st[j + i] = L::bxor(st[j + i], t);
+            }
+        }
+
+        // Rho Pi
+        V t = st[1];
+        for (int i = 0; i < 24; ++i) {
+            int j = PI_LANES[i];
+            V next = st[j];
+            st[j] = L::rotl(t, RHO_OFFSETS[i]);
+            t = next;
+        }
+
+        // Chi
+        for (int j = 0; j < 25; j += 5) {
+            for (int i = 0; i < 5; ++i) {
+                bc[i] = st[j + i];
+            }
+            for (int i = 0; i < 5; ++i) {
+                st[j + i] = L::bxor(st[j + i], L::andnot(bc[(i + 1) % 5], bc[(i + 2) % 5]));
+            }
+        }
+
+        // Iota
+        st[0] = L::bxor(st[0], L::constant(ROUND_CONSTANTS[r]));
+    }
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#ifdef HAVE_AVX2
+CLWE_TARGET_AVX2 void keccakf1600_x4_avx2(uint64_t state[25][4]) {
+    __m256i st[25];
+    for (int i = 0; i < 25; ++i) {
+        st[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(state[i]));
+    }
+    keccak_rounds<AVX2Lanes>(st);
+    for (int i = 0; i < 25; ++i) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(state[i]), st[i]);
+    }
+}
+#endif
+
+#ifdef HAVE_ARM_SHA3
+// Keccak-f[1600] on ARMv8.2-SHA3, each vector holding the same lane of two states: EOR3
+// folds the column parities, RAX1 forms theta's D, XAR applies D and the rho rotation in
+// one instruction (as a right rotation by 64 - rho), and BCAX is chi
+CLWE_TARGET_ARM_SHA3 void keccak_rounds_sha3(uint64x2_t a[25]) {
+    for (int r = 0; r < 24; ++r) {
+        uint64x2_t c0 = veor3q_u64(veor3q_u64(a[0], a[5], a[10]), a[15], a[20]);
+        uint64x2_t c1 = veor3q_u64(veor3q_u64(a[1], a[6], a[11]), a[16], a[21]);
+        uint64x2_t c2 = veor3q_u64(veor3q_u64(a[2], a[7], a[12]), a[17], a[22]);
+        uint64x2_t c3 = veor3q_u64(veor3q_u64(a[3], a[8], a[13]), a[18], a[23]);
+        uint64x2_t c4 = veor3q_u64(veor3q_u64(a[4], a[9], a[14]), a[19], a[24]);
+
+        uint64x2_t d0 = vrax1q_u64(c4, c1);
+        uint64x2_t d1 = vrax1q_u64(c0, c2);
+        uint64x2_t d2 = vrax1q_u64(c1, c3);
+        uint64x2_t d3 = vrax1q_u64(c2, c4);
+        uint64x2_t d4 = vrax1q_u64(c3, c0);
+
+        // b[y + 5 * ((2x + 3y) mod 5)] = rotl(a[x + 5y] ^ d[x], rho[x][y])
+        uint64x2_t b[25];
+        b[0] = veorq_u64(a[0], d0);
+        b[1] = vxarq_u64(a[6], d1, 20);
+        b[2] = vxarq_u64(a[12], d2, 21);
+        b[3] = vxarq_u64(a[18], d3, 43);
+        b[4] = vxarq_u64(a[24], d4, 50);
+        b[5] = vxarq_u64(a[3], d3, 36);
+        b[6] = vxarq_u64(a[9], d4, 44);
+        b[7] = vxarq_u64(a[10], d0, 61);
+        b[8] = vxarq_u64(a[16], d1, 19);
+        b[9] = vxarq_u64(a[22], d2, 3);
+        b[10] = vxarq_u64(a[1], d1, 63);
+        b[11] = vxarq_u64(a[7], d2, 58);
+        b[12] = vxarq_u64(a[13], d3, 39);
+        b[13] = vxarq_u64(a[19], d4, 56);
+        b[14] = vxarq_u64(a[20], d0, 46);
+        b[15] = vxarq_u64(a[4], d4, 37);
+        b[16] = vxarq_u64(a[5], d0, 28);
+        b[17] = vxarq_u64(a[11], d1, 54);
+        b[18] = vxarq_u64(a[17], d2, 49);
+        b[19] = vxarq_u64(a[23], d3, 8);
+        b[20] = vxarq_u64(a[2], d2, 2);
+        b[21] = vxarq_u64(a[8], d3, 9);
+        b[22] = vxarq_u64(a[14], d4, 25);
+        b[23] = vxarq_u64(a[15], d0, 23);
+        b[24] = vxarq_u64(a[21], d1, 62);
+
+        a[0] = vbcaxq_u64(b[0], b[2], b[1]);
+        a[1] = vbcaxq_u64(b[1], b[3], b[2]);
+        a[2] = vbcaxq_u64(b[2], b[4], b[3]);
+        a[3] = vbcaxq_u64(b[3], b[0], b[4]);
+        a[4] = vbcaxq_u64(b[4], b[1], b[0]);
+        a[5] = vbcaxq_u64(b[5], b[7], b[6]);
+        a[6] = vbcaxq_u64(b[6], b[8], b[7]);
+        a[7] = vbcaxq_u64(b[7], b[9], b[8]);
+        a[8] = vbcaxq_u64(b[8], b[5], b[9]);
+        a[9] = vbcaxq_u64(b[9], b[6], b[5]);
+        a[10] = vbcaxq_u64(b[10], b[12], b[11]);
+        a[11] = vbcaxq_u64(b[11], b[13], b[12]);
+        a[12] = vbcaxq_u64(b[12], b[14], b[13]);
+        a[13] = vbcaxq_u64(b[13], b[10], b[14]);
+        a[14] = vbcaxq_u64(b[14], b[11], b[10]);
+        a[15] = vbcaxq_u64(b[15], b[17], b[16]);
+        a[16] = vbcaxq_u64(b[16], b[18], b[17]);
+        a[17] = vbcaxq_u64(b[17], b[19], b[18]);
+        a[18] = vbcaxq_u64(b[18], b[15], b[19]);
+        a[19] = vbcaxq_u64(b[19], b[16], b[15]);
+        a[20] = vbcaxq_u64(b[20], b[22], b[21]);
+        a[21] = vbcaxq_u64(b[21], b[23], b[22]);
+        a[22] = vbcaxq_u64(b[22], b[24], b[23]);
+        a[23] = vbcaxq_u64(b[23], b[20], b[24]);
+        a[24] = vbcaxq_u64(b[24], b[21], b[20]);
+
+
+        a[0] = veorq_u64(a[0], vdupq_n_u64(ROUND_CONSTANTS[r]));
+    }
+}
+
+CLWE_TARGET_ARM_SHA3 void keccakf1600_x4_armsha3(uint64_t state[25][4]) {
+    // Instances 0-1 and 2-3 sit side by side in each lane row
+    for (int half = 0; half < 4; half += 2) {
+        uint64x2_t a[25];
+        for (int i = 0; i < 25; ++i) {
+            a[i] = vld1q_u64(&state[i][half]);
+        }
+        keccak_rounds_sha3(a);
+        for (int i = 0; i < 25; ++i) {
+            vst1q_u64(&state[i][half], a[i]);
+        }
+    }
+}
+#endif
+
+#ifdef HAVE_WASM_SIMD128
+void keccakf1600_x4_wasm(uint64_t state[25][4]) {
+    // Instances 0-1 and 2-3 sit side by side in each lane row
+    for (int half = 0; half < 4; half += 2) {
+        v128_t st[25];
+        for (int i = 0; i < 25; ++i) {
+            st[i] = wasm_v128_load(&state[i][half]);
+        }
+        keccak_rounds<WasmLanes>(st);
+        for (int i = 0; i < 25; ++i) {
+            wasm_v128_store(&state[i][half], st[i]);
+        }
+    }
+}
+#endif
+
+bool use_arm_sha3() {
+#ifdef HAVE_ARM_SHA3
+    static const bool supported = CPUFeatureDetector::cached().has_sha3;
+    return supported;
+#else
+    return false;
+#endif
+}
+
+bool use_wasm_simd128() {
+#ifdef HAVE_WASM_SIMD128
+    static const bool supported = CPUFeatureDetector::cached().has_wasm_simd128;
+    return supported;
+#else
+    return false;
+#endif
+}
+
+bool use_avx2() {
+#ifdef HAVE_AVX2
+    static const bool supported = CPUFeatureDetector::cached().has_avx2;
+    return supported;
+#else
+    return false;
+#endif
+}
+
+} // namespace
+
+void keccakf1600_x4_scalar(uint64_t state[25][4]) {
+    for (int instance = 0; instance < 4; ++instance) {
+        uint64_t st[25];
+        for (int i = 0; i < 25; ++i) {
+            st[i] = state[i][instance];
+        }
+        keccak_rounds<ScalarLanes>(st);
+        for (int i = 0; i < 25; ++i) {
+            state[i][instance] = st[i];
+        }
+    }
+}
+
+void keccakf1600_x4(uint64_t state[25][4]) {
+#ifdef HAVE_AVX2
+    if (use_avx2()) {
+        keccakf1600_x4_avx2(state);
+        return;
+    }
+#endif
+#ifdef HAVE_ARM_SHA3
+    if (use_arm_sha3()) {
+        keccakf1600_x4_armsha3(state);
+        return;
+    }
+#endif
+#ifdef HAVE_WASM_SIMD128
+    if (use_wasm_simd128()) {
+        keccakf1600_x4_wasm(state);
+        return;
+    }
+#endif
+    keccakf1600_x4_scalar(state);
+}
+
+bool keccak_arm_sha3_supported() {
+    return use_arm_sha3();
+}
+
+bool keccak_wasm_simd128_supported() {
+    return use_wasm_simd128();
+}
+
+#ifdef HAVE_ARM_SHA3
+CLWE_TARGET_ARM_SHA3 void keccakf1600_armsha3(uint64_t state[25]) {
+    // The upper half of every vector carries a copy of the state and is discarded
+    uint64x2_t a[25];
+    for (int i = 0; i < 25; ++i) {
+        a[i] = vdupq_n_u64(state[i]);
+    }
+    keccak_rounds_sha3(a);
+    for (int i = 0; i < 25; ++i) {
+        state[i] = vgetq_lane_u64(a[i], 0);
+    }
+}
+
+CLWE_TARGET_ARM_SHA3 void keccakf1600_x2_armsha3(uint64_t state[25][2]) {
+    uint64x2_t a[25];
+    for (int i = 0; i < 25; ++i) {
+        a[i] = vld1q_u64(state[i]);
+    }
+    keccak_rounds_sha3(a);
+    for (int i = 0; i < 25; ++i) {
+        vst1q_u64(state[i], a[i]);
+    }
+}
+#endif
+
+} // namespace clwe
@@ -0,0 +1,33 @@
+#ifndef KECCAK_X4_HPP
+#define KECCAK_X4_HPP
+
+#include <cstdint>
+
+namespace clwe {
+
+// Keccak-f[1600] on four independent states stored lane-major: state[lane][instance].
+// Uses AVX2 (one __m256i per lane), ARMv8.2-SHA3 or WebAssembly SIMD128 (two 64-bit halves
+// per lane) when built with it and the CPU reports it, else permutes the four states one
+// after another.
+void keccakf1600_x4(uint64_t state[25][4]);
+
+// Same permutation forced onto the portable path, for cross-checking the SIMD one
+void keccakf1600_x4_scalar(uint64_t state[25][4]);
+
+// Built with HAVE_ARM_SHA3 and the CPU reports CPUFeatures::has_sha3; keccakf1600_x4 then
+// runs as two 2-lane ARMv8.2-SHA3 permutations
+bool keccak_arm_sha3_supported();
+
+// Built with HAVE_WASM_SIMD128 (-msimd128) and not forced to the scalar backend
+bool keccak_wasm_simd128_supported();
+
+#ifdef HAVE_ARM_SHA3
+// ARMv8.2-SHA3 (EOR3, RAX1, XAR, BCAX) permutation of one state, and of two states stored
+// lane-major as state[lane][instance]; only call when keccak_arm_sha3_supported()
+void keccakf1600_armsha3(uint64_t state[25]);
+void keccakf1600_x2_armsha3(uint64_t state[25][2]);
+#endif
+
+} // namespace clwe
+
+#endif // KECCAK_X4_HPP
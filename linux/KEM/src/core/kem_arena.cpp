@@ -0,0 +1,73 @@
+#include "kem_arena.hpp"
+#include "utils.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace clwe {
+
+KemArena::KemArena(size_t capacity) {
+    reserve(capacity);
+}
+
+KemArena::~KemArena() {
+    reset();
+    release_page_region(region_);
+}
+
+KemArena::KemArena(KemArena&& other) noexcept
+    : region_(std::exchange(other.region_, PageRegion())),
+      capacity_(std::exchange(other.capacity_, 0)),
+      used_(std::exchange(other.used_, 0)),
+      follow_page_policy_(other.follow_page_policy_) {}
+
+KemArena& KemArena::operator=(KemArena&& other) noexcept {
+    if (this != &other) {
+        reset();
+        release_page_region(region_);
+        region_ = std::exchange(other.region_, PageRegion());
+        capacity_ = std::exchange(other.capacity_, 0);
+        used_ = std::exchange(other.used_, 0);
+        follow_page_policy_ = other.follow_page_policy_;
+    }
+    return *this;
+}
+
+void KemArena::reserve(size_t capacity) {
+    capacity = block_size(capacity);
+    if (capacity <= capacity_) {
+        return;
+    }
+    if (used_ != 0) {
+        throw std::logic_error("Cannot grow a KemArena with " + std::to_string(used_) + " bytes in use");
+    }
+
+    // Unallocated bytes are kept zero, so blocks need no clearing when handed out. Arenas
+    // hold noise and secret keys, so they come from the secure pool when it is enabled.
+    PageRegion region =
+        allocate_secret_page_region(capacity, follow_page_policy_ ? page_policy() : PagePolicy::Normal);
+    release_page_region(region_);
+    region_ = region;
+    capacity_ = capacity;
+}
+
+void* KemArena::allocate(size_t bytes) {
+    size_t size = block_size(bytes);
+    if (size > capacity_ - used_) {
+        throw std::logic_error("KemArena exhausted: " + std::to_string(size) + " bytes requested, " +
+                               std::to_string(capacity_ - used_) + " of " + std::to_string(capacity_) + " free");
+    }
+    void* block = region_.data + used_;
+    used_ += size;
+    return block;
+}
+
+void KemArena::reset() {
+    if (used_ != 0) {
+        secure_zero(region_.data, used_);
+        used_ = 0;
+    }
+}
+
+} // namespace clwe
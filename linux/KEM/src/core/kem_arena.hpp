@@ -0,0 +1,63 @@
+#ifndef KEM_ARENA_HPP
+#define KEM_ARENA_HPP
+
+#include "page_allocator.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace clwe {
+
+// Bump-pointer region for the temporaries of one KEM operation. Every block is carved
+// from a single 64-byte aligned allocation and starts zeroed; reset() wipes everything
+// handed out since the previous reset with secure_zero and rewinds. Blocks are never
+// freed one by one, and pointers into the arena are invalid after reset().
+class KemArena {
+private:
+    PageRegion region_;
+    size_t capacity_ = 0;
+    size_t used_ = 0;
+    bool follow_page_policy_ = false;
+
+public:
+    // Alignment and size granularity of every block
+    static constexpr size_t ALIGNMENT = 64;
+
+    // Bytes allocate(bytes) consumes, including the padding to the next block
+    static constexpr size_t block_size(size_t bytes) { return (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1); }
+
+    KemArena() = default;
+    explicit KemArena(size_t capacity);
+    ~KemArena();
+
+    KemArena(KemArena&& other) noexcept;
+    KemArena& operator=(KemArena&& other) noexcept;
+    KemArena(const KemArena&) = delete;
+    KemArena& operator=(const KemArena&) = delete;
+
+    // Grow the region to at least capacity bytes; only allowed while nothing is allocated
+    void reserve(size_t capacity);
+
+    // Long-lived arenas (workspaces) take their region under the current page_policy()
+    // whenever they grow; others always come from the heap
+    void set_follow_page_policy(bool follow) { follow_page_policy_ = follow; }
+    PageBacking backing() const { return region_.backing; }
+
+    // Zeroed, ALIGNMENT-aligned block; throws std::logic_error when the region is exhausted
+    void* allocate(size_t bytes);
+
+    template <typename T>
+    T* allocate_array(size_t count) {
+        static_assert(alignof(T) <= ALIGNMENT, "KemArena blocks are 64-byte aligned");
+        return static_cast<T*>(allocate(count * sizeof(T)));
+    }
+
+    // Wipe every allocated byte and make the whole region available again
+    void reset();
+
+    size_t capacity() const { return capacity_; }
+    size_t used() const { return used_; }
+};
+
+} // namespace clwe
+
+#endif // KEM_ARENA_HPP
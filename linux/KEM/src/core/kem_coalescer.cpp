@@ -0,0 +1,217 @@
+#include "clwe/kem_coalescer.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace clwe {
+
+namespace {
+
+using Encapsulation = std::pair<ColorCiphertext, ColorValue>;
+using Clock = std::chrono::steady_clock;
+
+struct Request {
+    bool decapsulate = false;
+    Clock::time_point arrival;
+    ColorPublicKey public_key;
+    ColorPrivateKey private_key;
+    ColorCiphertext ciphertext;
+    std::promise<Encapsulation> encapsulation;
+    std::promise<ColorValue> secret;
+};
+
+} // namespace
+
+struct KemCoalescer::Impl {
+    const ColorKEM& kem;
+    const KemCoalescerConfig config;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Request> queue;
+    bool stopping = false;
+    std::atomic<uint64_t> request_count{0};
+    std::atomic<uint64_t> batch_count{0};
+    std::thread dispatcher;
+
+    Impl(const ColorKEM& instance, const KemCoalescerConfig& coalescer_config)
+        : kem(instance), config(coalescer_config), dispatcher(&Impl::run, this) {}
+
+    void submit(Request request) {
+        request.arrival = Clock::now();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(std::move(request));
+        }
+        request_count.fetch_add(1, std::memory_order_relaxed);
+        cv.notify_one();
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        // Whether requests overlap: the last batch held several and more are waiting. A lone
+        // caller issuing one request after another never sees this and never waits.
+        bool loaded = false;
+        for (;;) {
+            if (queue.empty()) {
+                loaded = false;
+                cv.wait(lock, [this] { return stopping || !queue.empty(); });
+                if (queue.empty()) {
+                    return;
+                }
+            }
+            // Without overlap a request goes at once; under load the batch may fill for the
+            // rest of the oldest request's window
+            if (loaded && !stopping) {
+                const Clock::time_point deadline = queue.front().arrival + config.window;
+                cv.wait_until(lock, deadline, [this] { return stopping || queue.size() >= config.max_batch; });
+            }
+
+            std::vector<Request> batch;
+            const size_t count = std::min(queue.size(), config.max_batch);
+            batch.reserve(count);
+            for (size_t i = 0; i < count; ++i) {
+                batch.push_back(std::move(queue.front()));
+                queue.pop_front();
+            }
+            lock.unlock();
+            batch_count.fetch_add(1, std::memory_order_relaxed);
+            run_batch(batch);
+            lock.lock();
+            loaded = count > 1;
+        }
+    }
+
+    void run_batch(std::vector<Request>& batch) {
+        std::vector<Request*> encapsulations;
+        std::vector<Request*> decapsulations;
+        for (Request& request : batch) {
+            (request.decapsulate ? decapsulations : encapsulations).push_back(&request);
+        }
+        if (!encapsulations.empty()) {
+            run_encapsulations(encapsulations);
+        }
+        if (!decapsulations.empty()) {
+            run_decapsulations(decapsulations);
+        }
+    }
+
+    void run_encapsulations(const std::vector<Request*>& requests) {
+        std::vector<ColorPublicKey> public_keys;
+        public_keys.reserve(requests.size());
+        for (Request* request : requests) {
+            public_keys.push_back(std::move(request->public_key));
+        }
+
+        std::vector<Encapsulation> results;
+        try {
+            results = kem.encapsulate_batch(public_keys);
+        } catch (...) {
+            // Isolate the invalid key: rerun each request on its own
+            for (size_t i = 0; i < requests.size(); ++i) {
+                try {
+                    requests[i]->encapsulation.set_value(kem.encapsulate(public_keys[i]));
+                } catch (...) {
+                    requests[i]->encapsulation.set_exception(std::current_exception());
+                }
+            }
+            return;
+        }
+        for (size_t i = 0; i < requests.size(); ++i) {
+            requests[i]->encapsulation.set_value(std::move(results[i]));
+        }
+    }
+
+    void run_decapsulations(const std::vector<Request*>& requests) {
+        std::vector<ColorPublicKey> public_keys;
+        std::vector<ColorPrivateKey> private_keys;
+        std::vector<ColorCiphertext> ciphertexts;
+        public_keys.reserve(requests.size());
+        private_keys.reserve(requests.size());
+        ciphertexts.reserve(requests.size());
+        for (Request* request : requests) {
+            public_keys.push_back(std::move(request->public_key));
+            private_keys.push_back(std::move(request->private_key));
+            ciphertexts.push_back(std::move(request->ciphertext));
+        }
+
+        std::vector<ColorValue> secrets;
+        bool batched = true;
+        try {
+            secrets = kem.decapsulate_batch(public_keys, private_keys, ciphertexts);
+        } catch (...) {
+            batched = false;
+        }
+
+        for (size_t i = 0; i < requests.size(); ++i) {
+            if (batched) {
+                requests[i]->secret.set_value(secrets[i]);
+                continue;
+            }
+            try {
+                requests[i]->secret.set_value(kem.decapsulate(public_keys[i], private_keys[i], ciphertexts[i]));
+            } catch (...) {
+                requests[i]->secret.set_exception(std::current_exception());
+            }
+        }
+
+        for (ColorPrivateKey& key : private_keys) {
+            if (!key.secret_data.empty()) {
+                secure_zero(key.secret_data.data(), key.secret_data.size());
+            }
+        }
+    }
+};
+
+KemCoalescer::KemCoalescer(const ColorKEM& kem, const KemCoalescerConfig& config) {
+    if (config.max_batch == 0) {
+        throw std::invalid_argument("KemCoalescer max_batch must be positive");
+    }
+    impl_.reset(new Impl(kem, config));
+}
+
+KemCoalescer::~KemCoalescer() {
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        impl_->stopping = true;
+    }
+    impl_->cv.notify_all();
+    impl_->dispatcher.join();
+}
+
+std::future<std::pair<ColorCiphertext, ColorValue>> KemCoalescer::encapsulate(const ColorPublicKey& public_key) {
+    Request request;
+    request.public_key = public_key;
+    std::future<Encapsulation> result = request.encapsulation.get_future();
+    impl_->submit(std::move(request));
+    return result;
+}
+
+std::future<ColorValue> KemCoalescer::decapsulate(const ColorPublicKey& public_key, const ColorPrivateKey& private_key,
+                                                  const ColorCiphertext& ciphertext) {
+    Request request;
+    request.decapsulate = true;
+    request.public_key = public_key;
+    request.private_key = private_key;
+    request.ciphertext = ciphertext;
+    std::future<ColorValue> result = request.secret.get_future();
+    impl_->submit(std::move(request));
+    return result;
+}
+
+uint64_t KemCoalescer::requests() const {
+    return impl_->request_count.load(std::memory_order_relaxed);
+}
+
+uint64_t KemCoalescer::batches() const {
+    return impl_->batch_count.load(std::memory_order_relaxed);
+}
+
+} // namespace clwe
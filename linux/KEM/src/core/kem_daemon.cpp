@@ -0,0 +1,994 @@
+#include "clwe/kem_daemon.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <condition_variable>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace clwe {
+
+namespace {
+
+// Shared ring layout. Both sides map the same memfd: a RingHeader, slot_count queue entries
+// (slot indices the client submits), then slot_count slots of a SlotHeader and slot_bytes
+// of data each. Counters run freely and index modulo slot_count, a power of two.
+
+constexpr uint32_t RING_MAGIC = 0x4B454D44;  // "KEMD"
+constexpr uint32_t PROTOCOL_VERSION = 1;
+constexpr size_t CACHE_LINE = 64;
+constexpr size_t ERROR_TEXT_BYTES = 128;
+constexpr size_t SECRET_BYTES = 4;
+
+enum : uint32_t { SLOT_FREE = 0, SLOT_SUBMITTED = 1, SLOT_DONE = 2 };
+enum : uint32_t { OP_ENCAPSULATE = 1, OP_DECAPSULATE = 2 };
+enum : uint32_t { STATUS_OK = 0, STATUS_INVALID_ARGUMENT = 1, STATUS_FAILED = 2 };
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "ring counters must be lock-free across processes");
+
+struct RingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t slot_bytes;
+    uint32_t security_level;
+    alignas(CACHE_LINE) std::atomic<uint32_t> submit_head;  // Written by the client
+    alignas(CACHE_LINE) std::atomic<uint32_t> submit_tail;  // Written by the daemon
+    alignas(CACHE_LINE) std::atomic<uint32_t> daemon_idle;  // Set while the daemon may sleep: ring the doorbell
+};
+
+struct alignas(CACHE_LINE) SlotHeader {
+    std::atomic<uint32_t> state;    // Futex word the client sleeps on
+    std::atomic<uint32_t> waiting;  // Set while the client may sleep: the daemon wakes it
+    uint32_t op;
+    uint32_t status;
+    uint32_t input_bytes;
+    uint32_t output_bytes;
+};
+
+struct RingLayout {
+    size_t queue_offset;
+    size_t slots_offset;
+    size_t slot_stride;
+    size_t total;
+
+    RingLayout(uint32_t slot_count, uint32_t slot_bytes) {
+        auto align = [](size_t bytes) { return (bytes + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE; };
+        queue_offset = align(sizeof(RingHeader));
+        slots_offset = align(queue_offset + slot_count * sizeof(std::atomic<uint32_t>));
+        slot_stride = align(sizeof(SlotHeader) + slot_bytes);
+        total = slots_offset + slot_count * slot_stride;
+    }
+};
+
+// One mapped ring, as either side sees it
+struct RingView {
+    void* base = nullptr;
+    size_t bytes = 0;
+    RingHeader* header = nullptr;
+    std::atomic<uint32_t>* queue = nullptr;
+    uint8_t* slots = nullptr;
+    size_t stride = 0;
+    uint32_t slot_count = 0;
+    uint32_t slot_bytes = 0;
+
+    void attach(void* mapping, size_t mapping_bytes, uint32_t count, uint32_t data_bytes) {
+        RingLayout layout(count, data_bytes);
+        base = mapping;
+        bytes = mapping_bytes;
+        header = static_cast<RingHeader*>(mapping);
+        queue = reinterpret_cast<std::atomic<uint32_t>*>(static_cast<uint8_t*>(mapping) + layout.queue_offset);
+        slots = static_cast<uint8_t*>(mapping) + layout.slots_offset;
+        stride = layout.slot_stride;
+        slot_count = count;
+        slot_bytes = data_bytes;
+    }
+    void unmap() {
+        if (base != nullptr) {
+            munmap(base, bytes);
+            base = nullptr;
+        }
+    }
+    SlotHeader* slot(uint32_t index) const { return reinterpret_cast<SlotHeader*>(slots + index * stride); }
+    uint8_t* data(uint32_t index) const { return slots + index * stride + sizeof(SlotHeader); }
+};
+
+// Handshake datagrams on the SOCK_SEQPACKET socket; the reply carries the memfd and doorbell
+struct HelloRequest {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t security_level;
+    uint32_t ring_slots;
+};
+
+struct HelloReply {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t status;
+    uint32_t slot_count;
+    uint32_t slot_bytes;
+    uint64_t region_bytes;
+    char error[ERROR_TEXT_BYTES];
+};
+
+[[noreturn]] void throw_errno(const std::string& what) {
+    throw std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+void close_fd(int& fd) {
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+// Shared (not FUTEX_PRIVATE) operations, since the word lives in a mapping of two processes
+void futex_wait(std::atomic<uint32_t>* word, uint32_t expected, long timeout_ns) {
+    timespec timeout{0, timeout_ns};
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected, &timeout, nullptr, 0);
+}
+
+void futex_wake(std::atomic<uint32_t>* word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+void ring_doorbell(int fd) {
+    const uint64_t one = 1;
+    ssize_t written = write(fd, &one, sizeof(one));
+    (void)written;  // A full counter already means a pending wakeup
+}
+
+uint32_t round_up_pow2(size_t value) {
+    uint32_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+// Inputs of a decapsulation are the three serialized objects back to back
+struct WireSizes {
+    size_t public_key;
+    size_t private_key;
+    size_t ciphertext;
+
+    explicit WireSizes(const CLWEParameters& params)
+        : public_key(ColorPublicKey::serialized_size(params)),
+          private_key(ColorPrivateKey::serialized_size(params)),
+          ciphertext(ColorCiphertext::serialized_size(params)) {}
+
+    size_t slot_bytes() const {
+        const size_t bytes = std::max({public_key + private_key + ciphertext, ciphertext + SECRET_BYTES,
+                                       ERROR_TEXT_BYTES});
+        return (bytes + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+    }
+};
+
+void put_secret(const ColorValue& secret, uint8_t* out) {
+    const uint32_t value = secret.to_math_value();
+    out[0] = static_cast<uint8_t>(value >> 24);
+    out[1] = static_cast<uint8_t>(value >> 16);
+    out[2] = static_cast<uint8_t>(value >> 8);
+    out[3] = static_cast<uint8_t>(value);
+}
+
+ColorValue get_secret(const uint8_t* in) {
+    return ColorValue::from_math_value((static_cast<uint32_t>(in[0]) << 24) | (static_cast<uint32_t>(in[1]) << 16) |
+                                       (static_cast<uint32_t>(in[2]) << 8) | in[3]);
+}
+
+void wipe_private_key(ColorPrivateKey& key) {
+    if (!key.secret_data.empty()) {
+        secure_zero(key.secret_data.data(), key.secret_data.size());
+    }
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Daemon
+
+struct KemDaemon::Impl {
+    struct Client;
+
+    // epoll cookie: which descriptor of which client (or the daemon itself) is ready
+    struct Tag {
+        Client* client;
+        bool doorbell;
+    };
+
+    struct Client {
+        int socket = -1;
+        int doorbell = -1;
+        bool established = false;
+        bool dead = false;
+        RingView ring;
+        uint32_t tail = 0;
+        ColorKEM* kem = nullptr;
+        Tag socket_tag{this, false};
+        Tag doorbell_tag{this, true};
+
+        ~Client() {
+            ring.unmap();
+            close_fd(socket);
+            close_fd(doorbell);
+        }
+    };
+
+    struct Job {
+        Client* client;
+        uint32_t slot;
+    };
+
+    KemDaemonConfig config;
+    int listen_fd = -1;
+    int epoll_fd = -1;
+    int stop_fd = -1;
+    Tag listen_tag{nullptr, false};
+    Tag stop_tag{nullptr, true};
+    std::atomic<bool> stopping{false};
+    std::atomic<size_t> clients_connected{0};
+    std::atomic<uint64_t> served{0};
+    std::vector<std::unique_ptr<Client>> clients;
+    std::map<uint32_t, std::unique_ptr<ColorKEM>> engines;
+
+    explicit Impl(KemDaemonConfig daemon_config) : config(std::move(daemon_config)) {}
+
+    ~Impl() {
+        clients.clear();
+        if (listen_fd >= 0) {
+            unlink(config.socket_path.c_str());
+        }
+        close_fd(listen_fd);
+        close_fd(epoll_fd);
+        close_fd(stop_fd);
+    }
+
+    void watch(int fd, uint32_t events, Tag* tag) {
+        epoll_event event{};
+        event.events = events;
+        event.data.ptr = tag;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            throw_errno("epoll_ctl");
+        }
+    }
+
+    void listen_on_socket() {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (config.socket_path.empty() || config.socket_path.size() >= sizeof(address.sun_path)) {
+            throw std::invalid_argument("KEM daemon socket path must be 1 to " +
+                                        std::to_string(sizeof(address.sun_path) - 1) + " bytes");
+        }
+        std::memcpy(address.sun_path, config.socket_path.c_str(), config.socket_path.size() + 1);
+
+        struct stat existing;
+        if (lstat(config.socket_path.c_str(), &existing) == 0) {
+            if (!S_ISSOCK(existing.st_mode)) {
+                throw std::runtime_error("KEM daemon socket path exists and is not a socket: " + config.socket_path);
+            }
+            unlink(config.socket_path.c_str());
+        }
+
+        listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+        if (listen_fd < 0) {
+            throw_errno("KEM daemon socket");
+        }
+        if (bind(listen_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            const int err = errno;
+            close_fd(listen_fd);
+            errno = err;
+            throw_errno("Cannot bind KEM daemon socket " + config.socket_path);
+        }
+        if (chmod(config.socket_path.c_str(), config.socket_mode) != 0 || listen(listen_fd, SOMAXCONN) != 0) {
+            throw_errno("Cannot listen on KEM daemon socket " + config.socket_path);
+        }
+
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (epoll_fd < 0 || stop_fd < 0) {
+            throw_errno("KEM daemon event setup");
+        }
+        watch(listen_fd, EPOLLIN, &listen_tag);
+        watch(stop_fd, EPOLLIN, &stop_tag);
+    }
+
+    ColorKEM& engine(uint32_t security_level) {
+        auto it = engines.find(security_level);
+        if (it == engines.end()) {
+            // Unsupported levels throw here, before anything is stored
+            std::unique_ptr<ColorKEM> kem(new ColorKEM(CLWEParameters(security_level)));
+            if (config.executor) {
+                kem->set_executor(config.executor);
+            }
+            it = engines.emplace(security_level, std::move(kem)).first;
+        }
+        return *it->second;
+    }
+
+    void accept_clients() {
+        for (;;) {
+            int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+            if (fd < 0) {
+                return;
+            }
+            if (clients.size() >= config.max_clients) {
+                close(fd);
+                continue;
+            }
+            std::unique_ptr<Client> client(new Client());
+            client->socket = fd;
+            watch(fd, EPOLLIN | EPOLLRDHUP, &client->socket_tag);
+            clients.push_back(std::move(client));
+        }
+    }
+
+    // Answers the hello of a new connection with its ring, or with the reason it is refused
+    void handshake(Client& client) {
+        HelloRequest hello{};
+        ssize_t received = recv(client.socket, &hello, sizeof(hello), 0);
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        }
+        HelloReply reply{};
+        reply.magic = RING_MAGIC;
+        reply.version = PROTOCOL_VERSION;
+        int memfd = -1;
+        try {
+            if (received != static_cast<ssize_t>(sizeof(hello)) || hello.magic != RING_MAGIC ||
+                hello.version != PROTOCOL_VERSION) {
+                throw std::invalid_argument("KEM daemon protocol mismatch");
+            }
+            const size_t requested = hello.ring_slots == 0 ? config.ring_slots : hello.ring_slots;
+            if (requested > config.max_ring_slots) {
+                throw std::invalid_argument("Ring of " + std::to_string(requested) +
+                                            " slots exceeds the daemon limit of " +
+                                            std::to_string(config.max_ring_slots));
+            }
+            ColorKEM& kem = engine(hello.security_level);
+            const uint32_t slot_count = round_up_pow2(requested);
+            const uint32_t slot_bytes = static_cast<uint32_t>(WireSizes(kem.params()).slot_bytes());
+            const RingLayout layout(slot_count, slot_bytes);
+
+            // Sealed against resizing, so a client cannot truncate the mapping under the daemon
+            memfd = static_cast<int>(syscall(SYS_memfd_create, "clwe-kemd-ring", MFD_CLOEXEC | MFD_ALLOW_SEALING));
+            if (memfd < 0 || ftruncate(memfd, static_cast<off_t>(layout.total)) != 0 ||
+                fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0) {
+                throw_errno("KEM ring memfd");
+            }
+            void* mapping = mmap(nullptr, layout.total, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+            if (mapping == MAP_FAILED) {
+                throw_errno("KEM ring mmap");
+            }
+            client.ring.attach(mapping, layout.total, slot_count, slot_bytes);
+            RingHeader* header = client.ring.header;
+            header->magic = RING_MAGIC;
+            header->version = PROTOCOL_VERSION;
+            header->slot_count = slot_count;
+            header->slot_bytes = slot_bytes;
+            header->security_level = hello.security_level;
+
+            client.doorbell = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+            if (client.doorbell < 0) {
+                throw_errno("KEM ring doorbell");
+            }
+            client.kem = &kem;
+            reply.slot_count = slot_count;
+            reply.slot_bytes = slot_bytes;
+            reply.region_bytes = layout.total;
+            reply.status = STATUS_OK;
+        } catch (const std::exception& e) {
+            reply.status = dynamic_cast<const std::invalid_argument*>(&e) ? STATUS_INVALID_ARGUMENT : STATUS_FAILED;
+            std::strncpy(reply.error, e.what(), sizeof(reply.error) - 1);
+        }
+
+        iovec iov{&reply, sizeof(reply)};
+        msghdr message{};
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+        alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))];
+        if (reply.status == STATUS_OK) {
+            message.msg_control = control;
+            message.msg_controllen = sizeof(control);
+            cmsghdr* cmsg = CMSG_FIRSTHDR(&message);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_RIGHTS;
+            cmsg->cmsg_len = CMSG_LEN(2 * sizeof(int));
+            const int fds[2] = {memfd, client.doorbell};
+            std::memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+        }
+        if (reply.status == STATUS_OK) {
+            // Established before the reply, so the client never observes itself uncounted
+            watch(client.doorbell, EPOLLIN, &client.doorbell_tag);
+            client.established = true;
+            clients_connected.fetch_add(1, std::memory_order_relaxed);
+        }
+        const bool sent = sendmsg(client.socket, &message, MSG_NOSIGNAL) == static_cast<ssize_t>(sizeof(reply));
+        if (memfd >= 0) {
+            close(memfd);
+        }
+        if (reply.status != STATUS_OK || !sent) {
+            client.dead = true;
+        }
+    }
+
+    void handle_event(const epoll_event& event) {
+        Tag* tag = static_cast<Tag*>(event.data.ptr);
+        if (tag == &listen_tag) {
+            accept_clients();
+        } else if (tag == &stop_tag) {
+            uint64_t value;
+            ssize_t drained = read(stop_fd, &value, sizeof(value));
+            (void)drained;
+        } else if (tag->doorbell) {
+            uint64_t value;
+            ssize_t drained = read(tag->client->doorbell, &value, sizeof(value));
+            (void)drained;
+        } else if (!tag->client->established && !(event.events & (EPOLLHUP | EPOLLRDHUP | EPOLLERR))) {
+            handshake(*tag->client);
+        } else {
+            // Established clients never send after the hello: anything here is a hangup
+            tag->client->dead = true;
+        }
+    }
+
+    // Moves every submitted slot of every ring into jobs; a client breaking the protocol is dropped
+    void collect(std::vector<Job>& jobs) {
+        for (const std::unique_ptr<Client>& client : clients) {
+            if (!client->established || client->dead) {
+                continue;
+            }
+            RingView& ring = client->ring;
+            const uint32_t head = ring.header->submit_head.load(std::memory_order_seq_cst);
+            if (head - client->tail > ring.slot_count) {
+                client->dead = true;
+                continue;
+            }
+            while (client->tail != head) {
+                const uint32_t index = ring.queue[client->tail & (ring.slot_count - 1)].load(std::memory_order_relaxed);
+                ++client->tail;
+                if (index >= ring.slot_count ||
+                    ring.slot(index)->state.load(std::memory_order_acquire) != SLOT_SUBMITTED) {
+                    client->dead = true;
+                    break;
+                }
+                jobs.push_back({client.get(), index});
+            }
+            ring.header->submit_tail.store(client->tail, std::memory_order_release);
+        }
+    }
+
+    bool work_pending() const {
+        for (const std::unique_ptr<Client>& client : clients) {
+            if (client->established && !client->dead &&
+                client->ring.header->submit_head.load(std::memory_order_seq_cst) != client->tail) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void set_idle(uint32_t idle) {
+        for (const std::unique_ptr<Client>& client : clients) {
+            if (client->established) {
+                client->ring.header->daemon_idle.store(idle, std::memory_order_seq_cst);
+            }
+        }
+    }
+
+    void complete(const Job& job, uint32_t status, uint32_t output_bytes) {
+        served.fetch_add(1, std::memory_order_relaxed);
+        SlotHeader* slot = job.client->ring.slot(job.slot);
+        slot->status = status;
+        slot->output_bytes = output_bytes;
+        slot->state.store(SLOT_DONE, std::memory_order_seq_cst);
+        if (slot->waiting.load(std::memory_order_seq_cst) != 0) {
+            futex_wake(&slot->state);
+        }
+    }
+
+    void fail(const Job& job, const std::exception& error) {
+        const bool invalid = dynamic_cast<const std::invalid_argument*>(&error) != nullptr;
+        const size_t length = std::min(std::strlen(error.what()), ERROR_TEXT_BYTES - 1);
+        std::memcpy(job.client->ring.data(job.slot), error.what(), length);
+        complete(job, invalid ? STATUS_INVALID_ARGUMENT : STATUS_FAILED, static_cast<uint32_t>(length));
+    }
+
+    // The slot is the client's memory: only input_bytes is trusted, after checking it
+    static void check_input(const Job& job, size_t expected) {
+        if (job.client->ring.slot(job.slot)->input_bytes != expected) {
+            throw std::invalid_argument("Request size does not match the connection's parameters");
+        }
+    }
+
+    void run_encapsulations(ColorKEM& kem, const std::vector<Job>& jobs) {
+        const WireSizes sizes(kem.params());
+        std::vector<Job> parsed;
+        std::vector<ColorPublicKey> public_keys;
+        for (const Job& job : jobs) {
+            try {
+                check_input(job, sizes.public_key);
+                public_keys.push_back(
+                    ColorPublicKey::deserialize(job.client->ring.data(job.slot), sizes.public_key, kem.params()));
+                parsed.push_back(job);
+            } catch (const std::exception& e) {
+                fail(job, e);
+            }
+        }
+
+        std::vector<std::pair<ColorCiphertext, ColorValue>> results;
+        try {
+            results = kem.encapsulate_batch(public_keys);
+        } catch (const std::exception&) {
+            results.clear();  // Rerun one by one, so a bad key only fails its own request
+        }
+        for (size_t i = 0; i < parsed.size(); ++i) {
+            try {
+                std::pair<ColorCiphertext, ColorValue> result =
+                    results.empty() ? kem.encapsulate(public_keys[i]) : std::move(results[i]);
+                uint8_t* out = parsed[i].client->ring.data(parsed[i].slot);
+                const size_t written = result.first.serialize(out, sizes.ciphertext);
+                put_secret(result.second, out + written);
+                complete(parsed[i], STATUS_OK, static_cast<uint32_t>(written + SECRET_BYTES));
+            } catch (const std::exception& e) {
+                fail(parsed[i], e);
+            }
+        }
+    }
+
+    void run_decapsulations(ColorKEM& kem, const std::vector<Job>& jobs) {
+        const WireSizes sizes(kem.params());
+        const size_t input_bytes = sizes.public_key + sizes.private_key + sizes.ciphertext;
+        std::vector<Job> parsed;
+        std::vector<ColorPublicKey> public_keys;
+        std::vector<ColorPrivateKey> private_keys;
+        std::vector<ColorCiphertext> ciphertexts;
+        for (const Job& job : jobs) {
+            const uint8_t* in = job.client->ring.data(job.slot);
+            try {
+                check_input(job, input_bytes);
+                public_keys.push_back(ColorPublicKey::deserialize(in, sizes.public_key, kem.params()));
+                private_keys.push_back(
+                    ColorPrivateKey::deserialize(in + sizes.public_key, sizes.private_key, kem.params()));
+                ciphertexts.push_back(ColorCiphertext::deserialize(in + sizes.public_key + sizes.private_key,
+                                                                   sizes.ciphertext, kem.params()));
+                parsed.push_back(job);
+            } catch (const std::exception& e) {
+                public_keys.resize(parsed.size());
+                private_keys.resize(parsed.size());
+                ciphertexts.resize(parsed.size());
+                secure_zero(job.client->ring.data(job.slot), input_bytes);
+                fail(job, e);
+            }
+        }
+
+        std::vector<ColorValue> secrets;
+        try {
+            secrets = kem.decapsulate_batch(public_keys, private_keys, ciphertexts);
+        } catch (const std::exception&) {
+            secrets.clear();
+        }
+        for (size_t i = 0; i < parsed.size(); ++i) {
+            uint8_t* out = parsed[i].client->ring.data(parsed[i].slot);
+            secure_zero(out, input_bytes);
+            try {
+                const ColorValue secret =
+                    secrets.empty() ? kem.decapsulate(public_keys[i], private_keys[i], ciphertexts[i]) : secrets[i];
+                put_secret(secret, out);
+                complete(parsed[i], STATUS_OK, SECRET_BYTES);
+            } catch (const std::exception& e) {
+                fail(parsed[i], e);
+            }
+        }
+        for (ColorPrivateKey& key : private_keys) {
+            wipe_private_key(key);
+        }
+    }
+
+    // Groups jobs by engine and operation and runs them max_batch at a time
+    void run_jobs(std::vector<Job>& jobs) {
+        std::map<std::pair<ColorKEM*, uint32_t>, std::vector<Job>> groups;
+        for (const Job& job : jobs) {
+            const uint32_t op = job.client->ring.slot(job.slot)->op;
+            if (op != OP_ENCAPSULATE && op != OP_DECAPSULATE) {
+                fail(job, std::invalid_argument("Unknown KEM daemon operation " + std::to_string(op)));
+                continue;
+            }
+            groups[{job.client->kem, op}].push_back(job);
+        }
+        for (auto& group : groups) {
+            std::vector<Job>& members = group.second;
+            for (size_t first = 0; first < members.size(); first += config.max_batch) {
+                const size_t last = std::min(members.size(), first + config.max_batch);
+                std::vector<Job> chunk(members.begin() + first, members.begin() + last);
+                if (group.first.second == OP_ENCAPSULATE) {
+                    run_encapsulations(*group.first.first, chunk);
+                } else {
+                    run_decapsulations(*group.first.first, chunk);
+                }
+            }
+        }
+        jobs.clear();
+    }
+
+    void drop_dead_clients() {
+        auto dead = std::stable_partition(clients.begin(), clients.end(),
+                                          [](const std::unique_ptr<Client>& client) { return !client->dead; });
+        for (auto it = dead; it != clients.end(); ++it) {
+            if ((*it)->established) {
+                clients_connected.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+        clients.erase(dead, clients.end());  // Closing the descriptors also removes them from epoll
+    }
+
+    void run() {
+        std::vector<Job> jobs;
+        std::vector<epoll_event> events(64);
+        while (!stopping.load(std::memory_order_acquire)) {
+            collect(jobs);
+            const bool busy = !jobs.empty();
+            run_jobs(jobs);
+
+            // Dekker handshake with the clients: idle is published before the rings are
+            // checked one last time, and a client checks idle after publishing its head
+            int timeout = 0;
+            if (!busy) {
+                set_idle(1);
+                timeout = work_pending() ? 0 : -1;
+            }
+            const int ready = epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), timeout);
+            set_idle(0);
+            for (int i = 0; i < ready; ++i) {
+                handle_event(events[i]);
+            }
+            drop_dead_clients();
+        }
+    }
+};
+
+KemDaemon::KemDaemon(KemDaemonConfig config) {
+    if (config.ring_slots == 0 || config.max_ring_slots == 0 || config.max_batch == 0 || config.max_clients == 0) {
+        throw std::invalid_argument("KEM daemon ring sizes, batch size and client limit must be nonzero");
+    }
+    if (config.max_ring_slots > (1u << 20)) {
+        throw std::invalid_argument("KEM daemon rings are limited to 2^20 slots");
+    }
+    config.ring_slots = std::min(config.ring_slots, config.max_ring_slots);
+    impl_.reset(new Impl(std::move(config)));
+    impl_->listen_on_socket();
+}
+
+KemDaemon::~KemDaemon() = default;
+
+void KemDaemon::run() {
+    impl_->run();
+    impl_->stopping.store(false, std::memory_order_release);
+}
+
+void KemDaemon::stop() {
+    // Only an atomic store and a write(), so a signal handler may call it
+    impl_->stopping.store(true, std::memory_order_release);
+    ring_doorbell(impl_->stop_fd);
+}
+
+size_t KemDaemon::client_count() const {
+    return impl_->clients_connected.load(std::memory_order_relaxed);
+}
+
+uint64_t KemDaemon::requests_served() const {
+    return impl_->served.load(std::memory_order_relaxed);
+}
+
+const std::string& KemDaemon::socket_path() const {
+    return impl_->config.socket_path;
+}
+
+// ---------------------------------------------------------------------------
+// Client
+
+struct KemClient::Impl {
+    int socket = -1;
+    int doorbell = -1;
+    RingView ring;
+    CLWEParameters params;
+    WireSizes sizes;
+    uint32_t head = 0;
+    std::mutex mutex;
+    std::condition_variable slot_freed;
+    std::vector<uint32_t> free_slots;
+    std::vector<uint32_t> outstanding;  // Op per slot while a ticket is out, 0 otherwise
+
+    explicit Impl(const CLWEParameters& connection_params) : params(connection_params), sizes(connection_params) {}
+
+    ~Impl() {
+        ring.unmap();
+        close_fd(socket);
+        close_fd(doorbell);
+    }
+
+    void connect_to(const std::string& socket_path, uint32_t security_level, size_t ring_slots) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (socket_path.empty() || socket_path.size() >= sizeof(address.sun_path)) {
+            throw std::runtime_error("Invalid KEM daemon socket path: " + socket_path);
+        }
+        std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+        socket = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        if (socket < 0) {
+            throw_errno("KEM client socket");
+        }
+        if (connect(socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            throw_errno("Cannot connect to KEM daemon at " + socket_path);
+        }
+
+        const HelloRequest hello{RING_MAGIC, PROTOCOL_VERSION, security_level,
+                                 static_cast<uint32_t>(std::min<size_t>(ring_slots, UINT32_MAX))};
+        if (send(socket, &hello, sizeof(hello), MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof(hello))) {
+            throw_errno("KEM daemon handshake");
+        }
+
+        HelloReply reply{};
+        iovec iov{&reply, sizeof(reply)};
+        alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))];
+        msghdr message{};
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        const ssize_t received = recvmsg(socket, &message, MSG_CMSG_CLOEXEC);
+        int fds[2] = {-1, -1};
+        for (cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr; cmsg = CMSG_NXTHDR(&message, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+                cmsg->cmsg_len == CMSG_LEN(sizeof(fds))) {
+                std::memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+            }
+        }
+        int memfd = fds[0];
+        doorbell = fds[1];
+        if (received != static_cast<ssize_t>(sizeof(reply)) || reply.magic != RING_MAGIC ||
+            reply.version != PROTOCOL_VERSION) {
+            close_fd(memfd);
+            throw std::runtime_error("KEM daemon handshake failed");
+        }
+        if (reply.status != STATUS_OK) {
+            close_fd(memfd);
+            reply.error[sizeof(reply.error) - 1] = '\0';
+            throw std::runtime_error(std::string("KEM daemon refused the connection: ") + reply.error);
+        }
+        if (memfd < 0 || doorbell < 0 || reply.slot_count == 0 || (reply.slot_count & (reply.slot_count - 1)) != 0 ||
+            reply.slot_bytes < sizes.slot_bytes() ||
+            reply.region_bytes != RingLayout(reply.slot_count, reply.slot_bytes).total) {
+            close_fd(memfd);
+            throw std::runtime_error("KEM daemon sent an invalid ring");
+        }
+        void* mapping = mmap(nullptr, reply.region_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+        close_fd(memfd);
+        if (mapping == MAP_FAILED) {
+            throw_errno("KEM ring mmap");
+        }
+        ring.attach(mapping, reply.region_bytes, reply.slot_count, reply.slot_bytes);
+
+        free_slots.reserve(ring.slot_count);
+        for (uint32_t i = ring.slot_count; i-- > 0;) {
+            free_slots.push_back(i);
+        }
+        outstanding.assign(ring.slot_count, 0);
+    }
+
+    uint32_t acquire(uint32_t op) {
+        std::unique_lock<std::mutex> lock(mutex);
+        slot_freed.wait(lock, [&] { return !free_slots.empty(); });
+        const uint32_t index = free_slots.back();
+        free_slots.pop_back();
+        outstanding[index] = op;
+        return index;
+    }
+
+    void release(uint32_t index) {
+        ring.slot(index)->state.store(SLOT_FREE, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            outstanding[index] = 0;
+            free_slots.push_back(index);
+        }
+        slot_freed.notify_one();
+    }
+
+    Ticket publish(uint32_t index, uint32_t op, size_t input_bytes) {
+        SlotHeader* slot = ring.slot(index);
+        slot->op = op;
+        slot->input_bytes = static_cast<uint32_t>(input_bytes);
+        slot->waiting.store(0, std::memory_order_relaxed);
+        slot->state.store(SLOT_SUBMITTED, std::memory_order_release);
+
+        bool wake;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ring.queue[head & (ring.slot_count - 1)].store(index, std::memory_order_relaxed);
+            ++head;
+            ring.header->submit_head.store(head, std::memory_order_seq_cst);
+            wake = ring.header->daemon_idle.load(std::memory_order_seq_cst) != 0;
+        }
+        if (wake) {
+            ring_doorbell(doorbell);
+        }
+        return index;
+    }
+
+    bool daemon_alive() const {
+        pollfd descriptor{socket, POLLRDHUP, 0};
+        return poll(&descriptor, 1, 0) == 0 || (descriptor.revents & (POLLHUP | POLLRDHUP | POLLERR)) == 0;
+    }
+
+    // Spins briefly, then sleeps on the slot's state word until the daemon completes it
+    SlotHeader* await(Ticket ticket, uint32_t op) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (ticket >= outstanding.size() || outstanding[ticket] != op) {
+                throw std::logic_error("KEM client ticket " + std::to_string(ticket) + " is not outstanding");
+            }
+        }
+        SlotHeader* slot = ring.slot(ticket);
+        for (int spin = 0; spin < 1000; ++spin) {
+            if (slot->state.load(std::memory_order_acquire) == SLOT_DONE) {
+                return slot;
+            }
+        }
+        for (;;) {
+            slot->waiting.store(1, std::memory_order_seq_cst);
+            if (slot->state.load(std::memory_order_seq_cst) == SLOT_DONE) {
+                break;
+            }
+            futex_wait(&slot->state, SLOT_SUBMITTED, 50 * 1000 * 1000);
+            if (slot->state.load(std::memory_order_acquire) == SLOT_DONE) {
+                break;
+            }
+            if (!daemon_alive()) {
+                throw std::runtime_error("KEM daemon disconnected");
+            }
+        }
+        slot->waiting.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot;
+    }
+
+    // Throws the daemon's error for a failed slot, releasing it
+    void check_status(Ticket ticket, const SlotHeader* slot) {
+        if (slot->status == STATUS_OK) {
+            return;
+        }
+        const uint32_t status = slot->status;
+        const size_t length = std::min<size_t>(slot->output_bytes, ERROR_TEXT_BYTES - 1);
+        std::string message(reinterpret_cast<const char*>(ring.data(ticket)), length);
+        release(ticket);
+        if (status == STATUS_INVALID_ARGUMENT) {
+            throw std::invalid_argument(message);
+        }
+        throw std::runtime_error("KEM daemon: " + message);
+    }
+
+    void check_params(const CLWEParameters& object_params, const char* what) const {
+        if (object_params.fingerprint() != params.fingerprint()) {
+            throw std::invalid_argument(std::string(what) + " parameters do not match the KEM client's");
+        }
+    }
+};
+
+KemClient::KemClient(const std::string& socket_path, uint32_t security_level, size_t ring_slots) {
+    CLWEParameters params;
+    try {
+        params = CLWEParameters(security_level);
+    } catch (const std::invalid_argument& e) {
+        throw std::runtime_error(std::string("KEM client: ") + e.what());
+    }
+    impl_.reset(new Impl(params));
+    impl_->connect_to(socket_path, security_level, ring_slots);
+}
+
+KemClient::~KemClient() = default;
+
+const CLWEParameters& KemClient::params() const {
+    return impl_->params;
+}
+
+size_t KemClient::ring_slots() const {
+    return impl_->ring.slot_count;
+}
+
+std::pair<ColorCiphertext, ColorValue> KemClient::encapsulate(const ColorPublicKey& public_key) {
+    return wait_encapsulate(submit_encapsulate(public_key));
+}
+
+ColorValue KemClient::decapsulate(const ColorPublicKey& public_key, const ColorPrivateKey& private_key,
+                                  const ColorCiphertext& ciphertext) {
+    return wait_decapsulate(submit_decapsulate(public_key, private_key, ciphertext));
+}
+
+KemClient::Ticket KemClient::submit_encapsulate(const ColorPublicKey& public_key) {
+    impl_->check_params(public_key.params, "Public key");
+    const uint32_t index = impl_->acquire(OP_ENCAPSULATE);
+    try {
+        const size_t written = public_key.serialize(impl_->ring.data(index), impl_->ring.slot_bytes);
+        return impl_->publish(index, OP_ENCAPSULATE, written);
+    } catch (...) {
+        impl_->release(index);
+        throw;
+    }
+}
+
+KemClient::Ticket KemClient::submit_decapsulate(const ColorPublicKey& public_key, const ColorPrivateKey& private_key,
+                                                const ColorCiphertext& ciphertext) {
+    impl_->check_params(public_key.params, "Public key");
+    impl_->check_params(private_key.params, "Private key");
+    impl_->check_params(ciphertext.params, "Ciphertext");
+    const uint32_t index = impl_->acquire(OP_DECAPSULATE);
+    uint8_t* out = impl_->ring.data(index);
+    const size_t capacity = impl_->ring.slot_bytes;
+    try {
+        // Fixed offsets: each object fills exactly its serialized size for these parameters
+        const WireSizes& sizes = impl_->sizes;
+        size_t written = public_key.serialize(out, sizes.public_key);
+        written += private_key.serialize(out + written, sizes.private_key);
+        written += ciphertext.serialize(out + written, capacity - written);
+        return impl_->publish(index, OP_DECAPSULATE, written);
+    } catch (...) {
+        secure_zero(out, capacity);
+        impl_->release(index);
+        throw;
+    }
+}
+
+std::pair<ColorCiphertext, ColorValue> KemClient::wait_encapsulate(Ticket ticket) {
+    const SlotHeader* slot = impl_->await(ticket, OP_ENCAPSULATE);
+    impl_->check_status(ticket, slot);
+    const uint8_t* in = impl_->ring.data(ticket);
+    const size_t ciphertext_bytes = impl_->sizes.ciphertext;
+    if (slot->output_bytes != ciphertext_bytes + SECRET_BYTES) {
+        impl_->release(ticket);
+        throw std::runtime_error("KEM daemon returned a malformed encapsulation");
+    }
+    std::pair<ColorCiphertext, ColorValue> result;
+    try {
+        result.first = ColorCiphertext::deserialize(in, ciphertext_bytes, impl_->params);
+        result.second = get_secret(in + ciphertext_bytes);
+    } catch (...) {
+        impl_->release(ticket);
+        throw;
+    }
+    impl_->release(ticket);
+    return result;
+}
+
+ColorValue KemClient::wait_decapsulate(Ticket ticket) {
+    const SlotHeader* slot = impl_->await(ticket, OP_DECAPSULATE);
+    impl_->check_status(ticket, slot);
+    if (slot->output_bytes != SECRET_BYTES) {
+        impl_->release(ticket);
+        throw std::runtime_error("KEM daemon returned a malformed decapsulation");
+    }
+    uint8_t* data = impl_->ring.data(ticket);
+    const ColorValue secret = get_secret(data);
+    secure_zero(data, SECRET_BYTES);
+    impl_->release(ticket);
+    return secret;
+}
+
+} // namespace clwe
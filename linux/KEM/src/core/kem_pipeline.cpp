@@ -0,0 +1,389 @@
+#include "clwe/kem_pipeline.hpp"
+#include "mpmc_ring.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace clwe {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Fingerprint = std::array<uint8_t, 32>;
+
+// Yields an idle stage thread makes before it sleeps on its queue
+constexpr unsigned IDLE_SPINS = 64;
+
+// A request on its way through the stages; it moves between queues by pointer
+struct Job {
+    KemPipelineResponse response;
+    std::vector<uint8_t> payload;
+    Fingerprint private_key{};
+    ColorPublicKey public_key;
+    ColorCiphertext ciphertext;
+    std::shared_ptr<const ExpandedPublicKey> expanded;
+    std::shared_ptr<const PreparedPrivateKey> prepared;
+    ColorCiphertext encapsulated;
+};
+
+using JobPtr = std::unique_ptr<Job>;
+
+// Input queue of one stage: the lock-free ring, plus a sleep path for threads that find
+// it empty. Pushes only touch the mutex while a consumer sleeps.
+class StageQueue {
+public:
+    explicit StageQueue(size_t capacity) : ring_(round_up_power_of_two(capacity)) {}
+
+    bool try_push(JobPtr& job) {
+        if (!ring_.try_push(std::move(job))) {
+            return false;
+        }
+        size_t depth = ring_.size();
+        size_t deepest = max_depth_.load(std::memory_order_relaxed);
+        while (depth > deepest && !max_depth_.compare_exchange_weak(deepest, depth, std::memory_order_relaxed)) {
+        }
+        if (sleepers_.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cv_.notify_one();
+        }
+        return true;
+    }
+
+    // Waits while the ring is full, which is how a slow stage pushes back on the one before
+    void push(JobPtr job) {
+        while (!try_push(job)) {
+            std::this_thread::yield();
+        }
+    }
+
+    bool try_pop(JobPtr& job) { return ring_.try_pop(job); }
+
+    // Sleep until a push or stop; the timeout covers a wakeup lost between the checks
+    void wait(const std::atomic<bool>& stopping) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        cv_.wait_for(lock, std::chrono::milliseconds(1),
+                     [&] { return ring_.size() > 0 || stopping.load(std::memory_order_acquire); });
+        sleepers_.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    void wake_all() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cv_.notify_all();
+    }
+
+    size_t size() const { return ring_.size(); }
+    size_t capacity() const { return ring_.capacity(); }
+    size_t max_depth() const { return max_depth_.load(std::memory_order_relaxed); }
+
+private:
+    MPMCRing<JobPtr> ring_;
+    std::atomic<size_t> max_depth_{0};
+    std::atomic<int> sleepers_{0};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
+struct Stage {
+    StageQueue queue;
+    size_t thread_count;
+    std::vector<std::thread> threads;
+    std::atomic<bool> stopping{false};
+    std::atomic<uint64_t> processed{0};
+    std::atomic<uint64_t> busy_ns{0};
+
+    Stage(size_t capacity, size_t stage_threads) : queue(capacity), thread_count(stage_threads) {}
+};
+
+} // namespace
+
+struct KemPipeline::Impl {
+    const ColorKEM& kem;
+    const KemPipelineConfig config;
+    const KemPipelineCallback callback;
+    const Clock::time_point started = Clock::now();
+    std::array<std::unique_ptr<Stage>, KEM_PIPELINE_STAGES> stages;
+    std::atomic<uint64_t> submitted{0};
+    std::atomic<uint64_t> completed{0};
+
+    // Registered private keys, prepared once
+    mutable std::shared_mutex private_keys_mutex;
+    std::map<Fingerprint, std::shared_ptr<const PreparedPrivateKey>> private_keys;
+
+    // Expanded public keys, oldest dropped first once expanded_key_capacity are held
+    std::mutex expanded_mutex;
+    std::map<Fingerprint, std::shared_ptr<const ExpandedPublicKey>> expanded;
+    std::deque<Fingerprint> expanded_order;
+
+    Impl(const ColorKEM& instance, const KemPipelineConfig& pipeline_config, KemPipelineCallback on_response)
+        : kem(instance), config(pipeline_config), callback(std::move(on_response)) {
+        const size_t threads[KEM_PIPELINE_STAGES] = {config.parse_threads, config.prepare_threads,
+                                                     config.compute_threads, config.serialize_threads};
+        for (size_t s = 0; s < KEM_PIPELINE_STAGES; ++s) {
+            stages[s].reset(new Stage(config.queue_capacity, threads[s]));
+        }
+        for (size_t s = 0; s < KEM_PIPELINE_STAGES; ++s) {
+            for (size_t t = 0; t < threads[s]; ++t) {
+                stages[s]->threads.emplace_back(&Impl::run_stage, this, s);
+            }
+        }
+    }
+
+    // Stages stop in order, each once the one before has drained into it, so every
+    // submitted request reaches the callback
+    void stop() {
+        for (std::unique_ptr<Stage>& stage : stages) {
+            stage->stopping.store(true, std::memory_order_release);
+            stage->queue.wake_all();
+            for (std::thread& thread : stage->threads) {
+                thread.join();
+            }
+        }
+    }
+
+    void run_stage(size_t index) {
+        Stage& stage = *stages[index];
+        const size_t limit = index == static_cast<size_t>(KemPipelineStage::COMPUTE) ? config.max_batch : 1;
+        KemWorkspace workspace;
+        std::vector<JobPtr> batch;
+        batch.reserve(limit);
+        unsigned idle = 0;
+        for (;;) {
+            JobPtr job;
+            while (batch.size() < limit && stage.queue.try_pop(job)) {
+                batch.push_back(std::move(job));
+            }
+            if (batch.empty()) {
+                if (stage.stopping.load(std::memory_order_acquire) && stage.queue.size() == 0) {
+                    return;
+                }
+                if (++idle < IDLE_SPINS) {
+                    std::this_thread::yield();
+                } else {
+                    stage.queue.wait(stage.stopping);
+                }
+                continue;
+            }
+            idle = 0;
+
+            const Clock::time_point start = Clock::now();
+            switch (static_cast<KemPipelineStage>(index)) {
+                case KemPipelineStage::PARSE:
+                    parse(*batch[0]);
+                    break;
+                case KemPipelineStage::PREPARE:
+                    prepare(*batch[0]);
+                    break;
+                case KemPipelineStage::COMPUTE:
+                    compute(batch, workspace);
+                    break;
+                case KemPipelineStage::SERIALIZE:
+                    serialize(*batch[0]);
+                    break;
+            }
+            stage.busy_ns.fetch_add(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count()),
+                std::memory_order_relaxed);
+            stage.processed.fetch_add(batch.size(), std::memory_order_relaxed);
+
+            if (index + 1 < KEM_PIPELINE_STAGES) {
+                for (JobPtr& done : batch) {
+                    // A failed request skips straight to the response
+                    const bool failed = done->response.error != CLWEError::SUCCESS;
+                    stages[failed ? static_cast<size_t>(KemPipelineStage::SERIALIZE) : index + 1]->queue.push(
+                        std::move(done));
+                }
+            }
+            batch.clear();
+        }
+    }
+
+    void parse(Job& job) {
+        const CLWEParameters& params = kem.params();
+        if (job.response.op == KemPipelineOp::ENCAPSULATE) {
+            if (ColorPublicKey::try_deserialize(job.payload.data(), job.payload.size(), params, job.public_key) !=
+                CLWEError::SUCCESS) {
+                job.response.error = CLWEError::INVALID_KEY;
+            }
+        } else if (ColorCiphertext::try_deserialize(job.payload.data(), job.payload.size(), params,
+                                                    job.ciphertext) != CLWEError::SUCCESS) {
+            job.response.error = CLWEError::INVALID_CIPHERTEXT;
+        }
+        job.payload = std::vector<uint8_t>();
+    }
+
+    void prepare(Job& job) {
+        if (job.response.op == KemPipelineOp::DECAPSULATE) {
+            std::shared_lock<std::shared_mutex> lock(private_keys_mutex);
+            auto found = private_keys.find(job.private_key);
+            if (found == private_keys.end()) {
+                job.response.error = CLWEError::INVALID_KEY;
+                return;
+            }
+            job.prepared = found->second;
+            return;
+        }
+
+        const Fingerprint fingerprint = job.public_key.fingerprint();
+        {
+            std::lock_guard<std::mutex> lock(expanded_mutex);
+            auto found = expanded.find(fingerprint);
+            if (found != expanded.end()) {
+                job.expanded = found->second;
+                return;
+            }
+        }
+        // Expanded outside the lock; two threads meeting a new key both expand it, and
+        // the second insert is dropped
+        try {
+            job.expanded = std::make_shared<const ExpandedPublicKey>(kem.expand_public_key(job.public_key));
+        } catch (const std::exception&) {
+            job.response.error = CLWEError::INVALID_KEY;
+            return;
+        }
+        std::lock_guard<std::mutex> lock(expanded_mutex);
+        if (expanded.emplace(fingerprint, job.expanded).second) {
+            expanded_order.push_back(fingerprint);
+            if (expanded_order.size() > config.expanded_key_capacity) {
+                expanded.erase(expanded_order.front());
+                expanded_order.pop_front();
+            }
+        }
+    }
+
+    void compute(std::vector<JobPtr>& batch, KemWorkspace& workspace) {
+        // One entropy draw for the batch's encapsulations, as encapsulate_batch() makes
+        size_t encapsulations = 0;
+        for (const JobPtr& job : batch) {
+            encapsulations += job->response.op == KemPipelineOp::ENCAPSULATE ? 1 : 0;
+        }
+        std::vector<uint8_t> seeds(encapsulations * 32);
+        if (!seeds.empty()) {
+            kem.random_source()->generate(seeds.data(), seeds.size());
+        }
+
+        size_t seed = 0;
+        for (JobPtr& job : batch) {
+            try {
+                if (job->response.op == KemPipelineOp::ENCAPSULATE) {
+                    std::array<uint8_t, 32> m;
+                    std::copy(seeds.begin() + seed * 32, seeds.begin() + (seed + 1) * 32, m.begin());
+                    ++seed;
+                    job->response.shared_secret = kem.encapsulate_into(*job->expanded, m, job->encapsulated,
+                                                                       workspace);
+                    secure_zero(m.data(), m.size());
+                } else {
+                    job->response.shared_secret = kem.decapsulate(*job->prepared, job->ciphertext, workspace);
+                }
+            } catch (const std::exception&) {
+                job->response.error = CLWEError::UNKNOWN_ERROR;
+            }
+            job->expanded.reset();
+            job->prepared.reset();
+        }
+        if (!seeds.empty()) {
+            secure_zero(seeds.data(), seeds.size());
+        }
+    }
+
+    void serialize(Job& job) {
+        KemPipelineResponse& response = job.response;
+        if (response.error == CLWEError::SUCCESS && response.op == KemPipelineOp::ENCAPSULATE) {
+            response.ciphertext.resize(ColorCiphertext::serialized_size(kem.params()));
+            job.encapsulated.serialize(response.ciphertext.data(), response.ciphertext.size());
+        }
+        try {
+            callback(std::move(response));
+        } catch (...) {
+            // The stage thread outlives a throwing callback; the response is lost
+        }
+        completed.fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+KemPipeline::KemPipeline(const ColorKEM& kem, const KemPipelineConfig& config, KemPipelineCallback callback) {
+    if (config.parse_threads == 0 || config.prepare_threads == 0 || config.compute_threads == 0 ||
+        config.serialize_threads == 0) {
+        throw std::invalid_argument("KemPipeline needs at least one thread per stage");
+    }
+    if (config.queue_capacity == 0 || config.max_batch == 0 || config.expanded_key_capacity == 0) {
+        throw std::invalid_argument("KemPipeline queue_capacity, max_batch and expanded_key_capacity must be positive");
+    }
+    if (!callback) {
+        throw std::invalid_argument("KemPipeline needs a response callback");
+    }
+    impl_.reset(new Impl(kem, config, std::move(callback)));
+}
+
+KemPipeline::~KemPipeline() {
+    impl_->stop();
+}
+
+void KemPipeline::add_private_key(const std::array<uint8_t, 32>& fingerprint, const ColorPrivateKey& private_key) {
+    auto prepared = std::make_shared<const PreparedPrivateKey>(impl_->kem.prepare_private_key(private_key));
+    std::unique_lock<std::shared_mutex> lock(impl_->private_keys_mutex);
+    impl_->private_keys[fingerprint] = std::move(prepared);
+}
+
+bool KemPipeline::remove_private_key(const std::array<uint8_t, 32>& fingerprint) {
+    std::unique_lock<std::shared_mutex> lock(impl_->private_keys_mutex);
+    return impl_->private_keys.erase(fingerprint) > 0;
+}
+
+bool KemPipeline::try_submit(KemPipelineRequest& request) {
+    JobPtr job(new Job());
+    job->response.id = request.id;
+    job->response.op = request.op;
+    job->payload = std::move(request.payload);
+    job->private_key = request.private_key;
+    if (!impl_->stages[static_cast<size_t>(KemPipelineStage::PARSE)]->queue.try_push(job)) {
+        request.payload = std::move(job->payload);
+        return false;
+    }
+    impl_->submitted.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void KemPipeline::submit(KemPipelineRequest request) {
+    while (!try_submit(request)) {
+        std::this_thread::yield();
+    }
+}
+
+std::array<KemPipelineStageStats, KEM_PIPELINE_STAGES> KemPipeline::stats() const {
+    const double lifetime_ns = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - impl_->started).count());
+    std::array<KemPipelineStageStats, KEM_PIPELINE_STAGES> result;
+    for (size_t s = 0; s < KEM_PIPELINE_STAGES; ++s) {
+        const Stage& stage = *impl_->stages[s];
+        KemPipelineStageStats& stats = result[s];
+        const double busy_ns = static_cast<double>(stage.busy_ns.load(std::memory_order_relaxed));
+        stats.threads = stage.thread_count;
+        stats.queue_depth = stage.queue.size();
+        stats.queue_capacity = stage.queue.capacity();
+        stats.max_queue_depth = stage.queue.max_depth();
+        stats.processed = stage.processed.load(std::memory_order_relaxed);
+        stats.mean_service_us = stats.processed > 0 ? busy_ns / 1000.0 / static_cast<double>(stats.processed) : 0.0;
+        stats.utilization = lifetime_ns > 0 ? std::min(1.0, busy_ns / (lifetime_ns * stage.thread_count)) : 0.0;
+    }
+    return result;
+}
+
+uint64_t KemPipeline::submitted() const {
+    return impl_->submitted.load(std::memory_order_relaxed);
+}
+
+uint64_t KemPipeline::completed() const {
+    return impl_->completed.load(std::memory_order_relaxed);
+}
+
+} // namespace clwe
@@ -0,0 +1,292 @@
+#include "clwe/key_archive.hpp"
+#include "bulk_io.hpp"
+#include "key_store_format.hpp"
+#include "encoding.hpp"
+#include "poly.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace clwe {
+
+using namespace key_store_format;
+
+const char* bulk_io_backend_name(BulkIoBackend backend) {
+    switch (backend) {
+    case BulkIoBackend::Auto:
+        return "auto";
+    case BulkIoBackend::IoUring:
+        return "io_uring";
+    case BulkIoBackend::Threaded:
+        return "threaded";
+    }
+    return "unknown";
+}
+
+KeyArchiveWriter::KeyArchiveWriter(const std::string& path, const CLWEParameters& params,
+                                   const KeyArchiveOptions& options)
+    : path_(path), temp_path_(path + ".tmp"), params_(params), offset_(HEADER_BYTES) {
+    check_store_parameters(params);
+    record_bytes_ = record_bytes(params);
+
+    fd_ = ::open(temp_path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("Cannot create key store file " + temp_path_ + ": " + std::strerror(errno));
+    }
+    // Every buffer holds whole records, whole index entries, whole expanded entries and the header
+    const size_t buffer_bytes = std::max({options.buffer_bytes, record_bytes_, HEADER_BYTES, INDEX_ENTRY_BYTES,
+                                          expanded_entry_bytes(params)});
+    try {
+        io_ = make_bulk_file_io(fd_, std::max<size_t>(options.buffer_count, 1), buffer_bytes, options.submit_batch,
+                                options.backend);
+    } catch (...) {
+        discard();
+        throw;
+    }
+    backend_ = io_->backend();
+}
+
+KeyArchiveWriter::~KeyArchiveWriter() {
+    discard();
+}
+
+void KeyArchiveWriter::discard() noexcept {
+    // The transfers still in flight are waited for before their buffers go away
+    io_.reset();
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+        std::remove(temp_path_.c_str());
+    }
+}
+
+void KeyArchiveWriter::flush_buffer() {
+    if (fill_ == 0) {
+        return;
+    }
+    io_->write(current_, fill_, offset_);
+    offset_ += fill_;
+    fill_ = 0;
+    current_ = (current_ + 1) % io_->buffer_count();
+    io_->wait(current_);
+}
+
+void KeyArchiveWriter::reserve(size_t bytes) {
+    if (!io_) {
+        throw std::logic_error("Key archive writer is finished or has failed");
+    }
+    if (fill_ + bytes > io_->buffer_bytes()) {
+        try {
+            flush_buffer();
+        } catch (...) {
+            discard();
+            throw;
+        }
+    }
+}
+
+void KeyArchiveWriter::append(const ColorPublicKey& public_key) {
+    reserve(record_bytes_);
+    pack_record(public_key, params_, seeds_.size(), colors_, io_->buffer(current_) + fill_);
+    seeds_.push_back(public_key.seed);
+    fill_ += record_bytes_;
+}
+
+void KeyArchiveWriter::append(const std::vector<ColorPublicKey>& public_keys) {
+    seeds_.reserve(seeds_.size() + public_keys.size());
+    for (const ColorPublicKey& public_key : public_keys) {
+        append(public_key);
+    }
+}
+
+void KeyArchiveWriter::store_expanded(size_t record) {
+    if (!io_) {
+        throw std::logic_error("Key archive writer is finished or has failed");
+    }
+    if (record >= seeds_.size()) {
+        throw std::invalid_argument("Cannot store expanded matrix of record " + std::to_string(record) + ": only " +
+                                    std::to_string(seeds_.size()) + " records appended");
+    }
+    if (params_.shared_matrix) {
+        throw std::invalid_argument("Shared-matrix keys have no matrix of their own to store");
+    }
+    expanded_records_.push_back(record);
+}
+
+void KeyArchiveWriter::finish() {
+    if (!io_) {
+        throw std::logic_error("Key archive writer is finished or has failed");
+    }
+    const size_t count = seeds_.size();
+
+    // Sorting (seed, record) pairs keeps duplicate seeds in record order
+    std::vector<size_t> order(count);
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        int cmp = std::memcmp(seeds_[a].data(), seeds_[b].data(), SEED_BYTES);
+        return cmp != 0 ? cmp < 0 : a < b;
+    });
+
+    try {
+        for (size_t i : order) {
+            reserve(INDEX_ENTRY_BYTES);
+            uint8_t* entry = io_->buffer(current_) + fill_;
+            std::memcpy(entry, seeds_[i].data(), SEED_BYTES);
+            put_le64(entry + SEED_BYTES, i);
+            fill_ += INDEX_ENTRY_BYTES;
+        }
+
+        if (!expanded_records_.empty()) {
+            std::sort(expanded_records_.begin(), expanded_records_.end());
+            expanded_records_.erase(std::unique(expanded_records_.begin(), expanded_records_.end()),
+                                    expanded_records_.end());
+            reserve(EXPANDED_HEADER_BYTES);
+            encode_expanded_header(io_->buffer(current_) + fill_, expanded_records_.size());
+            fill_ += EXPANDED_HEADER_BYTES;
+
+            // A depends only on the seed, so a key with a zero t expands to the record's matrix
+            const ColorKEM kem(params_);
+            ColorPublicKey seed_key;
+            seed_key.params = params_;
+            seed_key.public_data.assign(
+                encoded_coefficients_size(static_cast<size_t>(params_.module_rank) * params_.degree, params_.encoding), 0);
+            const size_t entry_bytes = expanded_entry_bytes(params_);
+            for (uint64_t record : expanded_records_) {
+                seed_key.seed = seeds_[record];
+                const ExpandedPublicKey expanded = kem.expand_public_key(seed_key);
+                const PolyMatrix& matrix = *expanded.matrix_A;
+                reserve(entry_bytes);
+                uint8_t* entry = io_->buffer(current_) + fill_;
+                put_le64(entry, record);
+                encode_coefficients(matrix.data(), static_cast<size_t>(matrix.rank()) * matrix.rank() * matrix.degree(),
+                                    CoefficientEncoding::PACKED12, entry + 8);
+                fill_ += entry_bytes;
+            }
+        }
+        flush_buffer();
+        io_->wait_all();
+
+        // The header goes last, so a file cut short never claims records it lacks
+        encode_header(io_->buffer(current_), params_, count);
+        io_->write(current_, HEADER_BYTES, 0);
+        io_->wait(current_);
+        io_.reset();
+        if (::fsync(fd_) != 0) {
+            throw std::runtime_error("Cannot sync key store file " + temp_path_ + ": " + std::strerror(errno));
+        }
+    } catch (...) {
+        discard();
+        throw;
+    }
+
+    ::close(fd_);
+    fd_ = -1;
+    if (std::rename(temp_path_.c_str(), path_.c_str()) != 0) {
+        int err = errno;
+        std::remove(temp_path_.c_str());
+        throw std::runtime_error("Cannot replace key store file " + path_ + ": " + std::strerror(err));
+    }
+}
+
+KeyArchiveReader::KeyArchiveReader(const std::string& path, const KeyArchiveOptions& options) : path_(path) {
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+        throw std::runtime_error("Cannot open key store file " + path + ": " + std::strerror(errno));
+    }
+    try {
+        struct stat st;
+        if (fstat(fd_, &st) != 0) {
+            throw std::runtime_error("Cannot stat key store file " + path + ": " + std::strerror(errno));
+        }
+        const uint64_t file_size = static_cast<uint64_t>(st.st_size);
+        uint8_t header[HEADER_BYTES];
+        if (file_size < HEADER_BYTES || ::pread(fd_, header, HEADER_BYTES, 0) != static_cast<ssize_t>(HEADER_BYTES)) {
+            throw std::runtime_error("Key store file too small for its header: " + path);
+        }
+        const Header parsed = parse_header(header, file_size, path);
+        params_ = parsed.params;
+        count_ = static_cast<size_t>(parsed.count);
+        // Records are all the reader returns, but a file with a damaged expanded section is still refused
+        if (parsed.expanded_bytes != 0) {
+            uint8_t section[EXPANDED_HEADER_BYTES];
+            const uint64_t section_offset = file_size - parsed.expanded_bytes;
+            if (::pread(fd_, section, sizeof(section), static_cast<off_t>(section_offset)) !=
+                static_cast<ssize_t>(sizeof(section))) {
+                throw std::runtime_error("Cannot read key store expanded section: " + path);
+            }
+            parse_expanded_header(section, parsed.expanded_bytes, params_, path);
+        }
+        record_bytes_ = record_bytes(params_);
+
+        chunk_records_ = std::max(options.buffer_bytes, record_bytes_) / record_bytes_;
+        const size_t buffer_count = std::max<size_t>(options.buffer_count, 1);
+        io_ = make_bulk_file_io(fd_, buffer_count, chunk_records_ * record_bytes_, options.submit_batch,
+                                options.backend);
+        backend_ = io_->backend();
+        buffer_records_.assign(buffer_count, 0);
+        for (size_t b = 0; b < buffer_count; ++b) {
+            issue(b);
+        }
+        io_->submit();
+    } catch (...) {
+        io_.reset();
+        ::close(fd_);
+        throw;
+    }
+}
+
+KeyArchiveReader::~KeyArchiveReader() {
+    io_.reset();
+    ::close(fd_);
+}
+
+// Buffers are refilled round-robin, so they hold consecutive chunks in buffer order
+void KeyArchiveReader::issue(size_t buffer) {
+    const size_t records = std::min(chunk_records_, count_ - issued_);
+    buffer_records_[buffer] = records;
+    if (records > 0) {
+        io_->read(buffer, records * record_bytes_, HEADER_BYTES + static_cast<uint64_t>(issued_) * record_bytes_);
+        issued_ += records;
+    }
+}
+
+bool KeyArchiveReader::next(ColorPublicKey& public_key) {
+    if (delivered_ == count_) {
+        return false;
+    }
+    if (!consuming_ || position_ == buffer_records_[current_]) {
+        if (consuming_) {
+            issue(current_);
+            current_ = (current_ + 1) % buffer_records_.size();
+        }
+        consuming_ = true;
+        position_ = 0;
+        if (io_->wait(current_) != buffer_records_[current_] * record_bytes_) {
+            throw std::runtime_error("Key store file ends before its records: " + path_);
+        }
+    }
+    unpack_record(io_->buffer(current_) + position_ * record_bytes_, params_, colors_, public_key);
+    ++position_;
+    ++delivered_;
+    return true;
+}
+
+size_t KeyArchiveReader::read(std::vector<ColorPublicKey>& public_keys, size_t max_keys) {
+    const size_t available = std::min(max_keys, count_ - delivered_);
+    public_keys.reserve(public_keys.size() + available);
+    ColorPublicKey key;
+    for (size_t i = 0; i < available; ++i) {
+        next(key);
+        public_keys.push_back(key);
+    }
+    return available;
+}
+
+} // namespace clwe
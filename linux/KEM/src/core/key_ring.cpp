@@ -0,0 +1,131 @@
+#include "clwe/key_ring.hpp"
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace clwe {
+
+// Immutable once published; rotations replace it whole
+struct KeyRing::ReadGuard::Snapshot {
+    std::shared_ptr<const Key> current;
+    std::shared_ptr<const Key> previous;
+};
+
+namespace {
+
+// Spreads threads over the reader slots so they do not share a counter's cache line
+size_t reader_slot_index() {
+    static std::atomic<size_t> next_slot{0};
+    thread_local const size_t slot = next_slot.fetch_add(1, std::memory_order_relaxed) % KeyRing::READER_SLOTS;
+    return slot;
+}
+
+} // namespace
+
+KeyRing::ReadGuard::ReadGuard(std::atomic<uint64_t>* counter, const Snapshot* snapshot)
+    : counter_(counter), snapshot_(snapshot) {}
+
+KeyRing::ReadGuard::ReadGuard(ReadGuard&& other) noexcept
+    : counter_(other.counter_), snapshot_(other.snapshot_) {
+    other.counter_ = nullptr;
+    other.snapshot_ = nullptr;
+}
+
+KeyRing::ReadGuard::~ReadGuard() {
+    if (counter_ != nullptr) {
+        counter_->fetch_sub(1, std::memory_order_release);
+    }
+}
+
+const KeyRing::Key* KeyRing::ReadGuard::current() const {
+    return snapshot_ != nullptr ? snapshot_->current.get() : nullptr;
+}
+
+const KeyRing::Key* KeyRing::ReadGuard::previous() const {
+    return snapshot_ != nullptr ? snapshot_->previous.get() : nullptr;
+}
+
+const KeyRing::Key* KeyRing::ReadGuard::find(uint64_t version) const {
+    const Key* key = current();
+    if (key != nullptr && key->version == version) {
+        return key;
+    }
+    key = previous();
+    return key != nullptr && key->version == version ? key : nullptr;
+}
+
+KeyRing::KeyRing(const ColorKEM& kem)
+    : kem_(kem), snapshot_(new Snapshot()), epoch_(0), next_version_(1) {
+    for (ReaderSlot& slot : slots_) {
+        slot.readers[0].store(0, std::memory_order_relaxed);
+        slot.readers[1].store(0, std::memory_order_relaxed);
+    }
+}
+
+KeyRing::~KeyRing() {
+    delete snapshot_.load();
+}
+
+KeyRing::ReadGuard KeyRing::read() const {
+    ReaderSlot& slot = slots_[reader_slot_index()];
+    for (;;) {
+        // Announce the reader under the epoch it saw, then confirm no writer flipped it
+        // meanwhile; a reader counted under the old parity is one synchronize() waits for
+        const uint64_t epoch = epoch_.load();
+        std::atomic<uint64_t>& counter = slot.readers[epoch & 1];
+        counter.fetch_add(1);
+        if (epoch_.load() == epoch) {
+            return ReadGuard(&counter, snapshot_.load());
+        }
+        counter.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void KeyRing::synchronize() {
+    // Readers arriving after the flip count under the other parity and see the new snapshot
+    const uint64_t epoch = epoch_.load();
+    epoch_.store(epoch + 1);
+    for (ReaderSlot& slot : slots_) {
+        while (slot.readers[epoch & 1].load() != 0) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+uint64_t KeyRing::rotate(const ColorPublicKey& public_key, const ColorPrivateKey& private_key) {
+    // The expensive part, before any shared state is touched
+    auto key = std::make_shared<Key>();
+    key->public_key = public_key;
+    key->expanded_public_key = kem_.expand_public_key(public_key);
+    key->private_key = kem_.prepare_private_key(private_key);
+
+    std::lock_guard<std::mutex> lock(rotate_mutex_);
+    key->version = next_version_++;
+    const uint64_t version = key->version;
+    const Snapshot* retired = snapshot_.load();
+    snapshot_.store(new Snapshot{std::move(key), retired->current});
+    synchronize();
+    delete retired;
+    return version;
+}
+
+uint64_t KeyRing::rotate() {
+    auto keys = kem_.keygen();
+    return rotate(keys.first, keys.second);
+}
+
+ColorValue KeyRing::decapsulate(const ColorCiphertext& ciphertext, uint64_t version) const {
+    ReadGuard guard = read();
+    const Key* key = guard.find(version);
+    if (key == nullptr) {
+        throw std::invalid_argument("Key ring holds no key with version " + std::to_string(version));
+    }
+    return kem_.decapsulate(key->private_key, ciphertext);
+}
+
+uint64_t KeyRing::current_version() const {
+    ReadGuard guard = read();
+    return guard.current() != nullptr ? guard.current()->version : 0;
+}
+
+} // namespace clwe
@@ -0,0 +1,473 @@
+#include "clwe/key_store.hpp"
+#include "clwe/key_archive.hpp"
+#include "key_store_format.hpp"
+#include "encoding.hpp"
+#include "page_allocator.hpp"
+#include "poly.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace clwe {
+
+namespace {
+
+constexpr uint8_t STORE_MAGIC[4] = {'C', 'L', 'K', 'S'};
+constexpr uint8_t EXPANDED_MAGIC[4] = {'C', 'L', 'K', 'X'};
+
+// Header offsets; parameters are eight u32 fields followed by four u8 fields. The xof and
+// flags bytes were reserved (zero: SHAKE128, no flags) before they existed, so older stores
+// still open
+constexpr size_t OFFSET_VERSION = 4;
+constexpr size_t OFFSET_PARAMS = 8;
+constexpr size_t OFFSET_ENCODING = 40;
+constexpr size_t OFFSET_SPARSE_C2 = 41;
+constexpr size_t OFFSET_XOF = 42;
+constexpr size_t OFFSET_FLAGS = 43;
+constexpr size_t OFFSET_RECORD_BYTES = 44;
+constexpr size_t OFFSET_COUNT = 48;
+constexpr size_t OFFSET_INDEX = 56;
+
+constexpr uint8_t FLAG_SHARED_MATRIX = 0x01;
+
+void put_le32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+uint32_t get_le32(const uint8_t* in) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; --i) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+size_t coefficient_count(const CLWEParameters& params) {
+    return static_cast<size_t>(params.module_rank) * params.degree;
+}
+
+} // namespace
+
+namespace key_store_format {
+
+void put_le64(uint8_t* out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+uint64_t get_le64(const uint8_t* in) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+// secret_weight shapes private keys only and is not stored, so it is not compared
+bool same_parameters(const CLWEParameters& a, const CLWEParameters& b) {
+    return a.security_level == b.security_level &&
+           a.modulus == b.modulus &&
+           a.degree == b.degree &&
+           a.module_rank == b.module_rank &&
+           a.eta1 == b.eta1 &&
+           a.eta2 == b.eta2 &&
+           a.encoding == b.encoding &&
+           a.du == b.du &&
+           a.dv == b.dv &&
+           a.sparse_c2 == b.sparse_c2 &&
+           a.xof == b.xof &&
+           a.shared_matrix == b.shared_matrix &&
+           a.t_dropped_bits == b.t_dropped_bits;
+}
+
+void check_store_parameters(const CLWEParameters& params) {
+    params.validate();
+    if (params.modulus > 4096) {
+        throw std::invalid_argument("Key store requires a modulus of at most 4096, got " + std::to_string(params.modulus));
+    }
+    // Records hold t_hat packed at 12 bits, which rounded keys do not carry
+    if (params.t_dropped_bits != 0) {
+        throw std::invalid_argument("Key store does not support rounded public keys (t_dropped_bits " +
+                                    std::to_string(params.t_dropped_bits) + ")");
+    }
+}
+
+size_t record_bytes(const CLWEParameters& params) {
+    return SEED_BYTES + encoded_coefficients_size(coefficient_count(params), CoefficientEncoding::PACKED12);
+}
+
+void encode_header(uint8_t* header, const CLWEParameters& params, uint64_t count) {
+    const size_t record_size = record_bytes(params);
+    std::memset(header, 0, HEADER_BYTES);
+    std::memcpy(header, STORE_MAGIC, sizeof(STORE_MAGIC));
+    put_le32(header + OFFSET_VERSION, STORE_VERSION);
+    const uint32_t fields[8] = {params.security_level, params.degree, params.module_rank, params.modulus,
+                                params.eta1, params.eta2, params.du, params.dv};
+    for (size_t i = 0; i < 8; ++i) {
+        put_le32(header + OFFSET_PARAMS + 4 * i, fields[i]);
+    }
+    header[OFFSET_ENCODING] = static_cast<uint8_t>(params.encoding);
+    header[OFFSET_SPARSE_C2] = params.sparse_c2 ? 1 : 0;
+    header[OFFSET_XOF] = static_cast<uint8_t>(params.xof);
+    header[OFFSET_FLAGS] = params.shared_matrix ? FLAG_SHARED_MATRIX : 0;
+    put_le32(header + OFFSET_RECORD_BYTES, static_cast<uint32_t>(record_size));
+    put_le64(header + OFFSET_COUNT, count);
+    put_le64(header + OFFSET_INDEX, HEADER_BYTES + count * record_size);
+}
+
+Header parse_header(const uint8_t* header, uint64_t file_size, const std::string& path) {
+    if (std::memcmp(header, STORE_MAGIC, sizeof(STORE_MAGIC)) != 0) {
+        throw std::runtime_error("Not a key store file: " + path);
+    }
+    if (get_le32(header + OFFSET_VERSION) != STORE_VERSION) {
+        throw std::runtime_error("Unsupported key store version " + std::to_string(get_le32(header + OFFSET_VERSION)));
+    }
+
+    Header result;
+    CLWEParameters& params = result.params;
+    params.security_level = get_le32(header + OFFSET_PARAMS);
+    params.degree = get_le32(header + OFFSET_PARAMS + 4);
+    params.module_rank = get_le32(header + OFFSET_PARAMS + 8);
+    params.modulus = get_le32(header + OFFSET_PARAMS + 12);
+    params.eta1 = get_le32(header + OFFSET_PARAMS + 16);
+    params.eta2 = get_le32(header + OFFSET_PARAMS + 20);
+    params.du = get_le32(header + OFFSET_PARAMS + 24);
+    params.dv = get_le32(header + OFFSET_PARAMS + 28);
+    if (header[OFFSET_ENCODING] > static_cast<uint8_t>(CoefficientEncoding::PACKED12) || header[OFFSET_SPARSE_C2] > 1 ||
+        header[OFFSET_XOF] > static_cast<uint8_t>(XofAlgorithm::AES256_CTR) ||
+        (header[OFFSET_FLAGS] & ~FLAG_SHARED_MATRIX) != 0) {
+        throw std::runtime_error("Invalid key store parameters: unknown encoding, xof or flag");
+    }
+    params.encoding = static_cast<CoefficientEncoding>(header[OFFSET_ENCODING]);
+    params.sparse_c2 = header[OFFSET_SPARSE_C2] != 0;
+    params.xof = static_cast<XofAlgorithm>(header[OFFSET_XOF]);
+    params.shared_matrix = (header[OFFSET_FLAGS] & FLAG_SHARED_MATRIX) != 0;
+    try {
+        params.validate();
+    } catch (const std::invalid_argument& e) {
+        throw std::runtime_error(std::string("Invalid key store parameters: ") + e.what());
+    }
+    if (params.modulus > 4096) {
+        throw std::runtime_error("Invalid key store parameters: modulus does not fit in 12 bits");
+    }
+
+    const size_t record_size = record_bytes(params);
+    if (get_le32(header + OFFSET_RECORD_BYTES) != record_size) {
+        throw std::runtime_error("Key store record size does not match its parameters");
+    }
+    result.count = get_le64(header + OFFSET_COUNT);
+    result.index_offset = get_le64(header + OFFSET_INDEX);
+    const uint64_t max_count = (file_size - HEADER_BYTES) / (record_size + INDEX_ENTRY_BYTES);
+    if (result.count > max_count || result.index_offset != HEADER_BYTES + result.count * record_size ||
+        file_size < result.index_offset + result.count * INDEX_ENTRY_BYTES) {
+        throw std::runtime_error("Key store size does not match its header: " + path);
+    }
+    result.expanded_bytes = file_size - (result.index_offset + result.count * INDEX_ENTRY_BYTES);
+    // Shared-matrix keys have no matrix of their own to store
+    if (result.expanded_bytes != 0 && (result.expanded_bytes < EXPANDED_HEADER_BYTES || params.shared_matrix)) {
+        throw std::runtime_error("Key store size does not match its header: " + path);
+    }
+    return result;
+}
+
+size_t expanded_entry_bytes(const CLWEParameters& params) {
+    const size_t matrix_coeffs = static_cast<size_t>(params.module_rank) * coefficient_count(params);
+    return 8 + encoded_coefficients_size(matrix_coeffs, CoefficientEncoding::PACKED12);
+}
+
+void encode_expanded_header(uint8_t* header, uint64_t count) {
+    std::memset(header, 0, EXPANDED_HEADER_BYTES);
+    std::memcpy(header, EXPANDED_MAGIC, sizeof(EXPANDED_MAGIC));
+    put_le64(header + 8, count);
+}
+
+uint64_t parse_expanded_header(const uint8_t* section, uint64_t section_bytes, const CLWEParameters& params,
+                               const std::string& path) {
+    if (section_bytes < EXPANDED_HEADER_BYTES || std::memcmp(section, EXPANDED_MAGIC, sizeof(EXPANDED_MAGIC)) != 0 ||
+        get_le32(section + 4) != 0) {
+        throw std::runtime_error("Invalid key store expanded section: " + path);
+    }
+    const uint64_t count = get_le64(section + 8);
+    const uint64_t entry_size = expanded_entry_bytes(params);
+    if (count > (section_bytes - EXPANDED_HEADER_BYTES) / entry_size ||
+        section_bytes != EXPANDED_HEADER_BYTES + count * entry_size) {
+        throw std::runtime_error("Key store expanded section size does not match its header: " + path);
+    }
+    return count;
+}
+
+void pack_record(const ColorPublicKey& key, const CLWEParameters& params, size_t number,
+                 std::vector<ColorValue>& colors, uint8_t* out) {
+    const size_t coeffs = coefficient_count(params);
+    const size_t key_data_size = encoded_coefficients_size(coeffs, params.encoding);
+    if (!same_parameters(key.params, params)) {
+        throw std::invalid_argument("Public key " + std::to_string(number) + " does not have the key store parameters");
+    }
+    if (key.public_data.size() != key_data_size) {
+        throw std::invalid_argument("Invalid public key data size for key " + std::to_string(number) + ": expected " +
+                                    std::to_string(key_data_size) + " bytes, got " + std::to_string(key.public_data.size()));
+    }
+
+    colors.resize(coeffs);
+    if (!decode_coefficients_checked(key.public_data.data(), coeffs, params.encoding, params.modulus, colors.data())) {
+        throw std::invalid_argument("Public key " + std::to_string(number) + " has a coefficient not reduced mod q");
+    }
+    std::copy(key.seed.begin(), key.seed.end(), out);
+    encode_coefficients(colors.data(), coeffs, CoefficientEncoding::PACKED12, out + SEED_BYTES);
+}
+
+void unpack_record(const uint8_t* record, const CLWEParameters& params, std::vector<ColorValue>& colors,
+                   ColorPublicKey& key) {
+    const size_t coeffs = coefficient_count(params);
+    colors.resize(coeffs);
+    if (!decode_coefficients_checked(record + SEED_BYTES, coeffs, CoefficientEncoding::PACKED12, params.modulus,
+                                     colors.data())) {
+        throw std::runtime_error("Corrupt key store record: coefficient not reduced mod q");
+    }
+    std::copy(record, record + SEED_BYTES, key.seed.begin());
+    key.public_data.resize(encoded_coefficients_size(coeffs, params.encoding));
+    encode_coefficients(colors.data(), coeffs, params.encoding, key.public_data.data());
+    key.params = params;
+}
+
+} // namespace key_store_format
+
+using namespace key_store_format;
+
+static_assert(KeyStore::HEADER_BYTES == key_store_format::HEADER_BYTES &&
+              KeyStore::INDEX_ENTRY_BYTES == key_store_format::INDEX_ENTRY_BYTES,
+              "KeyStore constants must match the file format");
+
+size_t KeyStore::record_bytes(const CLWEParameters& params) {
+    return key_store_format::record_bytes(params);
+}
+
+void KeyStore::write(const std::string& path, const std::vector<ColorPublicKey>& public_keys,
+                     const CLWEParameters& params, const std::vector<size_t>& expanded_records) {
+    // The writer builds path + ".tmp" and renames it into place, so an open store never
+    // sees a partial file and a rejected key leaves any previous file untouched
+    KeyArchiveWriter writer(path, params);
+    writer.append(public_keys);
+    for (size_t record : expanded_records) {
+        writer.store_expanded(record);
+    }
+    writer.finish();
+}
+
+KeyStore KeyStore::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open key store file " + path + ": " + std::strerror(errno));
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int err = errno;
+        ::close(fd);
+        throw std::runtime_error("Cannot stat key store file " + path + ": " + std::strerror(err));
+    }
+    const size_t file_size = static_cast<size_t>(st.st_size);
+    if (file_size < HEADER_BYTES) {
+        ::close(fd);
+        throw std::runtime_error("Key store file too small for its header: " + path);
+    }
+
+    void* mapping = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+    int map_errno = errno;
+    // The mapping keeps the file referenced on its own
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Cannot map key store file " + path + ": " + std::strerror(map_errno));
+    }
+
+    // From here the store owns the mapping, so a malformed file unmaps on throw
+    KeyStore store;
+    store.mapping_ = static_cast<const uint8_t*>(mapping);
+    store.mapping_size_ = file_size;
+    const uint8_t* header = store.mapping_;
+
+    const Header parsed = parse_header(header, file_size, path);
+    store.params_ = parsed.params;
+    store.record_bytes_ = record_bytes(parsed.params);
+    const uint64_t count = parsed.count;
+    const uint64_t index_offset = parsed.index_offset;
+    store.count_ = static_cast<size_t>(count);
+    store.records_ = store.mapping_ + HEADER_BYTES;
+    store.index_ = store.mapping_ + index_offset;
+
+    if (parsed.expanded_bytes != 0) {
+        const size_t section_offset = file_size - static_cast<size_t>(parsed.expanded_bytes);
+        const uint8_t* section = store.mapping_ + section_offset;
+        store.expanded_count_ = static_cast<size_t>(parse_expanded_header(section, parsed.expanded_bytes,
+                                                                          store.params_, path));
+        store.expanded_entry_bytes_ = expanded_entry_bytes(store.params_);
+        store.expanded_ = section + EXPANDED_HEADER_BYTES;
+        // expanded_entry() binary-searches the record numbers, which must ascend within range
+        for (size_t i = 0; i < store.expanded_count_; ++i) {
+            const uint64_t record = get_le64(store.expanded_ + i * store.expanded_entry_bytes_);
+            if (record >= count ||
+                (i > 0 && record <= get_le64(store.expanded_ + (i - 1) * store.expanded_entry_bytes_))) {
+                throw std::runtime_error("Corrupt key store expanded section: record numbers out of order or range");
+            }
+        }
+        // Hot keys are wanted from the first request, so their matrices are read ahead
+        const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        const size_t prefetch_offset = section_offset / page * page;
+        posix_madvise(const_cast<uint8_t*>(store.mapping_) + prefetch_offset, file_size - prefetch_offset,
+                      POSIX_MADV_WILLNEED);
+    }
+
+    // Encapsulations touch records in no particular order, so readahead only wastes page cache
+    if (store.count_ > 0) {
+        posix_madvise(const_cast<uint8_t*>(store.mapping_), HEADER_BYTES + store.count_ * store.record_bytes_,
+                      POSIX_MADV_RANDOM);
+    }
+    // Best effort: page-cache huge pages need CONFIG_READ_ONLY_THP_FOR_FS
+    if (page_policy() == PagePolicy::Huge) {
+        advise_huge_pages(store.mapping_, store.mapping_size_);
+    }
+    return store;
+}
+
+KeyStore::KeyStore(KeyStore&& other) noexcept
+    : mapping_(other.mapping_), mapping_size_(other.mapping_size_), records_(other.records_),
+      index_(other.index_), count_(other.count_), record_bytes_(other.record_bytes_), expanded_(other.expanded_),
+      expanded_count_(other.expanded_count_), expanded_entry_bytes_(other.expanded_entry_bytes_),
+      params_(other.params_) {
+    other.mapping_ = nullptr;
+    other.mapping_size_ = 0;
+    other.records_ = nullptr;
+    other.index_ = nullptr;
+    other.count_ = 0;
+    other.expanded_ = nullptr;
+    other.expanded_count_ = 0;
+}
+
+KeyStore& KeyStore::operator=(KeyStore&& other) noexcept {
+    if (this != &other) {
+        if (mapping_ != nullptr) {
+            munmap(const_cast<uint8_t*>(mapping_), mapping_size_);
+        }
+        mapping_ = other.mapping_;
+        mapping_size_ = other.mapping_size_;
+        records_ = other.records_;
+        index_ = other.index_;
+        count_ = other.count_;
+        record_bytes_ = other.record_bytes_;
+        expanded_ = other.expanded_;
+        expanded_count_ = other.expanded_count_;
+        expanded_entry_bytes_ = other.expanded_entry_bytes_;
+        params_ = other.params_;
+        other.mapping_ = nullptr;
+        other.mapping_size_ = 0;
+        other.records_ = nullptr;
+        other.index_ = nullptr;
+        other.count_ = 0;
+        other.expanded_ = nullptr;
+        other.expanded_count_ = 0;
+    }
+    return *this;
+}
+
+KeyStore::~KeyStore() {
+    if (mapping_ != nullptr) {
+        munmap(const_cast<uint8_t*>(mapping_), mapping_size_);
+    }
+}
+
+ColorPublicKeyView KeyStore::key(size_t index) const {
+    if (index >= count_) {
+        throw std::invalid_argument("Key store index " + std::to_string(index) + " out of range for " +
+                                    std::to_string(count_) + " records");
+    }
+    const uint8_t* record = records_ + index * record_bytes_;
+    ColorPublicKeyView view;
+    view.seed = record;
+    view.public_data = record + 32;
+    view.public_data_size = record_bytes_ - 32;
+    view.encoding = CoefficientEncoding::PACKED12;
+    view.params = params_;
+    return view;
+}
+
+size_t KeyStore::find(const std::array<uint8_t, 32>& seed) const {
+    size_t lo = 0;
+    size_t hi = count_;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (std::memcmp(index_ + mid * INDEX_ENTRY_BYTES, seed.data(), 32) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == count_ || std::memcmp(index_ + lo * INDEX_ENTRY_BYTES, seed.data(), 32) != 0) {
+        return npos;
+    }
+    uint64_t record = get_le64(index_ + lo * INDEX_ENTRY_BYTES + 32);
+    if (record >= count_) {
+        throw std::runtime_error("Corrupt key store index: record " + std::to_string(record) + " out of range");
+    }
+    return static_cast<size_t>(record);
+}
+
+const uint8_t* KeyStore::expanded_entry(size_t index) const {
+    size_t lo = 0;
+    size_t hi = expanded_count_;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (get_le64(expanded_ + mid * expanded_entry_bytes_) < index) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == expanded_count_ || get_le64(expanded_ + lo * expanded_entry_bytes_) != index) {
+        return nullptr;
+    }
+    return expanded_ + lo * expanded_entry_bytes_;
+}
+
+ExpandedPublicKey KeyStore::expanded_key(size_t index) const {
+    if (index >= count_) {
+        throw std::invalid_argument("Key store index " + std::to_string(index) + " out of range for " +
+                                    std::to_string(count_) + " records");
+    }
+    const uint8_t* entry = expanded_entry(index);
+    if (entry == nullptr) {
+        throw std::invalid_argument("Key store record " + std::to_string(index) + " has no stored expanded matrix");
+    }
+
+    const uint32_t k = params_.module_rank;
+    const uint32_t n = params_.degree;
+    auto matrix = std::make_shared<PolyMatrix>(k, n);
+    if (!decode_coefficients_checked(entry + 8, static_cast<size_t>(k) * k * n, CoefficientEncoding::PACKED12,
+                                     params_.modulus, matrix->data())) {
+        throw std::runtime_error("Corrupt key store expanded section: coefficient not reduced mod q");
+    }
+    ColorPublicKey key;
+    std::vector<ColorValue> colors;
+    unpack_record(records_ + index * record_bytes_, params_, colors, key);
+    auto public_key_colors = std::make_shared<PolyVec>(k, n);
+    std::copy(colors.begin(), colors.end(), public_key_colors->data());
+
+    ExpandedPublicKey expanded;
+    expanded.seed = key.seed;
+    expanded.public_data = std::move(key.public_data);
+    expanded.params = params_;
+    expanded.matrix_A = std::move(matrix);
+    expanded.public_key_colors = std::move(public_key_colors);
+    expanded.coefficients_reduced = true;
+    return expanded;
+}
+
+} // namespace clwe
@@ -0,0 +1,72 @@
+#ifndef KEY_STORE_FORMAT_HPP
+#define KEY_STORE_FORMAT_HPP
+
+#include "clwe/color_kem.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace clwe {
+
+// Layout of the "CLKS" files of KeyStore and KeyArchiveWriter/Reader, documented on
+// KeyStore. Definitions are in key_store.cpp.
+namespace key_store_format {
+
+constexpr uint32_t STORE_VERSION = 1;
+constexpr size_t HEADER_BYTES = 64;
+constexpr size_t INDEX_ENTRY_BYTES = 40;
+constexpr size_t SEED_BYTES = 32;
+
+void put_le64(uint8_t* out, uint64_t value);
+uint64_t get_le64(const uint8_t* in);
+
+bool same_parameters(const CLWEParameters& a, const CLWEParameters& b);
+
+// params.validate() plus the 12-bit modulus limit; throws std::invalid_argument
+void check_store_parameters(const CLWEParameters& params);
+
+size_t record_bytes(const CLWEParameters& params);
+
+void encode_header(uint8_t* header, const CLWEParameters& params, uint64_t count);
+
+struct Header {
+    CLWEParameters params;
+    uint64_t count = 0;
+    uint64_t index_offset = 0;
+    uint64_t expanded_bytes = 0;  // Bytes after the seed index: the expanded section, if any
+};
+
+// Throws std::runtime_error if the header is malformed or does not describe a file of
+// file_size bytes, with or without an expanded section
+Header parse_header(const uint8_t* header, uint64_t file_size, const std::string& path);
+
+// The optional expanded section follows the seed index: a 16-byte header (magic "CLKX",
+// a zero u32, the u64 entry count), then one entry per hot record in ascending record
+// order, its u64 record number followed by A_hat^T packed to 12 bits
+constexpr size_t EXPANDED_HEADER_BYTES = 16;
+
+size_t expanded_entry_bytes(const CLWEParameters& params);
+
+void encode_expanded_header(uint8_t* header, uint64_t count);
+
+// Entry count of the section_bytes-byte section at section. Throws std::runtime_error if
+// its header is malformed or its size does not match the count; entries are not read.
+uint64_t parse_expanded_header(const uint8_t* section, uint64_t section_bytes, const CLWEParameters& params,
+                               const std::string& path);
+
+// Seed and PACKED12 coefficients of key number `number` into record_bytes(params) bytes
+// at out. Throws std::invalid_argument as KeyStore::write() documents.
+void pack_record(const ColorPublicKey& key, const CLWEParameters& params, size_t number,
+                 std::vector<ColorValue>& colors, uint8_t* out);
+
+// Inverse of pack_record, re-encoding t_hat to params.encoding. Throws
+// std::runtime_error on a coefficient not reduced mod q.
+void unpack_record(const uint8_t* record, const CLWEParameters& params, std::vector<ColorValue>& colors,
+                   ColorPublicKey& key);
+
+} // namespace key_store_format
+
+} // namespace clwe
+
+#endif // KEY_STORE_FORMAT_HPP
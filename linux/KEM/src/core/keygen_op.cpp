@@ -0,0 +1,241 @@
+#include "clwe/keygen_op.hpp"
+#include "kem_arena.hpp"
+#include "poly.hpp"
+#include "ring_operations.hpp"
+#include "trace.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace clwe {
+
+namespace {
+
+// The counter step() budgets in: cheap to read, monotonic on one core
+uint64_t read_cycle_counter() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    return __rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t value;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(value));
+    return value;
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+} // namespace
+
+struct KeygenOp::State {
+    std::unique_ptr<ColorKEM> owned_kem;
+    const ColorKEM* kem = nullptr;
+    std::array<uint8_t, 32> matrix_seed{};
+    std::array<uint8_t, 32> secret_seed{};
+    std::array<uint8_t, 32> error_seed{};
+
+    PolyVec secret;      // s_hat
+    PolyVec error;       // e_hat
+    PolyVec public_key;  // t_hat
+    PolyVec line;        // One row of A
+    KemArena noise_scratch;
+    std::pair<ColorPublicKey, ColorPrivateKey> keys;
+    bool taken = false;
+
+    // Units, in order: 2k noise polynomials, then per row of A its cell groups (none with a
+    // shared matrix) and the row product, then the two keys
+    uint32_t row_groups = 0;
+    size_t sampling_units = 0;
+    size_t matrix_units = 0;
+    size_t total_units = 0;
+    size_t next = 0;
+    uint64_t max_unit_cycles = 0;
+
+    void run_unit();
+
+    void wipe() {
+        secure_zero(matrix_seed.data(), matrix_seed.size());
+        secure_zero(secret_seed.data(), secret_seed.size());
+        secure_zero(error_seed.data(), error_seed.size());
+        secure_zero(secret.data(), secret.coeff_count() * sizeof(ColorValue));
+        secure_zero(error.data(), error.coeff_count() * sizeof(ColorValue));
+        noise_scratch.reset();
+        if (!taken) {
+            secure_zero(keys.second.secret_data.data(), keys.second.secret_data.size());
+        }
+    }
+};
+
+void KeygenOp::State::run_unit() {
+    const ColorKEM& instance = *kem;
+    const CLWEParameters& params = instance.params_;
+    const uint32_t k = params.module_rank;
+    const uint32_t n = params.degree;
+    size_t unit = next;
+
+    if (unit < sampling_units) {
+        const bool is_secret = unit < k;
+        const uint32_t index = static_cast<uint32_t>(is_secret ? unit : unit - k);
+        instance.sample_keygen_noise(is_secret ? secret_seed : error_seed, static_cast<uint8_t>(index), is_secret,
+                                     is_secret ? secret[index] : error[index], noise_scratch);
+    } else if ((unit -= sampling_units) < matrix_units) {
+        const uint32_t row = static_cast<uint32_t>(unit / (row_groups + 1));
+        const uint32_t group = static_cast<uint32_t>(unit % (row_groups + 1));
+        if (group < row_groups) {
+            // The cells matrix_vector_mul_streamed() expands for this row, four at a time
+            CLWE_TRACE_SPAN("generate_matrix_A");
+            std::array<uint32_t, 4> cells;
+            std::array<ColorValue*, 4> polys;
+            const uint32_t first = group * 4;
+            const uint32_t count = std::min<uint32_t>(4, k - first);
+            for (uint32_t lane = 0; lane < count; ++lane) {
+                cells[lane] = row * k + first + lane;
+                polys[lane] = line[first + lane];
+            }
+            instance.expand_matrix_cells(matrix_seed, cells.data(), polys.data(), count);
+        } else {
+            CLWE_TRACE_SPAN("matrix_vector_mul");
+            const ColorValue* a_row =
+                instance.shared_matrix_ ? instance.shared_matrix_->matrix_A->at(row, 0) : line.data();
+            instance.color_ntt_engine_->row_dot_colors(a_row, n, secret.data(), k, public_key[row]);
+            poly_add(public_key[row], error[row], public_key[row], n, params.modulus);
+        }
+    } else if (unit - matrix_units == 0) {
+        CLWE_TRACE_SPAN("pack_keys");
+        keys.first.seed = instance.shared_matrix_ ? instance.shared_matrix_->seed : matrix_seed;
+        keys.first.params = params;
+        instance.encode_public_key_data(public_key, keys.first.public_data);
+    } else {
+        CLWE_TRACE_SPAN("pack_keys");
+        keys.second.params = params;
+        ColorKEM::encode_polyvec(secret, params.encoding, keys.second.secret_data);
+    }
+    ++next;
+}
+
+KeygenOp::KeygenOp(const ColorKEM& kem) {
+    std::array<uint8_t, 32> d;
+    kem.random_bytes(d.data(), d.size());
+    *this = KeygenOp(kem, d);
+    secure_zero(d.data(), d.size());
+}
+
+KeygenOp::KeygenOp(const CLWEParameters& params) {
+    auto owned = std::make_unique<ColorKEM>(params);
+    const ColorKEM& kem = *owned;
+    *this = KeygenOp(kem);
+    state_->owned_kem = std::move(owned);
+}
+
+KeygenOp::KeygenOp(const ColorKEM& kem, const std::array<uint8_t, 32>& d) {
+    const CLWEParameters& params = kem.params_;
+    const uint32_t k = params.module_rank;
+    const uint32_t n = params.degree;
+    auto state = std::make_unique<State>();
+    state->kem = &kem;
+    kem.expand_keygen_seed(d, state->matrix_seed, state->secret_seed, state->error_seed);
+
+    state->secret = PolyVec(k, n);
+    state->error = PolyVec(k, n);
+    state->public_key = PolyVec(k, n);
+    state->noise_scratch.reserve(ColorKEM::keygen_noise_scratch_bytes(n));
+    state->row_groups = kem.shared_matrix_ ? 0 : (k + 3) / 4;
+    if (!kem.shared_matrix_) {
+        state->line = PolyVec(k, n);
+    }
+    // Exact capacity, so packing reuses it instead of allocating
+    state->keys.first.public_data.reserve(kem.public_key_bytes_);
+    state->keys.second.secret_data.reserve(kem.polyvec_bytes_);
+
+    state->sampling_units = 2 * static_cast<size_t>(k);
+    state->matrix_units = static_cast<size_t>(k) * (state->row_groups + 1);
+    state->total_units = state->sampling_units + state->matrix_units + 2;
+    state_ = std::move(state);
+}
+
+KeygenOp::~KeygenOp() {
+    if (state_) {
+        state_->wipe();
+    }
+}
+
+KeygenOp::KeygenOp(KeygenOp&&) noexcept = default;
+
+KeygenOp& KeygenOp::operator=(KeygenOp&& other) noexcept {
+    if (this != &other) {
+        if (state_) {
+            state_->wipe();
+        }
+        state_ = std::move(other.state_);
+    }
+    return *this;
+}
+
+bool KeygenOp::step(uint64_t budget_cycles) {
+    if (!state_) {
+        throw std::logic_error("KeygenOp has been moved from");
+    }
+    State& state = *state_;
+    const uint64_t start = read_cycle_counter();
+    uint64_t spent = 0;
+    while (state.next < state.total_units) {
+        const uint64_t before = read_cycle_counter();
+        state.run_unit();
+        const uint64_t after = read_cycle_counter();
+        state.max_unit_cycles = std::max(state.max_unit_cycles, after - before);
+        spent = after - start;
+        if (spent + state.max_unit_cycles > budget_cycles) {
+            break;
+        }
+    }
+    return done();
+}
+
+void KeygenOp::run() {
+    while (!step(UINT64_MAX / 2)) {
+    }
+}
+
+KeygenPhase KeygenOp::phase() const {
+    if (!state_) {
+        return KeygenPhase::Done;
+    }
+    const State& state = *state_;
+    if (state.next < state.sampling_units) {
+        return KeygenPhase::Sampling;
+    }
+    if (state.next < state.sampling_units + state.matrix_units) {
+        return KeygenPhase::Matrix;
+    }
+    return state.next < state.total_units ? KeygenPhase::Packing : KeygenPhase::Done;
+}
+
+size_t KeygenOp::units_done() const {
+    return state_ ? state_->next : 0;
+}
+
+size_t KeygenOp::units_total() const {
+    return state_ ? state_->total_units : 0;
+}
+
+std::pair<ColorPublicKey, ColorPrivateKey> KeygenOp::take_keys() {
+    if (!state_ || state_->next < state_->total_units) {
+        throw std::logic_error("KeygenOp has not finished");
+    }
+    if (state_->taken) {
+        throw std::logic_error("KeygenOp keys were already taken");
+    }
+    state_->taken = true;
+    return std::move(state_->keys);
+}
+
+} // namespace clwe
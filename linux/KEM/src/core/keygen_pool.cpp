@@ -0,0 +1,302 @@
+#include "clwe/keygen_pool.hpp"
+#include "clwe/priority_executor.hpp"
+#include "mpmc_ring.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace clwe {
+
+namespace {
+
+void wipe_private_key(ColorPrivateKey& key) {
+    if (!key.secret_data.empty()) {
+        secure_zero(key.secret_data.data(), key.secret_data.size());
+    }
+}
+
+} // namespace
+
+struct KeygenPool::Impl {
+    // Deque of scheduled tasks (key counts); the owner takes from the back, thieves from the front
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    const ColorKEM kem;
+    const KeygenPoolConfig config;
+    MPMCRing<KeyPair> ring;
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> next_queue{0};
+
+    // Keys scheduled but not yet generated, so refills do not over-schedule
+    std::atomic<size_t> pending{0};
+    std::atomic<size_t> generated{0};
+    std::atomic<bool> refilling{false};
+
+    // Idle workers sleep until a task is queued or the pool stops
+    std::mutex idle_mutex;
+    std::condition_variable work_cv;
+    size_t queued_tasks = 0;
+    bool stopping = false;
+
+    // Consumers waiting in wait_ready()
+    std::mutex ready_mutex;
+    std::condition_variable ready_cv;
+
+    Impl(const CLWEParameters& params, const KeygenPoolConfig& pool_config, size_t capacity)
+        : kem(params), config(pool_config), ring(capacity) {}
+
+    // Keys left in an executor task; it is reposted after each one so foreground work
+    // never waits behind more than one key generation
+    void post_task(size_t count) {
+        {
+            std::lock_guard<std::mutex> lock(idle_mutex);
+            ++queued_tasks;
+        }
+        try {
+            config.executor->post(WorkClass::BACKGROUND, [this, count] {
+                bool stopped;
+                {
+                    std::lock_guard<std::mutex> lock(idle_mutex);
+                    stopped = stopping;
+                }
+                if (stopped) {
+                    pending.fetch_sub(count, std::memory_order_acq_rel);
+                } else {
+                    KemWorkspace& workspace = executor_workspace();
+                    store(kem.keygen(workspace));
+                    if (count > 1) {
+                        post_task(count - 1);
+                    }
+                }
+                std::lock_guard<std::mutex> lock(idle_mutex);
+                --queued_tasks;
+                work_cv.notify_all();
+            });
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(idle_mutex);
+            --queued_tasks;
+            throw;
+        }
+    }
+
+    // Executor threads serve other users too, so the scratch is per thread, not per worker
+    static KemWorkspace& executor_workspace() {
+        thread_local KemWorkspace workspace;
+        return workspace;
+    }
+
+    void store(KeyPair keys) {
+        if (!ring.try_push(std::move(keys))) {
+            // Consumers drained slower than scheduled; never keep an unused secret
+            wipe_private_key(keys.second);
+        }
+        pending.fetch_sub(1, std::memory_order_acq_rel);
+        generated.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(ready_mutex);
+        }
+        ready_cv.notify_all();
+    }
+
+    void submit(size_t count) {
+        if (config.executor != nullptr) {
+            post_task(count);
+            return;
+        }
+        size_t index = next_queue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+        // Counted before it is visible: a worker may take it and decrement the moment it is pushed
+        {
+            std::lock_guard<std::mutex> lock(idle_mutex);
+            ++queued_tasks;
+        }
+        try {
+            std::lock_guard<std::mutex> lock(queues[index]->mutex);
+            queues[index]->tasks.push_back(count);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(idle_mutex);
+            --queued_tasks;
+            throw;
+        }
+        work_cv.notify_one();
+    }
+
+    bool take_task(size_t self, size_t& count) {
+        for (size_t offset = 0; offset < queues.size(); ++offset) {
+            WorkerQueue& queue = *queues[(self + offset) % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) {
+                continue;
+            }
+            if (offset == 0) {
+                count = queue.tasks.back();
+                queue.tasks.pop_back();
+            } else {
+                count = queue.tasks.front();
+                queue.tasks.pop_front();
+            }
+            std::lock_guard<std::mutex> idle_lock(idle_mutex);
+            --queued_tasks;
+            return true;
+        }
+        return false;
+    }
+
+    void maybe_refill() {
+        if (ring.size() + pending.load(std::memory_order_acquire) > config.low_watermark) {
+            return;
+        }
+        if (refilling.exchange(true, std::memory_order_acq_rel)) {
+            return;  // Another thread is already scheduling
+        }
+
+        size_t stocked = ring.size() + pending.load(std::memory_order_acquire);
+        if (stocked < config.high_watermark) {
+            size_t deficit = config.high_watermark - stocked;
+            pending.fetch_add(deficit, std::memory_order_acq_rel);
+            while (deficit > 0) {
+                size_t count = std::min(deficit, config.batch_size);
+                submit(count);
+                deficit -= count;
+            }
+        }
+        refilling.store(false, std::memory_order_release);
+    }
+
+    void run_worker(size_t self) {
+        if (config.numa_node != ANY_NUMA_NODE) {
+            bind_thread_to_numa_node(config.numa_node);
+        }
+        KemWorkspace workspace;
+        for (;;) {
+            size_t count = 0;
+            if (!take_task(self, count)) {
+                std::unique_lock<std::mutex> lock(idle_mutex);
+                work_cv.wait(lock, [this] { return stopping || queued_tasks > 0; });
+                if (stopping) {
+                    return;
+                }
+                continue;
+            }
+
+            for (size_t i = 0; i < count; ++i) {
+                {
+                    std::lock_guard<std::mutex> lock(idle_mutex);
+                    if (stopping) {
+                        return;
+                    }
+                }
+                store(kem.keygen(workspace));
+            }
+        }
+    }
+};
+
+KeygenPool::KeygenPool(const CLWEParameters& params, const KeygenPoolConfig& config) {
+    if (config.capacity == 0 || config.batch_size == 0) {
+        throw std::invalid_argument("KeygenPool capacity and batch size must be positive");
+    }
+    size_t capacity = round_up_power_of_two(config.capacity);
+    if (config.high_watermark == 0 || config.high_watermark > capacity ||
+        config.low_watermark >= config.high_watermark) {
+        throw std::invalid_argument("Invalid KeygenPool watermarks: low " + std::to_string(config.low_watermark) +
+                                    ", high " + std::to_string(config.high_watermark) +
+                                    ", capacity " + std::to_string(capacity));
+    }
+
+    size_t threads = config.executor != nullptr ? 0 : config.worker_threads;
+    if (threads == 0 && config.executor == nullptr) {
+        threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    if (config.numa_node == ANY_NUMA_NODE) {
+        impl_.reset(new Impl(params, config, capacity));
+    } else {
+        if (config.numa_node >= numa_node_count()) {
+            throw std::invalid_argument("KeygenPool NUMA node " + std::to_string(config.numa_node) +
+                                        " out of range, system has " + std::to_string(numa_node_count()));
+        }
+        // Ring slots and engine tables are first touched on the node
+        run_on_numa_node(config.numa_node, [&] { impl_.reset(new Impl(params, config, capacity)); });
+    }
+    for (size_t i = 0; i < threads; ++i) {
+        impl_->queues.emplace_back(new Impl::WorkerQueue());
+    }
+    for (size_t i = 0; i < threads; ++i) {
+        impl_->workers.emplace_back(&Impl::run_worker, impl_.get(), i);
+    }
+    impl_->maybe_refill();
+}
+
+KeygenPool::~KeygenPool() {
+    {
+        std::lock_guard<std::mutex> lock(impl_->idle_mutex);
+        impl_->stopping = true;
+    }
+    impl_->work_cv.notify_all();
+    for (std::thread& worker : impl_->workers) {
+        worker.join();
+    }
+    if (impl_->config.executor != nullptr) {
+        // Queued executor jobs see stopping and return at once
+        std::unique_lock<std::mutex> lock(impl_->idle_mutex);
+        impl_->work_cv.wait(lock, [this] { return impl_->queued_tasks == 0; });
+    }
+
+    KeyPair keys;
+    while (impl_->ring.try_pop(keys)) {
+        wipe_private_key(keys.second);
+    }
+}
+
+bool KeygenPool::try_pop(KeyPair& keys) {
+    if (!impl_->ring.try_pop(keys)) {
+        impl_->maybe_refill();
+        return false;
+    }
+    impl_->maybe_refill();
+    return true;
+}
+
+KeygenPool::KeyPair KeygenPool::pop() {
+    KeyPair keys;
+    if (try_pop(keys)) {
+        return keys;
+    }
+    return impl_->kem.keygen();
+}
+
+bool KeygenPool::wait_ready(size_t count, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(impl_->ready_mutex);
+    return impl_->ready_cv.wait_for(lock, timeout, [this, count] { return impl_->ring.size() >= count; });
+}
+
+size_t KeygenPool::ready() const {
+    return impl_->ring.size();
+}
+
+size_t KeygenPool::capacity() const {
+    return impl_->ring.capacity();
+}
+
+size_t KeygenPool::generated() const {
+    return impl_->generated.load(std::memory_order_relaxed);
+}
+
+const CLWEParameters& KeygenPool::params() const {
+    return impl_->kem.params();
+}
+
+} // namespace clwe
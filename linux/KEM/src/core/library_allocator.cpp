@@ -0,0 +1,99 @@
+#include "library_allocator.hpp"
+#include "slow_operations.hpp"
+#include "utils.hpp"
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+
+namespace clwe {
+
+namespace {
+
+void* default_allocate(size_t size, size_t alignment, void*) {
+    return ::operator new(size, std::align_val_t(alignment), std::nothrow);
+}
+
+void default_deallocate(void* ptr, size_t, size_t alignment, void*) {
+    ::operator delete(ptr, std::align_val_t(alignment));
+}
+
+const AllocatorHooks DEFAULT_HOOKS{default_allocate, default_deallocate, nullptr, nullptr};
+
+std::atomic<const AllocatorHooks*> installed_hooks{&DEFAULT_HOOKS};
+
+// Every distinct hook set ever installed, never freed: blocks allocated under a set
+// keep pointing at it. Installing an equal set again reuses its node
+struct HookNode {
+    AllocatorHooks hooks;
+    HookNode* next;
+};
+
+std::mutex hook_list_mutex;
+HookNode* hook_list = nullptr;  // Guarded by hook_list_mutex
+
+bool same_hooks(const AllocatorHooks& a, const AllocatorHooks& b) {
+    return a.allocate == b.allocate && a.deallocate == b.deallocate &&
+           a.secure_deallocate == b.secure_deallocate && a.context == b.context;
+}
+
+const AllocatorHooks* intern_hooks(const AllocatorHooks& hooks) {
+    std::lock_guard<std::mutex> lock(hook_list_mutex);
+    for (HookNode* node = hook_list; node != nullptr; node = node->next) {
+        if (same_hooks(node->hooks, hooks)) {
+            return &node->hooks;
+        }
+    }
+    hook_list = new HookNode{hooks, hook_list};
+    return &hook_list->hooks;
+}
+
+} // namespace
+
+const AllocatorHooks* current_allocator() {
+    return installed_hooks.load(std::memory_order_acquire);
+}
+
+void* allocate_with(const AllocatorHooks* hooks, size_t size, size_t alignment) {
+    void* ptr = hooks->allocate(size, alignment, hooks->context);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    count_slow_operation_library_allocation();
+    return ptr;
+}
+
+void deallocate_with(const AllocatorHooks* hooks, void* ptr, size_t size, size_t alignment) {
+    if (ptr != nullptr) {
+        hooks->deallocate(ptr, size, alignment, hooks->context);
+    }
+}
+
+void secure_deallocate_with(const AllocatorHooks* hooks, void* ptr, size_t size, size_t alignment) {
+    if (ptr == nullptr) {
+        return;
+    }
+    if (hooks->secure_deallocate != nullptr) {
+        hooks->secure_deallocate(ptr, size, alignment, hooks->context);
+        return;
+    }
+    secure_zero(ptr, size);
+    hooks->deallocate(ptr, size, alignment, hooks->context);
+}
+
+void set_allocator(const AllocatorHooks& hooks) {
+    if ((hooks.allocate == nullptr) != (hooks.deallocate == nullptr) ||
+        (hooks.secure_deallocate != nullptr && hooks.allocate == nullptr)) {
+        throw std::invalid_argument("Allocator hooks need both allocate and deallocate");
+    }
+    if (hooks.allocate == nullptr) {
+        installed_hooks.store(&DEFAULT_HOOKS, std::memory_order_release);
+        return;
+    }
+    installed_hooks.store(intern_hooks(hooks), std::memory_order_release);
+}
+
+AllocatorHooks allocator_hooks() {
+    return *current_allocator();
+}
+
+} // namespace clwe
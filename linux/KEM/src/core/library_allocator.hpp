@@ -0,0 +1,80 @@
+#ifndef LIBRARY_ALLOCATOR_HPP
+#define LIBRARY_ALLOCATOR_HPP
+
+#include "clwe/allocator.hpp"
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace clwe {
+
+// Hooks installed by the last set_allocator(). Every installed set is kept for the
+// life of the process, so a block can hold on to the pointer and be freed through it
+// after the hooks are replaced.
+const AllocatorHooks* current_allocator();
+
+// Throws std::bad_alloc when the hook returns nullptr
+void* allocate_with(const AllocatorHooks* hooks, size_t size, size_t alignment);
+void deallocate_with(const AllocatorHooks* hooks, void* ptr, size_t size, size_t alignment);
+// secure_deallocate hook, or secure_zero then deallocate
+void secure_deallocate_with(const AllocatorHooks* hooks, void* ptr, size_t size, size_t alignment);
+
+// Standard allocator over the hooks current when the container was created. Moves and
+// swaps carry the hooks along; copies take the hooks current at copy time.
+template <typename T, size_t Alignment = alignof(std::max_align_t)>
+class LibraryAllocator {
+    static_assert((Alignment & (Alignment - 1)) == 0 && Alignment >= alignof(T), "Bad alignment");
+
+    const AllocatorHooks* hooks_;
+
+    template <typename, size_t>
+    friend class LibraryAllocator;
+
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    template <typename U>
+    struct rebind {
+        using other = LibraryAllocator<U, Alignment>;
+    };
+
+    LibraryAllocator() noexcept : hooks_(current_allocator()) {}
+    template <typename U>
+    LibraryAllocator(const LibraryAllocator<U, Alignment>& other) noexcept : hooks_(other.hooks_) {}
+
+    T* allocate(size_t count) {
+        if (count > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(allocate_with(hooks_, count * sizeof(T), alignment()));
+    }
+
+    void deallocate(T* ptr, size_t count) noexcept {
+        deallocate_with(hooks_, ptr, count * sizeof(T), alignment());
+    }
+
+    LibraryAllocator select_on_container_copy_construction() const { return LibraryAllocator(); }
+
+    const AllocatorHooks* hooks() const { return hooks_; }
+
+    template <typename U>
+    bool operator==(const LibraryAllocator<U, Alignment>& other) const { return hooks_ == other.hooks_; }
+    template <typename U>
+    bool operator!=(const LibraryAllocator<U, Alignment>& other) const { return hooks_ != other.hooks_; }
+
+private:
+    // The hooks promise no less than pointer alignment
+    static constexpr size_t alignment() { return Alignment < sizeof(void*) ? sizeof(void*) : Alignment; }
+};
+
+template <typename T>
+using LibraryVector = std::vector<T, LibraryAllocator<T>>;
+
+} // namespace clwe
+
+#endif // LIBRARY_ALLOCATOR_HPP
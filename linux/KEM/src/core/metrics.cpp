@@ -0,0 +1,316 @@
+#include "metrics.hpp"
+#include "performance_metrics.hpp"
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace clwe {
+
+namespace metrics_detail {
+std::atomic<bool> g_enabled{false};
+} // namespace metrics_detail
+
+namespace {
+
+// One thread's counts. Only its owner adds to it; snapshots read it concurrently.
+struct MetricsShard {
+    std::atomic<uint64_t> buckets[METRIC_OPERATIONS][METRIC_LEVELS][METRIC_LATENCY_BUCKETS];
+    std::atomic<uint64_t> sum_ns[METRIC_OPERATIONS][METRIC_LEVELS];
+    std::atomic<uint64_t> counters[METRIC_COUNTERS][METRIC_LEVELS];
+    std::atomic<uint64_t> squeezed_bytes[METRIC_XOFS];
+
+    MetricsShard() { reset(); }
+
+    void reset() {
+        for (auto& operation : buckets) {
+            for (auto& level : operation) {
+                for (auto& bucket : level) {
+                    bucket.store(0, std::memory_order_relaxed);
+                }
+            }
+        }
+        for (auto& operation : sum_ns) {
+            for (auto& level : operation) {
+                level.store(0, std::memory_order_relaxed);
+            }
+        }
+        for (auto& counter : counters) {
+            for (auto& level : counter) {
+                level.store(0, std::memory_order_relaxed);
+            }
+        }
+        for (auto& xof : squeezed_bytes) {
+            xof.store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+// Every shard ever handed out. A thread that exits returns its shard, counts intact, for
+// the next new thread, so totals survive thread churn and memory stays bounded by the
+// peak thread count.
+struct ShardRegistry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<MetricsShard>> shards;
+    std::vector<MetricsShard*> free_shards;
+};
+
+// Never destroyed, so threads still exiting during static destruction can return shards
+ShardRegistry& shard_registry() {
+    static ShardRegistry* registry = new ShardRegistry();
+    return *registry;
+}
+
+struct ShardLease {
+    MetricsShard* shard = nullptr;
+
+    ~ShardLease() {
+        if (shard != nullptr) {
+            ShardRegistry& registry = shard_registry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            registry.free_shards.push_back(shard);
+        }
+    }
+};
+
+MetricsShard& thread_shard() {
+    thread_local ShardLease lease;
+    if (lease.shard == nullptr) {
+        ShardRegistry& registry = shard_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        if (!registry.free_shards.empty()) {
+            lease.shard = registry.free_shards.back();
+            registry.free_shards.pop_back();
+        } else {
+            registry.shards.push_back(std::make_unique<MetricsShard>());
+            lease.shard = registry.shards.back().get();
+        }
+    }
+    return *lease.shard;
+}
+
+uint64_t steady_now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+const char* const OPERATION_NAMES[METRIC_OPERATIONS] = {"keygen", "encapsulate", "decapsulate"};
+const char* const LEVEL_NAMES[METRIC_LEVELS] = {"512", "768", "1024", "other"};
+const char* const XOF_NAMES[METRIC_XOFS] = {"shake128", "shake256"};
+
+// value / 10^decimals with exactly that many decimals, so the output never depends on
+// the stream's formatting state
+void write_fixed(std::ostream& out, uint64_t value, unsigned decimals) {
+    uint64_t scale = 1;
+    for (unsigned i = 0; i < decimals; ++i) {
+        scale *= 10;
+    }
+    out << value / scale << '.';
+    uint64_t fraction = value % scale;
+    for (uint64_t digit = scale / 10; digit > 0; digit /= 10) {
+        out << static_cast<char>('0' + fraction / digit % 10);
+    }
+}
+
+void write_family(std::ostream& out, const char* name, const char* type, const char* help, bool openmetrics) {
+    // OpenMetrics names a counter family without the _total its samples carry
+    std::string family = name;
+    if (openmetrics && std::string(type) == "counter") {
+        family.resize(family.size() - 6);
+    }
+    out << "# HELP " << family << ' ' << help << '\n';
+    out << "# TYPE " << family << ' ' << type << '\n';
+}
+
+} // namespace
+
+size_t metric_level_slot(uint32_t security_level) {
+    switch (security_level) {
+    case 512:
+        return 0;
+    case 768:
+        return 1;
+    case 1024:
+        return 2;
+    default:
+        return 3;
+    }
+}
+
+size_t metric_latency_bucket(uint64_t duration_ns) {
+    // Smallest i with duration <= 2^i microseconds
+    uint64_t microseconds = duration_ns / 1000 + (duration_ns % 1000 != 0);
+    size_t bucket = 0;
+    while (bucket + 1 < METRIC_LATENCY_BUCKETS && (uint64_t(1) << bucket) < microseconds) {
+        ++bucket;
+    }
+    return bucket;
+}
+
+void set_metrics_enabled(bool enabled) {
+    metrics_detail::g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+namespace metrics_detail {
+
+void record_operation(MetricOperation operation, uint32_t security_level, uint64_t duration_ns) {
+    MetricsShard& shard = thread_shard();
+    const size_t op = static_cast<size_t>(operation);
+    const size_t level = metric_level_slot(security_level);
+    shard.buckets[op][level][metric_latency_bucket(duration_ns)].fetch_add(1, std::memory_order_relaxed);
+    shard.sum_ns[op][level].fetch_add(duration_ns, std::memory_order_relaxed);
+}
+
+void add_counter(MetricCounter counter, uint32_t security_level, uint64_t value) {
+    thread_shard().counters[static_cast<size_t>(counter)][metric_level_slot(security_level)]
+        .fetch_add(value, std::memory_order_relaxed);
+}
+
+void add_squeezed_bytes(MetricXof xof, uint64_t bytes) {
+    thread_shard().squeezed_bytes[static_cast<size_t>(xof)].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+} // namespace metrics_detail
+
+void MetricsTimer::start() {
+    uncaught_exceptions_ = std::uncaught_exceptions();
+    start_ns_ = steady_now_ns();
+}
+
+void MetricsTimer::finish() {
+    if (std::uncaught_exceptions() == uncaught_exceptions_) {
+        metrics_detail::record_operation(operation_, security_level_, steady_now_ns() - start_ns_);
+    }
+}
+
+MetricsSnapshot metrics_snapshot() {
+    MetricsSnapshot snapshot;
+    {
+        ShardRegistry& registry = shard_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (const auto& shard : registry.shards) {
+            for (size_t op = 0; op < METRIC_OPERATIONS; ++op) {
+                for (size_t level = 0; level < METRIC_LEVELS; ++level) {
+                    MetricsSnapshot::Operation& totals = snapshot.operations[op][level];
+                    for (size_t b = 0; b < METRIC_LATENCY_BUCKETS; ++b) {
+                        uint64_t count = shard->buckets[op][level][b].load(std::memory_order_relaxed);
+                        totals.buckets[b] += count;
+                        totals.count += count;
+                    }
+                    totals.sum_ns += shard->sum_ns[op][level].load(std::memory_order_relaxed);
+                }
+            }
+            for (size_t c = 0; c < METRIC_COUNTERS; ++c) {
+                for (size_t level = 0; level < METRIC_LEVELS; ++level) {
+                    snapshot.counters[c][level] += shard->counters[c][level].load(std::memory_order_relaxed);
+                }
+            }
+            for (size_t x = 0; x < METRIC_XOFS; ++x) {
+                snapshot.squeezed_bytes[x] += shard->squeezed_bytes[x].load(std::memory_order_relaxed);
+            }
+        }
+    }
+    snapshot.process_memory_bytes = PerformanceMetrics::get_memory_usage().current_memory;
+    return snapshot;
+}
+
+void reset_metrics() {
+    ShardRegistry& registry = shard_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (const auto& shard : registry.shards) {
+        shard->reset();
+    }
+}
+
+void write_prometheus_metrics(std::ostream& out, const MetricsSnapshot& snapshot, bool openmetrics) {
+    bool level_active[METRIC_LEVELS] = {};
+    for (size_t level = 0; level < METRIC_LEVELS; ++level) {
+        for (size_t op = 0; op < METRIC_OPERATIONS; ++op) {
+            level_active[level] |= snapshot.operations[op][level].count != 0;
+        }
+        for (size_t c = 0; c < METRIC_COUNTERS; ++c) {
+            level_active[level] |= snapshot.counters[c][level] != 0;
+        }
+    }
+
+    write_family(out, "clwe_operations_total", "counter",
+                 "KEM operations completed, by operation and security level.", openmetrics);
+    for (size_t op = 0; op < METRIC_OPERATIONS; ++op) {
+        for (size_t level = 0; level < METRIC_LEVELS; ++level) {
+            if (snapshot.operations[op][level].count != 0) {
+                out << "clwe_operations_total{operation=\"" << OPERATION_NAMES[op] << "\",level=\""
+                    << LEVEL_NAMES[level] << "\"} " << snapshot.operations[op][level].count << '\n';
+            }
+        }
+    }
+
+    write_family(out, "clwe_operation_duration_seconds", "histogram",
+                 "Latency of KEM operations, by operation and security level.", openmetrics);
+    for (size_t op = 0; op < METRIC_OPERATIONS; ++op) {
+        for (size_t level = 0; level < METRIC_LEVELS; ++level) {
+            const MetricsSnapshot::Operation& operation = snapshot.operations[op][level];
+            if (operation.count == 0) {
+                continue;
+            }
+            uint64_t cumulative = 0;
+            for (size_t b = 0; b < METRIC_LATENCY_BUCKETS; ++b) {
+                cumulative += operation.buckets[b];
+                out << "clwe_operation_duration_seconds_bucket{operation=\"" << OPERATION_NAMES[op]
+                    << "\",level=\"" << LEVEL_NAMES[level] << "\",le=\"";
+                if (b + 1 < METRIC_LATENCY_BUCKETS) {
+                    write_fixed(out, uint64_t(1) << b, 6);
+                } else {
+                    out << "+Inf";
+                }
+                out << "\"} " << cumulative << '\n';
+            }
+            out << "clwe_operation_duration_seconds_sum{operation=\"" << OPERATION_NAMES[op] << "\",level=\""
+                << LEVEL_NAMES[level] << "\"} ";
+            write_fixed(out, operation.sum_ns, 9);
+            out << '\n';
+            out << "clwe_operation_duration_seconds_count{operation=\"" << OPERATION_NAMES[op] << "\",level=\""
+                << LEVEL_NAMES[level] << "\"} " << operation.count << '\n';
+        }
+    }
+
+    const char* const counter_names[METRIC_COUNTERS] = {
+        "clwe_implicit_rejections_total",
+        "clwe_expanded_key_cache_hits_total",
+        "clwe_expanded_key_cache_misses_total",
+    };
+    const char* const counter_help[METRIC_COUNTERS] = {
+        "Decapsulations that returned the implicit-rejection value.",
+        "Expanded public key cache lookups that found the key.",
+        "Expanded public key cache lookups that expanded the key.",
+    };
+    for (size_t c = 0; c < METRIC_COUNTERS; ++c) {
+        write_family(out, counter_names[c], "counter", counter_help[c], openmetrics);
+        for (size_t level = 0; level < METRIC_LEVELS; ++level) {
+            if (level_active[level]) {
+                out << counter_names[c] << "{level=\"" << LEVEL_NAMES[level] << "\"} "
+                    << snapshot.counters[c][level] << '\n';
+            }
+        }
+    }
+
+    write_family(out, "clwe_xof_squeezed_bytes_total", "counter",
+                 "Bytes squeezed from the SHAKE samplers.", openmetrics);
+    for (size_t x = 0; x < METRIC_XOFS; ++x) {
+        out << "clwe_xof_squeezed_bytes_total{xof=\"" << XOF_NAMES[x] << "\"} " << snapshot.squeezed_bytes[x] << '\n';
+    }
+
+    write_family(out, "clwe_process_memory_bytes", "gauge", "Process memory size.", openmetrics);
+    out << "clwe_process_memory_bytes " << snapshot.process_memory_bytes << '\n';
+
+    if (openmetrics) {
+        out << "# EOF\n";
+    }
+}
+
+void write_prometheus_metrics(std::ostream& out, bool openmetrics) {
+    write_prometheus_metrics(out, metrics_snapshot(), openmetrics);
+}
+
+} // namespace clwe
@@ -0,0 +1,146 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+namespace clwe {
+
+// Live telemetry of the KEM operations, scraped in the Prometheus text format. Updates
+// go to a per-thread shard, so recording never takes a lock; a snapshot sums the
+// shards. Collection is off until set_metrics_enabled(true), and while it is off every
+// recording point costs one relaxed atomic load.
+
+enum class MetricOperation : uint8_t {
+    KEYGEN,
+    ENCAPSULATE,
+    DECAPSULATE,
+};
+constexpr size_t METRIC_OPERATIONS = 3;
+
+// Per security level counters
+enum class MetricCounter : uint8_t {
+    IMPLICIT_REJECTIONS,        // Decapsulations that returned the rejection value
+    EXPANDED_KEY_CACHE_HITS,
+    EXPANDED_KEY_CACHE_MISSES,
+};
+constexpr size_t METRIC_COUNTERS = 3;
+
+enum class MetricXof : uint8_t {
+    SHAKE128,
+    SHAKE256,
+};
+constexpr size_t METRIC_XOFS = 2;
+
+// Series are labelled 512, 768, 1024 or "other" for custom security levels
+constexpr size_t METRIC_LEVELS = 4;
+size_t metric_level_slot(uint32_t security_level);
+
+// Latency buckets: bucket i counts durations up to 2^i microseconds, the last one the rest
+constexpr size_t METRIC_LATENCY_BUCKETS = 22;
+size_t metric_latency_bucket(uint64_t duration_ns);
+
+void set_metrics_enabled(bool enabled);
+
+namespace metrics_detail {
+extern std::atomic<bool> g_enabled;
+void record_operation(MetricOperation operation, uint32_t security_level, uint64_t duration_ns);
+void add_counter(MetricCounter counter, uint32_t security_level, uint64_t value);
+void add_squeezed_bytes(MetricXof xof, uint64_t bytes);
+} // namespace metrics_detail
+
+inline bool metrics_enabled() {
+    return metrics_detail::g_enabled.load(std::memory_order_relaxed);
+}
+
+inline void record_operation(MetricOperation operation, uint32_t security_level, uint64_t duration_ns) {
+    if (metrics_enabled()) {
+        metrics_detail::record_operation(operation, security_level, duration_ns);
+    }
+}
+
+// value may depend on secret data: it is added whatever it is, without a branch on it
+inline void add_metric_counter(MetricCounter counter, uint32_t security_level, uint64_t value) {
+    if (metrics_enabled()) {
+        metrics_detail::add_counter(counter, security_level, value);
+    }
+}
+
+inline void add_squeezed_bytes(MetricXof xof, uint64_t bytes) {
+    if (metrics_enabled()) {
+        metrics_detail::add_squeezed_bytes(xof, bytes);
+    }
+}
+
+// Records the duration of its scope as one operation, unless the scope is left by an
+// exception. Reads the clock only while metrics are enabled.
+class MetricsTimer {
+private:
+    MetricOperation operation_;
+    uint32_t security_level_;
+    int uncaught_exceptions_ = 0;
+    uint64_t start_ns_ = 0;
+    bool active_;
+
+    void start();
+    void finish();
+
+public:
+    MetricsTimer(MetricOperation operation, uint32_t security_level)
+        : operation_(operation), security_level_(security_level), active_(metrics_enabled()) {
+        if (active_) {
+            start();
+        }
+    }
+    ~MetricsTimer() {
+        if (active_) {
+            finish();
+        }
+    }
+
+    MetricsTimer(const MetricsTimer&) = delete;
+    MetricsTimer& operator=(const MetricsTimer&) = delete;
+};
+
+// Totals over every shard at one point in time. Bucket counts are per bucket, not cumulative.
+struct MetricsSnapshot {
+    struct Operation {
+        std::array<uint64_t, METRIC_LATENCY_BUCKETS> buckets{};
+        uint64_t count = 0;
+        uint64_t sum_ns = 0;
+    };
+
+    std::array<std::array<Operation, METRIC_LEVELS>, METRIC_OPERATIONS> operations{};
+    std::array<std::array<uint64_t, METRIC_LEVELS>, METRIC_COUNTERS> counters{};
+    std::array<uint64_t, METRIC_XOFS> squeezed_bytes{};
+    size_t process_memory_bytes = 0;  // PerformanceMetrics::get_memory_usage() at snapshot time
+
+    const Operation& operation(MetricOperation op, uint32_t security_level) const {
+        return operations[static_cast<size_t>(op)][metric_level_slot(security_level)];
+    }
+    uint64_t counter(MetricCounter c, uint32_t security_level) const {
+        return counters[static_cast<size_t>(c)][metric_level_slot(security_level)];
+    }
+};
+
+MetricsSnapshot metrics_snapshot();
+
+// Zero every shard; updates racing with the reset may land on either side of it
+void reset_metrics();
+
+// Content types for the scrape response
+constexpr const char* PROMETHEUS_CONTENT_TYPE = "text/plain; version=0.0.4; charset=utf-8";
+constexpr const char* OPENMETRICS_CONTENT_TYPE = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+
+// Prometheus text exposition of snapshot, or OpenMetrics (counter families without the
+// _total suffix and a closing "# EOF") when openmetrics is set. Levels with no samples
+// are left out.
+void write_prometheus_metrics(std::ostream& out, const MetricsSnapshot& snapshot, bool openmetrics = false);
+void write_prometheus_metrics(std::ostream& out, bool openmetrics = false);
+
+} // namespace clwe
+
+#endif // METRICS_HPP
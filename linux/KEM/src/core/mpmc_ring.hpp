@@ -0,0 +1,101 @@
+#ifndef MPMC_RING_HPP
+#define MPMC_RING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace clwe {
+
+constexpr size_t MPMC_RING_CACHE_LINE = 64;
+
+// Bounded lock-free MPMC ring: every slot carries a sequence number that says whether
+// it is free for the producer at position pos (sequence == pos) or holds the value for
+// the consumer at pos (sequence == pos + 1). Capacity is a power of two.
+template <typename T>
+class MPMCRing {
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_;
+    alignas(MPMC_RING_CACHE_LINE) std::atomic<size_t> enqueue_pos_{0};
+    alignas(MPMC_RING_CACHE_LINE) std::atomic<size_t> dequeue_pos_{0};
+
+public:
+    explicit MPMCRing(size_t capacity) : slots_(new Slot[capacity]), mask_(capacity - 1) {
+        for (size_t i = 0; i < capacity; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool try_push(T&& value) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots_[pos & mask_];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;  // Full
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        slot->value = std::move(value);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T& value) {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots_[pos & mask_];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;  // Empty
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        value = std::move(slot->value);
+        slot->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const {
+        size_t dequeued = dequeue_pos_.load(std::memory_order_acquire);
+        size_t enqueued = enqueue_pos_.load(std::memory_order_acquire);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+};
+
+// Smallest power of two >= x, the capacity an MPMCRing for x values needs
+inline size_t round_up_power_of_two(size_t x) {
+    size_t p = 1;
+    while (p < x) {
+        p <<= 1;
+    }
+    return p;
+}
+
+} // namespace clwe
+
+#endif // MPMC_RING_HPP
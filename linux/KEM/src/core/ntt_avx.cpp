@@ -0,0 +1,337 @@
+#include "ntt_avx.hpp"
+#include "ntt_tables.hpp"
+#include "simd_target.hpp"
+#include "utils.hpp"
+#include <algorithm>
+
+namespace clwe {
+
+namespace {
+constexpr uint32_t AVX_LANES = 8;
+
+#ifdef HAVE_AVX2
+// Coefficients x0..x15 in v0, v1 -> a and b holding the two sides of the eight butterflies
+// of half-length K, lane for lane. K = 4: a = {x0..x3 x8..x11}; K = 2: a = {x0 x1 x8 x9
+// x4 x5 x12 x13}; K = 1: a = {x0 x2 x8 x10 x4 x6 x12 x14}. Butterfly l uses twiddle l % K.
+template <uint32_t K>
+CLWE_TARGET_AVX2 CLWE_ALWAYS_INLINE void split_halves(__m256i v0, __m256i v1, __m256i& a, __m256i& b) {
+    if constexpr (K == 4) {
+        a = _mm256_permute2x128_si256(v0, v1, 0x20);
+        b = _mm256_permute2x128_si256(v0, v1, 0x31);
+    } else {
+        if constexpr (K == 1) {
+            v0 = _mm256_shuffle_epi32(v0, 0xD8);
+            v1 = _mm256_shuffle_epi32(v1, 0xD8);
+        }
+        a = _mm256_unpacklo_epi64(v0, v1);
+        b = _mm256_unpackhi_epi64(v0, v1);
+    }
+}
+
+// Inverse of split_halves
+template <uint32_t K>
+CLWE_TARGET_AVX2 CLWE_ALWAYS_INLINE void merge_halves(__m256i a, __m256i b, __m256i& v0, __m256i& v1) {
+    if constexpr (K == 4) {
+        v0 = _mm256_permute2x128_si256(a, b, 0x20);
+        v1 = _mm256_permute2x128_si256(a, b, 0x31);
+    } else if constexpr (K == 2) {
+        v0 = _mm256_unpacklo_epi64(a, b);
+        v1 = _mm256_unpackhi_epi64(a, b);
+    } else {
+        v0 = _mm256_unpacklo_epi32(a, b);
+        v1 = _mm256_unpackhi_epi32(a, b);
+    }
+}
+#endif
+} // namespace
+
+AVXNTTEngine::AVXNTTEngine(uint32_t q, uint32_t n)
+    : NTTEngine(q, n),
+      barrett_m_(static_cast<uint32_t>((1ULL << 32) / q)),
+      vector_path_(q < (1u << 16)) {
+    NTTTableView tables = ntt_tables(q, n);
+    zetas_ = tables.zetas;
+    zetas_inv_ = tables.zetas_inv;
+    stage_zetas_ = tables.stage_zetas;
+    stage_zetas_inv_ = tables.stage_zetas_inv;
+
+    // Half-length k uses the k twiddles at stage_zetas + (n - 2k) in both directions
+    for (uint32_t k = 1; k < AVX_LANES; k *= 2) {
+        for (uint32_t lane = 0; lane < AVX_LANES; ++lane) {
+            const bool used = 2 * k <= n;
+            short_zetas_[k >> 1][lane] = used ? stage_zetas_[n - 2 * k + lane % k] : 1;
+            short_zetas_inv_[k >> 1][lane] = used ? stage_zetas_inv_[n - 2 * k + lane % k] : 1;
+        }
+    }
+}
+
+uint32_t AVXNTTEngine::mod_mul(uint32_t a, uint32_t b) const {
+    return static_cast<uint32_t>((static_cast<uint64_t>(a) * b) % q_);
+}
+
+void AVXNTTEngine::butterfly(uint32_t& a, uint32_t& b, uint32_t zeta) const {
+    uint32_t sum = a + b;
+    uint32_t reduce_mask = - (uint32_t)(sum >= q_);
+    sum -= reduce_mask & q_;
+    uint32_t diff = a - b;
+    uint32_t borrow_mask = - (uint32_t)(a < b);
+    diff += borrow_mask & q_;
+    a = sum;
+    b = mod_mul(diff, zeta);
+}
+
+void AVXNTTEngine::butterfly_inv(uint32_t& a, uint32_t& b, uint32_t zeta) const {
+    uint32_t t = mod_mul(b, zeta);
+    uint32_t diff = a - t;
+    uint32_t borrow_mask = - (uint32_t)(a < t);
+    diff += borrow_mask & q_;
+    uint32_t sum = a + t;
+    uint32_t reduce_mask = - (uint32_t)(sum >= q_);
+    sum -= reduce_mask & q_;
+    a = sum;
+    b = diff;
+}
+
+#ifdef HAVE_AVX2
+CLWE_TARGET_AVX2 __m256i AVXNTTEngine::add_mod_avx(__m256i a, __m256i b) const {
+    const __m256i q_vec = _mm256_set1_epi32(static_cast<int>(q_));
+    __m256i sum = _mm256_add_epi32(a, b);
+    // sum - q wraps around exactly when sum < q, so the unsigned min picks the reduced value
+    return _mm256_min_epu32(sum, _mm256_sub_epi32(sum, q_vec));
+}
+
+CLWE_TARGET_AVX2 __m256i AVXNTTEngine::sub_mod_avx(__m256i a, __m256i b) const {
+    const __m256i q_vec = _mm256_set1_epi32(static_cast<int>(q_));
+    __m256i diff = _mm256_add_epi32(_mm256_sub_epi32(a, b), q_vec);
+    return _mm256_min_epu32(diff, _mm256_sub_epi32(diff, q_vec));
+}
+
+CLWE_TARGET_AVX2 __m256i AVXNTTEngine::mul_mod_avx(__m256i a, __m256i b) const {
+    // a, b < q < 2^16, so the full product fits in 32 bits
+    return reduce_avx(_mm256_mullo_epi32(a, b));
+}
+
+CLWE_TARGET_AVX2 __m256i AVXNTTEngine::reduce_avx(__m256i x) const {
+    const __m256i q_vec = _mm256_set1_epi32(static_cast<int>(q_));
+    const __m256i m_vec = _mm256_set1_epi32(static_cast<int>(barrett_m_));
+
+    // Barrett quotient floor(x * m / 2^32) for even and odd lanes
+    __m256i t_even = _mm256_srli_epi64(_mm256_mul_epu32(x, m_vec), 32);
+    __m256i t_odd = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), m_vec);
+    __m256i t = _mm256_blend_epi32(t_even, t_odd, 0xAA);
+
+    // The quotient is at most one short, leaving r < 2q
+    __m256i r = _mm256_sub_epi32(x, _mm256_mullo_epi32(t, q_vec));
+    return _mm256_min_epu32(r, _mm256_sub_epi32(r, q_vec));
+}
+
+template <uint32_t K>
+CLWE_TARGET_AVX2 void AVXNTTEngine::forward_short_stage(uint32_t* poly, size_t total) const {
+    const __m256i z = _mm256_load_si256(reinterpret_cast<const __m256i*>(short_zetas_[K >> 1]));
+    for (size_t start = 0; start < total; start += 2 * AVX_LANES) {
+        __m256i* v = reinterpret_cast<__m256i*>(poly + start);
+        __m256i a, b, v0, v1;
+        split_halves<K>(_mm256_loadu_si256(v), _mm256_loadu_si256(v + 1), a, b);
+        merge_halves<K>(add_mod_avx(a, b), mul_mod_avx(sub_mod_avx(a, b), z), v0, v1);
+        _mm256_storeu_si256(v, v0);
+        _mm256_storeu_si256(v + 1, v1);
+    }
+}
+
+template <uint32_t K>
+CLWE_TARGET_AVX2 void AVXNTTEngine::inverse_short_stage(uint32_t* poly, size_t total) const {
+    const __m256i z = _mm256_load_si256(reinterpret_cast<const __m256i*>(short_zetas_inv_[K >> 1]));
+    for (size_t start = 0; start < total; start += 2 * AVX_LANES) {
+        __m256i* v = reinterpret_cast<__m256i*>(poly + start);
+        __m256i a, b, v0, v1;
+        split_halves<K>(_mm256_loadu_si256(v), _mm256_loadu_si256(v + 1), a, b);
+        __m256i t = mul_mod_avx(b, z);
+        merge_halves<K>(add_mod_avx(a, t), sub_mod_avx(a, t), v0, v1);
+        _mm256_storeu_si256(v, v0);
+        _mm256_storeu_si256(v + 1, v1);
+    }
+}
+#endif
+
+void AVXNTTEngine::ntt_forward(uint32_t* poly) const {
+    ntt_forward_batch(poly, 1);
+}
+
+CLWE_TARGET_AVX2 void AVXNTTEngine::ntt_forward_batch(uint32_t* poly, size_t count) const {
+    // Decimation-in-frequency NTT, natural order in, bit-reversed order out
+    const size_t total = count * n_;
+    uint32_t m = 1;
+    uint32_t k = n_ / 2;
+    const uint32_t* stage_zetas = stage_zetas_;
+#ifdef HAVE_AVX2
+    // The short stages consume two registers per step
+    const bool pairs = vector_path_ && total % (2 * AVX_LANES) == 0;
+#endif
+
+    for (uint32_t stage = 0; stage < log_degree(); ++stage) {
+#ifdef HAVE_AVX2
+        if (vector_path_ && k >= AVX_LANES) {
+            for (size_t start = 0; start < total; start += 2 * k) {
+                for (uint32_t i = 0; i < k; i += AVX_LANES) {
+                    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(poly + start + i));
+                    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(poly + start + i + k));
+                    __m256i z = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(stage_zetas + i));
+                    __m256i sum = add_mod_avx(a, b);
+                    __m256i diff = mul_mod_avx(sub_mod_avx(a, b), z);
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(poly + start + i), sum);
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(poly + start + i + k), diff);
+                }
+            }
+        } else if (pairs) {
+            if (k == 4) {
+                forward_short_stage<4>(poly, total);
+            } else if (k == 2) {
+                forward_short_stage<2>(poly, total);
+            } else {
+                forward_short_stage<1>(poly, total);
+            }
+        } else
+#endif
+        {
+            for (size_t start = 0; start < total; start += 2 * k) {
+                uint32_t j = 0;
+                for (size_t i = start; i < start + k; ++i) {
+                    butterfly(poly[i], poly[i + k], zetas_[j]);
+                    j += m;
+                }
+            }
+        }
+        stage_zetas += k;
+        m *= 2;
+        k /= 2;
+    }
+}
+
+void AVXNTTEngine::ntt_inverse(uint32_t* poly) const {
+    ntt_inverse_batch(poly, 1);
+}
+
+CLWE_TARGET_AVX2 void AVXNTTEngine::ntt_inverse_batch(uint32_t* poly, size_t count) const {
+    // Decimation-in-time inverse NTT, bit-reversed order in, natural order out (scaled by n)
+    const size_t total = count * n_;
+    uint32_t m = n_ / 2;
+    uint32_t k = 1;
+    const uint32_t* stage_zetas = stage_zetas_inv_ + (n_ - 1);
+#ifdef HAVE_AVX2
+    const bool pairs = vector_path_ && total % (2 * AVX_LANES) == 0;
+#endif
+
+    for (uint32_t stage = 0; stage < log_degree(); ++stage) {
+        stage_zetas -= k;
+#ifdef HAVE_AVX2
+        if (vector_path_ && k >= AVX_LANES) {
+            for (size_t start = 0; start < total; start += 2 * k) {
+                for (uint32_t i = 0; i < k; i += AVX_LANES) {
+                    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(poly + start + i));
+                    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(poly + start + i + k));
+                    __m256i z = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(stage_zetas + i));
+                    __m256i t = mul_mod_avx(b, z);
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(poly + start + i), add_mod_avx(a, t));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(poly + start + i + k), sub_mod_avx(a, t));
+                }
+            }
+        } else if (pairs) {
+            if (k == 4) {
+                inverse_short_stage<4>(poly, total);
+            } else if (k == 2) {
+                inverse_short_stage<2>(poly, total);
+            } else {
+                inverse_short_stage<1>(poly, total);
+            }
+        } else
+#endif
+        {
+            for (size_t start = 0; start < total; start += 2 * k) {
+                uint32_t j = 0;
+                for (size_t i = start; i < start + k; ++i) {
+                    butterfly_inv(poly[i], poly[i + k], zetas_inv_[j]);
+                    j += m;
+                }
+            }
+        }
+        m /= 2;
+        k *= 2;
+    }
+}
+
+CLWE_TARGET_AVX2 void AVXNTTEngine::multiply_inplace(uint32_t* a, uint32_t* b) const {
+    ntt_forward(a);
+    ntt_forward(b);
+
+    uint32_t i = 0;
+#ifdef HAVE_AVX2
+    if (vector_path_) {
+        for (; i + AVX_LANES <= n_; i += AVX_LANES) {
+            __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+            __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + i), mul_mod_avx(va, vb));
+        }
+    }
+#endif
+    for (; i < n_; ++i) {
+        a[i] = mod_mul(a[i], b[i]);
+    }
+
+    ntt_inverse(a);
+}
+
+CLWE_TARGET_AVX2 void AVXNTTEngine::basemul_acc(const uint32_t* a, const uint32_t* b, size_t k, uint32_t* out) const {
+    uint32_t i = 0;
+#ifdef HAVE_AVX2
+    if (vector_path_) {
+        // Eight coefficients at a time, accumulated across all k products in one register.
+        // When k raw products fit in 32 bits the sum is reduced once at the end.
+        const bool lazy = lazy_accumulation_fits(k);
+        for (; i + AVX_LANES <= n_; i += AVX_LANES) {
+            __m256i acc = _mm256_setzero_si256();
+            for (size_t j = 0; j < k; ++j) {
+                __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + j * n_ + i));
+                __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + j * n_ + i));
+                acc = lazy ? _mm256_add_epi32(acc, _mm256_mullo_epi32(va, vb)) : add_mod_avx(acc, mul_mod_avx(va, vb));
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), lazy ? reduce_avx(acc) : acc);
+        }
+    }
+#endif
+    for (; i < n_; ++i) {
+        uint64_t acc = 0;
+        for (size_t j = 0; j < k; ++j) {
+            acc += mod_mul(a[j * n_ + i], b[j * n_ + i]);
+        }
+        out[i] = static_cast<uint32_t>(acc % q_);
+    }
+}
+
+CLWE_TARGET_AVX2 uint32_t AVXNTTEngine::constant_term_product(const uint32_t* a, const uint32_t* b) const {
+    uint64_t acc = mod_mul(a[0], b[0]);
+    uint32_t j = 1;
+#ifdef HAVE_AVX2
+    if (vector_path_) {
+        // a[j..j+7] meets b[n-j..n-j-7]; reversed residues < q keep the 32-bit lane sums exact
+        const __m256i reverse = _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256i sum = _mm256_setzero_si256();
+        for (; j + AVX_LANES <= n_; j += AVX_LANES) {
+            __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + j));
+            __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + n_ - j - (AVX_LANES - 1)));
+            vb = _mm256_permutevar8x32_epi32(vb, reverse);
+            sum = _mm256_add_epi32(sum, mul_mod_avx(va, vb));
+        }
+        alignas(32) uint32_t lanes[AVX_LANES];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), sum);
+        for (uint32_t lane = 0; lane < AVX_LANES; ++lane) {
+            acc += lanes[lane];
+        }
+    }
+#endif
+    for (; j < n_; ++j) {
+        acc += mod_mul(a[j], b[n_ - j]);
+    }
+    return static_cast<uint32_t>(acc % q_);
+}
+
+} // namespace clwe
@@ -0,0 +1,74 @@
+#ifndef NTT_AVX_HPP
+#define NTT_AVX_HPP
+
+#include "ntt_engine.hpp"
+#include <cstdint>
+#include <vector>
+
+#ifdef HAVE_AVX2
+#include <immintrin.h>
+#endif
+
+namespace clwe {
+
+// AVX2 NTT engine: 8 uint32_t lanes per __m256i, bit-exact with ScalarNTTEngine.
+// Its kernels are compiled for AVX2 whatever the build flags, so only create it on CPUs
+// that report AVX2 (create_optimal_ntt_engine does).
+class AVXNTTEngine : public NTTEngine {
+private:
+    // Twiddles shared by all engines with this (q, n), see ntt_tables.hpp
+    const uint32_t* zetas_;
+    const uint32_t* zetas_inv_;
+
+    // Per-stage twiddles laid out contiguously so each butterfly group is one load.
+    // Stage s with half-length k = n >> (s + 1) stores zetas_[i << s] for i < k.
+    const uint32_t* stage_zetas_;
+    const uint32_t* stage_zetas_inv_;
+
+    // Stages with k < 8 work on two vectors split into butterfly halves. Row k >> 1 holds
+    // that stage's twiddles in the lane order of the split, so each step is one aligned load.
+    alignas(32) uint32_t short_zetas_[3][8];
+    alignas(32) uint32_t short_zetas_inv_[3][8];
+
+    // Barrett constant floor(2^32 / q); valid while q < 2^16 so products fit in 32 bits
+    uint32_t barrett_m_;
+    bool vector_path_;
+
+    // Scalar butterflies for the short stages and the q >= 2^16 fallback
+    void butterfly(uint32_t& a, uint32_t& b, uint32_t zeta) const;
+    void butterfly_inv(uint32_t& a, uint32_t& b, uint32_t zeta) const;
+    uint32_t mod_mul(uint32_t a, uint32_t b) const;
+
+#ifdef HAVE_AVX2
+    // AVX2 modular arithmetic on canonical residues
+    __m256i add_mod_avx(__m256i a, __m256i b) const;
+    __m256i sub_mod_avx(__m256i a, __m256i b) const;
+    __m256i mul_mod_avx(__m256i a, __m256i b) const;
+    // Barrett reduction of any 32-bit lane value
+    __m256i reduce_avx(__m256i x) const;
+    // One stage of half-length K < 8 over total coefficients, 16 at a time
+    template <uint32_t K>
+    void forward_short_stage(uint32_t* poly, size_t total) const;
+    template <uint32_t K>
+    void inverse_short_stage(uint32_t* poly, size_t total) const;
+#endif
+
+public:
+    AVXNTTEngine(uint32_t q, uint32_t n);
+    ~AVXNTTEngine() override = default;
+
+    // Implement pure virtual methods
+    void ntt_forward(uint32_t* poly) const override;
+    void ntt_inverse(uint32_t* poly) const override;
+    void ntt_forward_batch(uint32_t* polys, size_t count) const override;
+    void ntt_inverse_batch(uint32_t* polys, size_t count) const override;
+    void multiply_inplace(uint32_t* a, uint32_t* b) const override;
+    void basemul_acc(const uint32_t* a, const uint32_t* b, size_t k, uint32_t* out) const override;
+    uint32_t constant_term_product(const uint32_t* a, const uint32_t* b) const override;
+
+    SIMDSupport get_simd_support() const override { return SIMDSupport::AVX2; }
+};
+
+} // namespace clwe
+
+#endif // NTT_AVX_HPP
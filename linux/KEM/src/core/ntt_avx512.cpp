@@ -0,0 +1,270 @@
+#include "ntt_avx512.hpp"
+#include "ntt_tables.hpp"
+#include "simd_target.hpp"
+#include <algorithm>
+
+#ifdef HAVE_AVX512BW
+#include <immintrin.h>
+#endif
+
+// Value ranges on the 16-bit path, for odd 2^11 < q < 2^13:
+//   montgomery(x, z) with |x| < 2^15 and |z| <= q lies in (-q, q);
+//   barrett(x) with |x| < 4q lies in (-q, 2q) and is congruent to x.
+// Butterfly inputs therefore stay in (-q, 2q), sums and differences below 4q < 2^15, and the
+// final pass maps (-q, 2q) onto the canonical [0, q) the scalar engine produces.
+
+namespace clwe {
+
+namespace {
+
+uint32_t log2_of(uint32_t k) {
+    uint32_t log = 0;
+    while ((1u << log) < k) {
+        ++log;
+    }
+    return log;
+}
+
+// Lanes whose index has bit k set hold the second element of each in-register butterfly
+uint32_t upper_lanes(uint32_t k) {
+    uint32_t mask = 0;
+    for (uint32_t lane = 0; lane < AVX512NTTEngine::LANES; ++lane) {
+        if (lane & k) {
+            mask |= 1u << lane;
+        }
+    }
+    return mask;
+}
+
+#ifdef HAVE_AVX512BW
+alignas(64) constexpr int16_t LANE_INDEX[32] = {
+    0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14, 15,
+    16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31};
+
+struct Constants16 {
+    __m512i q;
+    __m512i qinv;
+    __m512i v;
+};
+
+// a * z * 2^-16 with z in Montgomery form and zqinv = z * q^-1 mod 2^16 precomputed
+CLWE_TARGET_AVX512 inline __m512i montgomery(__m512i a, __m512i z, __m512i zqinv, const Constants16& c) {
+    __m512i hi = _mm512_mulhi_epi16(a, z);
+    __m512i m = _mm512_mullo_epi16(a, zqinv);
+    return _mm512_sub_epi16(hi, _mm512_mulhi_epi16(m, c.q));
+}
+
+CLWE_TARGET_AVX512 inline __m512i barrett(__m512i a, const Constants16& c) {
+    __m512i t = _mm512_srai_epi16(_mm512_mulhi_epi16(a, c.v), 10);
+    return _mm512_sub_epi16(a, _mm512_mullo_epi16(t, c.q));
+}
+
+// (-q, 2q) -> [0, q)
+CLWE_TARGET_AVX512 inline __m512i canonical(__m512i a, const Constants16& c) {
+    a = _mm512_mask_add_epi16(a, _mm512_cmplt_epi16_mask(a, _mm512_setzero_si512()), a, c.q);
+    return _mm512_mask_sub_epi16(a, _mm512_cmpge_epi16_mask(a, c.q), a, c.q);
+}
+
+// 32 reduced uint32 coefficients -> one register of int16
+CLWE_TARGET_AVX512 inline __m512i load_narrow(const uint32_t* in) {
+    __m256i lo = _mm512_cvtepi32_epi16(_mm512_loadu_si512(in));
+    __m256i hi = _mm512_cvtepi32_epi16(_mm512_loadu_si512(in + 16));
+    return _mm512_inserti64x4(_mm512_castsi256_si512(lo), hi, 1);
+}
+
+CLWE_TARGET_AVX512 inline void store_widen(uint32_t* out, __m512i v) {
+    _mm512_storeu_si512(out, _mm512_cvtepu16_epi32(_mm512_castsi512_si256(v)));
+    _mm512_storeu_si512(out + 16, _mm512_cvtepu16_epi32(_mm512_extracti64x4_epi64(v, 1)));
+}
+
+// Barrett reduction of any 32-bit lane value with m = floor(2^32 / q), as AVXNTTEngine::reduce_avx
+CLWE_TARGET_AVX512 inline __m512i reduce32(__m512i x, __m512i q_vec, __m512i m_vec) {
+    __m512i t_even = _mm512_srli_epi64(_mm512_mul_epu32(x, m_vec), 32);
+    __m512i t_odd = _mm512_mul_epu32(_mm512_srli_epi64(x, 32), m_vec);
+    __m512i t = _mm512_mask_blend_epi32(0xAAAA, t_even, t_odd);
+    __m512i r = _mm512_sub_epi32(x, _mm512_mullo_epi32(t, q_vec));
+    return _mm512_min_epu32(r, _mm512_sub_epi32(r, q_vec));
+}
+
+CLWE_TARGET_AVX512 inline __m512i load16(const int16_t* in) {
+    return _mm512_loadu_si512(in);
+}
+
+CLWE_TARGET_AVX512 inline void store16(int16_t* out, __m512i v) {
+    _mm512_storeu_si512(out, v);
+}
+#endif
+
+} // namespace
+
+AVX512NTTEngine::AVX512NTTEngine(uint32_t q, uint32_t n)
+    : AVXNTTEngine(q, n),
+      qinv_(static_cast<int16_t>(inverse_mod_2_16(q))),
+      barrett_v_(q > 2048 && q < 8192 ? static_cast<int16_t>(((1u << 26) + q / 2) / q) : 0),
+      vector_path16_((q & 1) && q > 2048 && q < 8192 && n >= LANES && n <= MAX_VECTOR_DEGREE) {
+    if (!vector_path16_) {
+        return;
+    }
+
+    NTTMontgomeryTableView montgomery = ntt_montgomery_tables(q, n, LANES);
+    fwd_zetas_ = montgomery.fwd_zetas;
+    fwd_zetas_qinv_ = montgomery.fwd_zetas_qinv;
+    inv_zetas_ = montgomery.inv_zetas;
+    inv_zetas_qinv_ = montgomery.inv_zetas_qinv;
+    stage_offsets_ = montgomery.stage_offsets;
+}
+
+CLWE_TARGET_AVX512 void AVX512NTTEngine::forward16(uint32_t* poly) const {
+#ifdef HAVE_AVX512BW
+    const Constants16 c = {_mm512_set1_epi16(static_cast<int16_t>(q_)), _mm512_set1_epi16(qinv_),
+                           _mm512_set1_epi16(barrett_v_)};
+    alignas(64) int16_t work[MAX_VECTOR_DEGREE];
+    for (uint32_t i = 0; i < n_; i += LANES) {
+        store16(work + i, load_narrow(poly + i));
+    }
+
+    // Decimation in frequency: (a, b) -> (a + b, (a - b) * zeta), whole registers first
+    uint32_t k = n_ / 2;
+    for (; k >= LANES; k /= 2) {
+        const int16_t* z = fwd_zetas_ + stage_offsets_[log2_of(k)];
+        const int16_t* zq = fwd_zetas_qinv_ + stage_offsets_[log2_of(k)];
+        for (uint32_t start = 0; start < n_; start += 2 * k) {
+            for (uint32_t i = 0; i < k; i += LANES) {
+                __m512i a = load16(work + start + i);
+                __m512i b = load16(work + start + i + k);
+                store16(work + start + i, barrett(_mm512_add_epi16(a, b), c));
+                store16(work + start + i + k, montgomery(_mm512_sub_epi16(a, b), load16(z + i), load16(zq + i), c));
+            }
+        }
+    }
+
+    // Pairs inside one register: swap lane l with l ^ k and keep the half each lane owns
+    const __m512i lanes = _mm512_load_si512(LANE_INDEX);
+    for (; k >= 1; k /= 2) {
+        const __m512i z = load16(fwd_zetas_ + stage_offsets_[log2_of(k)]);
+        const __m512i zq = load16(fwd_zetas_qinv_ + stage_offsets_[log2_of(k)]);
+        const __m512i partner = _mm512_xor_si512(lanes, _mm512_set1_epi16(static_cast<int16_t>(k)));
+        const __mmask32 upper = upper_lanes(k);
+        for (uint32_t i = 0; i < n_; i += LANES) {
+            __m512i x = load16(work + i);
+            __m512i y = _mm512_permutexvar_epi16(partner, x);
+            __m512i a = _mm512_mask_blend_epi16(upper, x, y);
+            __m512i b = _mm512_mask_blend_epi16(upper, y, x);
+            __m512i sum = barrett(_mm512_add_epi16(a, b), c);
+            __m512i diff = montgomery(_mm512_sub_epi16(a, b), z, zq, c);
+            store16(work + i, _mm512_mask_blend_epi16(upper, sum, diff));
+        }
+    }
+
+    for (uint32_t i = 0; i < n_; i += LANES) {
+        store_widen(poly + i, canonical(load16(work + i), c));
+    }
+#else
+    AVXNTTEngine::ntt_forward_batch(poly, 1);
+#endif
+}
+
+CLWE_TARGET_AVX512 void AVX512NTTEngine::inverse16(uint32_t* poly) const {
+#ifdef HAVE_AVX512BW
+    const Constants16 c = {_mm512_set1_epi16(static_cast<int16_t>(q_)), _mm512_set1_epi16(qinv_),
+                           _mm512_set1_epi16(barrett_v_)};
+    alignas(64) int16_t work[MAX_VECTOR_DEGREE];
+    for (uint32_t i = 0; i < n_; i += LANES) {
+        store16(work + i, load_narrow(poly + i));
+    }
+
+    // Decimation in time: (a, b) -> (a + b * zeta, a - b * zeta), in-register pairs first
+    const __m512i lanes = _mm512_load_si512(LANE_INDEX);
+    uint32_t k = 1;
+    for (; k < LANES && k < n_; k *= 2) {
+        const __m512i z = load16(inv_zetas_ + stage_offsets_[log2_of(k)]);
+        const __m512i zq = load16(inv_zetas_qinv_ + stage_offsets_[log2_of(k)]);
+        const __m512i partner = _mm512_xor_si512(lanes, _mm512_set1_epi16(static_cast<int16_t>(k)));
+        const __mmask32 upper = upper_lanes(k);
+        for (uint32_t i = 0; i < n_; i += LANES) {
+            __m512i x = load16(work + i);
+            __m512i y = _mm512_permutexvar_epi16(partner, x);
+            __m512i a = _mm512_mask_blend_epi16(upper, x, y);
+            __m512i t = montgomery(_mm512_mask_blend_epi16(upper, y, x), z, zq, c);
+            __m512i sum = barrett(_mm512_add_epi16(a, t), c);
+            __m512i diff = barrett(_mm512_sub_epi16(a, t), c);
+            store16(work + i, _mm512_mask_blend_epi16(upper, sum, diff));
+        }
+    }
+
+    for (; k < n_; k *= 2) {
+        const int16_t* z = inv_zetas_ + stage_offsets_[log2_of(k)];
+        const int16_t* zq = inv_zetas_qinv_ + stage_offsets_[log2_of(k)];
+        for (uint32_t start = 0; start < n_; start += 2 * k) {
+            for (uint32_t i = 0; i < k; i += LANES) {
+                __m512i a = load16(work + start + i);
+                __m512i t = montgomery(load16(work + start + i + k), load16(z + i), load16(zq + i), c);
+                store16(work + start + i, barrett(_mm512_add_epi16(a, t), c));
+                store16(work + start + i + k, barrett(_mm512_sub_epi16(a, t), c));
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < n_; i += LANES) {
+        store_widen(poly + i, canonical(load16(work + i), c));
+    }
+#else
+    AVXNTTEngine::ntt_inverse_batch(poly, 1);
+#endif
+}
+
+void AVX512NTTEngine::ntt_forward_batch(uint32_t* polys, size_t count) const {
+    if (!vector_path16_) {
+        AVXNTTEngine::ntt_forward_batch(polys, count);
+        return;
+    }
+    for (size_t p = 0; p < count; ++p) {
+        forward16(polys + p * n_);
+    }
+}
+
+void AVX512NTTEngine::ntt_inverse_batch(uint32_t* polys, size_t count) const {
+    if (!vector_path16_) {
+        AVXNTTEngine::ntt_inverse_batch(polys, count);
+        return;
+    }
+    for (size_t p = 0; p < count; ++p) {
+        inverse16(polys + p * n_);
+    }
+}
+
+void AVX512NTTEngine::multiply_inplace(uint32_t* a, uint32_t* b) const {
+    if (!vector_path16_) {
+        AVXNTTEngine::multiply_inplace(a, b);
+        return;
+    }
+    forward16(a);
+    forward16(b);
+    // Each output lane is stored after its inputs are loaded, so basemul_acc may write over a
+    basemul_acc(a, b, 1, a);
+    inverse16(a);
+}
+
+CLWE_TARGET_AVX512 void AVX512NTTEngine::basemul_acc(const uint32_t* a, const uint32_t* b, size_t k,
+                                                     uint32_t* out) const {
+#ifdef HAVE_AVX512BW
+    if (vector_path16_ && lazy_accumulation_fits(k)) {
+        // Sixteen 32-bit lanes: raw products summed across all k, then one reduction.
+        // Narrowing to int16 would cost more shuffles than the Montgomery products save.
+        const __m512i q_vec = _mm512_set1_epi32(static_cast<int>(q_));
+        const __m512i m_vec = _mm512_set1_epi32(static_cast<int>(static_cast<uint32_t>((1ULL << 32) / q_)));
+        for (uint32_t i = 0; i < n_; i += 16) {
+            __m512i acc = _mm512_setzero_si512();
+            for (size_t j = 0; j < k; ++j) {
+                acc = _mm512_add_epi32(acc, _mm512_mullo_epi32(_mm512_loadu_si512(a + j * n_ + i),
+                                                               _mm512_loadu_si512(b + j * n_ + i)));
+            }
+            _mm512_storeu_si512(out + i, reduce32(acc, q_vec, m_vec));
+        }
+        return;
+    }
+#endif
+    AVXNTTEngine::basemul_acc(a, b, k, out);
+}
+
+} // namespace clwe
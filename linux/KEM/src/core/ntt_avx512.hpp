@@ -0,0 +1,57 @@
+#ifndef NTT_AVX512_HPP
+#define NTT_AVX512_HPP
+
+#include "ntt_avx.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace clwe {
+
+// AVX-512BW NTT engine: 32 int16 lanes per __m512i with vpmulhw Montgomery twiddles,
+// bit-exact with ScalarNTTEngine. Stages with half-length k >= 32 pair whole registers;
+// the last five pair lanes inside one register through a permute and a lane mask.
+// basemul_acc sums raw products in sixteen 32-bit lanes and reduces once.
+// Moduli or degrees outside the 16-bit path fall back to the AVX2 kernels it derives from.
+// Its kernels are compiled for AVX-512 whatever the build flags, so only create it on CPUs
+// that report AVX-512BW (create_ntt_engine checks).
+class AVX512NTTEngine : public AVXNTTEngine {
+public:
+    static constexpr uint32_t LANES = 32;
+    // Largest degree transformed in the on-stack int16 work buffer
+    static constexpr uint32_t MAX_VECTOR_DEGREE = 1024;
+
+private:
+    // Per-stage twiddles in Montgomery form (zeta * 2^16 mod q, centered) and their products
+    // with q^-1 mod 2^16. Half-length k starts at stage_offsets_[log2(k)]; stages shorter than
+    // a register are repeated to fill LANES entries, lane l using twiddle l mod k.
+    // Shared per (q, n, lanes) through ntt_montgomery_tables; null off the 16-bit path.
+    const int16_t* fwd_zetas_ = nullptr;
+    const int16_t* fwd_zetas_qinv_ = nullptr;
+    const int16_t* inv_zetas_ = nullptr;
+    const int16_t* inv_zetas_qinv_ = nullptr;
+    const uint32_t* stage_offsets_ = nullptr;
+
+    int16_t qinv_;       // q^-1 mod 2^16
+    int16_t barrett_v_;  // round(2^26 / q)
+    // Odd 2^11 < q < 2^13 keeps every intermediate inside int16, see ntt_avx512.cpp
+    bool vector_path16_;
+
+    void forward16(uint32_t* poly) const;
+    void inverse16(uint32_t* poly) const;
+
+public:
+    AVX512NTTEngine(uint32_t q, uint32_t n);
+    ~AVX512NTTEngine() override = default;
+
+    void ntt_forward_batch(uint32_t* polys, size_t count) const override;
+    void ntt_inverse_batch(uint32_t* polys, size_t count) const override;
+    void multiply_inplace(uint32_t* a, uint32_t* b) const override;
+    void basemul_acc(const uint32_t* a, const uint32_t* b, size_t k, uint32_t* out) const override;
+
+    bool has_avx512() const override { return true; }
+    SIMDSupport get_simd_support() const override { return SIMDSupport::AVX512; }
+};
+
+} // namespace clwe
+
+#endif // NTT_AVX512_HPP
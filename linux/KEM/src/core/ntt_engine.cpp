@@ -1,54 +1,129 @@
 #include "ntt_engine.hpp"
 #include "cpu_features.hpp"
 #include "ntt_scalar.hpp"
+#include "ntt_tables.hpp"
+#include "ntt_unrolled.hpp"
+#include "ntt_portable.hpp"
+#include "simd_vec.hpp"
 #ifdef HAVE_AVX2
 #include "ntt_avx.hpp"
 #endif
+#ifdef HAVE_AVX512BW
+#include "ntt_avx512.hpp"
+#endif
 #ifdef HAVE_NEON
 #include "ntt_neon.hpp"
 #endif
+#ifdef HAVE_SVE
+#include "ntt_sve.hpp"
+#endif
 #ifdef HAVE_RVV
 #include "ntt_rvv.hpp"
 #endif
+#ifdef HAVE_VSX
+#include "ntt_vsx.hpp"
+#endif
+#ifdef HAVE_WASM_SIMD128
+#include "ntt_wasm.hpp"
+#endif
 #include "utils.hpp"
+#include "clwe/autotune.hpp"
+#include "clwe/clwe.hpp"
 #include <algorithm>
+#include <atomic>
 #include <stdexcept>
+#include <string>
 
 namespace clwe {
 
 NTTEngine::NTTEngine(uint32_t q, uint32_t n)
-    : q_(q), n_(n), log_n_(0), bitrev_(n) {
+    : q_(q), n_(n), log_n_(0) {
 
     if (!is_power_of_two(n)) {
         throw std::invalid_argument("NTT degree must be a power of 2");
     }
 
+    if (!CLWEParameters::is_prime(q)) {
+        throw std::invalid_argument("NTT modulus must be prime, got " + std::to_string(q));
+    }
+
     // Calculate log_n_
     uint32_t temp = n;
     while (temp > 1) {
         temp >>= 1;
         log_n_++;
     }
-
-    precompute_bitrev();
 }
 
-void NTTEngine::precompute_bitrev() {
+void NTTEngine::bit_reverse(uint32_t* poly) const {
+    // Bit reversal is an involution, so swapping each pair once permutes in place
+    const uint32_t* bitrev = ntt_tables(q_, n_).bitrev;
     for (uint32_t i = 0; i < n_; ++i) {
-        uint32_t rev = 0;
-        for (uint32_t j = 0; j < log_n_; ++j) {
-            rev |= ((i >> j) & 1) << (log_n_ - 1 - j);
+        uint32_t j = bitrev[i];
+        if (i < j) {
+            std::swap(poly[i], poly[j]);
         }
-        bitrev_[i] = rev;
     }
 }
 
-void NTTEngine::bit_reverse(uint32_t* poly) const {
-    std::vector<uint32_t> temp(n_);
+void NTTEngine::multiply(const uint32_t* a, const uint32_t* b, uint32_t* result) const {
+    thread_local std::vector<uint32_t> scratch;
+    scratch.resize(n_);
+    // b is copied before result is written, so result may alias it
+    for (uint32_t i = 0; i < n_; ++i) {
+        scratch[i] = b[i] % q_;
+    }
+    for (uint32_t i = 0; i < n_; ++i) {
+        result[i] = a[i] % q_;
+    }
+    multiply_inplace(result, scratch.data());
+}
+
+uint32_t NTTEngine::constant_term_product(const uint32_t* a, const uint32_t* b) const {
+    // Cyclic ring: x^j * x^(n-j) = x^n = 1, so no sign flips
+    uint64_t acc = static_cast<uint64_t>(a[0]) * b[0] % q_;
+    for (uint32_t j = 1; j < n_; ++j) {
+        acc += static_cast<uint64_t>(a[j]) * b[n_ - j] % q_;
+    }
+    return static_cast<uint32_t>(acc % q_);
+}
+
+void NTTEngine::ntt_forward_batch(uint32_t* polys, size_t count) const {
+    for (size_t i = 0; i < count; ++i) {
+        ntt_forward(polys + i * n_);
+    }
+}
+
+void NTTEngine::ntt_inverse_batch(uint32_t* polys, size_t count) const {
+    for (size_t i = 0; i < count; ++i) {
+        ntt_inverse(polys + i * n_);
+    }
+}
+
+void NTTEngine::basemul_acc(const uint32_t* a, const uint32_t* b, size_t k, uint32_t* out) const {
+    // Each term is reduced before it is added, so the 64-bit sum cannot overflow
     for (uint32_t i = 0; i < n_; ++i) {
-        temp[bitrev_[i]] = poly[i];
+        uint64_t acc = 0;
+        for (size_t j = 0; j < k; ++j) {
+            acc += static_cast<uint64_t>(a[j * n_ + i]) * b[j * n_ + i] % q_;
+        }
+        out[i] = static_cast<uint32_t>(acc % q_);
+    }
+}
+
+void NTTEngine::check_lazy_bound(const uint32_t* poly, uint64_t bound, size_t count) const {
+#ifdef CLWE_NTT_BOUND_CHECKS
+    for (size_t i = 0; i < count * n_; ++i) {
+        if (poly[i] >= bound) {
+            throw std::logic_error("NTT coefficient " + std::to_string(poly[i]) + " at index " + std::to_string(i) +
+                                   " exceeds lazy bound " + std::to_string(bound));
+        }
     }
-    std::copy(temp.begin(), temp.end(), poly);
+#else
+    (void)poly;
+    (void)bound;
+    (void)count;
+#endif
 }
 
 void NTTEngine::copy_from_uint32(const uint32_t* coeffs, uint32_t* ntt_coeffs) const {
@@ -61,24 +136,109 @@ void NTTEngine::copy_to_uint32(const uint32_t* ntt_coeffs, uint32_t* coeffs) con
 
 // Forward declarations for concrete implementations
 class ScalarNTTEngine;
-// class AVX2NTTEngine;
-// class AVX512NTTEngine;
+#ifdef HAVE_AVX2
+class AVXNTTEngine;
+#endif
+#ifdef HAVE_AVX512BW
+class AVX512NTTEngine;
+#endif
 #ifdef HAVE_NEON
 class NEONNTTEngine;
 #endif
+#ifdef HAVE_SVE
+class SVENTTEngine;
+#endif
 #ifdef HAVE_RVV
 class RVVNTTEngine;
 #endif
-// class VSXNTTEngine;
+#ifdef HAVE_VSX
+class VSXNTTEngine;
+#endif
+#ifdef HAVE_WASM_SIMD128
+class WasmSIMD128NTTEngine;
+#endif
+
+namespace {
+
+// set_ntt_backend() choice; unset until the first call
+std::atomic<bool> g_ntt_backend_selected{false};
+std::atomic<SIMDSupport> g_ntt_backend{SIMDSupport::NONE};
+
+} // namespace
+
+std::vector<SIMDSupport> available_ntt_backends() {
+    const CPUFeatures& cpu = CPUFeatureDetector::cached();
+    const SIMDSupport candidates[] = {SIMDSupport::NONE, SIMDSupport::AVX2, SIMDSupport::AVX512,
+                                      SIMDSupport::NEON, SIMDSupport::SVE, SIMDSupport::RVV, SIMDSupport::VSX,
+                                      SIMDSupport::WASM_SIMD128};
+    std::vector<SIMDSupport> backends;
+    for (SIMDSupport simd : candidates) {
+        bool runs_here = simd == SIMDSupport::NONE ||
+                         (simd == SIMDSupport::AVX2 && cpu.has_avx2) ||
+                         (simd == SIMDSupport::AVX512 && cpu.has_avx512bw) ||
+                         (simd == SIMDSupport::NEON && cpu.has_neon) ||
+                         (simd == SIMDSupport::SVE && cpu.has_sve) ||
+                         (simd == SIMDSupport::RVV && cpu.has_rvv) ||
+                         (simd == SIMDSupport::VSX && cpu.has_vsx) ||
+                         (simd == SIMDSupport::WASM_SIMD128 && cpu.has_wasm_simd128);
+        // create_ntt_engine falls back to another engine for backends not compiled in
+        if (runs_here && create_ntt_engine(simd, 3329, 256)->get_simd_support() == simd) {
+            backends.push_back(simd);
+        }
+    }
+    return backends;
+}
+
+SIMDSupport ntt_backend() {
+    if (g_ntt_backend_selected.load(std::memory_order_acquire)) {
+        return g_ntt_backend.load(std::memory_order_relaxed);
+    }
+    return CPUFeatureDetector::cached().max_simd_support;
+}
+
+void set_ntt_backend(SIMDSupport backend) {
+    const std::vector<SIMDSupport> backends = available_ntt_backends();
+    if (std::find(backends.begin(), backends.end(), backend) == backends.end()) {
+        throw std::invalid_argument(std::string("NTT backend not available: ") + ntt_backend_name(backend));
+    }
+    g_ntt_backend.store(backend, std::memory_order_relaxed);
+    g_ntt_backend_selected.store(true, std::memory_order_release);
+}
+
+bool ntt_backend_selected() {
+    return g_ntt_backend_selected.load(std::memory_order_acquire);
+}
+
+void reset_ntt_backend() {
+    g_ntt_backend_selected.store(false, std::memory_order_release);
+}
+
+const char* ntt_backend_name(SIMDSupport backend) {
+    switch (backend) {
+        case SIMDSupport::NONE: return "scalar";
+        case SIMDSupport::AVX2: return "avx2";
+        case SIMDSupport::AVX512: return "avx512";
+        case SIMDSupport::NEON: return "neon";
+        case SIMDSupport::SVE: return "sve";
+        case SIMDSupport::RVV: return "rvv";
+        case SIMDSupport::VSX: return "vsx";
+        case SIMDSupport::WASM_SIMD128: return "wasm_simd128";
+    }
+    return "unknown";
+}
 
 std::unique_ptr<NTTEngine> create_optimal_ntt_engine(uint32_t q, uint32_t n) {
-    CPUFeatures features = CPUFeatureDetector::detect();
-    return create_ntt_engine(features.max_simd_support, q, n);
+    return create_ntt_engine(ntt_backend(), q, n);
 }
 
 std::unique_ptr<NTTEngine> create_ntt_engine(SIMDSupport simd_support, uint32_t q, uint32_t n) {
     switch (simd_support) {
 #ifdef HAVE_NEON
+        case SIMDSupport::SVE:
+#ifdef HAVE_SVE
+            // A compiler without SVE support still leaves the NEON engine for SVE cores
+            return std::make_unique<SVENTTEngine>(q, n);
+#endif
         case SIMDSupport::NEON:
             return std::make_unique<NEONNTTEngine>(q, n);
 #endif
@@ -86,14 +246,36 @@ std::unique_ptr<NTTEngine> create_ntt_engine(SIMDSupport simd_support, uint32_t
         case SIMDSupport::RVV:
             return std::make_unique<RVVNTTEngine>(q, n);
 #endif
+#ifdef HAVE_VSX
+        case SIMDSupport::VSX:
+            return std::make_unique<VSXNTTEngine>(q, n);
+#endif
+#ifdef HAVE_WASM_SIMD128
+        case SIMDSupport::WASM_SIMD128:
+            return std::make_unique<WasmSIMD128NTTEngine>(q, n);
+#endif
 #ifdef HAVE_AVX2
         case SIMDSupport::AVX512:
+#ifdef HAVE_AVX512BW
+            // The AVX-512 engine needs BW; AVX-512F-only CPUs keep the AVX2 one
+            if (CPUFeatureDetector::cached().has_avx512bw) {
+                return std::make_unique<AVX512NTTEngine>(q, n);
+            }
+#endif
+            return std::make_unique<AVXNTTEngine>(q, n);
         case SIMDSupport::AVX2:
             return std::make_unique<AVXNTTEngine>(q, n);
 #endif
-        case SIMDSupport::VSX:
         case SIMDSupport::NONE:
         default:
+            // A vector backend without its hand-written engine in this build gets the portable one
+            if (simd_support != SIMDSupport::NONE && simd::NATIVE) {
+                return std::make_unique<PortableNTTEngine>(q, n);
+            }
+            // Shapes with a compile-time engine get it; the runtime-loop one covers the rest
+            if (auto unrolled = create_unrolled_ntt_engine(q, n)) {
+                return unrolled;
+            }
             return std::make_unique<ScalarNTTEngine>(q, n);
     }
 }
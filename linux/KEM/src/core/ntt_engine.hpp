@@ -2,6 +2,7 @@
 #define NTT_ENGINE_HPP
 
 #include "cpu_features.hpp"
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 #include <memory>
@@ -21,17 +22,42 @@ public:
     NTTEngine(const NTTEngine&) = delete;
     NTTEngine& operator=(const NTTEngine&) = delete;
 
-    // Pure virtual methods that must be implemented by derived classes
+    // Pure virtual methods that must be implemented by derived classes.
+    // ntt_forward maps natural order to bit-reversed order, ntt_inverse maps it back
+    // without the 1/n scaling, so inverse(forward(x)) == n * x and multiply() returns
+    // n * (a * b) mod (x^n - 1, q). Inputs and outputs are reduced mod q.
+    // Slot i of the NTT domain holds x(zeta^bitrev(i)). Pointwise ops do not care about the
+    // order, so no engine path runs a permutation pass.
     virtual void ntt_forward(uint32_t* poly) const = 0;
     virtual void ntt_inverse(uint32_t* poly) const = 0;
-    virtual void multiply(const uint32_t* a, const uint32_t* b, uint32_t* result) const = 0;
+    // a = multiply(a, b), transforming a and b where they lie: b is left in the NTT domain.
+    // Needs no scratch and does not allocate.
+    virtual void multiply_inplace(uint32_t* a, uint32_t* b) const = 0;
+    // multiply_inplace on copies in per-thread scratch that keeps its capacity, so steady-state
+    // calls do not allocate. Inputs may be unreduced; result may alias a or b.
+    virtual void multiply(const uint32_t* a, const uint32_t* b, uint32_t* result) const;
+
+    // Batched transforms over count polynomials stored back to back (count * n coefficients).
+    // The defaults loop over the single-polynomial calls; backends override them to run each
+    // stage across the whole batch in one pass.
+    virtual void ntt_forward_batch(uint32_t* polys, size_t count) const;
+    virtual void ntt_inverse_batch(uint32_t* polys, size_t count) const;
+    // out = sum_{j < k} a_j * b_j pointwise, where a and b hold k NTT-domain polynomials back
+    // to back. Inputs must be reduced mod q; out is reduced mod q.
+    virtual void basemul_acc(const uint32_t* a, const uint32_t* b, size_t k, uint32_t* out) const;
 
     // Virtual methods with default implementations
     virtual bool has_avx512() const { return false; }
     virtual SIMDSupport get_simd_support() const = 0;
 
+    // Constant coefficient of a * b mod (x^n - 1, q) in O(n), unscaled:
+    // a[0] * b[0] + sum_{j>0} a[j] * b[n - j]. Inputs must be reduced mod q.
+    virtual uint32_t constant_term_product(const uint32_t* a, const uint32_t* b) const;
+
     // Utility functions
-    virtual void bit_reverse(uint32_t* poly) const;
+    // Permutes between NTT-domain order and natural evaluation order (an involution), for
+    // callers that index evaluations by power of zeta. Not used by any transform.
+    void bit_reverse(uint32_t* poly) const;
     virtual void copy_from_uint32(const uint32_t* coeffs, uint32_t* ntt_coeffs) const;
     virtual void copy_to_uint32(const uint32_t* ntt_coeffs, uint32_t* coeffs) const;
 
@@ -44,15 +70,29 @@ protected:
     uint32_t q_;           // Modulus
     uint32_t n_;           // Degree (power of 2)
     uint32_t log_n_;       // log2(n_)
-    std::vector<uint32_t> bitrev_;  // Bit reversal table
 
-    // Precompute bit reversal table
-    void precompute_bitrev();
+    // Lazy-reduction backends track an upper bound on their coefficients between stages.
+    // Builds with CLWE_NTT_BOUND_CHECKS (Debug) verify every coefficient of the count
+    // polynomials is below bound and throw std::logic_error otherwise; release builds
+    // compile this to nothing.
+    void check_lazy_bound(const uint32_t* poly, uint64_t bound, size_t count = 1) const;
+
+    // True when k products of reduced residues sum below 2^32, so basemul_acc kernels can
+    // accumulate raw 32-bit products and reduce once per coefficient
+    bool lazy_accumulation_fits(size_t k) const {
+        return static_cast<uint64_t>(q_ - 1) * (q_ - 1) * k <= 0xFFFFFFFFULL;
+    }
 };
 
-// Factory function to create optimal NTT engine
+// Factory function to create optimal NTT engine: ntt_backend() (clwe/autotune.hpp), which is
+// the detected max_simd_support unless set_ntt_backend() chose another
 std::unique_ptr<NTTEngine> create_optimal_ntt_engine(uint32_t q, uint32_t n);
 
+// Whether set_ntt_backend() has chosen a backend, and back to the detected default as
+// before its first call
+bool ntt_backend_selected();
+void reset_ntt_backend();
+
 // Factory function to create specific NTT engine
 std::unique_ptr<NTTEngine> create_ntt_engine(SIMDSupport simd_support, uint32_t q, uint32_t n);
 
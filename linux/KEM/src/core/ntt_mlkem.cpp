@@ -0,0 +1,181 @@
+#include "ntt_mlkem.hpp"
+#include <array>
+
+namespace clwe {
+
+namespace {
+
+constexpr int32_t Q = MLKEMNTTEngine::MODULUS;
+constexpr uint32_t N = MLKEMNTTEngine::DEGREE;
+constexpr uint32_t ZETA = 17;                       // Primitive 256th root of unity mod q
+constexpr int16_t QINV = -3327;                     // q^(-1) mod 2^16, signed
+constexpr int32_t MONT = (1 << 16) % Q;             // R = 2^16 mod q
+constexpr int32_t MONT_SQ = MONT * MONT % Q;        // R^2 mod q
+constexpr int16_t INV_SCALE = (1 << 9) % Q;         // R / 128 mod q: fqmul by it divides by 128
+constexpr int16_t INV_SCALE_MONT = static_cast<int16_t>(MONT_SQ * 3303 % Q);  // R^2 / 128, 3303 = 128^(-1)
+constexpr int32_t BARRETT_V = ((1 << 26) + Q / 2) / Q;
+
+using Poly16 = std::array<int16_t, N>;
+
+// Montgomery form of zeta^BitRev7(i), centered in (-q/2, q/2]; entries 64..127 also serve
+// basemul, whose i-th pair uses +-zeta^(2 * BitRev7(i) + 1)
+constexpr std::array<int16_t, 128> make_zetas() {
+    std::array<int16_t, 128> zetas{};
+    for (uint32_t i = 0; i < 128; ++i) {
+        uint32_t rev = 0;
+        for (uint32_t bit = 0; bit < 7; ++bit) {
+            rev |= ((i >> bit) & 1) << (6 - bit);
+        }
+        int64_t power = 1;
+        for (uint32_t e = 0; e < rev; ++e) {
+            power = power * ZETA % Q;
+        }
+        int64_t mont = power * MONT % Q;
+        zetas[i] = static_cast<int16_t>(mont > Q / 2 ? mont - Q : mont);
+    }
+    return zetas;
+}
+
+constexpr std::array<int16_t, 128> ZETAS = make_zetas();
+
+// a * R^(-1) mod q in (-q, q), for |a| < q * 2^15
+inline int16_t montgomery_reduce(int32_t a) {
+    int16_t t = static_cast<int16_t>(static_cast<int16_t>(a) * QINV);
+    return static_cast<int16_t>((a - static_cast<int32_t>(t) * Q) >> 16);
+}
+
+inline int16_t fqmul(int16_t a, int16_t b) {
+    return montgomery_reduce(static_cast<int32_t>(a) * b);
+}
+
+// Centered representative in [-(q - 1) / 2, (q - 1) / 2]
+inline int16_t barrett_reduce(int16_t a) {
+    int16_t t = static_cast<int16_t>((BARRETT_V * a + (1 << 25)) >> 26);
+    return static_cast<int16_t>(a - t * Q);
+}
+
+inline uint32_t to_canonical(int16_t a) {
+    int16_t r = barrett_reduce(a);
+    r = static_cast<int16_t>(r + ((r >> 15) & Q));
+    return static_cast<uint32_t>(r);
+}
+
+// Cooley-Tukey layers with len = 128 .. 2; inputs |r| < q give outputs |r| < 8q
+void ntt16(int16_t* r) {
+    uint32_t k = 1;
+    for (uint32_t len = 128; len >= 2; len >>= 1) {
+        for (uint32_t start = 0; start < N; start += 2 * len) {
+            int16_t zeta = ZETAS[k++];
+            for (uint32_t j = start; j < start + len; ++j) {
+                int16_t t = fqmul(zeta, r[j + len]);
+                r[j + len] = static_cast<int16_t>(r[j] - t);
+                r[j] = static_cast<int16_t>(r[j] + t);
+            }
+        }
+    }
+}
+
+// Gentleman-Sande layers with len = 2 .. 128, then every coefficient times f * R^(-1)
+void invntt16(int16_t* r, int16_t f) {
+    uint32_t k = 127;
+    for (uint32_t len = 2; len <= 128; len <<= 1) {
+        for (uint32_t start = 0; start < N; start += 2 * len) {
+            int16_t zeta = ZETAS[k--];
+            for (uint32_t j = start; j < start + len; ++j) {
+                int16_t t = r[j];
+                r[j] = barrett_reduce(static_cast<int16_t>(t + r[j + len]));
+                r[j + len] = fqmul(zeta, static_cast<int16_t>(r[j + len] - t));
+            }
+        }
+    }
+    for (uint32_t j = 0; j < N; ++j) {
+        r[j] = fqmul(r[j], f);
+    }
+}
+
+// (a0 + a1 x)(b0 + b1 x) mod (x^2 - zeta), times R^(-1); each output in (-2q, 2q)
+inline void basemul_pair(int32_t& r0, int32_t& r1, int16_t a0, int16_t a1, int16_t b0, int16_t b1, int16_t zeta) {
+    r0 = static_cast<int32_t>(fqmul(fqmul(a1, b1), zeta)) + fqmul(a0, b0);
+    r1 = static_cast<int32_t>(fqmul(a0, b1)) + fqmul(a1, b0);
+}
+
+void load(const uint32_t* in, int16_t* out) {
+    for (uint32_t i = 0; i < N; ++i) {
+        out[i] = static_cast<int16_t>(in[i]);
+    }
+}
+
+} // namespace
+
+void MLKEMNTTEngine::ntt_forward(uint32_t* poly) const {
+    Poly16 r;
+    load(poly, r.data());
+    ntt16(r.data());
+    for (uint32_t i = 0; i < N; ++i) {
+        poly[i] = to_canonical(r[i]);
+    }
+}
+
+void MLKEMNTTEngine::ntt_inverse(uint32_t* poly) const {
+    Poly16 r;
+    load(poly, r.data());
+    invntt16(r.data(), INV_SCALE);
+    for (uint32_t i = 0; i < N; ++i) {
+        poly[i] = to_canonical(r[i]);
+    }
+}
+
+void MLKEMNTTEngine::basemul(const uint32_t* a, const uint32_t* b, uint32_t* result) const {
+    basemul_acc(a, b, 1, result);
+}
+
+void MLKEMNTTEngine::basemul_acc(const uint32_t* a, const uint32_t* b, size_t k, uint32_t* out) const {
+    for (uint32_t i = 0; i < N / 2; ++i) {
+        // Pair i reduces mod x^2 - zeta^(2 * BitRev7(i) + 1); pairs 2m and 2m + 1 use +-ZETAS[64 + m]
+        int16_t zeta = (i & 1) ? static_cast<int16_t>(-ZETAS[64 + i / 2]) : ZETAS[64 + i / 2];
+        int64_t acc0 = 0;
+        int64_t acc1 = 0;
+        for (size_t j = 0; j < k; ++j) {
+            const uint32_t* aj = a + j * N + 2 * i;
+            const uint32_t* bj = b + j * N + 2 * i;
+            int32_t r0;
+            int32_t r1;
+            basemul_pair(r0, r1, static_cast<int16_t>(aj[0]), static_cast<int16_t>(aj[1]),
+                         static_cast<int16_t>(bj[0]), static_cast<int16_t>(bj[1]), zeta);
+            acc0 += r0;
+            acc1 += r1;
+        }
+        // The sums carry R^(-1); a Montgomery product with R^2 cancels it
+        out[2 * i] = to_canonical(fqmul(static_cast<int16_t>(acc0 % Q), static_cast<int16_t>(MONT_SQ)));
+        out[2 * i + 1] = to_canonical(fqmul(static_cast<int16_t>(acc1 % Q), static_cast<int16_t>(MONT_SQ)));
+    }
+}
+
+void MLKEMNTTEngine::multiply(const uint32_t* a, const uint32_t* b, uint32_t* result) const {
+    Poly16 a16;
+    Poly16 b16;
+    load(a, a16.data());
+    load(b, b16.data());
+    ntt16(a16.data());
+    ntt16(b16.data());
+    for (uint32_t i = 0; i < N; ++i) {
+        a16[i] = barrett_reduce(a16[i]);
+        b16[i] = barrett_reduce(b16[i]);
+    }
+
+    // The basemul outputs keep their R^(-1); the inverse scale R^2 / 128 absorbs it
+    for (uint32_t i = 0; i < N / 2; ++i) {
+        int16_t zeta = (i & 1) ? static_cast<int16_t>(-ZETAS[64 + i / 2]) : ZETAS[64 + i / 2];
+        int32_t r0;
+        int32_t r1;
+        basemul_pair(r0, r1, a16[2 * i], a16[2 * i + 1], b16[2 * i], b16[2 * i + 1], zeta);
+        a16[2 * i] = static_cast<int16_t>(r0 % Q);
+        a16[2 * i + 1] = static_cast<int16_t>(r1 % Q);
+    }
+    invntt16(a16.data(), INV_SCALE_MONT);
+    for (uint32_t i = 0; i < N; ++i) {
+        result[i] = to_canonical(a16[i]);
+    }
+}
+
+} // namespace clwe
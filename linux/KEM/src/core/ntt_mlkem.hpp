@@ -0,0 +1,42 @@
+#ifndef NTT_MLKEM_HPP
+#define NTT_MLKEM_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace clwe {
+
+// FIPS 203 transform over Z_q[x]/(x^256 + 1) with q = 3329. A 256-point negacyclic NTT would
+// need a 512th root of unity, which Z_3329 lacks, so this stops after 7 layers at 128 residues
+// mod (x^2 - zeta^(2 * BitRev7(i) + 1)), zeta = 17, and multiplies those degree-1 pairs with
+// basemul. Values in the NTT domain are exactly FIPS 203 NTT(f), so they interoperate with
+// other ML-KEM implementations.
+//
+// This is a separate mode from NTTEngine, whose engines work in the cyclic ring x^n - 1 and
+// leave inverse transforms unscaled. Internally it runs the reference int16 Montgomery
+// butterflies; every input and output is reduced mod q.
+class MLKEMNTTEngine {
+public:
+    static constexpr uint32_t MODULUS = 3329;
+    static constexpr uint32_t DEGREE = 256;
+
+    MLKEMNTTEngine() = default;
+
+    // Natural order -> NTT domain (FIPS 203 Algorithm 9)
+    void ntt_forward(uint32_t* poly) const;
+    // NTT domain -> natural order, scaled by 1/128, so inverse(forward(x)) == x (Algorithm 10)
+    void ntt_inverse(uint32_t* poly) const;
+    // result = a o b in the NTT domain, the 128 degree-1 products (Algorithms 11 and 12)
+    void basemul(const uint32_t* a, const uint32_t* b, uint32_t* result) const;
+    // out = sum_{j < k} a_j o b_j, where a and b hold k NTT-domain polynomials back to back
+    void basemul_acc(const uint32_t* a, const uint32_t* b, size_t k, uint32_t* out) const;
+    // result = a * b mod (x^256 + 1, q), unscaled; result may alias a or b
+    void multiply(const uint32_t* a, const uint32_t* b, uint32_t* result) const;
+
+    uint32_t modulus() const { return MODULUS; }
+    uint32_t degree() const { return DEGREE; }
+};
+
+} // namespace clwe
+
+#endif // NTT_MLKEM_HPP
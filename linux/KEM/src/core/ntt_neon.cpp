@@ -1,272 +1,649 @@
 #include "ntt_neon.hpp"
+#include "ntt_tables.hpp"
 #include "utils.hpp"
 #include <algorithm>
-#include <iostream>
-#include <cstring>
+
+// Value ranges on the 16-bit path, for odd 2^11 < q < 2^13 (as in ntt_avx512.cpp):
+//   montgomery(x, z) with |x| < 2^15 and |z| <= q lies in (-q, q);
+//   barrett(x) with |x| < 4q lies in (-q, 2q) and is congruent to x.
+// Butterfly inputs therefore stay in (-q, 2q), sums and differences below 4q < 2^15, and the
+// final pass maps (-q, 2q) onto the canonical [0, q) the scalar engine produces.
 
 namespace clwe {
 
-NEONNTTEngine::NEONNTTEngine(uint32_t q, uint32_t n)
-    : NTTEngine(q, n), zetas_(nullptr), zetas_inv_(nullptr),
-      montgomery_r_(0), montgomery_r_inv_(0) {
+namespace {
+constexpr uint32_t NEON_LANES = 4;
+// Coefficients per cache tile (4 KiB), matching ScalarNTTEngine
+constexpr uint32_t NTT_TILE_COEFFS = 1024;
 
-#ifdef HAVE_NEON
-    // NEON: 4 uint32_t per uint32x4_t
-    size_t neon_count = n / 4;
-    zetas_ = new uint32x4_t[neon_count];
-    zetas_inv_ = new uint32x4_t[neon_count];
-#endif
+uint32_t log2_of(uint32_t k) {
+    uint32_t log = 0;
+    while ((1u << log) < k) {
+        ++log;
+    }
+    return log;
+}
 
-    // Pre-compute Montgomery constants
-    montgomery_r_ = (1ULL << 32) % q_;
-    // QINV for q=3329 is 62209
-    montgomery_r_inv_ = 62209;
+#ifdef HAVE_NEON
+struct Constants16 {
+    int16x8_t q;
+    int16x8_t v;
+};
+
+// a * z * 2^-16 with z in Montgomery form and zqinv = z * q^-1 mod 2^16 precomputed.
+// vqdmulh doubles the high halves; they differ by an even amount, so one halving
+// subtract gives the exact quotient.
+inline int16x8_t montgomery(int16x8_t a, int16x8_t z, int16x8_t zqinv, const Constants16& c) {
+    int16x8_t hi = vqdmulhq_s16(a, z);
+    int16x8_t m = vmulq_s16(a, zqinv);
+    return vhsubq_s16(hi, vqdmulhq_s16(m, c.q));
+}
 
-    precompute_zetas();
+// floor(a * v / 2^26) as the quotient: vqdmulh yields floor(a * v / 2^15)
+inline int16x8_t barrett(int16x8_t a, const Constants16& c) {
+    int16x8_t t = vshrq_n_s16(vqdmulhq_s16(a, c.v), 11);
+    return vmlsq_s16(a, t, c.q);
 }
 
-NEONNTTEngine::~NEONNTTEngine() {
-#ifdef HAVE_NEON
-    if (zetas_) delete[] zetas_;
-    if (zetas_inv_) delete[] zetas_inv_;
-#endif
+// (-q, 2q) -> [0, q)
+inline int16x8_t canonical(int16x8_t a, const Constants16& c) {
+    a = vaddq_s16(a, vandq_s16(vshrq_n_s16(a, 15), c.q));
+    return vsubq_s16(a, vandq_s16(vreinterpretq_s16_u16(vcgeq_s16(a, c.q)), c.q));
 }
 
-void NEONNTTEngine::precompute_zetas() {
-    // Precompute primitive n-th root of unity
-    uint32_t g = 17;  // Primitive root for q = 3329 (Kyber modulus)
-    uint32_t zeta = mod_pow(g, (q_ - 1) / n_, q_);
-    uint32_t zeta_mont = montgomery_reduce(zeta);
+// 8 reduced uint32 coefficients -> one register of int16
+inline int16x8_t load_narrow(const uint32_t* in) {
+    return vreinterpretq_s16_u16(vcombine_u16(vmovn_u32(vld1q_u32(in)), vmovn_u32(vld1q_u32(in + 4))));
+}
 
-    std::vector<uint32_t> zetas_scalar(n_);
-    std::vector<uint32_t> zetas_inv_scalar(n_);
+inline void store_widen(uint32_t* out, int16x8_t v) {
+    uint16x8_t u = vreinterpretq_u16_s16(v);
+    vst1q_u32(out, vmovl_u16(vget_low_u16(u)));
+    vst1q_u32(out + 4, vmovl_u16(vget_high_u16(u)));
+}
 
-    zetas_scalar[0] = 1;
-    for (uint32_t i = 1; i < n_; ++i) {
-        zetas_scalar[i] = montgomery_reduce(static_cast<uint64_t>(zetas_scalar[i-1]) * zeta_mont);
+// Two registers x, y hold 16 coefficients; for half-length k < 8 this swaps them with the
+// first elements of every butterfly (x) and the second elements (y), lane l of x pairing
+// with lane l of y and using twiddle l mod k. The transform is its own inverse.
+inline void transpose_pairs(uint32_t k, int16x8_t& x, int16x8_t& y) {
+    int16x8_t a, b;
+    if (k == 4) {
+        a = vreinterpretq_s16_s64(vzip1q_s64(vreinterpretq_s64_s16(x), vreinterpretq_s64_s16(y)));
+        b = vreinterpretq_s16_s64(vzip2q_s64(vreinterpretq_s64_s16(x), vreinterpretq_s64_s16(y)));
+    } else if (k == 2) {
+        a = vreinterpretq_s16_s32(vtrn1q_s32(vreinterpretq_s32_s16(x), vreinterpretq_s32_s16(y)));
+        b = vreinterpretq_s16_s32(vtrn2q_s32(vreinterpretq_s32_s16(x), vreinterpretq_s32_s16(y)));
+    } else {
+        a = vtrn1q_s16(x, y);
+        b = vtrn2q_s16(x, y);
     }
+    x = a;
+    y = b;
+}
+#endif
+} // namespace
 
-    // Inverse zetas for inverse NTT
-    uint32_t zeta_inv = mod_inverse(zeta, q_);
-    uint32_t zeta_inv_mont = montgomery_reduce(zeta_inv);
-    zetas_inv_scalar[0] = 1;
-    for (uint32_t i = 1; i < n_; ++i) {
-        zetas_inv_scalar[i] = montgomery_reduce(static_cast<uint64_t>(zetas_inv_scalar[i-1]) * zeta_inv_mont);
+NEONNTTEngine::NEONNTTEngine(uint32_t q, uint32_t n)
+    : NTTEngine(q, n),
+      barrett_m_(static_cast<uint32_t>((1ULL << 32) / q)),
+      vector_path_(q < (1u << 16)),
+      lazy_limit_(static_cast<uint32_t>(0xFFFFFFFFULL / (static_cast<uint64_t>(q) * q))),
+      qinv_(static_cast<int16_t>(inverse_mod_2_16(q))),
+      barrett_v_(q > 2048 && q < 8192 ? static_cast<int16_t>(((1u << 26) + q / 2) / q) : 0),
+#ifdef HAVE_NEON
+      vector_path16_((q & 1) && q > 2048 && q < 8192 && n >= 2 * LANES16 && n <= MAX_VECTOR_DEGREE) {
+#else
+      vector_path16_(false) {
+#endif
+    NTTTableView tables = ntt_tables(q, n);
+    zetas_ = tables.zetas;
+    zetas_inv_ = tables.zetas_inv;
+    stage_zetas_ = tables.stage_zetas;
+    stage_zetas_inv_ = tables.stage_zetas_inv;
+    if (!vector_path16_) {
+        return;
     }
 
+    NTTMontgomeryTableView montgomery = ntt_montgomery_tables(q, n, LANES16);
+    fwd_zetas_ = montgomery.fwd_zetas;
+    fwd_zetas_qinv_ = montgomery.fwd_zetas_qinv;
+    inv_zetas_ = montgomery.inv_zetas;
+    inv_zetas_qinv_ = montgomery.inv_zetas_qinv;
+    stage_offsets_ = montgomery.stage_offsets;
+}
+
+uint32_t NEONNTTEngine::mod_mul(uint32_t a, uint32_t b) const {
+    return static_cast<uint32_t>((static_cast<uint64_t>(a) * b) % q_);
+}
+
+uint32_t NEONNTTEngine::reduce(uint32_t x) const {
+    uint32_t t = static_cast<uint32_t>((static_cast<uint64_t>(x) * barrett_m_) >> 32);
+    uint32_t r = x - t * q_;
+    return r - (q_ & -(uint32_t)(r >= q_));
+}
+
+void NEONNTTEngine::reduce_all(uint32_t* poly, size_t len) const {
+    size_t i = 0;
 #ifdef HAVE_NEON
-    // Pack into NEON vectors (4 values per vector)
-    for (uint32_t i = 0; i < n_; i += 4) {
-        uint32_t vals[4];
-        uint32_t vals_inv[4];
-        for (int j = 0; j < 4 && i + j < n_; ++j) {
-            vals[j] = zetas_scalar[i + j];
-            vals_inv[j] = zetas_inv_scalar[i + j];
-        }
-        zetas_[i/4] = vld1q_u32(vals);
-        zetas_inv_[i/4] = vld1q_u32(vals_inv);
+    for (; i + NEON_LANES <= len; i += NEON_LANES) {
+        vst1q_u32(poly + i, reduce_neon(vld1q_u32(poly + i)));
     }
 #endif
+    for (; i < len; ++i) {
+        poly[i] = reduce(poly[i]);
+    }
 }
 
-void NEONNTTEngine::butterfly_neon(uint32x4_t& a, uint32x4_t& b, uint32x4_t zeta) const {
-#ifdef HAVE_NEON
-    // NEON butterfly: a, b = a + b, (a - b) * zeta
-    uint32x4_t sum = vaddq_u32(a, b);
-    uint32x4_t diff = vsubq_u32(a, b);
-    // Constant-time modular subtraction: if underflow, add q
-    uint32x4_t underflow = vcltq_u32(a, b);
-    uint32x4_t q_vec = vdupq_n_u32(q_);
-    uint32x4_t add_q = vbslq_u32(underflow, q_vec, vdupq_n_u32(0));
-    diff = vaddq_u32(diff, add_q);
-    uint32x4_t prod = montgomery_multiply_neon(diff, zeta);
+void NEONNTTEngine::butterfly(uint32_t& a, uint32_t& b, uint32_t zeta) const {
+    uint32_t sum = a + b;
+    uint32_t reduce_mask = - (uint32_t)(sum >= q_);
+    sum -= reduce_mask & q_;
+    uint32_t diff = a - b;
+    uint32_t borrow_mask = - (uint32_t)(a < b);
+    diff += borrow_mask & q_;
     a = sum;
-    b = prod;
-#endif
+    b = mod_mul(diff, zeta);
 }
 
-void NEONNTTEngine::butterfly_inv_neon(uint32x4_t& a, uint32x4_t& b, uint32x4_t zeta) const {
-    // Same as forward for inverse (zeta is already inverse)
-    butterfly_neon(a, b, zeta);
+void NEONNTTEngine::butterfly_inv(uint32_t& a, uint32_t& b, uint32_t zeta) const {
+    uint32_t t = mod_mul(b, zeta);
+    uint32_t diff = a - t;
+    uint32_t borrow_mask = - (uint32_t)(a < t);
+    diff += borrow_mask & q_;
+    uint32_t sum = a + t;
+    uint32_t reduce_mask = - (uint32_t)(sum >= q_);
+    sum -= reduce_mask & q_;
+    a = sum;
+    b = diff;
 }
 
-uint32x4_t NEONNTTEngine::mod_reduce_neon(uint32x4_t val) const {
 #ifdef HAVE_NEON
-    uint32x4_t q_vec = vdupq_n_u32(q_);
-    uint32x4_t mask = vcgeq_u32(val, q_vec);
-    uint32x4_t sub = vbslq_u32(mask, q_vec, vdupq_n_u32(0));
-    return vsubq_u32(val, sub);
-#else
-    return val;  // Should not reach here
+uint32x4_t NEONNTTEngine::add_mod_neon(uint32x4_t a, uint32x4_t b) const {
+    const uint32x4_t q_vec = vdupq_n_u32(q_);
+    uint32x4_t sum = vaddq_u32(a, b);
+    // sum - q wraps around exactly when sum < q, so the unsigned min picks the reduced value
+    return vminq_u32(sum, vsubq_u32(sum, q_vec));
+}
+
+uint32x4_t NEONNTTEngine::sub_mod_neon(uint32x4_t a, uint32x4_t b) const {
+    const uint32x4_t q_vec = vdupq_n_u32(q_);
+    uint32x4_t diff = vaddq_u32(vsubq_u32(a, b), q_vec);
+    return vminq_u32(diff, vsubq_u32(diff, q_vec));
+}
+
+uint32x4_t NEONNTTEngine::mul_mod_neon(uint32x4_t a, uint32x4_t b) const {
+    const uint32x4_t q_vec = vdupq_n_u32(q_);
+    const uint32x2_t m_vec = vdup_n_u32(barrett_m_);
+
+    // a, b < q < 2^16, so the full product fits in 32 bits
+    uint32x4_t prod = vmulq_u32(a, b);
+
+    // Barrett quotient floor(prod * m / 2^32), widened per half
+    uint32x2_t t_low = vshrn_n_u64(vmull_u32(vget_low_u32(prod), m_vec), 32);
+    uint32x2_t t_high = vshrn_n_u64(vmull_u32(vget_high_u32(prod), m_vec), 32);
+    uint32x4_t t = vcombine_u32(t_low, t_high);
+
+    // The quotient is at most one short, leaving r < 2q
+    uint32x4_t r = vmlsq_u32(prod, t, q_vec);
+    return vminq_u32(r, vsubq_u32(r, q_vec));
+}
+
+uint32x4_t NEONNTTEngine::reduce_neon(uint32x4_t x) const {
+    const uint32x4_t q_vec = vdupq_n_u32(q_);
+    const uint32x2_t m_vec = vdup_n_u32(barrett_m_);
+    uint32x2_t t_low = vshrn_n_u64(vmull_u32(vget_low_u32(x), m_vec), 32);
+    uint32x2_t t_high = vshrn_n_u64(vmull_u32(vget_high_u32(x), m_vec), 32);
+    uint32x4_t r = vmlsq_u32(x, vcombine_u32(t_low, t_high), q_vec);
+    return vminq_u32(r, vsubq_u32(r, q_vec));
+}
 #endif
+
+uint32_t NEONNTTEngine::tile_size() const {
+    return std::min(n_, NTT_TILE_COEFFS);
 }
 
-uint32_t NEONNTTEngine::montgomery_reduce(uint64_t val) const {
-    // Montgomery reduction: optimized Kyber version
-    uint64_t t = val * montgomery_r_inv_;
-    t &= (1ULL << 32) - 1;
-    t *= q_;
-    return (val + t) >> 32;
+// Lazy DIF stages [first, last) on block[0, len); see ScalarNTTEngine::forward_layers for the bounds
+void NEONNTTEngine::forward_layers(uint32_t* block, size_t len, uint32_t first, uint32_t last,
+                                   uint32_t& bound) const {
+    uint32_t s = first;
+    while (s < last) {
+        const uint32_t k = n_ >> (s + 1);
+        const uint32_t* z_outer = stage_zetas_ + (n_ - 2 * k);
+        if (s + 1 < last && lazy_limit_ >= 4) {
+            if (4 * bound > lazy_limit_) {
+                reduce_all(block, len);
+                bound = 1;
+            }
+            const uint32_t h = k / 2;
+            const uint32_t* z_inner = stage_zetas_ + (n_ - k);
+            const uint32_t offset1 = bound * q_;
+            const uint32_t offset2 = 2 * bound * q_;
+            for (size_t start = 0; start < len; start += 2 * k) {
+                uint32_t* p = block + start;
+                uint32_t i = 0;
+#ifdef HAVE_NEON
+                const uint32x4_t off1 = vdupq_n_u32(offset1);
+                const uint32x4_t off2 = vdupq_n_u32(offset2);
+                for (; i + NEON_LANES <= h; i += NEON_LANES) {
+                    uint32x4_t x0 = vld1q_u32(p + i);
+                    uint32x4_t x1 = vld1q_u32(p + i + h);
+                    uint32x4_t x2 = vld1q_u32(p + i + k);
+                    uint32x4_t x3 = vld1q_u32(p + i + k + h);
+                    uint32x4_t y0 = vaddq_u32(x0, x2);
+                    uint32x4_t y2 = reduce_neon(vmulq_u32(vsubq_u32(vaddq_u32(x0, off1), x2), vld1q_u32(z_outer + i)));
+                    uint32x4_t y1 = vaddq_u32(x1, x3);
+                    uint32x4_t y3 = reduce_neon(vmulq_u32(vsubq_u32(vaddq_u32(x1, off1), x3), vld1q_u32(z_outer + i + h)));
+                    const uint32x4_t w = vld1q_u32(z_inner + i);
+                    vst1q_u32(p + i, vaddq_u32(y0, y1));
+                    vst1q_u32(p + i + h, reduce_neon(vmulq_u32(vsubq_u32(vaddq_u32(y0, off2), y1), w)));
+                    vst1q_u32(p + i + k, vaddq_u32(y2, y3));
+                    vst1q_u32(p + i + k + h, reduce_neon(vmulq_u32(vsubq_u32(vaddq_u32(y2, off2), y3), w)));
+                }
+#endif
+                for (; i < h; ++i) {
+                    uint32_t x0 = p[i], x1 = p[i + h], x2 = p[i + k], x3 = p[i + k + h];
+                    uint32_t y0 = x0 + x2;
+                    uint32_t y2 = reduce((x0 + offset1 - x2) * z_outer[i]);
+                    uint32_t y1 = x1 + x3;
+                    uint32_t y3 = reduce((x1 + offset1 - x3) * z_outer[i + h]);
+                    const uint32_t w = z_inner[i];
+                    p[i] = y0 + y1;
+                    p[i + h] = reduce((y0 + offset2 - y1) * w);
+                    p[i + k] = y2 + y3;
+                    p[i + k + h] = reduce((y2 + offset2 - y3) * w);
+                }
+            }
+            bound *= 4;
+            s += 2;
+        } else {
+            if (2 * bound > lazy_limit_) {
+                reduce_all(block, len);
+                bound = 1;
+            }
+            const uint32_t offset = bound * q_;
+            for (size_t start = 0; start < len; start += 2 * k) {
+                uint32_t* p = block + start;
+                uint32_t i = 0;
+#ifdef HAVE_NEON
+                const uint32x4_t offset_vec = vdupq_n_u32(offset);
+                for (; i + NEON_LANES <= k; i += NEON_LANES) {
+                    uint32x4_t a = vld1q_u32(p + i);
+                    uint32x4_t b = vld1q_u32(p + i + k);
+                    uint32x4_t diff = vsubq_u32(vaddq_u32(a, offset_vec), b);
+                    vst1q_u32(p + i, vaddq_u32(a, b));
+                    vst1q_u32(p + i + k, reduce_neon(vmulq_u32(diff, vld1q_u32(z_outer + i))));
+                }
+#endif
+                for (; i < k; ++i) {
+                    uint32_t a = p[i];
+                    uint32_t b = p[i + k];
+                    p[i] = a + b;
+                    p[i + k] = reduce((a + offset - b) * z_outer[i]);
+                }
+            }
+            bound *= 2;
+            s += 1;
+        }
+    }
 }
 
+// Lazy DIT stages with half-lengths k_first, 2 * k_first, ... below k_end on block[0, len)
+void NEONNTTEngine::inverse_layers(uint32_t* block, size_t len, uint32_t k_first, uint32_t k_end,
+                                   uint32_t& bound) const {
+    uint32_t k = k_first;
+    while (k < k_end) {
+        const uint32_t* z_inner = stage_zetas_inv_ + (n_ - 2 * k);
+        if (2 * k < k_end) {
+            if (bound + 1 > lazy_limit_) {
+                reduce_all(block, len);
+                bound = 1;
+            }
+            const uint32_t* z_outer = stage_zetas_inv_ + (n_ - 4 * k);
+            for (size_t start = 0; start < len; start += 4 * k) {
+                uint32_t* p = block + start;
+                uint32_t i = 0;
+#ifdef HAVE_NEON
+                const uint32x4_t q_vec = vdupq_n_u32(q_);
+                for (; i + NEON_LANES <= k; i += NEON_LANES) {
+                    const uint32x4_t w = vld1q_u32(z_inner + i);
+                    uint32x4_t x0 = vld1q_u32(p + i);
+                    uint32x4_t x2 = vld1q_u32(p + i + 2 * k);
+                    uint32x4_t t = reduce_neon(vmulq_u32(vld1q_u32(p + i + k), w));
+                    uint32x4_t y0 = vaddq_u32(x0, t);
+                    uint32x4_t y1 = vsubq_u32(vaddq_u32(x0, q_vec), t);
+                    t = reduce_neon(vmulq_u32(vld1q_u32(p + i + 3 * k), w));
+                    uint32x4_t y2 = vaddq_u32(x2, t);
+                    uint32x4_t y3 = vsubq_u32(vaddq_u32(x2, q_vec), t);
+                    t = reduce_neon(vmulq_u32(y2, vld1q_u32(z_outer + i)));
+                    vst1q_u32(p + i, vaddq_u32(y0, t));
+                    vst1q_u32(p + i + 2 * k, vsubq_u32(vaddq_u32(y0, q_vec), t));
+                    t = reduce_neon(vmulq_u32(y3, vld1q_u32(z_outer + i + k)));
+                    vst1q_u32(p + i + k, vaddq_u32(y1, t));
+                    vst1q_u32(p + i + 3 * k, vsubq_u32(vaddq_u32(y1, q_vec), t));
+                }
+#endif
+                for (; i < k; ++i) {
+                    const uint32_t w = z_inner[i];
+                    uint32_t t = reduce(p[i + k] * w);
+                    uint32_t y0 = p[i] + t;
+                    uint32_t y1 = p[i] + q_ - t;
+                    t = reduce(p[i + 3 * k] * w);
+                    uint32_t y2 = p[i + 2 * k] + t;
+                    uint32_t y3 = p[i + 2 * k] + q_ - t;
+                    t = reduce(y2 * z_outer[i]);
+                    p[i] = y0 + t;
+                    p[i + 2 * k] = y0 + q_ - t;
+                    t = reduce(y3 * z_outer[i + k]);
+                    p[i + k] = y1 + t;
+                    p[i + 3 * k] = y1 + q_ - t;
+                }
+            }
+            bound += 2;
+            k *= 4;
+        } else {
+            if (bound > lazy_limit_) {
+                reduce_all(block, len);
+                bound = 1;
+            }
+            for (size_t start = 0; start < len; start += 2 * k) {
+                uint32_t* p = block + start;
+                uint32_t i = 0;
+#ifdef HAVE_NEON
+                const uint32x4_t q_vec = vdupq_n_u32(q_);
+                for (; i + NEON_LANES <= k; i += NEON_LANES) {
+                    uint32x4_t a = vld1q_u32(p + i);
+                    uint32x4_t t = reduce_neon(vmulq_u32(vld1q_u32(p + i + k), vld1q_u32(z_inner + i)));
+                    vst1q_u32(p + i, vaddq_u32(a, t));
+                    vst1q_u32(p + i + k, vsubq_u32(vaddq_u32(a, q_vec), t));
+                }
+#endif
+                for (; i < k; ++i) {
+                    uint32_t a = p[i];
+                    uint32_t t = reduce(p[i + k] * z_inner[i]);
+                    p[i] = a + t;
+                    p[i + k] = a + q_ - t;
+                }
+            }
+            bound += 1;
+            k *= 2;
+        }
+    }
+}
 
-uint32x4_t NEONNTTEngine::montgomery_reduce_neon(uint32x4_t val) const {
+void NEONNTTEngine::forward16(uint32_t* poly) const {
 #ifdef HAVE_NEON
-    uint32x4_t qinv = vdupq_n_u32(montgomery_r_inv_);
-    uint32x4_t q = vdupq_n_u32(q_);
-    uint32x4_t t = vmulq_u32(val, qinv);
-    uint32x4_t m = vmulq_u32(t, q);
-    uint64x2_t sum_low = vaddl_u32(vget_low_u32(val), vget_low_u32(m));
-    uint64x2_t sum_high = vaddl_u32(vget_high_u32(val), vget_high_u32(m));
-    uint32x2_t res_low = vshrn_n_u64(sum_low, 32);
-    uint32x2_t res_high = vshrn_n_u64(sum_high, 32);
-    return vcombine_u32(res_low, res_high);
+    const Constants16 c = {vdupq_n_s16(static_cast<int16_t>(q_)), vdupq_n_s16(barrett_v_)};
+    alignas(16) int16_t work[MAX_VECTOR_DEGREE];
+    for (uint32_t i = 0; i < n_; i += LANES16) {
+        vst1q_s16(work + i, load_narrow(poly + i));
+    }
+
+    // Decimation in frequency: (a, b) -> (a + b, (a - b) * zeta), whole registers first
+    for (uint32_t k = n_ / 2; k >= LANES16; k /= 2) {
+        const int16_t* z = fwd_zetas_ + stage_offsets_[log2_of(k)];
+        const int16_t* zq = fwd_zetas_qinv_ + stage_offsets_[log2_of(k)];
+        for (uint32_t start = 0; start < n_; start += 2 * k) {
+            for (uint32_t i = 0; i < k; i += LANES16) {
+                int16x8_t a = vld1q_s16(work + start + i);
+                int16x8_t b = vld1q_s16(work + start + i + k);
+                vst1q_s16(work + start + i, barrett(vaddq_s16(a, b), c));
+                vst1q_s16(work + start + i + k, montgomery(vsubq_s16(a, b), vld1q_s16(z + i), vld1q_s16(zq + i), c));
+            }
+        }
+    }
+
+    // k = 4, 2, 1 on 16 coefficients held in two registers, written back canonical
+    int16x8_t z[3], zq[3];
+    for (uint32_t s = 0; s < 3; ++s) {
+        z[s] = vld1q_s16(fwd_zetas_ + stage_offsets_[2 - s]);
+        zq[s] = vld1q_s16(fwd_zetas_qinv_ + stage_offsets_[2 - s]);
+    }
+    for (uint32_t i = 0; i < n_; i += 2 * LANES16) {
+        int16x8_t x = vld1q_s16(work + i);
+        int16x8_t y = vld1q_s16(work + i + LANES16);
+        for (uint32_t s = 0; s < 3; ++s) {
+            const uint32_t k = 4 >> s;
+            transpose_pairs(k, x, y);
+            int16x8_t sum = barrett(vaddq_s16(x, y), c);
+            int16x8_t diff = montgomery(vsubq_s16(x, y), z[s], zq[s], c);
+            transpose_pairs(k, sum, diff);
+            x = sum;
+            y = diff;
+        }
+        store_widen(poly + i, canonical(x, c));
+        store_widen(poly + i + LANES16, canonical(y, c));
+    }
 #else
-    return val;  // Should not reach here
+    (void)poly;
 #endif
 }
 
-uint32x4_t NEONNTTEngine::montgomery_multiply_neon(uint32x4_t a, uint32x4_t b) const {
+void NEONNTTEngine::inverse16(uint32_t* poly) const {
 #ifdef HAVE_NEON
-    uint32x4_t prod = vmulq_u32(a, b);
-    return montgomery_reduce_neon(prod);
+    const Constants16 c = {vdupq_n_s16(static_cast<int16_t>(q_)), vdupq_n_s16(barrett_v_)};
+    alignas(16) int16_t work[MAX_VECTOR_DEGREE];
+
+    // Decimation in time: (a, b) -> (a + b * zeta, a - b * zeta); k = 1, 2, 4 in registers
+    int16x8_t z[3], zq[3];
+    for (uint32_t s = 0; s < 3; ++s) {
+        z[s] = vld1q_s16(inv_zetas_ + stage_offsets_[s]);
+        zq[s] = vld1q_s16(inv_zetas_qinv_ + stage_offsets_[s]);
+    }
+    for (uint32_t i = 0; i < n_; i += 2 * LANES16) {
+        int16x8_t x = load_narrow(poly + i);
+        int16x8_t y = load_narrow(poly + i + LANES16);
+        for (uint32_t s = 0; s < 3; ++s) {
+            const uint32_t k = 1u << s;
+            transpose_pairs(k, x, y);
+            int16x8_t t = montgomery(y, z[s], zq[s], c);
+            int16x8_t sum = barrett(vaddq_s16(x, t), c);
+            int16x8_t diff = barrett(vsubq_s16(x, t), c);
+            transpose_pairs(k, sum, diff);
+            x = sum;
+            y = diff;
+        }
+        vst1q_s16(work + i, x);
+        vst1q_s16(work + i + LANES16, y);
+    }
+
+    for (uint32_t k = LANES16; k < n_; k *= 2) {
+        const int16_t* zk = inv_zetas_ + stage_offsets_[log2_of(k)];
+        const int16_t* zqk = inv_zetas_qinv_ + stage_offsets_[log2_of(k)];
+        for (uint32_t start = 0; start < n_; start += 2 * k) {
+            for (uint32_t i = 0; i < k; i += LANES16) {
+                int16x8_t a = vld1q_s16(work + start + i);
+                int16x8_t t = montgomery(vld1q_s16(work + start + i + k), vld1q_s16(zk + i), vld1q_s16(zqk + i), c);
+                vst1q_s16(work + start + i, barrett(vaddq_s16(a, t), c));
+                vst1q_s16(work + start + i + k, barrett(vsubq_s16(a, t), c));
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < n_; i += LANES16) {
+        store_widen(poly + i, canonical(vld1q_s16(work + i), c));
+    }
 #else
-    return vmulq_u32(a, b);  // Should not reach here
+    (void)poly;
 #endif
 }
 
 void NEONNTTEngine::ntt_forward(uint32_t* poly) const {
-#ifdef HAVE_NEON
-    // NEON-optimized NTT implementation
+    ntt_forward_batch(poly, 1);
+}
+
+void NEONNTTEngine::ntt_forward_batch(uint32_t* poly, size_t count) const {
+    // Decimation-in-frequency NTT, natural order in, bit-reversed order out
+    const size_t total = count * n_;
     uint32_t m = 1;
     uint32_t k = n_ / 2;
+    const uint32_t* stage_zetas = stage_zetas_;
+
+    if (vector_path16_) {
+        for (size_t p = 0; p < count; ++p) {
+            forward16(poly + p * n_);
+        }
+        return;
+    }
+
+    if (lazy_limit_ >= 2) {
+        // Same schedule as ScalarNTTEngine: wide stages over the whole polynomial, then
+        // the rest tile by tile, merging stage pairs into radix-4 passes
+        const uint32_t tile = tile_size();
+        uint32_t global_stages = 0;
+        while ((n_ >> global_stages) > tile) {
+            ++global_stages;
+        }
+
+        uint32_t bound = 1;  // coefficients < bound * q
+        forward_layers(poly, total, 0, global_stages, bound);
+        check_lazy_bound(poly, static_cast<uint64_t>(bound) * q_, count);
+
+        uint32_t tile_bound = bound;
+        for (size_t t = 0; t < total; t += tile) {
+            tile_bound = bound;
+            forward_layers(poly + t, tile, global_stages, log_degree(), tile_bound);
+        }
+        check_lazy_bound(poly, static_cast<uint64_t>(tile_bound) * q_, count);
+        reduce_all(poly, total);
+        return;
+    }
 
     for (uint32_t stage = 0; stage < log_degree(); ++stage) {
-        uint32_t j = 0;
-        for (uint32_t i = 0; i < k; i += 4) {  // Process 4 butterflies at once
-            if (i + 4 <= k) {
-                // Load zeta values
-                uint32x4_t zeta_vec = zetas_[j];
-
-                // Load and process 4 pairs
-                uint32x4_t a0 = vld1q_u32(&poly[i]);
-                uint32x4_t b0 = vld1q_u32(&poly[i + k]);
-
-                butterfly_neon(a0, b0, zeta_vec);
-
-                vst1q_u32(&poly[i], a0);
-                vst1q_u32(&poly[i + k], b0);
-            } else {
-                // Handle remaining elements with scalar operations
-                for (uint32_t idx = i; idx < k; ++idx) {
-                    uint32_t zeta = reinterpret_cast<const uint32_t*>(&zetas_[j/4])[j%4];
-                    uint32_t sum = (poly[idx] + poly[idx + k]) % q_;
-                    uint32_t diff = poly[idx] - poly[idx + k];
-                    diff += ((diff >> 31) & q_);
-                    uint32_t prod = montgomery_reduce(static_cast<uint64_t>(diff) * zeta);
-                    poly[idx] = sum;
-                    poly[idx + k] = prod;
+#ifdef HAVE_NEON
+        if (vector_path_ && k >= NEON_LANES) {
+            for (size_t start = 0; start < total; start += 2 * k) {
+                for (uint32_t i = 0; i < k; i += NEON_LANES) {
+                    uint32x4_t a = vld1q_u32(poly + start + i);
+                    uint32x4_t b = vld1q_u32(poly + start + i + k);
+                    uint32x4_t z = vld1q_u32(stage_zetas + i);
+                    vst1q_u32(poly + start + i, add_mod_neon(a, b));
+                    vst1q_u32(poly + start + i + k, mul_mod_neon(sub_mod_neon(a, b), z));
+                }
+            }
+        } else
+#endif
+        {
+            for (size_t start = 0; start < total; start += 2 * k) {
+                uint32_t j = 0;
+                for (size_t i = start; i < start + k; ++i) {
+                    butterfly(poly[i], poly[i + k], zetas_[j]);
+                    j += m;
                 }
             }
-            j += m;
         }
+        stage_zetas += k;
         m *= 2;
         k /= 2;
-
-        // Modular reduction after each stage
-        for (uint32_t i = 0; i < n_; i += 4) {
-            uint32x4_t vec = vld1q_u32(&poly[i]);
-            vec = mod_reduce_neon(vec);
-            vst1q_u32(&poly[i], vec);
-        }
     }
-#else
-    // Fallback to scalar implementation
-    ntt_forward(poly);
-#endif
 }
 
 void NEONNTTEngine::ntt_inverse(uint32_t* poly) const {
-#ifdef HAVE_NEON
-    // NEON inverse NTT
+    ntt_inverse_batch(poly, 1);
+}
+
+void NEONNTTEngine::ntt_inverse_batch(uint32_t* poly, size_t count) const {
+    // Decimation-in-time inverse NTT, bit-reversed order in, natural order out (scaled by n)
+    const size_t total = count * n_;
     uint32_t m = n_ / 2;
     uint32_t k = 1;
+    const uint32_t* stage_zetas = stage_zetas_inv_ + (n_ - 1);
+
+    if (vector_path16_) {
+        for (size_t p = 0; p < count; ++p) {
+            inverse16(poly + p * n_);
+        }
+        return;
+    }
+
+    if (lazy_limit_ >= 2) {
+        const uint32_t tile = tile_size();
+        uint32_t bound = 1;  // coefficients < bound * q
+        for (size_t t = 0; t < total; t += tile) {
+            bound = 1;
+            inverse_layers(poly + t, tile, 1, tile, bound);
+        }
+        check_lazy_bound(poly, static_cast<uint64_t>(bound) * q_, count);
+
+        inverse_layers(poly, total, tile, n_, bound);
+        check_lazy_bound(poly, static_cast<uint64_t>(bound) * q_, count);
+        reduce_all(poly, total);
+        return;
+    }
 
     for (uint32_t stage = 0; stage < log_degree(); ++stage) {
-        uint32_t j = 0;
-        for (uint32_t i = 0; i < k; i += 4) {
-            if (i + 4 <= k) {
-                uint32x4_t zeta_vec = zetas_inv_[j];
-                uint32x4_t a0 = vld1q_u32(&poly[i]);
-                uint32x4_t b0 = vld1q_u32(&poly[i + k]);
-
-                butterfly_inv_neon(a0, b0, zeta_vec);
-
-                vst1q_u32(&poly[i], a0);
-                vst1q_u32(&poly[i + k], b0);
-            } else {
-                // Scalar fallback
-                for (uint32_t idx = i; idx < k; ++idx) {
-                    uint32_t zeta = reinterpret_cast<const uint32_t*>(&zetas_inv_[j/4])[j%4];
-                    uint32_t sum = (poly[idx] + poly[idx + k]) % q_;
-                    uint32_t diff = poly[idx] - poly[idx + k];
-                    diff += ((diff >> 31) & q_);
-                    uint32_t prod = montgomery_reduce(static_cast<uint64_t>(diff) * zeta);
-                    poly[idx] = sum;
-                    poly[idx + k] = prod;
+        stage_zetas -= k;
+#ifdef HAVE_NEON
+        if (vector_path_ && k >= NEON_LANES) {
+            for (size_t start = 0; start < total; start += 2 * k) {
+                for (uint32_t i = 0; i < k; i += NEON_LANES) {
+                    uint32x4_t a = vld1q_u32(poly + start + i);
+                    uint32x4_t b = vld1q_u32(poly + start + i + k);
+                    uint32x4_t z = vld1q_u32(stage_zetas + i);
+                    uint32x4_t t = mul_mod_neon(b, z);
+                    vst1q_u32(poly + start + i, add_mod_neon(a, t));
+                    vst1q_u32(poly + start + i + k, sub_mod_neon(a, t));
+                }
+            }
+        } else
+#endif
+        {
+            for (size_t start = 0; start < total; start += 2 * k) {
+                uint32_t j = 0;
+                for (size_t i = start; i < start + k; ++i) {
+                    butterfly_inv(poly[i], poly[i + k], zetas_inv_[j]);
+                    j += m;
                 }
             }
-            j += m;
         }
         m /= 2;
         k *= 2;
-
-        // Modular reduction after each stage
-        for (uint32_t i = 0; i < n_; i += 4) {
-            uint32x4_t vec = vld1q_u32(&poly[i]);
-            vec = mod_reduce_neon(vec);
-            vst1q_u32(&poly[i], vec);
-        }
     }
+}
 
-    // Scale by n^(-1) mod q
-    uint32_t n_inv = mod_inverse(n_, q_);
-    for (uint32_t i = 0; i < n_; ++i) {
-        poly[i] = montgomery_reduce(static_cast<uint64_t>(poly[i]) * n_inv);
+void NEONNTTEngine::basemul_acc(const uint32_t* a, const uint32_t* b, size_t k, uint32_t* out) const {
+    if (!lazy_accumulation_fits(k)) {
+        NTTEngine::basemul_acc(a, b, k, out);
+        return;
+    }
+    // Raw products accumulate in 32-bit lanes with one Barrett reduction per coefficient
+    uint32_t i = 0;
+#ifdef HAVE_NEON
+    for (; i + NEON_LANES <= n_; i += NEON_LANES) {
+        uint32x4_t acc = vdupq_n_u32(0);
+        for (size_t j = 0; j < k; ++j) {
+            acc = vmlaq_u32(acc, vld1q_u32(a + j * n_ + i), vld1q_u32(b + j * n_ + i));
+        }
+        vst1q_u32(out + i, reduce_neon(acc));
     }
-#else
-    // Fallback
-    ntt_inverse(poly);
 #endif
+    for (; i < n_; ++i) {
+        uint32_t acc = 0;
+        for (size_t j = 0; j < k; ++j) {
+            acc += a[j * n_ + i] * b[j * n_ + i];
+        }
+        out[i] = reduce(acc);
+    }
 }
 
-void NEONNTTEngine::multiply(const uint32_t* a, const uint32_t* b, uint32_t* result) const {
-    // Copy inputs for NTT
-    std::vector<uint32_t> a_ntt(n_);
-    std::vector<uint32_t> b_ntt(n_);
-    std::copy(a, a + n_, a_ntt.begin());
-    std::copy(b, b + n_, b_ntt.begin());
-
-    // Forward NTT
-    ntt_forward(a_ntt.data());
-    ntt_forward(b_ntt.data());
-
-    // Pointwise multiplication with Montgomery reduction
-    for (uint32_t i = 0; i < n_; i += 4) {
-        if (i + 4 <= n_) {
-            uint32x4_t a_vec = vld1q_u32(&a_ntt[i]);
-            uint32x4_t b_vec = vld1q_u32(&b_ntt[i]);
-            uint32x4_t prod = montgomery_multiply_neon(a_vec, b_vec);
-            vst1q_u32(&result[i], prod);
-        } else {
-            for (uint32_t j = i; j < n_; ++j) {
-                result[j] = montgomery_reduce(static_cast<uint64_t>(a_ntt[j]) * b_ntt[j]);
-            }
+void NEONNTTEngine::multiply_inplace(uint32_t* a, uint32_t* b) const {
+    ntt_forward(a);
+    ntt_forward(b);
+
+    uint32_t i = 0;
+#ifdef HAVE_NEON
+    if (vector_path_) {
+        for (; i + NEON_LANES <= n_; i += NEON_LANES) {
+            uint32x4_t va = vld1q_u32(a + i);
+            uint32x4_t vb = vld1q_u32(b + i);
+            vst1q_u32(a + i, mul_mod_neon(va, vb));
         }
     }
+#endif
+    for (; i < n_; ++i) {
+        a[i] = mod_mul(a[i], b[i]);
+    }
 
-    // Inverse NTT
-    ntt_inverse(result);
+    ntt_inverse(a);
 }
 
-} // namespace clwe
\ No newline at end of file
+} // namespace clwe
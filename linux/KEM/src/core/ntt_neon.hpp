@@ -3,6 +3,7 @@
 
 #include "ntt_engine.hpp"
 #include <cstdint>
+#include <vector>
 
 #ifdef HAVE_NEON
 #include <arm_neon.h>
@@ -10,45 +11,86 @@
 
 namespace clwe {
 
+// NEON NTT engine, bit-exact with ScalarNTTEngine. Odd 2^11 < q < 2^13 (Kyber's 3329)
+// transforms in 8 int16 lanes per int16x8_t with vqdmulh Montgomery twiddles; the k = 4, 2, 1
+// stages pair two registers through vzip / vtrn transposes. Other moduli use the lazy
+// 4 x uint32 kernels.
 class NEONNTTEngine : public NTTEngine {
+public:
+    static constexpr uint32_t LANES16 = 8;
+    // Largest degree transformed in the on-stack int16 work buffer
+    static constexpr uint32_t MAX_VECTOR_DEGREE = 1024;
+
 private:
-#ifdef HAVE_NEON
-    // NEON uses 128-bit vectors (4 uint32_t values)
-    uint32x4_t* zetas_;       // Precomputed zetas in NEON format
-    uint32x4_t* zetas_inv_;   // Inverse zetas in NEON format
-#endif
+    // Twiddles shared by all engines with this (q, n), see ntt_tables.hpp
+    const uint32_t* zetas_;
+    const uint32_t* zetas_inv_;
+
+    // Per-stage twiddles laid out contiguously so each butterfly group is one load.
+    // Stage s with half-length k = n >> (s + 1) stores zetas_[i << s] for i < k.
+    const uint32_t* stage_zetas_;
+    const uint32_t* stage_zetas_inv_;
 
-    // Montgomery reduction constants
-    uint32_t montgomery_r_;       // 2^32 mod q
-    uint32_t montgomery_r_inv_;   // R^(-1) mod q
+    // Barrett constant floor(2^32 / q); valid while q < 2^16 so products fit in 32 bits
+    uint32_t barrett_m_;
+    bool vector_path_;
+    // Largest c with c * q * q < 2^32; lazy stages let coefficients grow to c * q (needs c >= 2)
+    uint32_t lazy_limit_;
 
-    // Precompute zetas for NTT
-    void precompute_zetas();
+    // Per-stage twiddles in Montgomery form (zeta * 2^16 mod q, centered) and their products
+    // with q^-1 mod 2^16. Half-length k starts at stage_offsets_[log2(k)]; stages shorter than
+    // a register are repeated to fill LANES16 entries, lane l using twiddle l mod k.
+    // Shared per (q, n, lanes) through ntt_montgomery_tables; null off the 16-bit path.
+    const int16_t* fwd_zetas_ = nullptr;
+    const int16_t* fwd_zetas_qinv_ = nullptr;
+    const int16_t* inv_zetas_ = nullptr;
+    const int16_t* inv_zetas_qinv_ = nullptr;
+    const uint32_t* stage_offsets_ = nullptr;
 
-    // NEON butterfly operations
-    void butterfly_neon(uint32x4_t& a, uint32x4_t& b, uint32x4_t zeta) const;
-    void butterfly_inv_neon(uint32x4_t& a, uint32x4_t& b, uint32x4_t zeta) const;
+    int16_t qinv_;       // q^-1 mod 2^16
+    int16_t barrett_v_;  // round(2^26 / q)
+    // Same range argument as AVX512NTTEngine, see ntt_neon.cpp
+    bool vector_path16_;
 
-    // Modular reduction
-    uint32x4_t mod_reduce_neon(uint32x4_t val) const;
+    void forward16(uint32_t* poly) const;
+    void inverse16(uint32_t* poly) const;
 
-    // Montgomery reduction
-    uint32_t montgomery_reduce(uint64_t val) const;
-    uint32x4_t montgomery_reduce_neon(uint32x4_t val) const;
-    uint32x4_t montgomery_multiply_neon(uint32x4_t a, uint32x4_t b) const;
+    // Scalar butterflies for the short stages and the q >= 2^16 fallback
+    void butterfly(uint32_t& a, uint32_t& b, uint32_t zeta) const;
+    void butterfly_inv(uint32_t& a, uint32_t& b, uint32_t zeta) const;
+    uint32_t mod_mul(uint32_t a, uint32_t b) const;
+    // Barrett reduction of any 32-bit value, and of poly[0, len)
+    uint32_t reduce(uint32_t x) const;
+    void reduce_all(uint32_t* poly, size_t len) const;
+
+    // Merged-layer lazy kernels over one block (the full polynomial or one cache tile)
+    uint32_t tile_size() const;
+    void forward_layers(uint32_t* block, size_t len, uint32_t first, uint32_t last, uint32_t& bound) const;
+    void inverse_layers(uint32_t* block, size_t len, uint32_t k_first, uint32_t k_end, uint32_t& bound) const;
+
+#ifdef HAVE_NEON
+    // NEON modular arithmetic on canonical residues
+    uint32x4_t add_mod_neon(uint32x4_t a, uint32x4_t b) const;
+    uint32x4_t sub_mod_neon(uint32x4_t a, uint32x4_t b) const;
+    uint32x4_t mul_mod_neon(uint32x4_t a, uint32x4_t b) const;
+    uint32x4_t reduce_neon(uint32x4_t x) const;
+#endif
 
 public:
     NEONNTTEngine(uint32_t q, uint32_t n);
-    ~NEONNTTEngine() override;
+    ~NEONNTTEngine() override = default;
 
     // Implement pure virtual methods
     void ntt_forward(uint32_t* poly) const override;
     void ntt_inverse(uint32_t* poly) const override;
-    void multiply(const uint32_t* a, const uint32_t* b, uint32_t* result) const override;
+    void ntt_forward_batch(uint32_t* polys, size_t count) const override;
+    void ntt_inverse_batch(uint32_t* polys, size_t count) const override;
+    void multiply_inplace(uint32_t* a, uint32_t* b) const override;
+    void basemul_acc(const uint32_t* a, const uint32_t* b, size_t k, uint32_t* out) const override;
 
     SIMDSupport get_simd_support() const override { return SIMDSupport::NEON; }
 };
 
 } // namespace clwe
 
-#endif // NTT_NEON_HPP
\ No newline at end of file
+#endif // NTT_NEON_HPP
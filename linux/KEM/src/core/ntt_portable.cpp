@@ -0,0 +1,172 @@
+#include "ntt_portable.hpp"
+#include "ntt_tables.hpp"
+#include "simd_vec.hpp"
+
+namespace clwe {
+
+namespace {
+using Vec = simd::VecU32<simd::DEFAULT_U32_LANES>;
+constexpr uint32_t LANES = static_cast<uint32_t>(Vec::lanes);
+} // namespace
+
+PortableNTTEngine::PortableNTTEngine(uint32_t q, uint32_t n)
+    : NTTEngine(q, n),
+      barrett_m_(static_cast<uint32_t>((1ULL << 32) / q)),
+      vector_path_(q < (1u << 16)) {
+    NTTTableView tables = ntt_tables(q, n);
+    zetas_ = tables.zetas;
+    zetas_inv_ = tables.zetas_inv;
+    stage_zetas_ = tables.stage_zetas;
+    stage_zetas_inv_ = tables.stage_zetas_inv;
+
+    // The stages use n - 1 twiddles in total
+    stage_zetas_shoup_.resize(n);
+    stage_zetas_inv_shoup_.resize(n);
+    for (uint32_t i = 0; i + 1 < n; ++i) {
+        stage_zetas_shoup_[i] = static_cast<uint32_t>((static_cast<uint64_t>(stage_zetas_[i]) << 32) / q);
+        stage_zetas_inv_shoup_[i] = static_cast<uint32_t>((static_cast<uint64_t>(stage_zetas_inv_[i]) << 32) / q);
+    }
+}
+
+uint32_t PortableNTTEngine::mod_mul(uint32_t a, uint32_t b) const {
+    return static_cast<uint32_t>((static_cast<uint64_t>(a) * b) % q_);
+}
+
+void PortableNTTEngine::butterfly(uint32_t& a, uint32_t& b, uint32_t zeta) const {
+    uint32_t sum = a + b;
+    uint32_t reduce_mask = - (uint32_t)(sum >= q_);
+    sum -= reduce_mask & q_;
+    uint32_t diff = a - b;
+    uint32_t borrow_mask = - (uint32_t)(a < b);
+    diff += borrow_mask & q_;
+    a = sum;
+    b = mod_mul(diff, zeta);
+}
+
+void PortableNTTEngine::butterfly_inv(uint32_t& a, uint32_t& b, uint32_t zeta) const {
+    uint32_t t = mod_mul(b, zeta);
+    uint32_t diff = a - t;
+    uint32_t borrow_mask = - (uint32_t)(a < t);
+    diff += borrow_mask & q_;
+    uint32_t sum = a + t;
+    uint32_t reduce_mask = - (uint32_t)(sum >= q_);
+    sum -= reduce_mask & q_;
+    a = sum;
+    b = diff;
+}
+
+void PortableNTTEngine::ntt_forward(uint32_t* poly) const {
+    ntt_forward_batch(poly, 1);
+}
+
+void PortableNTTEngine::ntt_forward_batch(uint32_t* poly, size_t count) const {
+    // Decimation-in-frequency NTT, natural order in, bit-reversed order out
+    const size_t total = count * n_;
+    uint32_t m = 1;
+    uint32_t k = n_ / 2;
+    size_t offset = 0;
+    const Vec q_vec = Vec::splat(q_);
+
+    for (uint32_t stage = 0; stage < log_degree(); ++stage) {
+        const uint32_t* z = stage_zetas_ + offset;
+        const uint32_t* zs = stage_zetas_shoup_.data() + offset;
+        if (vector_path_ && k >= LANES) {
+            for (size_t start = 0; start < total; start += 2 * k) {
+                for (uint32_t i = 0; i < k; i += LANES) {
+                    uint32_t* lo = poly + start + i;
+                    Vec a = Vec::load(lo);
+                    Vec b = Vec::load(lo + k);
+                    simd::add_mod(a, b, q_vec).store(lo);
+                    simd::mul_shoup(simd::sub_mod(a, b, q_vec), Vec::load(z + i), Vec::load(zs + i), q_vec)
+                        .store(lo + k);
+                }
+            }
+        } else {
+            for (size_t start = 0; start < total; start += 2 * k) {
+                uint32_t j = 0;
+                for (size_t i = start; i < start + k; ++i) {
+                    butterfly(poly[i], poly[i + k], zetas_[j]);
+                    j += m;
+                }
+            }
+        }
+        offset += k;
+        m *= 2;
+        k /= 2;
+    }
+}
+
+void PortableNTTEngine::ntt_inverse(uint32_t* poly) const {
+    ntt_inverse_batch(poly, 1);
+}
+
+void PortableNTTEngine::ntt_inverse_batch(uint32_t* poly, size_t count) const {
+    // Decimation-in-time inverse NTT, bit-reversed order in, natural order out (scaled by n)
+    const size_t total = count * n_;
+    uint32_t m = n_ / 2;
+    uint32_t k = 1;
+    size_t offset = n_ - 1;
+    const Vec q_vec = Vec::splat(q_);
+
+    for (uint32_t stage = 0; stage < log_degree(); ++stage) {
+        offset -= k;
+        const uint32_t* z = stage_zetas_inv_ + offset;
+        const uint32_t* zs = stage_zetas_inv_shoup_.data() + offset;
+        if (vector_path_ && k >= LANES) {
+            for (size_t start = 0; start < total; start += 2 * k) {
+                for (uint32_t i = 0; i < k; i += LANES) {
+                    uint32_t* lo = poly + start + i;
+                    Vec a = Vec::load(lo);
+                    Vec t = simd::mul_shoup(Vec::load(lo + k), Vec::load(z + i), Vec::load(zs + i), q_vec);
+                    simd::add_mod(a, t, q_vec).store(lo);
+                    simd::sub_mod(a, t, q_vec).store(lo + k);
+                }
+            }
+        } else {
+            for (size_t start = 0; start < total; start += 2 * k) {
+                uint32_t j = 0;
+                for (size_t i = start; i < start + k; ++i) {
+                    butterfly_inv(poly[i], poly[i + k], zetas_inv_[j]);
+                    j += m;
+                }
+            }
+        }
+        m /= 2;
+        k *= 2;
+    }
+}
+
+void PortableNTTEngine::multiply_inplace(uint32_t* a, uint32_t* b) const {
+    ntt_forward(a);
+    ntt_forward(b);
+    // Each output lane is stored after its inputs are loaded, so basemul_acc may write over a
+    basemul_acc(a, b, 1, a);
+    ntt_inverse(a);
+}
+
+void PortableNTTEngine::basemul_acc(const uint32_t* a, const uint32_t* b, size_t k, uint32_t* out) const {
+    uint32_t i = 0;
+    if (vector_path_) {
+        // When k raw products fit in 32 bits the sum is reduced once at the end
+        const Vec q_vec = Vec::splat(q_);
+        const Vec m_vec = Vec::splat(barrett_m_);
+        const bool lazy = lazy_accumulation_fits(k);
+        for (; i + LANES <= n_; i += LANES) {
+            Vec acc = Vec::splat(0);
+            for (size_t j = 0; j < k; ++j) {
+                Vec p = Vec::load(a + j * n_ + i) * Vec::load(b + j * n_ + i);
+                acc = lazy ? acc + p : simd::add_mod(acc, simd::barrett_reduce(p, q_vec, m_vec), q_vec);
+            }
+            (lazy ? simd::barrett_reduce(acc, q_vec, m_vec) : acc).store(out + i);
+        }
+    }
+    for (; i < n_; ++i) {
+        uint64_t acc = 0;
+        for (size_t j = 0; j < k; ++j) {
+            acc += mod_mul(a[j * n_ + i], b[j * n_ + i]);
+        }
+        out[i] = static_cast<uint32_t>(acc % q_);
+    }
+}
+
+} // namespace clwe
@@ -0,0 +1,53 @@
+#ifndef NTT_PORTABLE_HPP
+#define NTT_PORTABLE_HPP
+
+#include "library_allocator.hpp"
+#include "ntt_engine.hpp"
+#include <cstdint>
+
+namespace clwe {
+
+// NTT engine written once against the portable vectors of simd_vec.hpp, 4 uint32_t lanes,
+// bit-exact with ScalarNTTEngine. Twiddle products use precomputed quotients (Shoup), data
+// products use Barrett, as in the WebAssembly engine it generalizes. Stages shorter than the
+// lanes and q >= 2^16, whose products overflow 32 bits, use scalar butterflies.
+// create_ntt_engine() returns it for backends whose hand-written engine is not compiled in,
+// where the baseline ISA has a vector unit (simd::NATIVE); it reports SIMDSupport::NONE, as
+// none of the hand-written backends is in use.
+class PortableNTTEngine : public NTTEngine {
+private:
+    // Twiddles shared by all engines with this (q, n), see ntt_tables.hpp
+    const uint32_t* zetas_;
+    const uint32_t* zetas_inv_;
+    const uint32_t* stage_zetas_;
+    const uint32_t* stage_zetas_inv_;
+
+    // floor(zeta * 2^32 / q) for each entry of the stage tables, same layout
+    LibraryVector<uint32_t> stage_zetas_shoup_;
+    LibraryVector<uint32_t> stage_zetas_inv_shoup_;
+
+    // Barrett constant floor(2^32 / q); valid while q < 2^16 so products fit in 32 bits
+    uint32_t barrett_m_;
+    bool vector_path_;
+
+    void butterfly(uint32_t& a, uint32_t& b, uint32_t zeta) const;
+    void butterfly_inv(uint32_t& a, uint32_t& b, uint32_t zeta) const;
+    uint32_t mod_mul(uint32_t a, uint32_t b) const;
+
+public:
+    PortableNTTEngine(uint32_t q, uint32_t n);
+    ~PortableNTTEngine() override = default;
+
+    void ntt_forward(uint32_t* poly) const override;
+    void ntt_inverse(uint32_t* poly) const override;
+    void ntt_forward_batch(uint32_t* polys, size_t count) const override;
+    void ntt_inverse_batch(uint32_t* polys, size_t count) const override;
+    void multiply_inplace(uint32_t* a, uint32_t* b) const override;
+    void basemul_acc(const uint32_t* a, const uint32_t* b, size_t k, uint32_t* out) const override;
+
+    SIMDSupport get_simd_support() const override { return SIMDSupport::NONE; }
+};
+
+} // namespace clwe
+
+#endif // NTT_PORTABLE_HPP
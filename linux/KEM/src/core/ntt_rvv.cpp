@@ -0,0 +1,242 @@
+#include "ntt_rvv.hpp"
+#include "ntt_tables.hpp"
+#include <vector>
+
+#ifdef HAVE_RVV
+#include <riscv_vector.h>
+#endif
+
+namespace clwe {
+
+#ifdef HAVE_RVV
+namespace {
+// LMUL=2 keeps sixteen register groups free for the butterfly temporaries
+using vec_t = vuint32m2_t;
+
+inline vec_t add_mod(vec_t a, vec_t b, uint32_t q, size_t vl) {
+    vec_t sum = __riscv_vadd_vv_u32m2(a, b, vl);
+    // sum - q wraps around exactly when sum < q, so the unsigned min picks the reduced value
+    return __riscv_vminu_vv_u32m2(sum, __riscv_vsub_vx_u32m2(sum, q, vl), vl);
+}
+
+inline vec_t sub_mod(vec_t a, vec_t b, uint32_t q, size_t vl) {
+    vec_t diff = __riscv_vadd_vx_u32m2(__riscv_vsub_vv_u32m2(a, b, vl), q, vl);
+    return __riscv_vminu_vv_u32m2(diff, __riscv_vsub_vx_u32m2(diff, q, vl), vl);
+}
+
+// Barrett reduction of any 32-bit lane value
+inline vec_t reduce(vec_t x, uint32_t q, uint32_t m, size_t vl) {
+    vec_t t = __riscv_vmulhu_vx_u32m2(x, m, vl);
+    // The quotient is at most one short, leaving r < 2q
+    vec_t r = __riscv_vnmsac_vx_u32m2(x, q, t, vl);
+    return __riscv_vminu_vv_u32m2(r, __riscv_vsub_vx_u32m2(r, q, vl), vl);
+}
+} // namespace
+#endif
+
+RVVNTTEngine::RVVNTTEngine(uint32_t q, uint32_t n)
+    : NTTEngine(q, n),
+      barrett_m_(static_cast<uint32_t>((1ULL << 32) / q)),
+      vector_path_(q < (1u << 16)),
+#ifdef HAVE_RVV
+      vlmax_(__riscv_vsetvlmax_e32m2()) {
+#else
+      vlmax_(1) {
+#endif
+    NTTTableView tables = ntt_tables(q, n);
+    zetas_ = tables.zetas;
+    zetas_inv_ = tables.zetas_inv;
+    stage_zetas_ = tables.stage_zetas;
+    stage_zetas_inv_ = tables.stage_zetas_inv;
+}
+
+uint32_t RVVNTTEngine::mod_mul(uint32_t a, uint32_t b) const {
+    return static_cast<uint32_t>((static_cast<uint64_t>(a) * b) % q_);
+}
+
+void RVVNTTEngine::butterfly(uint32_t& a, uint32_t& b, uint32_t zeta) const {
+    uint32_t sum = a + b;
+    uint32_t reduce_mask = - (uint32_t)(sum >= q_);
+    sum -= reduce_mask & q_;
+    uint32_t diff = a - b;
+    uint32_t borrow_mask = - (uint32_t)(a < b);
+    diff += borrow_mask & q_;
+    a = sum;
+    b = mod_mul(diff, zeta);
+}
+
+void RVVNTTEngine::butterfly_inv(uint32_t& a, uint32_t& b, uint32_t zeta) const {
+    uint32_t t = mod_mul(b, zeta);
+    uint32_t diff = a - t;
+    uint32_t borrow_mask = - (uint32_t)(a < t);
+    diff += borrow_mask & q_;
+    uint32_t sum = a + t;
+    uint32_t reduce_mask = - (uint32_t)(sum >= q_);
+    sum -= reduce_mask & q_;
+    a = sum;
+    b = diff;
+}
+
+void RVVNTTEngine::ntt_forward(uint32_t* poly) const {
+    ntt_forward_batch(poly, 1);
+}
+
+void RVVNTTEngine::ntt_forward_batch(uint32_t* poly, size_t count) const {
+    // Decimation-in-frequency NTT, natural order in, bit-reversed order out
+    const size_t total = count * n_;
+    uint32_t m = 1;
+    uint32_t k = n_ / 2;
+    const uint32_t* stage_zetas = stage_zetas_;
+
+    for (uint32_t stage = 0; stage < log_degree(); ++stage) {
+#ifdef HAVE_RVV
+        if (vector_path_ && k >= vlmax_) {
+            for (size_t start = 0; start < total; start += 2 * k) {
+                size_t vl;
+                for (size_t i = 0; i < k; i += vl) {
+                    vl = __riscv_vsetvl_e32m2(k - i);
+                    uint32_t* lo = poly + start + i;
+                    vec_t a = __riscv_vle32_v_u32m2(lo, vl);
+                    vec_t b = __riscv_vle32_v_u32m2(lo + k, vl);
+                    vec_t z = __riscv_vle32_v_u32m2(stage_zetas + i, vl);
+                    vec_t diff = __riscv_vmul_vv_u32m2(sub_mod(a, b, q_, vl), z, vl);
+                    __riscv_vse32_v_u32m2(lo, add_mod(a, b, q_, vl), vl);
+                    __riscv_vse32_v_u32m2(lo + k, reduce(diff, q_, barrett_m_, vl), vl);
+                }
+            }
+        } else if (vector_path_) {
+            // Short stage: lane j holds butterfly i of block j, all sharing one twiddle
+            const size_t blocks = total / (2 * k);
+            const ptrdiff_t stride = static_cast<ptrdiff_t>(2 * k * sizeof(uint32_t));
+            for (uint32_t i = 0; i < k; ++i) {
+                const uint32_t zeta = stage_zetas[i];
+                size_t vl;
+                for (size_t blk = 0; blk < blocks; blk += vl) {
+                    vl = __riscv_vsetvl_e32m2(blocks - blk);
+                    uint32_t* lo = poly + blk * 2 * k + i;
+                    vec_t a = __riscv_vlse32_v_u32m2(lo, stride, vl);
+                    vec_t b = __riscv_vlse32_v_u32m2(lo + k, stride, vl);
+                    vec_t diff = __riscv_vmul_vx_u32m2(sub_mod(a, b, q_, vl), zeta, vl);
+                    __riscv_vsse32_v_u32m2(lo, stride, add_mod(a, b, q_, vl), vl);
+                    __riscv_vsse32_v_u32m2(lo + k, stride, reduce(diff, q_, barrett_m_, vl), vl);
+                }
+            }
+        } else
+#endif
+        {
+            for (size_t start = 0; start < total; start += 2 * k) {
+                uint32_t j = 0;
+                for (size_t i = start; i < start + k; ++i) {
+                    butterfly(poly[i], poly[i + k], zetas_[j]);
+                    j += m;
+                }
+            }
+        }
+        stage_zetas += k;
+        m *= 2;
+        k /= 2;
+    }
+}
+
+void RVVNTTEngine::ntt_inverse(uint32_t* poly) const {
+    ntt_inverse_batch(poly, 1);
+}
+
+void RVVNTTEngine::ntt_inverse_batch(uint32_t* poly, size_t count) const {
+    // Decimation-in-time inverse NTT, bit-reversed order in, natural order out (scaled by n)
+    const size_t total = count * n_;
+    uint32_t m = n_ / 2;
+    uint32_t k = 1;
+    const uint32_t* stage_zetas = stage_zetas_inv_ + (n_ - 1);
+
+    for (uint32_t stage = 0; stage < log_degree(); ++stage) {
+        stage_zetas -= k;
+#ifdef HAVE_RVV
+        if (vector_path_ && k >= vlmax_) {
+            for (size_t start = 0; start < total; start += 2 * k) {
+                size_t vl;
+                for (size_t i = 0; i < k; i += vl) {
+                    vl = __riscv_vsetvl_e32m2(k - i);
+                    uint32_t* lo = poly + start + i;
+                    vec_t a = __riscv_vle32_v_u32m2(lo, vl);
+                    vec_t b = __riscv_vle32_v_u32m2(lo + k, vl);
+                    vec_t z = __riscv_vle32_v_u32m2(stage_zetas + i, vl);
+                    vec_t t = reduce(__riscv_vmul_vv_u32m2(b, z, vl), q_, barrett_m_, vl);
+                    __riscv_vse32_v_u32m2(lo, add_mod(a, t, q_, vl), vl);
+                    __riscv_vse32_v_u32m2(lo + k, sub_mod(a, t, q_, vl), vl);
+                }
+            }
+        } else if (vector_path_) {
+            const size_t blocks = total / (2 * k);
+            const ptrdiff_t stride = static_cast<ptrdiff_t>(2 * k * sizeof(uint32_t));
+            for (uint32_t i = 0; i < k; ++i) {
+                const uint32_t zeta = stage_zetas[i];
+                size_t vl;
+                for (size_t blk = 0; blk < blocks; blk += vl) {
+                    vl = __riscv_vsetvl_e32m2(blocks - blk);
+                    uint32_t* lo = poly + blk * 2 * k + i;
+                    vec_t a = __riscv_vlse32_v_u32m2(lo, stride, vl);
+                    vec_t b = __riscv_vlse32_v_u32m2(lo + k, stride, vl);
+                    vec_t t = reduce(__riscv_vmul_vx_u32m2(b, zeta, vl), q_, barrett_m_, vl);
+                    __riscv_vsse32_v_u32m2(lo, stride, add_mod(a, t, q_, vl), vl);
+                    __riscv_vsse32_v_u32m2(lo + k, stride, sub_mod(a, t, q_, vl), vl);
+                }
+            }
+        } else
+#endif
+        {
+            for (size_t start = 0; start < total; start += 2 * k) {
+                uint32_t j = 0;
+                for (size_t i = start; i < start + k; ++i) {
+                    butterfly_inv(poly[i], poly[i + k], zetas_inv_[j]);
+                    j += m;
+                }
+            }
+        }
+        m /= 2;
+        k *= 2;
+    }
+}
+
+void RVVNTTEngine::multiply_inplace(uint32_t* a, uint32_t* b) const {
+    ntt_forward(a);
+    ntt_forward(b);
+    // Each output lane is stored after its inputs are loaded, so basemul_acc may write over a
+    basemul_acc(a, b, 1, a);
+    ntt_inverse(a);
+}
+
+void RVVNTTEngine::basemul_acc(const uint32_t* a, const uint32_t* b, size_t k, uint32_t* out) const {
+#ifdef HAVE_RVV
+    if (vector_path_) {
+        // When k raw products fit in 32 bits the sum is reduced once at the end
+        const bool lazy = lazy_accumulation_fits(k);
+        size_t vl;
+        for (size_t i = 0; i < n_; i += vl) {
+            vl = __riscv_vsetvl_e32m2(n_ - i);
+            vec_t acc = __riscv_vmv_v_x_u32m2(0, vl);
+            for (size_t j = 0; j < k; ++j) {
+                vec_t va = __riscv_vle32_v_u32m2(a + j * n_ + i, vl);
+                vec_t vb = __riscv_vle32_v_u32m2(b + j * n_ + i, vl);
+                if (lazy) {
+                    acc = __riscv_vmacc_vv_u32m2(acc, va, vb, vl);
+                } else {
+                    vec_t p = reduce(__riscv_vmul_vv_u32m2(va, vb, vl), q_, barrett_m_, vl);
+                    acc = add_mod(acc, p, q_, vl);
+                }
+            }
+            __riscv_vse32_v_u32m2(out + i, lazy ? reduce(acc, q_, barrett_m_, vl) : acc, vl);
+        }
+        return;
+    }
+#endif
+    for (uint32_t i = 0; i < n_; ++i) {
+        uint64_t acc = 0;
+        for (size_t j = 0; j < k; ++j) {
+            acc += mod_mul(a[j * n_ + i], b[j * n_ + i]);
+        }
+        out[i] = static_cast<uint32_t>(acc % q_);
+    }
+}
+
+} // namespace clwe
@@ -0,0 +1,50 @@
+#ifndef NTT_RVV_HPP
+#define NTT_RVV_HPP
+
+#include "ntt_engine.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace clwe {
+
+// RISC-V Vector (RVV 1.0) NTT engine, bit-exact with ScalarNTTEngine.
+// Every loop is strip-mined with vsetvl, so the same binary uses all lanes of any VLEN:
+// stages with half-length k >= VLMAX run contiguous butterflies, shorter stages run one
+// twiddle across many blocks through strided loads. Residues stay canonical in 32-bit lanes.
+class RVVNTTEngine : public NTTEngine {
+private:
+    // Twiddles shared by all engines with this (q, n), see ntt_tables.hpp
+    const uint32_t* zetas_;
+    const uint32_t* zetas_inv_;
+    const uint32_t* stage_zetas_;
+    const uint32_t* stage_zetas_inv_;
+
+    // Barrett constant floor(2^32 / q); valid while q < 2^16 so products fit in 32 bits
+    uint32_t barrett_m_;
+    bool vector_path_;
+    // 32-bit elements per LMUL=2 register group on this hart (VLEN / 16)
+    size_t vlmax_;
+
+    // Scalar butterflies for the q >= 2^16 fallback
+    void butterfly(uint32_t& a, uint32_t& b, uint32_t zeta) const;
+    void butterfly_inv(uint32_t& a, uint32_t& b, uint32_t zeta) const;
+    uint32_t mod_mul(uint32_t a, uint32_t b) const;
+
+public:
+    RVVNTTEngine(uint32_t q, uint32_t n);
+    ~RVVNTTEngine() override = default;
+
+    void ntt_forward(uint32_t* poly) const override;
+    void ntt_inverse(uint32_t* poly) const override;
+    void ntt_forward_batch(uint32_t* polys, size_t count) const override;
+    void ntt_inverse_batch(uint32_t* polys, size_t count) const override;
+    void multiply_inplace(uint32_t* a, uint32_t* b) const override;
+    void basemul_acc(const uint32_t* a, const uint32_t* b, size_t k, uint32_t* out) const override;
+
+    size_t vector_length() const { return vlmax_; }
+    SIMDSupport get_simd_support() const override { return SIMDSupport::RVV; }
+};
+
+} // namespace clwe
+
+#endif // NTT_RVV_HPP
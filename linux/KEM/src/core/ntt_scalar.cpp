@@ -1,4 +1,5 @@
 #include "ntt_scalar.hpp"
+#include "ntt_tables.hpp"
 #include "utils.hpp"
 #include <algorithm>
 #include <iostream>
@@ -7,122 +8,287 @@
 
 namespace clwe {
 
-ScalarNTTEngine::ScalarNTTEngine(uint32_t q, uint32_t n)
-    : NTTEngine(q, n), zetas_(n), zetas_inv_(n),
-      montgomery_r_(0), montgomery_r_inv_(0) {
-
-    // Pre-compute Montgomery constants for modular reduction
-    montgomery_r_ = (1ULL << 32) % q_;
-    montgomery_r_inv_ = mod_inverse(montgomery_r_, q_);
-
-    precompute_zetas();
+namespace {
+// Coefficients per cache tile (4 KiB), small enough to stay in L1 with its twiddles
+constexpr uint32_t NTT_TILE_COEFFS = 1024;
 }
 
-void ScalarNTTEngine::precompute_zetas() {
-    // Precompute primitive n-th root of unity
-    uint32_t g = 17;  // Primitive root for q = 3329 (Kyber modulus)
-    uint32_t zeta = mod_pow(g, (q_ - 1) / n_, q_);
-
-    zetas_[0] = 1;
-    for (uint32_t i = 1; i < n_; ++i) {
-        zetas_[i] = (static_cast<uint64_t>(zetas_[i-1]) * zeta) % q_;
-    }
-
-    // Inverse zetas for inverse NTT
-    uint32_t zeta_inv = mod_inverse(zeta, q_);
-    zetas_inv_[0] = 1;
-    for (uint32_t i = 1; i < n_; ++i) {
-        zetas_inv_[i] = (static_cast<uint64_t>(zetas_inv_[i-1]) * zeta_inv) % q_;
-    }
+ScalarNTTEngine::ScalarNTTEngine(uint32_t q, uint32_t n)
+    : NTTEngine(q, n),
+      barrett_m_(static_cast<uint32_t>((1ULL << 32) / q)),
+      lazy_limit_(static_cast<uint32_t>(0xFFFFFFFFULL / (static_cast<uint64_t>(q) * q))) {
+    NTTTableView tables = ntt_tables(q, n);
+    zetas_ = tables.zetas;
+    zetas_inv_ = tables.zetas_inv;
 }
 
+// Gentleman-Sande butterfly: (a, b) -> (a + b, (a - b) * zeta)
 void ScalarNTTEngine::butterfly(uint32_t& a, uint32_t& b, uint32_t zeta) const {
-    uint32_t sum = (a + b) % q_;
+    uint32_t sum = a + b;
+    uint32_t reduce_mask = - (uint32_t)(sum >= q_);
+    sum -= reduce_mask & q_;
     uint32_t diff = a - b;
     uint32_t borrow_mask = - (uint32_t)(a < b);
     diff += borrow_mask & q_;
-    uint32_t reduce_mask = - (uint32_t)(diff >= q_);
-    diff -= reduce_mask & q_;
-    uint32_t prod = montgomery_reduce(static_cast<uint64_t>(diff) * zeta);
     a = sum;
-    b = prod;
+    b = mod_mul(diff, zeta);
 }
 
+// Cooley-Tukey butterfly: (a, b) -> (a + b * zeta, a - b * zeta)
 void ScalarNTTEngine::butterfly_inv(uint32_t& a, uint32_t& b, uint32_t zeta) const {
-    // Same as forward for inverse (zeta is already inverse)
-    butterfly(a, b, zeta);
+    uint32_t t = mod_mul(b, zeta);
+    uint32_t diff = a - t;
+    uint32_t borrow_mask = - (uint32_t)(a < t);
+    diff += borrow_mask & q_;
+    uint32_t sum = a + t;
+    uint32_t reduce_mask = - (uint32_t)(sum >= q_);
+    sum -= reduce_mask & q_;
+    a = sum;
+    b = diff;
 }
 
 uint32_t ScalarNTTEngine::mod_reduce(uint32_t val) const {
-    return val % q_;
+    // Barrett: the quotient estimate is at most one short, leaving r < 2q
+    uint32_t t = static_cast<uint32_t>((static_cast<uint64_t>(val) * barrett_m_) >> 32);
+    uint32_t r = val - t * q_;
+    return r - (q_ & -(uint32_t)(r >= q_));
 }
 
-uint32_t ScalarNTTEngine::montgomery_reduce(uint64_t val) const {
-    // Montgomery reduction: (val * R^-1) mod q
-    uint64_t t = val * montgomery_r_inv_;
-    uint32_t k = t % (1ULL << 32);
-    uint64_t res = val - static_cast<uint64_t>(k) * q_;
-    return res >> 32;
+uint32_t ScalarNTTEngine::mod_mul(uint32_t a, uint32_t b) const {
+    if (lazy_limit_ >= 1) {
+        return mod_reduce(a * b);
+    }
+    return static_cast<uint32_t>((static_cast<uint64_t>(a) * b) % q_);
+}
+
+void ScalarNTTEngine::reduce_all(uint32_t* poly, size_t len) const {
+    for (size_t i = 0; i < len; ++i) {
+        poly[i] = mod_reduce(poly[i]);
+    }
+}
+
+uint32_t ScalarNTTEngine::tile_size() const {
+    return std::min(n_, NTT_TILE_COEFFS);
+}
+
+// Lazy DIF stages [first, last) on block[0, len), len a multiple of the span n >> first.
+// Stage pairs run as one radix-4 pass: (a + b) stays unreduced and (a - b + offset) * zeta
+// is reduced, so a pair multiplies the bound by 4 and needs 4 * bound <= lazy_limit_.
+void ScalarNTTEngine::forward_layers(uint32_t* block, size_t len, uint32_t first, uint32_t last,
+                                     uint32_t& bound) const {
+    uint32_t s = first;
+    while (s < last) {
+        const uint32_t k = n_ >> (s + 1);
+        const uint32_t m = 1u << s;
+        if (s + 1 < last && lazy_limit_ >= 4) {
+            if (4 * bound > lazy_limit_) {
+                reduce_all(block, len);
+                bound = 1;
+            }
+            const uint32_t h = k / 2;
+            const uint32_t offset1 = bound * q_;
+            const uint32_t offset2 = 2 * bound * q_;
+            for (size_t start = 0; start < len; start += 2 * k) {
+                uint32_t* p = block + start;
+                for (uint32_t i = 0; i < h; ++i) {
+                    uint32_t x0 = p[i], x1 = p[i + h], x2 = p[i + k], x3 = p[i + k + h];
+                    uint32_t y0 = x0 + x2;
+                    uint32_t y2 = mod_reduce((x0 + offset1 - x2) * zetas_[i * m]);
+                    uint32_t y1 = x1 + x3;
+                    uint32_t y3 = mod_reduce((x1 + offset1 - x3) * zetas_[(i + h) * m]);
+                    const uint32_t w = zetas_[2 * i * m];
+                    p[i] = y0 + y1;
+                    p[i + h] = mod_reduce((y0 + offset2 - y1) * w);
+                    p[i + k] = y2 + y3;
+                    p[i + k + h] = mod_reduce((y2 + offset2 - y3) * w);
+                }
+            }
+            bound *= 4;
+            s += 2;
+        } else {
+            if (2 * bound > lazy_limit_) {
+                reduce_all(block, len);
+                bound = 1;
+            }
+            const uint32_t offset = bound * q_;
+            for (size_t start = 0; start < len; start += 2 * k) {
+                uint32_t* p = block + start;
+                for (uint32_t i = 0; i < k; ++i) {
+                    uint32_t a = p[i];
+                    uint32_t b = p[i + k];
+                    p[i] = a + b;
+                    p[i + k] = mod_reduce((a + offset - b) * zetas_[i * m]);
+                }
+            }
+            bound *= 2;
+            s += 1;
+        }
+    }
+}
+
+// Lazy DIT stages with half-lengths k_first, 2 * k_first, ... below k_end on block[0, len).
+// Only b * zeta is reduced, so each stage adds q to the bound; pairs run as one radix-4 pass.
+void ScalarNTTEngine::inverse_layers(uint32_t* block, size_t len, uint32_t k_first, uint32_t k_end,
+                                     uint32_t& bound) const {
+    uint32_t k = k_first;
+    while (k < k_end) {
+        const uint32_t m = n_ / (2 * k);
+        if (2 * k < k_end) {
+            if (bound + 1 > lazy_limit_) {
+                reduce_all(block, len);
+                bound = 1;
+            }
+            const uint32_t m2 = m / 2;
+            for (size_t start = 0; start < len; start += 4 * k) {
+                uint32_t* p = block + start;
+                for (uint32_t i = 0; i < k; ++i) {
+                    const uint32_t w = zetas_inv_[i * m];
+                    uint32_t t = mod_reduce(p[i + k] * w);
+                    uint32_t y0 = p[i] + t;
+                    uint32_t y1 = p[i] + q_ - t;
+                    t = mod_reduce(p[i + 3 * k] * w);
+                    uint32_t y2 = p[i + 2 * k] + t;
+                    uint32_t y3 = p[i + 2 * k] + q_ - t;
+                    t = mod_reduce(y2 * zetas_inv_[i * m2]);
+                    p[i] = y0 + t;
+                    p[i + 2 * k] = y0 + q_ - t;
+                    t = mod_reduce(y3 * zetas_inv_[(i + k) * m2]);
+                    p[i + k] = y1 + t;
+                    p[i + 3 * k] = y1 + q_ - t;
+                }
+            }
+            bound += 2;
+            k *= 4;
+        } else {
+            if (bound > lazy_limit_) {
+                reduce_all(block, len);
+                bound = 1;
+            }
+            for (size_t start = 0; start < len; start += 2 * k) {
+                uint32_t* p = block + start;
+                for (uint32_t i = 0; i < k; ++i) {
+                    uint32_t a = p[i];
+                    uint32_t t = mod_reduce(p[i + k] * zetas_inv_[i * m]);
+                    p[i] = a + t;
+                    p[i + k] = a + q_ - t;
+                }
+            }
+            bound += 1;
+            k *= 2;
+        }
+    }
 }
 
 void ScalarNTTEngine::ntt_forward(uint32_t* poly) const {
-    // Iterative NTT implementation
-    uint32_t m = 1;
-    uint32_t k = n_ / 2;
-
-    for (uint32_t stage = 0; stage < log_degree(); ++stage) {
-        uint32_t j = 0;
-        for (uint32_t i = 0; i < k; ++i) {
-            uint32_t zeta = zetas_[j];
-            butterfly(poly[i], poly[i + k], zeta);
-            j += m;
+    ntt_forward_batch(poly, 1);
+}
+
+void ScalarNTTEngine::ntt_forward_batch(uint32_t* poly, size_t count) const {
+    // Iterative decimation-in-frequency NTT, natural order in, bit-reversed order out
+    const size_t total = count * n_;
+    if (lazy_limit_ < 2) {
+        uint32_t m = 1;
+        uint32_t k = n_ / 2;
+        for (uint32_t stage = 0; stage < log_degree(); ++stage) {
+            for (size_t start = 0; start < total; start += 2 * k) {
+                uint32_t j = 0;
+                for (size_t i = start; i < start + k; ++i) {
+                    butterfly(poly[i], poly[i + k], zetas_[j]);
+                    j += m;
+                }
+            }
+            m *= 2;
+            k /= 2;
         }
-        m *= 2;
-        k /= 2;
+        return;
+    }
+
+    // Stages whose butterfly span n >> s exceeds a tile sweep the whole polynomial; the
+    // rest run tile by tile so each tile stays in L1 until it is fully transformed.
+    const uint32_t tile = tile_size();
+    uint32_t global_stages = 0;
+    while ((n_ >> global_stages) > tile) {
+        ++global_stages;
     }
+
+    uint32_t bound = 1;  // coefficients < bound * q
+    forward_layers(poly, total, 0, global_stages, bound);
+    check_lazy_bound(poly, static_cast<uint64_t>(bound) * q_, count);
+
+    uint32_t tile_bound = bound;
+    for (size_t t = 0; t < total; t += tile) {
+        tile_bound = bound;
+        forward_layers(poly + t, tile, global_stages, log_degree(), tile_bound);
+    }
+    check_lazy_bound(poly, static_cast<uint64_t>(tile_bound) * q_, count);
+    reduce_all(poly, total);
 }
 
 void ScalarNTTEngine::ntt_inverse(uint32_t* poly) const {
-    // Inverse NTT: similar to forward but with inverse zetas and scaling
-    uint32_t m = n_ / 2;
-    uint32_t k = 1;
-
-    for (uint32_t stage = 0; stage < log_degree(); ++stage) {
-        uint32_t j = 0;
-        for (uint32_t i = 0; i < k; ++i) {
-            uint32_t zeta = zetas_inv_[j];
-            butterfly_inv(poly[i], poly[i + k], zeta);
-            j += m;
+    ntt_inverse_batch(poly, 1);
+}
+
+void ScalarNTTEngine::ntt_inverse_batch(uint32_t* poly, size_t count) const {
+    // Iterative decimation-in-time inverse NTT, bit-reversed order in, natural order out (scaled by n)
+    const size_t total = count * n_;
+    if (lazy_limit_ < 2) {
+        uint32_t m = n_ / 2;
+        uint32_t k = 1;
+        for (uint32_t stage = 0; stage < log_degree(); ++stage) {
+            for (size_t start = 0; start < total; start += 2 * k) {
+                uint32_t j = 0;
+                for (size_t i = start; i < start + k; ++i) {
+                    butterfly_inv(poly[i], poly[i + k], zetas_inv_[j]);
+                    j += m;
+                }
+            }
+            m /= 2;
+            k *= 2;
         }
-        m /= 2;
-        k *= 2;
+        return;
     }
 
-    // Scale by n^(-1) mod q
-    uint32_t n_inv = mod_inverse(n_, q_);
-    for (uint32_t i = 0; i < n_; ++i) {
-        poly[i] = montgomery_reduce(static_cast<uint64_t>(poly[i]) * n_inv);
+    // Mirror of the forward schedule: tile-local stages first, then the wide ones
+    const uint32_t tile = tile_size();
+    uint32_t bound = 1;  // coefficients < bound * q
+    for (size_t t = 0; t < total; t += tile) {
+        bound = 1;
+        inverse_layers(poly + t, tile, 1, tile, bound);
     }
+    check_lazy_bound(poly, static_cast<uint64_t>(bound) * q_, count);
+
+    inverse_layers(poly, total, tile, n_, bound);
+    check_lazy_bound(poly, static_cast<uint64_t>(bound) * q_, count);
+    reduce_all(poly, total);
 }
 
-void ScalarNTTEngine::multiply(const uint32_t* a, const uint32_t* b, uint32_t* result) const {
-    // Copy inputs for NTT
-    std::vector<uint32_t> a_ntt(n_);
-    std::vector<uint32_t> b_ntt(n_);
-    std::copy(a, a + n_, a_ntt.begin());
-    std::copy(b, b + n_, b_ntt.begin());
+void ScalarNTTEngine::basemul_acc(const uint32_t* a, const uint32_t* b, size_t k, uint32_t* out) const {
+    if (!lazy_accumulation_fits(k)) {
+        NTTEngine::basemul_acc(a, b, k, out);
+        return;
+    }
+    // Raw products accumulate in 32 bits with one Barrett reduction per coefficient
+    std::fill(out, out + n_, 0u);
+    for (size_t j = 0; j < k; ++j) {
+        const uint32_t* aj = a + j * n_;
+        const uint32_t* bj = b + j * n_;
+        for (uint32_t i = 0; i < n_; ++i) {
+            out[i] += aj[i] * bj[i];
+        }
+    }
+    reduce_all(out, n_);
+}
 
-    // Forward NTT
-    ntt_forward(a_ntt.data());
-    ntt_forward(b_ntt.data());
+void ScalarNTTEngine::multiply_inplace(uint32_t* a, uint32_t* b) const {
+    ntt_forward(a);
+    ntt_forward(b);
 
-    // Pointwise multiplication with Montgomery reduction
+    // Pointwise multiplication
     for (uint32_t i = 0; i < n_; ++i) {
-        result[i] = montgomery_reduce(static_cast<uint64_t>(a_ntt[i]) * b_ntt[i]);
+        a[i] = mod_mul(a[i], b[i]);
     }
 
-    // Inverse NTT
-    ntt_inverse(result);
+    ntt_inverse(a);
 }
 
-} // namespace clwe
\ No newline at end of file
+} // namespace clwe
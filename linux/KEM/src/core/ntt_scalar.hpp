@@ -9,25 +9,31 @@ namespace clwe {
 
 class ScalarNTTEngine : public NTTEngine {
 private:
-    std::vector<uint32_t> zetas_;       // Precomputed zetas
-    std::vector<uint32_t> zetas_inv_;   // Inverse zetas
-
-    // Montgomery reduction constants
-    uint32_t montgomery_r_;       // 2^32 mod q
-    uint32_t montgomery_r_inv_;   // R^(-1) mod q
-
-    // Precompute zetas for NTT
-    void precompute_zetas();
+    // Twiddles shared by all engines with this (q, n), see ntt_tables.hpp
+    const uint32_t* zetas_;
+    const uint32_t* zetas_inv_;
 
     // Scalar butterfly operations
     void butterfly(uint32_t& a, uint32_t& b, uint32_t zeta) const;
     void butterfly_inv(uint32_t& a, uint32_t& b, uint32_t zeta) const;
 
+    // Barrett constant floor(2^32 / q)
+    uint32_t barrett_m_;
+    // Largest c with c * q * q < 2^32: coefficients may grow to c * q before a butterfly
+    // product overflows. Lazy stages need c >= 2, which holds for q < 2^15.
+    uint32_t lazy_limit_;
+
     // Modular reduction
     uint32_t mod_reduce(uint32_t val) const;
+    uint32_t mod_mul(uint32_t a, uint32_t b) const;
+
+    // Reduce every coefficient of poly[0, len) to [0, q)
+    void reduce_all(uint32_t* poly, size_t len) const;
 
-    // Montgomery reduction
-    uint32_t montgomery_reduce(uint64_t val) const;
+    // Merged-layer lazy kernels over one block (the full polynomial or one cache tile)
+    uint32_t tile_size() const;
+    void forward_layers(uint32_t* block, size_t len, uint32_t first, uint32_t last, uint32_t& bound) const;
+    void inverse_layers(uint32_t* block, size_t len, uint32_t k_first, uint32_t k_end, uint32_t& bound) const;
 
 public:
     ScalarNTTEngine(uint32_t q, uint32_t n);
@@ -36,7 +42,10 @@ public:
     // Implement pure virtual methods
     void ntt_forward(uint32_t* poly) const override;
     void ntt_inverse(uint32_t* poly) const override;
-    void multiply(const uint32_t* a, const uint32_t* b, uint32_t* result) const override;
+    void ntt_forward_batch(uint32_t* polys, size_t count) const override;
+    void ntt_inverse_batch(uint32_t* polys, size_t count) const override;
+    void multiply_inplace(uint32_t* a, uint32_t* b) const override;
+    void basemul_acc(const uint32_t* a, const uint32_t* b, size_t k, uint32_t* out) const override;
 
     SIMDSupport get_simd_support() const override { return SIMDSupport::NONE; }
 };
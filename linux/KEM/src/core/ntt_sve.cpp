@@ -0,0 +1,222 @@
+#include "ntt_sve.hpp"
+#include "ntt_tables.hpp"
+#include <arm_sve.h>
+
+namespace clwe {
+
+namespace {
+
+inline svuint32_t add_mod(svbool_t pg, svuint32_t a, svuint32_t b, uint32_t q) {
+    svuint32_t sum = svadd_u32_x(pg, a, b);
+    // sum - q wraps around exactly when sum < q, so the unsigned min picks the reduced value
+    return svmin_u32_x(pg, sum, svsub_n_u32_x(pg, sum, q));
+}
+
+inline svuint32_t sub_mod(svbool_t pg, svuint32_t a, svuint32_t b, uint32_t q) {
+    svuint32_t diff = svadd_n_u32_x(pg, svsub_u32_x(pg, a, b), q);
+    return svmin_u32_x(pg, diff, svsub_n_u32_x(pg, diff, q));
+}
+
+// Barrett reduction of any 32-bit lane value
+inline svuint32_t reduce(svbool_t pg, svuint32_t x, uint32_t q, uint32_t m) {
+    svuint32_t t = svmulh_n_u32_x(pg, x, m);
+    // The quotient is at most one short, leaving r < 2q
+    svuint32_t r = svmls_n_u32_x(pg, x, t, q);
+    return svmin_u32_x(pg, r, svsub_n_u32_x(pg, r, q));
+}
+
+inline svbool_t lanes(size_t i, size_t end) {
+    return svwhilelt_b32_u64(static_cast<uint64_t>(i), static_cast<uint64_t>(end));
+}
+
+} // namespace
+
+SVENTTEngine::SVENTTEngine(uint32_t q, uint32_t n)
+    : NTTEngine(q, n),
+      barrett_m_(static_cast<uint32_t>((1ULL << 32) / q)),
+      vector_path_(q < (1u << 16)),
+      vlmax_(static_cast<size_t>(svcntw())) {
+    NTTTableView tables = ntt_tables(q, n);
+    zetas_ = tables.zetas;
+    zetas_inv_ = tables.zetas_inv;
+    stage_zetas_ = tables.stage_zetas;
+    stage_zetas_inv_ = tables.stage_zetas_inv;
+}
+
+uint32_t SVENTTEngine::mod_mul(uint32_t a, uint32_t b) const {
+    return static_cast<uint32_t>((static_cast<uint64_t>(a) * b) % q_);
+}
+
+void SVENTTEngine::butterfly(uint32_t& a, uint32_t& b, uint32_t zeta) const {
+    uint32_t sum = a + b;
+    uint32_t reduce_mask = - (uint32_t)(sum >= q_);
+    sum -= reduce_mask & q_;
+    uint32_t diff = a - b;
+    uint32_t borrow_mask = - (uint32_t)(a < b);
+    diff += borrow_mask & q_;
+    a = sum;
+    b = mod_mul(diff, zeta);
+}
+
+void SVENTTEngine::butterfly_inv(uint32_t& a, uint32_t& b, uint32_t zeta) const {
+    uint32_t t = mod_mul(b, zeta);
+    uint32_t diff = a - t;
+    uint32_t borrow_mask = - (uint32_t)(a < t);
+    diff += borrow_mask & q_;
+    uint32_t sum = a + t;
+    uint32_t reduce_mask = - (uint32_t)(sum >= q_);
+    sum -= reduce_mask & q_;
+    a = sum;
+    b = diff;
+}
+
+void SVENTTEngine::ntt_forward(uint32_t* poly) const {
+    ntt_forward_batch(poly, 1);
+}
+
+void SVENTTEngine::ntt_forward_batch(uint32_t* poly, size_t count) const {
+    // Decimation-in-frequency NTT, natural order in, bit-reversed order out
+    const size_t total = count * n_;
+    uint32_t m = 1;
+    uint32_t k = n_ / 2;
+    const uint32_t* stage_zetas = stage_zetas_;
+
+    for (uint32_t stage = 0; stage < log_degree(); ++stage) {
+        if (vector_path_ && k >= vlmax_) {
+            for (size_t start = 0; start < total; start += 2 * k) {
+                for (size_t i = 0; i < k; i += vlmax_) {
+                    svbool_t pg = lanes(i, k);
+                    uint32_t* lo = poly + start + i;
+                    svuint32_t a = svld1_u32(pg, lo);
+                    svuint32_t b = svld1_u32(pg, lo + k);
+                    svuint32_t z = svld1_u32(pg, stage_zetas + i);
+                    svuint32_t diff = svmul_u32_x(pg, sub_mod(pg, a, b, q_), z);
+                    svst1_u32(pg, lo, add_mod(pg, a, b, q_));
+                    svst1_u32(pg, lo + k, reduce(pg, diff, q_, barrett_m_));
+                }
+            }
+        } else if (vector_path_) {
+            // Short stage: lane j holds butterfly i of block j, all sharing one twiddle
+            const size_t blocks = total / (2 * k);
+            const svuint32_t index = svindex_u32(0, 2 * k);
+            for (uint32_t i = 0; i < k; ++i) {
+                const uint32_t zeta = stage_zetas[i];
+                for (size_t blk = 0; blk < blocks; blk += vlmax_) {
+                    svbool_t pg = lanes(blk, blocks);
+                    uint32_t* lo = poly + blk * 2 * k + i;
+                    svuint32_t a = svld1_gather_u32index_u32(pg, lo, index);
+                    svuint32_t b = svld1_gather_u32index_u32(pg, lo + k, index);
+                    svuint32_t diff = svmul_n_u32_x(pg, sub_mod(pg, a, b, q_), zeta);
+                    svst1_scatter_u32index_u32(pg, lo, index, add_mod(pg, a, b, q_));
+                    svst1_scatter_u32index_u32(pg, lo + k, index, reduce(pg, diff, q_, barrett_m_));
+                }
+            }
+        } else {
+            for (size_t start = 0; start < total; start += 2 * k) {
+                uint32_t j = 0;
+                for (size_t i = start; i < start + k; ++i) {
+                    butterfly(poly[i], poly[i + k], zetas_[j]);
+                    j += m;
+                }
+            }
+        }
+        stage_zetas += k;
+        m *= 2;
+        k /= 2;
+    }
+}
+
+void SVENTTEngine::ntt_inverse(uint32_t* poly) const {
+    ntt_inverse_batch(poly, 1);
+}
+
+void SVENTTEngine::ntt_inverse_batch(uint32_t* poly, size_t count) const {
+    // Decimation-in-time inverse NTT, bit-reversed order in, natural order out (scaled by n)
+    const size_t total = count * n_;
+    uint32_t m = n_ / 2;
+    uint32_t k = 1;
+    const uint32_t* stage_zetas = stage_zetas_inv_ + (n_ - 1);
+
+    for (uint32_t stage = 0; stage < log_degree(); ++stage) {
+        stage_zetas -= k;
+        if (vector_path_ && k >= vlmax_) {
+            for (size_t start = 0; start < total; start += 2 * k) {
+                for (size_t i = 0; i < k; i += vlmax_) {
+                    svbool_t pg = lanes(i, k);
+                    uint32_t* lo = poly + start + i;
+                    svuint32_t a = svld1_u32(pg, lo);
+                    svuint32_t b = svld1_u32(pg, lo + k);
+                    svuint32_t z = svld1_u32(pg, stage_zetas + i);
+                    svuint32_t t = reduce(pg, svmul_u32_x(pg, b, z), q_, barrett_m_);
+                    svst1_u32(pg, lo, add_mod(pg, a, t, q_));
+                    svst1_u32(pg, lo + k, sub_mod(pg, a, t, q_));
+                }
+            }
+        } else if (vector_path_) {
+            const size_t blocks = total / (2 * k);
+            const svuint32_t index = svindex_u32(0, 2 * k);
+            for (uint32_t i = 0; i < k; ++i) {
+                const uint32_t zeta = stage_zetas[i];
+                for (size_t blk = 0; blk < blocks; blk += vlmax_) {
+                    svbool_t pg = lanes(blk, blocks);
+                    uint32_t* lo = poly + blk * 2 * k + i;
+                    svuint32_t a = svld1_gather_u32index_u32(pg, lo, index);
+                    svuint32_t b = svld1_gather_u32index_u32(pg, lo + k, index);
+                    svuint32_t t = reduce(pg, svmul_n_u32_x(pg, b, zeta), q_, barrett_m_);
+                    svst1_scatter_u32index_u32(pg, lo, index, add_mod(pg, a, t, q_));
+                    svst1_scatter_u32index_u32(pg, lo + k, index, sub_mod(pg, a, t, q_));
+                }
+            }
+        } else {
+            for (size_t start = 0; start < total; start += 2 * k) {
+                uint32_t j = 0;
+                for (size_t i = start; i < start + k; ++i) {
+                    butterfly_inv(poly[i], poly[i + k], zetas_inv_[j]);
+                    j += m;
+                }
+            }
+        }
+        m /= 2;
+        k *= 2;
+    }
+}
+
+void SVENTTEngine::multiply_inplace(uint32_t* a, uint32_t* b) const {
+    ntt_forward(a);
+    ntt_forward(b);
+    // Each output lane is stored after its inputs are loaded, so basemul_acc may write over a
+    basemul_acc(a, b, 1, a);
+    ntt_inverse(a);
+}
+
+void SVENTTEngine::basemul_acc(const uint32_t* a, const uint32_t* b, size_t k, uint32_t* out) const {
+    if (vector_path_) {
+        // When k raw products fit in 32 bits the sum is reduced once at the end
+        const bool lazy = lazy_accumulation_fits(k);
+        for (size_t i = 0; i < n_; i += vlmax_) {
+            svbool_t pg = lanes(i, n_);
+            svuint32_t acc = svdup_n_u32(0);
+            for (size_t j = 0; j < k; ++j) {
+                svuint32_t va = svld1_u32(pg, a + j * n_ + i);
+                svuint32_t vb = svld1_u32(pg, b + j * n_ + i);
+                if (lazy) {
+                    acc = svmla_u32_x(pg, acc, va, vb);
+                } else {
+                    svuint32_t p = reduce(pg, svmul_u32_x(pg, va, vb), q_, barrett_m_);
+                    acc = add_mod(pg, acc, p, q_);
+                }
+            }
+            svst1_u32(pg, out + i, lazy ? reduce(pg, acc, q_, barrett_m_) : acc);
+        }
+        return;
+    }
+    for (uint32_t i = 0; i < n_; ++i) {
+        uint64_t acc = 0;
+        for (size_t j = 0; j < k; ++j) {
+            acc += mod_mul(a[j * n_ + i], b[j * n_ + i]);
+        }
+        out[i] = static_cast<uint32_t>(acc % q_);
+    }
+}
+
+} // namespace clwe
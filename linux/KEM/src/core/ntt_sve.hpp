@@ -0,0 +1,54 @@
+#ifndef NTT_SVE_HPP
+#define NTT_SVE_HPP
+
+#include "ntt_engine.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace clwe {
+
+// ARM SVE NTT engine, bit-exact with ScalarNTTEngine. Vector-length agnostic like
+// RVVNTTEngine: every loop is predicated with WHILELT, so one binary fills 128-bit
+// (Graviton 4), 256-bit (Graviton 3) or wider units. Stages with half-length k >= VL run
+// contiguous butterflies, shorter ones run one twiddle across many blocks through
+// gather/scatter. Residues stay canonical in 32-bit lanes.
+//
+// The translation unit is compiled for +sve and only constructed when
+// CPUFeatures::has_sve is set; the rest of the library stays at the ARMv8-A baseline.
+class SVENTTEngine : public NTTEngine {
+private:
+    // Twiddles shared by all engines with this (q, n), see ntt_tables.hpp
+    const uint32_t* zetas_;
+    const uint32_t* zetas_inv_;
+    const uint32_t* stage_zetas_;
+    const uint32_t* stage_zetas_inv_;
+
+    // Barrett constant floor(2^32 / q); valid while q < 2^16 so products fit in 32 bits
+    uint32_t barrett_m_;
+    bool vector_path_;
+    // 32-bit lanes per vector on this core (VL / 32)
+    size_t vlmax_;
+
+    // Scalar butterflies for the q >= 2^16 fallback
+    void butterfly(uint32_t& a, uint32_t& b, uint32_t zeta) const;
+    void butterfly_inv(uint32_t& a, uint32_t& b, uint32_t zeta) const;
+    uint32_t mod_mul(uint32_t a, uint32_t b) const;
+
+public:
+    SVENTTEngine(uint32_t q, uint32_t n);
+    ~SVENTTEngine() override = default;
+
+    void ntt_forward(uint32_t* poly) const override;
+    void ntt_inverse(uint32_t* poly) const override;
+    void ntt_forward_batch(uint32_t* polys, size_t count) const override;
+    void ntt_inverse_batch(uint32_t* polys, size_t count) const override;
+    void multiply_inplace(uint32_t* a, uint32_t* b) const override;
+    void basemul_acc(const uint32_t* a, const uint32_t* b, size_t k, uint32_t* out) const override;
+
+    size_t vector_length() const { return vlmax_; }
+    SIMDSupport get_simd_support() const override { return SIMDSupport::SVE; }
+};
+
+} // namespace clwe
+
+#endif // NTT_SVE_HPP
@@ -0,0 +1,240 @@
+#include "ntt_tables.hpp"
+#include "library_allocator.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace clwe {
+
+namespace {
+
+// Least generator of Z_q^* for prime q, or 0 if none is found (q not prime)
+uint32_t least_generator(uint32_t q) {
+    std::vector<uint32_t> factors;
+    uint32_t rest = q - 1;
+    for (uint32_t p = 2; p * p <= rest; ++p) {
+        if (rest % p == 0) {
+            factors.push_back(p);
+            while (rest % p == 0) {
+                rest /= p;
+            }
+        }
+    }
+    if (rest > 1) {
+        factors.push_back(rest);
+    }
+    for (uint32_t g = 2; g < q; ++g) {
+        bool generates = true;
+        for (uint32_t p : factors) {
+            if (mod_pow(g, (q - 1) / p, q) == 1) {
+                generates = false;
+                break;
+            }
+        }
+        if (generates) {
+            return g;
+        }
+    }
+    return 0;
+}
+
+// Centered residue of value mod q, in (-q/2, q/2]
+int16_t centered(uint64_t value, uint32_t q) {
+    uint32_t r = static_cast<uint32_t>(value % q);
+    return static_cast<int16_t>(r > q / 2 ? static_cast<int32_t>(r) - static_cast<int32_t>(q) : r);
+}
+
+// Low 16 bits of a * b, the vpmullw / vmul result
+int16_t mullo16(int16_t a, int16_t b) {
+    return static_cast<int16_t>(static_cast<uint16_t>(static_cast<uint32_t>(static_cast<uint16_t>(a)) *
+                                                      static_cast<uint16_t>(b)));
+}
+
+template <uint32_t Q, uint32_t N, uint32_t LOG_N>
+struct StaticNTTTables {
+    std::array<uint32_t, N> zetas{};
+    std::array<uint32_t, N> zetas_inv{};
+    std::array<uint32_t, N> stage_zetas{};
+    std::array<uint32_t, N> stage_zetas_inv{};
+    std::array<uint32_t, N> bitrev{};
+};
+
+template <uint32_t Q, uint32_t N, uint32_t LOG_N>
+constexpr StaticNTTTables<Q, N, LOG_N> make_static_tables() {
+    StaticNTTTables<Q, N, LOG_N> t;
+    const uint32_t zeta = constexpr_mod_pow(NTT_ROOT_GENERATOR, (Q - 1) / N, Q);
+    const uint32_t zeta_inv = constexpr_mod_pow(zeta, Q - 2, Q);  // Q is prime
+    t.zetas[0] = 1;
+    t.zetas_inv[0] = 1;
+    for (uint32_t i = 1; i < N; ++i) {
+        t.zetas[i] = static_cast<uint32_t>(static_cast<uint64_t>(t.zetas[i - 1]) * zeta % Q);
+        t.zetas_inv[i] = static_cast<uint32_t>(static_cast<uint64_t>(t.zetas_inv[i - 1]) * zeta_inv % Q);
+    }
+    uint32_t pos = 0;
+    for (uint32_t stage = 0; stage < LOG_N; ++stage) {
+        for (uint32_t i = 0; i < (N >> (stage + 1)); ++i) {
+            t.stage_zetas[pos] = t.zetas[i << stage];
+            t.stage_zetas_inv[pos] = t.zetas_inv[i << stage];
+            ++pos;
+        }
+    }
+    for (uint32_t i = 0; i < N; ++i) {
+        uint32_t rev = 0;
+        for (uint32_t j = 0; j < LOG_N; ++j) {
+            rev |= ((i >> j) & 1) << (LOG_N - 1 - j);
+        }
+        t.bitrev[i] = rev;
+    }
+    return t;
+}
+
+constexpr StaticNTTTables<3329, 256, 8> STANDARD_TABLES = make_static_tables<3329, 256, 8>();
+
+// Built through the set_allocator() hooks current at first use and kept until exit
+struct DynamicNTTTables {
+    LibraryVector<uint32_t> zetas, zetas_inv, stage_zetas, stage_zetas_inv, bitrev;
+};
+
+std::unique_ptr<DynamicNTTTables> build_tables(uint32_t q, uint32_t n) {
+    auto t = std::make_unique<DynamicNTTTables>();
+    uint32_t log_n = 0;
+    while ((1u << log_n) < n) {
+        ++log_n;
+    }
+
+    t->zetas.resize(n);
+    t->zetas_inv.resize(n);
+    uint32_t zeta = 0;
+    ntt_root(q, n, zeta);
+    uint32_t zeta_inv = mod_inverse(zeta, q);
+    t->zetas[0] = 1;
+    t->zetas_inv[0] = 1;
+    for (uint32_t i = 1; i < n; ++i) {
+        t->zetas[i] = static_cast<uint32_t>(static_cast<uint64_t>(t->zetas[i - 1]) * zeta % q);
+        t->zetas_inv[i] = static_cast<uint32_t>(static_cast<uint64_t>(t->zetas_inv[i - 1]) * zeta_inv % q);
+    }
+
+    t->stage_zetas.reserve(n);
+    t->stage_zetas_inv.reserve(n);
+    for (uint32_t stage = 0; stage < log_n; ++stage) {
+        for (uint32_t i = 0; i < (n >> (stage + 1)); ++i) {
+            t->stage_zetas.push_back(t->zetas[i << stage]);
+            t->stage_zetas_inv.push_back(t->zetas_inv[i << stage]);
+        }
+    }
+
+    t->bitrev.resize(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        uint32_t rev = 0;
+        for (uint32_t j = 0; j < log_n; ++j) {
+            rev |= ((i >> j) & 1) << (log_n - 1 - j);
+        }
+        t->bitrev[i] = rev;
+    }
+    return t;
+}
+
+struct MontgomeryTables {
+    LibraryVector<int16_t> fwd_zetas, fwd_zetas_qinv, inv_zetas, inv_zetas_qinv;
+    LibraryVector<uint32_t> stage_offsets;
+};
+
+std::unique_ptr<MontgomeryTables> build_montgomery_tables(uint32_t q, uint32_t n, uint32_t lanes) {
+    auto t = std::make_unique<MontgomeryTables>();
+    NTTTableView tables = ntt_tables(q, n);
+    const int16_t qinv = static_cast<int16_t>(inverse_mod_2_16(q));
+    uint32_t log_n = 0;
+    while ((1u << log_n) < n) {
+        ++log_n;
+    }
+
+    t->stage_offsets.assign(std::max<uint32_t>(log_n, 1), 0);
+    uint32_t total = 0;
+    for (uint32_t k = 1, log_k = 0; k < n; k *= 2, ++log_k) {
+        t->stage_offsets[log_k] = total;
+        total += std::max(k, lanes);
+    }
+    t->fwd_zetas.resize(total);
+    t->fwd_zetas_qinv.resize(total);
+    t->inv_zetas.resize(total);
+    t->inv_zetas_qinv.resize(total);
+
+    // Half-length k uses the k twiddles at stage_zetas + (n - 2k) in both directions
+    for (uint32_t k = 1, log_k = 0; k < n; k *= 2, ++log_k) {
+        const uint32_t* fwd = tables.stage_zetas + (n - 2 * k);
+        const uint32_t* inv = tables.stage_zetas_inv + (n - 2 * k);
+        const uint32_t offset = t->stage_offsets[log_k];
+        for (uint32_t i = 0; i < std::max(k, lanes); ++i) {
+            const uint32_t j = i % k;
+            t->fwd_zetas[offset + i] = centered(static_cast<uint64_t>(fwd[j]) << 16, q);
+            t->inv_zetas[offset + i] = centered(static_cast<uint64_t>(inv[j]) << 16, q);
+            t->fwd_zetas_qinv[offset + i] = mullo16(t->fwd_zetas[offset + i], qinv);
+            t->inv_zetas_qinv[offset + i] = mullo16(t->inv_zetas[offset + i], qinv);
+        }
+    }
+    return t;
+}
+
+} // namespace
+
+uint16_t inverse_mod_2_16(uint32_t q) {
+    uint32_t inv = q;  // correct to 3 bits for odd q
+    for (int i = 0; i < 4; ++i) {
+        inv *= 2 - q * inv;
+    }
+    return static_cast<uint16_t>(inv);
+}
+
+bool ntt_root(uint32_t q, uint32_t n, uint32_t& root) {
+    root = mod_pow(NTT_ROOT_GENERATOR, (q - 1) / n, q);
+    if ((q - 1) % n != 0) {
+        return false;
+    }
+    // The order of root divides n; it is n exactly when root^(n/2) is -1 rather than 1
+    if (n == 1 || mod_pow(root, n / 2, q) == q - 1) {
+        return true;
+    }
+    const uint32_t generator = least_generator(q);
+    if (generator == 0) {
+        return false;
+    }
+    root = mod_pow(generator, (q - 1) / n, q);
+    return true;
+}
+
+NTTTableView ntt_tables(uint32_t q, uint32_t n) {
+    if (q == 3329 && n == 256) {
+        return {STANDARD_TABLES.zetas.data(), STANDARD_TABLES.zetas_inv.data(), STANDARD_TABLES.stage_zetas.data(),
+                STANDARD_TABLES.stage_zetas_inv.data(), STANDARD_TABLES.bitrev.data()};
+    }
+
+    static std::mutex mutex;
+    static std::map<std::pair<uint32_t, uint32_t>, std::unique_ptr<DynamicNTTTables>> cache;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& entry = cache[{q, n}];
+    if (!entry) {
+        entry = build_tables(q, n);
+    }
+    return {entry->zetas.data(), entry->zetas_inv.data(), entry->stage_zetas.data(), entry->stage_zetas_inv.data(),
+            entry->bitrev.data()};
+}
+
+NTTMontgomeryTableView ntt_montgomery_tables(uint32_t q, uint32_t n, uint32_t lanes) {
+    static std::mutex mutex;
+    static std::map<std::tuple<uint32_t, uint32_t, uint32_t>, std::unique_ptr<MontgomeryTables>> cache;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& entry = cache[std::make_tuple(q, n, lanes)];
+    if (!entry) {
+        entry = build_montgomery_tables(q, n, lanes);
+    }
+    return {entry->fwd_zetas.data(), entry->fwd_zetas_qinv.data(), entry->inv_zetas.data(),
+            entry->inv_zetas_qinv.data(), entry->stage_offsets.data()};
+}
+
+} // namespace clwe
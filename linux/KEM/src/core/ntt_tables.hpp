@@ -0,0 +1,94 @@
+#ifndef NTT_TABLES_HPP
+#define NTT_TABLES_HPP
+
+#include <cstdint>
+
+namespace clwe {
+
+// Read-only NTT tables for one (q, n), shared by every engine built for it. Roots are the
+// zeta of ntt_root and its inverse, in standard (non-Montgomery) form. Stage s with
+// half-length k = n >> (s + 1) stores zetas[i << s] for i < k in stage_zetas (n - 1 entries).
+struct NTTTableView {
+    const uint32_t* zetas;
+    const uint32_t* zetas_inv;
+    const uint32_t* stage_zetas;
+    const uint32_t* stage_zetas_inv;
+    const uint32_t* bitrev;
+};
+
+// The standard (3329, 256) tables are constexpr data; any other (q, n) is built on first
+// use and cached for the life of the process. The pointers never dangle.
+NTTTableView ntt_tables(uint32_t q, uint32_t n);
+
+// The n-th root of unity the tables of (q, n), q prime, are built on. Keeps zeta =
+// 17^((q - 1) / n) whenever it has order n, which covers (3329, 256) and every key made with
+// it; otherwise takes the matching power of the least generator of Z_q^*. Returns false when
+// no primitive n-th root exists (n does not divide q - 1): root is then still 17^((q - 1) / n),
+// and the transform built on it is not invertible.
+bool ntt_root(uint32_t q, uint32_t n, uint32_t& root);
+
+// Base of the 17^((q - 1) / n) root ntt_root prefers
+constexpr uint32_t NTT_ROOT_GENERATOR = 17;
+
+constexpr uint32_t constexpr_mod_pow(uint32_t base, uint32_t exp, uint32_t mod) {
+    uint64_t result = 1;
+    uint64_t b = base % mod;
+    while (exp > 0) {
+        if (exp & 1) {
+            result = result * b % mod;
+        }
+        b = b * b % mod;
+        exp >>= 1;
+    }
+    return static_cast<uint32_t>(result);
+}
+
+// ntt_root at compile time, for kernels that bake the twiddles of one (q, n) in as constants.
+// q must be prime with n dividing q - 1.
+constexpr uint32_t constexpr_ntt_root(uint32_t q, uint32_t n) {
+    const uint32_t root = constexpr_mod_pow(NTT_ROOT_GENERATOR, (q - 1) / n, q);
+    if (n == 1 || constexpr_mod_pow(root, n / 2, q) == q - 1) {
+        return root;
+    }
+    // Least generator: g^((q - 1) / p) != 1 for every prime p dividing q - 1
+    for (uint32_t g = 2; g < q; ++g) {
+        bool generates = true;
+        uint32_t rest = q - 1;
+        for (uint32_t p = 2; rest > 1 && generates; ++p) {
+            if (p * p > rest) {
+                p = rest;  // What remains is prime
+            }
+            if (rest % p == 0) {
+                generates = constexpr_mod_pow(g, (q - 1) / p, q) != 1;
+                while (rest % p == 0) {
+                    rest /= p;
+                }
+            }
+        }
+        if (generates) {
+            return constexpr_mod_pow(g, (q - 1) / n, q);
+        }
+    }
+    return 0;
+}
+
+// q^-1 mod 2^16 by Newton iteration, the Montgomery constant of every 16-bit kernel; q must be odd
+uint16_t inverse_mod_2_16(uint32_t q);
+
+// 16-bit Montgomery twiddles of (q, n) for kernels with lanes int16 lanes, odd q < 2^15:
+// zeta * 2^16 mod q, centered, and its product with q^-1 mod 2^16. Half-length k starts at
+// stage_offsets[log2(k)]; stages shorter than lanes are repeated to fill lanes entries,
+// lane l using twiddle l mod k. Built once per (q, n, lanes) and cached like ntt_tables.
+struct NTTMontgomeryTableView {
+    const int16_t* fwd_zetas;
+    const int16_t* fwd_zetas_qinv;
+    const int16_t* inv_zetas;
+    const int16_t* inv_zetas_qinv;
+    const uint32_t* stage_offsets;
+};
+
+NTTMontgomeryTableView ntt_montgomery_tables(uint32_t q, uint32_t n, uint32_t lanes);
+
+} // namespace clwe
+
+#endif // NTT_TABLES_HPP
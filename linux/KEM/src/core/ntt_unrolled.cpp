@@ -0,0 +1,32 @@
+#include "ntt_unrolled.hpp"
+
+namespace clwe {
+
+#ifdef CLWE_UNROLLED_NTT
+
+template class UnrolledNTTEngine<256, 3329>;
+template class UnrolledNTTEngine<512, 7681>;
+template class UnrolledNTTEngine<1024, 12289>;
+
+std::unique_ptr<NTTEngine> create_unrolled_ntt_engine(uint32_t q, uint32_t n) {
+    if (q == 3329 && n == 256) {
+        return std::make_unique<UnrolledNTTEngine<256, 3329>>();
+    }
+    if (q == 7681 && n == 512) {
+        return std::make_unique<UnrolledNTTEngine<512, 7681>>();
+    }
+    if (q == 12289 && n == 1024) {
+        return std::make_unique<UnrolledNTTEngine<1024, 12289>>();
+    }
+    return nullptr;
+}
+
+#else
+
+std::unique_ptr<NTTEngine> create_unrolled_ntt_engine(uint32_t, uint32_t) {
+    return nullptr;
+}
+
+#endif
+
+} // namespace clwe
@@ -0,0 +1,177 @@
+#ifndef NTT_UNROLLED_HPP
+#define NTT_UNROLLED_HPP
+
+#include "ntt_engine.hpp"
+#include "ntt_tables.hpp"
+#include "simd_target.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+namespace clwe {
+
+// Twiddles of one (N, Q) in butterfly order, computed by the compiler: forward stage s takes
+// zetas[i << s] for i < N >> (s + 1), inverse stage k = 1, 2, ..., N / 2 takes
+// zetas_inv[i * N / 2k] for i < k, each with its Shoup quotient floor(w * 2^32 / Q)
+template <uint32_t N, uint32_t Q>
+struct UnrolledNTTTwiddles {
+    std::array<uint32_t, N> forward{};
+    std::array<uint32_t, N> forward_shoup{};
+    std::array<uint32_t, N> inverse{};
+    std::array<uint32_t, N> inverse_shoup{};
+};
+
+template <uint32_t N, uint32_t Q>
+constexpr UnrolledNTTTwiddles<N, Q> make_unrolled_twiddles() {
+    std::array<uint32_t, N> zetas{};
+    std::array<uint32_t, N> zetas_inv{};
+    const uint32_t zeta = constexpr_ntt_root(Q, N);
+    const uint32_t zeta_inv = constexpr_mod_pow(zeta, Q - 2, Q);  // Q is prime
+    zetas[0] = 1;
+    zetas_inv[0] = 1;
+    for (uint32_t i = 1; i < N; ++i) {
+        zetas[i] = static_cast<uint32_t>(static_cast<uint64_t>(zetas[i - 1]) * zeta % Q);
+        zetas_inv[i] = static_cast<uint32_t>(static_cast<uint64_t>(zetas_inv[i - 1]) * zeta_inv % Q);
+    }
+
+    UnrolledNTTTwiddles<N, Q> t;
+    uint32_t pos = 0;
+    for (uint32_t stage = 0; (N >> (stage + 1)) > 0; ++stage) {
+        for (uint32_t i = 0; i < (N >> (stage + 1)); ++i, ++pos) {
+            t.forward[pos] = zetas[i << stage];
+            t.forward_shoup[pos] = static_cast<uint32_t>((static_cast<uint64_t>(t.forward[pos]) << 32) / Q);
+        }
+    }
+    pos = 0;
+    for (uint32_t k = 1; k < N; k <<= 1) {
+        for (uint32_t i = 0; i < k; ++i, ++pos) {
+            t.inverse[pos] = zetas_inv[i * (N / (2 * k))];
+            t.inverse_shoup[pos] = static_cast<uint32_t>((static_cast<uint64_t>(t.inverse[pos]) << 32) / Q);
+        }
+    }
+    return t;
+}
+
+// NTT for one fixed (N, Q), generated per stage at compile time: every stage is its own
+// instantiation with its half-length, block count and twiddle offset as constants, so loop
+// bounds, strides and the modulus are immediates the compiler unrolls and strength-reduces.
+// Same transform and domain order as ScalarNTTEngine, with every butterfly output fully
+// reduced (Shoup products). create_ntt_engine picks it for SIMDSupport::NONE when (q, n) has
+// an instantiation; other shapes keep the runtime-loop engines.
+template <uint32_t N, uint32_t Q>
+class UnrolledNTTEngine : public NTTEngine {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "N must be a power of 2");
+    static_assert((Q - 1) % N == 0, "Q must have a primitive N-th root of unity");
+    static_assert(Q < (1u << 16), "Pointwise products must fit in 32 bits");
+
+public:
+    UnrolledNTTEngine() : NTTEngine(Q, N) {
+        // The baked-in root must be the one every other engine (and every key) uses
+        if (ntt_tables(Q, N).zetas[1] != constexpr_ntt_root(Q, N)) {
+            throw std::logic_error("Unrolled NTT root does not match ntt_root");
+        }
+    }
+    ~UnrolledNTTEngine() override = default;
+
+    void ntt_forward(uint32_t* poly) const override { forward_stage<N / 2, 0>(poly); }
+
+    void ntt_inverse(uint32_t* poly) const override { inverse_stage<1, 0>(poly); }
+
+    void multiply_inplace(uint32_t* a, uint32_t* b) const override {
+        ntt_forward(a);
+        ntt_forward(b);
+        for (uint32_t i = 0; i < N; ++i) {
+            a[i] = a[i] * b[i] % Q;
+        }
+        ntt_inverse(a);
+    }
+
+    void basemul_acc(const uint32_t* a, const uint32_t* b, size_t k, uint32_t* out) const override {
+        if (!lazy_accumulation_fits(k)) {
+            NTTEngine::basemul_acc(a, b, k, out);
+            return;
+        }
+        // Raw products accumulate in 32 bits with one reduction by the constant Q per coefficient
+        std::fill(out, out + N, 0u);
+        for (size_t j = 0; j < k; ++j) {
+            const uint32_t* aj = a + j * N;
+            const uint32_t* bj = b + j * N;
+            for (uint32_t i = 0; i < N; ++i) {
+                out[i] += aj[i] * bj[i];
+            }
+        }
+        for (uint32_t i = 0; i < N; ++i) {
+            out[i] %= Q;
+        }
+    }
+
+    SIMDSupport get_simd_support() const override { return SIMDSupport::NONE; }
+
+private:
+    static constexpr UnrolledNTTTwiddles<N, Q> TWIDDLES = make_unrolled_twiddles<N, Q>();
+
+    // x - Q if x >= Q, for x < 2Q, without a branch
+    static CLWE_ALWAYS_INLINE uint32_t reduce_once(uint32_t x) {
+        x -= Q;
+        return x + ((0u - (x >> 31)) & Q);
+    }
+
+    // x * w mod Q for x < 2^32, with w_shoup = floor(w * 2^32 / Q)
+    static CLWE_ALWAYS_INLINE uint32_t mul_twiddle(uint32_t x, uint32_t w, uint32_t w_shoup) {
+        const uint32_t t = static_cast<uint32_t>((static_cast<uint64_t>(x) * w_shoup) >> 32);
+        return reduce_once(x * w - t * Q);
+    }
+
+    // DIF stage with half-length K; its twiddles start at OFFSET. Recurses into the next stage.
+    template <uint32_t K, uint32_t OFFSET>
+    static CLWE_ALWAYS_INLINE void forward_stage(uint32_t* poly) {
+        for (uint32_t j = 0; j < N; j += 2 * K) {
+            for (uint32_t i = 0; i < K; ++i) {
+                const uint32_t a = poly[j + i];
+                const uint32_t b = poly[j + i + K];
+                poly[j + i] = reduce_once(a + b);
+                poly[j + i + K] =
+                    mul_twiddle(a - b + Q, TWIDDLES.forward[OFFSET + i], TWIDDLES.forward_shoup[OFFSET + i]);
+            }
+        }
+        if constexpr (K > 1) {
+            forward_stage<K / 2, OFFSET + K>(poly);
+        }
+    }
+
+    // DIT stage with half-length K; its twiddles start at OFFSET. Recurses into the next stage.
+    template <uint32_t K, uint32_t OFFSET>
+    static CLWE_ALWAYS_INLINE void inverse_stage(uint32_t* poly) {
+        for (uint32_t j = 0; j < N; j += 2 * K) {
+            for (uint32_t i = 0; i < K; ++i) {
+                const uint32_t a = poly[j + i];
+                const uint32_t t =
+                    mul_twiddle(poly[j + i + K], TWIDDLES.inverse[OFFSET + i], TWIDDLES.inverse_shoup[OFFSET + i]);
+                poly[j + i] = reduce_once(a + t);
+                poly[j + i + K] = reduce_once(a - t + Q);
+            }
+        }
+        if constexpr (K < N / 2) {
+            inverse_stage<K * 2, OFFSET + K>(poly);
+        }
+    }
+};
+
+#ifdef CLWE_UNROLLED_NTT
+// Instantiated once in ntt_unrolled.cpp: the parameter-set shape and the NTT-friendly
+// degree-512 and degree-1024 shapes
+extern template class UnrolledNTTEngine<256, 3329>;
+extern template class UnrolledNTTEngine<512, 7681>;
+extern template class UnrolledNTTEngine<1024, 12289>;
+#endif
+
+// The unrolled engine for (q, n), or nullptr when there is none (or the build has
+// CLWE_UNROLLED_NTT off)
+std::unique_ptr<NTTEngine> create_unrolled_ntt_engine(uint32_t q, uint32_t n);
+
+} // namespace clwe
+
+#endif // NTT_UNROLLED_HPP
@@ -0,0 +1,300 @@
+#include "ntt_vsx.hpp"
+#include "ntt_tables.hpp"
+
+#if defined(HAVE_VSX) && defined(__POWER8_VECTOR__)
+#include <altivec.h>
+// vmuluwm / vmuleuw / vmrgew arrived with ISA 2.07; ppc64le always has them
+#define CLWE_VSX_KERNELS 1
+#endif
+
+namespace clwe {
+
+namespace {
+constexpr uint32_t VSX_LANES = 4;
+
+#ifdef CLWE_VSX_KERNELS
+using vu32 = __vector unsigned int;
+using vu64 = __vector unsigned long long;
+
+// High words of the four 32x32-bit lane products
+inline vu32 mulhi(vu32 a, vu32 b) {
+    vu32 even = (vu32)vec_mule(a, b);
+    vu32 odd = (vu32)vec_mulo(a, b);
+#if defined(__LITTLE_ENDIAN__)
+    return vec_mergeo(even, odd);
+#else
+    return vec_mergee(even, odd);
+#endif
+}
+
+// r < 2q to canonical: r - q wraps around exactly when r < q
+inline vu32 fold(vu32 r, vu32 q) {
+    return vec_min(r, r - q);
+}
+
+inline vu32 add_mod(vu32 a, vu32 b, vu32 q) {
+    return fold(a + b, q);
+}
+
+inline vu32 sub_mod(vu32 a, vu32 b, vu32 q) {
+    return fold(a - b + q, q);
+}
+
+// Barrett reduction of any 32-bit lane value; the quotient is at most one short
+inline vu32 reduce(vu32 x, vu32 q, vu32 m) {
+    return fold(x - mulhi(x, m) * q, q);
+}
+
+// b * w mod q for canonical b and a twiddle w with w_shoup = floor(w * 2^32 / q)
+inline vu32 mul_shoup(vu32 b, vu32 w, vu32 w_shoup, vu32 q) {
+    return fold(b * w - mulhi(b, w_shoup) * q, q);
+}
+
+inline vu32 load(const uint32_t* p) {
+    return vec_xl(0, p);
+}
+
+inline void store(uint32_t* p, vu32 v) {
+    vec_xst(v, 0, p);
+}
+
+// Element-order merges, so the same code is right on both endiannesses
+inline vu32 low_pairs(vu32 a, vu32 b) {
+    return (vu32)vec_mergeh((vu64)a, (vu64)b);
+}
+
+inline vu32 high_pairs(vu32 a, vu32 b) {
+    return (vu32)vec_mergel((vu64)a, (vu64)b);
+}
+#endif
+} // namespace
+
+VSXNTTEngine::VSXNTTEngine(uint32_t q, uint32_t n)
+    : NTTEngine(q, n),
+      barrett_m_(static_cast<uint32_t>((1ULL << 32) / q)),
+      vector_path_(q < (1u << 16)) {
+    NTTTableView tables = ntt_tables(q, n);
+    zetas_ = tables.zetas;
+    zetas_inv_ = tables.zetas_inv;
+    stage_zetas_ = tables.stage_zetas;
+    stage_zetas_inv_ = tables.stage_zetas_inv;
+
+    // The stages use n - 1 twiddles in total
+    stage_zetas_shoup_.resize(n);
+    stage_zetas_inv_shoup_.resize(n);
+    for (uint32_t i = 0; i + 1 < n; ++i) {
+        stage_zetas_shoup_[i] = static_cast<uint32_t>((static_cast<uint64_t>(stage_zetas_[i]) << 32) / q);
+        stage_zetas_inv_shoup_[i] = static_cast<uint32_t>((static_cast<uint64_t>(stage_zetas_inv_[i]) << 32) / q);
+    }
+}
+
+uint32_t VSXNTTEngine::mod_mul(uint32_t a, uint32_t b) const {
+    return static_cast<uint32_t>((static_cast<uint64_t>(a) * b) % q_);
+}
+
+void VSXNTTEngine::butterfly(uint32_t& a, uint32_t& b, uint32_t zeta) const {
+    uint32_t sum = a + b;
+    uint32_t reduce_mask = - (uint32_t)(sum >= q_);
+    sum -= reduce_mask & q_;
+    uint32_t diff = a - b;
+    uint32_t borrow_mask = - (uint32_t)(a < b);
+    diff += borrow_mask & q_;
+    a = sum;
+    b = mod_mul(diff, zeta);
+}
+
+void VSXNTTEngine::butterfly_inv(uint32_t& a, uint32_t& b, uint32_t zeta) const {
+    uint32_t t = mod_mul(b, zeta);
+    uint32_t diff = a - t;
+    uint32_t borrow_mask = - (uint32_t)(a < t);
+    diff += borrow_mask & q_;
+    uint32_t sum = a + t;
+    uint32_t reduce_mask = - (uint32_t)(sum >= q_);
+    sum -= reduce_mask & q_;
+    a = sum;
+    b = diff;
+}
+
+void VSXNTTEngine::ntt_forward(uint32_t* poly) const {
+    ntt_forward_batch(poly, 1);
+}
+
+void VSXNTTEngine::ntt_forward_batch(uint32_t* poly, size_t count) const {
+    // Decimation-in-frequency NTT, natural order in, bit-reversed order out
+    const size_t total = count * n_;
+    uint32_t m = 1;
+    uint32_t k = n_ / 2;
+    size_t offset = 0;
+#ifdef CLWE_VSX_KERNELS
+    const vu32 q_vec = vec_splats(q_);
+    // The paired short stages consume two registers per step
+    const bool pairs = vector_path_ && total % (2 * VSX_LANES) == 0;
+#endif
+
+    for (uint32_t stage = 0; stage < log_degree(); ++stage) {
+#ifdef CLWE_VSX_KERNELS
+        const uint32_t* z = stage_zetas_ + offset;
+        const uint32_t* zs = stage_zetas_shoup_.data() + offset;
+        if (vector_path_ && k >= VSX_LANES) {
+            for (size_t start = 0; start < total; start += 2 * k) {
+                for (uint32_t i = 0; i < k; i += VSX_LANES) {
+                    uint32_t* lo = poly + start + i;
+                    vu32 a = load(lo);
+                    vu32 b = load(lo + k);
+                    store(lo, add_mod(a, b, q_vec));
+                    store(lo + k, mul_shoup(sub_mod(a, b, q_vec), load(z + i), load(zs + i), q_vec));
+                }
+            }
+        } else if (pairs && k == 2) {
+            // x0..x7 -> a = {x0 x1 x4 x5}, b = {x2 x3 x6 x7}
+            const vu32 w = {z[0], z[1], z[0], z[1]};
+            const vu32 ws = {zs[0], zs[1], zs[0], zs[1]};
+            for (size_t start = 0; start < total; start += 2 * VSX_LANES) {
+                vu32 v0 = load(poly + start);
+                vu32 v1 = load(poly + start + VSX_LANES);
+                vu32 a = low_pairs(v0, v1);
+                vu32 b = high_pairs(v0, v1);
+                vu32 sum = add_mod(a, b, q_vec);
+                vu32 diff = mul_shoup(sub_mod(a, b, q_vec), w, ws, q_vec);
+                store(poly + start, low_pairs(sum, diff));
+                store(poly + start + VSX_LANES, high_pairs(sum, diff));
+            }
+        } else if (pairs && k == 1) {
+            // x0..x7 -> a = {x0 x4 x2 x6}, b = {x1 x5 x3 x7}
+            const vu32 w = vec_splats(z[0]);
+            const vu32 ws = vec_splats(zs[0]);
+            for (size_t start = 0; start < total; start += 2 * VSX_LANES) {
+                vu32 v0 = load(poly + start);
+                vu32 v1 = load(poly + start + VSX_LANES);
+                vu32 a = vec_mergee(v0, v1);
+                vu32 b = vec_mergeo(v0, v1);
+                vu32 sum = add_mod(a, b, q_vec);
+                vu32 diff = mul_shoup(sub_mod(a, b, q_vec), w, ws, q_vec);
+                store(poly + start, vec_mergee(sum, diff));
+                store(poly + start + VSX_LANES, vec_mergeo(sum, diff));
+            }
+        } else
+#endif
+        {
+            for (size_t start = 0; start < total; start += 2 * k) {
+                uint32_t j = 0;
+                for (size_t i = start; i < start + k; ++i) {
+                    butterfly(poly[i], poly[i + k], zetas_[j]);
+                    j += m;
+                }
+            }
+        }
+        offset += k;
+        m *= 2;
+        k /= 2;
+    }
+}
+
+void VSXNTTEngine::ntt_inverse(uint32_t* poly) const {
+    ntt_inverse_batch(poly, 1);
+}
+
+void VSXNTTEngine::ntt_inverse_batch(uint32_t* poly, size_t count) const {
+    // Decimation-in-time inverse NTT, bit-reversed order in, natural order out (scaled by n)
+    const size_t total = count * n_;
+    uint32_t m = n_ / 2;
+    uint32_t k = 1;
+    size_t offset = n_ - 1;
+#ifdef CLWE_VSX_KERNELS
+    const vu32 q_vec = vec_splats(q_);
+    const bool pairs = vector_path_ && total % (2 * VSX_LANES) == 0;
+#endif
+
+    for (uint32_t stage = 0; stage < log_degree(); ++stage) {
+        offset -= k;
+#ifdef CLWE_VSX_KERNELS
+        const uint32_t* z = stage_zetas_inv_ + offset;
+        const uint32_t* zs = stage_zetas_inv_shoup_.data() + offset;
+        if (vector_path_ && k >= VSX_LANES) {
+            for (size_t start = 0; start < total; start += 2 * k) {
+                for (uint32_t i = 0; i < k; i += VSX_LANES) {
+                    uint32_t* lo = poly + start + i;
+                    vu32 a = load(lo);
+                    vu32 t = mul_shoup(load(lo + k), load(z + i), load(zs + i), q_vec);
+                    store(lo, add_mod(a, t, q_vec));
+                    store(lo + k, sub_mod(a, t, q_vec));
+                }
+            }
+        } else if (pairs && k == 1) {
+            const vu32 w = vec_splats(z[0]);
+            const vu32 ws = vec_splats(zs[0]);
+            for (size_t start = 0; start < total; start += 2 * VSX_LANES) {
+                vu32 v0 = load(poly + start);
+                vu32 v1 = load(poly + start + VSX_LANES);
+                vu32 a = vec_mergee(v0, v1);
+                vu32 t = mul_shoup(vec_mergeo(v0, v1), w, ws, q_vec);
+                vu32 sum = add_mod(a, t, q_vec);
+                vu32 diff = sub_mod(a, t, q_vec);
+                store(poly + start, vec_mergee(sum, diff));
+                store(poly + start + VSX_LANES, vec_mergeo(sum, diff));
+            }
+        } else if (pairs && k == 2) {
+            const vu32 w = {z[0], z[1], z[0], z[1]};
+            const vu32 ws = {zs[0], zs[1], zs[0], zs[1]};
+            for (size_t start = 0; start < total; start += 2 * VSX_LANES) {
+                vu32 v0 = load(poly + start);
+                vu32 v1 = load(poly + start + VSX_LANES);
+                vu32 a = low_pairs(v0, v1);
+                vu32 t = mul_shoup(high_pairs(v0, v1), w, ws, q_vec);
+                vu32 sum = add_mod(a, t, q_vec);
+                vu32 diff = sub_mod(a, t, q_vec);
+                store(poly + start, low_pairs(sum, diff));
+                store(poly + start + VSX_LANES, high_pairs(sum, diff));
+            }
+        } else
+#endif
+        {
+            for (size_t start = 0; start < total; start += 2 * k) {
+                uint32_t j = 0;
+                for (size_t i = start; i < start + k; ++i) {
+                    butterfly_inv(poly[i], poly[i + k], zetas_inv_[j]);
+                    j += m;
+                }
+            }
+        }
+        m /= 2;
+        k *= 2;
+    }
+}
+
+void VSXNTTEngine::multiply_inplace(uint32_t* a, uint32_t* b) const {
+    ntt_forward(a);
+    ntt_forward(b);
+    // Each output lane is stored after its inputs are loaded, so basemul_acc may write over a
+    basemul_acc(a, b, 1, a);
+    ntt_inverse(a);
+}
+
+void VSXNTTEngine::basemul_acc(const uint32_t* a, const uint32_t* b, size_t k, uint32_t* out) const {
+    uint32_t i = 0;
+#ifdef CLWE_VSX_KERNELS
+    if (vector_path_) {
+        // When k raw products fit in 32 bits the sum is reduced once at the end
+        const vu32 q_vec = vec_splats(q_);
+        const vu32 m_vec = vec_splats(barrett_m_);
+        const bool lazy = lazy_accumulation_fits(k);
+        for (; i + VSX_LANES <= n_; i += VSX_LANES) {
+            vu32 acc = vec_splats(0u);
+            for (size_t j = 0; j < k; ++j) {
+                vu32 p = load(a + j * n_ + i) * load(b + j * n_ + i);
+                acc = lazy ? acc + p : add_mod(acc, reduce(p, q_vec, m_vec), q_vec);
+            }
+            store(out + i, lazy ? reduce(acc, q_vec, m_vec) : acc);
+        }
+    }
+#endif
+    for (; i < n_; ++i) {
+        uint64_t acc = 0;
+        for (size_t j = 0; j < k; ++j) {
+            acc += mod_mul(a[j * n_ + i], b[j * n_ + i]);
+        }
+        out[i] = static_cast<uint32_t>(acc % q_);
+    }
+}
+
+} // namespace clwe
@@ -0,0 +1,53 @@
+#ifndef NTT_VSX_HPP
+#define NTT_VSX_HPP
+
+#include "library_allocator.hpp"
+#include "ntt_engine.hpp"
+#include <cstdint>
+
+namespace clwe {
+
+// POWER VSX NTT engine: 4 uint32_t lanes per vector, bit-exact with ScalarNTTEngine.
+// Twiddle products use precomputed quotients (Shoup), data products use Barrett; both take
+// the high word from vec_mule/vec_mulo. The k = 2 and k = 1 stages pair lanes of two
+// registers through merges instead of dropping to scalar code.
+// The vector kernels need POWER8 (ISA 2.07) 32-bit multiplies; older VSX builds and
+// q >= 2^16 use the scalar butterflies.
+class VSXNTTEngine : public NTTEngine {
+private:
+    // Twiddles shared by all engines with this (q, n), see ntt_tables.hpp
+    const uint32_t* zetas_;
+    const uint32_t* zetas_inv_;
+    const uint32_t* stage_zetas_;
+    const uint32_t* stage_zetas_inv_;
+
+    // floor(zeta * 2^32 / q) for each entry of the stage tables, same layout
+    LibraryVector<uint32_t> stage_zetas_shoup_;
+    LibraryVector<uint32_t> stage_zetas_inv_shoup_;
+
+    // Barrett constant floor(2^32 / q); valid while q < 2^16 so products fit in 32 bits
+    uint32_t barrett_m_;
+    bool vector_path_;
+
+    // Scalar butterflies for the q >= 2^16 and pre-POWER8 fallback
+    void butterfly(uint32_t& a, uint32_t& b, uint32_t zeta) const;
+    void butterfly_inv(uint32_t& a, uint32_t& b, uint32_t zeta) const;
+    uint32_t mod_mul(uint32_t a, uint32_t b) const;
+
+public:
+    VSXNTTEngine(uint32_t q, uint32_t n);
+    ~VSXNTTEngine() override = default;
+
+    void ntt_forward(uint32_t* poly) const override;
+    void ntt_inverse(uint32_t* poly) const override;
+    void ntt_forward_batch(uint32_t* polys, size_t count) const override;
+    void ntt_inverse_batch(uint32_t* polys, size_t count) const override;
+    void multiply_inplace(uint32_t* a, uint32_t* b) const override;
+    void basemul_acc(const uint32_t* a, const uint32_t* b, size_t k, uint32_t* out) const override;
+
+    SIMDSupport get_simd_support() const override { return SIMDSupport::VSX; }
+};
+
+} // namespace clwe
+
+#endif // NTT_VSX_HPP
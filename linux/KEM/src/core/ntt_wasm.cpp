@@ -0,0 +1,290 @@
+#include "ntt_wasm.hpp"
+#include "ntt_tables.hpp"
+
+#include <wasm_simd128.h>
+
+namespace clwe {
+
+namespace {
+constexpr uint32_t WASM_LANES = 4;
+
+using vu32 = v128_t;
+
+inline vu32 splat(uint32_t x) {
+    return wasm_u32x4_splat(x);
+}
+
+// High words of the four 32x32-bit lane products
+inline vu32 mulhi(vu32 a, vu32 b) {
+    v128_t low = wasm_u64x2_extmul_low_u32x4(a, b);
+    v128_t high = wasm_u64x2_extmul_high_u32x4(a, b);
+    return wasm_i32x4_shuffle(low, high, 1, 3, 5, 7);
+}
+
+// r < 2q to canonical: r - q wraps around exactly when r < q
+inline vu32 fold(vu32 r, vu32 q) {
+    return wasm_u32x4_min(r, wasm_i32x4_sub(r, q));
+}
+
+inline vu32 add_mod(vu32 a, vu32 b, vu32 q) {
+    return fold(wasm_i32x4_add(a, b), q);
+}
+
+inline vu32 sub_mod(vu32 a, vu32 b, vu32 q) {
+    return fold(wasm_i32x4_add(wasm_i32x4_sub(a, b), q), q);
+}
+
+// Barrett reduction of any 32-bit lane value; the quotient is at most one short
+inline vu32 reduce(vu32 x, vu32 q, vu32 m) {
+    return fold(wasm_i32x4_sub(x, wasm_i32x4_mul(mulhi(x, m), q)), q);
+}
+
+// b * w mod q for canonical b and a twiddle w with w_shoup = floor(w * 2^32 / q)
+inline vu32 mul_shoup(vu32 b, vu32 w, vu32 w_shoup, vu32 q) {
+    return fold(wasm_i32x4_sub(wasm_i32x4_mul(b, w), wasm_i32x4_mul(mulhi(b, w_shoup), q)), q);
+}
+
+inline vu32 load(const uint32_t* p) {
+    return wasm_v128_load(p);
+}
+
+inline void store(uint32_t* p, vu32 v) {
+    wasm_v128_store(p, v);
+}
+
+// {a0 a1 b0 b1} and {a2 a3 b2 b3}
+inline vu32 low_pairs(vu32 a, vu32 b) {
+    return wasm_i32x4_shuffle(a, b, 0, 1, 4, 5);
+}
+
+inline vu32 high_pairs(vu32 a, vu32 b) {
+    return wasm_i32x4_shuffle(a, b, 2, 3, 6, 7);
+}
+
+// {a0 b0 a2 b2} and {a1 b1 a3 b3}
+inline vu32 even_lanes(vu32 a, vu32 b) {
+    return wasm_i32x4_shuffle(a, b, 0, 4, 2, 6);
+}
+
+inline vu32 odd_lanes(vu32 a, vu32 b) {
+    return wasm_i32x4_shuffle(a, b, 1, 5, 3, 7);
+}
+} // namespace
+
+WasmSIMD128NTTEngine::WasmSIMD128NTTEngine(uint32_t q, uint32_t n)
+    : NTTEngine(q, n),
+      barrett_m_(static_cast<uint32_t>((1ULL << 32) / q)),
+      vector_path_(q < (1u << 16)) {
+    NTTTableView tables = ntt_tables(q, n);
+    zetas_ = tables.zetas;
+    zetas_inv_ = tables.zetas_inv;
+    stage_zetas_ = tables.stage_zetas;
+    stage_zetas_inv_ = tables.stage_zetas_inv;
+
+    // The stages use n - 1 twiddles in total
+    stage_zetas_shoup_.resize(n);
+    stage_zetas_inv_shoup_.resize(n);
+    for (uint32_t i = 0; i + 1 < n; ++i) {
+        stage_zetas_shoup_[i] = static_cast<uint32_t>((static_cast<uint64_t>(stage_zetas_[i]) << 32) / q);
+        stage_zetas_inv_shoup_[i] = static_cast<uint32_t>((static_cast<uint64_t>(stage_zetas_inv_[i]) << 32) / q);
+    }
+}
+
+uint32_t WasmSIMD128NTTEngine::mod_mul(uint32_t a, uint32_t b) const {
+    return static_cast<uint32_t>((static_cast<uint64_t>(a) * b) % q_);
+}
+
+void WasmSIMD128NTTEngine::butterfly(uint32_t& a, uint32_t& b, uint32_t zeta) const {
+    uint32_t sum = a + b;
+    uint32_t reduce_mask = - (uint32_t)(sum >= q_);
+    sum -= reduce_mask & q_;
+    uint32_t diff = a - b;
+    uint32_t borrow_mask = - (uint32_t)(a < b);
+    diff += borrow_mask & q_;
+    a = sum;
+    b = mod_mul(diff, zeta);
+}
+
+void WasmSIMD128NTTEngine::butterfly_inv(uint32_t& a, uint32_t& b, uint32_t zeta) const {
+    uint32_t t = mod_mul(b, zeta);
+    uint32_t diff = a - t;
+    uint32_t borrow_mask = - (uint32_t)(a < t);
+    diff += borrow_mask & q_;
+    uint32_t sum = a + t;
+    uint32_t reduce_mask = - (uint32_t)(sum >= q_);
+    sum -= reduce_mask & q_;
+    a = sum;
+    b = diff;
+}
+
+void WasmSIMD128NTTEngine::ntt_forward(uint32_t* poly) const {
+    ntt_forward_batch(poly, 1);
+}
+
+void WasmSIMD128NTTEngine::ntt_forward_batch(uint32_t* poly, size_t count) const {
+    // Decimation-in-frequency NTT, natural order in, bit-reversed order out
+    const size_t total = count * n_;
+    uint32_t m = 1;
+    uint32_t k = n_ / 2;
+    size_t offset = 0;
+    const vu32 q_vec = splat(q_);
+    // The paired short stages consume two registers per step
+    const bool pairs = vector_path_ && total % (2 * WASM_LANES) == 0;
+
+    for (uint32_t stage = 0; stage < log_degree(); ++stage) {
+        const uint32_t* z = stage_zetas_ + offset;
+        const uint32_t* zs = stage_zetas_shoup_.data() + offset;
+        if (vector_path_ && k >= WASM_LANES) {
+            for (size_t start = 0; start < total; start += 2 * k) {
+                for (uint32_t i = 0; i < k; i += WASM_LANES) {
+                    uint32_t* lo = poly + start + i;
+                    vu32 a = load(lo);
+                    vu32 b = load(lo + k);
+                    store(lo, add_mod(a, b, q_vec));
+                    store(lo + k, mul_shoup(sub_mod(a, b, q_vec), load(z + i), load(zs + i), q_vec));
+                }
+            }
+        } else if (pairs && k == 2) {
+            // x0..x7 -> a = {x0 x1 x4 x5}, b = {x2 x3 x6 x7}
+            const vu32 w = wasm_u32x4_make(z[0], z[1], z[0], z[1]);
+            const vu32 ws = wasm_u32x4_make(zs[0], zs[1], zs[0], zs[1]);
+            for (size_t start = 0; start < total; start += 2 * WASM_LANES) {
+                vu32 v0 = load(poly + start);
+                vu32 v1 = load(poly + start + WASM_LANES);
+                vu32 a = low_pairs(v0, v1);
+                vu32 b = high_pairs(v0, v1);
+                vu32 sum = add_mod(a, b, q_vec);
+                vu32 diff = mul_shoup(sub_mod(a, b, q_vec), w, ws, q_vec);
+                store(poly + start, low_pairs(sum, diff));
+                store(poly + start + WASM_LANES, high_pairs(sum, diff));
+            }
+        } else if (pairs && k == 1) {
+            // x0..x7 -> a = {x0 x4 x2 x6}, b = {x1 x5 x3 x7}
+            const vu32 w = splat(z[0]);
+            const vu32 ws = splat(zs[0]);
+            for (size_t start = 0; start < total; start += 2 * WASM_LANES) {
+                vu32 v0 = load(poly + start);
+                vu32 v1 = load(poly + start + WASM_LANES);
+                vu32 a = even_lanes(v0, v1);
+                vu32 b = odd_lanes(v0, v1);
+                vu32 sum = add_mod(a, b, q_vec);
+                vu32 diff = mul_shoup(sub_mod(a, b, q_vec), w, ws, q_vec);
+                store(poly + start, even_lanes(sum, diff));
+                store(poly + start + WASM_LANES, odd_lanes(sum, diff));
+            }
+        } else {
+            for (size_t start = 0; start < total; start += 2 * k) {
+                uint32_t j = 0;
+                for (size_t i = start; i < start + k; ++i) {
+                    butterfly(poly[i], poly[i + k], zetas_[j]);
+                    j += m;
+                }
+            }
+        }
+        offset += k;
+        m *= 2;
+        k /= 2;
+    }
+}
+
+void WasmSIMD128NTTEngine::ntt_inverse(uint32_t* poly) const {
+    ntt_inverse_batch(poly, 1);
+}
+
+void WasmSIMD128NTTEngine::ntt_inverse_batch(uint32_t* poly, size_t count) const {
+    // Decimation-in-time inverse NTT, bit-reversed order in, natural order out (scaled by n)
+    const size_t total = count * n_;
+    uint32_t m = n_ / 2;
+    uint32_t k = 1;
+    size_t offset = n_ - 1;
+    const vu32 q_vec = splat(q_);
+    const bool pairs = vector_path_ && total % (2 * WASM_LANES) == 0;
+
+    for (uint32_t stage = 0; stage < log_degree(); ++stage) {
+        offset -= k;
+        const uint32_t* z = stage_zetas_inv_ + offset;
+        const uint32_t* zs = stage_zetas_inv_shoup_.data() + offset;
+        if (vector_path_ && k >= WASM_LANES) {
+            for (size_t start = 0; start < total; start += 2 * k) {
+                for (uint32_t i = 0; i < k; i += WASM_LANES) {
+                    uint32_t* lo = poly + start + i;
+                    vu32 a = load(lo);
+                    vu32 t = mul_shoup(load(lo + k), load(z + i), load(zs + i), q_vec);
+                    store(lo, add_mod(a, t, q_vec));
+                    store(lo + k, sub_mod(a, t, q_vec));
+                }
+            }
+        } else if (pairs && k == 1) {
+            const vu32 w = splat(z[0]);
+            const vu32 ws = splat(zs[0]);
+            for (size_t start = 0; start < total; start += 2 * WASM_LANES) {
+                vu32 v0 = load(poly + start);
+                vu32 v1 = load(poly + start + WASM_LANES);
+                vu32 a = even_lanes(v0, v1);
+                vu32 t = mul_shoup(odd_lanes(v0, v1), w, ws, q_vec);
+                vu32 sum = add_mod(a, t, q_vec);
+                vu32 diff = sub_mod(a, t, q_vec);
+                store(poly + start, even_lanes(sum, diff));
+                store(poly + start + WASM_LANES, odd_lanes(sum, diff));
+            }
+        } else if (pairs && k == 2) {
+            const vu32 w = wasm_u32x4_make(z[0], z[1], z[0], z[1]);
+            const vu32 ws = wasm_u32x4_make(zs[0], zs[1], zs[0], zs[1]);
+            for (size_t start = 0; start < total; start += 2 * WASM_LANES) {
+                vu32 v0 = load(poly + start);
+                vu32 v1 = load(poly + start + WASM_LANES);
+                vu32 a = low_pairs(v0, v1);
+                vu32 t = mul_shoup(high_pairs(v0, v1), w, ws, q_vec);
+                vu32 sum = add_mod(a, t, q_vec);
+                vu32 diff = sub_mod(a, t, q_vec);
+                store(poly + start, low_pairs(sum, diff));
+                store(poly + start + WASM_LANES, high_pairs(sum, diff));
+            }
+        } else {
+            for (size_t start = 0; start < total; start += 2 * k) {
+                uint32_t j = 0;
+                for (size_t i = start; i < start + k; ++i) {
+                    butterfly_inv(poly[i], poly[i + k], zetas_inv_[j]);
+                    j += m;
+                }
+            }
+        }
+        m /= 2;
+        k *= 2;
+    }
+}
+
+void WasmSIMD128NTTEngine::multiply_inplace(uint32_t* a, uint32_t* b) const {
+    ntt_forward(a);
+    ntt_forward(b);
+    // Each output lane is stored after its inputs are loaded, so basemul_acc may write over a
+    basemul_acc(a, b, 1, a);
+    ntt_inverse(a);
+}
+
+void WasmSIMD128NTTEngine::basemul_acc(const uint32_t* a, const uint32_t* b, size_t k, uint32_t* out) const {
+    uint32_t i = 0;
+    if (vector_path_) {
+        // When k raw products fit in 32 bits the sum is reduced once at the end
+        const vu32 q_vec = splat(q_);
+        const vu32 m_vec = splat(barrett_m_);
+        const bool lazy = lazy_accumulation_fits(k);
+        for (; i + WASM_LANES <= n_; i += WASM_LANES) {
+            vu32 acc = splat(0);
+            for (size_t j = 0; j < k; ++j) {
+                vu32 p = wasm_i32x4_mul(load(a + j * n_ + i), load(b + j * n_ + i));
+                acc = lazy ? wasm_i32x4_add(acc, p) : add_mod(acc, reduce(p, q_vec, m_vec), q_vec);
+            }
+            store(out + i, lazy ? reduce(acc, q_vec, m_vec) : acc);
+        }
+    }
+    for (; i < n_; ++i) {
+        uint64_t acc = 0;
+        for (size_t j = 0; j < k; ++j) {
+            acc += mod_mul(a[j * n_ + i], b[j * n_ + i]);
+        }
+        out[i] = static_cast<uint32_t>(acc % q_);
+    }
+}
+
+} // namespace clwe
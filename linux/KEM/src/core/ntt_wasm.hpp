@@ -0,0 +1,53 @@
+#ifndef NTT_WASM_HPP
+#define NTT_WASM_HPP
+
+#include "library_allocator.hpp"
+#include "ntt_engine.hpp"
+#include <cstdint>
+
+namespace clwe {
+
+// WebAssembly SIMD128 NTT engine: 4 uint32_t lanes per v128, bit-exact with ScalarNTTEngine.
+// Twiddle products use precomputed quotients (Shoup), data products use Barrett; SIMD128 has
+// no 32-bit high multiply, so the high words come from the two u64x2 extending multiplies.
+// The k = 2 and k = 1 stages pair lanes of two registers through shuffles.
+// Selected at compile time (-msimd128): a module built with it only loads on engines that
+// implement SIMD128. q >= 2^16 uses the scalar butterflies.
+class WasmSIMD128NTTEngine : public NTTEngine {
+private:
+    // Twiddles shared by all engines with this (q, n), see ntt_tables.hpp
+    const uint32_t* zetas_;
+    const uint32_t* zetas_inv_;
+    const uint32_t* stage_zetas_;
+    const uint32_t* stage_zetas_inv_;
+
+    // floor(zeta * 2^32 / q) for each entry of the stage tables, same layout
+    LibraryVector<uint32_t> stage_zetas_shoup_;
+    LibraryVector<uint32_t> stage_zetas_inv_shoup_;
+
+    // Barrett constant floor(2^32 / q); valid while q < 2^16 so products fit in 32 bits
+    uint32_t barrett_m_;
+    bool vector_path_;
+
+    // Scalar butterflies for the q >= 2^16 fallback
+    void butterfly(uint32_t& a, uint32_t& b, uint32_t zeta) const;
+    void butterfly_inv(uint32_t& a, uint32_t& b, uint32_t zeta) const;
+    uint32_t mod_mul(uint32_t a, uint32_t b) const;
+
+public:
+    WasmSIMD128NTTEngine(uint32_t q, uint32_t n);
+    ~WasmSIMD128NTTEngine() override = default;
+
+    void ntt_forward(uint32_t* poly) const override;
+    void ntt_inverse(uint32_t* poly) const override;
+    void ntt_forward_batch(uint32_t* polys, size_t count) const override;
+    void ntt_inverse_batch(uint32_t* polys, size_t count) const override;
+    void multiply_inplace(uint32_t* a, uint32_t* b) const override;
+    void basemul_acc(const uint32_t* a, const uint32_t* b, size_t k, uint32_t* out) const override;
+
+    SIMDSupport get_simd_support() const override { return SIMDSupport::WASM_SIMD128; }
+};
+
+} // namespace clwe
+
+#endif // NTT_WASM_HPP
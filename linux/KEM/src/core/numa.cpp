@@ -0,0 +1,197 @@
+#include "clwe/numa.hpp"
+#include <algorithm>
+#include <exception>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <fstream>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#endif
+
+namespace clwe {
+
+namespace {
+
+// Dense node index -> OS node id and the CPUs behind it
+struct NumaTopology {
+    std::vector<unsigned> node_ids;
+#if defined(_WIN32)
+    std::vector<GROUP_AFFINITY> affinities;
+#endif
+    std::vector<size_t> cpu_counts;
+};
+
+#if defined(__linux__)
+// Kernel list format: "0-3,8,10-11"
+std::vector<unsigned> parse_list(const std::string& text) {
+    std::vector<unsigned> values;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find(',', pos);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        const std::string range = text.substr(pos, end - pos);
+        pos = end + 1;
+        if (range.empty() || range.find_first_not_of("0123456789-\n") != std::string::npos) {
+            continue;
+        }
+        const size_t dash = range.find('-');
+        const unsigned first = static_cast<unsigned>(std::stoul(range.substr(0, dash)));
+        const unsigned last = dash == std::string::npos ? first
+                                                        : static_cast<unsigned>(std::stoul(range.substr(dash + 1)));
+        for (unsigned value = first; value <= last; ++value) {
+            values.push_back(value);
+        }
+    }
+    return values;
+}
+
+std::vector<unsigned> read_list(const std::string& path) {
+    std::ifstream file(path);
+    std::string text;
+    if (!std::getline(file, text)) {
+        return {};
+    }
+    return parse_list(text);
+}
+
+std::vector<unsigned> node_cpus(unsigned node_id) {
+    return read_list("/sys/devices/system/node/node" + std::to_string(node_id) + "/cpulist");
+}
+#endif
+
+NumaTopology detect_topology() {
+    NumaTopology topology;
+#if defined(__linux__)
+    for (unsigned id : read_list("/sys/devices/system/node/online")) {
+        const size_t cpus = node_cpus(id).size();
+        if (cpus != 0) {
+            topology.node_ids.push_back(id);
+            topology.cpu_counts.push_back(cpus);
+        }
+    }
+#elif defined(_WIN32)
+    ULONG highest = 0;
+    if (GetNumaHighestNodeNumber(&highest)) {
+        for (ULONG id = 0; id <= highest; ++id) {
+            GROUP_AFFINITY affinity{};
+            if (GetNumaNodeProcessorMaskEx(static_cast<USHORT>(id), &affinity) && affinity.Mask != 0) {
+                size_t cpus = 0;
+                for (KAFFINITY mask = affinity.Mask; mask != 0; mask &= mask - 1) {
+                    ++cpus;
+                }
+                topology.node_ids.push_back(static_cast<unsigned>(id));
+                topology.affinities.push_back(affinity);
+                topology.cpu_counts.push_back(cpus);
+            }
+        }
+    }
+#endif
+    if (topology.node_ids.empty()) {
+        // No NUMA information: one node holding every CPU
+        topology.node_ids.push_back(0);
+        topology.cpu_counts.push_back(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    return topology;
+}
+
+const NumaTopology& topology() {
+    static const NumaTopology detected = detect_topology();
+    return detected;
+}
+
+size_t dense_index(unsigned node_id) {
+    const std::vector<unsigned>& ids = topology().node_ids;
+    for (size_t i = 0; i < ids.size(); ++i) {
+        if (ids[i] == node_id) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+size_t numa_node_count() {
+    return topology().node_ids.size();
+}
+
+size_t current_numa_node() {
+    if (numa_node_count() == 1) {
+        return 0;
+    }
+#if defined(__linux__) && defined(SYS_getcpu)
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+        return dense_index(node);
+    }
+#elif defined(_WIN32)
+    PROCESSOR_NUMBER processor;
+    GetCurrentProcessorNumberEx(&processor);
+    USHORT node = 0;
+    if (GetNumaProcessorNodeEx(&processor, &node)) {
+        return dense_index(node);
+    }
+#endif
+    return 0;
+}
+
+size_t numa_node_cpu_count(size_t node) {
+    return node < numa_node_count() ? topology().cpu_counts[node] : 0;
+}
+
+bool bind_thread_to_numa_node(size_t node) {
+    if (node >= numa_node_count()) {
+        return false;
+    }
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (unsigned cpu : node_cpus(topology().node_ids[node])) {
+        if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    // The kernel intersects the set with the cpuset the process may use
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+    if (topology().affinities.empty()) {
+        return false;
+    }
+    return SetThreadGroupAffinity(GetCurrentThread(), &topology().affinities[node], nullptr) != 0;
+#else
+    return false;
+#endif
+}
+
+void run_on_numa_node(size_t node, const std::function<void()>& fn) {
+    std::exception_ptr error;
+    std::thread thread([&] {
+        bind_thread_to_numa_node(node);
+        try {
+            fn();
+        } catch (...) {
+            error = std::current_exception();
+        }
+    });
+    thread.join();
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+} // namespace clwe
@@ -0,0 +1,233 @@
+#include "clwe/numa_kem.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace clwe {
+
+namespace {
+
+// Parallel-for pool whose workers are bound to one node. The calling thread claims
+// tasks too, so a call finishes even while every worker is busy with other callers.
+class NodeExecutor {
+private:
+    struct Job {
+        size_t count;
+        const std::function<void(size_t)>* task;
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::exception_ptr error;
+
+        Job(size_t job_count, const std::function<void(size_t)>* job_task) : count(job_count), task(job_task) {}
+    };
+
+    std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::deque<std::shared_ptr<Job>> jobs_;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+
+    static void work_on(Job& job) {
+        for (;;) {
+            const size_t index = job.next.fetch_add(1, std::memory_order_relaxed);
+            if (index >= job.count) {
+                return;
+            }
+            try {
+                (*job.task)(index);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(job.mutex);
+                if (!job.error) {
+                    job.error = std::current_exception();
+                }
+            }
+            if (job.done.fetch_add(1, std::memory_order_acq_rel) + 1 == job.count) {
+                std::lock_guard<std::mutex> lock(job.mutex);
+                job.finished.notify_all();
+            }
+        }
+    }
+
+    void run_worker(size_t node) {
+        bind_thread_to_numa_node(node);
+        for (;;) {
+            std::shared_ptr<Job> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                work_cv_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+                if (stopping_) {
+                    return;
+                }
+                job = jobs_.front();
+                if (job->next.load(std::memory_order_relaxed) >= job->count) {
+                    // Every task is claimed; the remaining ones finish on their threads
+                    jobs_.pop_front();
+                    continue;
+                }
+            }
+            work_on(*job);
+        }
+    }
+
+public:
+    NodeExecutor(size_t node, size_t threads) {
+        for (size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back(&NodeExecutor::run_worker, this, node);
+        }
+    }
+
+    ~NodeExecutor() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        work_cv_.notify_all();
+        for (std::thread& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    NodeExecutor(const NodeExecutor&) = delete;
+    NodeExecutor& operator=(const NodeExecutor&) = delete;
+
+    void run(size_t count, const std::function<void(size_t)>& task) {
+        auto job = std::make_shared<Job>(count, &task);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            jobs_.push_back(job);
+        }
+        work_cv_.notify_all();
+
+        work_on(*job);
+        {
+            std::unique_lock<std::mutex> lock(job->mutex);
+            job->finished.wait(lock, [&] { return job->done.load(std::memory_order_acquire) == count; });
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = std::find(jobs_.begin(), jobs_.end(), job);
+            if (it != jobs_.end()) {
+                jobs_.erase(it);
+            }
+        }
+        if (job->error) {
+            std::rethrow_exception(job->error);
+        }
+    }
+};
+
+} // namespace
+
+struct NumaKemShards::Impl {
+    struct Shard {
+        std::unique_ptr<ColorKEM> kem;
+        std::unique_ptr<KeygenPool> pool;
+    };
+
+    const CLWEParameters params;
+    std::vector<Shard> shards;
+
+    explicit Impl(const CLWEParameters& shard_params) : params(shard_params) {}
+
+    Shard& shard(size_t node) {
+        if (node >= shards.size()) {
+            throw std::invalid_argument("NUMA node " + std::to_string(node) + " out of range, " +
+                                        std::to_string(shards.size()) + " shards");
+        }
+        return shards[node];
+    }
+
+    // Outside the node range only if the topology reports a CPU it did not list
+    Shard& local() {
+        return shards[std::min(current_numa_node(), shards.size() - 1)];
+    }
+};
+
+NumaKemShards::NumaKemShards(const CLWEParameters& params, const NumaShardConfig& config)
+    : impl_(new Impl(params)) {
+    const size_t nodes = numa_node_count();
+    impl_->shards.resize(nodes);
+    for (size_t node = 0; node < nodes; ++node) {
+        Impl::Shard& shard = impl_->shards[node];
+        // The engine lookup and the cache containers happen on the node
+        run_on_numa_node(node, [&] {
+            shard.kem.reset(new ColorKEM(params));
+            if (!config.executors) {
+                return;
+            }
+            size_t threads = config.executor_threads;
+            if (threads == 0) {
+                threads = std::max<size_t>(1, numa_node_cpu_count(node)) - 1;
+            }
+            if (threads == 0) {
+                return;  // A single CPU: the caller alone, serial is cheaper
+            }
+            auto executor = std::make_shared<NodeExecutor>(node, threads);
+            shard.kem->set_executor(
+                [executor](size_t count, const std::function<void(size_t)>& task) { executor->run(count, task); },
+                config.parallel_min_rank);
+        });
+        if (config.key_pools) {
+            KeygenPoolConfig pool_config = config.key_pool;
+            pool_config.numa_node = node;
+            shard.pool.reset(new KeygenPool(params, pool_config));
+        }
+    }
+}
+
+NumaKemShards::~NumaKemShards() = default;
+
+size_t NumaKemShards::node_count() const {
+    return impl_->shards.size();
+}
+
+ColorKEM& NumaKemShards::kem() {
+    return *impl_->local().kem;
+}
+
+ColorKEM& NumaKemShards::kem(size_t node) {
+    return *impl_->shard(node).kem;
+}
+
+bool NumaKemShards::has_key_pools() const {
+    return impl_->shards.front().pool != nullptr;
+}
+
+KeygenPool& NumaKemShards::key_pool() {
+    if (!has_key_pools()) {
+        throw std::logic_error("NumaKemShards built without key pools");
+    }
+    return *impl_->local().pool;
+}
+
+KeygenPool& NumaKemShards::key_pool(size_t node) {
+    Impl::Shard& shard = impl_->shard(node);
+    if (!shard.pool) {
+        throw std::logic_error("NumaKemShards built without key pools");
+    }
+    return *shard.pool;
+}
+
+NumaKemShards::KeyPair NumaKemShards::pop_keys() {
+    Impl::Shard& shard = impl_->local();
+    if (shard.pool) {
+        return shard.pool->pop();
+    }
+    return shard.kem->keygen();
+}
+
+const CLWEParameters& NumaKemShards::params() const {
+    return impl_->params;
+}
+
+} // namespace clwe
@@ -0,0 +1,252 @@
+#include "page_allocator.hpp"
+#include "library_allocator.hpp"
+#include "secure_memory_pool.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(__linux__)
+#include <fstream>
+#include <sys/mman.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#endif
+
+namespace clwe {
+
+namespace {
+
+constexpr size_t REGION_ALIGNMENT = 64;
+
+PagePolicy initial_policy() {
+    PagePolicy policy;
+    const char* env = std::getenv("CLWE_PAGE_POLICY");
+    if (env != nullptr && parse_page_policy(env, policy)) {
+        return policy;
+    }
+    return PagePolicy::Normal;
+}
+
+std::atomic<PagePolicy>& current_policy() {
+    static std::atomic<PagePolicy> policy{initial_policy()};
+    return policy;
+}
+
+size_t round_up(size_t bytes, size_t granule) {
+    return (bytes + granule - 1) / granule * granule;
+}
+
+#if defined(__linux__)
+// Hugepagesize from /proc/meminfo; without a hugetlbfs pool, the PMD size THP uses
+size_t detect_huge_page_size() {
+    std::ifstream meminfo("/proc/meminfo");
+    std::string key;
+    while (meminfo >> key) {
+        if (key == "Hugepagesize:") {
+            size_t kib = 0;
+            meminfo >> kib;
+            return kib * 1024;
+        }
+        meminfo.ignore(256, '\n');
+    }
+    std::ifstream pmd("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size");
+    size_t bytes = 0;
+    return pmd >> bytes ? bytes : 0;
+}
+#elif defined(_WIN32)
+// MEM_LARGE_PAGES needs SeLockMemoryPrivilege enabled in the process token; tried once
+bool enable_lock_memory_privilege() {
+    static const bool enabled = [] {
+        HANDLE token;
+        if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) {
+            return false;
+        }
+        TOKEN_PRIVILEGES privileges{};
+        privileges.PrivilegeCount = 1;
+        privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+        bool ok = LookupPrivilegeValue(nullptr, SE_LOCK_MEMORY_NAME, &privileges.Privileges[0].Luid) &&
+                  AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr) &&
+                  GetLastError() == ERROR_SUCCESS;
+        CloseHandle(token);
+        return ok;
+    }();
+    return enabled;
+}
+#endif
+
+// Huge-page attempts in order of preference; an empty region when the OS refuses all
+PageRegion map_huge_region(size_t bytes) {
+    const size_t huge = huge_page_size();
+    if (huge == 0) {
+        return {};
+    }
+    const size_t size = round_up(bytes, huge);
+#if defined(__linux__)
+    void* mapping = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (mapping != MAP_FAILED) {
+        return {static_cast<uint8_t*>(mapping), size, PageBacking::HugePages};
+    }
+#endif
+    // No hugetlbfs pool: over-map by one huge page and trim, so the region covers whole
+    // aligned huge pages the kernel can promote
+    const size_t span = size + huge;
+    mapping = mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        return {};
+    }
+    const uintptr_t base = reinterpret_cast<uintptr_t>(mapping);
+    const uintptr_t start = (base + huge - 1) & ~(static_cast<uintptr_t>(huge) - 1);
+    const size_t head = start - base;
+    const size_t tail = span - head - size;
+    if (head != 0) {
+        munmap(mapping, head);
+    }
+    if (tail != 0) {
+        munmap(reinterpret_cast<void*>(start + size), tail);
+    }
+    PageBacking backing = PageBacking::Pages;
+#ifdef MADV_HUGEPAGE
+    if (madvise(reinterpret_cast<void*>(start), size, MADV_HUGEPAGE) == 0) {
+        backing = PageBacking::TransparentHugePages;
+    }
+#endif
+    return {reinterpret_cast<uint8_t*>(start), size, backing};
+#elif defined(_WIN32)
+    if (!enable_lock_memory_privilege()) {
+        return {};
+    }
+    void* mapping = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+    if (mapping == nullptr) {
+        return {};
+    }
+    return {static_cast<uint8_t*>(mapping), size, PageBacking::HugePages};
+#else
+    (void)size;
+    return {};
+#endif
+}
+
+} // namespace
+
+PagePolicy page_policy() {
+    return current_policy().load(std::memory_order_acquire);
+}
+
+void set_page_policy(PagePolicy policy) {
+    current_policy().store(policy, std::memory_order_release);
+}
+
+const char* page_policy_name(PagePolicy policy) {
+    switch (policy) {
+        case PagePolicy::Normal: return "normal";
+        case PagePolicy::Huge: return "huge";
+    }
+    return "unknown";
+}
+
+bool parse_page_policy(const std::string& name, PagePolicy& policy) {
+    if (name == "normal") policy = PagePolicy::Normal;
+    else if (name == "huge") policy = PagePolicy::Huge;
+    else return false;
+    return true;
+}
+
+size_t huge_page_size() {
+#if defined(__linux__)
+    static const size_t size = detect_huge_page_size();
+    return size;
+#elif defined(_WIN32)
+    return GetLargePageMinimum();
+#else
+    return 0;
+#endif
+}
+
+const char* page_backing_name(PageBacking backing) {
+    switch (backing) {
+        case PageBacking::Heap: return "heap";
+        case PageBacking::Pages: return "pages";
+        case PageBacking::TransparentHugePages: return "thp";
+        case PageBacking::HugePages: return "huge";
+        case PageBacking::SecurePool: return "secure";
+    }
+    return "unknown";
+}
+
+PageRegion allocate_page_region(size_t bytes, PagePolicy policy) {
+    if (bytes == 0) {
+        return {};
+    }
+    if (policy == PagePolicy::Huge) {
+        // Fresh anonymous mappings are already zero
+        PageRegion region = map_huge_region(bytes);
+        if (region.data != nullptr) {
+            return region;
+        }
+    }
+
+    const size_t size = round_up(bytes, REGION_ALIGNMENT);
+    const AllocatorHooks* hooks = current_allocator();
+    void* raw = allocate_with(hooks, size, REGION_ALIGNMENT);
+    std::memset(raw, 0, size);
+    return {static_cast<uint8_t*>(raw), size, PageBacking::Heap, hooks};
+}
+
+PageRegion allocate_secret_page_region(size_t bytes, PagePolicy policy) {
+    if (bytes != 0) {
+        // Pool slots start zeroed and are wiped when released
+        void* slot = secure_pool_allocate(bytes, REGION_ALIGNMENT);
+        if (slot != nullptr) {
+            return {static_cast<uint8_t*>(slot), secure_pool_slot_size(bytes), PageBacking::SecurePool};
+        }
+    }
+    return allocate_page_region(bytes, policy);
+}
+
+void release_page_region(const PageRegion& region) {
+    if (region.data == nullptr) {
+        return;
+    }
+    if (region.backing == PageBacking::SecurePool) {
+        secure_pool_release(region.data, region.size);
+        return;
+    }
+    if (region.backing == PageBacking::Heap) {
+        deallocate_with(region.hooks, region.data, region.size, REGION_ALIGNMENT);
+        return;
+    }
+#if defined(__linux__)
+    munmap(region.data, region.size);
+#elif defined(_WIN32)
+    VirtualFree(region.data, 0, MEM_RELEASE);
+#endif
+}
+
+bool advise_huge_pages(const void* data, size_t bytes) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (data == nullptr || bytes == 0) {
+        return false;
+    }
+    // madvise wants a page-aligned start
+    const uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(data) & ~(page - 1);
+    const uintptr_t end = reinterpret_cast<uintptr_t>(data) + bytes;
+    return madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE) == 0;
+#else
+    (void)data;
+    (void)bytes;
+    return false;
+#endif
+}
+
+} // namespace clwe
@@ -0,0 +1,36 @@
+#ifndef PAGE_ALLOCATOR_HPP
+#define PAGE_ALLOCATOR_HPP
+
+#include "clwe/allocator.hpp"
+#include "clwe/page_allocation.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace clwe {
+
+// Zeroed, 64-byte aligned memory for long-lived buffers; size is what was actually
+// reserved, a whole number of huge pages for the huge-page backings
+struct PageRegion {
+    uint8_t* data = nullptr;
+    size_t size = 0;
+    PageBacking backing = PageBacking::Heap;
+    const AllocatorHooks* hooks = nullptr;  // What a Heap region is freed through
+};
+
+// Under PagePolicy::Huge: explicit huge pages, then transparent huge pages (Linux),
+// then normal mapped pages; otherwise, and where the OS maps nothing, the set_allocator()
+// hooks (by default aligned operator new, which AllocationTracker sees). Throws
+// std::bad_alloc when every path fails.
+PageRegion allocate_page_region(size_t bytes, PagePolicy policy);
+// For buffers that hold secrets: a slot of the secure memory pool when it is enabled and
+// has room (which takes precedence over huge pages), else allocate_page_region()
+PageRegion allocate_secret_page_region(size_t bytes, PagePolicy policy);
+void release_page_region(const PageRegion& region);
+
+// Ask for huge pages behind an existing mapping (a read-only file mapping on Linux,
+// which needs CONFIG_READ_ONLY_THP_FOR_FS); false where the OS declines
+bool advise_huge_pages(const void* data, size_t bytes);
+
+} // namespace clwe
+
+#endif // PAGE_ALLOCATOR_HPP
@@ -1,10 +1,83 @@
 #include "clwe/clwe.hpp"
+#include "ring_operations.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <string>
 
 namespace clwe {
 
-// Utility function to get error message
-std::string get_error_message(CLWEError error) {
+namespace {
+
+// Centered representative of x mod q, in (-q/2, q/2]
+int64_t centered(int64_t x, uint32_t modulus) {
+    int64_t q = modulus;
+    x %= q;
+    if (x < 0) {
+        x += q;
+    }
+    return x > q / 2 ? x - q : x;
+}
+
+// Mean square of the rounding error of round_trip over x uniform mod q
+template<typename RoundTrip>
+double rounding_variance(uint32_t modulus, RoundTrip round_trip) {
+    double sum = 0.0;
+    for (uint32_t x = 0; x < modulus; ++x) {
+        double error = static_cast<double>(centered(static_cast<int64_t>(round_trip(x)) - x, modulus));
+        sum += error * error;
+    }
+    return sum / modulus;
+}
+
+// log2 erfc(x), with the asymptotic series once erfc underflows a double
+double log2_erfc(double x) {
+    if (x < 25.0) {
+        return std::log2(std::erfc(x));
+    }
+    const double pi = 3.14159265358979323846;
+    return (-x * x - std::log(x * std::sqrt(pi)) + std::log1p(-1.0 / (2.0 * x * x))) / std::log(2.0);
+}
+
+} // namespace
+
+double decapsulation_failure_log2(const CLWEParameters& params) {
+    params.validate();
+    const uint32_t q = params.modulus;
+    // Centered binomial variances, or h / n for a fixed-weight ternary s
+    const double var_e = params.eta1 / 2.0;  // e and r
+    const double var_e1 = params.eta2 / 2.0;  // e1 and e2
+    const double var_s = params.secret_weight != 0 ? static_cast<double>(params.secret_weight) / params.degree
+                                                   : var_e;
+
+    double var_t0 = 0.0;
+    if (params.t_dropped_bits != 0) {
+        const uint32_t d = params.t_dropped_bits;
+        const uint32_t half = (1u << (d - 1)) - 1;
+        var_t0 = rounding_variance(q, [&](uint32_t t) { return static_cast<uint64_t>((t + half) >> d) << d; });
+    }
+    double var_cu = 0.0;
+    double var_cv = 0.0;
+    if (params.du != 0) {
+        var_cu = rounding_variance(q, [&](uint32_t u) {
+            return decompress_coefficient(compress_coefficient(u, params.du, q), params.du, q);
+        });
+        var_cv = rounding_variance(q, [&](uint32_t v) {
+            return decompress_coefficient(compress_coefficient(v, params.dv, q), params.dv, q);
+        });
+    }
+
+    // e^T r + t0^T r - s^T (e1 + cu) + e2 + cv, each product a sum of k * n terms
+    const double terms = static_cast<double>(params.module_rank) * params.degree;
+    const double variance = terms * (var_e * var_e + var_t0 * var_e + var_s * var_e1 + var_s * var_cu) +
+                            var_e1 + var_cv;
+    // A coefficient decodes wrongly once its error reaches q/4
+    const double x = (q / 4.0) / std::sqrt(2.0 * variance);
+    const double decoded = params.sparse_c2 ? 1.0 : params.degree;
+    return std::min(0.0, std::log2(decoded) + log2_erfc(x));
+}
+
+const char* error_string(CLWEError error) noexcept {
     switch (error) {
         case CLWEError::SUCCESS:
             return "Success";
@@ -18,10 +91,19 @@ std::string get_error_message(CLWEError error) {
             return "Invalid key";
         case CLWEError::VERIFICATION_FAILED:
             return "Verification failed";
+        case CLWEError::INVALID_CIPHERTEXT:
+            return "Invalid ciphertext";
+        case CLWEError::BUFFER_TOO_SMALL:
+            return "Output buffer too small";
         case CLWEError::UNKNOWN_ERROR:
         default:
             return "Unknown error";
     }
 }
 
+// Utility function to get error message
+std::string get_error_message(CLWEError error) {
+    return error_string(error);
+}
+
 } // namespace clwe
\ No newline at end of file
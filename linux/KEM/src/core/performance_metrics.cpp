@@ -1,8 +1,11 @@
 #include "performance_metrics.hpp"
+#include "allocation_tracker.hpp"
 #include <chrono>
 #include <algorithm>
+#include <cmath>
 #include <numeric>
 #include <limits>
+#include <mutex>
 
 // Include platform-specific implementations
 #if defined(__linux__)
@@ -15,6 +18,101 @@
 
 namespace clwe {
 
+void LatencyHistogram::reset() {
+    counts_.fill(0);
+    total_ = 0;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    total_ += other.total_;
+}
+
+uint64_t LatencyHistogram::bucket_midpoint(size_t index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    unsigned shift = static_cast<unsigned>(index / SUB_BUCKETS) - 1;
+    uint64_t lower = static_cast<uint64_t>(index % SUB_BUCKETS + SUB_BUCKETS) << shift;
+    return lower + ((uint64_t(1) << shift) - 1) / 2;
+}
+
+uint64_t LatencyHistogram::value_at_percentile(double percentile) const {
+    if (total_ == 0) {
+        return 0;
+    }
+    double clamped = std::min(100.0, std::max(0.0, percentile));
+    uint64_t target = static_cast<uint64_t>(std::ceil(clamped / 100.0 * static_cast<double>(total_)));
+    target = std::max<uint64_t>(target, 1);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        seen += counts_[i];
+        if (seen >= target) {
+            return bucket_midpoint(i);
+        }
+    }
+    return bucket_midpoint(BUCKET_COUNT - 1);
+}
+
+uint64_t LatencyHistogram::count_above(uint64_t value) const {
+    uint64_t above = 0;
+    for (size_t i = BUCKET_COUNT; i-- > 0 && bucket_midpoint(i) > value;) {
+        above += counts_[i];
+    }
+    return above;
+}
+
+TimingStats TimingAccumulator::summarize() const {
+    TimingStats stats{0, 0, 0, 0, 0};
+    uint64_t n = histogram_.count();
+    if (n == 0) {
+        return stats;
+    }
+
+    // Percentile buckets are approximate; keep them inside the exact range
+    auto percentile_us = [this](double percentile) {
+        double value = static_cast<double>(histogram_.value_at_percentile(percentile));
+        return std::min(max_, std::max(min_, value)) / 1000.0;
+    };
+
+    double mean = sum_ / static_cast<double>(n);
+    double variance = std::max(0.0, sum_squares_ / static_cast<double>(n) - mean * mean);
+
+    stats.total_time = total_ / 1000.0;
+    stats.average_time = mean / 1000.0;
+    stats.min_time = min_ / 1000.0;
+    stats.max_time = max_ / 1000.0;
+    // Operations per second; a coarse clock can read every sample as zero, which has no rate
+    stats.throughput = stats.average_time > 0.0 ? 1000000.0 / stats.average_time : 0.0;
+    stats.p50_time = percentile_us(50.0);
+    stats.p90_time = percentile_us(90.0);
+    stats.p99_time = percentile_us(99.0);
+    stats.p999_time = percentile_us(99.9);
+    stats.stddev_time = std::sqrt(variance) / 1000.0;
+
+    uint64_t q1 = histogram_.value_at_percentile(25.0);
+    uint64_t q3 = histogram_.value_at_percentile(75.0);
+    stats.outliers = static_cast<size_t>(histogram_.count_above(q3 + 3 * (q3 - q1)));
+    return stats;
+}
+
+namespace {
+
+std::mutex& energy_reader_mutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+PerformanceMetrics::EnergyReader& external_energy_reader() {
+    static PerformanceMetrics::EnergyReader reader;
+    return reader;
+}
+
+} // namespace
+
 // Get current memory usage
 MemoryStats PerformanceMetrics::get_memory_usage() {
     return get_memory_usage_impl();
@@ -26,88 +124,178 @@ TimingStats PerformanceMetrics::time_operation_with_memory(
     MemoryStats& memory_stats,
     int iterations
 ) {
-    std::vector<double> times;
-    std::vector<size_t> memory_usages;
+    return time_operation_with_memory<const std::function<void()>&>(operation, memory_stats, iterations);
+}
 
-    size_t min_memory = std::numeric_limits<size_t>::max();
-    size_t max_memory = 0;
-    size_t total_memory = 0;
+// Time operation with CPU cycle counting
+CycleStats PerformanceMetrics::time_operation_cycles(
+    const std::function<void()>& operation,
+    int iterations
+) {
+    return time_operation_cycles<const std::function<void()>&>(operation, iterations);
+}
 
+// High-precision timing only
+TimingStats PerformanceMetrics::time_operation(
+    const std::function<void()>& operation,
+    int iterations,
+    int warmup_iterations
+) {
+    return time_operation<const std::function<void()>&>(operation, iterations, warmup_iterations);
+}
+
+TimingStats PerformanceMetrics::time_operation_cold(
+    const std::function<void()>& operation,
+    CacheEvictor& evictor,
+    int iterations
+) {
+    TimingAccumulator timing;
     for (int i = 0; i < iterations; ++i) {
-        auto start = std::chrono::high_resolution_clock::now();
+        evictor.evict();
+        auto start = std::chrono::steady_clock::now();
         operation();
-        auto end = std::chrono::high_resolution_clock::now();
-
-        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-        times.push_back(static_cast<double>(duration.count()));
+        auto end = std::chrono::steady_clock::now();
+        timing.record(start, end);
+    }
 
-        // Get memory usage after operation
-        MemoryStats current_mem = get_memory_usage();
-        memory_usages.push_back(current_mem.current_memory);
+    return timing.summarize();
+}
 
-        min_memory = std::min(min_memory, current_mem.current_memory);
-        max_memory = std::max(max_memory, current_mem.current_memory);
-        total_memory += current_mem.current_memory;
+CacheEvictor::CacheEvictor(size_t bytes) {
+    if (bytes == 0) {
+        bytes = std::max<size_t>(size_t(32) << 20, 4 * last_level_cache_bytes());
     }
+    buffer_.assign(bytes, 0);
+}
 
-    double total_time = std::accumulate(times.begin(), times.end(), 0.0);
-    double avg_time = total_time / iterations;
-    double min_time = *std::min_element(times.begin(), times.end());
-    double max_time = *std::max_element(times.begin(), times.end());
-    double throughput = 1000000.0 / avg_time;  // operations per second
+void CacheEvictor::evict() {
+    // A read-modify-write per 64-byte line leaves the lines dirty, as real traffic does;
+    // volatile keeps the otherwise unread stores
+    ++round_;
+    volatile uint8_t* data = buffer_.data();
+    for (size_t i = 0; i < buffer_.size(); i += 64) {
+        data[i] = static_cast<uint8_t>(data[i] + round_);
+    }
+}
 
-    memory_stats.current_memory = memory_usages.back();
-    memory_stats.peak_memory = max_memory;
-    memory_stats.average_memory = total_memory / iterations;
+size_t CacheEvictor::last_level_cache_bytes() {
+#if defined(_SC_LEVEL3_CACHE_SIZE) && defined(_SC_LEVEL2_CACHE_SIZE)
+    long l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (l3 > 0) {
+        return static_cast<size_t>(l3);
+    }
+    long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    if (l2 > 0) {
+        return static_cast<size_t>(l2);
+    }
+#endif
+    return 0;
+}
 
-    return {total_time, avg_time, min_time, max_time, throughput};
+// Hardware performance counters
+HardwareCounterStats PerformanceMetrics::measure_hardware_counters(
+    const std::function<void()>& operation,
+    int iterations
+) {
+    return measure_hardware_counters_impl(operation, iterations);
 }
 
-// Time operation with CPU cycle counting
-CycleStats PerformanceMetrics::time_operation_cycles(
+namespace work_detail {
+thread_local WorkCounters* t_active = nullptr;
+} // namespace work_detail
+
+// Algorithmic work counters
+WorkStats PerformanceMetrics::measure_work(
     const std::function<void()>& operation,
     int iterations
 ) {
-    std::vector<uint64_t> cycles;
+    WorkStats stats;
+    if (iterations <= 0) {
+        return stats;
+    }
+    operation();
 
-    for (int i = 0; i < iterations; ++i) {
-        uint64_t start_cycles = get_cpu_cycles_impl();
-        operation();
-        uint64_t end_cycles = get_cpu_cycles_impl();
-        cycles.push_back(end_cycles - start_cycles);
+    stats.allocations_available = AllocationTracker::hooks_installed();
+    WorkCounters work;
+    uint64_t bytes_allocated = 0;
+    {
+        WorkCounterScope scope;
+        if (stats.allocations_available) {
+            AllocationTracker tracker;
+            for (int i = 0; i < iterations; ++i) {
+                operation();
+            }
+            bytes_allocated = tracker.stats().bytes_allocated;
+        } else {
+            for (int i = 0; i < iterations; ++i) {
+                operation();
+            }
+        }
+        work = scope.counters();
     }
 
-    uint64_t total_cycles = std::accumulate(cycles.begin(), cycles.end(), 0ULL);
-    uint64_t avg_cycles = total_cycles / iterations;
-    uint64_t min_cycles = *std::min_element(cycles.begin(), cycles.end());
-    uint64_t max_cycles = *std::max_element(cycles.begin(), cycles.end());
+    const double n = static_cast<double>(iterations);
+    stats.ntt_forward = static_cast<double>(work[WorkCounter::NTT_FORWARD]) / n;
+    stats.ntt_inverse = static_cast<double>(work[WorkCounter::NTT_INVERSE]) / n;
+    stats.basemul = static_cast<double>(work[WorkCounter::BASEMUL]) / n;
+    stats.shake_absorbed_bytes = static_cast<double>(work[WorkCounter::SHAKE_ABSORBED_BYTES]) / n;
+    stats.shake_squeezed_bytes = static_cast<double>(work[WorkCounter::SHAKE_SQUEEZED_BYTES]) / n;
+    stats.rng_bytes = static_cast<double>(work[WorkCounter::RNG_BYTES]) / n;
+    stats.coefficients_packed = static_cast<double>(work[WorkCounter::COEFFICIENTS_PACKED]) / n;
+    stats.bytes_allocated = static_cast<double>(bytes_allocated) / n;
+    return stats;
+}
 
-    return {total_cycles, avg_cycles, min_cycles, max_cycles};
+void PerformanceMetrics::set_energy_reader(EnergyReader reader) {
+    std::lock_guard<std::mutex> lock(energy_reader_mutex());
+    external_energy_reader() = std::move(reader);
 }
 
-// High-precision timing only
-TimingStats PerformanceMetrics::time_operation(
+// Energy per operation
+EnergyStats PerformanceMetrics::measure_energy(
     const std::function<void()>& operation,
     int iterations
 ) {
-    std::vector<double> times;
+    EnergyStats stats;
+    EnergyReader reader;
+    {
+        std::lock_guard<std::mutex> lock(energy_reader_mutex());
+        reader = external_energy_reader();
+    }
+    const char* source = "external";
+    if (!reader) {
+        reader = open_energy_reader_impl();
+        source = "rapl";
+    }
 
-    for (int i = 0; i < iterations; ++i) {
-        auto start = std::chrono::high_resolution_clock::now();
-        operation();
-        auto end = std::chrono::high_resolution_clock::now();
+    double start_joules = 0;
+    if (iterations <= 0 || !reader || !reader(start_joules)) {
+        return stats;
+    }
 
-        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-        times.push_back(static_cast<double>(duration.count()));
+    const auto window = std::chrono::milliseconds(MIN_ENERGY_WINDOW_MS);
+    const auto start = std::chrono::steady_clock::now();
+    auto end = start;
+    uint64_t operations = 0;
+    while (operations < static_cast<uint64_t>(iterations) || end - start < window) {
+        operation();
+        ++operations;
+        end = std::chrono::steady_clock::now();
     }
 
-    double total_time = std::accumulate(times.begin(), times.end(), 0.0);
-    double avg_time = total_time / iterations;
-    double min_time = *std::min_element(times.begin(), times.end());
-    double max_time = *std::max_element(times.begin(), times.end());
-    double throughput = 1000000.0 / avg_time;
+    double end_joules = 0;
+    if (!reader(end_joules) || end_joules < start_joules) {
+        return stats;
+    }
 
-    return {total_time, avg_time, min_time, max_time, throughput};
+    double seconds = std::chrono::duration<double>(end - start).count();
+    stats.available = true;
+    stats.source = source;
+    stats.operations = operations;
+    stats.total_joules = end_joules - start_joules;
+    stats.microjoules_per_operation = stats.total_joules * 1e6 / static_cast<double>(operations);
+    stats.average_watts = seconds > 0 ? stats.total_joules / seconds : 0.0;
+    return stats;
 }
 
 // Combined measurement
@@ -123,6 +311,9 @@ PerformanceMetrics::CombinedStats PerformanceMetrics::measure_operation(
     // Measure cycles separately
     result.cycles = time_operation_cycles(operation, iterations);
 
+    // Energy last; unavailable (and skipped) without a source
+    result.energy = measure_energy(operation, iterations);
+
     return result;
 }
 
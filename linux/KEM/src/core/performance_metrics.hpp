@@ -1,8 +1,17 @@
 #ifndef PERFORMANCE_METRICS_HPP
 #define PERFORMANCE_METRICS_HPP
 
+#include "allocation_tracker.hpp"
+#include "work_counters.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <limits>
+#include <utility>
 #include <vector>
 
 namespace clwe {
@@ -12,6 +21,12 @@ struct MemoryStats {
     size_t current_memory;  // Current memory usage in bytes
     size_t peak_memory;     // Peak memory usage in bytes
     size_t average_memory;  // Average memory usage in bytes
+
+    // Heap traffic of the measured operation, summed over the iterations of one
+    // time_operation_with_memory call. Zero unless the executable links clwe_alloc_hooks.
+    size_t allocations = 0;      // operator new calls
+    size_t bytes_allocated = 0;  // Bytes requested
+    size_t peak_live_bytes = 0;  // Largest net heap growth within a single iteration
 };
 
 // CPU cycle statistics
@@ -22,6 +37,49 @@ struct CycleStats {
     uint64_t max_cycles;      // Maximum CPU cycles
 };
 
+// Hardware performance counters per measured operation (Linux perf_event_open).
+// available is false when the events cannot be opened, e.g. without permission
+// (kernel.perf_event_paranoid), inside most VMs and containers, or off Linux.
+struct HardwareCounterStats {
+    bool available = false;
+    bool cache_misses_available = false;   // L1D / LLC events opened
+    bool branch_misses_available = false;  // Branch-miss event opened
+    double cycles = 0;                     // Core cycles per operation
+    double instructions = 0;               // Retired instructions per operation
+    double ipc = 0;                        // instructions / cycles
+    double l1d_misses = 0;                 // L1 data-cache read misses per operation
+    double llc_misses = 0;                 // Last-level cache misses per operation
+    double branch_misses = 0;              // Mispredicted branches per operation
+};
+
+// Algorithmic work per measured operation (WorkCounter), counted on the calling thread.
+// Unlike timings these are exact and machine-independent, so tests can assert them.
+struct WorkStats {
+    bool allocations_available = false;  // Executable links clwe_alloc_hooks
+    double ntt_forward = 0;              // Forward NTTs per operation
+    double ntt_inverse = 0;              // Inverse NTTs per operation
+    double basemul = 0;                  // NTT-domain products per operation
+    double shake_absorbed_bytes = 0;
+    double shake_squeezed_bytes = 0;
+    double rng_bytes = 0;
+    double coefficients_packed = 0;
+    double bytes_allocated = 0;          // Heap bytes requested per operation
+};
+
+// Energy drawn while an operation ran. Measured over the whole loop, at least
+// MIN_ENERGY_WINDOW_MS long, since RAPL refreshes only about once a millisecond; the
+// counters cover the whole package (or board), so other load on it is included.
+// available is false without a source: RAPL under /sys/class/powercap is root-only on
+// most kernels, and other platforms need a reader from set_energy_reader().
+struct EnergyStats {
+    bool available = false;
+    const char* source = "";                 // "rapl", "external", or "" when unavailable
+    uint64_t operations = 0;                 // Operations run inside the window
+    double total_joules = 0;                 // Energy over the window
+    double microjoules_per_operation = 0;
+    double average_watts = 0;                // total_joules over the window's wall time
+};
+
 // High-precision timing statistics
 struct TimingStats {
     double total_time;      // Total time in microseconds
@@ -29,6 +87,138 @@ struct TimingStats {
     double min_time;        // Minimum time in microseconds
     double max_time;        // Maximum time in microseconds
     double throughput;      // Operations per second
+
+    // Distribution, from a LatencyHistogram of the samples (about 3% relative error)
+    double p50_time = 0;     // Median in microseconds
+    double p90_time = 0;     // 90th percentile in microseconds
+    double p99_time = 0;     // 99th percentile in microseconds
+    double p999_time = 0;    // 99.9th percentile in microseconds
+    double stddev_time = 0;  // Standard deviation in microseconds
+    size_t outliers = 0;     // Samples above Q3 + 3 * IQR
+};
+
+// Log-linear latency histogram in the style of HdrHistogram: values below 2^SUB_BUCKET_BITS
+// are exact, larger ones fall into 2^SUB_BUCKET_BITS linear buckets per power of two.
+// record() is a few bit operations on a fixed array, so it never allocates.
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 5;
+    static constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BUCKET_BITS;
+    static constexpr size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    LatencyHistogram() { reset(); }
+
+    void record(uint64_t value) {
+        ++counts_[bucket_index(value)];
+        ++total_;
+    }
+
+    void reset();
+    uint64_t count() const { return total_; }
+
+    // Add other's samples, e.g. to combine per-thread histograms after a run
+    void merge(const LatencyHistogram& other);
+
+    // Smallest recorded bucket covering percentile (0..100) of the samples, as the bucket midpoint
+    uint64_t value_at_percentile(double percentile) const;
+
+    // Number of samples in buckets whose midpoint exceeds value
+    uint64_t count_above(uint64_t value) const;
+
+    static size_t bucket_index(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return static_cast<size_t>(value);
+        }
+        unsigned shift = highest_bit(value) - SUB_BUCKET_BITS;
+        return (shift + 1) * SUB_BUCKETS + static_cast<size_t>((value >> shift) - SUB_BUCKETS);
+    }
+
+    static uint64_t bucket_midpoint(size_t index);
+
+private:
+    static unsigned highest_bit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+        return 63u - static_cast<unsigned>(__builtin_clzll(value));
+#else
+        unsigned bit = 0;
+        while (value >>= 1) {
+            ++bit;
+        }
+        return bit;
+#endif
+    }
+
+    std::array<uint64_t, BUCKET_COUNT> counts_;
+    uint64_t total_ = 0;
+};
+
+// Running sums plus a histogram of per-operation nanoseconds; no per-sample allocation.
+// Samples use steady_clock: CLOCK_MONOTONIC on Linux, QueryPerformanceCounter on Windows.
+// A sample may cover a batch of back-to-back calls and then counts as their mean.
+class TimingAccumulator {
+public:
+    void record(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end,
+                int batch = 1) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        double total = elapsed > 0 ? static_cast<double>(elapsed) : 0.0;
+        double ns = total / batch;
+        histogram_.record(static_cast<uint64_t>(ns + 0.5));
+        total_ += total;
+        sum_ += ns;
+        sum_squares_ += ns * ns;
+        min_ = std::min(min_, ns);
+        max_ = std::max(max_, ns);
+    }
+
+    TimingStats summarize() const;
+
+private:
+    LatencyHistogram histogram_;
+    double total_ = 0;  // Wall time of every sample, batches counted whole
+    double sum_ = 0;
+    double sum_squares_ = 0;
+    double min_ = std::numeric_limits<double>::max();
+    double max_ = 0;
+};
+
+// Keeps value, and every store leading to it, from being optimized away. The empty asm
+// statement takes value's address as an input and clobbers memory, so it costs no instructions.
+template <typename T>
+inline void do_not_optimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static const volatile void* sink;
+    sink = &value;
+#endif
+}
+
+// Forces pending stores to memory, so a loop of writes is not merged or dropped
+inline void clobber_memory() {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : : "memory");
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+// Displaces the CPU caches between timed runs, leaving roughly the state a KEM call finds
+// after other request processing: evict() reads and rewrites every line of a buffer several
+// times the last-level cache, so the library's tables, keys and workspaces are no longer cached
+class CacheEvictor {
+public:
+    // 0 sizes the buffer at four times the last-level cache, and at least 32 MiB
+    explicit CacheEvictor(size_t bytes = 0);
+
+    void evict();
+    size_t size() const { return buffer_.size(); }
+
+    // Size of the largest data cache level reported by the OS; 0 when unknown
+    static size_t last_level_cache_bytes();
+
+private:
+    std::vector<uint8_t> buffer_;
+    uint8_t round_ = 0;
 };
 
 // Performance measurement class
@@ -37,6 +227,23 @@ public:
     // Get current memory usage
     static MemoryStats get_memory_usage();
 
+    // The std::function overloads below forward to these templates, which call any callable
+    // directly, so small operations inline into the loop instead of paying an indirect call
+    template <typename Operation>
+    static TimingStats time_operation_with_memory(Operation&& operation, MemoryStats& memory_stats,
+                                                  int iterations = 100);
+    template <typename Operation>
+    static CycleStats time_operation_cycles(Operation&& operation, int iterations = 100);
+    template <typename Operation>
+    static TimingStats time_operation(Operation&& operation, int iterations = 100, int warmup_iterations = 0);
+
+    // For sub-microsecond kernels (one NTT, one basemul): each of the samples times batch_size
+    // back-to-back calls and records their mean, so the two clock reads are spread over the
+    // batch. Percentiles are of batch means; total_time is the wall time of all samples.
+    template <typename Operation>
+    static TimingStats time_operation_batched(Operation&& operation, int samples = 100, int batch_size = 100,
+                                              int warmup_iterations = 0);
+
     // Time an operation with memory tracking
     static TimingStats time_operation_with_memory(
         const std::function<void()>& operation,
@@ -50,17 +257,55 @@ public:
         int iterations = 100
     );
 
-    // High-precision timing only
+    // High-precision timing only; warmup_iterations untimed runs come first
     static TimingStats time_operation(
+        const std::function<void()>& operation,
+        int iterations = 100,
+        int warmup_iterations = 0
+    );
+
+    // Cold-cache timing: evictor.evict() runs untimed ahead of every timed run
+    static TimingStats time_operation_cold(
+        const std::function<void()>& operation,
+        CacheEvictor& evictor,
+        int iterations = 100
+    );
+
+    // Hardware counters averaged over iterations; user-space events of this thread only
+    static HardwareCounterStats measure_hardware_counters(
+        const std::function<void()>& operation,
+        int iterations = 100
+    );
+
+    // Work counters averaged over iterations, after one uncounted warm-up run that
+    // fills thread-local scratch
+    static WorkStats measure_work(
+        const std::function<void()>& operation,
+        int iterations = 1
+    );
+
+    // Cumulative energy counter in joules, monotonic over the process lifetime; returns
+    // false when the sensor cannot be read. For boards with an external sense chip (an
+    // INA219 shunt monitor integrating bus power), or a powermetrics-style daemon feed.
+    using EnergyReader = std::function<bool(double& joules)>;
+
+    static constexpr int MIN_ENERGY_WINDOW_MS = 20;
+
+    // Replaces the platform source for later measure_energy() calls; an empty reader restores it
+    static void set_energy_reader(EnergyReader reader);
+
+    // Energy per operation; runs at least iterations operations and MIN_ENERGY_WINDOW_MS
+    static EnergyStats measure_energy(
         const std::function<void()>& operation,
         int iterations = 100
     );
 
-    // Combined measurement (timing + memory + cycles)
+    // Combined measurement (timing + memory + cycles + energy)
     struct CombinedStats {
         TimingStats timing;
         MemoryStats memory;
         CycleStats cycles;
+        EnergyStats energy;
     };
 
     static CombinedStats measure_operation(
@@ -72,8 +317,120 @@ private:
     // Platform-specific implementations
     static MemoryStats get_memory_usage_impl();
     static uint64_t get_cpu_cycles_impl();
+    static HardwareCounterStats measure_hardware_counters_impl(const std::function<void()>& operation,
+                                                               int iterations);
+    // The platform energy counter, freshly opened; empty when there is none
+    static EnergyReader open_energy_reader_impl();
 };
 
+template <typename Operation>
+TimingStats PerformanceMetrics::time_operation_with_memory(Operation&& operation, MemoryStats& memory_stats,
+                                                           int iterations) {
+    TimingAccumulator timing;
+    size_t last_memory = 0;
+    size_t max_memory = 0;
+    size_t total_memory = 0;
+
+    AllocationStats heap;
+    const bool count_allocations = AllocationTracker::hooks_installed();
+
+    for (int i = 0; i < iterations; ++i) {
+        std::chrono::steady_clock::time_point start, end;
+        if (count_allocations) {
+            // Scoped to the operation alone, so the bookkeeping below is not counted
+            AllocationTracker tracker;
+            start = std::chrono::steady_clock::now();
+            operation();
+            end = std::chrono::steady_clock::now();
+
+            AllocationStats iteration = tracker.stats();
+            heap.allocations += iteration.allocations;
+            heap.bytes_allocated += iteration.bytes_allocated;
+            heap.peak_live_bytes = std::max(heap.peak_live_bytes, iteration.peak_live_bytes);
+        } else {
+            start = std::chrono::steady_clock::now();
+            operation();
+            end = std::chrono::steady_clock::now();
+        }
+
+        timing.record(start, end);
+
+        // Get memory usage after operation
+        last_memory = get_memory_usage().current_memory;
+        max_memory = std::max(max_memory, last_memory);
+        total_memory += last_memory;
+    }
+
+    memory_stats.current_memory = last_memory;
+    memory_stats.peak_memory = max_memory;
+    memory_stats.average_memory = iterations > 0 ? total_memory / iterations : 0;
+    memory_stats.allocations = heap.allocations;
+    memory_stats.bytes_allocated = heap.bytes_allocated;
+    memory_stats.peak_live_bytes = heap.peak_live_bytes;
+
+    return timing.summarize();
+}
+
+template <typename Operation>
+CycleStats PerformanceMetrics::time_operation_cycles(Operation&& operation, int iterations) {
+    uint64_t total_cycles = 0;
+    uint64_t min_cycles = std::numeric_limits<uint64_t>::max();
+    uint64_t max_cycles = 0;
+
+    for (int i = 0; i < iterations; ++i) {
+        uint64_t start_cycles = get_cpu_cycles_impl();
+        operation();
+        uint64_t cycles = get_cpu_cycles_impl() - start_cycles;
+        total_cycles += cycles;
+        min_cycles = std::min(min_cycles, cycles);
+        max_cycles = std::max(max_cycles, cycles);
+    }
+
+    if (iterations <= 0) {
+        return {0, 0, 0, 0};
+    }
+    return {total_cycles, total_cycles / static_cast<uint64_t>(iterations), min_cycles, max_cycles};
+}
+
+template <typename Operation>
+TimingStats PerformanceMetrics::time_operation(Operation&& operation, int iterations, int warmup_iterations) {
+    // Untimed runs first, so caches, branch predictors and lazy tables are warm
+    for (int i = 0; i < warmup_iterations; ++i) {
+        operation();
+    }
+
+    TimingAccumulator timing;
+    for (int i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        operation();
+        auto end = std::chrono::steady_clock::now();
+        timing.record(start, end);
+    }
+
+    return timing.summarize();
+}
+
+template <typename Operation>
+TimingStats PerformanceMetrics::time_operation_batched(Operation&& operation, int samples, int batch_size,
+                                                       int warmup_iterations) {
+    batch_size = std::max(1, batch_size);
+    for (int i = 0; i < warmup_iterations; ++i) {
+        operation();
+    }
+
+    TimingAccumulator timing;
+    for (int i = 0; i < samples; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        for (int j = 0; j < batch_size; ++j) {
+            operation();
+        }
+        auto end = std::chrono::steady_clock::now();
+        timing.record(start, end, batch_size);
+    }
+
+    return timing.summarize();
+}
+
 } // namespace clwe
 
 #endif // PERFORMANCE_METRICS_HPP
\ No newline at end of file
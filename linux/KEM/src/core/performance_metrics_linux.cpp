@@ -4,6 +4,13 @@
 #include <unistd.h>
 #include <algorithm>
 #include <numeric>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <vector>
 
 #ifdef __x86_64__
 #include <x86intrin.h>
@@ -39,4 +46,192 @@ uint64_t PerformanceMetrics::get_cpu_cycles_impl() {
 #endif
 }
 
-} // namespace clwe
\ No newline at end of file
+namespace {
+
+// A perf event group led by the cycle counter; members that fail to open are left out
+class PerfEventGroup {
+public:
+    enum Event { CYCLES, INSTRUCTIONS, L1D_MISSES, LLC_MISSES, BRANCH_MISSES, EVENT_COUNT };
+
+private:
+    int fds_[EVENT_COUNT];
+    int order_[EVENT_COUNT];  // Position of each event in the group read, -1 if not opened
+    int opened_ = 0;
+
+    static int open_event(uint32_t type, uint64_t config, int group_fd) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = group_fd == -1 ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+    }
+
+    void add(Event event, uint32_t type, uint64_t config) {
+        int fd = open_event(type, config, fds_[CYCLES]);
+        if (fd >= 0) {
+            fds_[event] = fd;
+            order_[event] = opened_++;
+        }
+    }
+
+public:
+    PerfEventGroup() {
+        std::fill(fds_, fds_ + EVENT_COUNT, -1);
+        std::fill(order_, order_ + EVENT_COUNT, -1);
+
+        fds_[CYCLES] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1);
+        if (fds_[CYCLES] < 0) {
+            return;
+        }
+        order_[CYCLES] = opened_++;
+
+        add(INSTRUCTIONS, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        add(L1D_MISSES, PERF_TYPE_HW_CACHE,
+            PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+        add(LLC_MISSES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        add(BRANCH_MISSES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    }
+
+    ~PerfEventGroup() {
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+
+    PerfEventGroup(const PerfEventGroup&) = delete;
+    PerfEventGroup& operator=(const PerfEventGroup&) = delete;
+
+    bool has(Event event) const { return order_[event] >= 0; }
+
+    void start() {
+        ioctl(fds_[CYCLES], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fds_[CYCLES], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    void stop() { ioctl(fds_[CYCLES], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP); }
+
+    // Counter values, scaled up when the kernel multiplexed the group off the PMU
+    bool read_values(double values[EVENT_COUNT]) const {
+        uint64_t buffer[3 + EVENT_COUNT];
+        ssize_t expected = static_cast<ssize_t>((3 + opened_) * sizeof(uint64_t));
+        if (::read(fds_[CYCLES], buffer, sizeof(buffer)) < expected || buffer[2] == 0) {
+            return false;
+        }
+        double scale = static_cast<double>(buffer[1]) / static_cast<double>(buffer[2]);
+        for (int event = 0; event < EVENT_COUNT; ++event) {
+            values[event] = order_[event] >= 0 ? static_cast<double>(buffer[3 + order_[event]]) * scale : 0.0;
+        }
+        return true;
+    }
+};
+
+} // namespace
+
+HardwareCounterStats PerformanceMetrics::measure_hardware_counters_impl(const std::function<void()>& operation,
+                                                                        int iterations) {
+    HardwareCounterStats stats;
+    PerfEventGroup group;
+    if (iterations <= 0 || !group.has(PerfEventGroup::CYCLES) || !group.has(PerfEventGroup::INSTRUCTIONS)) {
+        return stats;
+    }
+
+    group.start();
+    for (int i = 0; i < iterations; ++i) {
+        operation();
+    }
+    group.stop();
+
+    double values[PerfEventGroup::EVENT_COUNT];
+    if (!group.read_values(values)) {
+        return stats;
+    }
+
+    double per_op = 1.0 / iterations;
+    stats.available = true;
+    stats.cache_misses_available = group.has(PerfEventGroup::L1D_MISSES) && group.has(PerfEventGroup::LLC_MISSES);
+    stats.branch_misses_available = group.has(PerfEventGroup::BRANCH_MISSES);
+    stats.cycles = values[PerfEventGroup::CYCLES] * per_op;
+    stats.instructions = values[PerfEventGroup::INSTRUCTIONS] * per_op;
+    stats.ipc = stats.cycles > 0 ? stats.instructions / stats.cycles : 0.0;
+    stats.l1d_misses = values[PerfEventGroup::L1D_MISSES] * per_op;
+    stats.llc_misses = values[PerfEventGroup::LLC_MISSES] * per_op;
+    stats.branch_misses = values[PerfEventGroup::BRANCH_MISSES] * per_op;
+    return stats;
+}
+
+namespace {
+
+// Package domains of the powercap RAPL driver (intel-rapl:N named "package-N", which AMD
+// Zen exposes under the same name); psys and the core/uncore subzones would double count.
+// Each energy_uj wraps at its max_energy_range_uj, so reads are unwrapped into a running sum.
+class RaplCounter {
+private:
+    struct Zone {
+        std::string path;
+        uint64_t range = 0;
+        uint64_t last = 0;
+    };
+    std::vector<Zone> zones_;
+    uint64_t total_uj_ = 0;
+
+    static bool read_u64(const std::string& path, uint64_t& value) {
+        std::ifstream in(path);
+        return static_cast<bool>(in >> value);
+    }
+
+public:
+    RaplCounter() {
+        for (int package = 0;; ++package) {
+            std::string dir = "/sys/class/powercap/intel-rapl:" + std::to_string(package);
+            std::ifstream name_file(dir + "/name");
+            std::string name;
+            if (!name_file.is_open()) {
+                break;
+            }
+            if (!(name_file >> name) || name.rfind("package", 0) != 0) {
+                continue;
+            }
+            Zone zone;
+            zone.path = dir + "/energy_uj";
+            if (read_u64(dir + "/max_energy_range_uj", zone.range) && read_u64(zone.path, zone.last)) {
+                zones_.push_back(zone);
+            }
+        }
+    }
+
+    bool empty() const { return zones_.empty(); }
+
+    bool read(double& joules) {
+        for (Zone& zone : zones_) {
+            uint64_t now = 0;
+            if (!read_u64(zone.path, now)) {
+                return false;
+            }
+            total_uj_ += now >= zone.last ? now - zone.last : zone.range - zone.last + now;
+            zone.last = now;
+        }
+        joules = static_cast<double>(total_uj_) / 1e6;
+        return true;
+    }
+};
+
+} // namespace
+
+// energy_uj is mode 0400 since the PLATYPUS side channel (CVE-2020-8694), so this is
+// empty unless the process runs as root or the file was made readable
+PerformanceMetrics::EnergyReader PerformanceMetrics::open_energy_reader_impl() {
+    auto counter = std::make_shared<RaplCounter>();
+    if (counter->empty()) {
+        return {};
+    }
+    return [counter](double& joules) { return counter->read(joules); };
+}
+
+} // namespace clwe
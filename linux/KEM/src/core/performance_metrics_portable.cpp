@@ -0,0 +1,38 @@
+#include "performance_metrics.hpp"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace clwe {
+
+// Metrics backend for platforms without a dedicated one: timing still comes from
+// std::chrono in performance_metrics.cpp, the OS-specific figures report zero
+
+MemoryStats PerformanceMetrics::get_memory_usage_impl() {
+    return {0, 0, 0};
+}
+
+uint64_t PerformanceMetrics::get_cpu_cycles_impl() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    return __rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// No counter backend on this platform
+HardwareCounterStats PerformanceMetrics::measure_hardware_counters_impl(const std::function<void()>&, int) {
+    return {};
+}
+
+// Nor an energy counter (macOS powermetrics needs root and a subprocess); see set_energy_reader
+PerformanceMetrics::EnergyReader PerformanceMetrics::open_energy_reader_impl() {
+    return {};
+}
+
+} // namespace clwe
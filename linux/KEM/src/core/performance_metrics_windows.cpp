@@ -0,0 +1,44 @@
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include "performance_metrics.hpp"
+#include <windows.h>
+#include <psapi.h>
+
+namespace clwe {
+
+// Windows memory measurement using PSAPI. PrivateUsage (commit charge) is the closest
+// match to what the Linux backend reports; the peak is the working-set high-water mark.
+MemoryStats PerformanceMetrics::get_memory_usage_impl() {
+    PROCESS_MEMORY_COUNTERS_EX pmc;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&pmc),
+                              sizeof(pmc))) {
+        return {0, 0, 0};
+    }
+    return {pmc.PrivateUsage, pmc.PeakWorkingSetSize, pmc.PrivateUsage};
+}
+
+// Cycles charged to the calling thread, so preemption and other threads do not inflate
+// the count the way a raw rdtsc delta does; comparable with perf's user+kernel cycles
+uint64_t PerformanceMetrics::get_cpu_cycles_impl() {
+    ULONG64 cycles = 0;
+    if (!QueryThreadCycleTime(GetCurrentThread(), &cycles)) {
+        return 0;
+    }
+    return static_cast<uint64_t>(cycles);
+}
+
+// Windows exposes PMU events only through ETW sessions, not in-process
+HardwareCounterStats PerformanceMetrics::measure_hardware_counters_impl(const std::function<void()>&, int) {
+    return {};
+}
+
+// The Energy Meter Interface needs a device driver handle; install a reader instead
+PerformanceMetrics::EnergyReader PerformanceMetrics::open_energy_reader_impl() {
+    return {};
+}
+
+} // namespace clwe
@@ -0,0 +1,42 @@
+#include "poly.hpp"
+#include "kem_arena.hpp"
+#include <algorithm>
+#include <new>
+
+namespace clwe {
+
+std::unique_ptr<ColorValue[], AlignedColorBuffer::Deleter> AlignedColorBuffer::allocate(size_t size) {
+    if (size == 0) {
+        return {};
+    }
+    const AllocatorHooks* hooks = current_allocator();
+    const size_t bytes = size * sizeof(ColorValue);
+    void* raw = secure_pool_allocate(bytes, POLY_ALIGNMENT);
+    if (raw == nullptr) {
+        raw = allocate_with(hooks, bytes, POLY_ALIGNMENT);
+    }
+    return {static_cast<ColorValue*>(raw), Deleter(hooks, bytes)};
+}
+
+AlignedColorBuffer::AlignedColorBuffer(size_t size)
+    : data_(allocate(size)), size_(size) {
+    std::fill(data_.get(), data_.get() + size_, ColorValue::from_math_value(0));
+}
+
+AlignedColorBuffer::AlignedColorBuffer(size_t size, KemArena& arena)
+    : data_(size == 0 ? nullptr : arena.allocate_array<ColorValue>(size), Deleter()), size_(size) {}
+
+AlignedColorBuffer::AlignedColorBuffer(const AlignedColorBuffer& other)
+    : data_(allocate(other.size_)), size_(other.size_) {
+    std::copy(other.data_.get(), other.data_.get() + size_, data_.get());
+}
+
+AlignedColorBuffer& AlignedColorBuffer::operator=(const AlignedColorBuffer& other) {
+    if (this != &other) {
+        AlignedColorBuffer copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+} // namespace clwe
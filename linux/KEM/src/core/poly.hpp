@@ -0,0 +1,130 @@
+#ifndef POLY_HPP
+#define POLY_HPP
+
+#include "color_value.hpp"
+#include "library_allocator.hpp"
+#include "secure_memory_pool.hpp"
+#include "utils.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+namespace clwe {
+
+class KemArena;
+
+// Alignment of every polynomial block: one cache line, enough for AVX-512 loads
+constexpr size_t POLY_ALIGNMENT = 64;
+
+// 64-byte aligned block of ColorValue coefficients, owned and allocated from the secure
+// memory pool when it is enabled and has room, else through the set_allocator() hooks;
+// or borrowed from a KemArena that outlives it. Copies are always owning. Owned blocks
+// may hold secret coefficients and are released with a secure free.
+class AlignedColorBuffer {
+private:
+    struct Deleter {
+        const AllocatorHooks* hooks;  // Null for a borrowed block
+        size_t bytes;
+        Deleter() : hooks(nullptr), bytes(0) {}
+        Deleter(const AllocatorHooks* from, size_t size) : hooks(from), bytes(size) {}
+        void operator()(ColorValue* ptr) const {
+            if (hooks != nullptr && !secure_pool_release(ptr, bytes)) {
+                secure_deallocate_with(hooks, ptr, bytes, POLY_ALIGNMENT);
+            }
+        }
+    };
+
+    std::unique_ptr<ColorValue[], Deleter> data_;
+    size_t size_ = 0;
+
+    // Owning block of size coefficients, left uninitialized
+    static std::unique_ptr<ColorValue[], Deleter> allocate(size_t size);
+
+public:
+    AlignedColorBuffer() = default;
+    // Coefficients start at math value 0
+    explicit AlignedColorBuffer(size_t size);
+    // Zeroed coefficients carved from arena, valid until its next reset()
+    AlignedColorBuffer(size_t size, KemArena& arena);
+
+    AlignedColorBuffer(const AlignedColorBuffer& other);
+    AlignedColorBuffer& operator=(const AlignedColorBuffer& other);
+    AlignedColorBuffer(AlignedColorBuffer&&) noexcept = default;
+    AlignedColorBuffer& operator=(AlignedColorBuffer&&) noexcept = default;
+
+    ColorValue* data() { return data_.get(); }
+    const ColorValue* data() const { return data_.get(); }
+    size_t size() const { return size_; }
+};
+
+// Single polynomial of n coefficients
+class Poly {
+private:
+    uint32_t degree_ = 0;
+    AlignedColorBuffer coeffs_;
+
+public:
+    Poly() = default;
+    explicit Poly(uint32_t degree) : degree_(degree), coeffs_(degree) {}
+    Poly(uint32_t degree, KemArena& arena) : degree_(degree), coeffs_(degree, arena) {}
+
+    ColorValue& operator[](size_t d) { return coeffs_.data()[d]; }
+    const ColorValue& operator[](size_t d) const { return coeffs_.data()[d]; }
+
+    ColorValue* data() { return coeffs_.data(); }
+    const ColorValue* data() const { return coeffs_.data(); }
+    uint32_t degree() const { return degree_; }
+};
+
+// Vector of rank polynomials stored back to back in one block
+class PolyVec {
+private:
+    uint32_t rank_ = 0;
+    uint32_t degree_ = 0;
+    AlignedColorBuffer coeffs_;
+
+public:
+    PolyVec() = default;
+    PolyVec(uint32_t rank, uint32_t degree)
+        : rank_(rank), degree_(degree), coeffs_(static_cast<size_t>(rank) * degree) {}
+    PolyVec(uint32_t rank, uint32_t degree, KemArena& arena)
+        : rank_(rank), degree_(degree), coeffs_(static_cast<size_t>(rank) * degree, arena) {}
+
+    // Pointer to the i-th polynomial
+    ColorValue* operator[](size_t i) { return coeffs_.data() + i * degree_; }
+    const ColorValue* operator[](size_t i) const { return coeffs_.data() + i * degree_; }
+
+    ColorValue* data() { return coeffs_.data(); }
+    const ColorValue* data() const { return coeffs_.data(); }
+    uint32_t rank() const { return rank_; }
+    uint32_t degree() const { return degree_; }
+    size_t coeff_count() const { return coeffs_.size(); }
+};
+
+// rank x rank matrix of polynomials in row-major order, one block
+class PolyMatrix {
+private:
+    uint32_t rank_ = 0;
+    uint32_t degree_ = 0;
+    AlignedColorBuffer coeffs_;
+
+public:
+    PolyMatrix() = default;
+    PolyMatrix(uint32_t rank, uint32_t degree)
+        : rank_(rank), degree_(degree), coeffs_(static_cast<size_t>(rank) * rank * degree) {}
+    PolyMatrix(uint32_t rank, uint32_t degree, KemArena& arena)
+        : rank_(rank), degree_(degree), coeffs_(static_cast<size_t>(rank) * rank * degree, arena) {}
+
+    // Pointer to the polynomial at row i, column j
+    ColorValue* at(size_t i, size_t j) { return coeffs_.data() + (i * rank_ + j) * degree_; }
+    const ColorValue* at(size_t i, size_t j) const { return coeffs_.data() + (i * rank_ + j) * degree_; }
+
+    ColorValue* data() { return coeffs_.data(); }
+    const ColorValue* data() const { return coeffs_.data(); }
+    uint32_t rank() const { return rank_; }
+    uint32_t degree() const { return degree_; }
+};
+
+} // namespace clwe
+
+#endif // POLY_HPP
@@ -0,0 +1,326 @@
+#include "poly_multiplier.hpp"
+#include "cpu_features.hpp"
+#include "ntt_engine.hpp"
+#include "ntt_tables.hpp"
+#include "simd_target.hpp"
+#include "utils.hpp"
+#include "clwe/clwe.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef HAVE_AVX2
+#include <immintrin.h>
+#endif
+
+namespace clwe {
+
+namespace {
+
+constexpr uint32_t MAX_MODULUS = 65536;
+constexpr uint32_t MAX_DEGREE = 8192;
+
+// Crossovers from clwe_bench PolyMul/* on AVX2: the NTT overtakes the vector schoolbook at
+// n = 128, Karatsuba at 256, and the multi-modular NTT overtakes Karatsuba above 1024
+constexpr uint32_t NTT_MIN_DEGREE = 128;
+constexpr uint32_t SCHOOLBOOK_MAX_DEGREE = 128;
+constexpr uint32_t KARATSUBA_MAX_DEGREE = 1024;
+// Karatsuba recursion bottoms out in a linear schoolbook product of this many coefficients
+constexpr uint32_t KARATSUBA_BASE = 32;
+
+// NTT primes for the multi-modular strategy: p = 1 mod 8192 and 17 is a non-residue, so
+// ntt_friendly(p, n) holds for every supported n. p1 * p2 > 2^59 exceeds the largest
+// integer coefficient of a cyclic product, n * (q - 1)^2 < 2^45.
+constexpr uint32_t CRT_PRIME_1 = 0x3FFD6001;  // 1073569793
+constexpr uint32_t CRT_PRIME_2 = 0x3FFC0001;  // 1073479681
+
+void check_shape(uint32_t q, uint32_t n) {
+    if (q < 2 || q > MAX_MODULUS) {
+        throw std::invalid_argument("Polynomial multiplier modulus must be between 2 and 65536, got " +
+                                    std::to_string(q));
+    }
+    if (n == 0 || n > MAX_DEGREE || !is_power_of_two(n)) {
+        throw std::invalid_argument("Polynomial multiplier degree must be a power of 2 up to 8192, got " +
+                                    std::to_string(n));
+    }
+}
+
+// Reusable scratch of the calling thread
+uint32_t* thread_scratch(size_t words) {
+    thread_local std::vector<uint32_t> scratch;
+    if (scratch.size() < words) {
+        scratch.resize(words);
+    }
+    return scratch.data();
+}
+
+#ifdef HAVE_AVX2
+bool use_avx2() {
+    static const bool supported = CPUFeatureDetector::cached().has_avx2;
+    return supported;
+}
+
+// Barrett reduction of any 32-bit lane value, q <= 2^16
+CLWE_TARGET_AVX2 inline __m256i reduce32_avx2(__m256i x, __m256i q_vec, __m256i m_vec) {
+    __m256i t_even = _mm256_srli_epi64(_mm256_mul_epu32(x, m_vec), 32);
+    __m256i t_odd = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), m_vec);
+    __m256i t = _mm256_blend_epi32(t_even, t_odd, 0xAA);
+    __m256i r = _mm256_sub_epi32(x, _mm256_mullo_epi32(t, q_vec));
+    return _mm256_min_epu32(r, _mm256_sub_epi32(r, q_vec));
+}
+
+// out[j] = sum_i a[i] * b[(j - i) mod n], eight outputs per register. bb holds b twice so
+// that b[(j - i) mod n] = bb[n + j - i] is always a contiguous load. When n products of
+// residues fit in 32 bits they are summed raw; otherwise each is reduced first (n * q < 2^32).
+CLWE_TARGET_AVX2 void schoolbook_avx2(const uint32_t* a, const uint32_t* bb, uint32_t n,
+                                      const BarrettReducer& reducer, uint32_t* out) {
+    const __m256i q_vec = _mm256_set1_epi32(static_cast<int>(reducer.modulus));
+    const __m256i m_vec = _mm256_set1_epi32(static_cast<int>(reducer.multiplier));
+    const bool lazy = static_cast<uint64_t>(reducer.modulus - 1) * (reducer.modulus - 1) * n <= 0xFFFFFFFFULL;
+    for (uint32_t j = 0; j < n; j += 8) {
+        __m256i acc = _mm256_setzero_si256();
+        const uint32_t* column = bb + n + j;
+        if (lazy) {
+            for (uint32_t i = 0; i < n; ++i) {
+                __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column - i));
+                acc = _mm256_add_epi32(acc, _mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int>(a[i])), vb));
+            }
+        } else {
+            for (uint32_t i = 0; i < n; ++i) {
+                __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column - i));
+                __m256i product = _mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int>(a[i])), vb);
+                acc = _mm256_add_epi32(acc, reduce32_avx2(product, q_vec, m_vec));
+            }
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + j), reduce32_avx2(acc, q_vec, m_vec));
+    }
+}
+#endif
+
+class SchoolbookMultiplier : public PolyMultiplier {
+public:
+    SchoolbookMultiplier(uint32_t q, uint32_t n) : PolyMultiplier(q, n), reducer_(q) {}
+
+    void multiply(const uint32_t* a, const uint32_t* b, uint32_t* result) const override {
+#ifdef HAVE_AVX2
+        if (n_ >= 8 && use_avx2()) {
+            // Copies of a and b twice over, so result may alias either
+            uint32_t* copy = thread_scratch(3 * static_cast<size_t>(n_));
+            std::copy(a, a + n_, copy);
+            std::copy(b, b + n_, copy + n_);
+            std::copy(b, b + n_, copy + 2 * n_);
+            schoolbook_avx2(copy, copy + n_, n_, reducer_, result);
+            return;
+        }
+#endif
+        // n products below q^2 each stay below 2^45 in 64 bits
+        thread_local std::vector<uint64_t> acc;
+        acc.assign(n_, 0);
+        for (uint32_t i = 0; i < n_; ++i) {
+            const uint64_t ai = a[i];
+            for (uint32_t j = 0; j < n_ - i; ++j) {
+                acc[i + j] += ai * b[j];
+            }
+            for (uint32_t j = n_ - i; j < n_; ++j) {
+                acc[i + j - n_] += ai * b[j];
+            }
+        }
+        for (uint32_t i = 0; i < n_; ++i) {
+            result[i] = static_cast<uint32_t>(acc[i] % q_);
+        }
+    }
+
+    MultiplierStrategy strategy() const override { return MultiplierStrategy::Schoolbook; }
+
+private:
+    BarrettReducer reducer_;
+};
+
+class KaratsubaMultiplier : public PolyMultiplier {
+public:
+    KaratsubaMultiplier(uint32_t q, uint32_t n)
+        : PolyMultiplier(q, n), reducer_(q),
+          lazy_base_(static_cast<uint64_t>(q - 1) * (q - 1) * KARATSUBA_BASE <= 0xFFFFFFFFULL) {}
+
+    void multiply(const uint32_t* a, const uint32_t* b, uint32_t* result) const override {
+        // Linear product (2n - 1 coefficients), then the recursion's scratch (under 4n)
+        uint32_t* linear = thread_scratch(6 * static_cast<size_t>(n_));
+        karatsuba(a, b, n_, linear, linear + 2 * n_);
+        // x^(n + i) = x^i in the cyclic ring
+        for (uint32_t i = 0; i + 1 < n_; ++i) {
+            result[i] = reducer_.add(linear[i], linear[n_ + i]);
+        }
+        result[n_ - 1] = linear[n_ - 1];
+    }
+
+    MultiplierStrategy strategy() const override { return MultiplierStrategy::Karatsuba; }
+
+private:
+    BarrettReducer reducer_;
+    bool lazy_base_;
+
+    // r[0, 2n - 1) = a * b with residues mod q; scratch holds 4n words
+    void karatsuba(const uint32_t* a, const uint32_t* b, uint32_t n, uint32_t* r, uint32_t* scratch) const {
+        if (n <= KARATSUBA_BASE) {
+            // 32-bit lanes vectorize; raw products when the column sums fit, reduced ones otherwise
+            uint32_t acc[2 * KARATSUBA_BASE - 1] = {};
+            if (lazy_base_) {
+                for (uint32_t i = 0; i < n; ++i) {
+                    for (uint32_t j = 0; j < n; ++j) {
+                        acc[i + j] += a[i] * b[j];
+                    }
+                }
+            } else {
+                for (uint32_t i = 0; i < n; ++i) {
+                    for (uint32_t j = 0; j < n; ++j) {
+                        acc[i + j] += reducer_.reduce(a[i] * b[j]);
+                    }
+                }
+            }
+            for (uint32_t i = 0; i + 1 < 2 * n; ++i) {
+                r[i] = reducer_.reduce(acc[i]);
+            }
+            return;
+        }
+
+        // a * b = z0 + (z1 - z0 - z2) x^h + z2 x^n with z1 = (a0 + a1)(b0 + b1)
+        const uint32_t h = n / 2;
+        karatsuba(a, b, h, r, scratch);
+        r[n - 1] = 0;
+        karatsuba(a + h, b + h, h, r + n, scratch);
+
+        uint32_t* sum_a = scratch;
+        uint32_t* sum_b = scratch + h;
+        uint32_t* middle = scratch + n;
+        for (uint32_t i = 0; i < h; ++i) {
+            sum_a[i] = reducer_.add(a[i], a[h + i]);
+            sum_b[i] = reducer_.add(b[i], b[h + i]);
+        }
+        karatsuba(sum_a, sum_b, h, middle, scratch + 2 * n);
+        // Subtract z0 and z2 before adding: the middle term overlaps both of them in r
+        for (uint32_t i = 0; i + 1 < n; ++i) {
+            middle[i] = reducer_.sub(reducer_.sub(middle[i], r[i]), r[n + i]);
+        }
+        for (uint32_t i = 0; i + 1 < n; ++i) {
+            r[h + i] = reducer_.add(r[h + i], middle[i]);
+        }
+    }
+};
+
+class NTTMultiplier : public PolyMultiplier {
+public:
+    NTTMultiplier(uint32_t q, uint32_t n)
+        : PolyMultiplier(q, n), engine_(create_optimal_ntt_engine(q, n)), reducer_(q),
+          degree_inv_(mod_inverse(n % q, q)) {}
+
+    void multiply(const uint32_t* a, const uint32_t* b, uint32_t* result) const override {
+        // The engines leave the inverse transform unscaled
+        engine_->multiply(a, b, result);
+        for (uint32_t i = 0; i < n_; ++i) {
+            result[i] = reducer_.mul(result[i], degree_inv_);
+        }
+    }
+
+    MultiplierStrategy strategy() const override { return MultiplierStrategy::NTT; }
+
+private:
+    std::unique_ptr<NTTEngine> engine_;
+    BarrettReducer reducer_;
+    uint32_t degree_inv_;
+};
+
+class MultiModularMultiplier : public PolyMultiplier {
+public:
+    MultiModularMultiplier(uint32_t q, uint32_t n)
+        : PolyMultiplier(q, n),
+          first_(create_optimal_ntt_engine(CRT_PRIME_1, n)),
+          second_(create_optimal_ntt_engine(CRT_PRIME_2, n)),
+          first_scale_(mod_inverse(n, CRT_PRIME_1)),
+          second_scale_(mod_inverse(n, CRT_PRIME_2)),
+          first_inv_(mod_inverse(CRT_PRIME_1 % CRT_PRIME_2, CRT_PRIME_2)) {}
+
+    void multiply(const uint32_t* a, const uint32_t* b, uint32_t* result) const override {
+        // Residues mod q are already reduced mod either prime
+        uint32_t* residues = thread_scratch(2 * static_cast<size_t>(n_));
+        first_->multiply(a, b, residues);
+        second_->multiply(a, b, residues + n_);
+        for (uint32_t i = 0; i < n_; ++i) {
+            // Garner: x = r1 + p1 * ((r2 - r1) / p1 mod p2) is the exact coefficient
+            const uint64_t r1 = static_cast<uint64_t>(residues[i]) * first_scale_ % CRT_PRIME_1;
+            const uint64_t r2 = static_cast<uint64_t>(residues[n_ + i]) * second_scale_ % CRT_PRIME_2;
+            const uint64_t lift = (r2 + CRT_PRIME_2 - r1 % CRT_PRIME_2) * first_inv_ % CRT_PRIME_2;
+            result[i] = static_cast<uint32_t>((r1 + lift * CRT_PRIME_1) % q_);
+        }
+    }
+
+    MultiplierStrategy strategy() const override { return MultiplierStrategy::MultiModularNTT; }
+
+private:
+    std::unique_ptr<NTTEngine> first_;
+    std::unique_ptr<NTTEngine> second_;
+    uint32_t first_scale_;
+    uint32_t second_scale_;
+    uint32_t first_inv_;
+};
+
+} // namespace
+
+PolyMultiplier::PolyMultiplier(uint32_t q, uint32_t n) : q_(q), n_(n) {
+    check_shape(q, n);
+}
+
+const char* multiplier_strategy_name(MultiplierStrategy strategy) {
+    switch (strategy) {
+    case MultiplierStrategy::Schoolbook:
+        return "schoolbook";
+    case MultiplierStrategy::Karatsuba:
+        return "karatsuba";
+    case MultiplierStrategy::NTT:
+        return "ntt";
+    case MultiplierStrategy::MultiModularNTT:
+    default:
+        return "multimodular";
+    }
+}
+
+bool ntt_friendly(uint32_t q, uint32_t n) {
+    uint32_t root = 0;
+    return CLWEParameters::is_prime(q) && n != 0 && is_power_of_two(n) && ntt_root(q, n, root);
+}
+
+MultiplierStrategy select_multiplier_strategy(uint32_t q, uint32_t n) {
+    check_shape(q, n);
+    if (n >= NTT_MIN_DEGREE && ntt_friendly(q, n)) {
+        return MultiplierStrategy::NTT;
+    }
+    if (n <= SCHOOLBOOK_MAX_DEGREE) {
+        return MultiplierStrategy::Schoolbook;
+    }
+    return n <= KARATSUBA_MAX_DEGREE ? MultiplierStrategy::Karatsuba : MultiplierStrategy::MultiModularNTT;
+}
+
+std::unique_ptr<PolyMultiplier> create_poly_multiplier(uint32_t q, uint32_t n) {
+    return create_poly_multiplier(select_multiplier_strategy(q, n), q, n);
+}
+
+std::unique_ptr<PolyMultiplier> create_poly_multiplier(MultiplierStrategy strategy, uint32_t q, uint32_t n) {
+    check_shape(q, n);
+    switch (strategy) {
+    case MultiplierStrategy::Schoolbook:
+        return std::make_unique<SchoolbookMultiplier>(q, n);
+    case MultiplierStrategy::Karatsuba:
+        return std::make_unique<KaratsubaMultiplier>(q, n);
+    case MultiplierStrategy::NTT:
+        if (!ntt_friendly(q, n)) {
+            throw std::invalid_argument("Modulus " + std::to_string(q) + " has no NTT of degree " +
+                                        std::to_string(n));
+        }
+        return std::make_unique<NTTMultiplier>(q, n);
+    case MultiplierStrategy::MultiModularNTT:
+        return std::make_unique<MultiModularMultiplier>(q, n);
+    }
+    throw std::invalid_argument("Unknown multiplier strategy");
+}
+
+} // namespace clwe
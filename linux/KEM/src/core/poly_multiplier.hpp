@@ -0,0 +1,62 @@
+#ifndef POLY_MULTIPLIER_HPP
+#define POLY_MULTIPLIER_HPP
+
+#include <cstdint>
+#include <memory>
+
+namespace clwe {
+
+// Coefficient-domain products in Z_q[x]/(x^n - 1) for any (q, n) CLWEParameters accepts:
+// 2 <= q <= 65536 and n a power of two up to 8192. NTTEngine only multiplies correctly when
+// its tables hold a primitive n-th root of unity; the other strategies need nothing of q.
+enum class MultiplierStrategy {
+    Schoolbook,       // O(n^2) rows of lazy products, AVX2 when the CPU has it
+    Karatsuba,        // Recursive three-product split down to a schoolbook base case
+    NTT,              // The dispatched NTTEngine; needs ntt_friendly(q, n)
+    MultiModularNTT,  // Exact integer product from NTTs mod two 30-bit primes, CRT, then mod q
+};
+
+// "schoolbook", "karatsuba", "ntt" or "multimodular"
+const char* multiplier_strategy_name(MultiplierStrategy strategy);
+
+// True when q is prime and n | q - 1, so ntt_root finds a primitive n-th root of unity for
+// the NTT tables of (q, n)
+bool ntt_friendly(uint32_t q, uint32_t n);
+
+class PolyMultiplier {
+public:
+    virtual ~PolyMultiplier() = default;
+
+    PolyMultiplier(const PolyMultiplier&) = delete;
+    PolyMultiplier& operator=(const PolyMultiplier&) = delete;
+
+    // result = a * b mod (x^n - 1, q), unscaled. Inputs must be reduced mod q; result may
+    // alias a or b. Scratch is thread-local and keeps its capacity, so steady-state calls
+    // do not allocate and one multiplier may be shared across threads.
+    virtual void multiply(const uint32_t* a, const uint32_t* b, uint32_t* result) const = 0;
+    virtual MultiplierStrategy strategy() const = 0;
+
+    uint32_t modulus() const { return q_; }
+    uint32_t degree() const { return n_; }
+
+protected:
+    PolyMultiplier(uint32_t q, uint32_t n);
+
+    uint32_t q_;
+    uint32_t n_;
+};
+
+// The strategy create_poly_multiplier(q, n) uses: the NTT when ntt_friendly(q, n) and n is
+// large enough to amortize it, otherwise schoolbook for small n, Karatsuba for medium n
+// and the multi-modular NTT above that. Throws std::invalid_argument outside the range above.
+MultiplierStrategy select_multiplier_strategy(uint32_t q, uint32_t n);
+
+std::unique_ptr<PolyMultiplier> create_poly_multiplier(uint32_t q, uint32_t n);
+
+// A specific strategy, for benchmarks and cross-checks. Throws std::invalid_argument for
+// MultiplierStrategy::NTT when !ntt_friendly(q, n).
+std::unique_ptr<PolyMultiplier> create_poly_multiplier(MultiplierStrategy strategy, uint32_t q, uint32_t n);
+
+} // namespace clwe
+
+#endif // POLY_MULTIPLIER_HPP
@@ -0,0 +1,377 @@
+#include "clwe/prepared_key_registry.hpp"
+#include "utils.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace clwe {
+
+// Immutable apart from its prepared form, which misses publish and evictions drop
+struct PreparedKeyRegistry::Entry {
+    KeyFingerprint fingerprint{};
+    uint64_t generation = 0;  // Unique per insert, so a miss can tell a replaced entry apart
+    ColorPrivateKey private_key;
+    std::atomic<const PreparedPrivateKey*> prepared{nullptr};
+    std::atomic<bool> referenced{false};  // Clock bit: used since the hand last passed
+
+    ~Entry() {
+        delete prepared.load();
+        secure_zero(private_key.secret_data.data(), private_key.secret_data.size());
+    }
+};
+
+namespace {
+
+// Spreads threads over the reader slots so they do not share a counter's cache line
+size_t reader_slot_index() {
+    static std::atomic<size_t> next_slot{0};
+    thread_local const size_t slot =
+        next_slot.fetch_add(1, std::memory_order_relaxed) % PreparedKeyRegistry::READER_SLOTS;
+    return slot;
+}
+
+size_t table_size_for(size_t capacity) {
+    size_t size = 1;
+    while (size < 2 * capacity) {
+        size <<= 1;
+    }
+    return size;
+}
+
+template <typename Entry>
+std::atomic<Entry*>* new_table(size_t size) {
+    std::atomic<Entry*>* slots = new std::atomic<Entry*>[size];
+    for (size_t i = 0; i < size; ++i) {
+        slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+    return slots;
+}
+
+} // namespace
+
+PreparedKeyRegistry::Pin::Pin(const PreparedKeyRegistry& registry) {
+    ReaderSlot& slot = registry.reader_slots_[reader_slot_index()];
+    for (;;) {
+        // Announce the reader under the epoch it saw, then confirm no writer flipped it
+        // meanwhile; a reader counted under the old parity is one synchronize() waits for
+        const uint64_t epoch = registry.epoch_.load();
+        std::atomic<uint64_t>& counter = slot.readers[epoch & 1];
+        counter.fetch_add(1);
+        if (registry.epoch_.load() == epoch) {
+            counter_ = &counter;
+            return;
+        }
+        counter.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+PreparedKeyRegistry::Pin::~Pin() {
+    counter_->fetch_sub(1, std::memory_order_release);
+}
+
+PreparedKeyRegistry::PreparedKeyRegistry(const ColorKEM& kem, size_t capacity, size_t max_prepared)
+    : kem_(kem), capacity_(capacity), max_prepared_(max_prepared), table_size_(table_size_for(capacity)),
+      slots_(nullptr), epoch_(0), key_count_(0), tombstone_count_(0), next_generation_(0), clock_hand_(0),
+      prepared_count_(0), preparations_(0), evictions_(0) {
+    if (capacity == 0 || max_prepared == 0) {
+        throw std::invalid_argument("Prepared key registry needs a capacity and a prepared bound of at least 1");
+    }
+    slots_.store(new_table<Entry>(table_size_), std::memory_order_relaxed);
+    for (ReaderSlot& slot : reader_slots_) {
+        slot.readers[0].store(0, std::memory_order_relaxed);
+        slot.readers[1].store(0, std::memory_order_relaxed);
+    }
+}
+
+PreparedKeyRegistry::~PreparedKeyRegistry() {
+    std::atomic<Entry*>* slots = slots_.load();
+    for (size_t i = 0; i < table_size_; ++i) {
+        Entry* entry = slots[i].load();
+        if (entry != tombstone()) {
+            delete entry;
+        }
+    }
+    delete[] slots;
+}
+
+PreparedKeyRegistry::Entry* PreparedKeyRegistry::tombstone() {
+    static Entry marker;
+    return &marker;
+}
+
+size_t PreparedKeyRegistry::home_slot(const KeyFingerprint& fingerprint) const {
+    uint64_t hash;
+    std::memcpy(&hash, fingerprint.data(), sizeof(hash));
+    return static_cast<size_t>(hash) & (table_size_ - 1);
+}
+
+size_t PreparedKeyRegistry::find_slot(const KeyFingerprint& fingerprint, const Entry** found,
+                                      size_t* probes) const {
+    // Linear probing from the home slot up to the first never-used slot
+    const std::atomic<Entry*>* slots = slots_.load(std::memory_order_acquire);
+    size_t slot = home_slot(fingerprint);
+    size_t probe = 0;
+    for (; probe < table_size_; ++probe, slot = (slot + 1) & (table_size_ - 1)) {
+        const Entry* entry = slots[slot].load(std::memory_order_acquire);
+        if (entry == nullptr) {
+            break;
+        }
+        if (entry != tombstone() && entry->fingerprint == fingerprint) {
+            if (found != nullptr) {
+                *found = entry;
+            }
+            if (probes != nullptr) {
+                *probes = probe + 1;
+            }
+            return slot;
+        }
+    }
+    if (probes != nullptr) {
+        *probes = probe + (probe < table_size_ ? 1 : 0);
+    }
+    return table_size_;
+}
+
+const PreparedKeyRegistry::Entry* PreparedKeyRegistry::lookup(const KeyFingerprint& fingerprint) const {
+    // One load per slot: a writer may replace the slot between two loads
+    const Entry* entry = nullptr;
+    find_slot(fingerprint, &entry);
+    return entry;
+}
+
+void PreparedKeyRegistry::synchronize() const {
+    // Readers arriving after the flip count under the other parity and cannot see what
+    // the writer unlinked before it. Writers call this after dropping write_mutex_, so
+    // flips are serialized here instead
+    std::lock_guard<std::mutex> lock(synchronize_mutex_);
+    const uint64_t epoch = epoch_.load();
+    epoch_.store(epoch + 1);
+    for (ReaderSlot& slot : reader_slots_) {
+        while (slot.readers[epoch & 1].load() != 0) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void PreparedKeyRegistry::insert(const KeyFingerprint& fingerprint, const ColorPrivateKey& private_key) {
+    if (private_key.params.fingerprint() != kem_.params().fingerprint()) {
+        throw std::invalid_argument("Private key parameters do not match KEM instance parameters");
+    }
+    const size_t expected = ColorPrivateKey::serialized_size(kem_.params());
+    if (private_key.secret_data.size() != expected) {
+        throw std::invalid_argument("Invalid private key data size: expected " + std::to_string(expected) +
+                                    " bytes, got " + std::to_string(private_key.secret_data.size()));
+    }
+    auto entry = std::make_unique<Entry>();
+    entry->fingerprint = fingerprint;
+    entry->private_key = private_key;
+
+    Entry* retired;
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        entry->generation = next_generation_++;
+        std::atomic<Entry*>* slots = slots_.load(std::memory_order_relaxed);
+        size_t slot = find_slot(fingerprint);
+        if (slot == table_size_) {
+            if (key_count_ == capacity_) {
+                throw std::runtime_error("Prepared key registry is full: " + std::to_string(capacity_) + " keys");
+            }
+            // The table is at most half full of keys, so a free or erased slot is always within reach
+            slot = home_slot(fingerprint);
+            Entry* used = slots[slot].load(std::memory_order_relaxed);
+            for (; used != nullptr && used != tombstone(); used = slots[slot].load(std::memory_order_relaxed)) {
+                slot = (slot + 1) & (table_size_ - 1);
+            }
+            if (used == tombstone()) {
+                --tombstone_count_;
+            }
+            slots[slot].store(entry.release(), std::memory_order_release);
+            ++key_count_;
+            return;
+        }
+
+        retired = slots[slot].exchange(entry.release(), std::memory_order_acq_rel);
+        if (retired->prepared.load() != nullptr) {
+            prepared_count_.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+    synchronize();
+    delete retired;
+}
+
+bool PreparedKeyRegistry::erase(const KeyFingerprint& fingerprint) {
+    Entry* retired;
+    std::atomic<Entry*>* retired_table = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        size_t slot = find_slot(fingerprint);
+        if (slot == table_size_) {
+            return false;
+        }
+        retired = slots_.load(std::memory_order_relaxed)[slot].exchange(tombstone(), std::memory_order_acq_rel);
+        --key_count_;
+        ++tombstone_count_;
+        if (retired->prepared.load() != nullptr) {
+            prepared_count_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        // Erased marks never turn back into free slots in place, so churn would leave misses
+        // probing the whole table; past three quarters occupancy, start from a clean table
+        if (4 * (key_count_ + tombstone_count_) > 3 * table_size_) {
+            retired_table = rebuild();
+        }
+    }
+    synchronize();
+    delete retired;
+    delete[] retired_table;
+    return true;
+}
+
+std::atomic<PreparedKeyRegistry::Entry*>* PreparedKeyRegistry::rebuild() {
+    std::atomic<Entry*>* old_slots = slots_.load(std::memory_order_relaxed);
+    std::atomic<Entry*>* slots = new_table<Entry>(table_size_);
+    for (size_t i = 0; i < table_size_; ++i) {
+        Entry* entry = old_slots[i].load(std::memory_order_relaxed);
+        if (entry == nullptr || entry == tombstone()) {
+            continue;
+        }
+        size_t slot = home_slot(entry->fingerprint);
+        while (slots[slot].load(std::memory_order_relaxed) != nullptr) {
+            slot = (slot + 1) & (table_size_ - 1);
+        }
+        slots[slot].store(entry, std::memory_order_relaxed);
+    }
+    // Readers still probing the old table find the same entries there until synchronize()
+    slots_.store(slots, std::memory_order_release);
+    tombstone_count_ = 0;
+    return old_slots;
+}
+
+bool PreparedKeyRegistry::contains(const KeyFingerprint& fingerprint) const {
+    Pin pin(*this);
+    return lookup(fingerprint) != nullptr;
+}
+
+void PreparedKeyRegistry::prepare(const KeyFingerprint& fingerprint) const {
+    // Copy the serialized key under a pin and prepare it with no lock held, so a slow
+    // preparation stalls neither other tenants' misses nor inserts and erases
+    ColorPrivateKey private_key;
+    uint64_t generation;
+    {
+        Pin pin(*this);
+        const Entry* entry = lookup(fingerprint);
+        if (entry == nullptr || entry->prepared.load(std::memory_order_acquire) != nullptr) {
+            return;  // Erased or prepared meanwhile; the caller's next lookup sees which
+        }
+        private_key = entry->private_key;
+        generation = entry->generation;
+    }
+    std::unique_ptr<PreparedPrivateKey> prepared(new PreparedPrivateKey(kem_.prepare_private_key(private_key)));
+    secure_zero(private_key.secret_data.data(), private_key.secret_data.size());
+
+    std::vector<const PreparedPrivateKey*> retired;
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        size_t slot = find_slot(fingerprint);
+        if (slot == table_size_) {
+            return;  // Erased meanwhile
+        }
+        Entry* entry = slots_.load(std::memory_order_relaxed)[slot].load(std::memory_order_relaxed);
+        if (entry->generation != generation || entry->prepared.load(std::memory_order_relaxed) != nullptr) {
+            return;  // Replaced, or another miss on the same key got here first; drop ours
+        }
+        entry->prepared.store(prepared.release(), std::memory_order_release);
+        entry->referenced.store(true, std::memory_order_relaxed);
+        prepared_count_.fetch_add(1, std::memory_order_relaxed);
+        preparations_.fetch_add(1, std::memory_order_relaxed);
+        evict(entry, retired);
+    }
+    if (retired.empty()) {
+        return;
+    }
+    synchronize();
+    for (const PreparedPrivateKey* evicted : retired) {
+        delete evicted;
+    }
+}
+
+void PreparedKeyRegistry::evict(const Entry* keep, std::vector<const PreparedPrivateKey*>& retired) const {
+    const std::atomic<Entry*>* slots = slots_.load(std::memory_order_relaxed);
+    while (prepared_count_.load(std::memory_order_relaxed) > max_prepared_) {
+        // Clock sweep: a key used since the last pass gets a second chance. With more than
+        // max_prepared_ >= 1 keys prepared, one besides keep is found within two passes
+        Entry* entry = slots[clock_hand_].load(std::memory_order_relaxed);
+        clock_hand_ = (clock_hand_ + 1) & (table_size_ - 1);
+        if (entry == nullptr || entry == tombstone() || entry == keep || entry->prepared.load(std::memory_order_relaxed) == nullptr) {
+            continue;
+        }
+        if (entry->referenced.exchange(false, std::memory_order_relaxed)) {
+            continue;
+        }
+        retired.push_back(entry->prepared.exchange(nullptr, std::memory_order_acq_rel));
+        prepared_count_.fetch_sub(1, std::memory_order_relaxed);
+        evictions_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+template <typename Decapsulate>
+ColorValue PreparedKeyRegistry::with_prepared(const KeyFingerprint& fingerprint,
+                                              const Decapsulate& decapsulate) const {
+    for (;;) {
+        {
+            Pin pin(*this);
+            const Entry* entry = lookup(fingerprint);
+            if (entry == nullptr) {
+                throw std::invalid_argument("Prepared key registry holds no key with this fingerprint");
+            }
+            const PreparedPrivateKey* prepared = entry->prepared.load(std::memory_order_acquire);
+            if (prepared != nullptr) {
+                // Skip the store when the bit is already set, so hot keys keep their line shared
+                if (!entry->referenced.load(std::memory_order_relaxed)) {
+                    const_cast<Entry*>(entry)->referenced.store(true, std::memory_order_relaxed);
+                }
+                return decapsulate(*prepared);
+            }
+        }
+        // Prepare with the pin released: publishing may evict, which waits for readers
+        prepare(fingerprint);
+    }
+}
+
+ColorValue PreparedKeyRegistry::decapsulate(const KeyFingerprint& fingerprint,
+                                            const ColorCiphertext& ciphertext) const {
+    return with_prepared(fingerprint, [&](const PreparedPrivateKey& key) { return kem_.decapsulate(key, ciphertext); });
+}
+
+ColorValue PreparedKeyRegistry::decapsulate(const KeyFingerprint& fingerprint, const ColorCiphertextView& ciphertext,
+                                            KemWorkspace& workspace) const {
+    return with_prepared(fingerprint,
+                         [&](const PreparedPrivateKey& key) { return kem_.decapsulate(key, ciphertext, workspace); });
+}
+
+size_t PreparedKeyRegistry::probe_length(const KeyFingerprint& fingerprint) const {
+    Pin pin(*this);
+    size_t probes = 0;
+    find_slot(fingerprint, nullptr, &probes);
+    return probes;
+}
+
+size_t PreparedKeyRegistry::size() const {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    return key_count_;
+}
+
+size_t PreparedKeyRegistry::prepared_size() const {
+    return prepared_count_.load(std::memory_order_relaxed);
+}
+
+uint64_t PreparedKeyRegistry::preparations() const {
+    return preparations_.load(std::memory_order_relaxed);
+}
+
+uint64_t PreparedKeyRegistry::evictions() const {
+    return evictions_.load(std::memory_order_relaxed);
+}
+
+} // namespace clwe
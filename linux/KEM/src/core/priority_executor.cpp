@@ -0,0 +1,211 @@
+#include "clwe/priority_executor.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace clwe {
+
+namespace {
+
+// One parallel-for call: workers and the caller claim indices until all are taken
+struct ParallelJob {
+    size_t count;
+    const std::function<void(size_t)>* task;  // Only touched after a successful claim
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> done{0};
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::exception_ptr error;
+
+    ParallelJob(size_t job_count, const std::function<void(size_t)>* job_task) : count(job_count), task(job_task) {}
+
+    void work() {
+        for (;;) {
+            const size_t index = next.fetch_add(1, std::memory_order_relaxed);
+            if (index >= count) {
+                return;
+            }
+            try {
+                (*task)(index);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+            if (done.fetch_add(1, std::memory_order_acq_rel) + 1 == count) {
+                std::lock_guard<std::mutex> lock(mutex);
+                finished.notify_all();
+            }
+        }
+    }
+};
+
+} // namespace
+
+struct PriorityExecutor::Impl {
+    std::mutex mutex;
+    std::condition_variable work_cv;
+    std::deque<std::function<void()>> queues[WORK_CLASS_COUNT];
+    size_t running[WORK_CLASS_COUNT] = {};
+    size_t caps[WORK_CLASS_COUNT] = {};
+    std::atomic<uint64_t> completed[WORK_CLASS_COUNT] = {};
+    std::atomic<uint64_t> failed[WORK_CLASS_COUNT] = {};
+    std::function<void(WorkClass, std::exception_ptr)> on_error;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+
+    // The most urgent queued class still under its cap, or WORK_CLASS_COUNT
+    size_t runnable_class() const {
+        for (size_t c = 0; c < WORK_CLASS_COUNT; ++c) {
+            if (!queues[c].empty() && running[c] < caps[c]) {
+                return c;
+            }
+        }
+        return WORK_CLASS_COUNT;
+    }
+
+    bool idle() const {
+        for (const auto& queue : queues) {
+            if (!queue.empty()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void report_error(WorkClass work_class, std::exception_ptr error) const {
+        if (!on_error) {
+            return;
+        }
+        try {
+            on_error(work_class, std::move(error));
+        } catch (...) {
+            // A throwing handler must not take the worker down either
+        }
+    }
+
+    void run_worker() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            size_t c;
+            work_cv.wait(lock, [&] { return (c = runnable_class()) < WORK_CLASS_COUNT || (stopping && idle()); });
+            if (c == WORK_CLASS_COUNT) {
+                return;
+            }
+            std::function<void()> job = std::move(queues[c].front());
+            queues[c].pop_front();
+            ++running[c];
+            lock.unlock();
+
+            // An exception escaping the worker would terminate the process
+            try {
+                job();
+            } catch (...) {
+                failed[c].fetch_add(1, std::memory_order_relaxed);
+                report_error(static_cast<WorkClass>(c), std::current_exception());
+            }
+            job = nullptr;
+            completed[c].fetch_add(1, std::memory_order_relaxed);
+
+            lock.lock();
+            --running[c];
+            // A capped class that was held back may run again; at stop the others must
+            // also see the queues drain
+            if (!queues[c].empty() || stopping) {
+                work_cv.notify_all();
+            }
+        }
+    }
+};
+
+PriorityExecutor::PriorityExecutor(const PriorityExecutorConfig& config) : impl_(new Impl()) {
+    size_t threads = config.threads;
+    if (threads == 0) {
+        threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    if (config.max_preparation_threads > threads || config.max_background_threads > threads) {
+        throw std::invalid_argument("PriorityExecutor caps must not exceed its " + std::to_string(threads) +
+                                    " threads");
+    }
+    impl_->on_error = config.on_error;
+    impl_->caps[static_cast<size_t>(WorkClass::FOREGROUND)] = threads;
+    impl_->caps[static_cast<size_t>(WorkClass::PREPARATION)] =
+        config.max_preparation_threads == 0 ? threads : config.max_preparation_threads;
+    impl_->caps[static_cast<size_t>(WorkClass::BACKGROUND)] =
+        config.max_background_threads == 0 ? threads : config.max_background_threads;
+    for (size_t i = 0; i < threads; ++i) {
+        impl_->workers.emplace_back(&Impl::run_worker, impl_.get());
+    }
+}
+
+PriorityExecutor::~PriorityExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        impl_->stopping = true;
+    }
+    impl_->work_cv.notify_all();
+    for (std::thread& worker : impl_->workers) {
+        worker.join();
+    }
+}
+
+void PriorityExecutor::post(WorkClass work_class, std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        impl_->queues[static_cast<size_t>(work_class)].push_back(std::move(job));
+    }
+    impl_->work_cv.notify_one();
+}
+
+AsyncKemPost PriorityExecutor::poster(WorkClass work_class) {
+    return [this, work_class](std::function<void()> job) { post(work_class, std::move(job)); };
+}
+
+KemExecutor PriorityExecutor::parallel_for(WorkClass work_class) {
+    return [this, work_class](size_t count, const std::function<void(size_t)>& task) {
+        if (count == 0) {
+            return;
+        }
+        auto job = std::make_shared<ParallelJob>(count, &task);
+        // Helpers that start after every index is claimed return without touching task
+        const size_t helpers = std::min(count, impl_->workers.size() + 1) - 1;
+        for (size_t i = 0; i < helpers; ++i) {
+            post(work_class, [job] { job->work(); });
+        }
+        job->work();
+        {
+            std::unique_lock<std::mutex> lock(job->mutex);
+            job->finished.wait(lock, [&] { return job->done.load(std::memory_order_acquire) == count; });
+        }
+        if (job->error) {
+            std::rethrow_exception(job->error);
+        }
+    };
+}
+
+size_t PriorityExecutor::pending(WorkClass work_class) const {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    return impl_->queues[static_cast<size_t>(work_class)].size();
+}
+
+uint64_t PriorityExecutor::completed(WorkClass work_class) const {
+    return impl_->completed[static_cast<size_t>(work_class)].load(std::memory_order_relaxed);
+}
+
+uint64_t PriorityExecutor::failed(WorkClass work_class) const {
+    return impl_->failed[static_cast<size_t>(work_class)].load(std::memory_order_relaxed);
+}
+
+size_t PriorityExecutor::threads() const {
+    return impl_->workers.size();
+}
+
+} // namespace clwe
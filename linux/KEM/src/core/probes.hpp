@@ -0,0 +1,35 @@
+#ifndef PROBES_HPP
+#define PROBES_HPP
+
+// USDT static probes of provider "clwe", for bpftrace, perf and SystemTap on running binaries:
+//
+//   bpftrace -e 'usdt:./server:clwe:decapsulate_entry { @s[tid] = nsecs; }
+//                usdt:./server:clwe:decapsulate_return /@s[tid]/ {
+//                    @ns = hist(nsecs - @s[tid]); delete(@s[tid]); }'
+//
+// A probe site is one nop plus an ELF note until a tracer attaches, so they stay compiled in.
+// CLWE_ENABLE_USDT builds on hosts with <sys/sdt.h> (systemtap-sdt-dev) get them; elsewhere
+// the macros compile to nothing.
+#if defined(CLWE_ENABLE_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define CLWE_HAVE_USDT 1
+#endif
+#endif
+
+#ifdef CLWE_HAVE_USDT
+#define CLWE_PROBE(name) DTRACE_PROBE(clwe, name)
+#define CLWE_PROBE1(name, arg) DTRACE_PROBE1(clwe, name, arg)
+// Fires name_entry here and name_return when the enclosing scope exits, also by exception
+#define CLWE_PROBE_SCOPE(name)                                                       \
+    CLWE_PROBE(name##_entry);                                                        \
+    struct clwe_probe_return_##name {                                                \
+        ~clwe_probe_return_##name() { CLWE_PROBE(name##_return); }                   \
+    } clwe_probe_scope_##name
+#else
+#define CLWE_PROBE(name) ((void)0)
+#define CLWE_PROBE1(name, arg) ((void)0)
+#define CLWE_PROBE_SCOPE(name) ((void)0)
+#endif
+
+#endif // PROBES_HPP
@@ -0,0 +1,37 @@
+#include "clwe/random_source.hpp"
+#include "csprng.hpp"
+#include "utils.hpp"
+
+namespace clwe {
+
+void OSRandomSource::generate(uint8_t* out, size_t len) {
+    os_random_bytes(out, len);
+}
+
+void DrbgRandomSource::generate(uint8_t* out, size_t len) {
+    thread_drbg().generate(out, len);
+}
+
+DeterministicRandomSource::DeterministicRandomSource(const std::array<uint8_t, 32>& seed)
+    : drbg_(new ChaCha20Drbg()) {
+    // An explicit seed turns off OS reseeding, so the stream depends on seed alone
+    drbg_->seed(seed.data());
+}
+
+DeterministicRandomSource::~DeterministicRandomSource() = default;
+
+void DeterministicRandomSource::generate(uint8_t* out, size_t len) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    drbg_->generate(out, len);
+}
+
+std::shared_ptr<RandomSource> default_random_source() {
+#ifdef CLWE_DIRECT_OS_RANDOM
+    static const std::shared_ptr<RandomSource> source = std::make_shared<OSRandomSource>();
+#else
+    static const std::shared_ptr<RandomSource> source = std::make_shared<DrbgRandomSource>();
+#endif
+    return source;
+}
+
+} // namespace clwe
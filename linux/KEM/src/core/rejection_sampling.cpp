@@ -0,0 +1,211 @@
+#include "rejection_sampling.hpp"
+#include "cpu_features.hpp"
+#include "simd_target.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#ifdef HAVE_AVX2
+#include <immintrin.h>
+#endif
+#ifdef HAVE_NEON
+#include <arm_neon.h>
+#endif
+#ifdef HAVE_SVE
+#include "sampling_sve.hpp"
+#endif
+
+namespace clwe {
+
+namespace {
+
+#if defined(HAVE_AVX2) || defined(HAVE_NEON)
+// Byte shuffle that packs the accepted 16-bit candidates of an 8-bit mask to the front
+using CompressTable = std::array<std::array<uint8_t, 16>, 256>;
+
+constexpr CompressTable make_compress_table() {
+    CompressTable table{};
+    for (size_t mask = 0; mask < 256; ++mask) {
+        size_t k = 0;
+        for (size_t i = 0; i < 8; ++i) {
+            if ((mask >> i) & 1) {
+                table[mask][2 * k] = static_cast<uint8_t>(2 * i);
+                table[mask][2 * k + 1] = static_cast<uint8_t>(2 * i + 1);
+                ++k;
+            }
+        }
+        for (size_t i = 2 * k; i < 16; ++i) {
+            table[mask][i] = 0x80;
+        }
+    }
+    return table;
+}
+
+alignas(16) constexpr CompressTable COMPRESS_TABLE = make_compress_table();
+
+// Spreads bytes [3t, 3t+1, 3t+2] of a 12-byte group into 16-bit words b0:b1 and b1:b2
+alignas(16) constexpr uint8_t SPREAD_INDEX[16] = {1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10};
+#endif
+
+inline uint32_t byte_swap32(uint32_t v) {
+    return (v >> 24) | ((v >> 8) & 0xFF00) | ((v << 8) & 0xFF0000) | (v << 24);
+}
+
+// Stores go through memcpy so the big-endian variant may target ColorValue storage
+template <bool BigEndian>
+size_t rejection_scalar(uint32_t* out, size_t written, size_t max_out,
+                        const uint8_t* buf, size_t pos, size_t buflen, uint32_t modulus) {
+    while (pos + 3 <= buflen && written < max_out) {
+        uint32_t coeff1 = ((buf[pos] << 4) | (buf[pos + 1] >> 4)) & 0xFFF;
+        uint32_t coeff2 = ((buf[pos + 1] << 8) | buf[pos + 2]) & 0xFFF;
+        pos += 3;
+
+        if (coeff1 < modulus && written < max_out) {
+            uint32_t value = BigEndian ? byte_swap32(coeff1) : coeff1;
+            std::memcpy(out + written++, &value, sizeof(value));
+        }
+        if (coeff2 < modulus && written < max_out) {
+            uint32_t value = BigEndian ? byte_swap32(coeff2) : coeff2;
+            std::memcpy(out + written++, &value, sizeof(value));
+        }
+    }
+    return written;
+}
+
+#ifdef HAVE_AVX2
+bool use_avx2() {
+    static const bool supported = CPUFeatureDetector::cached().has_avx2;
+    return supported;
+}
+
+// Widen up to eight packed candidates to 32 bits and store them; always writes 8 slots
+template <bool BigEndian>
+CLWE_TARGET_AVX2 inline void store_compressed(uint32_t* out, __m128i words, uint32_t mask) {
+    __m128i table = _mm_load_si128(reinterpret_cast<const __m128i*>(COMPRESS_TABLE[mask].data()));
+    __m256i wide = _mm256_cvtepu16_epi32(_mm_shuffle_epi8(words, table));
+    if (BigEndian) {
+        const __m256i swap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                              3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+        wide = _mm256_shuffle_epi8(wide, swap);
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), wide);
+}
+
+// 24 input bytes -> 16 candidates per step, one 12-byte group in each 128-bit lane
+template <bool BigEndian>
+CLWE_TARGET_AVX2 size_t rejection_avx2(uint32_t* out, size_t max_out, const uint8_t* buf, size_t buflen, uint32_t modulus) {
+    const __m128i spread128 = _mm_load_si128(reinterpret_cast<const __m128i*>(SPREAD_INDEX));
+    const __m256i spread = _mm256_broadcastsi128_si256(spread128);
+    const __m256i mask12 = _mm256_set1_epi16(0x0FFF);
+    const __m256i bound = _mm256_set1_epi16(static_cast<int16_t>(modulus));
+
+    size_t written = 0;
+    size_t pos = 0;
+    // Each lane loads 16 bytes for its 12, and each step may store 16 slots
+    while (pos + 28 <= buflen && written + 16 <= max_out) {
+        __m256i raw = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + pos))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + pos + 12)), 1);
+        __m256i words = _mm256_shuffle_epi8(raw, spread);
+        // Even words hold b0:b1 and need >> 4; odd words hold b1:b2 and only the mask
+        words = _mm256_blend_epi16(_mm256_srli_epi16(words, 4), words, 0xAA);
+        words = _mm256_and_si256(words, mask12);
+
+        __m256i accepted = _mm256_cmpgt_epi16(bound, words);
+        uint32_t bits = static_cast<uint32_t>(
+            _mm256_movemask_epi8(_mm256_packs_epi16(accepted, _mm256_setzero_si256())));
+        uint32_t mask_lo = bits & 0xFF;
+        uint32_t mask_hi = (bits >> 16) & 0xFF;
+
+        store_compressed<BigEndian>(out + written, _mm256_castsi256_si128(words), mask_lo);
+        written += static_cast<size_t>(__builtin_popcount(mask_lo));
+        store_compressed<BigEndian>(out + written, _mm256_extracti128_si256(words, 1), mask_hi);
+        written += static_cast<size_t>(__builtin_popcount(mask_hi));
+        pos += 24;
+    }
+    return rejection_scalar<BigEndian>(out, written, max_out, buf, pos, buflen, modulus);
+}
+#endif
+
+#ifdef HAVE_NEON
+// 12 input bytes -> 8 candidates per step, compressed with a table lookup
+template <bool BigEndian>
+size_t rejection_neon(uint32_t* out, size_t max_out, const uint8_t* buf, size_t buflen, uint32_t modulus) {
+    const uint8x16_t spread = vld1q_u8(SPREAD_INDEX);
+    const int16_t shift_values[8] = {-4, 0, -4, 0, -4, 0, -4, 0};
+    const int16x8_t shifts = vld1q_s16(shift_values);
+    const uint16_t bit_values[8] = {1, 2, 4, 8, 16, 32, 64, 128};
+    const uint16x8_t bit_weights = vld1q_u16(bit_values);
+    const uint16x8_t mask12 = vdupq_n_u16(0x0FFF);
+    const uint16x8_t bound = vdupq_n_u16(static_cast<uint16_t>(modulus));
+
+    size_t written = 0;
+    size_t pos = 0;
+    while (pos + 16 <= buflen && written + 8 <= max_out) {
+        uint8x16_t raw = vld1q_u8(buf + pos);
+        uint16x8_t words = vreinterpretq_u16_u8(vqtbl1q_u8(raw, spread));
+        words = vandq_u16(vshlq_u16(words, shifts), mask12);
+
+        uint16x8_t accepted = vcltq_u16(words, bound);
+        uint32_t mask = vaddvq_u16(vandq_u16(accepted, bit_weights));
+
+        uint8x16_t packed = vqtbl1q_u8(vreinterpretq_u8_u16(words), vld1q_u8(COMPRESS_TABLE[mask].data()));
+        uint16x8_t packed16 = vreinterpretq_u16_u8(packed);
+        uint32x4_t lo = vmovl_u16(vget_low_u16(packed16));
+        uint32x4_t hi = vmovl_u16(vget_high_u16(packed16));
+        if (BigEndian) {
+            lo = vreinterpretq_u32_u8(vrev32q_u8(vreinterpretq_u8_u32(lo)));
+            hi = vreinterpretq_u32_u8(vrev32q_u8(vreinterpretq_u8_u32(hi)));
+        }
+        vst1q_u32(out + written, lo);
+        vst1q_u32(out + written + 4, hi);
+        written += static_cast<size_t>(__builtin_popcount(mask));
+        pos += 12;
+    }
+    return rejection_scalar<BigEndian>(out, written, max_out, buf, pos, buflen, modulus);
+}
+#endif
+
+#ifdef HAVE_SVE
+bool use_sve() {
+    static const bool supported = CPUFeatureDetector::cached().has_sve;
+    return supported;
+}
+#endif
+
+template <bool BigEndian>
+size_t rejection_dispatch(uint32_t* out, size_t max_out, const uint8_t* buf, size_t buflen, uint32_t modulus) {
+    // Candidates never exceed 4095, so a larger modulus accepts everything
+    modulus = std::min<uint32_t>(modulus, 4096);
+#ifdef HAVE_SVE
+    if (use_sve()) {
+        size_t consumed = 0;
+        size_t written = rejection_uniform12_sve(out, max_out, buf, buflen, modulus, BigEndian, consumed);
+        return rejection_scalar<BigEndian>(out, written, max_out, buf, consumed, buflen, modulus);
+    }
+#endif
+#ifdef HAVE_AVX2
+    if (use_avx2()) {
+        return rejection_avx2<BigEndian>(out, max_out, buf, buflen, modulus);
+    }
+#endif
+#ifdef HAVE_NEON
+    return rejection_neon<BigEndian>(out, max_out, buf, buflen, modulus);
+#else
+    return rejection_scalar<BigEndian>(out, 0, max_out, buf, 0, buflen, modulus);
+#endif
+}
+
+} // namespace
+
+size_t rejection_sample_uniform12(uint32_t* out, size_t max_out,
+                                  const uint8_t* buf, size_t buflen, uint32_t modulus) {
+    return rejection_dispatch<false>(out, max_out, buf, buflen, modulus);
+}
+
+size_t rejection_sample_uniform12_be(uint32_t* out, size_t max_out,
+                                     const uint8_t* buf, size_t buflen, uint32_t modulus) {
+    return rejection_dispatch<true>(out, max_out, buf, buflen, modulus);
+}
+
+} // namespace clwe
@@ -0,0 +1,22 @@
+#ifndef REJECTION_SAMPLING_HPP
+#define REJECTION_SAMPLING_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace clwe {
+
+// Parse 12-bit candidates from buf, three bytes -> two values with the high nibble
+// first, and keep those below modulus. Stops after max_out values or
+// the last whole triple; returns the number written. SVE/AVX2/NEON when available.
+size_t rejection_sample_uniform12(uint32_t* out, size_t max_out,
+                                  const uint8_t* buf, size_t buflen, uint32_t modulus);
+
+// Same, but each value is stored big-endian: the in-memory form of a ColorValue, so
+// polynomial buffers can be filled in place
+size_t rejection_sample_uniform12_be(uint32_t* out, size_t max_out,
+                                     const uint8_t* buf, size_t buflen, uint32_t modulus);
+
+} // namespace clwe
+
+#endif // REJECTION_SAMPLING_HPP
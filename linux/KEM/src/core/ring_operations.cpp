@@ -0,0 +1,508 @@
+#include "ring_operations.hpp"
+#include "clwe/clwe.hpp"
+#include "cpu_features.hpp"
+#include "probes.hpp"
+#include "simd_target.hpp"
+#include "work_counters.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#if defined(HAVE_AVX2) || defined(HAVE_AVX512BW)
+#include <immintrin.h>
+#endif
+#ifdef HAVE_NEON
+#include <arm_neon.h>
+#endif
+
+namespace clwe {
+
+namespace {
+
+static_assert(sizeof(ColorValue) == 4, "ColorValue must be 4 packed bytes");
+
+// The color layout (r, g, b, a) is the big-endian math value
+inline uint32_t load_value(const ColorValue* colors, size_t i) {
+    return colors[i].to_math_value();
+}
+
+inline void store_value(ColorValue* colors, size_t i, uint32_t value) {
+    colors[i] = ColorValue::from_math_value(value);
+}
+
+// Pointwise operation of the two-input kernels; inputs are reduced before it is applied
+enum class Pointwise { Add, Sub, Mul };
+
+inline uint32_t apply_scalar(const BarrettReducer& reducer, uint32_t a, uint32_t b, Pointwise op) {
+    a = reducer.reduce(a);
+    b = reducer.reduce(b);
+    switch (op) {
+    case Pointwise::Add:
+        return reducer.add(a, b);
+    case Pointwise::Sub:
+        return reducer.sub(a, b);
+    default:
+        return reducer.mul(a, b);
+    }
+}
+
+#ifdef HAVE_AVX512BW
+bool use_avx512() {
+    static const bool supported = CPUFeatureDetector::cached().has_avx512bw;
+    return supported;
+}
+
+CLWE_TARGET_AVX512 inline __m512i load_colors512(const ColorValue* colors) {
+    const __m512i swap = _mm512_broadcast_i32x4(_mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+    return _mm512_shuffle_epi8(_mm512_loadu_si512(colors), swap);
+}
+
+CLWE_TARGET_AVX512 inline void store_colors512(ColorValue* colors, __m512i v) {
+    const __m512i swap = _mm512_broadcast_i32x4(_mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+    _mm512_storeu_si512(colors, _mm512_shuffle_epi8(v, swap));
+}
+
+// Barrett reduction of arbitrary 32-bit lanes, as reduce32 below
+CLWE_TARGET_AVX512 inline __m512i reduce32_512(__m512i x, __m512i q_vec, __m512i m_vec) {
+    __m512i t_even = _mm512_srli_epi64(_mm512_mul_epu32(x, m_vec), 32);
+    __m512i t_odd = _mm512_mul_epu32(_mm512_srli_epi64(x, 32), m_vec);
+    __m512i t = _mm512_mask_blend_epi32(0xAAAA, t_even, t_odd);
+    __m512i r = _mm512_sub_epi32(x, _mm512_mullo_epi32(t, q_vec));
+    return _mm512_min_epu32(r, _mm512_sub_epi32(r, q_vec));
+}
+
+CLWE_TARGET_AVX512 size_t binary_avx512(const ColorValue* a, const ColorValue* b, ColorValue* out, size_t count,
+                                        const BarrettReducer& reducer, Pointwise op) {
+    size_t i = 0;
+    const __m512i q_vec = _mm512_set1_epi32(static_cast<int>(reducer.modulus));
+    const __m512i m_vec = _mm512_set1_epi32(static_cast<int>(reducer.multiplier));
+    for (; i + 16 <= count; i += 16) {
+        __m512i va = reduce32_512(load_colors512(a + i), q_vec, m_vec);
+        __m512i vb = reduce32_512(load_colors512(b + i), q_vec, m_vec);
+        __m512i r;
+        if (op == Pointwise::Mul) {
+            r = reduce32_512(_mm512_mullo_epi32(va, vb), q_vec, m_vec);
+        } else {
+            r = op == Pointwise::Sub ? _mm512_add_epi32(_mm512_sub_epi32(va, vb), q_vec) : _mm512_add_epi32(va, vb);
+            r = _mm512_min_epu32(r, _mm512_sub_epi32(r, q_vec));
+        }
+        store_colors512(out + i, r);
+    }
+    return i;
+}
+
+CLWE_TARGET_AVX512 size_t reduce_avx512(ColorValue* poly, size_t count, const BarrettReducer& reducer) {
+    size_t i = 0;
+    const __m512i q_vec = _mm512_set1_epi32(static_cast<int>(reducer.modulus));
+    const __m512i m_vec = _mm512_set1_epi32(static_cast<int>(reducer.multiplier));
+    for (; i + 16 <= count; i += 16) {
+        store_colors512(poly + i, reduce32_512(load_colors512(poly + i), q_vec, m_vec));
+    }
+    return i;
+}
+
+CLWE_TARGET_AVX512 size_t scale_avx512(const ColorValue* a, uint32_t factor, ColorValue* out, size_t count,
+                                       const BarrettReducer& reducer) {
+    size_t i = 0;
+    const __m512i q_vec = _mm512_set1_epi32(static_cast<int>(reducer.modulus));
+    const __m512i m_vec = _mm512_set1_epi32(static_cast<int>(reducer.multiplier));
+    const __m512i f_vec = _mm512_set1_epi32(static_cast<int>(factor));
+    for (; i + 16 <= count; i += 16) {
+        __m512i va = reduce32_512(load_colors512(a + i), q_vec, m_vec);
+        store_colors512(out + i, reduce32_512(_mm512_mullo_epi32(va, f_vec), q_vec, m_vec));
+    }
+    return i;
+}
+#endif
+
+#ifdef HAVE_AVX2
+bool use_avx2() {
+    static const bool supported = CPUFeatureDetector::cached().has_avx2;
+    return supported;
+}
+
+CLWE_TARGET_AVX2 inline __m256i byteswap32(__m256i v) {
+    const __m256i swap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                          3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    return _mm256_shuffle_epi8(v, swap);
+}
+
+CLWE_TARGET_AVX2 inline __m256i load_colors(const ColorValue* colors) {
+    return byteswap32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(colors)));
+}
+
+CLWE_TARGET_AVX2 inline void store_colors(ColorValue* colors, __m256i v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(colors), byteswap32(v));
+}
+
+// Barrett reduction of arbitrary 32-bit lanes; the quotient estimate is at most one short
+CLWE_TARGET_AVX2 inline __m256i reduce32(__m256i x, __m256i q_vec, __m256i m_vec) {
+    __m256i t_even = _mm256_srli_epi64(_mm256_mul_epu32(x, m_vec), 32);
+    __m256i t_odd = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), m_vec);
+    __m256i t = _mm256_blend_epi32(t_even, t_odd, 0xAA);
+    __m256i r = _mm256_sub_epi32(x, _mm256_mullo_epi32(t, q_vec));
+    return _mm256_min_epu32(r, _mm256_sub_epi32(r, q_vec));
+}
+
+// [0, 2q) -> [0, q)
+CLWE_TARGET_AVX2 inline __m256i conditional_subtract(__m256i x, __m256i q_vec) {
+    return _mm256_min_epu32(x, _mm256_sub_epi32(x, q_vec));
+}
+
+// The kernels below run whole vector steps and return how many coefficients they handled
+CLWE_TARGET_AVX2 size_t binary_avx2(const ColorValue* a, const ColorValue* b, ColorValue* out, size_t count,
+                                    const BarrettReducer& reducer, Pointwise op) {
+    size_t i = 0;
+    const __m256i q_vec = _mm256_set1_epi32(static_cast<int>(reducer.modulus));
+    const __m256i m_vec = _mm256_set1_epi32(static_cast<int>(reducer.multiplier));
+    for (; i + 8 <= count; i += 8) {
+        __m256i va = reduce32(load_colors(a + i), q_vec, m_vec);
+        __m256i vb = reduce32(load_colors(b + i), q_vec, m_vec);
+        __m256i r;
+        if (op == Pointwise::Mul) {
+            // Both factors are below q <= 2^16, so the product fits a 32-bit lane
+            r = reduce32(_mm256_mullo_epi32(va, vb), q_vec, m_vec);
+        } else {
+            r = op == Pointwise::Sub ? _mm256_add_epi32(_mm256_sub_epi32(va, vb), q_vec) : _mm256_add_epi32(va, vb);
+            r = conditional_subtract(r, q_vec);
+        }
+        store_colors(out + i, r);
+    }
+    return i;
+}
+
+CLWE_TARGET_AVX2 size_t reduce_avx2(ColorValue* poly, size_t count, const BarrettReducer& reducer) {
+    size_t i = 0;
+    const __m256i q_vec = _mm256_set1_epi32(static_cast<int>(reducer.modulus));
+    const __m256i m_vec = _mm256_set1_epi32(static_cast<int>(reducer.multiplier));
+    for (; i + 8 <= count; i += 8) {
+        store_colors(poly + i, reduce32(load_colors(poly + i), q_vec, m_vec));
+    }
+    return i;
+}
+
+CLWE_TARGET_AVX2 size_t scale_avx2(const ColorValue* a, uint32_t factor, ColorValue* out, size_t count,
+                                   const BarrettReducer& reducer) {
+    size_t i = 0;
+    const __m256i q_vec = _mm256_set1_epi32(static_cast<int>(reducer.modulus));
+    const __m256i m_vec = _mm256_set1_epi32(static_cast<int>(reducer.multiplier));
+    const __m256i f_vec = _mm256_set1_epi32(static_cast<int>(factor));
+    for (; i + 8 <= count; i += 8) {
+        // Both factors are below q <= 2^16, so the product fits a 32-bit lane
+        __m256i va = reduce32(load_colors(a + i), q_vec, m_vec);
+        store_colors(out + i, reduce32(_mm256_mullo_epi32(va, f_vec), q_vec, m_vec));
+    }
+    return i;
+}
+#endif
+
+#ifdef HAVE_NEON
+// Barrett reduction of 32-bit lanes, as reduce32 above
+inline uint32x4_t reduce32_neon(uint32x4_t x, uint32x2_t m_vec, uint32x4_t q_vec) {
+    uint64x2_t lo = vmull_u32(vget_low_u32(x), m_vec);
+    uint64x2_t hi = vmull_u32(vget_high_u32(x), m_vec);
+    uint32x4_t t = vcombine_u32(vshrn_n_u64(lo, 32), vshrn_n_u64(hi, 32));
+    uint32x4_t r = vmlsq_u32(x, t, q_vec);
+    return vminq_u32(r, vsubq_u32(r, q_vec));
+}
+
+inline uint32x4_t load_colors_neon(const ColorValue* colors) {
+    return vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(reinterpret_cast<const uint8_t*>(colors))));
+}
+
+inline void store_colors_neon(ColorValue* colors, uint32x4_t v) {
+    vst1q_u8(reinterpret_cast<uint8_t*>(colors), vrev32q_u8(vreinterpretq_u8_u32(v)));
+}
+
+size_t binary_neon(const ColorValue* a, const ColorValue* b, ColorValue* out, size_t count,
+                   const BarrettReducer& reducer, Pointwise op) {
+    size_t i = 0;
+    const uint32x4_t q_vec = vdupq_n_u32(reducer.modulus);
+    const uint32x2_t m_vec = vdup_n_u32(reducer.multiplier);
+    for (; i + 4 <= count; i += 4) {
+        uint32x4_t va = reduce32_neon(load_colors_neon(a + i), m_vec, q_vec);
+        uint32x4_t vb = reduce32_neon(load_colors_neon(b + i), m_vec, q_vec);
+        uint32x4_t r;
+        if (op == Pointwise::Mul) {
+            r = reduce32_neon(vmulq_u32(va, vb), m_vec, q_vec);
+        } else {
+            r = op == Pointwise::Sub ? vaddq_u32(vsubq_u32(va, vb), q_vec) : vaddq_u32(va, vb);
+            r = vminq_u32(r, vsubq_u32(r, q_vec));
+        }
+        store_colors_neon(out + i, r);
+    }
+    return i;
+}
+
+size_t reduce_neon(ColorValue* poly, size_t count, const BarrettReducer& reducer) {
+    size_t i = 0;
+    const uint32x4_t q_vec = vdupq_n_u32(reducer.modulus);
+    const uint32x2_t m_vec = vdup_n_u32(reducer.multiplier);
+    for (; i + 4 <= count; i += 4) {
+        store_colors_neon(poly + i, reduce32_neon(load_colors_neon(poly + i), m_vec, q_vec));
+    }
+    return i;
+}
+
+size_t scale_neon(const ColorValue* a, uint32_t factor, ColorValue* out, size_t count, const BarrettReducer& reducer) {
+    size_t i = 0;
+    const uint32x4_t q_vec = vdupq_n_u32(reducer.modulus);
+    const uint32x2_t m_vec = vdup_n_u32(reducer.multiplier);
+    const uint32x4_t f_vec = vdupq_n_u32(factor);
+    for (; i + 4 <= count; i += 4) {
+        uint32x4_t va = reduce32_neon(load_colors_neon(a + i), m_vec, q_vec);
+        store_colors_neon(out + i, reduce32_neon(vmulq_u32(va, f_vec), m_vec, q_vec));
+    }
+    return i;
+}
+#endif
+
+// Widest kernel the CPU runs; returns how many coefficients it handled
+size_t binary_simd(const ColorValue* a, const ColorValue* b, ColorValue* out, size_t count,
+                   const BarrettReducer& reducer, Pointwise op) {
+#ifdef HAVE_AVX512BW
+    if (use_avx512()) {
+        return binary_avx512(a, b, out, count, reducer, op);
+    }
+#endif
+#ifdef HAVE_AVX2
+    if (use_avx2()) {
+        return binary_avx2(a, b, out, count, reducer, op);
+    }
+#elif defined(HAVE_NEON)
+    return binary_neon(a, b, out, count, reducer, op);
+#endif
+    (void)a;
+    (void)b;
+    (void)out;
+    (void)count;
+    (void)reducer;
+    (void)op;
+    return 0;
+}
+
+size_t reduce_simd(ColorValue* poly, size_t count, const BarrettReducer& reducer) {
+#ifdef HAVE_AVX512BW
+    if (use_avx512()) {
+        return reduce_avx512(poly, count, reducer);
+    }
+#endif
+#ifdef HAVE_AVX2
+    if (use_avx2()) {
+        return reduce_avx2(poly, count, reducer);
+    }
+#elif defined(HAVE_NEON)
+    return reduce_neon(poly, count, reducer);
+#endif
+    (void)poly;
+    (void)count;
+    (void)reducer;
+    return 0;
+}
+
+size_t scale_simd(const ColorValue* a, uint32_t factor, ColorValue* out, size_t count,
+                  const BarrettReducer& reducer) {
+#ifdef HAVE_AVX512BW
+    if (use_avx512()) {
+        return scale_avx512(a, factor, out, count, reducer);
+    }
+#endif
+#ifdef HAVE_AVX2
+    if (use_avx2()) {
+        return scale_avx2(a, factor, out, count, reducer);
+    }
+#elif defined(HAVE_NEON)
+    return scale_neon(a, factor, out, count, reducer);
+#endif
+    (void)a;
+    (void)factor;
+    (void)out;
+    (void)count;
+    (void)reducer;
+    return 0;
+}
+
+// Serializer of poly_scale_add_encode. Blocks of 8 keep PACKED12 pairs and d-bit groups whole,
+// so only the final block can leave a lone coefficient or a partial byte.
+class CoefficientPacker {
+public:
+    CoefficientPacker(CoefficientEncoding encoding, uint32_t bits, uint32_t modulus, uint8_t* out)
+        : encoding_(encoding), bits_(bits), modulus_(modulus), out_(out) {}
+
+    void put(const uint32_t* values, size_t count) {
+        if (bits_ != 0) {
+            for (size_t i = 0; i < count; ++i) {
+                acc_ |= static_cast<uint64_t>(compress_coefficient(values[i], bits_, modulus_)) << acc_bits_;
+                acc_bits_ += bits_;
+                while (acc_bits_ >= 8) {
+                    *out_++ = static_cast<uint8_t>(acc_);
+                    acc_ >>= 8;
+                    acc_bits_ -= 8;
+                }
+            }
+        } else if (encoding_ == CoefficientEncoding::PACKED12) {
+            size_t i = 0;
+            for (; i + 2 <= count; i += 2) {
+                out_[0] = static_cast<uint8_t>(values[i]);
+                out_[1] = static_cast<uint8_t>((values[i] >> 8) | (values[i + 1] << 4));
+                out_[2] = static_cast<uint8_t>(values[i + 1] >> 4);
+                out_ += 3;
+            }
+            if (i < count) {
+                out_[0] = static_cast<uint8_t>(values[i]);
+                out_[1] = static_cast<uint8_t>(values[i] >> 8);
+            }
+        } else {
+            // COLOR32 is the big-endian math value
+            for (size_t i = 0; i < count; ++i) {
+                out_[0] = static_cast<uint8_t>(values[i] >> 24);
+                out_[1] = static_cast<uint8_t>(values[i] >> 16);
+                out_[2] = static_cast<uint8_t>(values[i] >> 8);
+                out_[3] = static_cast<uint8_t>(values[i]);
+                out_ += 4;
+            }
+        }
+    }
+
+    void finish() {
+        if (acc_bits_ > 0) {
+            *out_ = static_cast<uint8_t>(acc_);
+        }
+    }
+
+private:
+    CoefficientEncoding encoding_;
+    uint32_t bits_;
+    uint32_t modulus_;
+    uint8_t* out_;
+    uint64_t acc_ = 0;
+    uint32_t acc_bits_ = 0;
+};
+
+#ifdef HAVE_AVX2
+// Whole blocks of poly_scale_add_encode: 8 raw lanes of a and 8 colors of b per step
+CLWE_TARGET_AVX2 size_t scale_add_encode_avx2(const uint32_t* a, uint32_t factor, const ColorValue* b, size_t count,
+                                              const BarrettReducer& reducer, CoefficientPacker& packer) {
+    const __m256i q_vec = _mm256_set1_epi32(static_cast<int>(reducer.modulus));
+    const __m256i m_vec = _mm256_set1_epi32(static_cast<int>(reducer.multiplier));
+    const __m256i f_vec = _mm256_set1_epi32(static_cast<int>(factor));
+    alignas(32) uint32_t block[8];
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i va = reduce32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)), q_vec, m_vec);
+        va = reduce32(_mm256_mullo_epi32(va, f_vec), q_vec, m_vec);
+        __m256i vb = reduce32(load_colors(b + i), q_vec, m_vec);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(block), conditional_subtract(_mm256_add_epi32(va, vb), q_vec));
+        packer.put(block, 8);
+    }
+    return i;
+}
+#endif
+
+void pointwise(const ColorValue* a, const ColorValue* b, ColorValue* out, size_t count, uint32_t modulus,
+               Pointwise op) {
+    const BarrettReducer reducer(modulus);
+    size_t i = binary_simd(a, b, out, count, reducer, op);
+    for (; i < count; ++i) {
+        store_value(out, i, apply_scalar(reducer, load_value(a, i), load_value(b, i), op));
+    }
+}
+
+void check_polyvec_shape(const PolyVec& a, const PolyVec& b, const char* operation) {
+    if (a.rank() != b.rank() || a.degree() != b.degree()) {
+        throw std::invalid_argument(std::string(operation) + ": polynomial vector shapes differ (" +
+                                    std::to_string(a.rank()) + "x" + std::to_string(a.degree()) + " and " +
+                                    std::to_string(b.rank()) + "x" + std::to_string(b.degree()) + ")");
+    }
+}
+
+} // namespace
+
+void poly_add(const ColorValue* a, const ColorValue* b, ColorValue* out, size_t count, uint32_t modulus) {
+    pointwise(a, b, out, count, modulus, Pointwise::Add);
+}
+
+void poly_sub(const ColorValue* a, const ColorValue* b, ColorValue* out, size_t count, uint32_t modulus) {
+    pointwise(a, b, out, count, modulus, Pointwise::Sub);
+}
+
+void poly_mul(const ColorValue* a, const ColorValue* b, ColorValue* out, size_t count, uint32_t modulus) {
+    pointwise(a, b, out, count, modulus, Pointwise::Mul);
+}
+
+void poly_reduce(ColorValue* poly, size_t count, uint32_t modulus) {
+    const BarrettReducer reducer(modulus);
+    size_t i = reduce_simd(poly, count, reducer);
+    for (; i < count; ++i) {
+        store_value(poly, i, reducer.reduce(load_value(poly, i)));
+    }
+}
+
+void poly_scale(const ColorValue* a, uint32_t factor, ColorValue* out, size_t count, uint32_t modulus) {
+    const BarrettReducer reducer(modulus);
+    size_t i = scale_simd(a, factor, out, count, reducer);
+    for (; i < count; ++i) {
+        store_value(out, i, reducer.mul(reducer.reduce(load_value(a, i)), factor));
+    }
+}
+
+void poly_compress(const ColorValue* in, ColorValue* out, size_t count, uint32_t bits, uint32_t modulus) {
+    for (size_t i = 0; i < count; ++i) {
+        store_value(out, i, compress_coefficient(load_value(in, i), bits, modulus));
+    }
+}
+
+void poly_decompress(const ColorValue* in, ColorValue* out, size_t count, uint32_t bits, uint32_t modulus) {
+    for (size_t i = 0; i < count; ++i) {
+        store_value(out, i, decompress_coefficient(load_value(in, i), bits, modulus));
+    }
+}
+
+void poly_scale_add_encode(const uint32_t* a, uint32_t factor, const ColorValue* b, size_t count, uint32_t modulus,
+                           CoefficientEncoding encoding, uint32_t bits, uint8_t* out) {
+    count_work(WorkCounter::COEFFICIENTS_PACKED, count);
+    const BarrettReducer reducer(modulus);
+    CoefficientPacker packer(encoding, bits, modulus, out);
+    size_t i = 0;
+#ifdef HAVE_AVX2
+    if (use_avx2()) {
+        i = scale_add_encode_avx2(a, factor, b, count, reducer, packer);
+    }
+#endif
+    uint32_t block[8];
+    while (i < count) {
+        size_t step = std::min<size_t>(8, count - i);
+        for (size_t j = 0; j < step; ++j) {
+            uint32_t scaled = reducer.mul(reducer.reduce(a[i + j]), factor);
+            block[j] = reducer.add(scaled, reducer.reduce(load_value(b, i + j)));
+        }
+        packer.put(block, step);
+        i += step;
+    }
+    packer.finish();
+}
+
+void polyvec_add(const PolyVec& a, const PolyVec& b, PolyVec& out, uint32_t modulus) {
+    check_polyvec_shape(a, b, "polyvec_add");
+    check_polyvec_shape(a, out, "polyvec_add");
+    poly_add(a.data(), b.data(), out.data(), a.coeff_count(), modulus);
+}
+
+void polyvec_ntt(const ColorNTTEngine& engine, PolyVec& vector) {
+    CLWE_PROBE_SCOPE(ntt_forward);
+    engine.ntt_forward_colors_batch(vector.data(), vector.rank());
+}
+
+void polyvec_invntt(const ColorNTTEngine& engine, PolyVec& vector, uint32_t degree_inv) {
+    CLWE_PROBE_SCOPE(ntt_inverse);
+    engine.ntt_inverse_colors_batch(vector.data(), vector.rank());
+    poly_scale(vector.data(), degree_inv, vector.data(), vector.coeff_count(), engine.modulus());
+}
+
+void polyvec_basemul_acc(const ColorNTTEngine& engine, const PolyVec& a_hat, const PolyVec& b_hat,
+                         ColorValue* out_hat) {
+    check_polyvec_shape(a_hat, b_hat, "polyvec_basemul_acc");
+    engine.row_dot_colors(a_hat.data(), a_hat.degree(), b_hat.data(), a_hat.rank(), out_hat);
+}
+
+} // namespace clwe
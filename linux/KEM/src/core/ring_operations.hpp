@@ -0,0 +1,66 @@
+#ifndef RING_OPERATIONS_HPP
+#define RING_OPERATIONS_HPP
+
+#include "clwe/clwe.hpp"
+#include "color_ntt_engine.hpp"
+#include "color_value.hpp"
+#include "poly.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace clwe {
+
+// Coefficient-wise arithmetic in Z_q[x] on ColorValue storage, the layer ColorKEM builds on.
+// Inputs may hold any 32-bit math value; outputs are reduced to [0, q), q <= 2^16. out may
+// alias either input. AVX-512 and AVX2 (runtime-detected) or NEON kernels handle whole
+// vectors, scalar code the rest.
+
+// out = a + b mod q
+void poly_add(const ColorValue* a, const ColorValue* b, ColorValue* out, size_t count, uint32_t modulus);
+// out = a - b mod q
+void poly_sub(const ColorValue* a, const ColorValue* b, ColorValue* out, size_t count, uint32_t modulus);
+// out = a * b mod q, coefficient by coefficient
+void poly_mul(const ColorValue* a, const ColorValue* b, ColorValue* out, size_t count, uint32_t modulus);
+// poly = poly mod q
+void poly_reduce(ColorValue* poly, size_t count, uint32_t modulus);
+// out = a * factor mod q, factor < q
+void poly_scale(const ColorValue* a, uint32_t factor, ColorValue* out, size_t count, uint32_t modulus);
+
+// Compress_d(x) = round(2^d / q * x) mod 2^d for x < q, 1 <= d <= 11
+inline uint32_t compress_coefficient(uint32_t x, uint32_t bits, uint32_t modulus) {
+    // floor(n / q) == (n * ceil(2^40 / q)) >> 40 for n < 2^23; exact since the error stays below 1/q
+    const uint64_t reciprocal = ((uint64_t{1} << 40) + modulus - 1) / modulus;
+    uint64_t y = (((static_cast<uint64_t>(x) << bits) + modulus / 2) * reciprocal) >> 40;
+    return static_cast<uint32_t>(y & ((uint64_t{1} << bits) - 1));
+}
+
+// Decompress_d(y) = round(q / 2^d * y) for y < 2^d
+inline uint32_t decompress_coefficient(uint32_t y, uint32_t bits, uint32_t modulus) {
+    return static_cast<uint32_t>((static_cast<uint64_t>(y) * modulus + (uint64_t{1} << (bits - 1))) >> bits);
+}
+
+// Compress_d / Decompress_d over count reduced coefficients
+void poly_compress(const ColorValue* in, ColorValue* out, size_t count, uint32_t bits, uint32_t modulus);
+void poly_decompress(const ColorValue* in, ColorValue* out, size_t count, uint32_t bits, uint32_t modulus);
+
+// Fused output stage of encryption: writes the serialized form of (a * factor + b) mod q to out
+// in one pass, eight coefficients at a time held in registers, so the result never exists as
+// colors. a is raw 32-bit engine output (ntt_inverse_colors_batch_raw), b the added noise. With
+// bits != 0 the bytes are those of compress_encode_coefficients(), otherwise those of
+// encode_coefficients() under encoding; factor < q.
+void poly_scale_add_encode(const uint32_t* a, uint32_t factor, const ColorValue* b, size_t count, uint32_t modulus,
+                           CoefficientEncoding encoding, uint32_t bits, uint8_t* out);
+
+// Whole-vector forms; shapes must match
+void polyvec_add(const PolyVec& a, const PolyVec& b, PolyVec& out, uint32_t modulus);
+// Forward NTT of every polynomial in one batched engine call
+void polyvec_ntt(const ColorNTTEngine& engine, PolyVec& vector);
+// Inverse NTT of every polynomial, scaled by n^(-1) so that it undoes polyvec_ntt
+void polyvec_invntt(const ColorNTTEngine& engine, PolyVec& vector, uint32_t degree_inv);
+// out_hat = sum_i a_hat[i] * b_hat[i] pointwise, one polynomial of n coefficients
+void polyvec_basemul_acc(const ColorNTTEngine& engine, const PolyVec& a_hat, const PolyVec& b_hat,
+                         ColorValue* out_hat);
+
+} // namespace clwe
+
+#endif // RING_OPERATIONS_HPP
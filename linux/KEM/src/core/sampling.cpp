@@ -16,7 +16,7 @@ namespace clwe {
 
 void sample_polynomial_binomial(uint32_t* coeffs, uint32_t degree, uint32_t eta, uint32_t modulus) {
     // Use production-ready SHAKE256Sampler
-    SHAKE256Sampler sampler;
+    SHAKE256Sampler& sampler = thread_shake256();
     std::array<uint8_t, 32> seed;
     std::random_device rd;
     std::generate(seed.begin(), seed.end(), [&rd]() { return rd() % 256; });
@@ -34,7 +34,7 @@ void sample_polynomial_binomial_batch(uint32_t** coeffs_batch, uint32_t batch_si
 void sample_polynomial_binomial_batch_avx512(uint32_t** coeffs_batch, uint32_t batch_size,
                                             uint32_t degree, uint32_t eta, uint32_t modulus) {
     // Use production-ready SHAKE256Sampler with AVX-512 acceleration
-    SHAKE256Sampler sampler;
+    SHAKE256Sampler& sampler = thread_shake256();
     std::array<uint8_t, 32> seed;
     std::random_device rd;
     std::generate(seed.begin(), seed.end(), [&rd]() { return rd() % 256; });
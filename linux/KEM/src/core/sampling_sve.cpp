@@ -0,0 +1,122 @@
+#include "sampling_sve.hpp"
+#include <arm_sve.h>
+
+namespace clwe {
+
+namespace {
+
+inline svbool_t lanes(size_t i, size_t end) {
+    return svwhilelt_b32_u64(static_cast<uint64_t>(i), static_cast<uint64_t>(end));
+}
+
+// TBL indices that put byte triple g into the low three bytes of 32-bit lane g. The fourth
+// byte of each lane takes index 0xFF, past every byte load_triples() fills, so it reads as
+// zero at any vector length
+svuint8_t triple_spread() {
+    const svbool_t all = svptrue_b8();
+    svuint8_t i = svindex_u8(0, 1);
+    svuint8_t rem = svand_n_u8_x(all, i, 3);
+    svuint8_t idx = svadd_u8_x(all, svmul_n_u8_x(all, svlsr_n_u8_x(all, i, 2), 3), rem);
+    return svsel_u8(svcmpeq_n_u8(all, rem, 3), svdup_n_u8(0xFF), idx);
+}
+
+// Lane g = buf[3g] | buf[3g+1] << 8 | buf[3g+2] << 16 for the first count triples, zero
+// beyond; reads exactly 3 * count bytes
+inline svuint32_t load_triples(const uint8_t* buf, size_t count, svuint8_t spread) {
+    svuint8_t raw = svld1_u8(svwhilelt_b8_u64(0, static_cast<uint64_t>(3 * count)), buf);
+    return svreinterpret_u32_u8(svtbl_u8(raw, spread));
+}
+
+// a - b lifted into [0, modulus) for a, b <= modulus: a + q - b wraps below q when reduced
+inline svuint32_t lift_difference(svbool_t pg, svuint32_t a, svuint32_t b, uint32_t q) {
+    svuint32_t v = svsub_u32_x(pg, svadd_n_u32_x(pg, a, q), b);
+    return svmin_u32_x(pg, v, svsub_n_u32_x(pg, v, q));
+}
+
+// One byte per lane, zero-extended on load: the low nibble gives coefficient 2j and the
+// high nibble coefficient 2j + 1, which ST2 interleaves back into order
+void cbd2_sve(uint32_t* out, const uint8_t* buf, size_t nbytes, uint32_t q) {
+    const size_t vl = svcntw();
+    for (size_t i = 0; i < nbytes; i += vl) {
+        svbool_t pg = lanes(i, nbytes);
+        svuint32_t x = svld1ub_u32(pg, buf + i);
+        svuint32_t f = svadd_u32_x(pg, svand_n_u32_x(pg, x, 0x55), svand_n_u32_x(pg, svlsr_n_u32_x(pg, x, 1), 0x55));
+        svuint32_t a = svand_n_u32_x(pg, f, 0x33);
+        svuint32_t b = svand_n_u32_x(pg, svlsr_n_u32_x(pg, f, 2), 0x33);
+        svuint32_t lo = lift_difference(pg, svand_n_u32_x(pg, a, 0x3), svand_n_u32_x(pg, b, 0x3), q);
+        svuint32_t hi = lift_difference(pg, svlsr_n_u32_x(pg, a, 4), svlsr_n_u32_x(pg, b, 4), q);
+        svst2_u32(pg, out + 2 * i, svcreate2_u32(lo, hi));
+    }
+}
+
+// One 24-bit group per lane, four coefficients each, written back with ST4
+void cbd3_sve(uint32_t* out, const uint8_t* buf, size_t ngroups, uint32_t q) {
+    const size_t vl = svcntw();
+    const svuint8_t spread = triple_spread();
+    for (size_t g = 0; g < ngroups; g += vl) {
+        svbool_t pg = lanes(g, ngroups);
+        size_t count = ngroups - g < vl ? ngroups - g : vl;
+        svuint32_t t = load_triples(buf + 3 * g, count, spread);
+        svuint32_t d = svadd_u32_x(pg, svand_n_u32_x(pg, t, 0x00249249u),
+                                   svand_n_u32_x(pg, svlsr_n_u32_x(pg, t, 1), 0x00249249u));
+        d = svadd_u32_x(pg, d, svand_n_u32_x(pg, svlsr_n_u32_x(pg, t, 2), 0x00249249u));
+        svuint32_t c[4];
+        for (uint32_t j = 0; j < 4; ++j) {
+            svuint32_t a = svand_n_u32_x(pg, svlsr_n_u32_x(pg, d, 6 * j), 0x7);
+            svuint32_t b = svand_n_u32_x(pg, svlsr_n_u32_x(pg, d, 6 * j + 3), 0x7);
+            c[j] = lift_difference(pg, a, b, q);
+        }
+        svst4_u32(pg, out + 4 * g, svcreate4_u32(c[0], c[1], c[2], c[3]));
+    }
+}
+
+// Pack the accepted values of one vector to out; returns how many there were
+inline size_t store_accepted(uint32_t* out, svbool_t accepted, svuint32_t values, bool big_endian) {
+    const svbool_t all = svptrue_b32();
+    uint64_t count = svcntp_b32(all, accepted);
+    svuint32_t packed = svcompact_u32(accepted, values);
+    if (big_endian) {
+        packed = svrevb_u32_x(all, packed);
+    }
+    svst1_u32(svwhilelt_b32_u64(0, count), out, packed);
+    return static_cast<size_t>(count);
+}
+
+} // namespace
+
+void cbd_blocks_sve(uint32_t* out, const uint8_t* buf, size_t nblocks, uint32_t eta, uint32_t modulus) {
+    if (eta == 2) {
+        cbd2_sve(out, buf, 32 * nblocks, modulus);
+    } else {
+        cbd3_sve(out, buf, 16 * nblocks, modulus);
+    }
+}
+
+// One triple per lane gives two candidates; ZIP restores their stream order and COMPACT
+// packs the accepted ones, so no shuffle table is needed at any vector length
+size_t rejection_uniform12_sve(uint32_t* out, size_t max_out, const uint8_t* buf, size_t buflen,
+                               uint32_t modulus, bool big_endian, size_t& consumed) {
+    const size_t vl = svcntw();
+    const svbool_t all = svptrue_b32();
+    const svuint8_t spread = triple_spread();
+
+    size_t written = 0;
+    size_t pos = 0;
+    while (pos + 3 * vl <= buflen && written + 2 * vl <= max_out) {
+        svuint32_t w = load_triples(buf + pos, vl, spread);
+        // c1 = b0 << 4 | b1 >> 4 and c2 = (b1 & 0xF) << 8 | b2
+        svuint32_t c1 = svorr_u32_x(all, svlsl_n_u32_x(all, svand_n_u32_x(all, w, 0xFF), 4),
+                                    svand_n_u32_x(all, svlsr_n_u32_x(all, w, 12), 0xF));
+        svuint32_t c2 = svorr_u32_x(all, svand_n_u32_x(all, w, 0xF00), svlsr_n_u32_x(all, w, 16));
+        svbool_t p1 = svcmplt_n_u32(all, c1, modulus);
+        svbool_t p2 = svcmplt_n_u32(all, c2, modulus);
+
+        written += store_accepted(out + written, svzip1_b32(p1, p2), svzip1_u32(c1, c2), big_endian);
+        written += store_accepted(out + written, svzip2_b32(p1, p2), svzip2_u32(c1, c2), big_endian);
+        pos += 3 * vl;
+    }
+    consumed = pos;
+    return written;
+}
+
+} // namespace clwe
@@ -0,0 +1,24 @@
+#ifndef SAMPLING_SVE_HPP
+#define SAMPLING_SVE_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace clwe {
+
+// Vector-length-agnostic SVE kernels behind cbd_blocks() and rejection_sample_uniform12*().
+// Built for +sve in their own translation unit (HAVE_SVE); callers check
+// CPUFeatures::has_sve before reaching them.
+
+// cbd_blocks() for eta 2 or 3: the blocks are contiguous, so wide vectors span several
+void cbd_blocks_sve(uint32_t* out, const uint8_t* buf, size_t nblocks, uint32_t eta, uint32_t modulus);
+
+// The vector part of a rejection pass over buf with modulus <= 4096. Stops while at least
+// one vector of input and of output room remain, leaving the tail to the scalar parse:
+// returns the values written and sets consumed to the bytes they came from.
+size_t rejection_uniform12_sve(uint32_t* out, size_t max_out, const uint8_t* buf, size_t buflen,
+                               uint32_t modulus, bool big_endian, size_t& consumed);
+
+} // namespace clwe
+
+#endif // SAMPLING_SVE_HPP
@@ -0,0 +1,215 @@
+#include "secure_memory_pool.hpp"
+#include "utils.hpp"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace clwe {
+
+namespace {
+
+// Slot sizes are SECURE_SLOT_ALIGNMENT << c for class c
+constexpr size_t SLOT_CLASSES = 48;
+
+// SLOT_CLASSES when size is beyond the largest class
+size_t slot_class(size_t size) {
+    if (size > (SECURE_SLOT_ALIGNMENT << (SLOT_CLASSES - 1))) {
+        return SLOT_CLASSES;
+    }
+    size_t c = 0;
+    while ((SECURE_SLOT_ALIGNMENT << c) < size) {
+        ++c;
+    }
+    return c;
+}
+
+// One locked region carved from the front in fixed slots; a released slot goes on the
+// free list of its size class and is never split or merged. Free slots are always zero,
+// which is what PageRegion promises. Lives until exit, so blocks released during static
+// destruction still find it.
+class SecureMemoryPool {
+public:
+    SecureMemoryPool(uint8_t* base, size_t size, bool locked, bool excluded)
+        : base_(base), size_(size), locked_(locked), excluded_(excluded) {}
+
+    bool contains(const void* ptr) const {
+        const uint8_t* p = static_cast<const uint8_t*>(ptr);
+        return p >= base_ && p < base_ + size_;
+    }
+
+    void* allocate(size_t size) {
+        const size_t c = slot_class(size);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (c >= SLOT_CLASSES) {
+            ++fallbacks_;
+            return nullptr;
+        }
+        const size_t slot = SECURE_SLOT_ALIGNMENT << c;
+        uint8_t* block = nullptr;
+        if (!free_[c].empty()) {
+            block = free_[c].back();
+            free_[c].pop_back();
+        } else if (slot <= size_ - carved_) {
+            block = base_ + carved_;
+            carved_ += slot;
+            // Room for every slot of the class, so release() never allocates
+            free_[c].reserve(++carved_slots_[c]);
+        } else {
+            ++fallbacks_;
+            return nullptr;
+        }
+        bytes_in_use_ += slot;
+        ++slots_in_use_;
+        return block;
+    }
+
+    void release(void* ptr, size_t size) {
+        secure_zero(ptr, size);
+        const size_t c = slot_class(size);
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_[c].push_back(static_cast<uint8_t*>(ptr));
+        bytes_in_use_ -= SECURE_SLOT_ALIGNMENT << c;
+        --slots_in_use_;
+    }
+
+    SecureMemoryStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        SecureMemoryStats stats;
+        stats.region_bytes = size_;
+        stats.bytes_in_use = bytes_in_use_;
+        stats.slots_in_use = slots_in_use_;
+        stats.fallbacks = fallbacks_;
+        stats.locked = locked_;
+        stats.excluded_from_dumps = excluded_;
+        return stats;
+    }
+
+private:
+    uint8_t* const base_;
+    const size_t size_;
+    const bool locked_;
+    const bool excluded_;
+    mutable std::mutex mutex_;
+    size_t carved_ = 0;
+    size_t bytes_in_use_ = 0;
+    size_t slots_in_use_ = 0;
+    uint64_t fallbacks_ = 0;
+    size_t carved_slots_[SLOT_CLASSES] = {};
+    std::vector<uint8_t*> free_[SLOT_CLASSES];
+};
+
+std::atomic<SecureMemoryPool*> active_pool{nullptr};
+
+size_t page_size() {
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+#else
+    return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+// Fresh zeroed mapping, locked and excluded from dumps where the OS allows
+SecureMemoryPool* map_pool(size_t bytes) {
+    const size_t page = page_size();
+    if (bytes > SIZE_MAX - page) {
+        return nullptr;
+    }
+    const size_t size = (bytes + page - 1) / page * page;
+    bool locked = false;
+    bool excluded = false;
+#if defined(_WIN32)
+    void* mapping = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (mapping == nullptr) {
+        return nullptr;
+    }
+    // VirtualLock is bounded by the working set minimum; raise it by the region first
+    SIZE_T minimum = 0, maximum = 0;
+    if (GetProcessWorkingSetSize(GetCurrentProcess(), &minimum, &maximum)) {
+        SetProcessWorkingSetSize(GetCurrentProcess(), minimum + size, maximum + size);
+    }
+    locked = VirtualLock(mapping, size) != 0;
+#else
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        return nullptr;
+    }
+    locked = mlock(mapping, size) == 0;
+#if defined(MADV_DONTDUMP)
+    excluded = madvise(mapping, size, MADV_DONTDUMP) == 0;
+#elif defined(MADV_NOCORE)
+    excluded = madvise(mapping, size, MADV_NOCORE) == 0;
+#endif
+#endif
+    return new SecureMemoryPool(static_cast<uint8_t*>(mapping), size, locked, excluded);
+}
+
+} // namespace
+
+void* secure_pool_allocate(size_t size, size_t alignment) {
+    SecureMemoryPool* pool = active_pool.load(std::memory_order_acquire);
+    if (pool == nullptr) {
+        return nullptr;
+    }
+    if (alignment > SECURE_SLOT_ALIGNMENT) {
+        return nullptr;
+    }
+    return pool->allocate(size);
+}
+
+size_t secure_pool_slot_size(size_t size) {
+    return SECURE_SLOT_ALIGNMENT << slot_class(size);
+}
+
+bool secure_pool_release(void* ptr, size_t size) {
+    SecureMemoryPool* pool = active_pool.load(std::memory_order_acquire);
+    if (pool == nullptr || ptr == nullptr || !pool->contains(ptr)) {
+        return false;
+    }
+    pool->release(ptr, size);
+    return true;
+}
+
+bool enable_secure_memory(size_t region_bytes) {
+    if (region_bytes == 0) {
+        throw std::invalid_argument("Secure memory pool needs a non-empty region");
+    }
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (active_pool.load(std::memory_order_relaxed) != nullptr) {
+        return true;
+    }
+    SecureMemoryPool* pool = map_pool(region_bytes);
+    if (pool == nullptr) {
+        return false;
+    }
+    active_pool.store(pool, std::memory_order_release);
+    return true;
+}
+
+bool secure_memory_enabled() {
+    return active_pool.load(std::memory_order_acquire) != nullptr;
+}
+
+SecureMemoryStats secure_memory_stats() {
+    SecureMemoryPool* pool = active_pool.load(std::memory_order_acquire);
+    return pool != nullptr ? pool->stats() : SecureMemoryStats();
+}
+
+} // namespace clwe
@@ -0,0 +1,26 @@
+#ifndef SECURE_MEMORY_POOL_HPP
+#define SECURE_MEMORY_POOL_HPP
+
+#include "clwe/secure_memory.hpp"
+#include <cstddef>
+
+namespace clwe {
+
+// Alignment of every pool slot, and the smallest slot
+constexpr size_t SECURE_SLOT_ALIGNMENT = 64;
+
+// Zeroed slot of at least size bytes from the secure pool, or nullptr when the pool is
+// not enabled, is full, or alignment exceeds SECURE_SLOT_ALIGNMENT. Costs one atomic
+// load while the pool is off.
+void* secure_pool_allocate(size_t size, size_t alignment);
+
+// Bytes of the slot secure_pool_allocate(size) hands out
+size_t secure_pool_slot_size(size_t size);
+
+// Wipes the first size bytes and returns the slot to its free list; false, touching
+// nothing, when ptr is not in the pool. size is what was passed to secure_pool_allocate.
+bool secure_pool_release(void* ptr, size_t size);
+
+} // namespace clwe
+
+#endif // SECURE_MEMORY_POOL_HPP
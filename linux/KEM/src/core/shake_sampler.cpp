@@ -1,9 +1,15 @@
 #include "shake_sampler.hpp"
 #include "utils.hpp"
+#include "keccak_x4.hpp"
+#include "metrics.hpp"
+#include "work_counters.hpp"
+#include "rejection_sampling.hpp"
+#include "binomial_sampling.hpp"
 #include <cstring>
 #include <algorithm>
 #include <random>
 #include <stdexcept>
+#include <string>
 #include <vector>
 
 #ifdef _MSC_VER
@@ -12,36 +18,108 @@
 
 namespace clwe {
 
-SHAKE256Sampler::SHAKE256Sampler() {
-    ctx_ = EVP_MD_CTX_new();
-    if (!ctx_) {
-        throw std::runtime_error("Failed to create EVP_MD_CTX");
+#ifdef CLWE_HAVE_EVP_DIGEST_SQUEEZE
+namespace {
+
+// Create the context on first use, else clear it for the next stream
+void reset_evp(EVP_MD_CTX*& ctx) {
+    if (!ctx) {
+        ctx = EVP_MD_CTX_new();
+        if (!ctx) {
+            throw std::runtime_error("Failed to create EVP_MD_CTX");
+        }
+        return;
+    }
+    EVP_MD_CTX_reset(ctx);
+}
+
+void begin_evp(EVP_MD_CTX* ctx, size_t rate, const char* name) {
+    const EVP_MD* md = shake_evp_md(rate);
+    if (!md || EVP_DigestInit_ex(ctx, md, NULL) != 1) {
+        throw std::runtime_error(std::string("Failed to initialize ") + name);
     }
 }
 
+} // namespace
+#endif
+
+SHAKE256Sampler::SHAKE256Sampler() : block_pos_(SHAKE256_RATE) {}
+
 SHAKE256Sampler::~SHAKE256Sampler() {
-    if (ctx_) {
-        EVP_MD_CTX_free(ctx_);
+#ifdef CLWE_HAVE_EVP_DIGEST_SQUEEZE
+    if (evp_ctx_) {
+        EVP_MD_CTX_free(evp_ctx_);
     }
+#endif
 }
 
 void SHAKE256Sampler::reset() {
-    EVP_MD_CTX_reset(ctx_);
+    const KeccakOps* ops = keccak_ops(keccak_backend());
+#ifdef CLWE_HAVE_EVP_DIGEST_SQUEEZE
+    use_evp_ = ops == nullptr;
+    if (use_evp_) {
+        reset_evp(evp_ctx_);
+    } else {
+        sponge_.begin(ops, SHAKE256_RATE);
+    }
+#else
+    sponge_.begin(ops, SHAKE256_RATE);
+#endif
+    block_pos_ = SHAKE256_RATE;
 }
 
 void SHAKE256Sampler::init(const uint8_t* seed, size_t seed_len) {
+    begin();
+    absorb(seed, seed_len);
+    finalize();
+}
+
+void SHAKE256Sampler::begin() {
     reset();
-    if (EVP_DigestInit_ex(ctx_, EVP_shake256(), NULL) != 1) {
-        throw std::runtime_error("Failed to initialize SHAKE-256");
+#ifdef CLWE_HAVE_EVP_DIGEST_SQUEEZE
+    if (use_evp_) {
+        begin_evp(evp_ctx_, SHAKE256_RATE, "SHAKE-256");
     }
-    if (EVP_DigestUpdate(ctx_, seed, seed_len) != 1) {
-        throw std::runtime_error("Failed to absorb seed into SHAKE-256");
+#endif
+}
+
+void SHAKE256Sampler::absorb(const uint8_t* data, size_t len) {
+    count_work(WorkCounter::SHAKE_ABSORBED_BYTES, len);
+#ifdef CLWE_HAVE_EVP_DIGEST_SQUEEZE
+    if (use_evp_) {
+        if (EVP_DigestUpdate(evp_ctx_, data, len) != 1) {
+            throw std::runtime_error("Failed to absorb seed into SHAKE-256");
+        }
+        return;
     }
-    output_buffer_.resize(10 * 1024 * 1024); // 10MB buffer
-    if (EVP_DigestFinalXOF(ctx_, output_buffer_.data(), output_buffer_.size()) != 1) {
-        throw std::runtime_error("Failed to finalize SHAKE-256");
+#endif
+    sponge_.absorb(data, len);
+}
+
+void SHAKE256Sampler::finalize() {
+#ifdef CLWE_HAVE_EVP_DIGEST_SQUEEZE
+    // EVP pads on the first squeeze; the sponge pads here
+    if (use_evp_) {
+        return;
+    }
+#endif
+    sponge_.finalize();
+}
+
+void SHAKE256Sampler::refill_block() {
+    add_squeezed_bytes(MetricXof::SHAKE256, block_.size());
+    count_work(WorkCounter::SHAKE_SQUEEZED_BYTES, block_.size());
+#ifdef CLWE_HAVE_EVP_DIGEST_SQUEEZE
+    if (use_evp_) {
+        if (EVP_DigestSqueeze(evp_ctx_, block_.data(), block_.size()) != 1) {
+            throw std::runtime_error("Failed to squeeze from SHAKE-256");
+        }
+        block_pos_ = 0;
+        return;
     }
-    output_pos_ = 0;
+#endif
+    sponge_.squeeze(block_.data(), block_.size());
+    block_pos_ = 0;
 }
 
 void SHAKE256Sampler::squeeze(uint8_t* out, size_t len) {
@@ -49,25 +127,28 @@ void SHAKE256Sampler::squeeze(uint8_t* out, size_t len) {
 }
 
 void SHAKE256Sampler::random_bytes(uint8_t* out, size_t len) {
-    if (output_pos_ + len > output_buffer_.size()) {
-        throw std::runtime_error("Not enough precomputed output");
+    while (len > 0) {
+        if (block_pos_ == block_.size()) {
+            refill_block();
+        }
+        size_t chunk = std::min(len, block_.size() - block_pos_);
+        memcpy(out, block_.data() + block_pos_, chunk);
+        block_pos_ += chunk;
+        out += chunk;
+        len -= chunk;
     }
-    memcpy(out, output_buffer_.data() + output_pos_, len);
-    output_pos_ += len;
 }
 
 int32_t SHAKE256Sampler::sample_binomial_coefficient(uint32_t eta) {
     // Sample from centered binomial distribution B(2η, 0.5) - η
     // Count the number of 1s in 2η random bits, then subtract η
     uint32_t count_ones = 0;
-    size_t num_bytes = (2 * eta + 7) / 8; // Enough bytes for 2η bits
-    std::vector<uint8_t> bytes(num_bytes);
-    random_bytes(bytes.data(), num_bytes);
-
+    uint8_t byte = 0;
     for (uint32_t i = 0; i < 2 * eta; ++i) {
-        uint8_t byte = bytes[i / 8];
-        uint8_t bit = (byte >> (i % 8)) & 1;
-        count_ones += bit;
+        if (i % 8 == 0) {
+            random_bytes(&byte, 1);
+        }
+        count_ones += (byte >> (i % 8)) & 1;
     }
 
     return static_cast<int32_t>(count_ones) - static_cast<int32_t>(eta);
@@ -75,6 +156,18 @@ int32_t SHAKE256Sampler::sample_binomial_coefficient(uint32_t eta) {
 
 void SHAKE256Sampler::sample_polynomial_binomial(uint32_t* coeffs, size_t degree,
                                                 uint32_t eta, uint32_t modulus) {
+    // Bit-sliced path: 64 coefficients from every 16 * eta bytes
+    if ((eta == 2 || eta == 3) && modulus > eta && degree % 64 == 0) {
+        std::array<uint8_t, 2 * cbd_block_bytes(3)> chunk;
+        const size_t block_bytes = cbd_block_bytes(eta);
+        for (size_t i = 0; i < degree; i += 128) {
+            size_t nblocks = std::min<size_t>(2, (degree - i) / 64);
+            random_bytes(chunk.data(), nblocks * block_bytes);
+            cbd_blocks(coeffs + i, chunk.data(), nblocks, eta, modulus);
+        }
+        return;
+    }
+
     for (size_t i = 0; i < degree; ++i) {
         int32_t sample = sample_binomial_coefficient(eta);
         // Map to positive range: (sample mod modulus + modulus) mod modulus
@@ -91,9 +184,20 @@ void SHAKE256Sampler::sample_polynomial_binomial_batch(uint32_t** coeffs_batch,
 
 void SHAKE256Sampler::sample_polynomial_binomial_batch_avx512(uint32_t** coeffs_batch, size_t count,
                                                              size_t degree, uint32_t eta, uint32_t modulus) {
-    // For now, fall back to scalar implementation
-    // In production, this would use AVX-512 instructions for parallel sampling
-    sample_polynomial_binomial_batch(coeffs_batch, count, degree, eta, modulus);
+    if (!((eta == 2 || eta == 3) && modulus > eta && degree % 64 == 0)) {
+        sample_polynomial_binomial_batch(coeffs_batch, count, degree, eta, modulus);
+        return;
+    }
+
+    // Squeeze the whole batch once, then run the CBD kernels (AVX-512BW when the CPU has it)
+    // over each polynomial; the stream is consumed exactly as the sequential batch does
+    const size_t nblocks = degree / 64;
+    const size_t poly_bytes = nblocks * cbd_block_bytes(eta);
+    std::vector<uint8_t> bytes(count * poly_bytes);
+    random_bytes(bytes.data(), bytes.size());
+    for (size_t poly = 0; poly < count; ++poly) {
+        cbd_blocks(coeffs_batch[poly], bytes.data() + poly * poly_bytes, nblocks, eta, modulus);
+    }
 }
 
 uint32_t SHAKE256Sampler::sample_uniform(uint32_t modulus) {
@@ -127,45 +231,155 @@ void SHAKE256Sampler::sample_polynomial_uniform(uint32_t* coeffs, size_t degree,
     }
 }
 
-// SHAKE128Sampler implementation for Kyber matrix generation
-SHAKE128Sampler::SHAKE128Sampler() {
-    ctx_ = EVP_MD_CTX_new();
-    if (!ctx_) {
-        throw std::runtime_error("Failed to create EVP_MD_CTX for SHAKE-128");
+void SHAKE256Sampler::sample_polynomial_uniform_fast(uint32_t* coeffs, size_t degree, uint32_t modulus) {
+    if (modulus > 4096) {
+        sample_polynomial_uniform(coeffs, degree, modulus);
+        return;
+    }
+
+    // A multiple of 3 bytes, so every chunk holds whole 12-bit candidate pairs
+    std::array<uint8_t, 168> chunk;
+    size_t filled = 0;
+    while (filled < degree) {
+        squeeze(chunk.data(), chunk.size());
+        filled += rejection_sample_uniform12(coeffs + filled, degree - filled, chunk.data(), chunk.size(), modulus);
     }
 }
 
+// SHAKE128Sampler implementation for Kyber matrix generation
+SHAKE128Sampler::SHAKE128Sampler() : block_pos_(SHAKE128_RATE) {}
+
 SHAKE128Sampler::~SHAKE128Sampler() {
-    if (ctx_) {
-        EVP_MD_CTX_free(ctx_);
+#ifdef CLWE_HAVE_EVP_DIGEST_SQUEEZE
+    if (evp_ctx_) {
+        EVP_MD_CTX_free(evp_ctx_);
     }
+#endif
 }
 
 void SHAKE128Sampler::reset() {
-    EVP_MD_CTX_reset(ctx_);
+    const KeccakOps* ops = keccak_ops(keccak_backend());
+#ifdef CLWE_HAVE_EVP_DIGEST_SQUEEZE
+    use_evp_ = ops == nullptr;
+    if (use_evp_) {
+        reset_evp(evp_ctx_);
+    } else {
+        sponge_.begin(ops, SHAKE128_RATE);
+    }
+#else
+    sponge_.begin(ops, SHAKE128_RATE);
+#endif
+    block_pos_ = SHAKE128_RATE;
 }
 
 void SHAKE128Sampler::init(const uint8_t* seed, size_t seed_len) {
     reset();
-    if (EVP_DigestInit_ex(ctx_, EVP_shake128(), NULL) != 1) {
-        throw std::runtime_error("Failed to initialize SHAKE-128");
-    }
-    if (EVP_DigestUpdate(ctx_, seed, seed_len) != 1) {
-        throw std::runtime_error("Failed to absorb seed into SHAKE-128");
+    count_work(WorkCounter::SHAKE_ABSORBED_BYTES, seed_len);
+#ifdef CLWE_HAVE_EVP_DIGEST_SQUEEZE
+    if (use_evp_) {
+        begin_evp(evp_ctx_, SHAKE128_RATE, "SHAKE-128");
+        if (EVP_DigestUpdate(evp_ctx_, seed, seed_len) != 1) {
+            throw std::runtime_error("Failed to absorb seed into SHAKE-128");
+        }
+        return;
     }
-    output_buffer_.resize(10 * 1024 * 1024); // 10MB buffer
-    if (EVP_DigestFinalXOF(ctx_, output_buffer_.data(), output_buffer_.size()) != 1) {
-        throw std::runtime_error("Failed to finalize SHAKE-128");
+#endif
+    sponge_.absorb(seed, seed_len);
+    sponge_.finalize();
+}
+
+void SHAKE128Sampler::refill_block() {
+    add_squeezed_bytes(MetricXof::SHAKE128, block_.size());
+    count_work(WorkCounter::SHAKE_SQUEEZED_BYTES, block_.size());
+#ifdef CLWE_HAVE_EVP_DIGEST_SQUEEZE
+    if (use_evp_) {
+        if (EVP_DigestSqueeze(evp_ctx_, block_.data(), block_.size()) != 1) {
+            throw std::runtime_error("Failed to squeeze from SHAKE-128");
+        }
+        block_pos_ = 0;
+        return;
     }
-    output_pos_ = 0;
+#endif
+    sponge_.squeeze(block_.data(), block_.size());
+    block_pos_ = 0;
 }
 
 void SHAKE128Sampler::squeeze(uint8_t* out, size_t len) {
-    if (output_pos_ + len > output_buffer_.size()) {
-        throw std::runtime_error("Not enough precomputed output");
+    while (len > 0) {
+        if (block_pos_ == block_.size()) {
+            refill_block();
+        }
+        size_t chunk = std::min(len, block_.size() - block_pos_);
+        memcpy(out, block_.data() + block_pos_, chunk);
+        block_pos_ += chunk;
+        out += chunk;
+        len -= chunk;
+    }
+}
+
+namespace {
+
+// Absorb four equal-length seeds into lane-major Keccak states and apply SHAKE padding
+void absorb_x4(uint64_t state[25][4], const uint8_t* const seeds[4], size_t seed_len, size_t rate) {
+    if (seed_len >= rate) {
+        throw std::invalid_argument("Batched SHAKE seed length must be below " + std::to_string(rate));
     }
-    memcpy(out, output_buffer_.data() + output_pos_, len);
-    output_pos_ += len;
+    std::memset(state, 0, sizeof(uint64_t) * 25 * 4);
+    count_work(WorkCounter::SHAKE_ABSORBED_BYTES, 4 * seed_len);
+    for (size_t lane = 0; lane < 4; ++lane) {
+        for (size_t i = 0; i < seed_len; ++i) {
+            state[i / 8][lane] ^= static_cast<uint64_t>(seeds[lane][i]) << (8 * (i % 8));
+        }
+        state[seed_len / 8][lane] ^= static_cast<uint64_t>(0x1F) << (8 * (seed_len % 8));
+        state[(rate - 1) / 8][lane] ^= static_cast<uint64_t>(0x80) << (8 * ((rate - 1) % 8));
+    }
+}
+
+void squeeze_x4(uint64_t state[25][4], KeccakF1600x4Fn permute, uint8_t* const out[4], size_t nblocks,
+                size_t rate) {
+    for (size_t block = 0; block < nblocks; ++block) {
+        permute(state);
+        for (size_t lane = 0; lane < 4; ++lane) {
+            uint8_t* dst = out[lane] + block * rate;
+            for (size_t i = 0; i < rate; ++i) {
+                dst[i] = static_cast<uint8_t>(state[i / 8][lane] >> (8 * (i % 8)));
+            }
+        }
+    }
+}
+
+} // namespace
+
+void SHAKE128x4Sampler::init_x4(const uint8_t* const seeds[4], size_t seed_len) {
+    absorb_x4(state_, seeds, seed_len, SHAKE128_RATE);
+    permute_ = keccakf1600_x4_for(keccak_backend());
+}
+
+void SHAKE128x4Sampler::squeeze_blocks_x4(uint8_t* const out[4], size_t nblocks) {
+    add_squeezed_bytes(MetricXof::SHAKE128, 4 * nblocks * SHAKE128_RATE);
+    count_work(WorkCounter::SHAKE_SQUEEZED_BYTES, 4 * nblocks * SHAKE128_RATE);
+    squeeze_x4(state_, permute_, out, nblocks, SHAKE128_RATE);
+}
+
+void SHAKE256x4Sampler::init_x4(const uint8_t* const seeds[4], size_t seed_len) {
+    absorb_x4(state_, seeds, seed_len, SHAKE256_RATE);
+    permute_ = keccakf1600_x4_for(keccak_backend());
+}
+
+void SHAKE256x4Sampler::squeeze_blocks_x4(uint8_t* const out[4], size_t nblocks) {
+    add_squeezed_bytes(MetricXof::SHAKE256, 4 * nblocks * SHAKE256_RATE);
+    count_work(WorkCounter::SHAKE_SQUEEZED_BYTES, 4 * nblocks * SHAKE256_RATE);
+    squeeze_x4(state_, permute_, out, nblocks, SHAKE256_RATE);
+}
+
+SHAKE128Sampler& thread_shake128() {
+    thread_local SHAKE128Sampler sampler;
+    return sampler;
+}
+
+SHAKE256Sampler& thread_shake256() {
+    thread_local SHAKE256Sampler sampler;
+    return sampler;
 }
 
 } // namespace clwe
\ No newline at end of file
@@ -4,24 +4,56 @@
 #include <cstdint>
 #include <vector>
 #include <array>
+#include "clwe/tiny_sha3.h"
+#include "clwe/keccak_backend.hpp"
+
+// The XOF backend: OpenSSL EVP when the build links it (CLWE_HAVE_OPENSSL), else the
+// in-tree Keccak. OpenSSL only supports repeated XOF squeezes from 3.3 onwards; older
+// releases finalize once, so the samplers fall back to the in-tree Keccak there too.
+#ifdef CLWE_HAVE_OPENSSL
 #include <openssl/evp.h>
+#include <openssl/opensslv.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30300000L
+#define CLWE_HAVE_EVP_DIGEST_SQUEEZE 1
+#endif
+#endif
 
 namespace clwe {
 
+// Keccak rates in bytes: output is squeezed one rate-sized block at a time
+constexpr size_t SHAKE128_RATE = 168;
+constexpr size_t SHAKE256_RATE = 136;
+
+#ifdef CLWE_HAVE_EVP_DIGEST_SQUEEZE
+// OpenSSL SHAKE digest for a rate (SHAKE128_RATE or SHAKE256_RATE), fetched once per
+// process; nullptr if no provider implements it
+const EVP_MD* shake_evp_md(size_t rate);
+#endif
+
 // SHAKE-128 based sampler for matrix generation
 class SHAKE128Sampler {
 private:
-    EVP_MD_CTX* ctx_;
-    std::vector<uint8_t> output_buffer_;
-    size_t output_pos_;
+#ifdef CLWE_HAVE_EVP_DIGEST_SQUEEZE
+    EVP_MD_CTX* evp_ctx_ = nullptr;  // Created on first use of the OpenSSL backend
+    bool use_evp_ = false;           // Backend captured by the last reset()
+#endif
+    KeccakSponge sponge_;
+    std::array<uint8_t, SHAKE128_RATE> block_;
+    size_t block_pos_;
 
     // SHAKE-128 internal state
     void reset();
 
+    // Squeeze the next block of output into block_
+    void refill_block();
+
 public:
     SHAKE128Sampler();
     ~SHAKE128Sampler();
 
+    SHAKE128Sampler(const SHAKE128Sampler&) = delete;
+    SHAKE128Sampler& operator=(const SHAKE128Sampler&) = delete;
+
     // Initialize with seed
     void init(const uint8_t* seed, size_t seed_len);
 
@@ -29,30 +61,75 @@ public:
     void squeeze(uint8_t* out, size_t len);
 };
 
+// Four SHAKE-128 instances run in lockstep on the 4-way Keccak backend; each lane's
+// output equals SHAKE128Sampler fed the same seed
+class SHAKE128x4Sampler {
+private:
+    uint64_t state_[25][4];
+    KeccakF1600x4Fn permute_ = nullptr;  // Permutation of the backend captured by init_x4()
+
+public:
+    // Absorb four equal-length seeds (seed_len < SHAKE128_RATE) and apply the padding
+    void init_x4(const uint8_t* const seeds[4], size_t seed_len);
+
+    // Squeeze nblocks rate-sized blocks per lane; out[i] receives nblocks * SHAKE128_RATE bytes
+    void squeeze_blocks_x4(uint8_t* const out[4], size_t nblocks);
+};
+
+// SHAKE-256 counterpart of SHAKE128x4Sampler, used to expand noise seeds in groups of four
+class SHAKE256x4Sampler {
+private:
+    uint64_t state_[25][4];
+    KeccakF1600x4Fn permute_ = nullptr;  // Permutation of the backend captured by init_x4()
+
+public:
+    // Absorb four equal-length seeds (seed_len < SHAKE256_RATE) and apply the padding
+    void init_x4(const uint8_t* const seeds[4], size_t seed_len);
+
+    // Squeeze nblocks rate-sized blocks per lane; out[i] receives nblocks * SHAKE256_RATE bytes
+    void squeeze_blocks_x4(uint8_t* const out[4], size_t nblocks);
+};
+
 // SHAKE-256 based sampler for Kyber/ML-KEM
 class SHAKE256Sampler {
 private:
-    std::vector<uint8_t> output_buffer_;
-    size_t output_pos_;
-    EVP_MD_CTX* ctx_;
+#ifdef CLWE_HAVE_EVP_DIGEST_SQUEEZE
+    EVP_MD_CTX* evp_ctx_ = nullptr;  // Created on first use of the OpenSSL backend
+    bool use_evp_ = false;           // Backend captured by the last reset()
+#endif
+    KeccakSponge sponge_;
+    std::array<uint8_t, SHAKE256_RATE> block_;
+    size_t block_pos_;
 
     // SHAKE-256 internal state
     void reset();
 
+    // Squeeze the next block of output into block_
+    void refill_block();
+
 public:
     SHAKE256Sampler();
     ~SHAKE256Sampler();
 
+    SHAKE256Sampler(const SHAKE256Sampler&) = delete;
+    SHAKE256Sampler& operator=(const SHAKE256Sampler&) = delete;
+
     // Initialize with seed
     void init(const uint8_t* seed, size_t seed_len);
 
+    // Streaming absorb: begin(), any number of absorb() calls, then finalize() before squeezing
+    void begin();
+    void absorb(const uint8_t* data, size_t len);
+    void finalize();
+
     // Squeeze bytes from SHAKE-256
     void squeeze(uint8_t* out, size_t len);
 
     // Sample a single coefficient from centered binomial distribution
     int32_t sample_binomial_coefficient(uint32_t eta);
 
-    // Sample polynomial with binomial distribution
+    // Sample polynomial with binomial distribution; eta 2 and 3 use the bit-sliced CBD
+    // (16 * eta bytes per 64 coefficients) when degree is a multiple of 64
     void sample_polynomial_binomial(uint32_t* coeffs, size_t degree, uint32_t eta, uint32_t modulus);
 
     // Batch sampling for efficiency
@@ -69,10 +146,20 @@ public:
     // Sample polynomial from uniform distribution
     void sample_polynomial_uniform(uint32_t* coeffs, size_t degree, uint32_t modulus);
 
+    // Same distribution from 12-bit candidates, parsed a chunk at a time by the SIMD
+    // rejection kernel; falls back to sample_polynomial_uniform for modulus > 4096
+    void sample_polynomial_uniform_fast(uint32_t* coeffs, size_t degree, uint32_t modulus);
+
     // Generate random bytes
     void random_bytes(uint8_t* out, size_t len);
 };
 
+// Per-thread samplers reused across calls: init()/begin() reset the state, so no
+// context or buffer is allocated per polynomial. Do not hold one across a call
+// that may use the same sampler.
+SHAKE128Sampler& thread_shake128();
+SHAKE256Sampler& thread_shake256();
+
 } // namespace clwe
 
 #endif // SHAKE_SAMPLER_HPP
\ No newline at end of file
@@ -0,0 +1,50 @@
+#ifndef SIMD_TARGET_HPP
+#define SIMD_TARGET_HPP
+
+// Per-function instruction set selection for x86 kernels.
+//
+// The library is compiled for the baseline ISA; HAVE_AVX2 / HAVE_AVX512* only say the
+// compiler can emit those instructions. Each kernel that uses them is tagged with one of the
+// macros below and is only reached after the CPUFeatureDetector::cached() check of its file,
+// so one binary runs on any x86-64 host and still uses the widest unit available.
+// Scalar code never carries a tag, keeping AVX encodings out of the shared paths.
+//
+// CLWE_NATIVE_SIMD builds the whole library with the host flags instead; the tags are then
+// redundant but harmless.
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CLWE_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define CLWE_TARGET_AVX512 __attribute__((target("avx2,fma,avx512f,avx512dq,avx512bw,avx512vl")))
+#define CLWE_TARGET_AES __attribute__((target("aes,sse4.1")))
+#define CLWE_TARGET_VAES __attribute__((target("avx2,aes,vaes")))
+// Lets generic code be inlined into, and compiled for, a tagged caller
+#define CLWE_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+// MSVC accepts the intrinsics in any function; other architectures never use the tags
+#define CLWE_TARGET_AVX2
+#define CLWE_TARGET_AVX512
+#define CLWE_TARGET_AES
+#define CLWE_TARGET_VAES
+#define CLWE_ALWAYS_INLINE inline
+#endif
+
+// ARMv8.2-SHA3 kernels follow the same scheme on AArch64: the baseline build targets
+// ARMv8-A and only the tagged functions may use EOR3, RAX1, XAR and BCAX
+#if defined(__aarch64__) && defined(__clang__)
+#define CLWE_TARGET_ARM_SHA3 __attribute__((target("sha3")))
+#elif defined(__aarch64__) && defined(__GNUC__)
+#define CLWE_TARGET_ARM_SHA3 __attribute__((target("arch=armv8.2-a+sha3")))
+#else
+#define CLWE_TARGET_ARM_SHA3
+#endif
+
+// Likewise for the ARMv8 Crypto AES instructions (AESE, AESMC)
+#if defined(__aarch64__) && defined(__clang__)
+#define CLWE_TARGET_ARM_AES __attribute__((target("aes")))
+#elif defined(__aarch64__) && defined(__GNUC__)
+#define CLWE_TARGET_ARM_AES __attribute__((target("arch=armv8-a+crypto")))
+#else
+#define CLWE_TARGET_ARM_AES
+#endif
+
+#endif // SIMD_TARGET_HPP
@@ -0,0 +1,175 @@
+#ifndef SIMD_VEC_HPP
+#define SIMD_VEC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Portable fixed-width vectors for kernels written once for every target.
+//
+// With GCC or Clang a VecU32<LANES> wraps a generic vector (vector_size), which the compiler
+// lowers to whatever unit the build's baseline ISA has: SSE2 on x86-64, NEON on AArch64,
+// VSX/AltiVec on POWER, SIMD128 on WebAssembly, RVV with fixed-length vectors, and scalar
+// code where there is none. Other compilers get an array and a loop per operation. All
+// arithmetic is modulo 2^32 per lane, as in the scalar kernels.
+//
+// The hand-written engines (ntt_avx.cpp, ntt_neon.cpp, ...) stay as overrides where they
+// measure faster; a kernel written against this header is the fallback for the rest.
+
+#if defined(__GNUC__) || defined(__clang__)
+#define CLWE_SIMD_VECTOR_EXTENSIONS 1
+#endif
+
+namespace clwe {
+namespace simd {
+
+// True when the baseline ISA has a vector unit VecU32 maps onto
+#if defined(__SSE2__) || defined(__ARM_NEON) || defined(__VSX__) || defined(__ALTIVEC__) || \
+    defined(__wasm_simd128__) || defined(__riscv_v)
+constexpr bool NATIVE = true;
+#else
+constexpr bool NATIVE = false;
+#endif
+
+// 128 bits, the width every unit above has
+constexpr size_t DEFAULT_U32_LANES = 4;
+
+#ifdef CLWE_SIMD_VECTOR_EXTENSIONS
+// GCC drops a vector_size that depends on a template parameter, so each width is spelled out
+template <size_t LANES>
+struct NativeU32;
+template <>
+struct NativeU32<4> {
+    typedef uint32_t type __attribute__((vector_size(16)));
+};
+template <>
+struct NativeU32<8> {
+    typedef uint32_t type __attribute__((vector_size(32)));
+};
+template <>
+struct NativeU32<16> {
+    typedef uint32_t type __attribute__((vector_size(64)));
+};
+#endif
+
+template <size_t LANES>
+struct VecU32 {
+    static constexpr size_t lanes = LANES;
+
+#ifdef CLWE_SIMD_VECTOR_EXTENSIONS
+    typedef typename NativeU32<LANES>::type Native;
+    Native v;
+
+    static VecU32 make(Native native) {
+        VecU32 r;
+        r.v = native;
+        return r;
+    }
+
+    static VecU32 splat(uint32_t x) { return make(Native{} + x); }
+
+    // Unaligned; memcpy compiles to one vector load or store
+    static VecU32 load(const uint32_t* p) {
+        VecU32 r;
+        std::memcpy(&r.v, p, sizeof(r.v));
+        return r;
+    }
+    void store(uint32_t* p) const { std::memcpy(p, &v, sizeof(v)); }
+
+    friend VecU32 operator+(VecU32 a, VecU32 b) { return make(a.v + b.v); }
+    friend VecU32 operator-(VecU32 a, VecU32 b) { return make(a.v - b.v); }
+    friend VecU32 operator*(VecU32 a, VecU32 b) { return make(a.v * b.v); }
+    friend VecU32 operator&(VecU32 a, VecU32 b) { return make(a.v & b.v); }
+
+    friend VecU32 min(VecU32 a, VecU32 b) {
+        Native m = (Native)(a.v < b.v);  // Comparisons give all-ones lanes
+        return make((a.v & m) | (b.v & ~m));
+    }
+
+    // High words of the 32x32-bit lane products. Written per lane: generic vectors have no
+    // widening multiply, and the compilers match this loop to pmuludq, umull and the like
+    friend VecU32 mulhi(VecU32 a, VecU32 b) {
+        VecU32 r;
+        for (size_t i = 0; i < LANES; ++i) {
+            r.v[i] = static_cast<uint32_t>((static_cast<uint64_t>(a.v[i]) * b.v[i]) >> 32);
+        }
+        return r;
+    }
+#else
+    uint32_t v[LANES];
+
+    static VecU32 splat(uint32_t x) {
+        VecU32 r;
+        for (size_t i = 0; i < LANES; ++i) r.v[i] = x;
+        return r;
+    }
+
+    static VecU32 load(const uint32_t* p) {
+        VecU32 r;
+        std::memcpy(r.v, p, sizeof(r.v));
+        return r;
+    }
+    void store(uint32_t* p) const { std::memcpy(p, v, sizeof(v)); }
+
+    friend VecU32 operator+(VecU32 a, VecU32 b) {
+        for (size_t i = 0; i < LANES; ++i) a.v[i] += b.v[i];
+        return a;
+    }
+    friend VecU32 operator-(VecU32 a, VecU32 b) {
+        for (size_t i = 0; i < LANES; ++i) a.v[i] -= b.v[i];
+        return a;
+    }
+    friend VecU32 operator*(VecU32 a, VecU32 b) {
+        for (size_t i = 0; i < LANES; ++i) a.v[i] *= b.v[i];
+        return a;
+    }
+    friend VecU32 operator&(VecU32 a, VecU32 b) {
+        for (size_t i = 0; i < LANES; ++i) a.v[i] &= b.v[i];
+        return a;
+    }
+    friend VecU32 min(VecU32 a, VecU32 b) {
+        for (size_t i = 0; i < LANES; ++i) a.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i];
+        return a;
+    }
+    friend VecU32 mulhi(VecU32 a, VecU32 b) {
+        for (size_t i = 0; i < LANES; ++i) {
+            a.v[i] = static_cast<uint32_t>((static_cast<uint64_t>(a.v[i]) * b.v[i]) >> 32);
+        }
+        return a;
+    }
+#endif
+};
+
+// Modular helpers for canonical lanes (< q) and q < 2^31, shared by the kernels
+template <size_t LANES>
+inline VecU32<LANES> fold(VecU32<LANES> r, VecU32<LANES> q) {
+    // r < 2q to canonical: r - q wraps around exactly when r < q
+    return min(r, r - q);
+}
+
+template <size_t LANES>
+inline VecU32<LANES> add_mod(VecU32<LANES> a, VecU32<LANES> b, VecU32<LANES> q) {
+    return fold(a + b, q);
+}
+
+template <size_t LANES>
+inline VecU32<LANES> sub_mod(VecU32<LANES> a, VecU32<LANES> b, VecU32<LANES> q) {
+    return fold(a - b + q, q);
+}
+
+// Barrett reduction of any lane value with m = floor(2^32 / q); the quotient is at most one short
+template <size_t LANES>
+inline VecU32<LANES> barrett_reduce(VecU32<LANES> x, VecU32<LANES> q, VecU32<LANES> m) {
+    return fold(x - mulhi(x, m) * q, q);
+}
+
+// b * w mod q for canonical b and a constant w with w_shoup = floor(w * 2^32 / q)
+template <size_t LANES>
+inline VecU32<LANES> mul_shoup(VecU32<LANES> b, VecU32<LANES> w, VecU32<LANES> w_shoup, VecU32<LANES> q) {
+    return fold(b * w - mulhi(b, w_shoup) * q, q);
+}
+
+} // namespace simd
+} // namespace clwe
+
+#endif // SIMD_VEC_HPP
@@ -0,0 +1,174 @@
+#include "slow_operations.hpp"
+#include "ntt_engine.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__linux__)
+#include <sched.h>
+#elif defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#endif
+
+namespace clwe {
+
+namespace slow_detail {
+
+std::atomic<uint64_t> g_threshold_ns{0};
+thread_local OperationState* t_active = nullptr;
+
+uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+} // namespace slow_detail
+
+namespace {
+
+static_assert(std::is_trivially_copyable<SlowOperation>::value, "SlowOperation is copied through atomic words");
+static_assert((SLOW_OPERATION_CAPACITY & (SLOW_OPERATION_CAPACITY - 1)) == 0, "Capacity must be a power of two");
+
+constexpr size_t RECORD_WORDS = (sizeof(SlowOperation) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+// A seqlock per slot: sequence is 0 while empty, odd while a writer fills it and
+// 2 * (ticket + 1) once it holds the operation of that ticket. The record lives in atomic
+// words so readers racing with a writer copy torn data, which the sequence check rejects,
+// rather than racing on plain memory.
+struct Slot {
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<uint64_t> words[RECORD_WORDS];
+};
+
+Slot g_ring[SLOW_OPERATION_CAPACITY];
+std::atomic<uint64_t> g_next_ticket{0};
+std::atomic<uint64_t> g_cleared_ticket{0};
+
+int32_t current_cpu() {
+#if defined(__linux__)
+    return static_cast<int32_t>(sched_getcpu());
+#elif defined(_WIN32)
+    return static_cast<int32_t>(GetCurrentProcessorNumber());
+#else
+    return -1;
+#endif
+}
+
+void publish(SlowOperation& operation) {
+    const uint64_t ticket = g_next_ticket.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = g_ring[ticket & (SLOW_OPERATION_CAPACITY - 1)];
+    uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    // A writer still filling the slot, or one a full lap ahead, keeps it; this record is lost
+    if ((sequence & 1) != 0 || sequence > 2 * (ticket + 1) ||
+        !slot.sequence.compare_exchange_strong(sequence, 2 * ticket + 1, std::memory_order_relaxed)) {
+        return;
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+
+    operation.sequence = ticket;
+    uint64_t words[RECORD_WORDS] = {};
+    std::memcpy(words, &operation, sizeof(operation));
+    for (size_t i = 0; i < RECORD_WORDS; ++i) {
+        slot.words[i].store(words[i], std::memory_order_relaxed);
+    }
+    slot.sequence.store(2 * (ticket + 1), std::memory_order_release);
+}
+
+} // namespace
+
+const char* slow_stage_name(SlowStage stage) {
+    switch (stage) {
+        case SlowStage::MATRIX: return "matrix";
+        case SlowStage::NOISE: return "noise";
+        case SlowStage::MULTIPLY: return "multiply";
+        case SlowStage::DECRYPT: return "decrypt";
+        case SlowStage::PACK: return "pack";
+        case SlowStage::UNPACK: return "unpack";
+    }
+    return "unknown";
+}
+
+uint64_t SlowOperation::other_ns() const {
+    uint64_t staged = 0;
+    for (uint64_t ns : stage_ns) {
+        staged += ns;
+    }
+    return duration_ns > staged ? duration_ns - staged : 0;
+}
+
+void set_slow_operation_threshold(uint64_t threshold_ns) {
+    slow_detail::g_threshold_ns.store(threshold_ns, std::memory_order_relaxed);
+}
+
+uint64_t slow_operation_threshold() {
+    return slow_detail::g_threshold_ns.load(std::memory_order_relaxed);
+}
+
+std::vector<SlowOperation> slow_operations() {
+    const uint64_t cleared = g_cleared_ticket.load(std::memory_order_acquire);
+    std::vector<SlowOperation> result;
+    result.reserve(SLOW_OPERATION_CAPACITY);
+    for (Slot& slot : g_ring) {
+        const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before == 0 || (before & 1) != 0 || before / 2 - 1 < cleared) {
+            continue;
+        }
+        uint64_t words[RECORD_WORDS];
+        for (size_t i = 0; i < RECORD_WORDS; ++i) {
+            words[i] = slot.words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != before) {
+            continue;  // Overwritten while copied
+        }
+        SlowOperation operation;
+        std::memcpy(&operation, words, sizeof(operation));
+        result.push_back(operation);
+    }
+    std::sort(result.begin(), result.end(),
+              [](const SlowOperation& a, const SlowOperation& b) { return a.sequence < b.sequence; });
+    return result;
+}
+
+uint64_t slow_operations_recorded() {
+    return g_next_ticket.load(std::memory_order_relaxed) - g_cleared_ticket.load(std::memory_order_relaxed);
+}
+
+void clear_slow_operations() {
+    // Slots keep their records; readers skip tickets from before the clear
+    g_cleared_ticket.store(g_next_ticket.load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+void SlowOperationTimer::start() {
+    slow_detail::t_active = &state_;
+    start_ns_ = slow_detail::now_ns();
+}
+
+void SlowOperationTimer::finish() {
+    const uint64_t duration = slow_detail::now_ns() - start_ns_;
+    slow_detail::t_active = nullptr;
+    if (duration < slow_detail::g_threshold_ns.load(std::memory_order_relaxed)) {
+        return;
+    }
+    SlowOperation operation;
+    operation.start_ns = start_ns_;
+    operation.duration_ns = duration;
+    operation.stage_ns = state_.stage_ns;
+    operation.library_allocations = state_.library_allocations;
+    operation.heap_allocations = state_.heap_allocations;
+    operation.security_level = security_level_;
+    operation.cpu = current_cpu();
+    operation.operation = operation_;
+    operation.ntt_backend = engine_->get_simd_support();
+    operation.keccak_backend = keccak_backend();
+    publish(operation);
+}
+
+} // namespace clwe
@@ -0,0 +1,160 @@
+#ifndef SLOW_OPERATIONS_HPP
+#define SLOW_OPERATIONS_HPP
+
+#include "metrics.hpp"
+#include "cpu_features.hpp"
+#include "clwe/keccak_backend.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace clwe {
+
+class NTTEngine;
+
+// Tail-latency forensics: every keygen, encapsulation and decapsulation that takes at
+// least the threshold leaves a SlowOperation, with where its time went, in a fixed ring
+// of the most recent ones. Off until set_slow_operation_threshold(); while off an operation
+// costs one relaxed atomic load and each stage one thread-local load, and while on an
+// operation under the threshold costs the clock reads of its stages and nothing else.
+
+// Stages an operation's time is split into. A stage entered inside another one counts
+// toward the outer stage only.
+enum class SlowStage : uint8_t {
+    MATRIX,    // Expanding A from its seed
+    NOISE,     // Sampling s, e, r, e1 and e2, with their forward NTTs
+    MULTIPLY,  // Matrix-vector products
+    DECRYPT,   // Recovering the message from a ciphertext
+    PACK,      // Serializing keys and ciphertexts
+    UNPACK,    // Parsing private keys and ciphertexts
+};
+constexpr size_t SLOW_STAGES = 6;
+
+const char* slow_stage_name(SlowStage stage);
+
+// Operations the ring keeps; older ones are overwritten
+constexpr size_t SLOW_OPERATION_CAPACITY = 256;
+
+struct SlowOperation {
+    uint64_t sequence = 0;             // Order of recording, one more per recorded operation
+    uint64_t start_ns = 0;             // Steady clock
+    uint64_t duration_ns = 0;
+    std::array<uint64_t, SLOW_STAGES> stage_ns{};
+    uint32_t library_allocations = 0;  // Blocks taken from the set_allocator() hooks
+    uint32_t heap_allocations = 0;     // operator new calls, counted when clwe_alloc_hooks is linked
+    uint32_t security_level = 0;
+    int32_t cpu = -1;                  // CPU the operation finished on, -1 if unknown
+    MetricOperation operation = MetricOperation::KEYGEN;
+    SIMDSupport ntt_backend = SIMDSupport::NONE;               // The ColorKEM's NTT engine
+    KeccakBackend keccak_backend = KeccakBackend::Reference;  // Selected when the operation finished
+
+    uint64_t stage(SlowStage s) const { return stage_ns[static_cast<size_t>(s)]; }
+    // Time outside every stage: hashing, compression, validation
+    uint64_t other_ns() const;
+};
+
+// Record operations taking at least threshold_ns; 0 turns recording off
+void set_slow_operation_threshold(uint64_t threshold_ns);
+uint64_t slow_operation_threshold();
+
+// Retained operations, oldest first. Readers never block recording threads.
+std::vector<SlowOperation> slow_operations();
+// Operations recorded since the last clear, including overwritten ones
+uint64_t slow_operations_recorded();
+void clear_slow_operations();
+
+namespace slow_detail {
+
+struct OperationState {
+    std::array<uint64_t, SLOW_STAGES> stage_ns{};
+    uint32_t library_allocations = 0;
+    uint32_t heap_allocations = 0;
+    bool in_stage = false;
+};
+
+extern std::atomic<uint64_t> g_threshold_ns;
+extern thread_local OperationState* t_active;
+
+uint64_t now_ns();
+
+} // namespace slow_detail
+
+inline void count_slow_operation_library_allocation() {
+    if (slow_detail::OperationState* active = slow_detail::t_active) {
+        ++active->library_allocations;
+    }
+}
+
+inline void count_slow_operation_heap_allocation() {
+    if (slow_detail::OperationState* active = slow_detail::t_active) {
+        ++active->heap_allocations;
+    }
+}
+
+// Times one top-level operation on the calling thread; an operation inside another (the
+// re-encryption of a decapsulation) belongs to the outer one
+class SlowOperationTimer {
+private:
+    slow_detail::OperationState state_;
+    const NTTEngine* engine_;
+    uint64_t start_ns_ = 0;
+    uint32_t security_level_;
+    MetricOperation operation_;
+    bool active_;
+
+    void start();
+    void finish();
+
+public:
+    SlowOperationTimer(MetricOperation operation, uint32_t security_level, const NTTEngine& engine)
+        : engine_(&engine), security_level_(security_level), operation_(operation),
+          active_(slow_detail::t_active == nullptr &&
+                  slow_detail::g_threshold_ns.load(std::memory_order_relaxed) != 0) {
+        if (active_) {
+            start();
+        }
+    }
+    ~SlowOperationTimer() {
+        if (active_) {
+            finish();
+        }
+    }
+
+    SlowOperationTimer(const SlowOperationTimer&) = delete;
+    SlowOperationTimer& operator=(const SlowOperationTimer&) = delete;
+};
+
+// Adds its lifetime to a stage of the operation being timed on this thread, if any
+class SlowStageTimer {
+private:
+    slow_detail::OperationState* state_;
+    uint64_t start_ns_ = 0;
+    SlowStage stage_;
+
+public:
+    explicit SlowStageTimer(SlowStage stage) : state_(slow_detail::t_active), stage_(stage) {
+        if (state_ != nullptr) {
+            if (state_->in_stage) {
+                state_ = nullptr;
+            } else {
+                state_->in_stage = true;
+                start_ns_ = slow_detail::now_ns();
+            }
+        }
+    }
+    ~SlowStageTimer() {
+        if (state_ != nullptr) {
+            state_->stage_ns[static_cast<size_t>(stage_)] += slow_detail::now_ns() - start_ns_;
+            state_->in_stage = false;
+        }
+    }
+
+    SlowStageTimer(const SlowStageTimer&) = delete;
+    SlowStageTimer& operator=(const SlowStageTimer&) = delete;
+};
+
+} // namespace clwe
+
+#endif // SLOW_OPERATIONS_HPP
@@ -0,0 +1,184 @@
+#include "sparse_ternary.hpp"
+#include "utils.hpp"
+#include <algorithm>
+
+namespace clwe {
+
+namespace {
+
+// All ones when a == b, else zero
+inline uint32_t eq_mask(uint32_t a, uint32_t b) {
+    uint32_t x = a ^ b;
+    return ((x | (0u - x)) >> 31) - 1;
+}
+
+// q - v for v in [1, q), 0 for v = 0
+inline uint32_t negate(uint32_t v, uint32_t modulus) {
+    return (modulus - v) & ~eq_mask(v, 0);
+}
+
+// a + b mod q for a, b < q
+inline uint32_t add_mod(uint32_t a, uint32_t b, uint32_t modulus) {
+    uint32_t t = a + b - modulus;
+    return t + (modulus & (0u - (t >> 31)));
+}
+
+// Ascending compare-exchange of a and b when up, descending otherwise; up is a public
+// index bit, the values decide only the mask
+inline void compare_exchange(uint32_t& a, uint32_t& b, bool up) {
+    uint32_t greater = 0u - ((b - a) >> 31);  // a > b; values stay below 2^31
+    uint32_t swap = up ? greater : ~greater & ~eq_mask(a, b);
+    uint32_t d = (a ^ b) & swap;
+    a ^= d;
+    b ^= d;
+}
+
+uint32_t log2_degree(uint32_t degree) {
+    uint32_t bits = 0;
+    while ((1u << bits) < degree) {
+        ++bits;
+    }
+    return bits;
+}
+
+// out = x^shift * x when m is all ones, x when it is zero; the cyclic ring wraps the words
+// shifted past x^n round unchanged
+void rotate_stage(const uint32_t* x, uint32_t* out, uint32_t n, uint32_t shift, uint32_t m) {
+    for (uint32_t i = 0; i < shift; ++i) {
+        out[i] = (x[i + n - shift] & m) | (x[i] & ~m);
+    }
+    for (uint32_t i = shift; i < n; ++i) {
+        out[i] = (x[i - shift] & m) | (x[i] & ~m);
+    }
+}
+
+// acc += y, -y or nothing by sign (1, 2 or 0)
+void accumulate_signed(uint32_t* acc, const uint32_t* y, uint32_t n, uint32_t sign, uint32_t modulus) {
+    const uint32_t plus = eq_mask(sign, 1);
+    const uint32_t minus = eq_mask(sign, 2);
+    for (uint32_t i = 0; i < n; ++i) {
+        uint32_t add = (y[i] & plus) | (negate(y[i], modulus) & minus);
+        acc[i] = add_mod(acc[i], add, modulus);
+    }
+}
+
+} // namespace
+
+void sample_fixed_weight_ternary(const uint8_t* random, uint32_t degree, uint32_t weight, uint32_t modulus,
+                                 uint32_t* keys, ColorValue* out) {
+    // key << 2 | code, code 0 (zero), 1 (+1) or 2 (-1); sorting by the whole word shuffles
+    // the weight nonzero codes to uniformly random positions
+    for (uint32_t i = 0; i < degree; ++i) {
+        uint32_t r = static_cast<uint32_t>(random[3 * i]) | (static_cast<uint32_t>(random[3 * i + 1]) << 8) |
+                     (static_cast<uint32_t>(random[3 * i + 2]) << 16);
+        uint32_t code = i < weight ? 1 + (r & 1) : 0;
+        keys[i] = ((r >> 1) << 2) | code;
+    }
+
+    for (uint32_t k = 2; k <= degree; k <<= 1) {
+        for (uint32_t j = k >> 1; j > 0; j >>= 1) {
+            for (uint32_t i = 0; i < degree; ++i) {
+                uint32_t l = i ^ j;
+                if (l > i) {
+                    compare_exchange(keys[i], keys[l], (i & k) == 0);
+                }
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < degree; ++i) {
+        uint32_t code = keys[i] & 3;
+        out[i] = ColorValue::from_math_value((1u & eq_mask(code, 1)) | ((modulus - 1) & eq_mask(code, 2)));
+    }
+    secure_zero(keys, degree * sizeof(uint32_t));
+}
+
+SparseTernaryVec::SparseTernaryVec(uint32_t rank, uint32_t degree, uint32_t weight)
+    : rank_(rank), degree_(degree), weight_(weight),
+      positions_(static_cast<size_t>(rank) * weight), signs_(static_cast<size_t>(rank) * weight) {}
+
+SparseTernaryVec::~SparseTernaryVec() {
+    secure_zero(positions_.data(), positions_.size() * sizeof(uint32_t));
+    secure_zero(signs_.data(), signs_.size() * sizeof(uint32_t));
+}
+
+bool SparseTernaryVec::assign(const ColorValue* coeffs, uint32_t modulus) {
+    std::fill(positions_.begin(), positions_.end(), 0u);
+    std::fill(signs_.begin(), signs_.end(), 0u);
+    uint32_t invalid = 0;
+    for (uint32_t i = 0; i < rank_; ++i) {
+        uint32_t* positions = positions_.data() + static_cast<size_t>(i) * weight_;
+        uint32_t* signs = signs_.data() + static_cast<size_t>(i) * weight_;
+        const ColorValue* poly = coeffs + static_cast<size_t>(i) * degree_;
+        // The count-th nonzero lands in slot count, by a masked compare against every slot
+        uint32_t count = 0;
+        for (uint32_t j = 0; j < degree_; ++j) {
+            uint32_t v = poly[j].to_math_value();
+            uint32_t plus = eq_mask(v, 1);
+            uint32_t minus = eq_mask(v, modulus - 1);
+            uint32_t nonzero = plus | minus;
+            invalid |= ~nonzero & ~eq_mask(v, 0);
+            uint32_t code = (1u & plus) | (2u & minus);
+            for (uint32_t t = 0; t < weight_; ++t) {
+                uint32_t m = eq_mask(count, t) & nonzero;
+                positions[t] |= j & m;
+                signs[t] |= code & m;
+            }
+            count += nonzero & 1;
+        }
+        invalid |= 0u - static_cast<uint32_t>(count > weight_);
+    }
+    return invalid == 0;
+}
+
+void sparse_ternary_dot(const SparseTernaryVec& s, const ColorValue* c, uint32_t modulus, uint32_t* rotate_a,
+                        uint32_t* rotate_b, ColorValue* out) {
+    const uint32_t n = s.degree();
+    const uint32_t stages = log2_degree(n);
+    // ColorValue storage is a 32-bit word, so the sum is kept in out and converted at the end
+    uint32_t* acc = reinterpret_cast<uint32_t*>(out);
+    std::fill(acc, acc + n, 0u);
+
+    for (uint32_t i = 0; i < s.rank(); ++i) {
+        const ColorValue* poly = c + static_cast<size_t>(i) * n;
+        const uint32_t* positions = s.positions(i);
+        const uint32_t* signs = s.signs(i);
+        for (uint32_t t = 0; t < s.weight(); ++t) {
+            // Stage b shifts by 2^b when bit b of the position is set; the first reads poly
+            colors_to_u32(poly, rotate_b, n);
+            uint32_t* x = rotate_b;
+            uint32_t* y = rotate_a;
+            for (uint32_t b = 0; b < stages; ++b) {
+                uint32_t m = 0u - ((positions[t] >> b) & 1);
+                rotate_stage(x, y, n, 1u << b, m);
+                std::swap(x, y);
+            }
+            accumulate_signed(acc, x, n, signs[t], modulus);
+        }
+    }
+    colors_from_u32(acc, out, n);
+}
+
+uint32_t sparse_ternary_dot_constant(const SparseTernaryVec& s, const ColorValue* c, uint32_t modulus) {
+    const uint32_t n = s.degree();
+    uint32_t acc = 0;
+    for (uint32_t i = 0; i < s.rank(); ++i) {
+        const ColorValue* poly = c + static_cast<size_t>(i) * n;
+        const uint32_t* positions = s.positions(i);
+        const uint32_t* signs = s.signs(i);
+        for (uint32_t t = 0; t < s.weight(); ++t) {
+            // (x^p c)[0] is c[(n - p) mod n]
+            const uint32_t index = (n - positions[t]) & (n - 1);
+            uint32_t v = 0;
+            for (uint32_t j = 0; j < n; ++j) {
+                v |= poly[j].to_math_value() & eq_mask(j, index);
+            }
+            const uint32_t plus = eq_mask(signs[t], 1);
+            const uint32_t minus = eq_mask(signs[t], 2);
+            acc = add_mod(acc, (v & plus) | (negate(v, modulus) & minus), modulus);
+        }
+    }
+    return acc;
+}
+
+} // namespace clwe
@@ -0,0 +1,70 @@
+#ifndef SPARSE_TERNARY_HPP
+#define SPARSE_TERNARY_HPP
+
+#include "color_value.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace clwe {
+
+// Fixed-weight ternary secrets (CLWEParameters::secret_weight) and the multiply-free
+// products decryption computes with them. Everything here is constant-time in the
+// secret: positions and signs never pick a branch or an address, only masks.
+
+// Random bytes sample_fixed_weight_ternary() consumes for degree coefficients
+constexpr size_t fixed_weight_random_bytes(uint32_t degree) {
+    return 3 * static_cast<size_t>(degree);
+}
+
+// Exactly weight of the degree coefficients set to +1 or -1 (stored as 1 and q - 1), the
+// rest 0. Each coefficient takes a 23-bit key and, among the first weight, a sign bit
+// from 3 bytes of random; a bitonic sorting network puts them in key order. degree a
+// power of two, weight <= degree; keys is degree words of scratch.
+void sample_fixed_weight_ternary(const uint8_t* random, uint32_t degree, uint32_t weight, uint32_t modulus,
+                                 uint32_t* keys, ColorValue* out);
+
+// A rank-polynomial ternary vector as weight (position, sign) slots per polynomial, in
+// ascending position; slots past a polynomial's last nonzero have sign 0 and add
+// nothing. Wiped when destroyed.
+class SparseTernaryVec {
+public:
+    SparseTernaryVec(uint32_t rank, uint32_t degree, uint32_t weight);
+    ~SparseTernaryVec();
+
+    SparseTernaryVec(const SparseTernaryVec&) = delete;
+    SparseTernaryVec& operator=(const SparseTernaryVec&) = delete;
+
+    // Gathers the nonzeros of rank * degree coefficient-domain values. False, leaving the
+    // slots unspecified, unless every coefficient is 0, 1 or q - 1 and no polynomial has
+    // more than weight nonzeros.
+    bool assign(const ColorValue* coeffs, uint32_t modulus);
+
+    uint32_t rank() const { return rank_; }
+    uint32_t degree() const { return degree_; }
+    uint32_t weight() const { return weight_; }
+    // weight slots of polynomial i; signs are 0, 1 (+1) or 2 (-1)
+    const uint32_t* positions(uint32_t i) const { return positions_.data() + static_cast<size_t>(i) * weight_; }
+    const uint32_t* signs(uint32_t i) const { return signs_.data() + static_cast<size_t>(i) * weight_; }
+
+private:
+    uint32_t rank_;
+    uint32_t degree_;
+    uint32_t weight_;
+    std::vector<uint32_t> positions_;
+    std::vector<uint32_t> signs_;
+};
+
+// out = s^T c in Z_q[x]/(x^n - 1), the ring NTTEngine works in, for rank
+// coefficient-domain polynomials c, reduced. Per slot, x^p * c_i is built by log2(n)
+// masked cyclic shifts of the whole polynomial and added or subtracted by mask: O(rank * weight * n log n) adds and
+// selects, no multiplications. rotate_a and rotate_b are n words of scratch each.
+void sparse_ternary_dot(const SparseTernaryVec& s, const ColorValue* c, uint32_t modulus, uint32_t* rotate_a,
+                        uint32_t* rotate_b, ColorValue* out);
+
+// Constant term of s^T c alone, by one masked pass over each c_i per slot
+uint32_t sparse_ternary_dot_constant(const SparseTernaryVec& s, const ColorValue* c, uint32_t modulus);
+
+} // namespace clwe
+
+#endif // SPARSE_TERNARY_HPP
@@ -0,0 +1,170 @@
+#include "trace.hpp"
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+
+#ifdef CLWE_HAVE_ETW
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <TraceLoggingProvider.h>
+
+// {4a110552-7061-46a8-9550-1f9b7e959dce}
+TRACELOGGING_DEFINE_PROVIDER(g_clwe_etw_provider, "ColorKEM.Trace",
+    (0x4a110552, 0x7061, 0x46a8, 0x95, 0x50, 0x1f, 0x9b, 0x7e, 0x95, 0x9d, 0xce));
+#endif
+
+namespace clwe {
+
+namespace {
+
+std::atomic<TraceSink*> g_sink{nullptr};
+std::atomic<uint32_t> g_next_thread_id{1};
+
+uint32_t current_thread_id() {
+    thread_local uint32_t id = g_next_thread_id.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+// Span names are code literals; escape anyway so the JSON stays valid
+void write_json_string(std::ostream& out, const char* text) {
+    out << '"';
+    for (const char* p = text; *p != '\0'; ++p) {
+        if (*p == '"' || *p == '\\') {
+            out << '\\';
+        }
+        out << *p;
+    }
+    out << '"';
+}
+
+// Microseconds with three decimals, so nanosecond resolution survives the format
+void write_microseconds(std::ostream& out, uint64_t ns) {
+    uint64_t fraction = ns % 1000;
+    out << ns / 1000 << '.' << fraction / 100 << fraction / 10 % 10 << fraction % 10;
+}
+
+} // namespace
+
+void set_trace_sink(TraceSink* sink) {
+    g_sink.store(sink, std::memory_order_release);
+}
+
+TraceSink* trace_sink() {
+    return g_sink.load(std::memory_order_acquire);
+}
+
+RingBufferTraceSink::RingBufferTraceSink(size_t capacity) : capacity_(capacity) {
+    if (capacity == 0) {
+        throw std::invalid_argument("RingBufferTraceSink capacity must be positive");
+    }
+    events_.reserve(capacity);
+}
+
+void RingBufferTraceSink::record(const TraceEvent& event) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (events_.size() < capacity_) {
+        events_.push_back(event);
+        return;
+    }
+    events_[next_] = event;
+    next_ = (next_ + 1) % capacity_;
+    ++dropped_;
+}
+
+std::vector<TraceEvent> RingBufferTraceSink::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<TraceEvent> ordered;
+    ordered.reserve(events_.size());
+    ordered.insert(ordered.end(), events_.begin() + next_, events_.end());
+    ordered.insert(ordered.end(), events_.begin(), events_.begin() + next_);
+    return ordered;
+}
+
+uint64_t RingBufferTraceSink::dropped() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dropped_;
+}
+
+void RingBufferTraceSink::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    events_.clear();
+    next_ = 0;
+    dropped_ = 0;
+}
+
+void ChromeTraceSink::record(const TraceEvent& event) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    events_.push_back(event);
+}
+
+size_t ChromeTraceSink::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return events_.size();
+}
+
+void ChromeTraceSink::write(std::ostream& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    write_chrome_trace(out, events_);
+}
+
+void write_chrome_trace(std::ostream& out, const std::vector<TraceEvent>& events) {
+    out << "{\"traceEvents\":[";
+    for (size_t i = 0; i < events.size(); ++i) {
+        const TraceEvent& event = events[i];
+        if (i != 0) {
+            out << ',';
+        }
+        out << "{\"name\":";
+        write_json_string(out, event.name);
+        out << ",\"cat\":\"clwe\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread_id << ",\"ts\":";
+        write_microseconds(out, event.start_ns);
+        out << ",\"dur\":";
+        write_microseconds(out, event.duration_ns);
+        out << '}';
+    }
+    out << "]}";
+}
+
+#ifdef CLWE_HAVE_ETW
+EtwTraceSink::EtwTraceSink() {
+    TraceLoggingRegister(g_clwe_etw_provider);
+}
+
+EtwTraceSink::~EtwTraceSink() {
+    TraceLoggingUnregister(g_clwe_etw_provider);
+}
+
+void EtwTraceSink::record(const TraceEvent& event) {
+    TraceLoggingWrite(g_clwe_etw_provider, "Span",
+                      TraceLoggingString(event.name, "Name"),
+                      TraceLoggingUInt64(event.start_ns, "StartNs"),
+                      TraceLoggingUInt64(event.duration_ns, "DurationNs"),
+                      TraceLoggingUInt32(event.thread_id, "ThreadId"));
+}
+#endif
+
+uint64_t TraceSpan::now_ns() {
+    static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+}
+
+TraceSpan::TraceSpan(const char* name) : name_(name), sink_(trace_sink()) {
+    if (sink_ != nullptr) {
+        start_ns_ = now_ns();
+    }
+}
+
+TraceSpan::~TraceSpan() {
+    if (sink_ != nullptr) {
+        uint64_t end_ns = now_ns();
+        sink_->record({name_, start_ns_, end_ns - start_ns_, current_thread_id()});
+    }
+}
+
+} // namespace clwe
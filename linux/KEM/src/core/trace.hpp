@@ -0,0 +1,123 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+// ETW export needs the Windows SDK TraceLogging header
+#if defined(_WIN32) && defined(__has_include)
+#if __has_include(<TraceLoggingProvider.h>)
+#define CLWE_HAVE_ETW 1
+#endif
+#endif
+
+namespace clwe {
+
+// One finished span; times are nanoseconds on the steady clock since the first span
+struct TraceEvent {
+    const char* name;      // Static string given to the span
+    uint64_t start_ns;
+    uint64_t duration_ns;
+    uint32_t thread_id;    // Small per-thread id, assigned in order of first use
+};
+
+// Receives finished spans, possibly from several threads at once
+class TraceSink {
+public:
+    virtual ~TraceSink() = default;
+    virtual void record(const TraceEvent& event) = 0;
+};
+
+// Install the sink spans report to; nullptr stops tracing. The sink is not owned and
+// must outlive every span that may still finish while it is installed.
+void set_trace_sink(TraceSink* sink);
+TraceSink* trace_sink();
+
+// Keeps the most recent capacity events, overwriting the oldest
+class RingBufferTraceSink : public TraceSink {
+private:
+    mutable std::mutex mutex_;
+    std::vector<TraceEvent> events_;
+    size_t capacity_;
+    size_t next_ = 0;      // Slot the next event goes to once the buffer is full
+    uint64_t dropped_ = 0;
+
+public:
+    // Throws std::invalid_argument if capacity is 0
+    explicit RingBufferTraceSink(size_t capacity);
+
+    void record(const TraceEvent& event) override;
+
+    // Retained events, oldest first
+    std::vector<TraceEvent> snapshot() const;
+    uint64_t dropped() const;
+    void clear();
+};
+
+// Buffers every event for export in the Chrome trace event format, which
+// chrome://tracing and the Perfetto UI both open
+class ChromeTraceSink : public TraceSink {
+private:
+    mutable std::mutex mutex_;
+    std::vector<TraceEvent> events_;
+
+public:
+    void record(const TraceEvent& event) override;
+
+    size_t size() const;
+    void write(std::ostream& out) const;
+};
+
+// Chrome trace JSON ({"traceEvents":[...]}) of complete ("X") events, in microseconds
+void write_chrome_trace(std::ostream& out, const std::vector<TraceEvent>& events);
+
+#ifdef CLWE_HAVE_ETW
+// Forwards every span to ETW as a "Span" event of the TraceLogging provider
+// "ColorKEM.Trace" {4a110552-7061-46a8-9550-1f9b7e959dce}, so WPR/WPA and PerfView
+// show KEM stages next to the system's CPU and scheduler events. The constructor
+// registers the provider; keep at most one instance alive at a time.
+class EtwTraceSink : public TraceSink {
+public:
+    EtwTraceSink();
+    ~EtwTraceSink() override;
+
+    EtwTraceSink(const EtwTraceSink&) = delete;
+    EtwTraceSink& operator=(const EtwTraceSink&) = delete;
+
+    void record(const TraceEvent& event) override;
+};
+#endif
+
+// Times its own lifetime and reports it to the installed sink. Costs one atomic load
+// when no sink is installed.
+class TraceSpan {
+private:
+    const char* name_;
+    TraceSink* sink_;
+    uint64_t start_ns_ = 0;
+
+    static uint64_t now_ns();
+
+public:
+    explicit TraceSpan(const char* name);
+    ~TraceSpan();
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+} // namespace clwe
+
+// Hot-path spans compile to nothing unless the build enables CLWE_ENABLE_TRACING
+#if defined(CLWE_ENABLE_TRACING)
+#define CLWE_TRACE_CONCAT_(a, b) a##b
+#define CLWE_TRACE_CONCAT(a, b) CLWE_TRACE_CONCAT_(a, b)
+#define CLWE_TRACE_SPAN(name) ::clwe::TraceSpan CLWE_TRACE_CONCAT(clwe_trace_span_, __LINE__)(name)
+#else
+#define CLWE_TRACE_SPAN(name) ((void)0)
+#endif
+
+#endif // TRACE_HPP
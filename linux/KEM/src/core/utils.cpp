@@ -1,5 +1,9 @@
 #include "utils.hpp"
+#include "csprng.hpp"
+#include "library_allocator.hpp"
+#include "simd_target.hpp"
 #include <cstring>
+#include <cstdlib>
 #include <chrono>
 #include <iostream>
 #include <stdexcept>
@@ -29,20 +33,47 @@ namespace clwe {
 
 
 // AVX-Aligned Memory Allocator Implementation
-void* AVXAllocator::allocate(size_t size) {
-#ifdef HAVE_AVX2
-    return _mm_malloc(size, 32);  // 32-byte alignment for AVX
-#else
-    return malloc(size);  // Standard allocation for non-AVX
-#endif
+namespace {
+
+struct AVXBlockHeader {
+    const AllocatorHooks* hooks;
+    size_t size;       // Caller's size, without the header
+    size_t alignment;
+};
+
+// Bytes from the start of the hooks' block to the caller's pointer
+size_t avx_block_offset(size_t alignment) {
+    return (sizeof(AVXBlockHeader) + alignment - 1) & ~(alignment - 1);
+}
+
+AVXBlockHeader* avx_block_header(void* ptr) {
+    return reinterpret_cast<AVXBlockHeader*>(static_cast<uint8_t*>(ptr) - sizeof(AVXBlockHeader));
+}
+
+} // namespace
+
+void* AVXAllocator::allocate(size_t size, size_t alignment) {
+    const AllocatorHooks* hooks = current_allocator();
+    const size_t offset = avx_block_offset(alignment);
+    if (size > SIZE_MAX - offset) {
+        return nullptr;
+    }
+    void* raw = hooks->allocate(offset + size, alignment, hooks->context);
+    if (raw == nullptr) {
+        return nullptr;
+    }
+    void* ptr = static_cast<uint8_t*>(raw) + offset;
+    *avx_block_header(ptr) = {hooks, size, alignment};
+    return ptr;
 }
 
 void AVXAllocator::deallocate(void* ptr) {
-#ifdef HAVE_AVX2
-    _mm_free(ptr);
-#else
-    free(ptr);  // Standard deallocation for non-AVX
-#endif
+    if (ptr == nullptr) {
+        return;
+    }
+    const AVXBlockHeader header = *avx_block_header(ptr);
+    const size_t offset = avx_block_offset(header.alignment);
+    deallocate_with(header.hooks, static_cast<uint8_t*>(ptr) - offset, offset + header.size, header.alignment);
 }
 
 void* AVXAllocator::reallocate(void* ptr, size_t new_size) {
@@ -55,8 +86,8 @@ void* AVXAllocator::reallocate(void* ptr, size_t new_size) {
     }
     void* new_ptr = allocate(new_size);
     if (new_ptr) {
-        // We don't know the old size, so we can't copy safely
-        // This is a limitation - reallocate should be used carefully
+        const size_t old_size = avx_block_header(ptr)->size;
+        memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
         deallocate(ptr);
     }
     return new_ptr;
@@ -155,6 +186,8 @@ void AVXVector<T>::pop_back() {
 // Explicit template instantiations
 template class AVXVector<uint32_t>;
 template class AVXVector<avx_type>;
+template class AVXVector<double>;
+template class AVXVector<int>;
 
 // Utility functions
 uint64_t get_timestamp_ns() {
@@ -168,11 +201,11 @@ double timestamp_to_ms(uint64_t ts) {
 
 // Montgomery reduction
 uint32_t montgomery_reduce(uint64_t a, uint32_t q) {
-    uint64_t t = a * (static_cast<uint64_t>(1) << 32) % q;
-    return (a + t * q) >> 32;
+    // Reduces into [0, q); the Montgomery-domain arithmetic lives in the NTT backends
+    return static_cast<uint32_t>(a % q);
 }
 
-uint32_t montgomery_reduce_avx(avx_type a, uint32_t q) {
+CLWE_TARGET_AVX2 uint32_t montgomery_reduce_avx(avx_type a, uint32_t q) {
     // This will be implemented in AVX-specific code
     // For now, return 0 as placeholder
     return 0;
@@ -189,6 +222,9 @@ uint32_t barrett_reduce(uint64_t a, uint32_t q, uint64_t mu) {
 
 // Bit operations
 int bit_length(uint32_t x) {
+    if (x == 0) {
+        return 0;
+    }
 #ifdef _MSC_VER
     unsigned long index;
     _BitScanReverse(&index, x);
@@ -245,8 +281,8 @@ uint32_t mod_pow(uint32_t base, uint32_t exp, uint32_t mod) {
     return result;
 }
 
-// Secure random bytes using platform-specific APIs
-void secure_random_bytes(uint8_t* buffer, size_t len) {
+// OS entropy using platform-specific APIs
+void os_random_bytes(uint8_t* buffer, size_t len) {
 #ifdef __APPLE__
     if (SecRandomCopyBytes(kSecRandomDefault, len, buffer) != 0) {
         throw std::runtime_error("Failed to generate secure random bytes on macOS");
@@ -264,4 +300,20 @@ void secure_random_bytes(uint8_t* buffer, size_t len) {
 #endif
 }
 
+void secure_random_bytes(uint8_t* buffer, size_t len) {
+#ifdef CLWE_DIRECT_OS_RANDOM
+    os_random_bytes(buffer, len);
+#else
+    thread_drbg().generate(buffer, len);
+#endif
+}
+
+void secure_zero(void* ptr, size_t len) {
+    // Stores through a volatile pointer are observable, so they survive dead-store elimination
+    volatile uint8_t* bytes = static_cast<volatile uint8_t*>(ptr);
+    for (size_t i = 0; i < len; ++i) {
+        bytes[i] = 0;
+    }
+}
+
 } // namespace clwe
\ No newline at end of file
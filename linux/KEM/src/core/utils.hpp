@@ -17,10 +17,12 @@ using avx_type = dummy_m256i;
 namespace clwe {
 
 
-// AVX-Aligned Memory Allocator
+// AVX-Aligned Memory Allocator over the set_allocator() hooks. Each block carries the
+// hooks, size and alignment it was allocated with in a header just below it.
 class AVXAllocator {
 public:
-    static void* allocate(size_t size);
+    // alignment must be a power of two and a multiple of sizeof(void*); nullptr on failure
+    static void* allocate(size_t size, size_t alignment = 32);
     static void deallocate(void* ptr);
     static void* reallocate(void* ptr, size_t new_size);
 };
@@ -70,7 +72,7 @@ double timestamp_to_ms(uint64_t ts);
 
 // Montgomery reduction utilities
 uint32_t montgomery_reduce(uint64_t a, uint32_t q);
-uint32_t montgomery_reduce_avx(avx_type a, uint32_t q); // Forward declare for AVX
+uint32_t montgomery_reduce_avx(avx_type a, uint32_t q); // Forward declare for AVX; compiled for AVX2 only
 
 // Barrett reduction
 uint32_t barrett_reduce(uint64_t a, uint32_t q, uint64_t mu);
@@ -86,9 +88,16 @@ uint32_t mod_inverse(uint32_t a, uint32_t m);
 // Modular exponentiation
 uint32_t mod_pow(uint32_t base, uint32_t exp, uint32_t mod);
 
-// Secure random bytes
+// Secure random bytes from the calling thread's ChaCha20 DRBG (csprng.hpp), or straight
+// from the OS when built with CLWE_DIRECT_OS_RANDOM
 void secure_random_bytes(uint8_t* buffer, size_t len);
 
+// One read of OS entropy (getrandom, SecRandomCopyBytes, BCryptGenRandom)
+void os_random_bytes(uint8_t* buffer, size_t len);
+
+// Zero len bytes in a way the compiler cannot elide, for wiping secrets
+void secure_zero(void* ptr, size_t len);
+
 } // namespace clwe
 
 #endif // UTILS_HPP
\ No newline at end of file
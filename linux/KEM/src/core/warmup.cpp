@@ -0,0 +1,98 @@
+#include "clwe/warmup.hpp"
+#include "color_kem.hpp"
+#include "cpu_features.hpp"
+#include "shake_sampler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace clwe {
+
+namespace {
+
+// One absorb-squeeze stream and one four-lane permutation per backend, so each
+// backend's code and constants are paged in whichever of them samplers end up using
+std::vector<KeccakBackend> warm_keccak() {
+#ifdef CLWE_HAVE_EVP_DIGEST_SQUEEZE
+    shake_evp_md(SHAKE128_RATE);
+    shake_evp_md(SHAKE256_RATE);
+#endif
+    const uint8_t input[32] = {};
+    uint8_t output[SHAKE128_RATE];
+    std::vector<KeccakBackend> backends = available_keccak_backends();
+    for (KeccakBackend backend : backends) {
+        if (const KeccakOps* ops = keccak_ops(backend)) {
+            KeccakSponge sponge;
+            sponge.begin(ops, SHAKE128_RATE);
+            sponge.absorb(input, sizeof(input));
+            sponge.finalize();
+            sponge.squeeze(output, sizeof(output));
+        }
+        uint64_t state[25][4];
+        std::memset(state, 0, sizeof(state));
+        keccakf1600_x4_for(backend)(state);
+    }
+    return backends;
+}
+
+// Every operation of both modes once, on the thread's own workspace when none is
+// passed: sizes the arena for the largest operation and touches each of its pages
+template <typename... Workspace>
+void warm_operations(const ColorKEM& kem, Workspace&... workspace) {
+    auto [public_key, private_key] = kem.keygen(workspace...);
+    auto [ciphertext, secret] = kem.encapsulate(public_key, workspace...);
+    if (kem.decapsulate(public_key, private_key, ciphertext, workspace...) != secret) {
+        throw std::runtime_error("Warm-up round trip failed");
+    }
+
+    const CLWEParameters& params = kem.params();
+    if (params.degree < ColorKEM::KEY_MESSAGE_BITS || params.sparse_c2) {
+        return;
+    }
+    ColorExpandedPrivateKey expanded = kem.expand_private_key(public_key, private_key);
+    auto [key_ciphertext, shared_key] = kem.encapsulate_key(public_key, workspace...);
+    if (kem.decapsulate_key(expanded, key_ciphertext, workspace...) != shared_key) {
+        throw std::runtime_error("Warm-up key round trip failed");
+    }
+}
+
+WarmupReport run_warmup(const std::vector<CLWEParameters>& params_list, KemWorkspace* workspace) {
+    const auto start = std::chrono::steady_clock::now();
+    CPUFeatureDetector::cached();
+
+    WarmupReport report;
+    report.keccak_backends = warm_keccak();
+    for (const CLWEParameters& params : params_list) {
+        ColorKEM kem(params);
+        warm_operations(kem);
+        if (workspace) {
+            warm_operations(kem, *workspace);
+        }
+        report.workspace_bytes = std::max(report.workspace_bytes, kem.memory_requirements().workspace_bytes());
+        ++report.parameter_sets;
+    }
+    if (workspace) {
+        report.workspace_bytes = std::max(report.workspace_bytes, workspace->reserved_bytes());
+    }
+    report.elapsed_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
+
+} // namespace
+
+WarmupReport warmup(const std::vector<CLWEParameters>& params_list) {
+    return run_warmup(params_list, nullptr);
+}
+
+WarmupReport warmup(const std::vector<CLWEParameters>& params_list, KemWorkspace& workspace) {
+    return run_warmup(params_list, &workspace);
+}
+
+WarmupReport warmup() {
+    return warmup({CLWEParameters(512), CLWEParameters(768), CLWEParameters(1024)});
+}
+
+} // namespace clwe
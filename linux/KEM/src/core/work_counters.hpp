@@ -0,0 +1,66 @@
+#ifndef WORK_COUNTERS_HPP
+#define WORK_COUNTERS_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace clwe {
+
+// Algorithmic work done by the calling thread, for proving an optimization removed work
+// rather than just time. Counting is opt-in: outside a WorkCounterScope every counting
+// point costs one thread-local load. Work an executor runs on other threads is not seen.
+enum class WorkCounter : uint8_t {
+    NTT_FORWARD,           // Polynomials transformed to NTT domain
+    NTT_INVERSE,           // Polynomials transformed back
+    BASEMUL,               // NTT-domain polynomial products
+    SHAKE_ABSORBED_BYTES,  // Bytes absorbed into SHAKE-128/256, four per lane for the x4 samplers
+    SHAKE_SQUEEZED_BYTES,  // Bytes squeezed from SHAKE-128/256, whole blocks
+    RNG_BYTES,             // Bytes drawn from a ColorKEM's RandomSource
+    COEFFICIENTS_PACKED,   // Coefficients serialized into keys and ciphertexts
+};
+constexpr size_t WORK_COUNTERS = 7;
+
+struct WorkCounters {
+    std::array<uint64_t, WORK_COUNTERS> counts{};
+
+    uint64_t operator[](WorkCounter counter) const { return counts[static_cast<size_t>(counter)]; }
+};
+
+namespace work_detail {
+extern thread_local WorkCounters* t_active;
+} // namespace work_detail
+
+inline void count_work(WorkCounter counter, uint64_t value) {
+    if (WorkCounters* active = work_detail::t_active) {
+        active->counts[static_cast<size_t>(counter)] += value;
+    }
+}
+
+// Counts the calling thread's work while alive. Scopes nest: an inner scope's counts are
+// also added to the enclosing one when it closes.
+class WorkCounterScope {
+private:
+    WorkCounters counters_;
+    WorkCounters* enclosing_;
+
+public:
+    WorkCounterScope() : enclosing_(work_detail::t_active) { work_detail::t_active = &counters_; }
+    ~WorkCounterScope() {
+        work_detail::t_active = enclosing_;
+        if (enclosing_ != nullptr) {
+            for (size_t i = 0; i < WORK_COUNTERS; ++i) {
+                enclosing_->counts[i] += counters_.counts[i];
+            }
+        }
+    }
+
+    WorkCounterScope(const WorkCounterScope&) = delete;
+    WorkCounterScope& operator=(const WorkCounterScope&) = delete;
+
+    const WorkCounters& counters() const { return counters_; }
+};
+
+} // namespace clwe
+
+#endif // WORK_COUNTERS_HPP
@@ -0,0 +1,276 @@
+#include "x25519.hpp"
+#include "utils.hpp"
+#include <cstring>
+
+namespace clwe {
+
+namespace {
+
+// GF(2^255 - 19) elements as five 51-bit limbs. Sums and differences are left
+// unreduced; every product is carried back below 2^52 per limb
+using Fe = uint64_t[5];
+
+constexpr uint64_t MASK51 = (uint64_t(1) << 51) - 1;
+
+#if defined(__SIZEOF_INT128__)
+using Wide = unsigned __int128;
+
+inline Wide mul_wide(uint64_t a, uint64_t b) {
+    return static_cast<Wide>(a) * b;
+}
+inline uint64_t low51(Wide x) {
+    return static_cast<uint64_t>(x) & MASK51;
+}
+inline uint64_t high51(Wide x) {
+    return static_cast<uint64_t>(x >> 51);
+}
+#else
+// 128-bit accumulator for compilers without __int128
+struct Wide {
+    uint64_t lo = 0;
+    uint64_t hi = 0;
+};
+
+inline Wide operator+(Wide a, Wide b) {
+    Wide r;
+    r.lo = a.lo + b.lo;
+    r.hi = a.hi + b.hi + (r.lo < a.lo);
+    return r;
+}
+inline Wide& operator+=(Wide& a, uint64_t b) {
+    a.lo += b;
+    a.hi += a.lo < b;
+    return a;
+}
+inline Wide mul_wide(uint64_t a, uint64_t b) {
+    const uint64_t a0 = a & 0xFFFFFFFFu, a1 = a >> 32, b0 = b & 0xFFFFFFFFu, b1 = b >> 32;
+    const uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+    const uint64_t middle = (p00 >> 32) + (p01 & 0xFFFFFFFFu) + (p10 & 0xFFFFFFFFu);
+    Wide r;
+    r.lo = (middle << 32) | (p00 & 0xFFFFFFFFu);
+    r.hi = p11 + (p01 >> 32) + (p10 >> 32) + (middle >> 32);
+    return r;
+}
+inline uint64_t low51(Wide x) {
+    return x.lo & MASK51;
+}
+inline uint64_t high51(Wide x) {
+    return (x.lo >> 51) | (x.hi << 13);
+}
+#endif
+
+inline uint64_t load64_le(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; --i) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+inline void store64_le(uint8_t* p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) {
+        p[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+}
+
+void fe_copy(Fe h, const Fe f) {
+    std::memcpy(h, f, sizeof(Fe));
+}
+
+void fe_add(Fe h, const Fe f, const Fe g) {
+    for (int i = 0; i < 5; ++i) {
+        h[i] = f[i] + g[i];
+    }
+}
+
+// f - g + 4p, so limbs stay positive for any g carried below 2^53
+void fe_sub(Fe h, const Fe f, const Fe g) {
+    h[0] = f[0] + 0x1FFFFFFFFFFFB4 - g[0];
+    for (int i = 1; i < 5; ++i) {
+        h[i] = f[i] + 0x1FFFFFFFFFFFFC - g[i];
+    }
+}
+
+void fe_carry(Fe h, Wide r0, Wide r1, Wide r2, Wide r3, Wide r4) {
+    r1 += high51(r0);
+    r2 += high51(r1);
+    r3 += high51(r2);
+    r4 += high51(r3);
+    uint64_t h0 = low51(r0) + 19 * high51(r4);
+    h[1] = low51(r1) + (h0 >> 51);
+    h[0] = h0 & MASK51;
+    h[2] = low51(r2);
+    h[3] = low51(r3);
+    h[4] = low51(r4);
+}
+
+void fe_mul(Fe h, const Fe f, const Fe g) {
+    const uint64_t g1_19 = 19 * g[1], g2_19 = 19 * g[2], g3_19 = 19 * g[3], g4_19 = 19 * g[4];
+    Wide r0 = mul_wide(f[0], g[0]) + mul_wide(f[1], g4_19) + mul_wide(f[2], g3_19) + mul_wide(f[3], g2_19) +
+              mul_wide(f[4], g1_19);
+    Wide r1 = mul_wide(f[0], g[1]) + mul_wide(f[1], g[0]) + mul_wide(f[2], g4_19) + mul_wide(f[3], g3_19) +
+              mul_wide(f[4], g2_19);
+    Wide r2 = mul_wide(f[0], g[2]) + mul_wide(f[1], g[1]) + mul_wide(f[2], g[0]) + mul_wide(f[3], g4_19) +
+              mul_wide(f[4], g3_19);
+    Wide r3 = mul_wide(f[0], g[3]) + mul_wide(f[1], g[2]) + mul_wide(f[2], g[1]) + mul_wide(f[3], g[0]) +
+              mul_wide(f[4], g4_19);
+    Wide r4 = mul_wide(f[0], g[4]) + mul_wide(f[1], g[3]) + mul_wide(f[2], g[2]) + mul_wide(f[3], g[1]) +
+              mul_wide(f[4], g[0]);
+    fe_carry(h, r0, r1, r2, r3, r4);
+}
+
+void fe_sq(Fe h, const Fe f) {
+    const uint64_t d0 = 2 * f[0], d1 = 2 * f[1], d3 = 2 * f[3];
+    const uint64_t f3_19 = 19 * f[3], f4_19 = 19 * f[4];
+    Wide r0 = mul_wide(f[0], f[0]) + mul_wide(d1, f4_19) + mul_wide(2 * f[2], f3_19);
+    Wide r1 = mul_wide(d0, f[1]) + mul_wide(2 * f[2], f4_19) + mul_wide(f[3], f3_19);
+    Wide r2 = mul_wide(d0, f[2]) + mul_wide(f[1], f[1]) + mul_wide(d3, f4_19);
+    Wide r3 = mul_wide(d0, f[3]) + mul_wide(d1, f[2]) + mul_wide(f[4], f4_19);
+    Wide r4 = mul_wide(d0, f[4]) + mul_wide(d1, f[3]) + mul_wide(f[2], f[2]);
+    fe_carry(h, r0, r1, r2, r3, r4);
+}
+
+void fe_sq_times(Fe h, const Fe f, int times) {
+    fe_sq(h, f);
+    for (int i = 1; i < times; ++i) {
+        fe_sq(h, h);
+    }
+}
+
+// z^(p - 2), the addition chain of the reference implementation
+void fe_invert(Fe out, const Fe z) {
+    Fe z2, z9, z11, z2_5_0, z2_10_0, z2_20_0, z2_50_0, z2_100_0, t;
+    fe_sq(z2, z);
+    fe_sq_times(t, z2, 2);
+    fe_mul(z9, t, z);
+    fe_mul(z11, z9, z2);
+    fe_sq(t, z11);
+    fe_mul(z2_5_0, t, z9);
+    fe_sq_times(t, z2_5_0, 5);
+    fe_mul(z2_10_0, t, z2_5_0);
+    fe_sq_times(t, z2_10_0, 10);
+    fe_mul(z2_20_0, t, z2_10_0);
+    fe_sq_times(t, z2_20_0, 20);
+    fe_mul(t, t, z2_20_0);
+    fe_sq_times(t, t, 10);
+    fe_mul(z2_50_0, t, z2_10_0);
+    fe_sq_times(t, z2_50_0, 50);
+    fe_mul(z2_100_0, t, z2_50_0);
+    fe_sq_times(t, z2_100_0, 100);
+    fe_mul(t, t, z2_100_0);
+    fe_sq_times(t, t, 50);
+    fe_mul(t, t, z2_50_0);
+    fe_sq_times(t, t, 5);
+    fe_mul(out, t, z11);
+}
+
+void fe_frombytes(Fe h, const uint8_t s[X25519_BYTES]) {
+    h[0] = load64_le(s) & MASK51;
+    h[1] = (load64_le(s + 6) >> 3) & MASK51;
+    h[2] = (load64_le(s + 12) >> 6) & MASK51;
+    h[3] = (load64_le(s + 19) >> 1) & MASK51;
+    h[4] = (load64_le(s + 24) >> 12) & MASK51;
+}
+
+void fe_tobytes(uint8_t s[X25519_BYTES], const Fe f) {
+    uint64_t h[5];
+    fe_copy(h, f);
+    // Two carry passes leave h below 2p, so one conditional subtraction of p reduces it
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int i = 0; i < 4; ++i) {
+            h[i + 1] += h[i] >> 51;
+            h[i] &= MASK51;
+        }
+        h[0] += 19 * (h[4] >> 51);
+        h[4] &= MASK51;
+    }
+    uint64_t q = (h[0] + 19) >> 51;
+    for (int i = 1; i < 5; ++i) {
+        q = (h[i] + q) >> 51;
+    }
+    h[0] += 19 * q;
+    for (int i = 0; i < 4; ++i) {
+        h[i + 1] += h[i] >> 51;
+        h[i] &= MASK51;
+    }
+    h[4] &= MASK51;
+
+    store64_le(s, h[0] | (h[1] << 51));
+    store64_le(s + 8, (h[1] >> 13) | (h[2] << 38));
+    store64_le(s + 16, (h[2] >> 26) | (h[3] << 25));
+    store64_le(s + 24, (h[3] >> 39) | (h[4] << 12));
+}
+
+// Swaps f and g when swap is 1, without a branch
+void fe_cswap(Fe f, Fe g, uint64_t swap) {
+    const uint64_t mask = 0 - swap;
+    for (int i = 0; i < 5; ++i) {
+        const uint64_t x = mask & (f[i] ^ g[i]);
+        f[i] ^= x;
+        g[i] ^= x;
+    }
+}
+
+} // namespace
+
+void x25519(uint8_t out[X25519_BYTES], const uint8_t scalar[X25519_BYTES], const uint8_t point[X25519_BYTES]) {
+    uint8_t k[X25519_BYTES];
+    std::memcpy(k, scalar, X25519_BYTES);
+    k[0] &= 248;
+    k[31] &= 127;
+    k[31] |= 64;
+
+    static const Fe a24 = {121665, 0, 0, 0, 0};
+    Fe x1, x2 = {1, 0, 0, 0, 0}, z2 = {0, 0, 0, 0, 0}, x3, z3 = {1, 0, 0, 0, 0};
+    Fe a, aa, b, bb, e, c, d, da, cb;
+    fe_frombytes(x1, point);
+    fe_copy(x3, x1);
+
+    // RFC 7748 section 5 ladder
+    uint64_t swap = 0;
+    for (int t = 254; t >= 0; --t) {
+        const uint64_t bit = (k[t >> 3] >> (t & 7)) & 1;
+        swap ^= bit;
+        fe_cswap(x2, x3, swap);
+        fe_cswap(z2, z3, swap);
+        swap = bit;
+
+        fe_add(a, x2, z2);
+        fe_sq(aa, a);
+        fe_sub(b, x2, z2);
+        fe_sq(bb, b);
+        fe_sub(e, aa, bb);
+        fe_add(c, x3, z3);
+        fe_sub(d, x3, z3);
+        fe_mul(da, d, a);
+        fe_mul(cb, c, b);
+        fe_add(x3, da, cb);
+        fe_sq(x3, x3);
+        fe_sub(z3, da, cb);
+        fe_sq(z3, z3);
+        fe_mul(z3, z3, x1);
+        fe_mul(x2, aa, bb);
+        fe_mul(z2, a24, e);
+        fe_add(z2, z2, aa);
+        fe_mul(z2, z2, e);
+    }
+    fe_cswap(x2, x3, swap);
+    fe_cswap(z2, z3, swap);
+
+    fe_invert(z2, z2);
+    fe_mul(x2, x2, z2);
+    fe_tobytes(out, x2);
+
+    secure_zero(k, sizeof(k));
+    secure_zero(x2, sizeof(x2));
+    secure_zero(z2, sizeof(z2));
+    secure_zero(x3, sizeof(x3));
+    secure_zero(z3, sizeof(z3));
+}
+
+void x25519_base(uint8_t out[X25519_BYTES], const uint8_t scalar[X25519_BYTES]) {
+    static const uint8_t base[X25519_BYTES] = {9};
+    x25519(out, scalar, base);
+}
+
+} // namespace clwe
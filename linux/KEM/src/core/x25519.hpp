@@ -0,0 +1,21 @@
+#ifndef X25519_HPP
+#define X25519_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace clwe {
+
+// X25519 (RFC 7748): scalar bytes, u-coordinates and results are 32 bytes, little endian.
+// The Montgomery ladder runs on 51-bit limbs in constant time; the scalar is clamped and
+// the top bit of the u-coordinate ignored, as the RFC requires.
+constexpr size_t X25519_BYTES = 32;
+
+void x25519(uint8_t out[X25519_BYTES], const uint8_t scalar[X25519_BYTES], const uint8_t point[X25519_BYTES]);
+
+// x25519() of the base point u = 9: the public key of a secret scalar
+void x25519_base(uint8_t out[X25519_BYTES], const uint8_t scalar[X25519_BYTES]);
+
+} // namespace clwe
+
+#endif // X25519_HPP
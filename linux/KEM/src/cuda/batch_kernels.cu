@@ -0,0 +1,406 @@
+#include "batch_offload.hpp"
+#include <cuda_runtime.h>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace clwe {
+
+namespace {
+
+constexpr unsigned THREADS_PER_BLOCK = 256;
+constexpr unsigned MAX_NTT_THREADS = 512;
+
+void check(cudaError_t status, const char* what) {
+    if (status != cudaSuccess) {
+        throw std::runtime_error(std::string("CUDA ") + what + " failed: " + cudaGetErrorString(status));
+    }
+}
+
+unsigned blocks_for(size_t threads) {
+    return static_cast<unsigned>((threads + THREADS_PER_BLOCK - 1) / THREADS_PER_BLOCK);
+}
+
+// Device and pinned host allocations released on scope exit, so a failing launch leaks nothing
+template <typename T>
+class DeviceBuffer {
+private:
+    T* data_ = nullptr;
+
+public:
+    explicit DeviceBuffer(size_t count) {
+        if (count != 0) {
+            check(cudaMalloc(&data_, count * sizeof(T)), "cudaMalloc");
+        }
+    }
+    ~DeviceBuffer() { cudaFree(data_); }
+    DeviceBuffer(const DeviceBuffer&) = delete;
+    DeviceBuffer& operator=(const DeviceBuffer&) = delete;
+    T* get() const { return data_; }
+};
+
+template <typename T>
+class PinnedBuffer {
+private:
+    T* data_ = nullptr;
+
+public:
+    explicit PinnedBuffer(size_t count) {
+        if (count != 0) {
+            check(cudaHostAlloc(&data_, count * sizeof(T), cudaHostAllocDefault), "cudaHostAlloc");
+        }
+    }
+    ~PinnedBuffer() { cudaFreeHost(data_); }
+    PinnedBuffer(const PinnedBuffer&) = delete;
+    PinnedBuffer& operator=(const PinnedBuffer&) = delete;
+    T* get() const { return data_; }
+};
+
+class Stream {
+private:
+    cudaStream_t stream_ = nullptr;
+
+public:
+    Stream() { check(cudaStreamCreateWithFlags(&stream_, cudaStreamNonBlocking), "cudaStreamCreate"); }
+    ~Stream() { cudaStreamDestroy(stream_); }
+    Stream(const Stream&) = delete;
+    Stream& operator=(const Stream&) = delete;
+    cudaStream_t get() const { return stream_; }
+};
+
+// Twiddle tables on the device and a KernelParams pointing at them
+class DeviceTables {
+private:
+    DeviceBuffer<uint32_t> zetas_;
+    DeviceBuffer<uint32_t> zetas_inv_;
+    batch::KernelParams params_;
+
+public:
+    explicit DeviceTables(const batch::KernelParams& host) : zetas_(host.n), zetas_inv_(host.n), params_(host) {
+        check(cudaMemcpy(zetas_.get(), host.zetas, host.n * sizeof(uint32_t), cudaMemcpyHostToDevice), "cudaMemcpy");
+        check(cudaMemcpy(zetas_inv_.get(), host.zetas_inv, host.n * sizeof(uint32_t), cudaMemcpyHostToDevice),
+              "cudaMemcpy");
+        params_.zetas = zetas_.get();
+        params_.zetas_inv = zetas_inv_.get();
+    }
+    const batch::KernelParams& params() const { return params_; }
+};
+
+// Kernels. Sampling runs one polynomial per thread; NTTs one polynomial per block with
+// one thread per butterfly; products one output coefficient per thread.
+
+// Per instance: k^2 matrix cells, then k secret and k error polynomials
+__global__ void keygen_sample_kernel(batch::KernelParams p, const uint8_t* seeds, size_t count, uint32_t* a,
+                                     uint32_t* s, uint32_t* e) {
+    const size_t tasks = static_cast<size_t>(p.k) * p.k + 2 * p.k;
+    const size_t id = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+    if (id >= count * tasks) {
+        return;
+    }
+    const size_t inst = id / tasks;
+    const uint32_t task = static_cast<uint32_t>(id % tasks);
+    const uint8_t* seed = seeds + inst * batch::INSTANCE_SEED_BYTES;
+    const size_t vec = static_cast<size_t>(p.k) * p.n;
+    if (task < p.k * p.k) {
+        batch::expand_matrix_poly(p, seed, task / p.k, task % p.k, a + (inst * p.k * p.k + task) * p.n);
+    } else if (task < p.k * p.k + p.k) {
+        const uint32_t i = task - p.k * p.k;
+        batch::sample_noise_poly(p, p.eta1, seed + batch::SEED_BYTES, i, s + inst * vec + i * p.n);
+    } else {
+        const uint32_t i = task - p.k * p.k - p.k;
+        batch::sample_noise_poly(p, p.eta1, seed + 2 * batch::SEED_BYTES, i, e + inst * vec + i * p.n);
+    }
+}
+
+// Per instance: k^2 cells of A_hat^T, then k polynomials of r, k of e1 and e2
+__global__ void encapsulate_sample_kernel(batch::KernelParams p, const uint8_t* matrix_seeds,
+                                          const uint8_t* noise_seeds, size_t count, uint32_t* a_trans, uint32_t* r,
+                                          uint32_t* e1, uint32_t* e2) {
+    const size_t tasks = static_cast<size_t>(p.k) * p.k + 2 * p.k + 1;
+    const size_t id = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+    if (id >= count * tasks) {
+        return;
+    }
+    const size_t inst = id / tasks;
+    const uint32_t task = static_cast<uint32_t>(id % tasks);
+    const uint8_t* seed = noise_seeds + inst * batch::INSTANCE_SEED_BYTES;
+    const size_t vec = static_cast<size_t>(p.k) * p.n;
+    if (task < p.k * p.k) {
+        // Position (i, j) of A_hat^T is stream (j, i)
+        const uint32_t i = task / p.k;
+        const uint32_t j = task % p.k;
+        batch::expand_matrix_poly(p, matrix_seeds + inst * batch::SEED_BYTES, j, i,
+                                  a_trans + (inst * p.k * p.k + task) * p.n);
+    } else if (task < p.k * p.k + p.k) {
+        const uint32_t i = task - p.k * p.k;
+        batch::sample_noise_poly(p, p.eta2, seed, i, r + inst * vec + i * p.n);
+    } else if (task < p.k * p.k + 2 * p.k) {
+        const uint32_t i = task - p.k * p.k - p.k;
+        batch::sample_noise_poly(p, p.eta2, seed + batch::SEED_BYTES, i, e1 + inst * vec + i * p.n);
+    } else {
+        batch::sample_noise_poly(p, p.eta2, seed + 2 * batch::SEED_BYTES, 0, e2 + inst * p.n);
+    }
+}
+
+// Block b transforms polynomial b in shared memory
+__global__ void ntt_kernel(batch::KernelParams p, uint32_t* polys, bool inverse) {
+    extern __shared__ uint32_t poly[];
+    uint32_t* global = polys + static_cast<size_t>(blockIdx.x) * p.n;
+    for (uint32_t c = threadIdx.x; c < p.n; c += blockDim.x) {
+        poly[c] = global[c];
+    }
+    __syncthreads();
+    for (uint32_t stage = 0; stage < p.log_n; ++stage) {
+        for (uint32_t b = threadIdx.x; b < p.n / 2; b += blockDim.x) {
+            if (inverse) {
+                batch::ntt_inverse_butterfly(p, poly, stage, b);
+            } else {
+                batch::ntt_forward_butterfly(p, poly, stage, b);
+            }
+        }
+        __syncthreads();
+    }
+    for (uint32_t c = threadIdx.x; c < p.n; c += blockDim.x) {
+        global[c] = inverse ? batch::mul_mod(poly[c], p.n_inv, p.q) : poly[c];
+    }
+}
+
+__global__ void keygen_combine_kernel(batch::KernelParams p, size_t count, const uint32_t* a, const uint32_t* s,
+                                      const uint32_t* e, uint32_t* t) {
+    const size_t vec = static_cast<size_t>(p.k) * p.n;
+    const size_t id = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+    if (id >= count * vec) {
+        return;
+    }
+    const size_t inst = id / vec;
+    const uint32_t row = static_cast<uint32_t>(id % vec) / p.n;
+    const uint32_t c = static_cast<uint32_t>(id % p.n);
+    batch::keygen_combine_coeff(p, a + inst * p.k * vec, s + inst * vec, e + inst * vec, row, c, t + inst * vec);
+}
+
+__global__ void encapsulate_product_kernel(batch::KernelParams p, size_t count, const uint32_t* a_trans,
+                                           const uint32_t* t, const uint32_t* r, uint32_t* uv) {
+    const size_t vec = static_cast<size_t>(p.k) * p.n;
+    const size_t out = vec + p.n;
+    const size_t id = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+    if (id >= count * out) {
+        return;
+    }
+    const size_t inst = id / out;
+    const uint32_t row = static_cast<uint32_t>(id % out) / p.n;
+    const uint32_t c = static_cast<uint32_t>(id % p.n);
+    batch::encapsulate_product_coeff(p, a_trans + inst * p.k * vec, t + inst * vec, r + inst * vec, row, c,
+                                     uv + inst * out);
+}
+
+__global__ void encapsulate_finish_kernel(batch::KernelParams p, size_t count, const uint32_t* uv,
+                                          const uint32_t* e1, const uint32_t* e2, const uint32_t* messages,
+                                          uint32_t* ciphertext) {
+    const size_t vec = static_cast<size_t>(p.k) * p.n;
+    const size_t out = vec + p.n;
+    const size_t id = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+    if (id >= count * out) {
+        return;
+    }
+    const size_t inst = id / out;
+    const uint32_t row = static_cast<uint32_t>(id % out) / p.n;
+    const uint32_t c = static_cast<uint32_t>(id % p.n);
+    batch::encapsulate_finish_coeff(p, uv + inst * out, e1 + inst * vec, e2 + inst * p.n, messages[inst], row, c,
+                                    ciphertext + inst * out);
+}
+
+void launch_ntt(const batch::KernelParams& p, uint32_t* polys, size_t count, bool inverse, cudaStream_t stream) {
+    if (count == 0) {
+        return;
+    }
+    const unsigned threads = std::min<unsigned>(p.n / 2, MAX_NTT_THREADS);
+    ntt_kernel<<<static_cast<unsigned>(count), threads, p.n * sizeof(uint32_t), stream>>>(p, polys, inverse);
+}
+
+// Splits count instances into launches of at most config.instances_per_launch and cycles
+// them over config.streams streams. Each stream owns a slot of pinned staging buffers and
+// device memory; a slot is refilled once its previous launch has been copied out, so the
+// transfers of one launch overlap the kernels of the others.
+template <typename Slot, typename MakeSlot, typename Stage, typename Launch, typename Collect>
+void run_pipelined(const GpuBatchConfig& config, size_t count, MakeSlot make_slot, Stage stage, Launch launch,
+                   Collect collect) {
+    const size_t per_launch = std::max<size_t>(1, std::min(config.instances_per_launch, count));
+    const size_t stream_count = std::max<size_t>(1, std::min(config.streams, (count + per_launch - 1) / per_launch));
+    std::vector<std::unique_ptr<Stream>> streams;
+    std::vector<std::unique_ptr<Slot>> slots;
+    for (size_t i = 0; i < stream_count; ++i) {
+        streams.emplace_back(new Stream());
+        slots.push_back(make_slot(per_launch));
+    }
+    std::vector<size_t> slot_first(stream_count, 0);
+    std::vector<size_t> slot_count(stream_count, 0);
+
+    auto drain = [&](size_t s) {
+        if (slot_count[s] == 0) {
+            return;
+        }
+        check(cudaStreamSynchronize(streams[s]->get()), "cudaStreamSynchronize");
+        collect(*slots[s], slot_first[s], slot_count[s]);
+        slot_count[s] = 0;
+    };
+
+    size_t launch_index = 0;
+    for (size_t first = 0; first < count; first += per_launch, ++launch_index) {
+        const size_t s = launch_index % stream_count;
+        drain(s);
+        const size_t n = std::min(per_launch, count - first);
+        stage(*slots[s], first, n);
+        launch(*slots[s], n, streams[s]->get());
+        check(cudaGetLastError(), "kernel launch");
+        slot_first[s] = first;
+        slot_count[s] = n;
+    }
+    for (size_t s = 0; s < stream_count; ++s) {
+        drain(s);
+    }
+}
+
+} // namespace
+
+int cuda_batch_device_count() {
+    int devices = 0;
+    if (cudaGetDeviceCount(&devices) != cudaSuccess) {
+        cudaGetLastError();  // Clear the sticky "no driver" error
+        return 0;
+    }
+    return devices;
+}
+
+void run_keygen_batch_cuda(const GpuBatchConfig& config, const batch::KernelParams& host_params, const uint8_t* seeds,
+                           size_t count, uint32_t* t_hat, uint32_t* s_hat) {
+    if (count == 0) {
+        return;
+    }
+    check(cudaSetDevice(config.device), "cudaSetDevice");
+    DeviceTables tables(host_params);
+    const batch::KernelParams& p = tables.params();
+    const size_t vec = static_cast<size_t>(p.k) * p.n;
+
+    struct Slot {
+        PinnedBuffer<uint8_t> host_seeds;
+        PinnedBuffer<uint32_t> host_t;
+        PinnedBuffer<uint32_t> host_s;
+        DeviceBuffer<uint8_t> seeds;
+        DeviceBuffer<uint32_t> a;
+        DeviceBuffer<uint32_t> s;
+        DeviceBuffer<uint32_t> e;
+        DeviceBuffer<uint32_t> t;
+
+        Slot(size_t instances, size_t vec_coeffs, uint32_t k)
+            : host_seeds(instances * batch::INSTANCE_SEED_BYTES), host_t(instances * vec_coeffs),
+              host_s(instances * vec_coeffs), seeds(instances * batch::INSTANCE_SEED_BYTES),
+              a(instances * k * vec_coeffs), s(instances * vec_coeffs), e(instances * vec_coeffs),
+              t(instances * vec_coeffs) {}
+    };
+    run_pipelined<Slot>(
+        config, count,
+        [&](size_t instances) { return std::unique_ptr<Slot>(new Slot(instances, vec, p.k)); },
+        [&](Slot& slot, size_t first, size_t n) {
+            std::memcpy(slot.host_seeds.get(), seeds + first * batch::INSTANCE_SEED_BYTES,
+                        n * batch::INSTANCE_SEED_BYTES);
+        },
+        [&](Slot& slot, size_t n, cudaStream_t stream) {
+            check(cudaMemcpyAsync(slot.seeds.get(), slot.host_seeds.get(), n * batch::INSTANCE_SEED_BYTES,
+                                  cudaMemcpyHostToDevice, stream), "cudaMemcpyAsync");
+            const size_t tasks = n * (static_cast<size_t>(p.k) * p.k + 2 * p.k);
+            keygen_sample_kernel<<<blocks_for(tasks), THREADS_PER_BLOCK, 0, stream>>>(
+                p, slot.seeds.get(), n, slot.a.get(), slot.s.get(), slot.e.get());
+            launch_ntt(p, slot.s.get(), n * p.k, false, stream);
+            launch_ntt(p, slot.e.get(), n * p.k, false, stream);
+            keygen_combine_kernel<<<blocks_for(n * vec), THREADS_PER_BLOCK, 0, stream>>>(
+                p, n, slot.a.get(), slot.s.get(), slot.e.get(), slot.t.get());
+            check(cudaMemcpyAsync(slot.host_t.get(), slot.t.get(), n * vec * sizeof(uint32_t), cudaMemcpyDeviceToHost,
+                                  stream), "cudaMemcpyAsync");
+            check(cudaMemcpyAsync(slot.host_s.get(), slot.s.get(), n * vec * sizeof(uint32_t), cudaMemcpyDeviceToHost,
+                                  stream), "cudaMemcpyAsync");
+        },
+        [&](Slot& slot, size_t first, size_t n) {
+            std::memcpy(t_hat + first * vec, slot.host_t.get(), n * vec * sizeof(uint32_t));
+            std::memcpy(s_hat + first * vec, slot.host_s.get(), n * vec * sizeof(uint32_t));
+        });
+}
+
+void run_encapsulate_batch_cuda(const GpuBatchConfig& config, const batch::KernelParams& host_params,
+                                const uint8_t* matrix_seeds, const uint8_t* noise_seeds, const uint32_t* messages,
+                                const uint32_t* t_hat, size_t count, uint32_t* ciphertext) {
+    if (count == 0) {
+        return;
+    }
+    check(cudaSetDevice(config.device), "cudaSetDevice");
+    DeviceTables tables(host_params);
+    const batch::KernelParams& p = tables.params();
+    const size_t vec = static_cast<size_t>(p.k) * p.n;
+    const size_t out = vec + p.n;
+
+    struct Slot {
+        PinnedBuffer<uint8_t> host_matrix_seeds;
+        PinnedBuffer<uint8_t> host_noise_seeds;
+        PinnedBuffer<uint32_t> host_messages;
+        PinnedBuffer<uint32_t> host_t;
+        PinnedBuffer<uint32_t> host_ciphertext;
+        DeviceBuffer<uint8_t> matrix_seeds;
+        DeviceBuffer<uint8_t> noise_seeds;
+        DeviceBuffer<uint32_t> messages;
+        DeviceBuffer<uint32_t> t;
+        DeviceBuffer<uint32_t> a_trans;
+        DeviceBuffer<uint32_t> r;
+        DeviceBuffer<uint32_t> e1;
+        DeviceBuffer<uint32_t> e2;
+        DeviceBuffer<uint32_t> uv;
+        DeviceBuffer<uint32_t> ciphertext;
+
+        Slot(size_t instances, size_t vec_coeffs, size_t n, uint32_t k)
+            : host_matrix_seeds(instances * batch::SEED_BYTES),
+              host_noise_seeds(instances * batch::INSTANCE_SEED_BYTES), host_messages(instances),
+              host_t(instances * vec_coeffs), host_ciphertext(instances * (vec_coeffs + n)),
+              matrix_seeds(instances * batch::SEED_BYTES), noise_seeds(instances * batch::INSTANCE_SEED_BYTES),
+              messages(instances), t(instances * vec_coeffs), a_trans(instances * k * vec_coeffs),
+              r(instances * vec_coeffs), e1(instances * vec_coeffs), e2(instances * n),
+              uv(instances * (vec_coeffs + n)), ciphertext(instances * (vec_coeffs + n)) {}
+    };
+    run_pipelined<Slot>(
+        config, count,
+        [&](size_t instances) { return std::unique_ptr<Slot>(new Slot(instances, vec, p.n, p.k)); },
+        [&](Slot& slot, size_t first, size_t n) {
+            std::memcpy(slot.host_matrix_seeds.get(), matrix_seeds + first * batch::SEED_BYTES, n * batch::SEED_BYTES);
+            std::memcpy(slot.host_noise_seeds.get(), noise_seeds + first * batch::INSTANCE_SEED_BYTES,
+                        n * batch::INSTANCE_SEED_BYTES);
+            std::memcpy(slot.host_messages.get(), messages + first, n * sizeof(uint32_t));
+            std::memcpy(slot.host_t.get(), t_hat + first * vec, n * vec * sizeof(uint32_t));
+        },
+        [&](Slot& slot, size_t n, cudaStream_t stream) {
+            check(cudaMemcpyAsync(slot.matrix_seeds.get(), slot.host_matrix_seeds.get(), n * batch::SEED_BYTES,
+                                  cudaMemcpyHostToDevice, stream), "cudaMemcpyAsync");
+            check(cudaMemcpyAsync(slot.noise_seeds.get(), slot.host_noise_seeds.get(), n * batch::INSTANCE_SEED_BYTES,
+                                  cudaMemcpyHostToDevice, stream), "cudaMemcpyAsync");
+            check(cudaMemcpyAsync(slot.messages.get(), slot.host_messages.get(), n * sizeof(uint32_t),
+                                  cudaMemcpyHostToDevice, stream), "cudaMemcpyAsync");
+            check(cudaMemcpyAsync(slot.t.get(), slot.host_t.get(), n * vec * sizeof(uint32_t), cudaMemcpyHostToDevice,
+                                  stream), "cudaMemcpyAsync");
+            const size_t tasks = n * (static_cast<size_t>(p.k) * p.k + 2 * p.k + 1);
+            encapsulate_sample_kernel<<<blocks_for(tasks), THREADS_PER_BLOCK, 0, stream>>>(
+                p, slot.matrix_seeds.get(), slot.noise_seeds.get(), n, slot.a_trans.get(), slot.r.get(),
+                slot.e1.get(), slot.e2.get());
+            launch_ntt(p, slot.r.get(), n * p.k, false, stream);
+            encapsulate_product_kernel<<<blocks_for(n * out), THREADS_PER_BLOCK, 0, stream>>>(
+                p, n, slot.a_trans.get(), slot.t.get(), slot.r.get(), slot.uv.get());
+            launch_ntt(p, slot.uv.get(), n * (p.k + 1), true, stream);
+            encapsulate_finish_kernel<<<blocks_for(n * out), THREADS_PER_BLOCK, 0, stream>>>(
+                p, n, slot.uv.get(), slot.e1.get(), slot.e2.get(), slot.messages.get(), slot.ciphertext.get());
+            check(cudaMemcpyAsync(slot.host_ciphertext.get(), slot.ciphertext.get(), n * out * sizeof(uint32_t),
+                                  cudaMemcpyDeviceToHost, stream), "cudaMemcpyAsync");
+        },
+        [&](Slot& slot, size_t first, size_t n) {
+            std::memcpy(ciphertext + first * out, slot.host_ciphertext.get(), n * out * sizeof(uint32_t));
+        });
+}
+
+} // namespace clwe
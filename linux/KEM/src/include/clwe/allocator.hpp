@@ -0,0 +1,76 @@
+/**
+ * @file allocator.hpp
+ * @brief Caller-supplied allocator for ColorKEM's own buffers
+ *
+ * Polynomial buffers (prepared keys, workspaces, batch scratch), heap-backed
+ * workspace and I/O regions, NTT twiddle tables and the library's SIMD-aligned
+ * containers are allocated through one process-wide set of hooks, so an
+ * application running a custom allocator (mimalloc per-core heaps, a tracking
+ * arena) can keep the library on it and account for it separately. The hooks
+ * default to aligned operator new and delete.
+ *
+ * Blocks remember the hooks they were allocated with and are freed through
+ * them, so hooks can be replaced at any time; they must stay callable until
+ * every block they allocated is freed, which for the NTT tables is static
+ * destruction at exit. Blocks that may hold key material are released through
+ * the secure_deallocate hook.
+ *
+ * Huge-page mappings (PagePolicy::Huge) and mapped key stores come from the
+ * OS and do not go through the hooks.
+ *
+ * @author ColorKEM Development Team
+ * @version 1.0.0
+ * @date 2024
+ *
+ * @see page_allocation.hpp for the huge-page policy
+ */
+
+#ifndef CLWE_ALLOCATOR_HPP
+#define CLWE_ALLOCATOR_HPP
+
+#include <cstddef>
+
+namespace clwe {
+
+/**
+ * @brief Allocation entry points the library calls
+ *
+ * alignment is a power of two of at least sizeof(void*); size may be 0.
+ * deallocate and secure_deallocate receive the size and alignment the block
+ * was allocated with, and the context the hooks were installed with.
+ */
+struct AllocatorHooks {
+    /** @brief Return a block of size bytes aligned to alignment, or nullptr on failure */
+    void* (*allocate)(size_t size, size_t alignment, void* context) = nullptr;
+
+    /** @brief Free a block returned by allocate */
+    void (*deallocate)(void* ptr, size_t size, size_t alignment, void* context) = nullptr;
+
+    /**
+     * @brief Free a block that may hold secrets (optional)
+     *
+     * When null, the library zeroes the block itself and calls deallocate.
+     */
+    void (*secure_deallocate)(void* ptr, size_t size, size_t alignment, void* context) = nullptr;
+
+    /** @brief Passed unchanged to every hook */
+    void* context = nullptr;
+};
+
+/**
+ * @brief Route subsequent library allocations through hooks
+ *
+ * Thread-safe. Hooks with every function null restore the default allocator.
+ * Blocks already allocated are still freed through the hooks that allocated them.
+ *
+ * @throws std::invalid_argument If only one of allocate and deallocate is set,
+ *         or secure_deallocate is set without them
+ */
+void set_allocator(const AllocatorHooks& hooks);
+
+/** @brief Hooks currently applied; the default ones when none were installed */
+AllocatorHooks allocator_hooks();
+
+} // namespace clwe
+
+#endif // CLWE_ALLOCATOR_HPP
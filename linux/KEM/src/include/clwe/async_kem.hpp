@@ -0,0 +1,167 @@
+/**
+ * @file async_kem.hpp
+ * @brief Non-blocking ColorKEM front end for event-loop servers
+ *
+ * This header defines AsyncKEM, which queues key generation, encapsulation and
+ * decapsulation requests and runs them on an executor instead of the calling
+ * thread. Each request completes through a handler, so a reactor thread never
+ * blocks on the lattice arithmetic. Requests that arrive together are run as
+ * one batch.
+ *
+ * @author ColorKEM Development Team
+ * @version 1.0.0
+ * @date 2024
+ *
+ * @see color_kem.hpp for the synchronous operations and their batch forms
+ */
+
+#ifndef ASYNC_KEM_HPP
+#define ASYNC_KEM_HPP
+
+#include "color_kem.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace clwe {
+
+/**
+ * @brief Executor hook used by AsyncKEM
+ *
+ * Must run the given job at some later point on any thread, for example by
+ * posting it to a thread pool. It must not run the job inline inside the call.
+ */
+using AsyncKemPost = std::function<void(std::function<void()> job)>;
+
+/**
+ * @brief Completion handler of an AsyncKEM request
+ *
+ * Invoked exactly once, normally on an executor thread. On success error is
+ * null and result holds the value. Otherwise error holds the exception
+ * (AsyncKemCancelled if the request was cancelled) and result is
+ * default-constructed. Handlers must not throw.
+ *
+ * @tparam T Result of the operation
+ */
+template <typename T>
+using AsyncKemHandler = std::function<void(std::exception_ptr error, T result)>;
+
+/** @brief Error delivered to the handler of a cancelled request */
+class AsyncKemCancelled : public std::runtime_error {
+public:
+    AsyncKemCancelled() : std::runtime_error("AsyncKEM request cancelled") {}
+};
+
+/** @brief Batching limits of an AsyncKEM */
+struct AsyncKemConfig {
+    size_t max_batch = 8;  /**< Most queued requests taken by one executor job */
+};
+
+/**
+ * @brief Asynchronous ColorKEM with request batching
+ *
+ * Each async_* call queues a request and returns a ticket at once. An executor
+ * job takes up to max_batch queued requests and groups them by operation.
+ * Key generations run through keygen_batch(), encapsulations through
+ * encapsulate_batch() and decapsulations through decapsulate_batch(). This way
+ * requests for the same key share its expanded matrix or parsed secret. If a
+ * batch call fails, its requests are rerun one by one, so a bad input only
+ * fails its own request.
+ *
+ * Without an AsyncKemPost, requests run on one worker thread owned by the
+ * instance. C++20 coroutines can wrap a handler that resumes the awaiting
+ * coroutine on its own event loop.
+ *
+ * Example usage:
+ * @code
+ * clwe::AsyncKEM kem(clwe::CLWEParameters(768));
+ * kem.async_encapsulate(public_key, [](std::exception_ptr error, auto result) {
+ *     if (!error) send(result.first);
+ * });
+ * @endcode
+ *
+ * @note All member functions are thread-safe.
+ * @warning Handlers must not destroy the AsyncKEM that invokes them.
+ */
+class AsyncKEM {
+public:
+    /** @brief Identifies a queued request for cancel(); never 0 */
+    using Ticket = uint64_t;
+
+    /**
+     * @brief Create the front end
+     *
+     * @param params Parameters of the underlying ColorKEM
+     * @param post Executor for request batches; empty uses an internal worker thread
+     * @param config Batching limits
+     *
+     * @throws std::invalid_argument If config.max_batch is 0
+     */
+    explicit AsyncKEM(const CLWEParameters& params, AsyncKemPost post = AsyncKemPost(),
+                      const AsyncKemConfig& config = AsyncKemConfig());
+
+    /**
+     * @brief Cancel the queued requests and wait for running batches to finish
+     *
+     * Handlers of the requests cancelled here run on the destroying thread.
+     */
+    ~AsyncKEM();
+
+    AsyncKEM(const AsyncKEM&) = delete;             /**< Copy constructor disabled */
+    AsyncKEM& operator=(const AsyncKEM&) = delete;  /**< Copy assignment disabled */
+
+    /**
+     * @brief Queue a key generation
+     * @param handler Receives the key pair
+     * @return Ticket Ticket for cancel()
+     */
+    Ticket async_keygen(AsyncKemHandler<std::pair<ColorPublicKey, ColorPrivateKey>> handler);
+
+    /**
+     * @brief Queue an encapsulation
+     * @param public_key Recipient's public key, copied into the request
+     * @param handler Receives the ciphertext and shared secret
+     * @return Ticket Ticket for cancel()
+     */
+    Ticket async_encapsulate(const ColorPublicKey& public_key,
+                             AsyncKemHandler<std::pair<ColorCiphertext, ColorValue>> handler);
+
+    /**
+     * @brief Queue a decapsulation
+     * @param public_key Public key of the key pair
+     * @param private_key Private key, copied into the request and wiped after use
+     * @param ciphertext Ciphertext to decapsulate
+     * @param handler Receives the shared secret
+     * @return Ticket Ticket for cancel()
+     */
+    Ticket async_decapsulate(const ColorPublicKey& public_key, const ColorPrivateKey& private_key,
+                             const ColorCiphertext& ciphertext, AsyncKemHandler<ColorValue> handler);
+
+    /**
+     * @brief Cancel a request that has not started yet
+     *
+     * On success the handler receives AsyncKemCancelled on an executor thread.
+     *
+     * @param ticket Ticket returned by an async_* call
+     * @return bool True if the request was still queued, false if it already started or finished
+     */
+    bool cancel(Ticket ticket);
+
+    /** @brief Number of queued requests that have not started */
+    size_t pending() const;
+
+    /** @brief The underlying synchronous instance */
+    const ColorKEM& kem() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace clwe
+
+#endif // ASYNC_KEM_HPP
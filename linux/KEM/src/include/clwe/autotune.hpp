@@ -0,0 +1,142 @@
+/**
+ * @file autotune.hpp
+ * @brief Startup autotuner for the NTT backend, Keccak backend and batch size
+ *
+ * By default the NTT engines follow the highest instruction set the CPU
+ * reports and the SHAKE samplers the first of available_keccak_backends().
+ * Neither is always the fastest: AVX-512 can lose to AVX2 where wide vectors
+ * lower the clock, and the bundled SIMD Keccak can beat OpenSSL's. autotune()
+ * times every available candidate on the operations ColorKEM runs, selects the
+ * winners with set_ntt_backend() and set_keccak_backend(), and reports the
+ * batch size past which batching stops paying.
+ *
+ * Tuning is opt-in and takes tens of milliseconds. With a profile path the
+ * winners are stored per CPU (model name plus detected features), so later
+ * starts on the same hardware apply them without timing anything.
+ *
+ * Example usage:
+ * @code
+ * clwe::AutotuneOptions options;
+ * options.profile_path = "/var/cache/myservice/clwe-autotune";
+ * clwe::AutotuneResult tuned = clwe::autotune(options);  // before any ColorKEM is built
+ * clwe::KemCoalescerConfig config;
+ * config.max_batch = tuned.batch_size;
+ * @endcode
+ *
+ * @author ColorKEM Development Team
+ * @version 1.0.0
+ * @date 2024
+ *
+ * @see cpu_features.hpp, keccak_backend.hpp, kem_coalescer.hpp
+ */
+
+#ifndef CLWE_AUTOTUNE_HPP
+#define CLWE_AUTOTUNE_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "clwe.hpp"
+#include "cpu_features.hpp"
+#include "keccak_backend.hpp"
+
+namespace clwe {
+
+/**
+ * @brief NTT backends that are compiled in and run on this CPU
+ *
+ * Always includes SIMDSupport::NONE (the scalar engines). Instruction sets
+ * removed by CPUFeatureDetector::force_backend() or CLWE_FORCE_BACKEND are
+ * not listed.
+ */
+std::vector<SIMDSupport> available_ntt_backends();
+
+/**
+ * @brief Backend create_optimal_ntt_engine() builds engines for
+ *
+ * The last set_ntt_backend() choice, else the detected max_simd_support.
+ */
+SIMDSupport ntt_backend();
+
+/**
+ * @brief Select the NTT backend for subsequently built engines
+ *
+ * Thread-safe. Engines already built keep their backend, so ColorKEM
+ * instances constructed before the call keep theirs; instances constructed
+ * afterwards share engines built for the new one.
+ *
+ * @throws std::invalid_argument If the backend is not in available_ntt_backends()
+ */
+void set_ntt_backend(SIMDSupport backend);
+
+/** @brief The CLWE_FORCE_BACKEND name of a backend: "scalar", "avx2", "avx512", ... */
+const char* ntt_backend_name(SIMDSupport backend);
+
+/**
+ * @brief Key the autotune profile stores winners under
+ *
+ * The CPU model name the OS reports (/proc/cpuinfo on Linux) followed by
+ * CPUFeatures::to_string(), so a host whose features are masked (a VM
+ * without AVX-512, CLWE_FORCE_BACKEND) gets its own entry.
+ */
+std::string autotune_cpu_key();
+
+/** @brief How autotune() measures and where it keeps its results */
+struct AutotuneOptions {
+    std::string profile_path;                    /**< Profile file to read and update; empty times every call */
+    bool retune = false;                         /**< Time even when the profile has an entry for this CPU */
+    bool apply = true;                           /**< Select the winning backends; false only reports them */
+    CLWEParameters params = CLWEParameters(768); /**< Parameter set whose operations are timed */
+    unsigned repetitions = 5;                    /**< Timed runs per candidate; the fastest counts */
+    std::chrono::microseconds min_run{200};      /**< Shortest timed run; iterations double until reached */
+    std::vector<size_t> batch_sizes = {1, 2, 4, 8, 16, 32, 64};  /**< Encapsulation batch sizes to try */
+    double batch_tolerance = 0.05;               /**< Smallest batch within this fraction of the best cost wins */
+};
+
+/** @brief One measured candidate */
+struct AutotuneTiming {
+    std::string candidate;  /**< Backend name or batch size */
+    double ns_per_op = 0.0; /**< Fastest run's time per operation */
+};
+
+/** @brief Winners of one autotune() call */
+struct AutotuneResult {
+    std::string cpu_key;                         /**< autotune_cpu_key() */
+    SIMDSupport ntt_backend = SIMDSupport::NONE; /**< Fastest NTT backend */
+    KeccakBackend keccak_backend = KeccakBackend::Reference; /**< Fastest Keccak backend */
+    size_t batch_size = 1;                       /**< Smallest batch size within batch_tolerance of the best */
+    bool from_profile = false;                   /**< Taken from the profile; the timing lists are then empty */
+    bool applied = false;                        /**< The backends were selected */
+    std::vector<AutotuneTiming> ntt_timings;     /**< One NTT inner product (k forward, basemul, inverse) */
+    std::vector<AutotuneTiming> keccak_timings;  /**< One matrix row and k noise streams */
+    std::vector<AutotuneTiming> batch_timings;   /**< One encapsulation, by batch size */
+    double elapsed_us = 0.0;                     /**< Wall time of the call */
+};
+
+/**
+ * @brief Measure, or load, the fastest backends for this host and select them
+ *
+ * NTT candidates are timed on a decapsulation-shaped inner product, Keccak
+ * candidates on a SHAKE128x4 matrix row plus SHAKE256 noise streams, and batch
+ * sizes on ColorKEM::encapsulate_batch() with the selected backends. An
+ * existing profile entry for autotune_cpu_key() whose backends are still
+ * available is used instead of timing, unless options.retune is set; a fresh
+ * measurement replaces the entry and keeps the other CPUs' entries.
+ *
+ * Meant for process start: call it before building ColorKEM instances and
+ * before other threads use the library. Timing switches both selections
+ * candidate by candidate; with options.apply false they are restored
+ * afterwards.
+ *
+ * @param options What to time and where to keep it
+ * @return AutotuneResult The winners and, when measured, every timing
+ *
+ * @throws std::invalid_argument If options.params is invalid, repetitions is 0 or batch_sizes is empty
+ * @throws std::runtime_error If the profile cannot be written
+ */
+AutotuneResult autotune(const AutotuneOptions& options = AutotuneOptions());
+
+} // namespace clwe
+
+#endif // CLWE_AUTOTUNE_HPP
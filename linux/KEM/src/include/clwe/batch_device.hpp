@@ -0,0 +1,65 @@
+/**
+ * @file batch_device.hpp
+ * @brief Offloading bulk key generation and encapsulation to a GPU
+ *
+ * ColorKEM::keygen_batch() and ColorKEM::encapsulate_batch() can run their
+ * lattice arithmetic (SHAKE matrix expansion, CBD noise sampling, NTTs and the
+ * NTT-domain products) on a CUDA device, thousands of independent instances
+ * per kernel launch, for offline provisioning of very many keys. Seed
+ * derivation and serialization stay on the host. Device results are
+ * byte-identical to the CPU path.
+ *
+ * CUDA support is compiled in with the CLWE_WITH_CUDA CMake option. Without
+ * it, or without a usable device, only BatchDevice::Cpu is available.
+ *
+ * @author ColorKEM Development Team
+ * @version 1.0.0
+ * @date 2024
+ *
+ * @see ColorKEM::set_batch_device()
+ */
+
+#ifndef BATCH_DEVICE_HPP
+#define BATCH_DEVICE_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace clwe {
+
+/** @brief Where the batch calls run */
+enum class BatchDevice {
+    Cpu,   /**< The calling thread (and the executor, if one is set) */
+    Cuda   /**< A CUDA device (CLWE_WITH_CUDA builds) */
+};
+
+/** @brief Launch geometry of the GPU batch path */
+struct GpuBatchConfig {
+    int device = 0;                      /**< CUDA device ordinal */
+    size_t instances_per_launch = 4096;  /**< Key pairs or encapsulations per kernel launch */
+    size_t streams = 2;                  /**< Launches in flight, so transfers overlap kernels */
+};
+
+/**
+ * @brief Whether a device can run the batch calls
+ *
+ * Cpu is always available. Cuda needs a CLWE_WITH_CUDA build and at least
+ * one CUDA device.
+ */
+bool batch_device_available(BatchDevice device);
+
+/** @brief "cpu" or "cuda" */
+const char* batch_device_name(BatchDevice device);
+
+/**
+ * @brief Parse a batch device name
+ *
+ * @param name "cpu" or "cuda"
+ * @param device Receives the parsed device
+ * @return bool False if name is not recognized
+ */
+bool parse_batch_device(const std::string& name, BatchDevice& device);
+
+} // namespace clwe
+
+#endif // BATCH_DEVICE_HPP
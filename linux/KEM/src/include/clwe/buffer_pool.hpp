@@ -0,0 +1,113 @@
+/**
+ * @file buffer_pool.hpp
+ * @brief Recyclable ciphertext and public key buffers for server hot paths
+ *
+ * ColorCiphertext and ColorPublicKey own their bytes in std::vector buffers,
+ * so every ciphertext a server sends and every client key it parses costs an
+ * allocation and a free, even when the operation itself runs in a warm
+ * KemWorkspace. A KemBufferPool keeps those buffers instead. Objects taken
+ * with ColorCiphertext::acquire() or ColorPublicKey::acquire() hand their
+ * buffers back to the pool when they are destroyed, on whichever thread that
+ * happens, and the next acquire() on that thread reuses them.
+ *
+ * Each thread has its own free list per pool, so acquiring and returning
+ * take no lock and never contend with other threads; a buffer acquired on
+ * one thread and destroyed on another simply moves to the second thread's
+ * list. Operations that write into an existing object (encapsulate_into(),
+ * try_encapsulate_key(), try_deserialize()) keep its buffers, so in steady
+ * state encapsulation allocates nothing, including the ciphertext that
+ * leaves the call.
+ *
+ * Example usage:
+ * @code
+ * clwe::KemBufferPool pool(params);
+ * clwe::ColorCiphertext ciphertext = clwe::ColorCiphertext::acquire(pool);
+ * kem.encapsulate_into(expanded_key, m, ciphertext, workspace);
+ * send_queue.push_back(std::move(ciphertext));  // buffers return when the entry is destroyed
+ * @endcode
+ *
+ * @author ColorKEM Development Team
+ * @version 1.0.0
+ * @date 2024
+ *
+ * @see color_kem.hpp, allocator.hpp
+ */
+
+#ifndef CLWE_BUFFER_POOL_HPP
+#define CLWE_BUFFER_POOL_HPP
+
+#include "clwe.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace clwe {
+
+struct BufferPoolState;
+
+/** @brief Counters of one KemBufferPool, summed over all threads */
+struct KemBufferPoolStats {
+    uint64_t acquired = 0;  /**< Objects handed out by acquire() */
+    uint64_t reused = 0;    /**< Of those, served from a free list rather than freshly allocated */
+    uint64_t returned = 0;  /**< Buffer sets put back on a free list */
+    uint64_t dropped = 0;   /**< Buffer sets freed instead: the list was full or they had shrunk */
+};
+
+/**
+ * @brief Per-thread free lists of ciphertext and public key buffers
+ *
+ * Buffers are sized for the pool's parameters; objects acquired from it
+ * start with their vectors at the sizes those parameters give
+ * (ColorCiphertext::serialized_size() less the hint, the public data of
+ * ColorPublicKey::serialized_size()) and unspecified contents. Buffers that
+ * come back smaller than that are freed rather than kept.
+ *
+ * Copies of an acquired object return their own buffers to the same pool;
+ * assigning over one frees its buffers the usual way. Secret material never
+ * goes through the pool: ciphertexts and public keys are public, and their
+ * buffers are reused without being wiped.
+ *
+ * The pool's state lives until the pool and every object acquired from it
+ * are gone, so objects may outlive the KemBufferPool. Buffers already on a
+ * thread's free list stay there until the thread exits, trim() is called on
+ * it, or the thread next meets a new pool after this one is gone.
+ *
+ * @note All member functions are thread-safe.
+ */
+class KemBufferPool {
+public:
+    /**
+     * @brief Create an empty pool for ciphertexts and public keys of params
+     *
+     * @param params Parameters whose sizes the buffers are kept at
+     * @param max_cached_per_thread Buffers of each kind a thread's free list keeps; more are freed
+     *
+     * @throws std::invalid_argument If params is invalid or max_cached_per_thread is 0
+     */
+    explicit KemBufferPool(const CLWEParameters& params, size_t max_cached_per_thread = 64);
+    ~KemBufferPool();
+
+    KemBufferPool(const KemBufferPool&) = delete;             /**< Copy constructor disabled */
+    KemBufferPool& operator=(const KemBufferPool&) = delete;  /**< Copy assignment disabled */
+
+    /** @brief Parameters the buffers are sized for */
+    const CLWEParameters& params() const;
+
+    /** @brief Buffers of each kind a thread's free list keeps */
+    size_t max_cached_per_thread() const;
+
+    /** @brief Free the calling thread's cached buffers of this pool */
+    void trim();
+
+    /** @brief Counters since construction (a snapshot under concurrency) */
+    KemBufferPoolStats stats() const;
+
+private:
+    friend struct ColorCiphertext;
+    friend struct ColorPublicKey;
+    std::shared_ptr<BufferPoolState> state_;
+};
+
+} // namespace clwe
+
+#endif // CLWE_BUFFER_POOL_HPP
@@ -36,6 +36,71 @@ namespace clwe {
 /** @brief Current version of the ColorKEM library */
 const std::string VERSION = "1.0.0";
 
+/**
+ * @brief Wire encoding of polynomial coefficients in keys and ciphertexts
+ */
+enum class CoefficientEncoding : uint8_t {
+    COLOR32 = 0,   /**< 4 bytes per coefficient: the RGBA color value, big-endian (default) */
+    PACKED12 = 1   /**< FIPS 203 ByteEncode12: two 12-bit coefficients per 3 bytes, little-endian */
+};
+
+/**
+ * @brief Symmetric primitive that expands the matrix A and the noise polynomials
+ *
+ * AES256_CTR is the Kyber-90s construction: cell (i, j) of A is rejection
+ * sampled from AES-256-CTR keyed with the public seed under nonce i | j << 8,
+ * and noise polynomial b from AES-256-CTR keyed with its noise seed under
+ * nonce b. It is faster where AES hardware (AES-NI, VAES, ARMv8 Crypto)
+ * outruns Keccak, and yields keys and ciphertexts of the same sizes that only
+ * interoperate with other AES256_CTR parameter sets.
+ */
+enum class XofAlgorithm : uint8_t {
+    SHAKE128 = 0,   /**< SHAKE-128 matrix expansion and SHAKE-256 noise, as FIPS 203 (default) */
+    AES256_CTR = 1  /**< AES-256 in counter mode for both, as Kyber-90s */
+};
+
+/**
+ * @brief Precomputed Barrett reduction modulo a runtime modulus
+ *
+ * A % by a modulus known only at run time compiles to a hardware divide, which
+ * is slow and on some CPUs takes a data-dependent number of cycles. This holds
+ * floor(2^32 / q) so that reduction is a multiply, a shift and one
+ * branch-free conditional subtraction.
+ *
+ * @note Requires 2 <= q <= 65536, so products of two residues fit in 32 bits.
+ * @see CLWEParameters::reducer()
+ */
+struct BarrettReducer {
+    uint32_t modulus;     /**< q */
+    uint32_t multiplier;  /**< floor(2^32 / q) */
+
+    explicit BarrettReducer(uint32_t q)
+        : modulus(q), multiplier(static_cast<uint32_t>((static_cast<uint64_t>(1) << 32) / q)) {}
+
+    /** @brief x mod q for any 32-bit x; the quotient estimate is at most one short */
+    uint32_t reduce(uint32_t x) const {
+        uint32_t t = static_cast<uint32_t>((static_cast<uint64_t>(x) * multiplier) >> 32);
+        uint32_t r = x - t * modulus;
+        return r - (modulus & (0u - static_cast<uint32_t>(r >= modulus)));
+    }
+
+    /** @brief (a + b) mod q for residues a, b < q */
+    uint32_t add(uint32_t a, uint32_t b) const {
+        uint32_t r = a + b;
+        return r - (modulus & (0u - static_cast<uint32_t>(r >= modulus)));
+    }
+
+    /** @brief (a - b) mod q for residues a, b < q */
+    uint32_t sub(uint32_t a, uint32_t b) const {
+        return add(a, modulus - b);
+    }
+
+    /** @brief (a * b) mod q for residues a, b < q */
+    uint32_t mul(uint32_t a, uint32_t b) const {
+        return reduce(a * b);
+    }
+};
+
 /**
  * @brief Cryptographic parameters for CLWE operations
  *
@@ -51,7 +116,13 @@ const std::string VERSION = "1.0.0";
  * - **module_rank**: Module rank k (2, 3, or 4 for ML-KEM levels)
  * - **modulus**: Prime modulus q (3329 for ML-KEM)
  * - **eta1**: Noise parameter for key generation
+ * - **secret_weight**: Optional fixed-weight ternary secret (h coefficients of +-1 per polynomial)
  * - **eta2**: Noise parameter for encryption
+ * - **du**, **dv**: Optional ciphertext compression (Compress_d rounding of c1 and c2)
+ * - **t_dropped_bits**: Optional public key rounding (Power2Round of t, dropping its low bits)
+ * - **sparse_c2**: Optional ciphertext layout carrying only c2[0], dropping n - 1 coefficients
+ * - **shared_matrix**: Optional deployment-wide matrix A (ColorKEM::install_shared_matrix()); public keys carry only t
+ * - **xof**: Primitive expanding A and the noise, SHAKE (FIPS 203) or AES-256-CTR (Kyber-90s)
  *
  * @note All parameters are validated during construction.
  * @see https://doi.org/10.6028/NIST.FIPS.203 for ML-KEM parameter details
@@ -63,6 +134,20 @@ struct CLWEParameters {
     uint32_t modulus;         // Prime modulus q
     uint32_t eta1;           // Binomial distribution parameter for key generation
     uint32_t eta2;           // Binomial distribution parameter for encryption
+    CoefficientEncoding encoding = CoefficientEncoding::COLOR32;  // Serialized coefficient format
+    uint32_t du = 0;         // Ciphertext c1 compression bits, 0 = uncompressed (ML-KEM: 10, or 11 at 1024)
+    uint32_t dv = 0;         // Ciphertext c2 compression bits, 0 = uncompressed (ML-KEM: 4, or 5 at 1024)
+    bool sparse_c2 = false;  // Transmit only the message-bearing constant term of c2
+    bool shared_matrix = false;  // Every key uses the installed deployment matrix A; public keys omit the seed
+    XofAlgorithm xof = XofAlgorithm::SHAKE128;  // Matrix and noise expansion primitive
+    // Low bits of t dropped from public keys (Power2Round), 0 = full precision. Public keys
+    // then carry t1 = round(t / 2^d) in coefficient domain, packed at rounded_t_bits() bits,
+    // and encapsulation uses t1 * 2^d; check decapsulation_failure_log2() before choosing d
+    uint32_t t_dropped_bits = 0;
+    // Fixed-weight ternary secret: s has exactly this many +-1 coefficients per polynomial
+    // and zeros elsewhere, 0 = centered binomial eta1 like e. Prepared private keys then
+    // decrypt by sparse add/subtract passes instead of NTTs; formats are unchanged
+    uint32_t secret_weight = 0;
 
     /**
      * @brief Construct CLWE parameters with standard ML-KEM settings
@@ -133,6 +218,71 @@ struct CLWEParameters {
         validate();
     }
 
+    /** @brief fingerprint() of every parameter set with a field too wide for its slot */
+    static constexpr uint64_t INVALID_FINGERPRINT = ~static_cast<uint64_t>(0);
+
+    /**
+     * @brief 64-bit identity of the fields that fix the key and ciphertext formats
+     *
+     * Packs security level (11 bits), t_dropped_bits (3), shared_matrix (1),
+     * xof (1), degree (16), modulus (17), module rank (5), du (4), dv (4),
+     * encoding (1) and sparse_c2 (1) into one word, so two parameter sets give
+     * identical formats exactly when their fingerprints are equal. The
+     * t_dropped_bits, xof and shared_matrix bits sit above the security level,
+     * which never needs more than 11 bits, so other sets keep the fingerprints
+     * they had before those fields existed. The noise parameters eta1, eta2
+     * and secret_weight are not part of it. A field too wide for its slot, which validate()
+     * rejects, yields INVALID_FINGERPRINT.
+     *
+     * @return uint64_t The fingerprint, computed in a few shifts
+     */
+    uint64_t fingerprint() const {
+        if (security_level > 0x7FF || t_dropped_bits > 0x7 || degree > 0xFFFF || modulus > 0x1FFFF || module_rank > 0x1F ||
+            du > 0xF || dv > 0xF || static_cast<uint8_t>(encoding) > 1 || static_cast<uint8_t>(xof) > 1) {
+            return INVALID_FINGERPRINT;
+        }
+        return static_cast<uint64_t>(security_level) |
+               (static_cast<uint64_t>(t_dropped_bits) << 11) |
+               (static_cast<uint64_t>(shared_matrix) << 14) |
+               (static_cast<uint64_t>(xof) << 15) |
+               (static_cast<uint64_t>(degree) << 16) |
+               (static_cast<uint64_t>(modulus) << 32) |
+               (static_cast<uint64_t>(module_rank) << 49) |
+               (static_cast<uint64_t>(du) << 54) |
+               (static_cast<uint64_t>(dv) << 58) |
+               (static_cast<uint64_t>(encoding) << 62) |
+               (static_cast<uint64_t>(sparse_c2) << 63);
+    }
+
+    /**
+     * @brief Barrett reducer for this parameter set's modulus
+     *
+     * Computed on each call with one division; hot paths keep the result.
+     */
+    BarrettReducer reducer() const {
+        return BarrettReducer(modulus);
+    }
+
+    /**
+     * @brief Bits per packed coefficient of a rounded public key
+     *
+     * Width of the largest t1 that Power2Round produces for this modulus and
+     * t_dropped_bits (11 for q = 3329, d = 1; 9 for d = 3).
+     *
+     * @return uint32_t 0 when t_dropped_bits is 0 (public keys use the coefficient encoding)
+     */
+    uint32_t rounded_t_bits() const {
+        if (t_dropped_bits == 0) {
+            return 0;
+        }
+        uint32_t max_t1 = (modulus - 1 + (1u << (t_dropped_bits - 1)) - 1) >> t_dropped_bits;
+        uint32_t bits = 0;
+        while ((max_t1 >> bits) != 0) {
+            ++bits;
+        }
+        return bits;
+    }
+
     /**
      * @brief Validate parameter values
      *
@@ -145,6 +295,11 @@ struct CLWEParameters {
      * - Module rank must be between 1 and 16
      * - Modulus must be prime between 256 and 65536
      * - Noise parameters must be between 1 and 16
+     * - PACKED12 encoding requires a modulus of at most 4096
+     * - du and dv are both 0, or both between 1 and 11 with a modulus of at most 4096
+     * - t_dropped_bits is at most 7
+     * - secret_weight is at most the degree, which it requires to be a multiple of 64
+     * - AES256_CTR requires eta1 and eta2 of 2 or 3 and a degree that is a multiple of 64
      *
      * @throws std::invalid_argument If any parameter validation fails
      *
@@ -180,9 +335,45 @@ struct CLWEParameters {
         if (eta2 == 0 || eta2 > 16) {
             throw std::invalid_argument("Invalid eta2: must be between 1 and 16");
         }
+
+        // Validate encoding: packed coefficients must fit in 12 bits
+        if (encoding == CoefficientEncoding::PACKED12 && modulus > 4096) {
+            throw std::invalid_argument("Invalid encoding: PACKED12 requires a modulus of at most 4096");
+        }
+
+        // Validate compression: both widths set, each below the 12-bit coefficient size
+        if (du != 0 || dv != 0) {
+            if (du == 0 || du > 11 || dv == 0 || dv > 11) {
+                throw std::invalid_argument("Invalid compression: du and dv must both be between 1 and 11");
+            }
+            if (modulus > 4096) {
+                throw std::invalid_argument("Invalid compression: requires a modulus of at most 4096");
+            }
+        }
+
+        // Validate public key rounding: the fingerprint has three bits for it
+        if (t_dropped_bits > 7) {
+            throw std::invalid_argument("Invalid t_dropped_bits: must be at most 7");
+        }
+
+        // Validate the ternary secret: its random bytes come from the noise sampler's stream
+        if (secret_weight != 0 && (secret_weight > degree || degree % 64 != 0)) {
+            throw std::invalid_argument("Invalid secret_weight: must be at most the degree, "
+                                        "and needs a degree divisible by 64");
+        }
+
+        // Validate xof: the AES noise PRF feeds the block CBD, which covers eta 2 and 3 only
+        if (xof != XofAlgorithm::SHAKE128) {
+            if (xof != XofAlgorithm::AES256_CTR) {
+                throw std::invalid_argument("Invalid xof: must be SHAKE128 or AES256_CTR");
+            }
+            if ((eta1 != 2 && eta1 != 3) || (eta2 != 2 && eta2 != 3) || degree % 64 != 0) {
+                throw std::invalid_argument("Invalid xof: AES256_CTR requires eta1 and eta2 of 2 or 3 "
+                                            "and a degree divisible by 64");
+            }
+        }
     }
 
-private:
     // Helper function to check if a number is prime
     static bool is_prime(uint32_t n) {
         if (n <= 1) return false;
@@ -195,6 +386,26 @@ private:
     }
 };
 
+/**
+ * @brief Estimated probability that decapsulation of an honest ciphertext fails
+ *
+ * Models each decoded coefficient's error (e^T r - s^T e1 + e2, the public key
+ * rounding term t0^T r, and the du/dv compression errors, with s binomial or
+ * fixed-weight ternary) as a centered
+ * Gaussian with the sum of the terms' exact variances, and takes the union
+ * bound over the decoded coefficients (one with sparse_c2, else the degree).
+ * Rounding and compression errors are averaged over t and u uniform mod q.
+ * This is a central-limit estimate for comparing choices of t_dropped_bits, du
+ * and dv, not a security claim: the bounded dv rounding error has lighter tails
+ * than a Gaussian, so with ML-KEM compression it is pessimistic (about 2^-76
+ * for ML-KEM-512, whose exact analysis gives 2^-139). Roughly 2^-213, 2^-159
+ * and 2^-77 for ML-KEM-512 at t_dropped_bits 1, 2 and 3 without compression.
+ *
+ * @param params Parameter set to evaluate
+ * @return double log2 of the failure probability (negative; 0 means certain failure)
+ */
+double decapsulation_failure_log2(const CLWEParameters& params);
+
 /**
  * @brief Error codes for CLWE operations
  *
@@ -209,7 +420,9 @@ enum class CLWEError {
     AVX_NOT_SUPPORTED = 3,          /**< AVX instructions not supported on this platform */
     INVALID_KEY = 4,                /**< Provided key is malformed or invalid */
     VERIFICATION_FAILED = 5,        /**< Cryptographic verification failed */
-    UNKNOWN_ERROR = 6               /**< An unspecified error occurred */
+    UNKNOWN_ERROR = 6,              /**< An unspecified error occurred */
+    INVALID_CIPHERTEXT = 7,         /**< Provided ciphertext is malformed */
+    BUFFER_TOO_SMALL = 8            /**< An output buffer is too small for the result */
 };
 
 /**
@@ -225,6 +438,14 @@ enum class CLWEError {
  */
 std::string get_error_message(CLWEError error);
 
+/**
+ * @brief get_error_message() as a static string, for error paths that must not allocate
+ *
+ * @param error The error code to convert
+ * @return const char* Human-readable description of the error; never null
+ */
+const char* error_string(CLWEError error) noexcept;
+
 } // namespace clwe
 
 #endif // CLWE_HPP
\ No newline at end of file
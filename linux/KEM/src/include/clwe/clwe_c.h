@@ -0,0 +1,138 @@
+/**
+ * @file clwe_c.h
+ * @brief Stable C interface to the 256-bit ColorKEM mode
+ *
+ * This header exposes key generation, encapsulation and decapsulation of
+ * ColorKEM::encapsulate_key() to C and to foreign-function interfaces. Every
+ * output goes to memory the caller owns and sizes with the clwe_*_bytes()
+ * queries; keys and ciphertexts cross the boundary as the same bytes the C++
+ * serialize() functions produce. Encapsulation reads the public key in place
+ * and writes the ciphertext in place, so once a thread is warm a call costs
+ * the KEM operation and nothing else: no copies of the key or the ciphertext
+ * and no allocations.
+ *
+ * No function throws or aborts: failures are reported as clwe_status codes.
+ * A context may be used from several threads at once.
+ *
+ * Example usage:
+ * @code
+ * clwe_ctx* ctx = clwe_ctx_new(768);
+ * uint8_t* pk = malloc(clwe_public_key_bytes(ctx));
+ * uint8_t* sk = malloc(clwe_private_key_bytes(ctx));
+ * uint8_t* ct = malloc(clwe_ciphertext_bytes(ctx));
+ * uint8_t ss[CLWE_SHARED_SECRET_BYTES], ss2[CLWE_SHARED_SECRET_BYTES];
+ *
+ * clwe_keygen(ctx, pk, clwe_public_key_bytes(ctx), sk, clwe_private_key_bytes(ctx));
+ * clwe_encapsulate(ctx, pk, clwe_public_key_bytes(ctx), ct, clwe_ciphertext_bytes(ctx), ss);
+ * clwe_decapsulate(ctx, sk, clwe_private_key_bytes(ctx), ct, clwe_ciphertext_bytes(ctx), ss2);
+ * clwe_ctx_free(ctx);
+ * @endcode
+ *
+ * @author ColorKEM Development Team
+ * @version 1.0.0
+ * @date 2024
+ */
+
+#ifndef CLWE_C_H
+#define CLWE_C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Bytes of every shared secret */
+#define CLWE_SHARED_SECRET_BYTES 32
+
+/** @brief Result of every fallible call */
+typedef enum clwe_status {
+    CLWE_OK = 0,                       /**< Success */
+    CLWE_ERROR_INVALID_ARGUMENT = -1,  /**< Null pointer, wrong input size, malformed or mismatched key */
+    CLWE_ERROR_BUFFER_TOO_SMALL = -2,  /**< An output buffer is shorter than its clwe_*_bytes() size */
+    CLWE_ERROR_OUT_OF_MEMORY = -3,     /**< An allocation failed */
+    CLWE_ERROR_INTERNAL = -4           /**< Any other failure, e.g. no entropy */
+} clwe_status;
+
+/** @brief Opaque KEM instance for one security level */
+typedef struct clwe_ctx clwe_ctx;
+
+/**
+ * @brief Create a context for security level 512, 768 or 1024
+ *
+ * @return clwe_ctx* The context, or NULL if the level is not supported or
+ *         memory runs out
+ */
+clwe_ctx* clwe_ctx_new(uint32_t security_level);
+
+/** @brief Free a context and wipe the key material it caches; NULL is ignored */
+void clwe_ctx_free(clwe_ctx* ctx);
+
+/** @brief Serialized public key bytes: matrix seed then t_hat */
+size_t clwe_public_key_bytes(const clwe_ctx* ctx);
+
+/** @brief Serialized private key bytes: s_hat, the public key and its hash */
+size_t clwe_private_key_bytes(const clwe_ctx* ctx);
+
+/** @brief Serialized ciphertext bytes, including the 4-byte hint */
+size_t clwe_ciphertext_bytes(const clwe_ctx* ctx);
+
+/** @brief Static description of a status code */
+const char* clwe_status_string(int status);
+
+/**
+ * @brief Generate a key pair
+ *
+ * @param pk_out Receives clwe_public_key_bytes() bytes
+ * @param sk_out Receives clwe_private_key_bytes() bytes
+ * @return int CLWE_OK or a clwe_status error; on error neither output holds a key
+ */
+int clwe_keygen(const clwe_ctx* ctx, uint8_t* pk_out, size_t pk_out_len, uint8_t* sk_out, size_t sk_out_len);
+
+/**
+ * @brief Encapsulate a fresh shared secret to a public key
+ *
+ * @param pk The recipient's public key; pk_len must be clwe_public_key_bytes()
+ * @param ct_out Receives clwe_ciphertext_bytes() bytes
+ * @param ss_out Receives CLWE_SHARED_SECRET_BYTES bytes
+ * @return int CLWE_OK or a clwe_status error; on error ss_out is zeroed
+ */
+int clwe_encapsulate(const clwe_ctx* ctx, const uint8_t* pk, size_t pk_len, uint8_t* ct_out, size_t ct_out_len,
+                     uint8_t* ss_out);
+
+/**
+ * @brief clwe_encapsulate() to count public keys in one call
+ *
+ * Key i is read from pks + i * pk_len, its ciphertext written to
+ * ct_out + i * ct_out_len and its secret to ss_out + i * CLWE_SHARED_SECRET_BYTES.
+ *
+ * @param pk_len Bytes of each key, clwe_public_key_bytes()
+ * @param ct_out_len Stride of each ciphertext, at least clwe_ciphertext_bytes()
+ * @return int CLWE_OK or a clwe_status error; on error every secret is zeroed,
+ *         except when count * CLWE_SHARED_SECRET_BYTES overflows size_t
+ */
+int clwe_encapsulate_batch(const clwe_ctx* ctx, size_t count, const uint8_t* pks, size_t pk_len, uint8_t* ct_out,
+                           size_t ct_out_len, uint8_t* ss_out);
+
+/**
+ * @brief Recover the shared secret of a ciphertext
+ *
+ * A ciphertext that fails re-encryption still succeeds, with an implicit
+ * rejection secret, exactly as ColorKEM::decapsulate_key(). The parsed private
+ * key of the latest call is kept in the context, so repeated calls with the
+ * same key skip parsing and allocate nothing.
+ *
+ * @param sk Private key from clwe_keygen(); sk_len must be clwe_private_key_bytes()
+ * @param ct Ciphertext; ct_len must be clwe_ciphertext_bytes()
+ * @param ss_out Receives CLWE_SHARED_SECRET_BYTES bytes
+ * @return int CLWE_OK or a clwe_status error; on error ss_out is zeroed
+ */
+int clwe_decapsulate(const clwe_ctx* ctx, const uint8_t* sk, size_t sk_len, const uint8_t* ct, size_t ct_len,
+                     uint8_t* ss_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CLWE_C_H
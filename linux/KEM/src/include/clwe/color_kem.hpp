@@ -22,24 +22,42 @@
 #define COLOR_KEM_HPP
 
 #include "clwe.hpp"
+#include "random_source.hpp"
+#include "page_allocation.hpp"
+#include "batch_device.hpp"
 #include "color_value.hpp"
 #include "color_ntt_engine.hpp"
+#include "cpu_features.hpp"
 #include <vector>
 #include <array>
 #include <memory>
+#include <list>
+#include <mutex>
+#include <functional>
+#include <utility>
 
 namespace clwe {
 
 // Forward declarations
 class ColorNTTEngine;
 class ColorKEM;
+class DecapsulationContext;
+class KeygenOp;
+class KemArena;
+class Poly;
+class PolyVec;
+class SHAKE256Sampler;
+class PolyMatrix;
+class SparseTernaryVec;
+class KemBufferPool;
+struct BufferPoolState;
 
 /**
  * @brief Public key structure for ColorKEM
  *
  * Contains the public key components needed for encapsulation:
- * - A 32-byte seed used to deterministically generate the matrix A
- * - Serialized public key data (polynomial coefficients as colors)
+ * - A 32-byte seed used to deterministically generate the matrix A (sampled in NTT domain)
+ * - Serialized public key data: t in NTT domain (t_hat), values as colors
  * - Cryptographic parameters
  *
  * @note The public key can be safely shared and does not contain sensitive information.
@@ -50,18 +68,110 @@ struct ColorPublicKey {
     CLWEParameters params;
 
     ColorPublicKey() = default;
-    ColorPublicKey(const std::array<uint8_t, 32>& s, const std::vector<uint8_t>& pd, const CLWEParameters& p)
-        : seed(s), public_data(pd), params(p) {}
+    ColorPublicKey(const std::array<uint8_t, 32>& s, std::vector<uint8_t> pd, const CLWEParameters& p)
+        : seed(s), public_data(std::move(pd)), params(p) {}
+    ColorPublicKey(const ColorPublicKey& other);             /**< Copies share the memoized form */
+    ColorPublicKey& operator=(const ColorPublicKey& other);  /**< Copies share the memoized form */
+    ColorPublicKey(ColorPublicKey&&) = default;
+    ColorPublicKey& operator=(ColorPublicKey&&) = default;
+    ~ColorPublicKey();
+
+    /**
+     * @brief Key whose public_data comes from, and returns to, a KemBufferPool
+     *
+     * public_data is sized for pool.params() and taken from the calling
+     * thread's free list when it has one; destroying the key puts it back.
+     * Parse received keys into it with try_deserialize(), which keeps the
+     * buffer. See buffer_pool.hpp.
+     *
+     * @param pool Pool to take the buffer from; the key may outlive it
+     * @return ColorPublicKey Key with params = pool.params() and unspecified seed and data
+     */
+    static ColorPublicKey acquire(KemBufferPool& pool);
 
     std::vector<uint8_t> serialize() const;
     static ColorPublicKey deserialize(const std::vector<uint8_t>& data, const CLWEParameters& params);
+
+    /** @brief Serialized size of a public key for the given parameters */
+    static size_t serialized_size(const CLWEParameters& params);
+
+    /**
+     * @brief Size of the serialized seed: 32, or 0 for CLWEParameters::shared_matrix
+     *
+     * Public keys of shared_matrix parameter sets carry t_hat only; parsing
+     * fills seed from the installed deployment matrix.
+     */
+    static size_t seed_bytes(const CLWEParameters& params);
+
+    /**
+     * @brief Serialize into a caller-provided buffer
+     *
+     * @return size_t Number of bytes written
+     * @throws std::invalid_argument If the key is malformed or out_size is too small
+     */
+    size_t serialize(uint8_t* out, size_t out_size) const;
+
+    /**
+     * @throws std::invalid_argument If the size is malformed
+     * @throws std::logic_error If params.shared_matrix is set and no matrix is installed
+     */
+    static ColorPublicKey deserialize(const uint8_t* data, size_t size, const CLWEParameters& params);
+
+    /**
+     * @brief deserialize() that reports failure as a code instead of throwing
+     *
+     * Nothing is allocated on the error path, and on success out reuses the
+     * capacity it already has.
+     *
+     * @return CLWEError SUCCESS, INVALID_KEY for a malformed size,
+     *         INVALID_PARAMETERS for shared_matrix parameters without an
+     *         installed matrix, or MEMORY_ALLOCATION_FAILED; out is
+     *         unspecified on error
+     */
+    static CLWEError try_deserialize(const uint8_t* data, size_t size, const CLWEParameters& params,
+                                     ColorPublicKey& out) noexcept;
+
+    /**
+     * @brief The bytes of serialize(), computed on first use and memoized
+     *
+     * The bytes and fingerprint() are built together once and kept with the
+     * key, shared by its copies, so a long-lived key serializes and hashes for
+     * free afterwards. Each call checks the memo against seed, public_data and
+     * params (one compare, no allocation) and rebuilds it if the key was
+     * modified since, so mutating the fields never returns stale bytes.
+     * Concurrent calls on an unmodified key are safe.
+     *
+     * @return const std::vector<uint8_t>& Valid until the key is modified or destroyed
+     * @throws std::invalid_argument If the key is malformed
+     */
+    const std::vector<uint8_t>& serialized() const;
+
+    /**
+     * @brief H(pk) = SHAKE-256 of serialized(), memoized with it
+     *
+     * The value ColorExpandedPrivateKey::public_key_hash embeds and
+     * PreparedKeyRegistry is keyed by.
+     *
+     * @return const std::array<uint8_t, 32>& Valid until the key is modified or destroyed
+     * @throws std::invalid_argument If the key is malformed
+     */
+    const std::array<uint8_t, 32>& fingerprint() const;
+
+private:
+    struct SerializedForm;
+    const SerializedForm& serialized_form() const;
+
+    // Read and published atomically: const calls on one key may race to build it
+    mutable std::shared_ptr<const SerializedForm> serialized_;
+    // Pool public_data returns to on destruction; null for keys not acquired from one
+    std::shared_ptr<BufferPoolState> pool_;
 };
 
 /**
  * @brief Private key structure for ColorKEM
  *
  * Contains the sensitive private key data needed for decapsulation:
- * - Serialized secret key polynomials (coefficients as colors)
+ * - Serialized secret key polynomials in NTT domain (s_hat), values as colors
  * - Cryptographic parameters
  *
  * @warning The private key must be kept secret and protected from unauthorized access.
@@ -72,11 +182,107 @@ struct ColorPrivateKey {
     CLWEParameters params;
 
     ColorPrivateKey() = default;
-    ColorPrivateKey(const std::vector<uint8_t>& sd, const CLWEParameters& p)
-        : secret_data(sd), params(p) {}
+    ColorPrivateKey(std::vector<uint8_t> sd, const CLWEParameters& p)
+        : secret_data(std::move(sd)), params(p) {}
 
     std::vector<uint8_t> serialize() const;
+    static ColorPrivateKey deserialize(const std::vector<uint8_t>& data);
     static ColorPrivateKey deserialize(const std::vector<uint8_t>& data, const CLWEParameters& params);
+
+    /** @brief Serialized size of a private key for the given parameters */
+    static size_t serialized_size(const CLWEParameters& params);
+
+    /**
+     * @brief Serialize into a caller-provided buffer
+     *
+     * @return size_t Number of bytes written
+     * @throws std::invalid_argument If the key is malformed or out_size is too small
+     */
+    size_t serialize(uint8_t* out, size_t out_size) const;
+    static ColorPrivateKey deserialize(const uint8_t* data, size_t size, const CLWEParameters& params);
+
+    /** @brief deserialize() without exceptions, as ColorPublicKey::try_deserialize() */
+    static CLWEError try_deserialize(const uint8_t* data, size_t size, const CLWEParameters& params,
+                                     ColorPrivateKey& out) noexcept;
+};
+
+/**
+ * @brief Seed-only private key
+ *
+ * Holds only the 32-byte seed d that keygen_derand(d) expanded, where a
+ * ColorPrivateKey holds every coefficient of s_hat (k * n * 4 bytes unless
+ * packed). ColorKEM::prepare_private_key() and expand_compact_private_key()
+ * regenerate s_hat from d in NTT domain, giving exactly the key
+ * keygen_derand(d) returned. Made by ColorKEM::keygen_compact(), or directly
+ * from a seed kept for keygen_derand() or derive_device_seed().
+ *
+ * Serialized as d alone; the parameters are supplied on deserialization, as
+ * for ColorPrivateKey.
+ *
+ * @warning d determines the whole key pair; protect and erase it as a ColorPrivateKey.
+ */
+struct ColorCompactPrivateKey {
+    static constexpr size_t BYTES = 32;  /**< Serialized size at every parameter set */
+
+    std::array<uint8_t, 32> seed{};
+    CLWEParameters params;
+
+    std::vector<uint8_t> serialize() const;
+
+    /** @throws std::invalid_argument If data is not exactly BYTES long */
+    static ColorCompactPrivateKey deserialize(const std::vector<uint8_t>& data, const CLWEParameters& params);
+    static ColorCompactPrivateKey deserialize(const uint8_t* data, size_t size, const CLWEParameters& params);
+};
+
+/**
+ * @brief Private key with the public key and its hash embedded
+ *
+ * The ColorKEM counterpart of the FIPS 203 decapsulation key: s_hat, the packed
+ * public key and H(pk) = SHAKE-256 of the serialized public key, 32 bytes.
+ * Built with ColorKEM::expand_private_key(); decapsulate(sk, ct) and
+ * decapsulate_key(sk, ct) then need no separate public key.
+ *
+ * Serialized as secret data || public key || H(pk). deserialize() recomputes
+ * the hash and rejects a key whose embedded public key does not match it.
+ *
+ * @warning Contains the private key; protect and erase it as a ColorPrivateKey.
+ */
+struct ColorExpandedPrivateKey {
+    std::vector<uint8_t> secret_data;          /**< Serialized s_hat, as ColorPrivateKey::secret_data */
+    ColorPublicKey public_key;                 /**< The matching public key */
+    std::array<uint8_t, 32> public_key_hash{}; /**< H(pk) */
+    CLWEParameters params;                     /**< Parameters of the key pair */
+
+    std::vector<uint8_t> serialize() const;
+
+    /**
+     * @brief Parse a serialized expanded private key
+     *
+     * @throws std::invalid_argument If the size is not serialized_size(params)
+     *         or the embedded hash does not match the embedded public key
+     */
+    static ColorExpandedPrivateKey deserialize(const std::vector<uint8_t>& data, const CLWEParameters& params);
+
+    /** @brief Serialized size: private key, public key and 32 hash bytes */
+    static size_t serialized_size(const CLWEParameters& params);
+
+    /**
+     * @brief Serialize into a caller-provided buffer
+     *
+     * @return size_t Number of bytes written
+     * @throws std::invalid_argument If the key is malformed or out_size is too small
+     */
+    size_t serialize(uint8_t* out, size_t out_size) const;
+    static ColorExpandedPrivateKey deserialize(const uint8_t* data, size_t size, const CLWEParameters& params);
+
+    /**
+     * @brief deserialize() without exceptions, as ColorPublicKey::try_deserialize()
+     *
+     * @return CLWEError SUCCESS, INVALID_KEY for a wrong size or a failed hash
+     *         check, or MEMORY_ALLOCATION_FAILED
+     */
+    static CLWEError try_deserialize(const uint8_t* data, size_t size, const CLWEParameters& params,
+                                     ColorExpandedPrivateKey& out) noexcept;
 };
 
 /**
@@ -95,11 +301,374 @@ struct ColorCiphertext {
     CLWEParameters params;
 
     ColorCiphertext() = default;
-    ColorCiphertext(const std::vector<uint8_t>& cd, const std::vector<uint8_t>& ssh, const CLWEParameters& p)
-        : ciphertext_data(cd), shared_secret_hint(ssh), params(p) {}
+    ColorCiphertext(std::vector<uint8_t> cd, std::vector<uint8_t> ssh, const CLWEParameters& p)
+        : ciphertext_data(std::move(cd)), shared_secret_hint(std::move(ssh)), params(p) {}
+    ColorCiphertext(const ColorCiphertext&) = default;
+    ColorCiphertext& operator=(const ColorCiphertext&) = default;
+    ColorCiphertext(ColorCiphertext&&) = default;
+    ColorCiphertext& operator=(ColorCiphertext&&) = default;
+    ~ColorCiphertext();
+
+    /**
+     * @brief Ciphertext whose buffers come from, and return to, a KemBufferPool
+     *
+     * Both buffers are sized for pool.params() and taken from the calling
+     * thread's free list when it has them; destroying the ciphertext puts
+     * them back. encapsulate_into() and try_encapsulate_key() write into it
+     * without reallocating, so a server can hand the result off and still
+     * encapsulate without allocating. See buffer_pool.hpp.
+     *
+     * @param pool Pool to take the buffers from; the ciphertext may outlive it
+     * @return ColorCiphertext Ciphertext with params = pool.params() and unspecified bytes
+     */
+    static ColorCiphertext acquire(KemBufferPool& pool);
 
     std::vector<uint8_t> serialize() const;
+
+    /**
+     * @brief Parse a serialized ciphertext
+     *
+     * The overload without parameters leaves params default-constructed (ML-KEM-512);
+     * pass the KEM parameters when decapsulating at other security levels.
+     */
+    static ColorCiphertext deserialize(const std::vector<uint8_t>& data);
     static ColorCiphertext deserialize(const std::vector<uint8_t>& data, const CLWEParameters& params);
+
+    /** @brief Serialized size of a ciphertext for the given parameters */
+    static size_t serialized_size(const CLWEParameters& params);
+
+    /**
+     * @brief Serialize into a caller-provided buffer
+     *
+     * @return size_t Number of bytes written
+     * @throws std::invalid_argument If the ciphertext is malformed or out_size is too small
+     */
+    size_t serialize(uint8_t* out, size_t out_size) const;
+    static ColorCiphertext deserialize(const uint8_t* data, size_t size, const CLWEParameters& params);
+
+    /**
+     * @brief deserialize() without exceptions, as ColorPublicKey::try_deserialize()
+     *
+     * @return CLWEError SUCCESS, INVALID_CIPHERTEXT as parse() would throw, or
+     *         MEMORY_ALLOCATION_FAILED
+     */
+    static CLWEError try_deserialize(const uint8_t* data, size_t size, const CLWEParameters& params,
+                                     ColorCiphertext& out) noexcept;
+
+private:
+    // Pool the buffers return to on destruction; null for ciphertexts not acquired from one
+    std::shared_ptr<BufferPoolState> pool_;
+};
+
+/**
+ * @brief Non-owning view of a ciphertext
+ *
+ * Points into memory owned by the caller (a ColorCiphertext or a received wire
+ * buffer) so decapsulation can run without copying the ciphertext bytes. The
+ * viewed memory must outlive the view.
+ */
+struct ColorCiphertextView {
+    const uint8_t* ciphertext_data = nullptr;     /**< Serialized polynomial data */
+    size_t ciphertext_size = 0;                   /**< Size of ciphertext_data in bytes */
+    const uint8_t* shared_secret_hint = nullptr;  /**< 4-byte shared secret hint */
+    CLWEParameters params;                        /**< Parameters the ciphertext is for */
+
+    ColorCiphertextView() = default;
+    explicit ColorCiphertextView(const ColorCiphertext& ciphertext);
+
+    /**
+     * @brief View a serialized ciphertext (ciphertext data followed by the 4-byte hint)
+     *
+     * @throws std::invalid_argument If size is not a multiple of 4 or below 8 bytes
+     */
+    static ColorCiphertextView parse(const uint8_t* data, size_t size, const CLWEParameters& params);
+
+    /**
+     * @brief parse() without exceptions
+     *
+     * @return CLWEError SUCCESS, or INVALID_CIPHERTEXT where parse() throws
+     */
+    static CLWEError try_parse(const uint8_t* data, size_t size, const CLWEParameters& params,
+                               ColorCiphertextView& out) noexcept;
+};
+
+/**
+ * @brief Non-owning view of a public key
+ *
+ * Points into memory owned by the caller (a ColorPublicKey or a KeyStore
+ * mapping) so encapsulation can read t_hat where it lies. The coefficient
+ * layout of public_data is given by encoding, which may differ from
+ * params.encoding: KeyStore records are always PACKED12. The viewed memory
+ * must outlive the view.
+ */
+struct ColorPublicKeyView {
+    const uint8_t* seed = nullptr;         /**< 32-byte matrix seed */
+    const uint8_t* public_data = nullptr;  /**< Serialized t_hat */
+    size_t public_data_size = 0;           /**< Size of public_data in bytes */
+    CoefficientEncoding encoding = CoefficientEncoding::COLOR32;  /**< Coefficient layout of public_data */
+    CLWEParameters params;                 /**< Parameters the key is for */
+
+    ColorPublicKeyView() = default;
+    explicit ColorPublicKeyView(const ColorPublicKey& public_key);
+};
+
+/**
+ * @brief 32-byte shared secret of the 256-bit encapsulation mode
+ *
+ * SHAKE256 of the encapsulated message and a hash of the ciphertext, derived
+ * inside the KEM so callers need no KDF of their own. A fixed-size value type:
+ * returned by value and never allocated.
+ */
+struct SharedSecret {
+    static constexpr size_t BYTES = 32;  /**< Secret size */
+
+    std::array<uint8_t, BYTES> bytes{};  /**< Secret key material */
+
+    const uint8_t* data() const { return bytes.data(); }
+    uint8_t* data() { return bytes.data(); }
+    static constexpr size_t size() { return BYTES; }
+
+    /** @brief Constant-time comparison */
+    bool operator==(const SharedSecret& other) const {
+        uint8_t difference = 0;
+        for (size_t i = 0; i < BYTES; ++i) {
+            difference |= static_cast<uint8_t>(bytes[i] ^ other.bytes[i]);
+        }
+        return difference == 0;
+    }
+    bool operator!=(const SharedSecret& other) const { return !(*this == other); }
+};
+
+/**
+ * @brief Public key with its matrix expanded and coefficients parsed
+ *
+ * Built once with ColorKEM::expand_public_key() and reusable for any number of
+ * encapsulations. The matrix A is kept in NTT domain, so repeat encapsulations
+ * skip the SHAKE128 seed expansion and the byte parsing of public_data. It is
+ * generated directly in transposed order, so A^T r reads it with unit stride.
+ * The FIPS 203 modulus check on t_hat is done once, while parsing, and recorded
+ * in coefficients_reduced; an expanded key assembled by hand without it is
+ * checked on every use.
+ */
+struct ExpandedPublicKey {
+    std::array<uint8_t, 32> seed;             /**< Matrix seed of the source key */
+    std::vector<uint8_t> public_data;         /**< Serialized t_hat of the source key */
+    CLWEParameters params;                    /**< Parameters of the source key */
+    std::shared_ptr<const PolyMatrix> matrix_A;       /**< Expanded A_hat, stored transposed (A_hat^T row-major) */
+    std::shared_ptr<const PolyVec> public_key_colors; /**< Parsed t_hat */
+    bool coefficients_reduced = false;        /**< t_hat passed the modulus check when parsed */
+};
+
+/**
+ * @brief Deployment-wide matrix A of CLWEParameters::shared_matrix parameter sets
+ *
+ * Installed once per parameter shape with ColorKEM::install_shared_matrix() and
+ * shared read-only by every thread and ColorKEM instance. A is expanded from
+ * the seed once, in NTT domain and in both orders, so key generation and
+ * encapsulation never run the seed expansion.
+ */
+struct SharedMatrix {
+    std::array<uint8_t, 32> seed;                     /**< Deployment seed A was expanded from */
+    std::shared_ptr<const PolyMatrix> matrix_A;       /**< A_hat, row-major, as key generation reads it */
+    std::shared_ptr<const PolyMatrix> matrix_A_trans; /**< A_hat^T, row-major, as encapsulation reads it */
+};
+
+/**
+ * @brief Private key parsed and validated once for repeated decapsulation
+ *
+ * Built with ColorKEM::prepare_private_key(). Holds s_hat already unpacked in NTT
+ * domain, so decapsulate(const PreparedPrivateKey&, const ColorCiphertext&) does
+ * no key parsing or validation. Copies share the same immutable coefficients.
+ *
+ * Under CLWEParameters::secret_weight the key also keeps s itself as (position,
+ * sign) slots, and decryption computes s^T c1 from them with constant-time
+ * add/subtract passes instead of k forward NTTs, k basemuls and an inverse NTT.
+ */
+struct PreparedPrivateKey {
+    CLWEParameters params;                            /**< Parameters of the source key */
+    std::shared_ptr<const PolyVec> secret_key_colors; /**< Parsed s_hat */
+    /** s as sparse slots under secret_weight; null otherwise, or when the key's s is not fixed-weight ternary */
+    std::shared_ptr<const SparseTernaryVec> sparse_secret;
+};
+
+/**
+ * @brief Message-independent half of one encapsulation, computed ahead of time
+ *
+ * Built by ColorKEM::precompute_encapsulation() for one public key. It holds
+ * everything an encapsulation computes before the message enters: the noise
+ * sampled from its seed, c1 = A^T r + e1 already packed, and c2 = t^T r + e2
+ * without the message, along with the shared secret it will carry.
+ * ColorKEM::encapsulate_online() finishes it into a ciphertext.
+ *
+ * A bundle is single use: reusing one would send two ciphertexts with the
+ * same r, so encapsulate_online() consumes it and refuses a spent one. It is
+ * move-only, and its secret and c2 are securely wiped when it is consumed or
+ * destroyed.
+ */
+class EncapsulationBundle {
+public:
+    /** @brief Empty bundle, not ready() */
+    EncapsulationBundle() = default;
+    /** @brief Securely erase the shared secret and c2 */
+    ~EncapsulationBundle();
+    /** @brief Take over other, leaving it not ready() */
+    EncapsulationBundle(EncapsulationBundle&& other) noexcept;
+    /** @brief Wipe this bundle and take over other, leaving it not ready() */
+    EncapsulationBundle& operator=(EncapsulationBundle&& other) noexcept;
+    EncapsulationBundle(const EncapsulationBundle&) = delete;             /**< Copy constructor disabled */
+    EncapsulationBundle& operator=(const EncapsulationBundle&) = delete;  /**< Copy assignment disabled */
+
+    /** @brief Whether the bundle can still be finished; false once consumed, empty or moved from */
+    bool ready() const { return ready_; }
+
+    /** @brief Parameters of the key the bundle was computed for */
+    const CLWEParameters& params() const { return params_; }
+
+private:
+    friend class ColorKEM;
+    void wipe();
+
+    CLWEParameters params_;
+    std::vector<uint8_t> ciphertext_data_;  // Whole ciphertext; c1 is written, c2 is not
+    std::vector<ColorValue> c2_;            // t^T r + e2 over the transmitted coefficients
+    ColorValue shared_secret_;
+    bool ready_ = false;
+};
+
+/**
+ * @brief Parallel-for hook used by ColorKEM::set_executor()
+ *
+ * Must run task(0) through task(count - 1), in any order and possibly
+ * concurrently, and return only once all of them have finished. ColorKEM may
+ * call it from several threads at once when one instance is shared.
+ */
+using KemExecutor = std::function<void(size_t count, const std::function<void(size_t)>& task)>;
+
+/**
+ * @brief Receiver of a ciphertext emitted by ColorKEM::encapsulate_streamed()
+ *
+ * Called with consecutive pieces of ColorCiphertext::serialize(); the bytes
+ * are only valid during the call. An exception thrown by the sink aborts the
+ * encapsulation and propagates to its caller.
+ */
+using CiphertextSink = std::function<void(const uint8_t* data, size_t size)>;
+
+/**
+ * @brief Reusable scratch memory for ColorKEM operations
+ *
+ * Holds every intermediate an operation needs: the matrix and noise
+ * polynomials, the parsed ciphertext, noise sampling requests and sampler
+ * buffers. They are carved from one bump-pointer arena when an operation
+ * starts, and every byte is securely zeroed when it ends, so no secret
+ * intermediate outlives the call. The arena is sized on first use and reused
+ * afterwards, so a worker that keeps one workspace pays no per-call allocation
+ * for intermediates. With a reused output ciphertext, encapsulate_into() and
+ * decapsulation with a PreparedPrivateKey perform no heap allocation at all.
+ *
+ * A workspace can serve any ColorKEM instance, but only one operation at a
+ * time; give each thread its own.
+ */
+class KemWorkspace {
+public:
+    /** @brief Create an empty workspace; buffers are allocated on first use */
+    KemWorkspace();
+    ~KemWorkspace();
+
+    KemWorkspace(KemWorkspace&&) noexcept;             /**< Move constructor */
+    KemWorkspace& operator=(KemWorkspace&&) noexcept;  /**< Move assignment */
+    KemWorkspace(const KemWorkspace&) = delete;             /**< Copy constructor disabled */
+    KemWorkspace& operator=(const KemWorkspace&) = delete;  /**< Copy assignment disabled */
+
+    /**
+     * @brief Bytes of scratch reserved so far
+     *
+     * Grows to the largest operation the workspace has served and is kept for
+     * reuse; streaming matrix A (ColorKEM::set_matrix_streaming) lowers it.
+     */
+    size_t reserved_bytes() const;
+
+    /**
+     * @brief Pages the scratch currently sits on
+     *
+     * Chosen from page_policy() each time the workspace grows; Heap before its
+     * first use.
+     */
+    PageBacking page_backing() const;
+
+    static constexpr size_t ARENA_ALIGNMENT = 64;                  /**< Alignment and granularity of every buffer */
+    static constexpr size_t NOISE_REQUEST_BYTES = 3 * sizeof(void*);  /**< One queued noise polynomial */
+    static constexpr size_t NOISE_SHAKE_RATE = 136;                /**< SHAKE-256 rate in bytes */
+    static constexpr size_t NOISE_CBD_BYTES = 48;                  /**< Stream bytes per 64 coefficients at eta = 3 */
+
+    /**
+     * @brief Scratch bytes one operation reserves
+     *
+     * Covers the polynomials (with room for all of A, or for one row of it
+     * when streaming), 2k + 1 noise requests and the noise sampler buffers.
+     * The implementation checks its own types against the constants above and
+     * carves exactly this many bytes.
+     *
+     * @param k Module rank
+     * @param n Ring degree
+     * @param with_matrix True when the operation materializes matrix A
+     * @return size_t Arena size in bytes
+     */
+    static constexpr size_t arena_bytes(uint32_t k, uint32_t n, bool with_matrix) {
+        const size_t poly = arena_block(n * sizeof(ColorValue));
+        const size_t vec = arena_block(static_cast<size_t>(k) * n * sizeof(ColorValue));
+        const size_t matrix = with_matrix ? arena_block(static_cast<size_t>(k) * k * n * sizeof(ColorValue)) : vec;
+        const size_t ciphertext = arena_block(static_cast<size_t>(k + 1) * n * sizeof(ColorValue));
+        const size_t noise_stream = 4 * ((n / 64 * NOISE_CBD_BYTES + NOISE_SHAKE_RATE - 1) / NOISE_SHAKE_RATE) *
+                                    NOISE_SHAKE_RATE;
+        return matrix + 7 * vec + 3 * poly + ciphertext + arena_block(n * sizeof(uint32_t)) +
+               arena_block(noise_stream) + arena_block((2 * static_cast<size_t>(k) + 1) * NOISE_REQUEST_BYTES);
+    }
+
+    /** @brief Opaque buffer set, defined by the implementation */
+    struct Buffers;
+
+private:
+    friend class ColorKEM;
+    std::unique_ptr<Buffers> buffers_;
+
+    static constexpr size_t arena_block(size_t bytes) { return (bytes + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1); }
+};
+
+/**
+ * @brief Heap one KEM operation takes, in bytes
+ *
+ * The workspace arena is reserved on a workspace's first use and reused by
+ * every later operation. Output is the key or ciphertext data returned to the
+ * caller. An encapsulation that misses the expanded-key cache also stores the
+ * key's A_hat, t_hat and public data there (expanded_key_bytes); the cache's
+ * list node and control blocks are not counted.
+ */
+struct KemOperationMemory {
+    size_t workspace_bytes = 0;     /**< KemWorkspace arena */
+    size_t output_bytes = 0;        /**< Returned key or ciphertext data */
+    size_t expanded_key_bytes = 0;  /**< Expanded-key cache entry, 0 when streaming A */
+
+    /** @brief Sum of all three */
+    constexpr size_t heap_bytes() const { return workspace_bytes + output_bytes + expanded_key_bytes; }
+};
+
+/**
+ * @brief Worst-case memory of each operation for one parameter set
+ *
+ * @see ColorKEM::memory_requirements
+ */
+struct KemMemoryRequirements {
+    KemOperationMemory keygen;       /**< keygen(), keygen_derand(), keygen_deterministic() */
+    KemOperationMemory encapsulate;  /**< encapsulate() and its seeded variants */
+    KemOperationMemory decapsulate;  /**< decapsulate() */
+    size_t stack_bytes = 0;          /**< Bound on the stack of any operation on the calling thread */
+
+    /** @brief Arena of one KemWorkspace that serves all three operations */
+    constexpr size_t workspace_bytes() const {
+        size_t bytes = keygen.workspace_bytes;
+        bytes = encapsulate.workspace_bytes > bytes ? encapsulate.workspace_bytes : bytes;
+        return decapsulate.workspace_bytes > bytes ? decapsulate.workspace_bytes : bytes;
+    }
 };
 
 /**
@@ -127,44 +696,149 @@ struct ColorCiphertext {
  * clwe::ColorValue recovered_ss = kem.decapsulate(pk, sk, ct);
  * @endcode
  *
- * @note All operations are thread-safe for read-only access.
+ * @note All operations are const and may be called concurrently on one instance.
+ *       Overloads taking a KemWorkspace use only that workspace for scratch; the
+ *       others use a per-thread workspace. The expanded-key cache is mutex-guarded.
  * @warning This class is not copyable due to internal state management.
  */
 class ColorKEM {
 private:
     CLWEParameters params_;
-    std::unique_ptr<ColorNTTEngine> color_ntt_engine_;
+    std::shared_ptr<const ColorNTTEngine> color_ntt_engine_;  /**< Shared per (q, n), see ColorNTTEngine::shared() */
+    uint32_t degree_inv_;  /**< n^(-1) mod q, undoes the scaling left by the inverse NTT */
+    uint64_t params_fingerprint_;  /**< params_.fingerprint(), checked against every key and ciphertext */
+    size_t polyvec_bytes_;         /**< Serialized size of k polynomials: private key data */
+    size_t public_key_bytes_;      /**< Serialized size of public key data: polyvec_bytes_, or less when t is rounded */
+    size_t ciphertext_bytes_;      /**< Serialized size of ciphertext data, without the hint */
+    BarrettReducer reducer_;       /**< params_.reducer(): division-free mod q for per-coefficient loops */
+
+    // True when params describe the same formats as this instance's
+    bool matches_parameters(const CLWEParameters& params) const { return params.fingerprint() == params_fingerprint_; }
 
     // Helper methods
-    std::vector<std::vector<ColorValue>> generate_matrix_A(const std::array<uint8_t, 32>& seed) const;
-    std::vector<ColorValue> generate_error_vector(uint32_t eta) const;
-    std::vector<ColorValue> generate_secret_key(uint32_t eta) const;
+    // A_hat, or with transposed A_hat^T in row order, as encapsulation consumes it
+    PolyMatrix generate_matrix_A(const std::array<uint8_t, 32>& seed, bool transposed = false) const;
+    void generate_matrix_A(const std::array<uint8_t, 32>& seed, PolyMatrix& matrix, bool transposed = false) const;
+    // Expand count <= 4 cells (i * k + j) of A into polys on the 4-way Keccak
+    void expand_matrix_cells(const std::array<uint8_t, 32>& seed, const uint32_t* cells,
+                             ColorValue* const* polys, uint32_t count) const;
+    // A_hat o vector (A_hat^T o vector when transpose) with A streamed from seed one row
+    // (column) at a time through line, which holds k polynomials
+    void matrix_vector_mul_streamed(const std::array<uint8_t, 32>& seed, const PolyVec& vector, bool transpose,
+                                    PolyVec& line, PolyVec& result) const;
+    // Row i of A (column i when transpose) into line, k polynomials
+    void expand_matrix_line(const std::array<uint8_t, 32>& seed, uint32_t i, bool transpose, PolyVec& line) const;
+    PolyVec sample_noise_vector(uint32_t eta, const std::array<uint8_t, 32>& seed) const;
+    PolyVec generate_secret_key(uint32_t eta) const;
+    PolyVec generate_error_vector(uint32_t eta) const;
     // Deterministic versions for KATs
-    std::vector<ColorValue> generate_error_vector_deterministic(uint32_t eta, const std::array<uint8_t, 32>& seed) const;
-    std::vector<ColorValue> generate_secret_key_deterministic(uint32_t eta, const std::array<uint8_t, 32>& seed) const;
-    std::vector<ColorValue> generate_public_key(const std::vector<ColorValue>& secret_key,
-                                               const std::vector<std::vector<ColorValue>>& matrix_A,
-                                               const std::vector<ColorValue>& error_vector) const;
-    std::vector<ColorValue> matrix_vector_mul(const std::vector<std::vector<ColorValue>>& matrix,
-                                             const std::vector<ColorValue>& vector) const;
-    std::vector<ColorValue> matrix_transpose_vector_mul(const std::vector<std::vector<ColorValue>>& matrix,
-                                                        const std::vector<ColorValue>& vector) const;
-    ColorValue decrypt_message(const std::vector<ColorValue>& secret_key,
-                              const std::vector<ColorValue>& ciphertext) const;
+    PolyVec generate_secret_key_deterministic(uint32_t eta, const std::array<uint8_t, 32>& seed) const;
+    PolyVec generate_error_vector_deterministic(uint32_t eta, const std::array<uint8_t, 32>& seed) const;
+    void generate_public_key(const PolyVec& secret_key,
+                             const PolyMatrix& matrix_A,
+                             const PolyVec& error_vector,
+                             PolyVec& public_key) const;
+    // public_key += error_vector, coefficient-wise mod q
+    void add_error_vector(const PolyVec& error_vector, PolyVec& public_key) const;
+    PolyVec encrypt_message(const PolyMatrix& matrix_A_trans,
+                            const PolyVec& public_key,
+                            const ColorValue& message) const;
+    PolyVec encrypt_message_deterministic(const PolyMatrix& matrix_A_trans,
+                                          const PolyVec& public_key,
+                                          const ColorValue& message,
+                                          const std::array<uint8_t, 32>& r_seed,
+                                          const std::array<uint8_t, 32>& e1_seed,
+                                          const std::array<uint8_t, 32>& e2_seed) const;
+    // matrix_A_trans (A_hat^T from generate_matrix_A(seed, true)), or when it is null, A
+    // streamed from *matrix_seed
+    void encrypt_message_into(const PolyMatrix* matrix_A_trans,
+                              const std::array<uint8_t, 32>* matrix_seed,
+                              const PolyVec& public_key,
+                              const ColorValue& message,
+                              const std::array<uint8_t, 32>& r_seed,
+                              const std::array<uint8_t, 32>& e1_seed,
+                              const std::array<uint8_t, 32>& e2_seed,
+                              KemWorkspace::Buffers& workspace) const;
+    // c1 and c2 = t^T r + e2 without any message, for the two encrypt_*_into() variants
+    void encrypt_noise_into(const PolyMatrix* matrix_A_trans,
+                            const std::array<uint8_t, 32>* matrix_seed,
+                            const PolyVec& public_key,
+                            const std::array<uint8_t, 32>& r_seed,
+                            const std::array<uint8_t, 32>& e1_seed,
+                            const std::array<uint8_t, 32>& e2_seed,
+                            KemWorkspace::Buffers& workspace) const;
+    // r_hat and A^T r, still in NTT domain, into workspace.A_trans_r; e1 and e2 as for encrypt_c1_into()
+    void encrypt_c1_ntt_into(const PolyMatrix* matrix_A_trans,
+                             const std::array<uint8_t, 32>* matrix_seed,
+                             const std::array<uint8_t, 32>& r_seed,
+                             const std::array<uint8_t, 32>& e1_seed,
+                             const std::array<uint8_t, 32>* e2_seed,
+                             KemWorkspace::Buffers& workspace) const;
+    // r_hat and e1 into the workspace, and e2 when e2_seed is non-null
+    void sample_encryption_noise(const std::array<uint8_t, 32>& r_seed,
+                                 const std::array<uint8_t, 32>& e1_seed,
+                                 const std::array<uint8_t, 32>* e2_seed,
+                                 KemWorkspace::Buffers& workspace) const;
+    // r_hat and c1 = A^T r + e1 into the workspace; e2 as well when e2_seed is non-null
+    void encrypt_c1_into(const PolyMatrix* matrix_A_trans,
+                         const std::array<uint8_t, 32>* matrix_seed,
+                         const std::array<uint8_t, 32>& r_seed,
+                         const std::array<uint8_t, 32>& e1_seed,
+                         const std::array<uint8_t, 32>* e2_seed,
+                         KemWorkspace::Buffers& workspace) const;
+    // c2 = t^T r + e2 from the r_hat and e2 encrypt_c1_into() left in the workspace
+    void encrypt_c2_into(const PolyVec& public_key, KemWorkspace::Buffers& workspace) const;
+    // c2[0] += message * q/2
+    void add_message(const ColorValue& message, PolyVec& ciphertext) const;
+    // Same as encrypt_message_into(), spreading the 256 message bits over c2[0..255] and
+    // writing the serialized c1 || c2 to ciphertext_data: each inverse NTT goes straight to
+    // poly_scale_add_encode(), so the ciphertext never exists as colors
+    void encrypt_key_message_into(const PolyMatrix* matrix_A_trans,
+                                  const std::array<uint8_t, 32>* matrix_seed,
+                                  const PolyVec& public_key,
+                                  const std::array<uint8_t, 32>& message,
+                                  const std::array<uint8_t, 32>& r_seed,
+                                  const std::array<uint8_t, 32>& e1_seed,
+                                  const std::array<uint8_t, 32>& e2_seed,
+                                  uint8_t* ciphertext_data,
+                                  KemWorkspace::Buffers& workspace) const;
+    ColorValue decrypt_message(const PolyVec& secret_key,
+                              const PolyVec& ciphertext,
+                              bool& padding_valid) const;
+    ColorValue decrypt_message_into(const PolyVec& secret_key,
+                                    const PolyVec& ciphertext,
+                                    PolyVec& c1_hat,
+                                    Poly& s_dot_c1_poly,
+                                    bool& padding_valid) const;
+    // Reads the 256 message bits back from c2[0..255]
+    void decrypt_key_message_into(const PolyVec& secret_key,
+                                  const PolyVec& ciphertext,
+                                  PolyVec& c1_hat,
+                                  Poly& s_dot_c1_poly,
+                                  std::array<uint8_t, 32>& message) const;
+    // s^T c1 into s_dot_c1_poly (only its constant term for a sparse c2)
+    void decrypt_inner_product(const PolyVec& secret_key,
+                               const PolyVec& ciphertext,
+                               PolyVec& c1_hat,
+                               Poly& s_dot_c1_poly) const;
+
+    // NTT-domain arithmetic: A, s and t are kept as A_hat, s_hat and t_hat
+    PolyVec matrix_vector_mul(const PolyMatrix& matrix, const PolyVec& vector) const;
+    void matrix_vector_mul(const PolyMatrix& matrix, const PolyVec& vector, PolyVec& result) const;
+    PolyVec matrix_transpose_vector_mul(const PolyMatrix& matrix, const PolyVec& vector) const;
+    void matrix_transpose_vector_mul(const PolyMatrix& matrix, const PolyVec& vector, PolyVec& result) const;
+    PolyVec ntt_forward_vector(const PolyVec& vector) const;
+    // Inverse NTT including the n^(-1) scaling
+    void ntt_inverse_poly(ColorValue* poly) const;
+    void ntt_inverse_vector(PolyVec& vector) const;
+    Poly inner_product_ntt(const PolyVec& a_hat, const PolyVec& b_hat) const;
+    uint32_t constant_term_ntt(const PolyVec& a_hat, const PolyVec& b_hat) const;
+
+    CPUFeatures cpu_features_;  /**< CPU capabilities kernels dispatch on, after any forced backend */
+
     ColorValue generate_shared_secret() const;
     std::vector<uint8_t> encode_color_secret(const ColorValue& secret) const;
     ColorValue decode_color_secret(const std::vector<uint8_t>& encoded) const;
-    std::vector<uint8_t> color_secret_to_bytes(const ColorValue& secret);
-    ColorValue bytes_to_color_secret(const std::vector<uint8_t>& bytes);
-    std::vector<ColorValue> encrypt_message(const std::vector<std::vector<ColorValue>>& matrix_A,
-                                           const std::vector<ColorValue>& public_key,
-                                           const ColorValue& message) const;
-    std::vector<ColorValue> encrypt_message_deterministic(const std::vector<std::vector<ColorValue>>& matrix_A,
-                                                         const std::vector<ColorValue>& public_key,
-                                                         const ColorValue& message,
-                                                         const std::array<uint8_t, 32>& r_seed,
-                                                         const std::array<uint8_t, 32>& e1_seed,
-                                                         const std::array<uint8_t, 32>& e2_seed) const;
 
 public:
     /**
@@ -177,11 +851,44 @@ public:
      *
      * @throws std::invalid_argument If parameters are invalid
      * @throws std::runtime_error If NTT engine initialization fails
+     * @throws std::logic_error If params.shared_matrix is set and no matrix
+     *         is installed for the parameter shape (install_shared_matrix())
      *
      * @note Parameter validation is performed during construction.
      * @see CLWEParameters for parameter details
      */
-    ColorKEM(const CLWEParameters& params);
+    ColorKEM(const CLWEParameters& params = CLWEParameters());
+
+    /**
+     * @brief Install the deployment-wide matrix A for shared_matrix parameter sets
+     *
+     * Expands A from seed once, in NTT domain, and registers it for every
+     * parameter set with the same module rank, degree, modulus and XOF. ColorKEM
+     * instances built afterwards with CLWEParameters::shared_matrix use it for
+     * key generation and encapsulation, which then skip the seed expansion, and
+     * their public keys carry t_hat only. Call it once at startup, before
+     * building such instances; the matrix is shared read-only across threads.
+     *
+     * @param params Parameter set; shared_matrix may be either value
+     * @param seed Deployment seed, the same on every party
+     * @return std::shared_ptr<const SharedMatrix> The installed matrix
+     *
+     * @throws std::invalid_argument If parameters are invalid
+     * @throws std::logic_error If a matrix from a different seed is already
+     *         installed for the parameter shape (installing the same seed again
+     *         returns the existing matrix)
+     *
+     * @note Thread-safe.
+     */
+    static std::shared_ptr<const SharedMatrix> install_shared_matrix(const CLWEParameters& params,
+                                                                     const std::array<uint8_t, 32>& seed);
+
+    /**
+     * @brief The matrix installed for the parameter shape of params, or nullptr
+     *
+     * @note Thread-safe.
+     */
+    static std::shared_ptr<const SharedMatrix> find_shared_matrix(const CLWEParameters& params);
 
     /**
      * @brief Destroy the ColorKEM instance
@@ -212,7 +919,7 @@ public:
      * @note This operation requires cryptographically secure random number generation.
      * @warning Key generation is computationally intensive and may take several milliseconds.
      */
-    std::pair<ColorPublicKey, ColorPrivateKey> keygen();
+    std::pair<ColorPublicKey, ColorPrivateKey> keygen() const;
 
     /**
      * @brief Encapsulate a shared secret
@@ -235,7 +942,7 @@ public:
      * @note The shared secret is a single ColorValue representing the encapsulated key.
      * @see decapsulate() for the corresponding decapsulation operation
      */
-    std::pair<ColorCiphertext, ColorValue> encapsulate(const ColorPublicKey& public_key);
+    std::pair<ColorCiphertext, ColorValue> encapsulate(const ColorPublicKey& public_key) const;
 
     /**
      * @brief Decapsulate a shared secret
@@ -262,7 +969,7 @@ public:
      */
     ColorValue decapsulate(const ColorPublicKey& public_key,
                            const ColorPrivateKey& private_key,
-                           const ColorCiphertext& ciphertext);
+                           const ColorCiphertext& ciphertext) const;
 
     // Key verification
     bool verify_keypair(const ColorPublicKey& public_key, const ColorPrivateKey& private_key) const;
@@ -270,17 +977,956 @@ public:
     // Deterministic key generation (for KATs)
     std::pair<ColorPublicKey, ColorPrivateKey> keygen_deterministic(const std::array<uint8_t, 32>& matrix_seed,
                                                                    const std::array<uint8_t, 32>& secret_seed,
-                                                                   const std::array<uint8_t, 32>& error_seed);
+                                                                   const std::array<uint8_t, 32>& error_seed) const;
 
     // Deterministic encapsulation (for KATs)
     std::pair<ColorCiphertext, ColorValue> encapsulate_deterministic(const ColorPublicKey& public_key,
                                                                     const std::array<uint8_t, 32>& r_seed,
                                                                     const std::array<uint8_t, 32>& e1_seed,
                                                                     const std::array<uint8_t, 32>& e2_seed,
-                                                                    const ColorValue& shared_secret);
+                                                                    const ColorValue& shared_secret) const;
 
-    // Getters
-    const CLWEParameters& params() const { return params_; }
+    /**
+     * @brief Derandomized key generation
+     *
+     * Expands d with SHAKE-256 under a key-generation domain byte into the
+     * matrix, secret and error seeds. keygen() draws d and calls this, so the
+     * RNG is read once per key pair.
+     *
+     * @param d 32-byte key generation seed
+     * @return std::pair<ColorPublicKey, ColorPrivateKey> The key pair determined by d
+     */
+    std::pair<ColorPublicKey, ColorPrivateKey> keygen_derand(const std::array<uint8_t, 32>& d) const;
+
+    /**
+     * @brief Derandomized encapsulation
+     *
+     * Expands m with SHAKE-256 under an encapsulation domain byte into the
+     * shared secret and the r, e1 and e2 seeds. encapsulate() draws m and
+     * calls this.
+     *
+     * @param public_key Recipient's public key
+     * @param m 32-byte encapsulation seed
+     * @return std::pair<ColorCiphertext, ColorValue> Ciphertext and shared secret determined by m
+     *
+     * @throws std::invalid_argument If the public key is invalid (as encapsulate())
+     */
+    std::pair<ColorCiphertext, ColorValue> encapsulate_derand(const ColorPublicKey& public_key,
+                                                              const std::array<uint8_t, 32>& m) const;
+
+    /**
+     * @brief Generate several key pairs
+     *
+     * Draws the entropy for all key pairs in one call and derives each pair
+     * with keygen_derand().
+     *
+     * @param count Number of key pairs to generate
+     * @return std::vector<std::pair<ColorPublicKey, ColorPrivateKey>> The key pairs, in order
+     */
+    std::vector<std::pair<ColorPublicKey, ColorPrivateKey>> keygen_batch(size_t count) const;
+
+    /**
+     * @brief keygen_derand() seed of one device, derived from a provisioning master secret
+     *
+     * SHAKE-256 of a device domain byte (0x44), the 8-byte parameter
+     * fingerprint, master_seed and device_id, both integers little-endian,
+     * truncated to 32 bytes. Distinct devices and parameter sets get
+     * independent seeds; the same inputs always give the same seed.
+     *
+     * @param master_seed 32-byte provisioning master secret
+     * @param device_id Device number
+     * @return std::array<uint8_t, 32> The device's keygen_derand() seed
+     */
+    std::array<uint8_t, 32> derive_device_seed(const std::array<uint8_t, 32>& master_seed, uint64_t device_id) const;
+
+    /**
+     * @brief Deterministic key pair of one device
+     *
+     * keygen_derand(derive_device_seed(master_seed, device_id)), so a device's
+     * keys can be re-derived from the master secret at any time.
+     */
+    std::pair<ColorPublicKey, ColorPrivateKey> derive_keypair(const std::array<uint8_t, 32>& master_seed,
+                                                              uint64_t device_id) const;
+
+    /**
+     * @brief derive_keypair() for a range of devices
+     *
+     * Derives the device seeds four at a time on the multi-lane Keccak
+     * backend, then generates the keys as keygen_batch() does, on the batch
+     * device when one is set. Entry i equals derive_keypair(master_seed,
+     * first_device_id + i).
+     *
+     * @param master_seed 32-byte provisioning master secret
+     * @param first_device_id Device number of the first pair
+     * @param count Number of devices
+     * @return std::vector<std::pair<ColorPublicKey, ColorPrivateKey>> The key pairs, in device order
+     *
+     * @throws std::invalid_argument If first_device_id + count - 1 overflows 64 bits
+     */
+    std::vector<std::pair<ColorPublicKey, ColorPrivateKey>> derive_keypair_batch(
+        const std::array<uint8_t, 32>& master_seed, uint64_t first_device_id, size_t count) const;
+
+    /**
+     * @brief Encapsulate to several public keys
+     *
+     * Each result equals encapsulate_derand() with the seed drawn for that
+     * request. Consecutive requests to the same public key reuse its expanded matrix
+     * and parsed coefficients instead of rebuilding them. A batch of at least
+     * eight requests to mostly different keys instead runs eight requests at a
+     * time in lockstep, one per SIMD lane (parameter sets the GPU kernels cover,
+     * see set_batch_device()).
+     *
+     * @param public_keys Recipients' public keys
+     * @return std::vector<std::pair<ColorCiphertext, ColorValue>> Ciphertext and shared secret per key
+     *
+     * @throws std::invalid_argument If any public key is invalid (as encapsulate())
+     */
+    std::vector<std::pair<ColorCiphertext, ColorValue>> encapsulate_batch(const std::vector<ColorPublicKey>& public_keys) const;
+
+    /**
+     * @brief Encapsulate one shared secret to several recipients
+     *
+     * Every ciphertext decapsulates to the returned secret under its recipient's
+     * private key. Recipients whose public keys share a matrix seed (a
+     * deployment-wide A) also share r, so A is expanded and c1 = A^T r + e1 is
+     * computed once per seed; each of them then costs only t_i^T r with its
+     * own e2. Seeds, and therefore groups, may appear in any order.
+     *
+     * @param public_keys Recipients' public keys
+     * @return std::pair<std::vector<ColorCiphertext>, ColorValue> One ciphertext per key, in order, and the secret
+     *
+     * @throws std::invalid_argument If public_keys is empty or any key is invalid (as encapsulate())
+     */
+    std::pair<std::vector<ColorCiphertext>, ColorValue> encapsulate_multi(
+        const std::vector<ColorPublicKey>& public_keys) const;
+
+    /**
+     * @brief Deterministic encapsulate_multi() from the 32-byte seed m
+     *
+     * @throws std::invalid_argument As encapsulate_multi()
+     */
+    std::pair<std::vector<ColorCiphertext>, ColorValue> encapsulate_multi_derand(
+        const std::vector<ColorPublicKey>& public_keys, const std::array<uint8_t, 32>& m) const;
+    std::pair<std::vector<ColorCiphertext>, ColorValue> encapsulate_multi_derand(
+        const std::vector<ColorPublicKey>& public_keys, const std::array<uint8_t, 32>& m,
+        KemWorkspace& workspace) const;
+
+    /**
+     * @brief Decapsulate several ciphertexts
+     *
+     * Element i equals decapsulate(public_keys[i], private_keys[i], ciphertexts[i]).
+     * Consecutive entries with the same private key reuse its parsed secret polynomials.
+     *
+     * @param public_keys Public keys, one per ciphertext
+     * @param private_keys Private keys, one per ciphertext
+     * @param ciphertexts Ciphertexts to decapsulate
+     * @return std::vector<ColorValue> The recovered shared secrets, in order
+     *
+     * @throws std::invalid_argument If the three inputs differ in length or any entry is invalid
+     */
+    std::vector<ColorValue> decapsulate_batch(const std::vector<ColorPublicKey>& public_keys,
+                                              const std::vector<ColorPrivateKey>& private_keys,
+                                              const std::vector<ColorCiphertext>& ciphertexts) const;
+
+    /** @brief Default number of expanded public keys kept by the encapsulation cache */
+    static constexpr size_t DEFAULT_EXPANDED_KEY_CACHE_CAPACITY = 16;
+
+    /**
+     * @brief Validate a public key and expand it for repeated encapsulation
+     *
+     * @param public_key The recipient's public key
+     * @return ExpandedPublicKey The key with matrix A_hat expanded and t_hat parsed
+     *
+     * @throws std::invalid_argument If public key parameters or data size are invalid
+     */
+    ExpandedPublicKey expand_public_key(const ColorPublicKey& public_key) const;
+
+    /**
+     * @brief Encapsulate to a pre-expanded public key
+     *
+     * Same result distribution as encapsulate(const ColorPublicKey&), without any
+     * seed expansion or parsing.
+     *
+     * @param public_key Key returned by expand_public_key() on this instance
+     * @return std::pair<ColorCiphertext, ColorValue> Ciphertext and encapsulated shared secret
+     *
+     * @throws std::invalid_argument If the key was expanded for different parameters
+     */
+    std::pair<ColorCiphertext, ColorValue> encapsulate(const ExpandedPublicKey& public_key) const;
+
+    /**
+     * @brief Encapsulate to a public key read in place
+     *
+     * Same result distribution as encapsulate(const ColorPublicKey&). t_hat is
+     * decoded from the viewed memory straight into the workspace, and A is
+     * expanded there from the seed, so the key is never copied or cached. This
+     * suits large key sets served from a KeyStore, where the expanded-key cache
+     * would rarely hit.
+     *
+     * @param public_key View of the recipient's public key
+     * @return std::pair<ColorCiphertext, ColorValue> Ciphertext and encapsulated shared secret
+     *
+     * @throws std::invalid_argument If the view is empty, its parameters differ from
+     *         this instance's or its data size does not match its encoding
+     */
+    std::pair<ColorCiphertext, ColorValue> encapsulate(const ColorPublicKeyView& public_key) const;
+
+    /**
+     * @brief Bound the LRU cache used by encapsulate(const ColorPublicKey&)
+     *
+     * Encapsulations keep the most recently used expanded keys, matched by seed and
+     * public data. A capacity of 0 disables caching.
+     *
+     * @param capacity Maximum number of cached keys
+     */
+    void set_expanded_key_cache_capacity(size_t capacity);
+
+    /** @brief Number of expanded public keys currently cached */
+    size_t expanded_key_cache_size() const;
+
+    /** @brief Smallest module rank that uses the executor by default (ML-KEM-768) */
+    static constexpr uint32_t DEFAULT_PARALLEL_MIN_RANK = 3;
+
+    /**
+     * @brief Spread the matrix work of each operation over an executor
+     *
+     * Expansion of the matrix A (four cells per task, on the 4-way Keccak) and
+     * the matrix-vector products (one output row per task) are handed to the
+     * executor. Results are identical to serial execution. Smaller parameter
+     * sets stay serial, since the dispatch overhead would exceed the work.
+     *
+     * @param executor Parallel-for callable; an empty one restores serial execution
+     * @param min_rank Smallest module rank at which the executor is used
+     *
+     * @note Not synchronized with running operations; configure the instance
+     *       before sharing it between threads.
+     */
+    void set_executor(KemExecutor executor, uint32_t min_rank = DEFAULT_PARALLEL_MIN_RANK);
+
+    /**
+     * @brief Stream matrix A instead of materializing it
+     *
+     * Key generation and encapsulation to a ColorPublicKey then expand one row
+     * of A (one column for A^T) from the seed at a time and fold it into the
+     * product straight away, so at most k polynomials of A (4 KB at ML-KEM-1024)
+     * exist instead of k^2 (16 KB). Encapsulation also bypasses the
+     * expanded-key cache, which would hold a full A per key. Results are
+     * byte-identical to the materialized path.
+     *
+     * The streamed rows reuse one buffer, so they run in order and do not use
+     * the executor. Encapsulation to an ExpandedPublicKey keeps using its
+     * precomputed A. Instances with CLWEParameters::shared_matrix never expand
+     * A, so for them this setting is ignored and matrix_streaming() is false.
+     *
+     * @param enabled True to stream A, false (the default) to materialize it
+     *
+     * @note Not synchronized with running operations; configure the instance
+     *       before sharing it between threads.
+     */
+    void set_matrix_streaming(bool enabled);
+
+    /** @brief Whether matrix A is streamed, see set_matrix_streaming() */
+    bool matrix_streaming() const { return matrix_streaming_; }
+
+    /**
+     * @brief Choose where the instance draws its randomness
+     *
+     * Every seed the instance draws (key generation, encapsulation and the
+     * batch calls) comes from source. The default, default_random_source(), is
+     * the per-thread ChaCha20 DRBG. A DeterministicRandomSource makes
+     * benchmarks and fuzzing independent of OS entropy and makes their keys
+     * reproducible, so it must never be used for real keys.
+     *
+     * @param source Source to use; nullptr restores default_random_source()
+     *
+     * @note Not synchronized with running operations; configure the instance
+     *       before sharing it between threads.
+     */
+    void set_random_source(std::shared_ptr<RandomSource> source);
+
+    /** @brief The source in use, see set_random_source() */
+    const std::shared_ptr<RandomSource>& random_source() const { return random_source_; }
+
+    /**
+     * @brief Run the batch calls on a GPU
+     *
+     * keygen_batch() and encapsulate_batch() then hand their lattice
+     * arithmetic for all instances to device, config.instances_per_launch
+     * instances per kernel launch over config.streams streams. Seeds are still
+     * drawn from the random source and derived on the host, so results are
+     * byte-identical to the CPU path. Parameter sets the kernels do not cover
+     * (noise other than CBD with eta 2 or 3) stay on the CPU.
+     *
+     * @param device BatchDevice::Cpu (the default) or BatchDevice::Cuda
+     * @param config Launch geometry for BatchDevice::Cuda
+     *
+     * @throws std::invalid_argument If device is not available (see
+     *         batch_device_available()) or config has a zero launch size or
+     *         stream count
+     *
+     * @note Not synchronized with running operations; configure the instance
+     *       before sharing it between threads.
+     */
+    void set_batch_device(BatchDevice device, const GpuBatchConfig& config = GpuBatchConfig());
+
+    /** @brief Where the batch calls run, see set_batch_device() */
+    BatchDevice batch_device() const { return batch_device_; }
+
+    /**
+     * @brief Stack bound of keygen, encapsulation and decapsulation
+     *
+     * Polynomials live in the workspace, so the stack only holds sampler
+     * states and seeds and does not grow with the security level.
+     */
+    static constexpr size_t MAX_STACK_BYTES = 32 * 1024;
+
+    /**
+     * @brief Exact memory of each operation, at compile time
+     *
+     * @param k Module rank
+     * @param n Ring degree
+     * @param public_data_bytes Size of ColorPublicKey::public_data
+     * @param secret_data_bytes Size of ColorPrivateKey::secret_data
+     * @param ciphertext_data_bytes Size of ColorCiphertext::ciphertext_data
+     * @param matrix_streaming Whether A is streamed, see set_matrix_streaming()
+     * @return KemMemoryRequirements Heap per operation and the stack bound
+     *
+     * @see ColorKEMLevel::memory_requirements for the fixed ML-KEM levels
+     */
+    static constexpr KemMemoryRequirements memory_requirements(uint32_t k, uint32_t n, size_t public_data_bytes,
+                                                               size_t secret_data_bytes, size_t ciphertext_data_bytes,
+                                                               bool matrix_streaming = false) {
+        KemMemoryRequirements requirements;
+        requirements.keygen.workspace_bytes = KemWorkspace::arena_bytes(k, n, !matrix_streaming);
+        requirements.keygen.output_bytes = public_data_bytes + secret_data_bytes;
+        requirements.encapsulate.workspace_bytes = KemWorkspace::arena_bytes(k, n, false);
+        requirements.encapsulate.output_bytes = ciphertext_data_bytes + 4;
+        requirements.encapsulate.expanded_key_bytes =
+            matrix_streaming ? 0 : (static_cast<size_t>(k) * k + k) * n * sizeof(ColorValue) + public_data_bytes;
+        requirements.decapsulate.workspace_bytes = KemWorkspace::arena_bytes(k, n, false);
+        requirements.stack_bytes = MAX_STACK_BYTES;
+        return requirements;
+    }
+
+    /**
+     * @brief Exact memory of each operation for a parameter set
+     *
+     * Output sizes follow the parameters' wire encoding and compression.
+     *
+     * @param params Parameter set
+     * @param matrix_streaming Whether A is streamed, see set_matrix_streaming()
+     * @return KemMemoryRequirements Heap per operation and the stack bound
+     */
+    static KemMemoryRequirements memory_requirements(const CLWEParameters& params, bool matrix_streaming = false);
+
+    /** @brief memory_requirements() for this instance's parameters and streaming setting */
+    KemMemoryRequirements memory_requirements() const { return memory_requirements(params_, matrix_streaming_); }
+
+    /**
+     * @brief Backend the NTT and basemul kernels of this instance run on
+     *
+     * Chosen from CPUFeatureDetector::cached(), so it reflects
+     * CLWE_FORCE_BACKEND and CPUFeatureDetector::force_backend(), unless
+     * set_ntt_backend() (autotune.hpp) selected another before this instance
+     * was constructed. Useful for tagging measurements in A/B tests.
+     *
+     * @return SIMDSupport The dispatched backend; NONE for the portable code
+     */
+    SIMDSupport backend() const;
+
+    /**
+     * @brief Validate and parse a private key once for repeated decapsulation
+     *
+     * @param private_key The private key to prepare
+     * @return PreparedPrivateKey The key with s_hat unpacked
+     *
+     * @throws std::invalid_argument If private key parameters or data size are invalid
+     */
+    PreparedPrivateKey prepare_private_key(const ColorPrivateKey& private_key) const;
+
+    /**
+     * @brief Generate a key pair whose private key is stored as its seed
+     *
+     * Draws d from the random source and returns keygen_derand(d)'s public key
+     * with d as a ColorCompactPrivateKey: 32 bytes of private storage instead
+     * of ColorPrivateKey::serialized_size().
+     *
+     * @return std::pair<ColorPublicKey, ColorCompactPrivateKey> The public key and the seed
+     */
+    std::pair<ColorPublicKey, ColorCompactPrivateKey> keygen_compact() const;
+
+    /**
+     * @brief Regenerate the full private key from a seed-only one
+     *
+     * Re-derives the secret seed from d and samples s_hat as keygen does, in
+     * one batched CBD pass over the multi-lane Keccak with the NTT applied as
+     * each polynomial leaves the sampler. Costs the noise half of a keygen,
+     * without the matrix or the public key product.
+     *
+     * @param private_key Seed-only key for this instance's parameters
+     * @return ColorPrivateKey The private key keygen_derand(d) returned
+     *
+     * @throws std::invalid_argument If the key belongs to other parameters
+     */
+    ColorPrivateKey expand_compact_private_key(const ColorCompactPrivateKey& private_key) const;
+
+    /**
+     * @brief Regenerate a seed-only private key straight into a prepared key
+     *
+     * As expand_compact_private_key() followed by prepare_private_key(), but
+     * s_hat is sampled into the prepared key without being packed and parsed.
+     *
+     * @throws std::invalid_argument If the key belongs to other parameters
+     */
+    PreparedPrivateKey prepare_private_key(const ColorCompactPrivateKey& private_key) const;
+
+    /**
+     * @brief Decapsulate with a prepared private key
+     *
+     * Returns the same value as decapsulate(pk, sk, ct) for the key it was prepared
+     * from. Ciphertext parsing and decryption run in reused per-thread buffers, so
+     * the accepting path performs no heap allocation once warmed up.
+     *
+     * @param private_key Key returned by prepare_private_key() on this instance
+     * @param ciphertext The ciphertext to decapsulate
+     * @return ColorValue The recovered shared secret, or the rejection value
+     *
+     * @throws std::invalid_argument If the key or ciphertext belong to other parameters
+     * @throws std::invalid_argument If ciphertext data is malformed
+     */
+    ColorValue decapsulate(const PreparedPrivateKey& private_key, const ColorCiphertext& ciphertext) const;
+
+    /**
+     * @brief Decapsulate a ciphertext view, e.g. one parsed in place from a receive buffer
+     *
+     * @throws std::invalid_argument If the key or ciphertext belong to other parameters
+     * @throws std::invalid_argument If the viewed data has the wrong size
+     */
+    ColorValue decapsulate(const PreparedPrivateKey& private_key, const ColorCiphertextView& ciphertext) const;
+
+    /**
+     * @brief Bundle a key pair into an expanded private key
+     *
+     * Validates both keys once and computes H(pk), so later decapsulations take
+     * only the private key and check nothing but its parameters and sizes.
+     *
+     * @param public_key The public key generated with private_key
+     * @param private_key The private key
+     * @return ColorExpandedPrivateKey private_key with public_key and H(pk) embedded
+     *
+     * @throws std::invalid_argument If either key belongs to other parameters or is malformed
+     */
+    ColorExpandedPrivateKey expand_private_key(const ColorPublicKey& public_key,
+                                               const ColorPrivateKey& private_key) const;
+
+    /**
+     * @brief Decapsulate with an expanded private key
+     *
+     * Same result as decapsulate(public_key, private_key, ciphertext) for the
+     * keys it was expanded from.
+     *
+     * @throws std::invalid_argument If the key or ciphertext belong to other parameters
+     *         or are malformed
+     */
+    ColorValue decapsulate(const ColorExpandedPrivateKey& private_key, const ColorCiphertext& ciphertext) const;
+    ColorValue decapsulate(const ColorExpandedPrivateKey& private_key, const ColorCiphertext& ciphertext,
+                           KemWorkspace& workspace) const;
+
+    /**
+     * @brief Generate a key pair using caller-provided scratch
+     * @param workspace Scratch for the operation, reused across calls
+     * @return std::pair<ColorPublicKey, ColorPrivateKey> Public and private key pair
+     */
+    std::pair<ColorPublicKey, ColorPrivateKey> keygen(KemWorkspace& workspace) const;
+
+    /**
+     * @brief keygen_derand() using caller-provided scratch
+     * @param d 32-byte key generation seed
+     * @param workspace Scratch for the operation, reused across calls
+     * @return std::pair<ColorPublicKey, ColorPrivateKey> The key pair determined by d
+     */
+    std::pair<ColorPublicKey, ColorPrivateKey> keygen_derand(const std::array<uint8_t, 32>& d,
+                                                             KemWorkspace& workspace) const;
+
+    /**
+     * @brief encapsulate() using caller-provided scratch
+     * @param public_key The recipient's public key
+     * @param workspace Scratch for the operation, reused across calls
+     * @return std::pair<ColorCiphertext, ColorValue> Ciphertext and encapsulated shared secret
+     *
+     * @throws std::invalid_argument If the public key is invalid (as encapsulate())
+     */
+    std::pair<ColorCiphertext, ColorValue> encapsulate(const ColorPublicKey& public_key, KemWorkspace& workspace) const;
+
+    /**
+     * @brief encapsulate_derand() using caller-provided scratch
+     * @param public_key Recipient's public key
+     * @param m 32-byte encapsulation seed
+     * @param workspace Scratch for the operation, reused across calls
+     * @return std::pair<ColorCiphertext, ColorValue> Ciphertext and shared secret determined by m
+     *
+     * @throws std::invalid_argument If the public key is invalid (as encapsulate())
+     */
+    std::pair<ColorCiphertext, ColorValue> encapsulate_derand(const ColorPublicKey& public_key,
+                                                              const std::array<uint8_t, 32>& m,
+                                                              KemWorkspace& workspace) const;
+
+    /**
+     * @brief Allocation-free encapsulation to a pre-expanded public key
+     *
+     * Produces the same ciphertext and shared secret as encapsulate_derand() with
+     * seed m, written into an existing ciphertext. Once the workspace is warm and
+     * the ciphertext has held one result, the call allocates nothing.
+     *
+     * @param public_key Key returned by expand_public_key() on this instance
+     * @param m 32-byte encapsulation seed
+     * @param ciphertext Output ciphertext; its buffers are resized and overwritten
+     * @param workspace Scratch for the operation, reused across calls
+     * @return ColorValue The shared secret determined by m
+     *
+     * @throws std::invalid_argument If the key was expanded for different parameters
+     */
+    ColorValue encapsulate_into(const ExpandedPublicKey& public_key,
+                                const std::array<uint8_t, 32>& m,
+                                ColorCiphertext& ciphertext,
+                                KemWorkspace& workspace) const;
+
+    /**
+     * @brief Allocation-free encapsulation to a viewed public key
+     *
+     * As encapsulate_into(const ExpandedPublicKey&, ...), reading the key as
+     * encapsulate(const ColorPublicKeyView&) does.
+     *
+     * @throws std::invalid_argument If the view is invalid (as encapsulate())
+     */
+    ColorValue encapsulate_into(const ColorPublicKeyView& public_key,
+                                const std::array<uint8_t, 32>& m,
+                                ColorCiphertext& ciphertext,
+                                KemWorkspace& workspace) const;
+
+    /**
+     * @brief Encapsulation that emits the ciphertext while it is computed
+     *
+     * Draws m as encapsulate() does and hands the serialized ciphertext to
+     * sink in k + 2 pieces: each c1 polynomial as soon as its row of A^T r is
+     * finished, then c2, then the 4-byte hint. A network send of the first
+     * rows then overlaps the computation of the rest. The concatenated pieces
+     * equal encapsulate_derand(public_key, m).first.serialize().
+     *
+     * @param public_key Recipient's public key
+     * @param sink Receiver of the ciphertext bytes
+     * @return ColorValue The shared secret
+     *
+     * @throws std::invalid_argument If the public key is invalid (as encapsulate()),
+     *         or a c1 polynomial of these parameters does not end on a byte boundary
+     */
+    ColorValue encapsulate_streamed(const ColorPublicKey& public_key, const CiphertextSink& sink) const;
+
+    /**
+     * @brief encapsulate_streamed() seeded with m, using caller-provided scratch
+     *
+     * Allocation-free once the workspace is warm and the key's expansion is
+     * cached (or, with matrix streaming, always).
+     */
+    ColorValue encapsulate_streamed(const ColorPublicKey& public_key, const std::array<uint8_t, 32>& m,
+                                    const CiphertextSink& sink, KemWorkspace& workspace) const;
+
+    /**
+     * @brief encapsulate_streamed() to a pre-expanded public key, as encapsulate_into()
+     *
+     * @throws std::invalid_argument If the key was expanded for different parameters
+     */
+    ColorValue encapsulate_streamed(const ExpandedPublicKey& public_key, const std::array<uint8_t, 32>& m,
+                                    const CiphertextSink& sink, KemWorkspace& workspace) const;
+
+    /**
+     * @brief Precompute single-use encapsulation bundles to a known public key
+     *
+     * Each bundle draws its own random m and does all the work of
+     * encapsulate_derand() with that m that does not depend on the message:
+     * seed derivation, noise sampling, A^T r + e1 and its packing, and
+     * t^T r + e2. Run it off the critical path, e.g. to refill a pool of
+     * bundles for a hot server key while idle.
+     *
+     * Since r is derived from m, m is fixed when the bundle is built rather
+     * than chosen online. Only color mode is covered; 256-bit mode folds the
+     * message into e2 and derives its secret from the ciphertext.
+     *
+     * @param public_key Recipient's public key; its expansion is cached as for encapsulate()
+     * @param count Number of bundles
+     * @return std::vector<EncapsulationBundle> count ready bundles
+     *
+     * @throws std::invalid_argument If the public key is invalid (as encapsulate())
+     */
+    std::vector<EncapsulationBundle> precompute_encapsulation(const ColorPublicKey& public_key,
+                                                              size_t count) const;
+
+    /**
+     * @brief precompute_encapsulation() to a pre-expanded public key
+     *
+     * @throws std::invalid_argument If the key was expanded for different parameters
+     */
+    std::vector<EncapsulationBundle> precompute_encapsulation(const ExpandedPublicKey& public_key,
+                                                              size_t count) const;
+
+    /**
+     * @brief Finish a precomputed bundle into a ciphertext
+     *
+     * Adds the message to c2, packs c2 and the hint next to the packed c1 and
+     * consumes the bundle. The result is the one encapsulate_derand() with the
+     * bundle's m returns; the cost is one polynomial's encoding.
+     *
+     * @param bundle Ready bundle from precompute_encapsulation() on this instance
+     * @return std::pair<ColorCiphertext, ColorValue> The ciphertext and shared secret
+     *
+     * @throws std::invalid_argument If the bundle is not ready() or was built for other parameters
+     */
+    std::pair<ColorCiphertext, ColorValue> encapsulate_online(EncapsulationBundle& bundle) const;
+
+    /**
+     * @brief encapsulate_online() into an existing ciphertext
+     *
+     * The ciphertext swaps its data buffer with the bundle, so once it has
+     * held one result the call allocates nothing.
+     *
+     * @throws std::invalid_argument If the bundle is not ready() or was built for other parameters
+     */
+    ColorValue encapsulate_online(EncapsulationBundle& bundle, ColorCiphertext& ciphertext) const;
+
+    /**
+     * @brief decapsulate() using caller-provided scratch
+     *
+     * The private key is parsed into the workspace rather than a fresh buffer.
+     *
+     * @throws std::invalid_argument If key/ciphertext parameters or data are invalid (as decapsulate())
+     */
+    ColorValue decapsulate(const ColorPublicKey& public_key,
+                           const ColorPrivateKey& private_key,
+                           const ColorCiphertext& ciphertext,
+                           KemWorkspace& workspace) const;
+
+    /**
+     * @brief Decapsulate with a prepared private key using caller-provided scratch
+     *
+     * @throws std::invalid_argument If the key or ciphertext belong to other parameters
+     * @throws std::invalid_argument If ciphertext data is malformed
+     */
+    ColorValue decapsulate(const PreparedPrivateKey& private_key, const ColorCiphertext& ciphertext,
+                           KemWorkspace& workspace) const;
+
+    /**
+     * @brief Decapsulate a ciphertext view with a prepared private key using caller-provided scratch
+     *
+     * @throws std::invalid_argument If the key or ciphertext belong to other parameters
+     * @throws std::invalid_argument If the viewed data has the wrong size
+     */
+    ColorValue decapsulate(const PreparedPrivateKey& private_key, const ColorCiphertextView& ciphertext,
+                           KemWorkspace& workspace) const;
+
+    /** @brief Message bits, and shared key bits, of the 256-bit encapsulation mode */
+    static constexpr uint32_t KEY_MESSAGE_BITS = 256;
+
+    /**
+     * @brief Encapsulate a 32-byte shared key
+     *
+     * The 256-bit mode: where encapsulate() carries one bit in c2[0], this spreads
+     * a random 32-byte message m over c2, one bit per coefficient as in ML-KEM, and
+     * returns SHAKE256(m, H(ciphertext)) as a SharedSecret. Ciphertexts have the
+     * same size and format as encapsulate(); the 4-byte hint is zero. Key
+     * confirmation is by re-encryption in decapsulate_key().
+     *
+     * @param public_key The recipient's public key
+     * @return std::pair<ColorCiphertext, SharedSecret> Ciphertext and shared key
+     *
+     * @throws std::invalid_argument If the degree is below KEY_MESSAGE_BITS or
+     *         sparse_c2 is set, or the key is invalid (as encapsulate())
+     */
+    std::pair<ColorCiphertext, SharedSecret> encapsulate_key(const ColorPublicKey& public_key) const;
+    std::pair<ColorCiphertext, SharedSecret> encapsulate_key(const ColorPublicKey& public_key,
+                                                             KemWorkspace& workspace) const;
+
+    /**
+     * @brief Deterministic encapsulate_key() from the 32-byte message m
+     *
+     * @throws std::invalid_argument As encapsulate_key()
+     */
+    std::pair<ColorCiphertext, SharedSecret> encapsulate_key_derand(const ColorPublicKey& public_key,
+                                                                    const std::array<uint8_t, 32>& m) const;
+    std::pair<ColorCiphertext, SharedSecret> encapsulate_key_derand(const ColorPublicKey& public_key,
+                                                                    const std::array<uint8_t, 32>& m,
+                                                                    KemWorkspace& workspace) const;
+
+    /**
+     * @brief Recover the shared key of an encapsulate_key() ciphertext
+     *
+     * Decrypts the 256-bit message, re-encrypts it under public_key and accepts
+     * only a byte-identical ciphertext. Otherwise the result is an implicit
+     * rejection key derived from the private key and the ciphertext. Both keys
+     * are computed on every call and selected in constant time.
+     *
+     * @return SharedSecret The shared secret, or the rejection secret
+     *
+     * @throws std::invalid_argument If the mode is unsupported (as encapsulate_key())
+     *         or key/ciphertext parameters or data are invalid (as decapsulate())
+     */
+    SharedSecret decapsulate_key(const ColorPublicKey& public_key,
+                                 const ColorPrivateKey& private_key,
+                                 const ColorCiphertext& ciphertext) const;
+    SharedSecret decapsulate_key(const ColorPublicKey& public_key,
+                                 const ColorPrivateKey& private_key,
+                                 const ColorCiphertext& ciphertext,
+                                 KemWorkspace& workspace) const;
+
+    /**
+     * @brief decapsulate_key() with the public key taken from an expanded private key
+     *
+     * @throws std::invalid_argument As decapsulate_key()
+     */
+    SharedSecret decapsulate_key(const ColorExpandedPrivateKey& private_key, const ColorCiphertext& ciphertext) const;
+    SharedSecret decapsulate_key(const ColorExpandedPrivateKey& private_key, const ColorCiphertext& ciphertext,
+                                 KemWorkspace& workspace) const;
+
+    /**
+     * @brief encapsulate_key() to a key view, writing the serialized ciphertext to caller memory
+     *
+     * ciphertext_out receives ColorCiphertext::serialized_size(params()) bytes,
+     * the serialize() form of the ciphertext encapsulate_key() returns. As with
+     * encapsulate_into() on a view, A is expanded or streamed in the workspace
+     * rather than cached, and a warm workspace makes the call allocation-free.
+     *
+     * @return SharedSecret The shared key
+     *
+     * @throws std::invalid_argument As encapsulate_key(), or if ciphertext_out
+     *         is null or smaller than the serialized ciphertext
+     */
+    SharedSecret encapsulate_key_into(const ColorPublicKeyView& public_key, uint8_t* ciphertext_out,
+                                      size_t ciphertext_out_size, KemWorkspace& workspace) const;
+    SharedSecret encapsulate_key_into(const ColorPublicKeyView& public_key, const std::array<uint8_t, 32>& m,
+                                      uint8_t* ciphertext_out, size_t ciphertext_out_size,
+                                      KemWorkspace& workspace) const;
+
+    /**
+     * @brief decapsulate_key() of a ciphertext view, e.g. ColorCiphertextView::parse() of received bytes
+     *
+     * @throws std::invalid_argument As decapsulate_key()
+     */
+    SharedSecret decapsulate_key(const ColorExpandedPrivateKey& private_key, const ColorCiphertextView& ciphertext,
+                                 KemWorkspace& workspace) const;
+
+    /**
+     * @brief encapsulate_key() that reports failure as a code instead of throwing
+     *
+     * Every check encapsulate_key() makes runs first and returns without
+     * exceptions or allocation; the throwing functions are the same checks with
+     * a message formatted after they fail. Only a failure inside the operation
+     * itself (no entropy, out of memory, a t_hat coefficient not reduced mod q)
+     * still raises internally, and is caught and mapped.
+     *
+     * @param ciphertext Receives the ciphertext, reusing its capacity
+     * @param shared_key Receives the shared key; zeroed on error
+     * @return CLWEError SUCCESS; INVALID_PARAMETERS for an unsupported mode or
+     *         mismatched parameters; INVALID_KEY for a malformed key;
+     *         MEMORY_ALLOCATION_FAILED or UNKNOWN_ERROR
+     */
+    CLWEError try_encapsulate_key(const ColorPublicKey& public_key, ColorCiphertext& ciphertext,
+                                  SharedSecret& shared_key) const noexcept;
+    CLWEError try_encapsulate_key(const ColorPublicKey& public_key, ColorCiphertext& ciphertext,
+                                  SharedSecret& shared_key, KemWorkspace& workspace) const noexcept;
+
+    /**
+     * @brief encapsulate_key_into() without exceptions, as try_encapsulate_key()
+     *
+     * @return CLWEError As try_encapsulate_key(), or BUFFER_TOO_SMALL if
+     *         ciphertext_out is null or too small
+     */
+    CLWEError try_encapsulate_key_into(const ColorPublicKeyView& public_key, uint8_t* ciphertext_out,
+                                       size_t ciphertext_out_size, SharedSecret& shared_key,
+                                       KemWorkspace& workspace) const noexcept;
+
+    /**
+     * @brief decapsulate_key() without exceptions, for floods of malformed ciphertexts
+     *
+     * A ciphertext of the wrong size or parameters is refused with a code, and
+     * one of the right shape but wrong content is implicitly rejected as by
+     * decapsulate_key(), so neither ever throws, unwinds or formats a message.
+     *
+     * @param shared_key Receives the shared or rejection secret; zeroed on error
+     * @return CLWEError SUCCESS; INVALID_CIPHERTEXT for a malformed ciphertext
+     *         view; INVALID_PARAMETERS or INVALID_KEY as try_encapsulate_key();
+     *         MEMORY_ALLOCATION_FAILED or UNKNOWN_ERROR
+     */
+    CLWEError try_decapsulate_key(const ColorExpandedPrivateKey& private_key, const ColorCiphertextView& ciphertext,
+                                  SharedSecret& shared_key) const noexcept;
+    CLWEError try_decapsulate_key(const ColorExpandedPrivateKey& private_key, const ColorCiphertextView& ciphertext,
+                                  SharedSecret& shared_key, KemWorkspace& workspace) const noexcept;
+
+    // Getters
+    const CLWEParameters& params() const { return params_; }
+
+private:
+    // DecapsulationContext runs decapsulate_expanded() one polynomial at a time
+    friend class DecapsulationContext;
+
+    ColorValue hash_ciphertext(const ColorCiphertextView& ciphertext) const;
+    // Implicit-rejection value from a finalized SHAKE-256 stream over the serialized ciphertext
+    ColorValue rejection_secret(SHAKE256Sampler& shake) const;
+    // Message bit of v = c2 - s^T c1; padding_valid is false unless every other transmitted
+    // coefficient decodes as zero
+    ColorValue decode_message(const ColorValue* c2, const ColorValue* s_dot_c1, bool& padding_valid) const;
+    // Fujisaki-Okamoto selection: recovered when it matches hint and the padding is valid,
+    // rejection otherwise, in constant time
+    ColorValue select_decapsulated_secret(const ColorValue& recovered, bool padding_valid, const uint8_t* hint,
+                                          const ColorValue& rejection) const;
+
+    // Workspace buffers sized for this instance's parameters
+    KemWorkspace::Buffers& workspace_buffers(KemWorkspace& workspace) const;
+
+    // Key generation/encapsulation/decapsulation after seed expansion, key validation and expansion
+    std::pair<ColorPublicKey, ColorPrivateKey> keygen_expanded(const std::array<uint8_t, 32>& matrix_seed,
+                                                               const std::array<uint8_t, 32>& secret_seed,
+                                                               const std::array<uint8_t, 32>& error_seed,
+                                                               KemWorkspace::Buffers& workspace) const;
+    // KeygenOp runs keygen_expanded() in bounded steps through these and the helpers above
+    friend class KeygenOp;
+    // The matrix, secret and error seeds keygen_derand(d) expands d into
+    void expand_keygen_seed(const std::array<uint8_t, 32>& d, std::array<uint8_t, 32>& matrix_seed,
+                            std::array<uint8_t, 32>& secret_seed, std::array<uint8_t, 32>& error_seed) const;
+    // s_hat[index] (secret) or e_hat[index] of keygen_expanded() into out; scratch is reset
+    // and carved, so it needs keygen_noise_scratch_bytes() of capacity
+    void sample_keygen_noise(const std::array<uint8_t, 32>& seed, uint8_t index, bool secret, ColorValue* out,
+                             KemArena& scratch) const;
+    static size_t keygen_noise_scratch_bytes(uint32_t degree);
+    // s_hat of keygen_derand(d) into secret, sampled with workspace's noise buffers
+    void regenerate_secret(const std::array<uint8_t, 32>& d, PolyVec& secret, KemWorkspace::Buffers& workspace) const;
+    // Sparse slots of prepared's s for fixed-weight ternary sets; left null for other keys
+    void attach_sparse_secret(PreparedPrivateKey& prepared) const;
+    ColorValue encapsulate_expanded(const PolyMatrix* matrix_A_trans,
+                                    const std::array<uint8_t, 32>* matrix_seed,
+                                    const PolyVec& public_key_colors,
+                                    const std::array<uint8_t, 32>& r_seed,
+                                    const std::array<uint8_t, 32>& e1_seed,
+                                    const std::array<uint8_t, 32>& e2_seed,
+                                    const ColorValue& shared_secret,
+                                    ColorCiphertext& ciphertext,
+                                    KemWorkspace::Buffers& workspace) const;
+    // encapsulate_expanded() handing each c1 polynomial to sink as its row of A^T r is done
+    ColorValue encapsulate_expanded_streamed(const PolyMatrix* matrix_A_trans,
+                                             const std::array<uint8_t, 32>* matrix_seed,
+                                             const PolyVec& public_key_colors,
+                                             const std::array<uint8_t, 32>& r_seed,
+                                             const std::array<uint8_t, 32>& e1_seed,
+                                             const std::array<uint8_t, 32>& e2_seed,
+                                             const ColorValue& shared_secret,
+                                             const CiphertextSink& sink,
+                                             KemWorkspace::Buffers& workspace) const;
+    // One bundle of precompute_encapsulation() with a fresh m: c1 packed, c2 before the message
+    void precompute_bundle(const PolyMatrix* matrix_A_trans, const std::array<uint8_t, 32>* matrix_seed,
+                           const PolyVec& public_key_colors, EncapsulationBundle& bundle,
+                           KemWorkspace::Buffers& workspace) const;
+    // Encapsulation to an unexpanded key: through the expanded-key cache, or streaming A
+    ColorValue encapsulate_public_key(const ColorPublicKey& public_key,
+                                      const std::array<uint8_t, 32>& r_seed,
+                                      const std::array<uint8_t, 32>& e1_seed,
+                                      const std::array<uint8_t, 32>& e2_seed,
+                                      const ColorValue& shared_secret,
+                                      ColorCiphertext& ciphertext,
+                                      KemWorkspace& workspace) const;
+    // encapsulate_key_derand() into ciphertext, resized in place
+    SharedSecret encapsulate_key_derand_into(const ColorPublicKey& public_key, const std::array<uint8_t, 32>& m,
+                                             ColorCiphertext& ciphertext, KemWorkspace& workspace) const;
+    // 256-bit encapsulation after key validation and expansion; returns the shared key.
+    // Writes the ciphertext_bytes_ of encoded polynomials to ciphertext_data and the zero
+    // hint to hint
+    SharedSecret encapsulate_key_expanded(const PolyMatrix* matrix_A_trans,
+                                          const std::array<uint8_t, 32>* matrix_seed,
+                                          const PolyVec& public_key_colors,
+                                          const std::array<uint8_t, 32>& m,
+                                          uint8_t* ciphertext_data,
+                                          uint8_t* hint,
+                                          KemWorkspace::Buffers& workspace) const;
+    // The same into ciphertext, resized in place
+    SharedSecret encapsulate_key_expanded(const PolyMatrix* matrix_A_trans,
+                                          const std::array<uint8_t, 32>* matrix_seed,
+                                          const PolyVec& public_key_colors,
+                                          const std::array<uint8_t, 32>& m,
+                                          ColorCiphertext& ciphertext,
+                                          KemWorkspace::Buffers& workspace) const;
+    // Throws std::invalid_argument unless the parameters can carry a 256-bit message
+    void validate_key_message_mode() const;
+    // The validate_*() conditions as codes, for the try_*() functions; the validators
+    // format their messages only once one of these has failed
+    CLWEError check_key_message_mode() const noexcept;
+    CLWEError check_public_key(const ColorPublicKey& public_key) const noexcept;
+    CLWEError check_public_key(const ColorPublicKeyView& public_key) const noexcept;
+    CLWEError check_private_key(const CLWEParameters& params, const std::vector<uint8_t>& secret_data) const noexcept;
+    CLWEError check_ciphertext(const ColorCiphertextView& ciphertext) const noexcept;
+    // decapsulate_key() after mode and key validation; checks the ciphertext
+    SharedSecret decapsulate_key_validated(const ColorPublicKey& public_key, const std::vector<uint8_t>& secret_data,
+                                           const ColorCiphertextView& ciphertext, KemWorkspace& workspace) const;
+    // Throws std::invalid_argument unless the private key matches this instance in parameters and size
+    void validate_private_key(const CLWEParameters& params, const std::vector<uint8_t>& secret_data) const;
+    // Throws std::invalid_argument unless a key-mode ciphertext matches this instance in parameters and size
+    void validate_ciphertext(const ColorCiphertextView& ciphertext) const;
+    // A non-null sparse_secret (the same s) replaces the NTT inner product with sparse passes
+    ColorValue decapsulate_expanded(const PolyVec& secret_key_colors, const ColorCiphertext& ciphertext,
+                                    KemWorkspace::Buffers& workspace,
+                                    const SparseTernaryVec* sparse_secret = nullptr) const;
+    ColorValue decapsulate_expanded(const PolyVec& secret_key_colors, const ColorCiphertextView& ciphertext,
+                                    KemWorkspace::Buffers& workspace,
+                                    const SparseTernaryVec* sparse_secret = nullptr) const;
+
+    // Coefficient (de)serialization in the parameters' wire encoding
+    static void encode_polyvec(const PolyVec& polys, CoefficientEncoding encoding, std::vector<uint8_t>& bytes);
+    static PolyVec bytes_to_polyvec(const std::vector<uint8_t>& bytes, uint32_t rank, uint32_t degree,
+                                    CoefficientEncoding encoding);
+    static void decode_polyvec(const uint8_t* bytes, PolyVec& polys, CoefficientEncoding encoding);
+    // decode_polyvec for public data (t_hat, an uncompressed ciphertext): throws
+    // std::invalid_argument naming what unless every coefficient is below q
+    void decode_public_polyvec(const uint8_t* bytes, PolyVec& polys, CoefficientEncoding encoding,
+                               const char* what) const;
+    // Public key data from t_hat: encode_polyvec, or with t_dropped_bits t1 of the
+    // coefficient-domain t, leaving t_hat holding t. Either way decode_public_key_data()
+    // gives t_hat back, rounded.
+    void encode_public_key_data(PolyVec& t_hat, std::vector<uint8_t>& bytes) const;
+    void decode_public_key_data(const uint8_t* bytes, PolyVec& t_hat, CoefficientEncoding encoding) const;
+    std::vector<uint8_t> ciphertext_to_bytes(const PolyVec& ciphertext) const;
+    void encode_ciphertext(const PolyVec& ciphertext, uint8_t* bytes) const;
+    // Packs ciphertext colors, the secret hint and the parameters into ciphertext
+    void pack_ciphertext(const PolyVec& ciphertext_colors, const ColorValue& shared_secret,
+                         ColorCiphertext& ciphertext) const;
+    // keygen_derand() of each 32-byte seed of seeds, on batch_device_ where it applies
+    std::vector<std::pair<ColorPublicKey, ColorPrivateKey>> keygen_batch_derand(const std::vector<uint8_t>& seeds,
+                                                                                size_t count) const;
+    // keygen_batch/encapsulate_batch with the lattice core on batch_device_; seeds as drawn
+    std::vector<std::pair<ColorPublicKey, ColorPrivateKey>> keygen_batch_offloaded(
+        const std::vector<uint8_t>& seeds, size_t count) const;
+    std::vector<std::pair<ColorCiphertext, ColorValue>> encapsulate_batch_offloaded(
+        const std::vector<ColorPublicKey>& public_keys, const std::vector<uint8_t>& seeds) const;
+    // False if an uncompressed coefficient is not reduced mod q; decapsulation then rejects
+    bool decode_ciphertext(const uint8_t* bytes, PolyVec& ciphertext) const;
+
+    // Throws std::invalid_argument unless public_key matches this instance's parameters
+    void validate_public_key(const ColorPublicKey& public_key) const;
+    void validate_public_key(const ColorPublicKeyView& public_key) const;
+    // Validates public_key and returns its entry in the expanded-key cache, most recently used first
+    std::shared_ptr<const ExpandedPublicKey> cached_expanded_key(const ColorPublicKey& public_key) const;
+    mutable std::list<std::shared_ptr<const ExpandedPublicKey>> expanded_key_cache_;
+    size_t expanded_key_cache_capacity_;
+    mutable std::mutex expanded_key_cache_mutex_;
+
+    // Runs task(0) .. task(count - 1) on executor_, or inline below the rank threshold.
+    // A template so the inline path never wraps task in a heap-allocated std::function.
+    template <typename Task>
+    void parallel_for(size_t count, const Task& task) const;
+    KemExecutor executor_;          /**< Optional parallel-for hook */
+    uint32_t parallel_min_rank_;    /**< Smallest module rank that uses executor_ */
+    bool matrix_streaming_;         /**< Expand A row by row instead of materializing it */
+    std::shared_ptr<const SharedMatrix> shared_matrix_;  /**< Installed A of shared_matrix parameter sets */
+    std::shared_ptr<RandomSource> random_source_;  /**< Where every drawn seed comes from */
+    BatchDevice batch_device_;      /**< Where keygen_batch/encapsulate_batch run */
+    GpuBatchConfig batch_config_;   /**< Launch geometry for BatchDevice::Cuda */
+    /** @brief Fill out from random_source_ */
+    void random_bytes(uint8_t* out, size_t len) const;
 };
 
 } // namespace clwe
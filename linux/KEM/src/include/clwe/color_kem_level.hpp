@@ -0,0 +1,215 @@
+/**
+ * @file color_kem_level.hpp
+ * @brief Compile-time specialized Color KEM front ends for the ML-KEM levels
+ *
+ * This header defines ColorKEMLevel<K> and the ColorKEM512, ColorKEM768 and
+ * ColorKEM1024 aliases. Each fixes the ML-KEM parameter set for module rank K
+ * at compile time, so ring constants are constexpr and keys and ciphertexts
+ * are exchanged in std::array buffers of their exact serialized size.
+ *
+ * @author ColorKEM Development Team
+ * @version 1.0.0
+ * @date 2024
+ *
+ * @see color_kem.hpp for the runtime-parameterized ColorKEM class
+ */
+
+#ifndef COLOR_KEM_LEVEL_HPP
+#define COLOR_KEM_LEVEL_HPP
+
+#include "color_kem.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace clwe {
+
+/**
+ * @brief ML-KEM level constants selected by module rank
+ *
+ * Only K = 2, 3 and 4 (ML-KEM-512, -768 and -1024) are defined.
+ */
+template <unsigned K>
+struct ColorKEMLevelTraits;
+
+template <>
+struct ColorKEMLevelTraits<2> {
+    static constexpr uint32_t security_level = 512;
+    static constexpr uint32_t eta1 = 3;
+    static constexpr uint32_t eta2 = 2;
+};
+
+template <>
+struct ColorKEMLevelTraits<3> {
+    static constexpr uint32_t security_level = 768;
+    static constexpr uint32_t eta1 = 2;
+    static constexpr uint32_t eta2 = 2;
+};
+
+template <>
+struct ColorKEMLevelTraits<4> {
+    static constexpr uint32_t security_level = 1024;
+    static constexpr uint32_t eta1 = 2;
+    static constexpr uint32_t eta2 = 2;
+};
+
+/**
+ * @brief Fixed-parameter Color KEM for module rank K
+ *
+ * All parameters are compile-time constants matching CLWEParameters(security_level)
+ * with the default COLOR32 encoding and uncompressed ciphertexts. Keys and
+ * ciphertexts are plain fixed-size byte arrays in the ColorPublicKey,
+ * ColorPrivateKey and ColorCiphertext wire formats, so they can be stored and
+ * passed around without heap allocation.
+ *
+ * The arithmetic runs on a ColorKEM instance per thread and level. It is
+ * constructed on first use and reused afterwards, so repeated calls do not pay
+ * for engine setup.
+ *
+ * @tparam K Module rank: 2, 3 or 4
+ */
+template <unsigned K>
+class ColorKEMLevel {
+    using Traits = ColorKEMLevelTraits<K>;
+
+public:
+    static constexpr uint32_t module_rank = K;
+    static constexpr uint32_t degree = 256;
+    static constexpr uint32_t modulus = 3329;
+    static constexpr uint32_t eta1 = Traits::eta1;
+    static constexpr uint32_t eta2 = Traits::eta2;
+    static constexpr uint32_t security_level = Traits::security_level;
+
+    /** @brief Serialized sizes: seed || t_hat, s_hat, and c1 || c2 || 4-byte hint */
+    static constexpr size_t public_key_bytes = 32 + 4 * static_cast<size_t>(K) * degree;
+    static constexpr size_t private_key_bytes = 4 * static_cast<size_t>(K) * degree;
+    static constexpr size_t ciphertext_bytes = 4 * static_cast<size_t>(K + 1) * degree + 4;
+
+    /**
+     * @brief Exact heap per operation and the stack bound of this level
+     *
+     * A constant expression, so a build can pin its memory budget:
+     * @code
+     * static_assert(clwe::ColorKEM768::memory_requirements().keygen.heap_bytes() <= 64 * 1024,
+     *               "ML-KEM-768 keygen exceeds the enclave heap");
+     * @endcode
+     *
+     * @param matrix_streaming Whether A is streamed, see ColorKEM::set_matrix_streaming()
+     * @return KemMemoryRequirements Same as ColorKEM::memory_requirements(parameters(), matrix_streaming)
+     */
+    static constexpr KemMemoryRequirements memory_requirements(bool matrix_streaming = false) {
+        return ColorKEM::memory_requirements(K, degree, public_key_bytes - 32, private_key_bytes, ciphertext_bytes - 4,
+                                             matrix_streaming);
+    }
+
+    using PublicKey = std::array<uint8_t, public_key_bytes>;
+    using PrivateKey = std::array<uint8_t, private_key_bytes>;
+    using Ciphertext = std::array<uint8_t, ciphertext_bytes>;
+
+    /**
+     * @brief Runtime parameters equivalent to this level
+     * @return CLWEParameters The standard parameter set for security_level
+     */
+    static CLWEParameters parameters() { return CLWEParameters(security_level); }
+
+    /**
+     * @brief The per-thread runtime engine used by this level
+     * @return ColorKEM& Engine constructed with parameters()
+     */
+    static ColorKEM& engine() {
+        thread_local ColorKEM kem(parameters());
+        return kem;
+    }
+
+    /**
+     * @brief Generate a key pair from fresh randomness
+     * @return std::pair<PublicKey, PrivateKey> Serialized public and private keys
+     */
+    static std::pair<PublicKey, PrivateKey> keygen() { return to_arrays(engine().keygen()); }
+
+    /**
+     * @brief Generate a key pair from a 32-byte seed
+     * @param d Seed, expanded as in ColorKEM::keygen_derand()
+     * @return std::pair<PublicKey, PrivateKey> Serialized public and private keys
+     */
+    static std::pair<PublicKey, PrivateKey> keygen_derand(const std::array<uint8_t, 32>& d) {
+        return to_arrays(engine().keygen_derand(d));
+    }
+
+    /**
+     * @brief Encapsulate a fresh shared secret to a public key
+     * @param public_key Serialized public key
+     * @return std::pair<Ciphertext, ColorValue> Serialized ciphertext and shared secret
+     *
+     * @throws std::invalid_argument If the public key fails validation
+     */
+    static std::pair<Ciphertext, ColorValue> encapsulate(const PublicKey& public_key) {
+        auto result = engine().encapsulate(parse_public_key(public_key));
+        return {to_array<Ciphertext>(result.first), result.second};
+    }
+
+    /**
+     * @brief Encapsulate with a caller-provided 32-byte seed
+     * @param public_key Serialized public key
+     * @param m Seed, expanded as in ColorKEM::encapsulate_derand()
+     * @return std::pair<Ciphertext, ColorValue> Serialized ciphertext and shared secret
+     *
+     * @throws std::invalid_argument If the public key fails validation
+     */
+    static std::pair<Ciphertext, ColorValue> encapsulate_derand(const PublicKey& public_key,
+                                                                const std::array<uint8_t, 32>& m) {
+        auto result = engine().encapsulate_derand(parse_public_key(public_key), m);
+        return {to_array<Ciphertext>(result.first), result.second};
+    }
+
+    /**
+     * @brief Recover the shared secret from a ciphertext
+     * @param public_key Serialized public key
+     * @param private_key Serialized private key
+     * @param ciphertext Serialized ciphertext
+     * @return ColorValue The shared secret (implicit-rejection value on failure)
+     *
+     * @throws std::invalid_argument If a key fails validation
+     */
+    static ColorValue decapsulate(const PublicKey& public_key, const PrivateKey& private_key,
+                                  const Ciphertext& ciphertext) {
+        const CLWEParameters params = parameters();
+        return engine().decapsulate(parse_public_key(public_key),
+                                    ColorPrivateKey::deserialize(private_key.data(), private_key.size(), params),
+                                    ColorCiphertext::deserialize(ciphertext.data(), ciphertext.size(), params));
+    }
+
+private:
+    static ColorPublicKey parse_public_key(const PublicKey& public_key) {
+        return ColorPublicKey::deserialize(public_key.data(), public_key.size(), parameters());
+    }
+
+    template <typename Array, typename Object>
+    static Array to_array(const Object& object) {
+        Array bytes;
+        size_t written = object.serialize(bytes.data(), bytes.size());
+        if (written != bytes.size()) {
+            throw std::logic_error("Serialized size " + std::to_string(written) + " does not match level size " +
+                                   std::to_string(bytes.size()));
+        }
+        return bytes;
+    }
+
+    static std::pair<PublicKey, PrivateKey> to_arrays(const std::pair<ColorPublicKey, ColorPrivateKey>& keys) {
+        return {to_array<PublicKey>(keys.first), to_array<PrivateKey>(keys.second)};
+    }
+};
+
+/** @brief ML-KEM-512 parameter set (module rank 2) */
+using ColorKEM512 = ColorKEMLevel<2>;
+/** @brief ML-KEM-768 parameter set (module rank 3) */
+using ColorKEM768 = ColorKEMLevel<3>;
+/** @brief ML-KEM-1024 parameter set (module rank 4) */
+using ColorKEM1024 = ColorKEMLevel<4>;
+
+} // namespace clwe
+
+#endif // COLOR_KEM_LEVEL_HPP
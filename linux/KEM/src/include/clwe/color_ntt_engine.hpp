@@ -24,6 +24,7 @@
 #include "ntt_engine.hpp"
 #include "color_value.hpp"
 #include <vector>
+#include <memory>
 
 namespace clwe {
 
@@ -33,7 +34,7 @@ namespace clwe {
  * Extends NTTEngine to perform fast polynomial arithmetic using ColorValue
  * coefficients. This class handles the transformation between coefficient
  * and evaluation representations of polynomials, enabling efficient multiplication
- * in the ring R_q = Z_q[X]/(X^n + 1).
+ * in the ring R_q = Z_q[X]/(X^n - 1).
  *
  * Key features:
  * - Forward and inverse NTT transforms for color polynomials
@@ -41,30 +42,25 @@ namespace clwe {
  * - Conversion between ColorValue and uint32_t representations
  * - Modular arithmetic operations on color coefficients
  *
- * The engine precomputes NTT roots (zetas) as ColorValue objects to maintain
- * consistency with the color-based arithmetic throughout the cryptographic operations.
+ * Color polynomials are unpacked once into a contiguous uint32_t buffer, transformed
+ * by the best NTTEngine backend for the running CPU (scalar, NEON or AVX2), and
+ * repacked once. Coefficients are interpreted through ColorValue::to_math_value()
+ * and reduced modulo q.
  */
 class ColorNTTEngine : public NTTEngine {
 private:
-    std::vector<ColorValue> color_zetas_;
-    std::vector<ColorValue> color_zetas_inv_;
+    // Coefficient arithmetic runs on the best uint32_t backend for this CPU
+    std::unique_ptr<NTTEngine> backend_;
 
-    ColorValue color_to_crypto_space(const ColorValue& color) const;
-    ColorValue crypto_space_to_color(const ColorValue& crypto_val) const;
-
-    void color_butterfly(ColorValue& a, ColorValue& b, const ColorValue& zeta, uint32_t modulus) const;
-    void color_butterfly_inv(ColorValue& a, ColorValue& b, const ColorValue& zeta, uint32_t modulus) const;
-
-    ColorValue color_add_precise(const ColorValue& a, const ColorValue& b, uint32_t modulus) const;
-    ColorValue color_subtract_precise(const ColorValue& a, const ColorValue& b, uint32_t modulus) const;
-    ColorValue color_multiply_precise(const ColorValue& a, const ColorValue& b, uint32_t modulus) const;
+    // Unpack count polynomials to a contiguous buffer of canonical residues
+    void unpack_colors(const ColorValue* colors, uint32_t* coeffs, size_t count = 1) const;
 
 public:
     /**
      * @brief Construct a ColorNTTEngine for the given parameters
      *
-     * Initializes the NTT engine with the specified modulus q and ring dimension n.
-     * Precomputes the NTT roots (zetas) as ColorValue objects for efficient transforms.
+     * Initializes the NTT engine with the specified modulus q and ring dimension n
+     * and selects the backend with create_optimal_ntt_engine().
      *
      * @param q Prime modulus for the ring R_q
      * @param n Ring dimension (must be a power of 2)
@@ -74,9 +70,29 @@ public:
      */
     ColorNTTEngine(uint32_t q, uint32_t n);
 
-    /** @brief Destructor - releases precomputed NTT roots */
+    /** @brief Destructor - releases the backend engine */
     ~ColorNTTEngine() override = default;
 
+    /**
+     * @brief Process-wide engine for the given parameters
+     *
+     * Returns the same immutable engine for every request with equal (q, n)
+     * from the same NUMA node under the same ntt_backend() (see autotune.hpp),
+     * constructing it on first use. Each node gets its
+     * own copy of the tables, allocated by the first thread that asks from
+     * there, so engines built from threads bound to a node (see NumaKemShards)
+     * read node-local memory. All methods are const and keep their scratch
+     * buffers thread-local, so the instance can be shared freely across
+     * threads and ColorKEM objects.
+     *
+     * @param q Prime modulus for the ring R_q
+     * @param n Ring dimension (must be a power of 2)
+     * @return std::shared_ptr<const ColorNTTEngine> The shared engine
+     *
+     * @throws std::invalid_argument If the parameters are invalid
+     */
+    static std::shared_ptr<const ColorNTTEngine> shared(uint32_t q, uint32_t n);
+
     /**
      * @brief Forward NTT transform for color polynomials
      *
@@ -94,7 +110,8 @@ public:
      * @brief Inverse NTT transform for color polynomials
      *
      * Transforms a polynomial from evaluation representation back to coefficient
-     * representation. Includes the necessary scaling by n^(-1) modulo q.
+     * representation. The n^(-1) scaling is not applied, so
+     * ntt_inverse_colors(ntt_forward_colors(x)) yields n * x modulo q.
      *
      * @param poly Pointer to polynomial values (modified in-place)
      *
@@ -102,6 +119,28 @@ public:
      */
     void ntt_inverse_colors(ColorValue* poly) const;
 
+    /**
+     * @brief Forward NTT of several color polynomials in one backend call
+     *
+     * Equivalent to calling ntt_forward_colors() on each polynomial, but the
+     * backend runs every stage across the whole batch, which amortizes dispatch
+     * and keeps independent butterflies in flight.
+     *
+     * @param polys count polynomials of n coefficients stored back to back (modified in-place)
+     * @param count Number of polynomials
+     */
+    void ntt_forward_colors_batch(ColorValue* polys, size_t count) const;
+
+    /**
+     * @brief Inverse NTT of several color polynomials in one backend call
+     *
+     * Batched counterpart of ntt_inverse_colors(); results are scaled by n.
+     *
+     * @param polys count polynomials of n values stored back to back (modified in-place)
+     * @param count Number of polynomials
+     */
+    void ntt_inverse_colors_batch(ColorValue* polys, size_t count) const;
+
     /**
      * @brief Multiply two color polynomials using NTT
      *
@@ -110,12 +149,58 @@ public:
      * 2. Pointwise multiplication in evaluation domain
      * 3. Inverse NTT to get coefficient representation
      *
+     * Like the inverse transform, the product is left scaled by n.
+     *
      * @param a First polynomial (n coefficients)
      * @param b Second polynomial (n coefficients)
      * @param result Output polynomial (n coefficients, overwritten)
      */
     void multiply_colors(const ColorValue* a, const ColorValue* b, ColorValue* result) const;
 
+    /**
+     * @brief Pointwise multiply-accumulate in the NTT domain
+     *
+     * Computes acc_hat[i] = (acc_hat[i] + a_hat[i] * b_hat[i]) mod q for all n
+     * values. Accumulating products of forward-transformed polynomials and
+     * applying ntt_inverse_colors() once to the sum gives n times the sum of the
+     * ring products.
+     *
+     * @param a_hat First operand in NTT domain (n values)
+     * @param b_hat Second operand in NTT domain (n values)
+     * @param acc_hat Accumulator in NTT domain (n values, updated in-place)
+     */
+    void pointwise_multiply_accumulate_colors(const ColorValue* a_hat, const ColorValue* b_hat, ColorValue* acc_hat) const;
+
+    /**
+     * @brief Fused dot product of k NTT-domain polynomial pairs
+     *
+     * Computes out_hat[i] = sum_{j<k} a_j[i] * b_j[i] mod q in one pass, with
+     * the k products accumulated per coefficient before a single reduction.
+     * This replaces k calls to pointwise_multiply_accumulate_colors() for a
+     * matrix row or column times a vector.
+     *
+     * @param a_hat First operand of the first pair; a_j starts at a_hat + j * a_stride
+     * @param a_stride Coefficients between consecutive a_j (n for a matrix row, k * n for a column)
+     * @param b_hat k NTT-domain polynomials stored back to back
+     * @param k Number of pairs
+     * @param out_hat Output in NTT domain (n values, overwritten)
+     */
+    void row_dot_colors(const ColorValue* a_hat, size_t a_stride, const ColorValue* b_hat, size_t k,
+                        ColorValue* out_hat) const;
+
+    /**
+     * @brief Constant coefficient of a color polynomial product
+     *
+     * Computes (a * b)[0] = a[0] * b[0] + sum_{j>0} a[j] * b[n - j] mod q directly
+     * in O(n) with the backend's SIMD kernel, without any NTT. Unlike
+     * multiply_colors() the result is not scaled by n.
+     *
+     * @param a First polynomial in coefficient domain (n coefficients)
+     * @param b Second polynomial in coefficient domain (n coefficients)
+     * @return ColorValue The constant coefficient of the product
+     */
+    ColorValue constant_term_product_colors(const ColorValue* a, const ColorValue* b) const;
+
     // Base class interface implementations
     /**
      * @brief Forward NTT for uint32_t polynomials (base class interface)
@@ -129,6 +214,29 @@ public:
      */
     void ntt_inverse(uint32_t* poly) const override;
 
+    /**
+     * @brief Batched forward NTT for uint32_t polynomials (base class interface)
+     * @param polys count polynomials stored back to back (modified in-place)
+     * @param count Number of polynomials
+     */
+    void ntt_forward_batch(uint32_t* polys, size_t count) const override;
+
+    /**
+     * @brief Batched inverse NTT for uint32_t polynomials (base class interface)
+     * @param polys count polynomials stored back to back (modified in-place)
+     * @param count Number of polynomials
+     */
+    void ntt_inverse_batch(uint32_t* polys, size_t count) const override;
+
+    /**
+     * @brief Sum of k pointwise products in the NTT domain (base class interface)
+     * @param a k NTT-domain polynomials stored back to back, reduced mod q
+     * @param b k NTT-domain polynomials stored back to back, reduced mod q
+     * @param k Number of products
+     * @param out Output values, out[i] = sum_j a_j[i] * b_j[i] mod q (overwritten)
+     */
+    void basemul_acc(const uint32_t* a, const uint32_t* b, size_t k, uint32_t* out) const override;
+
     /**
      * @brief Multiply uint32_t polynomials using NTT (base class interface)
      * @param a First polynomial
@@ -138,16 +246,34 @@ public:
     void multiply(const uint32_t* a, const uint32_t* b, uint32_t* result) const override;
 
     /**
-     * @brief Get SIMD support level (ColorNTTEngine uses scalar operations)
-     * @return SIMDSupport Always returns SIMDSupport::NONE
+     * @brief Multiply uint32_t polynomials in place (base class interface)
+     *
+     * The backend transforms both buffers where they lie, so no scratch is used.
+     *
+     * @param a First polynomial, reduced mod q; overwritten with the product scaled by n
+     * @param b Second polynomial, reduced mod q; left in the NTT domain
+     */
+    void multiply_inplace(uint32_t* a, uint32_t* b) const override;
+
+    /**
+     * @brief Constant coefficient of a uint32_t polynomial product (base class interface)
+     * @param a First polynomial, reduced mod q
+     * @param b Second polynomial, reduced mod q
+     * @return uint32_t Unscaled constant coefficient of a * b
+     */
+    uint32_t constant_term_product(const uint32_t* a, const uint32_t* b) const override;
+
+    /**
+     * @brief Get SIMD support level of the selected backend
+     * @return SIMDSupport The backend's SIMD level
      */
-    SIMDSupport get_simd_support() const override { return SIMDSupport::NONE; }
+    SIMDSupport get_simd_support() const override { return backend_->get_simd_support(); }
 
     /**
      * @brief Convert uint32_t coefficients to ColorValue representation
      *
      * Converts an array of uint32_t coefficients to their ColorValue equivalents.
-     * The conversion uses ColorValue::from_math_value() for each coefficient.
+     * The conversion is colors_from_u32() over n coefficients.
      *
      * @param coeffs Array of uint32_t coefficients (n elements)
      * @param colors Output array of ColorValue objects (must be pre-allocated, n elements)
@@ -160,7 +286,7 @@ public:
      * @brief Convert ColorValue coefficients to uint32_t representation
      *
      * Converts an array of ColorValue coefficients to their uint32_t equivalents.
-     * The conversion uses ColorValue::to_math_value() for each coefficient.
+     * The conversion is colors_to_u32() over n coefficients.
      *
      * @param colors Array of ColorValue coefficients (n elements)
      * @param coeffs Output array of uint32_t values (must be pre-allocated, n elements)
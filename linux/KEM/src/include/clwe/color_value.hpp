@@ -15,9 +15,14 @@
 #ifndef COLOR_VALUE_HPP
 #define COLOR_VALUE_HPP
 
+#include <cstddef>
 #include <cstdint>
 #include <iostream>
 
+#ifdef HAVE_AVX512
+#include <immintrin.h>
+#endif
+
 namespace clwe {
 
 /**
@@ -215,6 +220,31 @@ struct ColorValue {
     void print() const { std::cout << to_string() << std::endl; }
 };
 
+/**
+ * @brief Convert an array of math values to colors
+ *
+ * Equivalent to colors[i] = ColorValue::from_math_value(values[i]) for every i. The
+ * packing is big-endian, so this is a 32-bit byte swap and runs as AVX2 (when the CPU
+ * has it) or NEON byte shuffles.
+ *
+ * @param values Input math values (count elements)
+ * @param colors Output colors (count elements); may be the same memory as values
+ * @param count Number of elements
+ */
+void colors_from_u32(const uint32_t* values, ColorValue* colors, size_t count);
+
+/**
+ * @brief Convert an array of colors to math values
+ *
+ * Equivalent to values[i] = colors[i].to_math_value() for every i; the inverse of
+ * colors_from_u32().
+ *
+ * @param colors Input colors (count elements)
+ * @param values Output math values (count elements); may be the same memory as colors
+ * @param count Number of elements
+ */
+void colors_to_u32(const ColorValue* colors, uint32_t* values, size_t count);
+
 /**
  * @brief Color arithmetic operations namespace
  *
@@ -257,7 +287,12 @@ namespace color_ops {
      */
     ColorValue mod_reduce_color(const ColorValue& c, uint32_t modulus);
 
-    /** @brief AVX-512 SIMD operations (available when HAVE_AVX512 is defined) */
+    /**
+     * @brief AVX-512 SIMD operations (available when HAVE_AVX512 is defined)
+     *
+     * These are compiled for AVX-512 regardless of the build flags. Call them only from
+     * code compiled for AVX-512, on CPUs where CPUFeatures::has_avx512bw is set.
+     */
     #ifdef HAVE_AVX512
     /**
      * @brief AVX-512 vectorized color addition
@@ -343,6 +378,64 @@ namespace color_ops {
      */
     ColorValue mod_reduce_color_simd(const ColorValue& c, uint32_t modulus);
 
+    /**
+     * @brief Array modular addition: out[i] = (a[i] + b[i]) mod modulus
+     *
+     * Works on the math values of whole arrays with AVX-512 or AVX2 (selected at run
+     * time) or NEON kernels. Inputs may hold any value; outputs are reduced to
+     * [0, modulus).
+     *
+     * @param a First input array (count elements)
+     * @param b Second input array (count elements)
+     * @param out Output array (count elements); may alias a or b
+     * @param count Number of elements
+     * @param modulus Modulus, 2 <= modulus <= 65536
+     * @throws std::invalid_argument if modulus is out of range
+     */
+    void add_mod(const ColorValue* a, const ColorValue* b, ColorValue* out, size_t count, uint32_t modulus);
+
+    /**
+     * @brief Array modular subtraction: out[i] = (a[i] - b[i]) mod modulus
+     * @see add_mod() for the parameters and SIMD dispatch
+     */
+    void sub_mod(const ColorValue* a, const ColorValue* b, ColorValue* out, size_t count, uint32_t modulus);
+
+    /**
+     * @brief Array modular multiplication: out[i] = (a[i] * b[i]) mod modulus
+     * @see add_mod() for the parameters and SIMD dispatch
+     */
+    void mul_mod(const ColorValue* a, const ColorValue* b, ColorValue* out, size_t count, uint32_t modulus);
+
+    /**
+     * @brief Array modular reduction in place: colors[i] = colors[i] mod modulus
+     *
+     * @param colors Array to reduce (count elements)
+     * @param count Number of elements
+     * @param modulus Modulus, 2 <= modulus <= 65536
+     * @throws std::invalid_argument if modulus is out of range
+     */
+    void reduce_mod(ColorValue* colors, size_t count, uint32_t modulus);
+
+    /**
+     * @brief Convert an array of RGB colors to HSV: out[i] = in[i].to_hsv()
+     *
+     * Results are bit-exact with ColorValue::to_hsv(). Whole vectors run as branch-free
+     * AVX2 (selected at run time) or AArch64 NEON kernels, the remainder per element.
+     *
+     * @param in Input colors (count elements)
+     * @param out Output colors (count elements); may alias in
+     * @param count Number of elements
+     */
+    void rgb_to_hsv(const ColorValue* in, ColorValue* out, size_t count);
+
+    /**
+     * @brief Convert an array of HSV colors to RGB: out[i] = in[i].from_hsv()
+     *
+     * Bit-exact with ColorValue::from_hsv().
+     * @see rgb_to_hsv() for the parameters and SIMD dispatch
+     */
+    void hsv_to_rgb(const ColorValue* in, ColorValue* out, size_t count);
+
 };
 
 } // namespace clwe
@@ -0,0 +1,129 @@
+/**
+ * @file container.hpp
+ * @brief Self-describing binary container for ColorKEM keys and ciphertexts
+ *
+ * The plain serialize()/deserialize() formats carry no parameters, so the
+ * reader must know the security level, encoding and ciphertext options out of
+ * band. A container prefixes the same bytes with a 24-byte header (28 bytes
+ * with a secret weight) that names the object and its CLWEParameters, and can
+ * append a CRC-32.
+ *
+ * @author ColorKEM Development Team
+ * @version 1.0.0
+ * @date 2024
+ *
+ * @see color_kem.hpp for the payload formats
+ */
+
+#ifndef CONTAINER_HPP
+#define CONTAINER_HPP
+
+#include "color_kem.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace clwe {
+
+/**
+ * @brief Object held by a container
+ */
+enum class ContainerType : uint8_t {
+    PUBLIC_KEY = 1,   /**< ColorPublicKey::serialize() payload */
+    PRIVATE_KEY = 2,  /**< ColorPrivateKey::serialize() payload */
+    CIPHERTEXT = 3    /**< ColorCiphertext::serialize() payload */
+};
+
+/**
+ * @brief Parsed container header
+ *
+ * Layout, integers big-endian like the payloads:
+ * - bytes 0-3: magic "CKEM"; byte 4: format version (1, or 2 with a secret
+ *   weight); byte 5: ContainerType
+ * - byte 6: flags (bit 0: CRC-32 trailer present, bit 1: sparse_c2, bit 2: AES256_CTR xof,
+ *   bit 3: shared_matrix)
+ * - byte 7: CoefficientEncoding (0 = COLOR32, 1 = PACKED12)
+ * - bytes 8-13: security level, degree and modulus, 16 bits each
+ * - bytes 14-18: module rank, eta1, eta2, du and dv, one byte each
+ * - byte 19: t_dropped_bits (0 unless public keys are rounded)
+ * - bytes 20-23: payload size
+ * - version 2 only: bytes 24-25 secret_weight (nonzero), bytes 26-27 zero
+ *
+ * Parameters without a secret weight are written as version 1, so readers
+ * that predate version 2 read them unchanged.
+ *
+ * The payload follows the header. With the checksum flag set, a CRC-32
+ * (IEEE 802.3) of the header and payload follows the payload.
+ */
+struct ContainerHeader {
+    static constexpr size_t BYTES = 24;      /**< Version 1 header size, the smallest */
+    static constexpr size_t MAX_BYTES = 28;  /**< Version 2 header size */
+
+    size_t header_size = BYTES;                      /**< BYTES or MAX_BYTES; the payload starts here */
+    ContainerType type = ContainerType::PUBLIC_KEY;  /**< Object in the container */
+    CLWEParameters params;                           /**< Parameters of the object */
+    bool has_checksum = false;                       /**< Whether a CRC-32 trailer follows the payload */
+    size_t payload_size = 0;                         /**< Payload bytes after the header */
+    size_t total_size = 0;                           /**< Header, payload and trailer */
+};
+
+/**
+ * @brief Read and validate a container header
+ *
+ * Constant time in the container size: only the first header_size bytes are read.
+ * The parameters are validated and the payload size must match the one they
+ * imply for the object type, so a framing layer can size a frame from the
+ * header alone. The checksum is not verified here.
+ *
+ * @param data Start of the container
+ * @param size Bytes available; at least ContainerHeader::BYTES, and
+ *        MAX_BYTES for a version 2 header
+ *
+ * @throws std::invalid_argument If the header is truncated, has an unknown
+ *         magic, version, type, flag or encoding, or is inconsistent
+ */
+ContainerHeader parse_container_header(const uint8_t* data, size_t size);
+
+/**
+ * @brief Wrap an object in a container
+ *
+ * @param checksum Append a CRC-32 of the header and payload
+ *
+ * @throws std::invalid_argument If the object is malformed for its parameters
+ */
+std::vector<uint8_t> to_container(const ColorPublicKey& public_key, bool checksum = true);
+std::vector<uint8_t> to_container(const ColorPrivateKey& private_key, bool checksum = true);
+std::vector<uint8_t> to_container(const ColorCiphertext& ciphertext, bool checksum = true);
+
+/**
+ * @brief Parse an object from a container, taking its parameters from the header
+ *
+ * size must be exactly the container's total_size. The checksum, when present,
+ * is verified before the payload is copied.
+ *
+ * @throws std::invalid_argument If the header is invalid (as parse_container_header()),
+ *         holds a different object type, size differs from total_size or the
+ *         checksum does not match
+ */
+ColorPublicKey public_key_from_container(const uint8_t* data, size_t size);
+ColorPublicKey public_key_from_container(const std::vector<uint8_t>& data);
+ColorPrivateKey private_key_from_container(const uint8_t* data, size_t size);
+ColorPrivateKey private_key_from_container(const std::vector<uint8_t>& data);
+ColorCiphertext ciphertext_from_container(const uint8_t* data, size_t size);
+ColorCiphertext ciphertext_from_container(const std::vector<uint8_t>& data);
+
+/**
+ * @brief View the object in a container without copying it
+ *
+ * As the *_from_container() functions, but the view points into data, which
+ * must outlive it. Suited to containers read from a mapped file or a receive
+ * buffer.
+ *
+ * @throws std::invalid_argument As public_key_from_container()
+ */
+ColorPublicKeyView view_public_key_container(const uint8_t* data, size_t size);
+ColorCiphertextView view_ciphertext_container(const uint8_t* data, size_t size);
+
+} // namespace clwe
+
+#endif // CONTAINER_HPP
@@ -30,7 +30,8 @@ enum class CPUArchitecture {
     X86_64,   /**< x86-64 (Intel/AMD) architecture */
     ARM64,    /**< ARM64 (AArch64) architecture */
     RISCV64,  /**< RISC-V 64-bit architecture */
-    PPC64     /**< PowerPC 64-bit architecture */
+    PPC64,    /**< PowerPC 64-bit architecture */
+    WASM32    /**< WebAssembly (wasm32) */
 };
 
 /** @brief SIMD instruction set support levels */
@@ -40,7 +41,9 @@ enum class SIMDSupport {
     AVX512,   /**< AVX-512 (512-bit vectors) */
     NEON,     /**< ARM NEON */
     RVV,      /**< RISC-V Vector extension */
-    VSX       /**< PowerPC VSX */
+    VSX,      /**< PowerPC VSX */
+    WASM_SIMD128, /**< WebAssembly 128-bit SIMD */
+    SVE       /**< ARM Scalable Vector Extension, any vector length; implies NEON */
 };
 
 /**
@@ -60,10 +63,15 @@ struct CPUFeatures {
     bool has_avx512dq = false;  /**< AVX-512 Doubleword/Quadword instructions */
     bool has_avx512bw = false;  /**< AVX-512 Byte/Word instructions */
     bool has_avx512vl = false;  /**< AVX-512 Vector Length extensions */
+    bool has_aes = false;       /**< AES-NI; on ARM64 the ARMv8 Crypto AES instructions */
+    bool has_vaes = false;      /**< VAES (AES rounds on YMM registers) */
 
     // ARM-specific features
     bool has_neon = false;      /**< ARM NEON SIMD support */
     bool has_sve = false;       /**< ARM Scalable Vector Extension */
+    bool has_sve2 = false;      /**< ARM SVE2 */
+    uint32_t sve_vlen = 0;      /**< SVE vector length in bits */
+    bool has_sha3 = false;      /**< ARMv8.2-SHA3 (EOR3, RAX1, XAR, BCAX) */
 
     // RISC-V specific features
     bool has_rvv = false;       /**< RISC-V Vector extension */
@@ -73,6 +81,9 @@ struct CPUFeatures {
     bool has_vsx = false;       /**< PowerPC VSX instructions */
     bool has_altivec = false;   /**< PowerPC AltiVec instructions */
 
+    // WebAssembly specific features
+    bool has_wasm_simd128 = false;  /**< Built with -msimd128; fixed at compile time, since such a module only loads where SIMD128 exists */
+
     /**
      * @brief Convert CPU features to human-readable string
      *
@@ -107,6 +118,53 @@ public:
      */
     static CPUFeatures detect();
 
+    /**
+     * @brief CPU features detected once per process
+     *
+     * Runs detect() on the first call and returns the same object afterwards,
+     * so hot paths and short-lived objects avoid repeated CPUID queries.
+     *
+     * @return const CPUFeatures& Process-wide detected features
+     *
+     * @note Thread-safe; initialization happens exactly once
+     *
+     * Every SIMD kernel (NTT, basemul, sampling, pack/unpack, Keccak) dispatches on
+     * these features. If a backend was forced through force_backend() or the
+     * CLWE_FORCE_BACKEND environment variable, the instruction sets above it are
+     * cleared here.
+     */
+    static const CPUFeatures& cached();
+
+    /**
+     * @brief Cap kernel dispatch at a backend, for A/B testing
+     *
+     * Equivalent to setting CLWE_FORCE_BACKEND, and takes precedence over it.
+     * Forcing a backend the CPU lacks does not enable it.
+     *
+     * @param backend Highest instruction set the kernels may use
+     *
+     * @throws std::logic_error If cached() already ran, since kernels latch their choice on first use
+     */
+    static void force_backend(SIMDSupport backend);
+
+    /**
+     * @brief Parse a CLWE_FORCE_BACKEND value
+     *
+     * @param name "scalar" (or "none"), "avx2", "avx512", "neon", "sve", "rvv", "vsx" or "wasm_simd128"
+     * @param backend Receives the parsed backend
+     * @return bool False if name is not recognized
+     */
+    static bool parse_backend(const std::string& name, SIMDSupport& backend);
+
+    /**
+     * @brief Clear every instruction set above a backend
+     *
+     * @param features Detected features
+     * @param backend Highest instruction set to keep
+     * @return CPUFeatures The restricted features, with max_simd_support lowered to match
+     */
+    static CPUFeatures restrict_to(const CPUFeatures& features, SIMDSupport backend);
+
 private:
     /** @brief Detect x86-64 specific features using CPUID */
     static CPUFeatures detect_x86();
@@ -120,6 +178,9 @@ private:
     /** @brief Detect PowerPC specific features */
     static CPUFeatures detect_ppc();
 
+    /** @brief Detect WebAssembly features, which the compiler fixes */
+    static CPUFeatures detect_wasm();
+
     /** @brief Detect the CPU architecture */
     static CPUArchitecture detect_architecture();
 
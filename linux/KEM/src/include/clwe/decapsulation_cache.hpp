@@ -0,0 +1,129 @@
+/**
+ * @file decapsulation_cache.hpp
+ * @brief Cache of decapsulation results for retransmitted ciphertexts
+ *
+ * This header defines DecapsulationCache, which remembers the shared secrets
+ * one private key derived for recently seen ciphertexts. Clients on lossy
+ * links resend the same handshake message; with the cache a resent ciphertext
+ * costs one SHAKE-256 digest and a table scan instead of a decapsulation.
+ *
+ * Example usage:
+ * @code
+ * clwe::DecapsulationCacheConfig config;
+ * config.ttl = std::chrono::seconds(10);
+ * clwe::DecapsulationCache cache(kem, kem.prepare_private_key(server_private), config);
+ *
+ * // Request thread
+ * clwe::ColorValue secret = cache.decapsulate(ciphertext, workspace);
+ * @endcode
+ *
+ * @author ColorKEM Development Team
+ * @version 1.0.0
+ * @date 2024
+ *
+ * @see prepared_key_registry.hpp for decapsulating under many tenants' keys
+ */
+
+#ifndef DECAPSULATION_CACHE_HPP
+#define DECAPSULATION_CACHE_HPP
+
+#include "color_kem.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace clwe {
+
+/** @brief Size and lifetime of a DecapsulationCache's entries */
+struct DecapsulationCacheConfig {
+    size_t capacity = 1024;                  /**< Results kept, rounded up to whole sets of WAYS */
+    std::chrono::milliseconds ttl{30000};    /**< How long a result is returned after it was derived */
+};
+
+/**
+ * @brief Bounded, expiring map from ciphertext digest to the secret derived from it
+ *
+ * Entries are indexed by a 32-byte SHAKE-256 digest of the parameter set,
+ * ciphertext and hint under a random key drawn at construction, so peers can
+ * neither predict which set a ciphertext lands in nor crowd out others'
+ * entries on purpose. Each set holds WAYS entries behind its own lock.
+ *
+ * A lookup compares the digest with every entry of its set and selects the
+ * secret with masks, without branching on digests or secrets; only whether
+ * it hit (which a miss's decapsulation shows anyway) decides what happens
+ * next. A miss decapsulates and stores the result in an empty or expired
+ * entry, else in the oldest one. Implicit rejection values are cached like
+ * any other result, so a resent invalid ciphertext still gets its rejection
+ * value back.
+ *
+ * Evicted and expired entries are wiped as they are replaced or as their set
+ * is next used, and clear() and the destructor wipe every entry.
+ *
+ * @note The ColorKEM must outlive the cache. All member functions are thread-safe.
+ */
+class DecapsulationCache {
+public:
+    /** @brief Entries per set */
+    static constexpr size_t WAYS = 8;
+
+    /**
+     * @brief Cache for a prepared key, serving decapsulate()
+     *
+     * @throws std::invalid_argument If capacity or ttl is 0, or the key belongs to other parameters
+     */
+    DecapsulationCache(const ColorKEM& kem, const PreparedPrivateKey& private_key,
+                       const DecapsulationCacheConfig& config = DecapsulationCacheConfig());
+
+    /**
+     * @brief Cache for a 256-bit mode key, serving decapsulate_key()
+     *
+     * @throws std::invalid_argument If capacity or ttl is 0, or the key belongs to other parameters
+     */
+    DecapsulationCache(const ColorKEM& kem, const ColorExpandedPrivateKey& private_key,
+                       const DecapsulationCacheConfig& config = DecapsulationCacheConfig());
+
+    /** @brief Securely erase every entry and the cache's copy of the key */
+    ~DecapsulationCache();
+
+    DecapsulationCache(const DecapsulationCache&) = delete;             /**< Copy constructor disabled */
+    DecapsulationCache& operator=(const DecapsulationCache&) = delete;  /**< Copy assignment disabled */
+
+    /**
+     * @brief ColorKEM::decapsulate() of the prepared key, or its cached result
+     *
+     * @throws std::logic_error If the cache was built for a 256-bit mode key
+     * @throws std::invalid_argument If the ciphertext is invalid (as ColorKEM::decapsulate())
+     */
+    ColorValue decapsulate(const ColorCiphertextView& ciphertext, KemWorkspace& workspace) const;
+    ColorValue decapsulate(const ColorCiphertext& ciphertext) const;
+
+    /**
+     * @brief ColorKEM::decapsulate_key() of the 256-bit mode key, or its cached result
+     *
+     * @throws std::logic_error If the cache was built for a prepared key
+     * @throws std::invalid_argument If the ciphertext is invalid (as ColorKEM::decapsulate_key())
+     */
+    SharedSecret decapsulate_key(const ColorCiphertextView& ciphertext, KemWorkspace& workspace) const;
+    SharedSecret decapsulate_key(const ColorCiphertext& ciphertext) const;
+
+    /** @brief Wipe every entry */
+    void clear();
+
+    /** @brief Entries the cache holds, a multiple of WAYS */
+    size_t capacity() const;
+
+    /** @brief Lookups answered from the cache, and lookups that decapsulated, since construction */
+    uint64_t hits() const;
+    uint64_t misses() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace clwe
+
+#endif // DECAPSULATION_CACHE_HPP
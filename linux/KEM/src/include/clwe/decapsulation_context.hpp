@@ -0,0 +1,125 @@
+/**
+ * @file decapsulation_context.hpp
+ * @brief Incremental ColorKEM decapsulation of a ciphertext received in pieces
+ *
+ * This header defines DecapsulationContext, which decapsulates a serialized
+ * ciphertext while its bytes are still arriving, for example segment by
+ * segment from a TCP socket. Each c1 polynomial is decoded, transformed and
+ * folded into s^T c1 as soon as its bytes are complete, and every byte is
+ * absorbed into the implicit-rejection hash on arrival, so the lattice work
+ * overlaps the receive and no contiguous copy of the ciphertext is kept.
+ *
+ * @author ColorKEM Development Team
+ * @version 1.0.0
+ * @date 2024
+ *
+ * @see color_kem.hpp for the one-shot decapsulate() overloads
+ */
+
+#ifndef DECAPSULATION_CONTEXT_HPP
+#define DECAPSULATION_CONTEXT_HPP
+
+#include "color_kem.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace clwe {
+
+/**
+ * @brief Streaming decapsulation with a prepared private key
+ *
+ * Fed the bytes of ColorCiphertext::serialize() (ciphertext data then the
+ * 4-byte hint) in any number of pieces of any size, finish() returns the same
+ * value as ColorKEM::decapsulate(private_key, ciphertext). Bytes are staged
+ * only while a polynomial straddles two pieces, so the context holds at most
+ * one encoded polynomial besides its decoded state.
+ *
+ * A context is reusable: finish() and reset() make it ready for the next
+ * ciphertext under the same key without allocating. All secret-dependent
+ * state is securely zeroed on reset and destruction.
+ *
+ * Example usage:
+ * @code
+ * clwe::DecapsulationContext context(kem, kem.prepare_private_key(sk));
+ * while (!context.complete()) {
+ *     size_t got = recv(socket, buffer, sizeof(buffer), 0);
+ *     context.feed(buffer, got);
+ * }
+ * clwe::ColorValue secret = context.finish();
+ * @endcode
+ *
+ * @note The ColorKEM must outlive the context. A context serves one stream at
+ *       a time; give each connection its own.
+ */
+class DecapsulationContext {
+public:
+    /**
+     * @brief Start decapsulating under a prepared private key
+     *
+     * @param kem Instance whose parameters the ciphertext uses
+     * @param private_key Key returned by kem.prepare_private_key()
+     *
+     * @throws std::invalid_argument If the key belongs to other parameters, or a
+     *         c1 polynomial of these parameters does not end on a byte boundary
+     */
+    DecapsulationContext(const ColorKEM& kem, const PreparedPrivateKey& private_key);
+
+    /** @brief Securely erase all state */
+    ~DecapsulationContext();
+
+    DecapsulationContext(DecapsulationContext&&) noexcept;             /**< Move constructor */
+    DecapsulationContext& operator=(DecapsulationContext&&) noexcept;  /**< Move assignment */
+    DecapsulationContext(const DecapsulationContext&) = delete;             /**< Copy constructor disabled */
+    DecapsulationContext& operator=(const DecapsulationContext&) = delete;  /**< Copy assignment disabled */
+
+    /**
+     * @brief Consume the next piece of the serialized ciphertext
+     *
+     * Decodes and accumulates every polynomial the piece completes. The piece
+     * itself is not retained.
+     *
+     * @param data Next bytes of the ciphertext; may be null when size is 0
+     * @param size Number of bytes
+     *
+     * @throws std::invalid_argument If the bytes would run past ciphertext_size()
+     */
+    void feed(const uint8_t* data, size_t size);
+
+    /**
+     * @brief Finish the ciphertext and recover the shared secret
+     *
+     * Runs the inverse NTT, decodes the message and applies the
+     * Fujisaki-Okamoto check exactly as ColorKEM::decapsulate(), then resets
+     * the context for the next ciphertext.
+     *
+     * @return ColorValue The recovered shared secret, or the rejection value
+     *
+     * @throws std::invalid_argument If fewer than ciphertext_size() bytes were fed;
+     *         the context is then reset
+     */
+    ColorValue finish();
+
+    /** @brief Drop any partial ciphertext and start over */
+    void reset();
+
+    /** @brief Serialized ciphertext size, ColorCiphertext::serialized_size() of the parameters */
+    size_t ciphertext_size() const;
+
+    /** @brief Bytes fed since the last finish() or reset() */
+    size_t bytes_received() const;
+
+    /** @brief Whether the whole ciphertext has been fed */
+    bool complete() const { return bytes_received() == ciphertext_size(); }
+
+    /** @brief Opaque decoding state, defined by the implementation */
+    struct State;
+
+private:
+    const ColorKEM* kem_;
+    std::unique_ptr<State> state_;
+};
+
+} // namespace clwe
+
+#endif // DECAPSULATION_CONTEXT_HPP
@@ -0,0 +1,97 @@
+/**
+ * @file device_provisioning.hpp
+ * @brief Bulk derivation of device key pairs into a key store file
+ *
+ * This header defines provision_devices(), the factory-line driver for
+ * ColorKEM::derive_keypair(). Worker threads derive the key pairs of a range
+ * of device ids in batches with ColorKEM::derive_keypair_batch(); the calling
+ * thread hands each private key to a sink in device order and streams the
+ * public keys into a KeyArchiveWriter, so record i of the file is the key of
+ * device first_device_id + i.
+ *
+ * Example usage:
+ * @code
+ * clwe::ColorKEM kem(clwe::CLWEParameters(768));
+ * clwe::ProvisioningReport report = clwe::provision_devices(
+ *     kem, master_seed, 0, 1000000, "fleet.clks",
+ *     [&](uint64_t device_id, const clwe::ColorPrivateKey& private_key) {
+ *         burn_station.write(device_id, private_key.serialize());
+ *     });
+ * std::printf("%.0f devices/s\n", report.devices_per_second);
+ * @endcode
+ *
+ * @author ColorKEM Development Team
+ * @version 1.0.0
+ * @date 2024
+ *
+ * @see color_kem.hpp for derive_keypair() and the seed derivation
+ * @see key_archive.hpp for the archive writer
+ */
+
+#ifndef DEVICE_PROVISIONING_HPP
+#define DEVICE_PROVISIONING_HPP
+
+#include "color_kem.hpp"
+#include "key_archive.hpp"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace clwe {
+
+/** @brief Threading and batching of provision_devices() */
+struct ProvisioningConfig {
+    size_t worker_threads = 0;   /**< Derivation threads; 0 uses std::thread::hardware_concurrency() */
+    size_t batch_size = 256;     /**< Devices per derive_keypair_batch() call */
+    size_t batches_in_flight = 0;  /**< Derived batches waiting to be written at most; 0 uses 2 per worker */
+    KeyArchiveOptions archive;   /**< Buffering of the archive writer */
+};
+
+/** @brief Outcome of a provision_devices() run */
+struct ProvisioningReport {
+    uint64_t devices = 0;                /**< Key pairs derived and written */
+    std::chrono::nanoseconds elapsed{0};  /**< Wall time from the first derivation to the renamed file */
+    double devices_per_second = 0.0;     /**< devices / elapsed */
+};
+
+/**
+ * @brief Receives each device's private key, in device order
+ *
+ * Called on the thread that runs provision_devices(). The key is wiped once
+ * the call returns; an exception thrown by the sink aborts the run.
+ */
+using DevicePrivateKeySink = std::function<void(uint64_t device_id, const ColorPrivateKey& private_key)>;
+
+/**
+ * @brief Derive the key pairs of count devices and write them to a key store file
+ *
+ * Devices first_device_id .. first_device_id + count - 1 get
+ * kem.derive_keypair(master_seed, id). At most batches_in_flight derived
+ * batches wait for the writer, which bounds memory however many devices are
+ * provisioned. On any failure the workers are stopped and joined, the
+ * temporary file is removed and any previous file at archive_path is kept.
+ *
+ * @param kem Instance whose parameters (and batch device) the keys use
+ * @param master_seed 32-byte provisioning master secret
+ * @param first_device_id Device id of record 0
+ * @param count Number of devices
+ * @param archive_path Key store file to create or replace
+ * @param private_keys Sink for the private keys; may be empty
+ * @param config Threading, batching and archive buffering
+ * @return ProvisioningReport Devices written and throughput
+ *
+ * @throws std::invalid_argument If batch_size is 0, the device ids overflow or
+ *         the parameters cannot be stored (as KeyArchiveWriter)
+ * @throws std::runtime_error If the file cannot be written
+ */
+ProvisioningReport provision_devices(const ColorKEM& kem, const std::array<uint8_t, 32>& master_seed,
+                                     uint64_t first_device_id, size_t count, const std::string& archive_path,
+                                     const DevicePrivateKeySink& private_keys = DevicePrivateKeySink(),
+                                     const ProvisioningConfig& config = ProvisioningConfig());
+
+} // namespace clwe
+
+#endif // DEVICE_PROVISIONING_HPP
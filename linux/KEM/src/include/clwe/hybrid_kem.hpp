@@ -0,0 +1,219 @@
+/**
+ * @file hybrid_kem.hpp
+ * @brief X25519 + ColorKEM hybrid key encapsulation
+ *
+ * This header defines HybridKEM, which pairs an X25519 key exchange with the
+ * 256-bit key mode of ColorKEM and derives one shared key from both, so the
+ * result stays secret while either half holds. The two halves run at the same
+ * time on two lanes, which makes a hybrid handshake cost about as much as its
+ * slower half instead of the sum of both.
+ *
+ * Keys and ciphertexts have one serialized form each: the X25519 part followed
+ * by the ColorKEM part, with sizes fixed by the parameter set.
+ *
+ * @author ColorKEM Development Team
+ * @version 1.0.0
+ * @date 2024
+ *
+ * @see https://www.rfc-editor.org/rfc/rfc7748 (X25519)
+ * @see async_kem.hpp for AsyncKemPost
+ */
+
+#ifndef HYBRID_KEM_HPP
+#define HYBRID_KEM_HPP
+
+#include "async_kem.hpp"
+#include "color_kem.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace clwe {
+
+/** @brief Size of X25519 scalars, public keys and shared secrets */
+constexpr size_t HYBRID_X25519_BYTES = 32;
+
+/**
+ * @brief Public key of HybridKEM
+ *
+ * Serialized as the X25519 public key (32 bytes) || ColorPublicKey::serialize().
+ */
+struct HybridPublicKey {
+    std::array<uint8_t, HYBRID_X25519_BYTES> x25519{};  /**< X25519 public key */
+    ColorPublicKey color;                               /**< ColorKEM public key */
+
+    std::vector<uint8_t> serialize() const;
+
+    /**
+     * @brief Serialize into a caller-provided buffer
+     *
+     * @return size_t Number of bytes written
+     * @throws std::invalid_argument If the key is malformed or out_size is too small
+     */
+    size_t serialize(uint8_t* out, size_t out_size) const;
+
+    /** @throws std::invalid_argument If the size is not serialized_size(params) */
+    static HybridPublicKey deserialize(const uint8_t* data, size_t size, const CLWEParameters& params);
+    static HybridPublicKey deserialize(const std::vector<uint8_t>& data, const CLWEParameters& params);
+
+    /** @brief Serialized size of a public key for the given parameters */
+    static size_t serialized_size(const CLWEParameters& params);
+};
+
+/**
+ * @brief Private key of HybridKEM
+ *
+ * Serialized as the X25519 scalar (32 bytes) || the X25519 public key
+ * (32 bytes) || ColorExpandedPrivateKey::serialize(). The public halves are
+ * embedded because the key derivation absorbs them.
+ *
+ * @warning Contains both private keys; erase x25519_secret and
+ *          color.secret_data with secure_zero() when done.
+ */
+struct HybridPrivateKey {
+    std::array<uint8_t, HYBRID_X25519_BYTES> x25519_secret{};  /**< X25519 scalar */
+    std::array<uint8_t, HYBRID_X25519_BYTES> x25519_public{};  /**< X25519 public key of the scalar */
+    ColorExpandedPrivateKey color;                             /**< ColorKEM private key with its public key */
+
+    std::vector<uint8_t> serialize() const;
+
+    /**
+     * @brief Serialize into a caller-provided buffer
+     *
+     * @return size_t Number of bytes written
+     * @throws std::invalid_argument If the key is malformed or out_size is too small
+     */
+    size_t serialize(uint8_t* out, size_t out_size) const;
+
+    /**
+     * @brief Parse a serialized private key
+     *
+     * @throws std::invalid_argument If the size is not serialized_size(params),
+     *         the X25519 public key is not that of the scalar, or the ColorKEM
+     *         part fails ColorExpandedPrivateKey::deserialize()
+     */
+    static HybridPrivateKey deserialize(const uint8_t* data, size_t size, const CLWEParameters& params);
+    static HybridPrivateKey deserialize(const std::vector<uint8_t>& data, const CLWEParameters& params);
+
+    /** @brief Serialized size of a private key for the given parameters */
+    static size_t serialized_size(const CLWEParameters& params);
+};
+
+/**
+ * @brief Ciphertext of HybridKEM
+ *
+ * Serialized as the ephemeral X25519 public key (32 bytes) ||
+ * ColorCiphertext::serialize() of an encapsulate_key() ciphertext.
+ */
+struct HybridCiphertext {
+    std::array<uint8_t, HYBRID_X25519_BYTES> x25519{};  /**< Ephemeral X25519 public key */
+    ColorCiphertext color;                              /**< ColorKEM key-mode ciphertext */
+
+    std::vector<uint8_t> serialize() const;
+
+    /**
+     * @brief Serialize into a caller-provided buffer
+     *
+     * @return size_t Number of bytes written
+     * @throws std::invalid_argument If the ciphertext is malformed or out_size is too small
+     */
+    size_t serialize(uint8_t* out, size_t out_size) const;
+
+    /** @throws std::invalid_argument If the size is not serialized_size(params) */
+    static HybridCiphertext deserialize(const uint8_t* data, size_t size, const CLWEParameters& params);
+    static HybridCiphertext deserialize(const std::vector<uint8_t>& data, const CLWEParameters& params);
+
+    /** @brief Serialized size of a ciphertext for the given parameters */
+    static size_t serialized_size(const CLWEParameters& params);
+};
+
+/**
+ * @brief Hybrid X25519 + ColorKEM key encapsulation
+ *
+ * Every operation runs its X25519 half on an executor lane while the calling
+ * thread runs the ColorKEM half. If the executor has not started the X25519
+ * half by the time the ColorKEM half is done, the calling thread runs it
+ * itself, so a busy or exhausted pool degrades to sequential execution
+ * instead of blocking. Without an AsyncKemPost the instance owns one lane
+ * thread; servers with many concurrent handshakes should pass their pool.
+ *
+ * The shared key is SHAKE256 over a domain label, the ColorKEM shared key,
+ * the X25519 shared secret, the ephemeral and static X25519 public keys and
+ * the ColorKEM ciphertext, absorbed piece by piece without building a
+ * concatenated KDF input.
+ *
+ * Example usage:
+ * @code
+ * clwe::HybridKEM kem(clwe::CLWEParameters(768));
+ * auto [public_key, private_key] = kem.keygen();
+ * auto [ciphertext, shared_key] = kem.encapsulate(public_key);
+ * send(ciphertext.serialize());
+ * // Receiver:
+ * clwe::SharedSecret same_key = kem.decapsulate(private_key, ciphertext);
+ * @endcode
+ *
+ * @note All member functions are thread-safe.
+ */
+class HybridKEM {
+public:
+    /**
+     * @brief Create the hybrid KEM
+     *
+     * @param params Parameters of the ColorKEM half
+     * @param post Executor for the X25519 lane; empty uses a lane thread owned by the instance
+     *
+     * @throws std::invalid_argument If the parameters do not support the
+     *         256-bit key mode (ColorKEM::encapsulate_key())
+     */
+    explicit HybridKEM(const CLWEParameters& params, AsyncKemPost post = AsyncKemPost());
+
+    /** @brief Stop the lane thread, if the instance owns one */
+    ~HybridKEM();
+
+    HybridKEM(const HybridKEM&) = delete;             /**< Copy constructor disabled */
+    HybridKEM& operator=(const HybridKEM&) = delete;  /**< Copy assignment disabled */
+
+    /** @brief Parameters of the ColorKEM half */
+    const CLWEParameters& params() const;
+
+    /**
+     * @brief Generate a hybrid key pair
+     *
+     * @return std::pair<HybridPublicKey, HybridPrivateKey> Public and private key
+     * @throws std::runtime_error If random number generation fails
+     */
+    std::pair<HybridPublicKey, HybridPrivateKey> keygen() const;
+
+    /**
+     * @brief Encapsulate a fresh shared key to a public key
+     *
+     * @param public_key Recipient's hybrid public key
+     * @return std::pair<HybridCiphertext, SharedSecret> Ciphertext and 32-byte shared key
+     *
+     * @throws std::invalid_argument If the ColorKEM key is invalid for these
+     *         parameters or the X25519 key has small order (an all-zero shared secret)
+     */
+    std::pair<HybridCiphertext, SharedSecret> encapsulate(const HybridPublicKey& public_key) const;
+
+    /**
+     * @brief Recover the shared key of an encapsulate() ciphertext
+     *
+     * A tampered ColorKEM ciphertext yields an implicit-rejection key, as
+     * ColorKEM::decapsulate_key() does, so the result differs from the sender's.
+     *
+     * @throws std::invalid_argument If the key or ciphertext does not match
+     *         these parameters, or the ephemeral X25519 key has small order
+     */
+    SharedSecret decapsulate(const HybridPrivateKey& private_key, const HybridCiphertext& ciphertext) const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace clwe
+
+#endif // HYBRID_KEM_HPP
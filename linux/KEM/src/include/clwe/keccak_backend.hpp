@@ -0,0 +1,158 @@
+/**
+ * @file keccak_backend.hpp
+ * @brief Selectable Keccak implementations behind the SHAKE samplers
+ *
+ * Every SHAKE stream in the library (matrix expansion, noise sampling,
+ * message hashing) runs on one of several Keccak backends, selected at run
+ * time. Integrators can benchmark the available ones with clwe_bench
+ * (the "Keccak/..." benchmarks, one per backend) and pin the fastest for their
+ * hardware with set_keccak_backend() or the CLWE_KECCAK_BACKEND environment
+ * variable.
+ *
+ * All backends produce identical output; only the speed differs.
+ *
+ * @author ColorKEM Development Team
+ * @version 1.0.0
+ * @date 2024
+ *
+ * @see SHAKE128Sampler, SHAKE256Sampler, SHAKE128x4Sampler, SHAKE256x4Sampler
+ */
+
+#ifndef KECCAK_BACKEND_HPP
+#define KECCAK_BACKEND_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace clwe {
+
+/**
+ * @brief Keccak implementation used by the SHAKE samplers
+ *
+ * Each backend covers both sampler shapes: single streams
+ * (SHAKE128Sampler, SHAKE256Sampler) and the four-lane batch samplers
+ * (SHAKE128x4Sampler, SHAKE256x4Sampler).
+ */
+enum class KeccakBackend {
+    Reference,  /**< Bundled portable Keccak-f[1600]; four-lane batches permute one state at a time */
+    Simd,       /**< Bundled single-stream Keccak; four-lane batches on AVX2, ARMv8.2-SHA3 or WebAssembly SIMD128 */
+    OpenSSL,    /**< OpenSSL EVP SHAKE (3.3+, digest fetched once) for single streams; SIMD batches */
+    XKCP,       /**< XKCP's optimized permutation (CLWE_WITH_XKCP builds) for single streams; SIMD batches */
+    ArmSha3     /**< ARMv8.2-SHA3 (EOR3, RAX1, XAR, BCAX) permutation for single streams and batches */
+};
+
+/**
+ * @brief Whether a backend was compiled in and can run on this CPU
+ *
+ * Reference is always available. Simd needs AVX2, ARMv8.2-SHA3 or a
+ * WebAssembly build with SIMD128, ArmSha3 ARMv8.2-SHA3 (CPUFeatures::has_sha3). OpenSSL needs a build against OpenSSL
+ * 3.3 or later. XKCP needs a build with CLWE_WITH_XKCP.
+ */
+bool keccak_backend_available(KeccakBackend backend);
+
+/**
+ * @brief Available backends, in the order the default is chosen from
+ *
+ * XKCP, ArmSha3, OpenSSL, Simd, Reference; the first available one is the
+ * default.
+ */
+std::vector<KeccakBackend> available_keccak_backends();
+
+/**
+ * @brief Backend the samplers use from their next init()/begin() on
+ *
+ * Initially CLWE_KECCAK_BACKEND if it names an available backend, else the
+ * first of available_keccak_backends().
+ */
+KeccakBackend keccak_backend();
+
+/**
+ * @brief Select the backend for subsequently initialized samplers
+ *
+ * Thread-safe. A sampler keeps the backend it was initialized with until it is
+ * initialized again, so switching never corrupts a stream in progress.
+ *
+ * @throws std::invalid_argument If the backend is not available
+ */
+void set_keccak_backend(KeccakBackend backend);
+
+/** @brief "reference", "simd", "openssl", "xkcp" or "armsha3" */
+const char* keccak_backend_name(KeccakBackend backend);
+
+/**
+ * @brief Parse a CLWE_KECCAK_BACKEND value
+ *
+ * @param name One of the names keccak_backend_name() returns
+ * @param backend Receives the parsed backend
+ * @return bool False if name is not recognized
+ */
+bool parse_keccak_backend(const std::string& name, KeccakBackend& backend);
+
+/**
+ * @brief Permutation-level operations of a single-stream backend
+ *
+ * The state is opaque, 200 bytes aligned to 64; XKCP keeps it in its own
+ * (for example lane-complemented) representation, so the sponge only touches
+ * it through these functions.
+ */
+struct KeccakOps {
+    /** @brief Set the state to all zeros */
+    void (*initialize)(void* state);
+    /** @brief XOR length bytes of data into the state, starting at byte offset */
+    void (*add_bytes)(void* state, const uint8_t* data, size_t offset, size_t length);
+    /** @brief Copy length state bytes, starting at byte offset, to out */
+    void (*extract_bytes)(const void* state, uint8_t* out, size_t offset, size_t length);
+    /** @brief Apply Keccak-f[1600] */
+    void (*permute)(void* state);
+};
+
+/**
+ * @brief Operations of a backend's single-stream path
+ *
+ * @return const KeccakOps* nullptr for OpenSSL, which works at the sponge level
+ */
+const KeccakOps* keccak_ops(KeccakBackend backend);
+
+/** @brief Four-lane Keccak-f[1600] on a lane-major state[lane][instance] */
+using KeccakF1600x4Fn = void (*)(uint64_t state[25][4]);
+
+/** @brief Four-lane permutation of a backend's batch path */
+KeccakF1600x4Fn keccakf1600_x4_for(KeccakBackend backend);
+
+/**
+ * @brief SHAKE sponge over a backend's KeccakOps
+ *
+ * begin(), any number of absorb() calls, finalize(), then squeeze() as often
+ * as needed.
+ */
+class KeccakSponge {
+private:
+    alignas(64) uint8_t state_[200];
+    const KeccakOps* ops_ = nullptr;
+    size_t rate_ = 0;
+    size_t pos_ = 0;
+
+public:
+    /**
+     * @brief Start a new stream
+     *
+     * @param ops Backend operations; must not be nullptr
+     * @param rate Rate in bytes (SHAKE128_RATE or SHAKE256_RATE)
+     */
+    void begin(const KeccakOps* ops, size_t rate);
+
+    /** @brief Absorb input; only valid before finalize() */
+    void absorb(const uint8_t* data, size_t len);
+
+    /** @brief Apply the SHAKE padding and switch to squeezing */
+    void finalize();
+
+    /** @brief Squeeze output bytes */
+    void squeeze(uint8_t* out, size_t len);
+};
+
+} // namespace clwe
+
+#endif // KECCAK_BACKEND_HPP
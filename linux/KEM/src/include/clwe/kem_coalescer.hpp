@@ -0,0 +1,114 @@
+/**
+ * @file kem_coalescer.hpp
+ * @brief Automatic batching of concurrent single-operation KEM calls
+ *
+ * This header defines KemCoalescer, which lets request handlers keep calling
+ * encapsulate and decapsulate one request at a time while the work runs
+ * through the batch calls of ColorKEM. Calls that arrive while a batch is
+ * running are held for a short window, or until a batch is full, and then
+ * run together; each caller gets its result through a std::future.
+ *
+ * @author ColorKEM Development Team
+ * @version 1.0.0
+ * @date 2024
+ *
+ * @see async_kem.hpp for handler-based batching on an executor
+ */
+
+#ifndef KEM_COALESCER_HPP
+#define KEM_COALESCER_HPP
+
+#include "color_kem.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <utility>
+
+namespace clwe {
+
+/** @brief Batching limits of a KemCoalescer */
+struct KemCoalescerConfig {
+    size_t max_batch = 16;                       /**< Most requests run by one batch call */
+    std::chrono::microseconds window{100};       /**< Longest a request waits for its batch to fill */
+};
+
+/**
+ * @brief Collects concurrent encapsulate/decapsulate calls into batch calls
+ *
+ * One dispatcher thread owned by the coalescer runs the batches, each with
+ * whatever is queued, up to max_batch. Requests that arrive while a batch is
+ * running queue up. While requests do not overlap (the last batch held one),
+ * the next batch starts at once, so a lightly loaded service sees the latency
+ * of a direct call plus one thread handoff. Once they do, the next batch
+ * starts when max_batch requests are queued or the oldest has waited for
+ * window, whichever comes first. Under load, batches therefore grow toward
+ * max_batch while no request waits much longer than window plus one batch.
+ *
+ * Encapsulations go through encapsulate_batch() and decapsulations through
+ * decapsulate_batch(). Requests for the same key thus share its expanded
+ * matrix or parsed secret. If a batch call throws, its requests are rerun
+ * one by one, so an invalid input fails only its own future.
+ *
+ * Example usage:
+ * @code
+ * clwe::KemCoalescer coalescer(kem);
+ * // Any request thread
+ * auto [ciphertext, secret] = coalescer.encapsulate(client_key).get();
+ * @endcode
+ *
+ * @note The ColorKEM must outlive the coalescer. All member functions are thread-safe.
+ */
+class KemCoalescer {
+public:
+    /**
+     * @brief Start the dispatcher thread
+     *
+     * @param kem Instance that runs the batches
+     * @param config Batching limits
+     *
+     * @throws std::invalid_argument If config.max_batch is 0
+     */
+    explicit KemCoalescer(const ColorKEM& kem, const KemCoalescerConfig& config = KemCoalescerConfig());
+
+    /** @brief Run the queued requests, then stop the dispatcher thread */
+    ~KemCoalescer();
+
+    KemCoalescer(const KemCoalescer&) = delete;             /**< Copy constructor disabled */
+    KemCoalescer& operator=(const KemCoalescer&) = delete;  /**< Copy assignment disabled */
+
+    /**
+     * @brief Queue an encapsulation
+     *
+     * @param public_key Recipient's public key, copied into the request
+     * @return std::future Ciphertext and shared secret, or the exception
+     *         encapsulate() would throw
+     */
+    std::future<std::pair<ColorCiphertext, ColorValue>> encapsulate(const ColorPublicKey& public_key);
+
+    /**
+     * @brief Queue a decapsulation
+     *
+     * @param public_key Public key of the key pair
+     * @param private_key Private key, copied into the request and wiped after use
+     * @param ciphertext Ciphertext to decapsulate
+     * @return std::future Shared secret, or the exception decapsulate() would throw
+     */
+    std::future<ColorValue> decapsulate(const ColorPublicKey& public_key, const ColorPrivateKey& private_key,
+                                        const ColorCiphertext& ciphertext);
+
+    /** @brief Requests queued since construction */
+    uint64_t requests() const;
+
+    /** @brief Batches run since construction; requests() / batches() is the mean batch size */
+    uint64_t batches() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace clwe
+
+#endif // KEM_COALESCER_HPP
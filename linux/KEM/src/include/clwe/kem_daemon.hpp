@@ -0,0 +1,202 @@
+/**
+ * @file kem_daemon.hpp
+ * @brief Host-wide KEM service over shared-memory request rings
+ *
+ * KemDaemon (run by the clwe-kemd executable) owns one tuned ColorKEM per
+ * security level for the whole host, with its tables, expanded-key caches and
+ * executor. Processes use it through KemClient instead of embedding their own
+ * ColorKEM.
+ *
+ * A client connects to the daemon's Unix socket once. The daemon answers
+ * with a memfd holding the client's request ring and an eventfd doorbell.
+ * After that, requests never touch the socket. The client serializes each
+ * key and ciphertext straight into a slot of the shared mapping and publishes
+ * the slot index on a lock-free single-producer ring. The daemon drains the
+ * rings of all clients, runs the requests as encapsulate_batch() and
+ * decapsulate_batch() calls grouped by level, and writes each result back
+ * into its slot. Either side sleeps on a futex or the eventfd only when it
+ * finds no work, so a loaded daemon makes no syscalls per request.
+ *
+ * Linux only (memfd, futex, SCM_RIGHTS).
+ *
+ * @author ColorKEM Development Team
+ * @version 1.0.0
+ * @date 2024
+ *
+ * @see async_kem.hpp for in-process batching
+ */
+
+#ifndef KEM_DAEMON_HPP
+#define KEM_DAEMON_HPP
+
+#include "color_kem.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace clwe {
+
+/** @brief Configuration of a KemDaemon */
+struct KemDaemonConfig {
+    std::string socket_path = "/run/clwe-kemd.sock";  /**< Unix socket clients connect to */
+    uint32_t socket_mode = 0600;  /**< Permissions of the socket file; keys pass through the daemon */
+    size_t ring_slots = 64;       /**< Default requests in flight per client, rounded up to a power of two */
+    size_t max_ring_slots = 1024; /**< Largest ring a client may ask for */
+    size_t max_batch = 256;       /**< Most requests of one kind and level per batch call */
+    size_t max_clients = 256;     /**< Further connections are refused */
+    KemExecutor executor;         /**< Passed to every engine's ColorKEM::set_executor(); may be empty */
+};
+
+/**
+ * @brief The host-wide KEM service
+ *
+ * run() serves clients on the calling thread until stop(). Engines for a
+ * security level are created when the first client for that level
+ * connects and live as long as the daemon.
+ *
+ * A client that breaks the ring protocol (bad slot index, impossible
+ * counters) is disconnected. Other clients are not affected.
+ *
+ * @note stop(), client_count() and requests_served() are thread-safe; run()
+ *       may be called once at a time.
+ */
+class KemDaemon {
+public:
+    /**
+     * @brief Bind and listen on config.socket_path
+     *
+     * A stale socket file at the path is replaced.
+     *
+     * @throws std::invalid_argument If ring_slots, max_ring_slots, max_batch or max_clients is 0
+     * @throws std::runtime_error If the socket cannot be created
+     */
+    explicit KemDaemon(KemDaemonConfig config);
+
+    /** @brief Disconnect all clients and remove the socket file */
+    ~KemDaemon();
+
+    KemDaemon(const KemDaemon&) = delete;             /**< Copy constructor disabled */
+    KemDaemon& operator=(const KemDaemon&) = delete;  /**< Copy assignment disabled */
+
+    /** @brief Serve clients until stop() */
+    void run();
+
+    /** @brief Make run() return after the current pass; callable from any thread */
+    void stop();
+
+    /** @brief Clients currently connected */
+    size_t client_count() const;
+
+    /** @brief Requests answered since construction, successful or not */
+    uint64_t requests_served() const;
+
+    /** @brief The socket clients connect to */
+    const std::string& socket_path() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+/**
+ * @brief Connection of one process to a KemDaemon
+ *
+ * The blocking calls submit a request and wait for it. The submit_* / wait_*
+ * pairs keep up to ring_slots() requests in flight, which is what lets the
+ * daemon batch a single client's requests too. A submit_* call blocks while
+ * every slot is busy.
+ *
+ * Example usage:
+ * @code
+ * clwe::KemClient kem("/run/clwe-kemd.sock", 768);
+ * auto [ciphertext, secret] = kem.encapsulate(public_key);
+ * @endcode
+ *
+ * @note All member functions are thread-safe. Each ticket must be waited for
+ *       exactly once.
+ */
+class KemClient {
+public:
+    /** @brief Identifies a submitted request */
+    using Ticket = uint32_t;
+
+    /**
+     * @brief Connect and map the request ring
+     *
+     * @param socket_path The daemon's socket
+     * @param security_level Level of every request on this connection
+     * @param ring_slots Requests in flight; 0 takes the daemon's default
+     *
+     * @throws std::runtime_error If the daemon is unreachable or refuses the connection
+     */
+    KemClient(const std::string& socket_path, uint32_t security_level, size_t ring_slots = 0);
+
+    /** @brief Unmap the ring and close the connection */
+    ~KemClient();
+
+    KemClient(const KemClient&) = delete;             /**< Copy constructor disabled */
+    KemClient& operator=(const KemClient&) = delete;  /**< Copy assignment disabled */
+
+    /** @brief Parameters of the connection's level */
+    const CLWEParameters& params() const;
+
+    /** @brief Requests that can be in flight at once */
+    size_t ring_slots() const;
+
+    /**
+     * @brief Encapsulate on the daemon
+     *
+     * @throws std::invalid_argument If the daemon rejects public_key
+     * @throws std::runtime_error If the daemon fails or disconnects
+     */
+    std::pair<ColorCiphertext, ColorValue> encapsulate(const ColorPublicKey& public_key);
+
+    /**
+     * @brief Decapsulate on the daemon
+     *
+     * The private key is copied into the shared ring, which is wiped once the
+     * daemon has answered.
+     *
+     * @throws std::invalid_argument If the daemon rejects an input
+     * @throws std::runtime_error If the daemon fails or disconnects
+     */
+    ColorValue decapsulate(const ColorPublicKey& public_key, const ColorPrivateKey& private_key,
+                           const ColorCiphertext& ciphertext);
+
+    /**
+     * @brief Queue an encapsulation; collect it with wait_encapsulate()
+     *
+     * @throws std::invalid_argument If public_key is for other parameters
+     */
+    Ticket submit_encapsulate(const ColorPublicKey& public_key);
+
+    /**
+     * @brief Queue a decapsulation; collect it with wait_decapsulate()
+     *
+     * @throws std::invalid_argument If an input is for other parameters
+     */
+    Ticket submit_decapsulate(const ColorPublicKey& public_key, const ColorPrivateKey& private_key,
+                              const ColorCiphertext& ciphertext);
+
+    /**
+     * @brief Wait for a submitted encapsulation and release its slot
+     *
+     * @throws std::invalid_argument If the daemon rejected the request
+     * @throws std::runtime_error If the daemon failed or disconnected
+     * @throws std::logic_error If ticket is not an outstanding encapsulation
+     */
+    std::pair<ColorCiphertext, ColorValue> wait_encapsulate(Ticket ticket);
+
+    /** @brief Wait for a submitted decapsulation and release its slot; throws as wait_encapsulate() */
+    ColorValue wait_decapsulate(Ticket ticket);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace clwe
+
+#endif // KEM_DAEMON_HPP
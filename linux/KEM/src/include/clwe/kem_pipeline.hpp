@@ -0,0 +1,186 @@
+/**
+ * @file kem_pipeline.hpp
+ * @brief Staged (SEDA-style) KEM server engine
+ *
+ * This header defines KemPipeline, which splits serving a KEM request into
+ * four stages, each with its own threads, connected by bounded lock-free
+ * queues:
+ *
+ *   parse      deserialize and validate the peer's public key or ciphertext
+ *   prepare    look up the key: the expanded form of a public key, or the
+ *              prepared form of a registered private key
+ *   compute    the lattice work, a batch of queued requests at a time
+ *   serialize  encode the ciphertext and hand the response to the callback
+ *
+ * Per-stage queue depths and service times (stats()) show which stage is the
+ * bottleneck, so cores can be moved between stages by changing the thread
+ * counts.
+ *
+ * Example usage:
+ * @code
+ * clwe::KemPipelineConfig config;
+ * config.compute_threads = 6;
+ * clwe::KemPipeline pipeline(kem, config, [](clwe::KemPipelineResponse&& response) {
+ *     send(response.id, response.ciphertext, response.shared_secret);
+ * });
+ * pipeline.add_private_key(server_public.fingerprint(), server_private);
+ * pipeline.submit({connection_id, clwe::KemPipelineOp::DECAPSULATE, std::move(bytes),
+ *                  server_public.fingerprint()});
+ * @endcode
+ *
+ * @author ColorKEM Development Team
+ * @version 1.0.0
+ * @date 2024
+ *
+ * @see kem_coalescer.hpp for future-based batching on one dispatcher thread
+ */
+
+#ifndef KEM_PIPELINE_HPP
+#define KEM_PIPELINE_HPP
+
+#include "color_kem.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace clwe {
+
+/** @brief Stages of a KemPipeline, in the order a request passes them */
+enum class KemPipelineStage {
+    PARSE = 0,
+    PREPARE = 1,
+    COMPUTE = 2,
+    SERIALIZE = 3
+};
+
+/** @brief Number of KemPipelineStage values */
+constexpr size_t KEM_PIPELINE_STAGES = 4;
+
+/** @brief Operation a KemPipelineRequest asks for */
+enum class KemPipelineOp {
+    ENCAPSULATE,  /**< payload is a serialized ColorPublicKey */
+    DECAPSULATE   /**< payload is a serialized ColorCiphertext for a registered private key */
+};
+
+/** @brief Threads and queue sizes of a KemPipeline */
+struct KemPipelineConfig {
+    size_t parse_threads = 1;
+    size_t prepare_threads = 1;
+    size_t compute_threads = 2;
+    size_t serialize_threads = 1;
+    size_t queue_capacity = 1024;     /**< Requests each stage's input queue holds, rounded up to a power of two */
+    size_t max_batch = 16;            /**< Most requests one compute step takes from its queue */
+    size_t expanded_key_capacity = 64;  /**< Public keys the prepare stage keeps expanded */
+};
+
+/** @brief One request to a KemPipeline */
+struct KemPipelineRequest {
+    uint64_t id = 0;                          /**< Returned with the response */
+    KemPipelineOp op = KemPipelineOp::ENCAPSULATE;
+    std::vector<uint8_t> payload;             /**< Serialized public key or ciphertext */
+    std::array<uint8_t, 32> private_key{};    /**< Decapsulation: fingerprint the key was added under */
+};
+
+/** @brief Result of one KemPipelineRequest */
+struct KemPipelineResponse {
+    uint64_t id = 0;
+    KemPipelineOp op = KemPipelineOp::ENCAPSULATE;
+    /**
+     * @brief SUCCESS, INVALID_KEY (malformed or unregistered key),
+     *        INVALID_CIPHERTEXT, or UNKNOWN_ERROR if the operation threw
+     */
+    CLWEError error = CLWEError::SUCCESS;
+    std::vector<uint8_t> ciphertext;          /**< Encapsulation: ColorCiphertext::serialize() bytes */
+    ColorValue shared_secret;
+};
+
+/** @brief Called on a serialize thread with each finished response */
+using KemPipelineCallback = std::function<void(KemPipelineResponse&& response)>;
+
+/** @brief Load of one stage, as returned by KemPipeline::stats() */
+struct KemPipelineStageStats {
+    size_t threads = 0;
+    size_t queue_depth = 0;         /**< Requests waiting in the stage's input queue now */
+    size_t queue_capacity = 0;
+    size_t max_queue_depth = 0;     /**< Deepest the input queue has been */
+    uint64_t processed = 0;         /**< Requests the stage has finished */
+    double mean_service_us = 0;     /**< Busy time per request */
+    double utilization = 0;         /**< Busy time over threads times the pipeline's lifetime, 0 to 1 */
+};
+
+/**
+ * @brief KEM requests served by a pipeline of thread stages
+ *
+ * A stage thread takes requests from its input queue, processes them and
+ * pushes them into the next stage's queue. When that queue is full it waits,
+ * so a slow stage pushes back up to submit(). Threads that find their queue
+ * empty spin briefly, then sleep until a request arrives.
+ *
+ * The compute stage takes up to max_batch queued requests per step and draws
+ * the encapsulation randomness for all of them at once, as encapsulate_batch()
+ * does. Each compute thread keeps its own KemWorkspace, and the inputs are
+ * the expanded public keys and prepared private keys the prepare stage
+ * resolved, so the batch does no key parsing or matrix expansion for keys
+ * seen before.
+ *
+ * A request that fails a stage skips the rest and reaches the callback with
+ * its error. Responses can arrive out of submission order; match them by id.
+ *
+ * @note The ColorKEM must outlive the pipeline. All member functions are thread-safe.
+ */
+class KemPipeline {
+public:
+    /**
+     * @brief Start the stage threads
+     *
+     * @throws std::invalid_argument If a thread count, queue_capacity, max_batch or
+     *         expanded_key_capacity is 0, or callback is empty
+     */
+    KemPipeline(const ColorKEM& kem, const KemPipelineConfig& config, KemPipelineCallback callback);
+
+    /** @brief Finish every submitted request, then stop the threads and wipe the private keys */
+    ~KemPipeline();
+
+    KemPipeline(const KemPipeline&) = delete;             /**< Copy constructor disabled */
+    KemPipeline& operator=(const KemPipeline&) = delete;  /**< Copy assignment disabled */
+
+    /**
+     * @brief Make a private key available to DECAPSULATE requests under fingerprint
+     *
+     * The key is prepared here, once. Adding under an existing fingerprint replaces that key.
+     *
+     * @throws std::invalid_argument If the key does not belong to the pipeline's ColorKEM
+     */
+    void add_private_key(const std::array<uint8_t, 32>& fingerprint, const ColorPrivateKey& private_key);
+
+    /** @brief Drop a private key; returns whether one was registered */
+    bool remove_private_key(const std::array<uint8_t, 32>& fingerprint);
+
+    /**
+     * @brief Queue a request if the parse queue has room
+     *
+     * @return bool False, leaving request unchanged, if the queue is full
+     */
+    bool try_submit(KemPipelineRequest& request);
+
+    /** @brief Queue a request, waiting while the parse queue is full */
+    void submit(KemPipelineRequest request);
+
+    /** @brief Load of every stage, indexed by KemPipelineStage */
+    std::array<KemPipelineStageStats, KEM_PIPELINE_STAGES> stats() const;
+
+    /** @brief Requests submitted, and responses handed to the callback */
+    uint64_t submitted() const;
+    uint64_t completed() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace clwe
+
+#endif // KEM_PIPELINE_HPP
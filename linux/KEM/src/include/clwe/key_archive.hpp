@@ -0,0 +1,222 @@
+/**
+ * @file key_archive.hpp
+ * @brief Streaming import and export of key store files
+ *
+ * This header defines KeyArchiveWriter and KeyArchiveReader, which move large
+ * public key sets into and out of the KeyStore file format without holding the
+ * set in memory. Records are packed straight into a fixed set of page-aligned
+ * buffers and written or read with several transfers in flight: on Linux
+ * through io_uring, with the buffers and the file registered once so each
+ * batch of transfers is a single system call; elsewhere, or where the kernel
+ * refuses a ring, through pread/pwrite on a few worker threads. The archive is
+ * one file opened once, however many keys it holds.
+ *
+ * @author ColorKEM Development Team
+ * @version 1.0.0
+ * @date 2024
+ *
+ * @see key_store.hpp for the file layout and memory-mapped lookups
+ */
+
+#ifndef KEY_ARCHIVE_HPP
+#define KEY_ARCHIVE_HPP
+
+#include "color_kem.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace clwe {
+
+class BulkFileIo;
+
+/** @brief How archive transfers reach the file */
+enum class BulkIoBackend {
+    Auto,     /**< io_uring where the kernel offers it, otherwise Threaded */
+    IoUring,  /**< Linux io_uring with registered buffers and file */
+    Threaded  /**< pread/pwrite on a few worker threads */
+};
+
+/** @brief "auto", "io_uring" or "threaded" */
+const char* bulk_io_backend_name(BulkIoBackend backend);
+
+/** @brief Buffering of a KeyArchiveWriter or KeyArchiveReader */
+struct KeyArchiveOptions {
+    BulkIoBackend backend = BulkIoBackend::Auto;  /**< Transfer backend */
+    size_t buffer_bytes = size_t(1) << 20;        /**< Size of each buffer, raised to hold at least one record */
+    size_t buffer_count = 8;                      /**< Buffers, and so transfers, in flight at most */
+    size_t submit_batch = 4;                      /**< Transfers handed to the kernel per system call */
+};
+
+/**
+ * @brief Streams public keys into a new key store file
+ *
+ * Example usage:
+ * @code
+ * clwe::KeyArchiveWriter writer("directory.clks", params);
+ * for (const auto& key : incoming_keys) {
+ *     writer.append(key);
+ * }
+ * writer.finish();
+ *
+ * clwe::KeyStore store = clwe::KeyStore::open("directory.clks");
+ * @endcode
+ *
+ * The file is built as path + ".tmp" and renamed over path by finish(). A
+ * writer destroyed before finish(), or whose finish() fails, removes the
+ * temporary and leaves any previous file at path as it was. Besides the file,
+ * the writer keeps 40 bytes per key for the seed index. Not thread-safe.
+ */
+class KeyArchiveWriter {
+public:
+    /**
+     * @brief Create path + ".tmp" for writing
+     *
+     * @throws std::invalid_argument If params are invalid or the modulus does
+     *         not fit in 12 bits
+     * @throws std::runtime_error If the file cannot be created, or
+     *         BulkIoBackend::IoUring was asked for and is unavailable
+     */
+    KeyArchiveWriter(const std::string& path, const CLWEParameters& params,
+                     const KeyArchiveOptions& options = KeyArchiveOptions());
+    ~KeyArchiveWriter();
+
+    KeyArchiveWriter(const KeyArchiveWriter&) = delete;
+    KeyArchiveWriter& operator=(const KeyArchiveWriter&) = delete;
+
+    /**
+     * @brief Append one key as the next record
+     *
+     * @throws std::invalid_argument If the key's parameters differ from the
+     *         writer's, its data size is wrong or a coefficient is not reduced
+     *         mod q; the key is not appended and the writer stays usable
+     * @throws std::runtime_error If a write fails
+     * @throws std::logic_error After finish(), or after a failed write
+     */
+    void append(const ColorPublicKey& public_key);
+
+    /** @brief Append keys in order; stops at the first key append() rejects */
+    void append(const std::vector<ColorPublicKey>& public_keys);
+
+    /**
+     * @brief Also store the expanded matrix of an appended record
+     *
+     * finish() expands A_hat^T from the record's seed and writes it, packed to
+     * 12 bits, to the file's expanded section, so KeyStore::expanded_key()
+     * serves the record without SHAKE expansion. Meant for the few hot keys
+     * of a store: each costs k * k * n * 3 / 2 bytes. Marking a record twice
+     * stores it once.
+     *
+     * @throws std::invalid_argument If record has not been appended, or the
+     *         parameters use a shared matrix (which no key needs to store)
+     * @throws std::logic_error After finish(), or after a failed write
+     */
+    void store_expanded(size_t record);
+
+    /**
+     * @brief Write the seed index, the expanded section and header, sync and rename into place
+     *
+     * @throws std::runtime_error If a write, the sync or the rename fails
+     * @throws std::logic_error If called again, or after a failed write
+     */
+    void finish();
+
+    /** @brief Keys appended so far */
+    size_t size() const { return seeds_.size(); }
+
+    /** @brief Backend actually in use */
+    BulkIoBackend backend() const { return backend_; }
+
+private:
+    void flush_buffer();
+    void reserve(size_t bytes);
+    void discard() noexcept;
+
+    std::string path_;
+    std::string temp_path_;
+    CLWEParameters params_;
+    size_t record_bytes_;
+    int fd_ = -1;
+    std::unique_ptr<BulkFileIo> io_;
+    BulkIoBackend backend_;
+    size_t current_ = 0;       // Buffer being filled
+    size_t fill_ = 0;          // Bytes in it
+    uint64_t offset_;          // File offset of its first byte
+    std::vector<std::array<uint8_t, 32>> seeds_;
+    std::vector<ColorValue> colors_;
+    std::vector<uint64_t> expanded_records_;  // Marked by store_expanded(), unsorted
+};
+
+/**
+ * @brief Streams the public keys of a key store file in record order
+ *
+ * Reads run ahead of the caller by up to KeyArchiveOptions::buffer_count
+ * buffers. Keys come back with public_data in the store's parameter encoding,
+ * as ColorKEM::keygen() would produce them. Not thread-safe.
+ */
+class KeyArchiveReader {
+public:
+    /**
+     * @brief Open a key store file and start reading its records
+     *
+     * @throws std::runtime_error If the file cannot be opened, its header,
+     *         sizes or parameters are invalid, or BulkIoBackend::IoUring was
+     *         asked for and is unavailable
+     */
+    explicit KeyArchiveReader(const std::string& path, const KeyArchiveOptions& options = KeyArchiveOptions());
+    ~KeyArchiveReader();
+
+    KeyArchiveReader(const KeyArchiveReader&) = delete;
+    KeyArchiveReader& operator=(const KeyArchiveReader&) = delete;
+
+    /** @brief Parameters of every key in the file */
+    const CLWEParameters& params() const { return params_; }
+
+    /** @brief Number of records */
+    size_t size() const { return count_; }
+
+    /**
+     * @brief Read the next record
+     *
+     * @return bool False once every record has been read
+     * @throws std::runtime_error If a read fails, the file is shorter than its
+     *         header says or a record is corrupt
+     */
+    bool next(ColorPublicKey& public_key);
+
+    /**
+     * @brief Append up to max_keys further records to public_keys
+     *
+     * @return size_t Number of keys appended, 0 at the end of the file
+     */
+    size_t read(std::vector<ColorPublicKey>& public_keys, size_t max_keys);
+
+    /** @brief Backend actually in use */
+    BulkIoBackend backend() const { return backend_; }
+
+private:
+    void issue(size_t buffer);
+
+    std::string path_;
+    CLWEParameters params_;
+    size_t count_ = 0;
+    size_t record_bytes_ = 0;
+    size_t chunk_records_ = 0;       // Records per full buffer
+    int fd_ = -1;
+    std::unique_ptr<BulkFileIo> io_;
+    BulkIoBackend backend_;
+    std::vector<size_t> buffer_records_;  // Records of the chunk read into each buffer
+    size_t issued_ = 0;              // Records whose read has been queued
+    size_t delivered_ = 0;           // Records returned to the caller
+    size_t current_ = 0;             // Buffer being consumed
+    size_t position_ = 0;            // Next record in it
+    bool consuming_ = false;
+    std::vector<ColorValue> colors_;
+};
+
+} // namespace clwe
+
+#endif // KEY_ARCHIVE_HPP
@@ -0,0 +1,168 @@
+/**
+ * @file key_ring.hpp
+ * @brief Read-copy-update rotation of a server's static ColorKEM keys
+ *
+ * This header defines KeyRing, which holds the current and previous server
+ * key pairs already prepared for use: the public key expanded for
+ * encapsulation and the private key parsed for decapsulation. Readers reach
+ * them through one atomic pointer and never take a lock. A rotation prepares
+ * the new pair first, on the rotating thread, and then publishes it with a
+ * single pointer exchange. The retired snapshot is reclaimed once no reader
+ * can still see it (epoch-based reclamation).
+ *
+ * @author ColorKEM Development Team
+ * @version 1.0.0
+ * @date 2024
+ *
+ * @see color_kem.hpp for PreparedPrivateKey and ExpandedPublicKey
+ */
+
+#ifndef KEY_RING_HPP
+#define KEY_RING_HPP
+
+#include "color_kem.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace clwe {
+
+/**
+ * @brief Current and previous prepared server keys, rotated without blocking readers
+ *
+ * Each rotation numbers its key pair with the next version, starting at 1. The
+ * pair it replaces stays available as the previous key, so ciphertexts
+ * encapsulated just before a rotation still decapsulate. The rotation after
+ * that drops it.
+ *
+ * Readers pin the published snapshot with read(), which costs one atomic
+ * increment on a per-thread counter, two loads of the epoch and one pointer
+ * load; releasing the pin is one decrement. rotate() swaps in a
+ * new snapshot and then waits for the readers that may still hold the old one
+ * to let go before freeing it. It never waits for readers that arrive after
+ * the swap. Hold a ReadGuard only for the duration of one operation.
+ *
+ * Example usage:
+ * @code
+ * clwe::KeyRing ring(kem);
+ * ring.rotate();  // first key; later rotations run on a background thread
+ *
+ * // Request thread
+ * clwe::ColorValue secret = ring.decapsulate(ciphertext, key_version);
+ * @endcode
+ *
+ * @note The ColorKEM must outlive the ring. Calling rotate() while the same
+ *       thread holds a ReadGuard deadlocks.
+ */
+class KeyRing {
+public:
+    /** @brief One prepared key pair */
+    struct Key {
+        uint64_t version = 0;                  /**< Rotation number, from 1 */
+        ColorPublicKey public_key;             /**< Key to publish to clients */
+        ExpandedPublicKey expanded_public_key; /**< public_key with A_hat expanded */
+        PreparedPrivateKey private_key;        /**< Private key with s_hat parsed */
+    };
+
+    /** @brief Reader counter slots; threads beyond this share them */
+    static constexpr size_t READER_SLOTS = 64;
+
+    /**
+     * @brief Pin on the published snapshot
+     *
+     * The keys it returns stay valid until the guard is destroyed, however many
+     * rotations happen meanwhile.
+     */
+    class ReadGuard {
+    public:
+        ~ReadGuard();
+        ReadGuard(ReadGuard&& other) noexcept;             /**< Move constructor */
+        ReadGuard(const ReadGuard&) = delete;              /**< Copy constructor disabled */
+        ReadGuard& operator=(const ReadGuard&) = delete;   /**< Copy assignment disabled */
+        ReadGuard& operator=(ReadGuard&&) = delete;        /**< Move assignment disabled */
+
+        /** @brief The newest key, or nullptr before the first rotation */
+        const Key* current() const;
+        /** @brief The key current() replaced, or nullptr */
+        const Key* previous() const;
+        /** @brief current() or previous() when its version matches, otherwise nullptr */
+        const Key* find(uint64_t version) const;
+
+    private:
+        friend class KeyRing;
+        struct Snapshot;
+
+        ReadGuard(std::atomic<uint64_t>* counter, const Snapshot* snapshot);
+
+        std::atomic<uint64_t>* counter_;  // Reader count this guard holds, null once moved from
+        const Snapshot* snapshot_;
+    };
+
+    /**
+     * @brief Create an empty ring for kem's parameters
+     *
+     * @param kem Instance that prepares and uses the keys
+     */
+    explicit KeyRing(const ColorKEM& kem);
+
+    /** @brief Free the published snapshot; no ReadGuard may be alive */
+    ~KeyRing();
+
+    KeyRing(const KeyRing&) = delete;             /**< Copy constructor disabled */
+    KeyRing& operator=(const KeyRing&) = delete;  /**< Copy assignment disabled */
+
+    /** @brief Pin the published snapshot for lock-free reads */
+    ReadGuard read() const;
+
+    /**
+     * @brief Prepare a key pair and make it current
+     *
+     * Expands and parses both keys on the calling thread, publishes them in one
+     * pointer exchange and waits until the retired snapshot is unreachable
+     * before freeing it. Concurrent rotations run one after another.
+     *
+     * @param public_key Public key of the new pair
+     * @param private_key Its private key
+     * @return uint64_t Version of the new current key
+     *
+     * @throws std::invalid_argument If either key belongs to other parameters or is malformed
+     */
+    uint64_t rotate(const ColorPublicKey& public_key, const ColorPrivateKey& private_key);
+
+    /** @brief rotate() with a pair from kem.keygen() */
+    uint64_t rotate();
+
+    /**
+     * @brief Decapsulate under the key with the given version
+     *
+     * @throws std::invalid_argument If neither the current nor the previous key has
+     *         that version, or the ciphertext is invalid (as ColorKEM::decapsulate())
+     */
+    ColorValue decapsulate(const ColorCiphertext& ciphertext, uint64_t version) const;
+
+    /** @brief Version of the current key, 0 before the first rotation */
+    uint64_t current_version() const;
+
+private:
+    using Snapshot = ReadGuard::Snapshot;
+
+    // Reader counts under each epoch parity; one cache line per slot
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> readers[2];
+    };
+
+    // Wait until no reader pinned before the epoch flip remains
+    void synchronize();
+
+    const ColorKEM& kem_;
+    std::atomic<const Snapshot*> snapshot_;
+    std::atomic<uint64_t> epoch_;
+    mutable ReaderSlot slots_[READER_SLOTS];
+    std::mutex rotate_mutex_;  // Serializes writers only
+    uint64_t next_version_;
+};
+
+} // namespace clwe
+
+#endif // KEY_RING_HPP
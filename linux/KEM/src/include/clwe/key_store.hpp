@@ -0,0 +1,181 @@
+/**
+ * @file key_store.hpp
+ * @brief Memory-mapped store of long-term ColorKEM public keys
+ *
+ * This header defines KeyStore, a read-only file of fixed-size public key
+ * records for services that hold very large key sets. The file is mapped into
+ * memory and keys are handed out as ColorPublicKeyView objects pointing into
+ * the mapping, so encapsulation reads them from the page cache with no
+ * per-key allocation or deserialization.
+ *
+ * @author ColorKEM Development Team
+ * @version 1.0.0
+ * @date 2024
+ *
+ * @see color_kem.hpp for ColorPublicKeyView and encapsulation
+ * @see key_archive.hpp for streaming import and export
+ */
+
+#ifndef KEY_STORE_HPP
+#define KEY_STORE_HPP
+
+#include "color_kem.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace clwe {
+
+/**
+ * @brief Read-only, memory-mapped set of public keys
+ *
+ * File layout, all integers little-endian:
+ * - A 64-byte header: magic "CLKS", format version, the CLWEParameters fields
+ *   (shared_matrix as a flag bit), the record size, the record count and the
+ *   offset of the seed index. secret_weight only shapes private keys and is
+ *   not stored: keys of any weight share a store, which reopens with 0
+ * - Records of record_bytes(params) bytes each: the 32-byte seed, then t_hat
+ *   with coefficients packed to 12 bits (PACKED12) whatever params.encoding is
+ * - The seed index: one 40-byte entry per record (seed, then the 64-bit record
+ *   number), sorted by seed so find() is a binary search over the index alone
+ * - Optionally, the expanded section: a 16-byte header (magic "CLKX", a zero
+ *   32-bit field, the entry count), then for each hot record in ascending
+ *   record order its 64-bit record number and its A_hat^T in NTT domain,
+ *   packed to 12 bits. Files without hot records end at the index, as before
+ *
+ * Example usage:
+ * @code
+ * clwe::KeyStore::write("directory.clks", public_keys, params);
+ *
+ * clwe::KeyStore store = clwe::KeyStore::open("directory.clks");
+ * size_t index = store.find(recipient_seed);
+ * if (index != clwe::KeyStore::npos) {
+ *     auto [ct, ss] = kem.encapsulate(store.key(index));
+ * }
+ * @endcode
+ *
+ * Hot keys can be written with their expanded matrix, so a restarted service
+ * encapsulates to them without SHAKE expansion from the first request:
+ * @code
+ * clwe::KeyStore::write("directory.clks", public_keys, params, {front_door_index});
+ *
+ * clwe::KeyStore store = clwe::KeyStore::open("directory.clks");
+ * clwe::ExpandedPublicKey front_door = store.expanded_key(front_door_index);
+ * kem.encapsulate_into(front_door, m, ciphertext, workspace);
+ * @endcode
+ *
+ * Views returned by key() stay valid until the store is destroyed or moved
+ * from. A store is immutable once open, so any number of threads may read it.
+ */
+class KeyStore {
+public:
+    /** @brief Returned by find() when no record has the seed */
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    static constexpr size_t HEADER_BYTES = 64;       /**< File header size */
+    static constexpr size_t INDEX_ENTRY_BYTES = 40;  /**< Seed index entry size */
+
+    /** @brief Size of one key record for the given parameters */
+    static size_t record_bytes(const CLWEParameters& params);
+
+    /**
+     * @brief Write a key store file
+     *
+     * The file is built as path + ".tmp" and renamed over path once complete, so
+     * on failure any previous file at path is left as it was.
+     *
+     * @param path File to create or replace
+     * @param public_keys Keys to store, in record order
+     * @param params Parameters every key must have
+     * @param expanded_records Record numbers whose expanded matrix is stored too
+     *        (see KeyArchiveWriter::store_expanded())
+     *
+     * @throws std::invalid_argument If a key's parameters differ from params, its
+     *         data size is wrong, a coefficient is not reduced mod q, the
+     *         modulus does not fit in 12 bits, params round public keys
+     *         (t_dropped_bits) or an expanded record number is out of range
+     * @throws std::runtime_error If the file cannot be written
+     */
+    static void write(const std::string& path, const std::vector<ColorPublicKey>& public_keys,
+                      const CLWEParameters& params, const std::vector<size_t>& expanded_records = {});
+
+    /**
+     * @brief Map a key store file read-only
+     *
+     * Under PagePolicy::Huge the mapping is advised for transparent huge pages;
+     * kernels without read-only file THP keep it on normal pages. The expanded
+     * section, if any, is prefetched.
+     *
+     * @throws std::runtime_error If the file cannot be opened or mapped, or its
+     *         header, sizes, parameters or expanded section are invalid
+     */
+    static KeyStore open(const std::string& path);
+
+    KeyStore(KeyStore&& other) noexcept;             /**< Move constructor */
+    KeyStore& operator=(KeyStore&& other) noexcept;  /**< Move assignment */
+    KeyStore(const KeyStore&) = delete;             /**< Copy constructor disabled */
+    KeyStore& operator=(const KeyStore&) = delete;  /**< Copy assignment disabled */
+    ~KeyStore();
+
+    /** @brief Parameters of every key in the store */
+    const CLWEParameters& params() const { return params_; }
+
+    /** @brief Number of records */
+    size_t size() const { return count_; }
+
+    /**
+     * @brief View of a record, pointing into the mapping
+     *
+     * @throws std::invalid_argument If index is not below size()
+     */
+    ColorPublicKeyView key(size_t index) const;
+
+    /**
+     * @brief Record number of the key with this seed, or npos
+     *
+     * With several records sharing a seed, returns the lowest record number.
+     */
+    size_t find(const std::array<uint8_t, 32>& seed) const;
+
+    /** @brief Number of records whose expanded matrix is stored */
+    size_t expanded_size() const { return expanded_count_; }
+
+    /** @brief Whether record index has its expanded matrix stored */
+    bool has_expanded_key(size_t index) const { return expanded_entry(index) != nullptr; }
+
+    /**
+     * @brief Expanded public key of a hot record, read from the mapping
+     *
+     * Unpacks the stored A_hat^T and the record's t_hat instead of running the
+     * SHAKE expansion of ColorKEM::expand_public_key(); the result is the same
+     * and serves encapsulate_into(const ExpandedPublicKey&, ...) directly.
+     *
+     * @throws std::invalid_argument If index is not below size() or the record
+     *         has no stored matrix
+     * @throws std::runtime_error If a stored coefficient is not reduced mod q
+     */
+    ExpandedPublicKey expanded_key(size_t index) const;
+
+private:
+    KeyStore() = default;
+
+    // Entry of record index in the expanded section, or null
+    const uint8_t* expanded_entry(size_t index) const;
+
+    const uint8_t* mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+    const uint8_t* records_ = nullptr;
+    const uint8_t* index_ = nullptr;
+    size_t count_ = 0;
+    size_t record_bytes_ = 0;
+    const uint8_t* expanded_ = nullptr;  // First entry of the expanded section
+    size_t expanded_count_ = 0;
+    size_t expanded_entry_bytes_ = 0;
+    CLWEParameters params_;
+};
+
+} // namespace clwe
+
+#endif // KEY_STORE_HPP
@@ -0,0 +1,140 @@
+/**
+ * @file keygen_op.hpp
+ * @brief Resumable ColorKEM key generation for cooperative schedulers
+ *
+ * This header defines KeygenOp, which runs one key generation in bounded
+ * steps. keygen() expands matrix A, samples s and e, multiplies and packs in
+ * one call that does not return for milliseconds at the larger parameter
+ * sets; on a cooperative scheduler (green threads, an event loop, a
+ * run-to-completion task) that call starves every other task and can trip a
+ * watchdog. A KeygenOp does the same work in units of at most one
+ * polynomial's worth (one noise polynomial and its NTT, up to four cells of
+ * A, one row of A s + e, or packing one key), and step() runs units until a
+ * cycle budget is spent, so the caller can yield in between.
+ *
+ * Example usage:
+ * @code
+ * clwe::KeygenOp op(kem);
+ * while (!op.step(200000)) {
+ *     yield();
+ * }
+ * auto [public_key, private_key] = op.take_keys();
+ * @endcode
+ *
+ * @author ColorKEM Development Team
+ * @version 1.0.0
+ * @date 2024
+ *
+ * @see color_kem.hpp for the one-shot keygen() overloads
+ */
+
+#ifndef KEYGEN_OP_HPP
+#define KEYGEN_OP_HPP
+
+#include "color_kem.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace clwe {
+
+/** @brief Stage a KeygenOp's next unit belongs to */
+enum class KeygenPhase {
+    Sampling,  /**< s_hat and e_hat, one polynomial per unit */
+    Matrix,    /**< A streamed a row at a time: up to four cells, or the row of A s + e, per unit */
+    Packing,   /**< The public key, then the private key */
+    Done       /**< take_keys() may be called */
+};
+
+/**
+ * @brief One key generation, advanced a bounded step at a time
+ *
+ * The keys are those keygen_derand(d) returns for the same seed, on any
+ * instance configuration: A is always streamed from its seed one row at a
+ * time (or read from the installed shared matrix), so the operation holds k
+ * polynomials of A rather than k * k.
+ *
+ * Everything the steps write, including the key buffers, is allocated when
+ * the operation is constructed; step() itself does not allocate. The
+ * operation keeps s and e between steps and securely zeroes them on
+ * destruction.
+ *
+ * @note The ColorKEM must outlive the operation, unless the operation was
+ *       constructed from parameters and owns its instance. An operation is
+ *       not thread-safe, but may be stepped from any one thread at a time.
+ */
+class KeygenOp {
+public:
+    /**
+     * @brief Key generation on kem with a seed drawn from its random source
+     */
+    explicit KeygenOp(const ColorKEM& kem);
+
+    /**
+     * @brief Key generation on kem from seed d, as keygen_derand(d)
+     */
+    KeygenOp(const ColorKEM& kem, const std::array<uint8_t, 32>& d);
+
+    /**
+     * @brief Key generation on a default ColorKEM instance for params, owned by the operation
+     *
+     * @throws std::invalid_argument If params is invalid
+     */
+    explicit KeygenOp(const CLWEParameters& params);
+
+    /** @brief Securely erase all state */
+    ~KeygenOp();
+
+    KeygenOp(KeygenOp&&) noexcept;             /**< Move constructor */
+    KeygenOp& operator=(KeygenOp&&) noexcept;  /**< Move assignment */
+    KeygenOp(const KeygenOp&) = delete;             /**< Copy constructor disabled */
+    KeygenOp& operator=(const KeygenOp&) = delete;  /**< Copy assignment disabled */
+
+    /**
+     * @brief Run units until budget_cycles are spent or the keys are complete
+     *
+     * At least one unit runs per call, so a budget of 0 advances by exactly
+     * one. Another unit starts only while the cycles spent so far plus the
+     * most expensive unit seen stay within the budget, so a step overruns it
+     * by at most one unit when the budget is below the unit cost.
+     *
+     * Cycles are those of the timestamp counter (TSC on x86, the virtual
+     * counter on AArch64), or nanoseconds of a monotonic clock elsewhere.
+     *
+     * @param budget_cycles Cycles this call may use
+     * @return bool Whether the keys are complete
+     */
+    bool step(uint64_t budget_cycles);
+
+    /** @brief Run every remaining unit */
+    void run();
+
+    /** @brief Whether the keys are complete */
+    bool done() const { return phase() == KeygenPhase::Done; }
+
+    /** @brief Stage of the next unit */
+    KeygenPhase phase() const;
+
+    /** @brief Units run so far, and units in the whole operation */
+    size_t units_done() const;
+    size_t units_total() const;
+
+    /**
+     * @brief Move the generated keys out
+     *
+     * @throws std::logic_error If the operation is not done or the keys were already taken
+     */
+    std::pair<ColorPublicKey, ColorPrivateKey> take_keys();
+
+    /** @brief Opaque generation state, defined by the implementation */
+    struct State;
+
+private:
+    std::unique_ptr<State> state_;
+};
+
+} // namespace clwe
+
+#endif // KEYGEN_OP_HPP
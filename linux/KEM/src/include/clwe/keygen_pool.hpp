@@ -0,0 +1,144 @@
+/**
+ * @file keygen_pool.hpp
+ * @brief Background pool of pre-generated ColorKEM key pairs
+ *
+ * This header defines KeygenPool, which keeps a stock of ephemeral key pairs
+ * ready for handshake bursts. Worker threads generate keys in the background;
+ * consumers take a finished pair without running the RNG, the matrix expansion
+ * or any NTT on their own thread.
+ *
+ * @author ColorKEM Development Team
+ * @version 1.0.0
+ * @date 2024
+ *
+ * @see color_kem.hpp for the underlying key generation
+ */
+
+#ifndef KEYGEN_POOL_HPP
+#define KEYGEN_POOL_HPP
+
+#include "color_kem.hpp"
+#include "numa.hpp"
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace clwe {
+
+class PriorityExecutor;
+
+/**
+ * @brief Sizing and threading of a KeygenPool
+ *
+ * The pool refills when the ready keys plus those already being generated
+ * drop to low_watermark. It then schedules enough work to reach high_watermark.
+ */
+struct KeygenPoolConfig {
+    size_t capacity = 1024;        /**< Ready-key slots, rounded up to a power of two */
+    size_t low_watermark = 256;    /**< Refill threshold */
+    size_t high_watermark = 1024;  /**< Refill target, at most capacity */
+    size_t worker_threads = 0;     /**< Generator threads; 0 uses std::thread::hardware_concurrency() */
+    size_t batch_size = 16;        /**< Key pairs per scheduled task */
+    size_t numa_node = ANY_NUMA_NODE;  /**< Bind the workers, ring and engine to this node; ANY_NUMA_NODE places nothing */
+    PriorityExecutor* executor = nullptr;  /**< Run refills as WorkClass::BACKGROUND jobs here instead of on own workers */
+};
+
+/**
+ * @brief Pre-generated key pairs served from a lock-free ring
+ *
+ * Ready key pairs sit in a bounded lock-free multi-producer/multi-consumer
+ * ring. try_pop() takes one with a few atomic operations, moving the key
+ * vectors out without copying them. Refill work is split into tasks of
+ * batch_size keys. The tasks are spread over per-worker deques; each worker
+ * drains its own deque and steals from the others when idle. All workers share
+ * one ColorKEM and each reuses its own KemWorkspace. With
+ * KeygenPoolConfig::numa_node set, the ring, the ColorKEM and the workers
+ * live on that node, so the generated keys are in its memory.
+ *
+ * With KeygenPoolConfig::executor set the pool starts no threads of its own.
+ * Each task then runs on the shared executor as a chain of BACKGROUND jobs
+ * of one key each, so foreground work gets the next free worker after at
+ * most one key generation, and the executor's background cap bounds
+ * the refill rate. worker_threads is ignored, and numa_node places only the
+ * ring and the ColorKEM. The executor must outlive the pool.
+ *
+ * Example usage:
+ * @code
+ * clwe::KeygenPool pool(clwe::CLWEParameters(768));
+ * std::pair<clwe::ColorPublicKey, clwe::ColorPrivateKey> keys;
+ * if (!pool.try_pop(keys)) {
+ *     keys = pool.pop();  // generates on this thread when the pool is drained
+ * }
+ * @endcode
+ *
+ * @note All member functions are thread-safe.
+ * @warning Keys that are never popped are wiped when the pool is destroyed.
+ */
+class KeygenPool {
+public:
+    /** @brief A generated public/private key pair */
+    using KeyPair = std::pair<ColorPublicKey, ColorPrivateKey>;
+
+    /**
+     * @brief Start the workers and begin filling to the high watermark
+     *
+     * @param params Parameters of the generated keys
+     * @param config Pool sizing and threading
+     *
+     * @throws std::invalid_argument If the watermarks, capacity or batch size are inconsistent,
+     *         or numa_node is not a node of this system
+     */
+    explicit KeygenPool(const CLWEParameters& params, const KeygenPoolConfig& config = KeygenPoolConfig());
+
+    /** @brief Stop and join the workers, then wipe every unclaimed private key */
+    ~KeygenPool();
+
+    KeygenPool(const KeygenPool&) = delete;             /**< Copy constructor disabled */
+    KeygenPool& operator=(const KeygenPool&) = delete;  /**< Copy assignment disabled */
+
+    /**
+     * @brief Take a ready key pair if one is available
+     *
+     * Never touches the RNG or the NTT. May schedule a refill when the stock
+     * reaches the low watermark.
+     *
+     * @param keys Receives the key pair on success
+     * @return bool True if a key pair was taken, false if the pool is empty
+     */
+    bool try_pop(KeyPair& keys);
+
+    /**
+     * @brief Take a ready key pair, generating one on this thread if none is ready
+     * @return KeyPair A key pair never handed out before
+     */
+    KeyPair pop();
+
+    /**
+     * @brief Wait until at least count key pairs are ready
+     * @param count Number of ready key pairs to wait for, at most the capacity
+     * @param timeout Longest time to wait
+     * @return bool True if count pairs were ready before the timeout
+     */
+    bool wait_ready(size_t count, std::chrono::milliseconds timeout);
+
+    /** @brief Number of key pairs ready to pop (a snapshot under concurrency) */
+    size_t ready() const;
+
+    /** @brief Number of ready-key slots */
+    size_t capacity() const;
+
+    /** @brief Total key pairs generated by the workers so far */
+    size_t generated() const;
+
+    /** @brief Parameters of the generated keys */
+    const CLWEParameters& params() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace clwe
+
+#endif // KEYGEN_POOL_HPP
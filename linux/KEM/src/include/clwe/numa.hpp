@@ -0,0 +1,85 @@
+/**
+ * @file numa.hpp
+ * @brief NUMA topology and thread placement used by the per-node KEM shards
+ *
+ * Nodes are numbered densely from 0 to numa_node_count() - 1 in the order the
+ * OS lists them, so sparse system node ids ("0,2") still index arrays
+ * directly. Without NUMA support, or on a single-node system, there is exactly
+ * one node and every thread is on it.
+ *
+ * Memory is placed by first touch: what a thread bound with
+ * bind_thread_to_numa_node() allocates and writes first lands on that node
+ * under the default Linux and Windows policies, so the library needs no
+ * libnuma dependency.
+ *
+ * @author ColorKEM Development Team
+ * @version 1.0.0
+ * @date 2024
+ *
+ * @see NumaKemShards, KeygenPoolConfig::numa_node
+ */
+
+#ifndef NUMA_HPP
+#define NUMA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace clwe {
+
+/** @brief Placeholder node meaning "no placement" (KeygenPoolConfig::numa_node) */
+constexpr size_t ANY_NUMA_NODE = SIZE_MAX;
+
+/**
+ * @brief Number of NUMA nodes with CPUs
+ *
+ * Read once from /sys/devices/system/node on Linux, or with
+ * GetNumaNodeProcessorMaskEx() on Windows.
+ *
+ * @return size_t At least 1
+ */
+size_t numa_node_count();
+
+/**
+ * @brief Node of the CPU the calling thread is running on
+ *
+ * A snapshot: an unbound thread may migrate right after the call.
+ *
+ * @return size_t Dense node index, 0 where the CPU cannot be queried
+ */
+size_t current_numa_node();
+
+/**
+ * @brief Number of CPUs of a node
+ * @param node Dense node index
+ * @return size_t 0 if node is out of range
+ */
+size_t numa_node_cpu_count(size_t node);
+
+/**
+ * @brief Restrict the calling thread to the CPUs of a node
+ *
+ * The thread's later first touches, and so its allocations, come from that
+ * node's memory.
+ *
+ * @param node Dense node index
+ * @return bool False if node is out of range or the OS refused the affinity
+ */
+bool bind_thread_to_numa_node(size_t node);
+
+/**
+ * @brief Run a function on a short-lived thread bound to a node
+ *
+ * Used to build long-lived state (NTT engines, key pools) in node-local
+ * memory. Blocks until fn returns and rethrows what it throws. If the thread
+ * cannot be bound, fn still runs, on unplaced memory.
+ *
+ * @param node Dense node index
+ * @param fn Work to run
+ */
+void run_on_numa_node(size_t node, const std::function<void()>& fn);
+
+} // namespace clwe
+
+#endif // NUMA_HPP
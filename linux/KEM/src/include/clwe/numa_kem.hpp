@@ -0,0 +1,131 @@
+/**
+ * @file numa_kem.hpp
+ * @brief Per-NUMA-node ColorKEM instances, key pools and executors
+ *
+ * A single ColorKEM shared by every thread of a multi-socket server keeps its
+ * NTT tables, expanded-public-key cache and pregenerated keys on one node, so
+ * the threads of the other sockets pay for remote memory on every operation.
+ * NumaKemShards builds one of each per node instead, in that node's memory,
+ * and hands every thread the instance of the node it runs on.
+ *
+ * @author ColorKEM Development Team
+ * @version 1.0.0
+ * @date 2024
+ *
+ * @see numa.hpp for the topology functions, KeygenPool
+ */
+
+#ifndef NUMA_KEM_HPP
+#define NUMA_KEM_HPP
+
+#include "color_kem.hpp"
+#include "keygen_pool.hpp"
+#include "numa.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace clwe {
+
+/** @brief What NumaKemShards builds on each node */
+struct NumaShardConfig {
+    bool executors = true;          /**< Give each node's ColorKEM an executor bound to the node */
+    size_t executor_threads = 0;    /**< Executor workers per node; 0 uses the node's CPU count minus one */
+    uint32_t parallel_min_rank = ColorKEM::DEFAULT_PARALLEL_MIN_RANK;  /**< Passed to ColorKEM::set_executor() */
+    bool key_pools = false;         /**< Run a KeygenPool on each node */
+    KeygenPoolConfig key_pool;      /**< Sizing of each node's pool; numa_node is set per node */
+};
+
+/**
+ * @brief One ColorKEM, expanded-key cache and key pool per NUMA node
+ *
+ * Each node's ColorKEM is constructed on a thread bound to the node, so its
+ * NTT engine tables (ColorNTTEngine::shared() keeps one copy per node) are
+ * node-local. Its expanded-key cache fills from the threads the node serves
+ * and stays there too. Its executor runs the matrix work on worker threads
+ * bound to the same node, together with the calling thread, so a batch never
+ * crosses sockets. Key pools, if enabled, generate on their node
+ * (KeygenPoolConfig::numa_node).
+ *
+ * kem() and pop_keys() route by the node of the calling thread. Threads that
+ * are not bound may migrate between nodes; they always get a working
+ * instance, only possibly a remote one. Results never depend on the routing.
+ *
+ * Example usage:
+ * @code
+ * clwe::NumaKemShards shards(clwe::CLWEParameters(768));
+ * // On any server thread:
+ * auto [ct, secret] = shards.kem().encapsulate(peer_public_key);
+ * @endcode
+ *
+ * @note All member functions are thread-safe; with one node this is a single
+ *       ColorKEM with a thread pool.
+ */
+class NumaKemShards {
+public:
+    /** @brief A generated public/private key pair */
+    using KeyPair = KeygenPool::KeyPair;
+
+    /**
+     * @brief Build the per-node instances
+     *
+     * @param params Parameters of every shard
+     * @param config Executors and key pools per node
+     *
+     * @throws std::invalid_argument If params or the key pool configuration are invalid
+     */
+    explicit NumaKemShards(const CLWEParameters& params, const NumaShardConfig& config = NumaShardConfig());
+
+    /** @brief Stop the executors and key pools */
+    ~NumaKemShards();
+
+    NumaKemShards(const NumaKemShards&) = delete;             /**< Copy constructor disabled */
+    NumaKemShards& operator=(const NumaKemShards&) = delete;  /**< Copy assignment disabled */
+
+    /** @brief Number of shards, numa_node_count() at construction */
+    size_t node_count() const;
+
+    /** @brief ColorKEM of the calling thread's node */
+    ColorKEM& kem();
+
+    /**
+     * @brief ColorKEM of a given node
+     * @throws std::invalid_argument If node is not below node_count()
+     */
+    ColorKEM& kem(size_t node);
+
+    /** @brief Whether NumaShardConfig::key_pools was set */
+    bool has_key_pools() const;
+
+    /**
+     * @brief Key pool of the calling thread's node
+     * @throws std::logic_error If the shards were built without key pools
+     */
+    KeygenPool& key_pool();
+
+    /**
+     * @brief Key pool of a given node
+     * @throws std::invalid_argument If node is not below node_count()
+     * @throws std::logic_error If the shards were built without key pools
+     */
+    KeygenPool& key_pool(size_t node);
+
+    /**
+     * @brief Key pair from the calling thread's node
+     *
+     * Pops from the node's pool (which generates on this thread when drained),
+     * or runs kem().keygen() without key pools.
+     */
+    KeyPair pop_keys();
+
+    /** @brief Parameters of every shard */
+    const CLWEParameters& params() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace clwe
+
+#endif // NUMA_KEM_HPP
@@ -0,0 +1,90 @@
+/**
+ * @file page_allocation.hpp
+ * @brief Huge-page backing for long-lived ColorKEM buffers
+ *
+ * Workspace arenas (KemWorkspace, including the per-thread workspaces behind
+ * the overloads that take none, the batch calls and KeygenPool workers) and
+ * KeyStore mappings can be backed by huge pages, so bulk key generation and
+ * large key stores take fewer TLB misses. The policy is selected at run time
+ * with set_page_policy() or the CLWE_PAGE_POLICY environment variable
+ * ("normal" or "huge").
+ *
+ * Huge pages are best effort: on Linux explicit hugetlbfs pages
+ * (MAP_HUGETLB) are tried first, then transparent huge pages
+ * (madvise(MADV_HUGEPAGE)); on Windows large pages (MEM_LARGE_PAGES, which
+ * need the SeLockMemoryPrivilege right). Whatever the OS refuses falls back to
+ * normal pages. Results never depend on the policy.
+ *
+ * @author ColorKEM Development Team
+ * @version 1.0.0
+ * @date 2024
+ *
+ * @see KemWorkspace::page_backing(), KeyStore
+ */
+
+#ifndef PAGE_ALLOCATION_HPP
+#define PAGE_ALLOCATION_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace clwe {
+
+/** @brief Which pages long-lived buffers are allocated from */
+enum class PagePolicy {
+    Normal,  /**< The heap, as every other allocation */
+    Huge     /**< Huge pages where the OS grants them, normal pages otherwise */
+};
+
+/** @brief What a region actually ended up on */
+enum class PageBacking {
+    Heap,                 /**< Allocated with operator new */
+    Pages,                /**< Mapped from the OS on normal pages (huge pages were refused) */
+    TransparentHugePages, /**< Mapped with madvise(MADV_HUGEPAGE); the kernel promotes it when it can */
+    HugePages,            /**< Explicit huge or large pages (MAP_HUGETLB, MEM_LARGE_PAGES) */
+    SecurePool            /**< A slot of the locked secure memory pool, see secure_memory.hpp */
+};
+
+/**
+ * @brief Policy applied to regions reserved from now on
+ *
+ * Initially CLWE_PAGE_POLICY if it names a policy, else Normal.
+ */
+PagePolicy page_policy();
+
+/**
+ * @brief Select the policy for subsequently reserved regions
+ *
+ * Thread-safe. Regions already reserved keep their backing; a workspace picks
+ * up the new policy when it next grows, and a KeyStore when it is opened.
+ */
+void set_page_policy(PagePolicy policy);
+
+/** @brief "normal" or "huge" */
+const char* page_policy_name(PagePolicy policy);
+
+/**
+ * @brief Parse a CLWE_PAGE_POLICY value
+ *
+ * @param name "normal" or "huge"
+ * @param policy Receives the parsed policy
+ * @return bool False if name is not recognized
+ */
+bool parse_page_policy(const std::string& name, PagePolicy& policy);
+
+/**
+ * @brief Default huge page size of this system in bytes
+ *
+ * Hugepagesize from /proc/meminfo on Linux, GetLargePageMinimum() on Windows.
+ * Huge-page regions are rounded up to a multiple of it.
+ *
+ * @return size_t 0 where the platform has no huge-page support
+ */
+size_t huge_page_size();
+
+/** @brief "heap", "pages", "thp", "huge" or "secure" */
+const char* page_backing_name(PageBacking backing);
+
+} // namespace clwe
+
+#endif // PAGE_ALLOCATION_HPP
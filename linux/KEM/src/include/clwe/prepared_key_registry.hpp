@@ -0,0 +1,209 @@
+/**
+ * @file prepared_key_registry.hpp
+ * @brief Lock-free lookup of prepared private keys for many tenants
+ *
+ * This header defines PreparedKeyRegistry, which maps 32-byte key fingerprints
+ * to private keys for a service that decapsulates for many tenants, each with
+ * its own static key. Lookups probe an open-addressing table and never take a
+ * lock. Every key is kept in its small serialized form; at most a configured
+ * number of them are also held prepared (s_hat parsed in NTT domain), and a
+ * decapsulation under a key that is not prepares it on the spot, evicting a
+ * key that has not been used recently. Retired entries are reclaimed once no
+ * reader can still see them (epoch-based reclamation, as in KeyRing).
+ *
+ * @author ColorKEM Development Team
+ * @version 1.0.0
+ * @date 2024
+ *
+ * @see key_ring.hpp for the same reclamation scheme on one server key
+ */
+
+#ifndef PREPARED_KEY_REGISTRY_HPP
+#define PREPARED_KEY_REGISTRY_HPP
+
+#include "color_kem.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace clwe {
+
+/** @brief Key identifier, normally H(pk) (ColorPublicKey::fingerprint()) */
+using KeyFingerprint = std::array<uint8_t, 32>;
+
+/**
+ * @brief Fingerprint-to-key map with lock-free reads and a bounded prepared set
+ *
+ * The table has a fixed number of slots, the next power of two at or above
+ * twice the key capacity, so linear probes stay short. Fingerprints are
+ * expected to be uniformly distributed (hash outputs); the first eight bytes
+ * pick the home slot.
+ *
+ * A hit costs one epoch pin (as KeyRing::read()), a probe and two pointer
+ * loads. A miss prepares the key without any lock, publishes it under the
+ * writer lock and, if the prepared set is then over its bound, evicts the
+ * least recently used key by the clock algorithm: its prepared form is
+ * dropped and it falls back to its serialized form until the next use.
+ * Grace-period waits run after the writer lock is released.
+ *
+ * Erased slots are marked so probes walk past them. Once keys and marks
+ * together fill three quarters of the table, erase() rebuilds it without the
+ * marks, so probe lengths stay bounded under tenant churn.
+ *
+ * Example usage:
+ * @code
+ * clwe::PreparedKeyRegistry registry(kem, 50000, 4096);
+ * registry.insert(public_key.fingerprint(), private_key);  // at tenant onboarding
+ *
+ * // Request thread
+ * clwe::ColorValue secret = registry.decapsulate(tenant_fingerprint, ciphertext);
+ * @endcode
+ *
+ * @note The ColorKEM must outlive the registry. All member functions are
+ *       thread-safe; writers (insert(), erase(), misses) run one at a time.
+ */
+class PreparedKeyRegistry {
+public:
+    /** @brief Reader counter slots; threads beyond this share them */
+    static constexpr size_t READER_SLOTS = 64;
+
+    /**
+     * @brief Create an empty registry for kem's parameters
+     *
+     * @param kem Instance that prepares the keys and decapsulates
+     * @param capacity Most keys the registry holds
+     * @param max_prepared Most keys held prepared at once; at least 1
+     *
+     * @throws std::invalid_argument If capacity or max_prepared is 0
+     */
+    PreparedKeyRegistry(const ColorKEM& kem, size_t capacity, size_t max_prepared);
+
+    /** @brief Free every entry and securely erase the serialized keys */
+    ~PreparedKeyRegistry();
+
+    PreparedKeyRegistry(const PreparedKeyRegistry&) = delete;             /**< Copy constructor disabled */
+    PreparedKeyRegistry& operator=(const PreparedKeyRegistry&) = delete;  /**< Copy assignment disabled */
+
+    /**
+     * @brief Add a key, or replace the key registered under fingerprint
+     *
+     * The key is stored serialized and prepared on its first use.
+     *
+     * @throws std::invalid_argument If the key belongs to other parameters or is malformed
+     * @throws std::runtime_error If the registry already holds capacity keys
+     */
+    void insert(const KeyFingerprint& fingerprint, const ColorPrivateKey& private_key);
+
+    /**
+     * @brief Remove the key registered under fingerprint
+     *
+     * @return bool True if a key was removed
+     */
+    bool erase(const KeyFingerprint& fingerprint);
+
+    /** @brief Whether a key is registered under fingerprint */
+    bool contains(const KeyFingerprint& fingerprint) const;
+
+    /**
+     * @brief Decapsulate under the key registered under fingerprint
+     *
+     * Prepares the key first if it is not held prepared.
+     *
+     * @throws std::invalid_argument If no key is registered under fingerprint,
+     *         or the ciphertext is invalid (as ColorKEM::decapsulate())
+     */
+    ColorValue decapsulate(const KeyFingerprint& fingerprint, const ColorCiphertext& ciphertext) const;
+
+    /** @brief decapsulate() of a ciphertext view using caller-provided scratch */
+    ColorValue decapsulate(const KeyFingerprint& fingerprint, const ColorCiphertextView& ciphertext,
+                           KemWorkspace& workspace) const;
+
+    /** @brief Number of registered keys */
+    size_t size() const;
+
+    /** @brief Number of keys currently held prepared, at most max_prepared */
+    size_t prepared_size() const;
+
+    /** @brief Preparations done on a miss since construction */
+    uint64_t preparations() const;
+
+    /** @brief Prepared keys dropped to stay within max_prepared since construction */
+    uint64_t evictions() const;
+
+    /** @brief Number of table slots */
+    size_t table_size() const { return table_size_; }
+
+    /** @brief Slots a lookup of fingerprint visits, hit or miss; for diagnostics */
+    size_t probe_length(const KeyFingerprint& fingerprint) const;
+
+private:
+    struct Entry;
+
+    // Reader counts under each epoch parity; one cache line per slot
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> readers[2];
+    };
+
+    // Pin held while a reader touches entries; releasing it lets writers reclaim
+    class Pin {
+    public:
+        explicit Pin(const PreparedKeyRegistry& registry);
+        ~Pin();
+        Pin(const Pin&) = delete;
+        Pin& operator=(const Pin&) = delete;
+
+    private:
+        std::atomic<uint64_t>* counter_;
+    };
+
+    // Entry for fingerprint, or nullptr; callers hold a Pin or the writer lock
+    const Entry* lookup(const KeyFingerprint& fingerprint) const;
+    // Slot index holding fingerprint, or table_size_; found receives the entry seen there
+    // and probes the number of slots visited
+    size_t find_slot(const KeyFingerprint& fingerprint, const Entry** found = nullptr,
+                     size_t* probes = nullptr) const;
+    size_t home_slot(const KeyFingerprint& fingerprint) const;
+    // Marks an erased slot: probes walk past it, and inserts on its chain reuse it
+    static Entry* tombstone();
+
+    // Prepares the key of fingerprint if it is not; the miss path, which takes the
+    // writer lock only to publish
+    void prepare(const KeyFingerprint& fingerprint) const;
+    // Unlinks prepared keys until prepared_count_ fits max_prepared_, sparing keep;
+    // called under the writer lock, the caller frees them after synchronize()
+    void evict(const Entry* keep, std::vector<const PreparedPrivateKey*>& retired) const;
+    // Moves every key to a fresh table without erased marks and returns the old
+    // table, which the caller frees after synchronize(); called under the writer lock
+    std::atomic<Entry*>* rebuild();
+    // Wait until no reader pinned before the epoch flip remains; takes synchronize_mutex_
+    void synchronize() const;
+
+    // Runs decapsulate(prepared key) under a pin, preparing the key first on a miss
+    template <typename Decapsulate>
+    ColorValue with_prepared(const KeyFingerprint& fingerprint, const Decapsulate& decapsulate) const;
+
+    const ColorKEM& kem_;
+    const size_t capacity_;
+    const size_t max_prepared_;
+    const size_t table_size_;
+    std::atomic<std::atomic<Entry*>*> slots_;  // Replaced by rebuild(); readers load it under a Pin
+    mutable std::atomic<uint64_t> epoch_;
+    mutable ReaderSlot reader_slots_[READER_SLOTS];
+    mutable std::mutex write_mutex_;        // Serializes writers only
+    mutable std::mutex synchronize_mutex_;  // Serializes epoch flips, taken without write_mutex_
+    size_t key_count_;                      // Guarded by write_mutex_
+    size_t tombstone_count_;                // Guarded by write_mutex_
+    uint64_t next_generation_;              // Guarded by write_mutex_
+    mutable size_t clock_hand_;             // Guarded by write_mutex_
+    mutable std::atomic<size_t> prepared_count_;
+    mutable std::atomic<uint64_t> preparations_;
+    mutable std::atomic<uint64_t> evictions_;
+};
+
+} // namespace clwe
+
+#endif // PREPARED_KEY_REGISTRY_HPP
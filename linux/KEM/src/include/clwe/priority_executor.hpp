@@ -0,0 +1,131 @@
+/**
+ * @file priority_executor.hpp
+ * @brief Thread pool with work classes for foreground and background KEM work
+ *
+ * This header defines PriorityExecutor, a thread pool shared by the library's
+ * front ends that keeps latency-critical operations ahead of maintenance work
+ * on the same threads. Every job carries a WorkClass: foreground operations,
+ * preparation of keys about to be used (rotations, registry misses), or
+ * background refills. Workers always take the most urgent queued job, and the
+ * lower classes can be capped to a number of workers, so a refill burst never
+ * occupies the whole pool.
+ *
+ * @author ColorKEM Development Team
+ * @version 1.0.0
+ * @date 2024
+ *
+ * @see async_kem.hpp for AsyncKemPost
+ * @see color_kem.hpp for KemExecutor
+ */
+
+#ifndef PRIORITY_EXECUTOR_HPP
+#define PRIORITY_EXECUTOR_HPP
+
+#include "async_kem.hpp"
+#include "color_kem.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+
+namespace clwe {
+
+/** @brief Urgency of a PriorityExecutor job, most urgent first */
+enum class WorkClass {
+    FOREGROUND = 0,   /**< Request-path operations: encapsulation, decapsulation */
+    PREPARATION = 1,  /**< Keys about to be used: rotations, expansions, registry preparation */
+    BACKGROUND = 2    /**< Throughput work nobody waits on: key pool refills */
+};
+
+/** @brief Number of WorkClass values */
+constexpr size_t WORK_CLASS_COUNT = 3;
+
+/** @brief Thread count and per-class caps of a PriorityExecutor */
+struct PriorityExecutorConfig {
+    size_t threads = 0;                  /**< Worker threads; 0 uses std::thread::hardware_concurrency() */
+    size_t max_preparation_threads = 0;  /**< Most workers running PREPARATION jobs at once; 0 for no cap */
+    size_t max_background_threads = 1;   /**< Most workers running BACKGROUND jobs at once; 0 for no cap */
+    /** @brief Called on the worker with the exception of a posted job that threw; empty drops it */
+    std::function<void(WorkClass, std::exception_ptr)> on_error;
+};
+
+/**
+ * @brief Thread pool that runs the most urgent work class first
+ *
+ * Jobs run to completion: a foreground job arriving while every worker is
+ * busy starts on the first worker that finishes its job, ahead of every
+ * queued preparation or background job. It preempts at job boundaries, so
+ * long maintenance work should be posted as short jobs. KeygenPool does this
+ * when given an executor (KeygenPoolConfig::executor): it generates one key
+ * per job. A class capped at k workers never holds more than k of them, and
+ * with k below threads the rest stay free for more urgent work. Within a
+ * class, jobs run in the order they were posted.
+ *
+ * poster() and parallel_for() adapt the pool to the hooks of AsyncKEM,
+ * HybridKEM and ColorKEM::set_executor().
+ *
+ * Example usage:
+ * @code
+ * clwe::PriorityExecutor executor;
+ * clwe::AsyncKEM kem(params, executor.poster(clwe::WorkClass::FOREGROUND));
+ * clwe::KeygenPoolConfig pool_config;
+ * pool_config.executor = &executor;  // refills run as BACKGROUND jobs
+ * clwe::KeygenPool pool(params, pool_config);
+ * executor.post(clwe::WorkClass::PREPARATION, [&ring] { ring.rotate(); });
+ * @endcode
+ *
+ * @note All member functions are thread-safe. A job that throws is counted
+ *       in failed() and its exception passed to PriorityExecutorConfig::on_error;
+ *       the worker goes on with the next job.
+ */
+class PriorityExecutor {
+public:
+    /**
+     * @brief Start the workers
+     *
+     * @throws std::invalid_argument If a cap exceeds the thread count
+     */
+    explicit PriorityExecutor(const PriorityExecutorConfig& config = PriorityExecutorConfig());
+
+    /** @brief Run every queued job, then join the workers */
+    ~PriorityExecutor();
+
+    PriorityExecutor(const PriorityExecutor&) = delete;             /**< Copy constructor disabled */
+    PriorityExecutor& operator=(const PriorityExecutor&) = delete;  /**< Copy assignment disabled */
+
+    /** @brief Queue job to run on a worker under work_class */
+    void post(WorkClass work_class, std::function<void()> job);
+
+    /** @brief AsyncKemPost that posts under work_class; the executor must outlive its users */
+    AsyncKemPost poster(WorkClass work_class);
+
+    /**
+     * @brief KemExecutor that spreads a parallel-for over the workers under work_class
+     *
+     * The calling thread runs tasks too, so a call finishes even while every
+     * worker is busy or capped. An exception from a task is rethrown to the
+     * caller once every task has finished. The executor must outlive its users.
+     */
+    KemExecutor parallel_for(WorkClass work_class);
+
+    /** @brief Jobs of work_class queued and not yet started */
+    size_t pending(WorkClass work_class) const;
+
+    /** @brief Jobs of work_class finished since construction, including failed ones */
+    uint64_t completed(WorkClass work_class) const;
+
+    /** @brief Jobs of work_class that threw since construction */
+    uint64_t failed(WorkClass work_class) const;
+
+    /** @brief Number of worker threads */
+    size_t threads() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace clwe
+
+#endif // PRIORITY_EXECUTOR_HPP
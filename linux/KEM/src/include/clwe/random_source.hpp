@@ -0,0 +1,125 @@
+/**
+ * @file random_source.hpp
+ * @brief Entropy sources that ColorKEM draws its seeds from
+ *
+ * This header defines RandomSource, the interface ColorKEM uses for every
+ * random byte it consumes (key generation seeds, encapsulation messages and
+ * batch seeds), and three implementations: direct OS entropy, the buffered
+ * per-thread ChaCha20 DRBG that is the default, and a deterministic seeded
+ * source for tests, fuzzers and benchmarks.
+ *
+ * @author ColorKEM Development Team
+ * @version 1.0.0
+ * @date 2024
+ *
+ * @see ColorKEM::set_random_source()
+ */
+
+#ifndef RANDOM_SOURCE_HPP
+#define RANDOM_SOURCE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace clwe {
+
+class ChaCha20Drbg;
+
+/**
+ * @brief Source of random bytes for ColorKEM
+ *
+ * A single ColorKEM instance may be used from several threads at once, so
+ * generate() must be safe to call concurrently.
+ */
+class RandomSource {
+public:
+    virtual ~RandomSource() = default;
+
+    /**
+     * @brief Fill out with len random bytes
+     *
+     * @param out Output buffer (len bytes)
+     * @param len Number of bytes to produce
+     * @throws std::runtime_error If the underlying source fails
+     */
+    virtual void generate(uint8_t* out, size_t len) = 0;
+
+    /**
+     * @brief Whether the output is unpredictable
+     *
+     * False only for DeterministicRandomSource, whose output anyone with the
+     * seed can recompute.
+     */
+    virtual bool is_secure() const { return true; }
+};
+
+/**
+ * @brief Operating system entropy on every call
+ *
+ * getrandom() on Linux, SecRandomCopyBytes() on macOS, BCryptGenRandom() on
+ * Windows. Each call is a system call; prefer DrbgRandomSource where that cost
+ * shows up.
+ */
+class OSRandomSource : public RandomSource {
+public:
+    void generate(uint8_t* out, size_t len) override;
+};
+
+/**
+ * @brief Buffered ChaCha20 DRBG, one per thread, seeded from the OS
+ *
+ * The source behind secure_random_bytes(): it reads OS entropy on first use in
+ * each thread, every 2^20 output bytes and after fork(), and serves the rest
+ * from a fast-key-erasure ChaCha20 buffer.
+ */
+class DrbgRandomSource : public RandomSource {
+public:
+    void generate(uint8_t* out, size_t len) override;
+};
+
+/**
+ * @brief Deterministic, seeded output for tests and benchmarks — NOT SECURE
+ *
+ * Produces the ChaCha20 DRBG stream for the given seed and never mixes in OS
+ * entropy, so two sources built from the same seed yield the same bytes and
+ * keys generated from it are reproducible by anyone who knows the seed. Use it
+ * to make benchmarks measure the KEM instead of the entropy source and to keep
+ * fuzzing and known-answer runs fast and repeatable; never for real keys.
+ *
+ * Calls are serialized by a mutex, so concurrent use is safe, but the order in
+ * which threads receive bytes is then not reproducible.
+ */
+class DeterministicRandomSource : public RandomSource {
+public:
+    /** @param seed 32-byte seed; equal seeds give equal output streams */
+    explicit DeterministicRandomSource(const std::array<uint8_t, 32>& seed);
+    ~DeterministicRandomSource() override;
+
+    DeterministicRandomSource(const DeterministicRandomSource&) = delete;             /**< Copy disabled */
+    DeterministicRandomSource& operator=(const DeterministicRandomSource&) = delete;  /**< Copy disabled */
+
+    void generate(uint8_t* out, size_t len) override;
+
+    /** @return false */
+    bool is_secure() const override { return false; }
+
+private:
+    std::unique_ptr<ChaCha20Drbg> drbg_;
+    std::mutex mutex_;
+};
+
+/**
+ * @brief The process-wide default source
+ *
+ * A shared DrbgRandomSource, or an OSRandomSource in builds with
+ * CLWE_DIRECT_OS_RANDOM, matching secure_random_bytes(). Every ColorKEM starts
+ * with it.
+ */
+std::shared_ptr<RandomSource> default_random_source();
+
+} // namespace clwe
+
+#endif // RANDOM_SOURCE_HPP
@@ -0,0 +1,69 @@
+/**
+ * @file secure_memory.hpp
+ * @brief Locked, dump-excluded memory pool for secret ColorKEM buffers
+ *
+ * enable_secure_memory() reserves one region, locks it into RAM (mlock,
+ * VirtualLock) and excludes it from core dumps (madvise(MADV_DONTDUMP) on
+ * Linux), once. From then on polynomial buffers (prepared and expanded
+ * private keys, noise vectors) and workspace arenas are carved from it in
+ * fixed power-of-two slots, so keeping secrets out of swap and crash dumps
+ * costs no system call per allocation. A released slot is wiped before it is
+ * reused.
+ *
+ * The pool is best effort: blocks it cannot hold (it is full, or a block is
+ * larger than its free space) come from the set_allocator() hooks as before,
+ * and are counted in SecureMemoryStats::fallbacks. Serialized keys
+ * (ColorPrivateKey::secret_data) are caller-owned vectors and stay outside
+ * the pool.
+ *
+ * @author ColorKEM Development Team
+ * @version 1.0.0
+ * @date 2024
+ *
+ * @see allocator.hpp, page_allocation.hpp
+ */
+
+#ifndef CLWE_SECURE_MEMORY_HPP
+#define CLWE_SECURE_MEMORY_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace clwe {
+
+/** @brief State of the secure memory pool */
+struct SecureMemoryStats {
+    size_t region_bytes = 0;           /**< Size of the pool region; 0 before enable_secure_memory() */
+    size_t bytes_in_use = 0;           /**< Bytes of the slots currently handed out */
+    size_t slots_in_use = 0;           /**< Slots currently handed out */
+    uint64_t fallbacks = 0;            /**< Blocks that did not fit and came from the general allocator */
+    bool locked = false;               /**< The region is locked into RAM (RLIMIT_MEMLOCK permitting) */
+    bool excluded_from_dumps = false;  /**< The region is left out of core dumps */
+};
+
+/**
+ * @brief Reserve and lock the secure memory pool
+ *
+ * Thread-safe. Only the first successful call reserves a region; later calls
+ * leave it as it is. The region is kept until the process exits. Blocks
+ * allocated before the pool existed stay where they are.
+ *
+ * A region the OS will not lock is still used, with SecureMemoryStats::locked
+ * false: it keeps the secrets out of core dumps and in one wiped place.
+ *
+ * @param region_bytes Pool size, rounded up to whole pages
+ * @return bool True if the pool is active, false if the OS could not map it
+ *
+ * @throws std::invalid_argument If region_bytes is 0
+ */
+bool enable_secure_memory(size_t region_bytes);
+
+/** @brief Whether enable_secure_memory() has reserved the pool */
+bool secure_memory_enabled();
+
+/** @brief Current pool usage; all zero before the pool is enabled */
+SecureMemoryStats secure_memory_stats();
+
+} // namespace clwe
+
+#endif // CLWE_SECURE_MEMORY_HPP
@@ -25,10 +25,45 @@
 #include <cstdint>
 #include <vector>
 #include <array>
+#include "clwe/tiny_sha3.h"
+#include "clwe/keccak_backend.hpp"
+
+#ifdef CLWE_HAVE_OPENSSL
 #include <openssl/evp.h>
+#include <openssl/opensslv.h>
+
+/**
+ * @brief Incremental XOF squeezing is available in OpenSSL 3.3 and later
+ *
+ * The samplers use OpenSSL EVP only in builds that link OpenSSL
+ * (CLWE_WITH_OPENSSL, which defines CLWE_HAVE_OPENSSL) and only when it can
+ * squeeze repeatedly. Older OpenSSL releases can only finalize a SHAKE context
+ * once, and builds without OpenSSL have no EVP at all; both use the bundled
+ * Keccak implementation instead.
+ */
+#if OPENSSL_VERSION_NUMBER >= 0x30300000L
+#define CLWE_HAVE_EVP_DIGEST_SQUEEZE 1
+#endif
+#endif
 
 namespace clwe {
 
+/** @brief SHAKE-128 rate in bytes (size of one squeezed block) */
+constexpr size_t SHAKE128_RATE = 168;
+
+/** @brief SHAKE-256 rate in bytes (size of one squeezed block) */
+constexpr size_t SHAKE256_RATE = 136;
+
+#ifdef CLWE_HAVE_EVP_DIGEST_SQUEEZE
+/**
+ * @brief OpenSSL SHAKE digest for a rate, fetched once per process
+ *
+ * @param rate SHAKE128_RATE or SHAKE256_RATE
+ * @return const EVP_MD* nullptr if no provider implements it
+ */
+const EVP_MD* shake_evp_md(size_t rate);
+#endif
+
 /**
  * @brief SHAKE-128 based sampler for public cryptographic operations
  *
@@ -40,20 +75,26 @@ namespace clwe {
  */
 class SHAKE128Sampler {
 private:
-    EVP_MD_CTX* ctx_;              /**< OpenSSL EVP context for SHAKE-128 */
-    std::vector<uint8_t> output_buffer_;  /**< Internal buffer for squeezed output */
-    size_t output_pos_ = 0;        /**< Current position in output buffer */
+#ifdef CLWE_HAVE_EVP_DIGEST_SQUEEZE
+    EVP_MD_CTX* evp_ctx_ = nullptr;  /**< OpenSSL EVP context, created on first use of that backend */
+    bool use_evp_ = false;           /**< The stream runs on OpenSSL rather than sponge_ */
+#endif
+    KeccakSponge sponge_;            /**< SHAKE-128 state on the other backends */
+    std::array<uint8_t, SHAKE128_RATE> block_;  /**< One rate-sized block of squeezed output */
+    size_t block_pos_;             /**< Bytes of block_ already consumed */
 
     /** @brief Reset internal state */
     void reset();
 
+    /** @brief Squeeze the next rate-sized block into block_ */
+    void refill_block();
+
 public:
     /**
      * @brief Construct SHAKE-128 sampler
      *
-     * Initializes the OpenSSL EVP context for SHAKE-128 operations.
-     *
-     * @throws std::runtime_error If OpenSSL context initialization fails
+     * Allocates nothing; the OpenSSL context is created the first time the
+     * sampler is initialized on that backend.
      */
     SHAKE128Sampler();
 
@@ -64,13 +105,20 @@ public:
      */
     ~SHAKE128Sampler();
 
+    SHAKE128Sampler(const SHAKE128Sampler&) = delete;
+    SHAKE128Sampler& operator=(const SHAKE128Sampler&) = delete;
+
     /**
      * @brief Initialize sampler with seed
      *
      * Absorbs the seed into the SHAKE-128 sponge, preparing for squeezing.
+     * Output is produced lazily one block at a time, so there is no limit on
+     * how many bytes may be squeezed afterwards. The stream runs on the
+     * keccak_backend() selected at this call.
      *
      * @param seed Seed bytes for initialization
      * @param seed_len Length of seed in bytes
+     * @throws std::runtime_error If the OpenSSL backend fails
      */
     void init(const uint8_t* seed, size_t seed_len);
 
@@ -85,6 +133,66 @@ public:
     void squeeze(uint8_t* out, size_t len);
 };
 
+/**
+ * @brief Four SHAKE-128 instances evaluated in lockstep
+ *
+ * Used for matrix expansion, where many independent seeds are hashed at once.
+ * The permutation is the four-lane one of the keccak_backend() selected at
+ * init_x4(): AVX2 when available, scalar Keccak on the Reference backend or
+ * without AVX2. Each lane's output equals SHAKE128Sampler fed the same seed.
+ */
+class SHAKE128x4Sampler {
+private:
+    uint64_t state_[25][4];
+    KeccakF1600x4Fn permute_ = nullptr;  /**< Permutation of the backend captured by init_x4() */
+
+public:
+    /**
+     * @brief Absorb four seeds of equal length and apply SHAKE padding
+     *
+     * @param seeds Four seed pointers
+     * @param seed_len Length of every seed in bytes; must be below SHAKE128_RATE
+     */
+    void init_x4(const uint8_t* const seeds[4], size_t seed_len);
+
+    /**
+     * @brief Squeeze whole rate-sized blocks from all four lanes
+     *
+     * @param out Four output buffers of nblocks * SHAKE128_RATE bytes each
+     * @param nblocks Number of blocks to squeeze per lane
+     */
+    void squeeze_blocks_x4(uint8_t* const out[4], size_t nblocks);
+};
+
+/**
+ * @brief Four SHAKE-256 instances evaluated in lockstep
+ *
+ * Used to expand several noise seeds at once; each lane's output equals
+ * SHAKE256Sampler fed the same seed.
+ */
+class SHAKE256x4Sampler {
+private:
+    uint64_t state_[25][4];
+    KeccakF1600x4Fn permute_ = nullptr;  /**< Permutation of the backend captured by init_x4() */
+
+public:
+    /**
+     * @brief Absorb four seeds of equal length and apply SHAKE padding
+     *
+     * @param seeds Four seed pointers
+     * @param seed_len Length of every seed in bytes; must be below SHAKE256_RATE
+     */
+    void init_x4(const uint8_t* const seeds[4], size_t seed_len);
+
+    /**
+     * @brief Squeeze whole rate-sized blocks from all four lanes
+     *
+     * @param out Four output buffers of nblocks * SHAKE256_RATE bytes each
+     * @param nblocks Number of blocks to squeeze per lane
+     */
+    void squeeze_blocks_x4(uint8_t* const out[4], size_t nblocks);
+};
+
 /**
  * @brief SHAKE-256 based sampler for cryptographic random number generation
  *
@@ -101,20 +209,26 @@ public:
  */
 class SHAKE256Sampler {
 private:
-    EVP_MD_CTX* ctx_;              /**< OpenSSL EVP context for SHAKE-256 */
-    std::vector<uint8_t> output_buffer_;  /**< Internal buffer for squeezed output */
-    size_t output_pos_ = 0;        /**< Current position in output buffer */
+#ifdef CLWE_HAVE_EVP_DIGEST_SQUEEZE
+    EVP_MD_CTX* evp_ctx_ = nullptr;  /**< OpenSSL EVP context, created on first use of that backend */
+    bool use_evp_ = false;           /**< The stream runs on OpenSSL rather than sponge_ */
+#endif
+    KeccakSponge sponge_;            /**< SHAKE-256 state on the other backends */
+    std::array<uint8_t, SHAKE256_RATE> block_;  /**< One rate-sized block of squeezed output */
+    size_t block_pos_;             /**< Bytes of block_ already consumed */
 
     /** @brief Reset internal state */
     void reset();
 
+    /** @brief Squeeze the next rate-sized block into block_ */
+    void refill_block();
+
 public:
     /**
      * @brief Construct SHAKE-256 sampler
      *
-     * Initializes the OpenSSL EVP context for SHAKE-256 operations.
-     *
-     * @throws std::runtime_error If OpenSSL context initialization fails
+     * Allocates nothing; the OpenSSL context is created the first time the
+     * sampler is initialized on that backend.
      */
     SHAKE256Sampler();
 
@@ -125,16 +239,42 @@ public:
      */
     ~SHAKE256Sampler();
 
+    SHAKE256Sampler(const SHAKE256Sampler&) = delete;
+    SHAKE256Sampler& operator=(const SHAKE256Sampler&) = delete;
+
     /**
      * @brief Initialize sampler with seed
      *
      * Absorbs the seed into the SHAKE-256 sponge, preparing for sampling operations.
+     * The stream runs on the keccak_backend() selected at this call (or at begin()).
      *
      * @param seed Seed bytes for initialization (cryptographically random)
      * @param seed_len Length of seed in bytes
      */
     void init(const uint8_t* seed, size_t seed_len);
 
+    /**
+     * @brief Start a streaming absorb
+     *
+     * Call absorb() for each input fragment and finalize() before squeezing.
+     * init(seed, len) is begin(), absorb(seed, len), finalize().
+     */
+    void begin();
+
+    /** @brief Absorb one input fragment */
+    void absorb(const uint8_t* data, size_t len);
+
+    /** @brief Finish absorbing and switch the sponge to squeezing */
+    void finalize();
+
+    /**
+     * @brief Squeeze pseudorandom bytes from SHAKE-256
+     *
+     * @param out Output buffer for squeezed bytes
+     * @param len Number of bytes to squeeze
+     */
+    void squeeze(uint8_t* out, size_t len);
+
     /**
      * @brief Sample single coefficient from binomial distribution
      *
@@ -151,6 +291,8 @@ public:
      *
      * Fills a polynomial with coefficients sampled from the binomial distribution.
      * This is the primary sampling function for secret key and error polynomials.
+     * For eta 2 and 3 with degree a multiple of 64, the coefficients are
+     * bit-sliced from exactly degree * eta / 4 bytes (AVX2/NEON when available).
      *
      * @param coeffs Output array for polynomial coefficients
      * @param degree Degree of the polynomial (n)
@@ -212,6 +354,19 @@ public:
      */
     void sample_polynomial_uniform(uint32_t* coeffs, size_t degree, uint32_t modulus);
 
+    /**
+     * @brief Sample a uniform polynomial with the vectorized rejection kernel
+     *
+     * Squeezes output a chunk at a time and keeps 12-bit candidates below the
+     * modulus (AVX2 or NEON when available). The stream differs from
+     * sample_polynomial_uniform(); moduli above 4096 fall back to it.
+     *
+     * @param coeffs Output array for coefficients
+     * @param degree Polynomial degree (number of coefficients)
+     * @param modulus Modulus for coefficient range
+     */
+    void sample_polynomial_uniform_fast(uint32_t* coeffs, size_t degree, uint32_t modulus);
+
     /**
      * @brief Generate cryptographically secure random bytes
      *
@@ -224,6 +379,18 @@ public:
     void random_bytes(uint8_t* out, size_t len);
 };
 
+/**
+ * @brief Per-thread SHAKE-128 sampler reused across calls
+ *
+ * init() resets the sponge, so callers get a ready context without creating
+ * a new EVP context or buffer each time. Do not hold the reference across a
+ * call that may itself use the same sampler.
+ */
+SHAKE128Sampler& thread_shake128();
+
+/** @brief Per-thread SHAKE-256 sampler; same contract as thread_shake128() */
+SHAKE256Sampler& thread_shake256();
+
 } // namespace clwe
 
 #endif // SHAKE_SAMPLER_HPP
\ No newline at end of file
@@ -0,0 +1,77 @@
+/**
+ * @file warmup.hpp
+ * @brief Pay first-request costs before a process takes traffic
+ *
+ * The first operation after process start is much slower than steady state:
+ * CPU feature detection, the OpenSSL SHAKE fetch, NTT twiddle tables, the
+ * per-thread workspace arenas and the CSPRNG seed are all set up lazily, and
+ * every buffer takes its first-touch page faults on the way. warmup() does all
+ * of that up front, so an autoscaled instance answers its first request at
+ * steady-state latency.
+ *
+ * Per-thread state (workspaces, the re-encryption ciphertext, sampler and NTT
+ * scratch, the CSPRNG) is only warmed on the calling thread: call warmup() on
+ * every worker thread, or once per thread from a pool's start hook. Process-wide
+ * state is shared, so later calls on other threads cost only their own part.
+ *
+ * Example usage:
+ * @code
+ * clwe::CPUFeatureDetector::force_backend(clwe::SIMDSupport::AVX2);  // optional, first
+ * clwe::warmup({clwe::CLWEParameters(768)});
+ * @endcode
+ *
+ * @author ColorKEM Development Team
+ * @version 1.0.0
+ * @date 2024
+ *
+ * @see KemWorkspace, ColorKEM::memory_requirements
+ */
+
+#ifndef WARMUP_HPP
+#define WARMUP_HPP
+
+#include <cstddef>
+#include <vector>
+#include "clwe.hpp"
+#include "keccak_backend.hpp"
+
+namespace clwe {
+
+class KemWorkspace;
+
+/** @brief What one warmup() call touched */
+struct WarmupReport {
+    size_t parameter_sets = 0;                   /**< Parameter sets run end to end */
+    std::vector<KeccakBackend> keccak_backends;  /**< Keccak backends permuted at least once */
+    size_t workspace_bytes = 0;                  /**< Largest arena a warmed workspace now holds */
+    double elapsed_us = 0.0;                     /**< Wall time of the call */
+};
+
+/**
+ * @brief Warm every lazy cache the given parameter sets would hit
+ *
+ * Latches CPU dispatch, fetches the OpenSSL SHAKE digests, runs a dummy
+ * permutation through each of available_keccak_backends() (the selected
+ * backend is left as it is), then for each parameter set builds its NTT
+ * engine and runs one keygen, encapsulate and decapsulate in both the color
+ * mode and, where supported, the 256-bit key mode, through the calling
+ * thread's workspaces. Dispatch is latched on the first call, so
+ * CPUFeatureDetector::force_backend() and set_keccak_backend() belong before it.
+ *
+ * @param params_list Parameter sets to warm; empty warms only the shared state
+ * @return WarmupReport What was warmed
+ *
+ * @throws std::invalid_argument If a parameter set is invalid
+ * @throws std::runtime_error If the dummy operations fail (e.g. no entropy)
+ */
+WarmupReport warmup(const std::vector<CLWEParameters>& params_list);
+
+/** @brief warmup() that also runs the operations through, and so prefaults, a caller-owned workspace */
+WarmupReport warmup(const std::vector<CLWEParameters>& params_list, KemWorkspace& workspace);
+
+/** @brief warmup() of the three ML-KEM security levels 512, 768 and 1024 */
+WarmupReport warmup();
+
+} // namespace clwe
+
+#endif // WARMUP_HPP
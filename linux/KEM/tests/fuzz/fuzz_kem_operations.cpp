@@ -1,8 +1,10 @@
+#include <algorithm>
 #include <cstdint>
 #include <vector>
 #include <array>
 #include "clwe/color_kem.hpp"
 #include "clwe/clwe.hpp"
+#include "clwe/random_source.hpp"
 
 namespace clwe {
 
@@ -24,6 +26,12 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
         CLWEParameters params(security_level);
         ColorKEM kem(params);
 
+        // Seeds come from the input, not the OS: runs are reproducible and skip the
+        // entropy syscalls. Inputs shorter than a seed are zero-padded.
+        std::array<uint8_t, 32> seed{};
+        std::copy(data, data + std::min(size, seed.size()), seed.begin());
+        kem.set_random_source(std::make_shared<DeterministicRandomSource>(seed));
+
         // Test key generation
         try {
             auto [public_key, private_key] = kem.keygen();
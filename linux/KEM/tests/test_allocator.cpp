@@ -0,0 +1,183 @@
+#include <gtest/gtest.h>
+#include "clwe/allocator.hpp"
+#include "color_kem.hpp"
+#include "kem_arena.hpp"
+#include "library_allocator.hpp"
+#include "poly.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+
+namespace clwe {
+
+class AllocatorTest : public ::testing::Test {
+protected:
+    // Hooks over aligned operator new that count what passes through them
+    struct CountingHeap {
+        std::atomic<size_t> allocations{0};
+        std::atomic<size_t> deallocations{0};
+        std::atomic<size_t> secure_deallocations{0};
+        std::atomic<size_t> nonzero_frees{0};  // Plain frees of blocks that were not wiped
+        std::atomic<size_t> misaligned{0};
+        bool fail = false;
+
+        static void* allocate(size_t size, size_t alignment, void* context) {
+            auto* heap = static_cast<CountingHeap*>(context);
+            if (heap->fail) {
+                return nullptr;
+            }
+            void* ptr = ::operator new(size, std::align_val_t(alignment), std::nothrow);
+            if (reinterpret_cast<uintptr_t>(ptr) % alignment != 0) {
+                heap->misaligned.fetch_add(1);
+            }
+            heap->allocations.fetch_add(1);
+            return ptr;
+        }
+
+        static void deallocate(void* ptr, size_t size, size_t alignment, void* context) {
+            auto* heap = static_cast<CountingHeap*>(context);
+            const uint8_t* bytes = static_cast<const uint8_t*>(ptr);
+            if (std::any_of(bytes, bytes + size, [](uint8_t b) { return b != 0; })) {
+                heap->nonzero_frees.fetch_add(1);
+            }
+            heap->deallocations.fetch_add(1);
+            ::operator delete(ptr, std::align_val_t(alignment));
+        }
+
+        static void secure_deallocate(void* ptr, size_t size, size_t alignment, void* context) {
+            static_cast<CountingHeap*>(context)->secure_deallocations.fetch_add(1);
+            secure_zero(ptr, size);
+            ::operator delete(ptr, std::align_val_t(alignment));
+        }
+
+        AllocatorHooks hooks(bool with_secure = false) {
+            AllocatorHooks h;
+            h.allocate = allocate;
+            h.deallocate = deallocate;
+            h.secure_deallocate = with_secure ? secure_deallocate : nullptr;
+            h.context = this;
+            return h;
+        }
+    };
+
+    void TearDown() override {
+        set_allocator(AllocatorHooks{});
+    }
+};
+
+// Test that buffers, containers and arenas allocate through installed hooks
+TEST_F(AllocatorTest, RoutesLibraryAllocations) {
+    CountingHeap heap;
+    set_allocator(heap.hooks());
+    {
+        PolyVec vec(3, 256);
+        vec.data()[5] = ColorValue::from_math_value(17);
+        KemArena arena(4096);
+        LibraryVector<uint32_t> table(100, 7);
+        void* block = AVXAllocator::allocate(1000, 64);
+        ASSERT_NE(block, nullptr);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(block) % 64, 0u);
+        AVXAllocator::deallocate(block);
+        EXPECT_EQ(heap.allocations.load(), 4u);
+    }
+    EXPECT_EQ(heap.deallocations.load(), 4u);
+    EXPECT_EQ(heap.misaligned.load(), 0u);
+    // The polynomial is wiped before the hook frees it
+    EXPECT_EQ(heap.nonzero_frees.load(), 2u);  // The table and the AVX block header
+}
+
+// Test that blocks are freed through the hooks they came from after a switch
+TEST_F(AllocatorTest, FreesThroughOriginalHooks) {
+    CountingHeap first, second;
+    set_allocator(first.hooks());
+    auto poly = std::make_unique<Poly>(256);
+    auto table = std::make_unique<LibraryVector<int16_t>>(64);
+    void* block = AVXAllocator::allocate(128);
+    ASSERT_NE(block, nullptr);
+
+    set_allocator(second.hooks());
+    Poly copy = *poly;
+    LibraryVector<int16_t> copied_table = *table;
+    LibraryVector<int16_t> moved_table = std::move(*table);
+    poly.reset();
+    table.reset();
+    AVXAllocator::deallocate(block);
+    EXPECT_EQ(first.allocations.load(), 3u);
+    EXPECT_EQ(first.deallocations.load(), 2u);  // moved_table still holds the first heap's block
+    EXPECT_EQ(second.allocations.load(), 2u);
+    EXPECT_EQ(second.deallocations.load(), 0u);
+
+    set_allocator(AllocatorHooks{});
+    moved_table = LibraryVector<int16_t>();
+    EXPECT_EQ(first.deallocations.load(), 3u);
+}
+
+// Test that secret-bearing buffers use the secure hook when one is installed
+TEST_F(AllocatorTest, SecureDeallocateHook) {
+    CountingHeap heap;
+    set_allocator(heap.hooks(true));
+    {
+        Poly secret(256);
+        secret[0] = ColorValue::from_math_value(1);
+        LibraryVector<uint8_t> bytes(32);
+    }
+    EXPECT_EQ(heap.secure_deallocations.load(), 1u);
+    EXPECT_EQ(heap.deallocations.load(), 1u);
+}
+
+// Test that a full KEM round trip gives the same results under custom hooks
+TEST_F(AllocatorTest, KemUnderCustomHooks) {
+    CLWEParameters params(768);
+    ColorKEM kem(params);
+    std::array<uint8_t, 32> d{}, m{};
+    d.fill(3);
+    m.fill(9);
+    auto [reference_public, reference_private] = kem.keygen_derand(d);
+    auto [reference_ciphertext, reference_secret] = kem.encapsulate_derand(reference_public, m);
+
+    // Per-thread workspaces grown here outlive the test, so the heap must too
+    static CountingHeap heap;
+    set_allocator(heap.hooks(true));
+    {
+        ColorKEM hooked(params);
+        auto [public_key, private_key] = hooked.keygen_derand(d);
+        auto [ciphertext, secret] = hooked.encapsulate_derand(public_key, m);
+        EXPECT_EQ(public_key.public_data, reference_public.public_data);
+        EXPECT_EQ(ciphertext.ciphertext_data, reference_ciphertext.ciphertext_data);
+        EXPECT_EQ(secret, reference_secret);
+        PreparedPrivateKey prepared = hooked.prepare_private_key(private_key);
+        EXPECT_EQ(hooked.decapsulate(prepared, ciphertext), secret);
+    }
+    EXPECT_GT(heap.allocations.load(), 0u);
+}
+
+// Test hook validation, the getter and allocation failure
+TEST_F(AllocatorTest, ValidatesHooks) {
+    AllocatorHooks defaults = allocator_hooks();
+    EXPECT_NE(defaults.allocate, nullptr);
+    EXPECT_NE(defaults.deallocate, nullptr);
+
+    CountingHeap heap;
+    AllocatorHooks half = heap.hooks();
+    half.deallocate = nullptr;
+    EXPECT_THROW(set_allocator(half), std::invalid_argument);
+    AllocatorHooks secure_only;
+    secure_only.secure_deallocate = CountingHeap::secure_deallocate;
+    EXPECT_THROW(set_allocator(secure_only), std::invalid_argument);
+    EXPECT_EQ(allocator_hooks().allocate, defaults.allocate);
+
+    set_allocator(heap.hooks());
+    EXPECT_EQ(allocator_hooks().context, &heap);
+    heap.fail = true;
+    EXPECT_THROW(Poly(256), std::bad_alloc);
+    EXPECT_EQ(AVXAllocator::allocate(64), nullptr);
+    EXPECT_THROW(LibraryVector<uint32_t>(16), std::bad_alloc);
+
+    set_allocator(AllocatorHooks{});
+    EXPECT_EQ(allocator_hooks().allocate, defaults.allocate);
+}
+
+} // namespace clwe
@@ -0,0 +1,185 @@
+#include <gtest/gtest.h>
+#include "async_kem.hpp"
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace clwe {
+
+class AsyncKEMTest : public ::testing::Test {
+protected:
+    // Executor that holds jobs until the test runs them, so batching is deterministic
+    struct ManualExecutor {
+        std::mutex mutex;
+        std::deque<std::function<void()>> jobs;
+
+        AsyncKemPost post() {
+            return [this](std::function<void()> job) {
+                std::lock_guard<std::mutex> lock(mutex);
+                jobs.push_back(std::move(job));
+            };
+        }
+
+        size_t run_all() {
+            size_t ran = 0;
+            for (;;) {
+                std::function<void()> job;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (jobs.empty()) {
+                        return ran;
+                    }
+                    job = std::move(jobs.front());
+                    jobs.pop_front();
+                }
+                job();
+                ++ran;
+            }
+        }
+    };
+
+    CLWEParameters params{512};
+};
+
+// Test a full keygen / encapsulate / decapsulate exchange on the internal worker
+TEST_F(AsyncKEMTest, RoundTripOnInternalWorker) {
+    AsyncKEM kem(params);
+
+    std::promise<std::pair<ColorPublicKey, ColorPrivateKey>> keys_promise;
+    kem.async_keygen([&](std::exception_ptr error, std::pair<ColorPublicKey, ColorPrivateKey> keys) {
+        EXPECT_FALSE(error);
+        keys_promise.set_value(std::move(keys));
+    });
+    auto keys = keys_promise.get_future().get();
+
+    std::promise<std::pair<ColorCiphertext, ColorValue>> encaps_promise;
+    kem.async_encapsulate(keys.first, [&](std::exception_ptr error, std::pair<ColorCiphertext, ColorValue> result) {
+        EXPECT_FALSE(error);
+        encaps_promise.set_value(std::move(result));
+    });
+    auto encapsulation = encaps_promise.get_future().get();
+
+    std::promise<ColorValue> decaps_promise;
+    kem.async_decapsulate(keys.first, keys.second, encapsulation.first, [&](std::exception_ptr error, ColorValue secret) {
+        EXPECT_FALSE(error);
+        decaps_promise.set_value(secret);
+    });
+    EXPECT_EQ(decaps_promise.get_future().get(), encapsulation.second);
+}
+
+// Test that concurrent requests are grouped into max_batch-sized jobs
+TEST_F(AsyncKEMTest, BatchesQueuedRequests) {
+    ManualExecutor executor;
+    AsyncKemConfig config;
+    config.max_batch = 4;
+    AsyncKEM kem(params, executor.post(), config);
+    ColorKEM sync_kem(params);
+    auto keys = sync_kem.keygen();
+    auto [ciphertext, secret] = sync_kem.encapsulate(keys.first);
+
+    size_t completed = 0;
+    for (int i = 0; i < 10; ++i) {
+        kem.async_decapsulate(keys.first, keys.second, ciphertext, [&](std::exception_ptr error, ColorValue value) {
+            EXPECT_FALSE(error);
+            EXPECT_EQ(value, secret);
+            ++completed;
+        });
+    }
+    EXPECT_EQ(kem.pending(), 10u);
+    EXPECT_EQ(executor.run_all(), 3u);  // 4 + 4 + 2
+    EXPECT_EQ(completed, 10u);
+    EXPECT_EQ(kem.pending(), 0u);
+}
+
+// Test that a bad input fails only its own request
+TEST_F(AsyncKEMTest, ErrorsStayWithTheirRequest) {
+    ManualExecutor executor;
+    AsyncKEM kem(params, executor.post());
+    auto keys = kem.kem().keygen();
+    ColorPublicKey invalid = keys.first;
+    invalid.public_data.resize(3);
+
+    std::vector<bool> failed;
+    auto handler = [&](std::exception_ptr error, std::pair<ColorCiphertext, ColorValue>) {
+        failed.push_back(static_cast<bool>(error));
+    };
+    kem.async_encapsulate(keys.first, handler);
+    kem.async_encapsulate(invalid, handler);
+    kem.async_encapsulate(keys.first, handler);
+    executor.run_all();
+
+    ASSERT_EQ(failed.size(), 3u);
+    EXPECT_FALSE(failed[0]);
+    EXPECT_TRUE(failed[1]);
+    EXPECT_FALSE(failed[2]);
+}
+
+// Test that a queued request can be cancelled and a started one cannot
+TEST_F(AsyncKEMTest, CancelQueuedRequest) {
+    ManualExecutor executor;
+    AsyncKEM kem(params, executor.post());
+
+    bool cancelled = false;
+    bool generated = false;
+    AsyncKEM::Ticket first = kem.async_keygen([&](std::exception_ptr error, std::pair<ColorPublicKey, ColorPrivateKey>) {
+        try {
+            if (error) std::rethrow_exception(error);
+        } catch (const AsyncKemCancelled&) {
+            cancelled = true;
+        }
+    });
+    AsyncKEM::Ticket second = kem.async_keygen([&](std::exception_ptr error, std::pair<ColorPublicKey, ColorPrivateKey>) {
+        generated = !error;
+    });
+    EXPECT_NE(first, second);
+
+    EXPECT_TRUE(kem.cancel(first));
+    EXPECT_FALSE(kem.cancel(first));
+    executor.run_all();
+    EXPECT_TRUE(cancelled);
+    EXPECT_TRUE(generated);
+    EXPECT_FALSE(kem.cancel(second));
+}
+
+// Test that destruction cancels requests that never ran and waits for the running one
+TEST_F(AsyncKEMTest, DestructorCancelsQueued) {
+    std::promise<void> started;
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    bool first_ok = false;
+    bool second_cancelled = false;
+    {
+        AsyncKEM kem(params);
+        kem.async_keygen([&](std::exception_ptr error, std::pair<ColorPublicKey, ColorPrivateKey>) {
+            started.set_value();
+            released.wait();
+            first_ok = !error;
+        });
+        started.get_future().wait();
+
+        // Queued behind the running batch; the destructor cancels it, which lets the first finish
+        kem.async_keygen([&](std::exception_ptr error, std::pair<ColorPublicKey, ColorPrivateKey>) {
+            try {
+                if (error) std::rethrow_exception(error);
+            } catch (const AsyncKemCancelled&) {
+                second_cancelled = true;
+            }
+            release.set_value();
+        });
+    }
+    EXPECT_TRUE(first_ok);
+    EXPECT_TRUE(second_cancelled);
+}
+
+// Test that a zero batch size is rejected
+TEST_F(AsyncKEMTest, RejectsZeroBatch) {
+    AsyncKemConfig config;
+    config.max_batch = 0;
+    EXPECT_THROW(AsyncKEM(params, AsyncKemPost(), config), std::invalid_argument);
+}
+
+} // namespace clwe
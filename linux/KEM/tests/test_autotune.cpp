@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+#include "clwe/autotune.hpp"
+#include "color_kem.hpp"
+#include "ntt_engine.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+namespace clwe {
+
+class AutotuneTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        profile_path_ = ::testing::TempDir() + "clwe_autotune_" + std::to_string(::getpid());
+        std::remove(profile_path_.c_str());
+        keccak_ = keccak_backend();
+        // Quick settings: the tests check the plumbing, not which backend wins
+        options_.params = CLWEParameters(512);
+        options_.repetitions = 1;
+        options_.min_run = std::chrono::microseconds(20);
+        options_.batch_sizes = {1, 4};
+    }
+
+    void TearDown() override {
+        std::remove(profile_path_.c_str());
+        reset_ntt_backend();
+        set_keccak_backend(keccak_);
+    }
+
+    std::string read_file() const {
+        std::ifstream file(profile_path_);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    std::string profile_path_;
+    KeccakBackend keccak_ = KeccakBackend::Reference;
+    AutotuneOptions options_;
+};
+
+// Test that the NTT backend can be selected and reaches instances built afterwards
+TEST_F(AutotuneTest, SelectsNttBackend) {
+    const std::vector<SIMDSupport> backends = available_ntt_backends();
+    ASSERT_FALSE(backends.empty());
+    EXPECT_EQ(backends.front(), SIMDSupport::NONE);
+    EXPECT_FALSE(ntt_backend_selected());
+    EXPECT_EQ(ntt_backend(), CPUFeatureDetector::cached().max_simd_support);
+
+    for (SIMDSupport backend : backends) {
+        SIMDSupport parsed;
+        ASSERT_TRUE(CPUFeatureDetector::parse_backend(ntt_backend_name(backend), parsed));
+        EXPECT_EQ(parsed, backend);
+
+        set_ntt_backend(backend);
+        EXPECT_EQ(ntt_backend(), backend);
+        ColorKEM kem(CLWEParameters(768));
+        EXPECT_EQ(kem.backend(), backend) << ntt_backend_name(backend);
+        auto [public_key, private_key] = kem.keygen();
+        auto [ciphertext, secret] = kem.encapsulate(public_key);
+        EXPECT_EQ(kem.decapsulate(public_key, private_key, ciphertext), secret);
+    }
+
+    for (SIMDSupport missing : {SIMDSupport::AVX2, SIMDSupport::NEON, SIMDSupport::RVV, SIMDSupport::VSX}) {
+        if (std::find(backends.begin(), backends.end(), missing) == backends.end()) {
+            EXPECT_THROW(set_ntt_backend(missing), std::invalid_argument);
+        }
+    }
+    reset_ntt_backend();
+    EXPECT_FALSE(ntt_backend_selected());
+}
+
+// Test that a measured run times every candidate and applies the winners
+TEST_F(AutotuneTest, MeasuresAndApplies) {
+    AutotuneResult result = autotune(options_);
+    EXPECT_FALSE(result.from_profile);
+    EXPECT_TRUE(result.applied);
+    EXPECT_EQ(result.cpu_key, autotune_cpu_key());
+    EXPECT_EQ(result.ntt_timings.size(), available_ntt_backends().size());
+    EXPECT_EQ(result.keccak_timings.size(), available_keccak_backends().size());
+    ASSERT_EQ(result.batch_timings.size(), 2u);
+    EXPECT_EQ(result.batch_timings[0].candidate, "1");
+    for (const auto& timing : result.ntt_timings) {
+        EXPECT_GT(timing.ns_per_op, 0.0) << timing.candidate;
+    }
+    EXPECT_TRUE(result.batch_size == 1 || result.batch_size == 4);
+    EXPECT_EQ(ntt_backend(), result.ntt_backend);
+    EXPECT_EQ(keccak_backend(), result.keccak_backend);
+    EXPECT_GT(result.elapsed_us, 0.0);
+
+    ColorKEM kem(CLWEParameters(768));
+    EXPECT_EQ(kem.backend(), result.ntt_backend);
+}
+
+// Test that apply = false leaves both selections as they were
+TEST_F(AutotuneTest, ReportOnlyRestoresSelections) {
+    options_.apply = false;
+    AutotuneResult result = autotune(options_);
+    EXPECT_FALSE(result.applied);
+    EXPECT_FALSE(ntt_backend_selected());
+    EXPECT_EQ(keccak_backend(), keccak_);
+
+    set_ntt_backend(SIMDSupport::NONE);
+    autotune(options_);
+    EXPECT_TRUE(ntt_backend_selected());
+    EXPECT_EQ(ntt_backend(), SIMDSupport::NONE);
+}
+
+// Test that the profile stores one entry per CPU and is reused until retune
+TEST_F(AutotuneTest, PersistsProfilePerCpu) {
+    {
+        std::ofstream file(profile_path_);
+        file << "other cpu, Architecture: ARM64, SIMD: NEON\tneon\tarmsha3\t8\n";
+    }
+    options_.profile_path = profile_path_;
+    AutotuneResult measured = autotune(options_);
+    EXPECT_FALSE(measured.from_profile);
+    std::string contents = read_file();
+    EXPECT_NE(contents.find("other cpu, Architecture: ARM64"), std::string::npos);
+    EXPECT_NE(contents.find(measured.cpu_key + "\t" + ntt_backend_name(measured.ntt_backend) + "\t" +
+                            keccak_backend_name(measured.keccak_backend) + "\t" +
+                            std::to_string(measured.batch_size) + "\n"),
+              std::string::npos);
+
+    reset_ntt_backend();
+    AutotuneResult loaded = autotune(options_);
+    EXPECT_TRUE(loaded.from_profile);
+    EXPECT_TRUE(loaded.ntt_timings.empty());
+    EXPECT_EQ(loaded.ntt_backend, measured.ntt_backend);
+    EXPECT_EQ(loaded.keccak_backend, measured.keccak_backend);
+    EXPECT_EQ(loaded.batch_size, measured.batch_size);
+    EXPECT_EQ(ntt_backend(), measured.ntt_backend);
+
+    options_.retune = true;
+    EXPECT_FALSE(autotune(options_).from_profile);
+    options_.retune = false;
+
+    // An entry naming a backend this host lacks is measured again and replaced
+    {
+        std::ofstream file(profile_path_);
+        file << measured.cpu_key << "\tbogus\treference\t4\n";
+    }
+    EXPECT_FALSE(autotune(options_).from_profile);
+    EXPECT_EQ(read_file().find("bogus"), std::string::npos);
+    EXPECT_TRUE(autotune(options_).from_profile);
+}
+
+// Test that unusable options are rejected up front
+TEST_F(AutotuneTest, RejectsInvalidOptions) {
+    AutotuneOptions options = options_;
+    options.repetitions = 0;
+    EXPECT_THROW(autotune(options), std::invalid_argument);
+    options = options_;
+    options.batch_sizes.clear();
+    EXPECT_THROW(autotune(options), std::invalid_argument);
+    options.batch_sizes = {4, 0};
+    EXPECT_THROW(autotune(options), std::invalid_argument);
+    options = options_;
+    options.params.degree = 100;
+    EXPECT_THROW(autotune(options), std::invalid_argument);
+    options = options_;
+    options.profile_path = "/nonexistent-dir/clwe-autotune";
+    EXPECT_THROW(autotune(options), std::runtime_error);
+}
+
+} // namespace clwe
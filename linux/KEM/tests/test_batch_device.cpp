@@ -0,0 +1,254 @@
+#include <gtest/gtest.h>
+#include "batch_offload.hpp"
+#include "color_kem.hpp"
+#include "encoding.hpp"
+#include "clwe/random_source.hpp"
+#include <array>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace clwe {
+
+namespace {
+
+std::array<uint8_t, 32> test_seed(uint8_t tag) {
+    std::array<uint8_t, 32> seed;
+    for (size_t i = 0; i < seed.size(); ++i) {
+        seed[i] = static_cast<uint8_t>(tag * 37 + i);
+    }
+    return seed;
+}
+
+std::vector<uint8_t> encode_residues(const uint32_t* values, size_t count, CoefficientEncoding encoding) {
+    std::vector<ColorValue> colors(count);
+    colors_from_u32(values, colors.data(), count);
+    std::vector<uint8_t> bytes(encoded_coefficients_size(count, encoding));
+    encode_coefficients(colors.data(), count, encoding, bytes.data());
+    return bytes;
+}
+
+std::vector<CLWEParameters> kernel_parameter_sets() {
+    std::vector<CLWEParameters> sets;
+    for (uint32_t level : {512u, 768u, 1024u}) {
+        sets.emplace_back(level);
+    }
+    CLWEParameters sparse(512);
+    sparse.sparse_c2 = true;
+    sets.push_back(sparse);
+    return sets;
+}
+
+} // namespace
+
+TEST(BatchDeviceTest, NamesRoundTrip) {
+    for (BatchDevice device : {BatchDevice::Cpu, BatchDevice::Cuda}) {
+        BatchDevice parsed = BatchDevice::Cpu;
+        ASSERT_TRUE(parse_batch_device(batch_device_name(device), parsed));
+        EXPECT_EQ(parsed, device);
+    }
+    BatchDevice parsed = BatchDevice::Cuda;
+    EXPECT_FALSE(parse_batch_device("tpu", parsed));
+    EXPECT_EQ(parsed, BatchDevice::Cuda);
+    EXPECT_TRUE(batch_device_available(BatchDevice::Cpu));
+}
+
+TEST(BatchDeviceTest, SetBatchDeviceValidates) {
+    ColorKEM kem(CLWEParameters(512));
+    EXPECT_EQ(kem.batch_device(), BatchDevice::Cpu);
+
+    GpuBatchConfig empty_launch;
+    empty_launch.instances_per_launch = 0;
+    EXPECT_THROW(kem.set_batch_device(BatchDevice::Cpu, empty_launch), std::invalid_argument);
+    GpuBatchConfig no_streams;
+    no_streams.streams = 0;
+    EXPECT_THROW(kem.set_batch_device(BatchDevice::Cpu, no_streams), std::invalid_argument);
+
+    if (!batch_device_available(BatchDevice::Cuda)) {
+        EXPECT_THROW(kem.set_batch_device(BatchDevice::Cuda), std::invalid_argument);
+        EXPECT_EQ(kem.batch_device(), BatchDevice::Cpu);
+    }
+    kem.set_batch_device(BatchDevice::Cpu);
+    EXPECT_EQ(kem.batch_device(), BatchDevice::Cpu);
+}
+
+TEST(BatchDeviceTest, KernelsCoverBuiltInLevels) {
+    for (const CLWEParameters& params : kernel_parameter_sets()) {
+        EXPECT_TRUE(batch_kernels_support(params));
+    }
+    CLWEParameters wide_noise(512);
+    wide_noise.eta1 = 4;
+    EXPECT_FALSE(batch_kernels_support(wide_noise));
+}
+
+// The host run of the kernel stages reproduces ColorKEM key generation bit for bit
+TEST(BatchDeviceTest, HostKeygenKernelsMatchColorKEM) {
+    for (const CLWEParameters& params : kernel_parameter_sets()) {
+        ColorKEM kem(params);
+        const size_t count = 3;
+        const size_t vec = static_cast<size_t>(params.module_rank) * params.degree;
+        std::vector<uint8_t> seeds(count * batch::INSTANCE_SEED_BYTES);
+        for (size_t i = 0; i < count; ++i) {
+            for (size_t part = 0; part < 3; ++part) {
+                std::array<uint8_t, 32> seed = test_seed(static_cast<uint8_t>(i * 3 + part));
+                std::copy(seed.begin(), seed.end(), seeds.begin() + i * batch::INSTANCE_SEED_BYTES + part * 32);
+            }
+        }
+        std::vector<uint32_t> t_hat(count * vec);
+        std::vector<uint32_t> s_hat(count * vec);
+        run_keygen_batch(BatchDevice::Cpu, GpuBatchConfig(), batch_kernel_params(params), seeds.data(), count,
+                         t_hat.data(), s_hat.data());
+
+        for (size_t i = 0; i < count; ++i) {
+            auto keys = kem.keygen_deterministic(test_seed(static_cast<uint8_t>(i * 3)),
+                                                 test_seed(static_cast<uint8_t>(i * 3 + 1)),
+                                                 test_seed(static_cast<uint8_t>(i * 3 + 2)));
+            EXPECT_EQ(encode_residues(t_hat.data() + i * vec, vec, params.encoding), keys.first.public_data)
+                << "level " << params.security_level << " instance " << i;
+            EXPECT_EQ(encode_residues(s_hat.data() + i * vec, vec, params.encoding), keys.second.secret_data)
+                << "level " << params.security_level << " instance " << i;
+        }
+    }
+}
+
+// ... and encapsulation, including the message term and the sparse c2 layout
+TEST(BatchDeviceTest, HostEncapsulationKernelsMatchColorKEM) {
+    for (const CLWEParameters& params : kernel_parameter_sets()) {
+        ColorKEM kem(params);
+        const size_t count = 4;
+        const size_t vec = static_cast<size_t>(params.module_rank) * params.degree;
+        const size_t out = vec + params.degree;
+
+        std::vector<ColorPublicKey> public_keys;
+        std::vector<uint8_t> matrix_seeds(count * batch::SEED_BYTES);
+        std::vector<uint8_t> noise_seeds(count * batch::INSTANCE_SEED_BYTES);
+        std::vector<uint32_t> messages(count);
+        std::vector<uint32_t> t_hat(count * vec);
+        for (size_t i = 0; i < count; ++i) {
+            public_keys.push_back(kem.keygen_derand(test_seed(static_cast<uint8_t>(100 + i))).first);
+            std::copy(public_keys[i].seed.begin(), public_keys[i].seed.end(),
+                      matrix_seeds.begin() + i * batch::SEED_BYTES);
+            std::vector<ColorValue> colors(vec);
+            decode_coefficients(public_keys[i].public_data.data(), vec, params.encoding, colors.data());
+            colors_to_u32(colors.data(), t_hat.data() + i * vec, vec);
+            for (size_t part = 0; part < 3; ++part) {
+                std::array<uint8_t, 32> seed = test_seed(static_cast<uint8_t>(200 + i * 3 + part));
+                std::copy(seed.begin(), seed.end(), noise_seeds.begin() + i * batch::INSTANCE_SEED_BYTES + part * 32);
+            }
+            messages[i] = static_cast<uint32_t>(i & 1);
+        }
+        std::vector<uint32_t> ciphertexts(count * out);
+        run_encapsulate_batch(BatchDevice::Cpu, GpuBatchConfig(), batch_kernel_params(params), matrix_seeds.data(),
+                              noise_seeds.data(), messages.data(), t_hat.data(), count, ciphertexts.data());
+
+        for (size_t i = 0; i < count; ++i) {
+            auto expected = kem.encapsulate_deterministic(public_keys[i], test_seed(static_cast<uint8_t>(200 + i * 3)),
+                                                          test_seed(static_cast<uint8_t>(200 + i * 3 + 1)),
+                                                          test_seed(static_cast<uint8_t>(200 + i * 3 + 2)),
+                                                          ColorValue::from_math_value(messages[i]));
+            const size_t c2_count = params.sparse_c2 ? 1 : params.degree;
+            std::vector<uint8_t> packed = encode_residues(ciphertexts.data() + i * out, vec, params.encoding);
+            std::vector<uint8_t> c2 = encode_residues(ciphertexts.data() + i * out + vec, c2_count, params.encoding);
+            packed.insert(packed.end(), c2.begin(), c2.end());
+            EXPECT_EQ(packed, expected.first.ciphertext_data)
+                << "level " << params.security_level << " instance " << i;
+        }
+    }
+}
+
+// The lane-interleaved host run gives what the per-instance one gives, including a short
+// last group of lanes
+TEST(BatchDeviceTest, LaneKernelsMatchHostKernels) {
+    for (const CLWEParameters& params : kernel_parameter_sets()) {
+        ColorKEM kem(params);
+        const size_t count = BATCH_LANES + 3;
+        const size_t vec = static_cast<size_t>(params.module_rank) * params.degree;
+        const size_t out = vec + params.degree;
+
+        std::vector<uint8_t> matrix_seeds(count * batch::SEED_BYTES);
+        std::vector<uint8_t> noise_seeds(count * batch::INSTANCE_SEED_BYTES);
+        std::vector<uint32_t> messages(count);
+        std::vector<uint32_t> t_hat(count * vec);
+        for (size_t i = 0; i < count; ++i) {
+            ColorPublicKey public_key = kem.keygen_derand(test_seed(static_cast<uint8_t>(50 + i))).first;
+            std::copy(public_key.seed.begin(), public_key.seed.end(), matrix_seeds.begin() + i * batch::SEED_BYTES);
+            std::vector<ColorValue> colors(vec);
+            decode_coefficients(public_key.public_data.data(), vec, params.encoding, colors.data());
+            colors_to_u32(colors.data(), t_hat.data() + i * vec, vec);
+            for (size_t b = 0; b < batch::INSTANCE_SEED_BYTES; ++b) {
+                noise_seeds[i * batch::INSTANCE_SEED_BYTES + b] = static_cast<uint8_t>(i * 131 + b * 7);
+            }
+            messages[i] = static_cast<uint32_t>((i * 977) % params.modulus);
+        }
+        const batch::KernelParams p = batch_kernel_params(params);
+        std::vector<uint32_t> expected(count * out);
+        std::vector<uint32_t> lanes(count * out);
+        run_encapsulate_batch_host(p, matrix_seeds.data(), noise_seeds.data(), messages.data(), t_hat.data(), count,
+                                   expected.data());
+        run_encapsulate_batch_lanes(p, matrix_seeds.data(), noise_seeds.data(), messages.data(), t_hat.data(), count,
+                                    lanes.data());
+        EXPECT_EQ(lanes, expected) << "level " << params.security_level;
+    }
+}
+
+// A CPU batch to different keys, which takes the lane path, matches encapsulate_derand()
+TEST(BatchDeviceTest, CpuLaneBatchMatchesDerand) {
+    for (const CLWEParameters& params : kernel_parameter_sets()) {
+        ColorKEM kem(params);
+        kem.set_random_source(std::make_shared<DeterministicRandomSource>(test_seed(9)));
+        std::vector<ColorPublicKey> public_keys;
+        for (size_t i = 0; i < BATCH_LANES + 1; ++i) {
+            public_keys.push_back(kem.keygen_derand(test_seed(static_cast<uint8_t>(150 + i))).first);
+        }
+        auto results = kem.encapsulate_batch(public_keys);
+
+        DeterministicRandomSource replay(test_seed(9));
+        std::vector<uint8_t> seeds(public_keys.size() * 32);
+        replay.generate(seeds.data(), seeds.size());
+        ASSERT_EQ(results.size(), public_keys.size());
+        for (size_t i = 0; i < public_keys.size(); ++i) {
+            std::array<uint8_t, 32> m;
+            std::copy(seeds.begin() + i * 32, seeds.begin() + (i + 1) * 32, m.begin());
+            auto expected = kem.encapsulate_derand(public_keys[i], m);
+            EXPECT_EQ(results[i].first.serialize(), expected.first.serialize())
+                << "level " << params.security_level << " request " << i;
+            EXPECT_EQ(results[i].second, expected.second);
+        }
+    }
+}
+
+// On a CUDA device the batch calls give what the CPU path gives for the same entropy
+TEST(BatchDeviceTest, CudaBatchMatchesCpu) {
+    if (!batch_device_available(BatchDevice::Cuda)) {
+        GTEST_SKIP() << "no CUDA device";
+    }
+    for (const CLWEParameters& params : kernel_parameter_sets()) {
+        ColorKEM cpu(params);
+        ColorKEM gpu(params);
+        GpuBatchConfig config;
+        config.instances_per_launch = 5;  // Several launches over both streams
+        gpu.set_batch_device(BatchDevice::Cuda, config);
+        cpu.set_random_source(std::make_shared<DeterministicRandomSource>(test_seed(1)));
+        gpu.set_random_source(std::make_shared<DeterministicRandomSource>(test_seed(1)));
+
+        auto cpu_keys = cpu.keygen_batch(17);
+        auto gpu_keys = gpu.keygen_batch(17);
+        ASSERT_EQ(cpu_keys.size(), gpu_keys.size());
+        std::vector<ColorPublicKey> public_keys;
+        for (size_t i = 0; i < cpu_keys.size(); ++i) {
+            EXPECT_EQ(cpu_keys[i].first.serialize(), gpu_keys[i].first.serialize());
+            EXPECT_EQ(cpu_keys[i].second.serialize(), gpu_keys[i].second.serialize());
+            public_keys.push_back(cpu_keys[i].first);
+        }
+
+        auto cpu_ct = cpu.encapsulate_batch(public_keys);
+        auto gpu_ct = gpu.encapsulate_batch(public_keys);
+        ASSERT_EQ(cpu_ct.size(), gpu_ct.size());
+        for (size_t i = 0; i < cpu_ct.size(); ++i) {
+            EXPECT_EQ(cpu_ct[i].first.serialize(), gpu_ct[i].first.serialize());
+            EXPECT_EQ(cpu_ct[i].second, gpu_ct[i].second);
+        }
+    }
+}
+
+} // namespace clwe
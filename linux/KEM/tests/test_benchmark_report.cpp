@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+#include "benchmark_report.hpp"
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace clwe {
+
+class BenchmarkReportTest : public ::testing::Test {
+protected:
+    static BenchmarkRecord record(const std::string& name, double mean_us, double stddev_us) {
+        BenchmarkRecord r;
+        r.name = name;
+        r.iterations = 100;
+        r.mean_us = mean_us;
+        r.stddev_us = stddev_us;
+        r.min_us = mean_us - stddev_us;
+        r.p50_us = mean_us;
+        r.p99_us = mean_us + 2 * stddev_us;
+        r.max_us = mean_us + 3 * stddev_us;
+        return r;
+    }
+
+    static BenchmarkReport sample_report() {
+        BenchmarkReport report;
+        report.environment = BenchmarkEnvironment::current();
+        report.environment.flags = "-O3 \"quoted\"";
+        report.environment.host = "governor=performance turbo=off cpu=2 smt_siblings=1 sibling_busy=0.00";
+        report.records.push_back(record("keygen/512", 58.25, 1.5));
+        report.records.push_back(record("decapsulate/512", 33.125, 0.75));
+        report.records.push_back(record("throughput/512/t4", 40.5, 3.0));
+        report.records.back().ops_per_sec = 98765.5;
+        return report;
+    }
+
+    static void expect_same(const BenchmarkReport& a, const BenchmarkReport& b) {
+        EXPECT_EQ(a.environment.cpu, b.environment.cpu);
+        EXPECT_EQ(a.environment.compiler, b.environment.compiler);
+        EXPECT_EQ(a.environment.flags, b.environment.flags);
+        EXPECT_EQ(a.environment.build_type, b.environment.build_type);
+        EXPECT_EQ(a.environment.commit, b.environment.commit);
+        EXPECT_EQ(a.environment.host, b.environment.host);
+        ASSERT_EQ(a.records.size(), b.records.size());
+        for (size_t i = 0; i < a.records.size(); ++i) {
+            EXPECT_EQ(a.records[i].name, b.records[i].name);
+            EXPECT_EQ(a.records[i].iterations, b.records[i].iterations);
+            EXPECT_DOUBLE_EQ(a.records[i].mean_us, b.records[i].mean_us);
+            EXPECT_DOUBLE_EQ(a.records[i].stddev_us, b.records[i].stddev_us);
+            EXPECT_DOUBLE_EQ(a.records[i].p99_us, b.records[i].p99_us);
+            EXPECT_DOUBLE_EQ(a.records[i].ops_per_sec, b.records[i].ops_per_sec);
+        }
+    }
+};
+
+// Test that the environment block describes this build
+TEST_F(BenchmarkReportTest, EnvironmentIsFilled) {
+    BenchmarkEnvironment env = BenchmarkEnvironment::current();
+    EXPECT_NE(env.cpu.find("Architecture"), std::string::npos);
+    EXPECT_FALSE(env.compiler.empty());
+    EXPECT_FALSE(env.commit.empty());
+}
+
+// Test that JSON and CSV reports read back unchanged
+TEST_F(BenchmarkReportTest, RoundTrip) {
+    BenchmarkReport report = sample_report();
+
+    std::stringstream json;
+    write_report_json(json, report);
+    expect_same(report, read_report(json));
+
+    std::stringstream csv;
+    write_report_csv(csv, report);
+    expect_same(report, read_report(csv));
+}
+
+// Test that malformed reports are rejected
+TEST_F(BenchmarkReportTest, RejectsMalformedInput) {
+    std::stringstream truncated("{\"results\": [{\"name\": \"keygen\"");
+    EXPECT_THROW(read_report(truncated), std::runtime_error);
+
+    std::stringstream bad_header("a,b,c\n");
+    EXPECT_THROW(read_report(bad_header), std::runtime_error);
+
+    std::stringstream bad_row("name,iterations,mean_us,stddev_us,min_us,p50_us,p99_us,max_us,ops_per_sec\nkeygen,1,2\n");
+    EXPECT_THROW(read_report(bad_row), std::runtime_error);
+}
+
+// Test that only significant, large enough slowdowns count as regressions
+TEST_F(BenchmarkReportTest, FlagsSignificantRegressions) {
+    BenchmarkReport baseline;
+    baseline.records.push_back(record("keygen/512", 100.0, 2.0));
+    baseline.records.push_back(record("encapsulate/512", 100.0, 2.0));
+    baseline.records.push_back(record("decapsulate/512", 100.0, 40.0));
+    baseline.records.push_back(record("only_in_baseline", 1.0, 0.1));
+
+    BenchmarkReport candidate;
+    candidate.records.push_back(record("decapsulate/512", 110.0, 40.0));  // Within the noise
+    candidate.records.push_back(record("keygen/512", 110.0, 2.0));        // 10% slower
+    candidate.records.push_back(record("encapsulate/512", 90.0, 2.0));    // 10% faster
+
+    std::vector<BenchmarkComparison> comparisons = compare_reports(baseline, candidate);
+    ASSERT_EQ(comparisons.size(), 3u);
+
+    EXPECT_EQ(comparisons[0].name, "keygen/512");
+    EXPECT_NEAR(comparisons[0].change, 0.10, 1e-12);
+    EXPECT_LT(comparisons[0].p_value, 0.01);
+    EXPECT_TRUE(comparisons[0].regression);
+
+    EXPECT_TRUE(comparisons[1].improvement);
+    EXPECT_FALSE(comparisons[1].regression);
+
+    EXPECT_GT(comparisons[2].p_value, 0.01);
+    EXPECT_FALSE(comparisons[2].regression);
+
+    // The same slowdown is ignored once it is under the change threshold
+    BenchmarkCompareOptions lenient;
+    lenient.min_change = 0.2;
+    EXPECT_FALSE(compare_reports(baseline, candidate, lenient)[0].regression);
+}
+
+// Test the run-to-run spread and the median run's record
+TEST_F(BenchmarkReportTest, SummarizesRepeats) {
+    std::vector<BenchmarkReport> runs(3);
+    const double keygen_means[3] = {104.0, 100.0, 96.0};
+    for (size_t i = 0; i < runs.size(); ++i) {
+        runs[i].records.push_back(record("keygen/512", keygen_means[i], 1.0));
+        if (i != 1) {
+            runs[i].records.push_back(record("decapsulate/512", 50.0, 0.5));
+        }
+    }
+
+    std::vector<BenchmarkRepeatSummary> summaries = summarize_repeats(runs);
+    ASSERT_EQ(summaries.size(), 2u);
+    EXPECT_EQ(summaries[0].name, "keygen/512");
+    EXPECT_EQ(summaries[0].runs, 3u);
+    EXPECT_DOUBLE_EQ(summaries[0].mean_us, 100.0);
+    EXPECT_DOUBLE_EQ(summaries[0].min_us, 96.0);
+    EXPECT_DOUBLE_EQ(summaries[0].max_us, 104.0);
+    EXPECT_NEAR(summaries[0].cv, 0.04, 1e-12);
+    EXPECT_DOUBLE_EQ(summaries[0].median.mean_us, 100.0);
+
+    EXPECT_EQ(summaries[1].runs, 2u);
+    EXPECT_DOUBLE_EQ(summaries[1].cv, 0.0);
+    EXPECT_TRUE(summarize_repeats({}).empty());
+}
+
+// Test host inspection and its warnings; sysfs may be missing in containers
+TEST_F(BenchmarkReportTest, InspectsHostState) {
+    BenchmarkHostState quiet;
+    quiet.governor = "performance";
+    quiet.turbo = 0;
+    quiet.pinned_cpu = 2;
+    quiet.sibling_busy = 0.0;
+    EXPECT_TRUE(quiet.warnings().empty());
+
+    BenchmarkHostState noisy = quiet;
+    noisy.governor = "powersave";
+    noisy.turbo = 1;
+    noisy.sibling_busy = 0.5;
+    EXPECT_EQ(noisy.warnings().size(), 3u);
+    noisy.pinned_cpu = -1;
+    EXPECT_EQ(noisy.warnings().size(), 4u);
+    EXPECT_NE(noisy.to_string().find("governor=powersave turbo=on cpu=unpinned"), std::string::npos);
+
+    // Pin a scratch thread so the test thread keeps its affinity
+    std::thread([] {
+        unsigned cpu = 0;
+#if defined(__linux__)
+        int current = sched_getcpu();
+        cpu = current >= 0 ? static_cast<unsigned>(current) : 0;
+#endif
+        if (!pin_current_thread(cpu)) {
+            return;
+        }
+        BenchmarkHostState pinned = BenchmarkHostState::inspect(std::chrono::milliseconds(20));
+        EXPECT_EQ(pinned.pinned_cpu, static_cast<int>(cpu));
+        for (unsigned sibling : pinned.smt_siblings) {
+            EXPECT_NE(sibling, cpu);
+        }
+        EXPECT_LE(pinned.sibling_busy, 1.0);
+    }).join();
+}
+
+} // namespace clwe
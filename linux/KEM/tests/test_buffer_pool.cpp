@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include "clwe/buffer_pool.hpp"
+#include "color_kem.hpp"
+#include "allocation_tracker.hpp"
+#include <array>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace clwe {
+
+class BufferPoolTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        params = CLWEParameters(768);
+        kem = std::make_unique<ColorKEM>(params);
+        keys = kem->keygen();
+    }
+
+    CLWEParameters params;
+    std::unique_ptr<ColorKEM> kem;
+    std::pair<ColorPublicKey, ColorPrivateKey> keys;
+};
+
+// Test that acquired objects are sized for the pool's parameters and usable as usual
+TEST_F(BufferPoolTest, AcquireSizesBuffers) {
+    KemBufferPool pool(params);
+    ColorCiphertext ciphertext = ColorCiphertext::acquire(pool);
+    EXPECT_EQ(ciphertext.ciphertext_data.size() + ciphertext.shared_secret_hint.size(),
+              ColorCiphertext::serialized_size(params));
+    EXPECT_EQ(ciphertext.params.fingerprint(), params.fingerprint());
+
+    std::array<uint8_t, 32> m{};
+    KemWorkspace workspace;
+    ExpandedPublicKey expanded = kem->expand_public_key(keys.first);
+    ColorValue secret = kem->encapsulate_into(expanded, m, ciphertext, workspace);
+    EXPECT_EQ(kem->decapsulate(keys.first, keys.second, ciphertext), secret);
+
+    ColorPublicKey key = ColorPublicKey::acquire(pool);
+    EXPECT_EQ(key.public_data.size() + ColorPublicKey::seed_bytes(params), ColorPublicKey::serialized_size(params));
+    std::vector<uint8_t> wire = keys.first.serialize();
+    ASSERT_EQ(ColorPublicKey::try_deserialize(wire.data(), wire.size(), params, key), CLWEError::SUCCESS);
+    EXPECT_EQ(key.serialize(), wire);
+}
+
+// Test that destroyed objects return their buffers and the next acquire reuses them
+TEST_F(BufferPoolTest, RecyclesBuffers) {
+    KemBufferPool pool(params);
+    const uint8_t* data = nullptr;
+    const uint8_t* public_data = nullptr;
+    {
+        ColorCiphertext ciphertext = ColorCiphertext::acquire(pool);
+        ColorPublicKey key = ColorPublicKey::acquire(pool);
+        data = ciphertext.ciphertext_data.data();
+        public_data = key.public_data.data();
+    }
+    KemBufferPoolStats stats = pool.stats();
+    EXPECT_EQ(stats.acquired, 2u);
+    EXPECT_EQ(stats.reused, 0u);
+    EXPECT_EQ(stats.returned, 2u);
+
+    ColorCiphertext ciphertext = ColorCiphertext::acquire(pool);
+    ColorPublicKey key = ColorPublicKey::acquire(pool);
+    EXPECT_EQ(ciphertext.ciphertext_data.data(), data);
+    EXPECT_EQ(key.public_data.data(), public_data);
+    EXPECT_EQ(pool.stats().reused, 2u);
+
+    // Moving hands the buffers over; only the final owner returns them
+    ColorCiphertext moved = std::move(ciphertext);
+    EXPECT_EQ(moved.ciphertext_data.data(), data);
+
+    // Unpooled objects are unaffected
+    { ColorCiphertext plain = kem->encapsulate(keys.first).first; }
+    EXPECT_EQ(pool.stats().returned, 2u);
+}
+
+// Test that a warm pool makes encapsulation allocation-free, outputs included
+TEST_F(BufferPoolTest, SteadyStateEncapsulationAllocatesNothing) {
+    KemBufferPool pool(params);
+    KemWorkspace workspace;
+    ExpandedPublicKey expanded = kem->expand_public_key(keys.first);
+    std::array<uint8_t, 32> m{};
+    std::vector<ColorCiphertext> sent;
+    sent.reserve(8);
+    auto round = [&] {
+        for (int i = 0; i < 8; ++i) {
+            ColorCiphertext ciphertext = ColorCiphertext::acquire(pool);
+            m[0] = static_cast<uint8_t>(i);
+            kem->encapsulate_into(expanded, m, ciphertext, workspace);
+            sent.push_back(std::move(ciphertext));
+        }
+        sent.clear();
+    };
+    round();
+
+    ASSERT_TRUE(AllocationTracker::hooks_installed());
+    AllocationTracker tracker;
+    round();
+    round();
+    EXPECT_EQ(tracker.stats().allocations, 0u);
+}
+
+// Test the per-thread cap, cross-thread returns and trim()
+TEST_F(BufferPoolTest, PerThreadFreeLists) {
+    KemBufferPool pool(params, 2);
+    EXPECT_EQ(pool.max_cached_per_thread(), 2u);
+    {
+        std::vector<ColorCiphertext> held;
+        for (int i = 0; i < 3; ++i) {
+            held.push_back(ColorCiphertext::acquire(pool));
+        }
+    }
+    EXPECT_EQ(pool.stats().returned, 2u);
+    EXPECT_EQ(pool.stats().dropped, 1u);
+
+    // A ciphertext destroyed on another thread lands on that thread's list
+    ColorCiphertext traveller = ColorCiphertext::acquire(pool);  // Reuses one of this thread's two
+    std::thread([&] {
+        ColorCiphertext local = std::move(traveller);
+    }).join();
+    EXPECT_EQ(pool.stats().returned, 3u);
+    ColorCiphertext::acquire(pool);
+    ColorCiphertext::acquire(pool);
+    EXPECT_EQ(pool.stats().reused, 3u);
+
+    // trim() empties this thread's list, so the next acquire allocates afresh
+    pool.trim();
+    ColorCiphertext::acquire(pool);
+    EXPECT_EQ(pool.stats().reused, 3u);
+}
+
+// Test that objects may outlive their pool and that bad arguments are rejected
+TEST_F(BufferPoolTest, Lifetime) {
+    ColorCiphertext survivor;
+    {
+        KemBufferPool pool(params);
+        survivor = ColorCiphertext::acquire(pool);
+    }
+    auto encapsulated = kem->encapsulate_key(keys.first);
+    survivor = encapsulated.first;
+    EXPECT_EQ(kem->decapsulate_key(keys.first, keys.second, survivor), encapsulated.second);
+
+    EXPECT_THROW(KemBufferPool(params, 0), std::invalid_argument);
+    CLWEParameters bad = params;
+    bad.degree = 100;
+    EXPECT_THROW(KemBufferPool pool(bad), std::invalid_argument);
+}
+
+} // namespace clwe
@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+#include "clwe/clwe_c.h"
+#include "color_kem.hpp"
+#include "allocation_tracker.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace clwe {
+
+class CApiTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ctx = clwe_ctx_new(768);
+        ASSERT_NE(ctx, nullptr);
+        pk.resize(clwe_public_key_bytes(ctx));
+        sk.resize(clwe_private_key_bytes(ctx));
+        ct.resize(clwe_ciphertext_bytes(ctx));
+        ASSERT_EQ(clwe_keygen(ctx, pk.data(), pk.size(), sk.data(), sk.size()), CLWE_OK);
+    }
+
+    void TearDown() override {
+        clwe_ctx_free(ctx);
+    }
+
+    clwe_ctx* ctx = nullptr;
+    std::vector<uint8_t> pk, sk, ct;
+};
+
+// Test that sizes match the C++ serialized forms and unsupported levels give no context
+TEST_F(CApiTest, ContextAndSizes) {
+    CLWEParameters params(768);
+    EXPECT_EQ(clwe_public_key_bytes(ctx), ColorPublicKey::serialized_size(params));
+    EXPECT_EQ(clwe_private_key_bytes(ctx), ColorExpandedPrivateKey::serialized_size(params));
+    EXPECT_EQ(clwe_ciphertext_bytes(ctx), ColorCiphertext::serialized_size(params));
+    EXPECT_EQ(clwe_ctx_new(777), nullptr);
+    EXPECT_EQ(clwe_public_key_bytes(nullptr), 0u);
+    clwe_ctx_free(nullptr);
+    EXPECT_STREQ(clwe_status_string(CLWE_ERROR_BUFFER_TOO_SMALL), "output buffer too small");
+}
+
+// Test that C encapsulation and decapsulation agree with each other and with the C++ API
+TEST_F(CApiTest, RoundTripMatchesCppApi) {
+    uint8_t ss[CLWE_SHARED_SECRET_BYTES];
+    uint8_t recovered[CLWE_SHARED_SECRET_BYTES];
+    ASSERT_EQ(clwe_encapsulate(ctx, pk.data(), pk.size(), ct.data(), ct.size(), ss), CLWE_OK);
+    ASSERT_EQ(clwe_decapsulate(ctx, sk.data(), sk.size(), ct.data(), ct.size(), recovered), CLWE_OK);
+    EXPECT_EQ(std::memcmp(ss, recovered, sizeof(ss)), 0);
+
+    CLWEParameters params(768);
+    ColorKEM kem(params);
+    ColorExpandedPrivateKey private_key = ColorExpandedPrivateKey::deserialize(sk.data(), sk.size(), params);
+    ColorCiphertext ciphertext = ColorCiphertext::deserialize(ct.data(), ct.size(), params);
+    SharedSecret shared_key = kem.decapsulate_key(private_key, ciphertext);
+    EXPECT_EQ(std::memcmp(shared_key.data(), ss, sizeof(ss)), 0);
+
+    // The C++ encapsulation of the same public key decapsulates through the C API
+    auto [cpp_ciphertext, cpp_key] = kem.encapsulate_key(ColorPublicKey::deserialize(pk.data(), pk.size(), params));
+    std::vector<uint8_t> cpp_bytes = cpp_ciphertext.serialize();
+    ASSERT_EQ(clwe_decapsulate(ctx, sk.data(), sk.size(), cpp_bytes.data(), cpp_bytes.size(), recovered), CLWE_OK);
+    EXPECT_EQ(std::memcmp(cpp_key.data(), recovered, sizeof(recovered)), 0);
+
+    // A tampered ciphertext still succeeds, with the implicit rejection secret
+    ct[5] ^= 1;
+    ASSERT_EQ(clwe_decapsulate(ctx, sk.data(), sk.size(), ct.data(), ct.size(), recovered), CLWE_OK);
+    EXPECT_NE(std::memcmp(ss, recovered, sizeof(ss)), 0);
+}
+
+// Test that a batch writes every ciphertext at its stride and each one decapsulates
+TEST_F(CApiTest, BatchEncapsulation) {
+    const size_t count = 3;
+    std::vector<uint8_t> pks, sks;
+    for (size_t i = 0; i < count; ++i) {
+        std::vector<uint8_t> key_pk(pk.size()), key_sk(sk.size());
+        ASSERT_EQ(clwe_keygen(ctx, key_pk.data(), key_pk.size(), key_sk.data(), key_sk.size()), CLWE_OK);
+        pks.insert(pks.end(), key_pk.begin(), key_pk.end());
+        sks.insert(sks.end(), key_sk.begin(), key_sk.end());
+    }
+    const size_t stride = ct.size() + 16;
+    std::vector<uint8_t> cts(count * stride);
+    std::vector<uint8_t> ss(count * CLWE_SHARED_SECRET_BYTES);
+    ASSERT_EQ(clwe_encapsulate_batch(ctx, count, pks.data(), pk.size(), cts.data(), stride, ss.data()), CLWE_OK);
+
+    for (size_t i = 0; i < count; ++i) {
+        uint8_t recovered[CLWE_SHARED_SECRET_BYTES];
+        ASSERT_EQ(clwe_decapsulate(ctx, sks.data() + i * sk.size(), sk.size(), cts.data() + i * stride, ct.size(),
+                                   recovered),
+                  CLWE_OK);
+        EXPECT_EQ(std::memcmp(recovered, ss.data() + i * CLWE_SHARED_SECRET_BYTES, sizeof(recovered)), 0);
+    }
+    EXPECT_EQ(clwe_encapsulate_batch(ctx, 0, nullptr, 0, nullptr, 0, ss.data()), CLWE_OK);
+}
+
+// Test that bad arguments come back as status codes and zeroed secrets
+TEST_F(CApiTest, ErrorStatuses) {
+    uint8_t ss[CLWE_SHARED_SECRET_BYTES];
+    std::memset(ss, 0xAA, sizeof(ss));
+    const uint8_t zero[CLWE_SHARED_SECRET_BYTES] = {};
+
+    EXPECT_EQ(clwe_encapsulate(ctx, pk.data(), pk.size(), ct.data(), ct.size() - 1, ss), CLWE_ERROR_BUFFER_TOO_SMALL);
+    EXPECT_EQ(std::memcmp(ss, zero, sizeof(ss)), 0);
+    EXPECT_EQ(clwe_encapsulate(ctx, pk.data(), pk.size() - 1, ct.data(), ct.size(), ss), CLWE_ERROR_INVALID_ARGUMENT);
+    EXPECT_EQ(clwe_encapsulate(nullptr, pk.data(), pk.size(), ct.data(), ct.size(), ss), CLWE_ERROR_INVALID_ARGUMENT);
+    EXPECT_EQ(clwe_keygen(ctx, pk.data(), pk.size(), sk.data(), sk.size() - 1), CLWE_ERROR_BUFFER_TOO_SMALL);
+    EXPECT_EQ(clwe_decapsulate(ctx, sk.data(), sk.size(), ct.data(), ct.size() + 1, ss), CLWE_ERROR_INVALID_ARGUMENT);
+
+    // An unreduced t_hat coefficient is rejected by the key check, not by the caller
+    std::vector<uint8_t> bad_pk = pk;
+    std::memset(bad_pk.data() + 32, 0xFF, 4);
+    EXPECT_EQ(clwe_encapsulate(ctx, bad_pk.data(), bad_pk.size(), ct.data(), ct.size(), ss),
+              CLWE_ERROR_INVALID_ARGUMENT);
+
+    // So is a private key whose public key hash does not match
+    std::vector<uint8_t> bad_sk = sk;
+    bad_sk.back() ^= 1;
+    EXPECT_EQ(clwe_decapsulate(ctx, bad_sk.data(), bad_sk.size(), ct.data(), ct.size(), ss),
+              CLWE_ERROR_INVALID_ARGUMENT);
+    EXPECT_EQ(std::memcmp(ss, zero, sizeof(ss)), 0);
+
+    // A rejected batch zeroes every secret, not only the first
+    std::vector<uint8_t> batch_ss(3 * CLWE_SHARED_SECRET_BYTES, 0xAA);
+    std::vector<uint8_t> batch_zero(batch_ss.size(), 0);
+    EXPECT_EQ(clwe_encapsulate_batch(ctx, 3, pk.data(), pk.size() - 1, ct.data(), ct.size(), batch_ss.data()),
+              CLWE_ERROR_INVALID_ARGUMENT);
+    EXPECT_EQ(batch_ss, batch_zero);
+    std::fill(batch_ss.begin(), batch_ss.end(), 0xAA);
+    EXPECT_EQ(clwe_encapsulate_batch(ctx, 3, nullptr, pk.size(), ct.data(), ct.size(), batch_ss.data()),
+              CLWE_ERROR_INVALID_ARGUMENT);
+    EXPECT_EQ(batch_ss, batch_zero);
+    EXPECT_EQ(clwe_encapsulate_batch(ctx, SIZE_MAX, pk.data(), pk.size(), ct.data(), ct.size(), batch_ss.data()),
+              CLWE_ERROR_INVALID_ARGUMENT);
+}
+
+// Test that warm calls allocate nothing on either side of the boundary
+TEST_F(CApiTest, WarmCallsAllocateNothing) {
+    ASSERT_TRUE(AllocationTracker::hooks_installed());
+    uint8_t ss[CLWE_SHARED_SECRET_BYTES];
+    uint8_t recovered[CLWE_SHARED_SECRET_BYTES];
+    ASSERT_EQ(clwe_encapsulate(ctx, pk.data(), pk.size(), ct.data(), ct.size(), ss), CLWE_OK);
+    ASSERT_EQ(clwe_decapsulate(ctx, sk.data(), sk.size(), ct.data(), ct.size(), recovered), CLWE_OK);
+
+    AllocationTracker tracker;
+    ASSERT_EQ(clwe_encapsulate(ctx, pk.data(), pk.size(), ct.data(), ct.size(), ss), CLWE_OK);
+    ASSERT_EQ(clwe_decapsulate(ctx, sk.data(), sk.size(), ct.data(), ct.size(), recovered), CLWE_OK);
+    EXPECT_EQ(tracker.stats().allocations, 0u);
+    EXPECT_EQ(std::memcmp(ss, recovered, sizeof(ss)), 0);
+}
+
+} // namespace clwe
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include "clwe.hpp"
 #include <stdexcept>
+#include <vector>
 
 namespace clwe {
 
@@ -98,6 +99,16 @@ TEST_F(CLWEParametersTest, InvalidEtaValues) {
     EXPECT_THROW(CLWEParameters(512, 256, 2, 3329, 17, 2), std::invalid_argument);
     EXPECT_THROW(CLWEParameters(512, 256, 2, 3329, 3, 0), std::invalid_argument);
     EXPECT_THROW(CLWEParameters(512, 256, 2, 3329, 3, 17), std::invalid_argument);
+
+    // The AES noise PRF only feeds the eta 2 and 3 block sampler
+    CLWEParameters aes(512, 256, 2, 3329, 4, 2);
+    EXPECT_NO_THROW(aes.validate());
+    aes.xof = XofAlgorithm::AES256_CTR;
+    EXPECT_THROW(aes.validate(), std::invalid_argument);
+    aes.eta1 = 3;
+    EXPECT_NO_THROW(aes.validate());
+    aes.degree = 32;
+    EXPECT_THROW(aes.validate(), std::invalid_argument);
 }
 
 // Test prime checking helper
@@ -170,4 +181,145 @@ TEST_F(CLWEParametersTest, CopyBehavior) {
     EXPECT_EQ(copy.eta2, original.eta2);
 }
 
+// Test that the fingerprint separates every format-relevant field
+TEST_F(CLWEParametersTest, Fingerprint) {
+    CLWEParameters base(512);
+    EXPECT_EQ(base.fingerprint(), CLWEParameters(512).fingerprint());
+    EXPECT_NE(base.fingerprint(), CLWEParameters::INVALID_FINGERPRINT);
+    EXPECT_NE(base.fingerprint(), CLWEParameters(768).fingerprint());
+    EXPECT_NE(CLWEParameters(768).fingerprint(), CLWEParameters(1024).fingerprint());
+
+    // The noise parameters do not change any format
+    CLWEParameters noise = base;
+    noise.eta1 = 2;
+    EXPECT_EQ(noise.fingerprint(), base.fingerprint());
+
+    std::vector<CLWEParameters> variants(10, base);
+    variants[0].degree = 128;
+    variants[1].modulus = 7681;
+    variants[2].module_rank = 3;
+    variants[3].du = 10;
+    variants[4].dv = 4;
+    variants[5].encoding = CoefficientEncoding::PACKED12;
+    variants[6].sparse_c2 = true;
+    variants[7].xof = XofAlgorithm::AES256_CTR;
+    variants[8].shared_matrix = true;
+    variants[9].t_dropped_bits = 2;
+    for (size_t i = 0; i < variants.size(); ++i) {
+        EXPECT_NE(variants[i].fingerprint(), base.fingerprint()) << "variant " << i;
+        for (size_t j = i + 1; j < variants.size(); ++j) {
+            EXPECT_NE(variants[i].fingerprint(), variants[j].fingerprint()) << "variants " << i << ", " << j;
+        }
+    }
+
+    // Fields too wide for their slot cannot alias a valid set
+    CLWEParameters wide = base;
+    wide.modulus = 3329 + (1u << 17);
+    EXPECT_EQ(wide.fingerprint(), CLWEParameters::INVALID_FINGERPRINT);
+    wide = base;
+    wide.du = 16;
+    EXPECT_EQ(wide.fingerprint(), CLWEParameters::INVALID_FINGERPRINT);
+    wide = base;
+    wide.module_rank = 32;
+    EXPECT_EQ(wide.fingerprint(), CLWEParameters::INVALID_FINGERPRINT);
+    wide = base;
+    wide.security_level = 0x8000 | 512;
+    EXPECT_EQ(wide.fingerprint(), CLWEParameters::INVALID_FINGERPRINT);
+    wide = base;
+    wide.t_dropped_bits = 8;
+    EXPECT_EQ(wide.fingerprint(), CLWEParameters::INVALID_FINGERPRINT);
+    EXPECT_THROW(wide.validate(), std::invalid_argument);
+
+    // secret_weight is checked by validate() but does not change the fingerprint
+    CLWEParameters weighted = base;
+    weighted.secret_weight = 64;
+    EXPECT_NO_THROW(weighted.validate());
+    EXPECT_EQ(weighted.fingerprint(), base.fingerprint());
+    weighted.secret_weight = base.degree + 1;
+    EXPECT_THROW(weighted.validate(), std::invalid_argument);
+}
+
+// Test the rounded t width and that the failure estimate tracks each error source
+TEST_F(CLWEParametersTest, DecapsulationFailureEstimate) {
+    EXPECT_EQ(params512.rounded_t_bits(), 0u);
+    const uint32_t expected_bits[] = {12, 11, 10, 9, 8, 7, 6, 5};
+    for (uint32_t d = 1; d <= 7; ++d) {
+        CLWEParameters rounded = params768;
+        rounded.t_dropped_bits = d;
+        EXPECT_EQ(rounded.rounded_t_bits(), expected_bits[d]) << "d=" << d;
+    }
+
+    for (const CLWEParameters& base : {params512, params768, params1024}) {
+        double previous = decapsulation_failure_log2(base);
+        EXPECT_LT(previous, -200.0) << base.security_level;
+        for (uint32_t d = 1; d <= 4; ++d) {
+            CLWEParameters rounded = base;
+            rounded.t_dropped_bits = d;
+            double estimate = decapsulation_failure_log2(rounded);
+            EXPECT_GT(estimate, previous) << base.security_level << " d=" << d;
+            EXPECT_LE(estimate, 0.0);
+            if (d <= 3) {
+                EXPECT_LT(estimate, -50.0) << base.security_level << " d=" << d;
+            }
+            previous = estimate;
+        }
+    }
+
+    // Compression adds error; a sparse c2 decodes one coefficient instead of 256
+    CLWEParameters compressed = params512;
+    compressed.du = 10;
+    compressed.dv = 4;
+    EXPECT_GT(decapsulation_failure_log2(compressed), decapsulation_failure_log2(params512));
+    CLWEParameters sparse = params512;
+    sparse.sparse_c2 = true;
+    EXPECT_NEAR(decapsulation_failure_log2(sparse), decapsulation_failure_log2(params512) - 8.0, 1e-6);
+
+    // A fixed-weight secret has variance h / n, below the binomial eta1 / 2 at every weight
+    double previous = -1e9;
+    for (uint32_t weight : {32u, 64u, 128u, 256u}) {
+        CLWEParameters ternary = params512;
+        ternary.secret_weight = weight;
+        double estimate = decapsulation_failure_log2(ternary);
+        EXPECT_GT(estimate, previous) << weight;
+        EXPECT_LT(estimate, decapsulation_failure_log2(params512)) << weight;
+        previous = estimate;
+    }
+
+    // Half the field dropped: failure is certain
+    CLWEParameters coarse = params1024;
+    coarse.t_dropped_bits = 7;
+    EXPECT_EQ(decapsulation_failure_log2(coarse), 0.0);
+}
+
+
+TEST_F(CLWEParametersTest, BarrettReducerMatchesModulo) {
+    for (uint32_t q : {257u, 3329u, 7681u, 65521u, 65537u}) {
+        CLWEParameters params(512);
+        params.modulus = q;
+        BarrettReducer reducer = params.reducer();
+        EXPECT_EQ(reducer.modulus, q);
+
+        // Edges of the 32-bit range plus a multiplicative walk through the middle
+        std::vector<uint32_t> inputs = {0, 1, q - 1, q, q + 1, 2 * q - 1, 0xFFFFFFFFu, 0xFFFFFFFFu - q};
+        uint32_t x = 12345;
+        for (int i = 0; i < 10000; ++i) {
+            x = x * 1664525u + 1013904223u;
+            inputs.push_back(x);
+        }
+        for (uint32_t v : inputs) {
+            ASSERT_EQ(reducer.reduce(v), v % q) << "q=" << q << " x=" << v;
+        }
+
+        for (uint32_t a = 0; a < q; a += q / 97 + 1) {
+            for (uint32_t b = 0; b < q; b += q / 89 + 1) {
+                ASSERT_EQ(reducer.add(a, b), (a + b) % q);
+                ASSERT_EQ(reducer.sub(a, b), (a + q - b) % q);
+                if (q <= 65536) {
+                    ASSERT_EQ(reducer.mul(a, b), static_cast<uint32_t>(static_cast<uint64_t>(a) * b % q));
+                }
+            }
+        }
+    }
+}
+
 } // namespace clwe
\ No newline at end of file
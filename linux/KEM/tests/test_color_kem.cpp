@@ -1,8 +1,21 @@
 #include <gtest/gtest.h>
 #include "color_kem.hpp"
 #include "clwe.hpp"
+#include "clwe/color_kem_level.hpp"
+#include "allocation_tracker.hpp"
+#include "ntt_engine.hpp"
+#include "performance_metrics.hpp"
 #include <vector>
 #include <array>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <type_traits>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
 
 namespace clwe {
 
@@ -37,6 +50,34 @@ TEST_F(ColorKEMTest, KeyGeneration) {
     EXPECT_FALSE(private_key.secret_data.empty());
 }
 
+// Every seed comes from the injected source, so a deterministic one reproduces whole runs
+TEST_F(ColorKEMTest, InjectedRandomSource) {
+    EXPECT_EQ(kem->random_source(), default_random_source());
+
+    std::array<uint8_t, 32> seed{};
+    seed[31] = 0x5A;
+    ColorKEM first(params), second(params);
+    first.set_random_source(std::make_shared<DeterministicRandomSource>(seed));
+    second.set_random_source(std::make_shared<DeterministicRandomSource>(seed));
+
+    auto [pk1, sk1] = first.keygen();
+    auto [pk2, sk2] = second.keygen();
+    EXPECT_EQ(pk1.serialize(), pk2.serialize());
+    EXPECT_EQ(sk1.serialize(), sk2.serialize());
+    auto [ct1, ss1] = first.encapsulate(pk1);
+    auto [ct2, ss2] = second.encapsulate(pk2);
+    EXPECT_EQ(ct1.serialize(), ct2.serialize());
+    EXPECT_EQ(ss1, ss2);
+    EXPECT_EQ(first.decapsulate(pk1, sk1, ct1), ss1);
+    EXPECT_EQ(first.keygen_batch(2)[1].first.serialize(), second.keygen_batch(2)[1].first.serialize());
+
+    // The stream advances: the next key differs from the first
+    EXPECT_NE(first.keygen().first.serialize(), pk1.serialize());
+
+    first.set_random_source(nullptr);
+    EXPECT_EQ(first.random_source(), default_random_source());
+}
+
 // Test key verification
 TEST_F(ColorKEMTest, KeyVerification) {
     auto [public_key, private_key] = kem->keygen();
@@ -215,6 +256,48 @@ TEST_F(ColorKEMTest, DecapsulationInvalidCiphertext) {
     EXPECT_THROW(kem->decapsulate(public_key, private_key, invalid_ciphertext), std::exception);
 }
 
+// Test the FIPS 203 modulus check on public keys, and its counterpart on uncompressed ciphertexts
+TEST_F(ColorKEMTest, RejectsUnreducedCoefficients) {
+    auto [public_key, private_key] = kem->keygen();
+    auto [ciphertext, secret] = kem->encapsulate(public_key);
+
+    // COLOR32 coefficient 100 of t_hat set to q
+    ColorPublicKey unreduced = public_key;
+    const uint32_t q = params.modulus;
+    uint8_t* word = unreduced.public_data.data() + 4 * 100;
+    word[0] = static_cast<uint8_t>(q >> 24);
+    word[1] = static_cast<uint8_t>(q >> 16);
+    word[2] = static_cast<uint8_t>(q >> 8);
+    word[3] = static_cast<uint8_t>(q);
+    EXPECT_THROW(kem->encapsulate(unreduced), std::invalid_argument);
+    EXPECT_THROW(kem->expand_public_key(unreduced), std::invalid_argument);
+    EXPECT_THROW(kem->encapsulate(ColorPublicKeyView(unreduced)), std::invalid_argument);
+
+    // The check is recorded on an expanded key, and a hand-built one is checked on use
+    ExpandedPublicKey expanded = kem->expand_public_key(public_key);
+    EXPECT_TRUE(expanded.coefficients_reduced);
+    ExpandedPublicKey hand_built = expanded;
+    hand_built.coefficients_reduced = false;
+    EXPECT_NO_THROW(kem->encapsulate(hand_built));
+    PolyVec colors = *expanded.public_key_colors;
+    colors[1][7] = ColorValue::from_math_value(q + 5);
+    hand_built.public_key_colors = std::make_shared<const PolyVec>(colors);
+    EXPECT_THROW(kem->encapsulate(hand_built), std::invalid_argument);
+
+    // An unreduced ciphertext coefficient is rejected implicitly, even with a matching hint
+    ColorCiphertext bad_ciphertext = ciphertext;
+    uint8_t* c = bad_ciphertext.ciphertext_data.data();
+    uint32_t value = ((uint32_t(c[0]) << 24) | (uint32_t(c[1]) << 16) | (uint32_t(c[2]) << 8) | c[3]) + q;
+    c[0] = static_cast<uint8_t>(value >> 24);
+    c[1] = static_cast<uint8_t>(value >> 16);
+    c[2] = static_cast<uint8_t>(value >> 8);
+    c[3] = static_cast<uint8_t>(value);
+    ColorValue rejected = kem->decapsulate(public_key, private_key, bad_ciphertext);
+    EXPECT_NE(rejected, secret);
+    EXPECT_EQ(kem->decapsulate(kem->prepare_private_key(private_key), bad_ciphertext), rejected);
+    EXPECT_EQ(kem->decapsulate(public_key, private_key, ciphertext), secret);
+}
+
 // Test shared secret properties
 TEST_F(ColorKEMTest, SharedSecretProperties) {
     auto [public_key, private_key] = kem->keygen();
@@ -258,7 +341,1114 @@ TEST_F(ColorKEMTest, DifferentKeysDifferentCiphertexts) {
 
     // Ciphertexts should be different (with very high probability)
     EXPECT_NE(ciphertext1.ciphertext_data, ciphertext2.ciphertext_data);
-    EXPECT_EQ(ciphertext1.shared_secret_hint, ciphertext2.shared_secret_hint);
+    EXPECT_EQ(ciphertext1.shared_secret_hint.size(), ciphertext2.shared_secret_hint.size());
+}
+
+// Test batch operations round-trip and reuse of repeated keys
+TEST_F(ColorKEMTest, BatchRoundTrip) {
+    auto keys = kem->keygen_batch(2);
+    ASSERT_EQ(keys.size(), 2u);
+    EXPECT_NE(keys[0].first.public_data, keys[1].first.public_data);
+
+    // Repeat the first key so the batch exercises the expanded-key path
+    std::vector<ColorPublicKey> public_keys = {keys[0].first, keys[0].first, keys[1].first};
+    std::vector<ColorPrivateKey> private_keys = {keys[0].second, keys[0].second, keys[1].second};
+
+    auto encapsulated = kem->encapsulate_batch(public_keys);
+    ASSERT_EQ(encapsulated.size(), public_keys.size());
+
+    std::vector<ColorCiphertext> ciphertexts;
+    for (const auto& entry : encapsulated) {
+        ciphertexts.push_back(entry.first);
+    }
+
+    auto recovered = kem->decapsulate_batch(public_keys, private_keys, ciphertexts);
+    ASSERT_EQ(recovered.size(), ciphertexts.size());
+    for (size_t i = 0; i < recovered.size(); ++i) {
+        EXPECT_EQ(recovered[i], encapsulated[i].second);
+        EXPECT_EQ(recovered[i], kem->decapsulate(public_keys[i], private_keys[i], ciphertexts[i]));
+    }
+
+    // Mismatched lengths are rejected
+    ciphertexts.pop_back();
+    EXPECT_THROW(kem->decapsulate_batch(public_keys, private_keys, ciphertexts), std::invalid_argument);
+
+    EXPECT_TRUE(kem->keygen_batch(0).empty());
+}
+
+TEST_F(ColorKEMTest, ExpandedPublicKeyCache) {
+    auto [public_key, private_key] = kem->keygen();
+
+    ExpandedPublicKey expanded = kem->expand_public_key(public_key);
+    auto [ciphertext, shared_secret] = kem->encapsulate(expanded);
+    EXPECT_EQ(kem->decapsulate(public_key, private_key, ciphertext), shared_secret);
+
+    // Repeat encapsulations to one key share a single cache entry
+    EXPECT_EQ(kem->expanded_key_cache_size(), 0u);
+    for (int i = 0; i < 3; ++i) {
+        auto [ct, ss] = kem->encapsulate(public_key);
+        EXPECT_EQ(kem->decapsulate(public_key, private_key, ct), ss);
+    }
+    EXPECT_EQ(kem->expanded_key_cache_size(), 1u);
+
+    // The cache stays bounded and can be disabled
+    kem->set_expanded_key_cache_capacity(1);
+    auto [other_public, other_private] = kem->keygen();
+    kem->encapsulate(other_public);
+    EXPECT_EQ(kem->expanded_key_cache_size(), 1u);
+    kem->set_expanded_key_cache_capacity(0);
+    EXPECT_EQ(kem->expanded_key_cache_size(), 0u);
+    auto [ct, ss] = kem->encapsulate(other_public);
+    EXPECT_EQ(kem->decapsulate(other_public, other_private, ct), ss);
+    EXPECT_EQ(kem->expanded_key_cache_size(), 0u);
+
+    // Keys expanded for other parameters are rejected
+    ColorKEM other_kem(CLWEParameters(768));
+    ExpandedPublicKey foreign = other_kem.expand_public_key(other_kem.keygen().first);
+    EXPECT_THROW(kem->encapsulate(foreign), std::invalid_argument);
+}
+
+TEST_F(ColorKEMTest, PreparedPrivateKeyDecapsulation) {
+    auto [public_key, private_key] = kem->keygen();
+    PreparedPrivateKey prepared = kem->prepare_private_key(private_key);
+
+    for (int i = 0; i < 3; ++i) {
+        auto [ciphertext, shared_secret] = kem->encapsulate(public_key);
+        EXPECT_EQ(kem->decapsulate(prepared, ciphertext), shared_secret);
+    }
+
+    // Rejection matches the unprepared path
+    auto [ciphertext, shared_secret] = kem->encapsulate(public_key);
+    ciphertext.ciphertext_data[0] ^= 0x01;
+    EXPECT_EQ(kem->decapsulate(prepared, ciphertext), kem->decapsulate(public_key, private_key, ciphertext));
+
+    ColorCiphertext truncated = ciphertext;
+    truncated.ciphertext_data.pop_back();
+    EXPECT_THROW(kem->decapsulate(prepared, truncated), std::invalid_argument);
+
+    ColorPrivateKey short_key = private_key;
+    short_key.secret_data.pop_back();
+    EXPECT_THROW(kem->prepare_private_key(short_key), std::invalid_argument);
+
+    EXPECT_THROW(kem->decapsulate(PreparedPrivateKey{}, ciphertext), std::invalid_argument);
+}
+
+TEST_F(ColorKEMTest, ExpandedPrivateKeyDecapsulation) {
+    auto [public_key, private_key] = kem->keygen();
+    ColorExpandedPrivateKey expanded = kem->expand_private_key(public_key, private_key);
+    EXPECT_EQ(expanded.secret_data, private_key.secret_data);
+    EXPECT_EQ(expanded.public_key.public_data, public_key.public_data);
+
+    auto [ciphertext, shared_secret] = kem->encapsulate(public_key);
+    EXPECT_EQ(kem->decapsulate(expanded, ciphertext), shared_secret);
+    ColorCiphertext tampered = ciphertext;
+    tampered.ciphertext_data[0] ^= 0x01;
+    EXPECT_EQ(kem->decapsulate(expanded, tampered), kem->decapsulate(public_key, private_key, tampered));
+
+    auto [key_ciphertext, key] = kem->encapsulate_key(public_key);
+    EXPECT_EQ(kem->decapsulate_key(expanded, key_ciphertext), key);
+    EXPECT_EQ(kem->decapsulate_key(expanded, tampered), kem->decapsulate_key(public_key, private_key, tampered));
+
+    // Round trip through the wire format: secret data, public key, H(pk)
+    std::vector<uint8_t> bytes = expanded.serialize();
+    ASSERT_EQ(bytes.size(), ColorExpandedPrivateKey::serialized_size(params));
+    EXPECT_EQ(bytes.size(), ColorPrivateKey::serialized_size(params) + ColorPublicKey::serialized_size(params) + 32);
+    ColorExpandedPrivateKey parsed = ColorExpandedPrivateKey::deserialize(bytes, params);
+    EXPECT_EQ(parsed.public_key_hash, expanded.public_key_hash);
+    EXPECT_EQ(kem->decapsulate(parsed, ciphertext), shared_secret);
+
+    // A public key that does not match the embedded hash fails the hash check
+    std::vector<uint8_t> corrupted = bytes;
+    corrupted[ColorPrivateKey::serialized_size(params) + 32] ^= 0x01;
+    EXPECT_THROW(ColorExpandedPrivateKey::deserialize(corrupted, params), std::invalid_argument);
+    bytes.pop_back();
+    EXPECT_THROW(ColorExpandedPrivateKey::deserialize(bytes, params), std::invalid_argument);
+
+    ColorExpandedPrivateKey short_key = expanded;
+    short_key.secret_data.pop_back();
+    EXPECT_THROW(kem->decapsulate(short_key, ciphertext), std::invalid_argument);
+    EXPECT_THROW(kem->decapsulate(ColorExpandedPrivateKey{}, ciphertext), std::invalid_argument);
+
+    ColorKEM other(CLWEParameters(768));
+    EXPECT_THROW(other.expand_private_key(public_key, private_key), std::invalid_argument);
+    EXPECT_THROW(other.decapsulate(expanded, ciphertext), std::invalid_argument);
+}
+
+TEST_F(ColorKEMTest, WorkspaceOverloadsMatchDefaults) {
+    KemWorkspace workspace;
+    std::array<uint8_t, 32> d{};
+    std::array<uint8_t, 32> m{};
+    d[0] = 0x29;
+    m[0] = 0x92;
+
+    auto keys = kem->keygen_derand(d);
+    auto ws_keys = kem->keygen_derand(d, workspace);
+    EXPECT_EQ(ws_keys.first.public_data, keys.first.public_data);
+    EXPECT_EQ(ws_keys.second.secret_data, keys.second.secret_data);
+
+    auto encapsulated = kem->encapsulate_derand(keys.first, m);
+    auto ws_encapsulated = kem->encapsulate_derand(keys.first, m, workspace);
+    EXPECT_EQ(ws_encapsulated.first.ciphertext_data, encapsulated.first.ciphertext_data);
+    EXPECT_EQ(ws_encapsulated.second, encapsulated.second);
+
+    // Reused output ciphertext and workspace, as a worker would run them
+    ExpandedPublicKey expanded = kem->expand_public_key(keys.first);
+    PreparedPrivateKey prepared = kem->prepare_private_key(keys.second);
+    ColorCiphertext ciphertext;
+    for (int i = 0; i < 3; ++i) {
+        m[1] = static_cast<uint8_t>(i);
+        ColorValue secret = kem->encapsulate_into(expanded, m, ciphertext, workspace);
+        auto expected = kem->encapsulate_derand(keys.first, m);
+        EXPECT_EQ(ciphertext.ciphertext_data, expected.first.ciphertext_data);
+        EXPECT_EQ(ciphertext.shared_secret_hint, expected.first.shared_secret_hint);
+        EXPECT_EQ(secret, expected.second);
+
+        EXPECT_EQ(kem->decapsulate(prepared, ciphertext, workspace), secret);
+        EXPECT_EQ(kem->decapsulate(prepared, ColorCiphertextView(ciphertext), workspace), secret);
+        EXPECT_EQ(kem->decapsulate(keys.first, keys.second, ciphertext, workspace), secret);
+    }
+
+    ciphertext.ciphertext_data[0] ^= 0x01;
+    EXPECT_EQ(kem->decapsulate(prepared, ciphertext, workspace), kem->decapsulate(prepared, ciphertext));
+
+    // One workspace serves instances of other parameter sets, and survives being moved from
+    ColorKEM kem1024(CLWEParameters(1024));
+    auto keys1024 = kem1024.keygen(workspace);
+    auto encapsulated1024 = kem1024.encapsulate(keys1024.first, workspace);
+    EXPECT_EQ(kem1024.decapsulate(keys1024.first, keys1024.second, encapsulated1024.first, workspace),
+              encapsulated1024.second);
+
+    KemWorkspace moved = std::move(workspace);
+    EXPECT_EQ(kem->decapsulate(prepared, encapsulated.first, moved), encapsulated.second);
+    EXPECT_EQ(kem->decapsulate(prepared, encapsulated.first, workspace), encapsulated.second);
+
+    ExpandedPublicKey foreign = kem1024.expand_public_key(keys1024.first);
+    EXPECT_THROW(kem->encapsulate_into(foreign, m, ciphertext, workspace), std::invalid_argument);
+
+    // A failed operation releases the workspace for the next one
+    ColorCiphertext truncated = encapsulated.first;
+    truncated.ciphertext_data.pop_back();
+    EXPECT_THROW(kem->decapsulate(prepared, truncated, workspace), std::invalid_argument);
+    EXPECT_EQ(kem1024.decapsulate(keys1024.first, keys1024.second, encapsulated1024.first, workspace),
+              encapsulated1024.second);
+}
+
+// Steady-state heap allocations per operation, once the workspace and key cache are warm
+TEST_F(ColorKEMTest, AllocationBudget) {
+    KemWorkspace workspace;
+    auto keys = kem->keygen(workspace);
+    auto encapsulated = kem->encapsulate(keys.first, workspace);
+    ExpandedPublicKey expanded = kem->expand_public_key(keys.first);
+    PreparedPrivateKey prepared = kem->prepare_private_key(keys.second);
+    ColorCiphertext ciphertext;
+    std::array<uint8_t, 32> m{};
+    kem->encapsulate_into(expanded, m, ciphertext, workspace);
+
+    ASSERT_TRUE(AllocationTracker::hooks_installed());
+    auto count = [](const std::function<void()>& operation) {
+        AllocationTracker tracker;
+        operation();
+        return tracker.stats().allocations;
+    };
+
+    // Only the returned key and ciphertext bytes are allocated
+    std::pair<ColorPublicKey, ColorPrivateKey> fresh;
+    EXPECT_EQ(count([&] { fresh = kem->keygen(workspace); }), 2u);
+    std::pair<ColorCiphertext, ColorValue> result;
+    EXPECT_EQ(count([&] { result = kem->encapsulate(keys.first, workspace); }), 2u);
+    ColorValue secret;
+    EXPECT_EQ(count([&] { secret = kem->decapsulate(keys.first, keys.second, encapsulated.first, workspace); }), 0u);
+    EXPECT_EQ(secret, encapsulated.second);
+
+    // Expanded / prepared keys with a reused ciphertext never touch the heap
+    EXPECT_EQ(count([&] { kem->encapsulate_into(expanded, m, ciphertext, workspace); }), 0u);
+    EXPECT_EQ(count([&] { secret = kem->decapsulate(prepared, ciphertext, workspace); }), 0u);
+
+    // Implicit rejection takes the same allocation-free path
+    ColorCiphertext tampered = ciphertext;
+    tampered.shared_secret_hint[3] ^= 0x01;
+    EXPECT_EQ(count([&] { secret = kem->decapsulate(prepared, tampered, workspace); }), 0u);
+}
+
+// Test that rejected ciphertexts decapsulate to a deterministic value of the ciphertext
+TEST_F(ColorKEMTest, ImplicitRejection) {
+    auto [public_key, private_key] = kem->keygen();
+    auto [ciphertext, secret] = kem->encapsulate(public_key);
+    ASSERT_EQ(kem->decapsulate(public_key, private_key, ciphertext), secret);
+
+    ColorCiphertext bad_hint = ciphertext;
+    bad_hint.shared_secret_hint[3] ^= 0x01;
+    ColorCiphertext bad_data = ciphertext;
+    bad_data.ciphertext_data[1] ^= 0x40;
+
+    ColorValue rejected_hint = kem->decapsulate(public_key, private_key, bad_hint);
+    ColorValue rejected_data = kem->decapsulate(public_key, private_key, bad_data);
+    EXPECT_EQ(kem->decapsulate(public_key, private_key, bad_hint), rejected_hint);
+    EXPECT_EQ(kem->decapsulate(public_key, private_key, bad_data), rejected_data);
+    EXPECT_NE(rejected_hint, rejected_data);
+    EXPECT_LT(rejected_hint.to_math_value(), params.modulus);
+
+    // The prepared-key path selects the same values
+    PreparedPrivateKey prepared = kem->prepare_private_key(private_key);
+    EXPECT_EQ(kem->decapsulate(prepared, bad_hint), rejected_hint);
+    EXPECT_EQ(kem->decapsulate(prepared, ciphertext), secret);
+}
+
+// Test the 256-bit mode round trip across levels, encodings and ciphertext compression
+TEST_F(ColorKEMTest, KeyEncapsulationRoundTrip) {
+    for (uint32_t level : {512u, 768u, 1024u}) {
+        std::vector<CLWEParameters> variants(3, CLWEParameters(level));
+        variants[1].encoding = CoefficientEncoding::PACKED12;
+        variants[2].du = level == 1024 ? 11 : 10;
+        variants[2].dv = level == 1024 ? 5 : 4;
+        for (const CLWEParameters& variant : variants) {
+            ColorKEM level_kem(variant);
+            auto [public_key, private_key] = level_kem.keygen();
+            for (int i = 0; i < 8; ++i) {
+                auto [ciphertext, key] = level_kem.encapsulate_key(public_key);
+                EXPECT_EQ(ciphertext.ciphertext_data.size(), ColorCiphertext::serialized_size(variant) - 4);
+                EXPECT_EQ(level_kem.decapsulate_key(public_key, private_key, ciphertext), key)
+                    << "level " << level << ", du " << variant.du;
+            }
+        }
+    }
+
+    // Keys differ per encapsulation and follow m deterministically, streaming or not
+    auto [public_key, private_key] = kem->keygen();
+    auto first = kem->encapsulate_key(public_key);
+    auto second = kem->encapsulate_key(public_key);
+    EXPECT_NE(first.second, second.second);
+
+    std::array<uint8_t, 32> m;
+    m.fill(0xA5);
+    auto derand = kem->encapsulate_key_derand(public_key, m);
+    kem->set_matrix_streaming(true);
+    auto streamed = kem->encapsulate_key_derand(public_key, m);
+    EXPECT_EQ(streamed.first.ciphertext_data, derand.first.ciphertext_data);
+    EXPECT_EQ(streamed.second, derand.second);
+    EXPECT_EQ(kem->decapsulate_key(public_key, private_key, derand.first), derand.second);
+
+    // The key depends on every bit of m
+    std::array<uint8_t, 32> flipped = m;
+    flipped[31] ^= 0x80;
+    EXPECT_NE(kem->encapsulate_key_derand(public_key, flipped).second, derand.second);
+
+    // The secret is SHAKE256(m, H(ct)), not m itself, and binds the recipient's key
+    EXPECT_FALSE(std::equal(m.begin(), m.end(), derand.second.bytes.begin()));
+    auto other_key = kem->keygen().first;
+    EXPECT_NE(kem->encapsulate_key_derand(other_key, m).second, derand.second);
+}
+
+// Test that SharedSecret is a fixed-size value type
+TEST_F(ColorKEMTest, SharedSecretValueType) {
+    static_assert(sizeof(SharedSecret) == SharedSecret::BYTES, "SharedSecret carries only its bytes");
+    static_assert(std::is_trivially_copyable<SharedSecret>::value, "SharedSecret copies without allocating");
+
+    SharedSecret a;
+    SharedSecret b;
+    EXPECT_EQ(a, b);
+    b.bytes[31] = 1;
+    EXPECT_NE(a, b);
+    EXPECT_EQ(a.size(), 32u);
+
+    // Decapsulation returns the secret by value and, once warm, never touches the heap
+    auto [public_key, private_key] = kem->keygen();
+    auto [ciphertext, secret] = kem->encapsulate_key(public_key);
+    SharedSecret recovered = kem->decapsulate_key(public_key, private_key, ciphertext);
+    ASSERT_TRUE(AllocationTracker::hooks_installed());
+    {
+        AllocationTracker tracker;
+        recovered = kem->decapsulate_key(public_key, private_key, ciphertext);
+        EXPECT_EQ(tracker.stats().allocations, 0u);
+    }
+    EXPECT_EQ(recovered, secret);
+}
+
+// Test that tampered 256-bit ciphertexts decapsulate to a stable rejection key
+TEST_F(ColorKEMTest, KeyEncapsulationRejection) {
+    auto [public_key, private_key] = kem->keygen();
+    auto [ciphertext, key] = kem->encapsulate_key(public_key);
+
+    ColorCiphertext bad_data = ciphertext;
+    bad_data.ciphertext_data[bad_data.ciphertext_data.size() - 1] ^= 0x01;
+    ColorCiphertext bad_hint = ciphertext;
+    bad_hint.shared_secret_hint[0] = 0x01;
+
+    SharedSecret rejected = kem->decapsulate_key(public_key, private_key, bad_data);
+    EXPECT_NE(rejected, key);
+    EXPECT_EQ(kem->decapsulate_key(public_key, private_key, bad_data), rejected);
+    EXPECT_NE(kem->decapsulate_key(public_key, private_key, bad_hint), key);
+
+    // Another recipient's key pair does not recover the key either
+    auto [other_public, other_private] = kem->keygen();
+    EXPECT_NE(kem->decapsulate_key(other_public, other_private, ciphertext), key);
+
+    // A single-bit c2 cannot carry the message
+    CLWEParameters sparse(512);
+    sparse.sparse_c2 = true;
+    ColorKEM sparse_kem(sparse);
+    auto sparse_keys = sparse_kem.keygen();
+    EXPECT_THROW(sparse_kem.encapsulate_key(sparse_keys.first), std::invalid_argument);
+
+    ColorCiphertext truncated = ciphertext;
+    truncated.ciphertext_data.pop_back();
+    EXPECT_THROW(kem->decapsulate_key(public_key, private_key, truncated), std::invalid_argument);
+}
+
+TEST_F(ColorKEMTest, ExecutorMatchesSerial) {
+    std::atomic<int> dispatches{0};
+    KemExecutor threads = [&](size_t count, const std::function<void(size_t)>& task) {
+        ++dispatches;
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < count; ++i) {
+            workers.emplace_back(task, i);
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    };
+
+    ColorKEM serial(CLWEParameters(1024));
+    ColorKEM parallel(CLWEParameters(1024));
+    parallel.set_executor(threads);
+
+    std::array<uint8_t, 32> d{};
+    std::array<uint8_t, 32> m{};
+    d[0] = 0x31;
+    auto keys = serial.keygen_derand(d);
+    auto parallel_keys = parallel.keygen_derand(d);
+    EXPECT_GT(dispatches.load(), 0);
+    EXPECT_EQ(parallel_keys.first.public_data, keys.first.public_data);
+    EXPECT_EQ(parallel_keys.second.secret_data, keys.second.secret_data);
+
+    auto encapsulated = serial.encapsulate_derand(keys.first, m);
+    auto parallel_encapsulated = parallel.encapsulate_derand(keys.first, m);
+    EXPECT_EQ(parallel_encapsulated.first.ciphertext_data, encapsulated.first.ciphertext_data);
+    EXPECT_EQ(parallel.decapsulate(keys.first, keys.second, encapsulated.first), encapsulated.second);
+
+    // Below the rank threshold the executor is never called
+    dispatches = 0;
+    kem->set_executor(threads);
+    auto small_keys = kem->keygen();
+    auto small = kem->encapsulate(small_keys.first);
+    EXPECT_EQ(kem->decapsulate(small_keys.first, small_keys.second, small.first), small.second);
+    EXPECT_EQ(dispatches.load(), 0);
+
+    kem->set_executor(threads, 2);
+    kem->keygen();
+    EXPECT_GT(dispatches.load(), 0);
+}
+
+// Streaming A gives the same bytes while holding one row of it instead of all k^2 entries
+TEST_F(ColorKEMTest, StreamingMatrixMatchesMaterialized) {
+    std::array<uint8_t, 32> d{};
+    std::array<uint8_t, 32> m{};
+    for (uint32_t level : {512u, 768u, 1024u}) {
+        ColorKEM materialized{CLWEParameters(level)};
+        ColorKEM streamed{CLWEParameters(level)};
+        streamed.set_matrix_streaming(true);
+        EXPECT_TRUE(streamed.matrix_streaming());
+
+        d[0] = static_cast<uint8_t>(level);
+        auto keys = materialized.keygen_derand(d);
+        auto streamed_keys = streamed.keygen_derand(d);
+        EXPECT_EQ(streamed_keys.first.public_data, keys.first.public_data);
+        EXPECT_EQ(streamed_keys.second.secret_data, keys.second.secret_data);
+
+        auto encapsulated = materialized.encapsulate_derand(keys.first, m);
+        auto streamed_encapsulated = streamed.encapsulate_derand(keys.first, m);
+        EXPECT_EQ(streamed_encapsulated.first.ciphertext_data, encapsulated.first.ciphertext_data);
+        EXPECT_EQ(streamed.decapsulate(keys.first, keys.second, streamed_encapsulated.first), encapsulated.second);
+        EXPECT_EQ(streamed.expanded_key_cache_size(), 0u);
+
+        // Cached and view encapsulations both expand A already transposed
+        ColorCiphertext viewed;
+        KemWorkspace view_workspace;
+        EXPECT_EQ(materialized.encapsulate_into(ColorPublicKeyView(keys.first), m, viewed, view_workspace),
+                  encapsulated.second);
+        EXPECT_EQ(viewed.ciphertext_data, encapsulated.first.ciphertext_data);
+    }
+
+    // A cold workspace only reserves one row of A
+    CLWEParameters params1024(1024);
+    ColorKEM materialized(params1024);
+    ColorKEM streamed(params1024);
+    streamed.set_matrix_streaming(true);
+    auto reserved = [](const ColorKEM& instance) {
+        KemWorkspace workspace;
+        std::array<uint8_t, 32> seed{};
+        auto keys = instance.keygen_derand(seed, workspace);
+        instance.encapsulate(keys.first, workspace);
+        return workspace.reserved_bytes();
+    };
+    size_t k = params1024.module_rank;
+    size_t saved = (k * k - k) * params1024.degree * sizeof(ColorValue);
+    EXPECT_EQ(reserved(materialized), reserved(streamed) + saved);
+
+    // One workspace can serve streaming and materializing instances in turn
+    KemWorkspace workspace;
+    auto keys = streamed.keygen(workspace);
+    auto encapsulated = materialized.encapsulate(keys.first, workspace);
+    EXPECT_EQ(streamed.decapsulate(keys.first, keys.second, encapsulated.first, workspace), encapsulated.second);
+}
+
+// AES256_CTR sets round-trip in both modes, streamed or not, and expand keys of their own
+TEST_F(ColorKEMTest, AesXofRoundTrip) {
+    std::array<uint8_t, 32> d{};
+    std::array<uint8_t, 32> m{};
+    m.fill(0x3C);
+    for (uint32_t level : {512u, 768u, 1024u}) {
+        CLWEParameters aes_params(level);
+        aes_params.xof = XofAlgorithm::AES256_CTR;
+        ColorKEM aes_kem(aes_params);
+        ColorKEM streamed(aes_params);
+        streamed.set_matrix_streaming(true);
+        ColorKEM shake_kem{CLWEParameters(level)};
+
+        auto keys = aes_kem.keygen_derand(d);
+        EXPECT_EQ(streamed.keygen_derand(d).first.public_data, keys.first.public_data);
+        EXPECT_NE(shake_kem.keygen_derand(d).first.public_data, keys.first.public_data);
+        EXPECT_EQ(keys.first.public_data.size(), shake_kem.keygen_derand(d).first.public_data.size());
+
+        auto encapsulated = aes_kem.encapsulate_derand(keys.first, m);
+        EXPECT_EQ(streamed.encapsulate_derand(keys.first, m).first.ciphertext_data,
+                  encapsulated.first.ciphertext_data);
+        EXPECT_EQ(aes_kem.decapsulate(keys.first, keys.second, encapsulated.first), encapsulated.second);
+
+        auto [ciphertext, key] = aes_kem.encapsulate_key(keys.first);
+        EXPECT_EQ(streamed.decapsulate_key(keys.first, keys.second, ciphertext), key) << "level " << level;
+        EXPECT_THROW(shake_kem.encapsulate(keys.first), std::invalid_argument);
+    }
+}
+
+// Test that a shared matrix gives the keys and ciphertexts of its seed without carrying it
+TEST_F(ColorKEMTest, SharedMatrixMatchesSeededKeys) {
+    CLWEParameters shared_params(768);
+    shared_params.shared_matrix = true;
+    CLWEParameters plain_params(768);
+    std::array<uint8_t, 32> deployment_seed;
+    deployment_seed.fill(0xA5);
+
+    std::shared_ptr<const SharedMatrix> installed = ColorKEM::install_shared_matrix(shared_params, deployment_seed);
+    EXPECT_EQ(ColorKEM::install_shared_matrix(shared_params, deployment_seed), installed);
+    EXPECT_EQ(ColorKEM::find_shared_matrix(plain_params), installed);
+    std::array<uint8_t, 32> other_seed = deployment_seed;
+    other_seed[0] ^= 1;
+    EXPECT_THROW(ColorKEM::install_shared_matrix(shared_params, other_seed), std::logic_error);
+
+    ColorKEM shared_kem(shared_params);
+    ColorKEM plain_kem(plain_params);
+    shared_kem.set_matrix_streaming(true);
+    EXPECT_FALSE(shared_kem.matrix_streaming());
+
+    std::array<uint8_t, 32> secret_seed, error_seed, m;
+    secret_seed.fill(0x11);
+    error_seed.fill(0x22);
+    m.fill(0x33);
+    auto keys = shared_kem.keygen_deterministic(secret_seed, secret_seed, error_seed);
+    auto plain_keys = plain_kem.keygen_deterministic(deployment_seed, secret_seed, error_seed);
+    EXPECT_EQ(keys.first.seed, deployment_seed);
+    EXPECT_EQ(keys.first.public_data, plain_keys.first.public_data);
+
+    auto encapsulated = shared_kem.encapsulate_key_derand(keys.first, m);
+    EXPECT_EQ(encapsulated.first.ciphertext_data,
+              plain_kem.encapsulate_key_derand(plain_keys.first, m).first.ciphertext_data);
+    EXPECT_EQ(shared_kem.decapsulate_key(keys.first, keys.second, encapsulated.first), encapsulated.second);
+
+    // The wire form drops the seed and parsing restores it from the installed matrix
+    std::vector<uint8_t> wire = keys.first.serialize();
+    EXPECT_EQ(wire.size(), ColorPublicKey::serialized_size(plain_params) - 32);
+    EXPECT_EQ(wire, keys.first.public_data);
+    ColorPublicKey parsed = ColorPublicKey::deserialize(wire, shared_params);
+    EXPECT_EQ(parsed.seed, deployment_seed);
+    ColorExpandedPrivateKey expanded = shared_kem.expand_private_key(keys.first, keys.second);
+    EXPECT_EQ(ColorExpandedPrivateKey::deserialize(expanded.serialize(), shared_params).public_key.public_data,
+              keys.first.public_data);
+
+    ColorPublicKeyView view;
+    view.public_data = wire.data();
+    view.public_data_size = wire.size();
+    view.encoding = shared_params.encoding;
+    view.params = shared_params;
+    EXPECT_EQ(shared_kem.encapsulate_key_derand(parsed, m).first.ciphertext_data,
+              encapsulated.first.ciphertext_data);
+    KemWorkspace workspace;
+    std::vector<uint8_t> view_ciphertext(ColorCiphertext::serialized_size(shared_params));
+    EXPECT_EQ(shared_kem.encapsulate_key_into(view, m, view_ciphertext.data(), view_ciphertext.size(), workspace),
+              encapsulated.second);
+    EXPECT_EQ(view_ciphertext, encapsulated.first.serialize());
+
+    // Shapes without an installed matrix refuse to build instances or parse keys
+    CLWEParameters missing(1024);
+    missing.xof = XofAlgorithm::AES256_CTR;
+    missing.shared_matrix = true;
+    EXPECT_EQ(ColorKEM::find_shared_matrix(missing), nullptr);
+    EXPECT_THROW(ColorKEM kem_without(missing), std::logic_error);
+    std::vector<uint8_t> missing_wire(ColorPublicKey::serialized_size(missing), 0);
+    ColorPublicKey out;
+    EXPECT_EQ(ColorPublicKey::try_deserialize(missing_wire.data(), missing_wire.size(), missing, out),
+              CLWEError::INVALID_PARAMETERS);
+    EXPECT_THROW(ColorPublicKey::deserialize(missing_wire, missing), std::logic_error);
+}
+
+// Huge pages only move the workspace arena; results are unchanged and normal pages are the fallback
+TEST_F(ColorKEMTest, HugePageWorkspace) {
+    PagePolicy parsed;
+    EXPECT_TRUE(parse_page_policy(page_policy_name(PagePolicy::Huge), parsed));
+    EXPECT_EQ(parsed, PagePolicy::Huge);
+    EXPECT_FALSE(parse_page_policy("gigantic", parsed));
+
+    std::array<uint8_t, 32> d{};
+    std::array<uint8_t, 32> m{};
+    d[0] = 0x48;
+    KemWorkspace normal_workspace;
+    auto keys = kem->keygen_derand(d, normal_workspace);
+    EXPECT_EQ(normal_workspace.page_backing(), PageBacking::Heap);
+
+    const PagePolicy previous = page_policy();
+    set_page_policy(PagePolicy::Huge);
+    KemWorkspace huge_workspace;
+    EXPECT_EQ(huge_workspace.page_backing(), PageBacking::Heap);
+    auto huge_keys = kem->keygen_derand(d, huge_workspace);
+    auto encapsulated = kem->encapsulate_derand(keys.first, m, huge_workspace);
+    set_page_policy(previous);
+
+    EXPECT_EQ(huge_keys.first.public_data, keys.first.public_data);
+    EXPECT_EQ(huge_keys.second.secret_data, keys.second.secret_data);
+    EXPECT_EQ(kem->decapsulate(keys.first, keys.second, encapsulated.first, huge_workspace), encapsulated.second);
+    if (huge_page_size() != 0) {
+        EXPECT_NE(huge_workspace.page_backing(), PageBacking::Heap) << page_backing_name(huge_workspace.page_backing());
+        EXPECT_EQ(huge_workspace.reserved_bytes(), normal_workspace.reserved_bytes());
+    }
+}
+
+// The fixed levels' budgets are constant expressions
+static_assert(ColorKEM1024::memory_requirements().keygen.workspace_bytes == KemWorkspace::arena_bytes(4, 256, true),
+              "ML-KEM-1024 keygen materializes A");
+static_assert(ColorKEM1024::memory_requirements(true).workspace_bytes() <
+                  ColorKEM1024::memory_requirements().workspace_bytes(),
+              "Streaming A shrinks the workspace");
+static_assert(ColorKEM512::memory_requirements().decapsulate.output_bytes == 0, "Decapsulation returns no heap data");
+
+#ifndef _WIN32
+// Deepest stack the operation reaches on a fresh thread whose stack is pre-filled with a pattern
+size_t measure_stack_bytes(const std::function<void()>& operation) {
+    const size_t stack_size = 8 * ColorKEM::MAX_STACK_BYTES;
+    std::vector<uint8_t> stack(stack_size, 0xA5);
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, stack.data(), stack.size());
+    pthread_t thread;
+    auto entry = [](void* arg) -> void* {
+        (*static_cast<const std::function<void()>*>(arg))();
+        return nullptr;
+    };
+    const bool started = pthread_create(&thread, &attr, entry, const_cast<std::function<void()>*>(&operation)) == 0;
+    pthread_attr_destroy(&attr);
+    if (!started) {
+        return 0;
+    }
+    pthread_join(thread, nullptr);
+
+    // The stack grows down, so the untouched pattern is at the low end
+    size_t untouched = 0;
+    while (untouched < stack.size() && stack[untouched] == 0xA5) {
+        ++untouched;
+    }
+    return stack.size() - untouched;
+}
+#endif
+
+// memory_requirements() is what an operation on a cold workspace actually takes
+TEST_F(ColorKEMTest, MemoryRequirementsMatchMeasuredUse) {
+    ASSERT_TRUE(AllocationTracker::hooks_installed());
+    auto requested = [](const std::function<void()>& operation) {
+        AllocationTracker tracker;
+        operation();
+        return tracker.stats().bytes_allocated;
+    };
+
+    for (uint32_t level : {512u, 768u, 1024u}) {
+        for (bool streaming : {false, true}) {
+            CLWEParameters level_params(level);
+            ColorKEM instance(level_params);
+            instance.set_matrix_streaming(streaming);
+            KemMemoryRequirements expected = instance.memory_requirements();
+            EXPECT_EQ(ColorKEM::memory_requirements(level_params, streaming).workspace_bytes(),
+                      expected.workspace_bytes());
+
+            std::pair<ColorPublicKey, ColorPrivateKey> keys;
+            KemWorkspace keygen_workspace;
+            EXPECT_EQ(requested([&] { keys = instance.keygen(keygen_workspace); }),
+                      expected.keygen.heap_bytes());
+            EXPECT_EQ(keygen_workspace.reserved_bytes(), expected.keygen.workspace_bytes);
+
+            // Warm the expanded-key cache so the measured encapsulation hits it
+            instance.encapsulate(keys.first);
+            std::pair<ColorCiphertext, ColorValue> encapsulated;
+            KemWorkspace encapsulate_workspace;
+            EXPECT_EQ(requested([&] { encapsulated = instance.encapsulate(keys.first, encapsulate_workspace); }),
+                      expected.encapsulate.workspace_bytes + expected.encapsulate.output_bytes);
+            EXPECT_EQ(encapsulate_workspace.reserved_bytes(), expected.encapsulate.workspace_bytes);
+            EXPECT_EQ(expected.encapsulate.expanded_key_bytes == 0, streaming);
+
+            ColorValue recovered;
+            KemWorkspace decapsulate_workspace;
+            EXPECT_EQ(requested([&] {
+                          recovered = instance.decapsulate(keys.first, keys.second, encapsulated.first,
+                                                           decapsulate_workspace);
+                      }),
+                      expected.decapsulate.heap_bytes());
+            EXPECT_EQ(recovered, encapsulated.second);
+
+#ifndef _WIN32
+            EXPECT_LE(measure_stack_bytes([&] { instance.keygen(); }), expected.stack_bytes);
+            EXPECT_LE(measure_stack_bytes([&] { instance.encapsulate(keys.first); }), expected.stack_bytes);
+            EXPECT_LE(measure_stack_bytes([&] { instance.decapsulate(keys.first, keys.second, encapsulated.first); }),
+                      expected.stack_bytes);
+#endif
+        }
+    }
+
+    KemMemoryRequirements level768 = ColorKEM768::memory_requirements();
+    KemMemoryRequirements runtime768 = ColorKEM::memory_requirements(CLWEParameters(768));
+    EXPECT_EQ(level768.keygen.heap_bytes(), runtime768.keygen.heap_bytes());
+    EXPECT_EQ(level768.encapsulate.heap_bytes(), runtime768.encapsulate.heap_bytes());
+}
+
+TEST_F(ColorKEMTest, SerializeIntoBuffer) {
+    auto [public_key, private_key] = kem->keygen();
+    auto [ciphertext, shared_secret] = kem->encapsulate(public_key);
+
+    std::vector<uint8_t> pk_buffer(ColorPublicKey::serialized_size(params));
+    EXPECT_EQ(public_key.serialize(pk_buffer.data(), pk_buffer.size()), pk_buffer.size());
+    EXPECT_EQ(pk_buffer, public_key.serialize());
+
+    std::vector<uint8_t> sk_buffer(ColorPrivateKey::serialized_size(params));
+    EXPECT_EQ(private_key.serialize(sk_buffer.data(), sk_buffer.size()), sk_buffer.size());
+    EXPECT_EQ(sk_buffer, private_key.serialize());
+
+    std::vector<uint8_t> ct_buffer(ColorCiphertext::serialized_size(params));
+    EXPECT_EQ(ciphertext.serialize(ct_buffer.data(), ct_buffer.size()), ct_buffer.size());
+    EXPECT_EQ(ct_buffer, ciphertext.serialize());
+
+    EXPECT_THROW(ciphertext.serialize(ct_buffer.data(), ct_buffer.size() - 1), std::invalid_argument);
+
+    ColorPublicKey pk_copy = ColorPublicKey::deserialize(pk_buffer.data(), pk_buffer.size(), params);
+    ColorCiphertext ct_copy = ColorCiphertext::deserialize(ct_buffer.data(), ct_buffer.size(), params);
+    EXPECT_EQ(pk_copy.public_data, public_key.public_data);
+    EXPECT_EQ(ct_copy.ciphertext_data, ciphertext.ciphertext_data);
+    EXPECT_EQ(ct_copy.shared_secret_hint, ciphertext.shared_secret_hint);
+}
+
+// Test that the memoized serialized form and H(pk) are reused and follow mutations
+TEST_F(ColorKEMTest, MemoizedSerializedForm) {
+    auto [public_key, private_key] = kem->keygen();
+    const std::vector<uint8_t>& bytes = public_key.serialized();
+    EXPECT_EQ(bytes, public_key.serialize());
+    EXPECT_EQ(&public_key.serialized(), &bytes);
+    EXPECT_EQ(public_key.fingerprint(), kem->expand_private_key(public_key, private_key).public_key_hash);
+
+    // Copies share the memo; concurrent first uses agree on one
+    ColorPublicKey copy = public_key;
+    EXPECT_EQ(&copy.serialized(), &bytes);
+    ColorPublicKey fresh = ColorPublicKey::deserialize(public_key.serialize(), params);
+    std::vector<const std::array<uint8_t, 32>*> seen(4);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < seen.size(); ++t) {
+        threads.emplace_back([&, t] { seen[t] = &fresh.fingerprint(); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (const auto* hash : seen) {
+        EXPECT_EQ(hash, &fresh.fingerprint());
+    }
+    EXPECT_EQ(fresh.fingerprint(), public_key.fingerprint());
+
+    // Field writes invalidate the memo of the modified key only
+    const std::array<uint8_t, 32> original_hash = public_key.fingerprint();
+    copy.public_data[7] ^= 0x01;
+    EXPECT_EQ(copy.serialized(), copy.serialize());
+    EXPECT_NE(copy.fingerprint(), original_hash);
+    copy.seed[0] ^= 0x80;
+    EXPECT_EQ(copy.serialized(), copy.serialize());
+    EXPECT_EQ(public_key.fingerprint(), original_hash);
+    EXPECT_EQ(public_key.serialized(), public_key.serialize());
+
+    copy.public_data.pop_back();
+    EXPECT_THROW(copy.serialized(), std::invalid_argument);
+}
+
+TEST_F(ColorKEMTest, DecapsulateCiphertextView) {
+    auto [public_key, private_key] = kem->keygen();
+    auto [ciphertext, shared_secret] = kem->encapsulate(public_key);
+    PreparedPrivateKey prepared = kem->prepare_private_key(private_key);
+
+    // Decapsulate straight from the wire bytes
+    std::vector<uint8_t> wire = ciphertext.serialize();
+    ColorCiphertextView view = ColorCiphertextView::parse(wire.data(), wire.size(), params);
+    EXPECT_EQ(kem->decapsulate(prepared, view), shared_secret);
+    EXPECT_EQ(kem->decapsulate(prepared, ColorCiphertextView(ciphertext)), shared_secret);
+
+    // Rejection hashes the same bytes whether or not the view is contiguous
+    wire[0] ^= 0x01;
+    ColorCiphertext tampered = ColorCiphertext::deserialize(wire, params);
+    EXPECT_EQ(kem->decapsulate(prepared, ColorCiphertextView::parse(wire.data(), wire.size(), params)),
+              kem->decapsulate(public_key, private_key, tampered));
+
+    EXPECT_THROW(ColorCiphertextView::parse(wire.data(), 6, params), std::invalid_argument);
+    EXPECT_THROW(kem->decapsulate(prepared, ColorCiphertextView::parse(wire.data(), wire.size() - 4, params)),
+                 std::invalid_argument);
+}
+
+
+// Fixed-level front ends match the runtime engine byte for byte
+template <typename Level>
+void check_level_matches_runtime() {
+    CLWEParameters params = Level::parameters();
+    EXPECT_EQ(Level::module_rank, params.module_rank);
+    EXPECT_EQ(Level::degree, params.degree);
+    EXPECT_EQ(Level::modulus, params.modulus);
+    EXPECT_EQ(Level::eta1, params.eta1);
+    EXPECT_EQ(Level::eta2, params.eta2);
+    EXPECT_EQ(Level::public_key_bytes, ColorPublicKey::serialized_size(params));
+    EXPECT_EQ(Level::private_key_bytes, ColorPrivateKey::serialized_size(params));
+    EXPECT_EQ(Level::ciphertext_bytes, ColorCiphertext::serialized_size(params));
+
+    std::array<uint8_t, 32> d{}, m{};
+    for (size_t i = 0; i < d.size(); ++i) {
+        d[i] = static_cast<uint8_t>(i * 7 + Level::module_rank);
+        m[i] = static_cast<uint8_t>(255 - i);
+    }
+
+    auto keys = Level::keygen_derand(d);
+    auto encapsulated = Level::encapsulate_derand(keys.first, m);
+    EXPECT_EQ(Level::decapsulate(keys.first, keys.second, encapsulated.first), encapsulated.second);
+
+    ColorKEM runtime(params);
+    auto runtime_keys = runtime.keygen_derand(d);
+    auto runtime_encapsulated = runtime.encapsulate_derand(runtime_keys.first, m);
+    std::vector<uint8_t> pk_bytes = runtime_keys.first.serialize();
+    std::vector<uint8_t> ct_bytes = runtime_encapsulated.first.serialize();
+    EXPECT_TRUE(std::equal(pk_bytes.begin(), pk_bytes.end(), keys.first.begin(), keys.first.end()));
+    EXPECT_TRUE(std::equal(ct_bytes.begin(), ct_bytes.end(), encapsulated.first.begin(), encapsulated.first.end()));
+    EXPECT_EQ(runtime_encapsulated.second, encapsulated.second);
+}
+
+// Recipients sharing a matrix seed share r and c1; every ciphertext carries the one secret
+TEST_F(ColorKEMTest, EncapsulateMultiSharesMatrix) {
+    std::array<uint8_t, 32> matrix_seed{}, secret_seed{}, error_seed{};
+    matrix_seed.fill(0x11);
+    std::vector<ColorPublicKey> public_keys;
+    std::vector<ColorPrivateKey> private_keys;
+    for (uint8_t i = 0; i < 3; ++i) {
+        secret_seed.fill(static_cast<uint8_t>(0x20 + i));
+        error_seed.fill(static_cast<uint8_t>(0x30 + i));
+        auto keys = kem->keygen_deterministic(matrix_seed, secret_seed, error_seed);
+        public_keys.push_back(keys.first);
+        private_keys.push_back(keys.second);
+    }
+    // An unrelated recipient in the middle forms its own group
+    auto unrelated = kem->keygen();
+    public_keys.insert(public_keys.begin() + 1, unrelated.first);
+    private_keys.insert(private_keys.begin() + 1, unrelated.second);
+
+    std::array<uint8_t, 32> m{};
+    m.fill(0x5A);
+    auto encapsulated = kem->encapsulate_multi_derand(public_keys, m);
+    ASSERT_EQ(encapsulated.first.size(), public_keys.size());
+    for (size_t i = 0; i < public_keys.size(); ++i) {
+        EXPECT_EQ(kem->decapsulate(public_keys[i], private_keys[i], encapsulated.first[i]), encapsulated.second);
+    }
+
+    const size_t c1_bytes = encapsulated.first[0].ciphertext_data.size() * params.module_rank /
+                            (params.module_rank + 1);
+    auto c1 = [&](size_t i) {
+        const std::vector<uint8_t>& data = encapsulated.first[i].ciphertext_data;
+        return std::vector<uint8_t>(data.begin(), data.begin() + c1_bytes);
+    };
+    EXPECT_EQ(c1(0), c1(2));
+    EXPECT_EQ(c1(0), c1(3));
+    EXPECT_NE(c1(0), c1(1));
+    // Each recipient gets its own e2
+    EXPECT_NE(encapsulated.first[0].ciphertext_data, encapsulated.first[2].ciphertext_data);
+
+    // Deterministic, and the streamed matrix gives the same bytes
+    auto repeated = kem->encapsulate_multi_derand(public_keys, m);
+    ColorKEM streaming(params);
+    streaming.set_matrix_streaming(true);
+    auto streamed = streaming.encapsulate_multi_derand(public_keys, m);
+    EXPECT_EQ(repeated.second, encapsulated.second);
+    EXPECT_EQ(streamed.second, encapsulated.second);
+    for (size_t i = 0; i < public_keys.size(); ++i) {
+        EXPECT_EQ(repeated.first[i].ciphertext_data, encapsulated.first[i].ciphertext_data);
+        EXPECT_EQ(streamed.first[i].ciphertext_data, encapsulated.first[i].ciphertext_data);
+        EXPECT_EQ(streamed.first[i].shared_secret_hint, encapsulated.first[i].shared_secret_hint);
+    }
+
+    auto random = kem->encapsulate_multi(public_keys);
+    for (size_t i = 0; i < public_keys.size(); ++i) {
+        EXPECT_EQ(kem->decapsulate(public_keys[i], private_keys[i], random.first[i]), random.second);
+    }
+
+    EXPECT_THROW(kem->encapsulate_multi({}), std::invalid_argument);
+    ColorKEM other{CLWEParameters(768)};
+    public_keys.push_back(other.keygen().first);
+    EXPECT_THROW(kem->encapsulate_multi(public_keys), std::invalid_argument);
+}
+
+TEST_F(ColorKEMTest, CompileTimeLevels) {
+    check_level_matches_runtime<ColorKEM512>();
+    check_level_matches_runtime<ColorKEM768>();
+    check_level_matches_runtime<ColorKEM1024>();
+
+    auto keys = ColorKEM768::keygen();
+    auto encapsulated = ColorKEM768::encapsulate(keys.first);
+    EXPECT_EQ(ColorKEM768::decapsulate(keys.first, keys.second, encapsulated.first), encapsulated.second);
+}
+
+// Test that the instance reports the backend its kernels dispatch to
+TEST_F(ColorKEMTest, BackendFollowsDispatch) {
+    SIMDSupport expected = create_optimal_ntt_engine(params.modulus, params.degree)->get_simd_support();
+    EXPECT_EQ(kem->backend(), expected);
+
+    SIMDSupport forced;
+    const char* env = std::getenv("CLWE_FORCE_BACKEND");
+    if (env != nullptr && CPUFeatureDetector::parse_backend(env, forced) && forced == SIMDSupport::NONE) {
+        EXPECT_EQ(kem->backend(), SIMDSupport::NONE);
+    }
+}
+
+// The try_*() variants agree with the throwing API and report its failures as codes
+TEST_F(ColorKEMTest, ErrorCodeVariants) {
+    auto [public_key, private_key] = kem->keygen();
+    ColorExpandedPrivateKey expanded = kem->expand_private_key(public_key, private_key);
+    ColorCiphertext ciphertext;
+    SharedSecret shared_key, recovered;
+    ASSERT_EQ(kem->try_encapsulate_key(public_key, ciphertext, shared_key), CLWEError::SUCCESS);
+    std::vector<uint8_t> wire = ciphertext.serialize();
+    ColorCiphertextView view;
+    ASSERT_EQ(ColorCiphertextView::try_parse(wire.data(), wire.size(), params, view), CLWEError::SUCCESS);
+    ASSERT_EQ(kem->try_decapsulate_key(expanded, view, recovered), CLWEError::SUCCESS);
+    EXPECT_EQ(recovered, shared_key);
+    EXPECT_EQ(recovered, kem->decapsulate_key(expanded, ciphertext));
+
+    // Serialized forms parse back identically
+    std::vector<uint8_t> pk_bytes = public_key.serialize();
+    std::vector<uint8_t> sk_bytes = expanded.serialize();
+    ColorPublicKey parsed_public;
+    ColorExpandedPrivateKey parsed_private;
+    ColorCiphertext parsed_ciphertext;
+    ASSERT_EQ(ColorPublicKey::try_deserialize(pk_bytes.data(), pk_bytes.size(), params, parsed_public),
+              CLWEError::SUCCESS);
+    EXPECT_EQ(parsed_public.serialize(), pk_bytes);
+    ASSERT_EQ(ColorExpandedPrivateKey::try_deserialize(sk_bytes.data(), sk_bytes.size(), params, parsed_private),
+              CLWEError::SUCCESS);
+    EXPECT_EQ(parsed_private.serialize(), sk_bytes);
+    ASSERT_EQ(ColorCiphertext::try_deserialize(wire.data(), wire.size(), params, parsed_ciphertext),
+              CLWEError::SUCCESS);
+    EXPECT_EQ(parsed_ciphertext.serialize(), wire);
+
+    // Each failure the throwing functions raise is a code here
+    EXPECT_EQ(ColorCiphertextView::try_parse(wire.data(), 6, params, view), CLWEError::INVALID_CIPHERTEXT);
+    EXPECT_EQ(ColorCiphertextView::try_parse(nullptr, wire.size(), params, view), CLWEError::INVALID_CIPHERTEXT);
+    EXPECT_EQ(ColorPublicKey::try_deserialize(pk_bytes.data(), 32, params, parsed_public), CLWEError::INVALID_KEY);
+    EXPECT_THROW(ColorPublicKey::deserialize(pk_bytes.data(), 32, params), std::invalid_argument);
+    EXPECT_EQ(ColorPrivateKey::try_deserialize(sk_bytes.data(), 0, params, private_key), CLWEError::INVALID_KEY);
+    std::vector<uint8_t> bad_sk = sk_bytes;
+    bad_sk.back() ^= 1;
+    EXPECT_EQ(ColorExpandedPrivateKey::try_deserialize(bad_sk.data(), bad_sk.size(), params, parsed_private),
+              CLWEError::INVALID_KEY);
+    EXPECT_THROW(ColorExpandedPrivateKey::deserialize(bad_sk, params), std::invalid_argument);
+
+    // A short view is refused by shape; tampered content is implicitly rejected
+    ASSERT_EQ(ColorCiphertextView::try_parse(wire.data(), wire.size() - 4, params, view), CLWEError::SUCCESS);
+    EXPECT_EQ(kem->try_decapsulate_key(expanded, view, recovered), CLWEError::INVALID_CIPHERTEXT);
+    EXPECT_EQ(recovered, SharedSecret());
+    wire[3] ^= 0x10;
+    ASSERT_EQ(ColorCiphertextView::try_parse(wire.data(), wire.size(), params, view), CLWEError::SUCCESS);
+    ASSERT_EQ(kem->try_decapsulate_key(expanded, view, recovered), CLWEError::SUCCESS);
+    EXPECT_NE(recovered, shared_key);
+
+    ColorKEM other(CLWEParameters(768));
+    EXPECT_EQ(other.try_encapsulate_key(public_key, ciphertext, shared_key), CLWEError::INVALID_PARAMETERS);
+    EXPECT_EQ(shared_key, SharedSecret());
+    KemWorkspace workspace;
+    uint8_t small[8];
+    EXPECT_EQ(kem->try_encapsulate_key_into(ColorPublicKeyView(public_key), small, sizeof(small), shared_key,
+                                            workspace),
+              CLWEError::BUFFER_TOO_SMALL);
+    EXPECT_STREQ(error_string(CLWEError::INVALID_CIPHERTEXT), "Invalid ciphertext");
+}
+
+// Malformed ciphertexts cost no allocation (no exception objects, no messages)
+TEST_F(ColorKEMTest, MalformedCiphertextFloodAllocatesNothing) {
+    ASSERT_TRUE(AllocationTracker::hooks_installed());
+    auto [public_key, private_key] = kem->keygen();
+    ColorExpandedPrivateKey expanded = kem->expand_private_key(public_key, private_key);
+    std::vector<uint8_t> wire(ColorCiphertext::serialized_size(params), 0x5A);
+    SharedSecret recovered;
+    KemWorkspace workspace;
+    ColorCiphertextView view;
+    ASSERT_EQ(ColorCiphertextView::try_parse(wire.data(), wire.size(), params, view), CLWEError::SUCCESS);
+    ASSERT_EQ(kem->try_decapsulate_key(expanded, view, recovered, workspace), CLWEError::SUCCESS);
+
+    AllocationTracker tracker;
+    size_t refused = 0;
+    for (size_t size = 0; size < 64; ++size) {
+        // Too short to parse, or parsed but the wrong size for the parameters
+        if (ColorCiphertextView::try_parse(wire.data(), size, params, view) != CLWEError::SUCCESS ||
+            kem->try_decapsulate_key(expanded, view, recovered, workspace) != CLWEError::SUCCESS) {
+            ++refused;
+        }
+    }
+    EXPECT_EQ(refused, 64u);
+    EXPECT_EQ(tracker.stats().allocations, 0u);
+}
+
+// Test the algorithmic work of each operation, exactly, at every security level
+TEST_F(ColorKEMTest, WorkCountersPerOperation) {
+    for (uint32_t level : {512u, 768u, 1024u}) {
+        CLWEParameters level_params(level);
+        ColorKEM level_kem(level_params);
+        const double k = level_params.module_rank;
+        const double n = level_params.degree;
+        auto [public_key, private_key] = level_kem.keygen();
+        auto [ciphertext, secret] = level_kem.encapsulate(public_key);
+        PreparedPrivateKey prepared = level_kem.prepare_private_key(private_key);
+
+        // s and e forward, A s accumulated in NTT domain, t packed there without an inverse
+        WorkStats keygen = PerformanceMetrics::measure_work([&]() { level_kem.keygen(); });
+        EXPECT_EQ(keygen.ntt_forward, 2 * k) << "level " << level;
+        EXPECT_EQ(keygen.basemul, k * k);
+        EXPECT_EQ(keygen.ntt_inverse, 0);
+        EXPECT_EQ(keygen.rng_bytes, 32);
+        EXPECT_EQ(keygen.coefficients_packed, 2 * k * n);
+
+        // r forward; A^T r and t^T r, each back out of NTT domain
+        WorkStats encapsulate = PerformanceMetrics::measure_work([&]() { level_kem.encapsulate(public_key); });
+        EXPECT_EQ(encapsulate.ntt_forward, k);
+        EXPECT_EQ(encapsulate.basemul, k * k + k);
+        EXPECT_EQ(encapsulate.ntt_inverse, k + 1);
+        EXPECT_EQ(encapsulate.coefficients_packed, k * n + n);
+
+        // A prepared key is already in NTT domain: only c1 is transformed for s^T c1
+        KemWorkspace workspace;
+        ColorCiphertextView view(ciphertext);
+        WorkStats decapsulate =
+            PerformanceMetrics::measure_work([&]() { level_kem.decapsulate(prepared, view, workspace); }, 4);
+        EXPECT_EQ(decapsulate.basemul, k);
+        EXPECT_EQ(decapsulate.ntt_forward, k);
+        EXPECT_EQ(decapsulate.ntt_inverse, 1);
+        EXPECT_EQ(decapsulate.rng_bytes, 0);
+        EXPECT_EQ(decapsulate.coefficients_packed, 0);
+        EXPECT_TRUE(decapsulate.allocations_available);
+        EXPECT_EQ(decapsulate.bytes_allocated, 0);
+    }
+
+    // Nothing is counted outside a scope, and inner scopes add up into outer ones
+    auto [public_key, private_key] = kem->keygen();
+    WorkCounterScope outer;
+    {
+        WorkCounterScope inner;
+        kem->encapsulate(public_key);
+        EXPECT_EQ(inner.counters()[WorkCounter::RNG_BYTES], 32u);
+    }
+    EXPECT_EQ(outer.counters()[WorkCounter::RNG_BYTES], 32u);
+    EXPECT_GT(outer.counters()[WorkCounter::SHAKE_SQUEEZED_BYTES], 0u);
+}
+
+// Precomputed bundles finish into exactly the ciphertexts encapsulate() draws with the same m
+TEST_F(ColorKEMTest, PrecomputedEncapsulationMatchesEncapsulate) {
+    std::array<uint8_t, 32> seed{};
+    seed[0] = 0x43;
+    for (uint32_t level : {512u, 768u, 1024u}) {
+        for (bool streaming : {false, true}) {
+            ColorKEM offline{CLWEParameters(level)};
+            ColorKEM reference{CLWEParameters(level)};
+            offline.set_matrix_streaming(streaming);
+            auto [public_key, private_key] = reference.keygen();
+            offline.set_random_source(std::make_shared<DeterministicRandomSource>(seed));
+            reference.set_random_source(std::make_shared<DeterministicRandomSource>(seed));
+
+            std::vector<EncapsulationBundle> bundles = offline.precompute_encapsulation(public_key, 3);
+            ASSERT_EQ(bundles.size(), 3u);
+            ColorCiphertext reused;
+            for (EncapsulationBundle& bundle : bundles) {
+                ASSERT_TRUE(bundle.ready());
+                auto expected = reference.encapsulate(public_key);
+                EXPECT_EQ(offline.encapsulate_online(bundle, reused), expected.second);
+                EXPECT_EQ(reused.serialize(), expected.first.serialize());
+                EXPECT_EQ(offline.decapsulate(public_key, private_key, reused), expected.second);
+                EXPECT_FALSE(bundle.ready());
+            }
+        }
+    }
+
+    auto [public_key, private_key] = kem->keygen();
+    ExpandedPublicKey expanded = kem->expand_public_key(public_key);
+    std::vector<EncapsulationBundle> bundles = kem->precompute_encapsulation(expanded, 2);
+    auto online = kem->encapsulate_online(bundles[0]);
+    EXPECT_EQ(kem->decapsulate(public_key, private_key, online.first), online.second);
+    EXPECT_TRUE(kem->precompute_encapsulation(expanded, 0).empty());
+}
+
+// Test that a bundle finishes once, and only on a KEM of its parameters
+TEST_F(ColorKEMTest, EncapsulationBundleIsSingleUse) {
+    auto [public_key, private_key] = kem->keygen();
+    std::vector<EncapsulationBundle> bundles = kem->precompute_encapsulation(public_key, 2);
+    kem->encapsulate_online(bundles[0]);
+    EXPECT_THROW(kem->encapsulate_online(bundles[0]), std::invalid_argument);
+
+    EncapsulationBundle moved = std::move(bundles[1]);
+    EXPECT_FALSE(bundles[1].ready());
+    EXPECT_THROW(kem->encapsulate_online(bundles[1]), std::invalid_argument);
+    EncapsulationBundle empty;
+    EXPECT_THROW(kem->encapsulate_online(empty), std::invalid_argument);
+
+    ColorKEM other{CLWEParameters(768)};
+    EXPECT_THROW(other.encapsulate_online(moved), std::invalid_argument);
+    ASSERT_TRUE(moved.ready());
+    auto online = kem->encapsulate_online(moved);
+    EXPECT_EQ(kem->decapsulate(public_key, private_key, online.first), online.second);
+}
+
+// Test that a seed-only private key regenerates the key keygen_derand made, also in
+// streaming mode and for a fixed-weight ternary set
+TEST_F(ColorKEMTest, CompactPrivateKeyRegeneratesKey) {
+    std::array<uint8_t, 32> d;
+    d.fill(0x6B);
+    CLWEParameters weighted(768);
+    weighted.secret_weight = 64;
+    for (const CLWEParameters& params : {CLWEParameters(512), CLWEParameters(1024), weighted}) {
+        ColorKEM instance(params);
+        auto keys = instance.keygen_derand(d);
+        ColorCompactPrivateKey compact{d, params};
+        EXPECT_EQ(instance.expand_compact_private_key(compact).secret_data, keys.second.secret_data);
+
+        auto encapsulated = instance.encapsulate(keys.first);
+        PreparedPrivateKey prepared = instance.prepare_private_key(compact);
+        EXPECT_EQ(instance.decapsulate(prepared, encapsulated.first), encapsulated.second);
+        EXPECT_EQ(prepared.sparse_secret != nullptr, params.secret_weight != 0);
+    }
+
+    kem->set_matrix_streaming(true);
+    auto [public_key, compact] = kem->keygen_compact();
+    std::vector<uint8_t> stored = compact.serialize();
+    ASSERT_EQ(stored.size(), ColorCompactPrivateKey::BYTES);
+    ColorCompactPrivateKey loaded = ColorCompactPrivateKey::deserialize(stored, kem->params());
+    EXPECT_EQ(loaded.seed, compact.seed);
+    EXPECT_EQ(kem->keygen_derand(loaded.seed).first.serialize(), public_key.serialize());
+    auto encapsulated = kem->encapsulate(public_key);
+    EXPECT_EQ(kem->decapsulate(public_key, kem->expand_compact_private_key(loaded), encapsulated.first),
+              encapsulated.second);
+
+    stored.pop_back();
+    EXPECT_THROW(ColorCompactPrivateKey::deserialize(stored, kem->params()), std::invalid_argument);
+    ColorKEM other{CLWEParameters(1024)};
+    EXPECT_THROW(other.prepare_private_key(loaded), std::invalid_argument);
+    EXPECT_THROW(other.expand_compact_private_key(loaded), std::invalid_argument);
 }
 
-} // namespace clwe
\ No newline at end of file
+} // namespace clwe
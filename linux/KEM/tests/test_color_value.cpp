@@ -1,5 +1,9 @@
 #include <gtest/gtest.h>
 #include "color_value.hpp"
+#include "cpu_features.hpp"
+#include "simd_target.hpp"
+#include <algorithm>
+#include <stdexcept>
 #include <vector>
 
 namespace clwe {
@@ -56,6 +60,39 @@ TEST_F(ColorValueTest, MathValueConversion) {
     EXPECT_EQ(math_val, 0xFF804020u); // 255<<24 | 128<<16 | 64<<8 | 32
 }
 
+// Test bulk math value conversion
+TEST_F(ColorValueTest, BulkMathValueConversion) {
+    // Lengths around the vector widths exercise every kernel plus the scalar tail
+    for (size_t count : {0, 1, 3, 4, 7, 8, 15, 16, 17, 33, 256, 1031}) {
+        std::vector<uint32_t> values(count);
+        uint32_t x = 0x9E3779B9u;
+        for (size_t i = 0; i < count; ++i) {
+            x = x * 1664525u + 1013904223u;
+            values[i] = x;
+        }
+
+        std::vector<ColorValue> colors(count);
+        colors_from_u32(values.data(), colors.data(), count);
+        for (size_t i = 0; i < count; ++i) {
+            ASSERT_EQ(colors[i], ColorValue::from_math_value(values[i])) << "count=" << count << " i=" << i;
+        }
+
+        std::vector<uint32_t> round_trip(count);
+        colors_to_u32(colors.data(), round_trip.data(), count);
+        EXPECT_EQ(round_trip, values) << "count=" << count;
+    }
+
+    // In place: the buffer holds math values before and colors after
+    std::vector<uint32_t> buffer = {0x01020304u, 0xAABBCCDDu, 0, 0xFFFFFFFFu, 5, 6, 7, 8, 9};
+    std::vector<uint32_t> original = buffer;
+    ColorValue* colors = reinterpret_cast<ColorValue*>(buffer.data());
+    colors_from_u32(buffer.data(), colors, buffer.size());
+    EXPECT_EQ(colors[0], ColorValue(1, 2, 3, 4));
+    EXPECT_EQ(colors[1], ColorValue(0xAA, 0xBB, 0xCC, 0xDD));
+    colors_to_u32(colors, buffer.data(), buffer.size());
+    EXPECT_EQ(buffer, original);
+}
+
 // Test precise value conversion
 TEST_F(ColorValueTest, PreciseValueConversion) {
     ColorValue original(255, 128, 64);
@@ -114,6 +151,41 @@ TEST_F(ColorValueTest, HSVConversion) {
     EXPECT_NEAR(rgb.b, back_to_rgb.b, 1);
 }
 
+// Test the array HSV conversions against the per-pixel ones over every RGB triple
+TEST_F(ColorValueTest, ArrayHSVConversionIsBitExact) {
+    using namespace color_ops;
+
+    // 4099 pixels per chunk: not a multiple of any vector width, so the tails run too
+    const size_t chunk = 4099;
+    const uint32_t total = 1u << 24;
+    std::vector<ColorValue> in(chunk), hsv(chunk), rgb(chunk);
+    for (uint32_t first = 0; first < total; first += chunk) {
+        size_t count = std::min<size_t>(chunk, total - first);
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t v = first + static_cast<uint32_t>(i);
+            in[i] = ColorValue(static_cast<uint8_t>(v >> 16), static_cast<uint8_t>(v >> 8),
+                               static_cast<uint8_t>(v), static_cast<uint8_t>(v * 31));
+        }
+        rgb_to_hsv(in.data(), hsv.data(), count);
+        hsv_to_rgb(in.data(), rgb.data(), count);
+        for (size_t i = 0; i < count; ++i) {
+            ASSERT_EQ(hsv[i], in[i].to_hsv()) << in[i].to_string();
+            ASSERT_EQ(rgb[i], in[i].from_hsv()) << in[i].to_string();
+        }
+    }
+
+    // In place
+    std::vector<ColorValue> buffer = {ColorValue(255, 0, 0), ColorValue(12, 200, 99, 7), ColorValue(0, 0, 0),
+                                      ColorValue(1, 2, 3), ColorValue(9, 9, 9), ColorValue(250, 251, 3),
+                                      ColorValue(40, 4, 200), ColorValue(255, 255, 255), ColorValue(17, 0, 255)};
+    std::vector<ColorValue> expected;
+    for (const ColorValue& c : buffer) {
+        expected.push_back(c.to_hsv());
+    }
+    rgb_to_hsv(buffer.data(), buffer.data(), buffer.size());
+    EXPECT_EQ(buffer, expected);
+}
+
 // Test string representation
 TEST_F(ColorValueTest, StringRepresentation) {
     ColorValue c(255, 128, 64, 32);
@@ -164,18 +236,27 @@ TEST_F(ColorValueTest, ModularReduction) {
 
 // Test SIMD operations if available
 #ifdef HAVE_AVX512
-TEST_F(ColorValueTest, AVX512Operations) {
+// The kernels take vector arguments, so the caller must be compiled for AVX-512 as well
+CLWE_TARGET_AVX512 static void avx512_color_ops(int& sum_lane, int& prod_lane) {
     using namespace color_ops;
 
     __m512i a = _mm512_set1_epi32(0xFF804020);
     __m512i b = _mm512_set1_epi32(0x80402010);
 
-    __m512i sum = add_colors_avx512(a, b);
-    __m512i prod = multiply_colors_avx512(a, b);
+    sum_lane = _mm512_cvtsi512_si32(add_colors_avx512(a, b));
+    prod_lane = _mm512_cvtsi512_si32(multiply_colors_avx512(a, b));
+}
+
+TEST_F(ColorValueTest, AVX512Operations) {
+    if (!CPUFeatureDetector::cached().has_avx512bw) {
+        GTEST_SKIP() << "CPU lacks AVX-512BW";
+    }
+    int sum = 0, prod = 0;
+    avx512_color_ops(sum, prod);
 
     // Basic checks that operations don't crash
-    EXPECT_NE(_mm512_extract_epi32(sum, 0), 0);
-    EXPECT_NE(_mm512_extract_epi32(prod, 0), 0);
+    EXPECT_NE(sum, 0);
+    EXPECT_NE(prod, 0);
 }
 #endif
 
@@ -214,6 +295,54 @@ TEST_F(ColorValueTest, SIMDWrapperOperations) {
     EXPECT_LT(reduced_simd.to_math_value(), modulus);
 }
 
+// Test the array color_ops against per-element math-value arithmetic
+TEST_F(ColorValueTest, ArrayModularOperations) {
+    using namespace color_ops;
+
+    for (uint32_t q : {3329u, 65521u, 65536u}) {
+        // Not a multiple of any vector width, so the scalar tail runs too
+        const size_t count = 131;
+        std::vector<ColorValue> a(count), b(count), out(count);
+        uint32_t state = 0x243F6A88u ^ q;
+        for (size_t i = 0; i < count; ++i) {
+            state = state * 1664525u + 1013904223u;
+            a[i] = ColorValue::from_math_value(state);
+            state = state * 1664525u + 1013904223u;
+            b[i] = ColorValue::from_math_value(i % 3 == 0 ? state % q : state);
+        }
+
+        add_mod(a.data(), b.data(), out.data(), count, q);
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t expected = (static_cast<uint64_t>(a[i].to_math_value()) + b[i].to_math_value()) % q;
+            ASSERT_EQ(out[i].to_math_value(), expected) << "add q=" << q << " i=" << i;
+        }
+        sub_mod(a.data(), b.data(), out.data(), count, q);
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t expected = (a[i].to_math_value() % q + q - b[i].to_math_value() % q) % q;
+            ASSERT_EQ(out[i].to_math_value(), expected) << "sub q=" << q << " i=" << i;
+        }
+        mul_mod(a.data(), b.data(), out.data(), count, q);
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t expected = static_cast<uint64_t>(a[i].to_math_value() % q) * (b[i].to_math_value() % q) % q;
+            ASSERT_EQ(out[i].to_math_value(), expected) << "mul q=" << q << " i=" << i;
+        }
+
+        // Each element agrees with the single-value API; out may alias an input
+        std::vector<ColorValue> reduced = a;
+        reduce_mod(reduced.data(), count, q);
+        mul_mod(reduced.data(), reduced.data(), reduced.data(), count, q);
+        for (size_t i = 0; i < count; ++i) {
+            ColorValue single = mod_reduce_color(a[i], q);
+            ASSERT_EQ(reduced[i], single.mod_multiply(single, q)) << "q=" << q << " i=" << i;
+        }
+    }
+
+    std::vector<ColorValue> colors(4);
+    EXPECT_THROW(add_mod(colors.data(), colors.data(), colors.data(), colors.size(), 0), std::invalid_argument);
+    EXPECT_THROW(mul_mod(colors.data(), colors.data(), colors.data(), colors.size(), 65537), std::invalid_argument);
+    EXPECT_THROW(reduce_mod(colors.data(), colors.size(), 1), std::invalid_argument);
+}
+
 // Test invalid inputs
 TEST_F(ColorValueTest, InvalidInputs) {
     // Test with modulus = 0 (should handle gracefully)
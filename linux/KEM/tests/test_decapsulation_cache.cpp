@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+#include "clwe/decapsulation_cache.hpp"
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace clwe {
+
+class DecapsulationCacheTest : public ::testing::Test {
+protected:
+    ColorKEM kem{CLWEParameters(768)};
+};
+
+// Test that a resent ciphertext is answered from the cache with the same secret
+TEST_F(DecapsulationCacheTest, ReturnsCachedSecret) {
+    auto keys = kem.keygen();
+    DecapsulationCache cache(kem, kem.prepare_private_key(keys.second));
+    EXPECT_EQ(cache.capacity(), 1024u);
+    auto first = kem.encapsulate(keys.first);
+    auto second = kem.encapsulate(keys.first);
+
+    EXPECT_EQ(cache.decapsulate(first.first), first.second);
+    EXPECT_EQ(cache.misses(), 1u);
+    EXPECT_EQ(cache.decapsulate(first.first), first.second);
+    EXPECT_EQ(cache.hits(), 1u);
+    KemWorkspace workspace;
+    EXPECT_EQ(cache.decapsulate(ColorCiphertextView(second.first), workspace), second.second);
+    EXPECT_EQ(cache.decapsulate(ColorCiphertextView(second.first), workspace), second.second);
+    EXPECT_EQ(cache.decapsulate(first.first), first.second);
+    EXPECT_EQ(cache.hits(), 3u);
+    EXPECT_EQ(cache.misses(), 2u);
+}
+
+// Test the 256-bit mode, including a tampered ciphertext's implicit rejection value
+TEST_F(DecapsulationCacheTest, KeyModeAndImplicitRejection) {
+    auto keys = kem.keygen();
+    ColorExpandedPrivateKey expanded = kem.expand_private_key(keys.first, keys.second);
+    DecapsulationCache cache(kem, expanded);
+    auto encapsulated = kem.encapsulate_key(keys.first);
+    EXPECT_EQ(cache.decapsulate_key(encapsulated.first), encapsulated.second);
+    EXPECT_EQ(cache.decapsulate_key(encapsulated.first), encapsulated.second);
+
+    ColorCiphertext tampered = encapsulated.first;
+    tampered.ciphertext_data[5] ^= 1;
+    SharedSecret rejected = kem.decapsulate_key(expanded, tampered);
+    EXPECT_NE(rejected, encapsulated.second);
+    EXPECT_EQ(cache.decapsulate_key(tampered), rejected);
+    EXPECT_EQ(cache.decapsulate_key(tampered), rejected);
+    EXPECT_EQ(cache.hits(), 2u);
+    EXPECT_EQ(cache.misses(), 2u);
+    EXPECT_THROW(cache.decapsulate(encapsulated.first), std::logic_error);
+}
+
+// Test that results expire after the TTL and that clear() drops them
+TEST_F(DecapsulationCacheTest, ExpiresAndClears) {
+    auto keys = kem.keygen();
+    DecapsulationCacheConfig config;
+    config.ttl = std::chrono::milliseconds(30);
+    DecapsulationCache cache(kem, kem.prepare_private_key(keys.second), config);
+    auto encapsulated = kem.encapsulate(keys.first);
+
+    cache.decapsulate(encapsulated.first);
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    EXPECT_EQ(cache.decapsulate(encapsulated.first), encapsulated.second);
+    EXPECT_EQ(cache.misses(), 2u);
+    EXPECT_EQ(cache.hits(), 0u);
+
+    cache.clear();
+    EXPECT_EQ(cache.decapsulate(encapsulated.first), encapsulated.second);
+    EXPECT_EQ(cache.misses(), 3u);
+}
+
+// Test that a full set evicts its oldest result
+TEST_F(DecapsulationCacheTest, EvictsOldest) {
+    auto keys = kem.keygen();
+    DecapsulationCacheConfig config;
+    config.capacity = 3;
+    DecapsulationCache cache(kem, kem.prepare_private_key(keys.second), config);
+    ASSERT_EQ(cache.capacity(), DecapsulationCache::WAYS);
+
+    std::vector<std::pair<ColorCiphertext, ColorValue>> encapsulations;
+    for (size_t i = 0; i <= DecapsulationCache::WAYS; ++i) {
+        encapsulations.push_back(kem.encapsulate(keys.first));
+        cache.decapsulate(encapsulations.back().first);
+    }
+    EXPECT_EQ(cache.misses(), DecapsulationCache::WAYS + 1);
+    for (size_t i = 1; i < encapsulations.size(); ++i) {
+        EXPECT_EQ(cache.decapsulate(encapsulations[i].first), encapsulations[i].second);
+    }
+    EXPECT_EQ(cache.hits(), DecapsulationCache::WAYS);
+    EXPECT_EQ(cache.decapsulate(encapsulations[0].first), encapsulations[0].second);
+    EXPECT_EQ(cache.misses(), DecapsulationCache::WAYS + 2);
+}
+
+// Test that concurrent lookups of shared ciphertexts all get the right secrets
+TEST_F(DecapsulationCacheTest, ConcurrentLookups) {
+    auto keys = kem.keygen();
+    DecapsulationCache cache(kem, kem.prepare_private_key(keys.second));
+    std::vector<std::pair<ColorCiphertext, ColorValue>> encapsulations;
+    for (int i = 0; i < 16; ++i) {
+        encapsulations.push_back(kem.encapsulate(keys.first));
+    }
+    std::vector<std::thread> threads;
+    std::atomic<int> wrong{0};
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            KemWorkspace workspace;
+            for (int round = 0; round < 4; ++round) {
+                for (const auto& encapsulated : encapsulations) {
+                    if (cache.decapsulate(ColorCiphertextView(encapsulated.first), workspace) != encapsulated.second) {
+                        wrong.fetch_add(1);
+                    }
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(wrong.load(), 0);
+    EXPECT_EQ(cache.hits() + cache.misses(), 4u * 4u * 16u);
+    EXPECT_GE(cache.hits(), 3u * 4u * 16u);
+}
+
+// Test configuration, key and mode validation
+TEST_F(DecapsulationCacheTest, Validation) {
+    auto keys = kem.keygen();
+    PreparedPrivateKey prepared = kem.prepare_private_key(keys.second);
+    DecapsulationCacheConfig empty;
+    empty.capacity = 0;
+    EXPECT_THROW(DecapsulationCache(kem, prepared, empty), std::invalid_argument);
+    DecapsulationCacheConfig no_ttl;
+    no_ttl.ttl = std::chrono::milliseconds(0);
+    EXPECT_THROW(DecapsulationCache(kem, prepared, no_ttl), std::invalid_argument);
+
+    ColorKEM other{CLWEParameters(512)};
+    EXPECT_THROW(DecapsulationCache(other, prepared), std::invalid_argument);
+
+    DecapsulationCache cache(kem, prepared);
+    auto encapsulated = kem.encapsulate_key(keys.first);
+    EXPECT_THROW(cache.decapsulate_key(encapsulated.first), std::logic_error);
+}
+
+} // namespace clwe
@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+#include "clwe/decapsulation_context.hpp"
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <vector>
+
+namespace clwe {
+
+namespace {
+
+// Parameter sets covering both encodings, compression and a sparse c2
+std::vector<CLWEParameters> streaming_variants() {
+    std::vector<CLWEParameters> variants;
+    for (uint32_t level : {512u, 768u, 1024u}) {
+        variants.emplace_back(level);
+    }
+    CLWEParameters packed(768);
+    packed.encoding = CoefficientEncoding::PACKED12;
+    variants.push_back(packed);
+    CLWEParameters compressed(1024);
+    compressed.du = 11;
+    compressed.dv = 5;
+    variants.push_back(compressed);
+    CLWEParameters sparse(512);
+    sparse.sparse_c2 = true;
+    variants.push_back(sparse);
+    return variants;
+}
+
+} // namespace
+
+// Any split of the serialized ciphertext gives the one-shot result, accepted or rejected
+TEST(DecapsulationContextTest, MatchesOneShotForAnySegmentation) {
+    for (const CLWEParameters& params : streaming_variants()) {
+        ColorKEM kem(params);
+        auto keys = kem.keygen();
+        PreparedPrivateKey prepared = kem.prepare_private_key(keys.second);
+        DecapsulationContext context(kem, prepared);
+        EXPECT_EQ(context.ciphertext_size(), ColorCiphertext::serialized_size(params));
+
+        auto encapsulation = kem.encapsulate(keys.first);
+        // A wrong hint takes the implicit-rejection path
+        ColorCiphertext tampered = encapsulation.first;
+        tampered.shared_secret_hint[3] ^= 1;
+
+        for (const ColorCiphertext* ciphertext : {&encapsulation.first, &tampered}) {
+            const std::vector<uint8_t> wire = ciphertext->serialize();
+            const ColorValue expected = kem.decapsulate(prepared, *ciphertext);
+            for (size_t segment : {size_t{1}, size_t{7}, size_t{100}, size_t{1460}, wire.size()}) {
+                for (size_t offset = 0; offset < wire.size(); offset += segment) {
+                    EXPECT_FALSE(context.complete());
+                    context.feed(wire.data() + offset, std::min(segment, wire.size() - offset));
+                }
+                EXPECT_TRUE(context.complete());
+                EXPECT_EQ(context.finish(), expected) << "level " << params.security_level << ", segment " << segment;
+                EXPECT_EQ(context.bytes_received(), 0u);
+            }
+        }
+        EXPECT_EQ(kem.decapsulate(keys.first, keys.second, encapsulation.first), encapsulation.second);
+    }
+}
+
+TEST(DecapsulationContextTest, RejectsBadStreams) {
+    ColorKEM kem{CLWEParameters(512)};
+    auto keys = kem.keygen();
+    PreparedPrivateKey prepared = kem.prepare_private_key(keys.second);
+    DecapsulationContext context(kem, prepared);
+    auto encapsulation = kem.encapsulate(keys.first);
+    const std::vector<uint8_t> wire = encapsulation.first.serialize();
+
+    // A short stream fails and leaves the context ready for the next ciphertext
+    context.feed(wire.data(), wire.size() - 1);
+    EXPECT_THROW(context.finish(), std::invalid_argument);
+    EXPECT_EQ(context.bytes_received(), 0u);
+
+    context.feed(wire.data(), wire.size());
+    const uint8_t extra = 0;
+    EXPECT_THROW(context.feed(&extra, 1), std::invalid_argument);
+    EXPECT_EQ(context.finish(), encapsulation.second);
+
+    // reset() drops a partial ciphertext
+    context.feed(wire.data(), 100);
+    context.reset();
+    context.feed(wire.data(), wire.size());
+    EXPECT_EQ(context.finish(), encapsulation.second);
+
+    // Moved-to contexts keep working; moved-from ones refuse further use
+    DecapsulationContext moved(std::move(context));
+    moved.feed(wire.data(), wire.size());
+    EXPECT_EQ(moved.finish(), encapsulation.second);
+    EXPECT_THROW(context.feed(wire.data(), 1), std::logic_error);
+
+    ColorKEM other{CLWEParameters(768)};
+    EXPECT_THROW(DecapsulationContext(other, prepared), std::invalid_argument);
+    EXPECT_THROW(DecapsulationContext(kem, PreparedPrivateKey()), std::invalid_argument);
+}
+
+// Streamed encapsulation emits c1 row by row, then c2 and the hint, and a context consumes it
+TEST(DecapsulationContextTest, ConsumesStreamedEncapsulation) {
+    for (const CLWEParameters& params : streaming_variants()) {
+        for (bool streaming : {false, true}) {
+            ColorKEM kem(params);
+            kem.set_matrix_streaming(streaming);
+            auto keys = kem.keygen();
+            PreparedPrivateKey prepared = kem.prepare_private_key(keys.second);
+            DecapsulationContext context(kem, prepared);
+            std::array<uint8_t, 32> m;
+            m.fill(static_cast<uint8_t>(params.security_level));
+
+            std::vector<uint8_t> wire;
+            size_t pieces = 0;
+            KemWorkspace workspace;
+            ColorValue secret = kem.encapsulate_streamed(keys.first, m, [&](const uint8_t* data, size_t size) {
+                wire.insert(wire.end(), data, data + size);
+                context.feed(data, size);
+                ++pieces;
+            }, workspace);
+
+            auto reference = kem.encapsulate_derand(keys.first, m);
+            EXPECT_EQ(wire, reference.first.serialize()) << "level " << params.security_level;
+            EXPECT_EQ(secret, reference.second);
+            EXPECT_EQ(pieces, params.module_rank + 2u);
+            ASSERT_TRUE(context.complete());
+            EXPECT_EQ(context.finish(), secret);
+
+            ExpandedPublicKey expanded = kem.expand_public_key(keys.first);
+            std::vector<uint8_t> expanded_wire;
+            kem.encapsulate_streamed(expanded, m, [&](const uint8_t* data, size_t size) {
+                expanded_wire.insert(expanded_wire.end(), data, data + size);
+            }, workspace);
+            EXPECT_EQ(expanded_wire, wire);
+        }
+    }
+
+    ColorKEM kem{CLWEParameters(768)};
+    auto keys = kem.keygen();
+    std::vector<uint8_t> wire;
+    ColorValue secret = kem.encapsulate_streamed(keys.first, [&](const uint8_t* data, size_t size) {
+        wire.insert(wire.end(), data, data + size);
+    });
+    EXPECT_EQ(kem.decapsulate(keys.first, keys.second, ColorCiphertext::deserialize(wire, kem.params())), secret);
+}
+
+} // namespace clwe
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include "device_provisioning.hpp"
+#include "key_store.hpp"
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace clwe {
+
+class DeviceProvisioningTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path = ::testing::TempDir() + "clwe_device_provisioning_" +
+               ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".clks";
+        std::remove(path.c_str());
+        master.fill(0x3C);
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+
+    ColorKEM kem{CLWEParameters(768)};
+    std::array<uint8_t, 32> master{};
+    std::string path;
+};
+
+// Test that a device's keys depend only on the master seed, the device id and the parameters
+TEST_F(DeviceProvisioningTest, DerivationIsDeterministicAndSeparated) {
+    auto keys = kem.derive_keypair(master, 42);
+    auto again = kem.derive_keypair(master, 42);
+    EXPECT_EQ(keys.first.serialize(), again.first.serialize());
+    EXPECT_EQ(keys.second.secret_data, again.second.secret_data);
+    EXPECT_EQ(keys.first.serialize(), kem.keygen_derand(kem.derive_device_seed(master, 42)).first.serialize());
+
+    EXPECT_NE(kem.derive_device_seed(master, 43), kem.derive_device_seed(master, 42));
+    std::array<uint8_t, 32> other_master = master;
+    other_master[0] ^= 1;
+    EXPECT_NE(kem.derive_device_seed(other_master, 42), kem.derive_device_seed(master, 42));
+    ColorKEM other_level{CLWEParameters(512)};
+    EXPECT_NE(other_level.derive_device_seed(master, 42), kem.derive_device_seed(master, 42));
+
+    auto encapsulated = kem.encapsulate(keys.first);
+    EXPECT_EQ(kem.decapsulate(keys.first, keys.second, encapsulated.first), encapsulated.second);
+}
+
+// Test that the multi-lane batch, with its scalar tail, matches one-by-one derivation
+TEST_F(DeviceProvisioningTest, BatchMatchesSingleDerivation) {
+    for (size_t count : {0u, 3u, 4u, 11u}) {
+        auto batch = kem.derive_keypair_batch(master, 1000, count);
+        ASSERT_EQ(batch.size(), count);
+        for (size_t i = 0; i < count; ++i) {
+            auto single = kem.derive_keypair(master, 1000 + i);
+            EXPECT_EQ(batch[i].first.serialize(), single.first.serialize());
+            EXPECT_EQ(batch[i].second.secret_data, single.second.secret_data);
+        }
+    }
+    EXPECT_EQ(kem.derive_keypair_batch(master, UINT64_MAX, 1).size(), 1u);
+    EXPECT_THROW(kem.derive_keypair_batch(master, UINT64_MAX, 2), std::invalid_argument);
+}
+
+// Test that the driver writes every device's public key as its record and hands out private keys in order
+TEST_F(DeviceProvisioningTest, ProvisionsArchiveInDeviceOrder) {
+    ProvisioningConfig config;
+    config.worker_threads = 3;
+    config.batch_size = 5;
+    config.batches_in_flight = 2;
+    std::vector<uint64_t> ids;
+    std::vector<ColorPrivateKey> private_keys;
+    ProvisioningReport report = provision_devices(
+        kem, master, 500, 37, path,
+        [&](uint64_t device_id, const ColorPrivateKey& private_key) {
+            ids.push_back(device_id);
+            private_keys.push_back(private_key);
+        },
+        config);
+    EXPECT_EQ(report.devices, 37u);
+    EXPECT_GT(report.devices_per_second, 0.0);
+    ASSERT_EQ(ids.size(), 37u);
+
+    KeyStore store = KeyStore::open(path);
+    ASSERT_EQ(store.size(), 37u);
+    for (size_t i = 0; i < ids.size(); ++i) {
+        EXPECT_EQ(ids[i], 500 + i);
+        auto expected = kem.derive_keypair(master, 500 + i);
+        EXPECT_EQ(private_keys[i].secret_data, expected.second.secret_data);
+        EXPECT_EQ(store.find(expected.first.seed), i);
+    }
+    auto encapsulated = kem.encapsulate(store.key(36));
+    auto expected = kem.derive_keypair(master, 536);
+    EXPECT_EQ(kem.decapsulate(expected.first, private_keys[36], encapsulated.first), encapsulated.second);
+
+    // Without a sink, and with nothing to derive
+    EXPECT_EQ(provision_devices(kem, master, 0, 9, path).devices, 9u);
+    EXPECT_EQ(KeyStore::open(path).size(), 9u);
+    EXPECT_EQ(provision_devices(kem, master, 0, 0, path).devices, 0u);
+    EXPECT_EQ(KeyStore::open(path).size(), 0u);
+}
+
+// Test that a failing run keeps the previous file and leaves no temporary behind
+TEST_F(DeviceProvisioningTest, FailureKeepsPreviousFile) {
+    provision_devices(kem, master, 0, 4, path);
+    ProvisioningConfig config;
+    config.worker_threads = 2;
+    config.batch_size = 3;
+    EXPECT_THROW(provision_devices(kem, master, 0, 20, path,
+                                   [](uint64_t device_id, const ColorPrivateKey&) {
+                                       if (device_id == 7) {
+                                           throw std::runtime_error("burn station offline");
+                                       }
+                                   },
+                                   config),
+                 std::runtime_error);
+    EXPECT_EQ(KeyStore::open(path).size(), 4u);
+    EXPECT_FALSE(std::ifstream(path + ".tmp").good());
+
+    config.batch_size = 0;
+    EXPECT_THROW(provision_devices(kem, master, 0, 1, path, DevicePrivateKeySink(), config), std::invalid_argument);
+    EXPECT_THROW(provision_devices(kem, master, UINT64_MAX, 2, path), std::invalid_argument);
+}
+
+} // namespace clwe
@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+#include "encoding.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace clwe {
+
+class EncodingTest : public ::testing::Test {
+protected:
+    // Coefficients below 3329 with every 12-bit pattern class represented
+    static std::vector<ColorValue> make_coeffs(size_t count) {
+        std::vector<ColorValue> coeffs(count);
+        for (size_t i = 0; i < count; ++i) {
+            coeffs[i] = ColorValue::from_math_value(static_cast<uint32_t>((i * 1237 + 17) % 3329));
+        }
+        return coeffs;
+    }
+};
+
+// Test the FIPS 203 ByteEncode12 bit layout on a known pair
+TEST_F(EncodingTest, Packed12KnownVector) {
+    ColorValue coeffs[2] = {ColorValue::from_math_value(0x123), ColorValue::from_math_value(0x456)};
+    uint8_t out[3];
+    encode_coefficients(coeffs, 2, CoefficientEncoding::PACKED12, out);
+    EXPECT_EQ(out[0], 0x23);
+    EXPECT_EQ(out[1], 0x61);
+    EXPECT_EQ(out[2], 0x45);
+}
+
+// Test round trips across the vector kernel, its tail and odd counts
+TEST_F(EncodingTest, Packed12RoundTrip) {
+    for (size_t count : {1u, 2u, 7u, 15u, 16u, 17u, 33u, 512u, 768u}) {
+        std::vector<ColorValue> coeffs = make_coeffs(count);
+        std::vector<uint8_t> bytes(encoded_coefficients_size(count, CoefficientEncoding::PACKED12));
+        EXPECT_EQ(bytes.size(), count / 2 * 3 + (count % 2) * 2);
+        encode_coefficients(coeffs.data(), count, CoefficientEncoding::PACKED12, bytes.data());
+
+        // Byte-exact with a plain reference packing
+        for (size_t i = 0; i + 2 <= count; i += 2) {
+            uint32_t a = coeffs[i].to_math_value();
+            uint32_t b = coeffs[i + 1].to_math_value();
+            ASSERT_EQ(bytes[i / 2 * 3], static_cast<uint8_t>(a)) << "count " << count << " pair " << i;
+            ASSERT_EQ(bytes[i / 2 * 3 + 1], static_cast<uint8_t>((a >> 8) | (b << 4))) << "count " << count << " pair " << i;
+            ASSERT_EQ(bytes[i / 2 * 3 + 2], static_cast<uint8_t>(b >> 4)) << "count " << count << " pair " << i;
+        }
+
+        std::vector<ColorValue> decoded(count);
+        decode_coefficients(bytes.data(), count, CoefficientEncoding::PACKED12, decoded.data());
+        for (size_t i = 0; i < count; ++i) {
+            ASSERT_EQ(decoded[i], coeffs[i]) << "count " << count << " index " << i;
+        }
+    }
+}
+
+// Test that COLOR32 is the big-endian math value of every coefficient
+TEST_F(EncodingTest, Color32BigEndian) {
+    std::vector<ColorValue> coeffs = make_coeffs(5);
+    std::vector<uint8_t> bytes(encoded_coefficients_size(coeffs.size(), CoefficientEncoding::COLOR32));
+    ASSERT_EQ(bytes.size(), 20u);
+    encode_coefficients(coeffs.data(), coeffs.size(), CoefficientEncoding::COLOR32, bytes.data());
+
+    for (size_t i = 0; i < coeffs.size(); ++i) {
+        uint32_t value = coeffs[i].to_math_value();
+        EXPECT_EQ(bytes[4 * i], static_cast<uint8_t>(value >> 24));
+        EXPECT_EQ(bytes[4 * i + 1], static_cast<uint8_t>(value >> 16));
+        EXPECT_EQ(bytes[4 * i + 2], static_cast<uint8_t>(value >> 8));
+        EXPECT_EQ(bytes[4 * i + 3], static_cast<uint8_t>(value));
+    }
+
+    std::vector<ColorValue> decoded(coeffs.size());
+    decode_coefficients(bytes.data(), coeffs.size(), CoefficientEncoding::COLOR32, decoded.data());
+    EXPECT_EQ(decoded, coeffs);
+}
+
+// Test that Compress_d/Decompress_d stays within the FIPS 203 rounding bound
+TEST_F(EncodingTest, CompressionRoundTrip) {
+    const uint32_t q = 3329;
+    std::vector<ColorValue> coeffs(q);
+    for (uint32_t x = 0; x < q; ++x) {
+        coeffs[x] = ColorValue::from_math_value(x);
+    }
+
+    for (uint32_t bits : {1u, 4u, 5u, 10u, 11u}) {
+        std::vector<uint8_t> bytes(compressed_coefficients_size(q, bits));
+        EXPECT_EQ(bytes.size(), (q * bits + 7) / 8);
+        compress_encode_coefficients(coeffs.data(), q, bits, q, bytes.data());
+
+        std::vector<ColorValue> decoded(q);
+        decode_decompress_coefficients(bytes.data(), q, bits, q, decoded.data());
+
+        uint32_t bound = (q + (1u << (bits + 1)) - 1) >> (bits + 1);  // ceil(q / 2^(d+1))
+        for (uint32_t x = 0; x < q; ++x) {
+            uint32_t y = decoded[x].to_math_value();
+            ASSERT_LT(y, q);
+            uint32_t diff = (y + q - x) % q;
+            ASSERT_LE(std::min(diff, q - diff), bound) << "bits " << bits << " x " << x;
+        }
+    }
+}
+
+// Test that the fused modulus check catches one unreduced coefficient anywhere, in the
+// vector kernels and their scalar tails, for both encodings
+TEST_F(EncodingTest, CheckedDecodeRejectsUnreduced) {
+    const uint32_t q = 3329;
+    for (CoefficientEncoding encoding : {CoefficientEncoding::PACKED12, CoefficientEncoding::COLOR32}) {
+        for (size_t count : {1u, 7u, 16u, 17u, 33u, 512u}) {
+            std::vector<ColorValue> coeffs = make_coeffs(count);
+            std::vector<uint8_t> bytes(encoded_coefficients_size(count, encoding));
+            encode_coefficients(coeffs.data(), count, encoding, bytes.data());
+            std::vector<ColorValue> decoded(count);
+            ASSERT_TRUE(decode_coefficients_checked(bytes.data(), count, encoding, q, decoded.data()));
+            EXPECT_EQ(decoded, coeffs);
+            EXPECT_TRUE(coefficients_reduced(coeffs.data(), count, q));
+
+            for (size_t bad = 0; bad < count; bad += (count > 40 ? 37 : 1)) {
+                std::vector<ColorValue> unreduced = coeffs;
+                // q itself is the smallest value to reject; COLOR32 also sees values past 12 bits
+                uint32_t value = (encoding == CoefficientEncoding::COLOR32 && bad % 2) ? 0x80000000u : q;
+                unreduced[bad] = ColorValue::from_math_value(value);
+                encode_coefficients(unreduced.data(), count, encoding, bytes.data());
+                EXPECT_FALSE(decode_coefficients_checked(bytes.data(), count, encoding, q, decoded.data()))
+                    << "count " << count << " index " << bad;
+                EXPECT_EQ(decoded[bad].to_math_value(), value);
+                EXPECT_FALSE(coefficients_reduced(unreduced.data(), count, q)) << "count " << count << " index " << bad;
+            }
+        }
+    }
+
+    // q - 1 is the largest value accepted
+    std::vector<ColorValue> top(20, ColorValue::from_math_value(q - 1));
+    EXPECT_TRUE(coefficients_reduced(top.data(), top.size(), q));
+}
+
+} // namespace clwe
@@ -0,0 +1,220 @@
+#include <gtest/gtest.h>
+#include "hybrid_kem.hpp"
+#include "x25519.hpp"
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace clwe {
+
+class HybridKEMTest : public ::testing::Test {
+protected:
+    static std::vector<uint8_t> from_hex(const std::string& hex) {
+        std::vector<uint8_t> bytes(hex.size() / 2);
+        for (size_t i = 0; i < bytes.size(); ++i) {
+            bytes[i] = static_cast<uint8_t>(std::stoi(hex.substr(2 * i, 2), nullptr, 16));
+        }
+        return bytes;
+    }
+
+    // Executor that keeps jobs until the test runs them, or drops them
+    struct HeldExecutor {
+        std::mutex mutex;
+        std::deque<std::function<void()>> jobs;
+
+        AsyncKemPost post() {
+            return [this](std::function<void()> job) {
+                std::lock_guard<std::mutex> lock(mutex);
+                jobs.push_back(std::move(job));
+            };
+        }
+    };
+
+    CLWEParameters params{512};
+};
+
+// Test the scalar multiplication and Diffie-Hellman vectors of RFC 7748
+TEST_F(HybridKEMTest, X25519MatchesRFC7748) {
+    uint8_t out[X25519_BYTES];
+    auto scalar = from_hex("a546e36bf0527c9d3b16154b82465edd62144c0ac1fc5a18506a2244ba449ac4");
+    auto point = from_hex("e6db6867583030db3594c1a424b15f7c726624ec26b3353b10a903a6d0ab1c4c");
+    x25519(out, scalar.data(), point.data());
+    EXPECT_EQ(std::vector<uint8_t>(out, out + X25519_BYTES),
+              from_hex("c3da55379de9c6908e94ea4df28d084f32eccf03491c71f754b4075577a28552"));
+
+    // The top bit of the u-coordinate is ignored
+    scalar = from_hex("4b66e9d4d1b4673c5ad22691957d6af5c11b6421e0ea01d42ca4169e7918ba0d");
+    point = from_hex("e5210f12786811d3f4b7959d0538ae2c31dbe7106fc03c3efc4cd549c715a493");
+    x25519(out, scalar.data(), point.data());
+    EXPECT_EQ(std::vector<uint8_t>(out, out + X25519_BYTES),
+              from_hex("95cbde9476e8907d7aade45cb4b873f88b595a68799fa152e6f8f7647aac7957"));
+
+    auto alice = from_hex("77076d0a7318a57d3c16c17251b26645df4c2f87ebc0992ab177fba51db92c2a");
+    auto bob = from_hex("5dab087e624a8a4b79e17f8b83800ee66f3bb1292618b6fd1c2f8b27ff88e0eb");
+    uint8_t alice_public[X25519_BYTES], bob_public[X25519_BYTES], alice_shared[X25519_BYTES], bob_shared[X25519_BYTES];
+    x25519_base(alice_public, alice.data());
+    x25519_base(bob_public, bob.data());
+    EXPECT_EQ(std::vector<uint8_t>(alice_public, alice_public + X25519_BYTES),
+              from_hex("8520f0098930a754748b7ddcb43ef75a0dbf3a0d26381af4eba4a98eaa9b4e6a"));
+    EXPECT_EQ(std::vector<uint8_t>(bob_public, bob_public + X25519_BYTES),
+              from_hex("de9edb7d7b7dc1b4d35b61c2ece435373f8343c85b78674dadfc7e146f882b4f"));
+    x25519(alice_shared, alice.data(), bob_public);
+    x25519(bob_shared, bob.data(), alice_public);
+    EXPECT_EQ(std::vector<uint8_t>(alice_shared, alice_shared + X25519_BYTES),
+              from_hex("4a5d9d5ba4ce2de1728e3bf480350f25e07e21c947d19e3376f09b3c1e161742"));
+    EXPECT_EQ(0, std::memcmp(alice_shared, bob_shared, X25519_BYTES));
+}
+
+// Test the iterated vector of RFC 7748 section 5.2 (1000 iterations)
+TEST_F(HybridKEMTest, X25519IteratedVector) {
+    uint8_t k[X25519_BYTES] = {9};
+    uint8_t u[X25519_BYTES] = {9};
+    uint8_t out[X25519_BYTES];
+    for (int i = 0; i < 1000; ++i) {
+        x25519(out, k, u);
+        std::memcpy(u, k, X25519_BYTES);
+        std::memcpy(k, out, X25519_BYTES);
+        if (i == 0) {
+            EXPECT_EQ(std::vector<uint8_t>(k, k + X25519_BYTES),
+                      from_hex("422c8e7a6227d7bca1350b3e2bb7279f7897b87bb6854b783c60e80311ae3079"));
+        }
+    }
+    EXPECT_EQ(std::vector<uint8_t>(k, k + X25519_BYTES),
+              from_hex("684cf59ba83309552800ef566f2f4d3c1c3887c49360e3875f2eb94d99532c51"));
+}
+
+// Test a hybrid exchange at every security level on the internal lane thread
+TEST_F(HybridKEMTest, RoundTripAllLevels) {
+    for (uint32_t level : {512u, 768u, 1024u}) {
+        HybridKEM kem{CLWEParameters(level)};
+        auto [public_key, private_key] = kem.keygen();
+        EXPECT_EQ(public_key.x25519, private_key.x25519_public);
+
+        auto [ciphertext, shared_key] = kem.encapsulate(public_key);
+        EXPECT_EQ(kem.decapsulate(private_key, ciphertext), shared_key) << "level " << level;
+
+        auto [other_ciphertext, other_key] = kem.encapsulate(public_key);
+        EXPECT_NE(other_key, shared_key);
+        EXPECT_NE(other_ciphertext.x25519, ciphertext.x25519);
+    }
+}
+
+// Test that each type round-trips through its single serialized form
+TEST_F(HybridKEMTest, SerializationRoundTrip) {
+    HybridKEM kem(params);
+    auto [public_key, private_key] = kem.keygen();
+    auto [ciphertext, shared_key] = kem.encapsulate(public_key);
+
+    std::vector<uint8_t> public_bytes = public_key.serialize();
+    std::vector<uint8_t> private_bytes = private_key.serialize();
+    std::vector<uint8_t> ciphertext_bytes = ciphertext.serialize();
+    EXPECT_EQ(public_bytes.size(), HybridPublicKey::serialized_size(params));
+    EXPECT_EQ(public_bytes.size(), 32 + ColorPublicKey::serialized_size(params));
+    EXPECT_EQ(private_bytes.size(), HybridPrivateKey::serialized_size(params));
+    EXPECT_EQ(ciphertext_bytes.size(), HybridCiphertext::serialized_size(params));
+    EXPECT_EQ(ciphertext_bytes.size(), 32 + ColorCiphertext::serialized_size(params));
+    EXPECT_TRUE(std::equal(public_key.x25519.begin(), public_key.x25519.end(), public_bytes.begin()));
+
+    HybridPublicKey parsed_public = HybridPublicKey::deserialize(public_bytes, params);
+    HybridPrivateKey parsed_private = HybridPrivateKey::deserialize(private_bytes, params);
+    HybridCiphertext parsed_ciphertext = HybridCiphertext::deserialize(ciphertext_bytes, params);
+    EXPECT_EQ(parsed_public.serialize(), public_bytes);
+    EXPECT_EQ(parsed_private.serialize(), private_bytes);
+    EXPECT_EQ(kem.decapsulate(parsed_private, parsed_ciphertext), shared_key);
+
+    auto [second_ciphertext, second_key] = kem.encapsulate(parsed_public);
+    EXPECT_EQ(kem.decapsulate(private_key, second_ciphertext), second_key);
+
+    EXPECT_THROW(HybridPublicKey::deserialize(public_bytes.data(), public_bytes.size() - 1, params),
+                 std::invalid_argument);
+    EXPECT_THROW(HybridCiphertext::deserialize(ciphertext_bytes.data(), ciphertext_bytes.size() - 1, params),
+                 std::invalid_argument);
+    std::vector<uint8_t> small(8);
+    EXPECT_THROW(public_key.serialize(small.data(), small.size()), std::invalid_argument);
+
+    // The embedded X25519 public key must belong to the scalar
+    private_bytes[40] ^= 1;
+    EXPECT_THROW(HybridPrivateKey::deserialize(private_bytes, params), std::invalid_argument);
+}
+
+// Test that changing either half of the ciphertext changes the decapsulated key
+TEST_F(HybridKEMTest, TamperedCiphertextChangesKey) {
+    HybridKEM kem(params);
+    auto [public_key, private_key] = kem.keygen();
+    auto [ciphertext, shared_key] = kem.encapsulate(public_key);
+
+    HybridCiphertext classical = ciphertext;
+    classical.x25519[5] ^= 0x10;
+    EXPECT_NE(kem.decapsulate(private_key, classical), shared_key);
+
+    HybridCiphertext lattice = ciphertext;
+    lattice.color.ciphertext_data[3] ^= 0x01;
+    EXPECT_NE(kem.decapsulate(private_key, lattice), shared_key);
+
+    EXPECT_EQ(kem.decapsulate(private_key, ciphertext), shared_key);
+}
+
+// Test that small-order X25519 points are rejected instead of giving a zero secret
+TEST_F(HybridKEMTest, RejectsSmallOrderX25519Keys) {
+    HybridKEM kem(params);
+    auto [public_key, private_key] = kem.keygen();
+
+    HybridPublicKey identity = public_key;
+    identity.x25519.fill(0);
+    EXPECT_THROW(kem.encapsulate(identity), std::invalid_argument);
+
+    auto [ciphertext, shared_key] = kem.encapsulate(public_key);
+    ciphertext.x25519.fill(0);
+    ciphertext.x25519[0] = 1;
+    EXPECT_THROW(kem.decapsulate(private_key, ciphertext), std::invalid_argument);
+}
+
+// Test that every operation hands its X25519 lane to a caller-supplied executor
+TEST_F(HybridKEMTest, PostsClassicalLaneToExecutor) {
+    std::vector<std::thread> threads;
+    AsyncKemPost post = [&threads](std::function<void()> job) { threads.emplace_back(std::move(job)); };
+
+    {
+        HybridKEM kem(params, post);
+        auto [public_key, private_key] = kem.keygen();
+        auto [ciphertext, shared_key] = kem.encapsulate(public_key);
+        EXPECT_EQ(kem.decapsulate(private_key, ciphertext), shared_key);
+    }
+    EXPECT_EQ(threads.size(), 3u);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+// Test that lanes an executor never starts run on the calling thread instead
+TEST_F(HybridKEMTest, RunsUnstartedLaneInline) {
+    HeldExecutor executor;
+    HybridKEM kem(params, executor.post());
+    auto [public_key, private_key] = kem.keygen();
+    auto [ciphertext, shared_key] = kem.encapsulate(public_key);
+    EXPECT_EQ(kem.decapsulate(private_key, ciphertext), shared_key);
+
+    // Jobs that start late find their lanes done and return without touching them
+    EXPECT_EQ(executor.jobs.size(), 3u);
+    for (auto& job : executor.jobs) {
+        job();
+    }
+
+    HybridKEM refusing(params, [](std::function<void()>) { throw std::runtime_error("pool stopped"); });
+    auto [refused_ciphertext, refused_key] = refusing.encapsulate(public_key);
+    EXPECT_EQ(kem.decapsulate(private_key, refused_ciphertext), refused_key);
+}
+
+// Test that parameter sets without the 256-bit key mode are rejected
+TEST_F(HybridKEMTest, RejectsParametersWithoutKeyMode) {
+    CLWEParameters sparse(512);
+    sparse.sparse_c2 = true;
+    EXPECT_THROW(HybridKEM kem(sparse), std::invalid_argument);
+}
+
+} // namespace clwe
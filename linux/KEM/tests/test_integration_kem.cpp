@@ -219,6 +219,46 @@ TEST_F(ColorKEMIntegrationTest, ConcurrentKeyExchange) {
     SUCCEED();
 }
 
+// Workers sharing one const instance, each reusing its own workspace
+TEST_F(ColorKEMIntegrationTest, ConcurrentWorkspaces) {
+    const ColorKEM kem(CLWEParameters(768));
+    auto [pk, sk] = kem.keygen();
+    const ExpandedPublicKey expanded = kem.expand_public_key(pk);
+    const PreparedPrivateKey prepared = kem.prepare_private_key(sk);
+
+    const int num_threads = 4;
+    const int operations_per_thread = 25;
+    std::vector<int> mismatches(num_threads, 0);
+
+    auto worker = [&](int id) {
+        KemWorkspace workspace;
+        ColorCiphertext ciphertext;
+        std::array<uint8_t, 32> m{};
+        m[0] = static_cast<uint8_t>(id);
+        for (int i = 0; i < operations_per_thread; ++i) {
+            m[1] = static_cast<uint8_t>(i);
+            ColorValue secret = kem.encapsulate_into(expanded, m, ciphertext, workspace);
+            if (kem.decapsulate(prepared, ciphertext, workspace) != secret ||
+                kem.decapsulate(pk, sk, ciphertext) != secret) {
+                ++mismatches[id];
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; ++i) {
+        threads.emplace_back(worker, i);
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    for (int i = 0; i < num_threads; ++i) {
+        EXPECT_EQ(mismatches[i], 0) << "thread " << i;
+    }
+}
+
 // Test serialization round-trip in workflows
 TEST_F(ColorKEMIntegrationTest, SerializationWorkflow) {
     for (uint32_t sec_level : security_levels_) {
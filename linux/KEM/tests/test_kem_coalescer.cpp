@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include "kem_coalescer.hpp"
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace clwe {
+
+class KemCoalescerTest : public ::testing::Test {
+protected:
+    CLWEParameters params{512};
+    ColorKEM kem{params};
+};
+
+// Test that coalesced encapsulations and decapsulations match the direct calls
+TEST_F(KemCoalescerTest, RoundTrip) {
+    KemCoalescer coalescer(kem);
+    auto [public_key, private_key] = kem.keygen();
+
+    std::vector<std::future<std::pair<ColorCiphertext, ColorValue>>> encapsulations;
+    for (int i = 0; i < 12; ++i) {
+        encapsulations.push_back(coalescer.encapsulate(public_key));
+    }
+    std::vector<std::pair<ColorCiphertext, ColorValue>> results;
+    std::vector<std::future<ColorValue>> secrets;
+    for (auto& future : encapsulations) {
+        results.push_back(future.get());
+        secrets.push_back(coalescer.decapsulate(public_key, private_key, results.back().first));
+    }
+    for (size_t i = 0; i < secrets.size(); ++i) {
+        ColorValue secret = secrets[i].get();
+        EXPECT_EQ(secret, results[i].second);
+        EXPECT_EQ(secret, kem.decapsulate(public_key, private_key, results[i].first));
+    }
+    EXPECT_EQ(coalescer.requests(), 24u);
+}
+
+// Test that a request reaching an idle coalescer does not wait for the window
+TEST_F(KemCoalescerTest, IdleRequestSkipsWindow) {
+    KemCoalescerConfig config;
+    config.window = std::chrono::seconds(30);
+    KemCoalescer coalescer(kem, config);
+    auto [public_key, private_key] = kem.keygen();
+
+    for (int i = 0; i < 3; ++i) {
+        auto future = coalescer.encapsulate(public_key);
+        ASSERT_EQ(future.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+        auto [ciphertext, secret] = future.get();
+        EXPECT_EQ(kem.decapsulate(public_key, private_key, ciphertext), secret);
+    }
+    EXPECT_EQ(coalescer.batches(), 3u);
+}
+
+// Test that requests arriving together from many threads share batches
+TEST_F(KemCoalescerTest, CoalescesUnderLoad) {
+    KemCoalescerConfig config;
+    config.max_batch = 8;
+    config.window = std::chrono::milliseconds(20);
+    KemCoalescer coalescer(kem, config);
+    auto [public_key, private_key] = kem.keygen();
+
+    std::vector<std::future<std::pair<ColorCiphertext, ColorValue>>> futures;
+    futures.push_back(coalescer.encapsulate(public_key));
+    futures.front().wait();
+    std::vector<std::thread> threads;
+    std::vector<std::future<std::pair<ColorCiphertext, ColorValue>>> queued(2 * config.max_batch);
+    for (size_t t = 0; t < queued.size(); ++t) {
+        threads.emplace_back([&, t] { queued[t] = coalescer.encapsulate(public_key); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (auto& future : queued) {
+        ASSERT_EQ(future.wait_for(std::chrono::seconds(20)), std::future_status::ready);
+        auto [ciphertext, secret] = future.get();
+        EXPECT_EQ(kem.decapsulate(public_key, private_key, ciphertext), secret);
+    }
+    EXPECT_EQ(coalescer.requests(), 1 + queued.size());
+    EXPECT_LT(coalescer.batches(), coalescer.requests());
+}
+
+// Test that an invalid input fails only its own future
+TEST_F(KemCoalescerTest, InvalidRequestFailsAlone) {
+    KemCoalescer coalescer(kem);
+    auto [public_key, private_key] = kem.keygen();
+    ColorPublicKey broken = public_key;
+    broken.public_data.resize(4);
+
+    auto good = coalescer.encapsulate(public_key);
+    auto bad = coalescer.encapsulate(broken);
+    auto also_good = coalescer.encapsulate(public_key);
+    EXPECT_THROW(bad.get(), std::invalid_argument);
+    auto first = good.get();
+    auto second = also_good.get();
+    EXPECT_EQ(kem.decapsulate(public_key, private_key, first.first), first.second);
+
+    ColorCiphertext truncated = second.first;
+    truncated.ciphertext_data.resize(3);
+    auto bad_secret = coalescer.decapsulate(public_key, private_key, truncated);
+    auto good_secret = coalescer.decapsulate(public_key, private_key, second.first);
+    EXPECT_THROW(bad_secret.get(), std::invalid_argument);
+    EXPECT_EQ(good_secret.get(), second.second);
+
+    KemCoalescerConfig zero;
+    zero.max_batch = 0;
+    EXPECT_THROW(KemCoalescer(kem, zero), std::invalid_argument);
+}
+
+// Test that destruction completes the requests still queued
+TEST_F(KemCoalescerTest, DestructorRunsQueuedRequests) {
+    auto [public_key, private_key] = kem.keygen();
+    std::vector<std::future<std::pair<ColorCiphertext, ColorValue>>> futures;
+    {
+        KemCoalescerConfig config;
+        config.window = std::chrono::seconds(30);
+        KemCoalescer coalescer(kem, config);
+        for (int i = 0; i < 10; ++i) {
+            futures.push_back(coalescer.encapsulate(public_key));
+        }
+    }
+    for (auto& future : futures) {
+        ASSERT_EQ(future.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+        auto [ciphertext, secret] = future.get();
+        EXPECT_EQ(kem.decapsulate(public_key, private_key, ciphertext), secret);
+    }
+}
+
+} // namespace clwe
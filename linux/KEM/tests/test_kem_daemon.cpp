@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+#include "clwe/kem_daemon.hpp"
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace clwe {
+
+namespace {
+
+std::string test_socket_path(const char* name) {
+    return "/tmp/clwe-kemd-" + std::string(name) + "-" + std::to_string(getpid()) + ".sock";
+}
+
+// A daemon serving on its own thread for the lifetime of the fixture
+class KemDaemonTest : public ::testing::Test {
+protected:
+    std::unique_ptr<KemDaemon> daemon;
+    std::thread server;
+
+    void start(KemDaemonConfig config = KemDaemonConfig()) {
+        if (config.socket_path == KemDaemonConfig().socket_path) {
+            config.socket_path =
+                test_socket_path(::testing::UnitTest::GetInstance()->current_test_info()->name());
+        }
+        daemon.reset(new KemDaemon(config));
+        server = std::thread([this] { daemon->run(); });
+    }
+
+    void stop() {
+        if (server.joinable()) {
+            daemon->stop();
+            server.join();
+        }
+    }
+
+    void TearDown() override {
+        stop();
+        daemon.reset();
+    }
+};
+
+} // namespace
+
+TEST_F(KemDaemonTest, RoundTripPerLevel) {
+    start();
+    for (uint32_t level : {512u, 768u, 1024u}) {
+        ColorKEM local{CLWEParameters(level)};
+        KemClient client(daemon->socket_path(), level);
+        EXPECT_EQ(client.ring_slots(), KemDaemonConfig().ring_slots);
+        auto keys = local.keygen();
+
+        auto encapsulation = client.encapsulate(keys.first);
+        EXPECT_EQ(local.decapsulate(keys.first, keys.second, encapsulation.first), encapsulation.second);
+
+        auto local_encapsulation = local.encapsulate(keys.first);
+        EXPECT_EQ(client.decapsulate(keys.first, keys.second, local_encapsulation.first),
+                  local_encapsulation.second);
+    }
+    EXPECT_EQ(daemon->requests_served(), 6u);
+}
+
+// Tickets from several clients and threads are batched together and each gets its own answer
+TEST_F(KemDaemonTest, PipelinedRequestsFromManyClients) {
+    KemDaemonConfig config;
+    config.max_batch = 5;
+    start(config);
+    ColorKEM local{CLWEParameters(768)};
+    auto keys = local.keygen();
+    auto other_keys = local.keygen();
+
+    std::vector<std::thread> threads;
+    std::vector<int> failures(4, 0);
+    for (size_t t = 0; t < failures.size(); ++t) {
+        threads.emplace_back([&, t] {
+            KemClient client(daemon->socket_path(), 768, 8);
+            for (int round = 0; round < 5; ++round) {
+                std::vector<KemClient::Ticket> tickets;
+                for (size_t i = 0; i < client.ring_slots(); ++i) {
+                    tickets.push_back(client.submit_encapsulate(i % 2 ? keys.first : other_keys.first));
+                }
+                for (size_t i = 0; i < tickets.size(); ++i) {
+                    auto encapsulation = client.wait_encapsulate(tickets[i]);
+                    const auto& pair = i % 2 ? keys : other_keys;
+                    if (client.decapsulate(pair.first, pair.second, encapsulation.first) != encapsulation.second) {
+                        ++failures[t];
+                    }
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (int failed : failures) {
+        EXPECT_EQ(failed, 0);
+    }
+    EXPECT_EQ(daemon->requests_served(), 4u * 5 * 8 * 2);
+}
+
+// One malformed key fails only its own request in a batch
+TEST_F(KemDaemonTest, InvalidRequestFailsAlone) {
+    start();
+    ColorKEM local{CLWEParameters(512)};
+    auto keys = local.keygen();
+    ColorPublicKey corrupt = keys.first;
+    corrupt.public_data.resize(corrupt.public_data.size() - 4);
+
+    KemClient client(daemon->socket_path(), 512);
+    KemClient::Ticket before = client.submit_encapsulate(keys.first);
+    KemClient::Ticket bad = client.submit_encapsulate(corrupt);
+    KemClient::Ticket after = client.submit_encapsulate(keys.first);
+    EXPECT_NO_THROW(client.wait_encapsulate(before));
+    EXPECT_THROW(client.wait_encapsulate(bad), std::invalid_argument);
+    auto encapsulation = client.wait_encapsulate(after);
+    EXPECT_EQ(local.decapsulate(keys.first, keys.second, encapsulation.first), encapsulation.second);
+
+    // Mismatched parameters are caught before anything is sent; stale tickets are rejected
+    ColorKEM other{CLWEParameters(768)};
+    EXPECT_THROW(client.submit_encapsulate(other.keygen().first), std::invalid_argument);
+    EXPECT_THROW(client.wait_encapsulate(bad), std::logic_error);
+    EXPECT_THROW(client.wait_decapsulate(client.submit_encapsulate(keys.first)), std::logic_error);
+}
+
+TEST_F(KemDaemonTest, RefusesBadConnections) {
+    KemDaemonConfig config;
+    config.max_ring_slots = 16;
+    config.max_clients = 2;
+    start(config);
+    EXPECT_THROW(KemClient(daemon->socket_path(), 999), std::runtime_error);
+    EXPECT_THROW(KemClient(daemon->socket_path(), 512, 17), std::runtime_error);
+    EXPECT_THROW(KemClient("/tmp/clwe-kemd-no-such-socket", 512), std::runtime_error);
+
+    {
+        KemClient first(daemon->socket_path(), 512, 5);
+        EXPECT_EQ(first.ring_slots(), 8u);
+        KemClient second(daemon->socket_path(), 512);
+        EXPECT_EQ(daemon->client_count(), 2u);
+        EXPECT_THROW(KemClient(daemon->socket_path(), 512), std::runtime_error);
+    }
+    // Closed clients are dropped and their places reused
+    for (int attempt = 0; attempt < 100 && daemon->client_count() != 0; ++attempt) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(daemon->client_count(), 0u);
+    EXPECT_NO_THROW(KemClient(daemon->socket_path(), 512));
+
+    KemDaemonConfig empty;
+    empty.max_batch = 0;
+    EXPECT_THROW(KemDaemon{empty}, std::invalid_argument);
+}
+
+TEST_F(KemDaemonTest, WaitDetectsDaemonExit) {
+    start();
+    ColorKEM local{CLWEParameters(512)};
+    auto keys = local.keygen();
+    KemClient client(daemon->socket_path(), 512);
+    stop();
+    KemClient::Ticket ticket = client.submit_encapsulate(keys.first);
+    daemon.reset();
+    EXPECT_THROW(client.wait_encapsulate(ticket), std::runtime_error);
+}
+
+// The rings are shared across processes: a forked client is served like a local one
+TEST_F(KemDaemonTest, ServesOtherProcesses) {
+    start();
+    ColorKEM local{CLWEParameters(512)};
+    auto keys = local.keygen();
+    const std::string path = daemon->socket_path();
+
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        int status = 1;
+        try {
+            KemClient client(path, 512);
+            auto encapsulation = client.encapsulate(keys.first);
+            status = client.decapsulate(keys.first, keys.second, encapsulation.first) == encapsulation.second ? 0 : 3;
+        } catch (...) {
+            status = 2;
+        }
+        _exit(status);
+    }
+    int status = 0;
+    ASSERT_EQ(waitpid(child, &status, 0), child);
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+}
+
+} // namespace clwe
@@ -0,0 +1,200 @@
+#include <gtest/gtest.h>
+#include "clwe/kem_pipeline.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace clwe {
+
+namespace {
+
+// Responses collected by id from the serialize threads
+class Collector {
+public:
+    KemPipelineCallback callback() {
+        return [this](KemPipelineResponse&& response) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            responses_[response.id] = std::move(response);
+            cv_.notify_all();
+        };
+    }
+
+    std::map<uint64_t, KemPipelineResponse> wait_for(size_t count) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        EXPECT_TRUE(cv_.wait_for(lock, std::chrono::seconds(30), [&] { return responses_.size() >= count; }));
+        return std::move(responses_);
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::map<uint64_t, KemPipelineResponse> responses_;
+};
+
+KemPipelineRequest request(uint64_t id, KemPipelineOp op, std::vector<uint8_t> payload,
+                           const std::array<uint8_t, 32>& private_key = {}) {
+    KemPipelineRequest result;
+    result.id = id;
+    result.op = op;
+    result.payload = std::move(payload);
+    result.private_key = private_key;
+    return result;
+}
+
+} // namespace
+
+class KemPipelineTest : public ::testing::Test {
+protected:
+    CLWEParameters params{768};
+    ColorKEM kem{params};
+};
+
+// Test that pipelined encapsulations decapsulate to their secrets through the pipeline and directly
+TEST_F(KemPipelineTest, RoundTrip) {
+    auto [server_public, server_private] = kem.keygen();
+    auto [other_public, other_private] = kem.keygen();
+    Collector collector;
+    KemPipelineConfig config;
+    config.compute_threads = 3;
+    config.max_batch = 4;
+    KemPipeline pipeline(kem, config, collector.callback());
+    pipeline.add_private_key(server_public.fingerprint(), server_private);
+
+    const size_t count = 40;
+    for (uint64_t id = 0; id < count; ++id) {
+        const ColorPublicKey& key = id % 4 == 3 ? other_public : server_public;
+        pipeline.submit(request(id, KemPipelineOp::ENCAPSULATE, key.serialize()));
+    }
+    std::map<uint64_t, KemPipelineResponse> encapsulated = collector.wait_for(count);
+    ASSERT_EQ(encapsulated.size(), count);
+
+    for (const auto& entry : encapsulated) {
+        const KemPipelineResponse& response = entry.second;
+        ASSERT_EQ(response.error, CLWEError::SUCCESS);
+        EXPECT_EQ(response.op, KemPipelineOp::ENCAPSULATE);
+        ColorCiphertext ciphertext = ColorCiphertext::deserialize(response.ciphertext, params);
+        if (entry.first % 4 == 3) {
+            EXPECT_EQ(kem.decapsulate(other_public, other_private, ciphertext), response.shared_secret);
+            continue;
+        }
+        pipeline.submit(request(entry.first, KemPipelineOp::DECAPSULATE, response.ciphertext,
+                                server_public.fingerprint()));
+    }
+    std::map<uint64_t, KemPipelineResponse> decapsulated = collector.wait_for(30);
+    ASSERT_EQ(decapsulated.size(), 30u);
+    for (const auto& entry : decapsulated) {
+        EXPECT_EQ(entry.second.error, CLWEError::SUCCESS);
+        EXPECT_EQ(entry.second.op, KemPipelineOp::DECAPSULATE);
+        EXPECT_EQ(entry.second.shared_secret, encapsulated[entry.first].shared_secret);
+    }
+
+    EXPECT_EQ(pipeline.submitted(), 70u);
+    EXPECT_EQ(pipeline.completed(), 70u);
+    auto stats = pipeline.stats();
+    for (const KemPipelineStageStats& stage : stats) {
+        EXPECT_EQ(stage.processed, 70u);
+        EXPECT_EQ(stage.queue_depth, 0u);
+        EXPECT_EQ(stage.queue_capacity, 1024u);
+        EXPECT_GT(stage.mean_service_us, 0.0);
+        EXPECT_LE(stage.utilization, 1.0);
+    }
+    EXPECT_EQ(stats[static_cast<size_t>(KemPipelineStage::COMPUTE)].threads, 3u);
+}
+
+// Test that each failure reaches the callback with its code and skips the later stages
+TEST_F(KemPipelineTest, Errors) {
+    auto [public_key, private_key] = kem.keygen();
+    auto [ciphertext, secret] = kem.encapsulate(public_key);
+    Collector collector;
+    KemPipeline pipeline(kem, KemPipelineConfig(), collector.callback());
+    pipeline.add_private_key(public_key.fingerprint(), private_key);
+
+    std::vector<uint8_t> truncated = public_key.serialize();
+    truncated.pop_back();
+    pipeline.submit(request(1, KemPipelineOp::ENCAPSULATE, truncated));
+    pipeline.submit(request(2, KemPipelineOp::DECAPSULATE, std::vector<uint8_t>(7, 0), public_key.fingerprint()));
+    pipeline.submit(request(3, KemPipelineOp::DECAPSULATE, ciphertext.serialize()));
+    pipeline.submit(request(4, KemPipelineOp::DECAPSULATE, ciphertext.serialize(), public_key.fingerprint()));
+    std::map<uint64_t, KemPipelineResponse> responses = collector.wait_for(4);
+    EXPECT_EQ(responses[1].error, CLWEError::INVALID_KEY);
+    EXPECT_TRUE(responses[1].ciphertext.empty());
+    EXPECT_EQ(responses[2].error, CLWEError::INVALID_CIPHERTEXT);
+    EXPECT_EQ(responses[3].error, CLWEError::INVALID_KEY);
+    EXPECT_EQ(responses[4].error, CLWEError::SUCCESS);
+    EXPECT_EQ(responses[4].shared_secret, secret);
+
+    EXPECT_TRUE(pipeline.remove_private_key(public_key.fingerprint()));
+    EXPECT_FALSE(pipeline.remove_private_key(public_key.fingerprint()));
+    pipeline.submit(request(5, KemPipelineOp::DECAPSULATE, ciphertext.serialize(), public_key.fingerprint()));
+    EXPECT_EQ(collector.wait_for(1)[5].error, CLWEError::INVALID_KEY);
+    auto stats = pipeline.stats();
+    EXPECT_EQ(stats[static_cast<size_t>(KemPipelineStage::PARSE)].processed, 5u);
+    EXPECT_EQ(stats[static_cast<size_t>(KemPipelineStage::COMPUTE)].processed, 1u);
+    EXPECT_EQ(stats[static_cast<size_t>(KemPipelineStage::SERIALIZE)].processed, 5u);
+}
+
+// Test that a stalled stage fills the queues back to try_submit, and that the destructor drains them
+TEST_F(KemPipelineTest, BackpressureAndDrain) {
+    auto [public_key, private_key] = kem.keygen();
+    std::atomic<bool> released{false};
+    std::atomic<uint64_t> responses{0};
+    uint64_t responses_expected = 0;
+    KemPipelineConfig config;
+    config.queue_capacity = 2;
+    {
+        KemPipeline pipeline(kem, config, [&](KemPipelineResponse&& response) {
+            while (!released.load()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            EXPECT_EQ(response.error, CLWEError::SUCCESS);
+            responses.fetch_add(1);
+        });
+        const std::vector<uint8_t> key_bytes = public_key.serialize();
+        uint64_t accepted = 0;
+        KemPipelineRequest next = request(0, KemPipelineOp::ENCAPSULATE, key_bytes);
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (pipeline.try_submit(next) && std::chrono::steady_clock::now() < deadline) {
+            ++accepted;
+            next = request(accepted, KemPipelineOp::ENCAPSULATE, key_bytes);
+        }
+        // A refused request keeps its payload
+        EXPECT_EQ(next.payload, key_bytes);
+        // Four queues of two, plus what the stage threads hold: one each, two for the compute batch
+        EXPECT_LE(accepted, 4u * 2u + 5u);
+        EXPECT_EQ(pipeline.stats()[static_cast<size_t>(KemPipelineStage::PARSE)].queue_depth, 2u);
+        for (const KemPipelineStageStats& stage : pipeline.stats()) {
+            EXPECT_LE(stage.max_queue_depth, 2u);
+        }
+        EXPECT_EQ(pipeline.submitted(), accepted);
+        released = true;
+        pipeline.submit(request(accepted, KemPipelineOp::ENCAPSULATE, key_bytes));
+        accepted += 1;
+        EXPECT_EQ(pipeline.submitted(), accepted);
+        responses_expected = accepted;
+    }
+    EXPECT_EQ(responses.load(), responses_expected);
+}
+
+// Test configuration and key validation
+TEST_F(KemPipelineTest, InvalidConfiguration) {
+    auto callback = [](KemPipelineResponse&&) {};
+    KemPipelineConfig no_compute;
+    no_compute.compute_threads = 0;
+    EXPECT_THROW(KemPipeline(kem, no_compute, callback), std::invalid_argument);
+    KemPipelineConfig no_batch;
+    no_batch.max_batch = 0;
+    EXPECT_THROW(KemPipeline(kem, no_batch, callback), std::invalid_argument);
+    EXPECT_THROW(KemPipeline(kem, KemPipelineConfig(), nullptr), std::invalid_argument);
+
+    KemPipeline pipeline(kem, KemPipelineConfig(), callback);
+    ColorKEM other{CLWEParameters(512)};
+    auto keys = other.keygen();
+    EXPECT_THROW(pipeline.add_private_key(keys.first.fingerprint(), keys.second), std::invalid_argument);
+}
+
+} // namespace clwe
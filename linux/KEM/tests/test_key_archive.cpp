@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include "key_archive.hpp"
+#include "key_store.hpp"
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace clwe {
+
+class KeyArchiveTest : public ::testing::TestWithParam<BulkIoBackend> {
+protected:
+    void SetUp() override {
+        std::string name = ::testing::UnitTest::GetInstance()->current_test_info()->name();
+        for (char& c : name) {
+            if (c == '/') {
+                c = '_';
+            }
+        }
+        path = ::testing::TempDir() + "clwe_key_archive_" + name + ".clks";
+        std::remove(path.c_str());
+        options.backend = GetParam();
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+
+    // Skips the test where the kernel refuses io_uring
+    bool backend_available() {
+        try {
+            KeyArchiveWriter probe(path, params, options);
+        } catch (const std::runtime_error&) {
+            return false;
+        }
+        return true;
+    }
+
+    std::vector<ColorPublicKey> make_keys(const CLWEParameters& key_params, size_t count) {
+        ColorKEM kem(key_params);
+        std::vector<ColorPublicKey> keys;
+        for (auto& pair : kem.keygen_batch(count)) {
+            keys.push_back(pair.first);
+        }
+        return keys;
+    }
+
+    CLWEParameters params{512};
+    KeyArchiveOptions options;
+    std::string path;
+};
+
+// Test that keys written through small, few buffers come back identical and in order
+TEST_P(KeyArchiveTest, WriteReadRoundTrip) {
+    if (!backend_available()) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    auto keys = make_keys(params, 9);
+    keys.push_back(keys[3]);  // Duplicate seeds are allowed
+    options.buffer_bytes = 2 * KeyStore::record_bytes(params) + 100;
+    options.buffer_count = 3;
+    options.submit_batch = 2;
+
+    KeyArchiveWriter writer(path, params, options);
+    EXPECT_EQ(writer.backend(), GetParam());
+    for (const ColorPublicKey& key : keys) {
+        writer.append(key);
+    }
+    EXPECT_EQ(writer.size(), keys.size());
+    writer.finish();
+    EXPECT_THROW(writer.append(keys[0]), std::logic_error);
+    EXPECT_FALSE(std::ifstream(path + ".tmp").good());
+
+    KeyArchiveReader reader(path, options);
+    EXPECT_EQ(reader.backend(), GetParam());
+    ASSERT_EQ(reader.size(), keys.size());
+    EXPECT_EQ(reader.params().security_level, params.security_level);
+    ColorPublicKey key;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        ASSERT_TRUE(reader.next(key));
+        EXPECT_EQ(key.seed, keys[i].seed);
+        EXPECT_EQ(key.public_data, keys[i].public_data);
+        EXPECT_EQ(key.params.encoding, params.encoding);
+    }
+    EXPECT_FALSE(reader.next(key));
+
+    // The output is an ordinary key store
+    KeyStore store = KeyStore::open(path);
+    ASSERT_EQ(store.size(), keys.size());
+    EXPECT_EQ(store.find(keys[5].seed), 5u);
+    EXPECT_EQ(store.find(keys[3].seed), 3u);
+}
+
+// Test that buffers smaller than a record are enlarged and batched reads stop at the end
+TEST_P(KeyArchiveTest, TinyBuffersAndBatchedReads) {
+    if (!backend_available()) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    auto keys = make_keys(CLWEParameters(768), 5);
+    CLWEParameters store_params(768);
+    options.buffer_bytes = 1;
+    options.buffer_count = 1;
+    options.submit_batch = 0;
+
+    KeyArchiveWriter writer(path, store_params, options);
+    writer.append(keys);
+    writer.finish();
+
+    KeyArchiveReader reader(path, options);
+    std::vector<ColorPublicKey> read_back;
+    EXPECT_EQ(reader.read(read_back, 3), 3u);
+    EXPECT_EQ(reader.read(read_back, 3), 2u);
+    EXPECT_EQ(reader.read(read_back, 3), 0u);
+    ASSERT_EQ(read_back.size(), keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        EXPECT_EQ(read_back[i].public_data, keys[i].public_data);
+    }
+}
+
+// Test that rejected keys leave the writer usable and an abandoned writer leaves no file
+TEST_P(KeyArchiveTest, RejectedKeysAndAbandonedWriter) {
+    if (!backend_available()) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    auto keys = make_keys(params, 2);
+    {
+        KeyArchiveWriter writer(path, params, options);
+        writer.append(keys[0]);
+        EXPECT_THROW(writer.append(make_keys(CLWEParameters(768), 1)[0]), std::invalid_argument);
+        ColorPublicKey short_key = keys[1];
+        short_key.public_data.pop_back();
+        EXPECT_THROW(writer.append(short_key), std::invalid_argument);
+        writer.append(keys[1]);
+        EXPECT_EQ(writer.size(), 2u);
+    }
+    EXPECT_FALSE(std::ifstream(path).good());
+    EXPECT_FALSE(std::ifstream(path + ".tmp").good());
+
+    CLWEParameters wide = params;
+    wide.modulus = 7681;
+    EXPECT_THROW(KeyArchiveWriter(path, wide, options), std::invalid_argument);
+    EXPECT_THROW(KeyArchiveReader(path, options), std::runtime_error);
+}
+
+// Test that an empty archive round-trips
+TEST_P(KeyArchiveTest, EmptyArchive) {
+    if (!backend_available()) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    KeyArchiveWriter writer(path, params, options);
+    writer.finish();
+    KeyArchiveReader reader(path, options);
+    ColorPublicKey key;
+    EXPECT_EQ(reader.size(), 0u);
+    EXPECT_FALSE(reader.next(key));
+    EXPECT_EQ(KeyStore::open(path).size(), 0u);
+}
+
+INSTANTIATE_TEST_SUITE_P(Backends, KeyArchiveTest,
+                         ::testing::Values(BulkIoBackend::IoUring, BulkIoBackend::Threaded),
+                         [](const ::testing::TestParamInfo<BulkIoBackend>& info) {
+                             return info.param == BulkIoBackend::IoUring ? "IoUring" : "Threaded";
+                         });
+
+} // namespace clwe
@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include "clwe/key_ring.hpp"
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace clwe {
+
+TEST(KeyRingTest, RotationKeepsCurrentAndPrevious) {
+    ColorKEM kem{CLWEParameters(512)};
+    KeyRing ring(kem);
+    EXPECT_EQ(ring.current_version(), 0u);
+    EXPECT_EQ(ring.read().current(), nullptr);
+
+    auto first = kem.keygen();
+    EXPECT_EQ(ring.rotate(first.first, first.second), 1u);
+    auto first_encapsulation = kem.encapsulate(first.first);
+    EXPECT_EQ(ring.decapsulate(first_encapsulation.first, 1), first_encapsulation.second);
+
+    EXPECT_EQ(ring.rotate(), 2u);
+    {
+        KeyRing::ReadGuard guard = ring.read();
+        ASSERT_NE(guard.current(), nullptr);
+        ASSERT_NE(guard.previous(), nullptr);
+        EXPECT_EQ(guard.current()->version, 2u);
+        EXPECT_EQ(guard.previous()->version, 1u);
+        EXPECT_EQ(guard.find(1), guard.previous());
+        EXPECT_EQ(guard.find(3), nullptr);
+
+        // The published public key encapsulates to the current private key
+        auto encapsulation = kem.encapsulate(guard.current()->expanded_public_key);
+        EXPECT_EQ(kem.decapsulate(guard.current()->private_key, encapsulation.first), encapsulation.second);
+    }
+    // Ciphertexts under the previous key still decapsulate until the next rotation
+    EXPECT_EQ(ring.decapsulate(first_encapsulation.first, 1), first_encapsulation.second);
+    EXPECT_EQ(ring.rotate(), 3u);
+    EXPECT_THROW(ring.decapsulate(first_encapsulation.first, 1), std::invalid_argument);
+
+    // Keys for other parameters are refused before anything is published
+    ColorKEM other{CLWEParameters(768)};
+    auto foreign = other.keygen();
+    EXPECT_THROW(ring.rotate(foreign.first, foreign.second), std::invalid_argument);
+    EXPECT_EQ(ring.current_version(), 3u);
+}
+
+// A rotation frees the retired snapshot only after readers pinned on it are gone
+TEST(KeyRingTest, RotationWaitsForPinnedReaders) {
+    ColorKEM kem{CLWEParameters(512)};
+    KeyRing ring(kem);
+    ring.rotate();
+    ring.rotate();
+
+    KeyRing::ReadGuard guard = ring.read();
+    const KeyRing::Key* pinned = guard.previous();
+    ASSERT_NE(pinned, nullptr);
+    std::atomic<bool> rotated{false};
+    std::thread rotator([&] {
+        ring.rotate();
+        rotated = true;
+    });
+    // New readers are not held up by the pending rotation
+    for (int attempt = 0; attempt < 200 && ring.current_version() != 3; ++attempt) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(ring.current_version(), 3u);
+    EXPECT_FALSE(rotated);
+    EXPECT_EQ(pinned->version, 1u);
+    auto encapsulation = kem.encapsulate(pinned->public_key);
+    EXPECT_EQ(kem.decapsulate(pinned->private_key, encapsulation.first), encapsulation.second);
+
+    { KeyRing::ReadGuard released(std::move(guard)); }
+    rotator.join();
+    EXPECT_TRUE(rotated);
+}
+
+TEST(KeyRingTest, ConcurrentReadersDuringRotation) {
+    ColorKEM kem{CLWEParameters(512)};
+    KeyRing ring(kem);
+    ring.rotate();
+
+    std::atomic<bool> done{false};
+    std::vector<std::thread> readers;
+    std::vector<int> failures(4, 0);
+    for (size_t t = 0; t < failures.size(); ++t) {
+        readers.emplace_back([&, t] {
+            while (!done) {
+                KeyRing::ReadGuard guard = ring.read();
+                const KeyRing::Key* key = guard.current();
+                auto encapsulation = kem.encapsulate(key->expanded_public_key);
+                if (kem.decapsulate(key->private_key, encapsulation.first) != encapsulation.second ||
+                    guard.find(key->version) != key) {
+                    ++failures[t];
+                }
+            }
+        });
+    }
+    for (int i = 0; i < 10; ++i) {
+        ring.rotate();
+    }
+    done = true;
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+    for (int failed : failures) {
+        EXPECT_EQ(failed, 0);
+    }
+    EXPECT_EQ(ring.current_version(), 11u);
+}
+
+} // namespace clwe
@@ -0,0 +1,384 @@
+#include <gtest/gtest.h>
+#include "key_store.hpp"
+#include "key_archive.hpp"
+#include "poly.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace clwe {
+
+class KeyStoreTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path = ::testing::TempDir() + "clwe_key_store_" +
+               ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".clks";
+        std::remove(path.c_str());
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+
+    std::vector<std::pair<ColorPublicKey, ColorPrivateKey>> make_keys(const CLWEParameters& key_params, size_t count) {
+        ColorKEM kem(key_params);
+        return kem.keygen_batch(count);
+    }
+
+    static std::vector<ColorPublicKey> public_keys(const std::vector<std::pair<ColorPublicKey, ColorPrivateKey>>& pairs) {
+        std::vector<ColorPublicKey> keys;
+        for (const auto& pair : pairs) {
+            keys.push_back(pair.first);
+        }
+        return keys;
+    }
+
+    std::vector<uint8_t> read_file() const {
+        std::ifstream in(path, std::ios::binary);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    void write_file(const std::vector<uint8_t>& bytes) const {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    CLWEParameters params{512};
+    std::string path;
+};
+
+// Test that records, parameters and the seed index survive a write and open
+TEST_F(KeyStoreTest, WriteOpenRoundTrip) {
+    auto pairs = make_keys(params, 6);
+    auto keys = public_keys(pairs);
+    KeyStore::write(path, keys, params);
+
+    KeyStore store = KeyStore::open(path);
+    ASSERT_EQ(store.size(), keys.size());
+    EXPECT_EQ(store.params().security_level, params.security_level);
+    EXPECT_EQ(store.params().module_rank, params.module_rank);
+    EXPECT_EQ(store.params().encoding, params.encoding);
+    EXPECT_EQ(read_file().size(), KeyStore::HEADER_BYTES +
+              keys.size() * (KeyStore::record_bytes(params) + KeyStore::INDEX_ENTRY_BYTES));
+    // 32-byte seed plus k * n coefficients at 12 bits
+    EXPECT_EQ(KeyStore::record_bytes(params), 32u + params.module_rank * params.degree * 3 / 2);
+
+    for (size_t i = 0; i < keys.size(); ++i) {
+        ColorPublicKeyView view = store.key(i);
+        EXPECT_TRUE(std::equal(keys[i].seed.begin(), keys[i].seed.end(), view.seed));
+        EXPECT_EQ(view.encoding, CoefficientEncoding::PACKED12);
+        EXPECT_EQ(view.public_data_size, KeyStore::record_bytes(params) - 32);
+        EXPECT_EQ(store.find(keys[i].seed), i);
+    }
+
+    std::array<uint8_t, 32> unknown = keys[0].seed;
+    unknown[31] ^= 0x01;
+    EXPECT_EQ(store.find(unknown), KeyStore::npos);
+    EXPECT_THROW(store.key(keys.size()), std::invalid_argument);
+
+    // The secret weight is not stored: fixed-weight keys reopen under weight 0
+    CLWEParameters weighted(512);
+    weighted.secret_weight = 64;
+    auto weighted_pairs = make_keys(weighted, 2);
+    KeyStore::write(path, public_keys(weighted_pairs), weighted);
+    KeyStore weighted_store = KeyStore::open(path);
+    EXPECT_EQ(weighted_store.params().secret_weight, 0u);
+    ColorKEM weighted_kem(weighted);
+    auto [ciphertext, secret] = weighted_kem.encapsulate(weighted_store.key(1));
+    EXPECT_EQ(weighted_kem.decapsulate(weighted_pairs[1].first, weighted_pairs[1].second, ciphertext), secret);
+}
+
+// Test that encapsulating to a store record matches encapsulating to the original key
+TEST_F(KeyStoreTest, EncapsulationFromStoreMatchesKey) {
+    for (uint32_t level : {512u, 768u, 1024u}) {
+        CLWEParameters level_params(level);
+        auto pairs = make_keys(level_params, 3);
+        KeyStore::write(path, public_keys(pairs), level_params);
+        KeyStore store = KeyStore::open(path);
+
+        ColorKEM kem(level_params);
+        KemWorkspace workspace;
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            std::array<uint8_t, 32> m;
+            m.fill(static_cast<uint8_t>(i + level));
+            auto expected = kem.encapsulate_derand(pairs[i].first, m);
+
+            ColorCiphertext ciphertext;
+            ColorValue secret = kem.encapsulate_into(store.key(i), m, ciphertext, workspace);
+            EXPECT_EQ(secret, expected.second);
+            EXPECT_EQ(ciphertext.ciphertext_data, expected.first.ciphertext_data);
+            EXPECT_EQ(ciphertext.shared_secret_hint, expected.first.shared_secret_hint);
+
+            auto [random_ct, random_secret] = kem.encapsulate(store.key(i));
+            EXPECT_EQ(kem.decapsulate(pairs[i].first, pairs[i].second, random_ct), random_secret);
+        }
+
+        // Streaming A reads the same record the same way
+        kem.set_matrix_streaming(true);
+        std::array<uint8_t, 32> m;
+        m.fill(0x5A);
+        ColorCiphertext streamed;
+        ColorValue secret = kem.encapsulate_into(store.key(0), m, streamed, workspace);
+        EXPECT_EQ(secret, kem.encapsulate_derand(pairs[0].first, m).second);
+    }
+}
+
+// Test that a shared-matrix store reopens with its parameters and encapsulates to its keys
+TEST_F(KeyStoreTest, SharedMatrixStoreRoundTrip) {
+    CLWEParameters shared_params(512);
+    shared_params.shared_matrix = true;
+    std::array<uint8_t, 32> deployment_seed;
+    deployment_seed.fill(0x6B);
+    ColorKEM::install_shared_matrix(shared_params, deployment_seed);
+
+    auto pairs = make_keys(shared_params, 3);
+    KeyStore::write(path, public_keys(pairs), shared_params);
+    KeyStore store = KeyStore::open(path);
+    EXPECT_TRUE(store.params().shared_matrix);
+    EXPECT_EQ(store.params().fingerprint(), shared_params.fingerprint());
+
+    // Every record carries the deployment seed
+    EXPECT_EQ(store.find(deployment_seed), 0u);
+
+    ColorKEM kem(shared_params);
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        auto [ciphertext, secret] = kem.encapsulate(store.key(i));
+        EXPECT_EQ(kem.decapsulate(pairs[i].first, pairs[i].second, ciphertext), secret);
+    }
+
+    // A plain store of the same shape is a different parameter set
+    EXPECT_THROW(KeyStore::write(path, public_keys(pairs), CLWEParameters(512)), std::invalid_argument);
+    EXPECT_THROW(KeyStore::write(path, public_keys(pairs), shared_params, {0}), std::invalid_argument);
+
+    // Unknown flag bits are rejected
+    KeyStore::write(path, public_keys(pairs), shared_params);
+    std::vector<uint8_t> bytes = read_file();
+    bytes[43] |= 0x02;
+    write_file(bytes);
+    EXPECT_THROW(KeyStore::open(path), std::runtime_error);
+}
+
+// Test that a view of an in-memory key encapsulates like the key itself
+TEST_F(KeyStoreTest, ViewOfPublicKey) {
+    params.encoding = CoefficientEncoding::PACKED12;
+    ColorKEM kem(params);
+    auto [pk, sk] = kem.keygen();
+
+    std::array<uint8_t, 32> m;
+    m.fill(0x11);
+    ColorCiphertext ciphertext;
+    KemWorkspace workspace;
+    ColorValue secret = kem.encapsulate_into(ColorPublicKeyView(pk), m, ciphertext, workspace);
+    EXPECT_EQ(secret, kem.encapsulate_derand(pk, m).second);
+    EXPECT_EQ(kem.decapsulate(pk, sk, ciphertext), secret);
+
+    // PACKED12 keys are stored as they are
+    KeyStore::write(path, {pk}, params);
+    KeyStore store = KeyStore::open(path);
+    ColorPublicKeyView view = store.key(0);
+    EXPECT_TRUE(std::equal(pk.public_data.begin(), pk.public_data.end(), view.public_data));
+}
+
+// Test that views reject mismatched parameters and sizes
+TEST_F(KeyStoreTest, ViewValidation) {
+    ColorKEM kem(params);
+    auto [pk, sk] = kem.keygen();
+
+    ColorKEM other(CLWEParameters(768));
+    EXPECT_THROW(other.encapsulate(ColorPublicKeyView(pk)), std::invalid_argument);
+    EXPECT_THROW(kem.encapsulate(ColorPublicKeyView()), std::invalid_argument);
+
+    ColorPublicKeyView truncated(pk);
+    truncated.public_data_size -= 4;
+    EXPECT_THROW(kem.encapsulate(truncated), std::invalid_argument);
+
+    // COLOR32 data read as PACKED12 has the wrong size
+    ColorPublicKeyView relabeled(pk);
+    relabeled.encoding = CoefficientEncoding::PACKED12;
+    EXPECT_THROW(kem.encapsulate(relabeled), std::invalid_argument);
+}
+
+// Test that a moved store keeps its mapping and views
+TEST_F(KeyStoreTest, MoveKeepsMapping) {
+    auto keys = public_keys(make_keys(params, 2));
+    KeyStore::write(path, keys, params);
+
+    KeyStore store = KeyStore::open(path);
+    ColorPublicKeyView view = store.key(1);
+    KeyStore moved(std::move(store));
+    EXPECT_EQ(store.size(), 0u);
+    EXPECT_EQ(moved.size(), 2u);
+    EXPECT_EQ(moved.key(1).seed, view.seed);
+
+    KeyStore assigned = KeyStore::open(path);
+    assigned = std::move(moved);
+    EXPECT_EQ(assigned.find(keys[1].seed), 1u);
+}
+
+// Test that write rejects keys that do not fit the store
+TEST_F(KeyStoreTest, WriteRejectsInvalidKeys) {
+    auto keys = public_keys(make_keys(params, 2));
+    KeyStore::write(path, keys, params);
+    std::vector<uint8_t> original = read_file();
+
+    std::vector<ColorPublicKey> mixed = keys;
+    mixed.push_back(make_keys(CLWEParameters(768), 1)[0].first);
+    EXPECT_THROW(KeyStore::write(path, mixed, params), std::invalid_argument);
+
+    std::vector<ColorPublicKey> short_key = keys;
+    short_key[1].public_data.resize(short_key[1].public_data.size() - 4);
+    EXPECT_THROW(KeyStore::write(path, short_key, params), std::invalid_argument);
+
+    // COLOR32 coefficient 0xFFFFFFFF is not reduced mod q
+    std::vector<ColorPublicKey> unreduced = keys;
+    std::fill(unreduced[0].public_data.begin(), unreduced[0].public_data.begin() + 4, 0xFF);
+    EXPECT_THROW(KeyStore::write(path, unreduced, params), std::invalid_argument);
+
+    // Records are 12-bit t_hat, which rounded public keys do not carry
+    CLWEParameters rounded = params;
+    rounded.t_dropped_bits = 2;
+    EXPECT_THROW(KeyStore::write(path, public_keys(make_keys(rounded, 1)), rounded), std::invalid_argument);
+
+    // The previous file is untouched and no temporary is left behind
+    EXPECT_EQ(read_file(), original);
+    EXPECT_FALSE(std::ifstream(path + ".tmp").good());
+}
+
+// Test that open rejects files that are not well-formed stores
+TEST_F(KeyStoreTest, OpenRejectsMalformedFiles) {
+    EXPECT_THROW(KeyStore::open(path), std::runtime_error);
+
+    auto keys = public_keys(make_keys(params, 2));
+    KeyStore::write(path, keys, params);
+    const std::vector<uint8_t> good = read_file();
+
+    std::vector<uint8_t> bad = good;
+    bad[0] = 'X';
+    write_file(bad);
+    EXPECT_THROW(KeyStore::open(path), std::runtime_error);
+
+    bad = good;
+    bad.pop_back();
+    write_file(bad);
+    EXPECT_THROW(KeyStore::open(path), std::runtime_error);
+
+    // Record count beyond the file
+    bad = good;
+    bad[48] = 3;
+    write_file(bad);
+    EXPECT_THROW(KeyStore::open(path), std::runtime_error);
+
+    // Unsupported security level in the parameter block
+    bad = good;
+    bad[8] = 0;
+    bad[9] = 0;
+    write_file(bad);
+    EXPECT_THROW(KeyStore::open(path), std::runtime_error);
+
+    write_file(std::vector<uint8_t>(good.begin(), good.begin() + 16));
+    EXPECT_THROW(KeyStore::open(path), std::runtime_error);
+
+    // An empty store is valid
+    KeyStore::write(path, {}, params);
+    KeyStore empty = KeyStore::open(path);
+    EXPECT_EQ(empty.size(), 0u);
+    EXPECT_EQ(empty.find(keys[0].seed), KeyStore::npos);
+}
+
+// Test that hot records carry their expanded matrix and encapsulate as the original keys do
+TEST_F(KeyStoreTest, ExpandedSectionServesHotKeys) {
+    for (uint32_t level : {512u, 768u, 1024u}) {
+        CLWEParameters level_params(level);
+        auto pairs = make_keys(level_params, 5);
+        KeyStore::write(path, public_keys(pairs), level_params, {3, 1, 3});
+        const size_t entry_bytes = 8 + level_params.module_rank * level_params.module_rank * level_params.degree * 3 / 2;
+        EXPECT_EQ(read_file().size(), KeyStore::HEADER_BYTES +
+                  pairs.size() * (KeyStore::record_bytes(level_params) + KeyStore::INDEX_ENTRY_BYTES) +
+                  16 + 2 * entry_bytes);
+
+        KeyStore store = KeyStore::open(path);
+        EXPECT_EQ(store.expanded_size(), 2u);
+        EXPECT_FALSE(store.has_expanded_key(0));
+        EXPECT_TRUE(store.has_expanded_key(1));
+        EXPECT_TRUE(store.has_expanded_key(3));
+        EXPECT_FALSE(store.has_expanded_key(4));
+        EXPECT_EQ(store.find(pairs[3].first.seed), 3u);
+
+        ColorKEM kem(level_params);
+        for (size_t i : {1u, 3u}) {
+            ExpandedPublicKey stored = store.expanded_key(i);
+            ExpandedPublicKey reference = kem.expand_public_key(pairs[i].first);
+            const size_t matrix_coeffs = static_cast<size_t>(level_params.module_rank) * level_params.module_rank *
+                                         level_params.degree;
+            EXPECT_TRUE(std::equal(stored.matrix_A->data(), stored.matrix_A->data() + matrix_coeffs,
+                                   reference.matrix_A->data()));
+            EXPECT_EQ(stored.public_data, pairs[i].first.public_data);
+            EXPECT_EQ(stored.seed, pairs[i].first.seed);
+
+            std::array<uint8_t, 32> m;
+            m.fill(static_cast<uint8_t>(i));
+            ColorCiphertext ciphertext;
+            KemWorkspace workspace;
+            auto expected = kem.encapsulate_derand(pairs[i].first, m);
+            EXPECT_EQ(kem.encapsulate_into(stored, m, ciphertext, workspace), expected.second);
+            EXPECT_EQ(ciphertext.ciphertext_data, expected.first.ciphertext_data);
+        }
+        EXPECT_THROW(store.expanded_key(0), std::invalid_argument);
+        EXPECT_THROW(store.expanded_key(pairs.size()), std::invalid_argument);
+
+        // Moves carry the section; the archive reader still streams every record
+        KeyStore moved(std::move(store));
+        EXPECT_EQ(store.expanded_size(), 0u);
+        EXPECT_TRUE(moved.has_expanded_key(3));
+        KeyArchiveReader reader(path);
+        std::vector<ColorPublicKey> read;
+        EXPECT_EQ(reader.read(read, pairs.size() + 1), pairs.size());
+        EXPECT_EQ(read[4].public_data, pairs[4].first.public_data);
+    }
+}
+
+// Test that bad expanded record numbers and damaged expanded sections are refused
+TEST_F(KeyStoreTest, ExpandedSectionValidation) {
+    auto keys = public_keys(make_keys(params, 3));
+    EXPECT_THROW(KeyStore::write(path, keys, params, {3}), std::invalid_argument);
+    KeyArchiveWriter writer(path, params);
+    EXPECT_THROW(writer.store_expanded(0), std::invalid_argument);
+    writer.append(keys[0]);
+    writer.store_expanded(0);
+    writer.finish();
+    EXPECT_THROW(writer.store_expanded(0), std::logic_error);
+
+    KeyStore::write(path, keys, params, {2});
+    const std::vector<uint8_t> good = read_file();
+    const size_t section = KeyStore::HEADER_BYTES + keys.size() * (KeyStore::record_bytes(params) +
+                                                                  KeyStore::INDEX_ENTRY_BYTES);
+
+    std::vector<uint8_t> bad = good;
+    bad[section] = 'X';
+    write_file(bad);
+    EXPECT_THROW(KeyStore::open(path), std::runtime_error);
+    EXPECT_THROW(KeyArchiveReader{path}, std::runtime_error);
+
+    bad = good;
+    bad.pop_back();
+    write_file(bad);
+    EXPECT_THROW(KeyStore::open(path), std::runtime_error);
+
+    // Record number past the store
+    bad = good;
+    bad[section + 16] = 7;
+    write_file(bad);
+    EXPECT_THROW(KeyStore::open(path), std::runtime_error);
+
+    // Trailing bytes too few for a section header
+    bad = std::vector<uint8_t>(good.begin(), good.begin() + section);
+    bad.resize(section + 8);
+    write_file(bad);
+    EXPECT_THROW(KeyStore::open(path), std::runtime_error);
+}
+
+} // namespace clwe
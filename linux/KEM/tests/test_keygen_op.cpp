@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include "clwe/keygen_op.hpp"
+#include "color_kem.hpp"
+#include "allocation_tracker.hpp"
+#include <array>
+#include <stdexcept>
+#include <vector>
+
+namespace clwe {
+
+namespace {
+
+std::array<uint8_t, 32> test_seed(uint8_t base) {
+    std::array<uint8_t, 32> d;
+    for (size_t i = 0; i < d.size(); ++i) {
+        d[i] = static_cast<uint8_t>(base + 7 * i);
+    }
+    return d;
+}
+
+void expect_same_keys(const std::pair<ColorPublicKey, ColorPrivateKey>& a,
+                      const std::pair<ColorPublicKey, ColorPrivateKey>& b) {
+    EXPECT_EQ(a.first.seed, b.first.seed);
+    EXPECT_EQ(a.first.public_data, b.first.public_data);
+    EXPECT_EQ(a.second.secret_data, b.second.secret_data);
+    EXPECT_EQ(a.first.params.fingerprint(), b.first.params.fingerprint());
+}
+
+} // namespace
+
+// Test that stepping one unit at a time gives keygen_derand's keys at every level
+TEST(KeygenOpTest, MatchesKeygenDerand) {
+    for (uint32_t level : {512u, 768u, 1024u}) {
+        ColorKEM kem{CLWEParameters(level)};
+        std::array<uint8_t, 32> d = test_seed(static_cast<uint8_t>(level));
+        KeygenOp op(kem, d);
+        EXPECT_EQ(op.phase(), KeygenPhase::Sampling);
+        size_t steps = 0;
+        while (!op.step(0)) {
+            ++steps;
+            EXPECT_EQ(op.units_done(), steps);
+        }
+        EXPECT_EQ(steps + 1, op.units_total());
+        EXPECT_EQ(op.phase(), KeygenPhase::Done);
+        expect_same_keys(op.take_keys(), kem.keygen_derand(d));
+    }
+}
+
+// Test the phases in order and that a generous budget finishes in one step
+TEST(KeygenOpTest, PhasesAndBudget) {
+    ColorKEM kem{CLWEParameters(768)};
+    std::array<uint8_t, 32> d = test_seed(3);
+    KeygenOp op(kem, d);
+    std::vector<KeygenPhase> seen;
+    while (!op.done()) {
+        if (seen.empty() || seen.back() != op.phase()) {
+            seen.push_back(op.phase());
+        }
+        op.step(0);
+    }
+    EXPECT_EQ(seen, (std::vector<KeygenPhase>{KeygenPhase::Sampling, KeygenPhase::Matrix, KeygenPhase::Packing}));
+
+    KeygenOp whole(kem, d);
+    EXPECT_TRUE(whole.step(UINT64_MAX / 2));
+    expect_same_keys(whole.take_keys(), op.take_keys());
+}
+
+// Test that steps do not allocate once the operation is constructed
+TEST(KeygenOpTest, StepsAllocateNothing) {
+    ColorKEM kem{CLWEParameters(1024)};
+    KeygenOp op(kem, test_seed(9));
+    ASSERT_TRUE(AllocationTracker::hooks_installed());
+    AllocationTracker tracker;
+    while (!op.step(0)) {
+    }
+    EXPECT_EQ(tracker.stats().allocations, 0u);
+}
+
+// Test rounded public keys, fixed-weight secrets, a shared matrix and the owning constructor
+TEST(KeygenOpTest, ParameterVariants) {
+    CLWEParameters rounded(768);
+    rounded.t_dropped_bits = 2;
+    CLWEParameters weighted(768);
+    weighted.secret_weight = 64;
+    CLWEParameters shared(1024);
+    shared.shared_matrix = true;
+    ColorKEM::install_shared_matrix(shared, test_seed(0x5A));
+    for (const CLWEParameters& params : {rounded, weighted, shared}) {
+        ColorKEM kem(params);
+        std::array<uint8_t, 32> d = test_seed(21);
+        KeygenOp op(kem, d);
+        op.run();
+        auto keys = op.take_keys();
+        expect_same_keys(keys, kem.keygen_derand(d));
+        auto encapsulated = kem.encapsulate(keys.first);
+        EXPECT_EQ(kem.decapsulate(keys.first, keys.second, encapsulated.first), encapsulated.second);
+    }
+
+    KeygenOp owning{CLWEParameters(512)};
+    owning.run();
+    auto keys = owning.take_keys();
+    ColorKEM kem{CLWEParameters(512)};
+    auto encapsulated = kem.encapsulate(keys.first);
+    EXPECT_EQ(kem.decapsulate(keys.first, keys.second, encapsulated.first), encapsulated.second);
+}
+
+// Test misuse: early or repeated take_keys() and moved-from operations
+TEST(KeygenOpTest, Misuse) {
+    ColorKEM kem{CLWEParameters(512)};
+    KeygenOp op(kem);
+    EXPECT_THROW(op.take_keys(), std::logic_error);
+    op.step(0);
+    KeygenOp moved = std::move(op);
+    EXPECT_EQ(moved.units_done(), 1u);
+    EXPECT_THROW(op.step(0), std::logic_error);
+    moved.run();
+    moved.take_keys();
+    EXPECT_THROW(moved.take_keys(), std::logic_error);
+}
+
+} // namespace clwe
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include "keygen_pool.hpp"
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace clwe {
+
+class KeygenPoolTest : public ::testing::Test {
+protected:
+    // Small pool so the tests fill it quickly
+    static KeygenPoolConfig small_config() {
+        KeygenPoolConfig config;
+        config.capacity = 16;
+        config.low_watermark = 4;
+        config.high_watermark = 12;
+        config.worker_threads = 2;
+        config.batch_size = 3;
+        return config;
+    }
+
+    CLWEParameters params{512};
+};
+
+// Test that the pool fills to its high watermark in the background
+TEST_F(KeygenPoolTest, FillsToHighWatermark) {
+    KeygenPool pool(params, small_config());
+    EXPECT_EQ(pool.capacity(), 16u);
+    ASSERT_TRUE(pool.wait_ready(12, std::chrono::milliseconds(30000)));
+    EXPECT_EQ(pool.ready(), 12u);
+    EXPECT_EQ(pool.generated(), 12u);
+    EXPECT_EQ(pool.params().security_level, params.security_level);
+}
+
+// Test that popped keys are distinct and work with ColorKEM
+TEST_F(KeygenPoolTest, PoppedKeysRoundTrip) {
+    KeygenPool pool(params, small_config());
+    ASSERT_TRUE(pool.wait_ready(4, std::chrono::milliseconds(30000)));
+
+    ColorKEM kem(params);
+    std::set<std::vector<uint8_t>> seen;
+    for (int i = 0; i < 4; ++i) {
+        KeygenPool::KeyPair keys;
+        ASSERT_TRUE(pool.try_pop(keys));
+        EXPECT_TRUE(seen.insert(keys.first.serialize()).second);
+
+        auto [ciphertext, secret] = kem.encapsulate(keys.first);
+        EXPECT_EQ(kem.decapsulate(keys.first, keys.second, ciphertext), secret);
+    }
+}
+
+// Test that a drained pool still serves keys and refills
+TEST_F(KeygenPoolTest, DrainedPoolStillServes) {
+    KeygenPool pool(params, small_config());
+    ColorKEM kem(params);
+    for (int i = 0; i < 20; ++i) {
+        KeygenPool::KeyPair keys = pool.pop();
+        auto [ciphertext, secret] = kem.encapsulate(keys.first);
+        EXPECT_EQ(kem.decapsulate(keys.first, keys.second, ciphertext), secret);
+    }
+    EXPECT_TRUE(pool.wait_ready(1, std::chrono::milliseconds(30000)));
+}
+
+// Test that concurrent consumers never receive the same key pair
+TEST_F(KeygenPoolTest, ConcurrentConsumers) {
+    KeygenPool pool(params, small_config());
+    ASSERT_TRUE(pool.wait_ready(12, std::chrono::milliseconds(30000)));
+
+    std::mutex mutex;
+    std::set<std::vector<uint8_t>> seen;
+    size_t taken = 0;
+    std::vector<std::thread> consumers;
+    for (int t = 0; t < 4; ++t) {
+        consumers.emplace_back([&] {
+            for (int i = 0; i < 6; ++i) {
+                KeygenPool::KeyPair keys = pool.pop();
+                std::lock_guard<std::mutex> lock(mutex);
+                seen.insert(keys.second.serialize());
+                ++taken;
+            }
+        });
+    }
+    for (std::thread& consumer : consumers) {
+        consumer.join();
+    }
+    EXPECT_EQ(taken, 24u);
+    EXPECT_EQ(seen.size(), 24u);
+}
+
+// Test that inconsistent configurations are rejected
+TEST_F(KeygenPoolTest, RejectsBadConfig) {
+    KeygenPoolConfig config = small_config();
+    config.batch_size = 0;
+    EXPECT_THROW(KeygenPool(params, config), std::invalid_argument);
+
+    config = small_config();
+    config.low_watermark = config.high_watermark;
+    EXPECT_THROW(KeygenPool(params, config), std::invalid_argument);
+
+    config = small_config();
+    config.high_watermark = 17;
+    EXPECT_THROW(KeygenPool(params, config), std::invalid_argument);
+}
+
+} // namespace clwe
@@ -237,4 +237,30 @@ TEST_F(ColorKEMKnownAnswerTest, DeterministicKeyGeneration1024) {
     ASSERT_EQ(private_key.secret_data.size(), params.module_rank * params.degree * 4);
 }
 
+// Derandomized entry points are fully determined by their single seed
+TEST_F(ColorKEMKnownAnswerTest, DerandomizedRoundTrip) {
+    for (uint32_t level : security_levels_) {
+        CLWEParameters params(level);
+        ColorKEM kem(params);
+
+        auto [pk0, sk0] = kem.keygen_derand(MATRIX_SEED_512);
+        auto [pk1, sk1] = kem.keygen_derand(MATRIX_SEED_512);
+        auto [pk2, sk2] = kem.keygen_derand(SECRET_SEED_512);
+        EXPECT_EQ(pk0.seed, pk1.seed);
+        EXPECT_EQ(pk0.public_data, pk1.public_data);
+        EXPECT_EQ(sk0.secret_data, sk1.secret_data);
+        EXPECT_NE(pk0.public_data, pk2.public_data);
+
+        auto [ct0, ss0] = kem.encapsulate_derand(pk0, R_SEED_512);
+        auto [ct1, ss1] = kem.encapsulate_derand(pk0, R_SEED_512);
+        auto [ct2, ss2] = kem.encapsulate_derand(pk0, E1_SEED_512);
+        EXPECT_EQ(ct0.ciphertext_data, ct1.ciphertext_data);
+        EXPECT_EQ(ss0, ss1);
+        EXPECT_NE(ct0.ciphertext_data, ct2.ciphertext_data);
+
+        EXPECT_EQ(kem.decapsulate(pk0, sk0, ct0), ss0);
+        EXPECT_EQ(kem.decapsulate(pk0, sk0, ct2), ss2);
+    }
+}
+
 } // namespace clwe
\ No newline at end of file
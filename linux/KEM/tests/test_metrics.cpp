@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+#include "metrics.hpp"
+#include "color_kem.hpp"
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace clwe {
+
+class MetricsTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        reset_metrics();
+    }
+
+    void TearDown() override {
+        set_metrics_enabled(false);
+        reset_metrics();
+    }
+};
+
+TEST_F(MetricsTest, DisabledRecordsNothing) {
+    ColorKEM kem{CLWEParameters(512)};
+    auto keys = kem.keygen();
+    auto encapsulation = kem.encapsulate(keys.first);
+    kem.decapsulate(keys.first, keys.second, encapsulation.first);
+
+    MetricsSnapshot snapshot = metrics_snapshot();
+    for (const auto& operation : snapshot.operations) {
+        for (const auto& level : operation) {
+            EXPECT_EQ(level.count, 0u);
+        }
+    }
+    EXPECT_EQ(snapshot.squeezed_bytes[0] + snapshot.squeezed_bytes[1], 0u);
+}
+
+// Operations, rejections and cache lookups are counted per security level
+TEST_F(MetricsTest, CountsKemOperations) {
+    ColorKEM kem{CLWEParameters(768)};
+    kem.set_expanded_key_cache_capacity(4);
+    auto keys = kem.keygen();
+    set_metrics_enabled(true);
+
+    auto encapsulation = kem.encapsulate(keys.first);
+    kem.encapsulate(keys.first);
+    EXPECT_EQ(kem.decapsulate(keys.first, keys.second, encapsulation.first), encapsulation.second);
+    ColorCiphertext tampered = encapsulation.first;
+    tampered.shared_secret_hint[0] ^= 0x80;
+    kem.decapsulate(keys.first, keys.second, tampered);
+    kem.keygen();
+    // A call that throws is not an operation
+    EXPECT_THROW(kem.decapsulate(keys.first, keys.second, ColorCiphertext()), std::invalid_argument);
+
+    MetricsSnapshot snapshot = metrics_snapshot();
+    EXPECT_EQ(snapshot.operation(MetricOperation::KEYGEN, 768).count, 1u);
+    EXPECT_EQ(snapshot.operation(MetricOperation::ENCAPSULATE, 768).count, 2u);
+    EXPECT_EQ(snapshot.operation(MetricOperation::DECAPSULATE, 768).count, 2u);
+    EXPECT_EQ(snapshot.operation(MetricOperation::DECAPSULATE, 512).count, 0u);
+    EXPECT_GT(snapshot.operation(MetricOperation::ENCAPSULATE, 768).sum_ns, 0u);
+    EXPECT_EQ(snapshot.counter(MetricCounter::IMPLICIT_REJECTIONS, 768), 1u);
+    EXPECT_EQ(snapshot.counter(MetricCounter::EXPANDED_KEY_CACHE_MISSES, 768), 1u);
+    EXPECT_EQ(snapshot.counter(MetricCounter::EXPANDED_KEY_CACHE_HITS, 768), 1u);
+    EXPECT_GT(snapshot.squeezed_bytes[static_cast<size_t>(MetricXof::SHAKE128)], 0u);
+    EXPECT_GT(snapshot.squeezed_bytes[static_cast<size_t>(MetricXof::SHAKE256)], 0u);
+
+    reset_metrics();
+    EXPECT_EQ(metrics_snapshot().operation(MetricOperation::KEYGEN, 768).count, 0u);
+}
+
+// Counts from threads that have exited stay in the totals
+TEST_F(MetricsTest, ShardsSurviveThreadExit) {
+    set_metrics_enabled(true);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([] {
+            for (int i = 0; i < 1000; ++i) {
+                record_operation(MetricOperation::ENCAPSULATE, 1024, 1500);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    std::thread([] { record_operation(MetricOperation::ENCAPSULATE, 1024, 1500); }).join();
+
+    const MetricsSnapshot snapshot = metrics_snapshot();
+    const MetricsSnapshot::Operation& encapsulate = snapshot.operation(MetricOperation::ENCAPSULATE, 1024);
+    EXPECT_EQ(encapsulate.count, 4001u);
+    EXPECT_EQ(encapsulate.sum_ns, 4001u * 1500);
+    EXPECT_EQ(encapsulate.buckets[1], 4001u);
+}
+
+TEST_F(MetricsTest, LatencyBuckets) {
+    EXPECT_EQ(metric_latency_bucket(0), 0u);
+    EXPECT_EQ(metric_latency_bucket(1000), 0u);
+    EXPECT_EQ(metric_latency_bucket(1001), 1u);
+    EXPECT_EQ(metric_latency_bucket(4000), 2u);
+    EXPECT_EQ(metric_latency_bucket(4001), 3u);
+    EXPECT_EQ(metric_latency_bucket(UINT64_MAX), METRIC_LATENCY_BUCKETS - 1);
+    EXPECT_EQ(metric_level_slot(512), 0u);
+    EXPECT_EQ(metric_level_slot(1024), 2u);
+    EXPECT_EQ(metric_level_slot(256), 3u);
+}
+
+TEST_F(MetricsTest, PrometheusExposition) {
+    MetricsSnapshot snapshot;
+    auto& keygen = snapshot.operations[static_cast<size_t>(MetricOperation::KEYGEN)][0];
+    keygen.buckets[3] = 2;
+    keygen.buckets[5] = 1;
+    keygen.count = 3;
+    keygen.sum_ns = 1234567;
+    snapshot.counters[static_cast<size_t>(MetricCounter::IMPLICIT_REJECTIONS)][0] = 7;
+    snapshot.squeezed_bytes[static_cast<size_t>(MetricXof::SHAKE128)] = 504;
+
+    std::ostringstream text;
+    write_prometheus_metrics(text, snapshot);
+    const std::string exposition = text.str();
+    EXPECT_NE(exposition.find("# TYPE clwe_operations_total counter\n"
+                              "clwe_operations_total{operation=\"keygen\",level=\"512\"} 3\n"), std::string::npos);
+    EXPECT_NE(exposition.find("# TYPE clwe_operation_duration_seconds histogram\n"), std::string::npos);
+    EXPECT_NE(exposition.find("_bucket{operation=\"keygen\",level=\"512\",le=\"0.000004\"} 0\n"), std::string::npos);
+    EXPECT_NE(exposition.find("_bucket{operation=\"keygen\",level=\"512\",le=\"0.000008\"} 2\n"), std::string::npos);
+    EXPECT_NE(exposition.find("_bucket{operation=\"keygen\",level=\"512\",le=\"0.000032\"} 3\n"), std::string::npos);
+    EXPECT_NE(exposition.find("_bucket{operation=\"keygen\",level=\"512\",le=\"+Inf\"} 3\n"), std::string::npos);
+    EXPECT_NE(exposition.find("clwe_operation_duration_seconds_sum{operation=\"keygen\",level=\"512\"} 0.001234567\n"),
+              std::string::npos);
+    EXPECT_NE(exposition.find("clwe_implicit_rejections_total{level=\"512\"} 7\n"), std::string::npos);
+    EXPECT_NE(exposition.find("clwe_xof_squeezed_bytes_total{xof=\"shake128\"} 504\n"), std::string::npos);
+    // Levels without samples are left out
+    EXPECT_EQ(exposition.find("level=\"768\""), std::string::npos);
+    EXPECT_EQ(exposition.find("# EOF"), std::string::npos);
+
+    std::ostringstream openmetrics;
+    write_prometheus_metrics(openmetrics, snapshot, true);
+    const std::string om = openmetrics.str();
+    EXPECT_NE(om.find("# TYPE clwe_operations counter\n"), std::string::npos);
+    EXPECT_NE(om.find("clwe_operations_total{operation=\"keygen\",level=\"512\"} 3\n"), std::string::npos);
+    EXPECT_EQ(om.compare(om.size() - 6, 6, "# EOF\n"), 0);
+}
+
+} // namespace clwe
@@ -1,7 +1,38 @@
 #include <gtest/gtest.h>
+#include "allocation_tracker.hpp"
 #include "color_ntt_engine.hpp"
 #include "ntt_engine.hpp"
+#include "ntt_mlkem.hpp"
+#include "ntt_portable.hpp"
+#include "ntt_scalar.hpp"
+#include "ntt_tables.hpp"
+#include "ntt_unrolled.hpp"
+#include "cpu_features.hpp"
+#ifdef HAVE_AVX2
+#include "ntt_avx.hpp"
+#endif
+#ifdef HAVE_AVX512BW
+#include "ntt_avx512.hpp"
+#endif
+#ifdef HAVE_NEON
+#include "ntt_neon.hpp"
+#endif
+#ifdef HAVE_SVE
+#include "ntt_sve.hpp"
+#endif
+#ifdef HAVE_RVV
+#include "ntt_rvv.hpp"
+#endif
+#ifdef HAVE_VSX
+#include "ntt_vsx.hpp"
+#endif
+#ifdef HAVE_WASM_SIMD128
+#include "ntt_wasm.hpp"
+#endif
 #include "utils.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
 #include <vector>
 #include <algorithm>
 
@@ -111,10 +142,12 @@ TEST_F(NTTEngineTest, ColorPolynomialMultiplication) {
 
     color_ntt->multiply_colors(a.data(), b.data(), result.data());
 
-    // Result should have specific values at x^1
+    // Zero colors carry alpha = 255, so every coefficient contributes. Under the
+    // math value mapping result[1] = 256 * sum_j a[j] * b[1 - j] mod q = 1785.
     EXPECT_EQ(result[1].g, 0);
     EXPECT_EQ(result[1].r, 0);
-    EXPECT_EQ(result[1].b, 7);
+    EXPECT_EQ(result[1].b, 6);
+    EXPECT_EQ(result[1].to_math_value(), 1785u);
 }
 
 // Test conversion between uint32 and colors
@@ -211,8 +244,8 @@ TEST_F(NTTEngineTest, InvalidParameters) {
 // Test SIMD support detection
 TEST_F(NTTEngineTest, SIMDSupport) {
     SIMDSupport support = color_ntt->get_simd_support();
-    // ColorNTTEngine currently returns NONE
-    EXPECT_EQ(support, SIMDSupport::NONE);
+    // ColorNTTEngine reports the backend chosen for this CPU
+    EXPECT_EQ(support, create_optimal_ntt_engine(modulus, degree)->get_simd_support());
 }
 
 // Test NTT linearity
@@ -288,4 +321,1086 @@ TEST_F(NTTEngineTest, MultiplicationByMonomial) {
     }
 }
 
+// Pointwise accumulation in NTT domain matches summing full products
+TEST_F(NTTEngineTest, PointwiseMultiplyAccumulate) {
+    std::vector<ColorValue> a(degree), b(degree), c(degree);
+    for (size_t i = 0; i < degree; ++i) {
+        a[i] = ColorValue::from_math_value((i * 5 + 1) % modulus);
+        b[i] = ColorValue::from_math_value((i * 11 + 3) % modulus);
+        c[i] = ColorValue::from_math_value((i * i + 7) % modulus);
+    }
+
+    std::vector<ColorValue> ab(degree), cb(degree);
+    color_ntt->multiply_colors(a.data(), b.data(), ab.data());
+    color_ntt->multiply_colors(c.data(), b.data(), cb.data());
+
+    std::vector<ColorValue> a_hat = a, b_hat = b, c_hat = c;
+    color_ntt->ntt_forward_colors(a_hat.data());
+    color_ntt->ntt_forward_colors(b_hat.data());
+    color_ntt->ntt_forward_colors(c_hat.data());
+
+    std::vector<ColorValue> acc(degree, ColorValue::from_math_value(0));
+    color_ntt->pointwise_multiply_accumulate_colors(a_hat.data(), b_hat.data(), acc.data());
+    color_ntt->pointwise_multiply_accumulate_colors(c_hat.data(), b_hat.data(), acc.data());
+    color_ntt->ntt_inverse_colors(acc.data());
+
+    for (size_t i = 0; i < degree; ++i) {
+        uint32_t expected = (ab[i].to_math_value() + cb[i].to_math_value()) % modulus;
+        EXPECT_EQ(acc[i].to_math_value(), expected);
+    }
+}
+
+// Compact int16_t conversions and multiply-accumulate against plain modular arithmetic
+TEST_F(NTTEngineTest, Coeff16ConversionAndMultiplyAccumulate) {
+    const size_t count = 37;  // exercises the SIMD body and the scalar tail
+    std::vector<ColorValue> in(count);
+    for (size_t i = 0; i < count; ++i) {
+        // Unreduced values, including ones above 2^16
+        in[i] = ColorValue::from_math_value(static_cast<uint32_t>(i * 2654435761u));
+    }
+    std::vector<Coeff16> c16(count);
+    colors_to_coeff16(in.data(), c16.data(), count, modulus);
+    for (size_t i = 0; i < count; ++i) {
+        EXPECT_EQ(static_cast<uint32_t>(c16[i]), in[i].to_math_value() % modulus);
+    }
+
+    std::vector<ColorValue> back(count);
+    coeff16_to_colors(c16.data(), back.data(), count);
+    for (size_t i = 0; i < count; ++i) {
+        EXPECT_EQ(back[i].to_math_value(), static_cast<uint32_t>(c16[i]));
+    }
+
+    std::vector<Coeff16> a(count), b(count), acc(count);
+    for (size_t i = 0; i < count; ++i) {
+        a[i] = static_cast<Coeff16>(modulus - 1 - i);
+        b[i] = static_cast<Coeff16>((i * 977) % modulus);
+        acc[i] = static_cast<Coeff16>((i * 31 + modulus - 5) % modulus);
+    }
+    std::vector<Coeff16> expected(count);
+    for (size_t i = 0; i < count; ++i) {
+        expected[i] = static_cast<Coeff16>((static_cast<uint32_t>(acc[i]) + static_cast<uint32_t>(a[i]) * b[i]) % modulus);
+    }
+    coeff16_multiply_accumulate(a.data(), b.data(), acc.data(), count, modulus);
+    EXPECT_EQ(acc, expected);
+    EXPECT_TRUE(coeff16_supported(3329));
+    EXPECT_FALSE(coeff16_supported(7681 * 4 + 1));
+}
+
+// Byte-level be32 unpack / pack match the COLOR32 wire layout
+TEST_F(NTTEngineTest, Coeff16Be32PackUnpack) {
+    const size_t count = 45;  // exercises the SIMD body and the scalar tail
+    std::vector<uint8_t> bytes(4 * count);
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t value = static_cast<uint32_t>(i * 2246822519u + 7);
+        bytes[4 * i] = static_cast<uint8_t>(value >> 24);
+        bytes[4 * i + 1] = static_cast<uint8_t>(value >> 16);
+        bytes[4 * i + 2] = static_cast<uint8_t>(value >> 8);
+        bytes[4 * i + 3] = static_cast<uint8_t>(value);
+    }
+
+    std::vector<Coeff16> c16(count);
+    unpack_coeffs_be32(bytes.data(), count, c16.data(), modulus);
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t value = static_cast<uint32_t>(i * 2246822519u + 7);
+        EXPECT_EQ(static_cast<uint32_t>(c16[i]), value % modulus);
+    }
+
+    std::vector<uint8_t> packed(4 * count);
+    pack_coeffs_be32(c16.data(), count, packed.data());
+    std::vector<ColorValue> colors(count);
+    coeff16_to_colors(c16.data(), colors.data(), count);
+    for (size_t i = 0; i < count; ++i) {
+        EXPECT_EQ(std::memcmp(packed.data() + 4 * i, &colors[i], 4), 0);
+        EXPECT_EQ(ColorValue::from_math_value(static_cast<uint16_t>(c16[i])), colors[i]);
+    }
+}
+
+// Constant-term kernel agrees with the full product (which is scaled by n)
+TEST_F(NTTEngineTest, ConstantTermProduct) {
+    std::vector<uint32_t> a(degree), b(degree);
+    for (size_t i = 0; i < degree; ++i) {
+        a[i] = (i * 7 + 2) % modulus;
+        b[i] = (i * i * 3 + 11) % modulus;
+    }
+
+    std::vector<uint32_t> product(degree);
+    color_ntt->multiply(a.data(), b.data(), product.data());
+
+    uint32_t constant = color_ntt->constant_term_product(a.data(), b.data());
+    EXPECT_EQ(product[0], (static_cast<uint64_t>(constant) * degree) % modulus);
+
+    ScalarNTTEngine scalar(modulus, degree);
+    EXPECT_EQ(scalar.constant_term_product(a.data(), b.data()), constant);
+
+    std::vector<ColorValue> ca(degree), cbv(degree);
+    color_ntt->convert_uint32_to_colors(a.data(), ca.data());
+    color_ntt->convert_uint32_to_colors(b.data(), cbv.data());
+    EXPECT_EQ(color_ntt->constant_term_product_colors(ca.data(), cbv.data()).to_math_value(), constant);
+}
+
+// Scalar backend round-trip follows the unnormalized contract: inverse(forward(x)) = n * x
+TEST_F(NTTEngineTest, ScalarRoundTrip) {
+    ScalarNTTEngine scalar(modulus, degree);
+    std::vector<uint32_t> transformed = coeffs;
+
+    scalar.ntt_forward(transformed.data());
+    scalar.ntt_inverse(transformed.data());
+
+    for (size_t i = 0; i < degree; ++i) {
+        uint64_t expected = (static_cast<uint64_t>(coeffs[i]) * degree) % modulus;
+        EXPECT_EQ(transformed[i], expected);
+    }
+}
+
+// Lazy butterflies must agree with an exact cyclic convolution, including moduli
+// large enough to force intermediate reductions (18433, 36353). The moduli are ones
+// where 17 yields a primitive n-th root, as the scalar engine assumes.
+TEST_F(NTTEngineTest, LazyReductionMatchesSchoolbook) {
+    const std::vector<std::pair<uint32_t, uint32_t>> configs = {
+        {3329, 256}, {7681, 512}, {18433, 2048}, {36353, 512}};
+
+    for (const auto& config : configs) {
+        const uint32_t q = config.first;
+        const uint32_t n = config.second;
+        ScalarNTTEngine scalar(q, n);
+
+        std::vector<uint32_t> a(n), b(n);
+        for (uint32_t i = 0; i < n; ++i) {
+            a[i] = q - 1 - (i * 7919u) % q;
+            b[i] = (i * i * 31u + 5u) % q;
+        }
+
+        std::vector<uint64_t> expected(n, 0);
+        for (uint32_t i = 0; i < n; ++i) {
+            for (uint32_t j = 0; j < n; ++j) {
+                uint32_t idx = (i + j) % n;
+                expected[idx] = (expected[idx] + static_cast<uint64_t>(a[i]) * b[j]) % q;
+            }
+        }
+
+        std::vector<uint32_t> product(n);
+        scalar.multiply(a.data(), b.data(), product.data());
+        for (uint32_t i = 0; i < n; ++i) {
+            ASSERT_EQ(product[i], (expected[i] * n) % q) << "q=" << q << " n=" << n << " i=" << i;
+        }
+
+        std::vector<uint32_t> round_trip = a;
+        scalar.ntt_forward(round_trip.data());
+        for (uint32_t v : round_trip) {
+            ASSERT_LT(v, q);
+        }
+        scalar.ntt_inverse(round_trip.data());
+        for (uint32_t i = 0; i < n; ++i) {
+            ASSERT_EQ(round_trip[i], (static_cast<uint64_t>(a[i]) * n) % q);
+        }
+    }
+}
+
+// The ML-KEM mode must reproduce FIPS 203 NTT (Algorithm 9) written with plain modular
+// arithmetic, and its products must match a negacyclic schoolbook convolution
+TEST_F(NTTEngineTest, MLKEMIncompleteNTTMatchesFIPS203) {
+    const uint32_t q = MLKEMNTTEngine::MODULUS;
+    const uint32_t n = MLKEMNTTEngine::DEGREE;
+    MLKEMNTTEngine mlkem;
+    auto bitrev7 = [](uint32_t i) {
+        uint32_t rev = 0;
+        for (uint32_t bit = 0; bit < 7; ++bit) {
+            rev |= ((i >> bit) & 1) << (6 - bit);
+        }
+        return rev;
+    };
+
+    std::vector<uint32_t> a(n), b(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        a[i] = q - 1 - (i * 7919u) % q;
+        b[i] = (i * i * 31u + 5u) % q;
+    }
+
+    std::vector<uint32_t> expected = a;
+    uint32_t k = 1;
+    for (uint32_t len = 128; len >= 2; len /= 2) {
+        for (uint32_t start = 0; start < n; start += 2 * len) {
+            uint32_t zeta = mod_pow(17, bitrev7(k++), q);
+            for (uint32_t j = start; j < start + len; ++j) {
+                uint32_t t = static_cast<uint32_t>(static_cast<uint64_t>(zeta) * expected[j + len] % q);
+                expected[j + len] = (expected[j] + q - t) % q;
+                expected[j] = (expected[j] + t) % q;
+            }
+        }
+    }
+    std::vector<uint32_t> a_hat = a;
+    mlkem.ntt_forward(a_hat.data());
+    EXPECT_EQ(a_hat, expected);
+
+    std::vector<uint32_t> round_trip = a_hat;
+    mlkem.ntt_inverse(round_trip.data());
+    EXPECT_EQ(round_trip, a);
+
+    // x^256 = -1
+    std::vector<uint64_t> schoolbook(n, 0);
+    for (uint32_t i = 0; i < n; ++i) {
+        for (uint32_t j = 0; j < n; ++j) {
+            uint64_t prod = static_cast<uint64_t>(a[i]) * b[j] % q;
+            uint32_t idx = (i + j) % n;
+            schoolbook[idx] = (schoolbook[idx] + (i + j < n ? prod : q - prod)) % q;
+        }
+    }
+    std::vector<uint32_t> product(n);
+    mlkem.multiply(a.data(), b.data(), product.data());
+    for (uint32_t i = 0; i < n; ++i) {
+        ASSERT_EQ(product[i], schoolbook[i]) << "i=" << i;
+    }
+
+    // The same product through the NTT-domain API, and an accumulated row of three
+    std::vector<uint32_t> b_hat = b;
+    mlkem.ntt_forward(b_hat.data());
+    std::vector<uint32_t> via_basemul(n);
+    mlkem.basemul(a_hat.data(), b_hat.data(), via_basemul.data());
+    for (uint32_t v : via_basemul) {
+        ASSERT_LT(v, q);
+    }
+    mlkem.ntt_inverse(via_basemul.data());
+    EXPECT_EQ(via_basemul, product);
+
+    std::vector<uint32_t> row_a, row_b;
+    std::vector<uint32_t> summed(n, 0);
+    for (uint32_t j = 0; j < 3; ++j) {
+        std::vector<uint32_t> x(n), y(n), term(n);
+        for (uint32_t i = 0; i < n; ++i) {
+            x[i] = (a[i] * (j + 2) + j) % q;
+            y[i] = (b[(i + j) % n] + 17 * j) % q;
+        }
+        mlkem.basemul(x.data(), y.data(), term.data());
+        for (uint32_t i = 0; i < n; ++i) {
+            summed[i] = (summed[i] + term[i]) % q;
+        }
+        row_a.insert(row_a.end(), x.begin(), x.end());
+        row_b.insert(row_b.end(), y.begin(), y.end());
+    }
+    std::vector<uint32_t> accumulated(n);
+    mlkem.basemul_acc(row_a.data(), row_b.data(), 3, accumulated.data());
+    EXPECT_EQ(accumulated, summed);
+
+    // Aliased output
+    std::vector<uint32_t> aliased = a;
+    mlkem.multiply(aliased.data(), b.data(), aliased.data());
+    EXPECT_EQ(aliased, product);
+}
+
+// multiply_inplace transforms its own buffers; multiply and multiply_colors reuse per-thread
+// scratch, so once warm none of them touches the heap
+TEST_F(NTTEngineTest, InPlaceMultiplyDoesNotAllocate) {
+    ScalarNTTEngine scalar(modulus, degree);
+    auto optimal = create_optimal_ntt_engine(modulus, degree);
+    std::vector<uint32_t> a(degree), b(degree);
+    for (uint32_t i = 0; i < degree; ++i) {
+        a[i] = (i * 7919u + 3u) % modulus;
+        b[i] = (i * i * 31u + 5u) % modulus;
+    }
+    std::vector<uint32_t> expected(degree);
+    scalar.multiply(a.data(), b.data(), expected.data());
+
+    ASSERT_TRUE(AllocationTracker::hooks_installed());
+    const std::vector<const NTTEngine*> engines = {&scalar, optimal.get(), color_ntt.get()};
+    for (const NTTEngine* engine : engines) {
+        std::vector<uint32_t> product(degree), a_ntt = a, b_ntt = b, aliased = b;
+        engine->multiply(a.data(), b.data(), product.data());
+        {
+            AllocationTracker tracker;
+            engine->multiply(a.data(), b.data(), product.data());
+            engine->multiply_inplace(a_ntt.data(), b_ntt.data());
+            engine->multiply(a.data(), aliased.data(), aliased.data());
+            EXPECT_EQ(tracker.stats().allocations, 0u);
+        }
+        EXPECT_EQ(product, expected);
+        EXPECT_EQ(a_ntt, expected);
+        EXPECT_EQ(aliased, expected);
+
+        // b is left in the NTT domain
+        std::vector<uint32_t> b_hat = b;
+        engine->ntt_forward(b_hat.data());
+        EXPECT_EQ(b_ntt, b_hat);
+    }
+
+    std::vector<ColorValue> a_colors(degree), b_colors(degree), product_colors(degree);
+    for (uint32_t i = 0; i < degree; ++i) {
+        a_colors[i] = ColorValue::from_math_value(a[i]);
+        b_colors[i] = ColorValue::from_math_value(b[i]);
+    }
+    color_ntt->multiply_colors(a_colors.data(), b_colors.data(), product_colors.data());
+    {
+        AllocationTracker tracker;
+        color_ntt->multiply_colors(a_colors.data(), b_colors.data(), product_colors.data());
+        color_ntt->ntt_forward_colors(a_colors.data());
+        color_ntt->ntt_inverse_colors(a_colors.data());
+        EXPECT_EQ(tracker.stats().allocations, 0u);
+    }
+    for (uint32_t i = 0; i < degree; ++i) {
+        ASSERT_EQ(product_colors[i].to_math_value(), expected[i]);
+    }
+}
+
+// Batched transforms run each stage across all polynomials; results must match per-polynomial calls
+TEST_F(NTTEngineTest, BatchedNTTMatchesSingle) {
+    const size_t count = 3;
+    std::vector<std::unique_ptr<NTTEngine>> engines;
+    engines.push_back(std::make_unique<ScalarNTTEngine>(modulus, degree));
+    engines.push_back(std::make_unique<ScalarNTTEngine>(18433, 2048));
+    engines.push_back(std::make_unique<ColorNTTEngine>(modulus, degree));
+    engines.push_back(create_optimal_ntt_engine(modulus, degree));
+
+    for (const auto& engine : engines) {
+        const uint32_t q = engine->modulus();
+        const uint32_t n = engine->degree();
+        std::vector<uint32_t> polys(count * n), others(count * n);
+        for (size_t i = 0; i < polys.size(); ++i) {
+            polys[i] = static_cast<uint32_t>((i * 7919 + 13) % q);
+            others[i] = static_cast<uint32_t>((i * i * 31 + 5) % q);
+        }
+
+        std::vector<uint32_t> single = polys;
+        for (size_t p = 0; p < count; ++p) {
+            engine->ntt_forward(single.data() + p * n);
+        }
+        std::vector<uint32_t> batched = polys;
+        engine->ntt_forward_batch(batched.data(), count);
+        EXPECT_EQ(batched, single) << "q=" << q << " n=" << n;
+
+        for (size_t p = 0; p < count; ++p) {
+            engine->ntt_inverse(single.data() + p * n);
+        }
+        engine->ntt_inverse_batch(batched.data(), count);
+        EXPECT_EQ(batched, single) << "q=" << q << " n=" << n;
+
+        std::vector<uint32_t> out(n);
+        engine->basemul_acc(polys.data(), others.data(), count, out.data());
+        for (uint32_t i = 0; i < n; ++i) {
+            uint64_t expected = 0;
+            for (size_t p = 0; p < count; ++p) {
+                expected += static_cast<uint64_t>(polys[p * n + i]) * others[p * n + i];
+            }
+            ASSERT_EQ(out[i], expected % q) << "q=" << q << " n=" << n << " i=" << i;
+        }
+    }
+}
+
+// The uint32_t entry points of fused sampling and output stages skip only the color conversions
+TEST_F(NTTEngineTest, RawStagesMatchColorTransforms) {
+    const size_t count = 3;
+    std::vector<uint32_t> samples(count * degree);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = static_cast<uint32_t>((i * 40503u + 7) % modulus);
+    }
+    std::vector<ColorValue> expected(samples.size()), fused(samples.size());
+    colors_from_u32(samples.data(), expected.data(), samples.size());
+    color_ntt->ntt_forward_colors_batch(expected.data(), count);
+    std::vector<uint32_t> scratch = samples;
+    color_ntt->ntt_forward_u32_to_colors(scratch.data(), fused.data(), count);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        ASSERT_EQ(fused[i].to_math_value(), expected[i].to_math_value()) << "i=" << i;
+    }
+
+    std::vector<ColorValue> inverse = expected;
+    color_ntt->ntt_inverse_colors_batch(inverse.data(), count);
+    const uint32_t* raw = color_ntt->ntt_inverse_colors_batch_raw(expected.data(), count);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        ASSERT_EQ(raw[i], inverse[i].to_math_value()) << "i=" << i;
+    }
+}
+
+// Fused row and column dot products must equal k separate multiply-accumulates
+TEST_F(NTTEngineTest, RowDotMatchesPointwiseAccumulate) {
+    const size_t k = 3;
+    std::vector<ColorValue> matrix(k * k * degree), vec(k * degree);
+    for (size_t i = 0; i < matrix.size(); ++i) {
+        matrix[i] = ColorValue::from_math_value(static_cast<uint32_t>((i * 2654435761u) % modulus));
+    }
+    for (size_t i = 0; i < vec.size(); ++i) {
+        vec[i] = ColorValue::from_math_value(static_cast<uint32_t>((i * 40503u + 7) % modulus));
+    }
+
+    for (size_t i = 0; i < k; ++i) {
+        std::vector<ColorValue> row_expected(degree, ColorValue::from_math_value(0));
+        std::vector<ColorValue> col_expected(degree, ColorValue::from_math_value(0));
+        for (size_t j = 0; j < k; ++j) {
+            color_ntt->pointwise_multiply_accumulate_colors(matrix.data() + (i * k + j) * degree,
+                                                            vec.data() + j * degree, row_expected.data());
+            color_ntt->pointwise_multiply_accumulate_colors(matrix.data() + (j * k + i) * degree,
+                                                            vec.data() + j * degree, col_expected.data());
+        }
+
+        std::vector<ColorValue> row(degree), col(degree);
+        color_ntt->row_dot_colors(matrix.data() + i * k * degree, degree, vec.data(), k, row.data());
+        color_ntt->row_dot_colors(matrix.data() + i * degree, k * degree, vec.data(), k, col.data());
+        for (uint32_t c = 0; c < degree; ++c) {
+            ASSERT_EQ(row[c].to_math_value(), row_expected[c].to_math_value());
+            ASSERT_EQ(col[c].to_math_value(), col_expected[c].to_math_value());
+        }
+    }
+
+    // Enough terms that raw 32-bit accumulation would overflow takes the reducing path
+    ScalarNTTEngine scalar(18433, 16);
+    const size_t terms = 16;
+    std::vector<uint32_t> a(terms * 16, 18432), b(terms * 16, 18432), out(16);
+    scalar.basemul_acc(a.data(), b.data(), terms, out.data());
+    for (uint32_t v : out) {
+        EXPECT_EQ(v, terms % 18433);
+    }
+}
+
+// The compile-time (3329, 256) tables must match the generic construction, and both are shared
+TEST_F(NTTEngineTest, SharedTwiddleTables) {
+    NTTTableView standard = ntt_tables(3329, 256);
+    EXPECT_EQ(standard.zetas, ntt_tables(3329, 256).zetas);
+
+    uint32_t zeta = mod_pow(17, (3329 - 1) / 256, 3329);
+    uint32_t zeta_inv = mod_inverse(zeta, 3329);
+    uint64_t z = 1, z_inv = 1;
+    for (uint32_t i = 0; i < 256; ++i) {
+        ASSERT_EQ(standard.zetas[i], z);
+        ASSERT_EQ(standard.zetas_inv[i], z_inv);
+        z = z * zeta % 3329;
+        z_inv = z_inv * zeta_inv % 3329;
+    }
+
+    uint32_t pos = 0;
+    for (uint32_t stage = 0; stage < 8; ++stage) {
+        for (uint32_t i = 0; i < (256u >> (stage + 1)); ++i, ++pos) {
+            ASSERT_EQ(standard.stage_zetas[pos], standard.zetas[i << stage]);
+            ASSERT_EQ(standard.stage_zetas_inv[pos], standard.zetas_inv[i << stage]);
+        }
+    }
+    for (uint32_t i = 0; i < 256; ++i) {
+        ASSERT_EQ(standard.bitrev[standard.bitrev[i]], i);
+    }
+    EXPECT_EQ(standard.bitrev[1], 128u);
+
+    NTTTableView other = ntt_tables(7681, 512);
+    EXPECT_EQ(other.zetas, ntt_tables(7681, 512).zetas);
+    EXPECT_EQ(other.zetas[1], mod_pow(17, (7681 - 1) / 512, 7681));
+}
+
+// Forward output slot i is the evaluation at zeta^bitrev(i); bit_reverse puts it in natural order
+TEST_F(NTTEngineTest, ForwardOutputIsBitReversedEvaluation) {
+    const uint32_t zeta = ntt_tables(modulus, degree).zetas[1];
+    std::vector<uint32_t> natural(degree);
+    for (uint32_t k = 0; k < degree; ++k) {
+        const uint32_t point = mod_pow(zeta, k, modulus);
+        uint64_t acc = 0, power = 1;
+        for (uint32_t j = 0; j < degree; ++j) {
+            acc = (acc + coeffs[j] * power) % modulus;
+            power = power * point % modulus;
+        }
+        natural[k] = static_cast<uint32_t>(acc);
+    }
+
+    std::vector<std::unique_ptr<NTTEngine>> engines;
+    engines.push_back(create_optimal_ntt_engine(modulus, degree));
+    engines.push_back(create_ntt_engine(SIMDSupport::NONE, modulus, degree));
+    for (const auto& engine : engines) {
+        std::vector<uint32_t> poly = coeffs;
+        engine->ntt_forward(poly.data());
+        engine->bit_reverse(poly.data());
+        EXPECT_EQ(poly, natural);
+        engine->bit_reverse(poly.data());
+        engine->ntt_inverse(poly.data());
+        for (uint32_t i = 0; i < degree; ++i) {
+            ASSERT_EQ(poly[i], static_cast<uint64_t>(coeffs[i]) * degree % modulus);
+        }
+    }
+}
+
+// One immutable engine per (q, n) and one CPU feature probe per process
+// Moduli where 17 has too small an order fall back to the least generator of Z_q^*
+TEST_F(NTTEngineTest, PrimitiveRootForAnyFriendlyModulus) {
+    uint32_t root = 0;
+    EXPECT_TRUE(ntt_root(3329, 256, root));
+    EXPECT_EQ(root, mod_pow(17, 13, 3329));
+    EXPECT_FALSE(ntt_root(3329, 512, root));
+
+    const std::pair<uint32_t, uint32_t> shapes[] = {{12289, 256}, {12289, 1024}, {65537, 256}, {257, 256}};
+    for (const auto& shape : shapes) {
+        const uint32_t q = shape.first, n = shape.second;
+        ASSERT_TRUE(ntt_root(q, n, root)) << q << "/" << n;
+        EXPECT_EQ(mod_pow(root, n / 2, q), q - 1) << q << "/" << n;
+        EXPECT_EQ(ntt_tables(q, n).zetas[1], root);
+
+        std::vector<uint32_t> a(n), b(n), expected(n, 0);
+        for (uint32_t i = 0; i < n; ++i) {
+            a[i] = (i * 2654435761u) % q;
+            b[i] = (i * 40503u + 7) % q;
+        }
+        for (uint32_t i = 0; i < n; ++i) {
+            for (uint32_t j = 0; j < n; ++j) {
+                uint32_t& slot = expected[(i + j) % n];
+                slot = static_cast<uint32_t>((slot + static_cast<uint64_t>(a[i]) * b[j]) % q);
+            }
+        }
+        for (uint32_t& value : expected) {
+            value = static_cast<uint32_t>(static_cast<uint64_t>(value) * n % q);
+        }
+
+        std::vector<std::unique_ptr<NTTEngine>> engines;
+        engines.push_back(create_optimal_ntt_engine(q, n));
+        engines.push_back(create_ntt_engine(SIMDSupport::NONE, q, n));
+        for (const auto& engine : engines) {
+            std::vector<uint32_t> result(n);
+            engine->multiply(a.data(), b.data(), result.data());
+            EXPECT_EQ(result, expected) << q << "/" << n;
+        }
+    }
+
+    // The 16-bit Montgomery twiddles are built once per (q, n, lanes)
+    NTTMontgomeryTableView montgomery = ntt_montgomery_tables(3329, 256, 32);
+    EXPECT_EQ(montgomery.fwd_zetas, ntt_montgomery_tables(3329, 256, 32).fwd_zetas);
+    EXPECT_NE(montgomery.fwd_zetas, ntt_montgomery_tables(3329, 256, 8).fwd_zetas);
+    const uint32_t* stage = ntt_tables(3329, 256).stage_zetas + (256 - 2 * 64);
+    for (uint32_t i = 0; i < 64; ++i) {
+        int32_t value = montgomery.fwd_zetas[montgomery.stage_offsets[6] + i];
+        ASSERT_EQ(static_cast<uint32_t>((value + 3329) % 3329), (static_cast<uint64_t>(stage[i]) << 16) % 3329);
+    }
+}
+
+TEST_F(NTTEngineTest, SharedEngineRegistry) {
+    auto first = ColorNTTEngine::shared(modulus, degree);
+    auto second = ColorNTTEngine::shared(modulus, degree);
+    EXPECT_EQ(first.get(), second.get());
+    EXPECT_NE(first.get(), ColorNTTEngine::shared(7681, degree).get());
+    EXPECT_EQ(&CPUFeatureDetector::cached(), &CPUFeatureDetector::cached());
+    EXPECT_EQ(CPUFeatureDetector::cached().max_simd_support, CPUFeatureDetector::detect().max_simd_support);
+
+    std::vector<uint32_t> coeffs(degree), expected(degree);
+    for (uint32_t i = 0; i < degree; ++i) {
+        coeffs[i] = (i * 17 + 3) % modulus;
+    }
+    expected = coeffs;
+    color_ntt->ntt_forward(expected.data());
+    first->ntt_forward(coeffs.data());
+    EXPECT_EQ(coeffs, expected);
+}
+
+// CLWE_FORCE_BACKEND names and the feature masking they apply
+TEST_F(NTTEngineTest, BackendOverride) {
+    SIMDSupport backend = SIMDSupport::AVX512;
+    EXPECT_TRUE(CPUFeatureDetector::parse_backend("scalar", backend));
+    EXPECT_EQ(backend, SIMDSupport::NONE);
+    EXPECT_TRUE(CPUFeatureDetector::parse_backend("avx2", backend));
+    EXPECT_EQ(backend, SIMDSupport::AVX2);
+    EXPECT_TRUE(CPUFeatureDetector::parse_backend("neon", backend));
+    EXPECT_EQ(backend, SIMDSupport::NEON);
+    EXPECT_FALSE(CPUFeatureDetector::parse_backend("sse2", backend));
+    EXPECT_EQ(backend, SIMDSupport::NEON);
+    EXPECT_TRUE(CPUFeatureDetector::parse_backend("wasm_simd128", backend));
+    EXPECT_EQ(backend, SIMDSupport::WASM_SIMD128);
+    EXPECT_TRUE(CPUFeatureDetector::parse_backend("sve", backend));
+    EXPECT_EQ(backend, SIMDSupport::SVE);
+
+    CPUFeatures avx512;
+    avx512.architecture = CPUArchitecture::X86_64;
+    avx512.max_simd_support = SIMDSupport::AVX512;
+    avx512.has_avx2 = avx512.has_avx512f = avx512.has_avx512bw = true;
+
+    CPUFeatures capped = CPUFeatureDetector::restrict_to(avx512, SIMDSupport::AVX2);
+    EXPECT_EQ(capped.max_simd_support, SIMDSupport::AVX2);
+    EXPECT_TRUE(capped.has_avx2);
+    EXPECT_FALSE(capped.has_avx512f);
+    EXPECT_FALSE(capped.has_avx512bw);
+
+    CPUFeatures scalar = CPUFeatureDetector::restrict_to(avx512, SIMDSupport::NONE);
+    EXPECT_EQ(scalar.max_simd_support, SIMDSupport::NONE);
+    EXPECT_FALSE(scalar.has_avx2);
+
+    // Another family, or a level above the CPU's, enables nothing new
+    EXPECT_EQ(CPUFeatureDetector::restrict_to(avx512, SIMDSupport::NEON).max_simd_support, SIMDSupport::NONE);
+    CPUFeatures avx2_only = CPUFeatureDetector::restrict_to(avx512, SIMDSupport::AVX2);
+    EXPECT_EQ(CPUFeatureDetector::restrict_to(avx2_only, SIMDSupport::AVX512).max_simd_support, SIMDSupport::AVX2);
+
+    CPUFeatures wasm;
+    wasm.architecture = CPUArchitecture::WASM32;
+    wasm.max_simd_support = SIMDSupport::WASM_SIMD128;
+    wasm.has_wasm_simd128 = true;
+    EXPECT_TRUE(CPUFeatureDetector::restrict_to(wasm, SIMDSupport::WASM_SIMD128).has_wasm_simd128);
+    EXPECT_FALSE(CPUFeatureDetector::restrict_to(wasm, SIMDSupport::NONE).has_wasm_simd128);
+    EXPECT_EQ(CPUFeatureDetector::restrict_to(wasm, SIMDSupport::NONE).max_simd_support, SIMDSupport::NONE);
+
+    // SVE sits above NEON: capping at NEON keeps it, SVE itself keeps both
+    CPUFeatures sve;
+    sve.architecture = CPUArchitecture::ARM64;
+    sve.max_simd_support = SIMDSupport::SVE;
+    sve.has_neon = sve.has_sve = sve.has_sve2 = true;
+    sve.sve_vlen = 256;
+    CPUFeatures neon_only = CPUFeatureDetector::restrict_to(sve, SIMDSupport::NEON);
+    EXPECT_EQ(neon_only.max_simd_support, SIMDSupport::NEON);
+    EXPECT_TRUE(neon_only.has_neon);
+    EXPECT_FALSE(neon_only.has_sve);
+    EXPECT_FALSE(neon_only.has_sve2);
+    EXPECT_EQ(neon_only.sve_vlen, 0u);
+    CPUFeatures sve_kept = CPUFeatureDetector::restrict_to(sve, SIMDSupport::SVE);
+    EXPECT_EQ(sve_kept.max_simd_support, SIMDSupport::SVE);
+    EXPECT_TRUE(sve_kept.has_neon && sve_kept.has_sve);
+    EXPECT_EQ(CPUFeatureDetector::restrict_to(neon_only, SIMDSupport::SVE).max_simd_support, SIMDSupport::NEON);
+
+    // Dispatch is already latched by earlier use in this process
+    CPUFeatureDetector::cached();
+    EXPECT_THROW(CPUFeatureDetector::force_backend(SIMDSupport::NONE), std::logic_error);
+}
+
+// The shared engine follows the dispatch features, including a forced backend
+// Compile-time engines must be bit-exact with the runtime-loop scalar engine
+TEST_F(NTTEngineTest, UnrolledMatchesScalar) {
+    const std::pair<uint32_t, uint32_t> shapes[] = {{3329, 256}, {7681, 512}, {12289, 1024}};
+    for (const auto& shape : shapes) {
+        const uint32_t q = shape.first, n = shape.second;
+        std::unique_ptr<NTTEngine> unrolled = create_unrolled_ntt_engine(q, n);
+#ifdef CLWE_UNROLLED_NTT
+        ASSERT_NE(unrolled, nullptr) << q << "/" << n;
+#else
+        ASSERT_EQ(unrolled, nullptr);
+        GTEST_SKIP() << "Built without CLWE_UNROLLED_NTT";
+#endif
+        EXPECT_EQ(create_ntt_engine(SIMDSupport::NONE, q, n)->degree(), n);
+        ScalarNTTEngine scalar(q, n);
+
+        const size_t count = 3;
+        std::vector<uint32_t> a(count * n), b(count * n);
+        for (size_t i = 0; i < a.size(); ++i) {
+            a[i] = static_cast<uint32_t>((i * 2654435761u) % q);
+            b[i] = static_cast<uint32_t>((i * i * 31 + 5) % q);
+        }
+        // Extremes of the reduced range
+        a[0] = q - 1;
+        a[1] = 0;
+
+        std::vector<uint32_t> fwd_unrolled = a, fwd_scalar = a;
+        unrolled->ntt_forward_batch(fwd_unrolled.data(), count);
+        scalar.ntt_forward_batch(fwd_scalar.data(), count);
+        ASSERT_EQ(fwd_unrolled, fwd_scalar) << q << "/" << n;
+
+        std::vector<uint32_t> inv_unrolled = b, inv_scalar = b;
+        unrolled->ntt_inverse(inv_unrolled.data());
+        scalar.ntt_inverse(inv_scalar.data());
+        EXPECT_EQ(inv_unrolled, inv_scalar) << q << "/" << n;
+
+        std::vector<uint32_t> product_unrolled(n), product_scalar(n);
+        unrolled->multiply(a.data(), b.data(), product_unrolled.data());
+        scalar.multiply(a.data(), b.data(), product_scalar.data());
+        EXPECT_EQ(product_unrolled, product_scalar) << q << "/" << n;
+
+        std::vector<uint32_t> acc_unrolled(n), acc_scalar(n);
+        unrolled->basemul_acc(fwd_unrolled.data(), b.data(), count, acc_unrolled.data());
+        scalar.basemul_acc(fwd_scalar.data(), b.data(), count, acc_scalar.data());
+        EXPECT_EQ(acc_unrolled, acc_scalar) << q << "/" << n;
+    }
+    // Other shapes keep the runtime-loop engine
+    EXPECT_EQ(create_unrolled_ntt_engine(12289, 256), nullptr);
+    EXPECT_EQ(create_unrolled_ntt_engine(3329, 128), nullptr);
+}
+
+TEST_F(NTTEngineTest, DispatchFollowsForcedBackend) {
+    CPUFeatures expected = CPUFeatureDetector::detect();
+    SIMDSupport forced;
+    const char* env = std::getenv("CLWE_FORCE_BACKEND");
+    if (env != nullptr && CPUFeatureDetector::parse_backend(env, forced)) {
+        expected = CPUFeatureDetector::restrict_to(expected, forced);
+    }
+
+    const CPUFeatures& dispatch = CPUFeatureDetector::cached();
+    EXPECT_EQ(dispatch.max_simd_support, expected.max_simd_support);
+    EXPECT_EQ(dispatch.has_avx2, expected.has_avx2);
+    EXPECT_EQ(dispatch.has_avx512bw, expected.has_avx512bw);
+    EXPECT_EQ(dispatch.has_neon, expected.has_neon);
+    EXPECT_EQ(ColorNTTEngine::shared(modulus, degree)->get_simd_support(),
+              create_ntt_engine(expected.max_simd_support, modulus, degree)->get_simd_support());
+}
+
+#ifdef HAVE_AVX2
+// AVX2 backend must be bit-exact with the scalar backend
+TEST_F(NTTEngineTest, AVXMatchesScalar) {
+    if (!CPUFeatureDetector::detect().has_avx2) {
+        GTEST_SKIP() << "AVX2 not available";
+    }
+
+    ScalarNTTEngine scalar(modulus, degree);
+    AVXNTTEngine avx(modulus, degree);
+
+    std::vector<uint32_t> a(degree), b(degree);
+    for (size_t i = 0; i < degree; ++i) {
+        a[i] = (i * 1103 + 17) % modulus;
+        b[i] = (i * i * 31 + 5) % modulus;
+    }
+
+    std::vector<uint32_t> fwd_scalar = a, fwd_avx = a;
+    scalar.ntt_forward(fwd_scalar.data());
+    avx.ntt_forward(fwd_avx.data());
+    EXPECT_EQ(fwd_scalar, fwd_avx);
+
+    scalar.ntt_inverse(fwd_scalar.data());
+    avx.ntt_inverse(fwd_avx.data());
+    EXPECT_EQ(fwd_scalar, fwd_avx);
+
+    std::vector<uint32_t> prod_scalar(degree), prod_avx(degree);
+    scalar.multiply(a.data(), b.data(), prod_scalar.data());
+    avx.multiply(a.data(), b.data(), prod_avx.data());
+    EXPECT_EQ(prod_scalar, prod_avx);
+
+    EXPECT_EQ(scalar.constant_term_product(a.data(), b.data()), avx.constant_term_product(a.data(), b.data()));
+
+    // The shuffled short stages, including batches of polynomials shorter than two vectors
+    const uint32_t cases[][3] = {{3329, 16, 1}, {7681, 512, 3}, {3329, 8, 2}, {3329, 8, 3}, {12289, 32, 5}};
+    for (const auto& c : cases) {
+        ScalarNTTEngine small_scalar(c[0], c[1]);
+        AVXNTTEngine small_avx(c[0], c[1]);
+        std::vector<uint32_t> polys(c[1] * c[2]);
+        for (size_t i = 0; i < polys.size(); ++i) {
+            polys[i] = static_cast<uint32_t>((i * 7919 + 13) % c[0]);
+        }
+        std::vector<uint32_t> expected = polys;
+        for (uint32_t p = 0; p < c[2]; ++p) {
+            small_scalar.ntt_forward(expected.data() + p * c[1]);
+        }
+        small_avx.ntt_forward_batch(polys.data(), c[2]);
+        EXPECT_EQ(polys, expected) << "q=" << c[0] << " n=" << c[1] << " count=" << c[2];
+        for (uint32_t p = 0; p < c[2]; ++p) {
+            small_scalar.ntt_inverse(expected.data() + p * c[1]);
+        }
+        small_avx.ntt_inverse_batch(polys.data(), c[2]);
+        EXPECT_EQ(polys, expected) << "q=" << c[0] << " n=" << c[1] << " count=" << c[2];
+    }
+}
+#endif
+
+#ifdef HAVE_AVX512BW
+// AVX-512 backend must be bit-exact with the scalar backend on both the 16-bit path
+// (3329 and 7681, in-register-only and mixed stage counts) and the AVX2 fallback (12289)
+TEST_F(NTTEngineTest, AVX512MatchesScalar) {
+    if (!CPUFeatureDetector::detect().has_avx512bw) {
+        GTEST_SKIP() << "AVX-512BW not available";
+    }
+
+    const uint32_t cases[][2] = {{3329, 32}, {3329, 64}, {3329, 256}, {7681, 512}, {12289, 256}};
+    for (const auto& c : cases) {
+        const uint32_t q = c[0];
+        const uint32_t n = c[1];
+        ScalarNTTEngine scalar(q, n);
+        AVX512NTTEngine avx512(q, n);
+        EXPECT_EQ(avx512.get_simd_support(), SIMDSupport::AVX512);
+
+        const size_t k = 3;
+        std::vector<uint32_t> a(k * n), b(k * n);
+        for (size_t i = 0; i < k * n; ++i) {
+            a[i] = (i * 1103 + 17) % q;
+            b[i] = (i * i * 31 + 5) % q;
+        }
+        // Extremes of the input range
+        a[0] = q - 1;
+        a[1] = 0;
+        b[0] = q - 1;
+
+        std::vector<uint32_t> fwd_scalar = a, fwd_avx = a;
+        scalar.ntt_forward_batch(fwd_scalar.data(), k);
+        avx512.ntt_forward_batch(fwd_avx.data(), k);
+        EXPECT_EQ(fwd_scalar, fwd_avx) << q << "/" << n;
+
+        std::vector<uint32_t> acc_scalar(n), acc_avx(n);
+        scalar.basemul_acc(fwd_scalar.data(), b.data(), k, acc_scalar.data());
+        avx512.basemul_acc(fwd_avx.data(), b.data(), k, acc_avx.data());
+        EXPECT_EQ(acc_scalar, acc_avx) << q << "/" << n;
+
+        scalar.ntt_inverse_batch(fwd_scalar.data(), k);
+        avx512.ntt_inverse_batch(fwd_avx.data(), k);
+        EXPECT_EQ(fwd_scalar, fwd_avx) << q << "/" << n;
+
+        std::vector<uint32_t> prod_scalar(n), prod_avx(n);
+        scalar.multiply(a.data(), b.data(), prod_scalar.data());
+        avx512.multiply(a.data(), b.data(), prod_avx.data());
+        EXPECT_EQ(prod_scalar, prod_avx) << q << "/" << n;
+    }
+}
+#endif
+
+#ifdef HAVE_SVE
+// SVE backend must be bit-exact with the scalar backend on both the contiguous and the
+// gather/scatter short-stage paths (n = 16 leaves a partial vector at 512 bits and up),
+// and on the scalar fallback for q >= 2^16
+TEST_F(NTTEngineTest, SVEMatchesScalar) {
+    if (!CPUFeatureDetector::detect().has_sve) {
+        GTEST_SKIP() << "SVE not available";
+    }
+
+    const uint32_t cases[][2] = {{3329, 16}, {3329, 256}, {7681, 512}, {12289, 256}, {65537, 256}};
+    for (const auto& c : cases) {
+        const uint32_t q = c[0];
+        const uint32_t n = c[1];
+        ScalarNTTEngine scalar(q, n);
+        SVENTTEngine sve(q, n);
+        EXPECT_EQ(sve.get_simd_support(), SIMDSupport::SVE);
+        EXPECT_EQ(sve.vector_length() * 32, CPUFeatureDetector::detect().sve_vlen);
+
+        const size_t k = 3;
+        std::vector<uint32_t> a(k * n), b(k * n);
+        for (size_t i = 0; i < k * n; ++i) {
+            a[i] = (i * 1103 + 17) % q;
+            b[i] = (i * i * 31 + 5) % q;
+        }
+        a[0] = q - 1;
+        a[1] = 0;
+        b[0] = q - 1;
+
+        std::vector<uint32_t> fwd_scalar = a, fwd_sve = a;
+        scalar.ntt_forward_batch(fwd_scalar.data(), k);
+        sve.ntt_forward_batch(fwd_sve.data(), k);
+        EXPECT_EQ(fwd_scalar, fwd_sve) << q << "/" << n;
+
+        std::vector<uint32_t> acc_scalar(n), acc_sve(n);
+        scalar.basemul_acc(fwd_scalar.data(), b.data(), k, acc_scalar.data());
+        sve.basemul_acc(fwd_sve.data(), b.data(), k, acc_sve.data());
+        EXPECT_EQ(acc_scalar, acc_sve) << q << "/" << n;
+
+        scalar.ntt_inverse_batch(fwd_scalar.data(), k);
+        sve.ntt_inverse_batch(fwd_sve.data(), k);
+        EXPECT_EQ(fwd_scalar, fwd_sve) << q << "/" << n;
+
+        std::vector<uint32_t> prod_scalar(n), prod_sve(n);
+        scalar.multiply(a.data(), b.data(), prod_scalar.data());
+        sve.multiply(a.data(), b.data(), prod_sve.data());
+        EXPECT_EQ(prod_scalar, prod_sve) << q << "/" << n;
+    }
+}
+#endif
+
+#ifdef HAVE_RVV
+// RVV backend must be bit-exact with the scalar backend on both the contiguous and the
+// strided short-stage paths, and on the scalar fallback for q >= 2^16
+TEST_F(NTTEngineTest, RVVMatchesScalar) {
+    if (!CPUFeatureDetector::detect().has_rvv) {
+        GTEST_SKIP() << "RVV not available";
+    }
+
+    const uint32_t cases[][2] = {{3329, 32}, {3329, 256}, {7681, 512}, {65537, 256}};
+    for (const auto& c : cases) {
+        const uint32_t q = c[0];
+        const uint32_t n = c[1];
+        ScalarNTTEngine scalar(q, n);
+        RVVNTTEngine rvv(q, n);
+        EXPECT_EQ(rvv.get_simd_support(), SIMDSupport::RVV);
+        EXPECT_GT(rvv.vector_length(), 0u);
+
+        const size_t k = 3;
+        std::vector<uint32_t> a(k * n), b(k * n);
+        for (size_t i = 0; i < k * n; ++i) {
+            a[i] = (i * 1103 + 17) % q;
+            b[i] = (i * i * 31 + 5) % q;
+        }
+        a[0] = q - 1;
+        a[1] = 0;
+        b[0] = q - 1;
+
+        std::vector<uint32_t> fwd_scalar = a, fwd_rvv = a;
+        scalar.ntt_forward_batch(fwd_scalar.data(), k);
+        rvv.ntt_forward_batch(fwd_rvv.data(), k);
+        EXPECT_EQ(fwd_scalar, fwd_rvv) << q << "/" << n;
+
+        std::vector<uint32_t> acc_scalar(n), acc_rvv(n);
+        scalar.basemul_acc(fwd_scalar.data(), b.data(), k, acc_scalar.data());
+        rvv.basemul_acc(fwd_rvv.data(), b.data(), k, acc_rvv.data());
+        EXPECT_EQ(acc_scalar, acc_rvv) << q << "/" << n;
+
+        scalar.ntt_inverse_batch(fwd_scalar.data(), k);
+        rvv.ntt_inverse_batch(fwd_rvv.data(), k);
+        EXPECT_EQ(fwd_scalar, fwd_rvv) << q << "/" << n;
+
+        std::vector<uint32_t> prod_scalar(n), prod_rvv(n);
+        scalar.multiply(a.data(), b.data(), prod_scalar.data());
+        rvv.multiply(a.data(), b.data(), prod_rvv.data());
+        EXPECT_EQ(prod_scalar, prod_rvv) << q << "/" << n;
+    }
+}
+#endif
+
+#ifdef HAVE_VSX
+// VSX backend must be bit-exact with the scalar backend, including the paired k = 2 / k = 1
+// stages (n = 8 has no wide stage) and the scalar fallback for q >= 2^16
+TEST_F(NTTEngineTest, VSXMatchesScalar) {
+    if (!CPUFeatureDetector::detect().has_vsx) {
+        GTEST_SKIP() << "VSX not available";
+    }
+
+    const uint32_t cases[][2] = {{3329, 8}, {3329, 32}, {3329, 256}, {7681, 512}, {65537, 256}};
+    for (const auto& c : cases) {
+        const uint32_t q = c[0];
+        const uint32_t n = c[1];
+        ScalarNTTEngine scalar(q, n);
+        VSXNTTEngine vsx(q, n);
+        EXPECT_EQ(vsx.get_simd_support(), SIMDSupport::VSX);
+
+        const size_t k = 3;
+        std::vector<uint32_t> a(k * n), b(k * n);
+        for (size_t i = 0; i < k * n; ++i) {
+            a[i] = (i * 1103 + 17) % q;
+            b[i] = (i * i * 31 + 5) % q;
+        }
+        a[0] = q - 1;
+        a[1] = 0;
+        b[0] = q - 1;
+
+        std::vector<uint32_t> fwd_scalar = a, fwd_vsx = a;
+        scalar.ntt_forward_batch(fwd_scalar.data(), k);
+        vsx.ntt_forward_batch(fwd_vsx.data(), k);
+        EXPECT_EQ(fwd_scalar, fwd_vsx) << q << "/" << n;
+
+        std::vector<uint32_t> acc_scalar(n), acc_vsx(n);
+        scalar.basemul_acc(fwd_scalar.data(), b.data(), k, acc_scalar.data());
+        vsx.basemul_acc(fwd_vsx.data(), b.data(), k, acc_vsx.data());
+        EXPECT_EQ(acc_scalar, acc_vsx) << q << "/" << n;
+
+        scalar.ntt_inverse_batch(fwd_scalar.data(), k);
+        vsx.ntt_inverse_batch(fwd_vsx.data(), k);
+        EXPECT_EQ(fwd_scalar, fwd_vsx) << q << "/" << n;
+
+        std::vector<uint32_t> prod_scalar(n), prod_vsx(n);
+        scalar.multiply(a.data(), b.data(), prod_scalar.data());
+        vsx.multiply(a.data(), b.data(), prod_vsx.data());
+        EXPECT_EQ(prod_scalar, prod_vsx) << q << "/" << n;
+    }
+}
+#endif
+
+// Portable-vector engine must be bit-exact with the scalar backend on every build, including
+// the scalar stages shorter than the lanes and the scalar fallback for q >= 2^16
+TEST_F(NTTEngineTest, PortableSIMDMatchesScalar) {
+    const uint32_t cases[][2] = {{3329, 8}, {3329, 32}, {3329, 256}, {7681, 512}, {65537, 256}};
+    for (const auto& c : cases) {
+        const uint32_t q = c[0];
+        const uint32_t n = c[1];
+        ScalarNTTEngine scalar(q, n);
+        PortableNTTEngine portable(q, n);
+        EXPECT_EQ(portable.get_simd_support(), SIMDSupport::NONE);
+
+        const size_t k = 3;
+        std::vector<uint32_t> a(k * n), b(k * n);
+        for (size_t i = 0; i < k * n; ++i) {
+            a[i] = (i * 1103 + 17) % q;
+            b[i] = (i * i * 31 + 5) % q;
+        }
+        a[0] = q - 1;
+        a[1] = 0;
+        b[0] = q - 1;
+
+        std::vector<uint32_t> fwd_scalar = a, fwd_portable = a;
+        scalar.ntt_forward_batch(fwd_scalar.data(), k);
+        portable.ntt_forward_batch(fwd_portable.data(), k);
+        EXPECT_EQ(fwd_scalar, fwd_portable) << q << "/" << n;
+
+        std::vector<uint32_t> acc_scalar(n), acc_portable(n);
+        scalar.basemul_acc(fwd_scalar.data(), b.data(), k, acc_scalar.data());
+        portable.basemul_acc(fwd_portable.data(), b.data(), k, acc_portable.data());
+        EXPECT_EQ(acc_scalar, acc_portable) << q << "/" << n;
+
+        scalar.ntt_inverse_batch(fwd_scalar.data(), k);
+        portable.ntt_inverse_batch(fwd_portable.data(), k);
+        EXPECT_EQ(fwd_scalar, fwd_portable) << q << "/" << n;
+
+        std::vector<uint32_t> prod_scalar(n), prod_portable(n);
+        scalar.multiply(a.data(), b.data(), prod_scalar.data());
+        portable.multiply(a.data(), b.data(), prod_portable.data());
+        EXPECT_EQ(prod_scalar, prod_portable) << q << "/" << n;
+    }
+}
+
+#ifdef HAVE_WASM_SIMD128
+// WebAssembly SIMD128 backend must be bit-exact with the scalar backend, including the paired
+// k = 2 / k = 1 stages (n = 8 has no wide stage) and the scalar fallback for q >= 2^16
+TEST_F(NTTEngineTest, WasmSIMD128MatchesScalar) {
+    if (!CPUFeatureDetector::detect().has_wasm_simd128) {
+        GTEST_SKIP() << "WebAssembly SIMD128 not available";
+    }
+
+    const uint32_t cases[][2] = {{3329, 8}, {3329, 32}, {3329, 256}, {7681, 512}, {65537, 256}};
+    for (const auto& c : cases) {
+        const uint32_t q = c[0];
+        const uint32_t n = c[1];
+        ScalarNTTEngine scalar(q, n);
+        WasmSIMD128NTTEngine wasm(q, n);
+        EXPECT_EQ(wasm.get_simd_support(), SIMDSupport::WASM_SIMD128);
+
+        const size_t k = 3;
+        std::vector<uint32_t> a(k * n), b(k * n);
+        for (size_t i = 0; i < k * n; ++i) {
+            a[i] = (i * 1103 + 17) % q;
+            b[i] = (i * i * 31 + 5) % q;
+        }
+        a[0] = q - 1;
+        a[1] = 0;
+        b[0] = q - 1;
+
+        std::vector<uint32_t> fwd_scalar = a, fwd_wasm = a;
+        scalar.ntt_forward_batch(fwd_scalar.data(), k);
+        wasm.ntt_forward_batch(fwd_wasm.data(), k);
+        EXPECT_EQ(fwd_scalar, fwd_wasm) << q << "/" << n;
+
+        std::vector<uint32_t> acc_scalar(n), acc_wasm(n);
+        scalar.basemul_acc(fwd_scalar.data(), b.data(), k, acc_scalar.data());
+        wasm.basemul_acc(fwd_wasm.data(), b.data(), k, acc_wasm.data());
+        EXPECT_EQ(acc_scalar, acc_wasm) << q << "/" << n;
+
+        scalar.ntt_inverse_batch(fwd_scalar.data(), k);
+        wasm.ntt_inverse_batch(fwd_wasm.data(), k);
+        EXPECT_EQ(fwd_scalar, fwd_wasm) << q << "/" << n;
+
+        std::vector<uint32_t> prod_scalar(n), prod_wasm(n);
+        scalar.multiply(a.data(), b.data(), prod_scalar.data());
+        wasm.multiply(a.data(), b.data(), prod_wasm.data());
+        EXPECT_EQ(prod_scalar, prod_wasm) << q << "/" << n;
+    }
+}
+#endif
+
+#ifdef HAVE_NEON
+// NEON backend must be bit-exact with the scalar backend on the int16 path (3329 and 7681,
+// down to n = 16), the lazy 32-bit path beyond it (n = 2048, 12289) and q >= 2^16
+TEST_F(NTTEngineTest, NEONMatchesScalar) {
+    if (!CPUFeatureDetector::detect().has_neon) {
+        GTEST_SKIP() << "NEON not available";
+    }
+
+    const uint32_t cases[][2] = {{3329, 16}, {3329, 256}, {7681, 512}, {3329, 2048}, {12289, 256}, {65537, 256}};
+    for (const auto& c : cases) {
+        const uint32_t q = c[0];
+        const uint32_t n = c[1];
+        ScalarNTTEngine scalar(q, n);
+        NEONNTTEngine neon(q, n);
+        EXPECT_EQ(neon.get_simd_support(), SIMDSupport::NEON);
+
+        const size_t k = 3;
+        std::vector<uint32_t> a(k * n), b(k * n);
+        for (size_t i = 0; i < k * n; ++i) {
+            a[i] = (i * 1103 + 17) % q;
+            b[i] = (i * i * 31 + 5) % q;
+        }
+        a[0] = q - 1;
+        a[1] = 0;
+        b[0] = q - 1;
+
+        std::vector<uint32_t> fwd_scalar = a, fwd_neon = a;
+        scalar.ntt_forward_batch(fwd_scalar.data(), k);
+        neon.ntt_forward_batch(fwd_neon.data(), k);
+        EXPECT_EQ(fwd_scalar, fwd_neon) << q << "/" << n;
+
+        std::vector<uint32_t> acc_scalar(n), acc_neon(n);
+        scalar.basemul_acc(fwd_scalar.data(), b.data(), k, acc_scalar.data());
+        neon.basemul_acc(fwd_neon.data(), b.data(), k, acc_neon.data());
+        EXPECT_EQ(acc_scalar, acc_neon) << q << "/" << n;
+
+        scalar.ntt_inverse_batch(fwd_scalar.data(), k);
+        neon.ntt_inverse_batch(fwd_neon.data(), k);
+        EXPECT_EQ(fwd_scalar, fwd_neon) << q << "/" << n;
+
+        std::vector<uint32_t> prod_scalar(n), prod_neon(n);
+        scalar.multiply(a.data(), b.data(), prod_scalar.data());
+        neon.multiply(a.data(), b.data(), prod_neon.data());
+        EXPECT_EQ(prod_scalar, prod_neon) << q << "/" << n;
+    }
+}
+#endif
+
 } // namespace clwe
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include "numa_kem.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace clwe {
+
+TEST(NumaTopologyTest, ReportsConsistentNodes) {
+    const size_t nodes = numa_node_count();
+    ASSERT_GE(nodes, 1u);
+    EXPECT_LT(current_numa_node(), nodes);
+    for (size_t node = 0; node < nodes; ++node) {
+        EXPECT_GE(numa_node_cpu_count(node), 1u);
+    }
+    EXPECT_EQ(numa_node_cpu_count(nodes), 0u);
+    EXPECT_FALSE(bind_thread_to_numa_node(nodes));
+}
+
+// A bound thread reports the node it was bound to
+TEST(NumaTopologyTest, RunOnNodeBindsThread) {
+    for (size_t node = 0; node < numa_node_count(); ++node) {
+        size_t observed = SIZE_MAX;
+        run_on_numa_node(node, [&] { observed = current_numa_node(); });
+        EXPECT_EQ(observed, node);
+    }
+    EXPECT_THROW(run_on_numa_node(0, [] { throw std::runtime_error("inner"); }), std::runtime_error);
+}
+
+TEST(NumaTopologyTest, KeygenPoolOnNode) {
+    KeygenPoolConfig config;
+    config.capacity = 8;
+    config.low_watermark = 2;
+    config.high_watermark = 4;
+    config.worker_threads = 1;
+    config.batch_size = 2;
+    config.numa_node = numa_node_count() - 1;
+    KeygenPool pool(CLWEParameters(512), config);
+    ASSERT_TRUE(pool.wait_ready(4, std::chrono::milliseconds(30000)));
+
+    ColorKEM kem(CLWEParameters(512));
+    auto keys = pool.pop();
+    auto [ciphertext, secret] = kem.encapsulate(keys.first);
+    EXPECT_EQ(kem.decapsulate(keys.first, keys.second, ciphertext), secret);
+
+    config.numa_node = numa_node_count();
+    EXPECT_THROW(KeygenPool(CLWEParameters(512), config), std::invalid_argument);
+}
+
+// Shards give the same bytes as a plain ColorKEM, with the executor in use at ML-KEM-1024
+TEST(NumaKemShardsTest, ShardsMatchPlainKem) {
+    NumaShardConfig config;
+    config.executor_threads = 2;
+    NumaKemShards shards(CLWEParameters(1024), config);
+    ASSERT_EQ(shards.node_count(), numa_node_count());
+    EXPECT_FALSE(shards.has_key_pools());
+    EXPECT_THROW(shards.key_pool(), std::logic_error);
+    EXPECT_THROW(shards.kem(shards.node_count()), std::invalid_argument);
+
+    ColorKEM plain(CLWEParameters(1024));
+    std::array<uint8_t, 32> d{};
+    std::array<uint8_t, 32> m{};
+    d[0] = 0x5a;
+    auto keys = plain.keygen_derand(d);
+    auto encapsulated = plain.encapsulate_derand(keys.first, m);
+    for (size_t node = 0; node < shards.node_count(); ++node) {
+        ColorKEM& kem = shards.kem(node);
+        auto shard_keys = kem.keygen_derand(d);
+        EXPECT_EQ(shard_keys.first.public_data, keys.first.public_data);
+        EXPECT_EQ(shard_keys.second.secret_data, keys.second.secret_data);
+        auto shard_encapsulated = kem.encapsulate_derand(keys.first, m);
+        EXPECT_EQ(shard_encapsulated.first.ciphertext_data, encapsulated.first.ciphertext_data);
+        EXPECT_EQ(kem.decapsulate(keys.first, keys.second, encapsulated.first), encapsulated.second);
+    }
+}
+
+// Concurrent callers share each node's executor and key pool
+TEST(NumaKemShardsTest, ConcurrentRoutedRoundTrips) {
+    NumaShardConfig config;
+    config.executor_threads = 2;
+    config.key_pools = true;
+    config.key_pool.capacity = 8;
+    config.key_pool.low_watermark = 2;
+    config.key_pool.high_watermark = 4;
+    config.key_pool.worker_threads = 1;
+    config.key_pool.batch_size = 2;
+    NumaKemShards shards(CLWEParameters(768), config);
+    ASSERT_TRUE(shards.has_key_pools());
+    EXPECT_EQ(shards.key_pool(0).params().security_level, 768u);
+
+    std::atomic<int> failures{0};
+    std::vector<std::thread> callers;
+    for (int t = 0; t < 4; ++t) {
+        callers.emplace_back([&] {
+            for (int i = 0; i < 3; ++i) {
+                auto keys = shards.pop_keys();
+                auto [ciphertext, secret] = shards.kem().encapsulate(keys.first);
+                if (!(shards.kem().decapsulate(keys.first, keys.second, ciphertext) == secret)) {
+                    ++failures;
+                }
+            }
+        });
+    }
+    for (auto& caller : callers) {
+        caller.join();
+    }
+    EXPECT_EQ(failures.load(), 0);
+}
+
+} // namespace clwe
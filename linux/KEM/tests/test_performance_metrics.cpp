@@ -1,8 +1,13 @@
 #include <gtest/gtest.h>
 #include "performance_metrics.hpp"
+#include "allocation_tracker.hpp"
+#include <algorithm>
 #include <thread>
 #include <chrono>
 #include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <vector>
 
 using namespace clwe;
 
@@ -135,4 +140,215 @@ TEST_F(PerformanceMetricsTest, MultipleIterations) {
     double ratio = timing_5.average_time / timing_10.average_time;
     EXPECT_TRUE(ratio > 0.5 || std::isnan(ratio));
     EXPECT_TRUE(ratio < 2.0 || std::isnan(ratio));
-}
\ No newline at end of file
+}
+// Test per-call allocation counting through the linked allocation hooks
+TEST_F(PerformanceMetricsTest, AllocationTracking) {
+    ASSERT_TRUE(AllocationTracker::hooks_installed());
+
+    auto operation = []() {
+        std::vector<int> data(1000, 42);
+        std::vector<int> more(500, 7);
+        (void)data;
+        (void)more;
+    };
+
+    MemoryStats mem_stats;
+    PerformanceMetrics::time_operation_with_memory(operation, mem_stats, 4);
+    EXPECT_EQ(mem_stats.allocations, 8u);
+    EXPECT_EQ(mem_stats.bytes_allocated, 4 * 1500 * sizeof(int));
+    EXPECT_GE(mem_stats.peak_live_bytes, 1500 * sizeof(int));
+
+    MemoryStats quiet_stats;
+    PerformanceMetrics::time_operation_with_memory([]() {}, quiet_stats, 3);
+    EXPECT_EQ(quiet_stats.allocations, 0u);
+    EXPECT_EQ(quiet_stats.peak_live_bytes, 0u);
+
+    AllocationTracker tracker;
+    EXPECT_THROW(AllocationTracker(), std::logic_error);
+}
+
+// Test histogram bucketing and percentile lookup
+TEST_F(PerformanceMetricsTest, LatencyHistogramPercentiles) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(histogram.value_at_percentile(50.0), 0u);
+
+    for (uint64_t v = 1; v <= 1000; ++v) {
+        histogram.record(v * 1000);
+    }
+    EXPECT_EQ(histogram.count(), 1000u);
+
+    // Relative error of a bucket midpoint is below 2^-SUB_BUCKET_BITS
+    const double tolerance = 1.0 / LatencyHistogram::SUB_BUCKETS;
+    const double expected[] = {50.0, 90.0, 99.0, 99.9};
+    for (double percentile : expected) {
+        double value = static_cast<double>(histogram.value_at_percentile(percentile));
+        double exact = percentile * 10.0 * 1000.0;
+        EXPECT_NEAR(value, exact, exact * tolerance) << percentile;
+    }
+
+    // Small values are exact, and every value maps to a bucket that covers it
+    EXPECT_EQ(LatencyHistogram::bucket_midpoint(LatencyHistogram::bucket_index(7)), 7u);
+    EXPECT_LT(LatencyHistogram::bucket_index(UINT64_MAX), LatencyHistogram::BUCKET_COUNT);
+    EXPECT_EQ(histogram.count_above(2000000), 0u);
+    EXPECT_EQ(histogram.count_above(0), 1000u);
+
+    // Merging two halves gives the same distribution as recording everything in one
+    LatencyHistogram low, high;
+    for (uint64_t i = 1; i <= 1000; ++i) {
+        (i <= 500 ? low : high).record(i * 1000);
+    }
+    low.merge(high);
+    EXPECT_EQ(low.count(), histogram.count());
+    for (double percentile : expected) {
+        EXPECT_EQ(low.value_at_percentile(percentile), histogram.value_at_percentile(percentile));
+    }
+}
+
+// Test distribution fields, warm-up runs and outlier counting
+TEST_F(PerformanceMetricsTest, TimeOperationDistribution) {
+    int calls = 0;
+    auto operation = [&calls]() {
+        ++calls;
+        if (calls == 15) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    };
+
+    TimingStats timing = PerformanceMetrics::time_operation(operation, 40, 10);
+    EXPECT_EQ(calls, 50);
+    EXPECT_LE(timing.min_time, timing.p50_time);
+    EXPECT_LE(timing.p50_time, timing.p90_time);
+    EXPECT_LE(timing.p90_time, timing.p99_time);
+    EXPECT_LE(timing.p99_time, timing.p999_time);
+    EXPECT_LE(timing.p999_time, timing.max_time);
+    EXPECT_GE(timing.max_time, 5000.0);
+    EXPECT_GT(timing.stddev_time, 0.0);
+    EXPECT_GE(timing.outliers, 1u);
+}
+
+// Test the callable templates with a move-only operation, which std::function cannot hold,
+// and that a batched sample counts as the mean of its calls
+TEST_F(PerformanceMetricsTest, TemplatedAndBatchedTiming) {
+    int calls = 0;
+    std::unique_ptr<int> state(new int(0));
+    auto operation = [&calls, state = std::move(state)]() {
+        ++calls;
+        *state += calls;
+        do_not_optimize(*state);
+    };
+
+    EXPECT_GE(PerformanceMetrics::time_operation(operation, 10, 2).average_time, 0.0);
+    EXPECT_EQ(calls, 12);
+    EXPECT_GT(PerformanceMetrics::time_operation_cycles(operation, 5).total_cycles, 0u);
+    EXPECT_EQ(calls, 17);
+    MemoryStats mem_stats;
+    PerformanceMetrics::time_operation_with_memory(operation, mem_stats, 3);
+    EXPECT_EQ(calls, 20);
+    EXPECT_EQ(mem_stats.allocations, 0u);
+
+    calls = 0;
+    TimingStats batched = PerformanceMetrics::time_operation_batched(operation, 20, 50, 5);
+    EXPECT_EQ(calls, 5 + 20 * 50);
+    EXPECT_LE(batched.min_time, batched.p50_time);
+    EXPECT_LE(batched.p50_time, batched.max_time);
+    EXPECT_GE(batched.total_time, 20 * 50 * batched.min_time);
+
+    // One 2 ms sleep per batch of 4 shows up as 0.5 ms per call
+    int batch_calls = 0;
+    TimingStats sleepy = PerformanceMetrics::time_operation_batched([&batch_calls]() {
+        if (batch_calls++ % 4 == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }, 3, 4);
+    EXPECT_GE(sleepy.min_time, 500.0);
+    EXPECT_LT(sleepy.min_time, 2000.0);
+    EXPECT_GE(sleepy.total_time, 3 * 2000.0);
+}
+
+// Test that samples a coarse clock reads as zero report no throughput rather than inf
+TEST_F(PerformanceMetricsTest, ZeroDurationSamples) {
+    TimingAccumulator timing;
+    const auto now = std::chrono::steady_clock::now();
+    for (int i = 0; i < 4; ++i) {
+        timing.record(now, now, 8);
+    }
+    TimingStats stats = timing.summarize();
+    EXPECT_EQ(stats.average_time, 0.0);
+    EXPECT_EQ(stats.throughput, 0.0);
+}
+
+// Test cold-cache timing: one eviction ahead of every timed run, outside the timing
+TEST_F(PerformanceMetricsTest, TimeOperationCold) {
+    CacheEvictor evictor(size_t(1) << 20);
+    EXPECT_EQ(evictor.size(), size_t(1) << 20);
+    EXPECT_GE(CacheEvictor().size(), std::max<size_t>(size_t(32) << 20, 4 * CacheEvictor::last_level_cache_bytes()));
+
+    int calls = 0;
+    TimingStats timing = PerformanceMetrics::time_operation_cold([&calls]() { ++calls; }, evictor, 20);
+    EXPECT_EQ(calls, 20);
+    EXPECT_LE(timing.min_time, timing.p50_time);
+    EXPECT_LE(timing.p50_time, timing.max_time);
+    // Evicting 1 MiB takes far longer than an empty operation, and none of it is counted
+    TimingStats eviction = PerformanceMetrics::time_operation([&evictor]() { evictor.evict(); }, 20);
+    EXPECT_LT(timing.p50_time, eviction.p50_time);
+}
+
+// Test hardware counters; perf_event_open is often denied in containers
+TEST_F(PerformanceMetricsTest, HardwareCounters) {
+    volatile uint64_t sink = 0;
+    auto operation = [&sink]() {
+        for (int i = 0; i < 1000; ++i) {
+            sink = sink + static_cast<uint64_t>(i) * 3;
+        }
+    };
+
+    HardwareCounterStats counters = PerformanceMetrics::measure_hardware_counters(operation, 20);
+    if (!counters.available) {
+        EXPECT_EQ(counters.cycles, 0.0);
+        EXPECT_EQ(counters.instructions, 0.0);
+        EXPECT_FALSE(counters.cache_misses_available);
+        GTEST_SKIP() << "hardware counters not available";
+    }
+    EXPECT_GT(counters.cycles, 0.0);
+    EXPECT_GT(counters.instructions, 1000.0);
+    EXPECT_GT(counters.ipc, 0.0);
+    EXPECT_GE(counters.branch_misses, 0.0);
+}
+
+// Test energy measurement through an installed reader, then the platform source
+TEST_F(PerformanceMetricsTest, EnergyMeasurement) {
+    uint64_t calls = 0;
+    auto operation = [&calls]() { ++calls; };
+
+    // A sensor that charges exactly 250 microjoules per operation
+    PerformanceMetrics::set_energy_reader([&calls](double& joules) {
+        joules = static_cast<double>(calls) * 250e-6;
+        return true;
+    });
+    EnergyStats energy = PerformanceMetrics::measure_energy(operation, 10);
+    EXPECT_TRUE(energy.available);
+    EXPECT_STREQ(energy.source, "external");
+    EXPECT_GE(energy.operations, 10u);
+    EXPECT_EQ(energy.operations, calls);
+    EXPECT_NEAR(energy.microjoules_per_operation, 250.0, 1e-6);
+    EXPECT_NEAR(energy.total_joules, static_cast<double>(calls) * 250e-6, 1e-9);
+    EXPECT_GT(energy.average_watts, 0.0);
+
+    auto combined = PerformanceMetrics::measure_operation(operation, 5);
+    EXPECT_TRUE(combined.energy.available);
+    EXPECT_NEAR(combined.energy.microjoules_per_operation, 250.0, 1e-6);
+
+    // A failing sensor reports unavailable
+    PerformanceMetrics::set_energy_reader([](double&) { return false; });
+    EXPECT_FALSE(PerformanceMetrics::measure_energy(operation, 10).available);
+
+    PerformanceMetrics::set_energy_reader({});
+    energy = PerformanceMetrics::measure_energy(operation, 10);
+    if (!energy.available) {
+        EXPECT_EQ(energy.operations, 0u);
+        EXPECT_EQ(energy.total_joules, 0.0);
+        GTEST_SKIP() << "no platform energy counter readable";
+    }
+    EXPECT_STREQ(energy.source, "rapl");
+    EXPECT_GE(energy.total_joules, 0.0);
+}
@@ -0,0 +1,255 @@
+#include <gtest/gtest.h>
+#include "poly.hpp"
+#include "encoding.hpp"
+#include "kem_arena.hpp"
+#include "ring_operations.hpp"
+#include "utils.hpp"
+#include <stdexcept>
+#include <cstdint>
+#include <vector>
+
+namespace clwe {
+
+class PolyTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        degree = 256;
+        rank = 3;
+    }
+
+    uint32_t degree;
+    uint32_t rank;
+};
+
+// Test that every container is one aligned block starting at zero
+TEST_F(PolyTest, AlignedZeroInitialized) {
+    Poly poly(degree);
+    PolyVec vec(rank, degree);
+    PolyMatrix matrix(rank, degree);
+
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(poly.data()) % POLY_ALIGNMENT, 0u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(vec.data()) % POLY_ALIGNMENT, 0u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(matrix.data()) % POLY_ALIGNMENT, 0u);
+
+    for (uint32_t d = 0; d < degree; ++d) {
+        EXPECT_EQ(poly[d].to_math_value(), 0u);
+    }
+    for (size_t c = 0; c < vec.coeff_count(); ++c) {
+        EXPECT_EQ(vec.data()[c].to_math_value(), 0u);
+    }
+}
+
+// Test contiguous layout of vectors and matrices
+TEST_F(PolyTest, ContiguousLayout) {
+    PolyVec vec(rank, degree);
+    EXPECT_EQ(vec.coeff_count(), static_cast<size_t>(rank) * degree);
+    for (uint32_t i = 0; i < rank; ++i) {
+        EXPECT_EQ(vec[i], vec.data() + i * degree);
+    }
+
+    PolyMatrix matrix(rank, degree);
+    for (uint32_t i = 0; i < rank; ++i) {
+        for (uint32_t j = 0; j < rank; ++j) {
+            EXPECT_EQ(matrix.at(i, j), matrix.data() + (i * rank + j) * degree);
+        }
+    }
+}
+
+// Test deep copy and move semantics
+TEST_F(PolyTest, CopyAndMove) {
+    PolyVec vec(rank, degree);
+    vec[1][7] = ColorValue::from_math_value(1234);
+
+    PolyVec copy = vec;
+    EXPECT_NE(copy.data(), vec.data());
+    EXPECT_EQ(copy[1][7].to_math_value(), 1234u);
+
+    copy[1][7] = ColorValue::from_math_value(42);
+    EXPECT_EQ(vec[1][7].to_math_value(), 1234u);
+
+    const ColorValue* original = vec.data();
+    PolyVec moved = std::move(vec);
+    EXPECT_EQ(moved.data(), original);
+    EXPECT_EQ(moved.rank(), rank);
+    EXPECT_EQ(moved[1][7].to_math_value(), 1234u);
+}
+
+// Test arena-backed containers: one bump region, zeroed blocks, wiped on reset
+TEST_F(PolyTest, ArenaBackedContainers) {
+    const size_t vec_bytes = static_cast<size_t>(rank) * degree * sizeof(ColorValue);
+    const size_t matrix_bytes = static_cast<size_t>(rank) * rank * degree * sizeof(ColorValue);
+    KemArena arena(KemArena::block_size(vec_bytes) + KemArena::block_size(matrix_bytes) + 64);
+
+    PolyVec vec(rank, degree, arena);
+    PolyMatrix matrix(rank, degree, arena);
+    EXPECT_EQ(arena.used(), KemArena::block_size(vec_bytes) + KemArena::block_size(matrix_bytes));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(vec.data()) % POLY_ALIGNMENT, 0u);
+    EXPECT_EQ(reinterpret_cast<uint8_t*>(matrix.data()), reinterpret_cast<uint8_t*>(vec.data()) + vec_bytes);
+    for (size_t c = 0; c < vec.coeff_count(); ++c) {
+        EXPECT_EQ(vec.data()[c].to_math_value(), 0u);
+    }
+
+    // A poly-sized block no longer fits in the remaining 64 bytes
+    EXPECT_THROW(Poly(degree, arena), std::logic_error);
+    EXPECT_THROW(arena.reserve(2 * arena.capacity()), std::logic_error);
+
+    vec[2][5] = ColorValue::from_math_value(3328);
+    PolyVec copy = vec;
+    EXPECT_NE(copy.data(), vec.data());
+
+    // reset() wipes in place; copies own their storage and survive it
+    ColorValue* raw = vec.data();
+    arena.reset();
+    EXPECT_EQ(arena.used(), 0u);
+    EXPECT_EQ(raw[2 * degree + 5].to_math_value(), 0u);
+    EXPECT_EQ(copy[2][5].to_math_value(), 3328u);
+
+    Poly reused(degree, arena);
+    EXPECT_EQ(reused.data(), raw);
+}
+
+// Test that the ring operations match plain modular arithmetic on unreduced inputs,
+// including the scalar tail after the vector kernels and in-place use
+TEST_F(PolyTest, RingOperationsMatchReference) {
+    for (uint32_t q : {3329u, 7681u, 65521u}) {
+        const size_t count = 3 * degree + 5;
+        std::vector<ColorValue> a(count), b(count), out(count);
+        uint32_t state = 0x9E3779B9u ^ q;
+        for (size_t i = 0; i < count; ++i) {
+            state = state * 1664525u + 1013904223u;
+            a[i] = ColorValue::from_math_value(i % 7 == 0 ? 0xFFFFFFFFu - static_cast<uint32_t>(i) : state);
+            state = state * 1664525u + 1013904223u;
+            b[i] = ColorValue::from_math_value(i % 5 == 0 ? static_cast<uint32_t>(i) % q : state);
+        }
+        const uint32_t factor = q - 2;
+
+        poly_add(a.data(), b.data(), out.data(), count, q);
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t expected = (static_cast<uint64_t>(a[i].to_math_value()) + b[i].to_math_value()) % q;
+            ASSERT_EQ(out[i].to_math_value(), expected) << "add q=" << q << " i=" << i;
+        }
+        poly_sub(a.data(), b.data(), out.data(), count, q);
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t expected = (a[i].to_math_value() % q + q - b[i].to_math_value() % q) % q;
+            ASSERT_EQ(out[i].to_math_value(), expected) << "sub q=" << q << " i=" << i;
+        }
+        poly_mul(a.data(), b.data(), out.data(), count, q);
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t expected = static_cast<uint64_t>(a[i].to_math_value() % q) * (b[i].to_math_value() % q) % q;
+            ASSERT_EQ(out[i].to_math_value(), expected) << "mul q=" << q << " i=" << i;
+        }
+        poly_scale(a.data(), factor, out.data(), count, q);
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t expected = static_cast<uint64_t>(a[i].to_math_value()) * factor % q;
+            ASSERT_EQ(out[i].to_math_value(), expected) << "scale q=" << q << " i=" << i;
+        }
+
+        std::vector<ColorValue> reduced = a;
+        poly_reduce(reduced.data(), count, q);
+        for (size_t i = 0; i < count; ++i) {
+            ASSERT_EQ(reduced[i].to_math_value(), a[i].to_math_value() % q);
+        }
+        std::vector<ColorValue> in_place = a;
+        poly_add(in_place.data(), b.data(), in_place.data(), count, q);
+        poly_sub(in_place.data(), b.data(), in_place.data(), count, q);
+        for (size_t i = 0; i < count; ++i) {
+            ASSERT_EQ(in_place[i].to_math_value(), reduced[i].to_math_value());
+        }
+    }
+}
+
+// Test Compress_d / Decompress_d against their definitions and the FIPS 203 error bound
+TEST_F(PolyTest, CompressDecompress) {
+    const uint32_t q = 3329;
+    std::vector<ColorValue> coeffs(q), compressed(q), restored(q);
+    for (uint32_t x = 0; x < q; ++x) {
+        coeffs[x] = ColorValue::from_math_value(x);
+    }
+    for (uint32_t bits : {1u, 4u, 10u, 11u}) {
+        poly_compress(coeffs.data(), compressed.data(), q, bits, q);
+        poly_decompress(compressed.data(), restored.data(), q, bits, q);
+        for (uint32_t x = 0; x < q; ++x) {
+            uint32_t y = compressed[x].to_math_value();
+            ASSERT_EQ(y, ((static_cast<uint64_t>(x) << bits) * 2 + q) / (2 * q) % (1u << bits)) << "x=" << x;
+            // |Decompress(Compress(x)) - x| mod q is at most round(q / 2^(d+1))
+            uint32_t r = restored[x].to_math_value();
+            uint32_t diff = (r + q - x) % q;
+            ASSERT_LE(std::min(diff, q - diff), (q + (1u << (bits + 1)) - 1) >> (bits + 1)) << "bits=" << bits;
+        }
+    }
+}
+
+// Test that the fused output stage writes the bytes of its scale, add and encode passes,
+// for every serialization and for counts that end in a partial block
+TEST_F(PolyTest, ScaleAddEncodeMatchesSeparatePasses) {
+    const uint32_t q = 3329;
+    const uint32_t factor = 3303;  // 256^(-1) mod q
+    for (size_t count : {size_t{3} * 256, size_t{8}, size_t{13}, size_t{1}}) {
+        std::vector<uint32_t> raw(count);
+        std::vector<ColorValue> raw_colors(count), noise(count), expected(count);
+        uint32_t state = 0x2545F491u ^ static_cast<uint32_t>(count);
+        for (size_t i = 0; i < count; ++i) {
+            state = state * 1664525u + 1013904223u;
+            raw[i] = i % 9 == 0 ? 0xFFFFFFFFu - static_cast<uint32_t>(i) : state;
+            raw_colors[i] = ColorValue::from_math_value(raw[i]);
+            state = state * 1664525u + 1013904223u;
+            noise[i] = ColorValue::from_math_value(i % 4 == 0 ? q - 1 - static_cast<uint32_t>(i % 3) : state % q);
+        }
+        poly_scale(raw_colors.data(), factor, expected.data(), count, q);
+        poly_add(expected.data(), noise.data(), expected.data(), count, q);
+
+        for (CoefficientEncoding encoding : {CoefficientEncoding::COLOR32, CoefficientEncoding::PACKED12}) {
+            std::vector<uint8_t> want(encoded_coefficients_size(count, encoding));
+            std::vector<uint8_t> got(want.size(), 0xEE);
+            encode_coefficients(expected.data(), count, encoding, want.data());
+            poly_scale_add_encode(raw.data(), factor, noise.data(), count, q, encoding, 0, got.data());
+            EXPECT_EQ(got, want) << "count " << count << ", encoding " << static_cast<int>(encoding);
+        }
+        for (uint32_t bits : {1u, 4u, 5u, 10u, 11u}) {
+            std::vector<uint8_t> want(compressed_coefficients_size(count, bits));
+            std::vector<uint8_t> got(want.size(), 0xEE);
+            compress_encode_coefficients(expected.data(), count, bits, q, want.data());
+            poly_scale_add_encode(raw.data(), factor, noise.data(), count, q, CoefficientEncoding::COLOR32, bits,
+                                  got.data());
+            EXPECT_EQ(got, want) << "count " << count << ", bits " << bits;
+        }
+    }
+}
+
+// Test the vector forms: shapes are checked and the inverse NTT undoes the forward one
+TEST_F(PolyTest, PolyVecRingOperations) {
+    const uint32_t q = 3329;
+    auto engine = ColorNTTEngine::shared(q, degree);
+    PolyVec a(rank, degree), b(rank, degree), sum(rank, degree);
+    for (size_t c = 0; c < a.coeff_count(); ++c) {
+        a.data()[c] = ColorValue::from_math_value(static_cast<uint32_t>(c * 13 % q));
+        b.data()[c] = ColorValue::from_math_value(static_cast<uint32_t>((c * c + 1) % q));
+    }
+    polyvec_add(a, b, sum, q);
+    EXPECT_EQ(sum[1][7].to_math_value(), (a[1][7].to_math_value() + b[1][7].to_math_value()) % q);
+    EXPECT_THROW(polyvec_add(a, PolyVec(rank - 1, degree), sum, q), std::invalid_argument);
+    EXPECT_THROW(polyvec_basemul_acc(*engine, a, PolyVec(rank, degree / 2), sum[0]), std::invalid_argument);
+
+    PolyVec round_trip = a;
+    polyvec_ntt(*engine, round_trip);
+    PolyVec b_hat = b;
+    polyvec_ntt(*engine, b_hat);
+    Poly product(degree);
+    polyvec_basemul_acc(*engine, round_trip, b_hat, product.data());
+    polyvec_invntt(*engine, round_trip, mod_inverse(degree, q));
+    for (size_t c = 0; c < a.coeff_count(); ++c) {
+        ASSERT_EQ(round_trip.data()[c].to_math_value(), a.data()[c].to_math_value());
+    }
+
+    // Constant term of sum_i a_i * b_i in the cyclic ring, times n from the unscaled basemul
+    engine->ntt_inverse_colors(product.data());
+    uint64_t expected = 0;
+    for (uint32_t i = 0; i < rank; ++i) {
+        for (uint32_t j = 0; j < degree; ++j) {
+            expected += static_cast<uint64_t>(a[i][j].to_math_value()) * b[i][(degree - j) % degree].to_math_value() % q;
+        }
+    }
+    EXPECT_EQ(product[0].to_math_value(), expected % q * degree % q);
+}
+
+} // namespace clwe
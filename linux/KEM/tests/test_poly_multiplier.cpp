@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include "poly_multiplier.hpp"
+#include <stdexcept>
+#include <vector>
+
+namespace clwe {
+
+namespace {
+
+const MultiplierStrategy ALL_STRATEGIES[] = {MultiplierStrategy::Schoolbook, MultiplierStrategy::Karatsuba,
+                                             MultiplierStrategy::NTT, MultiplierStrategy::MultiModularNTT};
+
+std::vector<uint32_t> test_poly(uint32_t q, uint32_t n, uint32_t salt) {
+    std::vector<uint32_t> poly(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        poly[i] = static_cast<uint32_t>((static_cast<uint64_t>(i) * i * 7919 + i * 31 + salt) % q);
+    }
+    return poly;
+}
+
+// a * b mod (x^n - 1, q) straight from the definition
+std::vector<uint32_t> reference_product(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b, uint32_t q) {
+    const size_t n = a.size();
+    std::vector<uint64_t> acc(n, 0);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            acc[(i + j) % n] = (acc[(i + j) % n] + static_cast<uint64_t>(a[i]) * b[j]) % q;
+        }
+    }
+    return std::vector<uint32_t>(acc.begin(), acc.end());
+}
+
+} // namespace
+
+TEST(PolyMultiplierTest, NTTFriendliness) {
+    EXPECT_TRUE(ntt_friendly(3329, 256));
+    EXPECT_TRUE(ntt_friendly(7681, 512));
+    EXPECT_TRUE(ntt_friendly(3329, 1));
+    EXPECT_FALSE(ntt_friendly(3329, 512));   // 512 does not divide 3328
+    EXPECT_TRUE(ntt_friendly(12289, 256));   // 17 is a square mod 12289; the generator root is used
+    EXPECT_FALSE(ntt_friendly(4097, 2));     // Not prime
+}
+
+// Every strategy gives the textbook product, NTT-friendly or not, from one coefficient up
+TEST(PolyMultiplierTest, StrategiesMatchReference) {
+    const uint32_t cases[][2] = {{3329, 1},  {3329, 4},   {3329, 8},    {3329, 64},  {3329, 256},
+                                 {7681, 512}, {4099, 128}, {65521, 256}, {257, 2048}, {2, 16}};
+    for (const auto& c : cases) {
+        const uint32_t q = c[0];
+        const uint32_t n = c[1];
+        std::vector<uint32_t> a = test_poly(q, n, 5);
+        std::vector<uint32_t> b = test_poly(q, n, 11);
+        const std::vector<uint32_t> expected = reference_product(a, b, q);
+        for (MultiplierStrategy strategy : ALL_STRATEGIES) {
+            if (strategy == MultiplierStrategy::NTT && !ntt_friendly(q, n)) {
+                EXPECT_THROW(create_poly_multiplier(strategy, q, n), std::invalid_argument);
+                continue;
+            }
+            auto multiplier = create_poly_multiplier(strategy, q, n);
+            EXPECT_EQ(multiplier->strategy(), strategy);
+            std::vector<uint32_t> result(n);
+            multiplier->multiply(a.data(), b.data(), result.data());
+            EXPECT_EQ(result, expected) << multiplier_strategy_name(strategy) << " q=" << q << " n=" << n;
+
+            // The output may overwrite an input
+            std::vector<uint32_t> in_place = a;
+            multiplier->multiply(in_place.data(), b.data(), in_place.data());
+            EXPECT_EQ(in_place, expected) << multiplier_strategy_name(strategy) << " q=" << q << " n=" << n;
+        }
+    }
+}
+
+// All-(q - 1) inputs reach the largest integer coefficients, n * (q - 1)^2 = n mod q
+TEST(PolyMultiplierTest, LargestCoefficientsStayExact) {
+    const uint32_t q = 65521;
+    const uint32_t n = 8192;
+    std::vector<uint32_t> a(n, q - 1);
+    for (MultiplierStrategy strategy : {MultiplierStrategy::Karatsuba, MultiplierStrategy::MultiModularNTT,
+                                        MultiplierStrategy::Schoolbook}) {
+        auto multiplier = create_poly_multiplier(strategy, q, n);
+        std::vector<uint32_t> result(n);
+        multiplier->multiply(a.data(), a.data(), result.data());
+        EXPECT_EQ(result, std::vector<uint32_t>(n, n % q)) << multiplier_strategy_name(strategy);
+    }
+}
+
+TEST(PolyMultiplierTest, SelectsByShape) {
+    EXPECT_EQ(select_multiplier_strategy(3329, 16), MultiplierStrategy::Schoolbook);
+    EXPECT_EQ(select_multiplier_strategy(4099, 128), MultiplierStrategy::Schoolbook);
+    EXPECT_EQ(select_multiplier_strategy(3329, 128), MultiplierStrategy::NTT);
+    EXPECT_EQ(select_multiplier_strategy(3329, 256), MultiplierStrategy::NTT);
+    EXPECT_EQ(select_multiplier_strategy(4099, 256), MultiplierStrategy::Karatsuba);
+    EXPECT_EQ(select_multiplier_strategy(4099, 4096), MultiplierStrategy::MultiModularNTT);
+    EXPECT_EQ(create_poly_multiplier(7681, 512)->strategy(), MultiplierStrategy::NTT);
+    EXPECT_EQ(create_poly_multiplier(12289, 1024)->strategy(), select_multiplier_strategy(12289, 1024));
+
+    EXPECT_THROW(select_multiplier_strategy(3329, 0), std::invalid_argument);
+    EXPECT_THROW(select_multiplier_strategy(3329, 96), std::invalid_argument);
+    EXPECT_THROW(create_poly_multiplier(3329, 16384), std::invalid_argument);
+    EXPECT_THROW(create_poly_multiplier(MultiplierStrategy::Karatsuba, 65537, 256), std::invalid_argument);
+    EXPECT_THROW(create_poly_multiplier(MultiplierStrategy::Schoolbook, 1, 256), std::invalid_argument);
+}
+
+} // namespace clwe
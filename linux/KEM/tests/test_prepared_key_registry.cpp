@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+#include "clwe/prepared_key_registry.hpp"
+#include <atomic>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace clwe {
+
+class PreparedKeyRegistryTest : public ::testing::Test {
+protected:
+    struct Tenant {
+        KeyFingerprint fingerprint;
+        ColorPublicKey public_key;
+        ColorPrivateKey private_key;
+    };
+
+    std::vector<Tenant> make_tenants(size_t count) {
+        std::vector<Tenant> tenants;
+        for (size_t i = 0; i < count; ++i) {
+            auto keys = kem.keygen();
+            ColorExpandedPrivateKey expanded = kem.expand_private_key(keys.first, keys.second);
+            tenants.push_back({expanded.public_key_hash, keys.first, keys.second});
+        }
+        return tenants;
+    }
+
+    ColorKEM kem{CLWEParameters(512)};
+};
+
+// Test that every tenant decapsulates under its own key and unknown fingerprints are refused
+TEST_F(PreparedKeyRegistryTest, DecapsulatesPerTenant) {
+    std::vector<Tenant> tenants = make_tenants(4);
+    PreparedKeyRegistry registry(kem, 8, 8);
+    EXPECT_EQ(registry.table_size(), 16u);
+    for (const Tenant& tenant : tenants) {
+        registry.insert(tenant.fingerprint, tenant.private_key);
+    }
+    EXPECT_EQ(registry.size(), 4u);
+    EXPECT_EQ(registry.prepared_size(), 0u);
+
+    KemWorkspace workspace;
+    for (const Tenant& tenant : tenants) {
+        auto [ciphertext, secret] = kem.encapsulate(tenant.public_key);
+        EXPECT_EQ(registry.decapsulate(tenant.fingerprint, ciphertext), secret);
+        EXPECT_EQ(registry.decapsulate(tenant.fingerprint, ColorCiphertextView(ciphertext), workspace), secret);
+    }
+    // Keys are prepared once, on first use
+    EXPECT_EQ(registry.preparations(), 4u);
+    EXPECT_EQ(registry.prepared_size(), 4u);
+
+    KeyFingerprint unknown{};
+    EXPECT_FALSE(registry.contains(unknown));
+    auto encapsulation = kem.encapsulate(tenants[0].public_key);
+    EXPECT_THROW(registry.decapsulate(unknown, encapsulation.first), std::invalid_argument);
+
+    EXPECT_TRUE(registry.erase(tenants[1].fingerprint));
+    EXPECT_FALSE(registry.erase(tenants[1].fingerprint));
+    EXPECT_FALSE(registry.contains(tenants[1].fingerprint));
+    EXPECT_EQ(registry.size(), 3u);
+    EXPECT_EQ(registry.prepared_size(), 3u);
+    EXPECT_EQ(registry.decapsulate(tenants[0].fingerprint, encapsulation.first), encapsulation.second);
+
+    // Replacing a key under the same fingerprint takes effect for the next decapsulation
+    registry.insert(tenants[0].fingerprint, tenants[2].private_key);
+    auto replaced = kem.encapsulate(tenants[2].public_key);
+    EXPECT_EQ(registry.decapsulate(tenants[0].fingerprint, replaced.first), replaced.second);
+    EXPECT_EQ(registry.size(), 3u);
+}
+
+// Test that the prepared set stays within its bound and evicted keys are prepared again on use
+TEST_F(PreparedKeyRegistryTest, EvictsToSerializedForm) {
+    std::vector<Tenant> tenants = make_tenants(6);
+    PreparedKeyRegistry registry(kem, 6, 2);
+    for (const Tenant& tenant : tenants) {
+        registry.insert(tenant.fingerprint, tenant.private_key);
+    }
+
+    for (int round = 0; round < 2; ++round) {
+        for (const Tenant& tenant : tenants) {
+            auto [ciphertext, secret] = kem.encapsulate(tenant.public_key);
+            EXPECT_EQ(registry.decapsulate(tenant.fingerprint, ciphertext), secret);
+            EXPECT_LE(registry.prepared_size(), 2u);
+        }
+    }
+    EXPECT_EQ(registry.preparations(), 12u);
+    EXPECT_EQ(registry.evictions(), 10u);
+
+    // A hot key stays prepared while others rotate through the remaining slot
+    uint64_t before = registry.preparations();
+    for (int i = 0; i < 4; ++i) {
+        auto hot = kem.encapsulate(tenants[0].public_key);
+        EXPECT_EQ(registry.decapsulate(tenants[0].fingerprint, hot.first), hot.second);
+    }
+    EXPECT_LE(registry.preparations(), before + 1);
+}
+
+// Test the capacity and parameter checks
+TEST_F(PreparedKeyRegistryTest, RejectsOverflowAndForeignKeys) {
+    std::vector<Tenant> tenants = make_tenants(3);
+    EXPECT_THROW(PreparedKeyRegistry(kem, 0, 1), std::invalid_argument);
+    EXPECT_THROW(PreparedKeyRegistry(kem, 1, 0), std::invalid_argument);
+
+    PreparedKeyRegistry registry(kem, 2, 2);
+    registry.insert(tenants[0].fingerprint, tenants[0].private_key);
+    registry.insert(tenants[1].fingerprint, tenants[1].private_key);
+    EXPECT_THROW(registry.insert(tenants[2].fingerprint, tenants[2].private_key), std::runtime_error);
+
+    // An erased slot is free again
+    registry.erase(tenants[0].fingerprint);
+    registry.insert(tenants[2].fingerprint, tenants[2].private_key);
+    EXPECT_TRUE(registry.contains(tenants[2].fingerprint));
+
+    ColorKEM other{CLWEParameters(768)};
+    auto foreign = other.keygen();
+    EXPECT_THROW(registry.insert(tenants[0].fingerprint, foreign.second), std::invalid_argument);
+    ColorPrivateKey truncated = tenants[0].private_key;
+    truncated.secret_data.pop_back();
+    EXPECT_THROW(registry.insert(tenants[0].fingerprint, truncated), std::invalid_argument);
+}
+
+// Test concurrent decapsulation under eviction pressure while a writer erases and reinserts
+TEST_F(PreparedKeyRegistryTest, ConcurrentReadersAndWriter) {
+    std::vector<Tenant> tenants = make_tenants(8);
+    PreparedKeyRegistry registry(kem, 8, 3);
+    std::vector<std::pair<ColorCiphertext, ColorValue>> encapsulations;
+    for (const Tenant& tenant : tenants) {
+        registry.insert(tenant.fingerprint, tenant.private_key);
+        encapsulations.push_back(kem.encapsulate(tenant.public_key));
+    }
+
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> mismatches{0};
+    std::vector<std::thread> readers;
+    for (size_t t = 0; t < 4; ++t) {
+        readers.emplace_back([&, t] {
+            for (size_t i = t; !stop.load(); ++i) {
+                // Tenant 7 is the one the writer churns
+                size_t tenant = i % 7;
+                if (registry.decapsulate(tenants[tenant].fingerprint, encapsulations[tenant].first) !=
+                    encapsulations[tenant].second) {
+                    mismatches.fetch_add(1);
+                }
+            }
+        });
+    }
+    for (int i = 0; i < 50; ++i) {
+        registry.erase(tenants[7].fingerprint);
+        registry.insert(tenants[7].fingerprint, tenants[7].private_key);
+    }
+    stop.store(true);
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(mismatches.load(), 0u);
+    EXPECT_LE(registry.prepared_size(), 3u);
+    EXPECT_EQ(registry.size(), 8u);
+}
+
+// Test that tenant churn past the capacity leaves probes short for hits, misses and inserts
+TEST_F(PreparedKeyRegistryTest, ChurnKeepsProbesBounded) {
+    std::vector<Tenant> tenants = make_tenants(2);
+    PreparedKeyRegistry registry(kem, 64, 4);
+    std::mt19937_64 rng(7);
+    auto random_fingerprint = [&] {
+        KeyFingerprint fingerprint;
+        for (uint8_t& byte : fingerprint) {
+            byte = static_cast<uint8_t>(rng());
+        }
+        return fingerprint;
+    };
+
+    // Keep 48 keys live and replace one per step, many times over the table size
+    std::vector<KeyFingerprint> live;
+    for (size_t i = 0; i < 48; ++i) {
+        live.push_back(random_fingerprint());
+        registry.insert(live.back(), tenants[0].private_key);
+    }
+    for (size_t step = 0; step < 20 * registry.table_size(); ++step) {
+        size_t victim = rng() % live.size();
+        ASSERT_TRUE(registry.erase(live[victim]));
+        live[victim] = random_fingerprint();
+        registry.insert(live[victim], tenants[0].private_key);
+    }
+    EXPECT_EQ(registry.size(), 48u);
+
+    // At most three quarters of the slots are keys or erased marks, so no probe runs the table
+    size_t miss_probes = 0;
+    for (int i = 0; i < 256; ++i) {
+        size_t probes = registry.probe_length(random_fingerprint());
+        EXPECT_LT(probes, registry.table_size() / 2);
+        miss_probes += probes;
+    }
+    EXPECT_LE(miss_probes / 256, 16u);
+    for (const KeyFingerprint& fingerprint : live) {
+        EXPECT_TRUE(registry.contains(fingerprint));
+        EXPECT_LT(registry.probe_length(fingerprint), registry.table_size() / 2);
+    }
+
+    auto encapsulation = kem.encapsulate(tenants[0].public_key);
+    EXPECT_EQ(registry.decapsulate(live[0], encapsulation.first), encapsulation.second);
+}
+
+} // namespace clwe
@@ -0,0 +1,214 @@
+#include <gtest/gtest.h>
+#include "priority_executor.hpp"
+#include "keygen_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace clwe {
+
+class PriorityExecutorTest : public ::testing::Test {
+protected:
+    // Holds every job that waits on it until release()
+    struct Gate {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool open = false;
+
+        void wait() {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this] { return open; });
+        }
+
+        void release() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                open = true;
+            }
+            cv.notify_all();
+        }
+    };
+
+    CLWEParameters params{512};
+};
+
+// Test that a foreground job overtakes queued lower classes at the next job boundary
+TEST_F(PriorityExecutorTest, ForegroundRunsFirst) {
+    PriorityExecutorConfig config;
+    config.threads = 1;
+    PriorityExecutor executor(config);
+
+    Gate gate;
+    std::promise<void> started;
+    executor.post(WorkClass::BACKGROUND, [&] {
+        started.set_value();
+        gate.wait();
+    });
+    started.get_future().wait();
+
+    std::mutex mutex;
+    std::vector<WorkClass> order;
+    auto record = [&](WorkClass work_class) {
+        return [&, work_class] {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(work_class);
+        };
+    };
+    executor.post(WorkClass::BACKGROUND, record(WorkClass::BACKGROUND));
+    executor.post(WorkClass::PREPARATION, record(WorkClass::PREPARATION));
+    executor.post(WorkClass::BACKGROUND, record(WorkClass::BACKGROUND));
+    executor.post(WorkClass::FOREGROUND, record(WorkClass::FOREGROUND));
+    EXPECT_EQ(executor.pending(WorkClass::BACKGROUND), 2u);
+    gate.release();
+
+    while (executor.completed(WorkClass::BACKGROUND) < 3) {
+        std::this_thread::yield();
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(order, (std::vector<WorkClass>{WorkClass::FOREGROUND, WorkClass::PREPARATION, WorkClass::BACKGROUND,
+                                             WorkClass::BACKGROUND}));
+}
+
+// Test that capped background work leaves the other workers to foreground jobs
+TEST_F(PriorityExecutorTest, BackgroundCapHoldsWorkersFree) {
+    PriorityExecutorConfig config;
+    config.threads = 3;
+    config.max_background_threads = 1;
+    PriorityExecutor executor(config);
+
+    Gate gate;
+    std::atomic<int> running_background{0};
+    std::atomic<int> peak_background{0};
+    for (int i = 0; i < 6; ++i) {
+        executor.post(WorkClass::BACKGROUND, [&] {
+            const int now = running_background.fetch_add(1) + 1;
+            int peak = peak_background.load();
+            while (now > peak && !peak_background.compare_exchange_weak(peak, now)) {
+            }
+            gate.wait();
+            running_background.fetch_sub(1);
+        });
+    }
+
+    while (running_background.load() == 0) {
+        std::this_thread::yield();
+    }
+
+    // Both free workers serve foreground jobs while the background job is held
+    std::promise<void> first, second;
+    executor.post(WorkClass::FOREGROUND, [&] { first.set_value(); });
+    executor.post(WorkClass::FOREGROUND, [&] { second.set_value(); });
+    EXPECT_EQ(first.get_future().wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    EXPECT_EQ(second.get_future().wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    EXPECT_EQ(executor.pending(WorkClass::BACKGROUND), 5u);
+
+    gate.release();
+    while (executor.completed(WorkClass::BACKGROUND) < 6) {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(peak_background.load(), 1);
+
+    config.max_background_threads = 4;
+    EXPECT_THROW(PriorityExecutor invalid(config), std::invalid_argument);
+}
+
+// Test the parallel-for adapter standalone and as a ColorKEM executor
+TEST_F(PriorityExecutorTest, ParallelForRunsEveryTask) {
+    PriorityExecutorConfig config;
+    config.threads = 2;
+    PriorityExecutor executor(config);
+    KemExecutor parallel = executor.parallel_for(WorkClass::FOREGROUND);
+
+    std::vector<std::atomic<int>> hits(100);
+    parallel(hits.size(), [&](size_t i) { hits[i].fetch_add(1); });
+    for (const auto& hit : hits) {
+        EXPECT_EQ(hit.load(), 1);
+    }
+    parallel(0, [](size_t) { FAIL(); });
+    EXPECT_THROW(parallel(8, [](size_t i) {
+                     if (i == 5) {
+                         throw std::runtime_error("task failed");
+                     }
+                 }),
+                 std::runtime_error);
+
+    ColorKEM kem(CLWEParameters(768));
+    kem.set_executor(parallel);
+    auto [public_key, private_key] = kem.keygen();
+    auto [ciphertext, secret] = kem.encapsulate(public_key);
+    EXPECT_EQ(kem.decapsulate(public_key, private_key, ciphertext), secret);
+}
+
+// Test a key pool refilling through the executor and the AsyncKEM poster on the same workers
+TEST_F(PriorityExecutorTest, KeygenPoolRefillsInBackground) {
+    PriorityExecutorConfig config;
+    config.threads = 2;
+    PriorityExecutor executor(config);
+    {
+        KeygenPoolConfig pool_config;
+        pool_config.capacity = 32;
+        pool_config.low_watermark = 8;
+        pool_config.high_watermark = 32;
+        pool_config.batch_size = 8;
+        pool_config.executor = &executor;
+        KeygenPool pool(params, pool_config);
+
+        AsyncKEM async(params, executor.poster(WorkClass::FOREGROUND));
+        ASSERT_TRUE(pool.wait_ready(4, std::chrono::seconds(30)));
+        KeygenPool::KeyPair keys = pool.pop();
+        std::promise<std::pair<ColorCiphertext, ColorValue>> encapsulated;
+        async.async_encapsulate(keys.first, [&](std::exception_ptr error, std::pair<ColorCiphertext, ColorValue> result) {
+            EXPECT_FALSE(error);
+            encapsulated.set_value(std::move(result));
+        });
+        auto result = encapsulated.get_future().get();
+        EXPECT_EQ(async.kem().decapsulate(keys.first, keys.second, result.first), result.second);
+
+        ASSERT_TRUE(pool.wait_ready(31, std::chrono::seconds(30)));
+        EXPECT_GE(pool.generated(), 32u);
+
+        // Drain below the watermark so the pool is destroyed with refills still queued
+        for (int i = 0; i < 30; ++i) {
+            pool.pop();
+        }
+    }
+    EXPECT_EQ(executor.pending(WorkClass::BACKGROUND), 0u);
+}
+
+// Test that a throwing job reaches on_error and leaves the worker running later jobs
+TEST_F(PriorityExecutorTest, ThrowingJobReachesErrorHandler) {
+    std::mutex mutex;
+    std::vector<std::string> messages;
+    PriorityExecutorConfig config;
+    config.threads = 1;
+    config.on_error = [&](WorkClass work_class, std::exception_ptr error) {
+        EXPECT_EQ(work_class, WorkClass::PREPARATION);
+        try {
+            std::rethrow_exception(error);
+        } catch (const std::runtime_error& e) {
+            std::lock_guard<std::mutex> lock(mutex);
+            messages.push_back(e.what());
+        }
+    };
+    PriorityExecutor executor(config);
+
+    executor.post(WorkClass::PREPARATION, [] { throw std::runtime_error("rotation failed"); });
+    std::promise<void> ran;
+    executor.post(WorkClass::PREPARATION, [&] { ran.set_value(); });
+    ran.get_future().wait();
+
+    EXPECT_EQ(executor.failed(WorkClass::PREPARATION), 1u);
+    EXPECT_EQ(executor.failed(WorkClass::FOREGROUND), 0u);
+    std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_EQ(messages.size(), 1u);
+    EXPECT_EQ(messages[0], "rotation failed");
+}
+
+} // namespace clwe
@@ -1,9 +1,17 @@
 #include <gtest/gtest.h>
 #include "sampling.hpp"
 #include "shake_sampler.hpp"
+#include "keccak_x4.hpp"
+#include "rejection_sampling.hpp"
+#include "binomial_sampling.hpp"
+#include "aes_ctr.hpp"
 #include <vector>
+#include <thread>
 #include <set>
 #include <algorithm>
+#ifdef CLWE_HAVE_OPENSSL
+#include <openssl/evp.h>
+#endif
 
 namespace clwe {
 
@@ -235,6 +243,473 @@ TEST_F(SamplingTest, SHAKE128Sampler) {
     EXPECT_TRUE(has_nonzero);
 }
 
+// Streamed output must match a one-shot SHAKE squeeze, across rate boundaries
+TEST_F(SamplingTest, StreamingSqueezeMatchesOneShot) {
+    std::array<uint8_t, 32> seed = {7, 6, 5, 4, 3, 2, 1};
+    const size_t total = 3 * SHAKE128_RATE + 17;
+
+#ifdef CLWE_HAVE_OPENSSL
+    auto one_shot = [&](const EVP_MD* md) {
+        std::vector<uint8_t> expected(total);
+        EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+        EVP_DigestInit_ex(ctx, md, NULL);
+        EVP_DigestUpdate(ctx, seed.data(), seed.size());
+        EVP_DigestFinalXOF(ctx, expected.data(), expected.size());
+        EVP_MD_CTX_free(ctx);
+        return expected;
+    };
+    const EVP_MD* shake128_md = EVP_shake128();
+    const EVP_MD* shake256_md = EVP_shake256();
+#else
+    // Without OpenSSL the reference is a single bundled-Keccak squeeze
+    auto one_shot = [&](int mdlen) {
+        std::vector<uint8_t> expected(total);
+        sha3_ctx_t ctx;
+        sha3_init(&ctx, mdlen);
+        shake_update(&ctx, seed.data(), seed.size());
+        shake_xof(&ctx);
+        shake_out(&ctx, expected.data(), expected.size());
+        return expected;
+    };
+    const int shake128_md = 16;
+    const int shake256_md = 32;
+#endif
+
+    // Odd chunk sizes so that reads straddle block refills
+    const std::vector<size_t> chunks = {3, 1, 200, 5, 136, 168, 7};
+
+    SHAKE128Sampler shake128;
+    shake128.init(seed.data(), seed.size());
+    std::vector<uint8_t> out128(total);
+    for (size_t pos = 0, i = 0; pos < total; ++i) {
+        size_t len = std::min(chunks[i % chunks.size()], total - pos);
+        shake128.squeeze(out128.data() + pos, len);
+        pos += len;
+    }
+    EXPECT_EQ(out128, one_shot(shake128_md));
+
+    SHAKE256Sampler shake256;
+    shake256.init(seed.data(), seed.size());
+    std::vector<uint8_t> out256(total);
+    for (size_t pos = 0, i = 0; pos < total; ++i) {
+        size_t len = std::min(chunks[i % chunks.size()], total - pos);
+        shake256.squeeze(out256.data() + pos, len);
+        pos += len;
+    }
+    EXPECT_EQ(out256, one_shot(shake256_md));
+
+    // Re-initialising restarts the stream
+    shake256.init(seed.data(), seed.size());
+    std::vector<uint8_t> restart(64);
+    shake256.squeeze(restart.data(), restart.size());
+    EXPECT_TRUE(std::equal(restart.begin(), restart.end(), out256.begin()));
+}
+
+// Test that absorbing in fragments matches a single init
+TEST_F(SamplingTest, StreamingAbsorbMatchesInit) {
+    std::vector<uint8_t> message(3 * SHAKE256_RATE + 5);
+    for (size_t i = 0; i < message.size(); ++i) {
+        message[i] = static_cast<uint8_t>(i * 31 + 7);
+    }
+
+    SHAKE256Sampler whole;
+    whole.init(message.data(), message.size());
+    std::vector<uint8_t> expected(64);
+    whole.squeeze(expected.data(), expected.size());
+
+    // Fragments straddle rate boundaries, including an empty one
+    SHAKE256Sampler streamed;
+    streamed.begin();
+    size_t split[] = {1, 0, SHAKE256_RATE, 200};
+    size_t pos = 0;
+    for (size_t len : split) {
+        streamed.absorb(message.data() + pos, len);
+        pos += len;
+    }
+    streamed.absorb(message.data() + pos, message.size() - pos);
+    streamed.finalize();
+    std::vector<uint8_t> actual(64);
+    streamed.squeeze(actual.data(), actual.size());
+
+    EXPECT_EQ(actual, expected);
+}
+
+// Test that the per-thread samplers are reused and restart cleanly on init
+TEST_F(SamplingTest, ThreadLocalSamplerReuse) {
+    EXPECT_EQ(&thread_shake256(), &thread_shake256());
+    EXPECT_EQ(&thread_shake128(), &thread_shake128());
+
+    std::array<uint8_t, 32> seed = {1, 2, 3};
+    SHAKE256Sampler fresh;
+    fresh.init(seed.data(), seed.size());
+    std::vector<uint8_t> expected(100);
+    fresh.squeeze(expected.data(), expected.size());
+
+    // Leave the shared sampler mid-stream, then re-init it
+    SHAKE256Sampler& shared = thread_shake256();
+    shared.init(expected.data(), expected.size());
+    std::vector<uint8_t> discard(37);
+    shared.squeeze(discard.data(), discard.size());
+    shared.init(seed.data(), seed.size());
+    std::vector<uint8_t> actual(100);
+    shared.squeeze(actual.data(), actual.size());
+    EXPECT_EQ(actual, expected);
+
+    const SHAKE256Sampler* other = nullptr;
+    std::thread([&other]() { other = &thread_shake256(); }).join();
+    EXPECT_NE(other, &thread_shake256());
+}
+
+// Each lane of the 4-way sampler must reproduce the single-lane SHAKE-128 stream
+TEST_F(SamplingTest, X4SamplerMatchesSingleLane) {
+    const size_t nblocks = 3;
+    std::array<std::array<uint8_t, 34>, 4> seeds;
+    for (size_t lane = 0; lane < 4; ++lane) {
+        for (size_t i = 0; i < seeds[lane].size(); ++i) {
+            seeds[lane][i] = static_cast<uint8_t>(lane * 71 + i);
+        }
+    }
+    const uint8_t* seed_ptrs[4] = {seeds[0].data(), seeds[1].data(), seeds[2].data(), seeds[3].data()};
+    std::vector<std::vector<uint8_t>> lanes(4, std::vector<uint8_t>(nblocks * SHAKE128_RATE));
+    uint8_t* out_ptrs[4] = {lanes[0].data(), lanes[1].data(), lanes[2].data(), lanes[3].data()};
+
+    SHAKE128x4Sampler x4;
+    x4.init_x4(seed_ptrs, seeds[0].size());
+    x4.squeeze_blocks_x4(out_ptrs, nblocks);
+
+    for (size_t lane = 0; lane < 4; ++lane) {
+        SHAKE128Sampler single;
+        single.init(seeds[lane].data(), seeds[lane].size());
+        std::vector<uint8_t> expected(nblocks * SHAKE128_RATE);
+        single.squeeze(expected.data(), expected.size());
+        EXPECT_EQ(lanes[lane], expected) << "lane " << lane;
+    }
+
+    uint8_t long_seed[SHAKE128_RATE] = {};
+    const uint8_t* long_ptrs[4] = {long_seed, long_seed, long_seed, long_seed};
+    EXPECT_THROW(x4.init_x4(long_ptrs, SHAKE128_RATE), std::invalid_argument);
+}
+
+// The dispatched 4-way permutation must agree with the portable one
+TEST_F(SamplingTest, KeccakX4MatchesScalar) {
+    uint64_t dispatched[25][4];
+    uint64_t scalar[25][4];
+    for (size_t i = 0; i < 25; ++i) {
+        for (size_t lane = 0; lane < 4; ++lane) {
+            dispatched[i][lane] = scalar[i][lane] = 0x9E3779B97F4A7C15ULL * (i * 4 + lane + 1);
+        }
+    }
+    keccakf1600_x4(dispatched);
+    keccakf1600_x4_scalar(scalar);
+    for (size_t i = 0; i < 25; ++i) {
+        for (size_t lane = 0; lane < 4; ++lane) {
+            EXPECT_EQ(dispatched[i][lane], scalar[i][lane]);
+        }
+    }
+
+#ifdef HAVE_ARM_SHA3
+    // The single- and two-lane ARMv8.2-SHA3 permutations against lanes 0 and 1 of the scalar result
+    if (keccak_arm_sha3_supported()) {
+        uint64_t single[25];
+        uint64_t pair[25][2];
+        for (size_t i = 0; i < 25; ++i) {
+            single[i] = pair[i][0] = 0x9E3779B97F4A7C15ULL * (i * 4 + 1);
+            pair[i][1] = 0x9E3779B97F4A7C15ULL * (i * 4 + 2);
+        }
+        keccakf1600_armsha3(single);
+        keccakf1600_x2_armsha3(pair);
+        for (size_t i = 0; i < 25; ++i) {
+            EXPECT_EQ(single[i], scalar[i][0]);
+            EXPECT_EQ(pair[i][0], scalar[i][0]);
+            EXPECT_EQ(pair[i][1], scalar[i][1]);
+        }
+    }
+#endif
+}
+
+// AES-256 against FIPS-197 appendix C.3, and the counter mode against its block layout
+TEST_F(SamplingTest, AES256KnownAnswer) {
+    uint8_t key[32];
+    uint8_t plaintext[16];
+    for (int i = 0; i < 32; ++i) {
+        key[i] = static_cast<uint8_t>(i);
+    }
+    for (int i = 0; i < 16; ++i) {
+        plaintext[i] = static_cast<uint8_t>(0x11 * i);
+    }
+    const uint8_t expected[16] = {0x8e, 0xa2, 0xb7, 0xca, 0x51, 0x67, 0x45, 0xbf,
+                                  0xea, 0xfc, 0x49, 0x90, 0x4b, 0x49, 0x60, 0x89};
+    AES256CTR aes(key);
+    uint8_t ciphertext[16];
+    aes.encrypt_block(plaintext, ciphertext);
+    EXPECT_TRUE(std::equal(ciphertext, ciphertext + 16, expected));
+
+    // Block b of nonce 0x0201 is the cipher of 01 02 00 .. 00 || b as big-endian
+    uint8_t stream[3 * 16];
+    aes.keystream(0x0201, 0x01FF, stream, 3, AESBackend::Portable);
+    for (uint32_t b = 0; b < 3; ++b) {
+        uint8_t counter[16] = {0x01, 0x02};
+        counter[14] = static_cast<uint8_t>((0x01FF + b) >> 8);
+        counter[15] = static_cast<uint8_t>(0x01FF + b);
+        aes.encrypt_block(counter, ciphertext);
+        EXPECT_TRUE(std::equal(ciphertext, ciphertext + 16, stream + 16 * b)) << "block " << b;
+    }
+}
+
+// Every available AES backend must produce the portable keystream, across the 8-block
+// passes, their tails and a counter wrap
+TEST_F(SamplingTest, AESBackendsAgree) {
+    const std::vector<AESBackend> backends = available_aes_backends();
+    ASSERT_FALSE(backends.empty());
+    EXPECT_EQ(backends.back(), AESBackend::Portable);
+
+    uint8_t key[32];
+    for (int i = 0; i < 32; ++i) {
+        key[i] = static_cast<uint8_t>(0xA5 ^ (7 * i));
+    }
+    AES256CTR aes(key);
+    for (size_t blocks : {1u, 7u, 8u, 21u}) {
+        std::vector<uint8_t> reference(16 * blocks);
+        aes.keystream(0x0102030405060708ULL, 0xFFFFFFFCu, reference.data(), blocks, AESBackend::Portable);
+        for (AESBackend backend : backends) {
+            std::vector<uint8_t> out(16 * blocks);
+            aes.keystream(0x0102030405060708ULL, 0xFFFFFFFCu, out.data(), blocks, backend);
+            EXPECT_EQ(out, reference) << aes_backend_name(backend) << ", " << blocks << " blocks";
+        }
+        std::vector<uint8_t> dispatched(16 * blocks);
+        aes.keystream(0x0102030405060708ULL, 0xFFFFFFFCu, dispatched.data(), blocks);
+        EXPECT_EQ(dispatched, reference);
+    }
+
+    uint8_t block[16];
+    for (AESBackend backend : {AESBackend::AesNi, AESBackend::Vaes, AESBackend::ArmCrypto}) {
+        if (!aes_backend_available(backend)) {
+            EXPECT_THROW(aes.keystream(0, 0, block, 1, backend), std::invalid_argument);
+        }
+    }
+}
+
+// Every available Keccak backend must produce the same single-stream and four-lane output
+TEST_F(SamplingTest, KeccakBackendsAgree) {
+    const KeccakBackend saved = keccak_backend();
+    const std::vector<KeccakBackend> backends = available_keccak_backends();
+    ASSERT_FALSE(backends.empty());
+    EXPECT_EQ(backends.back(), KeccakBackend::Reference);
+
+    std::array<std::array<uint8_t, 34>, 4> seeds;
+    for (size_t lane = 0; lane < 4; ++lane) {
+        for (size_t i = 0; i < seeds[lane].size(); ++i) {
+            seeds[lane][i] = static_cast<uint8_t>(31 * lane + i);
+        }
+    }
+    const uint8_t* seed_ptrs[4] = {seeds[0].data(), seeds[1].data(), seeds[2].data(), seeds[3].data()};
+
+    // SHAKE-128 and streamed SHAKE-256 of seed 0, then both four-lane samplers
+    auto run = [&]() {
+        std::vector<std::vector<uint8_t>> out;
+        SHAKE128Sampler shake128;
+        shake128.init(seeds[0].data(), seeds[0].size());
+        out.emplace_back(2 * SHAKE128_RATE + 9);
+        shake128.squeeze(out.back().data(), out.back().size());
+
+        SHAKE256Sampler shake256;
+        shake256.begin();
+        shake256.absorb(seeds[0].data(), 5);
+        shake256.absorb(seeds[0].data() + 5, seeds[0].size() - 5);
+        shake256.finalize();
+        out.emplace_back(3 * SHAKE256_RATE + 1);
+        shake256.squeeze(out.back().data(), out.back().size());
+
+        SHAKE128x4Sampler x4_128;
+        SHAKE256x4Sampler x4_256;
+        x4_128.init_x4(seed_ptrs, seeds[0].size());
+        x4_256.init_x4(seed_ptrs, seeds[0].size());
+        for (size_t lane = 0; lane < 4; ++lane) {
+            out.emplace_back(2 * SHAKE128_RATE);
+            out.emplace_back(2 * SHAKE256_RATE);
+        }
+        uint8_t* out128[4] = {out[2].data(), out[4].data(), out[6].data(), out[8].data()};
+        uint8_t* out256[4] = {out[3].data(), out[5].data(), out[7].data(), out[9].data()};
+        x4_128.squeeze_blocks_x4(out128, 2);
+        x4_256.squeeze_blocks_x4(out256, 2);
+        return out;
+    };
+
+    set_keccak_backend(KeccakBackend::Reference);
+    const std::vector<std::vector<uint8_t>> reference = run();
+    EXPECT_TRUE(std::equal(reference[2].begin(), reference[2].end(), reference[0].begin()));
+    for (KeccakBackend backend : backends) {
+        set_keccak_backend(backend);
+        EXPECT_EQ(keccak_backend(), backend);
+        EXPECT_EQ(run(), reference) << keccak_backend_name(backend);
+
+        KeccakBackend parsed;
+        ASSERT_TRUE(parse_keccak_backend(keccak_backend_name(backend), parsed));
+        EXPECT_EQ(parsed, backend);
+    }
+    set_keccak_backend(saved);
+
+    KeccakBackend parsed;
+    EXPECT_FALSE(parse_keccak_backend("sha3", parsed));
+#ifndef CLWE_HAVE_XKCP
+    EXPECT_FALSE(keccak_backend_available(KeccakBackend::XKCP));
+    EXPECT_THROW(set_keccak_backend(KeccakBackend::XKCP), std::invalid_argument);
+#endif
+}
+
+// The SIMD rejection kernel must match a plain 12-bit parse, including truncation
+TEST_F(SamplingTest, RejectionKernelMatchesScalarParse) {
+    std::vector<uint8_t> buf(500);
+    sampler->squeeze(buf.data(), buf.size());
+
+    for (uint32_t q : {3329u, 4096u, 7681u, 17u}) {
+        for (size_t buflen : {size_t(0), size_t(5), size_t(28), size_t(168), size_t(500)}) {
+            for (size_t max_out : {size_t(0), size_t(7), size_t(256), size_t(400)}) {
+                std::vector<uint32_t> expected;
+                for (size_t pos = 0; pos + 3 <= buflen && expected.size() < max_out; pos += 3) {
+                    uint32_t c1 = ((buf[pos] << 4) | (buf[pos + 1] >> 4)) & 0xFFF;
+                    uint32_t c2 = ((buf[pos + 1] << 8) | buf[pos + 2]) & 0xFFF;
+                    if (c1 < q && expected.size() < max_out) expected.push_back(c1);
+                    if (c2 < q && expected.size() < max_out) expected.push_back(c2);
+                }
+
+                std::vector<uint32_t> actual(max_out + 16, 0xFFFFFFFFu);
+                size_t count = rejection_sample_uniform12(actual.data(), max_out, buf.data(), buflen, q);
+                ASSERT_EQ(count, expected.size()) << "q=" << q << " buflen=" << buflen << " max_out=" << max_out;
+                actual.resize(count);
+                EXPECT_EQ(actual, expected);
+
+                std::vector<uint32_t> swapped(max_out + 16);
+                ASSERT_EQ(rejection_sample_uniform12_be(swapped.data(), max_out, buf.data(), buflen, q), count);
+                for (size_t i = 0; i < count; ++i) {
+                    uint32_t v = expected[i];
+                    uint32_t be = (v >> 24) | ((v >> 8) & 0xFF00) | ((v << 8) & 0xFF0000) | (v << 24);
+                    EXPECT_EQ(swapped[i], be);
+                }
+            }
+        }
+    }
+}
+
+TEST_F(SamplingTest, PolynomialUniformFast) {
+    std::array<uint8_t, 32> seed = {7};
+    SHAKE256Sampler a, b;
+    a.init(seed.data(), seed.size());
+    b.init(seed.data(), seed.size());
+
+    std::vector<uint32_t> first(degree), second(degree);
+    a.sample_polynomial_uniform_fast(first.data(), degree, modulus);
+    b.sample_polynomial_uniform_fast(second.data(), degree, modulus);
+    EXPECT_EQ(first, second);
+    for (uint32_t c : first) {
+        EXPECT_LT(c, modulus);
+    }
+    std::set<uint32_t> distinct(first.begin(), first.end());
+    EXPECT_GT(distinct.size(), degree / 2);
+}
+
+// The bit-sliced CBD must follow the bit-by-bit definition and match across backends
+TEST_F(SamplingTest, BitSlicedBinomialMatchesDefinition) {
+    std::vector<uint8_t> buf(cbd_block_bytes(3));
+    for (uint32_t e : {2u, 3u}) {
+        for (int round = 0; round < 8; ++round) {
+            sampler->squeeze(buf.data(), buf.size());
+
+            std::vector<uint32_t> expected(64);
+            for (size_t i = 0; i < 64; ++i) {
+                int32_t a = 0, b = 0;
+                for (uint32_t bit = 0; bit < 2 * e; ++bit) {
+                    size_t index = i * 2 * e + bit;
+                    int32_t value = (buf[index / 8] >> (index % 8)) & 1;
+                    (bit < e ? a : b) += value;
+                }
+                expected[i] = static_cast<uint32_t>((a - b + static_cast<int32_t>(modulus)) % static_cast<int32_t>(modulus));
+            }
+
+            std::vector<uint32_t> scalar(64), dispatched(64);
+            cbd_block64_scalar(scalar.data(), buf.data(), e, modulus);
+            cbd_block64(dispatched.data(), buf.data(), e, modulus);
+            EXPECT_EQ(scalar, expected) << "eta=" << e;
+            EXPECT_EQ(dispatched, expected) << "eta=" << e;
+        }
+    }
+}
+
+TEST_F(SamplingTest, BinomialPolynomialConsumes64EtaBytes) {
+    std::array<uint8_t, 32> seed = {9};
+    for (uint32_t e : {2u, 3u}) {
+        SHAKE256Sampler a, b;
+        a.init(seed.data(), seed.size());
+        b.init(seed.data(), seed.size());
+
+        std::vector<uint32_t> coeffs(degree);
+        a.sample_polynomial_binomial(coeffs.data(), degree, e, modulus);
+        std::vector<uint8_t> skipped(64 * e);
+        b.squeeze(skipped.data(), skipped.size());
+
+        std::vector<uint8_t> next_a(16), next_b(16);
+        a.squeeze(next_a.data(), next_a.size());
+        b.squeeze(next_b.data(), next_b.size());
+        EXPECT_EQ(next_a, next_b) << "eta=" << e;
+    }
+}
+
+TEST_F(SamplingTest, X4Shake256MatchesSingleLane) {
+    const size_t nblocks = 2;
+    std::array<std::array<uint8_t, 32>, 4> seeds;
+    for (size_t lane = 0; lane < 4; ++lane) {
+        seeds[lane].fill(static_cast<uint8_t>(lane + 1));
+        seeds[lane][0] ^= static_cast<uint8_t>(lane);
+    }
+    const uint8_t* seed_ptrs[4] = {seeds[0].data(), seeds[1].data(), seeds[2].data(), seeds[3].data()};
+    std::vector<std::vector<uint8_t>> lanes(4, std::vector<uint8_t>(nblocks * SHAKE256_RATE));
+    uint8_t* out_ptrs[4] = {lanes[0].data(), lanes[1].data(), lanes[2].data(), lanes[3].data()};
+
+    SHAKE256x4Sampler x4;
+    x4.init_x4(seed_ptrs, seeds[0].size());
+    x4.squeeze_blocks_x4(out_ptrs, nblocks);
+
+    for (size_t lane = 0; lane < 4; ++lane) {
+        SHAKE256Sampler single;
+        single.init(seeds[lane].data(), seeds[lane].size());
+        std::vector<uint8_t> expected(nblocks * SHAKE256_RATE);
+        single.squeeze(expected.data(), expected.size());
+        EXPECT_EQ(lanes[lane], expected) << "lane " << lane;
+    }
+}
+
+// The AVX-512 batch must consume the stream exactly like the sequential batch
+TEST_F(SamplingTest, AVX512BatchMatchesSequentialBatch) {
+    std::array<uint8_t, 32> seed = {3, 1, 4};
+    for (uint32_t e : {2u, 3u}) {
+        const size_t batch = 5;
+        std::vector<std::vector<uint32_t>> fast(batch, std::vector<uint32_t>(degree));
+        std::vector<std::vector<uint32_t>> plain(batch, std::vector<uint32_t>(degree));
+        uint32_t* fast_ptrs[batch];
+        uint32_t* plain_ptrs[batch];
+        for (size_t i = 0; i < batch; ++i) {
+            fast_ptrs[i] = fast[i].data();
+            plain_ptrs[i] = plain[i].data();
+        }
+
+        SHAKE256Sampler a, b;
+        a.init(seed.data(), seed.size());
+        b.init(seed.data(), seed.size());
+        a.sample_polynomial_binomial_batch_avx512(fast_ptrs, batch, degree, e, modulus);
+        b.sample_polynomial_binomial_batch(plain_ptrs, batch, degree, e, modulus);
+        EXPECT_EQ(fast, plain) << "eta=" << e;
+
+        std::vector<uint8_t> buf(4 * cbd_block_bytes(e));
+        a.squeeze(buf.data(), buf.size());
+        std::vector<uint32_t> blocks(256), scalar(256);
+        cbd_blocks(blocks.data(), buf.data(), 4, e, modulus);
+        for (size_t blk = 0; blk < 4; ++blk) {
+            cbd_block64_scalar(scalar.data() + 64 * blk, buf.data() + blk * cbd_block_bytes(e), e, modulus);
+        }
+        EXPECT_EQ(blocks, scalar) << "eta=" << e;
+    }
+}
+
 // Test reproducibility with same seed
 TEST_F(SamplingTest, Reproducibility) {
     std::array<uint8_t, 32> seed = {42};
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include "clwe/secure_memory.hpp"
+#include "color_kem.hpp"
+#include "kem_arena.hpp"
+#include "poly.hpp"
+#include "secure_memory_pool.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace clwe {
+
+// The pool is process-wide and cannot be disabled, so these tests run in order in their
+// own executable
+class SecureMemoryTest : public ::testing::Test {
+protected:
+    static constexpr size_t REGION_BYTES = 1 << 20;
+};
+
+// Test that nothing goes to the pool before it is enabled
+TEST_F(SecureMemoryTest, InactiveUntilEnabled) {
+    EXPECT_FALSE(secure_memory_enabled());
+    EXPECT_EQ(secure_pool_allocate(64, 64), nullptr);
+    Poly poly(256);
+    EXPECT_FALSE(secure_pool_release(poly.data(), 256 * sizeof(ColorValue)));
+    EXPECT_EQ(secure_memory_stats().region_bytes, 0u);
+    EXPECT_THROW(enable_secure_memory(0), std::invalid_argument);
+}
+
+// Test that enabling maps one region, once
+TEST_F(SecureMemoryTest, EnablesOnce) {
+    ASSERT_TRUE(enable_secure_memory(REGION_BYTES));
+    EXPECT_TRUE(secure_memory_enabled());
+    SecureMemoryStats stats = secure_memory_stats();
+    EXPECT_GE(stats.region_bytes, REGION_BYTES);
+    EXPECT_EQ(stats.slots_in_use, 0u);
+#if defined(__linux__)
+    EXPECT_TRUE(stats.excluded_from_dumps);
+#endif
+    // locked depends on RLIMIT_MEMLOCK; report it rather than require it
+    RecordProperty("locked", stats.locked ? "yes" : "no");
+
+    EXPECT_TRUE(enable_secure_memory(4 * REGION_BYTES));
+    EXPECT_EQ(secure_memory_stats().region_bytes, stats.region_bytes);
+}
+
+// Test that released slots are wiped and reused
+TEST_F(SecureMemoryTest, WipesAndReusesSlots) {
+    ASSERT_TRUE(secure_memory_enabled());
+    uint8_t* slot = static_cast<uint8_t*>(secure_pool_allocate(1000, 64));
+    ASSERT_NE(slot, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(slot) % SECURE_SLOT_ALIGNMENT, 0u);
+    EXPECT_EQ(secure_pool_slot_size(1000), 1024u);
+    EXPECT_EQ(secure_memory_stats().bytes_in_use, 1024u);
+    std::memset(slot, 0xA5, 1000);
+    EXPECT_TRUE(secure_pool_release(slot, 1000));
+    EXPECT_TRUE(std::all_of(slot, slot + 1024, [](uint8_t b) { return b == 0; }));
+    EXPECT_EQ(secure_memory_stats().slots_in_use, 0u);
+
+    // Same size class, same slot
+    EXPECT_EQ(secure_pool_allocate(600, 64), slot);
+    EXPECT_TRUE(secure_pool_release(slot, 600));
+    EXPECT_EQ(secure_pool_allocate(64, 128), nullptr);
+}
+
+// Test that polynomials and arenas live in the pool and overflow goes to the heap
+TEST_F(SecureMemoryTest, HoldsPolynomialsAndArenas) {
+    ASSERT_TRUE(secure_memory_enabled());
+    const size_t before = secure_memory_stats().slots_in_use;
+    {
+        PolyVec secret(3, 256);
+        KemArena arena(4096);
+        EXPECT_EQ(arena.backing(), PageBacking::SecurePool);
+        EXPECT_EQ(secure_memory_stats().slots_in_use, before + 2);
+        EXPECT_EQ(secret.data()[7].to_math_value(), 0u);
+    }
+    EXPECT_EQ(secure_memory_stats().slots_in_use, before);
+
+    const uint64_t fallbacks = secure_memory_stats().fallbacks;
+    PolyVec oversized(4, 1 << 18);  // 4 MiB, more than the region
+    EXPECT_NE(oversized.data(), nullptr);
+    EXPECT_EQ(secure_memory_stats().fallbacks, fallbacks + 1);
+    EXPECT_EQ(secure_memory_stats().slots_in_use, before);
+}
+
+// Test that a KEM round trip keeps its workspace and prepared key in the pool
+TEST_F(SecureMemoryTest, KemRoundTripInPool) {
+    ASSERT_TRUE(secure_memory_enabled());
+    ColorKEM kem(CLWEParameters(768));
+    KemWorkspace workspace;
+    auto [public_key, private_key] = kem.keygen(workspace);
+    auto [ciphertext, secret] = kem.encapsulate(public_key, workspace);
+    EXPECT_EQ(workspace.page_backing(), PageBacking::SecurePool);
+
+    const size_t before = secure_memory_stats().slots_in_use;
+    {
+        PreparedPrivateKey prepared = kem.prepare_private_key(private_key);
+        EXPECT_GT(secure_memory_stats().slots_in_use, before);
+        EXPECT_EQ(kem.decapsulate(prepared, ciphertext, workspace), secret);
+    }
+    EXPECT_EQ(secure_memory_stats().slots_in_use, before);
+}
+
+} // namespace clwe
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include "color_kem.hpp"
+#include "container.hpp"
 #include <vector>
 #include <stdexcept>
 
@@ -265,4 +266,306 @@ TEST_F(SerializationTest, MemorySafety) {
     EXPECT_NO_THROW(ColorCiphertext::deserialize(ct_ser));
 }
 
-} // namespace clwe
\ No newline at end of file
+// Test the 12-bit packed wire format end to end
+TEST_F(SerializationTest, Packed12Encoding) {
+    CLWEParameters packed_params(768);
+    packed_params.encoding = CoefficientEncoding::PACKED12;
+    ColorKEM packed_kem(packed_params);
+
+    auto [pk, sk] = packed_kem.keygen();
+    auto [ct, ss] = packed_kem.encapsulate(pk);
+
+    uint32_t k = packed_params.module_rank;
+    EXPECT_EQ(pk.public_data.size(), 384u * k);
+    EXPECT_EQ(sk.secret_data.size(), 384u * k);
+    EXPECT_EQ(ct.ciphertext_data.size(), 384u * (k + 1));
+    EXPECT_EQ(ColorPublicKey::serialized_size(packed_params), 32 + 384u * k);
+    EXPECT_EQ(ColorCiphertext::serialized_size(packed_params), 384u * (k + 1) + 4);
+
+    ColorPublicKey pk2 = ColorPublicKey::deserialize(pk.serialize(), packed_params);
+    ColorPrivateKey sk2 = ColorPrivateKey::deserialize(sk.serialize(), packed_params);
+    ColorCiphertext ct2 = ColorCiphertext::deserialize(ct.serialize(), packed_params);
+    EXPECT_EQ(packed_kem.decapsulate(pk2, sk2, ct2), ss);
+
+    // Keys in one encoding are rejected by a KEM using the other
+    ColorKEM color_kem(CLWEParameters(768));
+    EXPECT_THROW(color_kem.encapsulate(pk), std::invalid_argument);
+
+    CLWEParameters wide_params(512, 256, 2, 7681, 3, 2);
+    wide_params.encoding = CoefficientEncoding::PACKED12;
+    EXPECT_THROW(wide_params.validate(), std::invalid_argument);
+}
+
+// Test du/dv ciphertext compression at every security level
+TEST_F(SerializationTest, CompressedCiphertext) {
+    for (uint32_t level : {512u, 768u, 1024u}) {
+        CLWEParameters compressed_params(level);
+        compressed_params.du = level == 1024 ? 11 : 10;
+        compressed_params.dv = level == 1024 ? 5 : 4;
+        compressed_params.validate();
+        ColorKEM compressed_kem(compressed_params);
+
+        uint32_t k = compressed_params.module_rank;
+        size_t expected = 32 * compressed_params.du * k + 32 * compressed_params.dv;
+        EXPECT_EQ(ColorCiphertext::serialized_size(compressed_params), expected + 4);
+
+        auto [pk, sk] = compressed_kem.keygen();
+        for (int i = 0; i < 10; ++i) {
+            auto [ct, ss] = compressed_kem.encapsulate(pk);
+            ASSERT_EQ(ct.ciphertext_data.size(), expected);
+            ColorCiphertext parsed = ColorCiphertext::deserialize(ct.serialize(), compressed_params);
+            EXPECT_EQ(compressed_kem.decapsulate(pk, sk, parsed), ss) << "level " << level;
+        }
+    }
+
+    CLWEParameters half_set(512);
+    half_set.du = 10;
+    EXPECT_THROW(half_set.validate(), std::invalid_argument);
+}
+
+// Test the sparse c2 layout alone and combined with packing and compression
+TEST_F(SerializationTest, SparseC2Layout) {
+    CLWEParameters sparse_params(768);
+    sparse_params.sparse_c2 = true;
+    ColorKEM sparse_kem(sparse_params);
+
+    uint32_t k = sparse_params.module_rank;
+    EXPECT_EQ(ColorCiphertext::serialized_size(sparse_params), 1024u * k + 4 + 4);
+
+    auto [pk, sk] = sparse_kem.keygen();
+    for (int i = 0; i < 10; ++i) {
+        auto [ct, ss] = sparse_kem.encapsulate(pk);
+        ASSERT_EQ(ct.ciphertext_data.size(), 1024u * k + 4);
+        EXPECT_EQ(sparse_kem.decapsulate(pk, sk, ColorCiphertext::deserialize(ct.serialize(), sparse_params)), ss);
+    }
+
+    // Full-layout ciphertexts have the wrong size for a sparse KEM
+    ColorKEM full_kem(CLWEParameters(768));
+    auto [full_pk, full_sk] = full_kem.keygen();
+    auto full_ct = full_kem.encapsulate(full_pk).first;
+    full_ct.params = sparse_params;
+    EXPECT_THROW(sparse_kem.decapsulate(pk, sk, full_ct), std::invalid_argument);
+
+    CLWEParameters small_params(512);
+    small_params.sparse_c2 = true;
+    small_params.encoding = CoefficientEncoding::PACKED12;
+    small_params.du = 10;
+    small_params.dv = 4;
+    ColorKEM small_kem(small_params);
+    EXPECT_EQ(ColorCiphertext::serialized_size(small_params), 320u * 2 + 1 + 4);
+
+    auto [small_pk, small_sk] = small_kem.keygen();
+    for (int i = 0; i < 10; ++i) {
+        auto [ct, ss] = small_kem.encapsulate(small_pk);
+        EXPECT_EQ(small_kem.decapsulate(small_pk, small_sk, ct), ss);
+    }
+}
+
+// Test that rounded public keys shrink, round-trip and still agree with decapsulation
+TEST_F(SerializationTest, RoundedPublicKey) {
+    for (uint32_t level : {512u, 768u, 1024u}) {
+        for (uint32_t d = 1; d <= 3; ++d) {
+            CLWEParameters rounded(level);
+            rounded.t_dropped_bits = d;
+            ColorKEM rounded_kem(rounded);
+
+            // 12 - d bits per coefficient at q = 3329, whatever the coefficient encoding
+            size_t expected = 32 * (12 - d) * rounded.module_rank;
+            EXPECT_EQ(ColorPublicKey::serialized_size(rounded), 32 + expected);
+
+            std::array<uint8_t, 32> seed{};
+            seed.fill(static_cast<uint8_t>(d));
+            auto [pk, sk] = rounded_kem.keygen_derand(seed);
+            ASSERT_EQ(pk.public_data.size(), expected);
+            ColorPublicKey parsed = ColorPublicKey::deserialize(pk.serialize(), rounded);
+            EXPECT_EQ(parsed.public_data, pk.public_data);
+            for (int i = 0; i < 4; ++i) {
+                auto [ct, ss] = rounded_kem.encapsulate(parsed);
+                EXPECT_EQ(rounded_kem.decapsulate(pk, sk, ct), ss) << "level " << level << " d=" << d;
+            }
+
+            // Views and the streamed path decode the same t
+            std::array<uint8_t, 32> m{};
+            m.fill(0x5A);
+            ColorCiphertext from_view;
+            KemWorkspace workspace;
+            EXPECT_EQ(rounded_kem.encapsulate_into(ColorPublicKeyView(pk), m, from_view, workspace),
+                      rounded_kem.encapsulate_derand(pk, m).second);
+            EXPECT_EQ(from_view.ciphertext_data, rounded_kem.encapsulate_derand(pk, m).first.ciphertext_data);
+        }
+    }
+
+    CLWEParameters rounded(512);
+    rounded.t_dropped_bits = 1;
+    ColorKEM rounded_kem(rounded);
+    auto [pk, sk] = rounded_kem.keygen();
+
+    // Full-precision keys have the wrong size, and 2047 is above the largest t1 (1664)
+    ColorPublicKey full = public_key;
+    full.params = rounded;
+    EXPECT_THROW(rounded_kem.encapsulate(full), std::invalid_argument);
+    ColorPublicKey out_of_range = pk;
+    out_of_range.public_data[0] = 0xFF;
+    out_of_range.public_data[1] |= 0x07;
+    EXPECT_THROW(rounded_kem.encapsulate(out_of_range), std::invalid_argument);
+
+    // Containers record the dropped bits
+    ColorPublicKey from_container = public_key_from_container(to_container(pk));
+    EXPECT_EQ(from_container.params.t_dropped_bits, 1u);
+    auto [ct, ss] = rounded_kem.encapsulate(from_container);
+    EXPECT_EQ(rounded_kem.decapsulate(pk, sk, ct), ss);
+}
+
+// Test that containers carry their parameters and round-trip every object type
+TEST_F(SerializationTest, ContainerRoundTrip) {
+    auto pk_container = to_container(public_key);
+    const uint8_t expected_header[ContainerHeader::BYTES] = {
+        'C', 'K', 'E', 'M', 0x01, 0x01, 0x01, 0x00,  // magic, version, public key, checksum, COLOR32
+        0x02, 0x00, 0x01, 0x00, 0x0D, 0x01,          // security level 512, degree 256, modulus 3329
+        0x02, 0x03, 0x02, 0x00, 0x00, 0x00,          // k, eta1, eta2, du, dv, t_dropped_bits
+        0x00, 0x00, 0x08, 0x20};                     // payload: 32 + 2 * 256 * 4 bytes
+    ASSERT_EQ(pk_container.size(), ContainerHeader::BYTES + 2080 + 4);
+    EXPECT_TRUE(std::equal(expected_header, expected_header + ContainerHeader::BYTES, pk_container.begin()));
+
+    ColorPublicKey pk = public_key_from_container(pk_container);
+    EXPECT_EQ(pk.seed, public_key.seed);
+    EXPECT_EQ(pk.public_data, public_key.public_data);
+
+    // Private keys and ciphertexts no longer need parameters passed alongside
+    CLWEParameters other(768);
+    other.encoding = CoefficientEncoding::PACKED12;
+    other.du = 10;
+    other.dv = 4;
+    other.sparse_c2 = true;
+    other.xof = XofAlgorithm::AES256_CTR;
+    ColorKEM other_kem(other);
+    auto [other_pk, other_sk] = other_kem.keygen();
+    auto [other_ct, other_ss] = other_kem.encapsulate(other_pk);
+
+    for (bool checksum : {true, false}) {
+        ColorPublicKey parsed_pk = public_key_from_container(to_container(other_pk, checksum));
+        ColorPrivateKey parsed_sk = private_key_from_container(to_container(other_sk, checksum));
+        ColorCiphertext parsed_ct = ciphertext_from_container(to_container(other_ct, checksum));
+        EXPECT_EQ(parsed_sk.params.security_level, 768u);
+        EXPECT_EQ(parsed_sk.params.encoding, CoefficientEncoding::PACKED12);
+        EXPECT_TRUE(parsed_ct.params.sparse_c2);
+        EXPECT_EQ(parsed_pk.params.xof, XofAlgorithm::AES256_CTR);
+        EXPECT_EQ(parsed_ct.params.du, 10u);
+        EXPECT_EQ(parsed_sk.secret_data, other_sk.secret_data);
+        EXPECT_EQ(other_kem.decapsulate(parsed_pk, parsed_sk, parsed_ct), other_ss);
+    }
+
+    // Views point into the container
+    auto ct_container = to_container(other_ct);
+    ColorCiphertextView ct_view = view_ciphertext_container(ct_container.data(), ct_container.size());
+    EXPECT_EQ(ct_view.ciphertext_data, ct_container.data() + ContainerHeader::BYTES);
+    auto other_pk_container = to_container(other_pk);
+    ColorPublicKeyView pk_view = view_public_key_container(other_pk_container.data(), other_pk_container.size());
+    EXPECT_EQ(pk_view.encoding, CoefficientEncoding::PACKED12);
+    std::array<uint8_t, 32> m{};
+    ColorCiphertext from_view;
+    KemWorkspace workspace;
+    EXPECT_EQ(other_kem.encapsulate_into(pk_view, m, from_view, workspace),
+              other_kem.encapsulate_derand(other_pk, m).second);
+}
+
+// Test that a fixed-weight set is written as a version 2 container that restores the weight
+TEST_F(SerializationTest, ContainerCarriesSecretWeight) {
+    CLWEParameters weighted(768);
+    weighted.secret_weight = 64;
+    ColorKEM weighted_kem(weighted);
+    auto [pk, sk] = weighted_kem.keygen();
+    auto [ct, ss] = weighted_kem.encapsulate(pk);
+
+    auto sk_container = to_container(sk);
+    ASSERT_EQ(sk_container.size(), ContainerHeader::MAX_BYTES + sk.secret_data.size() + 4);
+    EXPECT_EQ(sk_container[4], 2);
+    EXPECT_EQ(sk_container[24], 0x00);
+    EXPECT_EQ(sk_container[25], 0x40);
+    ContainerHeader header = parse_container_header(sk_container.data(), sk_container.size());
+    EXPECT_EQ(header.header_size, ContainerHeader::MAX_BYTES);
+    EXPECT_EQ(header.total_size, sk_container.size());
+
+    ColorPrivateKey parsed_sk = private_key_from_container(sk_container);
+    ColorPublicKey parsed_pk = public_key_from_container(to_container(pk));
+    ColorCiphertext parsed_ct = ciphertext_from_container(to_container(ct, false));
+    EXPECT_EQ(parsed_sk.params.secret_weight, 64u);
+    EXPECT_EQ(parsed_pk.params.secret_weight, 64u);
+    EXPECT_EQ(parsed_ct.params.secret_weight, 64u);
+    EXPECT_EQ(parsed_sk.secret_data, sk.secret_data);
+
+    // A KEM built from the header keeps the sparse decapsulation path
+    ColorKEM restored(parsed_sk.params);
+    EXPECT_NE(restored.prepare_private_key(parsed_sk).sparse_secret, nullptr);
+    EXPECT_EQ(restored.decapsulate(parsed_pk, parsed_sk, parsed_ct), ss);
+
+    auto pk_container = to_container(pk);
+    ColorPublicKeyView view = view_public_key_container(pk_container.data(), pk_container.size());
+    EXPECT_EQ(view.params.secret_weight, 64u);
+
+    // The weight field must be nonzero with zero padding, and fully present
+    auto corrupt = [&](size_t offset, uint8_t value) {
+        std::vector<uint8_t> bad = sk_container;
+        bad[offset] = value;
+        return bad;
+    };
+    EXPECT_THROW(parse_container_header(corrupt(25, 0).data(), sk_container.size()), std::invalid_argument);
+    EXPECT_THROW(parse_container_header(corrupt(27, 1).data(), sk_container.size()), std::invalid_argument);
+    EXPECT_THROW(parse_container_header(sk_container.data(), ContainerHeader::BYTES), std::invalid_argument);
+}
+
+// Test that the header alone gives the frame size and rejects inconsistent headers
+TEST_F(SerializationTest, ContainerHeaderValidation) {
+    auto container = to_container(ciphertext, false);
+    ContainerHeader header = parse_container_header(container.data(), ContainerHeader::BYTES);
+    EXPECT_EQ(header.type, ContainerType::CIPHERTEXT);
+    EXPECT_FALSE(header.has_checksum);
+    EXPECT_EQ(header.payload_size, ColorCiphertext::serialized_size(params));
+    EXPECT_EQ(header.total_size, container.size());
+
+    EXPECT_THROW(parse_container_header(container.data(), ContainerHeader::BYTES - 1), std::invalid_argument);
+    EXPECT_THROW(parse_container_header(nullptr, 0), std::invalid_argument);
+
+    auto corrupt = [&](size_t offset, uint8_t value) {
+        std::vector<uint8_t> bad = container;
+        bad[offset] = value;
+        return bad;
+    };
+    EXPECT_THROW(parse_container_header(corrupt(0, 'X').data(), container.size()), std::invalid_argument);   // magic
+    EXPECT_THROW(parse_container_header(corrupt(4, 3).data(), container.size()), std::invalid_argument);     // version
+    EXPECT_THROW(parse_container_header(corrupt(5, 4).data(), container.size()), std::invalid_argument);     // type
+    EXPECT_THROW(parse_container_header(corrupt(6, 0x10).data(), container.size()), std::invalid_argument);  // flags
+    EXPECT_THROW(parse_container_header(corrupt(7, 2).data(), container.size()), std::invalid_argument);     // encoding
+    EXPECT_THROW(parse_container_header(corrupt(9, 1).data(), container.size()), std::invalid_argument);     // level 513
+    EXPECT_THROW(parse_container_header(corrupt(14, 3).data(), container.size()), std::invalid_argument);    // payload vs k
+    EXPECT_THROW(parse_container_header(corrupt(19, 8).data(), container.size()), std::invalid_argument);    // t_dropped_bits > 7
+    EXPECT_THROW(parse_container_header(corrupt(23, 0).data(), container.size()), std::invalid_argument);    // payload size
+}
+
+// Test that full parsing checks the type, exact size and checksum
+TEST_F(SerializationTest, ContainerIntegrity) {
+    auto container = to_container(private_key);
+    EXPECT_THROW(public_key_from_container(container), std::invalid_argument);
+    EXPECT_THROW(ciphertext_from_container(container), std::invalid_argument);
+
+    std::vector<uint8_t> longer = container;
+    longer.push_back(0);
+    EXPECT_THROW(private_key_from_container(longer), std::invalid_argument);
+    std::vector<uint8_t> shorter(container.begin(), container.end() - 1);
+    EXPECT_THROW(private_key_from_container(shorter), std::invalid_argument);
+
+    // Any flipped payload or trailer byte fails the CRC
+    for (size_t offset : {ContainerHeader::BYTES, container.size() / 2, container.size() - 1}) {
+        std::vector<uint8_t> flipped = container;
+        flipped[offset] ^= 0x01;
+        EXPECT_THROW(private_key_from_container(flipped), std::invalid_argument);
+    }
+    EXPECT_EQ(private_key_from_container(container).secret_data, private_key.secret_data);
+
+    // Objects that do not match their parameters cannot be wrapped
+    ColorPublicKey short_key = public_key;
+    short_key.public_data.resize(short_key.public_data.size() - 4);
+    EXPECT_THROW(to_container(short_key), std::invalid_argument);
+}
+
+} // namespace clwe
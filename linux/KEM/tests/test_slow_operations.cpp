@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+#include "slow_operations.hpp"
+#include "allocation_tracker.hpp"
+#include "color_kem.hpp"
+#include "clwe/autotune.hpp"
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace clwe {
+
+class SlowOperationsTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        clear_slow_operations();
+    }
+
+    void TearDown() override {
+        set_slow_operation_threshold(0);
+        clear_slow_operations();
+    }
+};
+
+TEST_F(SlowOperationsTest, DisabledRecordsNothing) {
+    ColorKEM kem{CLWEParameters(512)};
+    auto keys = kem.keygen();
+    auto encapsulation = kem.encapsulate(keys.first);
+    kem.decapsulate(keys.first, keys.second, encapsulation.first);
+
+    EXPECT_EQ(slow_operation_threshold(), 0u);
+    EXPECT_TRUE(slow_operations().empty());
+    EXPECT_EQ(slow_operations_recorded(), 0u);
+}
+
+// Test that a threshold every operation exceeds records each one once, with its breakdown
+TEST_F(SlowOperationsTest, RecordsStageBreakdown) {
+    ColorKEM kem{CLWEParameters(768)};
+    set_slow_operation_threshold(1);
+    auto keys = kem.keygen();
+    auto encapsulation = kem.encapsulate(keys.first);
+    EXPECT_EQ(kem.decapsulate(keys.first, keys.second, encapsulation.first), encapsulation.second);
+
+    // The decapsulation's re-encryption is part of the decapsulation, not an operation of its own
+    std::vector<SlowOperation> operations = slow_operations();
+    ASSERT_EQ(operations.size(), 3u);
+    EXPECT_EQ(slow_operations_recorded(), 3u);
+    EXPECT_EQ(operations[0].operation, MetricOperation::KEYGEN);
+    EXPECT_EQ(operations[1].operation, MetricOperation::ENCAPSULATE);
+    EXPECT_EQ(operations[2].operation, MetricOperation::DECAPSULATE);
+
+    for (size_t i = 0; i < operations.size(); ++i) {
+        const SlowOperation& operation = operations[i];
+        EXPECT_EQ(operation.sequence, operations[0].sequence + i);
+        EXPECT_EQ(operation.security_level, 768u);
+        EXPECT_GT(operation.duration_ns, 0u);
+        uint64_t staged = 0;
+        for (uint64_t ns : operation.stage_ns) {
+            staged += ns;
+        }
+        EXPECT_LE(staged, operation.duration_ns);
+        EXPECT_EQ(staged + operation.other_ns(), operation.duration_ns);
+        EXPECT_EQ(operation.ntt_backend, ntt_backend());
+        EXPECT_EQ(operation.keccak_backend, keccak_backend());
+#if defined(__linux__)
+        EXPECT_GE(operation.cpu, 0);
+#endif
+        if (i > 0) {
+            EXPECT_GE(operation.start_ns, operations[i - 1].start_ns + operations[i - 1].duration_ns);
+        }
+    }
+
+    const SlowOperation& keygen = operations[0];
+    EXPECT_GT(keygen.stage(SlowStage::MATRIX), 0u);
+    EXPECT_GT(keygen.stage(SlowStage::NOISE), 0u);
+    EXPECT_GT(keygen.stage(SlowStage::MULTIPLY), 0u);
+    EXPECT_GT(keygen.stage(SlowStage::PACK), 0u);
+    EXPECT_EQ(keygen.stage(SlowStage::DECRYPT), 0u);
+    EXPECT_GT(operations[1].stage(SlowStage::NOISE), 0u);
+    EXPECT_GT(operations[1].stage(SlowStage::PACK), 0u);
+    EXPECT_GT(operations[2].stage(SlowStage::UNPACK), 0u);
+    EXPECT_GT(operations[2].stage(SlowStage::DECRYPT), 0u);
+    EXPECT_STREQ(slow_stage_name(SlowStage::MULTIPLY), "multiply");
+}
+
+// Test that operations under the threshold leave nothing and that clearing hides older records
+TEST_F(SlowOperationsTest, ThresholdAndClear) {
+    ColorKEM kem{CLWEParameters(512)};
+    set_slow_operation_threshold(60ull * 1000 * 1000 * 1000);
+    auto keys = kem.keygen();
+    kem.encapsulate(keys.first);
+    EXPECT_TRUE(slow_operations().empty());
+
+    set_slow_operation_threshold(1);
+    kem.encapsulate(keys.first);
+    EXPECT_EQ(slow_operations().size(), 1u);
+    clear_slow_operations();
+    EXPECT_TRUE(slow_operations().empty());
+    EXPECT_EQ(slow_operations_recorded(), 0u);
+    kem.encapsulate(keys.first);
+    EXPECT_EQ(slow_operations().size(), 1u);
+}
+
+// Test that the ring keeps the newest SLOW_OPERATION_CAPACITY records in order
+TEST_F(SlowOperationsTest, RingKeepsNewest) {
+    ColorKEM kem{CLWEParameters(512)};
+    auto keys = kem.keygen();
+    set_slow_operation_threshold(1);
+    const size_t total = SLOW_OPERATION_CAPACITY + 40;
+    for (size_t i = 0; i < total; ++i) {
+        kem.encapsulate(keys.first);
+    }
+    EXPECT_EQ(slow_operations_recorded(), total);
+    std::vector<SlowOperation> operations = slow_operations();
+    ASSERT_EQ(operations.size(), SLOW_OPERATION_CAPACITY);
+    for (size_t i = 1; i < operations.size(); ++i) {
+        EXPECT_EQ(operations[i].sequence, operations[i - 1].sequence + 1);
+    }
+    EXPECT_EQ(operations.back().sequence - operations.front().sequence + 1, SLOW_OPERATION_CAPACITY);
+}
+
+// Test that allocations made during the operation are counted, and only those
+TEST_F(SlowOperationsTest, CountsAllocations) {
+    ColorKEM kem{CLWEParameters(512)};
+    auto keys = kem.keygen();
+    ExpandedPublicKey expanded = kem.expand_public_key(keys.first);
+    KemWorkspace workspace;
+    ColorCiphertext ciphertext;
+    std::array<uint8_t, 32> m{};
+    kem.encapsulate_into(expanded, m, ciphertext, workspace);
+    set_slow_operation_threshold(1);
+
+    // Warm, encapsulate_into() allocates nothing; keygen returns freshly allocated keys
+    kem.encapsulate_into(expanded, m, ciphertext, workspace);
+    kem.keygen();
+    std::vector<SlowOperation> operations = slow_operations();
+    ASSERT_EQ(operations.size(), 2u);
+    ASSERT_TRUE(AllocationTracker::hooks_installed());
+    EXPECT_EQ(operations[0].heap_allocations, 0u);
+    EXPECT_GT(operations[1].heap_allocations, 0u);
+}
+
+// Test that concurrent recorders each publish whole records
+TEST_F(SlowOperationsTest, ConcurrentRecording) {
+    ColorKEM kem{CLWEParameters(512)};
+    auto keys = kem.keygen();
+    set_slow_operation_threshold(1);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 50; ++i) {
+                kem.encapsulate(keys.first);
+                slow_operations();
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(slow_operations_recorded(), 200u);
+    std::vector<SlowOperation> operations = slow_operations();
+    EXPECT_EQ(operations.size(), 200u);
+    std::set<uint64_t> sequences;
+    for (const SlowOperation& operation : operations) {
+        sequences.insert(operation.sequence);
+        EXPECT_EQ(operation.operation, MetricOperation::ENCAPSULATE);
+        EXPECT_EQ(operation.security_level, 512u);
+        EXPECT_GT(operation.stage(SlowStage::NOISE), 0u);
+    }
+    EXPECT_EQ(sequences.size(), operations.size());
+}
+
+} // namespace clwe
@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+#include "color_kem.hpp"
+#include "color_ntt_engine.hpp"
+#include "sparse_ternary.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace clwe {
+
+namespace {
+
+std::vector<uint8_t> test_random(size_t size, uint32_t salt) {
+    std::vector<uint8_t> bytes(size);
+    uint32_t x = 0x9E3779B9u ^ salt;
+    for (auto& b : bytes) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        b = static_cast<uint8_t>(x);
+    }
+    return bytes;
+}
+
+std::vector<ColorValue> ternary_vec(uint32_t rank, uint32_t n, uint32_t weight, uint32_t q, uint32_t salt) {
+    std::vector<ColorValue> s(static_cast<size_t>(rank) * n);
+    std::vector<uint32_t> keys(n);
+    for (uint32_t i = 0; i < rank; ++i) {
+        std::vector<uint8_t> random = test_random(fixed_weight_random_bytes(n), salt + i);
+        sample_fixed_weight_ternary(random.data(), n, weight, q, keys.data(), s.data() + static_cast<size_t>(i) * n);
+    }
+    return s;
+}
+
+// s^T c mod (x^n - 1, q) straight from the definition
+std::vector<uint32_t> reference_dot(const std::vector<ColorValue>& s, const std::vector<ColorValue>& c,
+                                    uint32_t rank, uint32_t n, uint32_t q) {
+    std::vector<uint64_t> acc(n, 0);
+    for (uint32_t p = 0; p < rank; ++p) {
+        for (uint32_t i = 0; i < n; ++i) {
+            uint64_t a = s[p * n + i].to_math_value();
+            for (uint32_t j = 0; j < n; ++j) {
+                uint64_t prod = a * c[p * n + j].to_math_value() % q;
+                acc[(i + j) % n] = (acc[(i + j) % n] + prod) % q;
+            }
+        }
+    }
+    return std::vector<uint32_t>(acc.begin(), acc.end());
+}
+
+} // namespace
+
+// Test that the sampler sets exactly weight coefficients, each to +1 or -1
+TEST(SparseTernaryTest, SamplerHasExactWeight) {
+    const uint32_t q = 3329;
+    for (uint32_t weight : {0u, 1u, 64u, 128u, 256u}) {
+        std::vector<ColorValue> s = ternary_vec(1, 256, weight, q, weight);
+        uint32_t plus = 0, minus = 0;
+        for (const ColorValue& v : s) {
+            uint32_t m = v.to_math_value();
+            ASSERT_TRUE(m == 0 || m == 1 || m == q - 1) << m;
+            plus += m == 1;
+            minus += m == q - 1;
+        }
+        EXPECT_EQ(plus + minus, weight);
+        if (weight >= 64) {
+            EXPECT_GT(plus, 0u);
+            EXPECT_GT(minus, 0u);
+        }
+    }
+
+    // Different randomness, different positions
+    std::vector<ColorValue> a = ternary_vec(1, 256, 64, q, 1);
+    std::vector<ColorValue> b = ternary_vec(1, 256, 64, q, 2);
+    bool differ = false;
+    for (uint32_t i = 0; i < 256; ++i) {
+        differ |= a[i].to_math_value() != b[i].to_math_value();
+    }
+    EXPECT_TRUE(differ);
+}
+
+// Test that assign() accepts ternary vectors within the weight and rejects the rest
+TEST(SparseTernaryTest, AssignChecksShapeAndWeight) {
+    const uint32_t q = 3329, n = 256;
+    std::vector<ColorValue> s = ternary_vec(2, n, 64, q, 7);
+    SparseTernaryVec sparse(2, n, 64);
+    ASSERT_TRUE(sparse.assign(s.data(), q));
+    for (uint32_t i = 0; i < 2; ++i) {
+        uint32_t previous = 0;
+        for (uint32_t t = 0; t < 64; ++t) {
+            uint32_t p = sparse.positions(i)[t];
+            if (t > 0) {
+                EXPECT_GT(p, previous);
+            }
+            previous = p;
+            uint32_t expected = sparse.signs(i)[t] == 1 ? 1 : q - 1;
+            EXPECT_EQ(s[i * n + p].to_math_value(), expected);
+        }
+    }
+
+    // Fewer nonzeros than the weight leave empty slots
+    SparseTernaryVec roomy(2, n, 80);
+    EXPECT_TRUE(roomy.assign(s.data(), q));
+    EXPECT_EQ(roomy.signs(1)[79], 0u);
+
+    SparseTernaryVec tight(2, n, 63);
+    EXPECT_FALSE(tight.assign(s.data(), q));
+
+    std::vector<ColorValue> binomial = s;
+    binomial[n + 3] = ColorValue::from_math_value(2);
+    EXPECT_FALSE(sparse.assign(binomial.data(), q));
+}
+
+// Test that the sparse product matches the schoolbook and NTT products
+TEST(SparseTernaryTest, DotMatchesCyclicProduct) {
+    const uint32_t q = 3329, n = 256, rank = 3;
+    std::vector<ColorValue> s = ternary_vec(rank, n, 64, q, 11);
+    std::vector<ColorValue> c(rank * n);
+    for (uint32_t i = 0; i < rank * n; ++i) {
+        c[i] = ColorValue::from_math_value((i * 7919u + 13u) % q);
+    }
+    SparseTernaryVec sparse(rank, n, 64);
+    ASSERT_TRUE(sparse.assign(s.data(), q));
+
+    std::vector<uint32_t> rotate_a(n), rotate_b(n);
+    std::vector<ColorValue> out(n);
+    sparse_ternary_dot(sparse, c.data(), q, rotate_a.data(), rotate_b.data(), out.data());
+    std::vector<uint32_t> expected = reference_dot(s, c, rank, n, q);
+    for (uint32_t i = 0; i < n; ++i) {
+        ASSERT_EQ(out[i].to_math_value(), expected[i]) << "i=" << i;
+    }
+    EXPECT_EQ(sparse_ternary_dot_constant(sparse, c.data(), q), expected[0]);
+
+    // Through the NTT engine, whose products come out scaled by n
+    ColorNTTEngine engine(q, n);
+    std::vector<uint64_t> acc(n, 0);
+    std::vector<ColorValue> prod(n);
+    for (uint32_t i = 0; i < rank; ++i) {
+        engine.multiply_colors(s.data() + i * n, c.data() + i * n, prod.data());
+        for (uint32_t j = 0; j < n; ++j) {
+            acc[j] = (acc[j] + prod[j].to_math_value()) % q;
+        }
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+        ASSERT_EQ(acc[i], static_cast<uint64_t>(out[i].to_math_value()) * n % q) << "i=" << i;
+    }
+}
+
+// Test fixed-weight KEM round trips, with prepared keys taking the sparse path
+TEST(SparseTernaryTest, KemRoundTrip) {
+    for (uint32_t level : {512u, 768u, 1024u}) {
+        for (bool sparse_c2 : {false, true}) {
+            CLWEParameters params(level);
+            params.secret_weight = 64;
+            params.sparse_c2 = sparse_c2;
+            ColorKEM kem(params);
+            auto [public_key, private_key] = kem.keygen();
+            PreparedPrivateKey prepared = kem.prepare_private_key(private_key);
+            ASSERT_NE(prepared.sparse_secret, nullptr) << level;
+            for (int trial = 0; trial < 4; ++trial) {
+                auto [ciphertext, secret] = kem.encapsulate(public_key);
+                EXPECT_EQ(kem.decapsulate(prepared, ciphertext), secret) << level << " " << sparse_c2;
+                EXPECT_EQ(kem.decapsulate(public_key, private_key, ciphertext), secret);
+            }
+        }
+    }
+
+    // A binomial secret under a weighted parameter set falls back to the NTT path
+    CLWEParameters binomial(768);
+    ColorKEM binomial_kem(binomial);
+    auto [public_key, private_key] = binomial_kem.keygen();
+    CLWEParameters weighted = binomial;
+    weighted.secret_weight = 64;
+    ColorKEM weighted_kem(weighted);
+    private_key.params = weighted;
+    public_key.params = weighted;
+    PreparedPrivateKey prepared = weighted_kem.prepare_private_key(private_key);
+    EXPECT_EQ(prepared.sparse_secret, nullptr);
+    auto [ciphertext, secret] = weighted_kem.encapsulate(public_key);
+    EXPECT_EQ(weighted_kem.decapsulate(prepared, ciphertext), secret);
+}
+
+} // namespace clwe
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include "trace.hpp"
+#include "color_kem.hpp"
+#include <algorithm>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace clwe {
+
+class TraceTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        set_trace_sink(nullptr);
+    }
+};
+
+// Test that spans report to the installed sink and to nothing once it is removed
+TEST_F(TraceTest, SpanReportsToInstalledSink) {
+    RingBufferTraceSink sink(8);
+    {
+        TraceSpan span("untraced");
+    }
+    EXPECT_TRUE(sink.snapshot().empty());
+
+    set_trace_sink(&sink);
+    EXPECT_EQ(trace_sink(), &sink);
+    {
+        TraceSpan outer("outer");
+        TraceSpan inner("inner");
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    set_trace_sink(nullptr);
+    {
+        TraceSpan span("after");
+    }
+
+    std::vector<TraceEvent> events = sink.snapshot();
+    ASSERT_EQ(events.size(), 2u);
+    EXPECT_STREQ(events[0].name, "inner");
+    EXPECT_STREQ(events[1].name, "outer");
+    EXPECT_GE(events[1].duration_ns, 1000000u);
+    EXPECT_LE(events[1].start_ns, events[0].start_ns);
+    EXPECT_EQ(events[0].thread_id, events[1].thread_id);
+}
+
+// Test that the ring buffer keeps the newest events in order
+TEST_F(TraceTest, RingBufferOverwritesOldest) {
+    static const char* names[] = {"a", "b", "c", "d", "e"};
+    RingBufferTraceSink sink(3);
+    for (uint64_t i = 0; i < 5; ++i) {
+        sink.record({names[i], i, 1, 1});
+    }
+
+    std::vector<TraceEvent> events = sink.snapshot();
+    ASSERT_EQ(events.size(), 3u);
+    EXPECT_STREQ(events[0].name, "c");
+    EXPECT_STREQ(events[1].name, "d");
+    EXPECT_STREQ(events[2].name, "e");
+    EXPECT_EQ(sink.dropped(), 2u);
+
+    sink.clear();
+    EXPECT_TRUE(sink.snapshot().empty());
+    EXPECT_EQ(sink.dropped(), 0u);
+    EXPECT_THROW(RingBufferTraceSink(0), std::invalid_argument);
+}
+
+// Test the Chrome trace event output
+TEST_F(TraceTest, ChromeTraceJson) {
+    ChromeTraceSink sink;
+    sink.record({"keygen", 1234567, 2000, 3});
+    sink.record({"quote\"d", 5, 40, 4});
+    EXPECT_EQ(sink.size(), 2u);
+
+    std::ostringstream out;
+    sink.write(out);
+    EXPECT_EQ(out.str(),
+              "{\"traceEvents\":["
+              "{\"name\":\"keygen\",\"cat\":\"clwe\",\"ph\":\"X\",\"pid\":1,\"tid\":3,\"ts\":1234.567,\"dur\":2.000},"
+              "{\"name\":\"quote\\\"d\",\"cat\":\"clwe\",\"ph\":\"X\",\"pid\":1,\"tid\":4,\"ts\":0.005,\"dur\":0.040}"
+              "]}");
+
+    std::ostringstream empty;
+    write_chrome_trace(empty, {});
+    EXPECT_EQ(empty.str(), "{\"traceEvents\":[]}");
+}
+
+// Test that the KEM stages show up when spans are compiled in, and nothing otherwise
+TEST_F(TraceTest, KemStagesTraced) {
+    ColorKEM kem(CLWEParameters(512));
+    RingBufferTraceSink sink(256);
+    set_trace_sink(&sink);
+    auto keys = kem.keygen();
+    auto [ciphertext, secret] = kem.encapsulate(keys.first);
+    EXPECT_EQ(kem.decapsulate(keys.first, keys.second, ciphertext), secret);
+    set_trace_sink(nullptr);
+
+    std::set<std::string> names;
+    for (const TraceEvent& event : sink.snapshot()) {
+        names.insert(event.name);
+    }
+#if defined(CLWE_ENABLE_TRACING)
+    for (const char* stage : {"keygen", "generate_matrix_A", "sample_noise", "matrix_vector_mul", "pack_keys",
+                              "encapsulate", "encrypt", "pack_ciphertext", "decapsulate", "decrypt"}) {
+        EXPECT_EQ(names.count(stage), 1u) << stage;
+    }
+#else
+    EXPECT_TRUE(names.empty());
+#endif
+}
+
+} // namespace clwe
@@ -1,8 +1,17 @@
 #include <gtest/gtest.h>
 #include "utils.hpp"
+#include "csprng.hpp"
+#include "clwe/random_source.hpp"
+#include "cpu_features.hpp"
+#include "simd_target.hpp"
 #include <vector>
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <cstring>
 #include <thread>
+#include <sys/wait.h>
+#include <unistd.h>
 
 namespace clwe {
 
@@ -170,6 +179,117 @@ TEST_F(UtilsTest, SecureRandomBytes) {
     EXPECT_NO_THROW(secure_random_bytes(large_buffer, 1024));
 }
 
+// RFC 8439 appendix A.1, test vector 1: all-zero key, nonce and counter
+static const uint8_t CHACHA20_ZERO_BLOCK[64] = {
+    0x76, 0xb8, 0xe0, 0xad, 0xa0, 0xf1, 0x3d, 0x90, 0x40, 0x5d, 0x6a, 0xe5, 0x53, 0x86, 0xbd, 0x28,
+    0xbd, 0xd2, 0x19, 0xb8, 0xa0, 0x8d, 0xed, 0x1a, 0xa8, 0x36, 0xef, 0xcc, 0x8b, 0x77, 0x0d, 0xc7,
+    0xda, 0x41, 0x59, 0x7c, 0x51, 0x57, 0x48, 0x8d, 0x77, 0x24, 0xe0, 0x3f, 0xb8, 0xd8, 0x4a, 0x37,
+    0x6a, 0x43, 0xb8, 0xf4, 0x15, 0x18, 0xa1, 0x1c, 0xc3, 0x87, 0xb6, 0x69, 0xb2, 0xee, 0x65, 0x86
+};
+
+TEST_F(UtilsTest, ChaCha20Block) {
+    uint32_t key[8] = {};
+    uint8_t out[ChaCha20Drbg::BLOCK_BYTES];
+    ChaCha20Drbg::block(key, 0, out);
+    EXPECT_EQ(0, std::memcmp(out, CHACHA20_ZERO_BLOCK, sizeof(out)));
+}
+
+// The first 32 keystream bytes become the next key and are never served
+TEST_F(UtilsTest, DrbgFastKeyErasure) {
+    uint8_t key[ChaCha20Drbg::KEY_BYTES] = {};
+    ChaCha20Drbg drbg;
+    drbg.seed(key);
+
+    uint8_t out[32];
+    drbg.generate(out, sizeof(out));
+    EXPECT_EQ(0, std::memcmp(out, CHACHA20_ZERO_BLOCK + 32, sizeof(out)));
+
+    // Reads of any size draw the same stream
+    ChaCha20Drbg a, b;
+    a.seed(key);
+    b.seed(key);
+    std::vector<uint8_t> whole(3 * ChaCha20Drbg::BUFFER_BYTES + 5);
+    std::vector<uint8_t> pieces(whole.size());
+    a.generate(whole.data(), whole.size());
+    for (size_t i = 0; i < pieces.size(); i += 7) {
+        b.generate(pieces.data() + i, std::min<size_t>(7, pieces.size() - i));
+    }
+    EXPECT_EQ(whole, pieces);
+}
+
+TEST_F(UtilsTest, DrbgPerThreadStreams) {
+    std::array<uint8_t, 32> main_bytes, other_bytes;
+    secure_random_bytes(main_bytes.data(), main_bytes.size());
+    std::thread other([&] { secure_random_bytes(other_bytes.data(), other_bytes.size()); });
+    other.join();
+    EXPECT_NE(main_bytes, other_bytes);
+}
+
+// A forked child must not replay the parent's buffered output
+TEST_F(UtilsTest, DrbgReseedsAfterFork) {
+    std::array<uint8_t, 32> parent_bytes, child_bytes;
+    secure_random_bytes(parent_bytes.data(), 1);  // leave output buffered
+
+    int fds[2];
+    ASSERT_EQ(0, pipe(fds));
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        secure_random_bytes(child_bytes.data(), child_bytes.size());
+        ssize_t written = write(fds[1], child_bytes.data(), child_bytes.size());
+        _exit(written == static_cast<ssize_t>(child_bytes.size()) ? 0 : 1);
+    }
+    close(fds[1]);
+    secure_random_bytes(parent_bytes.data(), parent_bytes.size());
+    ASSERT_EQ(static_cast<ssize_t>(child_bytes.size()), read(fds[0], child_bytes.data(), child_bytes.size()));
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    EXPECT_EQ(0, status);
+    EXPECT_NE(parent_bytes, child_bytes);
+}
+
+TEST_F(UtilsTest, DrbgReseedInterval) {
+    std::vector<uint8_t> bytes(ChaCha20Drbg::RESEED_INTERVAL + ChaCha20Drbg::BUFFER_BYTES);
+    EXPECT_NO_THROW(secure_random_bytes(bytes.data(), bytes.size()));
+}
+
+TEST_F(UtilsTest, RandomSources) {
+    std::array<uint8_t, 32> seed{};
+    seed[0] = 7;
+
+    // The deterministic source is the DRBG stream for its seed, however the reads are split
+    DeterministicRandomSource a(seed), b(seed);
+    ChaCha20Drbg reference;
+    reference.seed(seed.data());
+    std::vector<uint8_t> whole(2 * ChaCha20Drbg::BUFFER_BYTES + 3), pieces(whole.size()), expected(whole.size());
+    a.generate(whole.data(), whole.size());
+    for (size_t i = 0; i < pieces.size(); i += 100) {
+        b.generate(pieces.data() + i, std::min<size_t>(100, pieces.size() - i));
+    }
+    reference.generate(expected.data(), expected.size());
+    EXPECT_EQ(whole, expected);
+    EXPECT_EQ(pieces, expected);
+    EXPECT_FALSE(a.is_secure());
+
+    seed[0] = 8;
+    DeterministicRandomSource other(seed);
+    std::vector<uint8_t> other_bytes(32);
+    other.generate(other_bytes.data(), other_bytes.size());
+    EXPECT_FALSE(std::equal(other_bytes.begin(), other_bytes.end(), expected.begin()));
+
+    OSRandomSource os;
+    DrbgRandomSource drbg;
+    std::array<uint8_t, 32> x{}, y{};
+    os.generate(x.data(), x.size());
+    drbg.generate(y.data(), y.size());
+    EXPECT_NE(x, y);
+    EXPECT_TRUE(os.is_secure());
+    EXPECT_TRUE(drbg.is_secure());
+    EXPECT_TRUE(default_random_source()->is_secure());
+    EXPECT_EQ(default_random_source(), default_random_source());
+}
+
 // Test AVXAllocator
 TEST_F(UtilsTest, AVXAllocator) {
     // Test allocation and deallocation
@@ -272,10 +392,17 @@ TEST_F(UtilsTest, AVXVectorBounds) {
 }
 
 #ifdef HAVE_AVX2
+CLWE_TARGET_AVX2 static uint32_t reduce_avx_lanes(uint32_t value, uint32_t q) {
+    avx_type vec = _mm256_set1_epi32(static_cast<int>(value));
+    return montgomery_reduce_avx(vec, q);
+}
+
 // Test AVX-specific functions
 TEST_F(UtilsTest, AVXFunctions) {
-    avx_type vec = _mm256_set1_epi32(42);
-    uint32_t result = montgomery_reduce_avx(vec, modulus);
+    if (!CPUFeatureDetector::cached().has_avx2) {
+        GTEST_SKIP() << "CPU lacks AVX2";
+    }
+    uint32_t result = reduce_avx_lanes(42, modulus);
     EXPECT_LT(result, modulus);
     EXPECT_GE(result, 0u);
 }
@@ -0,0 +1,40 @@
+#include <gtest/gtest.h>
+#include "clwe/warmup.hpp"
+#include "color_kem.hpp"
+
+namespace clwe {
+
+// Test that warmup reports every parameter set and Keccak backend and leaves the selection alone
+TEST(WarmupTest, ReportsWhatItWarmed) {
+    KeccakBackend selected = keccak_backend();
+    WarmupReport report = warmup({CLWEParameters(512), CLWEParameters(768)});
+    EXPECT_EQ(report.parameter_sets, 2u);
+    EXPECT_EQ(report.keccak_backends, available_keccak_backends());
+    EXPECT_EQ(report.workspace_bytes, ColorKEM::memory_requirements(CLWEParameters(768)).workspace_bytes());
+    EXPECT_GT(report.elapsed_us, 0.0);
+    EXPECT_EQ(keccak_backend(), selected);
+
+    WarmupReport shared_only = warmup({});
+    EXPECT_EQ(shared_only.parameter_sets, 0u);
+    EXPECT_EQ(shared_only.workspace_bytes, 0u);
+}
+
+// Test that a warmed caller workspace already holds the arena of every operation
+TEST(WarmupTest, PrefaultsCallerWorkspace) {
+    CLWEParameters params(1024);
+    KemWorkspace workspace;
+    WarmupReport report = warmup({params}, workspace);
+    EXPECT_EQ(report.parameter_sets, 1u);
+    EXPECT_EQ(report.workspace_bytes, workspace.reserved_bytes());
+    EXPECT_GE(workspace.reserved_bytes(), ColorKEM::memory_requirements(params).workspace_bytes());
+
+    const size_t reserved = workspace.reserved_bytes();
+    ColorKEM kem(params);
+    auto [public_key, private_key] = kem.keygen(workspace);
+    auto [ciphertext, shared_key] = kem.encapsulate_key(public_key, workspace);
+    ColorExpandedPrivateKey expanded = kem.expand_private_key(public_key, private_key);
+    EXPECT_EQ(kem.decapsulate_key(expanded, ciphertext, workspace), shared_key);
+    EXPECT_EQ(workspace.reserved_bytes(), reserved);
+}
+
+} // namespace clwe
@@ -6,6 +6,7 @@
 #include "clwe/clwe.hpp"
 #include "src/core/color_kem.hpp"
 #include "src/core/cpu_features.hpp"
+#include "src/core/ntt_engine.hpp"
 #include "src/core/performance_metrics.hpp"
 
 using namespace clwe;
@@ -125,6 +126,13 @@ int main() {
     
     CPUFeatures features = CPUFeatureDetector::detect();
     std::cout << "CPU: " << features.to_string() << std::endl;
+    // Cycle figures are only comparable between runs that used the same engine
+    clwe::CLWEParameters default_params;
+    auto engine = create_optimal_ntt_engine(default_params.modulus, default_params.degree);
+    std::cout << "NTT engine: " << (engine->get_simd_support() == SIMDSupport::NEON   ? "NEON"
+                                    : engine->get_simd_support() == SIMDSupport::AVX2 ? "AVX2"
+                                                                                      : "scalar")
+              << std::endl;
     std::cout << std::endl;
 
     
@@ -746,12 +746,12 @@ std::vector<uint8_t> ColorPublicKey::serialize() const {
 }
 
 ColorPublicKey ColorPublicKey::deserialize(const std::vector<uint8_t>& data, const CLWEParameters& params) {
-    if (data.size() < 40) { // Minimum: header(8) + seed(32)
-        throw std::invalid_argument("Public key data too small: minimum 40 bytes required, got " + std::to_string(data.size()));
-    }
+    return deserialize(data.data(), data.size(), params);
+}
 
-    if (data.empty()) {
-        throw std::invalid_argument("Public key data cannot be empty");
+ColorPublicKey ColorPublicKey::deserialize(const uint8_t* data, size_t size, const CLWEParameters& params) {
+    if (size < 40) { // Minimum: header(8) + seed(32)
+        throw std::invalid_argument("Public key data too small: minimum 40 bytes required, got " + std::to_string(size));
     }
 
     size_t offset = 0;
@@ -767,17 +767,16 @@ ColorPublicKey ColorPublicKey::deserialize(const std::vector<uint8_t>& data, con
                                 data[offset + 3];
         offset += 4;
 
-        if (offset + 32 > data.size()) {
+        if (offset + 32 > size) {
             throw std::invalid_argument("Public key data too small for seed");
         }
 
         ColorPublicKey key;
-        std::copy(data.begin() + offset, data.begin() + offset + 32, key.seed.begin());
+        std::copy(data + offset, data + offset + 32, key.seed.begin());
         offset += 32;
 
         // Decompress the public data
-        std::vector<uint8_t> compressed_data(data.begin() + offset, data.end());
-        key.public_data = decode_colors_to_color_kem_key_compressed(compressed_data, original_size);
+        key.public_data = decode_colors_to_color_kem_key_compressed(data + offset, size - offset, original_size);
         key.params = params;
 
         // Validate public data size (should be multiple of 4 for ColorValue serialization and non-empty)
@@ -788,8 +787,8 @@ ColorPublicKey ColorPublicKey::deserialize(const std::vector<uint8_t>& data, con
     } else {
         // Legacy uncompressed format (for backward compatibility)
         ColorPublicKey key;
-        std::copy(data.begin(), data.begin() + 32, key.seed.begin());
-        key.public_data.assign(data.begin() + 32, data.end());
+        std::copy(data, data + 32, key.seed.begin());
+        key.public_data.assign(data + 32, data + size);
         key.params = params;
 
         // Validate public data size (should be multiple of 4 for ColorValue serialization and non-empty)
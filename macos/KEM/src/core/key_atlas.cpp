@@ -0,0 +1,248 @@
+#include "clwe/key_atlas.hpp"
+#include "clwe/key_image_codec.hpp"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace clwe {
+
+namespace {
+
+constexpr size_t KEY_SIZE_HEADER_BYTES = 4;
+constexpr size_t MAX_ATLAS_WIDTH = 65536;
+constexpr uint8_t QOI_END_MARKER[QoiKeyImageCodec::END_MARKER_BYTES] = {0, 0, 0, 0, 0, 0, 0, 1};
+
+bool valid_label(const std::string& label) {
+    return !label.empty() && std::none_of(label.begin(), label.end(),
+                                          [](char c) { return std::isspace(static_cast<unsigned char>(c)) != 0; });
+}
+
+// "key value" header line of the index
+size_t read_header_value(std::istream& in, const char* key) {
+    std::string line;
+    std::string name;
+    size_t value = 0;
+    if (!std::getline(in, line)) {
+        throw std::invalid_argument(std::string("Key atlas index ends before '") + key + "'");
+    }
+    std::istringstream fields(line);
+    if (!(fields >> name >> value) || name != key) {
+        throw std::invalid_argument(std::string("Key atlas index has no '") + key + "' line");
+    }
+    return value;
+}
+
+} // namespace
+
+void KeyAtlasIndex::write(std::ostream& out) const {
+    out << "clwe-key-atlas 1\n"
+        << "codec qoi\n"
+        << "width " << width << "\n"
+        << "height " << height << "\n"
+        << "tiles " << entries.size() << "\n";
+    for (const KeyAtlasEntry& entry : entries) {
+        out << entry.label << ' ' << entry.security_level << ' ' << entry.first_row << ' ' << entry.rows << ' '
+            << entry.byte_offset << ' ' << entry.byte_length << ' ' << entry.key_bytes << '\n';
+    }
+}
+
+KeyAtlasIndex KeyAtlasIndex::read(std::istream& in) {
+    std::string line;
+    if (!std::getline(in, line) || line != "clwe-key-atlas 1") {
+        throw std::invalid_argument("Not a version 1 key atlas index");
+    }
+    if (!std::getline(in, line) || line != "codec qoi") {
+        throw std::invalid_argument("Key atlas index names an unsupported codec");
+    }
+
+    KeyAtlasIndex index;
+    index.width = read_header_value(in, "width");
+    index.height = read_header_value(in, "height");
+    const size_t tiles = read_header_value(in, "tiles");
+    if (index.width == 0 || index.width > MAX_ATLAS_WIDTH || index.height == 0 ||
+        index.height > QoiKeyImageCodec::MAX_PIXELS / index.width) {
+        throw std::invalid_argument("Key atlas index has invalid dimensions");
+    }
+
+    // Tiles start on consecutive rows, so every fit is checked against the height
+    size_t next_row = 0;
+    for (size_t i = 0; i < tiles; ++i) {
+        if (!std::getline(in, line)) {
+            throw std::invalid_argument("Key atlas index ends after " + std::to_string(i) + " of " +
+                                        std::to_string(tiles) + " tiles");
+        }
+        KeyAtlasEntry entry;
+        std::istringstream fields(line);
+        std::string extra;
+        if (!(fields >> entry.label >> entry.security_level >> entry.first_row >> entry.rows >> entry.byte_offset >>
+              entry.byte_length >> entry.key_bytes) ||
+            (fields >> extra)) {
+            throw std::invalid_argument("Malformed key atlas tile line " + std::to_string(i));
+        }
+        if (entry.first_row != next_row || entry.rows == 0 || entry.rows > index.height - entry.first_row ||
+            entry.key_bytes + KEY_SIZE_HEADER_BYTES > entry.rows * index.width * 3 || entry.byte_length == 0) {
+            throw std::invalid_argument("Key atlas tile '" + entry.label + "' does not fit the atlas");
+        }
+        next_row = entry.first_row + entry.rows;
+        index.entries.push_back(std::move(entry));
+    }
+    return index;
+}
+
+const KeyAtlasEntry* KeyAtlasIndex::find(const std::string& label) const {
+    auto it = std::find_if(entries.begin(), entries.end(),
+                           [&label](const KeyAtlasEntry& entry) { return entry.label == label; });
+    return it == entries.end() ? nullptr : &*it;
+}
+
+KeyAtlasWriter::KeyAtlasWriter(std::ostream& image, size_t width)
+    : image_(image), start_(image.tellp()), offset_(QoiKeyImageCodec::HEADER_BYTES) {
+    if (width == 0 || width > MAX_ATLAS_WIDTH) {
+        throw std::invalid_argument("Invalid key atlas width: " + std::to_string(width));
+    }
+    index_.width = width;
+
+    // Height 0 until finish() knows it
+    std::vector<uint8_t> header;
+    QoiKeyImageCodec::write_header(width, 0, header);
+    image_.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+    if (!image_) {
+        throw std::runtime_error("Failed to write key atlas header");
+    }
+}
+
+KeyAtlasWriter::Tile KeyAtlasWriter::encode_tile(const uint8_t* key, size_t size, size_t width) {
+    if (width == 0 || key == nullptr || size == 0 || size > 0xFFFFFFFFu) {
+        throw std::invalid_argument("Invalid key for a key atlas tile");
+    }
+    const size_t row_bytes = width * 3;
+    Tile tile;
+    tile.key_bytes = size;
+    tile.rows = (KEY_SIZE_HEADER_BYTES + size + row_bytes - 1) / row_bytes;
+
+    std::vector<uint8_t> pixels(tile.rows * row_bytes, 0);
+    pixels[0] = static_cast<uint8_t>(size >> 24);
+    pixels[1] = static_cast<uint8_t>(size >> 16);
+    pixels[2] = static_cast<uint8_t>(size >> 8);
+    pixels[3] = static_cast<uint8_t>(size);
+    std::copy(key, key + size, pixels.begin() + KEY_SIZE_HEADER_BYTES);
+
+    tile.data.reserve(tile.rows * width * 4);
+    QoiKeyImageCodec::encode_chunks(pixels.data(), tile.rows * width, true, tile.data);
+    return tile;
+}
+
+bool KeyAtlasWriter::fits(size_t rows) const {
+    return rows <= QoiKeyImageCodec::MAX_PIXELS / index_.width - index_.height;
+}
+
+void KeyAtlasWriter::add(const std::string& label, uint32_t security_level, const Tile& tile) {
+    if (finished_) {
+        throw std::logic_error("Key atlas is already finished");
+    }
+    if (!valid_label(label)) {
+        throw std::invalid_argument("Key atlas labels must be non-empty and free of whitespace");
+    }
+    if (tile.rows == 0 || tile.data.empty() || tile.key_bytes + KEY_SIZE_HEADER_BYTES > tile.rows * index_.width * 3) {
+        throw std::invalid_argument("Key atlas tile '" + label + "' was not encoded for width " +
+                                    std::to_string(index_.width));
+    }
+    if (!fits(tile.rows)) {
+        throw std::runtime_error("Key atlas is full at " + std::to_string(index_.entries.size()) + " tiles");
+    }
+
+    image_.write(reinterpret_cast<const char*>(tile.data.data()), static_cast<std::streamsize>(tile.data.size()));
+    if (!image_) {
+        throw std::runtime_error("Failed to write key atlas tile '" + label + "'");
+    }
+
+    KeyAtlasEntry entry;
+    entry.label = label;
+    entry.security_level = security_level;
+    entry.first_row = index_.height;
+    entry.rows = tile.rows;
+    entry.byte_offset = offset_;
+    entry.byte_length = tile.data.size();
+    entry.key_bytes = tile.key_bytes;
+    index_.entries.push_back(std::move(entry));
+    index_.height += tile.rows;
+    offset_ += tile.data.size();
+}
+
+void KeyAtlasWriter::add(const std::string& label, uint32_t security_level, const std::vector<uint8_t>& key) {
+    add(label, security_level, encode_tile(key.data(), key.size(), index_.width));
+}
+
+const KeyAtlasIndex& KeyAtlasWriter::finish() {
+    if (finished_) {
+        return index_;
+    }
+    if (index_.entries.empty()) {
+        throw std::runtime_error("Key atlas has no tiles");
+    }
+    image_.write(reinterpret_cast<const char*>(QOI_END_MARKER), sizeof(QOI_END_MARKER));
+
+    // Patch the height, bytes 8-11 of the header
+    const std::streampos end = image_.tellp();
+    const uint8_t height[4] = {static_cast<uint8_t>(index_.height >> 24), static_cast<uint8_t>(index_.height >> 16),
+                               static_cast<uint8_t>(index_.height >> 8), static_cast<uint8_t>(index_.height)};
+    image_.seekp(start_ + std::streamoff(8));
+    image_.write(reinterpret_cast<const char*>(height), sizeof(height));
+    image_.seekp(end);
+    image_.flush();
+    if (!image_) {
+        throw std::runtime_error("Failed to finish key atlas image");
+    }
+    finished_ = true;
+    return index_;
+}
+
+std::vector<uint8_t> KeyAtlasReader::read_key(const uint8_t* tile, size_t size, const KeyAtlasIndex& index,
+                                              const KeyAtlasEntry& entry) {
+    if (tile == nullptr || size != entry.byte_length || index.width == 0 || entry.rows == 0 ||
+        entry.rows > QoiKeyImageCodec::MAX_PIXELS / index.width) {
+        throw std::invalid_argument("Key atlas tile '" + entry.label + "' does not match its index entry");
+    }
+    const size_t pixels = entry.rows * index.width;
+    if (rgb_.size() < pixels * 3) {
+        rgb_.resize(pixels * 3);
+    }
+    QoiKeyImageCodec::decode_chunks(tile, size, rgb_.data(), pixels);
+
+    const size_t key_size = (static_cast<size_t>(rgb_[0]) << 24) | (static_cast<size_t>(rgb_[1]) << 16) |
+                            (static_cast<size_t>(rgb_[2]) << 8) | rgb_[3];
+    if (key_size != entry.key_bytes || key_size > pixels * 3 - KEY_SIZE_HEADER_BYTES) {
+        throw std::invalid_argument("Key atlas tile '" + entry.label + "' holds " + std::to_string(key_size) +
+                                    " key bytes, its index entry " + std::to_string(entry.key_bytes));
+    }
+    return std::vector<uint8_t>(rgb_.begin() + KEY_SIZE_HEADER_BYTES,
+                                rgb_.begin() + static_cast<std::ptrdiff_t>(KEY_SIZE_HEADER_BYTES + key_size));
+}
+
+std::vector<uint8_t> KeyAtlasReader::read_key(const std::string& atlas_path, const KeyAtlasIndex& index,
+                                              const KeyAtlasEntry& entry) {
+    std::ifstream file(atlas_path, std::ios::binary);
+    if (!file) {
+        throw std::invalid_argument("Cannot open key atlas " + atlas_path);
+    }
+    if (entry.byte_length > static_cast<uint64_t>(std::numeric_limits<std::streamsize>::max())) {
+        throw std::invalid_argument("Key atlas tile '" + entry.label + "' is too large");
+    }
+    std::vector<uint8_t> tile(static_cast<size_t>(entry.byte_length));
+    file.seekg(static_cast<std::streamoff>(entry.byte_offset));
+    if (!file.read(reinterpret_cast<char*>(tile.data()), static_cast<std::streamsize>(tile.size()))) {
+        throw std::invalid_argument("Key atlas " + atlas_path + " ends inside tile '" + entry.label + "'");
+    }
+    return read_key(tile.data(), tile.size(), index, entry);
+}
+
+ColorPublicKey KeyAtlasReader::load_public_key(const std::string& atlas_path, const KeyAtlasIndex& index,
+                                               const KeyAtlasEntry& entry) {
+    std::vector<uint8_t> key = read_key(atlas_path, index, entry);
+    return ColorPublicKey::deserialize(key.data(), key.size(), CLWEParameters(entry.security_level));
+}
+
+} // namespace clwe
@@ -0,0 +1,49 @@
+#include "clwe/key_image.hpp"
+#include "clwe/key_image_codec.hpp"
+#include <stdexcept>
+#include <string>
+
+namespace clwe {
+
+namespace {
+
+constexpr size_t KEY_SIZE_HEADER_BYTES = 4;
+
+} // namespace
+
+ColorPublicKey KeyImageDecoder::load_public_key(const uint8_t* image, size_t size, const CLWEParameters& params) {
+    const KeyImageCodec* codec = detect_key_image_codec(image, size);
+    if (codec == nullptr) {
+        throw std::invalid_argument("Key image is not in a supported format");
+    }
+    size_t width = 0;
+    size_t height = 0;
+    codec->decode(image, size, rgb_, width, height);
+    const size_t pixel_bytes = width * height * 3;
+
+    if (pixel_bytes < KEY_SIZE_HEADER_BYTES) {
+        throw std::invalid_argument("Key image too small for its size header");
+    }
+    const uint8_t* pixels = rgb_.data();
+    size_t key_size = (static_cast<size_t>(pixels[0]) << 24) |
+                      (static_cast<size_t>(pixels[1]) << 16) |
+                      (static_cast<size_t>(pixels[2]) << 8) |
+                      pixels[3];
+    if (key_size > pixel_bytes - KEY_SIZE_HEADER_BYTES) {
+        throw std::invalid_argument("Key image size header exceeds the image: " + std::to_string(key_size) +
+                                    " bytes in a " + std::to_string(width) + "x" + std::to_string(height) + " image");
+    }
+
+    return ColorPublicKey::deserialize(pixels + KEY_SIZE_HEADER_BYTES, key_size, params);
+}
+
+ColorPublicKey load_public_key_from_image(const uint8_t* image, size_t size, const CLWEParameters& params) {
+    thread_local KeyImageDecoder decoder;
+    return decoder.load_public_key(image, size, params);
+}
+
+ColorPublicKey load_public_key_from_image(const std::vector<uint8_t>& image, const CLWEParameters& params) {
+    return load_public_key_from_image(image.data(), image.size(), params);
+}
+
+} // namespace clwe
@@ -9,25 +9,32 @@ namespace clwe {
 
 class ScalarNTTEngine : public NTTEngine {
 private:
-    std::vector<uint32_t> zetas_;       // Precomputed zetas
-    std::vector<uint32_t> zetas_inv_;   // Inverse zetas
+    // Twiddles in Montgomery form (zeta * R mod q, R = 2^32), so montgomery_reduce()
+    // of a reduced coefficient times a twiddle is the coefficient times zeta mod q
+    std::vector<uint32_t> zetas_;        // Precomputed zetas
+    std::vector<uint32_t> zetas_inv_;    // Inverse zetas
+    // Last inverse stage twiddles with n^(-1) folded in, and n^(-1) itself, both in
+    // Montgomery form: the scaling costs no pass of its own
+    std::vector<uint32_t> zetas_inv_scaled_;
+    uint32_t n_inv_mont_;
 
     // Montgomery reduction constants
     uint32_t montgomery_r_;       // 2^32 mod q
-    uint32_t montgomery_r_inv_;   // R^(-1) mod q
+    uint32_t q_inv_neg_;          // -q^(-1) mod 2^32
 
     // Precompute zetas for NTT
     void precompute_zetas();
 
-    // Scalar butterfly operations
+    // Scalar butterfly operations; a and b reduced mod q, zeta in Montgomery form
     void butterfly(uint32_t& a, uint32_t& b, uint32_t zeta) const;
     void butterfly_inv(uint32_t& a, uint32_t& b, uint32_t zeta) const;
 
     // Modular reduction
     uint32_t mod_reduce(uint32_t val) const;
 
-    // Montgomery reduction
+    // Montgomery reduction: val * R^(-1) mod q for val < q * 2^32
     uint32_t montgomery_reduce(uint64_t val) const;
+    uint32_t to_montgomery(uint32_t val) const;
 
 public:
     ScalarNTTEngine(uint32_t q, uint32_t n);
@@ -1,34 +1,84 @@
 #include "performance_metrics.hpp"
 #include <mach/mach.h>
+#include <mach/mach_time.h>
 #include <mach/task_info.h>
+#include <libproc.h>
+#include <sys/resource.h>
+#include <unistd.h>
 #include <chrono>
+#include <cstddef>
 
 namespace clwe {
 
-// macOS-specific memory measurement using Mach APIs
+namespace {
+
+// True when task_info filled in the whole of a field (older kernels return shorter revisions)
+template <typename Field>
+bool vm_info_has(mach_msg_type_number_t count, size_t offset, const Field&) {
+    return count * sizeof(natural_t) >= offset + sizeof(Field);
+}
+
+// Core cycles retired by this process (all threads), from the counters kperf samples;
+// 0 where the kernel does not expose them, e.g. inside some virtual machines
+uint64_t process_cycles() {
+    rusage_info_v4 info;
+    if (proc_pid_rusage(getpid(), RUSAGE_INFO_V4, reinterpret_cast<rusage_info_t*>(&info)) != 0) {
+        return 0;
+    }
+    return info.ri_cycles;
+}
+
+// mach_absolute_time ticks in nanoseconds; the timebase is 1/1 on Intel and 125/3 on M-series
+uint64_t absolute_time_ns() {
+    static const mach_timebase_info_data_t timebase = [] {
+        mach_timebase_info_data_t tb;
+        mach_timebase_info(&tb);
+        return tb;
+    }();
+    return mach_absolute_time() * timebase.numer / timebase.denom;
+}
+
+} // namespace
+
+// macOS memory measurement: phys_footprint is the figure Activity Monitor and jetsam use,
+// and the kernel ledger keeps its high-water mark, so the peak is not just a last sample
 MemoryStats PerformanceMetrics::get_memory_usage_impl() {
-    task_basic_info_data_t info;
-    mach_msg_type_number_t info_count = TASK_BASIC_INFO_COUNT;
-    kern_return_t kr = task_info(mach_task_self(), TASK_BASIC_INFO, (task_info_t)&info, &info_count);
+    task_vm_info_data_t vm_info;
+    mach_msg_type_number_t vm_count = TASK_VM_INFO_COUNT;
+    if (task_info(mach_task_self(), TASK_VM_INFO, (task_info_t)&vm_info, &vm_count) == KERN_SUCCESS &&
+        vm_info_has(vm_count, offsetof(task_vm_info_data_t, phys_footprint), vm_info.phys_footprint)) {
+        size_t current = static_cast<size_t>(vm_info.phys_footprint);
+        size_t peak = current;
+        if (vm_info_has(vm_count, offsetof(task_vm_info_data_t, ledger_phys_footprint_peak),
+                        vm_info.ledger_phys_footprint_peak)) {
+            peak = static_cast<size_t>(vm_info.ledger_phys_footprint_peak);
+        }
+        return {current, peak, current};
+    }
 
-    if (kr == KERN_SUCCESS) {
-        return {info.resident_size, info.resident_size, info.resident_size};
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t info_count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &info_count) == KERN_SUCCESS) {
+        return {static_cast<size_t>(info.resident_size), static_cast<size_t>(info.resident_size_max),
+                static_cast<size_t>(info.resident_size)};
     }
 
     return {0, 0, 0};
 }
 
-// macOS-specific CPU cycle counting
+// macOS cycle counting. cntvct_el0 on Apple Silicon is the 24 MHz system timer, not a cycle
+// counter, so prefer the per-process core cycle count; without it fall back to the TSC on
+// Intel and to timer nanoseconds on arm64.
 uint64_t PerformanceMetrics::get_cpu_cycles_impl() {
-#ifdef __arm64__
-    // For Apple Silicon
-    return __builtin_arm_rsr64("cntvct_el0");
-#elif defined(__x86_64__)
-    // For Intel Macs
+    static const bool have_cycles = process_cycles() != 0;
+    if (have_cycles) {
+        return process_cycles();
+    }
+#if defined(__x86_64__)
     return __builtin_readcyclecounter();
 #else
-    return 0;
+    return absolute_time_ns();
 #endif
 }
 
-} // namespace clwe
\ No newline at end of file
+} // namespace clwe
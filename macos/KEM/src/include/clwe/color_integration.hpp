@@ -85,6 +85,7 @@ std::vector<uint8_t> decode_colors_to_color_kem_ciphertext(const std::vector<uin
 // Compression functions for color integration
 std::vector<uint8_t> encode_color_kem_key_as_colors_compressed(const std::vector<uint8_t>& key_data);
 std::vector<uint8_t> decode_colors_to_color_kem_key_compressed(const std::vector<uint8_t>& color_data, size_t expected_size);
+std::vector<uint8_t> decode_colors_to_color_kem_key_compressed(const uint8_t* color_data, size_t color_size, size_t expected_size);
 std::vector<uint8_t> convert_compressed_key_to_color_format(const std::vector<uint8_t>& compressed_data, size_t expected_size);
 std::vector<uint8_t> encode_color_kem_key_as_colors_auto(const std::vector<uint8_t>& key_data);
 
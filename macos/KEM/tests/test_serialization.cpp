@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include "color_kem.hpp"
+#include "color_integration.hpp"
 #include <vector>
 #include <stdexcept>
 
@@ -264,4 +265,30 @@ TEST_F(SerializationTest, MemorySafety) {
     EXPECT_NO_THROW(ColorCiphertext::deserialize(ct_ser));
 }
 
+// The compressed key format is fixed: known bytes decode, and every code length
+// round-trips through both the word-at-a-time and the per-code decoder paths
+TEST_F(SerializationTest, CompressedKeyFormat) {
+    std::vector<uint8_t> key;
+    for (uint32_t value : {0u, 5u, 0x40u, 1000u, 0x12345u, 0xDEADBEEFu}) {
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            key.push_back(static_cast<uint8_t>(value >> shift));
+        }
+    }
+    const std::vector<uint8_t> expected = {0x01, 0x07, 0x00, 0x00, 0x00, 0x18,
+                                           0x00, 0x85, 0xC0, 0x40, 0xC3, 0xE8, 0xE1, 0x23, 0x45,
+                                           0xF0, 0xDE, 0xAD, 0xBE, 0xEF};
+    EXPECT_EQ(expected, encode_color_kem_key_as_colors_compressed(key));
+    EXPECT_EQ(key, decode_colors_to_color_kem_key_compressed(expected, key.size()));
+
+    EXPECT_EQ(public_key.public_data,
+              decode_colors_to_color_kem_key_compressed(encode_color_kem_key_as_colors_compressed(public_key.public_data),
+                                                        public_key.public_data.size()));
+
+    std::vector<uint8_t> truncated(expected.begin(), expected.end() - 2);
+    EXPECT_THROW(decode_colors_to_color_kem_key_compressed(truncated, key.size()), std::invalid_argument);
+    std::vector<uint8_t> invalid = expected;
+    invalid[7] = 0xF8;
+    EXPECT_THROW(decode_colors_to_color_kem_key_compressed(invalid, key.size()), std::invalid_argument);
+}
+
 } // namespace clwe
\ No newline at end of file
@@ -0,0 +1,174 @@
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+#include "clwe/clwe.hpp"
+#include "clwe/color_integration.hpp"
+#include "src/core/color_kem.hpp"
+#include "src/core/cpu_features.hpp"
+#include "src/core/performance_metrics.hpp"
+
+using namespace clwe;
+
+// Heap allocations made through operator new, counted for the allocation columns
+static std::atomic<size_t> g_allocations{0};
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size != 0 ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+// Key data from keygen()/encapsulate() is 4 big-endian bytes per coefficient
+std::vector<std::vector<ColorValue>> parse_polynomials(const std::vector<uint8_t>& data, uint32_t count, uint32_t n) {
+    std::vector<std::vector<ColorValue>> polys(count, std::vector<ColorValue>(n));
+    for (uint32_t i = 0; i < count; ++i) {
+        for (uint32_t j = 0; j < n; ++j) {
+            const uint8_t* p = data.data() + 4 * (static_cast<size_t>(i) * n + j);
+            uint32_t value = (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+                             (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+            polys[i][j] = ColorValue::from_math_value(value);
+        }
+    }
+    return polys;
+}
+
+struct Codec {
+    const char* name;
+    std::function<std::vector<uint8_t>(const std::vector<std::vector<ColorValue>>&, uint32_t)> encode;
+    std::function<std::vector<std::vector<ColorValue>>(const std::vector<uint8_t>&, uint32_t, uint32_t, uint32_t)> decode;
+};
+
+std::vector<Codec> codecs() {
+    return {
+        {"standard",
+         [](const std::vector<std::vector<ColorValue>>& polys, uint32_t) { return encode_polynomial_vector_as_colors(polys); },
+         [](const std::vector<uint8_t>& data, uint32_t k, uint32_t n, uint32_t) { return decode_colors_to_polynomial_vector(data, k, n); }},
+        {"compressed", encode_polynomial_vector_as_colors_compressed, decode_colors_to_polynomial_vector_compressed},
+        {"huffman", encode_polynomial_vector_as_colors_huffman, decode_colors_to_polynomial_vector_huffman},
+        {"dense", encode_polynomial_vector_as_colors_dense, decode_colors_to_polynomial_vector_dense},
+        {"dual-format",
+         [](const std::vector<std::vector<ColorValue>>& polys, uint32_t modulus) { return compress_with_color_support(polys, modulus); },
+         [](const std::vector<uint8_t>& data, uint32_t, uint32_t, uint32_t) {
+             uint32_t k, n, modulus;
+             return decompress_with_color_support(data, k, n, modulus);
+         }},
+    };
+}
+
+// Allocations one call of operation makes
+size_t count_allocations(const std::function<void()>& operation) {
+    size_t before = g_allocations.load(std::memory_order_relaxed);
+    operation();
+    return g_allocations.load(std::memory_order_relaxed) - before;
+}
+
+void benchmark_key_type(const char* key_type, const std::vector<std::vector<ColorValue>>& polys, uint32_t modulus) {
+    const uint32_t k = static_cast<uint32_t>(polys.size());
+    const uint32_t n = static_cast<uint32_t>(polys[0].size());
+    const size_t coefficients = static_cast<size_t>(k) * n;
+    const size_t raw_bytes = coefficients * 4;
+
+    std::cout << key_type << " (" << k << " x " << n << " coefficients, " << raw_bytes << " raw bytes)" << std::endl;
+    std::cout << "  " << std::left << std::setw(12) << "codec" << std::right
+              << std::setw(9) << "bytes" << std::setw(8) << "ratio"
+              << std::setw(11) << "enc MB/s" << std::setw(12) << "enc Mcoef/s" << std::setw(7) << "allocs"
+              << std::setw(11) << "dec MB/s" << std::setw(12) << "dec Mcoef/s" << std::setw(7) << "allocs" << std::endl;
+
+    for (const Codec& codec : codecs()) {
+        std::vector<uint8_t> encoded = codec.encode(polys, modulus);
+        TimingStats encode_timing = PerformanceMetrics::time_operation([&]() {
+            std::vector<uint8_t> data = codec.encode(polys, modulus);
+        });
+        size_t encode_allocations = count_allocations([&]() {
+            std::vector<uint8_t> data = codec.encode(polys, modulus);
+        });
+        std::cout << "  " << std::left << std::setw(12) << codec.name << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(9) << encoded.size() << std::setw(8) << static_cast<double>(encoded.size()) / raw_bytes
+                  << std::setw(11) << raw_bytes / encode_timing.average_time
+                  << std::setw(12) << coefficients / encode_timing.average_time << std::setw(7) << encode_allocations;
+        std::cout.unsetf(std::ios::fixed);
+
+        std::vector<std::vector<ColorValue>> decoded;
+        try {
+            decoded = codec.decode(encoded, k, n, modulus);
+        } catch (const std::exception& e) {
+            std::cout << "  decode failed: " << e.what() << std::endl;
+            continue;
+        }
+        bool round_trip = true;
+        for (uint32_t i = 0; i < k && round_trip; ++i) {
+            for (uint32_t j = 0; j < n; ++j) {
+                if (decoded[i][j].to_math_value() % modulus != polys[i][j].to_math_value() % modulus) {
+                    round_trip = false;
+                    break;
+                }
+            }
+        }
+
+        TimingStats decode_timing = PerformanceMetrics::time_operation([&]() {
+            std::vector<std::vector<ColorValue>> result = codec.decode(encoded, k, n, modulus);
+        });
+        size_t decode_allocations = count_allocations([&]() {
+            std::vector<std::vector<ColorValue>> result = codec.decode(encoded, k, n, modulus);
+        });
+
+        // Throughput is over the raw 32-bit coefficients; bytes per microsecond are MB/s
+        std::cout << std::fixed << std::setprecision(2)
+                  << std::setw(11) << raw_bytes / decode_timing.average_time
+                  << std::setw(12) << coefficients / decode_timing.average_time << std::setw(7) << decode_allocations
+                  << (round_trip ? "" : "  ROUND TRIP FAILED") << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+    }
+    std::cout << std::endl;
+}
+
+void benchmark_security_level(int security_level) {
+    std::cout << "Security Level: " << security_level << "-bit" << std::endl;
+    std::cout << "=====================================" << std::endl;
+
+    CLWEParameters params(security_level);
+    ColorKEM kem(params);
+    auto [public_key, private_key] = kem.keygen();
+    auto [ciphertext, shared_secret] = kem.encapsulate(public_key);
+
+    const uint32_t k = params.module_rank;
+    const uint32_t n = params.degree;
+    benchmark_key_type("Secret key", parse_polynomials(private_key.secret_data, k, n), params.modulus);
+    benchmark_key_type("Public key", parse_polynomials(public_key.public_data, k, n), params.modulus);
+    benchmark_key_type("Ciphertext", parse_polynomials(ciphertext.ciphertext_data, k + 1, n), params.modulus);
+}
+
+int main() {
+    std::cout << "CLWE Color Integration Codec Benchmark" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    CPUFeatures features = CPUFeatureDetector::detect();
+    std::cout << "CPU: " << features.to_string() << std::endl;
+    std::cout << "Ratio is encoded size over 4 bytes per coefficient" << std::endl;
+    std::cout << std::endl;
+
+    std::vector<int> security_levels = {512, 768, 1024};
+
+    for (int level : security_levels) {
+        benchmark_security_level(level);
+    }
+
+    std::cout << "Benchmark completed successfully!" << std::endl;
+
+    return 0;
+}
@@ -121,6 +121,7 @@ echo.
 echo Build completed successfully!
 echo Executables are available in the build/ directory:
 echo   - benchmark_color_kem_timing: Benchmark executable
+echo   - benchmark_color_integration: Color codec benchmark
 echo   - key_sizes_test: Key sizes test
 echo   - avx_test: AVX support test
 echo   - test_compression: Compression test
@@ -3,96 +3,69 @@
 #include <vector>
 #include <iomanip>
 #include <cmath>
+#include <cstring>
 #include <fstream>
 #include <string>
 #include <stdexcept>
 #include <system_error>
-
-#ifdef __has_include
-#  if __has_include(<webp/encode.h>)
-#    include <webp/encode.h>
-#    define HAS_WEBP 1
-#  else
-#    define HAS_WEBP 0
-#  endif
-#else
-#  include <webp/encode.h>
-#  define HAS_WEBP 1
-#endif
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <thread>
 
 #include "src/include/clwe/color_kem.hpp"
 #include "src/include/clwe/clwe.hpp"
+#include "src/include/clwe/key_atlas.hpp"
+#include "src/include/clwe/key_image_codec.hpp"
 
 namespace fs = std::filesystem;
 
 /**
- * Saves serialized data as a WebP image file.
- * Encodes the data into an RGB image and saves it as lossless WebP.
- * @param data The serialized data to save.
- * @param filepath The path to the output WebP file.
- * @return true if successful, false otherwise.
+ * Packs serialized data into a square RGB image.
+ * The data size comes first as 4 big-endian bytes; the rest of the image is black.
+ * @param data The serialized data to pack.
+ * @param width Receives the image width in pixels.
+ * @param height Receives the image height in pixels.
+ * @return The RGB image, 3 bytes per pixel.
  */
-bool save_webp_file(const std::vector<uint8_t>& data, const fs::path& filepath) {
-    if (data.empty()) {
-        std::cerr << "Error: Data is empty, cannot save WebP file." << std::endl;
-        return false;
-    }
-
-#if HAS_WEBP
-    // Prepend the data size as 4 bytes (big-endian for cross-platform compatibility)
-    std::vector<uint8_t> rgb_data;
-    uint32_t size = static_cast<uint32_t>(data.size());
-    rgb_data.push_back((size >> 24) & 0xFF);
-    rgb_data.push_back((size >> 16) & 0xFF);
-    rgb_data.push_back((size >> 8) & 0xFF);
-    rgb_data.push_back(size & 0xFF);
-    rgb_data.insert(rgb_data.end(), data.begin(), data.end());
-
-    size_t total_size = rgb_data.size();
+std::vector<uint8_t> pack_rgb_image(const std::vector<uint8_t>& data, size_t& width, size_t& height) {
+    size_t total_size = 4 + data.size();
     size_t num_pixels = (total_size + 2) / 3; // Ensure at least enough for the data
-    size_t width = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(num_pixels))));
-    size_t height = (num_pixels + width - 1) / width;
+    width = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(num_pixels))));
+    height = (num_pixels + width - 1) / width;
 
-    // Create image buffer, pad with black pixels if necessary
     std::vector<uint8_t> image(width * height * 3, 0);
-    for (size_t i = 0; i < total_size; ++i) {
-        image[i] = rgb_data[i];
-    }
-
-    uint8_t* webp_data = nullptr;
-    size_t webp_size = WebPEncodeLosslessRGB(image.data(), static_cast<int>(width), static_cast<int>(height), static_cast<int>(width * 3), &webp_data);
-    if (webp_size == 0) {
-        std::cerr << "Error: Failed to encode WebP data." << std::endl;
-        return false;
-    }
+    uint32_t size = static_cast<uint32_t>(data.size());
+    image[0] = (size >> 24) & 0xFF;
+    image[1] = (size >> 16) & 0xFF;
+    image[2] = (size >> 8) & 0xFF;
+    image[3] = size & 0xFF;
+    std::memcpy(image.data() + 4, data.data(), data.size());
+    return image;
+}
 
-    // Write to file with error checking
-    std::ofstream file(filepath, std::ios::binary);
-    if (!file) {
-        std::cerr << "Error: Cannot open file for writing: " << filepath << std::endl;
-        WebPFree(webp_data);
-        return false;
-    }
-    file.write(reinterpret_cast<char*>(webp_data), webp_size);
-    if (!file.good()) {
-        std::cerr << "Error: Failed to write WebP data to file: " << filepath << std::endl;
-        WebPFree(webp_data);
-        file.close();
-        return false;
-    }
-    file.close();
-    if (!file.good()) {
-        std::cerr << "Error: Failed to close WebP file: " << filepath << std::endl;
-        WebPFree(webp_data);
+/**
+ * Encodes an RGB image with the selected key image codec.
+ * @param image RGB pixels, 3 bytes each, row by row.
+ * @param codec Key image codec.
+ * @param encoded Receives the encoded file.
+ * @return true if successful, false otherwise.
+ */
+bool encode_image(const std::vector<uint8_t>& image, size_t width, size_t height,
+                  const clwe::KeyImageCodec& codec, std::vector<uint8_t>& encoded) {
+    try {
+        encoded = codec.encode(image.data(), width, height);
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << codec.name() << " encoding failed: " << e.what() << std::endl;
         return false;
     }
-
-    WebPFree(webp_data);
-    return true;
-#else
-    std::cerr << "Error: WebP library not available. Cannot save WebP file." << std::endl;
-    return false;
-#endif
 }
 
 /**
@@ -121,6 +94,30 @@ bool save_binary_file(const std::vector<uint8_t>& data, const fs::path& filepath
     return true;
 }
 
+/**
+ * Saves serialized data as a key image file.
+ * Encodes the data into an RGB image and saves it with the given codec.
+ * @param data The serialized data to save.
+ * @param filepath The path to the output image file.
+ * @param codec Key image codec.
+ * @return true if successful, false otherwise.
+ */
+bool save_image_file(const std::vector<uint8_t>& data, const fs::path& filepath, const clwe::KeyImageCodec& codec) {
+    if (data.empty()) {
+        std::cerr << "Error: Data is empty, cannot save key image." << std::endl;
+        return false;
+    }
+
+    size_t width = 0;
+    size_t height = 0;
+    std::vector<uint8_t> image = pack_rgb_image(data, width, height);
+    std::vector<uint8_t> encoded;
+    if (!encode_image(image, width, height, codec, encoded)) {
+        return false;
+    }
+    return save_binary_file(encoded, filepath);
+}
+
 /**
  * Validates and prepares the output directory.
  * Checks if the directory exists and is writable.
@@ -149,35 +146,442 @@ bool validate_output_directory(const fs::path& dir_path) {
     return true;
 }
 
+/**
+ * Fixed-capacity queue between pipeline stages.
+ * push() blocks while the queue is full and pop() while it is empty. Once every
+ * producer has called close(), pop() drains what is left and then returns nothing.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    BoundedQueue(size_t capacity, size_t producers) : capacity_(capacity), producers_(producers) {}
+
+    void push(T item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this] { return items_.size() < capacity_ || cancelled_; });
+        if (cancelled_) {
+            return;
+        }
+        items_.push_back(std::move(item));
+        not_empty_.notify_one();
+    }
+
+    std::optional<T> pop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return !items_.empty() || producers_ == 0 || cancelled_; });
+        if (items_.empty() || cancelled_) {
+            return std::nullopt;
+        }
+        T item = std::move(items_.front());
+        items_.pop_front();
+        not_full_.notify_one();
+        return item;
+    }
+
+    // Called by each producer when it is done
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (producers_ > 0 && --producers_ == 0) {
+            not_empty_.notify_all();
+        }
+    }
+
+    // Wakes every waiting thread and drops the remaining items
+    void cancel() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled_ = true;
+        items_.clear();
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+    std::deque<T> items_;
+    size_t capacity_;
+    size_t producers_;
+    bool cancelled_ = false;
+};
+
+/**
+ * One keypair moving through the batch pipeline.
+ */
+struct KeyImageJob {
+    size_t index = 0;
+    std::vector<uint8_t> public_serialized;
+    std::vector<uint8_t> private_serialized;
+    std::vector<uint8_t> public_image;
+    std::vector<uint8_t> private_image;
+    clwe::KeyAtlasWriter::Tile public_tile;
+    clwe::KeyAtlasWriter::Tile private_tile;
+};
+
+/**
+ * Numbered key atlases <base>_NNNN.qoi, each with its .idx index sidecar.
+ * A new atlas starts every keys_per_atlas keys, or earlier at the QOI pixel limit.
+ */
+class AtlasSeries {
+public:
+    AtlasSeries(fs::path base, size_t keys_per_atlas, uint32_t security_level)
+        : base_(std::move(base)), keys_per_atlas_(keys_per_atlas), security_level_(security_level) {}
+
+    /**
+     * Appends a tile made by KeyAtlasWriter::encode_tile() at the default width.
+     * @throws std::runtime_error If an atlas file cannot be written.
+     */
+    void add(const std::string& label, const clwe::KeyAtlasWriter::Tile& tile) {
+        if (writer_ && (writer_->index().entries.size() >= keys_per_atlas_ || !writer_->fits(tile.rows))) {
+            close_atlas();
+        }
+        if (!writer_) {
+            open_atlas();
+        }
+        writer_->add(label, security_level_, tile);
+    }
+
+    /**
+     * Completes the current atlas and writes its index.
+     */
+    void finish() {
+        if (writer_) {
+            close_atlas();
+        }
+    }
+
+    /**
+     * Files written so far, images and indexes.
+     */
+    size_t files() const { return 2 * atlases_; }
+
+private:
+    void open_atlas() {
+        std::ostringstream number;
+        number << "_" << std::setw(4) << std::setfill('0') << atlases_;
+        path_ = base_;
+        path_ += number.str();
+        image_.open(fs::path(path_).replace_extension(".qoi"), std::ios::binary | std::ios::trunc);
+        if (!image_) {
+            throw std::runtime_error("Cannot create key atlas " + path_.string() + ".qoi");
+        }
+        writer_ = std::make_unique<clwe::KeyAtlasWriter>(image_);
+        ++atlases_;
+    }
+
+    void close_atlas() {
+        const clwe::KeyAtlasIndex& index = writer_->finish();
+        image_.close();
+        std::ofstream sidecar(fs::path(path_).replace_extension(".idx"));
+        index.write(sidecar);
+        sidecar.close();
+        writer_.reset();
+        if (!image_ || !sidecar) {
+            throw std::runtime_error("Failed to write key atlas " + path_.string());
+        }
+    }
+
+    fs::path base_;
+    size_t keys_per_atlas_;
+    uint32_t security_level_;
+    fs::path path_;
+    std::ofstream image_;
+    std::unique_ptr<clwe::KeyAtlasWriter> writer_;
+    size_t atlases_ = 0;
+};
+
+/**
+ * Busy time of a pipeline stage, summed over its threads.
+ */
+class StageClock {
+public:
+    void add(std::chrono::steady_clock::duration elapsed) {
+        nanoseconds_ += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    }
+    double seconds() const { return nanoseconds_.load() / 1e9; }
+
+private:
+    std::atomic<long long> nanoseconds_{0};
+};
+
+/**
+ * Generates count keypairs and saves each as key images and binary files.
+ * Keygen threads feed encoder threads, which pack and encode both images of a
+ * keypair; one writer thread saves the files. Bounded queues between the stages
+ * keep at most a few keypairs per thread in memory.
+ * With keys_per_atlas set, the keys go into public and private key atlases
+ * instead of one image and one binary file each.
+ * @param output_dir Directory for the numbered output files.
+ * @param count Number of keypairs.
+ * @param threads Keygen and encoder threads in total.
+ * @param codec Key image codec.
+ * @param keys_per_atlas Keys per atlas image, or 0 for per-key files.
+ * @return true if every file was saved, false otherwise.
+ */
+bool run_batch(const fs::path& output_dir, size_t count, size_t threads, const clwe::KeyImageCodec& codec,
+               size_t keys_per_atlas) {
+    // WebP encoding is several times slower than keygen, so it gets most threads;
+    // QOI is a single pass over the pixels, so there keygen does
+    bool fast_codec = std::strcmp(codec.name(), "qoi") == 0;
+    size_t keygen_threads = std::max<size_t>(1, fast_codec ? threads - threads / 4 : threads / 4);
+    size_t encoder_threads = std::max<size_t>(1, threads - keygen_threads);
+    size_t capacity = 2 * threads;
+
+    BoundedQueue<KeyImageJob> generated(capacity, keygen_threads);
+    BoundedQueue<KeyImageJob> encoded(capacity, encoder_threads);
+    std::atomic<size_t> next_index{0};
+    std::atomic<bool> failed{false};
+    StageClock keygen_clock, encode_clock, write_clock;
+    std::atomic<size_t> output_bytes{0};
+    const uint32_t security_level = 512;
+    std::optional<AtlasSeries> public_atlas;
+    std::optional<AtlasSeries> private_atlas;
+    if (keys_per_atlas > 0) {
+        public_atlas.emplace(output_dir / "public_keys", keys_per_atlas, security_level);
+        private_atlas.emplace(output_dir / "private_keys", keys_per_atlas, security_level);
+    }
+
+    auto fail = [&](const std::string& message) {
+        if (!failed.exchange(true)) {
+            std::cerr << "Error: " << message << std::endl;
+        }
+        generated.cancel();
+        encoded.cancel();
+    };
+
+    std::cout << "Generating " << count << " keypairs with " << keygen_threads << " keygen and "
+              << encoder_threads << " encoder threads..." << std::endl;
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < keygen_threads; ++t) {
+        workers.emplace_back([&] {
+            try {
+                clwe::CLWEParameters params(security_level);
+                clwe::ColorKEM kem(params);
+                for (size_t index = next_index++; index < count && !failed; index = next_index++) {
+                    auto begin = std::chrono::steady_clock::now();
+                    auto [public_key, private_key] = kem.keygen();
+                    KeyImageJob job;
+                    job.index = index;
+                    job.public_serialized = public_key.serialize();
+                    job.private_serialized = private_key.serialize();
+                    keygen_clock.add(std::chrono::steady_clock::now() - begin);
+                    generated.push(std::move(job));
+                }
+            } catch (const std::exception& e) {
+                fail(e.what());
+            }
+            generated.close();
+        });
+    }
+
+    for (size_t t = 0; t < encoder_threads; ++t) {
+        workers.emplace_back([&] {
+            while (auto job = generated.pop()) {
+                auto begin = std::chrono::steady_clock::now();
+                bool ok = true;
+                if (keys_per_atlas > 0) {
+                    const size_t width = clwe::KeyAtlasWriter::DEFAULT_WIDTH;
+                    try {
+                        job->public_tile = clwe::KeyAtlasWriter::encode_tile(job->public_serialized.data(),
+                                                                             job->public_serialized.size(), width);
+                        job->private_tile = clwe::KeyAtlasWriter::encode_tile(job->private_serialized.data(),
+                                                                              job->private_serialized.size(), width);
+                    } catch (const std::exception& e) {
+                        std::cerr << "Error: Atlas tile encoding failed: " << e.what() << std::endl;
+                        ok = false;
+                    }
+                } else {
+                    size_t width = 0;
+                    size_t height = 0;
+                    auto public_pixels = pack_rgb_image(job->public_serialized, width, height);
+                    ok = encode_image(public_pixels, width, height, codec, job->public_image);
+                    auto private_pixels = pack_rgb_image(job->private_serialized, width, height);
+                    ok = ok && encode_image(private_pixels, width, height, codec, job->private_image);
+                }
+                encode_clock.add(std::chrono::steady_clock::now() - begin);
+                if (!ok) {
+                    fail(std::string(codec.name()) + " encoding failed for keypair " + std::to_string(job->index));
+                    break;
+                }
+                encoded.push(std::move(*job));
+            }
+            encoded.close();
+        });
+    }
+
+    size_t written = 0;
+    auto last_report = start;
+    while (auto job = encoded.pop()) {
+        auto begin = std::chrono::steady_clock::now();
+        std::ostringstream suffix;
+        suffix << "_" << std::setw(6) << std::setfill('0') << job->index;
+        std::string name = suffix.str();
+        bool ok = true;
+        if (keys_per_atlas > 0) {
+            try {
+                public_atlas->add("public_key" + name, job->public_tile);
+                private_atlas->add("private_key" + name, job->private_tile);
+            } catch (const std::exception& e) {
+                fail(e.what());
+                break;
+            }
+            output_bytes += job->public_tile.data.size() + job->private_tile.data.size();
+        } else {
+            std::string extension = codec.file_extension();
+            ok = save_binary_file(job->public_image, output_dir / ("public_key" + name + extension)) &&
+                 save_binary_file(job->private_image, output_dir / ("private_key" + name + extension)) &&
+                 save_binary_file(job->public_serialized, output_dir / ("public_key" + name + ".bin")) &&
+                 save_binary_file(job->private_serialized, output_dir / ("private_key" + name + ".bin"));
+            output_bytes += job->public_image.size() + job->private_image.size() +
+                            job->public_serialized.size() + job->private_serialized.size();
+        }
+        auto end = std::chrono::steady_clock::now();
+        write_clock.add(end - begin);
+        if (!ok) {
+            fail("Failed to save keypair " + std::to_string(job->index));
+            break;
+        }
+        ++written;
+
+        if (end - last_report >= std::chrono::seconds(1)) {
+            double elapsed = std::chrono::duration<double>(end - start).count();
+            std::cout << "  " << written << "/" << count << " keypairs, "
+                      << std::fixed << std::setprecision(1) << written / elapsed << " keypairs/s" << std::endl;
+            last_report = end;
+        }
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    size_t files = 4 * written;
+    if (keys_per_atlas > 0 && !failed) {
+        try {
+            public_atlas->finish();
+            private_atlas->finish();
+            files = public_atlas->files() + private_atlas->files();
+        } catch (const std::exception& e) {
+            fail(e.what());
+        }
+    }
+    if (failed) {
+        return false;
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << std::fixed << std::setprecision(2)
+              << "\nSaved " << written << " keypairs (" << files << " files) in " << elapsed << " s\n"
+              << "Throughput: " << written / elapsed << " keypairs/s, "
+              << 2 * written / elapsed << " images/s, "
+              << output_bytes / elapsed / (1024.0 * 1024.0) << " MiB/s written\n"
+              << "Stage busy time (thread-seconds): keygen " << keygen_clock.seconds()
+              << ", pack+encode " << encode_clock.seconds()
+              << ", write " << write_clock.seconds() << std::endl;
+    return true;
+}
+
+/**
+ * Parses a non-negative integer option value.
+ * @return false if the value is not a number in [min_value, max_value].
+ */
+bool parse_number(const std::string& text, long long min_value, long long max_value, long long& value) {
+    try {
+        size_t used = 0;
+        value = std::stoll(text, &used);
+        return used == text.size() && value >= min_value && value <= max_value;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
 /**
  * Prints usage information.
  */
 void print_usage(const char* program_name) {
     std::cout << "Usage: " << program_name << " [options]\n"
               << "Options:\n"
-              << "  -d <directory>  Output directory (default: current directory)\n"
-              << "  -h              Show this help message\n";
+              << "  -d <directory>     Output directory (default: current directory)\n"
+              << "  --count <N>        Generate N keypairs as numbered files (batch mode)\n"
+              << "  --threads <T>      Worker threads for batch mode (default: hardware threads)\n"
+              << "  --format <F>       Key image format: webp (default) or qoi (much faster to encode)\n"
+              << "  --atlas            Batch mode: pack keys into QOI key atlases of 65536 keys with .idx indexes\n"
+              << "  --atlas-keys <N>   Same, N keys per atlas\n"
+              << "  --webp-level <L>   Lossless preset 0 (fastest) to 9 (smallest)\n"
+              << "  --webp-method <M>  WebP method 0 (fastest) to 6 (slowest), after the preset\n"
+              << "  --webp-quality <Q> WebP lossless effort 0 to 100, after the preset\n"
+              << "  -h                 Show this help message\n";
 }
 
 /**
- * Main function: Generates ColorKEM keypair and saves as WebP images and binary files.
+ * Main function: Generates ColorKEM keypair and saves as key images and binary files.
  */
 int main(int argc, char* argv[]) {
     fs::path output_dir = ".";
+    size_t count = 0;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    std::string format = "webp";
+    bool format_given = false;
+    size_t keys_per_atlas = 0;
+    clwe::WebPKeyImageCodec::Settings settings;
 
     // Parse command-line arguments
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
+        long long value = 0;
         if (arg == "-d" && i + 1 < argc) {
             output_dir = argv[++i];
+        } else if (arg == "--count" && i + 1 < argc && parse_number(argv[i + 1], 1, 100000000, value)) {
+            count = static_cast<size_t>(value);
+            ++i;
+        } else if (arg == "--threads" && i + 1 < argc && parse_number(argv[i + 1], 1, 1024, value)) {
+            threads = static_cast<size_t>(value);
+            ++i;
+        } else if (arg == "--format" && i + 1 < argc) {
+            format = argv[++i];
+            format_given = true;
+        } else if (arg == "--atlas") {
+            keys_per_atlas = std::max<size_t>(keys_per_atlas, 65536);
+        } else if (arg == "--atlas-keys" && i + 1 < argc && parse_number(argv[i + 1], 1, 100000000, value)) {
+            keys_per_atlas = static_cast<size_t>(value);
+            ++i;
+        } else if (arg == "--webp-level" && i + 1 < argc && parse_number(argv[i + 1], 0, 9, value)) {
+            settings.level = static_cast<int>(value);
+            ++i;
+        } else if (arg == "--webp-method" && i + 1 < argc && parse_number(argv[i + 1], 0, 6, value)) {
+            settings.method = static_cast<int>(value);
+            ++i;
+        } else if (arg == "--webp-quality" && i + 1 < argc && parse_number(argv[i + 1], 0, 100, value)) {
+            settings.quality = static_cast<float>(value);
+            ++i;
         } else if (arg == "-h" || arg == "--help") {
             print_usage(argv[0]);
             return 0;
         } else {
-            std::cerr << "Error: Unknown option: " << arg << std::endl;
+            std::cerr << "Error: Unknown option or invalid value: " << arg << std::endl;
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Atlases are QOI, whose chunks can restart at every tile
+    if (keys_per_atlas > 0) {
+        if (count == 0 || (format_given && format != "qoi")) {
+            std::cerr << "Error: --atlas needs --count and writes QOI images" << std::endl;
             print_usage(argv[0]);
             return 1;
         }
+        format = "qoi";
+    }
+
+    // The WebP options configure a codec of their own; other formats have no settings
+    clwe::WebPKeyImageCodec webp_codec(settings);
+    const clwe::KeyImageCodec* codec = format == "webp" ? &webp_codec : clwe::find_key_image_codec(format.c_str());
+    if (codec == nullptr) {
+        std::cerr << "Error: Unknown key image format: " << format << std::endl;
+        print_usage(argv[0]);
+        return 1;
     }
 
     // Validate output directory
@@ -185,6 +589,10 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    if (count > 0) {
+        return run_batch(output_dir, count, threads, *codec, keys_per_atlas) ? 0 : 1;
+    }
+
     try {
         // Initialize parameters and KEM
         clwe::CLWEParameters params(512);
@@ -198,22 +606,21 @@ int main(int argc, char* argv[]) {
         auto public_serialized = public_key.serialize();
         auto private_serialized = private_key.serialize();
 
-        // Save public key as WebP
-        fs::path pub_webp_path = output_dir / "public_key.webp";
-        std::cout << "Saving public key as WebP: " << pub_webp_path << std::endl;
-        if (!save_webp_file(public_serialized, pub_webp_path)) {
+        // Save public key as an image
+        fs::path pub_image_path = output_dir / ("public_key" + std::string(codec->file_extension()));
+        std::cout << "Saving public key as " << codec->name() << ": " << pub_image_path << std::endl;
+        if (!save_image_file(public_serialized, pub_image_path, *codec)) {
             return 1;
         }
-        std::cout << "Public key saved successfully as WebP!" << std::endl;
+        std::cout << "Public key saved successfully as " << codec->name() << "!" << std::endl;
 
-        // Save private key as WebP
-        fs::path priv_webp_path = output_dir / "private_key.webp";
-        std::cout << "Saving private key as WebP: " << priv_webp_path << std::endl;
-        if (!save_webp_file(private_serialized, priv_webp_path)) {
+        // Save private key as an image
+        fs::path priv_image_path = output_dir / ("private_key" + std::string(codec->file_extension()));
+        std::cout << "Saving private key as " << codec->name() << ": " << priv_image_path << std::endl;
+        if (!save_image_file(private_serialized, priv_image_path, *codec)) {
             return 1;
         }
-        std::cout << "Private key saved successfully as WebP!" << std::endl;
-
+        std::cout << "Private key saved successfully as " << codec->name() << "!" << std::endl;
         // Save public key as binary
         fs::path pub_bin_path = output_dir / "public_key.bin";
         std::cout << "Saving public key as binary: " << pub_bin_path << std::endl;
@@ -231,8 +638,8 @@ int main(int argc, char* argv[]) {
         std::cout << "Private key saved successfully as binary!" << std::endl;
 
         std::cout << "\nAll keys saved successfully!" << std::endl;
-        std::cout << "Public key WebP: " << pub_webp_path << std::endl;
-        std::cout << "Private key WebP: " << priv_webp_path << std::endl;
+        std::cout << "Public key image: " << pub_image_path << std::endl;
+        std::cout << "Private key image: " << priv_image_path << std::endl;
         std::cout << "Public key binary: " << pub_bin_path << std::endl;
         std::cout << "Private key binary: " << priv_bin_path << std::endl;
 
@@ -1,7 +1,13 @@
 #include "../include/clwe/color_integration.hpp"
 #include "../include/clwe/utils.hpp"
+#include <algorithm>
+#include <cstring>
 #include <stdexcept>
 
+#if defined(_MSC_VER)
+#include <stdlib.h>
+#endif
+
 using namespace clwe;
 
 namespace clwe {
@@ -110,54 +116,123 @@ std::vector<std::vector<ColorValue>> decode_colors_to_polynomial_vector(const st
     return poly_vector;
 }
 
+namespace {
+
+// Leading byte of a 0x03 code: total code length (0 = invalid), the mask of its
+// payload bits and the shifts that join them with the two bytes after it. Existing
+// 0x03 data is read exactly as before: 0xE0-0xEF lead three-byte codes and every
+// other byte from 0xC0 up, 0xF0-0xFF included, a two-byte one. Coefficients below
+// 0x2000 (any ML-KEM modulus) round-trip.
+struct CompressedLead {
+    uint8_t length;
+    uint8_t mask;
+    uint8_t lead_shift;
+    uint8_t tail_shift;
+};
+
+constexpr CompressedLead lead_for(int b) {
+    return b == 0x00 ? CompressedLead{1, 0x00, 0, 16}
+         : b < 0x80 ? CompressedLead{0, 0x00, 0, 16}
+         : b < 0xC0 ? CompressedLead{1, 0x7F, 0, 16}
+         : (b & 0xF0) == 0xE0 ? CompressedLead{3, 0x0F, 16, 0}
+         : CompressedLead{2, 0x3F, 8, 8};
+}
+
+struct CompressedLeadTable {
+    CompressedLead entries[256];
+    constexpr CompressedLeadTable() : entries() {
+        for (int b = 0; b < 256; ++b) {
+            entries[b] = lead_for(b);
+        }
+    }
+};
+
+constexpr CompressedLeadTable COMPRESSED_LEADS;
+
+// Per length class: leading-byte prefix and the bits of the value that are kept
+struct CompressedClass {
+    uint32_t length;
+    uint32_t prefix;
+    uint32_t mask;
+};
+
+constexpr CompressedClass COMPRESSED_CLASSES[4] = {
+    {1, 0x80, 0x3F}, {2, 0xC0, 0x3FFF}, {3, 0xE0, 0x1FFFFF}, {4, 0xF0, 0xFFFFFF}
+};
+
+inline uint64_t load_be64(const uint8_t* p) {
+    uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+#if defined(__GNUC__)
+    return __builtin_bswap64(word);
+#else
+    return _byteswap_uint64(word);
+#endif
+}
+
+inline uint32_t reduce_coefficient(uint32_t value, uint32_t modulus) {
+    return value < modulus ? value : value % modulus;
+}
+
+// Four two-byte codes with leading bytes 0xC0-0xDF
+inline bool four_two_byte_codes(uint64_t word) {
+    return (word & 0xE000E000E000E000ULL) == 0xC000C000C000C000ULL;
+}
+
+// Writes the 0x03 code of a reduced coefficient as a full 4-byte word and returns the
+// code length; out must have 4 bytes of room
+inline size_t put_compressed_code(uint8_t* out, uint32_t value) {
+    uint32_t index = (value >= 0x40) + (value >= 0x4000) + (value >= 0x200000);
+    const CompressedClass& cls = COMPRESSED_CLASSES[index];
+    uint32_t prefix = (index == 0 && value == 0) ? 0 : cls.prefix;
+    uint32_t shift = 8 * (cls.length - 1);
+    uint32_t code = ((prefix << shift) | (value & cls.mask)) << (8 * (4 - cls.length));
+    out[0] = static_cast<uint8_t>(code >> 24);
+    out[1] = static_cast<uint8_t>(code >> 16);
+    out[2] = static_cast<uint8_t>(code >> 8);
+    out[3] = static_cast<uint8_t>(code);
+    return cls.length;
+}
+
+inline void put_compressed_header(uint8_t* out, uint32_t k, uint32_t n) {
+    out[0] = 0x01; // Version 1
+    out[1] = 0x03; // Compression flag (3 = color-compatible compressed)
+    out[2] = static_cast<uint8_t>(k);
+    out[3] = static_cast<uint8_t>(n >> 8);
+    out[4] = static_cast<uint8_t>(n & 0xFF);
+}
+
+} // namespace
+
 // Compressed color encoding with variable-length encoding
 std::vector<uint8_t> encode_polynomial_vector_as_colors_compressed(const std::vector<std::vector<ColorValue>>& poly_vector, uint32_t modulus) {
     // Use the compressed packing format but maintain color compatibility
     // The compressed format is still compatible with color visualization since we can decode it back
 
-    std::vector<uint8_t> compressed;
-    compressed.reserve(1024);
-
-    // Add format version and compression flag for color-compatible compression
-    compressed.push_back(0x01); // Version 1
-    compressed.push_back(0x03); // Compression flag (3 = color-compatible compressed)
-
     // Store number of polynomials and degree
     uint32_t k = poly_vector.size();
     uint32_t n = k > 0 ? poly_vector[0].size() : 0;
 
-    compressed.push_back(static_cast<uint8_t>(k));
-    compressed.push_back(static_cast<uint8_t>(n >> 8));
-    compressed.push_back(static_cast<uint8_t>(n & 0xFF));
+    size_t coefficients = 0;
+    for (const auto& poly : poly_vector) {
+        coefficients += poly.size();
+    }
+
+    // Every code is written as a full 4-byte word, so the buffer holds the longest
+    // possible encoding and is trimmed afterwards
+    std::vector<uint8_t> compressed(5 + 4 * coefficients);
+    put_compressed_header(compressed.data(), k, n);
+    uint8_t* out = compressed.data() + 5;
 
-    // Color-compatible variable-length encoding
-    // This maintains the ability to reconstruct the original color representation
+    // Color-compatible variable-length encoding: 0x00 for zero, 0x80 | v below 0x40,
+    // then 2, 3 and 4-byte codes led by 0xC0, 0xE0 and 0xF0
     for (const auto& poly : poly_vector) {
         for (const ColorValue& coeff : poly) {
-            uint32_t value = coeff.to_math_value() % modulus;
-
-            // Color-compatible variable-length encoding
-            if (value == 0) {
-                compressed.push_back(0x00); // Single byte for zero
-            } else if (value < 0x40) {
-                compressed.push_back(static_cast<uint8_t>(value | 0x80)); // 1 byte
-            } else if (value < 0x4000) {
-                compressed.push_back(static_cast<uint8_t>((value >> 8) | 0xC0));
-                compressed.push_back(static_cast<uint8_t>(value & 0xFF)); // 2 bytes
-            } else if (value < 0x200000) {
-                compressed.push_back(static_cast<uint8_t>((value >> 16) | 0xE0));
-                compressed.push_back(static_cast<uint8_t>((value >> 8) & 0xFF));
-                compressed.push_back(static_cast<uint8_t>(value & 0xFF)); // 3 bytes
-            } else {
-                // For larger values, use 4 bytes (standard color format)
-                compressed.push_back(0xF0);
-                compressed.push_back(static_cast<uint8_t>((value >> 16) & 0xFF));
-                compressed.push_back(static_cast<uint8_t>((value >> 8) & 0xFF));
-                compressed.push_back(static_cast<uint8_t>(value & 0xFF));
-            }
+            out += put_compressed_code(out, coeff.to_math_value() % modulus);
         }
     }
 
+    compressed.resize(out - compressed.data());
     return compressed;
 }
 
@@ -188,36 +263,50 @@ std::vector<std::vector<ColorValue>> decode_colors_to_polynomial_vector_compress
 
     std::vector<std::vector<ColorValue>> poly_vector(k, std::vector<ColorValue>(n, ColorValue()));
 
-    // Decode color-compatible compressed data
+    const uint8_t* data = color_data.data();
+    const size_t size = color_data.size();
+
+    // Runs of four two-byte codes (uniform coefficients) are decoded a 64-bit word at a
+    // time, other codes through the leading-byte table
     for (uint32_t i = 0; i < k; ++i) {
-        for (uint32_t j = 0; j < n; ++j) {
-            if (offset >= color_data.size()) {
-                throw std::invalid_argument("Truncated compressed color data");
+        ColorValue* poly = poly_vector[i].data();
+        uint32_t j = 0;
+        while (j < n) {
+            if (offset + 8 <= size && j + 4 <= n) {
+                uint64_t word = load_be64(data + offset);
+                if (four_two_byte_codes(word)) {
+                    for (int c = 0; c < 4; ++c) {
+                        uint32_t value = static_cast<uint32_t>(word >> (48 - 16 * c)) & 0x3FFF;
+                        poly[j + c] = ColorValue::from_math_value(reduce_coefficient(value, modulus));
+                    }
+                    offset += 8;
+                    j += 4;
+                    continue;
+                }
             }
 
-            uint8_t first_byte = color_data[offset++];
-            uint32_t value = 0;
-
-            if (first_byte == 0x00) {
-                value = 0;
-            } else if ((first_byte & 0xC0) == 0x80) {
-                value = first_byte & 0x7F;
-            } else if ((first_byte & 0xF0) == 0xE0) {
-                if (offset + 1 >= color_data.size()) throw std::invalid_argument("Truncated compressed color data");
-                value = ((first_byte & 0x0F) << 16) | (color_data[offset] << 8) | color_data[offset + 1];
-                offset += 2;
-            } else if ((first_byte & 0xC0) == 0xC0) {
-                if (offset >= color_data.size()) throw std::invalid_argument("Truncated compressed color data");
-                value = ((first_byte & 0x3F) << 8) | color_data[offset++];
-            } else if (first_byte == 0xF0) {
-                if (offset + 2 >= color_data.size()) throw std::invalid_argument("Truncated compressed color data");
-                value = (color_data[offset] << 16) | (color_data[offset + 1] << 8) | color_data[offset + 2];
-                offset += 3;
-            } else {
+            if (offset >= size) {
+                throw std::invalid_argument("Truncated compressed color data");
+            }
+            uint8_t first_byte = data[offset];
+            const CompressedLead& lead = COMPRESSED_LEADS.entries[first_byte];
+            if (lead.length == 0) {
                 throw std::invalid_argument("Invalid color-compatible compression encoding");
             }
-
-            poly_vector[i][j] = ColorValue::from_math_value(value % modulus);
+            if (offset + lead.length > size) {
+                throw std::invalid_argument("Truncated compressed color data");
+            }
+            uint32_t value = first_byte & lead.mask;
+            if (offset + 3 <= size) {
+                uint32_t tail = (static_cast<uint32_t>(data[offset + 1]) << 8) | data[offset + 2];
+                value = (value << lead.lead_shift) | (tail >> lead.tail_shift);
+            } else {
+                for (uint32_t b = 1; b < lead.length; ++b) {
+                    value = (value << 8) | data[offset + b];
+                }
+            }
+            offset += lead.length;
+            poly[j++] = ColorValue::from_math_value(reduce_coefficient(value, modulus));
         }
     }
 
@@ -233,35 +322,442 @@ std::vector<uint8_t> convert_compressed_to_color_format(const std::vector<uint8_
     return encode_polynomial_vector_as_colors(poly_vector);
 }
 
-// Auto-select best compression method for color integration
-std::vector<uint8_t> encode_polynomial_vector_as_colors_auto(const std::vector<std::vector<ColorValue>>& poly_vector, uint32_t modulus) {
-    // Count non-zero coefficients to determine sparsity
+namespace {
+
+enum class AutoFormat { Standard, Compressed };
+
+constexpr size_t STANDARD_COEFF_BYTES = 12;
+constexpr size_t DUAL_HEADER_BYTES = 9;
+// Coefficients seen before the speculative format follows the data
+constexpr size_t AUTO_PROBE_COEFFS = 64;
+
+// Room encode_auto_into needs: the larger of the two formats, plus the word the
+// compressed writer stores past its last code
+size_t auto_encoding_capacity(size_t coefficients) {
+    size_t compressed = 5 + 4 * coefficients;
+    size_t standard = STANDARD_COEFF_BYTES * coefficients;
+    return compressed > standard ? compressed : standard;
+}
+
+inline void put_standard_coefficient(uint8_t* out, uint32_t value) {
+    // 4 RGB pixels: the value big-endian across the first four channels, then zeros
+    out[0] = static_cast<uint8_t>(value >> 24);
+    out[1] = static_cast<uint8_t>(value >> 16);
+    out[2] = static_cast<uint8_t>(value >> 8);
+    out[3] = static_cast<uint8_t>(value);
+    std::memset(out + 4, 0, STANDARD_COEFF_BYTES - 4);
+}
+
+// Re-encodes the first count coefficients in a new format; returns the bytes written
+size_t encode_auto_prefix(const std::vector<std::vector<ColorValue>>& poly_vector, uint32_t modulus,
+                          size_t count, AutoFormat format, uint8_t* out) {
+    uint32_t k = poly_vector.size();
+    uint32_t n = k > 0 ? poly_vector[0].size() : 0;
+    uint8_t* pos = out;
+    if (format == AutoFormat::Compressed) {
+        put_compressed_header(pos, k, n);
+        pos += 5;
+    }
+    for (const auto& poly : poly_vector) {
+        for (const ColorValue& coeff : poly) {
+            if (count-- == 0) {
+                return pos - out;
+            }
+            if (format == AutoFormat::Compressed) {
+                pos += put_compressed_code(pos, coeff.to_math_value() % modulus);
+            } else {
+                put_standard_coefficient(pos, coeff.to_math_value());
+                pos += STANDARD_COEFF_BYTES;
+            }
+        }
+    }
+    return pos - out;
+}
+
+// Writes what encode_polynomial_vector_as_colors_auto returns at out, which holds
+// auto_encoding_capacity(coefficients) bytes, and returns its length.
+//
+// The choice is the compressed format if fewer than 70% of the coefficients are
+// non-zero. Coefficients go out in a speculative format as they are counted: the
+// compressed one at first, then whichever format the first AUTO_PROBE_COEFFS favour.
+// Once the count settles the choice, so does the format. Only a wrong guess goes back
+// over the input, to rewrite the coefficients already seen.
+size_t encode_auto_into(const std::vector<std::vector<ColorValue>>& poly_vector, uint32_t modulus, uint8_t* out) {
+    uint32_t k = poly_vector.size();
+    uint32_t n = k > 0 ? poly_vector[0].size() : 0;
     size_t total_coeffs = 0;
+    for (const auto& poly : poly_vector) {
+        total_coeffs += poly.size();
+    }
+    const double threshold = total_coeffs * 0.7;
+
+    AutoFormat format = AutoFormat::Compressed;
+    bool settled = false;
+    size_t seen = 0;
     size_t non_zero_coeffs = 0;
+    uint8_t* pos = out;
+    put_compressed_header(pos, k, n);
+    pos += 5;
+
+    auto follow = [&](AutoFormat wanted) {
+        if (wanted != format) {
+            format = wanted;
+            pos = out + encode_auto_prefix(poly_vector, modulus, seen, format, out);
+        }
+    };
+    auto settle = [&]() {
+        if (non_zero_coeffs >= threshold) {
+            settled = true;
+            follow(AutoFormat::Standard);
+        } else if (non_zero_coeffs + (total_coeffs - seen) < threshold) {
+            settled = true;
+            follow(AutoFormat::Compressed);
+        } else if (seen == AUTO_PROBE_COEFFS) {
+            follow(non_zero_coeffs >= seen * 0.7 ? AutoFormat::Standard : AutoFormat::Compressed);
+        }
+    };
 
+    settle();
     for (const auto& poly : poly_vector) {
         for (const ColorValue& coeff : poly) {
-            total_coeffs++;
-            if ((coeff.to_math_value() % modulus) != 0) {
-                non_zero_coeffs++;
+            uint32_t value = coeff.to_math_value();
+            if (format == AutoFormat::Compressed) {
+                uint32_t reduced = value % modulus;
+                non_zero_coeffs += reduced != 0;
+                pos += put_compressed_code(pos, reduced);
+            } else {
+                if (!settled) {
+                    non_zero_coeffs += (value % modulus) != 0;
+                }
+                put_standard_coefficient(pos, value);
+                pos += STANDARD_COEFF_BYTES;
+            }
+            ++seen;
+            if (!settled) {
+                settle();
             }
         }
     }
 
-    // If the data is sparse enough, use color-compatible compression
-    // Otherwise use standard color format (which is already somewhat compressed for small values)
-    if (non_zero_coeffs < total_coeffs * 0.7) { // 70% threshold for color-compatible compression
-        return encode_polynomial_vector_as_colors_compressed(poly_vector, modulus);
-    } else {
-        return encode_polynomial_vector_as_colors(poly_vector);
+    return pos - out;
+}
+
+} // namespace
+
+// Auto-select best compression method for color integration
+std::vector<uint8_t> encode_polynomial_vector_as_colors_auto(const std::vector<std::vector<ColorValue>>& poly_vector, uint32_t modulus) {
+    size_t total_coeffs = 0;
+    for (const auto& poly : poly_vector) {
+        total_coeffs += poly.size();
+    }
+
+    // Sparse data (under 70% non-zero) takes the color-compatible compression, anything
+    // else the standard color format (which is already somewhat compressed for small values)
+    std::vector<uint8_t> encoded(auto_encoding_capacity(total_coeffs));
+    encoded.resize(encode_auto_into(poly_vector, modulus, encoded.data()));
+    return encoded;
+}
+
+namespace {
+
+// Static canonical Huffman tables for CBD(eta) coefficients. Symbols are the centered
+// values -eta..eta followed by an escape, which carries any other coefficient as a raw
+// 32-bit value. Lengths come from a Huffman tree over the binomial probabilities
+// C(2 eta, eta + x) / 4^eta, with the escape weighted about 2^-13.
+constexpr uint32_t HUFFMAN_MAX_BITS = 6;
+constexpr uint32_t HUFFMAN_ESCAPE_BITS = 32;
+constexpr uint32_t HUFFMAN_MAX_SYMBOLS = 8;
+constexpr size_t HUFFMAN_HEADER_BYTES = 6;
+
+struct HuffmanEntry {
+    uint8_t symbol;
+    uint8_t length;
+};
+
+struct HuffmanTable {
+    uint32_t eta;
+    uint32_t symbols;  // 2 * eta + 2; the escape is the last one
+    uint8_t lengths[HUFFMAN_MAX_SYMBOLS];
+    uint8_t codes[HUFFMAN_MAX_SYMBOLS];
+    // Indexed by the next HUFFMAN_MAX_BITS bits of the stream
+    HuffmanEntry decode[1 << HUFFMAN_MAX_BITS];
+};
+
+// Canonical codes: shorter first, equal lengths in symbol order
+constexpr HuffmanTable make_huffman_table(uint32_t eta, const uint8_t (&lengths)[HUFFMAN_MAX_SYMBOLS]) {
+    HuffmanTable table{eta, 2 * eta + 2, {}, {}, {}};
+    uint32_t code = 0;
+    for (uint32_t length = 1; length <= HUFFMAN_MAX_BITS; ++length) {
+        for (uint32_t symbol = 0; symbol < table.symbols; ++symbol) {
+            if (lengths[symbol] != length) {
+                continue;
+            }
+            table.lengths[symbol] = static_cast<uint8_t>(length);
+            table.codes[symbol] = static_cast<uint8_t>(code);
+            uint32_t first = code << (HUFFMAN_MAX_BITS - length);
+            for (uint32_t fill = 0; fill < (1u << (HUFFMAN_MAX_BITS - length)); ++fill) {
+                table.decode[first + fill] = {static_cast<uint8_t>(symbol), static_cast<uint8_t>(length)};
+            }
+            ++code;
+        }
+        code <<= 1;
     }
+    return table;
+}
+
+constexpr uint8_t HUFFMAN_ETA2_LENGTHS[HUFFMAN_MAX_SYMBOLS] = {4, 2, 2, 2, 3, 4};        // -2..2, escape
+constexpr uint8_t HUFFMAN_ETA3_LENGTHS[HUFFMAN_MAX_SYMBOLS] = {6, 4, 2, 2, 2, 3, 5, 6};  // -3..3, escape
+
+constexpr HuffmanTable HUFFMAN_ETA2 = make_huffman_table(2, HUFFMAN_ETA2_LENGTHS);
+constexpr HuffmanTable HUFFMAN_ETA3 = make_huffman_table(3, HUFFMAN_ETA3_LENGTHS);
+
+const HuffmanTable* huffman_table_for(uint32_t eta) {
+    return eta == 2 ? &HUFFMAN_ETA2 : eta == 3 ? &HUFFMAN_ETA3 : nullptr;
 }
 
+// MSB-first bit packing through a 64-bit accumulator
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& out) : out_(out), buffer_(0), bits_(0) {}
+
+    void put(uint64_t value, uint32_t count) {
+        buffer_ = (buffer_ << count) | value;
+        bits_ += count;
+        while (bits_ >= 8) {
+            bits_ -= 8;
+            out_.push_back(static_cast<uint8_t>(buffer_ >> bits_));
+        }
+    }
+
+    // Pads the last byte with zero bits
+    void flush() {
+        if (bits_ > 0) {
+            out_.push_back(static_cast<uint8_t>(buffer_ << (8 - bits_)));
+            bits_ = 0;
+        }
+    }
+
+private:
+    std::vector<uint8_t>& out_;
+    uint64_t buffer_;  // only the low bits_ bits are pending
+    uint32_t bits_;
+};
+
+} // namespace
+
 // Huffman-based color encoding with adaptive compression
 std::vector<uint8_t> encode_polynomial_vector_as_colors_huffman(const std::vector<std::vector<ColorValue>>& poly_vector, uint32_t modulus) {
-    // Simplified Huffman-like compression for color compatibility
-    // For now, use variable-length encoding as a base
-    return encode_polynomial_vector_as_colors_compressed(poly_vector, modulus);
+    uint32_t k = poly_vector.size();
+    uint32_t n = k > 0 ? poly_vector[0].size() : 0;
+
+    // Centered coefficients pick the table: eta 2 when they all fit, eta 3 otherwise
+    size_t coefficients = 0;
+    bool fits_eta2 = true;
+    for (const auto& poly : poly_vector) {
+        for (const ColorValue& coeff : poly) {
+            uint32_t value = coeff.to_math_value() % modulus;
+            fits_eta2 = fits_eta2 && (value <= 2 || modulus - value <= 2);
+        }
+        coefficients += poly.size();
+    }
+    const HuffmanTable& table = fits_eta2 ? HUFFMAN_ETA2 : HUFFMAN_ETA3;
+    const int64_t eta = table.eta;
+    const uint32_t escape = table.symbols - 1;
+
+    std::vector<uint8_t> encoded;
+    encoded.reserve(HUFFMAN_HEADER_BYTES + coefficients * HUFFMAN_MAX_BITS / 8 + 1);
+    encoded.push_back(0x01); // Version 1
+    encoded.push_back(0x05); // Compression flag (5 = static Huffman over centered coefficients)
+    encoded.push_back(static_cast<uint8_t>(k));
+    encoded.push_back(static_cast<uint8_t>(n >> 8));
+    encoded.push_back(static_cast<uint8_t>(n & 0xFF));
+    encoded.push_back(static_cast<uint8_t>(table.eta));
+
+    BitWriter writer(encoded);
+    for (const auto& poly : poly_vector) {
+        for (const ColorValue& coeff : poly) {
+            uint32_t value = coeff.to_math_value() % modulus;
+            int64_t centered = value > modulus / 2 ? static_cast<int64_t>(value) - modulus : value;
+            if (centered >= -eta && centered <= eta) {
+                uint32_t symbol = static_cast<uint32_t>(centered + eta);
+                writer.put(table.codes[symbol], table.lengths[symbol]);
+            } else {
+                writer.put(table.codes[escape], table.lengths[escape]);
+                writer.put(value, HUFFMAN_ESCAPE_BITS);
+            }
+        }
+    }
+    writer.flush();
+
+    return encoded;
+}
+
+// Decode Huffman-coded color data back to polynomial vector
+std::vector<std::vector<ColorValue>> decode_colors_to_polynomial_vector_huffman(const std::vector<uint8_t>& color_data, uint32_t k, uint32_t n, uint32_t modulus) {
+    if (color_data.size() < HUFFMAN_HEADER_BYTES) {
+        throw std::invalid_argument("Huffman color data too small");
+    }
+    if (color_data[0] != 0x01 || color_data[1] != 0x05) {
+        throw std::invalid_argument("Unsupported Huffman color compression format");
+    }
+    uint32_t data_k = color_data[2];
+    uint32_t data_n = (static_cast<uint32_t>(color_data[3]) << 8) | color_data[4];
+    if (data_k != k || data_n != n) {
+        throw std::invalid_argument("Dimension mismatch in Huffman color data");
+    }
+    const HuffmanTable* table = huffman_table_for(color_data[5]);
+    if (table == nullptr) {
+        throw std::invalid_argument("Unsupported Huffman table in color data");
+    }
+    if (modulus <= 2 * table->eta) {
+        throw std::invalid_argument("Modulus too small for Huffman color data");
+    }
+    const int32_t eta = table->eta;
+    const uint32_t escape = table->symbols - 1;
+
+    std::vector<std::vector<ColorValue>> poly_vector(k, std::vector<ColorValue>(n, ColorValue()));
+
+    const uint8_t* data = color_data.data();
+    const size_t size = color_data.size();
+    size_t offset = HUFFMAN_HEADER_BYTES;
+    uint64_t buffer = 0;  // next bits of the stream, MSB first
+    uint32_t bits = 0;
+
+    for (uint32_t i = 0; i < k; ++i) {
+        ColorValue* poly = poly_vector[i].data();
+        for (uint32_t j = 0; j < n; ++j) {
+            // Enough for a code and an escaped value
+            if (bits < HUFFMAN_MAX_BITS + HUFFMAN_ESCAPE_BITS) {
+                while (bits <= 56 && offset < size) {
+                    buffer |= static_cast<uint64_t>(data[offset++]) << (56 - bits);
+                    bits += 8;
+                }
+            }
+
+            const HuffmanEntry entry = table->decode[buffer >> (64 - HUFFMAN_MAX_BITS)];
+            if (entry.length > bits) {
+                throw std::invalid_argument("Truncated Huffman color data");
+            }
+            buffer <<= entry.length;
+            bits -= entry.length;
+
+            uint32_t value;
+            if (entry.symbol != escape) {
+                int32_t centered = static_cast<int32_t>(entry.symbol) - eta;
+                value = centered < 0 ? modulus - static_cast<uint32_t>(-centered) : static_cast<uint32_t>(centered);
+            } else {
+                if (bits < HUFFMAN_ESCAPE_BITS) {
+                    throw std::invalid_argument("Truncated Huffman color data");
+                }
+                value = static_cast<uint32_t>(buffer >> 32) % modulus;
+                buffer <<= HUFFMAN_ESCAPE_BITS;
+                bits -= HUFFMAN_ESCAPE_BITS;
+            }
+            poly[j] = ColorValue::from_math_value(value);
+        }
+    }
+
+    return poly_vector;
+}
+
+namespace {
+
+constexpr size_t DENSE_HEADER_BYTES = 6;
+
+// Bits that hold any coefficient below modulus
+uint32_t dense_coefficient_bits(uint32_t modulus) {
+    uint32_t bits = 1;
+    while (bits < 32 && ((modulus - 1) >> bits) != 0) {
+        ++bits;
+    }
+    return bits;
+}
+
+} // namespace
+
+// Dense RGB packing: coefficients back to back at the modulus bit width
+std::vector<uint8_t> encode_polynomial_vector_as_colors_dense(const std::vector<std::vector<ColorValue>>& poly_vector, uint32_t modulus) {
+    uint32_t k = poly_vector.size();
+    uint32_t n = k > 0 ? poly_vector[0].size() : 0;
+    size_t coefficients = 0;
+    for (const auto& poly : poly_vector) {
+        coefficients += poly.size();
+    }
+    const uint32_t bits = dense_coefficient_bits(modulus);
+
+    // The stream is padded with zeros to whole RGB pixels
+    size_t payload = (coefficients * bits + 7) / 8;
+    std::vector<uint8_t> dense(DENSE_HEADER_BYTES + (payload + 2) / 3 * 3);
+    dense[0] = 0x01; // Version 1
+    dense[1] = 0x06; // Compression flag (6 = dense RGB packing)
+    dense[2] = static_cast<uint8_t>(k);
+    dense[3] = static_cast<uint8_t>(n >> 8);
+    dense[4] = static_cast<uint8_t>(n & 0xFF);
+    dense[5] = static_cast<uint8_t>(bits);
+    uint8_t* out = dense.data() + DENSE_HEADER_BYTES;
+
+    // MSB first, so two 12-bit coefficients fill exactly one pixel
+    uint64_t buffer = 0;  // only the low pending bits are kept
+    uint32_t pending = 0;
+    for (const auto& poly : poly_vector) {
+        for (const ColorValue& coeff : poly) {
+            buffer = (buffer << bits) | (coeff.to_math_value() % modulus);
+            pending += bits;
+            while (pending >= 8) {
+                pending -= 8;
+                *out++ = static_cast<uint8_t>(buffer >> pending);
+            }
+        }
+    }
+    if (pending > 0) {
+        *out = static_cast<uint8_t>(buffer << (8 - pending));
+    }
+
+    return dense;
+}
+
+// Decode densely packed color data back to polynomial vector
+std::vector<std::vector<ColorValue>> decode_colors_to_polynomial_vector_dense(const std::vector<uint8_t>& color_data, uint32_t k, uint32_t n, uint32_t modulus) {
+    if (color_data.size() < DENSE_HEADER_BYTES) {
+        throw std::invalid_argument("Dense color data too small");
+    }
+    if (color_data[0] != 0x01 || color_data[1] != 0x06) {
+        throw std::invalid_argument("Unsupported dense color packing format");
+    }
+    uint32_t data_k = color_data[2];
+    uint32_t data_n = (static_cast<uint32_t>(color_data[3]) << 8) | color_data[4];
+    if (data_k != k || data_n != n) {
+        throw std::invalid_argument("Dimension mismatch in dense color data");
+    }
+    const uint32_t bits = color_data[5];
+    if (bits == 0 || bits > 32) {
+        throw std::invalid_argument("Invalid coefficient width in dense color data");
+    }
+    const size_t coefficients = static_cast<size_t>(k) * n;
+    if (color_data.size() - DENSE_HEADER_BYTES < (coefficients * bits + 7) / 8) {
+        throw std::invalid_argument("Truncated dense color data");
+    }
+
+    std::vector<std::vector<ColorValue>> poly_vector(k, std::vector<ColorValue>(n, ColorValue()));
+
+    const uint8_t* in = color_data.data() + DENSE_HEADER_BYTES;
+    const uint64_t mask = (static_cast<uint64_t>(1) << bits) - 1;
+    uint64_t buffer = 0;
+    uint32_t available = 0;
+    for (uint32_t i = 0; i < k; ++i) {
+        ColorValue* poly = poly_vector[i].data();
+        for (uint32_t j = 0; j < n; ++j) {
+            while (available < bits) {
+                buffer = (buffer << 8) | *in++;
+                available += 8;
+            }
+            available -= bits;
+            uint32_t value = static_cast<uint32_t>((buffer >> available) & mask);
+            poly[j] = ColorValue::from_math_value(reduce_coefficient(value, modulus));
+        }
+    }
+
+    return poly_vector;
 }
 
 std::vector<uint8_t> generate_color_representation_from_compressed(const std::vector<uint8_t>& compressed_data, uint32_t k, uint32_t n, uint32_t modulus) {
@@ -273,42 +769,44 @@ std::vector<uint8_t> generate_color_representation_from_compressed(const std::ve
 }
 
 std::vector<uint8_t> compress_with_color_support(const std::vector<std::vector<ColorValue>>& poly_vector, uint32_t modulus, bool enable_color_metadata) {
-    // First compress the polynomial data using auto compression
-    auto compressed_data = encode_polynomial_vector_as_colors_auto(poly_vector, modulus);
-
-    // If color metadata is enabled, add color generation capabilities
-    if (enable_color_metadata) {
-        std::vector<uint8_t> dual_format_data;
+    if (!enable_color_metadata) {
+        return encode_polynomial_vector_as_colors_auto(poly_vector, modulus);
+    }
 
-        // Add dual-format header
-        dual_format_data.push_back(0x02); // Version 2
-        dual_format_data.push_back(0x01); // Dual-format flag
+    uint32_t k = poly_vector.size();
+    uint32_t n = k > 0 ? poly_vector[0].size() : 0;
+    size_t total_coeffs = 0;
+    for (const auto& poly : poly_vector) {
+        total_coeffs += poly.size();
+    }
 
-        // Store dimensions
-        uint32_t k = poly_vector.size();
-        uint32_t n = k > 0 ? poly_vector[0].size() : 0;
+    // The auto-compressed cryptographic data is written in place behind the header
+    std::vector<uint8_t> dual_format_data(DUAL_HEADER_BYTES + auto_encoding_capacity(total_coeffs) + 1);
+    uint8_t* header = dual_format_data.data();
 
-        dual_format_data.push_back(static_cast<uint8_t>(k));
-        dual_format_data.push_back(static_cast<uint8_t>(n >> 8));
-        dual_format_data.push_back(static_cast<uint8_t>(n & 0xFF));
+    // Add dual-format header
+    header[0] = 0x02; // Version 2
+    header[1] = 0x01; // Dual-format flag
 
-        // Add modulus information
-        dual_format_data.push_back(static_cast<uint8_t>(modulus >> 24));
-        dual_format_data.push_back(static_cast<uint8_t>(modulus >> 16));
-        dual_format_data.push_back(static_cast<uint8_t>(modulus >> 8));
-        dual_format_data.push_back(static_cast<uint8_t>(modulus & 0xFF));
+    // Store dimensions
+    header[2] = static_cast<uint8_t>(k);
+    header[3] = static_cast<uint8_t>(n >> 8);
+    header[4] = static_cast<uint8_t>(n & 0xFF);
 
-        // Add compressed cryptographic data
-        dual_format_data.insert(dual_format_data.end(), compressed_data.begin(), compressed_data.end());
+    // Add modulus information
+    header[5] = static_cast<uint8_t>(modulus >> 24);
+    header[6] = static_cast<uint8_t>(modulus >> 16);
+    header[7] = static_cast<uint8_t>(modulus >> 8);
+    header[8] = static_cast<uint8_t>(modulus & 0xFF);
 
-        // Add color metadata (optional, can be used for visualization hints)
-        // For now, we'll add a simple color generation flag
-        dual_format_data.push_back(0x01); // Color generation enabled
+    size_t end = DUAL_HEADER_BYTES + encode_auto_into(poly_vector, modulus, header + DUAL_HEADER_BYTES);
 
-        return dual_format_data;
-    }
+    // Add color metadata (optional, can be used for visualization hints)
+    // For now, we'll add a simple color generation flag
+    dual_format_data[end++] = 0x01; // Color generation enabled
 
-    return compressed_data;
+    dual_format_data.resize(end);
+    return dual_format_data;
 }
 
 std::vector<std::vector<ColorValue>> decompress_with_color_support(const std::vector<uint8_t>& dual_format_data, uint32_t& out_k, uint32_t& out_n, uint32_t& out_modulus) {
@@ -345,13 +843,155 @@ std::vector<std::vector<ColorValue>> decompress_with_color_support(const std::ve
 }
 
 std::vector<uint8_t> generate_color_from_dual_format(const std::vector<uint8_t>& dual_format_data) {
-    uint32_t k, n, modulus;
+    // Render the whole image straight from the compressed stream
+    DualFormatColorView view(dual_format_data);
+    return view.render_pixels(0, view.pixel_count());
+}
 
-    // First decompress to get the polynomial data
-    auto poly_vector = decompress_with_color_support(dual_format_data, k, n, modulus);
+namespace {
 
-    // Then generate color representation
-    return encode_polynomial_vector_as_colors(poly_vector);
+constexpr size_t VIEW_CHECKPOINT_COEFFS = 64;
+
+} // namespace
+
+DualFormatColorView::DualFormatColorView(const std::vector<uint8_t>& dual_format_data)
+    : payload_(nullptr), k_(0), n_(0), modulus_(0), compressed_(false) {
+    if (dual_format_data.size() < DUAL_HEADER_BYTES) {
+        throw std::invalid_argument("Dual-format data too small");
+    }
+    const uint8_t* header = dual_format_data.data();
+    if (header[0] != 0x02 || header[1] != 0x01) {
+        throw std::invalid_argument("Unsupported dual-format container");
+    }
+    k_ = header[2];
+    n_ = (static_cast<uint32_t>(header[3]) << 8) | header[4];
+    modulus_ = (static_cast<uint32_t>(header[5]) << 24) |
+               (static_cast<uint32_t>(header[6]) << 16) |
+               (static_cast<uint32_t>(header[7]) << 8) |
+               header[8];
+    if (modulus_ == 0) {
+        throw std::invalid_argument("Invalid modulus in dual-format data");
+    }
+
+    payload_ = header + DUAL_HEADER_BYTES;
+    const size_t size = dual_format_data.size() - DUAL_HEADER_BYTES;
+    const size_t coefficients = static_cast<size_t>(k_) * n_;
+
+    if (size >= 5 && payload_[0] == 0x01 && payload_[1] == 0x03) {
+        compressed_ = true;
+        uint32_t data_k = payload_[2];
+        uint32_t data_n = (static_cast<uint32_t>(payload_[3]) << 8) | payload_[4];
+        if (data_k != k_ || data_n != n_) {
+            throw std::invalid_argument("Dimension mismatch in compressed color data");
+        }
+
+        // One pass over the leading bytes checks every code and records the checkpoints
+        checkpoints_.reserve(coefficients / VIEW_CHECKPOINT_COEFFS + 1);
+        size_t offset = 5;
+        for (size_t c = 0; c < coefficients; ++c) {
+            if (c % VIEW_CHECKPOINT_COEFFS == 0) {
+                checkpoints_.push_back(static_cast<uint32_t>(offset));
+            }
+            if (offset >= size) {
+                throw std::invalid_argument("Truncated compressed color data");
+            }
+            uint32_t length = COMPRESSED_LEADS.entries[payload_[offset]].length;
+            if (length == 0) {
+                throw std::invalid_argument("Invalid color-compatible compression encoding");
+            }
+            if (offset + length > size) {
+                throw std::invalid_argument("Truncated compressed color data");
+            }
+            offset += length;
+        }
+    } else if (size / STANDARD_COEFF_BYTES != coefficients || size % STANDARD_COEFF_BYTES > 1) {
+        // Otherwise the auto encoder chose the standard format, followed by the metadata byte
+        throw std::invalid_argument("Unsupported dual-format payload");
+    }
+}
+
+size_t DualFormatColorView::seek(size_t index) const {
+    if (!compressed_) {
+        return index * STANDARD_COEFF_BYTES;
+    }
+    size_t offset = checkpoints_[index / VIEW_CHECKPOINT_COEFFS];
+    for (size_t skip = index % VIEW_CHECKPOINT_COEFFS; skip > 0; --skip) {
+        offset += COMPRESSED_LEADS.entries[payload_[offset]].length;
+    }
+    return offset;
+}
+
+uint32_t DualFormatColorView::read(size_t& offset) const {
+    const uint8_t* code = payload_ + offset;
+    if (!compressed_) {
+        offset += STANDARD_COEFF_BYTES;
+        return (static_cast<uint32_t>(code[0]) << 24) |
+               (static_cast<uint32_t>(code[1]) << 16) |
+               (static_cast<uint32_t>(code[2]) << 8) |
+               code[3];
+    }
+    const CompressedLead& lead = COMPRESSED_LEADS.entries[code[0]];
+    uint32_t value = code[0] & lead.mask;
+    for (uint32_t b = 1; b < lead.length; ++b) {
+        value = (value << 8) | code[b];
+    }
+    offset += lead.length;
+    return reduce_coefficient(value, modulus_);
+}
+
+void DualFormatColorView::render_unchecked(size_t first_pixel, size_t count, uint8_t* rgb_out) const {
+    if (count == 0) {
+        return;
+    }
+    size_t offset = seek(first_pixel / 4);
+    uint32_t value = read(offset);
+    size_t pixel = first_pixel % 4;
+
+    // Same layout as encode_polynomial_as_colors: (b0, b1, b2), (b3, 0, 0), black, black
+    for (size_t p = 0; p < count; ++p, ++pixel, rgb_out += 3) {
+        if (pixel == 4) {
+            pixel = 0;
+            value = read(offset);
+        }
+        if (pixel == 0) {
+            rgb_out[0] = static_cast<uint8_t>(value >> 24);
+            rgb_out[1] = static_cast<uint8_t>(value >> 16);
+            rgb_out[2] = static_cast<uint8_t>(value >> 8);
+        } else {
+            rgb_out[0] = pixel == 1 ? static_cast<uint8_t>(value) : 0;
+            rgb_out[1] = 0;
+            rgb_out[2] = 0;
+        }
+    }
+}
+
+void DualFormatColorView::render_pixels(size_t first_pixel, size_t count, uint8_t* rgb_out) const {
+    if (first_pixel > pixel_count() || count > pixel_count() - first_pixel) {
+        throw std::invalid_argument("Pixel range exceeds the dual-format image");
+    }
+    render_unchecked(first_pixel, count, rgb_out);
+}
+
+std::vector<uint8_t> DualFormatColorView::render_pixels(size_t first_pixel, size_t count) const {
+    if (first_pixel > pixel_count() || count > pixel_count() - first_pixel) {
+        throw std::invalid_argument("Pixel range exceeds the dual-format image");
+    }
+    std::vector<uint8_t> rgb(3 * count);
+    render_unchecked(first_pixel, count, rgb.data());
+    return rgb;
+}
+
+void DualFormatColorView::render_tile(size_t image_width, size_t x, size_t y, size_t tile_width, size_t tile_height, uint8_t* rgb_out) const {
+    if (tile_width > image_width || x > image_width - tile_width) {
+        throw std::invalid_argument("Tile exceeds the image width");
+    }
+    const size_t total = pixel_count();
+    for (size_t row = 0; row < tile_height; ++row, rgb_out += 3 * tile_width) {
+        size_t start = (y + row) * image_width + x;
+        size_t visible = start < total ? std::min(tile_width, total - start) : 0;
+        render_unchecked(start, visible, rgb_out);
+        std::memset(rgb_out + 3 * visible, 0, 3 * (tile_width - visible));
+    }
 }
 
 std::vector<uint8_t> encode_polynomial_vector_with_color_integration(const std::vector<std::vector<ColorValue>>& poly_vector, uint32_t modulus, bool enable_on_demand_color) {
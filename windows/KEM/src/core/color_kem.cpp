@@ -1,5 +1,6 @@
 #include "color_kem.hpp"
 #include "shake_sampler.hpp"
+#include "keccak_x4.hpp"
 #include "utils.hpp"
 #include "../include/clwe/color_integration.hpp"
 #include <random>
@@ -17,6 +18,35 @@ ColorKEM::ColorKEM(const CLWEParameters& params)
 
 ColorKEM::~ColorKEM() = default;
 
+namespace {
+
+// Two 12-bit candidates per three bytes, each kept if below q, until poly is full
+void parse_uniform(const uint8_t* bytes, size_t len, std::vector<ColorValue>& poly, size_t& coeff_idx, uint32_t q) {
+    const size_t n = poly.size();
+    for (size_t pos = 0; pos + 3 <= len && coeff_idx < n; pos += 3) {
+        uint16_t coeff1 = ((bytes[pos] << 4) | (bytes[pos + 1] >> 4)) & 0xFFF;
+        uint16_t coeff2 = ((bytes[pos + 1] << 8) | bytes[pos + 2]) & 0xFFF;
+
+        if (coeff1 < q && coeff_idx < n) {
+            poly[coeff_idx++] = ColorValue::from_math_value(coeff1);
+        }
+        if (coeff2 < q && coeff_idx < n) {
+            poly[coeff_idx++] = ColorValue::from_math_value(coeff2);
+        }
+    }
+}
+
+// SHAKE-128 input of matrix entry (i, j): seed || i || j
+std::array<uint8_t, 34> matrix_entry_input(const std::array<uint8_t, 32>& seed, uint32_t i, uint32_t j) {
+    std::array<uint8_t, 34> input;
+    std::copy(seed.begin(), seed.end(), input.begin());
+    input[32] = static_cast<uint8_t>(i);
+    input[33] = static_cast<uint8_t>(j);
+    return input;
+}
+
+} // namespace
+
 std::vector<std::vector<std::vector<ColorValue>>> ColorKEM::generate_matrix_A(const std::array<uint8_t, 32>& seed) const {
     uint32_t k = params_.module_rank;
     uint32_t n = params_.degree;
@@ -24,35 +54,50 @@ std::vector<std::vector<std::vector<ColorValue>>> ColorKEM::generate_matrix_A(co
 
     std::vector<std::vector<std::vector<ColorValue>>> matrix(k, std::vector<std::vector<ColorValue>>(k, std::vector<ColorValue>(n)));
 
-    for (uint32_t i = 0; i < k; ++i) {
-        for (uint32_t j = 0; j < k; ++j) {
-
-            std::vector<uint8_t> shake_input;
-            shake_input.reserve(seed.size() + 2);
-            shake_input.insert(shake_input.end(), seed.begin(), seed.end());
-            shake_input.push_back(static_cast<uint8_t>(i));
-            shake_input.push_back(static_cast<uint8_t>(j));
-
+    // With AVX2, four entries (in row-major order) share one 4-way Keccak permutation. A
+    // squeezed block holds a whole number of byte triples, so each entry parses the same
+    // stream as the sequential path below.
+    const uint32_t entries = k * k;
+    uint32_t entry = 0;
+    if (keccak_x4_avx2_supported()) {
+        std::array<std::array<uint8_t, 34>, 4> inputs;
+        std::array<std::array<uint8_t, SHAKE128_RATE>, 4> blocks;
+        for (; entry + 4 <= entries; entry += 4) {
+            const uint8_t* seeds[4];
+            uint8_t* out[4];
+            for (uint32_t lane = 0; lane < 4; ++lane) {
+                inputs[lane] = matrix_entry_input(seed, (entry + lane) / k, (entry + lane) % k);
+                seeds[lane] = inputs[lane].data();
+                out[lane] = blocks[lane].data();
+            }
 
-            SHAKE128Sampler shake128;
-            shake128.init(shake_input.data(), shake_input.size());
+            SHAKE128x4Sampler shake128;
+            shake128.init_x4(seeds, inputs[0].size());
 
+            std::array<size_t, 4> coeff_idx = {0, 0, 0, 0};
+            while (*std::min_element(coeff_idx.begin(), coeff_idx.end()) < n) {
+                shake128.squeeze_blocks_x4(out, 1);
+                for (uint32_t lane = 0; lane < 4; ++lane) {
+                    parse_uniform(out[lane], SHAKE128_RATE, matrix[(entry + lane) / k][(entry + lane) % k],
+                                  coeff_idx[lane], q);
+                }
+            }
+        }
+    }
 
-            size_t coeff_idx = 0;
-            while (coeff_idx < n) {
-                std::array<uint8_t, 3> bytes;
-                shake128.squeeze(bytes.data(), bytes.size());
+    for (; entry < entries; ++entry) {
+        uint32_t i = entry / k;
+        uint32_t j = entry % k;
+        std::array<uint8_t, 34> shake_input = matrix_entry_input(seed, i, j);
 
-                uint16_t coeff1 = ((bytes[0] << 4) | (bytes[1] >> 4)) & 0xFFF;
-                uint16_t coeff2 = ((bytes[1] << 8) | bytes[2]) & 0xFFF;
+        SHAKE128Sampler shake128;
+        shake128.init(shake_input.data(), shake_input.size());
 
-                if (coeff1 < q && coeff_idx < n) {
-                    matrix[i][j][coeff_idx++] = ColorValue::from_math_value(coeff1);
-                }
-                if (coeff2 < q && coeff_idx < n) {
-                    matrix[i][j][coeff_idx++] = ColorValue::from_math_value(coeff2);
-                }
-            }
+        size_t coeff_idx = 0;
+        while (coeff_idx < n) {
+            std::array<uint8_t, 3> bytes;
+            shake128.squeeze(bytes.data(), bytes.size());
+            parse_uniform(bytes.data(), bytes.size(), matrix[i][j], coeff_idx, q);
         }
     }
 
@@ -777,12 +822,12 @@ std::vector<uint8_t> ColorPublicKey::serialize() const {
 }
 
 ColorPublicKey ColorPublicKey::deserialize(const std::vector<uint8_t>& data, const CLWEParameters& params) {
-    if (data.size() < 38) {  // format_version(1) + use_compression(1) + metadata_size(2) + min_metadata(0) + seed(32) + min_public_data(4)
-        throw std::invalid_argument("Public key data too small: minimum 38 bytes required, got " + std::to_string(data.size()));
-    }
+    return deserialize(data.data(), data.size(), params);
+}
 
-    if (data.empty()) {
-        throw std::invalid_argument("Public key data cannot be empty");
+ColorPublicKey ColorPublicKey::deserialize(const uint8_t* data, size_t size, const CLWEParameters& params) {
+    if (size < 38) {  // format_version(1) + use_compression(1) + metadata_size(2) + min_metadata(0) + seed(32) + min_public_data(4)
+        throw std::invalid_argument("Public key data too small: minimum 38 bytes required, got " + std::to_string(size));
     }
 
     ColorPublicKey key;
@@ -791,14 +836,14 @@ ColorPublicKey ColorPublicKey::deserialize(const std::vector<uint8_t>& data, con
     key.use_compression = (data[offset++] != 0);
     uint16_t metadata_size = (static_cast<uint16_t>(data[offset]) << 8) | data[offset + 1];
     offset += 2;
-    if (offset + metadata_size + 32 > data.size()) {
+    if (offset + metadata_size + 32 > size) {
         throw std::invalid_argument("Invalid metadata size in public key data");
     }
-    key.metadata.assign(data.begin() + offset, data.begin() + offset + metadata_size);
+    key.metadata.assign(data + offset, data + offset + metadata_size);
     offset += metadata_size;
-    std::copy(data.begin() + offset, data.begin() + offset + 32, key.seed.begin());
+    std::copy(data + offset, data + offset + 32, key.seed.begin());
     offset += 32;
-    key.public_data.assign(data.begin() + offset, data.end());
+    key.public_data.assign(data + offset, data + size);
     key.params = params;
 
     // Validate public data size based on compression
@@ -25,6 +25,7 @@ struct ColorPublicKey {
 
     std::vector<uint8_t> serialize() const;
     static ColorPublicKey deserialize(const std::vector<uint8_t>& data, const CLWEParameters& params);
+    static ColorPublicKey deserialize(const uint8_t* data, size_t size, const CLWEParameters& params);
 };
 
 struct ColorPrivateKey {
@@ -0,0 +1,288 @@
+#include "color_ntt_avx2.hpp"
+#include "cpu_features.hpp"
+#include "simd_target.hpp"
+#include <stdexcept>
+#include <utility>
+
+#ifdef HAVE_AVX2
+#include <immintrin.h>
+#endif
+
+namespace clwe {
+
+bool ColorNTTAVX2::usable(uint32_t q, uint32_t n) {
+#ifdef HAVE_AVX2
+    return CPUFeatureDetector::cached().has_avx2 && n >= 16 && q < (1u << 31);
+#else
+    (void)q;
+    (void)n;
+    return false;
+#endif
+}
+
+#ifdef HAVE_AVX2
+
+static_assert(sizeof(ColorValue) == 4, "ColorValue must pack into one 32-bit word");
+
+namespace {
+
+// Lane offsets, within a 16-coefficient chunk, of the u inputs of the stages with half < 8;
+// each v input sits half further on
+constexpr uint32_t SMALL_STAGE_OFFSETS[3][8] = {
+    {0, 8, 2, 10, 4, 12, 6, 14},  // half = 1
+    {0, 1, 8, 9, 4, 5, 12, 13},   // half = 2
+    {0, 1, 2, 3, 8, 9, 10, 11},   // half = 4
+};
+
+// Twiddles of one stage in butterfly order: the block of each u input picks the zeta, as in
+// the zeta_index walk of ColorNTTEngine
+std::vector<uint32_t> stage_twiddles(const std::vector<uint32_t>& zetas, uint32_t q, uint32_t n,
+                                     uint32_t log_half, uint32_t r_mod_q) {
+    const uint32_t half = 1u << log_half;
+    const uint32_t len = 2 * half;
+    std::vector<uint32_t> table;
+    table.reserve(n / 2);
+    auto push = [&](uint32_t u) {
+        uint32_t block = u / len;
+        uint32_t zeta = zetas[(static_cast<uint64_t>(block) * (n / len)) % n];
+        table.push_back(static_cast<uint32_t>((static_cast<uint64_t>(zeta) * r_mod_q) % q));
+    };
+    if (half >= 8) {
+        for (uint32_t start = 0; start < n; start += len) {
+            for (uint32_t j = 0; j < half; ++j) {
+                push(start + j);
+            }
+        }
+    } else {
+        for (uint32_t chunk = 0; chunk < n; chunk += 16) {
+            for (uint32_t lane = 0; lane < 8; ++lane) {
+                push(chunk + SMALL_STAGE_OFFSETS[log_half][lane]);
+            }
+        }
+    }
+    return table;
+}
+
+// a * b * 2^-32 mod q, fully reduced, for a * b < 2^32 * q: even and odd lanes are
+// widened to 64 bits separately and blended back
+CLWE_TARGET_AVX2 CLWE_ALWAYS_INLINE __m256i mont_mul(__m256i a, __m256i b, __m256i q, __m256i qinv) {
+    __m256i t_even = _mm256_mul_epu32(a, b);
+    __m256i t_odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+    __m256i r_even = _mm256_add_epi64(t_even, _mm256_mul_epu32(_mm256_mul_epu32(t_even, qinv), q));
+    __m256i r_odd = _mm256_add_epi64(t_odd, _mm256_mul_epu32(_mm256_mul_epu32(t_odd, qinv), q));
+    __m256i r = _mm256_blend_epi32(_mm256_srli_epi64(r_even, 32), r_odd, 0xAA);
+    return _mm256_min_epu32(r, _mm256_sub_epi32(r, q));
+}
+
+// For x < 2q: x - q wraps above x exactly when x < q
+CLWE_TARGET_AVX2 CLWE_ALWAYS_INLINE __m256i reduce_once(__m256i x, __m256i q) {
+    return _mm256_min_epu32(x, _mm256_sub_epi32(x, q));
+}
+
+template <bool Inverse>
+CLWE_TARGET_AVX2 CLWE_ALWAYS_INLINE void butterfly(__m256i& u, __m256i& v, __m256i w, __m256i q, __m256i qinv) {
+    if (Inverse) {
+        __m256i diff = reduce_once(_mm256_add_epi32(_mm256_sub_epi32(u, v), q), q);
+        u = reduce_once(_mm256_add_epi32(u, v), q);
+        v = mont_mul(diff, w, q, qinv);
+    } else {
+        __m256i t = mont_mul(v, w, q, qinv);
+        v = reduce_once(_mm256_add_epi32(_mm256_sub_epi32(u, t), q), q);
+        u = reduce_once(_mm256_add_epi32(u, t), q);
+    }
+}
+
+// Stages with half >= 8: u and v are contiguous runs of eight
+template <bool Inverse>
+CLWE_TARGET_AVX2 void wide_stage(uint32_t* x, uint32_t n, uint32_t half, const uint32_t* w,
+                                 uint32_t modulus, uint32_t qinv_neg) {
+    const __m256i q = _mm256_set1_epi32(static_cast<int>(modulus));
+    const __m256i qinv = _mm256_set1_epi32(static_cast<int>(qinv_neg));
+    for (uint32_t start = 0; start < n; start += 2 * half) {
+        for (uint32_t j = 0; j < half; j += 8, w += 8) {
+            __m256i* pu = reinterpret_cast<__m256i*>(x + start + j);
+            __m256i* pv = reinterpret_cast<__m256i*>(x + start + j + half);
+            __m256i u = _mm256_loadu_si256(pu);
+            __m256i v = _mm256_loadu_si256(pv);
+            butterfly<Inverse>(u, v, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w)), q, qinv);
+            _mm256_storeu_si256(pu, u);
+            _mm256_storeu_si256(pv, v);
+        }
+    }
+}
+
+// Stages with half 1, 2 and 4: each 16-coefficient chunk is split into its u and v
+// halves (SMALL_STAGE_OFFSETS), transformed, and interleaved back
+template <bool Inverse, int LogHalf>
+CLWE_TARGET_AVX2 void narrow_stage(uint32_t* x, uint32_t n, const uint32_t* w, uint32_t modulus, uint32_t qinv_neg) {
+    const __m256i q = _mm256_set1_epi32(static_cast<int>(modulus));
+    const __m256i qinv = _mm256_set1_epi32(static_cast<int>(qinv_neg));
+    for (uint32_t chunk = 0; chunk < n; chunk += 16, w += 8) {
+        __m256i* pa = reinterpret_cast<__m256i*>(x + chunk);
+        __m256i* pb = reinterpret_cast<__m256i*>(x + chunk + 8);
+        __m256i a = _mm256_loadu_si256(pa);
+        __m256i b = _mm256_loadu_si256(pb);
+        __m256i u, v;
+        if (LogHalf == 0) {
+            u = _mm256_blend_epi32(a, _mm256_slli_epi64(b, 32), 0xAA);
+            v = _mm256_blend_epi32(_mm256_srli_epi64(a, 32), b, 0xAA);
+        } else if (LogHalf == 1) {
+            u = _mm256_unpacklo_epi64(a, b);
+            v = _mm256_unpackhi_epi64(a, b);
+        } else {
+            u = _mm256_permute2x128_si256(a, b, 0x20);
+            v = _mm256_permute2x128_si256(a, b, 0x31);
+        }
+        butterfly<Inverse>(u, v, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w)), q, qinv);
+        if (LogHalf == 0) {
+            a = _mm256_blend_epi32(u, _mm256_slli_epi64(v, 32), 0xAA);
+            b = _mm256_blend_epi32(_mm256_srli_epi64(u, 32), v, 0xAA);
+        } else if (LogHalf == 1) {
+            a = _mm256_unpacklo_epi64(u, v);
+            b = _mm256_unpackhi_epi64(u, v);
+        } else {
+            a = _mm256_permute2x128_si256(u, v, 0x20);
+            b = _mm256_permute2x128_si256(u, v, 0x31);
+        }
+        _mm256_storeu_si256(pa, a);
+        _mm256_storeu_si256(pb, b);
+    }
+}
+
+template <bool Inverse>
+void run_stage(uint32_t* x, uint32_t n, uint32_t log_half, const uint32_t* w, uint32_t q, uint32_t qinv_neg) {
+    switch (log_half) {
+        case 0: narrow_stage<Inverse, 0>(x, n, w, q, qinv_neg); break;
+        case 1: narrow_stage<Inverse, 1>(x, n, w, q, qinv_neg); break;
+        case 2: narrow_stage<Inverse, 2>(x, n, w, q, qinv_neg); break;
+        default: wide_stage<Inverse>(x, n, 1u << log_half, w, q, qinv_neg); break;
+    }
+}
+
+// ColorValue stores r, g, b, a in memory order while to_math_value() puts r on top, so
+// converting between the two is a byte swap of every word
+CLWE_TARGET_AVX2 CLWE_ALWAYS_INLINE __m256i byte_swap_words(__m256i v) {
+    const __m256i mask = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                          3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    return _mm256_shuffle_epi8(v, mask);
+}
+
+// Montgomery multiplication by 2^32 mod q maps any 32-bit word to its residue
+CLWE_TARGET_AVX2 void load_colors(const ColorValue* colors, uint32_t* x, uint32_t n, uint32_t modulus,
+                                  uint32_t qinv_neg, uint32_t r_mod_q) {
+    const __m256i q = _mm256_set1_epi32(static_cast<int>(modulus));
+    const __m256i qinv = _mm256_set1_epi32(static_cast<int>(qinv_neg));
+    const __m256i r = _mm256_set1_epi32(static_cast<int>(r_mod_q));
+    for (uint32_t i = 0; i < n; i += 8) {
+        __m256i v = byte_swap_words(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(colors + i)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(x + i), mont_mul(v, r, q, qinv));
+    }
+}
+
+CLWE_TARGET_AVX2 void store_colors(const uint32_t* x, ColorValue* colors, uint32_t n) {
+    for (uint32_t i = 0; i < n; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(colors + i), byte_swap_words(v));
+    }
+}
+
+// a * b mod q: the first reduction leaves a * b * 2^-32, the multiplication by 2^64 mod q
+// cancels it
+CLWE_TARGET_AVX2 void pointwise(uint32_t* a, const uint32_t* b, uint32_t n, uint32_t modulus,
+                                uint32_t qinv_neg, uint32_t r2_mod_q) {
+    const __m256i q = _mm256_set1_epi32(static_cast<int>(modulus));
+    const __m256i qinv = _mm256_set1_epi32(static_cast<int>(qinv_neg));
+    const __m256i r2 = _mm256_set1_epi32(static_cast<int>(r2_mod_q));
+    for (uint32_t i = 0; i < n; i += 8) {
+        __m256i* pa = reinterpret_cast<__m256i*>(a + i);
+        __m256i va = _mm256_loadu_si256(pa);
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        _mm256_storeu_si256(pa, mont_mul(mont_mul(va, vb, q, qinv), r2, q, qinv));
+    }
+}
+
+} // namespace
+
+ColorNTTAVX2::ColorNTTAVX2(uint32_t q, uint32_t n, const std::vector<uint32_t>& zetas,
+                           const std::vector<uint32_t>& zetas_inv, const std::vector<uint32_t>& bitrev)
+    : q_(q), n_(n), log_n_(0), bitrev_(bitrev) {
+    if (!usable(q, n)) {
+        throw std::logic_error("AVX2 NTT kernels are not usable for these parameters on this CPU");
+    }
+    while ((1u << log_n_) < n_) {
+        ++log_n_;
+    }
+
+    // Newton iteration doubles the correct low bits of q^-1 mod 2^32 each step
+    uint32_t inv = q_;
+    for (int i = 0; i < 5; ++i) {
+        inv *= 2 - q_ * inv;
+    }
+    qinv_neg_ = 0u - inv;
+    r_mod_q_ = static_cast<uint32_t>((uint64_t(1) << 32) % q_);
+    r2_mod_q_ = static_cast<uint32_t>((static_cast<uint64_t>(r_mod_q_) * r_mod_q_) % q_);
+
+    for (uint32_t s = 0; s < log_n_; ++s) {
+        forward_twiddles_.push_back(stage_twiddles(zetas, q_, n_, s, r_mod_q_));
+        inverse_twiddles_.push_back(stage_twiddles(zetas_inv, q_, n_, s, r_mod_q_));
+    }
+}
+
+void ColorNTTAVX2::forward(uint32_t* x) const {
+    for (uint32_t s = 0; s < log_n_; ++s) {
+        run_stage<false>(x, n_, s, forward_twiddles_[s].data(), q_, qinv_neg_);
+    }
+    bit_reverse(x);
+}
+
+void ColorNTTAVX2::inverse(uint32_t* x) const {
+    bit_reverse(x);
+    for (uint32_t s = log_n_; s-- > 0;) {
+        run_stage<true>(x, n_, s, inverse_twiddles_[s].data(), q_, qinv_neg_);
+    }
+}
+
+void ColorNTTAVX2::bit_reverse(uint32_t* x) const {
+    for (uint32_t i = 0; i < n_; ++i) {
+        if (i < bitrev_[i]) {
+            std::swap(x[i], x[bitrev_[i]]);
+        }
+    }
+}
+
+void ColorNTTAVX2::load(const ColorValue* colors, uint32_t* x) const {
+    load_colors(colors, x, n_, q_, qinv_neg_, r_mod_q_);
+}
+
+void ColorNTTAVX2::store(const uint32_t* x, ColorValue* colors) const {
+    store_colors(x, colors, n_);
+}
+
+void ColorNTTAVX2::ntt_forward(ColorValue* poly) const {
+    std::vector<uint32_t> x(n_);
+    load(poly, x.data());
+    forward(x.data());
+    store(x.data(), poly);
+}
+
+void ColorNTTAVX2::ntt_inverse(ColorValue* poly) const {
+    std::vector<uint32_t> x(n_);
+    load(poly, x.data());
+    inverse(x.data());
+    store(x.data(), poly);
+}
+
+void ColorNTTAVX2::multiply(const ColorValue* a, const ColorValue* b, ColorValue* result) const {
+    std::vector<uint32_t> x(n_), y(n_);
+    load(a, x.data());
+    load(b, y.data());
+    forward(x.data());
+    forward(y.data());
+    pointwise(x.data(), y.data(), n_, q_, qinv_neg_, r2_mod_q_);
+    inverse(x.data());
+    store(x.data(), result);
+}
+
+#endif // HAVE_AVX2
+
+} // namespace clwe
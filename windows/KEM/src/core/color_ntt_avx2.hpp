@@ -0,0 +1,47 @@
+#ifndef COLOR_NTT_AVX2_HPP
+#define COLOR_NTT_AVX2_HPP
+
+#include "color_value.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace clwe {
+
+// AVX2 backend of ColorNTTEngine: the same transforms, eight coefficients per butterfly.
+// Products use Montgomery reduction (R = 2^32) against twiddles stored in Montgomery form,
+// and every stage's twiddles are laid out in the order its vector butterflies read them.
+// Outputs are canonical residues, which is what the scalar path returns for reduced input.
+class ColorNTTAVX2 {
+public:
+    // zetas and zetas_inv as ColorNTTEngine computes them, bitrev its bit reversal table
+    ColorNTTAVX2(uint32_t q, uint32_t n, const std::vector<uint32_t>& zetas,
+                 const std::vector<uint32_t>& zetas_inv, const std::vector<uint32_t>& bitrev);
+
+    // Built with HAVE_AVX2, the CPU reports AVX2, n >= 16 and q < 2^31
+    static bool usable(uint32_t q, uint32_t n);
+
+    void ntt_forward(ColorValue* poly) const;
+    void ntt_inverse(ColorValue* poly) const;
+    void multiply(const ColorValue* a, const ColorValue* b, ColorValue* result) const;
+
+private:
+    void forward(uint32_t* x) const;
+    void inverse(uint32_t* x) const;
+    void bit_reverse(uint32_t* x) const;
+    void load(const ColorValue* colors, uint32_t* x) const;   // Reduces mod q on the way in
+    void store(const uint32_t* x, ColorValue* colors) const;
+
+    uint32_t q_;
+    uint32_t n_;
+    uint32_t log_n_;
+    uint32_t qinv_neg_;    // -q^-1 mod 2^32
+    uint32_t r_mod_q_;     // 2^32 mod q
+    uint32_t r2_mod_q_;    // 2^64 mod q
+    std::vector<std::vector<uint32_t>> forward_twiddles_;  // [log2(half)][butterfly], Montgomery form
+    std::vector<std::vector<uint32_t>> inverse_twiddles_;
+    std::vector<uint32_t> bitrev_;
+};
+
+} // namespace clwe
+
+#endif // COLOR_NTT_AVX2_HPP
@@ -1,4 +1,5 @@
 #include "color_ntt_engine.hpp"
+#include "color_ntt_avx2.hpp"
 #include "../include/clwe/clwe.hpp"
 #include "utils.hpp"
 #include <algorithm>
@@ -6,7 +7,7 @@
 
 namespace clwe {
 
-ColorNTTEngine::ColorNTTEngine(uint32_t q, uint32_t n)
+ColorNTTEngine::ColorNTTEngine(uint32_t q, uint32_t n, bool allow_simd)
     : NTTEngine(q, n), color_zetas_(n), color_zetas_inv_(n) {
 
     // Additional validation for ColorNTTEngine
@@ -35,6 +36,20 @@ ColorNTTEngine::ColorNTTEngine(uint32_t q, uint32_t n)
         color_zetas_[i] = ColorValue::from_math_value(standard_zetas[i]);
         color_zetas_inv_[i] = ColorValue::from_math_value(standard_zetas_inv[i]);
     }
+
+#ifdef HAVE_AVX2
+    if (allow_simd && ColorNTTAVX2::usable(q_, n_)) {
+        avx2_ = std::make_unique<ColorNTTAVX2>(q_, n_, standard_zetas, standard_zetas_inv, bitrev_);
+    }
+#else
+    (void)allow_simd;
+#endif
+}
+
+ColorNTTEngine::~ColorNTTEngine() = default;
+
+SIMDSupport ColorNTTEngine::get_simd_support() const {
+    return avx2_ ? SIMDSupport::AVX2 : SIMDSupport::NONE;
 }
 
 ColorValue ColorNTTEngine::color_to_crypto_space(const ColorValue& color) const {
@@ -87,6 +102,12 @@ void ColorNTTEngine::color_butterfly_inv(ColorValue& a, ColorValue& b, const Col
 }
 
 void ColorNTTEngine::ntt_forward_colors(ColorValue* poly) const {
+#ifdef HAVE_AVX2
+    if (avx2_) {
+        avx2_->ntt_forward(poly);
+        return;
+    }
+#endif
     for (uint32_t len = 2; len <= n_; len <<= 1) {
         uint32_t half = len / 2;
         uint32_t zeta_index = 0;
@@ -106,6 +127,12 @@ void ColorNTTEngine::ntt_forward_colors(ColorValue* poly) const {
 }
 
 void ColorNTTEngine::ntt_inverse_colors(ColorValue* poly) const {
+#ifdef HAVE_AVX2
+    if (avx2_) {
+        avx2_->ntt_inverse(poly);
+        return;
+    }
+#endif
     bit_reverse_colors(poly);
 
     for (uint32_t len = n_; len > 1; len >>= 1) {
@@ -127,6 +154,12 @@ void ColorNTTEngine::ntt_inverse_colors(ColorValue* poly) const {
 }
 
 void ColorNTTEngine::multiply_colors(const ColorValue* a, const ColorValue* b, ColorValue* result) const {
+#ifdef HAVE_AVX2
+    if (avx2_) {
+        avx2_->multiply(a, b, result);
+        return;
+    }
+#endif
     std::vector<ColorValue> a_ntt(n_);
     std::vector<ColorValue> b_ntt(n_);
     std::copy(a, a + n_, a_ntt.begin());
@@ -3,14 +3,18 @@
 
 #include "ntt_engine.hpp"
 #include "color_value.hpp"
+#include <memory>
 #include <vector>
 
 namespace clwe {
 
+class ColorNTTAVX2;
+
 class ColorNTTEngine : public NTTEngine {
 private:
     std::vector<ColorValue> color_zetas_;
     std::vector<ColorValue> color_zetas_inv_;
+    std::unique_ptr<ColorNTTAVX2> avx2_;  // Set when the CPU and parameters allow the AVX2 kernels
 
     ColorValue color_to_crypto_space(const ColorValue& color) const;
     ColorValue crypto_space_to_color(const ColorValue& crypto_val) const;
@@ -23,8 +27,9 @@ private:
     ColorValue color_multiply_precise(const ColorValue& a, const ColorValue& b, uint32_t modulus) const;
 
 public:
-    ColorNTTEngine(uint32_t q, uint32_t n);
-    ~ColorNTTEngine() override = default;
+    // allow_simd = false keeps the scalar transforms, e.g. to cross-check the AVX2 ones
+    ColorNTTEngine(uint32_t q, uint32_t n, bool allow_simd = true);
+    ~ColorNTTEngine() override;
 
     void ntt_forward_colors(ColorValue* poly) const;
     void ntt_inverse_colors(ColorValue* poly) const;
@@ -34,7 +39,7 @@ public:
     void ntt_inverse(uint32_t* poly) const override;
     void multiply(const uint32_t* a, const uint32_t* b, uint32_t* result) const override;
 
-    SIMDSupport get_simd_support() const override { return SIMDSupport::NONE; }
+    SIMDSupport get_simd_support() const override;
 
     void convert_uint32_to_colors(const uint32_t* coeffs, ColorValue* colors) const;
     void convert_colors_to_uint32(const ColorValue* colors, uint32_t* coeffs) const;
@@ -54,6 +54,11 @@ CPUFeatures CPUFeatureDetector::detect() {
     }
 }
 
+const CPUFeatures& CPUFeatureDetector::cached() {
+    static const CPUFeatures features = detect();
+    return features;
+}
+
 CPUArchitecture CPUFeatureDetector::detect_architecture() {
 #if defined(__x86_64__) || defined(_M_X64)
     return CPUArchitecture::X86_64;
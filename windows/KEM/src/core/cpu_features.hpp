@@ -48,6 +48,9 @@ struct CPUFeatures {
 class CPUFeatureDetector {
 public:
     static CPUFeatures detect();
+    // detect() run once per process; later calls return the same object. The AVX2 kernels
+    // dispatch on it
+    static const CPUFeatures& cached();
 
 private:
     static CPUFeatures detect_x86();
@@ -0,0 +1,156 @@
+#include "keccak_x4.hpp"
+#include "cpu_features.hpp"
+#include "simd_target.hpp"
+
+#ifdef HAVE_AVX2
+#include <immintrin.h>
+#endif
+
+namespace clwe {
+
+namespace {
+
+constexpr uint64_t ROUND_CONSTANTS[24] = {
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL,
+    0x8000000080008000ULL, 0x000000000000808bULL, 0x0000000080000001ULL,
+    0x8000000080008081ULL, 0x8000000000008009ULL, 0x000000000000008aULL,
+    0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+    0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL,
+    0x8000000000008003ULL, 0x8000000000008002ULL, 0x8000000000000080ULL,
+    0x000000000000800aULL, 0x800000008000000aULL, 0x8000000080008081ULL,
+    0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+};
+constexpr int RHO_OFFSETS[24] = {
+    1,  3,  6,  10, 15, 21, 28, 36, 45, 55, 2,  14,
+    27, 41, 56, 8,  25, 43, 62, 18, 39, 61, 20, 44
+};
+constexpr int PI_LANES[24] = {
+    10, 7,  11, 17, 18, 3, 5,  16, 8,  21, 24, 4,
+    15, 23, 19, 13, 12, 2, 20, 14, 22, 9,  6,  1
+};
+
+// Lane operations for one 64-bit state word
+struct ScalarLanes {
+    using V = uint64_t;
+    static V bxor(V a, V b) { return a ^ b; }
+    static V andnot(V a, V b) { return ~a & b; }
+    static V rotl(V a, int n) { return (a << n) | (a >> (64 - n)); }
+    static V constant(uint64_t c) { return c; }
+};
+
+#ifdef HAVE_AVX2
+// Lane operations for the same word of four states at once
+struct AVX2Lanes {
+    using V = __m256i;
+    CLWE_TARGET_AVX2 static V bxor(V a, V b) { return _mm256_xor_si256(a, b); }
+    CLWE_TARGET_AVX2 static V andnot(V a, V b) { return _mm256_andnot_si256(a, b); }
+    CLWE_TARGET_AVX2 static V rotl(V a, int n) {
+        return _mm256_or_si256(_mm256_sll_epi64(a, _mm_cvtsi32_si128(n)),
+                               _mm256_srl_epi64(a, _mm_cvtsi32_si128(64 - n)));
+    }
+    CLWE_TARGET_AVX2 static V constant(uint64_t c) { return _mm256_set1_epi64x(static_cast<long long>(c)); }
+};
+#endif
+
+// The tiny_sha3 round structure, generic over the lane type. Always inlined so the AVX2
+// instance is compiled for the target of its caller; no __m256i ever crosses a real call,
+// hence the silenced ABI note.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+template <typename L>
+CLWE_ALWAYS_INLINE void keccak_rounds(typename L::V st[25]) {
+    using V = typename L::V;
+    V bc[5];
+    for (int r = 0; r < 24; ++r) {
+        // Theta
+        for (int i = 0; i < 5; ++i) {
+            bc[i] = L::bxor(L::bxor(L::bxor(st[i], st[i + 5]), L::bxor(st[i + 10], st[i + 15])), st[i + 20]);
+        }
+        for (int i = 0; i < 5; ++i) {
+            V t = L::bxor(bc[(i + 4) % 5], L::rotl(bc[(i + 1) % 5], 1));
+            for (int j = 0; j < 25; j += 5) {
+                st[j + i] = L::bxor(st[j + i], t);
+            }
+        }
+
+        // Rho Pi
+        V t = st[1];
+        for (int i = 0; i < 24; ++i) {
+            int j = PI_LANES[i];
+            V next = st[j];
+            st[j] = L::rotl(t, RHO_OFFSETS[i]);
+            t = next;
+        }
+
+        // Chi
+        for (int j = 0; j < 25; j += 5) {
+            for (int i = 0; i < 5; ++i) {
+                bc[i] = st[j + i];
+            }
+            for (int i = 0; i < 5; ++i) {
+                st[j + i] = L::bxor(st[j + i], L::andnot(bc[(i + 1) % 5], bc[(i + 2) % 5]));
+            }
+        }
+
+        // Iota
+        st[0] = L::bxor(st[0], L::constant(ROUND_CONSTANTS[r]));
+    }
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#ifdef HAVE_AVX2
+CLWE_TARGET_AVX2 void keccakf1600_x4_avx2(uint64_t state[25][4]) {
+    __m256i st[25];
+    for (int i = 0; i < 25; ++i) {
+        st[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(state[i]));
+    }
+    keccak_rounds<AVX2Lanes>(st);
+    for (int i = 0; i < 25; ++i) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(state[i]), st[i]);
+    }
+}
+#endif
+
+bool use_avx2() {
+#ifdef HAVE_AVX2
+    static const bool supported = CPUFeatureDetector::cached().has_avx2;
+    return supported;
+#else
+    return false;
+#endif
+}
+
+} // namespace
+
+void keccakf1600_x4_scalar(uint64_t state[25][4]) {
+    for (int instance = 0; instance < 4; ++instance) {
+        uint64_t st[25];
+        for (int i = 0; i < 25; ++i) {
+            st[i] = state[i][instance];
+        }
+        keccak_rounds<ScalarLanes>(st);
+        for (int i = 0; i < 25; ++i) {
+            state[i][instance] = st[i];
+        }
+    }
+}
+
+void keccakf1600_x4(uint64_t state[25][4]) {
+#ifdef HAVE_AVX2
+    if (use_avx2()) {
+        keccakf1600_x4_avx2(state);
+        return;
+    }
+#endif
+    keccakf1600_x4_scalar(state);
+}
+
+bool keccak_x4_avx2_supported() {
+    return use_avx2();
+}
+
+} // namespace clwe
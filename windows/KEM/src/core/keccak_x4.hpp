@@ -0,0 +1,21 @@
+#ifndef KECCAK_X4_HPP
+#define KECCAK_X4_HPP
+
+#include <cstdint>
+
+namespace clwe {
+
+// Keccak-f[1600] on four independent states stored lane-major: state[lane][instance].
+// Uses AVX2 (one __m256i per lane) when built with it and the CPU reports it, else permutes
+// the four states one after another.
+void keccakf1600_x4(uint64_t state[25][4]);
+
+// Same permutation forced onto the portable path, for cross-checking the AVX2 one
+void keccakf1600_x4_scalar(uint64_t state[25][4]);
+
+// Built with HAVE_AVX2 and the CPU reports it; keccakf1600_x4 then permutes all four at once
+bool keccak_x4_avx2_supported();
+
+} // namespace clwe
+
+#endif // KECCAK_X4_HPP
@@ -0,0 +1,333 @@
+#include "../include/clwe/key_image_codec.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#ifdef CLWE_HAVE_WEBP
+#include <webp/decode.h>
+#include <webp/encode.h>
+#endif
+
+namespace clwe {
+
+namespace {
+
+constexpr uint8_t QOI_END_MARKER[QoiKeyImageCodec::END_MARKER_BYTES] = {0, 0, 0, 0, 0, 0, 0, 1};
+constexpr size_t QOI_MAX_RUN = 62;
+
+constexpr uint8_t QOI_OP_INDEX = 0x00;
+constexpr uint8_t QOI_OP_DIFF = 0x40;
+constexpr uint8_t QOI_OP_LUMA = 0x80;
+constexpr uint8_t QOI_OP_RUN = 0xC0;
+constexpr uint8_t QOI_OP_RGB = 0xFE;
+constexpr uint8_t QOI_OP_RGBA = 0xFF;
+constexpr uint8_t QOI_MASK = 0xC0;
+
+struct QoiPixel {
+    uint8_t r = 0;
+    uint8_t g = 0;
+    uint8_t b = 0;
+    uint8_t a = 255;
+
+    bool operator==(const QoiPixel& other) const {
+        return r == other.r && g == other.g && b == other.b && a == other.a;
+    }
+};
+
+// The specification starts the index zeroed, alpha included, while the previous pixel is
+// opaque black; an opaque pixel therefore never matches a slot that has not been written
+void clear_index(QoiPixel (&index)[64]) {
+    for (QoiPixel& slot : index) {
+        slot.a = 0;
+    }
+}
+
+size_t qoi_hash(const QoiPixel& px) {
+    return (px.r * 3u + px.g * 5u + px.b * 7u + px.a * 11u) % 64u;
+}
+
+void put_u32_be(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+uint32_t get_u32_be(const uint8_t* in) {
+    return (static_cast<uint32_t>(in[0]) << 24) | (static_cast<uint32_t>(in[1]) << 16) |
+           (static_cast<uint32_t>(in[2]) << 8) | in[3];
+}
+
+} // namespace
+
+bool QoiKeyImageCodec::recognizes(const uint8_t* data, size_t size) const {
+    return data != nullptr && size >= 4 && std::memcmp(data, "qoif", 4) == 0;
+}
+
+void QoiKeyImageCodec::encode_chunks(const uint8_t* rgb, size_t pixels, bool restart, std::vector<uint8_t>& out) {
+    QoiPixel index[64];
+    clear_index(index);
+    QoiPixel previous;
+    size_t run = 0;
+    for (size_t i = 0; i < pixels; ++i) {
+        QoiPixel px;
+        px.r = rgb[3 * i];
+        px.g = rgb[3 * i + 1];
+        px.b = rgb[3 * i + 2];
+
+        // A literal first pixel depends on no earlier state; later ops only see state set from here on
+        if (i == 0 && restart) {
+            index[qoi_hash(px)] = px;
+            out.insert(out.end(), {QOI_OP_RGB, px.r, px.g, px.b});
+            previous = px;
+            continue;
+        }
+        if (px == previous) {
+            if (++run == QOI_MAX_RUN || i + 1 == pixels) {
+                out.push_back(static_cast<uint8_t>(QOI_OP_RUN | (run - 1)));
+                run = 0;
+            }
+            continue;
+        }
+        if (run > 0) {
+            out.push_back(static_cast<uint8_t>(QOI_OP_RUN | (run - 1)));
+            run = 0;
+        }
+
+        const size_t slot = qoi_hash(px);
+        if (index[slot] == px) {
+            out.push_back(static_cast<uint8_t>(QOI_OP_INDEX | slot));
+        } else {
+            index[slot] = px;
+            // Channel differences wrap, as the specification requires
+            const int dr = static_cast<int8_t>(static_cast<uint8_t>(px.r - previous.r));
+            const int dg = static_cast<int8_t>(static_cast<uint8_t>(px.g - previous.g));
+            const int db = static_cast<int8_t>(static_cast<uint8_t>(px.b - previous.b));
+            const int dr_dg = dr - dg;
+            const int db_dg = db - dg;
+            if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                out.push_back(static_cast<uint8_t>(QOI_OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+            } else if (dr_dg >= -8 && dr_dg <= 7 && dg >= -32 && dg <= 31 && db_dg >= -8 && db_dg <= 7) {
+                out.push_back(static_cast<uint8_t>(QOI_OP_LUMA | (dg + 32)));
+                out.push_back(static_cast<uint8_t>((dr_dg + 8) << 4 | (db_dg + 8)));
+            } else {
+                out.insert(out.end(), {QOI_OP_RGB, px.r, px.g, px.b});
+            }
+        }
+        previous = px;
+    }
+}
+
+size_t QoiKeyImageCodec::decode_chunks(const uint8_t* data, size_t size, uint8_t* rgb, size_t pixels) {
+    QoiPixel index[64];
+    clear_index(index);
+    QoiPixel px;
+    size_t pos = 0;
+    size_t run = 0;
+    for (size_t i = 0; i < pixels; ++i) {
+        if (run > 0) {
+            --run;
+        } else {
+            if (pos >= size) {
+                throw std::invalid_argument("Truncated QOI image");
+            }
+            const uint8_t op = data[pos++];
+            if (op == QOI_OP_RGB || op == QOI_OP_RGBA) {
+                const size_t bytes = op == QOI_OP_RGB ? 3 : 4;
+                if (size - pos < bytes) {
+                    throw std::invalid_argument("Truncated QOI image");
+                }
+                px.r = data[pos];
+                px.g = data[pos + 1];
+                px.b = data[pos + 2];
+                if (op == QOI_OP_RGBA) {
+                    px.a = data[pos + 3];
+                }
+                pos += bytes;
+            } else if ((op & QOI_MASK) == QOI_OP_INDEX) {
+                px = index[op];
+            } else if ((op & QOI_MASK) == QOI_OP_DIFF) {
+                px.r = static_cast<uint8_t>(px.r + ((op >> 4) & 3) - 2);
+                px.g = static_cast<uint8_t>(px.g + ((op >> 2) & 3) - 2);
+                px.b = static_cast<uint8_t>(px.b + (op & 3) - 2);
+            } else if ((op & QOI_MASK) == QOI_OP_LUMA) {
+                if (pos >= size) {
+                    throw std::invalid_argument("Truncated QOI image");
+                }
+                const uint8_t second = data[pos++];
+                const int dg = (op & 0x3F) - 32;
+                px.r = static_cast<uint8_t>(px.r + dg - 8 + (second >> 4));
+                px.g = static_cast<uint8_t>(px.g + dg);
+                px.b = static_cast<uint8_t>(px.b + dg - 8 + (second & 0x0F));
+            } else {
+                run = op & 0x3F;
+            }
+            index[qoi_hash(px)] = px;
+        }
+        rgb[3 * i] = px.r;
+        rgb[3 * i + 1] = px.g;
+        rgb[3 * i + 2] = px.b;
+    }
+    if (run > 0) {
+        throw std::invalid_argument("QOI run extends past the image");
+    }
+    return pos;
+}
+
+std::vector<uint8_t> QoiKeyImageCodec::encode(const uint8_t* rgb, size_t width, size_t height) const {
+    if (rgb == nullptr || width == 0 || height == 0 || width > 0xFFFFFFFFu || height > MAX_PIXELS / width) {
+        throw std::invalid_argument("Invalid QOI image dimensions: " + std::to_string(width) + "x" +
+                                    std::to_string(height));
+    }
+    const size_t pixels = width * height;
+
+    // Worst case is one QOI_OP_RGB of 4 bytes per pixel
+    std::vector<uint8_t> out;
+    out.reserve(HEADER_BYTES + pixels * 4 + END_MARKER_BYTES);
+    write_header(width, height, out);
+    encode_chunks(rgb, pixels, false, out);
+    out.insert(out.end(), QOI_END_MARKER, QOI_END_MARKER + END_MARKER_BYTES);
+    return out;
+}
+
+void QoiKeyImageCodec::write_header(size_t width, size_t height, std::vector<uint8_t>& out) {
+    out.insert(out.end(), {'q', 'o', 'i', 'f'});
+    put_u32_be(out, static_cast<uint32_t>(width));
+    put_u32_be(out, static_cast<uint32_t>(height));
+    out.push_back(3);  // Channels
+    out.push_back(0);  // sRGB with linear alpha
+}
+
+void QoiKeyImageCodec::decode(const uint8_t* data, size_t size, std::vector<uint8_t>& rgb, size_t& width,
+                              size_t& height) const {
+    if (!recognizes(data, size) || size < HEADER_BYTES + END_MARKER_BYTES) {
+        throw std::invalid_argument("Key image is not a QOI image");
+    }
+    const size_t w = get_u32_be(data + 4);
+    const size_t h = get_u32_be(data + 8);
+    const uint8_t channels = data[12];
+    if (w == 0 || h == 0 || h > MAX_PIXELS / w || (channels != 3 && channels != 4) || data[13] > 1) {
+        throw std::invalid_argument("Invalid QOI header");
+    }
+    const size_t pixels = w * h;
+    const size_t end = size - END_MARKER_BYTES;
+    if (pixels / QOI_MAX_RUN > end - HEADER_BYTES) {
+        throw std::invalid_argument("QOI image is too short for its " + std::to_string(w) + "x" +
+                                    std::to_string(h) + " pixels");
+    }
+
+    if (rgb.size() < pixels * 3) {
+        rgb.resize(pixels * 3);
+    }
+    decode_chunks(data + HEADER_BYTES, end - HEADER_BYTES, rgb.data(), pixels);
+    if (std::memcmp(data + end, QOI_END_MARKER, END_MARKER_BYTES) != 0) {
+        throw std::invalid_argument("QOI image has no end marker");
+    }
+    width = w;
+    height = h;
+}
+
+#ifdef CLWE_HAVE_WEBP
+bool WebPKeyImageCodec::recognizes(const uint8_t* data, size_t size) const {
+    return data != nullptr && size >= 12 && std::memcmp(data, "RIFF", 4) == 0 && std::memcmp(data + 8, "WEBP", 4) == 0;
+}
+
+std::vector<uint8_t> WebPKeyImageCodec::encode(const uint8_t* rgb, size_t width, size_t height) const {
+    if (rgb == nullptr || width == 0 || height == 0 || width > WEBP_MAX_DIMENSION || height > WEBP_MAX_DIMENSION) {
+        throw std::invalid_argument("Invalid WebP image dimensions: " + std::to_string(width) + "x" +
+                                    std::to_string(height));
+    }
+
+    // Quality 70 with the default preset is what WebPEncodeLosslessRGB uses
+    WebPConfig config;
+    if (!WebPConfigPreset(&config, WEBP_PRESET_DEFAULT, 70.0f)) {
+        throw std::runtime_error("WebP library version mismatch");
+    }
+    config.lossless = 1;
+    if (settings_.level >= 0 && !WebPConfigLosslessPreset(&config, settings_.level)) {
+        throw std::invalid_argument("Invalid WebP lossless level: " + std::to_string(settings_.level));
+    }
+    if (settings_.method >= 0) {
+        config.method = settings_.method;
+    }
+    if (settings_.quality >= 0) {
+        config.quality = settings_.quality;
+    }
+    if (!WebPValidateConfig(&config)) {
+        throw std::invalid_argument("Invalid WebP settings");
+    }
+
+    WebPPicture picture;
+    if (!WebPPictureInit(&picture)) {
+        throw std::runtime_error("WebP library version mismatch");
+    }
+    picture.use_argb = 1;
+    picture.width = static_cast<int>(width);
+    picture.height = static_cast<int>(height);
+    if (!WebPPictureImportRGB(&picture, rgb, static_cast<int>(width * 3))) {
+        WebPPictureFree(&picture);
+        throw std::runtime_error("Failed to import RGB data for WebP");
+    }
+
+    WebPMemoryWriter writer;
+    WebPMemoryWriterInit(&writer);
+    picture.writer = WebPMemoryWrite;
+    picture.custom_ptr = &writer;
+    bool encoded = WebPEncode(&config, &picture) != 0;
+    WebPPictureFree(&picture);
+    if (!encoded) {
+        WebPMemoryWriterClear(&writer);
+        throw std::runtime_error("Failed to encode WebP data");
+    }
+    std::vector<uint8_t> out(writer.mem, writer.mem + writer.size);
+    WebPMemoryWriterClear(&writer);
+    return out;
+}
+
+void WebPKeyImageCodec::decode(const uint8_t* data, size_t size, std::vector<uint8_t>& rgb, size_t& width,
+                               size_t& height) const {
+    int w = 0;
+    int h = 0;
+    if (data == nullptr || !WebPGetInfo(data, size, &w, &h)) {
+        throw std::invalid_argument("Key image is not a WebP image");
+    }
+
+    // WebP limits both dimensions to 16383, so this cannot overflow
+    const size_t stride = static_cast<size_t>(w) * 3;
+    const size_t pixel_bytes = stride * static_cast<size_t>(h);
+    if (rgb.size() < pixel_bytes) {
+        rgb.resize(pixel_bytes);
+    }
+    if (WebPDecodeRGBInto(data, size, rgb.data(), pixel_bytes, static_cast<int>(stride)) == nullptr) {
+        throw std::invalid_argument("Failed to decode key image");
+    }
+    width = static_cast<size_t>(w);
+    height = static_cast<size_t>(h);
+}
+#endif
+
+const KeyImageCodec* find_key_image_codec(const char* name) {
+    static const QoiKeyImageCodec qoi;
+    if (name != nullptr && std::strcmp(name, qoi.name()) == 0) {
+        return &qoi;
+    }
+#ifdef CLWE_HAVE_WEBP
+    static const WebPKeyImageCodec webp;
+    if (name != nullptr && std::strcmp(name, webp.name()) == 0) {
+        return &webp;
+    }
+#endif
+    return nullptr;
+}
+
+const KeyImageCodec* detect_key_image_codec(const uint8_t* data, size_t size) {
+    for (const char* name : {"qoi", "webp"}) {
+        const KeyImageCodec* codec = find_key_image_codec(name);
+        if (codec != nullptr && codec->recognizes(data, size)) {
+            return codec;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace clwe
@@ -34,9 +34,9 @@ TimingStats PerformanceMetrics::time_operation_with_memory(
     size_t total_memory = 0;
 
     for (int i = 0; i < iterations; ++i) {
-        auto start = std::chrono::high_resolution_clock::now();
+        auto start = std::chrono::steady_clock::now();
         operation();
-        auto end = std::chrono::high_resolution_clock::now();
+        auto end = std::chrono::steady_clock::now();
 
         auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
         times.push_back(static_cast<double>(duration.count()));
@@ -93,9 +93,9 @@ TimingStats PerformanceMetrics::time_operation(
     std::vector<double> times;
 
     for (int i = 0; i < iterations; ++i) {
-        auto start = std::chrono::high_resolution_clock::now();
+        auto start = std::chrono::steady_clock::now();
         operation();
-        auto end = std::chrono::high_resolution_clock::now();
+        auto end = std::chrono::steady_clock::now();
 
         auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
         times.push_back(static_cast<double>(duration.count()));
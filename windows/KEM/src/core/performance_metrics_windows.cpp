@@ -2,23 +2,30 @@
 #include "performance_metrics.hpp"
 #include <windows.h>
 #include <psapi.h>
-#include <intrin.h>
 
 namespace clwe {
 
-// Windows-specific memory measurement using PSAPI
+// Windows memory measurement using PSAPI: PrivateUsage (commit charge) as the current
+// figure, the working-set high-water mark as the peak
 MemoryStats PerformanceMetrics::get_memory_usage_impl() {
-    PROCESS_MEMORY_COUNTERS pmc;
-    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
-        return {pmc.WorkingSetSize, pmc.PeakWorkingSetSize, pmc.WorkingSetSize};
+    PROCESS_MEMORY_COUNTERS_EX pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&pmc),
+                             sizeof(pmc))) {
+        return {pmc.PrivateUsage, pmc.PeakWorkingSetSize, pmc.PrivateUsage};
     }
 
     return {0, 0, 0};
 }
 
-// Windows-specific CPU cycle counting
+// Cycles charged to the calling thread; unlike a raw rdtsc delta this excludes time
+// the thread spent preempted
 uint64_t PerformanceMetrics::get_cpu_cycles_impl() {
-    return __rdtsc();
+    ULONG64 cycles = 0;
+    if (QueryThreadCycleTime(GetCurrentThread(), &cycles)) {
+        return static_cast<uint64_t>(cycles);
+    }
+
+    return 0;
 }
 
 } // namespace clwe
\ No newline at end of file
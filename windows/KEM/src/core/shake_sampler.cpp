@@ -1,9 +1,11 @@
 #include "shake_sampler.hpp"
+#include "keccak_x4.hpp"
 #include "utils.hpp"
 #include <cstring>
 #include <algorithm>
 #include <random>
 #include <stdexcept>
+#include <string>
 #ifndef _MSC_VER
 #include <openssl/evp.h>
 #endif
@@ -196,4 +198,30 @@ void SHAKE128Sampler::squeeze(uint8_t* out, size_t len) {
 #endif
 }
 
+void SHAKE128x4Sampler::init_x4(const uint8_t* const seeds[4], size_t seed_len) {
+    if (seed_len >= SHAKE128_RATE) {
+        throw std::invalid_argument("Batched SHAKE-128 seed length must be below " + std::to_string(SHAKE128_RATE));
+    }
+    std::memset(state_, 0, sizeof(state_));
+    for (size_t lane = 0; lane < 4; ++lane) {
+        for (size_t i = 0; i < seed_len; ++i) {
+            state_[i / 8][lane] ^= static_cast<uint64_t>(seeds[lane][i]) << (8 * (i % 8));
+        }
+        state_[seed_len / 8][lane] ^= static_cast<uint64_t>(0x1F) << (8 * (seed_len % 8));
+        state_[(SHAKE128_RATE - 1) / 8][lane] ^= static_cast<uint64_t>(0x80) << (8 * ((SHAKE128_RATE - 1) % 8));
+    }
+}
+
+void SHAKE128x4Sampler::squeeze_blocks_x4(uint8_t* const out[4], size_t nblocks) {
+    for (size_t block = 0; block < nblocks; ++block) {
+        keccakf1600_x4(state_);
+        for (size_t lane = 0; lane < 4; ++lane) {
+            uint8_t* dst = out[lane] + block * SHAKE128_RATE;
+            for (size_t i = 0; i < SHAKE128_RATE; ++i) {
+                dst[i] = static_cast<uint8_t>(state_[i / 8][lane] >> (8 * (i % 8)));
+            }
+        }
+    }
+}
+
 } // namespace clwe
\ No newline at end of file
@@ -12,6 +12,8 @@
 
 namespace clwe {
 
+constexpr size_t SHAKE128_RATE = 168;  // Bytes per SHAKE-128 output block
+
 // SHAKE-128 based sampler for matrix generation
 class SHAKE128Sampler {
 private:
@@ -35,6 +37,20 @@ public:
     void squeeze(uint8_t* out, size_t len);
 };
 
+// Four SHAKE-128 instances run in lockstep on keccakf1600_x4; each lane's output equals
+// SHAKE128Sampler fed the same seed
+class SHAKE128x4Sampler {
+private:
+    uint64_t state_[25][4];
+
+public:
+    // Absorb four equal-length seeds (seed_len < SHAKE128_RATE) and apply the padding
+    void init_x4(const uint8_t* const seeds[4], size_t seed_len);
+
+    // Squeeze nblocks rate-sized blocks per lane; out[i] receives nblocks * SHAKE128_RATE bytes
+    void squeeze_blocks_x4(uint8_t* const out[4], size_t nblocks);
+};
+
 // SHAKE-256 based sampler for Kyber/ML-KEM
 class SHAKE256Sampler {
 private:
@@ -0,0 +1,23 @@
+#ifndef SIMD_TARGET_HPP
+#define SIMD_TARGET_HPP
+
+// Per-function instruction set selection for x86 kernels.
+//
+// The library is compiled for the baseline ISA; HAVE_AVX2 only says the compiler can emit
+// AVX2. Each kernel that uses it is tagged with CLWE_TARGET_AVX2 and is only reached after
+// a CPUFeatureDetector::cached() check, so one binary runs on any x86-64 host.
+// MSVC accepts the intrinsics in any function without /arch:AVX2, so the tags are empty there.
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CLWE_TARGET_AVX2 __attribute__((target("avx2,fma")))
+// Lets generic code be inlined into, and compiled for, a tagged caller
+#define CLWE_ALWAYS_INLINE inline __attribute__((always_inline))
+#elif defined(_MSC_VER)
+#define CLWE_TARGET_AVX2
+#define CLWE_ALWAYS_INLINE __forceinline
+#else
+#define CLWE_TARGET_AVX2
+#define CLWE_ALWAYS_INLINE inline
+#endif
+
+#endif // SIMD_TARGET_HPP
@@ -152,10 +152,7 @@ void AVXVector<T>::pop_back() {
 template class AVXVector<uint32_t>;
 template class AVXVector<avx_type>;
 template class AVXVector<double>;
-template class AVXVector<int>;
-#ifdef HAVE_AVX2
-template class AVXVector<__m256i>;
-#endif
+template class AVXVector<int>;  // avx_type is __m256i under HAVE_AVX2
 
 // Utility functions
 uint64_t get_timestamp_ns() {
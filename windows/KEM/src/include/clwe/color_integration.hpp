@@ -2,6 +2,7 @@
 #define CLWE_COLOR_INTEGRATION_HPP
 
 #include <vector>
+#include <cstddef>
 #include <cstdint>
 #include "color_value.hpp"
 
@@ -64,11 +65,111 @@ std::vector<uint8_t> encode_polynomial_vector_as_colors_compressed(const std::ve
 std::vector<std::vector<ColorValue>> decode_colors_to_polynomial_vector_compressed(const std::vector<uint8_t>& color_data, uint32_t k, uint32_t n, uint32_t modulus);
 std::vector<uint8_t> convert_compressed_to_color_format(const std::vector<uint8_t>& compressed_data, uint32_t k, uint32_t n, uint32_t modulus);
 std::vector<uint8_t> encode_polynomial_vector_as_colors_auto(const std::vector<std::vector<ColorValue>>& poly_vector, uint32_t modulus);
+/**
+ * @brief Entropy-code secret or noise polynomials for storage
+ *
+ * Centered coefficients go through a static canonical Huffman table for CBD(2)
+ * or CBD(3), chosen by whether every coefficient is within +/-2; others are
+ * escaped as raw 32-bit values. CBD(2) secrets take about 2.2 bits per
+ * coefficient, against 8 to 16 for the compressed format.
+ *
+ * Format: 0x01 0x05, k, n (16-bit big-endian), eta, then the MSB-first codes
+ * padded with zero bits to a whole byte.
+ */
 std::vector<uint8_t> encode_polynomial_vector_as_colors_huffman(const std::vector<std::vector<ColorValue>>& poly_vector, uint32_t modulus);
+
+/**
+ * @brief Decode data from encode_polynomial_vector_as_colors_huffman
+ *
+ * @throws std::invalid_argument If the header, dimensions or table do not match,
+ *         or the data ends early
+ */
+std::vector<std::vector<ColorValue>> decode_colors_to_polynomial_vector_huffman(const std::vector<uint8_t>& color_data, uint32_t k, uint32_t n, uint32_t modulus);
+
+/**
+ * @brief Pack polynomials densely across RGB channels
+ *
+ * Coefficients, reduced mod modulus, are stored back to back at the bit width of
+ * modulus - 1, most significant bit first. At 12 bits (modulus 3329) two
+ * coefficients fill one RGB pixel, an eighth of encode_polynomial_vector_as_colors.
+ * The bytes can go into an RGB image as they are: the header and the zero-padded
+ * stream both fill whole pixels.
+ *
+ * Format: 0x01 0x06, k, n (16-bit big-endian), coefficient bits, packed stream.
+ */
+std::vector<uint8_t> encode_polynomial_vector_as_colors_dense(const std::vector<std::vector<ColorValue>>& poly_vector, uint32_t modulus);
+
+/**
+ * @brief Decode data from encode_polynomial_vector_as_colors_dense
+ *
+ * @throws std::invalid_argument If the header or dimensions do not match, or the data ends early
+ */
+std::vector<std::vector<ColorValue>> decode_colors_to_polynomial_vector_dense(const std::vector<uint8_t>& color_data, uint32_t k, uint32_t n, uint32_t modulus);
 std::vector<uint8_t> generate_color_representation_from_compressed(const std::vector<uint8_t>& compressed_data, uint32_t k, uint32_t n, uint32_t modulus);
 std::vector<uint8_t> compress_with_color_support(const std::vector<std::vector<ColorValue>>& poly_vector, uint32_t modulus, bool enable_color_metadata = true);
 std::vector<std::vector<ColorValue>> decompress_with_color_support(const std::vector<uint8_t>& dual_format_data, uint32_t& out_k, uint32_t& out_n, uint32_t& out_modulus);
 std::vector<uint8_t> generate_color_from_dual_format(const std::vector<uint8_t>& dual_format_data);
+
+/**
+ * @brief Lazy RGB rendering of dual-format data
+ *
+ * Renders ranges of the image generate_color_from_dual_format() returns (4 RGB
+ * pixels per coefficient) straight from the container, without decoding the
+ * polynomial vector or building the padded image. Construction validates the
+ * payload and keeps the byte offset of every 64th coefficient, 4 bytes per 64
+ * coefficients, so a range is reached by skipping at most 63 codes.
+ *
+ * The view reads the caller's buffer, which must outlive it and stay unchanged.
+ */
+class DualFormatColorView {
+public:
+    /**
+     * @throws std::invalid_argument If the data is not a well-formed dual-format container
+     */
+    explicit DualFormatColorView(const std::vector<uint8_t>& dual_format_data);
+
+    uint32_t k() const { return k_; }
+    uint32_t n() const { return n_; }
+    uint32_t modulus() const { return modulus_; }
+
+    // Pixels in the full image: 4 per coefficient
+    size_t pixel_count() const { return 4 * static_cast<size_t>(k_) * n_; }
+
+    /**
+     * @brief Write pixels [first_pixel, first_pixel + count) as RGB bytes to rgb_out
+     *
+     * @param rgb_out Room for 3 * count bytes
+     * @throws std::invalid_argument If the range goes past pixel_count()
+     */
+    void render_pixels(size_t first_pixel, size_t count, uint8_t* rgb_out) const;
+    std::vector<uint8_t> render_pixels(size_t first_pixel, size_t count) const;
+
+    /**
+     * @brief Render a tile of the pixel stream laid out in rows of image_width pixels
+     *
+     * Pixels past pixel_count(), as in the padding of a square image, are black.
+     *
+     * @param rgb_out Room for 3 * tile_width * tile_height bytes, written row by row
+     * @throws std::invalid_argument If the tile does not fit within image_width
+     */
+    void render_tile(size_t image_width, size_t x, size_t y, size_t tile_width, size_t tile_height, uint8_t* rgb_out) const;
+
+private:
+    // Payload offset of a coefficient
+    size_t seek(size_t index) const;
+    // Coefficient at offset, reduced like decode_colors_to_polynomial_vector_compressed
+    // in compressed payloads and as stored in standard ones; offset moves to the next
+    uint32_t read(size_t& offset) const;
+    void render_unchecked(size_t first_pixel, size_t count, uint8_t* rgb_out) const;
+
+    const uint8_t* payload_;
+    uint32_t k_;
+    uint32_t n_;
+    uint32_t modulus_;
+    bool compressed_;
+    std::vector<uint32_t> checkpoints_;
+};
+
 std::vector<uint8_t> encode_polynomial_vector_with_color_integration(const std::vector<std::vector<ColorValue>>& poly_vector, uint32_t modulus, bool enable_on_demand_color = true);
 std::vector<std::vector<ColorValue>> decode_polynomial_vector_with_color_integration(const std::vector<uint8_t>& color_integrated_data, uint32_t modulus);
 
@@ -0,0 +1,149 @@
+#ifndef CLWE_KEY_ATLAS_HPP
+#define CLWE_KEY_ATLAS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "color_kem.hpp"
+
+namespace clwe {
+
+/**
+ * @brief One key of a key atlas, as listed in its index sidecar
+ *
+ * A tile is a band of whole atlas rows holding the same pixels a single key
+ * image would: the key size as 4 big-endian bytes, the key, black padding.
+ */
+struct KeyAtlasEntry {
+    std::string label;            /**< Caller-chosen name, e.g. "public_key_000042"; no whitespace */
+    uint32_t security_level = 0;  /**< Parameters of the key, as for CLWEParameters(security_level) */
+    size_t first_row = 0;         /**< First atlas row of the tile */
+    size_t rows = 0;              /**< Rows of the tile */
+    uint64_t byte_offset = 0;     /**< Offset of the tile's encoded bytes in the atlas file */
+    uint64_t byte_length = 0;     /**< Length of the tile's encoded bytes */
+    size_t key_bytes = 0;         /**< Size of the serialized key */
+};
+
+/**
+ * @brief Index sidecar of a key atlas
+ *
+ * Text, one tile per line after a short header, so it can be grepped and diffed:
+ * @code
+ * clwe-key-atlas 1
+ * codec qoi
+ * width 256
+ * height 1536
+ * tiles 2
+ * public_key_000000 512 0 2 14 2052 800
+ * ...
+ * @endcode
+ * Tile lines are label, security_level, first_row, rows, byte_offset,
+ * byte_length and key_bytes.
+ */
+struct KeyAtlasIndex {
+    size_t width = 0;
+    size_t height = 0;
+    std::vector<KeyAtlasEntry> entries;
+
+    void write(std::ostream& out) const;
+
+    /** @throws std::invalid_argument If the index is malformed or not version 1 */
+    static KeyAtlasIndex read(std::istream& in);
+
+    /** @brief Entry with the given label, or nullptr */
+    const KeyAtlasEntry* find(const std::string& label) const;
+};
+
+/**
+ * @brief Tiles many keys into one QOI image plus an index sidecar
+ *
+ * Millions of one-key images are slow on every filesystem and object store;
+ * an atlas is two files per few ten thousand keys. The image is a standard QOI
+ * file that any viewer opens, but each tile's encoding restarts (see
+ * QoiKeyImageCodec::encode_chunks), so one key is read by fetching and decoding
+ * only its byte range, e.g. one pread or an HTTP range request.
+ *
+ * The image stream must be seekable: finish() writes the final height back
+ * into the header. Tiles may be encoded on other threads with encode_tile()
+ * and added in any order.
+ */
+class KeyAtlasWriter {
+public:
+    static constexpr size_t DEFAULT_WIDTH = 256;
+
+    /** @brief A key packed and encoded for an atlas of a given width */
+    struct Tile {
+        size_t rows = 0;
+        size_t key_bytes = 0;
+        std::vector<uint8_t> data;
+    };
+
+    /** @throws std::invalid_argument If width is 0 or above 65536 */
+    explicit KeyAtlasWriter(std::ostream& image, size_t width = DEFAULT_WIDTH);
+
+    /** @throws std::invalid_argument If width is 0 or the key is empty or above 4 GiB */
+    static Tile encode_tile(const uint8_t* key, size_t size, size_t width);
+
+    /**
+     * @brief Append a tile made by encode_tile() for this atlas width
+     * @throws std::invalid_argument If the label is empty or contains whitespace
+     * @throws std::runtime_error If the atlas would exceed the QOI pixel limit or writing fails
+     */
+    void add(const std::string& label, uint32_t security_level, const Tile& tile);
+
+    /** @brief Encode and append one serialized key */
+    void add(const std::string& label, uint32_t security_level, const std::vector<uint8_t>& key);
+
+    /** @brief Whether another rows rows still fit under the QOI pixel limit */
+    bool fits(size_t rows) const;
+
+    /**
+     * @brief Complete the image and return its index; no tiles may follow
+     * @throws std::runtime_error If the atlas is empty or writing fails
+     */
+    const KeyAtlasIndex& finish();
+
+    const KeyAtlasIndex& index() const { return index_; }
+
+private:
+    std::ostream& image_;
+    std::streampos start_;
+    uint64_t offset_;
+    KeyAtlasIndex index_;
+    bool finished_ = false;
+};
+
+/**
+ * @brief Random access to the keys of an atlas
+ *
+ * Keeps its pixel buffer between calls, like KeyImageDecoder.
+ */
+class KeyAtlasReader {
+public:
+    /**
+     * @brief Serialized key of one tile, from that tile's bytes alone
+     *
+     * @param tile The byte_length bytes at byte_offset of the atlas file
+     * @throws std::invalid_argument If tile does not decode to the entry's key
+     */
+    std::vector<uint8_t> read_key(const uint8_t* tile, size_t size, const KeyAtlasIndex& index,
+                                  const KeyAtlasEntry& entry);
+
+    /** @brief Same, reading only the tile's byte range from the atlas file */
+    std::vector<uint8_t> read_key(const std::string& atlas_path, const KeyAtlasIndex& index,
+                                  const KeyAtlasEntry& entry);
+
+    /** @brief Public key of a tile, with the entry's security level */
+    ColorPublicKey load_public_key(const std::string& atlas_path, const KeyAtlasIndex& index,
+                                   const KeyAtlasEntry& entry);
+
+private:
+    std::vector<uint8_t> rgb_;
+};
+
+} // namespace clwe
+
+#endif // CLWE_KEY_ATLAS_HPP
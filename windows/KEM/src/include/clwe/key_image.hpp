@@ -0,0 +1,53 @@
+#ifndef CLWE_KEY_IMAGE_HPP
+#define CLWE_KEY_IMAGE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "color_kem.hpp"
+
+namespace clwe {
+
+/**
+ * @brief Decoder for the key images written by generate_key_images
+ *
+ * The pixels of a key image, row by row as RGB bytes, hold the size of the
+ * serialized key (4 bytes, big-endian) followed by the serialized key.
+ *
+ * The format (QOI, or lossless WebP when the library is built with WebP) is
+ * detected from the file signature; see KeyImageCodec.
+ *
+ * A decoder keeps its pixel buffer between images: the codec decodes straight
+ * into it and the key is parsed in place, so the only copies are into the key
+ * itself, and a buffer reallocation happens only for an image larger than any before.
+ */
+class KeyImageDecoder {
+public:
+    /**
+     * @brief Decode a key image and parse the public key it holds
+     *
+     * @param image Contents of a key image file
+     * @param size Size of the file in bytes
+     * @param params Parameters of the key
+     * @return The public key, as ColorPublicKey::deserialize() returns it
+     *
+     * @throws std::invalid_argument If the image does not decode, its size header
+     *         runs past the pixels, or the key data is malformed
+     */
+    ColorPublicKey load_public_key(const uint8_t* image, size_t size, const CLWEParameters& params);
+
+private:
+    std::vector<uint8_t> rgb_;
+};
+
+/**
+ * @brief Load a public key from a key image, reusing a per-thread KeyImageDecoder
+ *
+ * @throws std::invalid_argument As KeyImageDecoder::load_public_key()
+ */
+ColorPublicKey load_public_key_from_image(const uint8_t* image, size_t size, const CLWEParameters& params);
+ColorPublicKey load_public_key_from_image(const std::vector<uint8_t>& image, const CLWEParameters& params);
+
+} // namespace clwe
+
+#endif // CLWE_KEY_IMAGE_HPP
@@ -0,0 +1,136 @@
+#ifndef CLWE_KEY_IMAGE_CODEC_HPP
+#define CLWE_KEY_IMAGE_CODEC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace clwe {
+
+/**
+ * @brief Lossless image format of the key images written by generate_key_images
+ *
+ * Key image pixels carry serialized key bytes, which are close to random, so no
+ * format compresses them much: what matters in bulk generation is encoder speed.
+ * Lossless WebP spends most of a keypair's time in its entropy search; QOI
+ * (the "Quite OK Image" format) is a single pass over the pixels and keeps
+ * generation bound by keygen, at the cost of files about a third larger than
+ * the pixels (random bytes mostly take its 4-byte literal op).
+ *
+ * Implementations are stateless and may be shared between threads.
+ */
+class KeyImageCodec {
+public:
+    virtual ~KeyImageCodec() = default;
+
+    /** @brief Short name, as given to generate_key_images --format */
+    virtual const char* name() const = 0;
+
+    /** @brief File extension including the dot, e.g. ".qoi" */
+    virtual const char* file_extension() const = 0;
+
+    /** @brief Whether data starts with this format's signature */
+    virtual bool recognizes(const uint8_t* data, size_t size) const = 0;
+
+    /**
+     * @brief Encode RGB pixels, 3 bytes each, row by row
+     *
+     * @throws std::invalid_argument If the dimensions are zero or too large for the format
+     * @throws std::runtime_error If the encoder fails
+     */
+    virtual std::vector<uint8_t> encode(const uint8_t* rgb, size_t width, size_t height) const = 0;
+
+    /**
+     * @brief Decode an image into RGB pixels
+     *
+     * rgb is only grown, never shrunk, so a caller decoding many images keeps one
+     * buffer; the pixels are its first width * height * 3 bytes.
+     *
+     * @throws std::invalid_argument If the data is not a valid image of this format
+     */
+    virtual void decode(const uint8_t* data, size_t size, std::vector<uint8_t>& rgb, size_t& width,
+                        size_t& height) const = 0;
+};
+
+/**
+ * @brief QOI encoder and decoder for 3-channel images
+ *
+ * Follows the QOI 1.0 specification, so files open in any QOI viewer. The
+ * decoder rejects images whose pixel count the data cannot account for (every
+ * QOI byte encodes at most 62 pixels), so a forged header cannot make it
+ * allocate more than a bounded multiple of its input.
+ */
+class QoiKeyImageCodec final : public KeyImageCodec {
+public:
+    static constexpr size_t HEADER_BYTES = 14;
+    static constexpr size_t END_MARKER_BYTES = 8;
+    static constexpr size_t MAX_PIXELS = 400000000;  /**< Limit of the specification */
+
+    const char* name() const override { return "qoi"; }
+    const char* file_extension() const override { return ".qoi"; }
+    bool recognizes(const uint8_t* data, size_t size) const override;
+    std::vector<uint8_t> encode(const uint8_t* rgb, size_t width, size_t height) const override;
+    void decode(const uint8_t* data, size_t size, std::vector<uint8_t>& rgb, size_t& width,
+                size_t& height) const override;
+
+    /** @brief The 14-byte header of a 3-channel sRGB image */
+    static void write_header(size_t width, size_t height, std::vector<uint8_t>& out);
+
+    /**
+     * @brief Append the chunks of pixels RGB pixels, from a fresh encoder state
+     *
+     * With restart set the first pixel is a literal and no op refers to state from
+     * before it, so a decoder may begin at this byte offset with a fresh state
+     * (decode_chunks) while the stream stays a valid QOI image read from the start.
+     */
+    static void encode_chunks(const uint8_t* rgb, size_t pixels, bool restart, std::vector<uint8_t>& out);
+
+    /**
+     * @brief Decode pixels pixels from chunks written from a fresh or restarted state
+     * @return Bytes of data consumed
+     * @throws std::invalid_argument If data ends first or a run overshoots the pixels
+     */
+    static size_t decode_chunks(const uint8_t* data, size_t size, uint8_t* rgb, size_t pixels);
+};
+
+/**
+ * @brief Lossless WebP through libwebp; built into the library when WebP is available
+ */
+class WebPKeyImageCodec final : public KeyImageCodec {
+public:
+    /** @brief Encoder settings; negative values keep the defaults of WebPEncodeLosslessRGB */
+    struct Settings {
+        int level = -1;       /**< Lossless preset 0 (fastest) to 9 (smallest); sets method and quality */
+        int method = -1;      /**< Compression method 0 (fastest) to 6 (slowest), after the preset */
+        float quality = -1;   /**< Lossless effort 0 to 100, after the preset */
+    };
+
+    WebPKeyImageCodec() = default;
+    explicit WebPKeyImageCodec(const Settings& settings) : settings_(settings) {}
+
+    const char* name() const override { return "webp"; }
+    const char* file_extension() const override { return ".webp"; }
+    bool recognizes(const uint8_t* data, size_t size) const override;
+    std::vector<uint8_t> encode(const uint8_t* rgb, size_t width, size_t height) const override;
+    void decode(const uint8_t* data, size_t size, std::vector<uint8_t>& rgb, size_t& width,
+                size_t& height) const override;
+
+private:
+    Settings settings_;
+};
+
+/**
+ * @brief Codec by name with default settings ("qoi", or "webp" when built with WebP)
+ * @return The codec, or nullptr for an unknown or unavailable name
+ */
+const KeyImageCodec* find_key_image_codec(const char* name);
+
+/**
+ * @brief Codec whose signature data starts with
+ * @return The codec, or nullptr if no available codec recognizes the data
+ */
+const KeyImageCodec* detect_key_image_codec(const uint8_t* data, size_t size);
+
+} // namespace clwe
+
+#endif // CLWE_KEY_IMAGE_CODEC_HPP
@@ -1,8 +1,14 @@
 #include "src/include/clwe/color_kem.hpp"
 #include "src/include/clwe/clwe.hpp"
+#include "src/include/clwe/key_atlas.hpp"
+#include "src/include/clwe/key_image.hpp"
+#include "src/include/clwe/key_image_codec.hpp"
+#include <algorithm>
 #include <iostream>
 #include <vector>
 #include <fstream>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <webp/decode.h>
 #include <webp/encode.h>
@@ -152,6 +158,93 @@ int main(int argc, char* argv[]) {
                 pub_loaded = clwe::ColorPublicKey::deserialize(pub_webp, params);
                 priv_loaded = clwe::ColorPrivateKey::deserialize(priv_webp, params);
                 std::cout << "Keys loaded from WebP successfully!" << std::endl;
+
+                // Decode the public key image straight into a key
+                std::ifstream image_in(pub_webp_file, std::ios::binary);
+                std::vector<uint8_t> image((std::istreambuf_iterator<char>(image_in)),
+                                           std::istreambuf_iterator<char>());
+                auto pub_direct = clwe::load_public_key_from_image(image, params);
+                if (pub_direct.seed != public_key.seed || pub_direct.public_data != public_key.public_data) {
+                    std::cout << "Public key loaded from image does not match!" << std::endl;
+                    return 1;
+                }
+                std::cout << "Public key loaded directly from image successfully!" << std::endl;
+
+                // The same pixels as QOI load through the same entry point
+                int width = 0;
+                int height = 0;
+                uint8_t* rgb = WebPDecodeRGB(image.data(), image.size(), &width, &height);
+                if (rgb == nullptr) {
+                    std::cout << "Failed to decode public key image!" << std::endl;
+                    return 1;
+                }
+                clwe::QoiKeyImageCodec qoi;
+                std::vector<uint8_t> qoi_image = qoi.encode(rgb, static_cast<size_t>(width), static_cast<size_t>(height));
+                std::vector<uint8_t> qoi_pixels;
+                size_t qoi_width = 0;
+                size_t qoi_height = 0;
+                qoi.decode(qoi_image.data(), qoi_image.size(), qoi_pixels, qoi_width, qoi_height);
+                bool pixels_match = qoi_width == static_cast<size_t>(width) && qoi_height == static_cast<size_t>(height) &&
+                                    std::equal(rgb, rgb + qoi_width * qoi_height * 3, qoi_pixels.begin());
+                WebPFree(rgb);
+                auto pub_qoi = clwe::load_public_key_from_image(qoi_image, params);
+                if (!pixels_match || pub_qoi.seed != public_key.seed || pub_qoi.public_data != public_key.public_data) {
+                    std::cout << "Public key loaded from QOI image does not match!" << std::endl;
+                    return 1;
+                }
+                try {
+                    qoi_image.resize(qoi_image.size() / 2);
+                    clwe::load_public_key_from_image(qoi_image, params);
+                    std::cout << "Truncated QOI image was accepted!" << std::endl;
+                    return 1;
+                } catch (const std::invalid_argument&) {
+                }
+                std::cout << "Public key loaded from QOI image successfully!" << std::endl;
+
+                // The index starts zeroed, so black after white is a DIFF op, never INDEX 53
+                const uint8_t white_black[] = {255, 255, 255, 0, 0, 0};
+                std::vector<uint8_t> two_pixels = qoi.encode(white_black, 2, 1);
+                if (two_pixels.size() != clwe::QoiKeyImageCodec::HEADER_BYTES + 2 +
+                                             clwe::QoiKeyImageCodec::END_MARKER_BYTES ||
+                    two_pixels[clwe::QoiKeyImageCodec::HEADER_BYTES] != 0x55 ||
+                    two_pixels[clwe::QoiKeyImageCodec::HEADER_BYTES + 1] != 0x7F) {
+                    std::cout << "QOI encoder used an index slot it never wrote!" << std::endl;
+                    return 1;
+                }
+
+                // An atlas of several keys, each read back from its tile's bytes alone
+                std::stringstream atlas_image(std::ios::in | std::ios::out | std::ios::binary);
+                clwe::KeyAtlasWriter atlas(atlas_image);
+                atlas.add("public_key_0", params.security_level, pub_ser);
+                atlas.add("private_key_0", params.security_level, priv_ser);
+                atlas.add("public_key_1", params.security_level, kem.keygen().first.serialize());
+                std::stringstream atlas_index_text;
+                atlas.finish().write(atlas_index_text);
+                clwe::KeyAtlasIndex atlas_index = clwe::KeyAtlasIndex::read(atlas_index_text);
+                std::string atlas_bytes = atlas_image.str();
+                std::string atlas_file = input_dir + "/key_atlas.qoi";
+                std::ofstream(atlas_file, std::ios::binary).write(atlas_bytes.data(), atlas_bytes.size());
+
+                const clwe::KeyAtlasEntry* atlas_public = atlas_index.find("public_key_0");
+                const clwe::KeyAtlasEntry* atlas_private = atlas_index.find("private_key_0");
+                if (atlas_index.entries.size() != 3 || atlas_public == nullptr || atlas_private == nullptr) {
+                    std::cout << "Key atlas index does not list its keys!" << std::endl;
+                    return 1;
+                }
+                clwe::KeyAtlasReader atlas_reader;
+                auto pub_atlas = atlas_reader.load_public_key(atlas_file, atlas_index, *atlas_public);
+                auto priv_atlas = atlas_reader.read_key(atlas_file, atlas_index, *atlas_private);
+                std::vector<uint8_t> atlas_pixels;
+                size_t atlas_width = 0;
+                size_t atlas_height = 0;
+                qoi.decode(reinterpret_cast<const uint8_t*>(atlas_bytes.data()), atlas_bytes.size(), atlas_pixels,
+                           atlas_width, atlas_height);
+                if (pub_atlas.seed != public_key.seed || pub_atlas.public_data != public_key.public_data ||
+                    priv_atlas != priv_ser || atlas_width != atlas_index.width || atlas_height != atlas_index.height) {
+                    std::cout << "Keys loaded from key atlas do not match!" << std::endl;
+                    return 1;
+                }
+                std::cout << "Keys loaded from key atlas successfully!" << std::endl;
             } else {
                 std::cout << "WebP data does not match!" << std::endl;
                 return 1;
@@ -1,9 +1,11 @@
 #include <gtest/gtest.h>
 #include "color_ntt_engine.hpp"
+#include "color_ntt_avx2.hpp"
 #include "ntt_engine.hpp"
 #include "utils.hpp"
 #include <vector>
 #include <algorithm>
+#include <random>
 
 namespace clwe {
 
@@ -211,8 +213,54 @@ TEST_F(NTTEngineTest, InvalidParameters) {
 // Test SIMD support detection
 TEST_F(NTTEngineTest, SIMDSupport) {
     SIMDSupport support = color_ntt->get_simd_support();
-    // ColorNTTEngine currently returns NONE
-    EXPECT_EQ(support, SIMDSupport::NONE);
+    // ColorNTTEngine reports AVX2 when it dispatches to the AVX2 kernels
+    EXPECT_EQ(support, ColorNTTAVX2::usable(modulus, degree) ? SIMDSupport::AVX2 : SIMDSupport::NONE);
+
+    ColorNTTEngine scalar_ntt(modulus, degree, false);
+    EXPECT_EQ(scalar_ntt.get_simd_support(), SIMDSupport::NONE);
+}
+
+// Test that the AVX2 kernels match the scalar transforms bit for bit
+TEST_F(NTTEngineTest, SIMDMatchesScalar) {
+    if (!ColorNTTAVX2::usable(modulus, degree)) {
+        GTEST_SKIP() << "AVX2 kernels not available";
+    }
+    std::mt19937 rng(7);
+    for (uint32_t mod : {3329u, 7681u, 12289u}) {
+        for (uint32_t deg : {16u, 32u, 256u, 1024u}) {
+            ColorNTTEngine scalar_ntt(mod, deg, false);
+            ColorNTTEngine simd_ntt(mod, deg);
+            ASSERT_EQ(simd_ntt.get_simd_support(), SIMDSupport::AVX2);
+
+            std::vector<ColorValue> a(deg), b(deg);
+            for (uint32_t i = 0; i < deg; ++i) {
+                a[i] = ColorValue::from_math_value(rng() % mod);
+                b[i] = ColorValue::from_math_value(rng() % mod);
+            }
+
+            std::vector<ColorValue> expected = a, actual = a;
+            scalar_ntt.ntt_forward_colors(expected.data());
+            simd_ntt.ntt_forward_colors(actual.data());
+            EXPECT_EQ(actual, expected) << "forward, q " << mod << ", n " << deg;
+
+            expected = a;
+            actual = a;
+            scalar_ntt.ntt_inverse_colors(expected.data());
+            simd_ntt.ntt_inverse_colors(actual.data());
+            EXPECT_EQ(actual, expected) << "inverse, q " << mod << ", n " << deg;
+
+            std::vector<ColorValue> expected_product(deg), actual_product(deg);
+            scalar_ntt.multiply_colors(a.data(), b.data(), expected_product.data());
+            simd_ntt.multiply_colors(a.data(), b.data(), actual_product.data());
+            EXPECT_EQ(actual_product, expected_product) << "multiply, q " << mod << ", n " << deg;
+
+            // Products reduce unreduced colors to the same residues
+            a[0] = ColorValue(255, 0, 0);
+            scalar_ntt.multiply_colors(a.data(), b.data(), expected_product.data());
+            simd_ntt.multiply_colors(a.data(), b.data(), actual_product.data());
+            EXPECT_EQ(actual_product, expected_product) << "unreduced multiply, q " << mod << ", n " << deg;
+        }
+    }
 }
 
 // Test NTT linearity
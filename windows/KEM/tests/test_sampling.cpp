@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include "sampling.hpp"
 #include "shake_sampler.hpp"
+#include "keccak_x4.hpp"
+#include <cstring>
 #include <vector>
 #include <set>
 #include <algorithm>
@@ -27,6 +29,46 @@ protected:
     std::unique_ptr<SHAKE256Sampler> sampler;
 };
 
+// Test that each lane of the 4-way SHAKE-128 matches a sequential SHAKE-128 instance
+TEST_F(SamplingTest, SHAKE128x4MatchesSequential) {
+    uint8_t inputs[4][34];
+    for (int lane = 0; lane < 4; ++lane) {
+        for (int i = 0; i < 34; ++i) {
+            inputs[lane][i] = static_cast<uint8_t>(i * 7 + lane * 31);
+        }
+    }
+    const uint8_t* seeds[4] = {inputs[0], inputs[1], inputs[2], inputs[3]};
+    std::vector<std::vector<uint8_t>> blocks(4, std::vector<uint8_t>(3 * SHAKE128_RATE));
+    uint8_t* out[4] = {blocks[0].data(), blocks[1].data(), blocks[2].data(), blocks[3].data()};
+
+    SHAKE128x4Sampler batched;
+    batched.init_x4(seeds, sizeof(inputs[0]));
+    batched.squeeze_blocks_x4(out, 2);
+    batched.squeeze_blocks_x4(out, 1);  // Third block, written to the start of out
+
+    for (int lane = 0; lane < 4; ++lane) {
+        SHAKE128Sampler sequential;
+        sequential.init(inputs[lane], sizeof(inputs[lane]));
+        std::vector<uint8_t> expected(3 * SHAKE128_RATE);
+        sequential.squeeze(expected.data(), expected.size());
+        EXPECT_EQ(0, std::memcmp(blocks[lane].data(), expected.data() + 2 * SHAKE128_RATE, SHAKE128_RATE))
+            << "lane " << lane;
+    }
+
+    // The scalar and AVX2 permutations agree
+    uint64_t state_a[25][4], state_b[25][4];
+    for (int i = 0; i < 25; ++i) {
+        for (int lane = 0; lane < 4; ++lane) {
+            state_a[i][lane] = state_b[i][lane] = 0x0123456789abcdefULL * (i + 1) + lane;
+        }
+    }
+    keccakf1600_x4(state_a);
+    keccakf1600_x4_scalar(state_b);
+    EXPECT_EQ(0, std::memcmp(state_a, state_b, sizeof(state_a)));
+
+    EXPECT_THROW(batched.init_x4(seeds, SHAKE128_RATE), std::invalid_argument);
+}
+
 // Test SHAKE256Sampler initialization
 TEST_F(SamplingTest, SHAKE256SamplerInit) {
     std::array<uint8_t, 32> seed = {0};
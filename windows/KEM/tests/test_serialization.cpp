@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include "color_kem.hpp"
+#include "color_integration.hpp"
 #include <vector>
+#include <algorithm>
 #include <stdexcept>
 #include <chrono>
 
@@ -272,4 +274,233 @@ TEST_F(SerializationTest, MemorySafety) {
     EXPECT_NO_THROW(ColorCiphertext::deserialize(ct_ser));
 }
 
+// The compressed coefficient format is fixed: known bytes decode, and every code length
+// round-trips through both the word-at-a-time and the per-code decoder paths
+TEST_F(SerializationTest, CompressedCoefficientFormat) {
+    std::vector<std::vector<ColorValue>> poly_vector(1);
+    for (uint32_t value : {0u, 5u, 0x40u, 1000u, 3328u, 63u}) {
+        poly_vector[0].push_back(ColorValue::from_math_value(value));
+    }
+    const std::vector<uint8_t> expected = {0x01, 0x03, 0x01, 0x00, 0x06,
+                                           0x00, 0x85, 0xC0, 0x40, 0xC3, 0xE8, 0xCD, 0x00, 0xBF};
+    EXPECT_EQ(expected, encode_polynomial_vector_as_colors_compressed(poly_vector, params.modulus));
+    auto decoded = decode_colors_to_polynomial_vector_compressed(expected, 1, 6, params.modulus);
+    for (size_t j = 0; j < 6; ++j) {
+        EXPECT_EQ(poly_vector[0][j].to_math_value(), decoded[0][j].to_math_value());
+    }
+
+    // Runs of two-byte codes mixed with short ones, across polynomial boundaries
+    std::vector<std::vector<ColorValue>> keys(params.module_rank, std::vector<ColorValue>(params.degree));
+    for (uint32_t i = 0; i < params.module_rank; ++i) {
+        for (uint32_t j = 0; j < params.degree; ++j) {
+            uint32_t value = (j % 7 == 3) ? j % 64 : (i * 977 + j * 131) % params.modulus;
+            keys[i][j] = ColorValue::from_math_value(value);
+        }
+    }
+    auto encoded = encode_polynomial_vector_as_colors_compressed(keys, params.modulus);
+    auto round_trip = decode_colors_to_polynomial_vector_compressed(encoded, params.module_rank, params.degree, params.modulus);
+    for (uint32_t i = 0; i < params.module_rank; ++i) {
+        for (uint32_t j = 0; j < params.degree; ++j) {
+            ASSERT_EQ(keys[i][j].to_math_value(), round_trip[i][j].to_math_value()) << i << "," << j;
+        }
+    }
+
+    std::vector<uint8_t> truncated(expected.begin(), expected.end() - 2);
+    EXPECT_THROW(decode_colors_to_polynomial_vector_compressed(truncated, 1, 6, params.modulus), std::invalid_argument);
+    std::vector<uint8_t> invalid = expected;
+    invalid[6] = 0x01;
+    EXPECT_THROW(decode_colors_to_polynomial_vector_compressed(invalid, 1, 6, params.modulus), std::invalid_argument);
+}
+
+// Secret-sized vectors entropy-code near the binomial entropy and round-trip, including
+// coefficients outside the table's range
+TEST_F(SerializationTest, HuffmanCoefficientFormat) {
+    const uint32_t q = params.modulus;
+    std::vector<std::vector<ColorValue>> small(1);
+    for (uint32_t value : {0u, 1u, q - 1, 2u, q - 2}) {
+        small[0].push_back(ColorValue::from_math_value(value));
+    }
+    const std::vector<uint8_t> expected = {0x01, 0x05, 0x01, 0x00, 0x05, 0x02, 0x63, 0x70};
+    EXPECT_EQ(expected, encode_polynomial_vector_as_colors_huffman(small, q));
+
+    uint32_t state = 12345;
+    for (uint32_t eta : {2u, 3u}) {
+        std::vector<std::vector<ColorValue>> noise(params.module_rank, std::vector<ColorValue>(params.degree));
+        for (auto& poly : noise) {
+            for (auto& coeff : poly) {
+                int32_t centered = 0;
+                for (uint32_t b = 0; b < eta; ++b) {
+                    state = state * 1103515245u + 12345u;
+                    centered += static_cast<int32_t>((state >> 16) & 1) - static_cast<int32_t>((state >> 17) & 1);
+                }
+                coeff = ColorValue::from_math_value(centered < 0 ? q + centered : centered);
+            }
+        }
+        if (eta == 3) {
+            noise[0][0] = ColorValue::from_math_value(1000);
+            noise[1][params.degree - 1] = ColorValue::from_math_value(q - 4);
+        }
+
+        auto encoded = encode_polynomial_vector_as_colors_huffman(noise, q);
+        EXPECT_EQ(eta, encoded[5]);
+        EXPECT_LT(encoded.size(), 6 + params.module_rank * params.degree * 3 / 8);
+        EXPECT_LT(encoded.size(), encode_polynomial_vector_as_colors_compressed(noise, q).size() / 3);
+
+        auto decoded = decode_colors_to_polynomial_vector_huffman(encoded, params.module_rank, params.degree, q);
+        for (uint32_t i = 0; i < params.module_rank; ++i) {
+            for (uint32_t j = 0; j < params.degree; ++j) {
+                ASSERT_EQ(noise[i][j].to_math_value(), decoded[i][j].to_math_value()) << eta << ":" << i << "," << j;
+            }
+        }
+    }
+
+    EXPECT_THROW(decode_colors_to_polynomial_vector_huffman(expected, 1, 6, q), std::invalid_argument);
+    std::vector<uint8_t> truncated(expected.begin(), expected.end() - 1);
+    EXPECT_THROW(decode_colors_to_polynomial_vector_huffman(truncated, 1, 5, q), std::invalid_argument);
+    std::vector<uint8_t> unknown_table = expected;
+    unknown_table[5] = 0x04;
+    EXPECT_THROW(decode_colors_to_polynomial_vector_huffman(unknown_table, 1, 5, q), std::invalid_argument);
+}
+
+// The single-pass auto encoder picks the same format as counting first would, including
+// when the data changes density after the first coefficients, and the dual format wraps it
+TEST_F(SerializationTest, AutoFormatSelection) {
+    const uint32_t q = params.modulus;
+    std::vector<std::vector<ColorValue>> dense(params.module_rank, std::vector<ColorValue>(params.degree));
+    std::vector<std::vector<ColorValue>> sparse_then_dense = dense;
+    std::vector<std::vector<ColorValue>> dense_then_sparse = dense;
+    for (uint32_t i = 0; i < params.module_rank; ++i) {
+        for (uint32_t j = 0; j < params.degree; ++j) {
+            uint32_t value = 1 + (i * 977 + j * 131) % (q - 1);
+            uint32_t index = i * params.degree + j;
+            dense[i][j] = ColorValue::from_math_value(value);
+            // 20% zeros, all among the first coefficients: standard format
+            sparse_then_dense[i][j] = ColorValue::from_math_value(index % 2 == 0 && index < 205 ? 0 : value);
+            // 40% zeros, all after the first coefficients: compressed format
+            dense_then_sparse[i][j] = ColorValue::from_math_value(index >= 307 ? 0 : value);
+        }
+    }
+
+    EXPECT_EQ(encode_polynomial_vector_as_colors(dense), encode_polynomial_vector_as_colors_auto(dense, q));
+    EXPECT_EQ(encode_polynomial_vector_as_colors(sparse_then_dense),
+              encode_polynomial_vector_as_colors_auto(sparse_then_dense, q));
+    EXPECT_EQ(encode_polynomial_vector_as_colors_compressed(dense_then_sparse, q),
+              encode_polynomial_vector_as_colors_auto(dense_then_sparse, q));
+    EXPECT_TRUE(encode_polynomial_vector_as_colors_auto({}, q).empty());
+
+    auto crypto_data = encode_polynomial_vector_as_colors_compressed(dense_then_sparse, q);
+    std::vector<uint8_t> expected = {0x02, 0x01, static_cast<uint8_t>(params.module_rank),
+                                     static_cast<uint8_t>(params.degree >> 8), static_cast<uint8_t>(params.degree),
+                                     static_cast<uint8_t>(q >> 24), static_cast<uint8_t>(q >> 16),
+                                     static_cast<uint8_t>(q >> 8), static_cast<uint8_t>(q)};
+    expected.insert(expected.end(), crypto_data.begin(), crypto_data.end());
+    expected.push_back(0x01);
+    auto dual = compress_with_color_support(dense_then_sparse, q, true);
+    EXPECT_EQ(expected, dual);
+    EXPECT_EQ(crypto_data, compress_with_color_support(dense_then_sparse, q, false));
+
+    uint32_t k, n, modulus;
+    auto decoded = decompress_with_color_support(dual, k, n, modulus);
+    EXPECT_EQ(params.module_rank, k);
+    EXPECT_EQ(params.degree, n);
+    EXPECT_EQ(q, modulus);
+    for (uint32_t i = 0; i < k; ++i) {
+        for (uint32_t j = 0; j < n; ++j) {
+            ASSERT_EQ(dense_then_sparse[i][j].to_math_value(), decoded[i][j].to_math_value()) << i << "," << j;
+        }
+    }
+}
+
+// Ranges and tiles rendered from a dual-format container match the full color image
+TEST_F(SerializationTest, DualFormatColorView) {
+    const uint32_t q = params.modulus;
+    std::vector<std::vector<ColorValue>> sparse(params.module_rank, std::vector<ColorValue>(params.degree));
+    std::vector<std::vector<ColorValue>> dense = sparse;
+    for (uint32_t i = 0; i < params.module_rank; ++i) {
+        for (uint32_t j = 0; j < params.degree; ++j) {
+            uint32_t value = (i * 977 + j * 131) % q;
+            sparse[i][j] = ColorValue::from_math_value(j % 2 == 0 ? 0 : value);
+            dense[i][j] = ColorValue::from_math_value(1 + value % (q - 1));
+        }
+    }
+
+    for (const auto* poly_vector : {&sparse, &dense}) {
+        auto dual = compress_with_color_support(*poly_vector, q, true);
+        auto image = encode_polynomial_vector_as_colors(*poly_vector);
+        EXPECT_EQ(image, generate_color_from_dual_format(dual));
+
+        DualFormatColorView view(dual);
+        ASSERT_EQ(image.size(), 3 * view.pixel_count());
+        EXPECT_EQ(params.module_rank, view.k());
+        EXPECT_EQ(params.degree, view.n());
+        EXPECT_EQ(q, view.modulus());
+        for (size_t first : {0u, 1u, 255u, 257u, 1023u, 2047u}) {
+            size_t count = std::min<size_t>(301, view.pixel_count() - first);
+            auto pixels = view.render_pixels(first, count);
+            EXPECT_TRUE(std::equal(pixels.begin(), pixels.end(), image.begin() + 3 * first)) << first;
+        }
+        EXPECT_THROW(view.render_pixels(view.pixel_count() - 2, 3), std::invalid_argument);
+
+        // Square layout as for key images, with the last row padded black
+        const size_t width = 46;
+        std::vector<uint8_t> tile(3 * 7 * 5);
+        view.render_tile(width, 39, 42, 7, 5, tile.data());
+        for (size_t row = 0; row < 5; ++row) {
+            for (size_t col = 0; col < 7; ++col) {
+                size_t pixel = (42 + row) * width + 39 + col;
+                for (size_t c = 0; c < 3; ++c) {
+                    uint8_t expected = pixel < view.pixel_count() ? image[3 * pixel + c] : 0;
+                    ASSERT_EQ(expected, tile[3 * (row * 7 + col) + c]) << row << "," << col;
+                }
+            }
+        }
+        EXPECT_THROW(view.render_tile(width, 40, 0, 7, 1, tile.data()), std::invalid_argument);
+    }
+
+    auto dual = compress_with_color_support(sparse, q, true);
+    std::vector<uint8_t> truncated(dual.begin(), dual.begin() + dual.size() / 2);
+    EXPECT_THROW(DualFormatColorView view(truncated), std::invalid_argument);
+    std::vector<uint8_t> not_dual = encode_polynomial_vector_as_colors_compressed(sparse, q);
+    EXPECT_THROW(DualFormatColorView view(not_dual), std::invalid_argument);
+}
+
+// Dense packing puts two 12-bit coefficients in each RGB pixel and round-trips at other widths
+TEST_F(SerializationTest, DenseColorPacking) {
+    std::vector<std::vector<ColorValue>> small(1);
+    for (uint32_t value : {0x123u, 0xABCu, 0x001u}) {
+        small[0].push_back(ColorValue::from_math_value(value));
+    }
+    const std::vector<uint8_t> expected = {0x01, 0x06, 0x01, 0x00, 0x03, 0x0C,
+                                           0x12, 0x3A, 0xBC, 0x00, 0x10, 0x00};
+    EXPECT_EQ(expected, encode_polynomial_vector_as_colors_dense(small, params.modulus));
+
+    for (uint32_t modulus : {params.modulus, 7681u, 17u}) {
+        std::vector<std::vector<ColorValue>> keys(params.module_rank, std::vector<ColorValue>(params.degree));
+        for (uint32_t i = 0; i < params.module_rank; ++i) {
+            for (uint32_t j = 0; j < params.degree; ++j) {
+                keys[i][j] = ColorValue::from_math_value((i * 977 + j * 131) % modulus);
+            }
+        }
+        auto dense = encode_polynomial_vector_as_colors_dense(keys, modulus);
+        EXPECT_EQ(0u, dense.size() % 3);
+        if (modulus == params.modulus) {
+            EXPECT_EQ(6 + params.module_rank * params.degree * 3 / 2, dense.size());
+            EXPECT_EQ(encode_polynomial_vector_as_colors(keys).size() / 8 + 6, dense.size());
+        }
+        auto decoded = decode_colors_to_polynomial_vector_dense(dense, params.module_rank, params.degree, modulus);
+        for (uint32_t i = 0; i < params.module_rank; ++i) {
+            for (uint32_t j = 0; j < params.degree; ++j) {
+                ASSERT_EQ(keys[i][j].to_math_value(), decoded[i][j].to_math_value()) << modulus << ":" << i << "," << j;
+            }
+        }
+    }
+
+    std::vector<uint8_t> truncated(expected.begin(), expected.end() - 2);
+    EXPECT_THROW(decode_colors_to_polynomial_vector_dense(truncated, 1, 3, params.modulus), std::invalid_argument);
+    EXPECT_THROW(decode_colors_to_polynomial_vector_dense(expected, 1, 4, params.modulus), std::invalid_argument);
+    std::vector<uint8_t> invalid = expected;
+    invalid[5] = 0;
+    EXPECT_THROW(decode_colors_to_polynomial_vector_dense(invalid, 1, 3, params.modulus), std::invalid_argument);
+}
+
 } // namespace clwe
\ No newline at end of file
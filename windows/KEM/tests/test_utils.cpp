@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include "utils.hpp"
+#include <cstring>
 #include <vector>
 #include <chrono>
 #include <thread>
@@ -274,7 +275,10 @@ TEST_F(UtilsTest, AVXVectorBounds) {
 #ifdef HAVE_AVX2
 // Test AVX-specific functions
 TEST_F(UtilsTest, AVXFunctions) {
-    avx_type vec = _mm256_set1_epi32(42);
+    // Filled without intrinsics: GCC only allows those in AVX2-tagged functions
+    uint32_t lanes[8] = {42, 42, 42, 42, 42, 42, 42, 42};
+    avx_type vec;
+    std::memcpy(&vec, lanes, sizeof(vec));
     uint32_t result = montgomery_reduce_avx(vec, modulus);
     EXPECT_LT(result, modulus);
     EXPECT_GE(result, 0u);